@@ -176,6 +176,15 @@ class Loader(object):
                            action='store_true',help='Do not register Xrootd Db')
         group.add_argument( '-Y','--doNotResetCSSTable', dest='doNotResetCSSTable',default=None, 
                            action='store_true',help='Do not reset the content of the CSS table (chunk vs node)')
+        group.add_argument('--zone-map-columns', dest='zoneMapColumns', default=None, metavar='COLUMNS',
+                           help='Comma-separated list of numeric columns of a partitioned table whose '
+                           'per-chunk ranges are written to "zonemap_<db>.txt" in the directory of '
+                           '"empty chunks" file, with their sums and the row counts. Czar skips the '
+                           'chunks that these ranges exclude, and answers aggregates of the whole table.')
+        group.add_argument('--row-counts', dest='rowCounts', default=False, action='store_true',
+                           help='Write per-chunk row counts of a partitioned table to "zonemap_<db>.txt" '
+                           'in the directory of "empty chunks" file, czar answers COUNT(*) of the whole '
+                           'table from them. Implied by --zone-map-columns.')
 
         group.add_argument('-i', '--index-db', dest='indexDb', default='qservMeta', metavar='DB_NAME',
                            help='Name of the database which keeps czar-side object index, def: '
@@ -241,6 +250,10 @@ class Loader(object):
         for worker in self.args.workerNodes:
             workerWmgrMap[worker] = self._wmgrConnect(worker, css_inst)
 
+        zoneMapColumns = []
+        if self.args.zoneMapColumns:
+            zoneMapColumns = [col.strip() for col in self.args.zoneMapColumns.split(',') if col.strip()]
+
         # instantiate loader
         self.loader = DataLoader(self.args.configFiles,
                                  czarWmgr,
@@ -257,6 +270,8 @@ class Loader(object):
                                  doNotResetEmptyChunks=self.args.doNotResetEmptyChunks,
                                  doNotRegisterXrootdDb=self.args.doNotRegisterXrootdDb,
                                  doNotResetCSSTable=self.args.doNotResetCSSTable,
+                                 zoneMapColumns=zoneMapColumns,
+                                 rowCounts=self.args.rowCounts,
                                  deleteTables=self.args.deleteTables,
                                  loggerName=loggerName)
 
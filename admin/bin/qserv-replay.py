@@ -0,0 +1,273 @@
+#!/usr/bin/env python
+
+# LSST Data Management System
+# Copyright 2018 AURA/LSST.
+#
+# This product includes software developed by the
+# LSST Project (http://www.lsst.org/).
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the LSST License Statement and
+# the GNU General Public License along with this program.  If not,
+# see <http://www.lsstcorp.org/LegalNotices/>.
+
+"""
+Tool replaying a workload captured by the czar against a Qserv instance
+
+The czar captures its workload when capture.file is set in its
+configuration: the text, hints and submission time of every user query,
+and with capture.timing the completion and time spent in each stage of
+every query.
+
+Script performs these tasks:
+  - read the captured workload
+  - submit the queries to the mysql proxy at their captured times, divided
+    by the speedup factor, the queries of one client session one after the
+    other on their own connection, as they were captured
+  - report the latency distributions of the captured and replayed queries
+
+@author  Qserv team
+
+"""
+
+from __future__ import absolute_import, division, print_function
+
+# --------------------------------
+#  Imports of standard modules  --
+# --------------------------------
+import argparse
+import collections
+import logging
+import sys
+import threading
+import time
+
+# -----------------------------
+# Imports for other modules  --
+# -----------------------------
+import MySQLdb
+
+# ----------------------------------
+# Local non-exported definitions  --
+# ----------------------------------
+_LOG = logging.getLogger(__name__)
+
+_UNESCAPE = {'\\': '\\', 't': '\t', 'n': '\n'}
+
+Query = collections.namedtuple('Query', ['submitMs', 'queryId', 'text', 'hints'])
+Timing = collections.namedtuple('Timing', ['doneMs', 'success', 'planMs', 'execMs', 'finalizeMs'])
+
+
+def _unescape(field):
+    """
+    Undo the escaping of tab, newline and backslash of WorkloadCapture.
+    """
+    out = []
+    i = 0
+    while i < len(field):
+        c = field[i]
+        if c == '\\' and i + 1 < len(field):
+            i += 1
+            c = _UNESCAPE.get(field[i], field[i])
+        out.append(c)
+        i += 1
+    return ''.join(out)
+
+
+def _readCapture(path):
+    """
+    Read a captured workload.
+
+    @return list of Query ordered by submission time, dict of Timing by query id
+    """
+    queries = []
+    timings = {}
+    bad = 0
+    with open(path) as f:
+        for line in f:
+            fields = [_unescape(fld) for fld in line.rstrip('\n').split('\t')]
+            try:
+                if fields[0] == 'Q' and len(fields) >= 4 and len(fields) % 2 == 0:
+                    hints = dict(zip(fields[4::2], fields[5::2]))
+                    queries.append(Query(int(fields[1]), fields[2], fields[3], hints))
+                elif fields[0] == 'T' and len(fields) == 7:
+                    timings[fields[2]] = Timing(int(fields[1]), fields[3] == '1', float(fields[4]),
+                                                float(fields[5]), float(fields[6]))
+                else:
+                    bad += 1
+            except ValueError:
+                bad += 1
+    if bad:
+        _LOG.warning("skipped %d bad records of %s", bad, path)
+    queries.sort(key=lambda q: q.submitMs)
+    return queries, timings
+
+
+def _percentiles(values):
+    """
+    @return string with the count, percentiles and max of values, in ms
+    """
+    if not values:
+        return "count=0"
+    values = sorted(values)
+
+    def pct(p):
+        return values[min(len(values) - 1, int(p * len(values) / 100))]
+
+    return "count=%d p50=%.1f p90=%.1f p99=%.1f max=%.1f" % (len(values), pct(50), pct(90), pct(99),
+                                                               values[-1])
+
+
+# ------------------------
+# Exported definitions  --
+# ------------------------
+class Replay(object):
+    """
+    Application class for the workload replay tool
+    """
+
+    def __init__(self):
+        """
+        Constructor parse all arguments and prepares for execution.
+        """
+
+        parser = argparse.ArgumentParser(description='Replay a workload captured by the Qserv czar.')
+
+        parser.add_argument('-v', '--verbose', dest='verbose', default=[],
+                            action='append_const',
+                            const=None,
+                            help='More verbose output, can use several times.')
+        parser.add_argument('-H', '--host', dest='host', default='127.0.0.1',
+                            help='mysql proxy host, default: %(default)s')
+        parser.add_argument('-P', '--port', dest='port', type=int, default=4040,
+                            help='mysql proxy port, default: %(default)s')
+        parser.add_argument('-u', '--user', dest='user', default='qsmaster',
+                            help='mysql user, default: %(default)s')
+        parser.add_argument('-s', '--speedup', dest='speedup', type=float, default=1.0,
+                            help='Divide the time between submissions by this factor, '
+                            '1 replays at the captured rate, default: %(default)s')
+        parser.add_argument('-l', '--limit', dest='limit', type=int, default=0,
+                            help='Replay at most this many queries, 0 for all, default: %(default)s')
+        parser.add_argument('--select-only', dest='selectOnly', action='store_true',
+                            help='Only replay SELECT queries.')
+        parser.add_argument('-o', '--output', dest='output', default=None,
+                            help='Write the latency of every replayed query to this file, '
+                            'tab separated: query id, captured ms, replayed ms, error.')
+        parser.add_argument('capture', help='File captured by the czar')
+
+        self.args = parser.parse_args()
+
+        verbosity = len(self.args.verbose)
+        levels = {0: logging.ERROR, 1: logging.WARNING, 2: logging.INFO, 3: logging.DEBUG}
+        logging.basicConfig(format="[%(levelname)s] %(name)s: %(message)s",
+                            level=levels.get(verbosity, logging.DEBUG))
+
+        self._results = {}
+        self._resultsMtx = threading.Lock()
+
+    def _runSession(self, queries, startTime, t0Ms):
+        """
+        Submit the queries of one client session, in order, on one connection.
+        """
+        conn = MySQLdb.connect(host=self.args.host, port=self.args.port, user=self.args.user, passwd='')
+        cursor = conn.cursor()
+        db = None
+        for q in queries:
+            delay = startTime + (q.submitMs - t0Ms) / 1000.0 / self.args.speedup - time.time()
+            if delay > 0:
+                time.sleep(delay)
+            error = ''
+            begin = time.time()
+            try:
+                qDb = q.hints.get('db', '')
+                if qDb and qDb != db:
+                    conn.select_db(qDb)
+                    db = qDb
+                cursor.execute(q.text)
+                cursor.fetchall()
+            except MySQLdb.Error as exc:
+                error = str(exc)
+                _LOG.warning("query %s failed: %s", q.queryId, error)
+            elapsedMs = (time.time() - begin) * 1000.0
+            _LOG.info("query %s took %.1f ms", q.queryId, elapsedMs)
+            with self._resultsMtx:
+                self._results[q.queryId] = (elapsedMs, error)
+        conn.close()
+
+    def run(self):
+        """
+        Replay the workload and report the latencies.
+        """
+        queries, timings = _readCapture(self.args.capture)
+        if self.args.selectOnly:
+            queries = [q for q in queries if q.text.lstrip().upper().startswith('SELECT')]
+        if self.args.limit > 0:
+            queries = queries[:self.args.limit]
+        if not queries:
+            print("No query to replay in", self.args.capture)
+            return 1
+
+        # Queries of a session were submitted one after the other on one connection.
+        sessions = collections.OrderedDict()
+        for q in queries:
+            key = (q.hints.get('client_dst_name', ''), q.hints.get('server_thread_id', q.queryId))
+            sessions.setdefault(key, []).append(q)
+        t0Ms = queries[0].submitMs
+        spanSecs = (queries[-1].submitMs - t0Ms) / 1000.0 / self.args.speedup
+        print("Replaying %d queries of %d sessions over %.1f s" % (len(queries), len(sessions), spanSecs))
+
+        startTime = time.time()
+        threads = []
+        for sessionQueries in sessions.values():
+            t = threading.Thread(target=self._runSession, args=(sessionQueries, startTime, t0Ms))
+            t.daemon = True
+            t.start()
+            threads.append(t)
+        for t in threads:
+            t.join()
+
+        # Captured latencies are those seen by the czar, replayed ones those seen
+        # by the client, including the transfer of the results.
+        captured = []
+        replayed = []
+        failed = 0
+        for q in queries:
+            timing = timings.get(q.queryId)
+            if timing is not None and timing.success:
+                captured.append(timing.doneMs - q.submitMs)
+            elapsedMs, error = self._results.get(q.queryId, (None, 'not run'))
+            if error:
+                failed += 1
+            else:
+                replayed.append(elapsedMs)
+        print("captured latency ms:", _percentiles(captured))
+        print("replayed latency ms:", _percentiles(replayed))
+        if timings:
+            ok = [timings[q.queryId] for q in queries if q.queryId in timings and timings[q.queryId].success]
+            print("captured planning ms:", _percentiles([t.planMs for t in ok]))
+            print("captured execution ms:", _percentiles([t.execMs for t in ok]))
+            print("captured finalization ms:", _percentiles([t.finalizeMs for t in ok]))
+        print("replayed queries failed:", failed)
+
+        if self.args.output:
+            with open(self.args.output, 'w') as f:
+                for q in queries:
+                    timing = timings.get(q.queryId)
+                    capturedMs = "%.1f" % (timing.doneMs - q.submitMs) if timing else ''
+                    elapsedMs, error = self._results.get(q.queryId, (None, 'not run'))
+                    replayedMs = "%.1f" % elapsedMs if elapsedMs is not None else ''
+                    f.write("%s\t%s\t%s\t%s\n" % (q.queryId, capturedMs, replayedMs, error.replace('\n', ' ')))
+        return 0
+
+
+if __name__ == '__main__':
+    sys.exit(Replay().run())
@@ -0,0 +1,103 @@
+#!/usr/bin/env python
+
+# LSST Data Management System
+# Copyright 2018 LSST Corporation.
+#
+# This product includes software developed by the
+# LSST Project (http://www.lsstcorp.org/).
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the LSST License Statement and
+# the GNU General Public License along with this program.  If not,
+# see <http://www.lsstcorp.org/LegalNotices/>.
+
+"""
+Tool writing the secondary index file of a director table
+
+Script reads lines of tab-separated director key, chunk id and subchunk id,
+as written by:
+
+  mysql -N -B -e "SELECT objectId, chunkId, subChunkId FROM qservMeta.LSST__Object"
+
+and writes them, sorted by key, in the format the czar maps into memory
+when [partitioner] secondaryIndexPath holds the file, e.g.
+secondaryIndexPath/LSST__Object.idx.
+
+"""
+
+from __future__ import absolute_import, division, print_function
+
+# --------------------------------
+#  Imports of standard modules  --
+# --------------------------------
+import argparse
+from array import array
+import fileinput
+import logging
+import struct
+import sys
+
+# ----------------------------------
+# Local non-exported definitions  --
+# ----------------------------------
+_LOG = logging.getLogger(__name__)
+
+_MAGIC = b"QSIDX001"
+
+
+def _readRows(inputs):
+    """
+    Return rows of the input files, as (key, chunk, subchunk) tuples.
+    """
+    rows = []
+    for line in fileinput.input(inputs):
+        line = line.strip()
+        if line:
+            key, chunk, subChunk = line.split('\t')
+            rows.append((int(key), int(chunk), int(subChunk)))
+    return rows
+
+
+def _writeIndex(rows, path):
+    """
+    Write the index file: magic, key count, keys, chunk ids, subchunk ids.
+    """
+    rows.sort()
+    for prev, row in zip(rows, rows[1:]):
+        if prev[0] == row[0]:
+            raise ValueError("Duplicate key %d" % row[0])
+    keys = array('q', (row[0] for row in rows))
+    chunks = array('i', (row[1] for row in rows))
+    subChunks = array('i', (row[2] for row in rows))
+    with open(path, 'wb') as out:
+        out.write(_MAGIC)
+        out.write(struct.pack('=Q', len(rows)))
+        for values in (keys, chunks, subChunks):
+            values.tofile(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Secondary index file writer for Qserv.')
+    parser.add_argument('output', help='Index file to write, DB__TABLE.idx')
+    parser.add_argument('inputs', nargs='*',
+                        help='Files of tab-separated key, chunk and subchunk, standard input if none')
+    args = parser.parse_args()
+
+    logging.basicConfig(format='%(asctime)s %(levelname)-8s %(message)s', level=logging.INFO)
+    rows = _readRows(args.inputs)
+    _writeIndex(rows, args.output)
+    _LOG.info("Wrote %d keys to %s", len(rows), args.output)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -71,6 +71,19 @@ def _mysql_identifier_validator(db_or_table_name):
 # ------------------------
 
 
+def _zoneMapNumber(value):
+    """Convert zone map value to int if it is one, to keep sums of integers exact"""
+    try:
+        return int(value)
+    except ValueError:
+        return float(value)
+
+
+def _zoneMapString(value):
+    """Format zone map value, floats with all their digits"""
+    return repr(value) if isinstance(value, float) else str(value)
+
+
 class DataLoader(object):
     """
     DataLoader class defines all logic for loading data, including data
@@ -82,7 +95,8 @@ class DataLoader(object):
                  chunkPrefix='chunk', keepChunks=False, skipPart=False, oneTable=False,
                  css=None, cssClear=False, indexDb='qservMeta', tmpDir=None,
                  emptyChunks=None, deleteTables=False, loggerName=None,
-                 doNotResetEmptyChunks=None, doNotRegisterXrootdDb=None, doNotResetCSSTable=None):
+                 doNotResetEmptyChunks=None, doNotRegisterXrootdDb=None, doNotResetCSSTable=None,
+                 zoneMapColumns=None, rowCounts=False):
         """
         Constructor parses all arguments and prepares for execution.
 
@@ -108,6 +122,10 @@ class DataLoader(object):
         @param emptyChunks:  Path name for "empty chunks" file, may be None.
         @param deleteTables: If True then existing tables in database will be deleted.
         @param loggerName:   Logger name used for logging all messages from loader.
+        @param zoneMapColumns: Sequence of numeric column names whose per-chunk ranges are
+                             written to the zone map file next to "empty chunks" file.
+        @param rowCounts:    If True then per-chunk row counts are written to the zone map
+                             file, implied by zoneMapColumns.
         """
 
         if not loggerName:
@@ -131,6 +149,8 @@ class DataLoader(object):
         self.doNotRegisterXrootdDb = doNotRegisterXrootdDb
         self.doNotResetCSSTable = doNotResetCSSTable
         self.deleteTables = deleteTables
+        self.zoneMapColumns = zoneMapColumns or []
+        self.rowCounts = bool(rowCounts or self.zoneMapColumns)
 
         self.chunkRe = re.compile('^' + self.chunkPrefix + '_(?P<id>[0-9]+)(?P<ov>_overlap)?[.]txt$')
         self.cleanupDirs = []
@@ -236,6 +256,9 @@ class DataLoader(object):
             self._log.info('*** SES *** : keep existing empty chunk file')
             self._updateEmptyChunks()
 
+        # optionally make zone map file
+        self._makeZoneMap(database, table)
+
 
     def _cleanup(self):
         """
@@ -813,6 +836,107 @@ class DataLoader(object):
                 print(chunk, file=out)
 
 
+    def _makeZoneMap(self, database, table):
+        """
+        Write per-chunk row counts, and min/max, NULL count and sum of zone map columns,
+        to the zone map file of the database. Czar uses them to skip chunks that cannot
+        match a query and to answer aggregates of the whole table. Statistics of a table
+        loaded without these options are dropped, as they no longer match its data.
+        """
+
+        if not self.emptyChunks or not self.partitioned or self.oneTable:
+            return
+
+        zoneMapPath = os.path.join(os.path.dirname(self.emptyChunks), 'zonemap_%s.txt' % database)
+        collect = bool(self.zoneMapColumns) or self.rowCounts
+        if not collect and not os.path.exists(zoneMapPath):
+            return
+
+        positions = {}
+        if self.zoneMapColumns:
+            names = [col['name'] for col in self.czarWmgr.tableColumns(database, table)]
+            for column in self.zoneMapColumns:
+                if column not in names:
+                    self._log.warning('Zone map column %r is not in table %r.%r', column, database, table)
+                else:
+                    positions[column] = names.index(column)
+
+        # rows[chunk] = row count
+        # ranges[(column, chunk)] = [min, max, nullCount, sum], min is None if all values are NULL
+        rows = {}
+        ranges = {}
+        delimiter = self.partOptions.get('out.csv.delimiter', '\t')
+        for path, chunkId, overlap in (self._chunkFiles() if collect else []):
+            # overlap rows belong to the neighbour chunks
+            if overlap:
+                continue
+            rows.setdefault(chunkId, 0)
+            for column in positions:
+                ranges.setdefault((column, chunkId), [None, None, 0, 0])
+            with open(path) as data:
+                for line in data:
+                    rows[chunkId] += 1
+                    fields = line.rstrip('\n').split(delimiter)
+                    for column, pos in list(positions.items()):
+                        value = fields[pos] if pos < len(fields) else '\\N'
+                        entry = ranges[(column, chunkId)]
+                        if value in ('\\N', 'NULL'):
+                            entry[2] += 1
+                            continue
+                        try:
+                            value = _zoneMapNumber(value)
+                        except ValueError:
+                            self._log.warning('Zone map column %r is not numeric, skipped', column)
+                            del positions[column]
+                            continue
+                        if entry[0] is None or value < entry[0]:
+                            entry[0] = value
+                        if entry[1] is None or value > entry[1]:
+                            entry[1] = value
+                        entry[3] += value
+
+        self._log.info('Making zone map of columns %r %r', list(positions.keys()), zoneMapPath)
+
+        # keep lines of other tables, when appending to a table add to its statistics
+        lines = []
+        if os.path.exists(zoneMapPath):
+            with open(zoneMapPath) as old:
+                for line in old:
+                    fields = line.split()
+                    if not fields or fields[0] != table:
+                        lines.append(line.rstrip('\n'))
+                        continue
+                    if not (collect and self.doNotResetEmptyChunks):
+                        continue
+                    if len(fields) == 3 and self.rowCounts:
+                        chunkId = int(fields[1])
+                        rows[chunkId] = rows.get(chunkId, 0) + int(fields[2])
+                    elif len(fields) == 7 and fields[1] in positions:
+                        entry = ranges.setdefault((fields[1], int(fields[2])), [None, None, 0, 0])
+                        if fields[3] != 'NULL':
+                            oldMin = _zoneMapNumber(fields[3])
+                            oldMax = _zoneMapNumber(fields[4])
+                            entry[0] = oldMin if entry[0] is None else min(entry[0], oldMin)
+                            entry[1] = oldMax if entry[1] is None else max(entry[1], oldMax)
+                            entry[3] += _zoneMapNumber(fields[6])
+                        entry[2] += int(fields[5])
+
+        if self.rowCounts:
+            for chunkId, count in sorted(rows.items()):
+                lines.append('%s %d %d' % (table, chunkId, count))
+        for (column, chunkId), (low, high, nulls, total) in sorted(ranges.items()):
+            if column not in positions:
+                continue
+            if low is None:
+                lines.append('%s %s %d NULL NULL %d NULL' % (table, column, chunkId, nulls))
+            else:
+                lines.append('%s %s %d %s %s %d %s' % (table, column, chunkId, _zoneMapString(low),
+                                                        _zoneMapString(high), nulls, _zoneMapString(total)))
+
+        with open(zoneMapPath, 'w') as out:
+            for line in lines:
+                print(line, file=out)
+
     def _makeIndex(self, database, table):
         """
         Generate object index in czar meta database.
@@ -6,12 +6,16 @@ set -e
 EMPTY_CHUNK_PATH={{QSERV_DATA_DIR}}/qserv
 DIR=$(cd "$(dirname "$0")"; pwd -P)
 SQL_LOADER=${DIR}/tools/sql-loader.sh
+QSERV_UDF={{QSERV_DIR}}/lib/mysql/plugin/qserv_udf.so
+MYSQL_PLUGIN_DIR={{MYSQL_DIR}}/lib/plugin
 SQL_FILE="qserv-czar.sql QueryMetadata.sql CssData.sql"
 
 mkdir -p $EMPTY_CHUNK_PATH
 
 echo 
 echo "-- Initializing Qserv czar database "
+echo "-- Deploying Qserv UDF plugin in MySQL database"
+cp "${QSERV_UDF}" "${MYSQL_PLUGIN_DIR}"
 if [ -r "${SQL_LOADER}" ]; then
     . "${SQL_LOADER}"
 else
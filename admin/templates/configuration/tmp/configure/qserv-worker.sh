@@ -4,10 +4,14 @@ set -e
 
 DIR=$(cd "$(dirname "$0")"; pwd -P)
 SQL_LOADER=${DIR}/tools/sql-loader.sh
+QSERV_UDF={{QSERV_DIR}}/lib/mysql/plugin/qserv_udf.so
+MYSQL_PLUGIN_DIR={{MYSQL_DIR}}/lib/plugin
 SQL_FILE=qserv-worker.sql
 
 echo 
 echo "-- Initializing Qserv Worker database "
+echo "-- Deploying Qserv UDF plugin in MySQL database"
+cp "${QSERV_UDF}" "${MYSQL_PLUGIN_DIR}"
 if [ -r "${SQL_LOADER}" ]; then
     . "${SQL_LOADER}"
 else
@@ -24,6 +24,11 @@ CREATE TABLE IF NOT EXISTS `QCzar` (
   `czarId` INT NOT NULL AUTO_INCREMENT COMMENT 'Czar identifier',
   `czar` CHAR(63) NOT NULL COMMENT 'Czar unique name',
   `active` BIT NOT NULL COMMENT 'Set to 0 when czar disappears',
+  `loadTime` TIMESTAMP NULL DEFAULT NULL COMMENT 'Time of the last load update, NULL if never advertised',
+  `runningQueries` INT UNSIGNED NOT NULL DEFAULT 0 COMMENT 'Queries dispatching or merging',
+  `queuedQueries` INT UNSIGNED NOT NULL DEFAULT 0 COMMENT 'Queries waiting for admission',
+  `runningJobs` BIGINT UNSIGNED NOT NULL DEFAULT 0 COMMENT 'Chunk jobs of running scan and async queries',
+  `queuedJobs` BIGINT UNSIGNED NOT NULL DEFAULT 0 COMMENT 'Chunk jobs of queued scan and async queries',
   PRIMARY KEY (`czarId`),
   UNIQUE INDEX `QCzar_czar_UNIQUE` (`czar` ASC))
 ENGINE = InnoDB
@@ -48,6 +53,10 @@ CREATE TABLE IF NOT EXISTS `QInfo` (
   `returned` TIMESTAMP NULL COMMENT 'Time when result is sent back to user. NULL if not completed yet.',
   `messageTable` CHAR(63) NULL COMMENT 'Name of the message table for the ASYNC query',
   `resultLocation` TEXT NULL COMMENT 'Result destination - table name, file name, etc.',
+  `cpuSeconds` DOUBLE NULL COMMENT 'CPU time of the worker threads running the query tasks, NULL until the query completes.',
+  `rowsRead` BIGINT UNSIGNED NULL COMMENT 'Rows read by MySQL on the workers, from its Handler_read counters.',
+  `bytesTransmitted` BIGINT UNSIGNED NULL COMMENT 'Result bytes sent by the workers to the czar.',
+  `memLockedBytes` BIGINT UNSIGNED NULL COMMENT 'Bytes of tables locked in memory for the query tasks.',
   PRIMARY KEY (`queryId`),
   INDEX `QInfo_czarId_index` (`czarId` ASC),
   CONSTRAINT `QInfo_cid`
@@ -160,7 +169,9 @@ COMMENT = 'Metadata about database as a whole, bunch of key-value pairs';
 -- Version 0 corresponds to initial QMeta release and it had no
 -- QMetadata table at all.
 -- Version 1 introduced QMetadata table and altered schema for QInfo table
-INSERT INTO `QMetadata` (`metakey`, `value`) VALUES ('version', '1');
+-- Version 2 added resource usage columns to QInfo table
+-- Version 3 added load columns to QCzar table
+INSERT INTO `QMetadata` (`metakey`, `value`) VALUES ('version', '3');
 
 SET SQL_MODE=@OLD_SQL_MODE;
 SET FOREIGN_KEY_CHECKS=@OLD_FOREIGN_KEY_CHECKS;
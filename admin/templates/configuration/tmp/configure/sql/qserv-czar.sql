@@ -12,6 +12,10 @@ GRANT ALL ON qservMeta.* TO '{{MYSQLD_USER_QSERV}}'@'localhost';
 CREATE DATABASE IF NOT EXISTS qservCssData;
 GRANT ALL ON qservCssData.* TO '{{MYSQLD_USER_QSERV}}'@'localhost';
 
+-- Merges the HyperLogLog sketches of APPROX_COUNT_DISTINCT() into estimates
+DROP FUNCTION IF EXISTS qserv_hll_count;
+CREATE AGGREGATE FUNCTION qserv_hll_count RETURNS INTEGER SONAME 'qserv_udf.so';
+
 -- Create user for external monitoring applications
 CREATE USER IF NOT EXISTS '{{MYSQLD_USER_MONITOR}}'@'localhost' IDENTIFIED BY '{{MYSQLD_PASSWORD_MONITOR}}';
 GRANT PROCESS ON *.* TO '{{MYSQLD_USER_MONITOR}}'@'localhost';
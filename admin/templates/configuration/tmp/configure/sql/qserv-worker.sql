@@ -54,6 +54,10 @@ GRANT ALL ON `q\_memoryLockDb`.* TO '{{MYSQLD_USER_QSERV}}'@'localhost';
 -- Subchunks databases
 GRANT ALL ON `Subchunks\_%`.* TO '{{MYSQLD_USER_QSERV}}'@'localhost';
 
+-- HyperLogLog sketches computed by the chunk queries of APPROX_COUNT_DISTINCT()
+DROP FUNCTION IF EXISTS qserv_hll;
+CREATE AGGREGATE FUNCTION qserv_hll RETURNS STRING SONAME 'qserv_udf.so';
+
 
 -- Create user for external monitoring applications
 CREATE USER IF NOT EXISTS '{{MYSQLD_USER_MONITOR}}'@'localhost' IDENTIFIED BY '{{MYSQLD_PASSWORD_MONITOR}}';
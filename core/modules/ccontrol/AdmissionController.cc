@@ -0,0 +1,304 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "ccontrol/AdmissionController.h"
+
+// System headers
+#include <algorithm>
+#include <sstream>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "util/Metrics.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.ccontrol.AdmissionController");
+
+lsst::qserv::util::Histogram::Ptr const waitHisto = lsst::qserv::util::MetricsRegistry::get().histogram(
+        "qserv_czar_admission_wait_seconds", "Time admitted queries waited to start",
+        {0.01, 0.1, 1, 10, 60, 300});
+
+} // annonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace ccontrol {
+
+AdmissionController::Ticket::Ticket(std::shared_ptr<AdmissionController> const& controller,
+                                    QueryClass qClass, int64_t jobs, double cost,
+                                    std::chrono::milliseconds wait)
+    : _controller(controller), _qClass(qClass), _jobs(jobs), _cost(cost), _wait(wait) {
+}
+
+
+AdmissionController::Ticket::~Ticket() {
+    auto controller = _controller.lock();
+    if (controller != nullptr) {
+        controller->_release(_qClass, _jobs, _cost);
+    }
+}
+
+
+AdmissionController::Ptr AdmissionController::create(Config const& config, Pressure const& pressure) {
+    Ptr controller(new AdmissionController(config, pressure));
+    std::weak_ptr<AdmissionController> weak(controller);
+    util::MetricsRegistry::get().addCollector("admission", [weak](std::ostream& os) {
+        using util::MetricsRegistry;
+        auto controller = weak.lock();
+        if (controller == nullptr) {
+            return;
+        }
+        MetricsRegistry::writeHeader(os, "qserv_czar_admission_queries", "gauge",
+                                     "Queries waiting to start or running, per class");
+        for (int c = 0; c < CLASS_COUNT; ++c) {
+            auto const stats = controller->getStats(static_cast<QueryClass>(c));
+            std::string const cls = std::string("class=\"") + className(static_cast<QueryClass>(c)) + "\"";
+            MetricsRegistry::writeValue(os, "qserv_czar_admission_queries", cls + ",state=\"queued\"",
+                                        stats.queued);
+            MetricsRegistry::writeValue(os, "qserv_czar_admission_queries", cls + ",state=\"running\"",
+                                        stats.running);
+        }
+        MetricsRegistry::writeHeader(os, "qserv_czar_admission_decisions_total", "counter",
+                                     "Queries admitted or rejected, per class");
+        MetricsRegistry::writeHeader(os, "qserv_czar_admission_queue_seconds_total", "counter",
+                                     "Time admitted queries waited to start, per class");
+        for (int c = 0; c < CLASS_COUNT; ++c) {
+            auto const stats = controller->getStats(static_cast<QueryClass>(c));
+            std::string const cls = std::string("class=\"") + className(static_cast<QueryClass>(c)) + "\"";
+            MetricsRegistry::writeValue(os, "qserv_czar_admission_decisions_total",
+                                        cls + ",decision=\"admitted\"", stats.admitted);
+            MetricsRegistry::writeValue(os, "qserv_czar_admission_decisions_total",
+                                        cls + ",decision=\"rejected\"", stats.rejected);
+            MetricsRegistry::writeValue(os, "qserv_czar_admission_queue_seconds_total", cls,
+                                        stats.waitSeconds);
+        }
+        auto const load = controller->getLoad();
+        MetricsRegistry::writeHeader(os, "qserv_czar_admission_jobs", "gauge",
+                                     "Chunk jobs of scan and async queries, and their budget");
+        MetricsRegistry::writeValue(os, "qserv_czar_admission_jobs", "state=\"queued\"", load.queuedJobs);
+        MetricsRegistry::writeValue(os, "qserv_czar_admission_jobs", "state=\"running\"", load.runningJobs);
+        MetricsRegistry::writeValue(os, "qserv_czar_admission_jobs", "state=\"budget\"",
+                                    controller->getMaxRunningJobs());
+    });
+    return controller;
+}
+
+
+AdmissionController::AdmissionController(Config const& config, Pressure const& pressure)
+    : _config(config), _pressure(pressure), _maxRunningJobs(config.maxRunningJobs) {
+}
+
+
+AdmissionController::~AdmissionController() {
+    util::MetricsRegistry::get().removeCollector("admission");
+}
+
+
+char const* AdmissionController::className(QueryClass qClass) {
+    switch (qClass) {
+    case INTERACTIVE: return "interactive";
+    case SCAN: return "scan";
+    case ASYNC: return "async";
+    }
+    return "unknown";
+}
+
+
+AdmissionController::Ticket::Ptr
+AdmissionController::admit(QueryId queryId, QueryClass qClass, qproc::QueryCost const& cost,
+                           std::string& reason) {
+    using std::chrono::steady_clock;
+    int64_t const jobs = (qClass == INTERACTIVE) ? 0 : cost.chunkCount;
+    double const budgetCost = (qClass == INTERACTIVE) ? 0.0 : cost.cost;
+    auto const start = steady_clock::now();
+    auto const deadline = start + _config.maxWait;
+
+    std::unique_lock<std::mutex> lock(_mtx);
+    ClassStats& stats = _stats[qClass];
+    std::deque<QueryId>& queue = _queues[qClass];
+    if (static_cast<int>(queue.size()) >= std::max(0, _config.maxQueued)) {
+        ++stats.rejected;
+        std::ostringstream os;
+        os << "Query rejected, " << queue.size() << " " << className(qClass)
+           << " queries are already waiting to start. Try again later.";
+        reason = os.str();
+        _addHint(reason);
+        LOGS(_log, LOG_LVL_WARN, "QID=" << queryId << " " << reason);
+        return nullptr;
+    }
+    queue.push_back(queryId);
+    _waiting[queryId] = false;
+    ++stats.queued;
+    _queuedJobs += jobs;
+
+    bool admitted = false;
+    std::string blocker;
+    std::string logged;
+    while (true) {
+        if (_waiting[queryId]) {
+            reason = "Query cancelled while waiting to start.";
+            break;
+        }
+        if (queue.front() == queryId) {
+            blocker = _blocker(qClass, jobs, budgetCost);
+            if (blocker.empty()) {
+                admitted = true;
+                break;
+            }
+        } else {
+            blocker = "earlier " + std::string(className(qClass)) + " queries";
+        }
+        auto const now = steady_clock::now();
+        if (now >= deadline) {
+            std::ostringstream os;
+            os << "Query rejected after waiting "
+               << std::chrono::duration_cast<std::chrono::seconds>(now - start).count()
+               << " s to start, the czar is busy (" << blocker << "). Try again later.";
+            reason = os.str();
+            _addHint(reason);
+            break;
+        }
+        if (blocker != logged) {
+            LOGS(_log, LOG_LVL_DEBUG, "QID=" << queryId << " waiting for " << blocker);
+            logged = blocker;
+        }
+        _cv.wait_until(lock, std::min(deadline, now + _config.recheck));
+    }
+    queue.erase(std::find(queue.begin(), queue.end(), queryId));
+    _waiting.erase(queryId);
+    --stats.queued;
+    _queuedJobs -= jobs;
+    // The query behind this one may start now, or becomes the first to wait.
+    _cv.notify_all();
+    if (!admitted) {
+        ++stats.rejected;
+        LOGS(_log, LOG_LVL_WARN, "QID=" << queryId << " " << reason);
+        return nullptr;
+    }
+    auto const wait = std::chrono::duration_cast<std::chrono::milliseconds>(steady_clock::now() - start);
+    ++stats.running;
+    ++stats.admitted;
+    stats.waitSeconds += wait.count() / 1000.0;
+    _runningJobs += jobs;
+    _runningCost += budgetCost;
+    lock.unlock();
+    waitHisto->observe(wait.count() / 1000.0);
+    LOGS(_log, LOG_LVL_INFO, "QID=" << queryId << " admitted as " << className(qClass)
+         << " query after " << wait.count() << " ms");
+    return Ticket::Ptr(new Ticket(shared_from_this(), qClass, jobs, budgetCost, wait));
+}
+
+
+void AdmissionController::cancel(QueryId queryId) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    auto iter = _waiting.find(queryId);
+    if (iter != _waiting.end()) {
+        iter->second = true;
+        _cv.notify_all();
+    }
+}
+
+
+std::string AdmissionController::_blocker(QueryClass qClass, int64_t jobs, double cost) const {
+    std::ostringstream os;
+    int const maxRunning = _config.maxRunning[qClass];
+    if (maxRunning > 0 && _stats[qClass].running >= maxRunning) {
+        os << _stats[qClass].running << " running " << className(qClass) << " queries";
+        return os.str();
+    }
+    // A query always starts alone, however large, so that none waits forever.
+    if (qClass == INTERACTIVE || _stats[SCAN].running + _stats[ASYNC].running == 0) {
+        return std::string();
+    }
+    if (_maxRunningJobs > 0 && _runningJobs + jobs > _maxRunningJobs) {
+        os << _runningJobs << " chunk jobs of running queries";
+        return os.str();
+    }
+    if (_config.maxRunningCost > 0 && _runningCost + cost > _config.maxRunningCost) {
+        os << "running queries of estimated cost " << _runningCost;
+        return os.str();
+    }
+    return _pressure ? _pressure() : std::string();
+}
+
+
+void AdmissionController::_release(QueryClass qClass, int64_t jobs, double cost) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    --_stats[qClass].running;
+    _runningJobs -= jobs;
+    _runningCost -= cost;
+    _cv.notify_all();
+}
+
+
+AdmissionController::ClassStats AdmissionController::getStats(QueryClass qClass) const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _stats[qClass];
+}
+
+
+AdmissionController::Load AdmissionController::getLoad() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    Load load;
+    for (int c = 0; c < CLASS_COUNT; ++c) {
+        load.running += _stats[c].running;
+        load.queued += _stats[c].queued;
+    }
+    load.runningJobs = _runningJobs;
+    load.queuedJobs = _queuedJobs;
+    return load;
+}
+
+
+void AdmissionController::setMaxRunningJobs(int64_t maxRunningJobs) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    if (maxRunningJobs != _maxRunningJobs) {
+        _maxRunningJobs = maxRunningJobs;
+        _cv.notify_all();
+    }
+}
+
+
+int64_t AdmissionController::getMaxRunningJobs() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _maxRunningJobs;
+}
+
+
+void AdmissionController::setRejectionHint(std::string const& hint) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _hint = hint;
+}
+
+
+void AdmissionController::_addHint(std::string& reason) const {
+    if (!_hint.empty()) {
+        reason += " " + _hint;
+    }
+}
+
+}}} // namespace lsst::qserv::ccontrol
@@ -0,0 +1,179 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_CCONTROL_ADMISSIONCONTROLLER_H
+#define LSST_QSERV_CCONTROL_ADMISSIONCONTROLLER_H
+
+// System headers
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Qserv headers
+#include "global/intTypes.h"
+#include "qproc/QueryCost.h"
+
+namespace lsst {
+namespace qserv {
+namespace ccontrol {
+
+/// AdmissionController decides when a SELECT query may start dispatching
+/// its jobs, so that a burst of queries queues in the czar instead of
+/// starting as many executives competing for dispatch threads and merge
+/// connections.
+///
+/// Each class of queries has its own limit of running queries and its own
+/// queue, served in arrival order. Scan and async queries also wait while
+/// the chunk jobs or the estimated cost of the running ones are above the
+/// budget, or while the czar is short of resources as told by the pressure
+/// function, unless no other query of these classes runs. Interactive
+/// queries, which are cheap by definition, only have their own limit.
+/// A query that finds its queue full, or waits longer than allowed, is
+/// rejected.
+class AdmissionController : public std::enable_shared_from_this<AdmissionController> {
+public:
+    enum QueryClass { INTERACTIVE = 0, SCAN = 1, ASYNC = 2 };
+    static int const CLASS_COUNT = 3;
+
+    struct Config {
+        int maxRunning[CLASS_COUNT] = {0, 0, 0}; ///< Running queries per class, 0 for no limit
+        int maxQueued{1000};            ///< Queries waiting per class
+        std::chrono::milliseconds maxWait{std::chrono::minutes(10)};
+        int64_t maxRunningJobs{0};      ///< Chunk jobs of running scan and async queries, 0 for no limit
+        double maxRunningCost{0.0};     ///< Cost of running scan and async queries, 0 for no limit
+        std::chrono::milliseconds recheck{std::chrono::milliseconds(200)}; ///< How often pressure is checked
+    };
+
+    /// @return a description of the resource the czar is short of, or an
+    ///         empty string if it may start another query. It is called with
+    ///         the controller lock held.
+    using Pressure = std::function<std::string()>;
+
+    /// Held by an admitted query while it runs.
+    class Ticket {
+    public:
+        using Ptr = std::shared_ptr<Ticket>;
+        ~Ticket();
+        Ticket(Ticket const&) = delete;
+        Ticket& operator=(Ticket const&) = delete;
+        /// @return the time the query waited to be admitted.
+        std::chrono::milliseconds getWait() const { return _wait; }
+    private:
+        friend class AdmissionController;
+        Ticket(std::shared_ptr<AdmissionController> const& controller, QueryClass qClass,
+               int64_t jobs, double cost, std::chrono::milliseconds wait);
+        std::weak_ptr<AdmissionController> const _controller;
+        QueryClass const _qClass;
+        int64_t const _jobs;
+        double const _cost;
+        std::chrono::milliseconds const _wait;
+    };
+
+    struct ClassStats {
+        int queued{0};
+        int running{0};
+        uint64_t admitted{0};
+        uint64_t rejected{0};
+        double waitSeconds{0.0}; ///< Total time admitted queries waited
+    };
+
+    using Ptr = std::shared_ptr<AdmissionController>;
+
+    static Ptr create(Config const& config, Pressure const& pressure);
+
+    AdmissionController(AdmissionController const&) = delete;
+    AdmissionController& operator=(AdmissionController const&) = delete;
+
+    ~AdmissionController();
+
+    static char const* className(QueryClass qClass);
+
+    /// Wait until query 'queryId', of class 'qClass' and estimated cost
+    /// 'cost', may start.
+    /// @return the ticket to hold while it runs, or nullptr with 'reason' set
+    ///         if it is rejected or cancelled.
+    Ticket::Ptr admit(QueryId queryId, QueryClass qClass, qproc::QueryCost const& cost,
+                      std::string& reason);
+
+    /// Reject query 'queryId' if it is waiting, e.g. when it is killed.
+    void cancel(QueryId queryId);
+
+    ClassStats getStats(QueryClass qClass) const;
+
+    /// Load of the czar, as advertised to the other czars.
+    struct Load {
+        int running{0};          ///< Queries of all classes running
+        int queued{0};           ///< Queries of all classes waiting to start
+        int64_t runningJobs{0};  ///< Chunk jobs of running scan and async queries
+        int64_t queuedJobs{0};   ///< Chunk jobs of waiting scan and async queries
+    };
+
+    Load getLoad() const;
+
+    /// Change the chunk jobs budget of running scan and async queries, e.g.
+    /// to this czar's share of a budget for all czars. Queries already
+    /// running keep running.
+    /// @param maxRunningJobs - number of jobs, 0 for no limit.
+    void setMaxRunningJobs(int64_t maxRunningJobs);
+
+    int64_t getMaxRunningJobs() const;
+
+    /// Set the advice added to the message of rejected queries, such as
+    /// which czar is less loaded, empty for none.
+    void setRejectionHint(std::string const& hint);
+
+private:
+    AdmissionController(Config const& config, Pressure const& pressure);
+
+    /// @return an empty string if the first query queued in 'qClass' may start,
+    ///         or why it waits. Precondition: _mtx must be held.
+    std::string _blocker(QueryClass qClass, int64_t jobs, double cost) const;
+
+    void _release(QueryClass qClass, int64_t jobs, double cost);
+
+    /// Add the rejection hint to 'reason'. Precondition: _mtx must be held.
+    void _addHint(std::string& reason) const;
+
+    Config const _config;
+    Pressure const _pressure;
+
+    mutable std::mutex _mtx; ///< Protects members below
+    std::condition_variable _cv;
+    std::deque<QueryId> _queues[CLASS_COUNT]; ///< Waiting queries, in arrival order
+    std::map<QueryId, bool> _waiting;         ///< Waiting queries, true once cancelled
+    ClassStats _stats[CLASS_COUNT];
+    int64_t _runningJobs{0};   ///< Chunk jobs of running scan and async queries
+    int64_t _queuedJobs{0};    ///< Chunk jobs of waiting scan and async queries
+    int64_t _maxRunningJobs;   ///< Budget of _runningJobs, 0 for no limit
+    std::string _hint;         ///< Added to the message of rejected queries
+    double _runningCost{0.0};  ///< Cost of running scan and async queries
+};
+
+}}} // namespace lsst::qserv::ccontrol
+
+#endif // LSST_QSERV_CCONTROL_ADMISSIONCONTROLLER_H
@@ -0,0 +1,187 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "ccontrol/CzarLoadShare.h"
+
+// System headers
+#include <algorithm>
+#include <exception>
+#include <sstream>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "qmeta/QMeta.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.ccontrol.CzarLoadShare");
+
+/// Loads not updated for this many periods are ignored.
+int const MAX_AGE_PERIODS = 3;
+
+} // annonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace ccontrol {
+
+CzarLoadShare::CzarLoadShare(std::shared_ptr<qmeta::QMeta> const& qMeta, qmeta::CzarId czarId,
+                             std::string const& czarName, AdmissionController::Ptr const& admission,
+                             Config const& config)
+    : _qMeta(qMeta), _czarId(czarId), _czarName(czarName), _admission(admission), _config(config),
+      _localMaxRunningJobs(admission->getMaxRunningJobs()),
+      _thread(&CzarLoadShare::_run, this) {
+}
+
+
+CzarLoadShare::~CzarLoadShare() {
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _stop = true;
+    }
+    _stopCv.notify_all();
+    _thread.join();
+}
+
+
+int64_t CzarLoadShare::jobShare(int64_t clusterMaxRunningJobs, qmeta::CzarId czarId,
+                                std::vector<qmeta::QCzarLoad> const& loads) {
+    std::vector<int64_t> demands;
+    int64_t demand = 0;
+    int64_t total = 0;
+    for (auto const& load : loads) {
+        int64_t const jobs = load.runningJobs + load.queuedJobs;
+        demands.push_back(jobs);
+        total += jobs;
+        if (load.czarId == czarId) {
+            demand = jobs;
+        }
+    }
+    if (demands.empty()) {
+        return std::max<int64_t>(1, clusterMaxRunningJobs);
+    }
+    int64_t share = 0;
+    if (total <= clusterMaxRunningJobs) {
+        share = demand + (clusterMaxRunningJobs - total) / static_cast<int64_t>(demands.size());
+    } else {
+        // Raise the level until the czars asking for less than it are satisfied.
+        std::sort(demands.begin(), demands.end());
+        int64_t remaining = clusterMaxRunningJobs;
+        int64_t level = 0;
+        for (size_t j = 0; j < demands.size(); ++j) {
+            level = remaining / static_cast<int64_t>(demands.size() - j);
+            if (demands[j] > level) {
+                break;
+            }
+            remaining -= demands[j];
+        }
+        share = std::min(demand, level);
+    }
+    return std::max<int64_t>(1, share);
+}
+
+
+std::string CzarLoadShare::lessLoaded(qmeta::CzarId czarId, std::vector<qmeta::QCzarLoad> const& loads) {
+    auto busier = [](qmeta::QCzarLoad const& a, qmeta::QCzarLoad const& b) {
+        if (a.queuedQueries != b.queuedQueries) {
+            return a.queuedQueries > b.queuedQueries;
+        }
+        return a.runningQueries > b.runningQueries;
+    };
+    auto self = std::find_if(loads.begin(), loads.end(),
+                             [czarId](qmeta::QCzarLoad const& load) { return load.czarId == czarId; });
+    if (self == loads.end()) {
+        return std::string();
+    }
+    auto best = self;
+    for (auto iter = loads.begin(); iter != loads.end(); ++iter) {
+        if (busier(*best, *iter)) {
+            best = iter;
+        }
+    }
+    return (best == self) ? std::string() : best->czarName;
+}
+
+
+void CzarLoadShare::update() {
+    auto const local = _admission->getLoad();
+    qmeta::QCzarLoad self;
+    self.czarId = _czarId;
+    self.czarName = _czarName;
+    self.runningQueries = std::max(0, local.running);
+    self.queuedQueries = std::max(0, local.queued);
+    self.runningJobs = std::max<int64_t>(0, local.runningJobs);
+    self.queuedJobs = std::max<int64_t>(0, local.queuedJobs);
+
+    std::vector<qmeta::QCzarLoad> loads;
+    try {
+        _qMeta->updateCzarLoad(_czarId, self);
+        auto const period = std::chrono::duration_cast<std::chrono::seconds>(_config.period).count();
+        loads = _qMeta->getCzarLoads(static_cast<unsigned>(std::max<int64_t>(1, MAX_AGE_PERIODS * period)));
+    } catch (std::exception const& exc) {
+        // Keep the current budget until QMeta answers again.
+        LOGS(_log, LOG_LVL_WARN, "failed to exchange czar loads: " << exc.what());
+        return;
+    }
+
+    // The row of this czar may be a second older than its load.
+    auto iter = std::find_if(loads.begin(), loads.end(),
+                             [this](qmeta::QCzarLoad const& load) { return load.czarId == _czarId; });
+    if (iter != loads.end()) {
+        *iter = self;
+    } else {
+        loads.push_back(self);
+    }
+
+    std::string const other = lessLoaded(_czarId, loads);
+    _admission->setRejectionHint(other.empty() ? std::string()
+                                 : "Czar " + other + " is less loaded.");
+
+    if (_config.clusterMaxRunningJobs > 0) {
+        int64_t share = jobShare(_config.clusterMaxRunningJobs, _czarId, loads);
+        if (_localMaxRunningJobs > 0) {
+            share = std::min(share, _localMaxRunningJobs);
+        }
+        if (share != _admission->getMaxRunningJobs()) {
+            LOGS(_log, LOG_LVL_INFO, "share of the chunk jobs budget of " << loads.size()
+                 << " czars: " << share << " of " << _config.clusterMaxRunningJobs);
+        }
+        _admission->setMaxRunningJobs(share);
+    }
+}
+
+
+void CzarLoadShare::_run() {
+    std::unique_lock<std::mutex> lock(_mtx);
+    while (not _stop) {
+        lock.unlock();
+        update();
+        lock.lock();
+        _stopCv.wait_for(lock, _config.period, [this] { return _stop; });
+    }
+}
+
+}}} // namespace lsst::qserv::ccontrol
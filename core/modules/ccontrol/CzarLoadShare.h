@@ -0,0 +1,120 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_CCONTROL_CZARLOADSHARE_H
+#define LSST_QSERV_CCONTROL_CZARLOADSHARE_H
+
+// System headers
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Qserv headers
+#include "ccontrol/AdmissionController.h"
+#include "qmeta/QCzarLoad.h"
+#include "qmeta/types.h"
+
+// Forward declarations
+namespace lsst {
+namespace qserv {
+namespace qmeta {
+class QMeta;
+}}}
+
+namespace lsst {
+namespace qserv {
+namespace ccontrol {
+
+/// CzarLoadShare coordinates the czars of a cluster through QMeta. A thread
+/// periodically advertises the load of this czar's AdmissionController in
+/// its QCzar row and reads the loads of the other active czars. From them it
+/// sets the chunk jobs budget of this czar to its share of the budget of all
+/// czars, so that together they do not dispatch more jobs than the workers
+/// were sized for, and it tells the controller which czar to suggest to the
+/// users of rejected queries.
+///
+/// Loads are only as fresh as the update period, a czar that stopped
+/// updating its load is ignored once it is older than a few periods.
+class CzarLoadShare {
+public:
+    struct Config {
+        int64_t clusterMaxRunningJobs{0}; ///< Jobs budget of all czars, 0 to only advertise the load
+        std::chrono::milliseconds period{std::chrono::seconds(5)};
+    };
+
+    /// @param qMeta - where the loads are advertised.
+    /// @param czarId - ID of this czar in QMeta.
+    /// @param czarName - name of this czar, for the logs.
+    /// @param admission - controller of this czar's queries.
+    /// @param config - budget and update period.
+    CzarLoadShare(std::shared_ptr<qmeta::QMeta> const& qMeta, qmeta::CzarId czarId,
+                  std::string const& czarName, AdmissionController::Ptr const& admission,
+                  Config const& config);
+
+    CzarLoadShare(CzarLoadShare const&) = delete;
+    CzarLoadShare& operator=(CzarLoadShare const&) = delete;
+
+    /// Stop the thread.
+    ~CzarLoadShare();
+
+    /// Share 'clusterMaxRunningJobs' between the czars by max-min fairness:
+    /// a czar asking for less than an equal share gets what it asks for, and
+    /// the others split what remains. A czar asks for the jobs of its running
+    /// and queued queries, and what no czar asks for is split evenly so that
+    /// new queries can start without waiting for the next update.
+    /// @return the share of czar 'czarId', at least 1 job.
+    static int64_t jobShare(int64_t clusterMaxRunningJobs, qmeta::CzarId czarId,
+                            std::vector<qmeta::QCzarLoad> const& loads);
+
+    /// @return the name of the czar with the fewest queued and then running
+    ///         queries, if it is less loaded than czar 'czarId', or an
+    ///         empty string.
+    static std::string lessLoaded(qmeta::CzarId czarId, std::vector<qmeta::QCzarLoad> const& loads);
+
+    /// Advertise the load of this czar and update its budget and hint.
+    void update();
+
+private:
+    void _run();
+
+    std::shared_ptr<qmeta::QMeta> const _qMeta;
+    qmeta::CzarId const _czarId;
+    std::string const _czarName;
+    AdmissionController::Ptr const _admission;
+    Config const _config;
+    int64_t const _localMaxRunningJobs; ///< Budget of this czar alone, 0 for no limit
+
+    std::mutex _mtx;   ///< Protects _stop
+    std::condition_variable _stopCv;
+    bool _stop{false};
+
+    std::thread _thread;
+};
+
+}}} // namespace lsst::qserv::ccontrol
+
+#endif // LSST_QSERV_CCONTROL_CZARLOADSHARE_H
@@ -0,0 +1,220 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "ccontrol/MergeBufferPool.h"
+
+// System headers
+#include <algorithm>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+namespace {
+LOG_LOGGER _log = LOG_GET("lsst.qserv.ccontrol.MergeBufferPool");
+
+int const CLASS_COUNT = 15; // 4KB to 64MB
+
+uint64_t const MB = 1024 * 1024;
+}
+
+namespace lsst {
+namespace qserv {
+namespace ccontrol {
+
+MergeBufferPool& MergeBufferPool::instance() {
+    // Never deleted, MergeBuffers may outlive static destruction.
+    static MergeBufferPool* pool = new MergeBufferPool(512 * MB);
+    return *pool;
+}
+
+
+MergeBufferPool::MergeBufferPool(uint64_t maxBytes)
+    : _idle(CLASS_COUNT), _maxBytes(maxBytes) {
+}
+
+
+void MergeBufferPool::setMaxBytes(uint64_t maxBytes) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _maxBytes = maxBytes;
+    // Free idle buffers, largest first, until the pool is under the cap.
+    for (int c = CLASS_COUNT - 1; c >= 0 && _inUseBytes + _idleBytes > _maxBytes; --c) {
+        auto& idle = _idle[c];
+        while (!idle.empty() && _inUseBytes + _idleBytes > _maxBytes) {
+            _idleBytes -= idle.back()->capacity();
+            idle.pop_back();
+        }
+    }
+}
+
+
+MergeBufferPool::BufPtr MergeBufferPool::borrow(size_t size) {
+    int const sizeClass = _classFor(size);
+    BufPtr buf;
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        ++_borrowCount;
+        if (sizeClass >= 0 && !_idle[sizeClass].empty()) {
+            buf = std::move(_idle[sizeClass].back());
+            _idle[sizeClass].pop_back();
+            _idleBytes -= buf->capacity();
+            ++_reuseCount;
+        }
+    }
+    if (buf == nullptr) {
+        buf.reset(new bufType());
+        buf->reserve(sizeClass >= 0 ? _classBytes(sizeClass) : size);
+    }
+    buf->resize(size);
+    std::lock_guard<std::mutex> lock(_mtx);
+    _inUseBytes += buf->capacity();
+    _updateHighWater();
+    return buf;
+}
+
+
+MergeBufferPool::BufPtr MergeBufferPool::adopt(bufType& buf) {
+    BufPtr adopted(new bufType());
+    adopted->swap(buf);
+    std::lock_guard<std::mutex> lock(_mtx);
+    _inUseBytes += adopted->capacity();
+    _updateHighWater();
+    return adopted;
+}
+
+
+void MergeBufferPool::giveBack(BufPtr buf) {
+    if (buf == nullptr) return;
+    size_t const capacity = buf->capacity();
+    int const sizeClass = _classOf(capacity);
+    std::lock_guard<std::mutex> lock(_mtx);
+    _inUseBytes -= std::min<uint64_t>(_inUseBytes, capacity);
+    if (sizeClass < 0 || _inUseBytes + _idleBytes + capacity > _maxBytes) {
+        return; // buf is freed
+    }
+    buf->clear();
+    _idleBytes += capacity;
+    _idle[sizeClass].push_back(std::move(buf));
+    _updateHighWater();
+}
+
+
+uint64_t MergeBufferPool::getMaxBytes() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _maxBytes;
+}
+
+
+uint64_t MergeBufferPool::getInUseBytes() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _inUseBytes;
+}
+
+
+uint64_t MergeBufferPool::getIdleBytes() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _idleBytes;
+}
+
+
+uint64_t MergeBufferPool::getHighWaterInUseBytes() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _highWaterInUse;
+}
+
+
+uint64_t MergeBufferPool::getHighWaterTotalBytes() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _highWaterTotal;
+}
+
+
+uint64_t MergeBufferPool::getBorrowCount() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _borrowCount;
+}
+
+
+uint64_t MergeBufferPool::getReuseCount() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _reuseCount;
+}
+
+
+void MergeBufferPool::getMessageRange(uint32_t& minBytes, uint32_t& maxBytes) const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    if (_maxBytes > 0 && _inUseBytes < _maxBytes / 4) {
+        minBytes = 1 * MB;
+        maxBytes = 8 * MB;
+    } else if (_maxBytes == 0 || _inUseBytes < _maxBytes / 4 * 3) {
+        minBytes = 256 * 1024;
+        maxBytes = 2 * MB;
+    } else {
+        minBytes = 64 * 1024;
+        maxBytes = 512 * 1024;
+    }
+}
+
+
+int MergeBufferPool::_classFor(size_t size) {
+    for (int c = 0; c < CLASS_COUNT; ++c) {
+        if (size <= _classBytes(c)) return c;
+    }
+    return -1;
+}
+
+
+int MergeBufferPool::_classOf(size_t capacity) {
+    for (int c = CLASS_COUNT - 1; c >= 0; --c) {
+        if (capacity >= _classBytes(c)) return c;
+    }
+    return -1;
+}
+
+
+void MergeBufferPool::_updateHighWater() {
+    _highWaterInUse = std::max(_highWaterInUse, _inUseBytes);
+    _highWaterTotal = std::max(_highWaterTotal, _inUseBytes + _idleBytes);
+    // Log each time the high water mark grows by 10%.
+    if (_highWaterTotal > _loggedHighWater + _loggedHighWater / 10 + MB) {
+        _loggedHighWater = _highWaterTotal;
+        LOGS(_log, LOG_LVL_INFO, "MergeBufferPool new high water mark highWaterTotalMB="
+             << _highWaterTotal / MB << " highWaterInUseMB=" << _highWaterInUse / MB
+             << " maxMB=" << _maxBytes / MB);
+    }
+}
+
+
+std::ostream& operator<<(std::ostream& os, MergeBufferPool const& pool) {
+    std::lock_guard<std::mutex> lock(pool._mtx);
+    os << "MergeBufferPool(maxBytes=" << pool._maxBytes
+       << " inUseBytes=" << pool._inUseBytes
+       << " idleBytes=" << pool._idleBytes
+       << " highWaterInUse=" << pool._highWaterInUse
+       << " highWaterTotal=" << pool._highWaterTotal
+       << " borrows=" << pool._borrowCount
+       << " reuses=" << pool._reuseCount << ")";
+    return os;
+}
+
+}}} // namespace lsst::qserv::ccontrol
@@ -0,0 +1,111 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_CCONTROL_MERGEBUFFERPOOL_H
+#define LSST_QSERV_CCONTROL_MERGEBUFFERPOOL_H
+
+// System headers
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lsst {
+namespace qserv {
+namespace ccontrol {
+
+/// MergeBufferPool keeps the buffers that MergingHandlers receive result
+/// messages in, so that a query with many jobs reuses a few large
+/// allocations instead of making and freeing one for every message.
+///
+/// Buffers are grouped in size classes, powers of 2 from MIN_CLASS_BYTES to
+/// MAX_CLASS_BYTES. A borrowed buffer has the requested size and at least
+/// the capacity of its class. Larger requests are not pooled. Idle buffers
+/// are freed instead of kept once the pool holds more than the
+/// configured cap, in use and idle together.
+class MergeBufferPool {
+public:
+    using bufType = std::vector<char>;
+    using BufPtr = std::unique_ptr<bufType>;
+
+    static size_t const MIN_CLASS_BYTES = 4 * 1024;
+    static size_t const MAX_CLASS_BYTES = 64 * 1024 * 1024;
+
+    /// @return the czar-wide pool.
+    static MergeBufferPool& instance();
+
+    explicit MergeBufferPool(uint64_t maxBytes);
+    MergeBufferPool(MergeBufferPool const&) = delete;
+    MergeBufferPool& operator=(MergeBufferPool const&) = delete;
+
+    /// Set the cap on bytes held by the pool. 0 disables keeping idle buffers.
+    void setMaxBytes(uint64_t maxBytes);
+
+    /// @return a buffer whose size is 'size'.
+    BufPtr borrow(size_t size);
+
+    /// @return a buffer holding the contents of 'buf', which is left empty,
+    ///         counted as in use as if it had been borrowed.
+    BufPtr adopt(bufType& buf);
+
+    /// Return a buffer from borrow() or adopt() to the pool.
+    void giveBack(BufPtr buf);
+
+    uint64_t getMaxBytes() const;
+    uint64_t getInUseBytes() const;  ///< Capacity of buffers lent out.
+    uint64_t getIdleBytes() const;   ///< Capacity of buffers kept for reuse.
+    uint64_t getHighWaterInUseBytes() const;
+    uint64_t getHighWaterTotalBytes() const; ///< Highest in use plus idle.
+    uint64_t getBorrowCount() const;
+    uint64_t getReuseCount() const;  ///< Borrows served by an idle buffer.
+
+    /// Set the range of Result message sizes workers should be asked for.
+    /// Buffers in use hold messages received and not merged yet, so the
+    /// fuller the pool, the smaller the messages: they cost less czar memory
+    /// each and merging starts sooner. An idle pool asks for larger ones to
+    /// save per-message overhead.
+    void getMessageRange(uint32_t& minBytes, uint32_t& maxBytes) const;
+
+    friend std::ostream& operator<<(std::ostream& os, MergeBufferPool const& pool);
+
+private:
+    static int _classFor(size_t size);   ///< Smallest class holding 'size'.
+    static int _classOf(size_t capacity); ///< Largest class 'capacity' fits.
+    static size_t _classBytes(int sizeClass) { return MIN_CLASS_BYTES << sizeClass; }
+    void _updateHighWater(); ///< Precondition: _mtx must be held.
+
+    mutable std::mutex _mtx; ///< Protects all members
+    std::vector<std::vector<BufPtr>> _idle; ///< Idle buffers by size class.
+    uint64_t _maxBytes;
+    uint64_t _inUseBytes{0};
+    uint64_t _idleBytes{0};
+    uint64_t _highWaterInUse{0};
+    uint64_t _highWaterTotal{0};
+    uint64_t _loggedHighWater{0}; ///< _highWaterTotal when it was last logged.
+    uint64_t _borrowCount{0};
+    uint64_t _reuseCount{0};
+};
+
+}}} // namespace lsst::qserv::ccontrol
+
+#endif // LSST_QSERV_CCONTROL_MERGEBUFFERPOOL_H
@@ -25,23 +25,35 @@
 #include "ccontrol/MergingHandler.h"
 
 // System headers
+#include <algorithm>
 #include <cassert>
 
+// Third-party headers
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+
 // LSST headers
 #include "lsst/log/Log.h"
 
 // Qserv headers
+#include "ccontrol/MergeBufferPool.h"
 #include "ccontrol/msgCode.h"
 #include "global/Bug.h"
 #include "global/debugUtil.h"
 #include "global/MsgReceiver.h"
 #include "proto/ProtoHeaderWrap.h"
 #include "proto/ProtoImporter.h"
+#include "proto/ResultCompression.h"
 #include "proto/WorkerResponse.h"
+#include "qdisp/Executive.h"
 #include "qdisp/JobQuery.h"
+#include "qdisp/ScanCursors.h"
+#include "qmeta/QUsage.h"
 #include "rproc/InfileMerger.h"
 #include "util/common.h"
 #include "util/StringHash.h"
+#include "util/Timer.h"
+#include "util/Trace.h"
 
 using lsst::qserv::proto::ProtoImporter;
 using lsst::qserv::proto::ProtoHeader;
@@ -59,6 +71,7 @@ namespace ccontrol {
 
 std::atomic<std::int64_t> MergeBuffer::_totalBytes{0};
 std::atomic<int> MergeBuffer::_sequence{0};
+size_t const MergingHandler::resultSegmentSize = 4 * 1024 * 1024;
 
 ////////////////////////////////////////////////////////////////////////
 // MergingHandler public
@@ -66,9 +79,10 @@ std::atomic<int> MergeBuffer::_sequence{0};
 MergingHandler::MergingHandler(
     std::shared_ptr<MsgReceiver> msgReceiver,
     std::shared_ptr<rproc::InfileMerger> merger,
-    std::string const& tableName)
+    std::string const& tableName,
+    std::shared_ptr<util::QueryTrace> const& trace)
     : _msgReceiver{msgReceiver}, _infileMerger{merger}, _tableName{tableName},
-      _response{new WorkerResponse()} {
+      _response{new WorkerResponse()}, _trace{trace} {
     _initState();
 }
 
@@ -111,21 +125,28 @@ bool MergingHandler::flush(int bLen, bool& last, bool& largeResult) {
         if (_wName == "~") {
             _wName = _response->protoHeader.wname();
         }
+        _noteScanCursor();
 
         LOGS(_log, LOG_LVL_DEBUG, "HEADER_SIZE_WAIT: From:" << _wName
              << "Resizing buffer to " <<  _response->protoHeader.size());
-        _mBuf.zero(); // Free memory.
-        _mBuf.setTargetSize(_response->protoHeader.size());
+        _startResult();
         largeResult = _response->protoHeader.largeresult();
         _state = MsgState::RESULT_WAIT;
         return true;
 
     case MsgState::RESULT_WAIT:
+        if (_streaming) {
+            if (!_receiveSegment()) { return false; }
+            if (_streamLeft > 0) { return true; } // Wait for the next segment.
+        }
         {
             auto jobQuery = getJobQuery().lock();
             auto jobId = (jobQuery != nullptr) ? jobQuery->getIdStr() : "?";
-            if (!_verifyResult()) { return false; }
-            if (!_setResult()) { return false; } // set _response->result
+            if (!_streaming) {
+                if (!_verifyResult()) { return false; }
+                if (!_decompressResult()) { return false; }
+                if (!_setResult()) { return false; } // set _response->result
+            }
             largeResult = _response->result.largeresult();
             LOGS(_log, LOG_LVL_DEBUG, jobId << " From:" << _wName << " _mBuf "
                     << util::prettyCharList(_mBuf.getBuffer(), 5));
@@ -157,10 +178,10 @@ bool MergingHandler::flush(int bLen, bool& last, bool& largeResult) {
             return false;
         }
         largeResult = _response->protoHeader.largeresult();
+        _noteScanCursor();
         LOGS(_log, LOG_LVL_DEBUG, "RESULT_EXTRA: Resizing buffer to "
              << _response->protoHeader.size() << " largeResult=" << largeResult);
-        _mBuf.zero();
-        _mBuf.setTargetSize(_response->protoHeader.size());
+        _startResult();
         _state = MsgState::RESULT_WAIT;
         return true;
     case MsgState::RESULT_RECV:
@@ -223,6 +244,9 @@ std::ostream& MergingHandler::print(std::ostream& os) const {
 ////////////////////////////////////////////////////////////////////////
 
 void MergingHandler::_initState() {
+    _streaming = false;
+    _streamLeft = 0;
+    _partial.clear();
     _mBuf.setTargetSize(proto::ProtoHeaderWrap::PROTO_HEADER_SIZE);
     _state = MsgState::HEADER_SIZE_WAIT;
     _setError(0, "");
@@ -233,12 +257,43 @@ bool MergingHandler::_merge() {
         if (_flushed) {
             throw Bug("MergingRequester::_merge : already flushed");
         }
+        uint64_t const mergeStartUs = util::traceNowUs();
+        util::Timer mergeTimer;
+        mergeTimer.start();
         bool success = _infileMerger->merge(_response);
+        mergeTimer.stop();
+        if (auto exec = job->getExecutive()) {
+            // Retried attempts count too, the workers did the work.
+            qmeta::QUsage usage;
+            usage.bytesTransmitted = _response->protoHeader.size();
+            if (_response->result.has_usage()) {
+                proto::ResourceUsage const& workerUsage = _response->result.usage();
+                usage.cpuUs = workerUsage.cpuus();
+                usage.rowsRead = workerUsage.rowsread();
+                usage.memLockedBytes = workerUsage.memlockedbytes();
+            }
+            exec->addUsage(usage);
+        }
+        if (_trace != nullptr && _response != nullptr) {
+            proto::Result const& result = _response->result;
+            int const jobId = result.jobid();
+            int const attempt = result.attemptcount();
+            _trace->add("merge", jobId, attempt, mergeStartUs,
+                        static_cast<uint64_t>(mergeTimer.getElapsed() * 1e6));
+            for (auto const& span : result.span()) {
+                _trace->add(span.name(), jobId, attempt, span.startus(), span.durationus());
+            }
+        }
         if (!success) {
             LOGS(_log, LOG_LVL_WARN, "_merge() failed");
             rproc::InfileMergerError const& err = _infileMerger->getError();
             _setError(ccontrol::MSG_RESULT_ERROR, err.getMsg());
             _state = MsgState::RESULT_ERR;
+        } else if (_infileMerger->limitReached()) {
+            // Enough rows for the user query, the other jobs are not needed.
+            if (auto exec = job->getExecutive()) {
+                exec->squashSatisfied();
+            }
         }
         _response.reset();
         return success;
@@ -247,6 +302,16 @@ bool MergingHandler::_merge() {
     return false;
 }
 
+/// Tell qdisp::ScanCursors which worker has the chunk of this job, and where its scan is.
+void MergingHandler::_noteScanCursor() {
+    auto jobQuery = getJobQuery().lock();
+    if (jobQuery == nullptr) return;
+    proto::ProtoHeader const& header = _response->protoHeader;
+    int const cursor = header.has_scancursor() ? header.scancursor() : -1;
+    qdisp::ScanCursors::instance().update(header.wname(),
+                                          jobQuery->getDescription()->resource().chunk(), cursor);
+}
+
 void MergingHandler::_setError(int code, std::string const& msg) {
     LOGS(_log, LOG_LVL_DEBUG, "_setErr: code: " << code << ", message: " << msg);
     std::lock_guard<std::mutex> lock(_errorMutex);
@@ -267,21 +332,166 @@ bool MergingHandler::_setResult() {
     return true;
 }
 bool MergingHandler::_verifyResult() {
-    auto buff = _mBuf.getBuffer();
-    if (_response->protoHeader.md5() != util::StringHash::getMd5(buff.data(), _mBuf.getSize())) {
-        _setError(ccontrol::MSG_RESULT_MD5, "Result message MD5 mismatch");
+    auto& buff = _mBuf.getBuffer();
+    auto const& header = _response->protoHeader;
+    switch (header.checksum()) {
+    case ProtoHeader::CRC32C:
+        if (header.crc32c() != util::StringHash::getCrc32c(buff.data(), _mBuf.getSize())) {
+            _setError(ccontrol::MSG_RESULT_MD5, "Result message CRC32C mismatch");
+            _state = MsgState::RESULT_ERR;
+            return false;
+        }
+        return true;
+    case ProtoHeader::MD5:
+        if (header.md5() != util::StringHash::getMd5(buff.data(), _mBuf.getSize())) {
+            _setError(ccontrol::MSG_RESULT_MD5, "Result message MD5 mismatch");
+            _state = MsgState::RESULT_ERR;
+            return false;
+        }
+        return true;
+    }
+    _setError(ccontrol::MSG_RESULT_MD5, "Result message has unknown checksum type");
+    _state = MsgState::RESULT_ERR;
+    return false;
+}
+
+
+/// Decompress the result message in _mBuf, if the worker compressed it.
+bool MergingHandler::_decompressResult() {
+    auto codec = _response->protoHeader.compression();
+    if (codec == proto::ProtoHeader::NONE) {
+        return true;
+    }
+    auto start = std::chrono::system_clock::now();
+    MergeBuffer::bufType uncompressed;
+    auto& buff = _mBuf.getBuffer();
+    if (!proto::ResultCompression::decompress(codec, buff.data(), _mBuf.getSize(),
+                                              _response->protoHeader.uncompressedsize(), uncompressed)) {
+        _setError(ccontrol::MSG_RESULT_DECODE, "Error decompressing result msg From:" + _wName);
         _state = MsgState::RESULT_ERR;
         return false;
     }
+    _mBuf.swapIn(uncompressed);
+    auto end = std::chrono::system_clock::now();
+    LOGS(_log, LOG_LVL_DEBUG, "decompressDur="
+         << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
     return true;
 }
 
 
+/// Prepare _mBuf for the Result message described by the header. Large messages
+/// that are neither compressed nor checked with MD5 are received in segments,
+/// so the whole message is never held in _mBuf and decoding overlaps receiving.
+void MergingHandler::_startResult() {
+    auto const& header = _response->protoHeader;
+    size_t const size = header.size();
+    _mBuf.zero(); // Free memory.
+    _streaming = header.compression() == ProtoHeader::NONE && header.checksum() == ProtoHeader::CRC32C
+                 && size > resultSegmentSize;
+    _streamLeft = _streaming ? size : 0;
+    _crc = 0;
+    _partial.clear();
+    _mBuf.setTargetSize(_streaming ? resultSegmentSize : size);
+}
+
+
+/// Merge the complete fields of the segment in _mBuf into _response->result,
+/// keeping the bytes of the field that continues into the next segment.
+/// The checksum is verified with the last segment.
+bool MergingHandler::_receiveSegment() {
+    auto& buff = _mBuf.getBuffer();
+    size_t const size = std::min(_mBuf.getSize(), _streamLeft);
+    _crc = util::StringHash::getCrc32c(buff.data(), size, _crc);
+    _streamLeft -= size;
+    char const* data = buff.data();
+    size_t dataSize = size;
+    if (!_partial.empty()) {
+        _partial.insert(_partial.end(), buff.begin(), buff.begin() + size);
+        data = _partial.data();
+        dataSize = _partial.size();
+    }
+    int const used = _mergeFields(data, dataSize);
+    if (used < 0) {
+        _setError(ccontrol::MSG_RESULT_DECODE, "Error decoding result msg segment From:" + _wName);
+        _state = MsgState::RESULT_ERR;
+        return false;
+    }
+    std::vector<char> tail(data + used, data + dataSize);
+    _partial.swap(tail);
+    if (_streamLeft > 0) {
+        _mBuf.setTargetSize(std::min(_streamLeft, resultSegmentSize));
+        return true;
+    }
+    _mBuf.zero();
+    if (_crc != _response->protoHeader.crc32c()) {
+        _setError(ccontrol::MSG_RESULT_MD5, "Result message CRC32C mismatch");
+        _state = MsgState::RESULT_ERR;
+        return false;
+    }
+    if (!_partial.empty() || !_response->result.IsInitialized()) {
+        _setError(ccontrol::MSG_RESULT_DECODE, "Error decoding result msg");
+        _state = MsgState::RESULT_ERR;
+        return false;
+    }
+    std::vector<char>().swap(_partial); // Free memory.
+    return true;
+}
+
+
+/// Merge the complete top level fields at the start of 'data' into _response->result.
+/// @return the number of bytes merged, or -1 if 'data' is not part of a Result message.
+int MergingHandler::_mergeFields(char const* data, int size) {
+    using google::protobuf::internal::WireFormatLite;
+    auto const bytes = reinterpret_cast<std::uint8_t const*>(data);
+    google::protobuf::io::CodedInputStream in(bytes, size);
+    int complete = 0;
+    while (true) {
+        std::uint32_t const tag = in.ReadTag();
+        if (tag == 0) {
+            break; // All fields read, or the start of one that continues.
+        }
+        bool read = false;
+        switch (WireFormatLite::GetTagWireType(tag)) {
+        case WireFormatLite::WIRETYPE_VARINT: {
+            std::uint64_t value;
+            read = in.ReadVarint64(&value);
+            break;
+        }
+        case WireFormatLite::WIRETYPE_FIXED64:
+            read = in.Skip(8);
+            break;
+        case WireFormatLite::WIRETYPE_FIXED32:
+            read = in.Skip(4);
+            break;
+        case WireFormatLite::WIRETYPE_LENGTH_DELIMITED: {
+            std::uint32_t length;
+            read = in.ReadVarint32(&length) && in.Skip(length);
+            break;
+        }
+        default:
+            return -1; // Result has no groups.
+        }
+        if (!read) {
+            break;
+        }
+        complete = in.CurrentPosition();
+    }
+    if (complete > 0) {
+        google::protobuf::io::CodedInputStream fields(bytes, complete);
+        if (!_response->result.MergePartialFromCodedStream(&fields)) {
+            return -1;
+        }
+    }
+    return complete;
+}
+
+
 MergeBuffer::~MergeBuffer() {
     if (_buff != nullptr && _buff->size() != 0) {
         _totalBytes -= _buff->size();
         LOGS(_log, LOG_LVL_DEBUG, _id << " ~ totalBytes=" << _totalBytes);
     }
+    MergeBufferPool::instance().giveBack(std::move(_buff));
 }
 
 
@@ -318,15 +528,37 @@ void MergeBuffer::zero() {
         _totalBytes -= _buff->size();
         LOGS(_log, LOG_LVL_DEBUG, _id << " zero totalBytes=" << _totalBytes);
     }
-    // Just resizing to 0 would not guarantee freeing the memory.
+    // Just resizing to 0 would not guarantee freeing the memory, so the
+    // buffer goes back to the pool for the next message that needs one.
+    MergeBufferPool::instance().giveBack(std::move(_buff));
     _buff.reset(new bufType(0));
  }
 
 
+void MergeBuffer::swapIn(bufType& buff) {
+    if (_buff == nullptr) {
+        zero();
+    }
+    _totalBytes += static_cast<std::int64_t>(buff.size()) - _buff->size();
+    auto& pool = MergeBufferPool::instance();
+    pool.giveBack(std::move(_buff));
+    _buff = pool.adopt(buff);
+    _targetSize = _buff->size();
+    LOGS(_log, LOG_LVL_DEBUG, _id << " swapIn totalBytes=" << _totalBytes);
+}
+
+
  void MergeBuffer::_resize(int sz) {
      if (sz != (int)_buff->size()) {
          _totalBytes += sz - _buff->size();
-         _buff->resize(sz);
+         if (static_cast<size_t>(sz) > _buff->capacity()) {
+             // Borrow a buffer that is large enough rather than growing this one.
+             auto& pool = MergeBufferPool::instance();
+             pool.giveBack(std::move(_buff));
+             _buff = pool.borrow(sz);
+         } else {
+             _buff->resize(sz);
+         }
          LOGS(_log, LOG_LVL_DEBUG, _id << " resize totalBytes=" << _totalBytes);
      } else if (sz != 0) {
          LOGS(_log, LOG_LVL_WARN, _id << " resize called twice sz=" << sz << " totalBytes=" << _totalBytes);
@@ -40,6 +40,9 @@ namespace proto {
 }
 namespace rproc {
   class InfileMerger;
+}
+namespace util {
+  class QueryTrace;
 }}}
 
 namespace lsst {
@@ -49,8 +52,9 @@ namespace ccontrol {
 /// A class to delay creating the buffer until it is requested
 /// by xrootd SSI. The size of the buffer that will be needed is
 /// set using setTargetSize(int sz), and the buffer of that size is
-/// created by calling resizeToTargetSize(). When a buffer is no longer
-/// needed, zero() should be called to free the memory.
+/// borrowed from the MergeBufferPool by calling resizeToTargetSize().
+/// When a buffer is no longer needed, zero() should be called to return
+/// the memory to the pool.
 class MergeBuffer {
 public:
     using bufType = std::vector<char>;
@@ -66,10 +70,12 @@ public:
     bufType& getBuffer();
     size_t getSize(); ///< @return the current size of the buffer.
     /// @return the size the buffer needs to be when data is ready.
-    size_t getTargetSize() { return _targetSize; }
+    size_t getTargetSize() const { return _targetSize; }
     void setTargetSize(int sz);
     void resizeToTargetSize();
     void zero(); ///< Set buffer size and _targetSize to zero, ensure memory is freed.
+    /// Replace the contents of the buffer with 'buff', which is left empty.
+    void swapIn(bufType& buff);
 
 
 private:
@@ -104,9 +110,11 @@ public:
     /// @param msgReceiver Message code receiver
     /// @param merger downstream merge acceptor
     /// @param tableName target table for incoming data
+    /// @param trace receives the merge and worker spans of a traced query, may be null
     MergingHandler(std::shared_ptr<MsgReceiver> msgReceiver,
                      std::shared_ptr<rproc::InfileMerger> merger,
-                     std::string const& tableName);
+                     std::string const& tableName,
+                     std::shared_ptr<util::QueryTrace> const& trace=nullptr);
 
     /// @return a char vector to receive the next message. The vector
     /// should be sized to the request size. The buffer will be filled
@@ -126,6 +134,15 @@ public:
     /// @return true if successful (no error)
     bool flush(int bLen, bool& last, bool& largeResult) override;
 
+    /// Only the last buffer of a Result message is merged, headers and the
+    /// segments of a large message are decoded right away.
+    bool flushMayBlock() const override {
+        return _state == MsgState::RESULT_WAIT && (!_streaming || _streamLeft <= _mBuf.getTargetSize());
+    }
+
+    /// Result messages larger than this are received in segments of this size.
+    static size_t const resultSegmentSize;
+
     /// Signal an unrecoverable error condition. No further calls are expected.
     void errorFlush(std::string const& msg, int code) override;
 
@@ -151,8 +168,13 @@ private:
     void _initState();
     bool _merge();
     void _setError(int code, std::string const& msg);
+    void _noteScanCursor();
     bool _setResult();
     bool _verifyResult();
+    bool _decompressResult();
+    void _startResult();
+    bool _receiveSegment();
+    int _mergeFields(char const* data, int size);
 
 
     std::shared_ptr<MsgReceiver> _msgReceiver; ///< Message code receiver
@@ -165,6 +187,14 @@ private:
     std::shared_ptr<proto::WorkerResponse> _response; ///< protobufs msg buf
     bool _flushed {false}; ///< flushed to InfileMerger?
     std::string _wName {"~"}; /// worker name
+    std::shared_ptr<util::QueryTrace> _trace; ///< May be null
+
+    // A large Result message is received in segments, its complete fields are
+    // merged into _response->result as they arrive, see _receiveSegment().
+    bool _streaming{false}; ///< The Result message is received in segments.
+    size_t _streamLeft{0}; ///< Bytes of the Result message not received yet, current segment included.
+    std::uint32_t _crc{0}; ///< CRC32C of the segments received so far.
+    std::vector<char> _partial; ///< Bytes of a field that continues in the next segment.
 };
 
 }}} // namespace lsst::qserv::qdisp
@@ -0,0 +1,266 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "ccontrol/ResultTableCache.h"
+
+// System headers
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.ccontrol.ResultTableCache");
+
+/// Functions whose value changes between two runs of the same query.
+char const* const volatileFunctions[] = {
+    "now", "sysdate", "curdate", "curtime", "current_date", "current_time",
+    "current_timestamp", "localtime", "localtimestamp", "unix_timestamp",
+    "utc_date", "utc_time", "utc_timestamp", "rand", "uuid", "uuid_short",
+    "connection_id", "last_insert_id", "found_rows", "row_count", "sleep"
+};
+
+/// @return true if 'text', in lower case, calls function 'name'.
+bool callsFunction(std::string const& text, std::string const& name) {
+    for (auto pos = text.find(name); pos != std::string::npos; pos = text.find(name, pos + 1)) {
+        if (pos > 0 && (std::isalnum(static_cast<unsigned char>(text[pos - 1])) || text[pos - 1] == '_')) {
+            continue;
+        }
+        auto next = pos + name.size();
+        if (next < text.size() && text[next] == ' ') {
+            ++next;
+        }
+        if (next < text.size() && text[next] == '(') {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // annonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace ccontrol {
+
+ResultTableCache::ResultTableCache(uint64_t maxBytes, uint64_t maxEntryBytes,
+                                   std::chrono::seconds ttl, std::chrono::seconds dropDelay,
+                                   DropTable const& dropTable, TableBytes const& tableBytes)
+    : _maxBytes(maxBytes), _maxEntryBytes(std::min(maxEntryBytes, maxBytes)),
+      _ttl(ttl), _dropDelay(dropDelay), _dropTable(dropTable), _tableBytes(tableBytes) {
+}
+
+
+std::string ResultTableCache::makeKey(std::string const& query, std::string const& defaultDb) {
+    // Collapse white space outside of quoted strings and identifiers.
+    std::string normalized;
+    char quote = 0;
+    bool space = false;
+    for (char c : query) {
+        if (quote != 0) {
+            normalized += c;
+            if (c == quote) {
+                quote = 0;
+            }
+            continue;
+        }
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            space = true;
+            continue;
+        }
+        if (space && !normalized.empty()) {
+            normalized += ' ';
+        }
+        space = false;
+        if (c == '\'' || c == '"' || c == '`') {
+            quote = c;
+        }
+        normalized += c;
+    }
+    while (!normalized.empty() && (normalized.back() == ';' || normalized.back() == ' ')) {
+        normalized.pop_back();
+    }
+
+    std::string lower(normalized);
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    if (lower.find("sql_no_cache") != std::string::npos) {
+        return std::string();
+    }
+    for (char const* name : volatileFunctions) {
+        if (callsFunction(lower, name)) {
+            return std::string();
+        }
+    }
+    return defaultDb + "\n" + normalized;
+}
+
+
+uint64_t ResultTableCache::getGeneration() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _generation;
+}
+
+
+bool ResultTableCache::get(std::string const& key, Entry& entry, Clock::time_point now) {
+    bool found = false;
+    std::vector<std::string> droppable;
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        auto iter = _index.find(key);
+        if (iter != _index.end() && iter->second->expires <= now) {
+            _evict(iter->second, now);
+            iter = _index.end();
+        }
+        if (iter == _index.end()) {
+            ++_missCount;
+        } else {
+            ++_hitCount;
+            _entries.splice(_entries.begin(), _entries, iter->second);
+            entry = iter->second->entry;
+            found = true;
+        }
+        droppable = _takeDroppable(now);
+    }
+    _drop(droppable);
+    return found;
+}
+
+
+bool ResultTableCache::put(std::string const& key, Entry const& entry, uint64_t generation,
+                           Clock::time_point now) {
+    int64_t const bytes = (_maxBytes == 0) ? -1 : _tableBytes(entry.table);
+    bool kept = false;
+    std::vector<std::string> droppable;
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        if (bytes < 0 || static_cast<uint64_t>(bytes) > _maxEntryBytes || generation != _generation) {
+            LOGS(_log, LOG_LVL_DEBUG, "not caching " << entry.table << " bytes=" << bytes
+                 << " generation=" << generation << "/" << _generation);
+            _retired.emplace_back(now + _dropDelay, entry.table);
+        } else {
+            // An identical query may have completed in the meantime.
+            auto iter = _index.find(key);
+            if (iter != _index.end()) {
+                _evict(iter->second, now);
+            }
+            _entries.push_front(Cached{key, entry, static_cast<uint64_t>(bytes), now + _ttl});
+            _index[key] = _entries.begin();
+            _bytes += bytes;
+            while (_bytes > _maxBytes) {
+                _evict(std::prev(_entries.end()), now);
+            }
+            kept = true;
+        }
+        droppable = _takeDroppable(now);
+    }
+    _drop(droppable);
+    return kept;
+}
+
+
+void ResultTableCache::retire(std::string const& table, Clock::time_point now) {
+    std::vector<std::string> droppable;
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _retired.emplace_back(now + _dropDelay, table);
+        droppable = _takeDroppable(now);
+    }
+    _drop(droppable);
+}
+
+
+void ResultTableCache::invalidate(Clock::time_point now) {
+    std::vector<std::string> droppable;
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        ++_generation;
+        while (!_entries.empty()) {
+            _evict(_entries.begin(), now);
+        }
+        droppable = _takeDroppable(now);
+    }
+    LOGS(_log, LOG_LVL_INFO, "result cache invalidated");
+    _drop(droppable);
+}
+
+
+/// Move the table of 'iter' to the retired tables.
+/// Precondition: _mtx must be held.
+void ResultTableCache::_evict(std::list<Cached>::iterator iter, Clock::time_point now) {
+    _retired.emplace_back(now + _dropDelay, iter->entry.table);
+    _bytes -= iter->bytes;
+    _index.erase(iter->key);
+    _entries.erase(iter);
+}
+
+
+/// @return the retired tables that may be dropped at 'now', removing them.
+/// Precondition: _mtx must be held.
+std::vector<std::string> ResultTableCache::_takeDroppable(Clock::time_point now) {
+    std::vector<std::string> tables;
+    // Delays are all the same, so tables are retired in the order they can be dropped.
+    while (!_retired.empty() && _retired.front().first <= now) {
+        tables.push_back(std::move(_retired.front().second));
+        _retired.pop_front();
+    }
+    return tables;
+}
+
+
+void ResultTableCache::_drop(std::vector<std::string> const& tables) {
+    for (auto const& table : tables) {
+        LOGS(_log, LOG_LVL_DEBUG, "dropping result table " << table);
+        _dropTable(table);
+    }
+}
+
+
+size_t ResultTableCache::size() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _entries.size();
+}
+
+
+uint64_t ResultTableCache::getBytes() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _bytes;
+}
+
+
+uint64_t ResultTableCache::getHitCount() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _hitCount;
+}
+
+
+uint64_t ResultTableCache::getMissCount() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _missCount;
+}
+
+}}} // namespace lsst::qserv::ccontrol
@@ -0,0 +1,142 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_CCONTROL_RESULTTABLECACHE_H
+#define LSST_QSERV_CCONTROL_RESULTTABLECACHE_H
+
+// System headers
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace lsst {
+namespace qserv {
+namespace ccontrol {
+
+/// ResultTableCache keeps the result tables of recently completed SELECT
+/// queries in the result database, so that the same query sent again, as
+/// the portal does, is answered from the table without dispatching any job.
+///
+/// Entries are keyed by the normalized query text and the default database.
+/// CSS has no version of the data, so a SELECT result is kept for at most
+/// the TTL, and every entry is dropped when a database or table is dropped
+/// or the empty chunk lists are flushed. A query started before such an
+/// invalidation, as told by its generation, does not store its result.
+///
+/// Tables leaving the cache are only dropped after a delay, as the proxy
+/// may still be reading them: it reads a result once the query is done,
+/// without telling the czar when it is finished.
+class ResultTableCache {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// Drops the named table of the result database.
+    using DropTable = std::function<void(std::string const& table)>;
+
+    /// @return the size in bytes of the named table of the result database,
+    ///         a negative value if it is unknown.
+    using TableBytes = std::function<int64_t(std::string const& table)>;
+
+    struct Entry {
+        std::string table;   ///< Result table, without database name
+        std::string orderBy; ///< ORDER BY clause the proxy applies to the table
+    };
+
+    /// @param maxBytes - size of all cached tables, 0 disables the cache.
+    /// @param maxEntryBytes - size of a table above which it is not cached.
+    /// @param ttl - time a result is served for.
+    /// @param dropDelay - time a table leaving the cache is kept for its readers.
+    ResultTableCache(uint64_t maxBytes, uint64_t maxEntryBytes,
+                     std::chrono::seconds ttl, std::chrono::seconds dropDelay,
+                     DropTable const& dropTable, TableBytes const& tableBytes);
+
+    ResultTableCache(ResultTableCache const&) = delete;
+    ResultTableCache& operator=(ResultTableCache const&) = delete;
+
+    /// @return the key of 'query' run with 'defaultDb', or an empty string if
+    ///         the result of 'query' cannot be reused, e.g. it calls NOW().
+    static std::string makeKey(std::string const& query, std::string const& defaultDb);
+
+    /// @return the current generation, to be passed to put().
+    uint64_t getGeneration() const;
+
+    /// Find the result table of 'key' into 'entry'.
+    /// @return false if it is not cached or has expired.
+    bool get(std::string const& key, Entry& entry, Clock::time_point now=Clock::now());
+
+    /// Keep 'entry', the result of the query of 'key' started at 'generation',
+    /// dropping the least recently used tables to make room. The table is
+    /// dropped instead if it is too large or the cache was invalidated since.
+    /// @return true if the table was kept.
+    bool put(std::string const& key, Entry const& entry, uint64_t generation,
+             Clock::time_point now=Clock::now());
+
+    /// Drop 'table', a result table meant for the cache that is not kept.
+    void retire(std::string const& table, Clock::time_point now=Clock::now());
+
+    /// Drop all cached tables, and refuse those of the queries running now.
+    void invalidate(Clock::time_point now=Clock::now());
+
+    size_t size() const;
+    uint64_t getBytes() const;
+    uint64_t getHitCount() const;
+    uint64_t getMissCount() const;
+
+private:
+    struct Cached {
+        std::string key;
+        Entry entry;
+        uint64_t bytes;
+        Clock::time_point expires;
+    };
+    using Retired = std::pair<Clock::time_point, std::string>; ///< Drop time and table
+
+    void _evict(std::list<Cached>::iterator iter, Clock::time_point now);
+    std::vector<std::string> _takeDroppable(Clock::time_point now);
+    void _drop(std::vector<std::string> const& tables);
+
+    uint64_t const _maxBytes;
+    uint64_t const _maxEntryBytes;
+    std::chrono::seconds const _ttl;
+    std::chrono::seconds const _dropDelay;
+    DropTable const _dropTable;
+    TableBytes const _tableBytes;
+
+    mutable std::mutex _mtx; ///< Protects all members below
+    std::list<Cached> _entries; ///< Most recently used first
+    std::unordered_map<std::string, std::list<Cached>::iterator> _index;
+    std::list<Retired> _retired; ///< Tables to drop, oldest first
+    uint64_t _bytes{0};
+    uint64_t _generation{0};
+    uint64_t _hitCount{0};
+    uint64_t _missCount{0};
+};
+
+}}} // namespace lsst::qserv::ccontrol
+
+#endif // LSST_QSERV_CCONTROL_RESULTTABLECACHE_H
@@ -0,0 +1,94 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "ccontrol/SelectStmtCache.h"
+
+// Qserv headers
+#include "query/SelectStmt.h"
+
+namespace lsst {
+namespace qserv {
+namespace ccontrol {
+
+SelectStmtCache::SelectStmtCache(size_t maxEntries) : _maxEntries(maxEntries) {
+}
+
+
+std::shared_ptr<query::SelectStmt> SelectStmtCache::get(std::string const& query) {
+    std::shared_ptr<query::SelectStmt const> stmt;
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        auto iter = _index.find(query);
+        if (iter == _index.end()) {
+            ++_missCount;
+            return nullptr;
+        }
+        ++_hitCount;
+        _entries.splice(_entries.begin(), _entries, iter->second);
+        stmt = iter->second->second;
+    }
+    // Cached statements are never modified, copy outside the lock.
+    return stmt->clone();
+}
+
+
+void SelectStmtCache::put(std::string const& query, query::SelectStmt const& stmt) {
+    if (_maxEntries == 0) {
+        return;
+    }
+    std::shared_ptr<query::SelectStmt const> copy = stmt.clone();
+    std::lock_guard<std::mutex> lock(_mtx);
+    auto iter = _index.find(query);
+    if (iter != _index.end()) {
+        iter->second->second = copy;
+        _entries.splice(_entries.begin(), _entries, iter->second);
+        return;
+    }
+    _entries.emplace_front(query, copy);
+    _index[query] = _entries.begin();
+    if (_entries.size() > _maxEntries) {
+        _index.erase(_entries.back().first);
+        _entries.pop_back();
+    }
+}
+
+
+size_t SelectStmtCache::size() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _entries.size();
+}
+
+
+uint64_t SelectStmtCache::getHitCount() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _hitCount;
+}
+
+
+uint64_t SelectStmtCache::getMissCount() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _missCount;
+}
+
+}}} // namespace lsst::qserv::ccontrol
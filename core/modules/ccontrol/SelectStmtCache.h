@@ -0,0 +1,77 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_CCONTROL_SELECTSTMTCACHE_H
+#define LSST_QSERV_CCONTROL_SELECTSTMTCACHE_H
+
+// System headers
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace lsst {
+namespace qserv {
+namespace query {
+class SelectStmt;
+}
+
+namespace ccontrol {
+
+/// SelectStmtCache keeps the statements parsed from the most recently seen
+/// SELECT queries, so that a query sent again, as dashboards do, skips the
+/// parser. Entries are keyed by the exact query text and handed out as
+/// copies, because query analysis modifies the statement it is given.
+class SelectStmtCache {
+public:
+    /// @param maxEntries - number of statements kept, 0 disables the cache.
+    explicit SelectStmtCache(size_t maxEntries);
+    SelectStmtCache(SelectStmtCache const&) = delete;
+    SelectStmtCache& operator=(SelectStmtCache const&) = delete;
+
+    /// @return a copy of the statement parsed from 'query', nullptr if not cached.
+    std::shared_ptr<query::SelectStmt> get(std::string const& query);
+
+    /// Keep a copy of 'stmt', parsed from 'query', dropping the least
+    /// recently used statement if the cache is full.
+    void put(std::string const& query, query::SelectStmt const& stmt);
+
+    size_t size() const;
+    uint64_t getHitCount() const;
+    uint64_t getMissCount() const;
+
+private:
+    using Entry = std::pair<std::string, std::shared_ptr<query::SelectStmt const>>;
+
+    size_t const _maxEntries;
+    mutable std::mutex _mtx; ///< Protects all members below
+    std::list<Entry> _entries; ///< Most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> _index;
+    uint64_t _hitCount{0};
+    uint64_t _missCount{0};
+};
+
+}}} // namespace lsst::qserv::ccontrol
+
+#endif // LSST_QSERV_CCONTROL_SELECTSTMTCACHE_H
@@ -0,0 +1,278 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "ccontrol/SemiJoin.h"
+
+// System headers
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "css/CssAccess.h"
+#include "query/AndTerm.h"
+#include "query/BoolFactor.h"
+#include "query/ColumnRef.h"
+#include "query/CompPredicate.h"
+#include "query/FromList.h"
+#include "query/InPredicate.h"
+#include "query/JoinRef.h"
+#include "query/JoinSpec.h"
+#include "query/OrTerm.h"
+#include "query/QueryTemplate.h"
+#include "query/SelectStmt.h"
+#include "query/SqlSQL2Tokens.h"
+#include "query/TableRef.h"
+#include "query/ValueExpr.h"
+#include "query/ValueFactor.h"
+#include "query/WhereClause.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.ccontrol.SemiJoin");
+
+using namespace lsst::qserv;
+
+typedef std::vector<std::shared_ptr<query::BoolTerm const>> TermVector;
+typedef std::pair<query::ColumnRef::Ptr, query::ColumnRef::Ptr> Equality;
+
+/// A table of the join.
+struct Side {
+    Side(query::TableRef const& ref, std::string const& defaultDb)
+        : db(ref.getDb().empty() ? defaultDb : ref.getDb()),
+          table(ref.getTable()), alias(ref.getAlias()) {}
+
+    /// @return the name the columns of the table are qualified with.
+    std::string const& name() const { return alias.empty() ? table : alias; }
+
+    /// @return true if 'cr', as written, is a column of this table.
+    bool owns(query::ColumnRef const& cr) const {
+        if (cr.table != name()) return false;
+        return cr.db.empty() || (alias.empty() && cr.db == db);
+    }
+
+    std::string db; ///< With the default database applied
+    std::string table;
+    std::string alias;
+};
+
+/// Add the terms ANDed at the top of 'term' to 'terms'.
+void flattenAnd(std::shared_ptr<query::BoolTerm const> const& term, TermVector& terms) {
+    if (auto const andTerm = std::dynamic_pointer_cast<query::AndTerm const>(term)) {
+        for (auto const& t : andTerm->_terms) flattenAnd(t, terms);
+    } else if (auto const orTerm = std::dynamic_pointer_cast<query::OrTerm const>(term)) {
+        if (orTerm->_terms.size() == 1) {
+            flattenAnd(orTerm->_terms.front(), terms);
+        } else {
+            terms.push_back(term);
+        }
+    } else if (term != nullptr) {
+        terms.push_back(term);
+    }
+}
+
+/// @return the columns of 'term' if it is the equality of two columns.
+Equality getEquality(query::BoolTerm const& term) {
+    auto const factor = dynamic_cast<query::BoolFactor const*>(&term);
+    if (factor == nullptr || factor->_hasNot || factor->_terms.size() != 1) return Equality();
+    auto const comp = std::dynamic_pointer_cast<query::CompPredicate>(factor->_terms.front());
+    if (comp == nullptr || comp->op != SqlSQL2Tokens::EQUALS_OP
+            || comp->left == nullptr || comp->right == nullptr) {
+        return Equality();
+    }
+    Equality equality(comp->left->copyAsColumnRef(), comp->right->copyAsColumnRef());
+    if (equality.first == nullptr || equality.second == nullptr) return Equality();
+    return equality;
+}
+
+/// @return the index in 'sides' of the table of 'cr', -1 if not known.
+int ownerOf(std::vector<Side> const& sides, query::ColumnRef const& cr) {
+    for (size_t i = 0; i < sides.size(); ++i) {
+        if (sides[i].owns(cr)) return i;
+    }
+    return -1;
+}
+
+} // annonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace ccontrol {
+
+SemiJoin::Ptr SemiJoin::detect(query::SelectStmt const& stmt, css::CssAccess const& css,
+                               std::string const& defaultDb) {
+    if (!stmt.hasWhereClause()) return nullptr;
+    auto const whereAnd = stmt.getWhereClause().getRootAndTerm();
+    if (whereAnd == nullptr) return nullptr;
+
+    // Two tables, listed or joined by an inner join.
+    std::vector<Side> sides;
+    TermVector terms;
+    std::vector<Equality> equalities;
+    auto const& refs = stmt.getFromList().getTableRefList();
+    if (refs.size() == 2 && refs[0]->isSimple() && refs[1]->isSimple()) {
+        sides.emplace_back(*refs[0], defaultDb);
+        sides.emplace_back(*refs[1], defaultDb);
+    } else if (refs.size() == 1 && refs[0]->getJoins().size() == 1) {
+        query::JoinRef const& join = *refs[0]->getJoins().front();
+        auto const right = join.getRight();
+        auto const spec = join.getSpec();
+        if (join.isNatural() || right == nullptr || !right->isSimple() || spec == nullptr
+                || (join.getJoinType() != query::JoinRef::DEFAULT
+                    && join.getJoinType() != query::JoinRef::INNER)) {
+            return nullptr;
+        }
+        sides.emplace_back(*refs[0], defaultDb);
+        sides.emplace_back(*right, defaultDb);
+        if (auto const usingColumn = spec->getUsing()) {
+            equalities.emplace_back(
+                std::make_shared<query::ColumnRef>("", sides[0].name(), usingColumn->column),
+                std::make_shared<query::ColumnRef>("", sides[1].name(), usingColumn->column));
+        }
+        flattenAnd(spec->getOn(), terms);
+    } else {
+        return nullptr;
+    }
+    if (sides[0].name() == sides[1].name()) return nullptr;
+    flattenAnd(whereAnd, terms);
+
+    // Sort the terms into join equalities and terms of a single table.
+    std::vector<TermVector> own(sides.size());
+    for (auto const& term : terms) {
+        Equality equality = getEquality(*term);
+        if (equality.first != nullptr) {
+            int const left = ownerOf(sides, *equality.first);
+            int const right = ownerOf(sides, *equality.second);
+            if (left >= 0 && right >= 0 && left != right) {
+                if (left == 1) std::swap(equality.first, equality.second);
+                equalities.push_back(equality);
+                continue;
+            }
+        }
+        query::ColumnRef::Vector columns;
+        term->findColumnRefs(columns);
+        int owner = -1;
+        for (auto const& cr : columns) {
+            int const o = ownerOf(sides, *cr);
+            if (o < 0 || (owner >= 0 && o != owner)) {
+                owner = -1;
+                break;
+            }
+            owner = o;
+        }
+        if (owner >= 0) own[owner].push_back(term);
+    }
+    if (equalities.empty()) return nullptr;
+
+    // The keys of the side with terms of its own restrict a secondary index
+    // column of the other side. When both have terms of their own, a child
+    // table, usually the larger, is restricted by the keys of its director.
+    try {
+        std::vector<int> order;
+        for (int i = 0; i < 2; ++i) {
+            if (!css.containsTable(sides[i].db, sides[i].table)) return nullptr;
+            auto const params = css.getPartTableParams(sides[i].db, sides[i].table);
+            if (params.dirTable.empty() || params.dirTable == sides[i].table) {
+                order.push_back(i);
+            } else {
+                order.insert(order.begin(), i);
+            }
+        }
+        for (int restricted : order) {
+            int const selective = 1 - restricted;
+            if (own[selective].empty()) continue;
+            Side const& side = sides[restricted];
+            auto const params = css.getPartTableParams(side.db, side.table);
+            if (!params.isChunked()) continue;
+            auto const indexCols = params.secIndexColNames();
+            for (auto const& equality : equalities) {
+                auto const& restrictedCol = restricted == 0 ? equality.first : equality.second;
+                auto const& keyCol = restricted == 0 ? equality.second : equality.first;
+                if (std::find(indexCols.begin(), indexCols.end(), restrictedCol->column) == indexCols.end()) {
+                    continue;
+                }
+                Ptr semiJoin(new SemiJoin());
+                semiJoin->_restrictedDb = restrictedCol->db;
+                semiJoin->_restrictedTable = restrictedCol->table;
+                semiJoin->_restrictedColumn = restrictedCol->column;
+                query::QueryTemplate keyQt;
+                keyCol->renderTo(keyQt);
+                semiJoin->_keyColumn = keyQt.sqlFragment();
+                Side const& keySide = sides[selective];
+                semiJoin->_keyFrom = keySide.db + "." + keySide.table;
+                if (!keySide.alias.empty()) {
+                    semiJoin->_keyFrom += " AS " + keySide.alias;
+                }
+                for (auto const& term : own[selective]) {
+                    query::QueryTemplate qt;
+                    term->renderTo(qt);
+                    if (!semiJoin->_keyWhere.empty()) semiJoin->_keyWhere += " AND ";
+                    semiJoin->_keyWhere += "(" + qt.sqlFragment() + ")";
+                }
+                LOGS(_log, LOG_LVL_DEBUG, "semi-join of " << side.db << "." << side.table
+                     << "." << restrictedCol->column << " on " << semiJoin->_keyColumn);
+                return semiJoin;
+            }
+        }
+    } catch (std::exception const& exc) {
+        LOGS(_log, LOG_LVL_DEBUG, "no semi-join: " << exc.what());
+    }
+    return nullptr;
+}
+
+
+bool SemiJoin::isKey(std::string const& key) {
+    size_t const start = (!key.empty() && key[0] == '-') ? 1 : 0;
+    return key.size() > start
+        && std::all_of(key.begin() + start, key.end(), [](char c) { return c >= '0' && c <= '9'; });
+}
+
+
+std::string SemiJoin::makeKeyQuery(int maxKeys) const {
+    return "SELECT " + _keyColumn + " FROM " + _keyFrom + " WHERE " + _keyWhere
+           + " LIMIT " + std::to_string(maxKeys + 1);
+}
+
+
+std::shared_ptr<query::SelectStmt> SemiJoin::restrict(query::SelectStmt const& stmt,
+                                                      std::vector<std::string> const& keys) const {
+    auto restricted = stmt.clone();
+    auto column = std::make_shared<query::ColumnRef>(_restrictedDb, _restrictedTable, _restrictedColumn);
+    query::ValueExprPtrVector cands;
+    for (auto const& key : keys) {
+        cands.push_back(query::ValueExpr::newSimple(query::ValueFactor::newConstFactor(key)));
+    }
+    if (cands.empty()) {
+        cands.push_back(query::ValueExpr::newSimple(query::ValueFactor::newConstFactor("NULL")));
+    }
+    auto in = std::make_shared<query::InPredicate>(
+        query::ValueExpr::newSimple(query::ValueFactor::newColumnRefFactor(column)), cands, false);
+    restricted->getWhereClause().prependAndTerm(std::make_shared<query::BoolFactor>(in));
+    return restricted;
+}
+
+}}} // namespace lsst::qserv::ccontrol
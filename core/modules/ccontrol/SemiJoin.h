@@ -0,0 +1,101 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_CCONTROL_SEMIJOIN_H
+#define LSST_QSERV_CCONTROL_SEMIJOIN_H
+
+// System headers
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lsst {
+namespace qserv {
+namespace css {
+class CssAccess;
+}
+namespace query {
+class SelectStmt;
+}
+
+namespace ccontrol {
+
+/// SemiJoin plans a join between a partitioned table and a table whose own
+/// WHERE terms select few rows in two steps. The keys of the selective side
+/// are read first, with a query of their own, and the join is then run with
+/// the key column of the partitioned side restricted to them:
+///
+///     SELECT ... FROM Source s JOIN Object o ON s.objectId = o.objectId
+///     WHERE o.gMag < 18 AND ...
+///
+/// first runs
+///
+///     SELECT o.objectId FROM Object AS o WHERE (o.gMag < 18) LIMIT maxKeys+1
+///
+/// and then the join with s.objectId IN (<keys>) added to its WHERE clause.
+/// The secondary index then leaves out the chunks holding none of the keys,
+/// and each chunk query is sent only the keys of its chunk.
+///
+/// Only inner joins of two tables, on the equality of a secondary index
+/// column of one of them with a column of the other, are planned this way.
+class SemiJoin {
+public:
+    typedef std::shared_ptr<SemiJoin> Ptr;
+
+    /// @param stmt - the statement, as parsed, before query analysis.
+    /// @return the plan of 'stmt', nullptr if its join does not have that form.
+    static Ptr detect(query::SelectStmt const& stmt, css::CssAccess const& css,
+                      std::string const& defaultDb);
+
+    /// @return true if 'key' may be put in the IN list as it is, which is
+    ///         the case of integers, the type of secondary index columns.
+    static bool isKey(std::string const& key);
+
+    /// @return the query reading the keys of the selective side, at most
+    ///         maxKeys+1 of them to tell when there are too many.
+    std::string makeKeyQuery(int maxKeys) const;
+
+    /// @return a copy of 'stmt', as parsed, with the key column of the
+    ///         partitioned side restricted to 'keys'. No key selects no row.
+    std::shared_ptr<query::SelectStmt> restrict(query::SelectStmt const& stmt,
+                                                std::vector<std::string> const& keys) const;
+
+    /// @return the key column of the partitioned side, as written in the query.
+    std::string const& getRestrictedColumn() const { return _restrictedColumn; }
+
+    /// @return the key column of the selective side, as written in the query.
+    std::string const& getKeyColumn() const { return _keyColumn; }
+
+private:
+    SemiJoin() = default;
+
+    std::string _restrictedDb;     ///< Database of the partitioned side key, as written, may be empty
+    std::string _restrictedTable;  ///< Table or alias of the partitioned side key, as written
+    std::string _restrictedColumn; ///< Secondary index column of the partitioned side
+    std::string _keyColumn;        ///< Key column of the selective side, qualified as written
+    std::string _keyFrom;          ///< FROM clause of the selective side
+    std::string _keyWhere;         ///< WHERE terms of the selective side alone
+};
+
+}}} // namespace lsst::qserv::ccontrol
+
+#endif // LSST_QSERV_CCONTROL_SEMIJOIN_H
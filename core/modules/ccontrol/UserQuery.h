@@ -105,6 +105,10 @@ public:
 
     /// @return True if query is async query
     virtual bool isAsync() const { return false; }
+
+    /// @return True if the result table is kept by the result cache,
+    ///         which drops it, instead of the client after reading it.
+    virtual bool isResultCached() const { return false; }
 };
 
 }}} // namespace lsst::qserv:ccontrol
@@ -24,6 +24,9 @@
 #include "ccontrol/UserQueryAsyncResult.h"
 
 // System headers
+#include <algorithm>
+#include <mutex>
+#include <vector>
 
 // Third-party headers
 
@@ -34,11 +37,17 @@
 #include "qmeta/Exceptions.h"
 #include "qmeta/QMeta.h"
 #include "qdisp/MessageStore.h"
-#include "sql/SqlConnection.h"
+#include "sql/SqlConnectionPool.h"
 #include "sql/SqlResults.h"
 
 namespace {
 LOG_LOGGER _log = LOG_GET("lsst.qserv.ccontrol.UserQueryProcessList");
+
+// Rows of a page at most, so that neither czar nor proxy holds a large result.
+#define MAX_PAGE_ROWS 1000000
+
+// Serializes adding the row key, which the first pages asked for at once would all try.
+std::mutex rowKeyMutex;
 }
 
 namespace lsst {
@@ -49,14 +58,21 @@ namespace ccontrol {
 UserQueryAsyncResult::UserQueryAsyncResult(QueryId queryId,
                                            qmeta::CzarId qMetaCzarId,
                                            std::shared_ptr<qmeta::QMeta> const& qMeta,
-                                           sql::SqlConnection* resultDbConn)
+                                           std::shared_ptr<sql::SqlConnectionPool> const& resultDbPool,
+                                           uint64_t afterRowId,
+                                           uint64_t pageRows,
+                                           std::string const& userQueryId)
     : UserQuery(),
       _queryId(queryId),
       _qMetaCzarId(qMetaCzarId),
-      _resultDbConn(resultDbConn),
-      _messageStore(std::make_shared<qdisp::MessageStore>()) {
+      _resultDbPool(resultDbPool),
+      _messageStore(std::make_shared<qdisp::MessageStore>()),
+      _afterRowId(afterRowId),
+      _pageRows(std::min<uint64_t>(pageRows, MAX_PAGE_ROWS)),
+      _pageTableName("result_page_" + userQueryId) {
 
-    LOGS(_log, LOG_LVL_DEBUG, "UserQueryAsyncResult: QID=" << queryId);
+    LOGS(_log, LOG_LVL_DEBUG, "UserQueryAsyncResult: QID=" << queryId
+         << " afterRowId=" << afterRowId << " pageRows=" << _pageRows);
 
     // get query info from QMeta
     try {
@@ -124,10 +140,18 @@ void UserQueryAsyncResult::submit() {
     }
     std::string const resultTableName = _qInfo.resultLocation().substr(6);
 
-    // check that message and result tables exist
     sql::SqlErrorObject sqlErrObj;
-    if (!_resultDbConn->tableExists(_qInfo.msgTableName(), sqlErrObj) or
-        !_resultDbConn->tableExists(resultTableName, sqlErrObj)) {
+    auto resultDbConn = _resultDbPool->acquire("asyncResult", sqlErrObj);
+    if (not resultDbConn) {
+        LOGS(_log, LOG_LVL_ERROR, "Failed to connect to results database: " << sqlErrObj.errMsg());
+        std::string message = "Failed to connect to results database.";
+        _messageStore->addErrorMessage(message);
+        return;
+    }
+
+    // check that message and result tables exist
+    if (!resultDbConn->tableExists(_qInfo.msgTableName(), sqlErrObj) or
+        !resultDbConn->tableExists(resultTableName, sqlErrObj)) {
         std::string message = "Result or message table does not exist, result is likely expired.";
         LOGS(_log, LOG_LVL_DEBUG, message);
         _messageStore->addErrorMessage(message);
@@ -136,10 +160,10 @@ void UserQueryAsyncResult::submit() {
 
     // all checks are OK, copy message table from original query
     // into the message store, at this point original result table must be unlocked
-    std::string query = "SELECT chunkId, code, message, severity, timeStamp FROM " +
+    std::string query = "SELECT chunkId, code, message, severity, timeStamp, msgCount FROM " +
                     _qInfo.msgTableName();
     sql::SqlResults sqlResults;
-    if (!_resultDbConn->runQuery(query, sqlResults, sqlErrObj)) {
+    if (!resultDbConn->runQueryStreaming(query, sqlResults, sqlErrObj)) {
         LOGS(_log, LOG_LVL_ERROR, "Failed to retrieve message table data: " << sqlErrObj.errMsg());
         std::string message = "Failed to retrieve message table data.";
         _messageStore->addErrorMessage(message);
@@ -155,8 +179,13 @@ void UserQueryAsyncResult::submit() {
             std::string message = row[2].first;
             std::string sevStr = row[3].first;
             float timestamp = boost::lexical_cast<float>(row[4].first);
+            int msgCount = boost::lexical_cast<int>(row[5].first);
             MessageSeverity sev = sevStr == "INFO" ? MSG_INFO : MSG_ERROR;
-            _messageStore->addMessage(chunkId, code, message, sev, std::time_t(timestamp));
+            // a row stands for msgCount identical messages, which MessageTable
+            // folds into one row again
+            for (int i = 0; i < msgCount; ++i) {
+                _messageStore->addMessage(chunkId, code, message, sev, std::time_t(timestamp));
+            }
         } catch (std::exception const& exc) {
             LOGS(_log, LOG_LVL_ERROR, "Error reading message table data: " << exc.what());
             std::string message = "Error reading message table data.";
@@ -165,14 +194,37 @@ void UserQueryAsyncResult::submit() {
         }
         ++ count;
     }
+    if (!sqlResults.checkStreamError(sqlErrObj)) {
+        LOGS(_log, LOG_LVL_ERROR, "Failed to retrieve message table data: " << sqlErrObj.errMsg());
+        std::string message = "Failed to retrieve message table data.";
+        _messageStore->addErrorMessage(message);
+        return;
+    }
+    sqlResults.freeResults();
     LOGS(_log, LOG_LVL_DEBUG, "Copied " << count << " messages from " << _qInfo.msgTableName());
 
+    // A page is copied to its own table, which the proxy drops, and the result
+    // is kept for the next page unless this one was the last.
+    if (_pageRows > 0) {
+        bool lastPage = false;
+        if (!_makePage(*resultDbConn, resultTableName, lastPage)) {
+            return;
+        }
+        if (!lastPage) {
+            _qState = SUCCESS;
+            return;
+        }
+        if (!resultDbConn->dropTable(resultTableName, sqlErrObj, false)) {
+            LOGS(_log, LOG_LVL_ERROR, "Failed to drop result table: " << sqlErrObj.errMsg());
+        }
+    }
+
     // Original message table is not useful any more because the result table
     // will be deleted by proxy anyways. Until we have better lifetime management
     // of results I'm going to drop this table now, meaning result can be only
     // retrieved once.
     query = "DROP TABLE " + _qInfo.msgTableName();
-    if (!_resultDbConn->runQuery(query, sqlErrObj)) {
+    if (!resultDbConn->runQuery(query, sqlErrObj)) {
         LOGS(_log, LOG_LVL_ERROR, "Failed to drop message table: " << sqlErrObj.errMsg());
         // Users do not care about this error, so don't send it upstream.
     } else {
@@ -183,6 +235,68 @@ void UserQueryAsyncResult::submit() {
     _qState = SUCCESS;
 }
 
+bool UserQueryAsyncResult::_addRowKey(sql::SqlConnection& conn, std::string const& resultTableName,
+                                      sql::SqlErrorObject& errObj) {
+    std::lock_guard<std::mutex> lock(rowKeyMutex);
+    sql::SqlResults results;
+    std::vector<std::string> columns;
+    if (!conn.runQuery("SHOW COLUMNS FROM " + resultTableName + " LIKE 'qserv_rowid'", results, errObj)
+        || !results.extractFirstColumn(columns, errObj)) {
+        return false;
+    }
+    if (!columns.empty()) {
+        return true;
+    }
+
+    // Rows are numbered in the order the proxy returns them, so that pages
+    // follow that order. The table is copied once, then swapped in.
+    std::string const keyedTable = resultTableName + "_k";
+    std::string const oldTable = resultTableName + "_o";
+    std::string const createKeyed = "CREATE TABLE " + keyedTable
+        + " (qserv_rowid BIGINT UNSIGNED NOT NULL AUTO_INCREMENT PRIMARY KEY) ENGINE=MyISAM"
+        + " SELECT * FROM " + resultTableName + " " + _qInfo.proxyOrderBy();
+    LOGS(_log, LOG_LVL_DEBUG, "adding row key: " << createKeyed);
+    if (!conn.dropTable(keyedTable, errObj, false)
+        || !conn.runQuery(createKeyed, errObj)
+        || !conn.runQuery("RENAME TABLE " + resultTableName + " TO " + oldTable + ", "
+                          + keyedTable + " TO " + resultTableName, errObj)) {
+        return false;
+    }
+    if (!conn.dropTable(oldTable, errObj, false)) {
+        LOGS(_log, LOG_LVL_WARN, "Failed to drop " << oldTable << ": " << errObj.errMsg());
+    }
+    return true;
+}
+
+bool UserQueryAsyncResult::_makePage(sql::SqlConnection& conn, std::string const& resultTableName,
+                                     bool& lastPage) {
+    sql::SqlErrorObject sqlErrObj;
+    if (!_addRowKey(conn, resultTableName, sqlErrObj)) {
+        LOGS(_log, LOG_LVL_ERROR, "Failed to add row key to result table: " << sqlErrObj.errMsg());
+        _messageStore->addErrorMessage("Failed to prepare result for paging.");
+        return false;
+    }
+    std::string const createPage = "CREATE TABLE " + _pageTableName + " ENGINE=MyISAM"
+        + " SELECT * FROM " + resultTableName
+        + " WHERE qserv_rowid > " + std::to_string(_afterRowId)
+        + " ORDER BY qserv_rowid LIMIT " + std::to_string(_pageRows);
+    LOGS(_log, LOG_LVL_DEBUG, "making page: " << createPage);
+    sql::SqlResults results;
+    std::string rows;
+    if (!conn.dropTable(_pageTableName, sqlErrObj, false)
+        || !conn.runQuery(createPage, sqlErrObj)
+        || !conn.runQuery("SELECT COUNT(*) FROM " + _pageTableName, results, sqlErrObj)
+        || !results.extractFirstValue(rows, sqlErrObj)) {
+        LOGS(_log, LOG_LVL_ERROR, "Failed to make result page: " << sqlErrObj.errMsg());
+        _messageStore->addErrorMessage("Failed to make result page.");
+        return false;
+    }
+    lastPage = std::stoull(rows) < _pageRows;
+    LOGS(_log, LOG_LVL_DEBUG, "page of " << rows << " rows after " << _afterRowId
+         << (lastPage ? ", last page" : ""));
+    return true;
+}
+
 QueryState UserQueryAsyncResult::join() {
     return _qState;
 }
@@ -198,6 +312,9 @@ std::shared_ptr<qdisp::MessageStore> UserQueryAsyncResult::getMessageStore() {
 }
 
 std::string UserQueryAsyncResult::getResultTableName() const {
+    if (_pageRows > 0) {
+        return _pageTableName;
+    }
     if (_qInfo.resultLocation().compare(0, 6, "table:") == 0) {
         return _qInfo.resultLocation().substr(6);
     } else {
@@ -210,6 +327,9 @@ std::string UserQueryAsyncResult::getResultLocation() const {
 }
 
 std::string UserQueryAsyncResult::getProxyOrderBy() const {
+    if (_pageRows > 0) {
+        return "ORDER BY qserv_rowid";
+    }
     return _qInfo.proxyOrderBy();
 }
 
@@ -23,6 +23,9 @@
 #define LSST_QSERV_CCONTROL_USERQUERYASYNCRESULT_H
 
 // System headers
+#include <cstdint>
+#include <memory>
+#include <string>
 
 // Third-party headers
 
@@ -41,6 +44,8 @@ class QMeta;
 }
 namespace sql {
 class SqlConnection;
+class SqlConnectionPool;
+class SqlErrorObject;
 }}}
 
 
@@ -60,17 +65,30 @@ class UserQueryAsyncResult : public UserQuery {
 public:
 
     /**
-     *  Constructor for "SELECT * FROM QSERV_RESULT(QID)".
+     *  Constructor for "SELECT * FROM QSERV_RESULT(QID)", which returns the
+     *  whole result once, and "SELECT * FROM QSERV_RESULT(QID, ROWID, N)",
+     *  which returns the rows of the result that follow row ROWID, at most N.
+     *
+     *  Pages are found by their key, the qserv_rowid column added to the result
+     *  table, numbering rows in result order from 1, so the czar keeps no cursor:
+     *  a client asks for the next page with the last qserv_rowid it read, and
+     *  the result is dropped once its last page is returned.
      *
      *  @param queryId:       Query ID for which to return result
      *  @param qMetaCzarId:   ID for current czar
      *  @param qMetaSelect:   QMetaSelect instance
-     *  @param resultDbConn:  Connection to results database
+     *  @param resultDbPool:  Connections to results database
+     *  @param afterRowId:    Key of the last row already read
+     *  @param pageRows:      Rows returned at most, 0 for the whole result
+     *  @param userQueryId:   Unique string identifying this request, names the page table
      */
     UserQueryAsyncResult(QueryId queryId,
                          qmeta::CzarId qMetaCzarId,
                          std::shared_ptr<qmeta::QMeta> const& qMeta,
-                         sql::SqlConnection* resultDbConn);
+                         std::shared_ptr<sql::SqlConnectionPool> const& resultDbPool,
+                         uint64_t afterRowId=0,
+                         uint64_t pageRows=0,
+                         std::string const& userQueryId=std::string());
 
     // Destructor
     ~UserQueryAsyncResult();
@@ -116,12 +134,23 @@ protected:
 
 private:
 
+    /// Add the qserv_rowid key to the result table unless it is there already.
+    bool _addRowKey(sql::SqlConnection& conn, std::string const& resultTableName,
+                    sql::SqlErrorObject& errObj);
+
+    /// Copy the requested page of the result table to the page table.
+    /// @return false on error, with a message in the message store.
+    bool _makePage(sql::SqlConnection& conn, std::string const& resultTableName, bool& lastPage);
+
     QueryId _queryId;
     qmeta::CzarId _qMetaCzarId;
     std::shared_ptr<qmeta::QMeta> _qMeta;
-    sql::SqlConnection* _resultDbConn;
+    std::shared_ptr<sql::SqlConnectionPool> _resultDbPool;
     qmeta::QInfo _qInfo;
     std::shared_ptr<qdisp::MessageStore> _messageStore;
+    uint64_t const _afterRowId;
+    uint64_t const _pageRows;        ///< 0 unless a page is returned
+    std::string const _pageTableName;
     QueryState _qState = UNKNOWN;
 };
 
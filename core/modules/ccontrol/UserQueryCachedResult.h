@@ -0,0 +1,97 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_QSERV_CCONTROL_USERQUERYCACHEDRESULT_H
+#define LSST_QSERV_CCONTROL_USERQUERYCACHEDRESULT_H
+
+// System headers
+#include <memory>
+#include <string>
+
+// Qserv headers
+#include "ccontrol/ResultTableCache.h"
+#include "ccontrol/UserQuery.h"
+#include "qdisp/MessageStore.h"
+
+namespace lsst {
+namespace qserv {
+namespace ccontrol {
+
+/// UserQueryCachedResult : implementation of the UserQuery for a SELECT
+/// answered from the result table of an identical earlier query, kept
+/// by ResultTableCache. Nothing is dispatched.
+class UserQueryCachedResult : public UserQuery {
+public:
+
+    explicit UserQueryCachedResult(ResultTableCache::Entry const& entry)
+        : _entry(entry),
+          _messageStore(std::make_shared<qdisp::MessageStore>()) {}
+
+    UserQueryCachedResult(UserQueryCachedResult const&) = delete;
+    UserQueryCachedResult& operator=(UserQueryCachedResult const&) = delete;
+
+    // Accessors
+
+    /// @return a non-empty string describing the current error state
+    /// Returns an empty string if no errors have been detected.
+    std::string getError() const override { return std::string(); }
+
+    /// Begin execution of the query over all ChunkSpecs added so far.
+    void submit() override {}
+
+    /// Wait until the query has completed execution.
+    /// @return the final execution state.
+    QueryState join() override { return SUCCESS; }
+
+    /// Stop a query in progress (for immediate shutdowns)
+    void kill() override {}
+
+    /// Release resources related to user query
+    void discard() override {}
+
+    // Delegate objects
+    std::shared_ptr<qdisp::MessageStore> getMessageStore() override {
+        return _messageStore; }
+
+    /// @return Name of the cached result table
+    std::string getResultTableName() const override { return _entry.table; }
+
+    /// @return Result location for this query
+    std::string getResultLocation() const override { return "table:" + _entry.table; }
+
+    /// @return ORDER BY part of SELECT statement to be executed by proxy
+    std::string getProxyOrderBy() const override { return _entry.orderBy; }
+
+    /// @return True, the cache drops the table
+    bool isResultCached() const override { return true; }
+
+private:
+
+    ResultTableCache::Entry const _entry;
+    std::shared_ptr<qdisp::MessageStore> _messageStore;
+
+};
+
+}}} // namespace lsst::qserv:ccontrol
+
+#endif // LSST_QSERV_CCONTROL_USERQUERYCACHEDRESULT_H
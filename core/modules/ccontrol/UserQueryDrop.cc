@@ -36,7 +36,7 @@
 #include "qdisp/MessageStore.h"
 #include "qmeta/Exceptions.h"
 #include "qmeta/QMeta.h"
-#include "sql/SqlConnection.h"
+#include "sql/SqlConnectionPool.h"
 #include "sql/SqlErrorObject.h"
 #include "util/IterableFormatter.h"
 
@@ -52,11 +52,11 @@ namespace ccontrol {
 UserQueryDrop::UserQueryDrop(std::shared_ptr<css::CssAccess> const& css,
                              std::string const& dbName,
                              std::string const& tableName,
-                             sql::SqlConnection* resultDbConn,
+                             std::shared_ptr<sql::SqlConnectionPool> const& resultDbPool,
                              std::shared_ptr<qmeta::QMeta> const& queryMetadata,
                              qmeta::CzarId qMetaCzarId)
     : _css(css), _dbName(dbName), _tableName(tableName),
-      _resultDbConn(resultDbConn), _queryMetadata(queryMetadata),
+      _resultDbPool(resultDbPool), _queryMetadata(queryMetadata),
       _qMetaCzarId(qMetaCzarId), _qState(UNKNOWN),
       _messageStore(std::make_shared<qdisp::MessageStore>()),
       _sessionId(0) {
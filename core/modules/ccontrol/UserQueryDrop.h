@@ -44,7 +44,7 @@ namespace qmeta {
 class QMeta;
 }
 namespace sql {
-class SqlConnection;
+class SqlConnectionPool;
 }}}
 
 
@@ -61,14 +61,14 @@ public:
      *  @param dbName:        Name of the database
      *  @param tableName:     Name of the table to drop, if empty then drop
      *                        entire database
-     *  @param resultDbConn:  Connection to results database
+     *  @param resultDbPool:  Connections to results database
      *  @param queryMetadata: QMeta interface
      *  @param qMetaCzarId:   Czar ID in QMeta database
      */
     UserQueryDrop(std::shared_ptr<css::CssAccess> const& css,
                   std::string const& dbName,
                   std::string const& tableName,
-                  sql::SqlConnection* resultDbConn,
+                  std::shared_ptr<sql::SqlConnectionPool> const& resultDbPool,
                   std::shared_ptr<qmeta::QMeta> const& queryMetadata,
                   qmeta::CzarId qMetaCzarId);
 
@@ -106,7 +106,7 @@ private:
     std::shared_ptr<css::CssAccess> const _css;
     std::string const _dbName;
     std::string const _tableName;
-    sql::SqlConnection* _resultDbConn;
+    std::shared_ptr<sql::SqlConnectionPool> _resultDbPool;
     std::shared_ptr<qmeta::QMeta> _queryMetadata;
     qmeta::CzarId const _qMetaCzarId;   ///< Czar ID in QMeta database
     QueryState _qState;
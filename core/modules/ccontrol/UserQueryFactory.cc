@@ -25,24 +25,38 @@
 #include "ccontrol/UserQueryFactory.h"
 
 // System headers
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cmath>
 #include <cstdlib>
+#include <future>
+#include <mutex>
 #include <string>
 
 // Third-party headers
+#include "XrdSsi/XrdSsiErrInfo.hh"
 
 // LSST headers
 #include "lsst/log/Log.h"
 
 // Qserv headers
+#include "ccontrol/AdmissionController.h"
 #include "ccontrol/ConfigError.h"
 #include "ccontrol/ConfigMap.h"
+#include "ccontrol/CzarLoadShare.h"
+#include "ccontrol/MergeBufferPool.h"
+#include "ccontrol/ResultTableCache.h"
+#include "ccontrol/SelectStmtCache.h"
+#include "ccontrol/SemiJoin.h"
 #include "ccontrol/UserQueryAsyncResult.h"
+#include "ccontrol/UserQueryCachedResult.h"
 #include "ccontrol/UserQueryDrop.h"
 #include "ccontrol/UserQueryFlushChunksCache.h"
 #include "ccontrol/UserQueryInvalid.h"
 #include "ccontrol/UserQueryProcessList.h"
 #include "ccontrol/UserQuerySelect.h"
+#include "ccontrol/UserQuerySelectStats.h"
 #include "ccontrol/UserQueryType.h"
 #include "css/CssAccess.h"
 #include "css/KvInterfaceImplMem.h"
@@ -52,18 +66,68 @@
 #include "parser/SelectParser.h"
 #include "qdisp/Executive.h"
 #include "qdisp/MessageStore.h"
+#include "qdisp/ReplicaSelector.h"
+#include "qdisp/WarmupRequest.h"
+#include "qdisp/WorkerSessions.h"
+#include "qmeta/QMetaAsync.h"
 #include "qmeta/QMetaMysql.h"
 #include "qmeta/QMetaSelect.h"
+#include "qmeta/QMetaWriteQueue.h"
+#include "qmeta/QStatusAggregator.h"
+#include "qmeta/QStatusAsync.h"
 #include "qmeta/QStatusMysql.h"
 #include "qproc/QuerySession.h"
 #include "qproc/SecondaryIndex.h"
 #include "query/FromList.h"
 #include "query/SelectStmt.h"
 #include "rproc/InfileMerger.h"
-#include "sql/SqlConnection.h"
+#include "sql/SqlConnectionPool.h"
+#include "sql/SqlResults.h"
+#include "util/CgroupMemory.h"
+#include "util/Trace.h"
 
 namespace {
 LOG_LOGGER _log = LOG_GET("lsst.qserv.ccontrol.UserQueryFactory");
+
+// Delay before a failed QMeta update is tried again, doubled after each attempt.
+#define QMETA_QUEUE_RETRY_MSECS 500
+
+// Time a table leaving the result cache is kept for the proxy still reading it.
+#define RESULT_CACHE_DROP_DELAY_SECS 600
+
+using lsst::qserv::sql::SqlConnectionPool;
+
+void dropResultTable(SqlConnectionPool::Ptr const& pool, std::string const& dbName,
+                     std::string const& table) {
+    lsst::qserv::sql::SqlErrorObject errObj;
+    auto conn = pool->acquire("resultCache", errObj);
+    if (conn == nullptr || !conn->dropTable(table, errObj, false, dbName)) {
+        LOGS(_log, LOG_LVL_WARN, "failed to drop cached result table " << table << ": "
+             << errObj.printErrMsg());
+    }
+}
+
+int64_t resultTableBytes(SqlConnectionPool::Ptr const& pool, std::string const& dbName,
+                         std::string const& table) {
+    lsst::qserv::sql::SqlErrorObject errObj;
+    lsst::qserv::sql::SqlResults results;
+    std::string value;
+    auto conn = pool->acquire("resultCache", errObj);
+    if (conn == nullptr
+        || !conn->runQuery("SELECT data_length + index_length FROM information_schema.TABLES"
+                           " WHERE table_schema = '" + dbName + "' AND table_name = '" + table + "'",
+                           results, errObj)
+        || !results.extractFirstValue(value, errObj)) {
+        LOGS(_log, LOG_LVL_WARN, "failed to get size of result table " << table << ": "
+             << errObj.printErrMsg());
+        return -1;
+    }
+    try {
+        return std::stoll(value);
+    } catch (std::exception const&) {
+        return -1;
+    }
+}
 }
 
 
@@ -85,19 +149,47 @@ public:
     std::shared_ptr<qproc::SecondaryIndex> secondaryIndex;
     std::shared_ptr<qmeta::QMeta> queryMetadata;
     std::shared_ptr<qmeta::QStatus> queryStatsData;
+    qmeta::QStatusAggregator::Ptr queryProgress; ///< In-memory progress, also in queryStatsData, may be null
     std::shared_ptr<qmeta::QMetaSelect> qMetaSelect;
-    std::unique_ptr<sql::SqlConnection> resultDbConn;
+    qmeta::QMetaWriteQueue::Ptr qMetaQueue; ///< Runs QMeta and QStatus updates, may be null
+    sql::SqlConnectionPool::Ptr resultDbPool; ///< Connections to the results database
     qmeta::CzarId qMetaCzarId = {0};   ///< Czar ID in QMeta database
+    int mergeShards = 1;               ///< Number of InfileMerger shard tables
+    int aggMaxGroups = 0;              ///< Max groups InfileMerger folds in memory
+    bool workerAggFold = false;        ///< Ask the workers to fold partial aggregates
+    int topKMaxRows = 0;               ///< Max ORDER BY ... LIMIT rows InfileMerger ranks in memory
+    std::string sortedRunDir;          ///< Where InfileMerger keeps sorted chunk results, empty for none
+    int passThroughMemoryTableMB = 0;  ///< Max MB of an in-memory result table
+    int mergeJobIdPartitions = 0;      ///< Partitions of a merge table on disk
+    rproc::ResultSink::Kind resultSink = rproc::ResultSink::MYSQL; ///< Where InfileMerger stores rows
+    std::string resultSinkDir;         ///< Where a columnar result sink writes rows past its memory
+    int resultSinkMemoryMB = 0;        ///< Max MB of rows a columnar result sink holds in memory
+    int maxQueryCost = 0;              ///< Max estimated cost of an accepted query, 0 for no limit
+    int interactiveDeadlineMs = 0;     ///< Worker deadline of interactive tasks, 0 for none
+    int traceSampleEvery = 0;          ///< Trace one query out of this many, 0 for none
+    std::unique_ptr<SelectStmtCache> selectStmtCache; ///< Recently parsed SELECT statements
+    std::shared_ptr<ResultTableCache> resultCache; ///< Results of recent SELECTs, may be null
+    AdmissionController::Ptr admission; ///< Decides when SELECT queries start
+    std::unique_ptr<CzarLoadShare> loadShare; ///< Shares load with other czars, may be null
+    int semiJoinMaxKeys = 0;           ///< Max keys of the selective side of a semi-join, 0 for none
+    std::mutex mtx; ///< Held while a UserQuery is made, by the czar or for a semi-join
 };
 
 
 ////////////////////////////////////////////////////////////////////////
 UserQueryFactory::UserQueryFactory(czar::CzarConfig const& czarConfig,
-                                   std::string const& czarName)
+                                   std::string const& czarName,
+                                   sql::SqlConnectionPool::Ptr const& resultDbPool)
     :  _impl(std::make_shared<Impl>(czarConfig)) {
 
+    _impl->resultDbPool = resultDbPool;
+
     ::putenv((char*)"XRDDEBUG=1");
 
+    // The parser warms up while the czar registers, it is ready before
+    // the first query.
+    auto warmUp = std::async(std::launch::async, &parser::SelectParser::warmUp);
+
     // register czar in QMeta
     // TODO: check that czar with the same name is not active already?
     _impl->qMetaCzarId = _impl->queryMetadata->registerCzar(czarName);
@@ -107,6 +199,75 @@ UserQueryFactory::UserQueryFactory(czar::CzarConfig const& czarConfig,
     // to avoid confusion. Note that when/if clean czar restart is implemented
     // we'll need a new logic to restart query processing.
     _impl->queryMetadata->cleanup(_impl->qMetaCzarId);
+
+    // Scan and async queries wait while the czar is short of merge resources.
+    size_t const maxConnections = std::max(1, czarConfig.getResultDbMaxConnections());
+    std::shared_ptr<util::CgroupMemory> const cgroup =
+        std::make_shared<util::CgroupMemory>(util::CgroupMemory::selfDir());
+    AdmissionController::Config admissionConfig;
+    admissionConfig.maxRunning[AdmissionController::INTERACTIVE] = czarConfig.getAdmissionMaxInteractive();
+    admissionConfig.maxRunning[AdmissionController::SCAN] = czarConfig.getAdmissionMaxScan();
+    admissionConfig.maxRunning[AdmissionController::ASYNC] = czarConfig.getAdmissionMaxAsync();
+    admissionConfig.maxQueued = czarConfig.getAdmissionMaxQueued();
+    admissionConfig.maxWait = std::chrono::seconds(std::max(0, czarConfig.getAdmissionMaxWaitSecs()));
+    admissionConfig.maxRunningJobs = czarConfig.getAdmissionMaxRunningJobs();
+    admissionConfig.maxRunningCost = czarConfig.getAdmissionMaxRunningCost();
+    std::weak_ptr<sql::SqlConnectionPool> weakPool(resultDbPool);
+    _impl->admission = AdmissionController::create(admissionConfig,
+            [weakPool, maxConnections, cgroup]() -> std::string {
+        auto pool = weakPool.lock();
+        if (pool != nullptr && pool->getStats().inUse >= maxConnections) {
+            return "all result database connections in use";
+        }
+        auto const& bufferPool = MergeBufferPool::instance();
+        if (bufferPool.getMaxBytes() > 0 && bufferPool.getInUseBytes() >= bufferPool.getMaxBytes()) {
+            return "merge buffers full";
+        }
+        if (cgroup->isValid()) {
+            auto const usage = cgroup->read();
+            if (usage.valid && usage.max > 0 && usage.current >= usage.max / 10 * 9) {
+                return "czar memory close to its limit";
+            }
+        }
+        return std::string();
+    });
+
+    if (czarConfig.getCzarLoadPeriodSecs() > 0) {
+        CzarLoadShare::Config loadShareConfig;
+        loadShareConfig.clusterMaxRunningJobs = std::max(0, czarConfig.getClusterMaxRunningJobs());
+        loadShareConfig.period = std::chrono::seconds(czarConfig.getCzarLoadPeriodSecs());
+        _impl->loadShare.reset(new CzarLoadShare(_impl->queryMetadata, _impl->qMetaCzarId, czarName,
+                                                 _impl->admission, loadShareConfig));
+    }
+
+    if (czarConfig.getResultCacheMB() > 0) {
+        uint64_t const mb = 1024*1024;
+        std::string const dbName = _impl->mysqlResultConfig.dbName;
+        _impl->resultCache = std::make_shared<ResultTableCache>(
+            czarConfig.getResultCacheMB()*mb, std::max(0, czarConfig.getResultCacheEntryMB())*mb,
+            std::chrono::seconds(czarConfig.getResultCacheTtlSecs()),
+            std::chrono::seconds(RESULT_CACHE_DROP_DELAY_SECS),
+            [resultDbPool, dbName](std::string const& table) {
+                dropResultTable(resultDbPool, dbName, table); },
+            [resultDbPool, dbName](std::string const& table) {
+                return resultTableBytes(resultDbPool, dbName, table); });
+
+        // Tables cached before a restart are unknown to the new cache, they
+        // are dropped while the parser warms up.
+        sql::SqlErrorObject errObj;
+        std::vector<std::string> tables;
+        auto conn = resultDbPool->acquire("resultCache", errObj);
+        if (conn == nullptr || !conn->listTables(tables, errObj, "qcache_", dbName)) {
+            LOGS(_log, LOG_LVL_WARN, "failed to list cached result tables: " << errObj.printErrMsg());
+        }
+        for (auto const& table : tables) {
+            dropResultTable(resultDbPool, dbName, table);
+        }
+        LOGS(_log, LOG_LVL_INFO, "result cache of " << czarConfig.getResultCacheMB()
+             << " MB, dropped " << tables.size() << " tables of a previous run");
+    }
+
+    warmUp.get();
 }
 
 
@@ -116,10 +277,23 @@ UserQueryFactory::newUserQuery(std::string const& aQuery,
                                qdisp::QdispPool::Ptr const& qdispPool,
                                std::string const& userQueryId,
                                std::string const& msgTableName) {
+    std::lock_guard<std::mutex> lock(_impl->mtx);
+    return _newUserQuery(aQuery, defaultDb, qdispPool, userQueryId, msgTableName, false);
+}
+
+
+UserQuery::Ptr
+UserQueryFactory::_newUserQuery(std::string const& aQuery,
+                                std::string const& defaultDb,
+                                qdisp::QdispPool::Ptr const& qdispPool,
+                                std::string const& userQueryId,
+                                std::string const& msgTableName,
+                                bool keyQuery) {
 
     // result location could potentially be specified by SUBMIT command, for now
     // we keep it empty which means that UserQuerySelect uses default result table.
     std::string resultLocation;
+    uint64_t const startUs = util::traceNowUs();
 
     // First check for SUBMIT and strip it
     std::string query = aQuery;
@@ -136,9 +310,25 @@ UserQueryFactory::newUserQuery(std::string const& aQuery,
         query = stripped;
     }
 
+    // Then for SAMPLE, which runs a SELECT on about one chunk in sampleEvery.
+    // The cache key keeps the prefix to tell the result from that of the
+    // full query.
+    std::string const cacheQuery = query;
+    int sampleEvery = 0;
+    double samplePercent = 0;
+    if (UserQueryType::isSample(query, samplePercent, stripped)) {
+        if (!UserQueryType::isSelect(stripped) || samplePercent <= 0 || samplePercent > 100) {
+            auto uq = std::make_shared<UserQueryInvalid>("Invalid or unsupported query: " + query);
+            return uq;
+        }
+        sampleEvery = std::max(1L, std::lround(100 / samplePercent));
+        query = stripped;
+    }
+
     std::string dbName, tableName;
     bool full = false;
     QueryId userJobId = 0;
+    uint64_t afterRowId = 0, pageRows = 0;
 
 
 
@@ -147,6 +337,20 @@ UserQueryFactory::newUserQuery(std::string const& aQuery,
         bool sessionValid = true;
         std::string errorExtra;
 
+        // An identical query may have left its result in the cache. The async
+        // result of SUBMIT is in QMeta and read later, so it is not cached.
+        std::string resultCacheKey;
+        if (_impl->resultCache != nullptr && !async && !keyQuery) {
+            resultCacheKey = ResultTableCache::makeKey(cacheQuery, defaultDb);
+        }
+        if (!resultCacheKey.empty()) {
+            ResultTableCache::Entry entry;
+            if (_impl->resultCache->get(resultCacheKey, entry)) {
+                LOGS(_log, LOG_LVL_INFO, "SELECT answered from cached result table " << entry.table);
+                return std::make_shared<UserQueryCachedResult>(entry);
+            }
+        }
+
         // Parse SELECT
 
 // While the antlr4 parser is still under development we will leave in the code that can be used to generate
@@ -169,13 +373,19 @@ UserQueryFactory::newUserQuery(std::string const& aQuery,
     }
 #endif
 
-        auto parser = parser::SelectParser::newInstance(query, parser::SelectParser::ANTLR4);
-        try {
-            parser->setup();
-        } catch (parser::ParseException& e) {
-            return std::make_shared<UserQueryInvalid>(std::string("ParseException:") + e.what());
+        auto stmt = _impl->selectStmtCache->get(query);
+        if (stmt == nullptr) {
+            auto parser = parser::SelectParser::newInstance(query, parser::SelectParser::ANTLR4);
+            try {
+                parser->setup();
+            } catch (parser::ParseException& e) {
+                return std::make_shared<UserQueryInvalid>(std::string("ParseException:") + e.what());
+            }
+            stmt = parser->getSelectStmt();
+            _impl->selectStmtCache->put(query, *stmt);
+        } else {
+            LOGS(_log, LOG_LVL_DEBUG, "SELECT statement found in parse cache");
         }
-        auto stmt = parser->getSelectStmt();
 
         // handle special database/table names
         auto&& tblRefList = stmt->getFromList().getTableRefList();
@@ -190,7 +400,7 @@ UserQueryFactory::newUserQuery(std::string const& aQuery,
                 }
                 LOGS(_log, LOG_LVL_DEBUG, "SELECT query is a PROCESSLIST");
                 try {
-                    return std::make_shared<UserQueryProcessList>(stmt, _impl->resultDbConn.get(),
+                    return std::make_shared<UserQueryProcessList>(stmt, _impl->resultDbPool,
                             _impl->qMetaSelect, _impl->qMetaCzarId, userQueryId);
                 } catch(std::exception const& exc) {
                     return std::make_shared<UserQueryInvalid>(exc.what());
@@ -200,10 +410,23 @@ UserQueryFactory::newUserQuery(std::string const& aQuery,
 
         // This is a regular SELECT for qserv
 
+        // A join against a table with selective terms of its own may first
+        // read the keys of that table, see SemiJoin. Analysis modifies the
+        // statement, the keys restrict a copy of it as parsed.
+        SemiJoin::Ptr semiJoin;
+        std::shared_ptr<query::SelectStmt> parsedStmt;
+        if (_impl->semiJoinMaxKeys > 0 && !keyQuery) {
+            semiJoin = SemiJoin::detect(*stmt, *_impl->css, defaultDb);
+            if (semiJoin != nullptr) {
+                parsedStmt = stmt->clone();
+            }
+        }
+
         // Currently using the database for results to get schema information.
         auto qs = std::make_shared<qproc::QuerySession>(_impl->css,
                                                         _impl->mysqlResultConfig,
                                                         defaultDb);
+        qs->setSampleEvery(sampleEvery);
         try {
             qs->analyzeQuery(query, stmt);
         } catch (...) {
@@ -216,6 +439,14 @@ UserQueryFactory::newUserQuery(std::string const& aQuery,
             sessionValid = false;
         }
 
+        // Aggregates of whole tables may be known from chunk statistics. The
+        // async result of SUBMIT is in QMeta, so it still runs on the chunks.
+        if (sessionValid && !async && !qs->getStatsAnswer().empty()) {
+            LOGS(_log, LOG_LVL_INFO, "SELECT answered from chunk statistics");
+            return std::make_shared<UserQuerySelectStats>(qs->getStatsAnswer(), _impl->resultDbPool,
+                                                          userQueryId);
+        }
+
         auto messageStore = std::make_shared<qdisp::MessageStore>();
         std::shared_ptr<qdisp::Executive> executive;
         std::shared_ptr<rproc::InfileMergerConfig> infileMergerConfig;
@@ -223,21 +454,77 @@ UserQueryFactory::newUserQuery(std::string const& aQuery,
             executive = qdisp::Executive::create(*_impl->executiveConfig, messageStore,
                                                  qdispPool, _impl->queryStatsData);
             infileMergerConfig = std::make_shared<rproc::InfileMergerConfig>(_impl->mysqlResultConfig);
+            infileMergerConfig->mergeShards = _impl->mergeShards;
+            infileMergerConfig->aggMaxGroups = std::max(0, _impl->aggMaxGroups);
+            infileMergerConfig->topKMaxRows = std::max(0, _impl->topKMaxRows);
+            infileMergerConfig->sortedRunDir = _impl->sortedRunDir;
+            infileMergerConfig->memoryTableMaxMB = std::max(0, _impl->passThroughMemoryTableMB);
+            infileMergerConfig->jobIdPartitions = _impl->mergeJobIdPartitions;
+            infileMergerConfig->resultSink = _impl->resultSink;
+            infileMergerConfig->resultSinkDir = _impl->resultSinkDir;
+            infileMergerConfig->resultSinkMemoryMB = std::max(0, _impl->resultSinkMemoryMB);
+            infileMergerConfig->sqlConnPool = _impl->resultDbPool;
         }
         auto uq = std::make_shared<UserQuerySelect>(qs, messageStore, executive, infileMergerConfig,
                                                     _impl->secondaryIndex, _impl->queryMetadata,
                                                     _impl->queryStatsData, _impl->qMetaCzarId,
                                                     qdispPool, errorExtra, async);
         if (sessionValid) {
+            if (!resultCacheKey.empty()) {
+                uq->setResultCache(_impl->resultCache, resultCacheKey);
+            }
             uq->qMetaRegister(resultLocation, msgTableName);
+            uq->setMaxQueryCost(_impl->maxQueryCost);
+            uq->setAdmissionController(_impl->admission);
+            uq->setInteractiveDeadlineMs(_impl->interactiveDeadlineMs);
+            uq->setWorkerAggFold(_impl->workerAggFold);
+            // Sampling needs the QueryId, so the parse span also covers analysis
+            // and registration in QMeta.
+            auto trace = util::QueryTrace::sample(uq->getQueryId(), _impl->traceSampleEvery);
+            if (trace != nullptr) {
+                trace->add("parse", -1, 0, startUs, util::traceNowUs() - startUs);
+                uq->setTrace(trace);
+            }
+            if (semiJoin != nullptr) {
+                size_t const maxKeys = _impl->semiJoinMaxKeys;
+                auto const impl = _impl;
+                // The czar keeps the factory for as long as its queries run.
+                uq->setSemiJoin([this, impl, semiJoin, parsedStmt, maxKeys, query, defaultDb,
+                                 qdispPool, userQueryId, sampleEvery]() {
+                    std::shared_ptr<qproc::QuerySession> none;
+                    std::vector<std::string> keys;
+                    if (!_readKeys(semiJoin->makeKeyQuery(maxKeys), defaultDb, qdispPool, userQueryId,
+                                   maxKeys, keys)) {
+                        return none;
+                    }
+                    auto qs = std::make_shared<qproc::QuerySession>(impl->css, impl->mysqlResultConfig,
+                                                                    defaultDb);
+                    qs->setSampleEvery(sampleEvery);
+                    try {
+                        qs->analyzeQuery(query, semiJoin->restrict(*parsedStmt, keys));
+                    } catch (std::exception const& exc) {
+                        LOGS(_log, LOG_LVL_WARN, "semi-join not analyzed: " << exc.what());
+                        return none;
+                    }
+                    if (!qs->getError().empty()) {
+                        LOGS(_log, LOG_LVL_WARN, "semi-join not analyzed: " << qs->getError());
+                        return none;
+                    }
+                    LOGS(_log, LOG_LVL_INFO, "semi-join restricts " << semiJoin->getRestrictedColumn()
+                         << " to " << keys.size() << " keys");
+                    return qs;
+                });
+            }
             uq->setupChunking();
         }
         return uq;
-    } else if (UserQueryType::isSelectResult(query, userJobId)) {
+    } else if (UserQueryType::isSelectResult(query, userJobId, afterRowId, pageRows)) {
         auto uq = std::make_shared<UserQueryAsyncResult>(userJobId, _impl->qMetaCzarId,
                                                          _impl->queryMetadata,
-                                                         _impl->resultDbConn.get());
-        LOGS(_log, LOG_LVL_DEBUG, "make UserQueryAsyncResult: userJobId=" << userJobId);
+                                                         _impl->resultDbPool,
+                                                         afterRowId, pageRows, userQueryId);
+        LOGS(_log, LOG_LVL_DEBUG, "make UserQueryAsyncResult: userJobId=" << userJobId
+             << " afterRowId=" << afterRowId << " pageRows=" << pageRows);
         return uq;
     } else if (UserQueryType::isDropTable(query, dbName, tableName)) {
         // processing DROP TABLE
@@ -245,27 +532,30 @@ UserQueryFactory::newUserQuery(std::string const& aQuery,
             dbName = defaultDb;
         }
         auto uq = std::make_shared<UserQueryDrop>(_impl->css, dbName, tableName,
-                                                  _impl->resultDbConn.get(),
+                                                  _impl->resultDbPool,
                                                   _impl->queryMetadata, _impl->qMetaCzarId);
         LOGS(_log, LOG_LVL_DEBUG, "make UserQueryDrop: " << dbName << "." << tableName);
+        _invalidateResultCache();
         return uq;
     } else if (UserQueryType::isDropDb(query, dbName)) {
         // processing DROP DATABASE
         auto uq = std::make_shared<UserQueryDrop>(_impl->css, dbName, std::string(),
-                                                  _impl->resultDbConn.get(),
+                                                  _impl->resultDbPool,
                                                   _impl->queryMetadata, _impl->qMetaCzarId);
         LOGS(_log, LOG_LVL_DEBUG, "make UserQueryDrop: db=" << dbName);
+        _invalidateResultCache();
         return uq;
     } else if (UserQueryType::isFlushChunksCache(query, dbName)) {
         auto uq = std::make_shared<UserQueryFlushChunksCache>(_impl->css, dbName,
-                                                              _impl->resultDbConn.get());
+                                                              _impl->resultDbPool);
         LOGS(_log, LOG_LVL_DEBUG, "make UserQueryFlushChunksCache: " << dbName);
+        _invalidateResultCache();
         return uq;
     } else if (UserQueryType::isShowProcessList(query, full)) {
         LOGS(_log, LOG_LVL_DEBUG, "make UserQueryProcessList: full=" << (full ? 'y' : 'n'));
         try {
-            return std::make_shared<UserQueryProcessList>(full, _impl->resultDbConn.get(),
-                    _impl->qMetaSelect, _impl->qMetaCzarId, userQueryId);
+            return std::make_shared<UserQueryProcessList>(full, _impl->resultDbPool,
+                    _impl->qMetaSelect, _impl->qMetaCzarId, userQueryId, _impl->queryProgress);
         } catch(std::exception const& exc) {
             return std::make_shared<UserQueryInvalid>(exc.what());
         }
@@ -276,24 +566,166 @@ UserQueryFactory::newUserQuery(std::string const& aQuery,
     }
 }
 
+bool UserQueryFactory::_readKeys(std::string const& keyQuery, std::string const& defaultDb,
+                                 qdisp::QdispPool::Ptr const& qdispPool, std::string const& userQueryId,
+                                 size_t maxKeys, std::vector<std::string>& keys) {
+    LOGS(_log, LOG_LVL_DEBUG, "semi-join key query: " << keyQuery);
+    UserQuery::Ptr uq;
+    {
+        std::lock_guard<std::mutex> lock(_impl->mtx);
+        uq = _newUserQuery(keyQuery, defaultDb, qdispPool, userQueryId + "_keys", std::string(), true);
+    }
+    if (std::dynamic_pointer_cast<UserQuerySelect>(uq) == nullptr || !uq->getError().empty()) {
+        LOGS(_log, LOG_LVL_WARN, "semi-join key query not run: " << uq->getError());
+        uq->discard();
+        return false;
+    }
+    uq->submit();
+    bool success = uq->join() == SUCCESS;
+    std::string const table = uq->getResultTableName();
+    uq->discard();
+
+    std::string const dbName = _impl->mysqlResultConfig.dbName;
+    if (success) {
+        sql::SqlErrorObject errObj;
+        sql::SqlResults results;
+        auto conn = _impl->resultDbPool->acquire("semiJoin", errObj);
+        success = conn != nullptr
+                  && conn->runQuery("SELECT * FROM " + dbName + "." + table, results, errObj)
+                  && results.extractFirstColumn(keys, errObj);
+        if (!success) {
+            LOGS(_log, LOG_LVL_WARN, "semi-join keys not read: " << errObj.printErrMsg());
+        }
+    }
+    dropResultTable(_impl->resultDbPool, dbName, table);
+    if (!success) {
+        return false;
+    }
+    // The key query stops after maxKeys+1 rows, it may have left keys out.
+    if (keys.size() > maxKeys) {
+        LOGS(_log, LOG_LVL_INFO, "semi-join not run, more than " << maxKeys << " keys");
+        return false;
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    if (!std::all_of(keys.begin(), keys.end(), &SemiJoin::isKey)) {
+        LOGS(_log, LOG_LVL_INFO, "semi-join not run, keys are not integers");
+        return false;
+    }
+    return true;
+}
+
+void UserQueryFactory::_invalidateResultCache() {
+    if (_impl->resultCache != nullptr) {
+        _impl->resultCache->invalidate();
+    }
+}
+
 UserQueryFactory::Impl::Impl(czar::CzarConfig const& czarConfig)
-    : mysqlResultConfig(czarConfig.getMySqlResultConfig()) {
+    : mysqlResultConfig(czarConfig.getMySqlResultConfig()),
+      mergeShards(czarConfig.getMergeShards()),
+      aggMaxGroups(czarConfig.getAggMaxGroups()),
+      workerAggFold(czarConfig.getWorkerAggFold()),
+      topKMaxRows(czarConfig.getTopKMaxRows()),
+      sortedRunDir(czarConfig.getSortedRunDir()),
+      passThroughMemoryTableMB(czarConfig.getPassThroughMemoryTableMB()),
+      mergeJobIdPartitions(czarConfig.getMergeJobIdPartitions()),
+      resultSink(rproc::ResultSink::kindFromString(czarConfig.getResultSink())),
+      resultSinkDir(czarConfig.getResultSinkDir()),
+      resultSinkMemoryMB(czarConfig.getResultSinkMemoryMB()),
+      maxQueryCost(czarConfig.getMaxQueryCost()),
+      interactiveDeadlineMs(czarConfig.getInteractiveDeadlineMs()),
+      traceSampleEvery(std::max(0, czarConfig.getTraceSampleEvery())),
+      selectStmtCache(new SelectStmtCache(czarConfig.getSelectStmtCacheSize())),
+      semiJoinMaxKeys(std::max(0, czarConfig.getSemiJoinMaxKeys())) {
 
     executiveConfig = std::make_shared<qdisp::Executive::Config>(
                           czarConfig.getXrootdFrontendUrl(),
                           czarConfig.getQMetaSecondsBetweenChunkUpdates());
-    secondaryIndex = std::make_shared<qproc::SecondaryIndex>(mysqlResultConfig);
-
-    // make one dedicated connection for results database
-    resultDbConn.reset(new sql::SqlConnection(mysqlResultConfig));
-
-    queryMetadata = std::make_shared<qmeta::QMetaMysql>(czarConfig.getMySqlQmetaConfig());
+    executiveConfig->stragglerPercentile = czarConfig.getStragglerPercentile();
+    executiveConfig->stragglerFactor = czarConfig.getStragglerFactor();
+    executiveConfig->scanAffinityOrder = czarConfig.getScanAffinityOrder();
+    executiveConfig->maxResponseReads = czarConfig.getMaxResponseReads();
+
+    // CSS is loaded while the QMeta connections are set up.
+    auto cssFuture = std::async(std::launch::async, [&czarConfig]() {
+        return css::CssAccess::createFromConfig(czarConfig.getCssConfigMap(),
+                                                czarConfig.getEmptyChunkPath());
+    });
+
+    secondaryIndex = std::make_shared<qproc::SecondaryIndex>(mysqlResultConfig,
+                         czarConfig.getSecondaryIndexCacheSize(),
+                         czarConfig.getSecondaryIndexPath());
+
+    queryMetadata = std::make_shared<qmeta::QMetaMysql>(czarConfig.getMySqlQmetaConfig(),
+                                                        czarConfig.getQMetaMaxBatchRows());
     qMetaSelect = std::make_shared<qmeta::QMetaSelect>(czarConfig.getMySqlQmetaConfig());
 
     queryStatsData = std::make_shared<qmeta::QStatusMysql>(czarConfig.getMySqlQStatusDataConfig());
 
-    // create CssAccess instance
-    css = css::CssAccess::createFromConfig(czarConfig.getCssConfigMap(), czarConfig.getEmptyChunkPath());
+    // Query status updates are written behind so that a slow QMeta database
+    // does not hold up dispatch and merging.
+    if (czarConfig.getQMetaQueueSize() > 0) {
+        qMetaQueue = std::make_shared<qmeta::QMetaWriteQueue>(czarConfig.getQMetaQueueSize(),
+                         czarConfig.getQMetaQueueMaxRetries(),
+                         std::chrono::milliseconds(QMETA_QUEUE_RETRY_MSECS));
+        queryMetadata = std::make_shared<qmeta::QMetaAsync>(queryMetadata, qMetaQueue);
+        queryStatsData = std::make_shared<qmeta::QStatusAsync>(queryStatsData, qMetaQueue);
+    }
+
+    // The progress of running queries is aggregated in memory and only
+    // written periodically, so every completed chunk can be counted.
+    if (czarConfig.getQMetaProgressFlushSecs() > 0) {
+        queryProgress = std::make_shared<qmeta::QStatusAggregator>(queryStatsData,
+                            std::chrono::seconds(czarConfig.getQMetaProgressFlushSecs()));
+        queryStatsData = queryProgress;
+        executiveConfig->secondsBetweenChunkUpdates = 0;
+    }
+
+    css = cssFuture.get();
+
+    if (czarConfig.getReplicaSelection()) {
+        // Every chunked table of a database has its chunks on the same
+        // workers, the first one gives the replicas of all.
+        auto cssAccess = css;
+        auto load = [cssAccess](std::string const& db) {
+            for (auto const& table : cssAccess->getTableNames(db)) {
+                if (cssAccess->getPartTableParams(db, table).isChunked()) {
+                    return cssAccess->getChunks(db, table);
+                }
+            }
+            return qdisp::ReplicaSelector::Replicas();
+        };
+        auto version = [cssAccess]() { return cssAccess->getVersion(); };
+        executiveConfig->replicaSelector = std::make_shared<qdisp::ReplicaSelector>(
+            load, version, std::chrono::seconds(std::max(1, czarConfig.getReplicaCheckSecs())));
+    }
+
+    if (czarConfig.getWorkerKeepAliveSecs() > 0
+            && czarConfig.getXrootdFrontendUrl() != qdisp::Executive::Config::getMockStr()) {
+        auto cssAccess = css;
+        auto workers = [cssAccess]() {
+            std::vector<std::string> ids;
+            for (auto const& elem : cssAccess->getAllNodeParams()) {
+                if (elem.second.type == "worker" && elem.second.isActive()) {
+                    ids.push_back(elem.first);
+                }
+            }
+            return ids;
+        };
+        auto version = [cssAccess]() { return cssAccess->getVersion(); };
+        std::string const url = czarConfig.getXrootdFrontendUrl();
+        auto ping = [url](std::string const& worker) {
+            XrdSsiErrInfo eInfo;
+            XrdSsiService* service = qdisp::Executive::getSharedXrdSsiService(url, eInfo);
+            if (service != nullptr) {
+                qdisp::WarmupRequest::send(service, worker);
+            }
+        };
+        executiveConfig->workerSessions = std::make_shared<qdisp::WorkerSessions>(
+            workers, version, ping, std::chrono::seconds(czarConfig.getWorkerKeepAliveSecs()));
+        executiveConfig->workerSessions->start();
+    }
 }
 
 }}} // lsst::qserv::ccontrol
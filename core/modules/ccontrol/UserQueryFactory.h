@@ -34,6 +34,8 @@
 // System headers
 #include <cstdint>
 #include <memory>
+#include <string>
+#include <vector>
 
 // Third-party headers
 #include "boost/utility.hpp"
@@ -51,6 +53,9 @@ class SelectStmt;
 namespace czar {
 class CzarConfig;
 }
+namespace sql {
+class SqlConnectionPool;
+}
 
 namespace ccontrol {
 
@@ -61,8 +66,12 @@ namespace ccontrol {
 class UserQueryFactory : private boost::noncopyable {
 public:
 
+    /// @param czarConfig:   Czar configuration
+    /// @param czarName:     Name of this czar, registered in QMeta
+    /// @param resultDbPool: Connections to the result database shared with the czar
     UserQueryFactory(czar::CzarConfig const& czarConfig,
-                     std::string const& czarName);
+                     std::string const& czarName,
+                     std::shared_ptr<sql::SqlConnectionPool> const& resultDbPool);
 
     /// @param query:        Query text
     /// @param defaultDb:    Default database name, may be empty
@@ -77,6 +86,25 @@ public:
                                 std::string const& msgTableName);
 
 private:
+    /// newUserQuery(), with 'keyQuery' true for the key query of a semi-join,
+    /// which is neither cached nor planned as a semi-join. _impl->mtx must be held.
+    UserQuery::Ptr _newUserQuery(std::string const& query,
+                                 std::string const& defaultDb,
+                                 qdisp::QdispPool::Ptr const& qdispPool,
+                                 std::string const& userQueryId,
+                                 std::string const& msgTableName,
+                                 bool keyQuery);
+
+    /// Run 'keyQuery', the key query of a semi-join, and read the keys it returns.
+    /// @return false if it failed, returned more than 'maxKeys' keys, or keys
+    ///         that are not integers.
+    bool _readKeys(std::string const& keyQuery, std::string const& defaultDb,
+                   qdisp::QdispPool::Ptr const& qdispPool, std::string const& userQueryId,
+                   size_t maxKeys, std::vector<std::string>& keys);
+
+    /// Empty the result cache, as the data of its results may have changed.
+    void _invalidateResultCache();
+
     class Impl;
     std::shared_ptr<Impl> _impl;
 };
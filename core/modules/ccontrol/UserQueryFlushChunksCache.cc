@@ -31,8 +31,9 @@
 // Qserv headers
 #include "css/CssAccess.h"
 #include "css/EmptyChunks.h"
+#include "css/ZoneMaps.h"
 #include "qdisp/MessageStore.h"
-#include "sql/SqlConnection.h"
+#include "sql/SqlConnectionPool.h"
 #include "sql/SqlErrorObject.h"
 
 namespace {
@@ -46,8 +47,8 @@ namespace ccontrol {
 // Constructor
 UserQueryFlushChunksCache::UserQueryFlushChunksCache(std::shared_ptr<css::CssAccess> const& css,
                                                      std::string const& dbName,
-                                                     sql::SqlConnection* resultDbConn)
-    : _css(css), _dbName(dbName), _resultDbConn(resultDbConn),
+                                                     std::shared_ptr<sql::SqlConnectionPool> const& resultDbPool)
+    : _css(css), _dbName(dbName), _resultDbPool(resultDbPool),
       _qState(UNKNOWN), _messageStore(std::make_shared<qdisp::MessageStore>()) {
 }
 
@@ -66,6 +67,7 @@ void UserQueryFlushChunksCache::submit() {
 
     // reset empty chunk cache , this does not throw
     _css->getEmptyChunks().clearCache(_dbName);
+    _css->getZoneMaps().clearCache(_dbName);
 
     _qState = SUCCESS;
 }
@@ -37,7 +37,7 @@ namespace css {
 class CssAccess;
 }
 namespace sql {
-class SqlConnection;
+class SqlConnectionPool;
 }}}
 
 namespace lsst {
@@ -58,11 +58,11 @@ public:
     /**
      *  @param css:           CSS interface
      *  @param dbName:        Name of the database where table is
-     *  @param resultDbConn:  Connection to results database
+     *  @param resultDbPool:  Connections to results database
      */
     UserQueryFlushChunksCache(std::shared_ptr<css::CssAccess> const& css,
                               std::string const& dbName,
-                              sql::SqlConnection* resultDbConn);
+                              std::shared_ptr<sql::SqlConnectionPool> const& resultDbPool);
 
     UserQueryFlushChunksCache(UserQueryFlushChunksCache const&) = delete;
     UserQueryFlushChunksCache& operator=(UserQueryFlushChunksCache const&) = delete;
@@ -96,7 +96,7 @@ private:
 
     std::shared_ptr<css::CssAccess> const _css;
     std::string const _dbName;
-    sql::SqlConnection* _resultDbConn;
+    std::shared_ptr<sql::SqlConnectionPool> _resultDbPool;
     QueryState _qState;
     std::shared_ptr<qdisp::MessageStore> _messageStore;
 
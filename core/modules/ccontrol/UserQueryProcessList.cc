@@ -26,8 +26,10 @@
 
 // System headers
 #include <atomic>
+#include <cstdlib>
 #include <ctime>
 #include <sstream>
+#include <string>
 
 // LSST headers
 #include "lsst/log/Log.h"
@@ -40,7 +42,7 @@
 #include "qmeta/QMetaSelect.h"
 #include "query/FromList.h"
 #include "query/SelectStmt.h"
-#include "sql/SqlConnection.h"
+#include "sql/SqlConnectionPool.h"
 #include "sql/SqlErrorObject.h"
 #include "sql/SqlBulkInsert.h"
 #include "sql/statement.h"
@@ -64,11 +66,11 @@ namespace ccontrol {
 
 // Constructor
 UserQueryProcessList::UserQueryProcessList(std::shared_ptr<query::SelectStmt> const& statement,
-        sql::SqlConnection* resultDbConn,
+        std::shared_ptr<sql::SqlConnectionPool> const& resultDbPool,
         std::shared_ptr<qmeta::QMetaSelect> const& qMetaSelect,
         qmeta::CzarId qMetaCzarId,
         std::string const& userQueryId)
-    : _resultDbConn(resultDbConn),
+    : _resultDbPool(resultDbPool),
       _qMetaSelect(qMetaSelect),
       _qMetaCzarId(qMetaCzarId),
       _messageStore(std::make_shared<qdisp::MessageStore>()),
@@ -101,19 +103,22 @@ UserQueryProcessList::UserQueryProcessList(std::shared_ptr<query::SelectStmt> co
 }
 
 UserQueryProcessList::UserQueryProcessList(bool full,
-        sql::SqlConnection* resultDbConn,
+        std::shared_ptr<sql::SqlConnectionPool> const& resultDbPool,
         std::shared_ptr<qmeta::QMetaSelect> const& qMetaSelect,
         qmeta::CzarId qMetaCzarId,
-        std::string const& userQueryId)
-    : _resultDbConn(resultDbConn),
+        std::string const& userQueryId,
+        qmeta::QStatusAggregator::Ptr const& queryProgress)
+    : _resultDbPool(resultDbPool),
       _qMetaSelect(qMetaSelect),
       _qMetaCzarId(qMetaCzarId),
       _messageStore(std::make_shared<qdisp::MessageStore>()),
-      _resultTableName(::g_nextResultTableId(userQueryId)) {
+      _resultTableName(::g_nextResultTableId(userQueryId)),
+      _queryProgress(queryProgress) {
 
-    // use ShowProcessList view
+    // use ShowProcessList view, Progress is filled in from memory
     _query = "SELECT Id, User, Host, db, Command, Time, State, ";
     _query += full ? "Info, " : "SUBSTRING(Info FROM 1 FOR 100) Info, ";
+    _query += "CAST(Progress AS DECIMAL(7,3)) Progress, ";
     // These are non-standard but they need to be there because they appear in WHERE
     _query += "CzarId, Submitted, Completed, ResultLocation";
     _query += " FROM ShowProcessList";
@@ -160,6 +165,15 @@ void UserQueryProcessList::submit() {
         return;
     }
 
+    auto resultDbConn = _resultDbPool->acquire("processList", errObj);
+    if (not resultDbConn) {
+        LOGS(_log, LOG_LVL_ERROR, "failed to connect to results database: " << errObj.errMsg());
+        std::string message = "Internal failure, failed to connect to results database: " + errObj.errMsg();
+        _messageStore->addMessage(-1, 1051, message, MessageSeverity::MSG_ERROR);
+        _qState = ERROR;
+        return;
+    }
+
     // create result table, one could use formCreateTable() method
     // to build statement but it does not set NULL flag on TIMESTAMP columns
     std::string createTable = "CREATE TABLE " + _resultTableName;
@@ -174,7 +188,7 @@ void UserQueryProcessList::submit() {
     }
     createTable += ')';
     LOGS(_log, LOG_LVL_DEBUG, "creating result table: " << createTable);
-    if (!_resultDbConn->runQuery(createTable, errObj)) {
+    if (!resultDbConn->runQuery(createTable, errObj)) {
         LOGS(_log, LOG_LVL_ERROR, "failed to create result table: " << errObj.errMsg());
         std::string message = "Internal failure, failed to create result table: " + errObj.errMsg();
         _messageStore->addMessage(-1, 1051, message, MessageSeverity::MSG_ERROR);
@@ -188,32 +202,34 @@ void UserQueryProcessList::submit() {
         resColumns.push_back(col.name);
     }
 
-    // copy stuff over to result table
-    sql::SqlBulkInsert bulkInsert(_resultDbConn, _resultTableName, resColumns);
+    // Progress of running queries comes from memory, not from QMeta
+    int idCol = -1;
+    int progressCol = -1;
+    if (_queryProgress != nullptr) {
+        for (unsigned i = 0; i != resColumns.size(); ++i) {
+            if (resColumns[i] == "Id") idCol = i;
+            if (resColumns[i] == "Progress") progressCol = i;
+        }
+    }
+
+    // copy stuff over to result table, values are passed as they are
+    sql::SqlBulkInsert bulkInsert(resultDbConn.get(), _resultTableName, resColumns);
+    sql::SqlBulkInsert::RowView values;
+    std::string progress;
     for (auto& row: *results) {
 
-        std::vector<std::string> values;
-        for (unsigned i = 0; i != row.size(); ++i) {
-            auto ptr = row[i].first;
-            auto len = row[i].second;
-
-            if (ptr == nullptr) {
-                values.push_back("NULL");
-            } else if (IS_NUM(schema.columns[i].colType.mysqlType) &&
-                    schema.columns[i].colType.mysqlType != MYSQL_TYPE_TIMESTAMP) {
-                // Numeric types do not need quoting (IS_NUM is mysql macro).
-                // In mariadb 10.2 IS_NUM returns true for TIMESTAMP even though value is
-                // date-time formatted string, IS_NUM returned false in mariadb 10.1 and prior.
-                // Potentially we can quote all values, but I prefer to have numbers look like
-                // numbers, both solutions (IS_NUM or quotes) are mysql-specific.
-                values.push_back(std::string(ptr, ptr+len));
-            } else {
-                // everything else should be quoted
-                values.push_back("'" + _resultDbConn->escapeString(std::string(ptr, ptr+len)) + "'");
+        values.assign(row.begin(), row.end());
+        if (progressCol >= 0 && idCol >= 0 && row[idCol].first != nullptr) {
+            qmeta::QStats stats;
+            std::string const idStr(row[idCol].first, row[idCol].second);
+            QueryId const queryId = std::strtoull(idStr.c_str(), nullptr, 10);
+            if (_queryProgress->getLocal(queryId, stats) && stats.totalChunks > 0) {
+                progress = std::to_string(100.0 * stats.completedChunks / stats.totalChunks);
+                values[progressCol] = std::make_pair(progress.data(), progress.size());
             }
         }
 
-        if (!bulkInsert.addRow(values, errObj)) {
+        if (!bulkInsert.addRowView(values, errObj)) {
             LOGS(_log, LOG_LVL_ERROR, "error updating result table: " << errObj.errMsg());
             std::string message = "Internal failure, error updating result table: " + errObj.errMsg();
             _messageStore->addMessage(-1, 1051, message, MessageSeverity::MSG_ERROR);
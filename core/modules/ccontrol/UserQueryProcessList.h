@@ -33,6 +33,7 @@
 // Qserv headers
 #include "ccontrol/UserQuery.h"
 #include "qmeta/QMetaSelect.h"
+#include "qmeta/QStatusAggregator.h"
 #include "qmeta/types.h"
 
 // Forward decl
@@ -45,7 +46,7 @@ namespace query {
 class SelectStmt;
 }
 namespace sql {
-class SqlConnection;
+class SqlConnectionPool;
 }}}
 
 
@@ -61,13 +62,13 @@ public:
      *  Constructor for "SELECT ... FROM  INFORMATION_SCHEMA.PROCESSLIST ...".
      *
      *  @param statement:     Parsed SELECT statement
-     *  @param resultDbConn:  Connection to results database
+     *  @param resultDbPool:  Connections to results database
      *  @param qMetaSelect:   QMetaSelect instance
      *  @param qMetaCzarId:   Czar ID for QMeta queries
      *  @param userQueryId:   Unique string identifying query
      */
     UserQueryProcessList(std::shared_ptr<query::SelectStmt> const& statement,
-            sql::SqlConnection* resultDbConn,
+            std::shared_ptr<sql::SqlConnectionPool> const& resultDbPool,
             std::shared_ptr<qmeta::QMetaSelect> const& qMetaSelect,
             qmeta::CzarId qMetaCzarId,
             std::string const& userQueryId);
@@ -76,16 +77,19 @@ public:
      *  Constructor for "SHOW [FULL] PROCESSLIST".
      *
      *  @param full:          True if FULL is in query
-     *  @param resultDbConn:  Connection to results database
+     *  @param resultDbPool:  Connections to results database
      *  @param qMetaSelect:   QMetaSelect instance
      *  @param qMetaCzarId:   Czar ID for QMeta queries
      *  @param userQueryId:   Unique string identifying query
+     *  @param queryProgress: In-memory progress of this czar's queries, used
+     *                        for the Progress column, may be null
      */
     UserQueryProcessList(bool full,
-            sql::SqlConnection* resultDbConn,
+            std::shared_ptr<sql::SqlConnectionPool> const& resultDbPool,
             std::shared_ptr<qmeta::QMetaSelect> const& qMetaSelect,
             qmeta::CzarId qMetaCzarId,
-            std::string const& userQueryId);
+            std::string const& userQueryId,
+            qmeta::QStatusAggregator::Ptr const& queryProgress=nullptr);
 
     UserQueryProcessList(UserQueryProcessList const&) = delete;
     UserQueryProcessList& operator=(UserQueryProcessList const&) = delete;
@@ -124,13 +128,14 @@ public:
 
 private:
 
-    sql::SqlConnection* _resultDbConn;
+    std::shared_ptr<sql::SqlConnectionPool> _resultDbPool;
     std::shared_ptr<qmeta::QMetaSelect> _qMetaSelect;
     qmeta::CzarId const _qMetaCzarId;   ///< Czar ID in QMeta database
     QueryState _qState = UNKNOWN;
     std::shared_ptr<qdisp::MessageStore> _messageStore;
     std::string _resultTableName;
     std::string _query;            ///< query to execute on QMeta database
+    qmeta::QStatusAggregator::Ptr _queryProgress; ///< Fills the Progress column, may be null
     std::string _orderBy;
 
 };
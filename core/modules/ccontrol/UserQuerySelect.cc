@@ -64,9 +64,13 @@
 #include "ccontrol/UserQuerySelect.h"
 
 // System headers
+#include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <iomanip>
 #include <memory>
+#include <set>
+#include <sstream>
 
 // Third-party headers
 #include <boost/algorithm/string/replace.hpp>
@@ -76,9 +80,12 @@
 #include "lsst/log/Log.h"
 
 // Qserv headers
+#include "ccontrol/MergeBufferPool.h"
 #include "ccontrol/MergingHandler.h"
+#include "ccontrol/ResultTableCache.h"
 #include "ccontrol/TmpTableName.h"
 #include "ccontrol/UserQueryError.h"
+#include "css/ChunkBitmap.h"
 #include "global/constants.h"
 #include "global/MsgReceiver.h"
 #include "proto/worker.pb.h"
@@ -97,6 +104,8 @@
 #include "rproc/InfileMerger.h"
 #include "util/IterableFormatter.h"
 #include "util/ThreadPriority.h"
+#include "util/Timer.h"
+#include "util/Trace.h"
 
 namespace {
 
@@ -180,6 +189,9 @@ void UserQuerySelect::kill() {
     std::lock_guard<std::mutex> lock(_killMutex);
     if (!_killed) {
         _killed = true;
+        if (_admission != nullptr) {
+            _admission->cancel(_qMetaQueryId);
+        }
         try {
             // make a copy of executive pointer to keep it alive and avoid race
             // with pointer being reset in discard() method
@@ -196,6 +208,14 @@ void UserQuerySelect::kill() {
 }
 
 
+void UserQuerySelect::setResultCache(std::shared_ptr<ResultTableCache> const& cache,
+                                     std::string const& key) {
+    _resultCache = cache;
+    _resultCacheKey = key;
+    _resultCacheGeneration = cache->getGeneration();
+}
+
+
 std::string
 UserQuerySelect::getProxyOrderBy() const {
     return _qSession->getProxyOrderBy();
@@ -204,6 +224,45 @@ UserQuerySelect::getProxyOrderBy() const {
 
 /// Begin running on all chunks added so far.
 void UserQuerySelect::submit() {
+    // A semi-join first reads the keys of its selective side, its chunks are
+    // then those holding the keys. Without the keys it runs as it is.
+    if (_semiJoin) {
+        auto const qs = _semiJoin();
+        _semiJoin = nullptr;
+        if (qs != nullptr) {
+            _qSession = qs;
+            setupChunking();
+        } else {
+            _checkCost();
+        }
+        if (!_errorExtra.empty()) {
+            _admissionRejected = true;
+            // Error: 1105 SQLSTATE: HY000 (ER_UNKNOWN_ERROR) Message: Unknown error
+            _messageStore->addMessage(-1, 1105, _errorExtra, MessageSeverity::MSG_ERROR);
+            return;
+        }
+    }
+
+    // A cheap query that does not read many rows goes to the interactive
+    // pool queue, even when it touches too many chunks to count as an
+    // interactive scan on the workers.
+    bool const interactive = _qSession->getScanInteractive()
+                             || (_cost.restricted && _cost.cost <= qproc::QueryCost::INTERACTIVE_COST);
+
+    // Wait for the czar to have room for this query, nothing is set up before.
+    if (_admission != nullptr) {
+        auto const qClass = _async ? AdmissionController::ASYNC
+                          : interactive ? AdmissionController::INTERACTIVE : AdmissionController::SCAN;
+        std::string reason;
+        _admissionTicket = _admission->admit(_qMetaQueryId, qClass, _cost, reason);
+        if (_admissionTicket == nullptr) {
+            _admissionRejected = true;
+            // Error: 1040 SQLSTATE: 08004 (ER_CON_COUNT_ERROR) Message: Too many connections
+            _messageStore->addMessage(-1, 1040, reason, MessageSeverity::MSG_ERROR);
+            return;
+        }
+    }
+
     _qSession->finalize();
 
     // has to be done after result table name
@@ -214,13 +273,32 @@ void UserQuerySelect::submit() {
     LOGS(_log, LOG_LVL_DEBUG, getQueryIdString() << " UserQuerySelect beginning submission");
     assert(_infileMerger);
 
-    auto taskMsgFactory = std::make_shared<qproc::TaskMsgFactory>(_qMetaQueryId);
+    // The workers are asked to finish the tasks of interactive queries in time.
+    uint32_t const deadlineMs = interactive ? _interactiveDeadlineMs : 0;
+    // The workers size their result messages to what the merge can take now.
+    uint32_t resultMinBytes = 0;
+    uint32_t resultMaxBytes = 0;
+    MergeBufferPool::instance().getMessageRange(resultMinBytes, resultMaxBytes);
+    // Sampled queries need the partial totals of each chunk to estimate their error.
+    std::shared_ptr<query::AggRecord::FoldVector const> workerFold;
+    if (_workerAggFold && _qSession->getSampleEvery() <= 1) {
+        workerFold = _qSession->getAggFold();
+    }
+    auto taskMsgFactory = std::make_shared<qproc::TaskMsgFactory>(_qMetaQueryId, _qMetaCzarId, deadlineMs,
+                                                                  _trace != nullptr,
+                                                                  resultMinBytes, resultMaxBytes,
+                                                                  workerFold);
     TmpTableName ttn(_qMetaQueryId, _qSession->getOriginal());
     std::vector<int> chunks;
     std::mutex chunksMtx;
     int sequence = 0;
 
     auto queryTemplates = _qSession->makeQueryTemplates();
+    // The chunk queries only differ by the chunk id, let the workers fill it in.
+    std::shared_ptr<std::vector<std::string> const> taggedQueries;
+    if (_qSession->cQueryBegin() != _qSession->cQueryEnd()) {
+        taggedQueries = _qSession->makeTaggedQueries(queryTemplates, *_qSession->cQueryBegin());
+    }
 
     std::atomic<int> addTimeSum; // TEMPORARY-timing
 
@@ -242,21 +320,36 @@ void UserQuerySelect::submit() {
         LOGS(_log, LOG_LVL_WARN, "Failed queryStatsTmpRegister " << getQueryIdString() << " " << e.what());
     }
 
-    for(auto i = _qSession->cQueryBegin(), e = _qSession->cQueryEnd();
-            i != e && !_executive->getCancelled(); ++i) {
-        auto& chunkSpec = *i;
+    // Scan queries start with the chunks the worker scans reach next.
+    std::vector<int> chunkIds;
+    chunkIds.reserve(_qSession->getChunksSize());
+    for (auto i = _qSession->cQueryBegin(), e = _qSession->cQueryEnd(); i != e; ++i) {
+        chunkIds.push_back(i->chunkId);
+    }
+    auto const dispatchOrder = _executive->dispatchOrder(chunkIds, interactive);
+
+    for (auto iter = dispatchOrder.begin();
+            iter != dispatchOrder.end() && !_executive->getCancelled(); ++iter) {
+        auto& chunkSpec = *(_qSession->cQueryBegin() + *iter);
 
+        uint64_t const queuedUs = (_trace != nullptr) ? util::traceNowUs() : 0;
         std::function<void(util::CmdData*)> funcBuildJob =
-                [this, sequence,     // sequence must be a copy
-                 &chunkSpec, &queryTemplates,
+                [this, sequence, queuedUs,     // sequence must be a copy
+                 &chunkSpec, &queryTemplates, &taggedQueries,
                  &chunks, &chunksMtx, &ttn,
                  &taskMsgFactory, &addTimeSum](util::CmdData*) {
 
             auto startbuildQSJ = std::chrono::system_clock::now(); // TEMPORARY-timing
-            qproc::ChunkQuerySpec::Ptr cs;
+            if (_trace != nullptr) {
+                // Time the job waited in the QdispPool queue.
+                _trace->add("dispatch_queue", sequence, 0, queuedUs, util::traceNowUs() - queuedUs);
+            }
+            // Building the spec only reads the analyzed query, so the pool
+            // threads build specs in parallel and dispatch each as it is ready.
+            qproc::ChunkQuerySpec::Ptr cs =
+                    _qSession->buildChunkQuerySpec(queryTemplates, chunkSpec, taggedQueries);
             {
                 std::lock_guard<std::mutex> lock(chunksMtx);
-                cs = _qSession->buildChunkQuerySpec(queryTemplates, chunkSpec);
                 chunks.push_back(cs->chunkId);
             }
             std::string chunkResultName = ttn.make(cs->chunkId);
@@ -266,7 +359,7 @@ void UserQuerySelect::submit() {
             ru.setAsDbChunk(cs->db, cs->chunkId);
             qdisp::JobDescription::Ptr jobDesc = qdisp::JobDescription::create(
                     _executive->getId(), sequence, ru,
-                    std::make_shared<MergingHandler>(cmr, _infileMerger, chunkResultName),
+                    std::make_shared<MergingHandler>(cmr, _infileMerger, chunkResultName, _trace),
                     taskMsgFactory, cs, chunkResultName);
             _executive->add(jobDesc);
             auto endChunkAddQSJ = std::chrono::system_clock::now(); // TEMPORARY-timing
@@ -276,7 +369,7 @@ void UserQuerySelect::submit() {
         };
 
         auto cmd = std::make_shared<qdisp::PriorityCommand>(funcBuildJob);
-        _executive->queueJobStart(cmd, _qSession->getScanInteractive());
+        _executive->queueJobStart(cmd, interactive);
         ++sequence;
     }
 
@@ -311,8 +404,21 @@ void UserQuerySelect::submit() {
 /// Block until a submit()'ed query completes.
 /// @return the QueryState indicating success or failure
 QueryState UserQuerySelect::join() {
+    if (_admissionRejected) {
+        if (_resultCache != nullptr) {
+            _resultCache->retire(_resultTable);
+        }
+        if (!_killed) {
+            _qMetaUpdateStatus(qmeta::QInfo::FAILED);
+        }
+        LOGS(_log, LOG_LVL_ERROR, getQueryIdString() << " Joined nothing (not admitted)");
+        return ERROR;
+    }
     bool successful = _executive->join(); // Wait for all data
     // Since all data are in, run final SQL commands like GROUP BY.
+    uint64_t const finalizeStartUs = util::traceNowUs();
+    util::Timer finalizeTimer;
+    finalizeTimer.start();
     if (!_infileMerger->finalize()) {
         successful = false;
         LOGS(_log, LOG_LVL_ERROR, getQueryIdString() << " InfileMerger::finalize failed");
@@ -320,6 +426,16 @@ QueryState UserQuerySelect::join() {
         _messageStore->addMessage(-1, 1105, "Failure while merging result",
                 MessageSeverity::MSG_ERROR);
     }
+    if (successful && _qSession->getSampleEvery() > 1) {
+        _addSampleMessage();
+    }
+    finalizeTimer.stop();
+    if (_trace != nullptr) {
+        _trace->add("finalize", -1, 0, finalizeStartUs,
+                    static_cast<uint64_t>(finalizeTimer.getElapsed() * 1e6));
+        LOGS(_log, LOG_LVL_INFO, getQueryIdString() << " trace " << _trace->breakdownStr());
+        _trace->writeTraceFile();
+    }
     try {
         _discardMerger();
     } catch (std::exception const& exc) {
@@ -327,6 +443,20 @@ QueryState UserQuerySelect::join() {
         // it or expose it to user, just dump it to log
         LOGS(_log, LOG_LVL_ERROR, getQueryIdString() << " exception from _discardMerger: "<< exc.what());
     }
+    if (_resultCache != nullptr) {
+        // The proxy leaves the table to the cache, which drops it if it is not kept.
+        if (successful) {
+            ResultTableCache::Entry entry;
+            entry.table = _resultTable;
+            entry.orderBy = getProxyOrderBy();
+            bool const kept = _resultCache->put(_resultCacheKey, entry, _resultCacheGeneration);
+            LOGS(_log, LOG_LVL_DEBUG, getQueryIdString() << " result table "
+                 << (kept ? "cached" : "not cached"));
+        } else {
+            _resultCache->retire(_resultTable);
+        }
+    }
+    _admissionTicket.reset();
     if (successful) {
         _qMetaUpdateStatus(qmeta::QInfo::COMPLETED);
         LOGS(_log, LOG_LVL_DEBUG, getQueryIdString() << " Joined everything (success)");
@@ -375,11 +505,55 @@ void UserQuerySelect::discard() {
     LOGS(_log, LOG_LVL_DEBUG, getQueryIdString() << " Discarded UserQuerySelect");
 }
 
+/// Report the sampled fraction of a SAMPLE query, and the estimated errors
+/// of its totals if they are known, in the message table.
+void UserQuerySelect::_addSampleMessage() {
+    int const sampleEvery = _qSession->getSampleEvery();
+    std::ostringstream os;
+    os << "Sampled " << _sampledChunks << " of " << _coveredChunks << " chunks (one in "
+       << sampleEvery << "), COUNT and SUM results are scaled by " << sampleEvery << ".";
+    auto const errors = _infileMerger->getSampleErrors();
+    if (!errors.empty()) {
+        os << " Relative standard errors:";
+        for (auto const& error : errors) {
+            os << " " << error.first << "=" << std::setprecision(2) << 100 * error.second << "%";
+        }
+    }
+    LOGS(_log, LOG_LVL_INFO, getQueryIdString() << " " << os.str());
+    // Code 0, this is not an error.
+    _messageStore->addMessage(-1, 0, os.str(), MessageSeverity::MSG_INFO);
+}
+
 /// Setup merger (for results handling and aggregation)
 void UserQuerySelect::_setupMerger() {
     LOGS(_log, LOG_LVL_TRACE, getQueryIdString() << " Setup merger");
     _infileMergerConfig->targetTable = _resultTable;
     _infileMergerConfig->mergeStmt = _qSession->getMergeStmt();
+    _infileMergerConfig->aggFold = _qSession->getAggFold();
+    _infileMergerConfig->rowLimit = _qSession->getRowLimit();
+    _infileMergerConfig->topK = _qSession->getTopK();
+    _infileMergerConfig->topKOrder = _qSession->getTopKOrder();
+    _infileMergerConfig->sortedOrder = _qSession->getSortedOrder();
+    _infileMergerConfig->sampleEvery = _qSession->getSampleEvery();
+    _infileMergerConfig->smallResult = _cost.isSmallResult();
+    if (_cost.isSmallResult()) {
+        // Shards only pay off when many rows are merged, and so does
+        // holding the rows outside of MySQL until the end.
+        _infileMergerConfig->mergeShards = 1;
+        _infileMergerConfig->resultSink = rproc::ResultSink::MYSQL;
+    }
+    if (!_infileMergerConfig->sortedOrder.empty() && !_infileMergerConfig->sortedRunDir.empty()) {
+        // Sorted chunk results are loaded in order, through a single table.
+        _infileMergerConfig->mergeShards = 1;
+    }
+    // Merged bytes and rows are part of the query progress.
+    if (_queryStatsData != nullptr) {
+        auto queryStatsData = _queryStatsData;
+        auto const queryId = _qMetaQueryId;
+        _infileMergerConfig->onMerged = [queryStatsData, queryId](uint64_t bytes, uint64_t rows) {
+            queryStatsData->queryStatsTmpMergeUpdate(queryId, bytes, rows);
+        };
+    }
     _infileMerger = std::make_shared<rproc::InfileMerger>(*_infileMergerConfig);
 }
 
@@ -393,41 +567,74 @@ void UserQuerySelect::setupChunking() {
         throw UserQueryError(getQueryIdString() + " Couldn't determine dominantDb for dispatch");
     }
 
-    std::shared_ptr<IntSet const> eSet = _qSession->getEmptyChunks();
-    {
-        eSet = _qSession->getEmptyChunks();
-        if (!eSet) {
-            eSet = std::make_shared<IntSet>();
-            LOGS(_log, LOG_LVL_WARN, getQueryIdString() << " Missing empty chunks info for " << dominantDb);
-        }
+    std::shared_ptr<css::ChunkBitmap const> eSet = _qSession->getEmptyChunks();
+    if (!eSet) {
+        eSet = std::make_shared<css::ChunkBitmap>();
+        LOGS(_log, LOG_LVL_WARN, getQueryIdString() << " Missing empty chunks info for " << dominantDb);
     }
     // FIXME add operator<< for QuerySession
     LOGS(_log, LOG_LVL_TRACE, getQueryIdString() << " _qSession: " << _qSession);
-    if (_qSession->hasChunks()) {
+    if (_qSession->isUnsatisfiable()) {
+        LOGS(_log, LOG_LVL_DEBUG, getQueryIdString()
+             << " WHERE clause selects no rows, QuerySession will add dummy chunk");
+    } else if (_qSession->hasChunks()) {
         std::shared_ptr<query::ConstraintVector> constraints = _qSession->getConstraints();
         css::StripingParams partStriping = _qSession->getDbStriping();
 
-        im = std::make_shared<qproc::IndexMap>(partStriping, _secondaryIndex);
+        // Empty chunks are left out by the index map.
+        im = std::make_shared<qproc::IndexMap>(partStriping, _secondaryIndex, eSet);
         qproc::ChunkSpecVector csv;
         if (constraints) {
             csv = im->getChunks(*constraints);
         } else { // Unconstrained: full-sky
             csv = im->getAllChunks();
         }
+        std::set<int> const& pruned = _qSession->getPrunedChunks();
+        if (!pruned.empty()) {
+            size_t const covered = csv.size();
+            auto isPruned = [&pruned](qproc::ChunkSpec const& spec) { return pruned.count(spec.chunkId) > 0; };
+            csv.erase(std::remove_if(csv.begin(), csv.end(), isPruned), csv.end());
+            LOGS(_log, LOG_LVL_INFO, getQueryIdString() << " zone maps left out " << covered - csv.size()
+                 << " of " << covered << " chunks");
+        }
+        int const sampleEvery = _qSession->getSampleEvery();
+        if (sampleEvery > 1) {
+            _coveredChunks = csv.size();
+            csv = qproc::sampleChunks(csv, sampleEvery);
+            _sampledChunks = csv.size();
+            LOGS(_log, LOG_LVL_INFO, getQueryIdString() << " sampled " << _sampledChunks
+                 << " of " << _coveredChunks << " chunks, one in " << sampleEvery);
+        }
 
         LOGS(_log, LOG_LVL_TRACE, getQueryIdString() << " Chunk specs: " << util::printable(csv));
-        // Filter out empty chunks
         for(qproc::ChunkSpecVector::const_iterator i=csv.begin(), e=csv.end();
             i != e;
             ++i) {
-            if (eSet->count(i->chunkId) == 0) { // chunk not in empty?
-                _qSession->addChunk(*i);
-            }
+            _qSession->addChunk(*i);
         }
     } else {
         LOGS(_log, LOG_LVL_TRACE, getQueryIdString() << " No chunks added, QuerySession will add dummy chunk");
     }
     _qSession->setScanInteractive();
+
+    _cost = _qSession->estimateCost();
+    LOGS(_log, LOG_LVL_INFO, getQueryIdString() << " " << _cost);
+    // The cost of a semi-join is known once its keys are read, in submit().
+    if (!_semiJoin) {
+        _checkCost();
+    }
+}
+
+void UserQuerySelect::_checkCost() {
+    if (_maxQueryCost > 0 && _cost.cost > _maxQueryCost) {
+        std::ostringstream os;
+        os << "Query rejected, its estimated cost " << _cost.cost
+           << " is above the limit " << _maxQueryCost
+           << ". Restrict it with a spatial or secondary index constraint.";
+        _errorExtra = os.str();
+        LOGS(_log, LOG_LVL_WARN, getQueryIdString() << " " << _errorExtra);
+        _qMetaUpdateStatus(qmeta::QInfo::FAILED);
+    }
 }
 
 // register query in qmeta database
@@ -458,8 +665,9 @@ void UserQuerySelect::qMetaRegister(std::string const& resultLocation, std::stri
     std::string proxyOrderBy = _qSession->getProxyOrderBy();
     _resultLoc = resultLocation;
     if (_resultLoc.empty()) {
-        // Special token #QID# is replaced with query ID later.
-        _resultLoc = "table:result_#QID#";
+        // Special token #QID# is replaced with query ID later. A table of the
+        // result cache is told apart from those the proxy drops by its name.
+        _resultLoc = (_resultCache != nullptr) ? "table:qcache_#QID#" : "table:result_#QID#";
     }
     qmeta::QInfo qInfo(qType, _qMetaCzarId, user, _qSession->getOriginal(),
                        qTemplate, qMerge, proxyOrderBy, _resultLoc, msgTableName);
@@ -527,6 +735,19 @@ void UserQuerySelect::qMetaRegister(std::string const& resultLocation, std::stri
 void UserQuerySelect::_qMetaUpdateStatus(qmeta::QInfo::QStatus qStatus)
 {
     _queryMetadata->completeQuery(_qMetaQueryId, qStatus);
+    // Resources used on the workers, for accounting. A killed query only has
+    // those of the jobs that returned.
+    if (_executive != nullptr) {
+        qmeta::QUsage const usage = _executive->getUsage();
+        LOGS(_log, LOG_LVL_INFO, getQueryIdString() << " usage cpuUs=" << usage.cpuUs
+             << " rowsRead=" << usage.rowsRead << " bytesTransmitted=" << usage.bytesTransmitted
+             << " memLockedBytes=" << usage.memLockedBytes);
+        try {
+            _queryMetadata->saveQueryUsage(_qMetaQueryId, usage);
+        } catch (qmeta::SqlError const& e) {
+            LOGS(_log, LOG_LVL_WARN, "saveQueryUsage failed " << _queryIdStr << " " << e.what());
+        }
+    }
     // Remove the row for temporary query statistics.
     try {
         _queryStatsData->queryStatsTmpRemove(_qMetaQueryId);
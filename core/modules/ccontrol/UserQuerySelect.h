@@ -32,19 +32,23 @@
   */
 
 // System headers
+#include <algorithm>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <mutex>
 
 // Third-party headers
 
 // Qserv headers
+#include "ccontrol/AdmissionController.h"
 #include "ccontrol/UserQuery.h"
 #include "css/StripingParams.h"
 #include "qmeta/QInfo.h"
 #include "qmeta/QStatus.h"
 #include "qmeta/types.h"
 #include "qproc/ChunkSpec.h"
+#include "qproc/QueryCost.h"
 #include "query/Constraint.h"
 
 // Forward decl
@@ -64,6 +68,9 @@ class SecondaryIndex;
 namespace rproc {
 class InfileMerger;
 class InfileMergerConfig;
+}
+namespace util {
+class QueryTrace;
 }}}
 
 namespace lsst {
@@ -79,6 +86,8 @@ class TaskMsgFactory;
 
 namespace ccontrol {
 
+class ResultTableCache;
+
 /// UserQuerySelect : implementation of the UserQuery for regular SELECT statements.
 class UserQuerySelect : public UserQuery {
 public:
@@ -145,10 +154,43 @@ public:
     /// @return True if query is async query
     bool isAsync() const override { return _async; }
 
+    /// @return True if the result table is handed to the result cache
+    bool isResultCached() const override { return _resultCache != nullptr; }
+
+    /// Reject queries whose estimated cost is above 'maxCost', 0 accepts every query.
+    void setMaxQueryCost(double maxCost) { _maxQueryCost = maxCost; }
+
+    /// Give each task of an interactive query 'deadlineMs' on its worker, 0 for no deadline.
+    void setInteractiveDeadlineMs(int deadlineMs) { _interactiveDeadlineMs = std::max(0, deadlineMs); }
+    /// Ask the workers to fold the partial aggregates of the chunks they hold.
+    void setWorkerAggFold(bool workerAggFold) { _workerAggFold = workerAggFold; }
+
+    /// Record the stages of this query in 'trace', null for an untraced query.
+    void setTrace(std::shared_ptr<util::QueryTrace> const& trace) { _trace = trace; }
+
+    /// Hand the result table to 'cache' once the query is done, under 'key'.
+    /// To be called before qMetaRegister(), which names the result table.
+    void setResultCache(std::shared_ptr<ResultTableCache> const& cache, std::string const& key);
+
+    /// Wait for 'admission' to let the query start before dispatching it.
+    void setAdmissionController(std::shared_ptr<AdmissionController> const& admission) {
+        _admission = admission;
+    }
+
+    /// Function returning the session of the query restricted to the keys of
+    /// its selective side, read by a query of their own, or nullptr to run
+    /// the query as it is. See SemiJoin.
+    typedef std::function<std::shared_ptr<qproc::QuerySession>()> SemiJoinFunc;
+
+    /// Have submit() first call 'semiJoin' and run the session it returns.
+    void setSemiJoin(SemiJoinFunc const& semiJoin) { _semiJoin = semiJoin; }
+
     void setupChunking();
 
 private:
     void _setupMerger();
+    void _checkCost();
+    void _addSampleMessage();
     void _discardMerger();
     void _qMetaUpdateStatus(qmeta::QInfo::QStatus qStatus);
     void _qMetaAddChunks(std::vector<int> const& chunks);
@@ -171,9 +213,25 @@ private:
     bool _killed{false};
     std::mutex _killMutex;
     std::string _errorExtra;    ///< Additional error information
+    double _maxQueryCost{0.0};  ///< Max estimated cost of an accepted query, 0 for no limit
+    int _interactiveDeadlineMs{0}; ///< Worker deadline of interactive tasks, 0 for none
+    bool _workerAggFold{false}; ///< True to have the workers fold partial aggregates
+    qproc::QueryCost _cost;     ///< Estimated cost, set by setupChunking()
+    /// Chunks sampled and chunks covered by the query, set by setupChunking()
+    /// when the query runs on a sample of its chunks.
+    size_t _sampledChunks{0};
+    size_t _coveredChunks{0};
     std::string _resultTable;   ///< Result table name
     std::string _resultLoc;     ///< Result location
     bool _async;                ///< true for async query
+    std::shared_ptr<util::QueryTrace> _trace; ///< Null unless the query was sampled for tracing
+    std::shared_ptr<ResultTableCache> _resultCache; ///< Null unless the result may be cached
+    std::string _resultCacheKey;     ///< Key of the result in _resultCache
+    uint64_t _resultCacheGeneration{0}; ///< Generation of _resultCache when the query started
+    std::shared_ptr<AdmissionController> _admission; ///< Null if every query starts at once
+    AdmissionController::Ticket::Ptr _admissionTicket; ///< Held while the query runs
+    bool _admissionRejected{false}; ///< True if the query was not let start, or rejected by its cost
+    SemiJoinFunc _semiJoin; ///< Empty unless the query is run as a semi-join
 };
 
 }}} // namespace lsst::qserv:ccontrol
@@ -0,0 +1,84 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "ccontrol/UserQuerySelectStats.h"
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "qdisp/MessageStore.h"
+#include "sql/SqlConnectionPool.h"
+#include "sql/SqlErrorObject.h"
+
+namespace {
+LOG_LOGGER _log = LOG_GET("lsst.qserv.ccontrol.UserQuerySelectStats");
+}
+
+namespace lsst {
+namespace qserv {
+namespace ccontrol {
+
+UserQuerySelectStats::UserQuerySelectStats(std::vector<std::pair<std::string, std::string>> const& answer,
+                                           std::shared_ptr<sql::SqlConnectionPool> const& resultDbPool,
+                                           std::string const& userQueryId)
+    : _answer(answer),
+      _resultDbPool(resultDbPool),
+      _messageStore(std::make_shared<qdisp::MessageStore>()),
+      _resultTableName("qserv_result_stats_" + userQueryId) {
+}
+
+void UserQuerySelectStats::submit() {
+    std::string createTable = "CREATE TABLE " + _resultTableName + " SELECT ";
+    char const* sep = "";
+    for (auto const& column: _answer) {
+        std::string name = column.first;
+        for (size_t pos = name.find('`'); pos != std::string::npos; pos = name.find('`', pos + 2)) {
+            name.insert(pos, 1, '`');
+        }
+        createTable += sep + column.second + " AS `" + name + "`";
+        sep = ", ";
+    }
+
+    sql::SqlErrorObject errObj;
+    auto resultDbConn = _resultDbPool->acquire("selectStats", errObj);
+    if (not resultDbConn) {
+        LOGS(_log, LOG_LVL_ERROR, "failed to connect to results database: " << errObj.errMsg());
+        std::string message = "Internal failure, failed to connect to results database: " + errObj.errMsg();
+        _messageStore->addMessage(-1, 1051, message, MessageSeverity::MSG_ERROR);
+        _qState = ERROR;
+        return;
+    }
+    LOGS(_log, LOG_LVL_DEBUG, "creating result table: " << createTable);
+    if (!resultDbConn->runQuery(createTable, errObj)) {
+        LOGS(_log, LOG_LVL_ERROR, "failed to create result table: " << errObj.errMsg());
+        std::string message = "Internal failure, failed to create result table: " + errObj.errMsg();
+        _messageStore->addMessage(-1, 1051, message, MessageSeverity::MSG_ERROR);
+        _qState = ERROR;
+        return;
+    }
+    _qState = SUCCESS;
+}
+
+}}} // lsst::qserv::ccontrol
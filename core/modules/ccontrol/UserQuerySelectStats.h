@@ -0,0 +1,106 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_QSERV_CCONTROL_USERQUERYSELECTSTATS_H
+#define LSST_QSERV_CCONTROL_USERQUERYSELECTSTATS_H
+
+// System headers
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Qserv headers
+#include "ccontrol/UserQuery.h"
+
+// Forward decl
+namespace lsst {
+namespace qserv {
+namespace sql {
+class SqlConnectionPool;
+}}}
+
+namespace lsst {
+namespace qserv {
+namespace ccontrol {
+
+/// UserQuerySelectStats : implementation of the UserQuery for an aggregate
+/// SELECT whose result row qana::AggregatePlugin computed from per-chunk
+/// statistics. The row goes to the result table, nothing is dispatched.
+class UserQuerySelectStats : public UserQuery {
+public:
+
+    /**
+     *  @param answer:        Column name and SQL value of each result column
+     *  @param resultDbPool:  Connections to results database
+     *  @param userQueryId:   Unique string identifying query
+     */
+    UserQuerySelectStats(std::vector<std::pair<std::string, std::string>> const& answer,
+                         std::shared_ptr<sql::SqlConnectionPool> const& resultDbPool,
+                         std::string const& userQueryId);
+
+    UserQuerySelectStats(UserQuerySelectStats const&) = delete;
+    UserQuerySelectStats& operator=(UserQuerySelectStats const&) = delete;
+
+    // Accessors
+
+    /// @return a non-empty string describing the current error state
+    /// Returns an empty string if no errors have been detected.
+    std::string getError() const override { return std::string(); }
+
+    /// Begin execution of the query over all ChunkSpecs added so far.
+    void submit() override;
+
+    /// Wait until the query has completed execution.
+    /// @return the final execution state.
+    QueryState join() override { return _qState; }
+
+    /// Stop a query in progress (for immediate shutdowns)
+    void kill() override {}
+
+    /// Release resources related to user query
+    void discard() override {}
+
+    // Delegate objects
+    std::shared_ptr<qdisp::MessageStore> getMessageStore() override {
+        return _messageStore; }
+
+    /// @return Name of the result table for this query
+    std::string getResultTableName() const override { return _resultTableName; }
+
+    /// @return Result location for this query
+    std::string getResultLocation() const override { return "table:" + _resultTableName; }
+
+private:
+
+    std::vector<std::pair<std::string, std::string>> const _answer;
+    std::shared_ptr<sql::SqlConnectionPool> _resultDbPool;
+    QueryState _qState = UNKNOWN;
+    std::shared_ptr<qdisp::MessageStore> _messageStore;
+    std::string _resultTableName;
+
+};
+
+}}} // namespace lsst::qserv:ccontrol
+
+#endif // LSST_QSERV_CCONTROL_USERQUERYSELECTSTATS_H
@@ -24,6 +24,7 @@
 #include "ccontrol/UserQueryType.h"
 
 // System headers
+#include <stdexcept>
 
 // Third-party headers
 #include "boost/regex.hpp"
@@ -73,10 +74,16 @@ boost::regex _showProcessListRe(R"(^show\s+(full\s+)?processlist$)",
 boost::regex _submitRe(R"(^submit\s+(.+)$)",
                        boost::regex::ECMAScript | boost::regex::icase | boost::regex::optimize);
 
-// regex for SELECT * FROM QSERV_RESULT(12345)
-// group 1 is the query ID number
+// regex for SAMPLE 1.5 PERCENT ...
+// group 1 is the percentage, group 2 the query without the SAMPLE prefix
+// Note that parens around whole string are not part of the regex but raw string literal
+boost::regex _sampleRe(R"(^sample\s+(\d+(?:\.\d*)?|\.\d+)\s+percent\s+(.+)$)",
+                       boost::regex::ECMAScript | boost::regex::icase | boost::regex::optimize);
+
+// regex for SELECT * FROM QSERV_RESULT(12345) or SELECT * FROM QSERV_RESULT(12345, 1000, 500)
+// group 1 is the query ID number, groups 2 and 3 the last row ID seen and the page size
 // Note that parens around whole string are not part of the regex but raw string literal
-boost::regex _selectResultRe(R"(^select\s+\*\s+from\s+qserv_result\s*\(\s*(\d+)\s*\)$)",
+boost::regex _selectResultRe(R"(^select\s+\*\s+from\s+qserv_result\s*\(\s*(\d+)\s*(?:,\s*(\d+)\s*,\s*(\d+)\s*)?\)$)",
                              boost::regex::ECMAScript | boost::regex::icase | boost::regex::optimize);
 
 // regex for KILL [QUERY|CONNECTION] 12345
@@ -186,15 +193,44 @@ UserQueryType::isSubmit(std::string const& query, std::string& stripped) {
      return match;
 }
 
+/// Returns true if query is SAMPLE N PERCENT ...
+bool
+UserQueryType::isSample(std::string const& query, double& percent, std::string& stripped) {
+     LOGS(_log, LOG_LVL_DEBUG, "isSample: " << query);
+     boost::smatch sm;
+     bool match = boost::regex_match(query, sm, _sampleRe);
+     if (match) {
+         percent = std::stod(sm.str(1));
+         stripped = sm.str(2);
+         LOGS(_log, LOG_LVL_DEBUG, "isSample: match: " << percent << "% " << stripped);
+     }
+     return match;
+}
+
 /// Returns true if query is SELECT * FROM QSERV_RESULT(...)
 bool
 UserQueryType::isSelectResult(std::string const& query, QueryId& queryId) {
+     uint64_t afterRowId, pageRows;
+     return isSelectResult(query, queryId, afterRowId, pageRows);
+}
+
+/// Returns true if query is SELECT * FROM QSERV_RESULT(...), with or without paging
+bool
+UserQueryType::isSelectResult(std::string const& query, QueryId& queryId,
+                              uint64_t& afterRowId, uint64_t& pageRows) {
      LOGS(_log, LOG_LVL_DEBUG, "isSelectResult: " << query);
      boost::smatch sm;
      bool match = boost::regex_match(query, sm, _selectResultRe);
      if (match) {
-         queryId = std::stoull(sm.str(1));
-         LOGS(_log, LOG_LVL_DEBUG, "isSelectResult: queryId: " << queryId);
+         try {
+             queryId = std::stoull(sm.str(1));
+             afterRowId = sm[2].matched ? std::stoull(sm.str(2)) : 0;
+             pageRows = sm[3].matched ? std::stoull(sm.str(3)) : 0;
+         } catch (std::out_of_range const&) {
+             return false;
+         }
+         LOGS(_log, LOG_LVL_DEBUG, "isSelectResult: queryId: " << queryId
+              << " afterRowId: " << afterRowId << " pageRows: " << pageRows);
      }
      return match;
 }
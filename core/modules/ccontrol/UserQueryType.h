@@ -79,12 +79,27 @@ public:
      */
     static bool isSubmit(std::string const& query, std::string& stripped);
 
+    /**
+     *  Returns true if query is SAMPLE N PERCENT ..., returns N in `percent`
+     *  and the query without the SAMPLE prefix in `stripped` string.
+     */
+    static bool isSample(std::string const& query, double& percent, std::string& stripped);
+
     /**
      *  Returns true if query is SELECT * FROM QSERV_RESULT(...), returns
      *  query ID in `queryId` argument.
      */
     static bool isSelectResult(std::string const& query, QueryId& queryId);
 
+    /**
+     *  Returns true if query is SELECT * FROM QSERV_RESULT(...), returns
+     *  query ID in `queryId` argument. For SELECT * FROM QSERV_RESULT(QID, ROWID, N),
+     *  which asks for the N rows following row ROWID, returns ROWID in `afterRowId`
+     *  and N in `pageRows`, otherwise sets both to 0.
+     */
+    static bool isSelectResult(std::string const& query, QueryId& queryId,
+                               uint64_t& afterRowId, uint64_t& pageRows);
+
     /**
      *  Returns true if query is KILL [QUERY|CONNECTION] NNN, returns
      *  thread ID in `threadId` argument.
@@ -0,0 +1,417 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/// qserv-merge-bench.cc measures the rate results are merged at on the czar.
+/// Result messages are made with proto::FakeProtocolFixture, then parsed,
+/// escaped for LOAD DATA INFILE and, with MERGE, sent through MergingHandler
+/// into an InfileMerger on a local MySQL.
+
+// System header
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+// Third-party headers
+#include <mysql/mysql.h>
+
+// Qserv headers
+#include "ccontrol/MergingHandler.h"
+#include "global/MsgReceiver.h"
+#include "global/ResourceUnit.h"
+#include "mysql/MySqlConfig.h"
+#include "proto/FakeProtocolFixture.h"
+#include "proto/ProtoHeaderWrap.h"
+#include "proto/ProtoImporter.h"
+#include "proto/WorkerResponse.h"
+#include "proto/worker.pb.h"
+#include "qdisp/Executive.h"
+#include "qdisp/JobDescription.h"
+#include "qdisp/JobQuery.h"
+#include "qdisp/JobStatus.h"
+#include "qdisp/MessageStore.h"
+#include "qdisp/QdispPool.h"
+#include "rproc/InfileMerger.h"
+#include "rproc/ProtoRowBuffer.h"
+#include "sql/SqlConnection.h"
+#include "sql/SqlErrorObject.h"
+#include "util/CmdLineParser.h"
+#include "util/StringHash.h"
+#include "util/Timer.h"
+
+namespace global   = lsst::qserv;
+namespace ccontrol = lsst::qserv::ccontrol;
+namespace mysql    = lsst::qserv::mysql;
+namespace proto    = lsst::qserv::proto;
+namespace qdisp    = lsst::qserv::qdisp;
+namespace rproc    = lsst::qserv::rproc;
+namespace sql      = lsst::qserv::sql;
+namespace util     = lsst::qserv::util;
+
+using FakeColumn = proto::FakeProtocolFixture::FakeColumn;
+
+namespace {
+
+// Command line parameters
+
+std::string  operation;
+unsigned int numJobs;
+unsigned int rowsPerJob;
+unsigned int rowsPerMsg;
+std::string  columnsSpec;
+double       nullRatio;
+double       escapeRatio;
+bool         rowBundles;
+bool         md5;
+unsigned int mergeShards;
+std::string  user;
+std::string  password;
+std::string  socketFile;
+std::string  db;
+std::string  jsonFileName;
+
+
+/// Rate of one stage over all the messages.
+struct Stage {
+    std::string name;
+    double seconds;
+    uint64_t bytes;  ///< Bytes of the serialized Result messages.
+    uint64_t rows;
+    double mbPerSec() const { return seconds > 0 ? bytes / seconds / 1e6 : 0; }
+    double rowsPerSec() const { return seconds > 0 ? rows / seconds : 0; }
+};
+
+
+/// @return the columns described by 'spec', a comma separated list of
+///         INT, BIGINT, FLOAT, DOUBLE, CHAR:<width>, VARCHAR:<width> or TEXT:<width>.
+std::vector<FakeColumn> parseColumns(std::string const& spec) {
+    std::vector<FakeColumn> columns;
+    std::istringstream is(spec);
+    std::string item;
+    while (std::getline(is, item, ',')) {
+        auto const colon = item.find(':');
+        std::string const type = item.substr(0, colon);
+        unsigned const width = (colon == std::string::npos) ? 0 : std::stoul(item.substr(colon + 1));
+        if (type == "INT") {
+            columns.push_back({FakeColumn::INTEGER, "INT", MYSQL_TYPE_LONG, 0, ::nullRatio});
+        } else if (type == "BIGINT") {
+            columns.push_back({FakeColumn::INTEGER, "BIGINT", MYSQL_TYPE_LONGLONG, 0, ::nullRatio});
+        } else if (type == "FLOAT") {
+            columns.push_back({FakeColumn::REAL, "FLOAT", MYSQL_TYPE_FLOAT, 0, ::nullRatio});
+        } else if (type == "DOUBLE") {
+            columns.push_back({FakeColumn::REAL, "DOUBLE", MYSQL_TYPE_DOUBLE, 0, ::nullRatio});
+        } else if ((type == "CHAR" || type == "VARCHAR" || type == "TEXT") && width > 0) {
+            std::string const sqlType = (type == "TEXT") ? type : type + "(" + std::to_string(width) + ")";
+            int const mysqlType = (type == "CHAR") ? MYSQL_TYPE_STRING
+                                : (type == "VARCHAR") ? MYSQL_TYPE_VAR_STRING : MYSQL_TYPE_BLOB;
+            columns.push_back({FakeColumn::STRING, sqlType, mysqlType, width, ::nullRatio});
+        } else {
+            throw std::invalid_argument("unsupported column: " + item);
+        }
+    }
+    if (columns.empty()) throw std::invalid_argument("no columns");
+    return columns;
+}
+
+
+/// The serialized Result messages of one job, and the bytes the worker
+/// would send for them: each message preceded by its wrapped ProtoHeader.
+struct Job {
+    std::vector<std::string> msgs;
+    std::string stream;
+};
+
+
+Job makeJob(proto::FakeProtocolFixture& fixture, std::vector<FakeColumn> const& columns, int jobId) {
+    Job job;
+    for (unsigned done = 0; done < ::rowsPerJob; done += ::rowsPerMsg) {
+        unsigned const rows = std::min(::rowsPerMsg, ::rowsPerJob - done);
+        std::unique_ptr<proto::Result> result(
+            fixture.makeResult(columns, rows, not ::rowBundles, ::escapeRatio));
+        result->set_jobid(jobId);
+        result->set_continues(done + rows < ::rowsPerJob);
+        std::string msg;
+        result->SerializeToString(&msg);
+
+        proto::ProtoHeader header;
+        header.set_protocol(::rowBundles ? 2 : 3);
+        header.set_size(msg.size());
+        header.set_wname("qserv-merge-bench");
+        header.set_largeresult(false);
+        if (::md5) {
+            header.set_checksum(proto::ProtoHeader::MD5);
+            header.set_md5(util::StringHash::getMd5(msg.data(), msg.size()));
+        } else {
+            header.set_checksum(proto::ProtoHeader::CRC32C);
+            header.set_crc32c(util::StringHash::getCrc32c(msg.data(), msg.size()));
+        }
+        std::string headerString;
+        header.SerializeToString(&headerString);
+        job.stream += proto::ProtoHeaderWrap::wrap(headerString);
+        job.stream += msg;
+        job.msgs.push_back(std::move(msg));
+    }
+    return job;
+}
+
+
+class ErrorReceiver : public global::MsgReceiver {
+public:
+    void operator()(int code, std::string const& msg) override {
+        std::cerr << "error: code=" << code << " " << msg << std::endl;
+    }
+};
+
+
+/// Send the jobs through MergingHandler into an InfileMerger, the way
+/// QueryRequest does with the buffers it reads from the workers.
+/// @return false if a message could not be merged.
+bool merge(std::vector<Job> const& jobs, double& seconds) {
+    rproc::InfileMergerConfig mergerConfig(mysql::MySqlConfig(::user, ::password, ::socketFile, ::db));
+    mergerConfig.targetTable = ::db + ".merge_bench_" + std::to_string(::getpid());
+    mergerConfig.mergeShards = ::mergeShards;
+    auto merger = std::make_shared<rproc::InfileMerger>(mergerConfig);
+
+    qdisp::Executive::Config exConfig(qdisp::Executive::Config::getMockStr(), 0);
+    auto executive = qdisp::Executive::create(exConfig, std::make_shared<qdisp::MessageStore>(),
+                                              std::make_shared<qdisp::QdispPool>(true), nullptr);
+    auto receiver = std::make_shared<ErrorReceiver>();
+
+    bool ok = true;
+    util::Timer timer;
+    timer.start();
+    for (size_t jobId = 0; jobId < jobs.size() && ok; ++jobId) {
+        auto handler = std::make_shared<ccontrol::MergingHandler>(receiver, merger, "bench");
+        global::ResourceUnit ru;
+        ru.setAsDbChunk("Bench", jobId);
+        auto jobDesc = qdisp::JobDescription::create(executive->getId(), jobId, ru, handler,
+                                                     nullptr, nullptr, "bench", true);
+        auto jobQuery = qdisp::JobQuery::create(executive, jobDesc, std::make_shared<qdisp::JobStatus>(),
+                                                nullptr, executive->getId());
+        std::string const& stream = jobs[jobId].stream;
+        size_t pos = 0;
+        bool last = false;
+        while (not last) {
+            size_t const size = handler->nextBufferSize();
+            auto& buffer = handler->nextBuffer();
+            size_t const n = std::min(size, stream.size() - pos);
+            if (n == 0) {
+                std::cerr << "error: job " << jobId << " stream ended before the last message" << std::endl;
+                ok = false;
+                break;
+            }
+            std::copy(stream.data() + pos, stream.data() + pos + n, buffer.begin());
+            pos += n;
+            bool largeResult = false;
+            if (not handler->flush(size, last, largeResult)) {
+                std::cerr << "error: job " << jobId << " " << handler->getError().getMsg() << std::endl;
+                ok = false;
+                break;
+            }
+        }
+    }
+    if (ok and not merger->finalize()) {
+        std::cerr << "error: finalize " << merger->getError().getMsg() << std::endl;
+        ok = false;
+    }
+    timer.stop();
+    seconds = timer.getElapsed();
+
+    sql::SqlConnection conn(mergerConfig.mySqlConfig);
+    sql::SqlErrorObject errObj;
+    if (not conn.dropTable(merger->getTargetTable(), errObj, false)) {
+        std::cerr << "error: failed to drop " << merger->getTargetTable() << ": "
+                  << errObj.errMsg() << std::endl;
+    }
+    return ok;
+}
+
+
+void writeReport(std::vector<Stage> const& stages) {
+    std::cout << std::left << std::setw(8) << "stage" << std::right << std::setw(12) << "seconds"
+              << std::setw(12) << "MB/s" << std::setw(14) << "rows/s" << std::endl;
+    for (auto const& stage : stages) {
+        std::cout << std::left << std::setw(8) << stage.name << std::right << std::fixed
+                  << std::setprecision(3) << std::setw(12) << stage.seconds
+                  << std::setprecision(1) << std::setw(12) << stage.mbPerSec()
+                  << std::setprecision(0) << std::setw(14) << stage.rowsPerSec() << std::endl;
+    }
+    if (::jsonFileName.empty()) return;
+    std::ofstream file(::jsonFileName);
+    file << "{\"jobs\":" << ::numJobs << ",\"rows_per_job\":" << ::rowsPerJob
+         << ",\"rows_per_msg\":" << ::rowsPerMsg << ",\"columns\":\"" << ::columnsSpec << "\""
+         << ",\"null_ratio\":" << ::nullRatio << ",\"escape_ratio\":" << ::escapeRatio
+         << ",\"protocol\":" << (::rowBundles ? 2 : 3) << ",\"stages\":[";
+    for (size_t i = 0; i < stages.size(); ++i) {
+        auto const& stage = stages[i];
+        file << (i ? "," : "") << "{\"name\":\"" << stage.name << "\",\"seconds\":" << stage.seconds
+             << ",\"bytes\":" << stage.bytes << ",\"rows\":" << stage.rows
+             << ",\"mb_per_sec\":" << stage.mbPerSec() << ",\"rows_per_sec\":" << stage.rowsPerSec() << "}";
+    }
+    file << "]}" << std::endl;
+}
+
+
+int run() {
+    std::vector<FakeColumn> columns;
+    try {
+        columns = parseColumns(::columnsSpec);
+    } catch (std::exception const& ex) {
+        std::cerr << "error: --columns=" << ::columnsSpec << " " << ex.what() << std::endl;
+        return 1;
+    }
+    proto::FakeProtocolFixture fixture;
+    std::vector<Job> jobs;
+    uint64_t bytes = 0;
+    for (unsigned jobId = 0; jobId < ::numJobs; ++jobId) {
+        jobs.push_back(makeJob(fixture, columns, jobId));
+        for (auto const& msg : jobs.back().msgs) bytes += msg.size();
+    }
+    uint64_t const rows = static_cast<uint64_t>(::numJobs) * ::rowsPerJob;
+    std::cerr << "merging " << rows << " rows in " << bytes << " bytes of messages" << std::endl;
+
+    // parse: decode the messages as MergingHandler does, onto an arena.
+    std::vector<std::shared_ptr<proto::WorkerResponse>> responses;
+    util::Timer timer;
+    timer.start();
+    for (auto const& job : jobs) {
+        for (auto const& msg : job.msgs) {
+            auto response = std::make_shared<proto::WorkerResponse>();
+            if (not proto::ProtoImporter<proto::Result>::setMsgFrom(response->result, msg.data(), msg.size())) {
+                std::cerr << "error: failed to parse a message" << std::endl;
+                return 1;
+            }
+            responses.push_back(response);
+        }
+    }
+    timer.stop();
+    std::vector<Stage> stages;
+    stages.push_back({"parse", timer.getElapsed(), bytes, rows});
+
+    // escape: the rows as LOAD DATA INFILE reads them from the merger.
+    std::vector<char> buffer(1024 * 1024);
+    timer.start();
+    for (auto const& response : responses) {
+        rproc::ProtoRowBuffer rowBuffer(response->result, response->result.jobid(), "jobId", "INT(9)",
+                                        MYSQL_TYPE_LONG);
+        while (rowBuffer.fetch(buffer.data(), buffer.size()) > 0) {}
+    }
+    timer.stop();
+    stages.push_back({"escape", timer.getElapsed(), bytes, rows});
+    responses.clear();
+
+    // merge: the whole path into MySQL, 'load' is what parse and escape leave of it.
+    if (::operation == "MERGE") {
+        double seconds = 0;
+        if (not merge(jobs, seconds)) return 1;
+        stages.push_back({"merge", seconds, bytes, rows});
+        double const load = std::max(0.0, seconds - stages[0].seconds - stages[1].seconds);
+        stages.push_back({"load", load, bytes, rows});
+    }
+    writeReport(stages);
+    return 0;
+}
+} // namespace
+
+int main(int argc, const char* const argv[]) {
+
+    // Verify that the version of the library that we linked against is
+    // compatible with the version of the headers we compiled against.
+
+    GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+    // Parse command line parameters
+    try {
+        util::CmdLineParser parser(
+            argc,
+            argv,
+            "\n"
+            "Usage:\n"
+            "  PARSE\n"
+            "  MERGE\n"
+            "  [--jobs=<value>]\n"
+            "  [--rows=<value>]\n"
+            "  [--rows-per-msg=<value>]\n"
+            "  [--columns=<spec>]\n"
+            "  [--null-ratio=<value>]\n"
+            "  [--escape-ratio=<value>]\n"
+            "  [--row-bundles]\n"
+            "  [--md5]\n"
+            "  [--merge-shards=<value>]\n"
+            "  [--user=<name>]\n"
+            "  [--password=<value>]\n"
+            "  [--socket=<file>]\n"
+            "  [--db=<name>]\n"
+            "  [--json=<file>]\n"
+            "\n"
+            "Flags an options:\n"
+            "  --jobs=<value>         - jobs (chunks) sending results (default: 10)\n"
+            "  --rows=<value>         - rows sent by each job (default: 100000)\n"
+            "  --rows-per-msg=<value> - rows in each Result message (default: 20000)\n"
+            "  --columns=<spec>       - comma separated columns, each INT, BIGINT, FLOAT, DOUBLE,\n"
+            "                           CHAR:<width>, VARCHAR:<width> or TEXT:<width>\n"
+            "                           (default: BIGINT,INT,DOUBLE,DOUBLE,VARCHAR:32)\n"
+            "  --null-ratio=<value>   - fraction of the values that are NULL (default: 0.05)\n"
+            "  --escape-ratio=<value> - fraction of the string values that must be escaped (default: 0.01)\n"
+            "  --row-bundles          - send rows as RowBundles (protocol 2) instead of column blocks\n"
+            "  --md5                  - check the messages with MD5 instead of CRC32C\n"
+            "  --merge-shards=<value> - MERGE: tables rows are loaded into (default: 1)\n"
+            "  --user=<name>          - MERGE: MySQL user (default: qsmaster)\n"
+            "  --password=<value>     - MERGE: MySQL password (default: none)\n"
+            "  --socket=<file>        - MERGE: MySQL socket (default: /qserv/data/mysql/mysql.sock)\n"
+            "  --db=<name>            - MERGE: database of the result table (default: qservResult)\n"
+            "  --json=<file>          - also write the rates to the file as JSON\n"
+            "\n"
+            "Operations:\n"
+            "  PARSE  - measure parsing and escaping the messages\n"
+            "  MERGE  - also merge them into MySQL with LOAD DATA INFILE\n");
+
+        ::operation = parser.parameterRestrictedBy(1, {"PARSE", "MERGE"});
+
+        ::numJobs     = parser.option<unsigned int>("jobs", 10);
+        ::rowsPerJob  = parser.option<unsigned int>("rows", 100000);
+        ::rowsPerMsg  = std::max(1U, parser.option<unsigned int>("rows-per-msg", 20000));
+        ::columnsSpec = parser.option<std::string>("columns", "BIGINT,INT,DOUBLE,DOUBLE,VARCHAR:32");
+        ::nullRatio   = std::stod(parser.option<std::string>("null-ratio", "0.05"));
+        ::escapeRatio = std::stod(parser.option<std::string>("escape-ratio", "0.01"));
+        ::rowBundles  = parser.flag("row-bundles");
+        ::md5         = parser.flag("md5");
+        ::mergeShards = parser.option<unsigned int>("merge-shards", 1);
+        ::user        = parser.option<std::string>("user", "qsmaster");
+        ::password    = parser.option<std::string>("password", "");
+        ::socketFile  = parser.option<std::string>("socket", "/qserv/data/mysql/mysql.sock");
+        ::db          = parser.option<std::string>("db", "qservResult");
+
+        ::jsonFileName = parser.option<std::string>("json", "");
+
+    } catch (std::exception const& ex) {
+        return 1;
+    }
+    return ::run();
+}
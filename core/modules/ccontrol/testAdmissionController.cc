@@ -0,0 +1,198 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+// Class header
+#include "ccontrol/AdmissionController.h"
+
+// System headers
+#include <atomic>
+#include <thread>
+
+// Boost unit test header
+#define BOOST_TEST_MODULE AdmissionController
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::ccontrol::AdmissionController;
+using lsst::qserv::qproc::QueryCost;
+using std::chrono::milliseconds;
+
+namespace {
+
+QueryCost makeCost(int chunks, double cost) {
+    QueryCost qc;
+    qc.chunkCount = chunks;
+    qc.cost = cost;
+    return qc;
+}
+
+} // annonymous namespace
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(ClassLimit) {
+    AdmissionController::Config config;
+    config.maxRunning[AdmissionController::SCAN] = 1;
+    config.maxWait = milliseconds(5000);
+    config.recheck = milliseconds(10);
+    auto controller = AdmissionController::create(config, nullptr);
+    std::string reason;
+    auto first = controller->admit(1, AdmissionController::SCAN, makeCost(10, 10), reason);
+    BOOST_REQUIRE(first != nullptr);
+    // Other classes are not held up.
+    BOOST_CHECK(controller->admit(2, AdmissionController::INTERACTIVE, makeCost(1, 1), reason) != nullptr);
+
+    std::atomic<bool> started(false);
+    std::thread waiter([&]() {
+        std::string why;
+        auto ticket = controller->admit(3, AdmissionController::SCAN, makeCost(10, 10), why);
+        started = ticket != nullptr;
+    });
+    while (controller->getStats(AdmissionController::SCAN).queued == 0) {
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+    BOOST_CHECK(!started);
+    first.reset();
+    waiter.join();
+    BOOST_CHECK(started);
+    auto const stats = controller->getStats(AdmissionController::SCAN);
+    BOOST_CHECK_EQUAL(stats.admitted, 2U);
+    BOOST_CHECK_EQUAL(stats.running, 0);
+    BOOST_CHECK_EQUAL(stats.queued, 0);
+}
+
+BOOST_AUTO_TEST_CASE(Rejections) {
+    AdmissionController::Config config;
+    config.maxRunning[AdmissionController::ASYNC] = 1;
+    config.maxQueued = 1;
+    config.maxWait = milliseconds(50);
+    config.recheck = milliseconds(10);
+    auto controller = AdmissionController::create(config, nullptr);
+    std::string reason;
+    auto ticket = controller->admit(1, AdmissionController::ASYNC, makeCost(10, 10), reason);
+    BOOST_REQUIRE(ticket != nullptr);
+    // Times out in the queue.
+    BOOST_CHECK(controller->admit(2, AdmissionController::ASYNC, makeCost(10, 10), reason) == nullptr);
+    BOOST_CHECK(reason.find("after waiting") != std::string::npos);
+
+    // Finds the queue full.
+    std::thread waiter([&]() {
+        std::string why;
+        controller->admit(3, AdmissionController::ASYNC, makeCost(10, 10), why);
+    });
+    while (controller->getStats(AdmissionController::ASYNC).queued == 0) {
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+    BOOST_CHECK(controller->admit(4, AdmissionController::ASYNC, makeCost(10, 10), reason) == nullptr);
+    BOOST_CHECK(reason.find("already waiting") != std::string::npos);
+    waiter.join();
+    BOOST_CHECK_EQUAL(controller->getStats(AdmissionController::ASYNC).rejected, 3U);
+}
+
+BOOST_AUTO_TEST_CASE(Cancel) {
+    AdmissionController::Config config;
+    config.maxRunning[AdmissionController::SCAN] = 1;
+    config.maxWait = milliseconds(10000);
+    auto controller = AdmissionController::create(config, nullptr);
+    std::string reason;
+    auto ticket = controller->admit(1, AdmissionController::SCAN, makeCost(10, 10), reason);
+    std::string why;
+    std::thread waiter([&]() {
+        BOOST_CHECK(controller->admit(2, AdmissionController::SCAN, makeCost(10, 10), why) == nullptr);
+    });
+    while (controller->getStats(AdmissionController::SCAN).queued == 0) {
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+    controller->cancel(2);
+    waiter.join();
+    BOOST_CHECK(why.find("cancelled") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(Budgets) {
+    AdmissionController::Config config;
+    config.maxRunningJobs = 100;
+    config.maxWait = milliseconds(30);
+    config.recheck = milliseconds(5);
+    std::string shortOf;
+    auto controller = AdmissionController::create(config, [&shortOf]() { return shortOf; });
+    std::string reason;
+    // Alone, a query starts whatever its size or the pressure.
+    shortOf = "no memory";
+    auto big = controller->admit(1, AdmissionController::SCAN, makeCost(500, 500), reason);
+    BOOST_REQUIRE(big != nullptr);
+    shortOf.clear();
+    BOOST_CHECK(controller->admit(2, AdmissionController::ASYNC, makeCost(10, 10), reason) == nullptr);
+    BOOST_CHECK(reason.find("chunk jobs") != std::string::npos);
+    big.reset();
+    auto small = controller->admit(3, AdmissionController::SCAN, makeCost(50, 50), reason);
+    BOOST_REQUIRE(small != nullptr);
+    BOOST_CHECK(controller->admit(4, AdmissionController::SCAN, makeCost(50, 50), reason) != nullptr);
+    shortOf = "no memory";
+    BOOST_CHECK(controller->admit(5, AdmissionController::SCAN, makeCost(0, 0), reason) == nullptr);
+    BOOST_CHECK(reason.find("no memory") != std::string::npos);
+    // Interactive queries only have their own limit.
+    BOOST_CHECK(controller->admit(6, AdmissionController::INTERACTIVE, makeCost(1, 1), reason) != nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(SharedBudget) {
+    AdmissionController::Config config;
+    config.maxWait = milliseconds(5000);
+    config.recheck = milliseconds(10);
+    auto controller = AdmissionController::create(config, nullptr);
+    std::string reason;
+    auto first = controller->admit(1, AdmissionController::SCAN, makeCost(60, 60), reason);
+    BOOST_REQUIRE(first != nullptr);
+    controller->setMaxRunningJobs(100);
+    BOOST_CHECK_EQUAL(controller->getMaxRunningJobs(), 100);
+
+    std::atomic<bool> started(false);
+    std::thread waiter([&]() {
+        std::string why;
+        auto ticket = controller->admit(2, AdmissionController::SCAN, makeCost(50, 50), why);
+        started = ticket != nullptr;
+    });
+    while (controller->getLoad().queued == 0) {
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+    auto const load = controller->getLoad();
+    BOOST_CHECK_EQUAL(load.running, 1);
+    BOOST_CHECK_EQUAL(load.runningJobs, 60);
+    BOOST_CHECK_EQUAL(load.queuedJobs, 50);
+    BOOST_CHECK(!started);
+    // A larger share lets the waiting query start.
+    controller->setMaxRunningJobs(110);
+    waiter.join();
+    BOOST_CHECK(started);
+    BOOST_CHECK_EQUAL(controller->getLoad().queuedJobs, 0);
+
+    AdmissionController::Config rejectAll;
+    rejectAll.maxQueued = 0;
+    auto rejecting = AdmissionController::create(rejectAll, nullptr);
+    rejecting->setRejectionHint("Czar czar-2 is less loaded.");
+    BOOST_CHECK(rejecting->admit(3, AdmissionController::SCAN, makeCost(1, 1), reason) == nullptr);
+    BOOST_CHECK(reason.find("czar-2") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
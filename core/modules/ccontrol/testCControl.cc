@@ -1079,6 +1079,19 @@ BOOST_AUTO_TEST_CASE(testUserQueryType) {
     BOOST_CHECK(not UserQueryType::isSubmit("unsubmit select", stripped));
     BOOST_CHECK(not UserQueryType::isSubmit("submitting select", stripped));
 
+    double percent = 0;
+    BOOST_CHECK(UserQueryType::isSample("SAMPLE 1 PERCENT SELECT 1", percent, stripped));
+    BOOST_CHECK_EQUAL(percent, 1.);
+    BOOST_CHECK_EQUAL("SELECT 1", stripped);
+    BOOST_CHECK(UserQueryType::isSample("sample\t.5 percent\nselect", percent, stripped));
+    BOOST_CHECK_EQUAL(percent, 0.5);
+    BOOST_CHECK_EQUAL("select", stripped);
+    BOOST_CHECK(UserQueryType::isSample("Sample 12.5 Percent SELECT", percent, stripped));
+    BOOST_CHECK_EQUAL(percent, 12.5);
+    BOOST_CHECK(not UserQueryType::isSample("SAMPLE PERCENT SELECT", percent, stripped));
+    BOOST_CHECK(not UserQueryType::isSample("SAMPLE -1 PERCENT SELECT", percent, stripped));
+    BOOST_CHECK(not UserQueryType::isSample("SAMPLE 1 SELECT", percent, stripped));
+
     struct {
         const char* query;
         const char* db;
@@ -1241,6 +1254,38 @@ BOOST_AUTO_TEST_CASE(testUserQueryType) {
         BOOST_CHECK(not UserQueryType::isProcessListTable(test.db, test.table));
     }
 
+    struct {
+        const char* query;
+        lsst::qserv::QueryId id;
+        uint64_t afterRowId;
+        uint64_t pageRows;
+    } select_result_ok[] = {
+        {"SELECT * FROM QSERV_RESULT(100)", 100, 0, 0},
+        {"select * from qserv_result ( 101 )", 101, 0, 0},
+        {"SELECT * FROM QSERV_RESULT(102, 0, 1000)", 102, 0, 1000},
+        {"SELECT\t*\tFROM QSERV_RESULT( 103 ,5000,  1000 )", 103, 5000, 1000},
+    };
+    for (auto test: select_result_ok) {
+        lsst::qserv::QueryId queryId;
+        uint64_t afterRowId, pageRows;
+        BOOST_CHECK(UserQueryType::isSelectResult(test.query, queryId, afterRowId, pageRows));
+        BOOST_CHECK_EQUAL(queryId, test.id);
+        BOOST_CHECK_EQUAL(afterRowId, test.afterRowId);
+        BOOST_CHECK_EQUAL(pageRows, test.pageRows);
+        BOOST_CHECK(not UserQueryType::isSelect(test.query));
+    }
+
+    const char* select_result_fail[] = {
+        "SELECT * FROM QSERV_RESULT()",
+        "SELECT * FROM QSERV_RESULT(100, 5)",
+        "SELECT * FROM QSERV_RESULT(100, 5, 10, 20)",
+        "SELECT a FROM QSERV_RESULT(100)",
+    };
+    for (auto test: select_result_fail) {
+        lsst::qserv::QueryId queryId;
+        BOOST_CHECK(not UserQueryType::isSelectResult(test, queryId));
+    }
+
     struct {
         const char* query;
         int id;
@@ -0,0 +1,85 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "ccontrol/CzarLoadShare.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE CzarLoadShare
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::ccontrol::CzarLoadShare;
+using lsst::qserv::qmeta::QCzarLoad;
+
+namespace {
+
+QCzarLoad makeLoad(unsigned czarId, uint32_t running, uint32_t queued, uint64_t jobs, uint64_t queuedJobs) {
+    QCzarLoad load;
+    load.czarId = czarId;
+    load.czarName = "czar-" + std::to_string(czarId);
+    load.runningQueries = running;
+    load.queuedQueries = queued;
+    load.runningJobs = jobs;
+    load.queuedJobs = queuedJobs;
+    return load;
+}
+
+} // annonymous namespace
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(JobShare) {
+    // Alone, a czar gets the whole budget.
+    BOOST_CHECK_EQUAL(CzarLoadShare::jobShare(1000, 1, {makeLoad(1, 0, 0, 0, 0)}), 1000);
+    BOOST_CHECK_EQUAL(CzarLoadShare::jobShare(1000, 1, {}), 1000);
+
+    // Below the budget, what nobody asks for is split evenly.
+    std::vector<QCzarLoad> light = {makeLoad(1, 1, 0, 100, 0), makeLoad(2, 1, 0, 300, 0)};
+    BOOST_CHECK_EQUAL(CzarLoadShare::jobShare(1000, 1, light), 400);
+    BOOST_CHECK_EQUAL(CzarLoadShare::jobShare(1000, 2, light), 600);
+
+    // Above the budget, small demands are met and large ones split the rest.
+    std::vector<QCzarLoad> heavy = {makeLoad(1, 1, 0, 100, 0), makeLoad(2, 5, 2, 800, 400),
+                                    makeLoad(3, 5, 5, 500, 2000)};
+    BOOST_CHECK_EQUAL(CzarLoadShare::jobShare(1000, 1, heavy), 100);
+    BOOST_CHECK_EQUAL(CzarLoadShare::jobShare(1000, 2, heavy), 450);
+    BOOST_CHECK_EQUAL(CzarLoadShare::jobShare(1000, 3, heavy), 450);
+
+    // A czar asking for nothing still gets a budget.
+    std::vector<QCzarLoad> idle = {makeLoad(1, 0, 0, 0, 0), makeLoad(2, 5, 5, 800, 4000)};
+    BOOST_CHECK_EQUAL(CzarLoadShare::jobShare(100, 1, idle), 1);
+}
+
+BOOST_AUTO_TEST_CASE(LessLoaded) {
+    std::vector<QCzarLoad> loads = {makeLoad(1, 4, 3, 0, 0), makeLoad(2, 9, 0, 0, 0),
+                                    makeLoad(3, 2, 0, 0, 0)};
+    BOOST_CHECK_EQUAL(CzarLoadShare::lessLoaded(1, loads), "czar-3");
+    BOOST_CHECK_EQUAL(CzarLoadShare::lessLoaded(2, loads), "czar-3");
+    BOOST_CHECK_EQUAL(CzarLoadShare::lessLoaded(3, loads), "");
+    // Unknown czars get no advice.
+    BOOST_CHECK_EQUAL(CzarLoadShare::lessLoaded(4, loads), "");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,116 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+// Class header
+#include "ccontrol/MergeBufferPool.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE MergeBufferPool
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::ccontrol::MergeBufferPool;
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(Reuse) {
+    MergeBufferPool pool(100 * 1024 * 1024);
+    auto buf = pool.borrow(5000);
+    BOOST_CHECK_EQUAL(buf->size(), 5000u);
+    BOOST_CHECK(buf->capacity() >= 8192u);
+    char const* data = buf->data();
+    uint64_t const inUse = pool.getInUseBytes();
+    BOOST_CHECK(inUse >= 8192u);
+    pool.giveBack(std::move(buf));
+    BOOST_CHECK_EQUAL(pool.getInUseBytes(), 0u);
+    BOOST_CHECK_EQUAL(pool.getIdleBytes(), inUse);
+
+    // Anything in the same size class reuses the buffer.
+    auto buf2 = pool.borrow(8000);
+    BOOST_CHECK_EQUAL(buf2->size(), 8000u);
+    BOOST_CHECK(buf2->data() == data);
+    BOOST_CHECK_EQUAL(pool.getReuseCount(), 1u);
+    BOOST_CHECK_EQUAL(pool.getBorrowCount(), 2u);
+    BOOST_CHECK_EQUAL(pool.getIdleBytes(), 0u);
+
+    // A larger class needs a new buffer.
+    auto buf3 = pool.borrow(20000);
+    BOOST_CHECK_EQUAL(pool.getReuseCount(), 1u);
+    BOOST_CHECK(pool.getHighWaterInUseBytes() >= 8192u + 32768u);
+    pool.giveBack(std::move(buf2));
+    pool.giveBack(std::move(buf3));
+    BOOST_CHECK_EQUAL(pool.getInUseBytes(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(Cap) {
+    MergeBufferPool pool(64 * 1024);
+    auto a = pool.borrow(40000);
+    auto b = pool.borrow(40000);
+    // Over the cap, returned buffers are freed.
+    pool.giveBack(std::move(a));
+    BOOST_CHECK_EQUAL(pool.getIdleBytes(), 0u);
+    pool.giveBack(std::move(b));
+    BOOST_CHECK_EQUAL(pool.getIdleBytes(), 65536u);
+    BOOST_CHECK_EQUAL(pool.getHighWaterTotalBytes(), 2u * 65536u);
+    pool.setMaxBytes(0);
+    BOOST_CHECK_EQUAL(pool.getIdleBytes(), 0u);
+
+    // Buffers from elsewhere can be adopted and returned.
+    std::vector<char> other(10000, 'x');
+    auto c = pool.adopt(other);
+    BOOST_CHECK(other.empty());
+    BOOST_CHECK_EQUAL(c->size(), 10000u);
+    BOOST_CHECK_EQUAL(pool.getInUseBytes(), c->capacity());
+    pool.giveBack(std::move(c));
+    BOOST_CHECK_EQUAL(pool.getInUseBytes(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(MessageRange) {
+    uint64_t const MB = 1024 * 1024;
+    MergeBufferPool pool(16 * MB);
+    uint32_t minBytes = 0;
+    uint32_t maxBytes = 0;
+    pool.getMessageRange(minBytes, maxBytes);
+    BOOST_CHECK_EQUAL(minBytes, 1 * MB);
+    BOOST_CHECK_EQUAL(maxBytes, 8 * MB);
+
+    // The fuller the pool, the smaller the messages.
+    auto a = pool.borrow(8 * MB);
+    pool.getMessageRange(minBytes, maxBytes);
+    BOOST_CHECK_EQUAL(minBytes, 256 * 1024u);
+    BOOST_CHECK_EQUAL(maxBytes, 2 * MB);
+    auto b = pool.borrow(4 * MB);
+    pool.getMessageRange(minBytes, maxBytes);
+    BOOST_CHECK_EQUAL(minBytes, 64 * 1024u);
+    BOOST_CHECK_EQUAL(maxBytes, 512 * 1024u);
+    BOOST_CHECK(minBytes <= maxBytes);
+
+    pool.giveBack(std::move(a));
+    pool.giveBack(std::move(b));
+    pool.getMessageRange(minBytes, maxBytes);
+    BOOST_CHECK_EQUAL(maxBytes, 8 * MB);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,154 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+// Class header
+#include "ccontrol/ResultTableCache.h"
+
+// System headers
+#include <map>
+
+// Boost unit test header
+#define BOOST_TEST_MODULE ResultTableCache
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::ccontrol::ResultTableCache;
+using std::chrono::seconds;
+
+namespace {
+
+/// Result database holding tables of known sizes.
+struct FakeDb {
+    std::map<std::string, int64_t> tables;
+    std::vector<std::string> dropped;
+
+    ResultTableCache::DropTable dropTable() {
+        return [this](std::string const& table) { dropped.push_back(table); tables.erase(table); };
+    }
+    ResultTableCache::TableBytes tableBytes() {
+        return [this](std::string const& table) {
+            auto iter = tables.find(table);
+            return iter == tables.end() ? int64_t(-1) : iter->second;
+        };
+    }
+};
+
+ResultTableCache::Entry makeEntry(std::string const& table) {
+    ResultTableCache::Entry entry;
+    entry.table = table;
+    entry.orderBy = "ORDER BY a";
+    return entry;
+}
+
+} // annonymous namespace
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(Keys) {
+    auto key = ResultTableCache::makeKey("SELECT  a\n FROM  t WHERE b='x  y' ;", "db");
+    BOOST_CHECK_EQUAL(key, "db\nSELECT a FROM t WHERE b='x  y'");
+    BOOST_CHECK_EQUAL(key, ResultTableCache::makeKey("SELECT a FROM t WHERE b='x  y'", "db"));
+    BOOST_CHECK(key != ResultTableCache::makeKey("SELECT a FROM t WHERE b='x  y'", "db2"));
+    BOOST_CHECK(ResultTableCache::makeKey("SELECT NOW() FROM t", "db").empty());
+    BOOST_CHECK(ResultTableCache::makeKey("SELECT a FROM t ORDER BY rand ()", "db").empty());
+    BOOST_CHECK(ResultTableCache::makeKey("SELECT SQL_NO_CACHE a FROM t", "db").empty());
+    BOOST_CHECK(!ResultTableCache::makeKey("SELECT known(a) FROM t", "db").empty());
+}
+
+BOOST_AUTO_TEST_CASE(HitsAndExpiry) {
+    FakeDb db;
+    db.tables["qcache_1"] = 100;
+    ResultTableCache cache(1000, 1000, seconds(60), seconds(10), db.dropTable(), db.tableBytes());
+    auto const t0 = ResultTableCache::Clock::now();
+    ResultTableCache::Entry entry;
+    BOOST_CHECK(!cache.get("q", entry, t0));
+    BOOST_CHECK(cache.put("q", makeEntry("qcache_1"), cache.getGeneration(), t0));
+    BOOST_CHECK_EQUAL(cache.getBytes(), 100U);
+    BOOST_REQUIRE(cache.get("q", entry, t0 + seconds(30)));
+    BOOST_CHECK_EQUAL(entry.table, "qcache_1");
+    BOOST_CHECK_EQUAL(entry.orderBy, "ORDER BY a");
+    // Expired, the table is kept a little longer for its readers.
+    BOOST_CHECK(!cache.get("q", entry, t0 + seconds(60)));
+    BOOST_CHECK_EQUAL(cache.size(), 0U);
+    BOOST_CHECK(db.dropped.empty());
+    cache.retire("result_x", t0 + seconds(65));
+    BOOST_REQUIRE_EQUAL(db.dropped.size(), 0U);
+    cache.get("q", entry, t0 + seconds(70));
+    BOOST_REQUIRE_EQUAL(db.dropped.size(), 1U);
+    BOOST_CHECK_EQUAL(db.dropped[0], "qcache_1");
+    BOOST_CHECK_EQUAL(cache.getHitCount(), 1U);
+    BOOST_CHECK_EQUAL(cache.getMissCount(), 3U);
+}
+
+BOOST_AUTO_TEST_CASE(SizeLimits) {
+    FakeDb db;
+    db.tables["qcache_1"] = 400;
+    db.tables["qcache_2"] = 400;
+    db.tables["qcache_3"] = 400;
+    db.tables["qcache_4"] = 700;
+    ResultTableCache cache(1000, 600, seconds(60), seconds(0), db.dropTable(), db.tableBytes());
+    auto const t0 = ResultTableCache::Clock::now();
+    ResultTableCache::Entry entry;
+    BOOST_CHECK(cache.put("a", makeEntry("qcache_1"), 0, t0));
+    BOOST_CHECK(cache.put("b", makeEntry("qcache_2"), 0, t0));
+    BOOST_CHECK(cache.get("a", entry, t0)); // "b" is now the oldest.
+    BOOST_CHECK(cache.put("c", makeEntry("qcache_3"), 0, t0));
+    BOOST_CHECK_EQUAL(cache.size(), 2U);
+    BOOST_CHECK_EQUAL(cache.getBytes(), 800U);
+    BOOST_CHECK(!cache.get("b", entry, t0));
+    BOOST_CHECK(!cache.put("d", makeEntry("qcache_4"), 0, t0)); // above the entry limit
+    BOOST_CHECK(!cache.put("e", makeEntry("qcache_5"), 0, t0)); // size unknown
+    BOOST_REQUIRE_EQUAL(db.dropped.size(), 3U);
+    BOOST_CHECK_EQUAL(db.dropped[0], "qcache_2");
+    BOOST_CHECK_EQUAL(db.dropped[1], "qcache_4");
+    BOOST_CHECK_EQUAL(db.dropped[2], "qcache_5");
+}
+
+BOOST_AUTO_TEST_CASE(Invalidate) {
+    FakeDb db;
+    db.tables["qcache_1"] = 10;
+    db.tables["qcache_2"] = 10;
+    ResultTableCache cache(1000, 1000, seconds(60), seconds(0), db.dropTable(), db.tableBytes());
+    auto const t0 = ResultTableCache::Clock::now();
+    uint64_t const generation = cache.getGeneration();
+    BOOST_CHECK(cache.put("a", makeEntry("qcache_1"), generation, t0));
+    cache.invalidate(t0);
+    BOOST_CHECK_EQUAL(cache.size(), 0U);
+    // Started before the invalidation, its result may be stale.
+    BOOST_CHECK(!cache.put("b", makeEntry("qcache_2"), generation, t0));
+    BOOST_CHECK_EQUAL(db.dropped.size(), 2U);
+}
+
+BOOST_AUTO_TEST_CASE(Disabled) {
+    FakeDb db;
+    db.tables["qcache_1"] = 10;
+    ResultTableCache cache(0, 1000, seconds(60), seconds(0), db.dropTable(), db.tableBytes());
+    ResultTableCache::Entry entry;
+    BOOST_CHECK(!cache.put("a", makeEntry("qcache_1"), 0));
+    BOOST_CHECK(!cache.get("a", entry));
+    BOOST_CHECK_EQUAL(db.dropped.size(), 1U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
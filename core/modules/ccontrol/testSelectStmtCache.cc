@@ -0,0 +1,81 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+// Class header
+#include "ccontrol/SelectStmtCache.h"
+
+// Qserv headers
+#include "query/SelectStmt.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE SelectStmtCache
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::ccontrol::SelectStmtCache;
+using lsst::qserv::query::SelectStmt;
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(Copies) {
+    SelectStmtCache cache(10);
+    SelectStmt stmt;
+    stmt.setLimit(5);
+    BOOST_CHECK(cache.get("SELECT 1") == nullptr);
+    cache.put("SELECT 1", stmt);
+    auto first = cache.get("SELECT 1");
+    BOOST_REQUIRE(first != nullptr);
+    BOOST_CHECK_EQUAL(first->getLimit(), 5);
+    first->setLimit(7); // Changing a copy leaves the cached statement alone.
+    auto second = cache.get("SELECT 1");
+    BOOST_REQUIRE(second != nullptr);
+    BOOST_CHECK(second != first);
+    BOOST_CHECK_EQUAL(second->getLimit(), 5);
+    BOOST_CHECK_EQUAL(cache.getHitCount(), 2U);
+    BOOST_CHECK_EQUAL(cache.getMissCount(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(LeastRecentlyUsed) {
+    SelectStmtCache cache(2);
+    SelectStmt stmt;
+    cache.put("a", stmt);
+    cache.put("b", stmt);
+    BOOST_CHECK(cache.get("a") != nullptr); // "b" is now the oldest.
+    cache.put("c", stmt);
+    BOOST_CHECK_EQUAL(cache.size(), 2U);
+    BOOST_CHECK(cache.get("a") != nullptr);
+    BOOST_CHECK(cache.get("b") == nullptr);
+    BOOST_CHECK(cache.get("c") != nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(Disabled) {
+    SelectStmtCache cache(0);
+    SelectStmt stmt;
+    cache.put("a", stmt);
+    BOOST_CHECK_EQUAL(cache.size(), 0U);
+    BOOST_CHECK(cache.get("a") == nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
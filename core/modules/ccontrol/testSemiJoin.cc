@@ -0,0 +1,144 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// System headers
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "ccontrol/SemiJoin.h"
+#include "css/CssAccess.h"
+#include "parser/SelectParser.h"
+#include "query/AndTerm.h"
+#include "query/BoolFactor.h"
+#include "query/InPredicate.h"
+#include "query/SelectStmt.h"
+#include "query/WhereClause.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE SemiJoin
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::ccontrol::SemiJoin;
+using lsst::qserv::parser::SelectParser;
+using namespace lsst::qserv;
+
+struct Fixture {
+    Fixture() {
+        // Object is the director table of Source in LSST, see qana/testPlugins.cc
+        std::ifstream stream("./core/modules/qana/testPlugins.kvmap");
+        css = css::CssAccess::createFromStream(stream, ".");
+    }
+
+    SemiJoin::Ptr detect(std::string const& query) {
+        auto stmt = SelectParser::makeSelectStmt(query, SelectParser::ANTLR4);
+        return SemiJoin::detect(*stmt, *css, "LSST");
+    }
+
+    std::shared_ptr<css::CssAccess> css;
+};
+
+BOOST_FIXTURE_TEST_SUITE(Suite, Fixture)
+
+BOOST_AUTO_TEST_CASE(ListedTables) {
+    auto semiJoin = detect("SELECT s.sourceId FROM Object o, Source s "
+                           "WHERE o.objectIdObjTest = s.objectIdSourceTest AND o.ra_Test < 10 "
+                           "AND s.flux > 1");
+    BOOST_REQUIRE(semiJoin != nullptr);
+    BOOST_CHECK_EQUAL(semiJoin->getRestrictedColumn(), "objectIdSourceTest");
+    BOOST_CHECK_EQUAL(semiJoin->getKeyColumn(), "o.objectIdObjTest");
+    std::string const keyQuery = semiJoin->makeKeyQuery(10);
+    BOOST_CHECK(keyQuery.find("SELECT o.objectIdObjTest FROM LSST.Object AS o WHERE (") == 0);
+    BOOST_CHECK(keyQuery.find("ra_Test") != std::string::npos);
+    BOOST_CHECK(keyQuery.find("flux") == std::string::npos);
+    BOOST_CHECK(keyQuery.find("LIMIT 11") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(InnerJoin) {
+    auto semiJoin = detect("SELECT o.ra_Test FROM Source s JOIN Object o "
+                           "ON o.objectIdObjTest = s.objectIdSourceTest WHERE s.flux > 1");
+    BOOST_REQUIRE(semiJoin != nullptr);
+    BOOST_CHECK_EQUAL(semiJoin->getRestrictedColumn(), "objectIdObjTest");
+    BOOST_CHECK_EQUAL(semiJoin->getKeyColumn(), "s.objectIdSourceTest");
+}
+
+BOOST_AUTO_TEST_CASE(NotSemiJoins) {
+    // No terms of a table of its own.
+    BOOST_CHECK(detect("SELECT s.sourceId FROM Object o, Source s "
+                       "WHERE o.objectIdObjTest = s.objectIdSourceTest") == nullptr);
+    // Not joined on a secondary index column.
+    BOOST_CHECK(detect("SELECT s.sourceId FROM Object o, Source s "
+                       "WHERE o.ra_Test = s.raObjectTest AND o.decl_Test < 10") == nullptr);
+    // Outer join.
+    BOOST_CHECK(detect("SELECT o.ra_Test FROM Source s LEFT JOIN Object o "
+                       "ON o.objectIdObjTest = s.objectIdSourceTest WHERE s.flux > 1") == nullptr);
+    // A term of both tables is not one of the selective side.
+    BOOST_CHECK(detect("SELECT s.sourceId FROM Object o, Source s "
+                       "WHERE o.objectIdObjTest = s.objectIdSourceTest OR o.ra_Test < 10") == nullptr);
+    BOOST_CHECK(detect("SELECT objectIdObjTest FROM Object WHERE ra_Test < 10") == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(Restrict) {
+    std::string const query = "SELECT s.sourceId FROM Object o, Source s "
+                              "WHERE o.objectIdObjTest = s.objectIdSourceTest AND o.ra_Test < 10";
+    auto stmt = SelectParser::makeSelectStmt(query, SelectParser::ANTLR4);
+    auto semiJoin = SemiJoin::detect(*stmt, *css, "LSST");
+    BOOST_REQUIRE(semiJoin != nullptr);
+
+    auto restricted = semiJoin->restrict(*stmt, {"3", "5"});
+    BOOST_REQUIRE(restricted != stmt);
+    auto andTerm = restricted->getWhereClause().getRootAndTerm();
+    BOOST_REQUIRE(andTerm != nullptr);
+    BOOST_CHECK_EQUAL(andTerm->_terms.size(), 3U);
+    auto factor = std::dynamic_pointer_cast<query::BoolFactor>(andTerm->_terms.front());
+    BOOST_REQUIRE(factor != nullptr);
+    auto in = std::dynamic_pointer_cast<query::InPredicate>(factor->_terms.front());
+    BOOST_REQUIRE(in != nullptr);
+    BOOST_CHECK_EQUAL(in->cands.size(), 2U);
+    // The statement given is left alone.
+    BOOST_CHECK_EQUAL(stmt->getWhereClause().getRootAndTerm()->_terms.size(), 2U);
+
+    // No key selects no row.
+    restricted = semiJoin->restrict(*stmt, {});
+    andTerm = restricted->getWhereClause().getRootAndTerm();
+    factor = std::dynamic_pointer_cast<query::BoolFactor>(andTerm->_terms.front());
+    in = std::dynamic_pointer_cast<query::InPredicate>(factor->_terms.front());
+    BOOST_REQUIRE(in != nullptr);
+    BOOST_REQUIRE_EQUAL(in->cands.size(), 1U);
+    BOOST_CHECK_EQUAL(in->cands.front()->copyAsLiteral(), "NULL");
+}
+
+BOOST_AUTO_TEST_CASE(Keys) {
+    BOOST_CHECK(SemiJoin::isKey("42"));
+    BOOST_CHECK(SemiJoin::isKey("-7"));
+    BOOST_CHECK(!SemiJoin::isKey(""));
+    BOOST_CHECK(!SemiJoin::isKey("-"));
+    BOOST_CHECK(!SemiJoin::isKey("1.5"));
+    BOOST_CHECK(!SemiJoin::isKey("1 OR 1"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,73 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "css/ChunkBitmap.h"
+
+// System headers
+#include <algorithm>
+
+namespace lsst {
+namespace qserv {
+namespace css {
+
+void ChunkBitmap::set(int chunkId) {
+    if (chunkId < 0) return;
+    size_t word = static_cast<size_t>(chunkId) / 64;
+    if (word >= _words.size()) {
+        _words.resize(word + 1, 0);
+    }
+    _words[word] |= uint64_t(1) << (chunkId % 64);
+}
+
+
+void ChunkBitmap::andNot(ChunkBitmap const& other) {
+    size_t n = std::min(_words.size(), other._words.size());
+    // No dependency between iterations, the compiler vectorizes this loop.
+    for (size_t w = 0; w < n; ++w) {
+        _words[w] &= ~other._words[w];
+    }
+}
+
+
+size_t ChunkBitmap::count() const {
+    size_t n = 0;
+    for (uint64_t word : _words) {
+        n += __builtin_popcountll(word);
+    }
+    return n;
+}
+
+
+IntVector ChunkBitmap::getChunks() const {
+    IntVector chunks;
+    chunks.reserve(count());
+    for (size_t w = 0; w < _words.size(); ++w) {
+        for (uint64_t word = _words[w]; word != 0; word &= word - 1) {
+            chunks.push_back(static_cast<int>(64 * w + __builtin_ctzll(word)));
+        }
+    }
+    return chunks;
+}
+
+}}} // namespace lsst::qserv::css
@@ -0,0 +1,75 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_CSS_CHUNKBITMAP_H
+#define LSST_QSERV_CSS_CHUNKBITMAP_H
+
+// System headers
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "global/intTypes.h"
+
+namespace lsst {
+namespace qserv {
+namespace css {
+
+/// ChunkBitmap is a set of chunk ids held as one bit per chunk id, up to the
+/// largest id in the set. Chunk ids of a partitioning are dense, so this takes
+/// far less memory than a std::set, answers membership with a single load,
+/// and combines sets a 64-bit word at a time.
+class ChunkBitmap {
+public:
+    ChunkBitmap() = default;
+
+    /// Add 'chunkId' to the set. Negative ids are ignored.
+    void set(int chunkId);
+
+    /// @return true if 'chunkId' is in the set.
+    bool test(int chunkId) const {
+        if (chunkId < 0) return false;
+        size_t word = static_cast<size_t>(chunkId) / 64;
+        return word < _words.size() && ((_words[word] >> (chunkId % 64)) & 1);
+    }
+
+    /// Remove the chunk ids of 'other' from the set.
+    void andNot(ChunkBitmap const& other);
+
+    /// @return the number of chunk ids in the set.
+    size_t count() const;
+
+    /// @return true if the set holds no chunk id.
+    bool empty() const { return count() == 0; }
+
+    /// @return the chunk ids of the set, in increasing order.
+    IntVector getChunks() const;
+
+private:
+    std::vector<uint64_t> _words; ///< Bit j of word w set if chunk 64*w+j is in the set
+};
+
+}}} // namespace lsst::qserv::css
+
+#endif // LSST_QSERV_CSS_CHUNKBITMAP_H
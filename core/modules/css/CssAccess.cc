@@ -25,11 +25,14 @@
 
 // System headers
 #include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <map>
 #include <sstream>
+#include <utility>
 
 // Third-party headers
+#include "boost/algorithm/string.hpp"
 #include "boost/lexical_cast.hpp"
 #include "boost/property_tree/ptree.hpp"
 #include "boost/property_tree/json_parser.hpp"
@@ -45,6 +48,8 @@
 #include "css/KvInterface.h"
 #include "css/KvInterfaceImplMem.h"
 #include "css/KvInterfaceImplMySql.h"
+#include "css/KvInterfaceImplSnapshot.h"
+#include "css/ZoneMaps.h"
 #include "mysql/MySqlConfig.h"
 #include "util/IterableFormatter.h"
 
@@ -116,7 +121,14 @@ CssAccess::createFromConfig(std::map<std::string, std::string> const& config,
         }
     } else if (cssConfig.getTechnology() == "mysql") {
         LOGS(_log, LOG_LVL_DEBUG, "Create CSS instance with mysql store " << cssConfig.getMySqlConfig());
-        auto kvi = std::make_shared<KvInterfaceImplMySql>(cssConfig.getMySqlConfig(), readOnly);
+        std::shared_ptr<KvInterface> kvi =
+            std::make_shared<KvInterfaceImplMySql>(cssConfig.getMySqlConfig(), readOnly);
+        if (cssConfig.getSnapshotRefreshSec() > 0) {
+            LOGS(_log, LOG_LVL_DEBUG, "Reading mysql store through an in-memory copy");
+            kvi = std::make_shared<KvInterfaceImplSnapshot>(
+                kvi, std::chrono::seconds(cssConfig.getSnapshotRefreshSec()),
+                cssConfig.getSnapshotCacheFile());
+        }
         return std::shared_ptr<CssAccess>(new CssAccess(kvi, std::make_shared<EmptyChunks>(emptyChunkPath)));
     } else {
         LOGS(_log, LOG_LVL_DEBUG, "Unexpected value of \"technology\" key: " << cssConfig.getTechnology());
@@ -129,6 +141,7 @@ CssAccess::CssAccess(std::shared_ptr<KvInterface> const& kvInterface,
                      std::shared_ptr<EmptyChunks> const& emptyChunks,
                      std::string const& prefix)
     : _kvI(kvInterface), _emptyChunks(emptyChunks),
+      _zoneMaps(std::make_shared<ZoneMaps>(emptyChunks->getPath())),
       _prefix(prefix), _versionOk(false) {
 
     // Check CSS version defined in KV, or create key with version
@@ -335,26 +348,23 @@ CssAccess::getTableNames(std::string const& dbName, bool readyOnly) const {
     _checkVersion();
 
     std::string key = _prefix + "/DBS/" + dbName + "/TABLES";
-    std::vector<std::string> names;
+    std::map<std::string, std::string> kvs;
     try {
-        names = _kvI->getChildren(key);
+        // statuses come with the names, no need for another query
+        kvs = _kvI->getChildrenValues(key);
     } catch (NoSuchKey const& exc) {
         LOGS(_log, LOG_LVL_DEBUG, "getTableNames: key is not found: " << key);
         _assertDbExists(dbName);
     }
 
     // tables cannot be packed, but just in case remove packed key if any
-    auto it = std::remove(names.begin(), names.end(), ::_packedKeyName);
-    names.erase(it, names.end());
+    kvs.erase(::_packedKeyName);
 
-    if (readyOnly and not names.empty()) {
+    std::vector<std::string> names;
+    for (auto& kv: kvs) {
         // filter out names with status other than READY
-        auto const tableStatuses = _getSubkeys(key, names);
-        names.clear();
-        for (auto& kv: tableStatuses) {
-            if (kv.second == "READY") {
-                names.push_back(kv.first);
-            }
+        if (not readyOnly or kv.second == "READY") {
+            names.push_back(kv.first);
         }
     }
     return names;
@@ -672,22 +682,7 @@ CssAccess::getNodeParams(std::string const& nodeName) const {
         return params;
     }
 
-    // fill the structure
-    params.state = paramMap[nodeName];
-    params.type = paramMap[nodeName + "/type"];
-    params.host = paramMap[nodeName + "/host"];
-    try {
-        auto iter = paramMap.find(nodeName + "/port");
-        if (iter != paramMap.end()) {
-            params.port = std::stoi(iter->second);
-        }
-    } catch (std::exception const& exc) {
-        LOGS(_log, LOG_LVL_ERROR, "one of the sub-keys is not numeric: "
-             << util::printable(paramMap));
-        throw KeyValueError(key + "/" + nodeName,
-                            "one of the sub-keys is not numeric: " + std::string(exc.what()));
-    }
-
+    _fillNodeParams(paramMap, nodeName, params, key);
     return params;
 }
 
@@ -698,20 +693,24 @@ CssAccess::getAllNodeParams() const {
 
     std::string const key = _prefix + "/NODES";
 
-    // we do not really care much about consistency here and
-    // are prepared to deal with nodes disappearing.
+    // all nodes are read at once, with their sub-keys
+    auto paramMap = _getSubtree(key);
+
     std::map<std::string, NodeParams> result;
-    for (auto& node: getNodeNames()) {
-        try {
-            result.insert(std::make_pair(node, getNodeParams(node)));
-        } catch (NoSuchNode const& exc) {
-            LOGS(_log, LOG_LVL_DEBUG, "node disappeared");
-        }
+    for (auto& kv: paramMap) {
+        auto const& node = kv.first;
+        if (node.empty() or node.find('/') != std::string::npos) continue;
+        _fillNodeParams(paramMap, node, result[node], key);
     }
 
     return result;
 }
 
+std::string
+CssAccess::getVersion() const {
+    return _kvI->getVersion();
+}
+
 void
 CssAccess::addNode(std::string const& nodeName, NodeParams const& nodeParams) {
     LOGS(_log, LOG_LVL_DEBUG, "addNode(" << nodeName << ")");
@@ -838,44 +837,35 @@ CssAccess::getChunks(std::string const& dbName, std::string const& tableName) {
 
     std::map<int, std::vector<std::string>> result;
 
-    std::vector<std::string> chunks;
+    // all chunks are read at once, with their replicas
+    std::map<std::string, std::string> kvs;
     try {
-        chunks = _kvI->getChildren(chunksKey);
+        kvs = _getSubtree(chunksKey);
     } catch (NoSuchKey const& exc) {
         if (not _kvI->exists(tableKey)) throw NoSuchTable(dbName, tableName);
         LOGS(_log, LOG_LVL_DEBUG, "getChunks: No CHUNKS sub-key for: " << tableKey);
         return result;
     }
 
-    for (auto& chunk: chunks) {
-        int chunkId;
-        try {
-            chunkId = std::stoi(chunk);
-        } catch (std::exception const& exc) {
-            LOGS(_log, LOG_LVL_DEBUG, "getChunks: non-numeric chunk key: " << chunk);
-            continue;
-        }
+    // keys look like CHUNK/REPLICAS[/REPLICA/nodeName]
+    for (auto& kv: kvs) {
+        std::vector<std::string> path;
+        boost::split(path, kv.first, boost::is_any_of("/"));
+        bool const isReplicas = path.size() == 2 and path[1] == "REPLICAS";
+        bool const isNodeName = path.size() == 4 and path[1] == "REPLICAS" and path[3] == "nodeName";
+        if (not isReplicas and not isNodeName) continue;
 
-        std::string const replicasKey = chunksKey + "/" + chunk + "/REPLICAS";
-        std::vector<std::string> replicas;
+        int chunkId;
         try {
-            replicas = _kvI->getChildren(replicasKey);
-
-            // replicas cannot be packed, but just in case remove packed key if any
-            auto it = std::remove(replicas.begin(), replicas.end(), ::_packedKeyName);
-            replicas.erase(it, replicas.end());
+            chunkId = std::stoi(path[0]);
         } catch (std::exception const& exc) {
-            LOGS(_log, LOG_LVL_DEBUG, "getChunks: replica key is missing: " << replicasKey);
+            LOGS(_log, LOG_LVL_DEBUG, "getChunks: non-numeric chunk key: " << path[0]);
             continue;
         }
 
         auto& nodes = result[chunkId];
-        for (auto& replica: replicas) {
-            auto nodeMap = _getSubkeys(replicasKey + "/" + replica, {"nodeName"});
-            auto iter = nodeMap.find("nodeName");
-            if (iter != nodeMap.end()) {
-                nodes.push_back(iter->second);
-            }
+        if (isNodeName) {
+            nodes.push_back(kv.second);
         }
     }
 
@@ -953,6 +943,37 @@ CssAccess::_getSubkeys(std::string const& key, std::vector<std::string> const& s
     return result;
 }
 
+std::map<std::string, std::string>
+CssAccess::_getSubtree(std::string const& key) const {
+    LOGS(_log, LOG_LVL_DEBUG, "_getSubtree(" << key << ")");
+
+    auto const keyMap = _kvI->getSubtree(key);
+
+    // make keys relative, unpack packed keys without overwriting regular
+    // keys (which override same packed keys)
+    std::string const pfx = key + "/";
+    std::map<std::string, std::string> result;
+    std::vector<std::pair<std::string, std::string>> packed;
+    for (auto& kv: keyMap) {
+        if (not boost::starts_with(kv.first, pfx)) continue;
+        std::string const subKey = kv.first.substr(pfx.size());
+        if (subKey == ::_packedKeyName or boost::ends_with(subKey, "/" + ::_packedKeyName)) {
+            packed.push_back(std::make_pair(subKey, kv.second));
+        } else {
+            result.insert(result.end(), std::make_pair(subKey, kv.second));
+        }
+    }
+    for (auto& kv: packed) {
+        std::string const parentKey = kv.first.substr(0, kv.first.size() - ::_packedKeyName.size());
+        for (auto& unpacked: _unpackJson(pfx + kv.first, kv.second)) {
+            result.insert(std::make_pair(parentKey + unpacked.first, unpacked.second));
+        }
+    }
+
+    LOGS(_log, LOG_LVL_DEBUG, "_getSubtree: " << result.size() << " keys");
+    return result;
+}
+
 std::map<std::string, std::string>
 CssAccess::_unpackJson(std::string const& key, std::string const& data) {
     namespace ptree = boost::property_tree;
@@ -1037,6 +1058,27 @@ CssAccess::_fillPartTableParams(std::map<std::string, std::string>& paramMap,
     }
 }
 
+void
+CssAccess::_fillNodeParams(std::map<std::string, std::string>& paramMap,
+                           std::string const& nodeName,
+                           NodeParams& params,
+                           std::string const& nodesKey) const {
+    params.state = paramMap[nodeName];
+    params.type = paramMap[nodeName + "/type"];
+    params.host = paramMap[nodeName + "/host"];
+    try {
+        auto iter = paramMap.find(nodeName + "/port");
+        if (iter != paramMap.end()) {
+            params.port = std::stoi(iter->second);
+        }
+    } catch (std::exception const& exc) {
+        LOGS(_log, LOG_LVL_ERROR, "one of the sub-keys is not numeric: "
+             << util::printable(paramMap));
+        throw KeyValueError(nodesKey + "/" + nodeName,
+                            "one of the sub-keys is not numeric: " + std::string(exc.what()));
+    }
+}
+
 void
 CssAccess::_fillMatchTableParams(std::map<std::string, std::string>& paramMap,
                                  MatchTableParams& params,
@@ -45,6 +45,7 @@ namespace qserv {
 namespace css {
 
 class EmptyChunks;
+class ZoneMaps;
 class KvInterface;
 
 /// @addtogroup css
@@ -121,6 +122,10 @@ public:
      *       'username': mysql user name
      *       'password': user password
      *       'database': database name
+     *       'snapshot_refresh_sec': if positive, reads are served from an
+     *           in-memory copy of the store, which is checked for changes
+     *           made by other clients with this period (see
+     *           KvInterfaceImplSnapshot)
      *
      *  @param config:  configuration map
      *  @param emptyChunkPath:  path to empty chunk list file
@@ -488,6 +493,17 @@ public:
      */
     EmptyChunks const& getEmptyChunks() const { return *_emptyChunks; }
 
+    /**
+     * @brief Access the per-chunk column ranges, kept with the empty chunk lists.
+     */
+    ZoneMaps const& getZoneMaps() const { return *_zoneMaps; }
+
+    /**
+     *  Return a string identifying the current CSS contents, empty if they
+     *  can not be identified. See KvInterface::getVersion().
+     */
+    std::string getVersion() const;
+
     /**
      *  Return underlying KvInterface instance.
      *
@@ -518,6 +534,15 @@ protected:
     std::map<std::string, std::string> _getSubkeys(std::string const& key,
                                                    std::vector<std::string> const& subKeys) const;
 
+    /**
+     * Get all sub-keys of a given key, at any depth, in a single call to the KV
+     * store. Returned map has sub-key paths relative to the key as keys, packed
+     * keys are unpacked like in _getSubkeys().
+     *
+     * @throws NoSuchKey: if the key does not exist
+     */
+    std::map<std::string, std::string> _getSubtree(std::string const& key) const;
+
     /**
      * Unpack json string into key-value map, only one-level nesting
      * is supported, keys with more complex values are ignored. For empty
@@ -549,11 +574,16 @@ private:
     void _fillScanTableParams(std::map<std::string, std::string>& paramMap,
                               ScanTableParams& params,
                               std::string const& tableKey) const;
+    void _fillNodeParams(std::map<std::string, std::string>& paramMap,
+                         std::string const& nodeName,
+                         NodeParams& params,
+                         std::string const& nodesKey) const;
 
 private:
 
     std::shared_ptr<KvInterface> _kvI;
     std::shared_ptr<EmptyChunks> _emptyChunks;
+    std::shared_ptr<ZoneMaps> _zoneMaps;
     std::string _prefix;    // optional prefix, for isolating tests from production
     mutable bool _versionOk;   // True if version is checked (and is OK)
 };
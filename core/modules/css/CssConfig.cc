@@ -54,7 +54,9 @@ CssConfig::CssConfig(util::ConfigStore const& configStore)
            configStore.get("hostname"),
            configStore.getInt("port"),
            configStore.get("socket"),
-           configStore.get("database")) {
+           configStore.get("database")),
+      _snapshotRefreshSec(configStore.getInt("snapshot_refresh_sec")),
+      _snapshotCacheFile(configStore.get("snapshot_cache_file")) {
 
     if (_technology.empty()) {
         std::string msg = "\"technology\" does not exist in configuration map";
@@ -67,13 +69,21 @@ CssConfig::CssConfig(util::ConfigStore const& configStore)
         LOGS(_log, LOG_LVL_ERROR, msg);
         throw ConfigError(msg);
     }
+
+    if (_snapshotRefreshSec < 0) {
+        std::string msg = "\"snapshot_refresh_sec\" can not be negative";
+        LOGS(_log, LOG_LVL_ERROR, msg);
+        throw ConfigError(msg);
+    }
 } catch (util::ConfigStoreError const& e) {
     throw ConfigError(e.what());
 }
 
 std::ostream& operator<<(std::ostream &out, CssConfig const& cssConfig) {
     out << "[ technology=" << cssConfig._technology << ", data=" << cssConfig._data
-        << ", file=" << cssConfig._file << ", mysql_configuration=" << cssConfig._mySqlConfig <<"]";
+        << ", file=" << cssConfig._file << ", mysql_configuration=" << cssConfig._mySqlConfig
+        << ", snapshot_refresh_sec=" << cssConfig._snapshotRefreshSec
+        << ", snapshot_cache_file=" << cssConfig._snapshotCacheFile << "]";
     return out;
 }
 
@@ -100,6 +100,24 @@ public:
         return _technology;
     }
 
+    /* Get the period of the checks for changes made to a "mysql" store by
+     * other clients, when it is read through an in-memory copy
+     *
+     * @return period in seconds, 0 if the store is read directly
+     */
+    int getSnapshotRefreshSec() const {
+        return _snapshotRefreshSec;
+    }
+
+    /* Get the local file keeping the last in-memory copy of a "mysql" store,
+     * used at startup instead of reading the whole store if it is current
+     *
+     * @return path of the file, empty for none
+     */
+    std::string const& getSnapshotCacheFile() const {
+        return _snapshotCacheFile;
+    }
+
 private:
 
     CssConfig(util::ConfigStore const& configStore);
@@ -112,6 +130,8 @@ private:
 
     // used by "mysql" technology
     mysql::MySqlConfig const _mySqlConfig;
+    int const _snapshotRefreshSec;
+    std::string const _snapshotCacheFile;
 
 };
 
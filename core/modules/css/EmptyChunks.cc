@@ -39,7 +39,7 @@
 #include "global/stringUtil.h"
 
 using lsst::qserv::ConfigError;
-using lsst::qserv::IntSet;
+using lsst::qserv::css::ChunkBitmap;
 
 namespace {
 
@@ -53,7 +53,7 @@ makeFilename(std::string const& db) {
 void
 populate(std::string const& path,
          std::string const& fallbackFile,
-         IntSet& s,
+         ChunkBitmap& s,
          std::string const& db) {
     std::string const best = path + "/" + makeFilename(db);
     std::string fileName = best;
@@ -70,7 +70,9 @@ populate(std::string const& path,
     }
     std::istream_iterator<int> chunkStream(rawStream);
     std::istream_iterator<int> eos;
-    std::copy(chunkStream, eos, std::insert_iterator<IntSet>(s, s.begin()));
+    for (; chunkStream != eos; ++chunkStream) {
+        s.set(*chunkStream);
+    }
 }
 } // anonymous namespace
 
@@ -78,28 +80,27 @@ namespace lsst {
 namespace qserv {
 namespace css {
 
-std::shared_ptr<IntSet const>
+std::shared_ptr<ChunkBitmap const>
 EmptyChunks::getEmpty(std::string const& db) const {
     std::lock_guard<std::mutex> lock(_setsMutex);
-    IntSetMap::const_iterator i = _sets.find(db);
+    ChunkBitmapMap::const_iterator i = _sets.find(db);
     if (i != _sets.end()) {
-        IntSetConstPtr readOnly = i->second;
-        return readOnly;
+        return i->second;
     }
-    IntSetPtr newSet = std::make_shared<IntSet>();
-    _sets.insert(IntSetMap::value_type(db, newSet));
+    auto newSet = std::make_shared<ChunkBitmap>();
+    _sets.insert(ChunkBitmapMap::value_type(db, newSet));
     populate(_path, _fallbackFile, *newSet, db); // Populate reference
-    return IntSetConstPtr(newSet);
+    return newSet;
 }
 
 bool
 EmptyChunks::isEmpty(std::string const& db, int chunk) const {
-    IntSetConstPtr s = getEmpty(db);
-    return s->end() != s->find(chunk);
+    return getEmpty(db)->test(chunk);
 }
 
 void
 EmptyChunks::clearCache(std::string const& db) const {
+    std::lock_guard<std::mutex> lock(_setsMutex);
     if (db.empty()) {
         LOGS(_log, LOG_LVL_DEBUG, "Clearing empty chunks cache for all databases");
         _sets.clear();
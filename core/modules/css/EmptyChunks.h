@@ -40,7 +40,7 @@
 #include <string>
 
 // Qserv headers
-#include "global/intTypes.h"
+#include "css/ChunkBitmap.h"
 
 namespace lsst {
 namespace qserv {
@@ -59,8 +59,11 @@ public:
 
     // accessors
 
+    /// @return the directory of the empty chunk lists
+    std::string const& getPath() const { return _path; }
+
     /// @return set of empty chunks for this db
-    std::shared_ptr<IntSet const> getEmpty(std::string const& db) const;
+    std::shared_ptr<ChunkBitmap const> getEmpty(std::string const& db) const;
 
     /// @return true if db/chunk is empty
     bool isEmpty(std::string const& db, int chunk) const;
@@ -73,13 +76,12 @@ public:
 private:
 
     // Convenience types
-    typedef std::shared_ptr<IntSet> IntSetPtr;
-    typedef std::shared_ptr<IntSet const> IntSetConstPtr;
+    typedef std::shared_ptr<ChunkBitmap const> ChunkBitmapConstPtr;
 
-    typedef std::map<std::string, IntSetPtr> IntSetMap;
+    typedef std::map<std::string, ChunkBitmapConstPtr> ChunkBitmapMap;
     std::string _path; ///< Search path for empty chunks files
     std::string _fallbackFile; ///< Fallback path for empty chunks
-    mutable IntSetMap _sets; ///< Container for empty chunks sets (cache)
+    mutable ChunkBitmapMap _sets; ///< Container for empty chunks sets (cache)
     mutable std::mutex _setsMutex;
 };
 
@@ -129,6 +129,15 @@ public:
      */
     virtual std::map<std::string, std::string> getChildrenValues(std::string const& key) = 0;
 
+    /**
+     * Returns a key and all of its sub-keys at any depth, together with values,
+     * keyed by full path (the root key itself is not included). This is done
+     * with a single read of the storage.
+     * @throws NoSuchKey if the key does not exist
+     * @throws CssError for other problems (e.g., a connection error is detected).
+     */
+    virtual std::map<std::string, std::string> getSubtree(std::string const& key) = 0;
+
     /**
      * Delete a key, and all of its children (if they exist)
      * @throws NoSuchKey on failure.
@@ -147,6 +156,16 @@ public:
      */
     virtual std::string dumpKV(std::string const& key=std::string()) = 0;
 
+    /**
+     *  Return a string identifying the current contents of the store.
+     *
+     *  Two calls returning the same non-empty string, in any instance of
+     *  this process, see the same contents, so that objects derived from
+     *  them can be kept. An empty string, the default, means that the
+     *  contents can not be identified.
+     */
+    virtual std::string getVersion() { return std::string(); }
+
 protected:
     KvInterface() {}
     virtual std::string _get(std::string const& key,
@@ -249,6 +249,28 @@ KvInterfaceImplMem::getChildrenValues(std::string const& key) {
     return retV;
 }
 
+std::map<std::string, std::string>
+KvInterfaceImplMem::getSubtree(std::string const& key) {
+    LOGS(_log, LOG_LVL_DEBUG, "getSubtree(), key: " << key);
+    std::string path = norm_key(key);
+    std::map<std::string, std::string> retV;
+    if (not path.empty()) {
+        auto iter = _kvMap.find(path);
+        if (iter == _kvMap.end()) {
+            throw NoSuchKey(path);
+        }
+        retV.insert(*iter);
+    }
+    // sub-keys are sorted right after their common prefix
+    const string pfx(path + "/");
+    for (auto iter = _kvMap.lower_bound(pfx);
+         iter != _kvMap.end() and boost::starts_with(iter->first, pfx); ++iter) {
+        retV.insert(retV.end(), *iter);
+    }
+    LOGS(_log, LOG_LVL_DEBUG, "got: " << retV.size() << " keys");
+    return retV;
+}
+
 void
 KvInterfaceImplMem::deleteKey(string const& key) {
     LOGS(_log, LOG_LVL_DEBUG, "deleteKey(" << key << ")");
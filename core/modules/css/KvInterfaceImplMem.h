@@ -62,6 +62,7 @@ public:
     virtual std::map<std::string, std::string> getMany(std::vector<std::string> const& keys) override;
     virtual std::vector<std::string> getChildren(std::string const& key) override;
     virtual std::map<std::string, std::string> getChildrenValues(std::string const& key) override;
+    virtual std::map<std::string, std::string> getSubtree(std::string const& key) override;
     virtual void deleteKey(std::string const& key) override;
     virtual std::string dumpKV(std::string const& key=std::string()) override;
 
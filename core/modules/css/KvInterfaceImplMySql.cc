@@ -55,6 +55,7 @@
 #include "lsst/log/Log.h"
 
 // Qserv headers
+#include "css/constants.h"
 #include "css/CssError.h"
 #include "sql/SqlResults.h"
 #include "sql/SqlTransaction.h"
@@ -285,6 +286,7 @@ KvInterfaceImplMySql::create(std::string const& key, std::string const& value, b
         _create(path, value, false, transaction);
     }
 
+    _bumpChanges(transaction);
     transaction.commit();
     return path;
 }
@@ -343,6 +345,7 @@ KvInterfaceImplMySql::set(std::string const& key, std::string const& value) {
     // key is validated by _create
     KvTransaction transaction(_conn);
     _create(norm_key(key), value, true, transaction);
+    _bumpChanges(transaction);
     transaction.commit();
 }
 
@@ -493,6 +496,57 @@ KvInterfaceImplMySql::getChildrenValues(std::string const& parentKey) {
 }
 
 
+std::map<std::string, std::string>
+KvInterfaceImplMySql::getSubtree(std::string const& keyArg) {
+    std::string const key = norm_key(keyArg);
+    if (not key.empty()) {
+        _validateKey(key);
+    }
+
+    // The sub-keys of a key are the keys between "key/" and "key0" ('0'
+    // follows '/'), so this is a range scan of the kvKey index.
+    std::string const escKey = _escapeSqlString(key);
+    std::string query = str(boost::format("SELECT kvKey, kvVal FROM kvData WHERE "
+                                          "(kvKey >= '%1%/' AND kvKey < '%1%0')") % escKey);
+    if (not key.empty()) {
+        query += str(boost::format(" OR kvKey = '%1%'") % escKey);
+    }
+
+    // run query
+    KvTransaction transaction(_conn);
+    sql::SqlErrorObject errObj;
+    sql::SqlResults results;
+    LOGS(_log, LOG_LVL_DEBUG, "getSubtree - executing query: " << query);
+    if (not _conn.runQueryStreaming(query, results, errObj)) {
+        std::stringstream ss;
+        ss << "getSubtree - " << query << " failed with err: " << errObj.errMsg() << std::ends;
+        LOGS(_log, LOG_LVL_ERROR, ss.str());
+        throw CssError(ss.str());
+    }
+
+    // copy results
+    std::map<std::string, std::string> res;
+    for (auto& row: results) {
+        const char* subKey = row[0].first;
+        const char* val = row[1].first ? row[1].first : "";
+        res.insert(std::make_pair(subKey, val));
+    }
+    if (not results.checkStreamError(errObj)) {
+        std::stringstream ss;
+        ss << "getSubtree - " << query << " failed with err: " << errObj.errMsg() << std::ends;
+        LOGS(_log, LOG_LVL_ERROR, ss.str());
+        throw CssError(ss.str());
+    }
+    results.freeResults();
+    transaction.commit();
+
+    if (not key.empty() and res.count(key) == 0) {
+        throw NoSuchKey(key);
+    }
+    return res;
+}
+
+
 std::vector<std::string>
 KvInterfaceImplMySql::_getChildrenFullPath(std::string const& parentKey, KvTransaction const& transaction) {
     if (not transaction.isActive()) {
@@ -540,10 +594,39 @@ KvInterfaceImplMySql::deleteKey(std::string const& keyArg) {
     std::string key = norm_key(keyArg);
     KvTransaction transaction(_conn);
     _delete(key, transaction);
+    _bumpChanges(transaction);
     transaction.commit();
 }
 
 
+void
+KvInterfaceImplMySql::_bumpChanges(KvTransaction const& transaction) {
+    if (not transaction.isActive()) {
+        throw CssError("A transaction must active here.");
+    }
+
+    unsigned int parentKvId(0);
+    bool hasParent(false);
+    _findParentId(CHANGES_KEY, &hasParent, &parentKvId, transaction);
+
+    boost::format fmQuery;
+    if (hasParent) {
+        fmQuery = boost::format("INSERT INTO kvData (kvKey, kvVal, parentKvId) VALUES ('%1%', '1', '%2%')");
+        fmQuery % CHANGES_KEY % parentKvId;
+    } else {
+        fmQuery = boost::format("INSERT INTO kvData (kvKey, kvVal) VALUES ('%1%', '1')");
+        fmQuery % CHANGES_KEY;
+    }
+    std::string query = fmQuery.str() + " ON DUPLICATE KEY UPDATE kvVal=CAST(kvVal AS UNSIGNED)+1";
+    sql::SqlErrorObject errObj;
+    LOGS(_log, LOG_LVL_DEBUG, "_bumpChanges - executing query: " << query);
+    if (not _conn.runQuery(query, errObj)) {
+        LOGS(_log, LOG_LVL_ERROR, "_bumpChanges - " << query << " failed with err: " << errObj.errMsg());
+        throw CssError(errObj);
+    }
+}
+
+
 std::string KvInterfaceImplMySql::dumpKV(std::string const& key) {
 
     // It's better to make them ordered so that /key comes before /key/subkey
@@ -554,7 +637,7 @@ std::string KvInterfaceImplMySql::dumpKV(std::string const& key) {
     sql::SqlErrorObject errObj;
     sql::SqlResults results;
     LOGS(_log, LOG_LVL_DEBUG, "dumpKV - executing query: " << query);
-    if (not _conn.runQuery(query, results, errObj)) {
+    if (not _conn.runQueryStreaming(query, results, errObj)) {
         std::stringstream ss;
         ss << "dumpKV - " << query << " failed with err: " << errObj.errMsg() << std::ends;
         LOGS(_log, LOG_LVL_ERROR, ss.str());
@@ -577,6 +660,13 @@ std::string KvInterfaceImplMySql::dumpKV(std::string const& key) {
             }
         }
     }
+    if (not results.checkStreamError(errObj)) {
+        std::stringstream ss;
+        ss << "dumpKV - " << query << " failed with err: " << errObj.errMsg() << std::ends;
+        LOGS(_log, LOG_LVL_ERROR, ss.str());
+        throw CssError(ss.str());
+    }
+    results.freeResults();
 
     transaction.commit();
 
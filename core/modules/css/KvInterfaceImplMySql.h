@@ -71,6 +71,8 @@ public:
 
     virtual std::map<std::string, std::string> getChildrenValues(std::string const& key) override;
 
+    virtual std::map<std::string, std::string> getSubtree(std::string const& key) override;
+
     virtual void deleteKey(std::string const& key) override;
 
     virtual std::string dumpKV(std::string const& key=std::string()) override;
@@ -114,6 +116,11 @@ private:
      */
     void _delete(std::string const& key, KvTransaction const& transaction);
 
+    /**
+     * @brief increment the change counter (CHANGES_KEY), creating it if needed
+     */
+    void _bumpChanges(KvTransaction const& transaction);
+
     /**
      * @brief Validate key string our key rules.
      * @param key
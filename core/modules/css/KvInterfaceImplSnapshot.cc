@@ -0,0 +1,349 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+  * @file
+  *
+  * @brief Interface to the Common State System - immutable in-memory copy
+  * of another key-value store.
+  */
+
+// Class header
+#include "css/KvInterfaceImplSnapshot.h"
+
+// System headers
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+// Third-party headers
+#include "boost/algorithm/string/predicate.hpp"
+#include "boost/property_tree/ptree.hpp"
+#include "boost/property_tree/json_parser.hpp"
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "css/constants.h"
+#include "css/CssError.h"
+
+namespace ptree = boost::property_tree;
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.css.KvInterfaceImplSnapshot");
+
+// Number of copies loaded by all instances, see Snapshot::generation.
+std::atomic<unsigned long> generations{0};
+
+// Normalizes key path, takes user-provided key and converts it into
+// acceptable path for storage.
+std::string norm_key(std::string const& key) {
+    // root key is stored as empty string
+    std::string path(key == "/" ? "" : key);
+    return path;
+}
+
+// Fill 'kvMap' with the keys in 'dump', the output of KvInterface::dumpKV().
+void parseDump(std::string const& dump, std::map<std::string, std::string>& kvMap) {
+    std::istringstream data(dump);
+    ptree::ptree tree;
+    try {
+        ptree::read_json(data, tree);
+    } catch (ptree::json_parser_error const& exc) {
+        throw lsst::qserv::css::CssError("KvInterfaceImplSnapshot - failed to parse store contents");
+    }
+    kvMap.insert(std::make_pair(std::string(), std::string()));
+    for (auto&& pair: tree) {
+        kvMap[pair.first] = pair.second.data();
+    }
+}
+
+}
+
+namespace lsst {
+namespace qserv {
+namespace css {
+
+KvInterfaceImplSnapshot::KvInterfaceImplSnapshot(std::shared_ptr<KvInterface> const& store,
+                                                 std::chrono::milliseconds const& refreshInterval,
+                                                 std::string const& cacheFile)
+    : _store(store), _cacheFile(cacheFile) {
+    {
+        std::lock_guard<std::mutex> lock(_storeMtx);
+        if (not _loadCache()) {
+            _load();
+        } else {
+            // Only the change counter is read when the saved copy is current.
+            try {
+                if (_store->get(CHANGES_KEY, "") != _current()->changes) _load();
+            } catch (CssError const& exc) {
+                LOGS(_log, LOG_LVL_WARN, "failed to read the store, using the copy saved to "
+                     << _cacheFile << ": " << exc.what());
+            }
+        }
+    }
+    if (refreshInterval.count() > 0) {
+        _refresher = std::thread(&KvInterfaceImplSnapshot::_refreshLoop, this, refreshInterval);
+    }
+}
+
+KvInterfaceImplSnapshot::~KvInterfaceImplSnapshot() {
+    {
+        std::lock_guard<std::mutex> lock(_stopMtx);
+        _stop = true;
+    }
+    _stopCv.notify_all();
+    if (_refresher.joinable()) _refresher.join();
+}
+
+std::string
+KvInterfaceImplSnapshot::create(std::string const& key, std::string const& value, bool unique) {
+    std::lock_guard<std::mutex> lock(_storeMtx);
+    std::string const path = _store->create(key, value, unique);
+    _load();
+    return path;
+}
+
+void
+KvInterfaceImplSnapshot::set(std::string const& key, std::string const& value) {
+    std::lock_guard<std::mutex> lock(_storeMtx);
+    _store->set(key, value);
+    _load();
+}
+
+bool
+KvInterfaceImplSnapshot::exists(std::string const& key) {
+    auto const snapshot = _current();
+    return snapshot->kvMap.count(norm_key(key)) > 0;
+}
+
+std::map<std::string, std::string>
+KvInterfaceImplSnapshot::getMany(std::vector<std::string> const& keys) {
+    auto const snapshot = _current();
+    std::map<std::string, std::string> result;
+    for (auto& key: keys) {
+        auto iter = snapshot->kvMap.find(norm_key(key));
+        if (iter != snapshot->kvMap.end()) {
+            result.insert(*iter);
+        }
+    }
+    return result;
+}
+
+std::vector<std::string>
+KvInterfaceImplSnapshot::getChildren(std::string const& key) {
+    std::vector<std::string> children;
+    for (auto&& pair: getChildrenValues(key)) {
+        children.push_back(pair.first);
+    }
+    return children;
+}
+
+std::map<std::string, std::string>
+KvInterfaceImplSnapshot::getChildrenValues(std::string const& key) {
+    auto const snapshot = _current();
+    std::string const path = norm_key(key);
+    if (snapshot->kvMap.count(path) == 0) {
+        throw NoSuchKey(path);
+    }
+
+    // Keys are sorted, so the sub-keys of the key follow each other
+    // right after its prefix.
+    std::string const pfx(path + "/");
+    std::map<std::string, std::string> children;
+    for (auto iter = snapshot->kvMap.lower_bound(pfx);
+         iter != snapshot->kvMap.end() and boost::starts_with(iter->first, pfx); ++iter) {
+        std::string child(iter->first, pfx.size());
+        if (not child.empty() and child.find('/') == std::string::npos) {
+            children.insert(children.end(), std::make_pair(child, iter->second));
+        }
+    }
+    return children;
+}
+
+std::map<std::string, std::string>
+KvInterfaceImplSnapshot::getSubtree(std::string const& key) {
+    auto const snapshot = _current();
+    std::string const path = norm_key(key);
+    std::map<std::string, std::string> subtree;
+    if (not path.empty()) {
+        auto iter = snapshot->kvMap.find(path);
+        if (iter == snapshot->kvMap.end()) {
+            throw NoSuchKey(path);
+        }
+        subtree.insert(*iter);
+    }
+    std::string const pfx(path + "/");
+    for (auto iter = snapshot->kvMap.lower_bound(pfx);
+         iter != snapshot->kvMap.end() and boost::starts_with(iter->first, pfx); ++iter) {
+        subtree.insert(subtree.end(), *iter);
+    }
+    return subtree;
+}
+
+void
+KvInterfaceImplSnapshot::deleteKey(std::string const& key) {
+    std::lock_guard<std::mutex> lock(_storeMtx);
+    _store->deleteKey(key);
+    _load();
+}
+
+std::string
+KvInterfaceImplSnapshot::dumpKV(std::string const& key) {
+    auto const snapshot = _current();
+    std::string const pfx(norm_key(key) + "/");
+    ptree::ptree tree;
+    for (auto iter = snapshot->kvMap.lower_bound(pfx);
+         iter != snapshot->kvMap.end() and boost::starts_with(iter->first, pfx); ++iter) {
+        tree.push_back(ptree::ptree::value_type(iter->first, ptree::ptree(iter->second)));
+    }
+    std::ostringstream str;
+    ptree::write_json(str, tree);
+    return str.str();
+}
+
+bool
+KvInterfaceImplSnapshot::refresh() {
+    std::lock_guard<std::mutex> lock(_storeMtx);
+    if (_store->get(CHANGES_KEY, "") == _current()->changes) return false;
+    _load();
+    return true;
+}
+
+unsigned int
+KvInterfaceImplSnapshot::numLoads() const {
+    return _numLoads;
+}
+
+std::string
+KvInterfaceImplSnapshot::getVersion() {
+    return std::to_string(_current()->generation);
+}
+
+std::string
+KvInterfaceImplSnapshot::_get(std::string const& key,
+                              std::string const& defaultValue,
+                              bool throwIfKeyNotFound) {
+    auto const snapshot = _current();
+    std::string const path = norm_key(key);
+    auto iter = snapshot->kvMap.find(path);
+    if (iter == snapshot->kvMap.end()) {
+        if (throwIfKeyNotFound) {
+            throw NoSuchKey(path);
+        }
+        return defaultValue;
+    }
+    return iter->second;
+}
+
+std::shared_ptr<KvInterfaceImplSnapshot::Snapshot const>
+KvInterfaceImplSnapshot::_current() const {
+    return std::atomic_load(&_snapshot);
+}
+
+void
+KvInterfaceImplSnapshot::_load() {
+
+    // The counter is read first: a change made in between is then loaded
+    // now, and loaded again by the next refresh.
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->changes = _store->get(CHANGES_KEY, "");
+
+    std::string const dump = _store->dumpKV();
+    parseDump(dump, snapshot->kvMap);
+    std::string const changes = snapshot->changes;
+
+    snapshot->generation = ++generations;
+    std::atomic_store(&_snapshot, std::shared_ptr<Snapshot const>(std::move(snapshot)));
+    ++_numLoads;
+    LOGS(_log, LOG_LVL_DEBUG, "loaded copy " << _numLoads << " of the store, change counter: "
+         << changes);
+    _saveCache(changes, dump);
+}
+
+bool
+KvInterfaceImplSnapshot::_loadCache() {
+    if (_cacheFile.empty()) return false;
+    std::ifstream file(_cacheFile);
+    if (not file) return false;
+
+    // The change counter is on the first line, the dump follows.
+    auto snapshot = std::make_shared<Snapshot>();
+    std::string dump;
+    if (not std::getline(file, snapshot->changes) or not std::getline(file, dump, '\0')) {
+        LOGS(_log, LOG_LVL_WARN, "ignoring truncated copy in " << _cacheFile);
+        return false;
+    }
+    try {
+        parseDump(dump, snapshot->kvMap);
+    } catch (CssError const& exc) {
+        LOGS(_log, LOG_LVL_WARN, "ignoring copy in " << _cacheFile << ": " << exc.what());
+        return false;
+    }
+
+    snapshot->generation = ++generations;
+    std::atomic_store(&_snapshot, std::shared_ptr<Snapshot const>(std::move(snapshot)));
+    ++_numLoads;
+    LOGS(_log, LOG_LVL_INFO, "using copy saved to " << _cacheFile << ", change counter: "
+         << _current()->changes);
+    return true;
+}
+
+void
+KvInterfaceImplSnapshot::_saveCache(std::string const& changes, std::string const& dump) const {
+    if (_cacheFile.empty()) return;
+    std::string const tmpFile = _cacheFile + ".tmp";
+    {
+        std::ofstream file(tmpFile, std::ios::trunc);
+        file << changes << '\n' << dump;
+        file.close();
+        if (not file) {
+            LOGS(_log, LOG_LVL_WARN, "failed to save copy to " << tmpFile);
+            std::remove(tmpFile.c_str());
+            return;
+        }
+    }
+    if (std::rename(tmpFile.c_str(), _cacheFile.c_str()) != 0) {
+        LOGS(_log, LOG_LVL_WARN, "failed to replace " << _cacheFile);
+        std::remove(tmpFile.c_str());
+    }
+}
+
+void
+KvInterfaceImplSnapshot::_refreshLoop(std::chrono::milliseconds refreshInterval) {
+    std::unique_lock<std::mutex> stopLock(_stopMtx);
+    while (not _stopCv.wait_for(stopLock, refreshInterval, [this] { return _stop; })) {
+        stopLock.unlock();
+        try {
+            refresh();
+        } catch (CssError const& exc) {
+            LOGS(_log, LOG_LVL_WARN, "failed to refresh, keeping the current copy: " << exc.what());
+        }
+        stopLock.lock();
+    }
+}
+
+}}} // namespace lsst::qserv::css
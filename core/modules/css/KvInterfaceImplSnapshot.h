@@ -0,0 +1,152 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+  * @file
+  *
+  * @brief Interface to the Common State System - immutable in-memory copy
+  * of another key-value store.
+  */
+
+#ifndef LSST_QSERV_CSS_KVINTERFACEIMPLSNAPSHOT_H
+#define LSST_QSERV_CSS_KVINTERFACEIMPLSNAPSHOT_H
+
+// System headers
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Local headers
+#include "css/KvInterface.h"
+
+namespace lsst {
+namespace qserv {
+namespace css {
+
+/**
+ *  KvInterfaceImplSnapshot serves reads from a complete in-memory copy of
+ *  another store (normally KvInterfaceImplMySql), so that they need neither
+ *  SQL nor locks, and keep working while the store is unavailable.
+ *
+ *  A copy is never modified. Writes are forwarded to the store, after which
+ *  a new copy is loaded and swapped in atomically; readers holding the old
+ *  one finish with it. Changes made by other clients are picked up by a
+ *  thread which polls the change counter of the store (CHANGES_KEY, bumped
+ *  by KvInterfaceImplMySql on every write), and by calls to refresh().
+ *
+ *  Every copy loaded from the store can also be saved to a local file. At
+ *  startup a copy saved there is then used if the change counter of the
+ *  store did not move, or if the store can not be reached, instead of
+ *  reading the whole store again.
+ */
+class KvInterfaceImplSnapshot : public KvInterface {
+public:
+
+    /**
+     *  @param store: store to copy, and to forward writes to
+     *  @param refreshInterval: period of the change counter checks, no
+     *         thread is started if it is zero
+     *  @param cacheFile: local file keeping the last copy, none if empty
+     *  @throws CssError if the store can not be loaded, and no copy was
+     *          saved to the file
+     */
+    KvInterfaceImplSnapshot(std::shared_ptr<KvInterface> const& store,
+                            std::chrono::milliseconds const& refreshInterval,
+                            std::string const& cacheFile=std::string());
+
+    virtual ~KvInterfaceImplSnapshot();
+
+    virtual std::string create(std::string const& key, std::string const& value,
+                               bool unique=false) override;
+    virtual void set(std::string const& key, std::string const& value) override;
+    virtual bool exists(std::string const& key) override;
+    virtual std::map<std::string, std::string> getMany(std::vector<std::string> const& keys) override;
+    virtual std::vector<std::string> getChildren(std::string const& key) override;
+    virtual std::map<std::string, std::string> getChildrenValues(std::string const& key) override;
+    virtual std::map<std::string, std::string> getSubtree(std::string const& key) override;
+    virtual void deleteKey(std::string const& key) override;
+    virtual std::string dumpKV(std::string const& key=std::string()) override;
+
+    /// @return generation number of the current copy, unique in this process
+    virtual std::string getVersion() override;
+
+    /**
+     *  Load a new copy if the change counter of the store differs from the one
+     *  of the current copy.
+     *
+     *  @return true if a new copy was loaded
+     *  @throws CssError if the store can not be read, the current copy is kept
+     */
+    bool refresh();
+
+    /// @return number of copies loaded so far, including the initial one
+    unsigned int numLoads() const;
+
+protected:
+    virtual std::string _get(std::string const& key,
+                             std::string const& defaultValue,
+                             bool throwIfKeyNotFound) override;
+
+private:
+
+    struct Snapshot {
+        std::string changes;                        ///< Change counter of the store at load time
+        std::map<std::string, std::string> kvMap;   ///< All keys, the root key is ""
+        unsigned long generation = 0;               ///< Number of the copy among all loaded by this process
+    };
+
+    std::shared_ptr<Snapshot const> _current() const;
+
+    /// Load a new copy. Precondition: _storeMtx must be held.
+    void _load();
+
+    /// Use the copy saved to _cacheFile. @return false if there is none.
+    bool _loadCache();
+
+    /// Save a copy to _cacheFile, replacing the previous one at once.
+    void _saveCache(std::string const& changes, std::string const& dump) const;
+
+    void _refreshLoop(std::chrono::milliseconds refreshInterval);
+
+    std::shared_ptr<KvInterface> const _store;
+    std::string const _cacheFile;
+    std::mutex _storeMtx;   ///< Serializes the access to _store, and the loads
+
+    std::shared_ptr<Snapshot const> _snapshot;  ///< Accessed with std::atomic_load/std::atomic_store
+    std::atomic<unsigned int> _numLoads{0};
+
+    std::mutex _stopMtx;
+    std::condition_variable _stopCv;
+    bool _stop = false;
+    std::thread _refresher;
+};
+
+}}} // namespace lsst::qserv::css
+
+#endif // LSST_QSERV_CSS_KVINTERFACEIMPLSNAPSHOT_H
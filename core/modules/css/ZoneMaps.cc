@@ -0,0 +1,175 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "css/ZoneMaps.h"
+
+// System headers
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "global/stringUtil.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.css.ZoneMaps");
+
+/// @return true if all of 'str' is a number, stored in 'val'.
+bool toNumber(std::string const& str, long double& val) {
+    char* end = nullptr;
+    val = std::strtold(str.c_str(), &end);
+    return !str.empty() && *end == '\0';
+}
+
+} // annonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace css {
+
+bool ColumnRange::mayMatch(Op op, long double value) const {
+    if (!hasValues) return false;
+    long double const slack = 1e-6L * std::max(std::fabs(min), std::fabs(max));
+    long double const low = min - slack;
+    long double const high = max + slack;
+    switch (op) {
+    case EQ: return value >= low && value <= high;
+    case LT: return low < value;
+    case LE: return low <= value;
+    case GT: return high > value;
+    case GE: return high >= value;
+    }
+    return true;
+}
+
+
+int ZoneMap::read(std::istream& in) {
+    int bad = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream is(line);
+        std::vector<std::string> fields;
+        std::string field;
+        while (is >> field) {
+            fields.push_back(field);
+        }
+        char* end = nullptr;
+        if (fields.size() == 3) {
+            int const chunk = std::strtol(fields[1].c_str(), &end, 10);
+            if (*end != '\0') { ++bad; continue; }
+            int64_t const rows = std::strtoll(fields[2].c_str(), &end, 10);
+            if (*end != '\0' || rows < 0) { ++bad; continue; }
+            addRows(fields[0], chunk, rows);
+            continue;
+        }
+        if (fields.size() != 6 && fields.size() != 7) { ++bad; continue; }
+        int const chunk = std::strtol(fields[2].c_str(), &end, 10);
+        if (*end != '\0') { ++bad; continue; }
+        ColumnRange range;
+        range.nullCount = std::strtoll(fields[5].c_str(), &end, 10);
+        if (*end != '\0') { ++bad; continue; }
+        if (fields[3] == "NULL" && fields[4] == "NULL") {
+            range.hasValues = false;
+        } else if (toNumber(fields[3], range.min) && toNumber(fields[4], range.max)) {
+            range.hasValues = true;
+        } else {
+            ++bad;
+            continue;
+        }
+        if (fields.size() == 7) {
+            if (fields[6] == "NULL") {
+                range.hasSum = !range.hasValues;
+            } else {
+                range.hasSum = toNumber(fields[6], range.sum) && range.hasValues;
+            }
+            if (!range.hasSum) { ++bad; continue; }
+        }
+        add(fields[0], fields[1], chunk, range);
+    }
+    return bad;
+}
+
+
+void ZoneMap::add(std::string const& table, std::string const& column, int chunk,
+                  ColumnRange const& range) {
+    _columns[std::make_pair(table, column)][chunk] = range;
+}
+
+
+void ZoneMap::addRows(std::string const& table, int chunk, int64_t rows) {
+    _rows[table][chunk] = rows;
+}
+
+
+ZoneMap::ChunkRanges const* ZoneMap::get(std::string const& table, std::string const& column) const {
+    auto iter = _columns.find(std::make_pair(table, column));
+    return (iter == _columns.end()) ? nullptr : &iter->second;
+}
+
+
+ZoneMap::ChunkRows const* ZoneMap::getRows(std::string const& table) const {
+    auto iter = _rows.find(table);
+    return (iter == _rows.end()) ? nullptr : &iter->second;
+}
+
+
+std::shared_ptr<ZoneMap const> ZoneMaps::get(std::string const& db) const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    auto iter = _maps.find(db);
+    if (iter != _maps.end()) {
+        return iter->second;
+    }
+    auto zoneMap = std::make_shared<ZoneMap>();
+    std::string const fileName = _path + "/zonemap_" + sanitizeName(db) + ".txt";
+    std::ifstream in(fileName);
+    if (in.good()) {
+        int const bad = zoneMap->read(in);
+        LOGS(_log, LOG_LVL_DEBUG, "Read zone map for db " << db << " from file " << fileName);
+        if (bad > 0) {
+            LOGS(_log, LOG_LVL_WARN, "Skipped " << bad << " bad lines of " << fileName);
+        }
+    }
+    _maps[db] = zoneMap;
+    return zoneMap;
+}
+
+
+void ZoneMaps::clearCache(std::string const& db) const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    if (db.empty()) {
+        _maps.clear();
+    } else {
+        _maps.erase(db);
+    }
+}
+
+}}} // namespace lsst::qserv::css
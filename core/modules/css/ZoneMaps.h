@@ -0,0 +1,114 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_CSS_ZONEMAPS_H
+#define LSST_QSERV_CSS_ZONEMAPS_H
+
+// System headers
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace lsst {
+namespace qserv {
+namespace css {
+
+/// The values of a numeric column in one chunk.
+struct ColumnRange {
+    enum Op { EQ, LT, LE, GT, GE };
+
+    long double min{0};
+    long double max{0};
+    bool hasValues{false}; ///< False if every value is NULL, min and max are unset.
+    int64_t nullCount{0};
+    long double sum{0};
+    bool hasSum{false};    ///< True if sum, of the values that are not NULL, is known.
+
+    /// @return false if no value of the range is 'op' 'value'. The range is
+    ///         widened by a relative 1e-6 first, as FLOAT columns do not
+    ///         store their values exactly.
+    bool mayMatch(Op op, long double value) const;
+
+    /// @return false if no value of the range is between 'low' and 'high'.
+    bool mayMatchBetween(long double low, long double high) const {
+        return low <= high && mayMatch(GE, low) && mayMatch(LE, high);
+    }
+};
+
+/// The ranges of chosen columns of the chunked tables of a database, and
+/// the row counts of these tables, by chunk.
+class ZoneMap {
+public:
+    using Ptr = std::shared_ptr<ZoneMap>;
+    using ChunkRanges = std::map<int, ColumnRange>;
+    using ChunkRows = std::map<int, int64_t>;
+
+    /// Read lines of "<table> <column> <chunk> <min> <max> <nullCount> [<sum>]",
+    /// where min, max and sum are NULL if every value is, and lines of
+    /// "<table> <chunk> <rows>". Empty lines and lines starting with '#'
+    /// are skipped.
+    /// @return the number of lines that could not be read.
+    int read(std::istream& in);
+
+    void add(std::string const& table, std::string const& column, int chunk, ColumnRange const& range);
+    void addRows(std::string const& table, int chunk, int64_t rows);
+
+    /// @return the ranges of 'column' of 'table', nullptr if there are none.
+    ChunkRanges const* get(std::string const& table, std::string const& column) const;
+
+    /// @return the row counts of 'table', nullptr if there are none.
+    ChunkRows const* getRows(std::string const& table) const;
+
+    bool empty() const { return _columns.empty() && _rows.empty(); }
+
+private:
+    std::map<std::pair<std::string, std::string>, ChunkRanges> _columns;
+    std::map<std::string, ChunkRows> _rows;
+};
+
+/// ZoneMaps reads the zone map of each database from "zonemap_<db>.txt",
+/// in the directory of the empty chunk lists, which the data loader writes
+/// next to them, and caches it. A database without the file has an empty
+/// zone map.
+class ZoneMaps {
+public:
+    explicit ZoneMaps(std::string const& path=".") : _path(path) {}
+
+    /// @return the zone map of 'db'.
+    std::shared_ptr<ZoneMap const> get(std::string const& db) const;
+
+    /// Drop the cached zone map of 'db', or of every database if empty.
+    void clearCache(std::string const& db=std::string()) const;
+
+private:
+    std::string const _path;
+    mutable std::mutex _mtx; ///< Protects _maps.
+    mutable std::map<std::string, std::shared_ptr<ZoneMap const>> _maps;
+};
+
+}}} // namespace lsst::qserv::css
+
+#endif // LSST_QSERV_CSS_ZONEMAPS_H
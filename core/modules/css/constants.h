@@ -40,6 +40,11 @@ int const VERSION = 1; ///< Current supported version (integer)
 // conversions I define this string once and use it with kvInterface
 char const VERSION_STR[] = "1"; ///< Current supported version
 
+// Counter of the changes made to the KV store, incremented by every write
+// of KvInterfaceImplMySql. KvInterfaceImplSnapshot reloads its copy of the
+// store when it moves.
+char const CHANGES_KEY[] = "/css_meta/changes"; ///< Path to change counter
+
 // Set of values used for database and table status.
 
 /// This status means CSS data is in inconsistent state, do not use.
@@ -61,6 +61,7 @@ PYBIND11_MODULE(cssLib, mod) {
         .def("getMany", &KvInterface::getMany)
         .def("getChildren", &KvInterface::getChildren)
         .def("getChildrenValues", &KvInterface::getChildrenValues)
+        .def("getSubtree", &KvInterface::getSubtree)
         .def("deleteKey", &KvInterface::deleteKey)
         .def("dumpKV", &KvInterface::dumpKV)
         ;
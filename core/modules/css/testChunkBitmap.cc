@@ -0,0 +1,85 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Local headers
+#include "css/ChunkBitmap.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE testChunkBitmap
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::IntVector;
+using lsst::qserv::css::ChunkBitmap;
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(SetTest) {
+    ChunkBitmap bitmap;
+    BOOST_CHECK(bitmap.empty());
+    bitmap.set(0);
+    bitmap.set(63);
+    bitmap.set(64);
+    bitmap.set(1000);
+    bitmap.set(64);
+    bitmap.set(-1);
+    BOOST_CHECK_EQUAL(bitmap.count(), 4U);
+    BOOST_CHECK(bitmap.test(0));
+    BOOST_CHECK(bitmap.test(63));
+    BOOST_CHECK(bitmap.test(64));
+    BOOST_CHECK(bitmap.test(1000));
+    BOOST_CHECK(!bitmap.test(1));
+    BOOST_CHECK(!bitmap.test(999));
+    BOOST_CHECK(!bitmap.test(100000));
+    BOOST_CHECK(!bitmap.test(-1));
+    IntVector expected = {0, 63, 64, 1000};
+    IntVector chunks = bitmap.getChunks();
+    BOOST_CHECK_EQUAL_COLLECTIONS(chunks.begin(), chunks.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(AndNot) {
+    ChunkBitmap all;
+    for (int chunkId = 0; chunkId < 300; ++chunkId) {
+        all.set(chunkId);
+    }
+    ChunkBitmap empty;
+    for (int chunkId = 1; chunkId < 1000; chunkId += 2) {
+        empty.set(chunkId);
+    }
+    all.andNot(empty);
+    BOOST_CHECK_EQUAL(all.count(), 150U);
+    IntVector chunks = all.getChunks();
+    for (size_t j = 0; j < chunks.size(); ++j) {
+        BOOST_CHECK_EQUAL(chunks[j], static_cast<int>(2 * j));
+    }
+
+    // A shorter bitmap leaves the chunks past its end alone.
+    ChunkBitmap low;
+    low.set(0);
+    all.andNot(low);
+    BOOST_CHECK(!all.test(0));
+    BOOST_CHECK(all.test(298));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
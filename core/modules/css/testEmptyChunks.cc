@@ -109,14 +109,14 @@ BOOST_FIXTURE_TEST_SUITE(Suite, Fixture)
 BOOST_AUTO_TEST_CASE(Basic) {
     EmptyChunks ec(dummyFile._path, dummyFile._fallback);
     auto s = ec.getEmpty("TestOne");
-    BOOST_CHECK(s->find(3) != s->end());
-    BOOST_CHECK(s->find(103) == s->end());
-    BOOST_CHECK(s->find(1001) == s->end());
+    BOOST_CHECK(s->test(3));
+    BOOST_CHECK(!s->test(103));
+    BOOST_CHECK(!s->test(1001));
 
     s = ec.getEmpty("TestTwo");
-    BOOST_CHECK(s->find(3) == s->end());
-    BOOST_CHECK(s->find(103) != s->end());
-    BOOST_CHECK(s->find(1001) == s->end());
+    BOOST_CHECK(!s->test(3));
+    BOOST_CHECK(s->test(103));
+    BOOST_CHECK(!s->test(1001));
 
     BOOST_CHECK(ec.isEmpty("TestOne", 3));
     BOOST_CHECK(ec.isEmpty("TestTwo", 103));
@@ -31,7 +31,9 @@
 
 // System headers
 #include <algorithm> // sort
+#include <chrono>
 #include <cstddef>   // nullptr
+#include <cstdio>    // remove
 #include <cstdlib>   // rand, srand
 #include <iostream>
 #include <sstream>
@@ -43,8 +45,11 @@
 #include "boost/lexical_cast.hpp"
 
 // Qserv headers
+#include "css/constants.h"
+#include "css/CssError.h"
 #include "css/KvInterfaceImplMem.h"
 #include "css/KvInterfaceImplMySql.h"
+#include "css/KvInterfaceImplSnapshot.h"
 
 // Boost unit test header
 #define BOOST_TEST_MODULE MyTest
@@ -80,6 +85,14 @@ struct KvInterfaceFixture {
         BOOST_CHECK(v[0]=="xyzA");
         BOOST_CHECK(v[1]=="xyzB");
 
+        kvI->create(k1 + "/sub", v2);
+        std::map<std::string, std::string> subtree = kvI->getSubtree(prefix);
+        BOOST_CHECK_EQUAL(subtree.size(), 4u);
+        BOOST_CHECK_EQUAL(subtree[prefix], v1);
+        BOOST_CHECK_EQUAL(subtree[k1 + "/sub"], v2);
+        BOOST_CHECK_EQUAL(kvI->getSubtree(k2).size(), 1u);
+        BOOST_CHECK_THROW(kvI->getSubtree(k3), lsst::qserv::css::NoSuchKey);
+
         kvI->deleteKey(k1);
         BOOST_CHECK(kvI->get(k1, "xyz4") == "xyz4");
 
@@ -110,4 +123,79 @@ BOOST_AUTO_TEST_CASE(testMem) {
     doIt(new lsst::qserv::css::KvInterfaceImplMem());
 }
 
+BOOST_AUTO_TEST_CASE(testSnapshot) {
+    std::cout << "========== Testing SNAPSHOT ==========\n";
+    auto store = std::make_shared<lsst::qserv::css::KvInterfaceImplMem>();
+    doIt(new lsst::qserv::css::KvInterfaceImplSnapshot(store, std::chrono::milliseconds(0)));
+}
+
+BOOST_AUTO_TEST_CASE(testSnapshotRefresh) {
+    using lsst::qserv::css::CHANGES_KEY;
+    auto store = std::make_shared<lsst::qserv::css::KvInterfaceImplMem>();
+    store->create(k1, v1);
+    lsst::qserv::css::KvInterfaceImplSnapshot snapshot(store, std::chrono::milliseconds(0));
+    BOOST_CHECK_EQUAL(snapshot.get(k1), v1);
+    BOOST_CHECK_EQUAL(snapshot.numLoads(), 1u);
+    std::string const version = snapshot.getVersion();
+    BOOST_CHECK(not version.empty());
+    BOOST_CHECK(store->getVersion().empty());
+
+    // changes made by others are only seen once the counter moves
+    store->set(k1, v2);
+    store->create(k2, v2);
+    BOOST_CHECK(not snapshot.refresh());
+    BOOST_CHECK_EQUAL(snapshot.get(k1), v1);
+    BOOST_CHECK(not snapshot.exists(k2));
+    BOOST_CHECK_EQUAL(snapshot.getVersion(), version);
+
+    store->set(CHANGES_KEY, "1");
+    BOOST_CHECK(snapshot.refresh());
+    BOOST_CHECK_EQUAL(snapshot.numLoads(), 2u);
+    BOOST_CHECK(snapshot.getVersion() != version);
+    BOOST_CHECK_EQUAL(snapshot.get(k1), v2);
+    BOOST_CHECK_EQUAL(snapshot.getChildren(prefix).size(), 2u);
+    BOOST_CHECK(not snapshot.refresh());
+
+    // own writes are seen right away
+    snapshot.deleteKey(k2);
+    BOOST_CHECK(not snapshot.exists(k2));
+    BOOST_CHECK(not store->exists(k2));
+}
+
+BOOST_AUTO_TEST_CASE(testSnapshotCacheFile) {
+    using lsst::qserv::css::CHANGES_KEY;
+    using lsst::qserv::css::KvInterfaceImplSnapshot;
+    std::string const cacheFile = "/tmp/testKvInterfaceImpl_" + boost::lexical_cast<std::string>(rand());
+    auto store = std::make_shared<lsst::qserv::css::KvInterfaceImplMem>();
+    store->create(k1, v1);
+    store->set(CHANGES_KEY, "1");
+    {
+        KvInterfaceImplSnapshot snapshot(store, std::chrono::milliseconds(0), cacheFile);
+        BOOST_CHECK_EQUAL(snapshot.get(k1), v1);
+    }
+
+    // an unchanged store is not read again, the saved copy is used
+    store->create(k2, v2);
+    {
+        KvInterfaceImplSnapshot snapshot(store, std::chrono::milliseconds(0), cacheFile);
+        BOOST_CHECK_EQUAL(snapshot.get(k1), v1);
+        BOOST_CHECK(not snapshot.exists(k2));
+        BOOST_CHECK_EQUAL(snapshot.numLoads(), 1u);
+    }
+
+    // a changed one is, and the new copy is saved
+    store->set(CHANGES_KEY, "2");
+    {
+        KvInterfaceImplSnapshot snapshot(store, std::chrono::milliseconds(0), cacheFile);
+        BOOST_CHECK_EQUAL(snapshot.get(k2), v2);
+        BOOST_CHECK_EQUAL(snapshot.numLoads(), 2u);
+    }
+    {
+        KvInterfaceImplSnapshot snapshot(store, std::chrono::milliseconds(0), cacheFile);
+        BOOST_CHECK_EQUAL(snapshot.get(k2), v2);
+        BOOST_CHECK_EQUAL(snapshot.numLoads(), 1u);
+    }
+    std::remove(cacheFile.c_str());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
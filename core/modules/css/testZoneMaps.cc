@@ -0,0 +1,161 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// System headers
+#include <cassert>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+// Qserv headers
+#include "css/ZoneMaps.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE ZoneMaps
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::css::ColumnRange;
+using lsst::qserv::css::ZoneMap;
+using lsst::qserv::css::ZoneMaps;
+
+namespace {
+
+char const* const zoneMapText =
+    "# table column chunk min max nullCount\n"
+    "Object mag 100 12.5 20.25 0\n"
+    "Object mag 101 NULL NULL 7\n"
+    "\n"
+    "Object flags 100 -3 1e3 2\n"
+    "Object mag 102 12.5\n"
+    "Object mag 103 low high 0\n"
+    "Object mag 104 1 2 0 3.5\n"
+    "Object mag 105 NULL NULL 4 NULL\n"
+    "Object mag 106 1 2 0 NULL\n"
+    "Object 100 42\n"
+    "Object 101 x\n";
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(Read) {
+    ZoneMap zoneMap;
+    std::istringstream in(zoneMapText);
+    BOOST_CHECK_EQUAL(zoneMap.read(in), 4);
+    BOOST_CHECK(!zoneMap.empty());
+    BOOST_CHECK(zoneMap.get("Object", "ra") == nullptr);
+    BOOST_CHECK(zoneMap.get("Source", "mag") == nullptr);
+
+    auto mag = zoneMap.get("Object", "mag");
+    BOOST_REQUIRE(mag != nullptr);
+    BOOST_CHECK_EQUAL(mag->size(), 4U);
+    auto const& r100 = mag->at(100);
+    BOOST_CHECK(r100.hasValues);
+    BOOST_CHECK_EQUAL(r100.min, 12.5L);
+    BOOST_CHECK_EQUAL(r100.max, 20.25L);
+    BOOST_CHECK_EQUAL(r100.nullCount, 0);
+    auto const& r101 = mag->at(101);
+    BOOST_CHECK(!r101.hasValues);
+    BOOST_CHECK_EQUAL(r101.nullCount, 7);
+    BOOST_CHECK(!r101.hasSum);
+    BOOST_CHECK(mag->at(104).hasSum);
+    BOOST_CHECK_EQUAL(mag->at(104).sum, 3.5L);
+    BOOST_CHECK(mag->at(105).hasSum);
+    BOOST_CHECK(!mag->at(105).hasValues);
+
+    auto flags = zoneMap.get("Object", "flags");
+    BOOST_REQUIRE(flags != nullptr);
+    BOOST_CHECK_EQUAL(flags->at(100).min, -3.0L);
+    BOOST_CHECK_EQUAL(flags->at(100).max, 1000.0L);
+
+    BOOST_CHECK(zoneMap.getRows("Source") == nullptr);
+    auto rows = zoneMap.getRows("Object");
+    BOOST_REQUIRE(rows != nullptr);
+    BOOST_CHECK_EQUAL(rows->size(), 1U);
+    BOOST_CHECK_EQUAL(rows->at(100), 42);
+}
+
+BOOST_AUTO_TEST_CASE(MayMatch) {
+    ColumnRange range;
+    range.min = 10;
+    range.max = 20;
+    range.hasValues = true;
+    BOOST_CHECK(range.mayMatch(ColumnRange::EQ, 10));
+    BOOST_CHECK(range.mayMatch(ColumnRange::EQ, 15));
+    BOOST_CHECK(!range.mayMatch(ColumnRange::EQ, 21));
+    BOOST_CHECK(!range.mayMatch(ColumnRange::LT, 9));
+    BOOST_CHECK(range.mayMatch(ColumnRange::LE, 10));
+    BOOST_CHECK(!range.mayMatch(ColumnRange::GT, 21));
+    BOOST_CHECK(range.mayMatch(ColumnRange::GE, 20));
+    BOOST_CHECK(range.mayMatchBetween(5, 10));
+    BOOST_CHECK(range.mayMatchBetween(12, 13));
+    BOOST_CHECK(!range.mayMatchBetween(21, 30));
+    BOOST_CHECK(!range.mayMatchBetween(15, 12));
+
+    // FLOAT values may be off by a few ulps from the literal.
+    BOOST_CHECK(range.mayMatch(ColumnRange::GT, 20.000001L));
+    BOOST_CHECK(range.mayMatch(ColumnRange::EQ, 9.99999L));
+    BOOST_CHECK(!range.mayMatch(ColumnRange::GT, 20.001L));
+
+    // Nothing but NULLs never matches a comparison.
+    ColumnRange nulls;
+    nulls.nullCount = 3;
+    BOOST_CHECK(!nulls.mayMatch(ColumnRange::GE, -1e30L));
+    BOOST_CHECK(!nulls.mayMatchBetween(-1, 1));
+}
+
+BOOST_AUTO_TEST_CASE(Files) {
+    std::ostringstream os;
+    os << "/tmp/testZM_" << ::getpid();
+    std::string const path = os.str();
+    assert(path.find("/tmp/") == 0);
+    std::string const mkdir = "mkdir " + path;
+    ::system(mkdir.c_str());
+    {
+        std::ofstream out(path + "/zonemap_TestOne.txt");
+        out << zoneMapText;
+    }
+
+    ZoneMaps zoneMaps(path);
+    auto zoneMap = zoneMaps.get("TestOne");
+    BOOST_CHECK(zoneMap->get("Object", "mag") != nullptr);
+    BOOST_CHECK(zoneMaps.get("TestTwo")->empty());
+
+    // The cached map stays until the cache is cleared.
+    {
+        std::ofstream out(path + "/zonemap_TestTwo.txt");
+        out << "Object mag 1 0 1 0\n";
+    }
+    BOOST_CHECK(zoneMaps.get("TestTwo")->empty());
+    zoneMaps.clearCache("TestTwo");
+    BOOST_CHECK(!zoneMaps.get("TestTwo")->empty());
+    BOOST_CHECK(zoneMaps.get("TestOne") == zoneMap);
+
+    std::string const rmdir = "rm -r " + path;
+    ::system(rmdir.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
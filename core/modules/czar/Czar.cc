@@ -24,6 +24,9 @@
 #include "czar/Czar.h"
 
 // System headers
+#include <algorithm>
+#include <chrono>
+#include <sstream>
 #include <sys/time.h>
 #include <thread>
 
@@ -36,12 +39,18 @@
 
 // Qserv headers
 #include "ccontrol/ConfigMap.h"
+#include "ccontrol/MergeBufferPool.h"
 #include "ccontrol/UserQueryType.h"
 #include "czar/CzarErrors.h"
 #include "czar/MessageTable.h"
+#include "qdisp/MessageStore.h"
 #include "rproc/InfileMerger.h"
 #include "sql/SqlConnection.h"
 #include "util/IterableFormatter.h"
+#include "util/Metrics.h"
+#include "util/Profiler.h"
+#include "util/RingAppender.h"
+#include "util/Trace.h"
 #include "XrdSsi/XrdSsiProvider.hh"
 
 
@@ -59,6 +68,17 @@ std::string const createAsyncResultTmpl("CREATE TABLE IF NOT EXISTS %1% "
 
 LOG_LOGGER _log = LOG_GET("lsst.qserv.czar.Czar");
 
+// Time a component waits for a result database connection before it is
+// given one beyond the configured number.
+#define RESULT_DB_MAX_WAIT_MSECS 10000
+// Idle result database connections are checked before reuse after this long.
+#define RESULT_DB_CHECK_IDLE_SECS 60
+
+/// @return the milliseconds elapsed since 'start'.
+double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
 } // anonymous namespace
 
 namespace lsst {
@@ -85,6 +105,7 @@ Czar::Czar(std::string const& configPath, std::string const& czarName)
 
     std::string logConfig = _czarConfig.getLogConfig();
     if (not logConfig.empty()) {
+        util::RingAppender::registerClass();
         LOG_CONFIG(logConfig);
     }
 
@@ -93,6 +114,10 @@ Czar::Czar(std::string const& configPath, std::string const& czarName)
     LOGS(_log, LOG_LVL_INFO, "config largeResultConcurrent=" << largeResultConcurrent);
     _qdispPool = std::make_shared<qdisp::QdispPool>(); // TODO:configuration add to configuration
 
+    int mergeBufferPoolMB = std::max(0, _czarConfig.getMergeBufferPoolMB());
+    LOGS(_log, LOG_LVL_INFO, "config mergeBufferPoolMB=" << mergeBufferPoolMB);
+    ccontrol::MergeBufferPool::instance().setMaxBytes(static_cast<uint64_t>(mergeBufferPoolMB) * 1024 * 1024);
+
     int xrootdCBThreadsMax = _czarConfig.getXrootdCBThreadsMax();
     int xrootdCBThreadsInit = _czarConfig.getXrootdCBThreadsInit();
     LOGS(_log, LOG_LVL_INFO, "config xrootdCBThreadsMax=" << xrootdCBThreadsMax);
@@ -102,7 +127,104 @@ Czar::Czar(std::string const& configPath, std::string const& czarName)
     LOGS(_log, LOG_LVL_INFO, "Creating czar instance with name " << czarName);
     LOGS(_log, LOG_LVL_DEBUG, "Czar config: " << _czarConfig);
 
-    _uqFactory.reset(new ccontrol::UserQueryFactory(_czarConfig, _czarName));
+    // Connections to the result database are shared by all components.
+    _resultDbPool = sql::SqlConnectionPool::create(_czarConfig.getMySqlResultConfig(),
+                        std::max(1, _czarConfig.getResultDbMaxConnections()),
+                        std::chrono::milliseconds(RESULT_DB_MAX_WAIT_MSECS),
+                        std::chrono::seconds(RESULT_DB_CHECK_IDLE_SECS));
+
+    _uqFactory.reset(new ccontrol::UserQueryFactory(_czarConfig, _czarName, _resultDbPool));
+
+    std::weak_ptr<sql::SqlConnectionPool> weakPool(_resultDbPool);
+    util::MetricsRegistry::get().addCollector("czar", [weakPool](std::ostream& os) {
+        using util::MetricsRegistry;
+        auto pool = weakPool.lock();
+        if (pool != nullptr) {
+            auto const stats = pool->getStats();
+            MetricsRegistry::writeHeader(os, "qserv_czar_resultdb_connections", "gauge",
+                                         "Connections to the result database");
+            MetricsRegistry::writeValue(os, "qserv_czar_resultdb_connections", "state=\"idle\"", stats.idle);
+            MetricsRegistry::writeValue(os, "qserv_czar_resultdb_connections", "state=\"inuse\"", stats.inUse);
+            MetricsRegistry::writeHeader(os, "qserv_czar_resultdb_leases_total", "counter",
+                                         "Connections leased from the result database pool");
+            MetricsRegistry::writeHeader(os, "qserv_czar_resultdb_wait_seconds_total", "counter",
+                                         "Time spent waiting for a result database connection");
+            for (auto const& elem : stats.purposes) {
+                std::string const labels = "purpose=\"" + MetricsRegistry::escapeLabel(elem.first) + "\"";
+                MetricsRegistry::writeValue(os, "qserv_czar_resultdb_leases_total", labels, elem.second.leases);
+                MetricsRegistry::writeValue(os, "qserv_czar_resultdb_wait_seconds_total", labels,
+                                            elem.second.waitMs/1000.0);
+            }
+        }
+        auto const& bufferPool = ccontrol::MergeBufferPool::instance();
+        MetricsRegistry::writeHeader(os, "qserv_czar_merge_buffer_bytes", "gauge", "Merge buffer memory");
+        MetricsRegistry::writeValue(os, "qserv_czar_merge_buffer_bytes", "state=\"inuse\"",
+                                    bufferPool.getInUseBytes());
+        MetricsRegistry::writeValue(os, "qserv_czar_merge_buffer_bytes", "state=\"idle\"",
+                                    bufferPool.getIdleBytes());
+    });
+
+    util::QueryTrace::setTraceFile(_czarConfig.getTraceFile());
+
+    if (not _czarConfig.getCaptureFile().empty()) {
+        _capture.reset(new WorkloadCapture(_czarConfig.getCaptureFile(), _czarConfig.getCaptureTiming()));
+    }
+
+    int const metricsPort = _czarConfig.getMetricsPort();
+    if (metricsPort > 0) {
+        _startMetricsServer(metricsPort);
+    }
+}
+
+
+Czar::~Czar() {
+    util::MetricsRegistry::get().removeCollector("czar");
+    if (_metricsServer != nullptr) {
+        _metricsIoService.stop();
+        _metricsThread.join();
+    }
+}
+
+
+void Czar::_startMetricsServer(unsigned short port) {
+    _metricsServer = qhttp::Server::create(_metricsIoService, port);
+    _metricsServer->addHandler("GET", "/metrics", [](qhttp::Request::Ptr, qhttp::Response::Ptr resp) {
+        std::ostringstream os;
+        util::MetricsRegistry::get().write(os);
+        resp->send(os.str(), "text/plain; version=0.0.4");
+    });
+    // GET /profile?seconds=10&hz=99 samples the stacks of the czar threads, see
+    // util::Profiler. The profile runs on its own thread, the response is sent from
+    // the one of the server.
+    _metricsServer->addHandler("GET", "/profile", [this](qhttp::Request::Ptr req, qhttp::Response::Ptr resp) {
+        unsigned long seconds = 10;
+        unsigned long hz = 99;
+        try {
+            auto itr = req->query.find("seconds");
+            if (itr != req->query.end()) seconds = std::stoul(itr->second);
+            itr = req->query.find("hz");
+            if (itr != req->query.end()) hz = std::stoul(itr->second);
+        } catch (std::exception const&) {
+            resp->sendStatus(400);
+            return;
+        }
+        std::thread([this, resp, seconds, hz]() {
+            std::string folded;
+            std::string error;
+            bool const ok = util::Profiler::profile(std::chrono::seconds(seconds), hz, folded, error);
+            _metricsIoService.post([resp, ok, folded, error]() {
+                if (!ok) {
+                    resp->status = 409;
+                    resp->send(error + "\n", "text/plain");
+                    return;
+                }
+                resp->send(folded, "text/plain");
+            });
+        }).detach();
+    });
+    _metricsServer->start();
+    LOGS(_log, LOG_LVL_INFO, "serving metrics on port " << _metricsServer->getPort());
+    _metricsThread = std::thread([this]() { _metricsIoService.run(); });
 }
 
 SubmitResult
@@ -111,6 +233,7 @@ Czar::submitQuery(std::string const& query,
 
     LOGS(_log, LOG_LVL_INFO, "New query: " << query
          << ", hints: " << util::printable(hints));
+    auto const submitTime = std::chrono::steady_clock::now();
 
     util::ConfigStore hintsConfigStore(hints);
 
@@ -128,6 +251,7 @@ Czar::submitQuery(std::string const& query,
     // make message table name
     std::string userQueryId = std::to_string(_idCounter++);
     LOGS(_log, LOG_LVL_DEBUG, "userQueryId: " << userQueryId);
+    if (_capture) _capture->submitted(userQueryId, query, hints);
     std::string resultDb = _czarConfig.getMySqlResultConfig().dbName;
     std::string const msgTableName = "message_" + userQueryId;
     std::string const lockName = resultDb + "." + msgTableName;
@@ -135,11 +259,12 @@ Czar::submitQuery(std::string const& query,
     SubmitResult result;
 
     // instantiate message table manager
-    MessageTable msgTable(lockName, _czarConfig.getMySqlResultConfig());
+    MessageTable msgTable(lockName, _resultDbPool);
     try {
         msgTable.lock();
     } catch (std::exception const& exc) {
         result.errorMessage = exc.what();
+        if (_capture) _capture->completed(userQueryId, false, WorkloadCapture::Timing());
         return result;
     }
 
@@ -152,20 +277,41 @@ Czar::submitQuery(std::string const& query,
         uq = _uqFactory->newUserQuery(query, defaultDb, getQdispPool(), userQueryId, msgTableName);
     }
     auto queryIdStr = uq->getQueryIdString();
+    WorkloadCapture::Timing timing;
+    timing.planMs = msSince(submitTime);
 
     // check for errors
     auto error = uq->getError();
     if (not error.empty()) {
         result.errorMessage = queryIdStr + " Failed to instantiate query: " + error;
+        if (_capture) _capture->completed(userQueryId, false, timing);
         return result;
     }
 
+    // messages of failing chunks go to the table while the query runs
+    msgTable.startWriting(uq);
+
+    // the proxy may wait for a synchronous query to complete, see waitQuery()
+    bool const notify = not uq->isAsync();
+    if (notify) {
+        std::lock_guard<std::mutex> lock(_completionMutex);
+        _completions[lockName] = Completion::PENDING;
+    }
+
     // spawn background thread to wait until query finishes to unlock,
     // note that lambda stores copies of uq and msgTable.
-    auto finalizer = [uq, msgTable]() mutable {
+    auto finalizer = [this, uq, msgTable, lockName, notify, userQueryId, timing]() mutable {
         LOGS(_log, LOG_LVL_DEBUG, uq->getQueryIdString() << " submitting new query");
+        auto const execTime = std::chrono::steady_clock::now();
         uq->submit();
         uq->join();
+        timing.execMs = msSince(execTime);
+        auto const finalizeTime = std::chrono::steady_clock::now();
+        bool success = true;
+        auto msgStore = uq->getMessageStore();
+        for (int i = 0; i != msgStore->messageCount(); ++i) {
+            if (msgStore->getMessage(i).severity == MSG_ERROR) success = false;
+        }
         try {
             msgTable.unlock(uq);
             if (uq) uq->discard();
@@ -174,7 +320,11 @@ Czar::submitQuery(std::string const& query,
             // will likely hang because table may still be locked.
             LOGS(_log, LOG_LVL_ERROR, uq->getQueryIdString()
                  << " Query finalization failed (client likely hangs): " << exc.what());
+            success = false;
         }
+        timing.finalizeMs = msSince(finalizeTime);
+        if (_capture) _capture->completed(userQueryId, success, timing);
+        if (notify) _completeQuery(lockName, success);
     };
     LOGS(_log, LOG_LVL_DEBUG, queryIdStr << " starting finalizer thread for query");
     std::thread finalThread(finalizer);
@@ -190,7 +340,7 @@ Czar::submitQuery(std::string const& query,
         // we do not need to lock message because result is ready before we return
         std::string const resultTableName = resultDb + ".result_async_" + userQueryId;
         std::string const asyncLockName = resultDb + ".message_async_" + userQueryId;
-        MessageTable msgTable(asyncLockName, _czarConfig.getMySqlResultConfig());
+        MessageTable msgTable(asyncLockName, _resultDbPool);
         try {
             _makeAsyncResult(resultTableName, uq->getQueryId(), uq->getResultLocation());
             msgTable.create();
@@ -209,11 +359,12 @@ Czar::submitQuery(std::string const& query,
         }
         result.messageTable = lockName;
         result.orderBy = uq->getProxyOrderBy();
+        result.dropResult = not uq->isResultCached();
 
     }
     LOGS(_log, LOG_LVL_DEBUG, queryIdStr << " returning result to proxy: resultTable="
          << result.resultTable << " messageTable=" << result.messageTable
-         << " orderBy=" << result.orderBy);
+         << " orderBy=" << result.orderBy << " dropResult=" << result.dropResult);
 
     return result;
 }
@@ -301,6 +452,55 @@ Czar::_cleanupQueryHistoryLocked() {
     }
 }
 
+bool
+Czar::waitQuery(std::string const& messageTable) {
+
+    auto const wait = std::chrono::milliseconds(std::max(0, _czarConfig.getProxyCompletionWaitMs()));
+    std::unique_lock<std::mutex> lock(_completionMutex);
+    auto iter = _completions.find(messageTable);
+    if (iter == _completions.end()) {
+        return false;
+    }
+    _completionCv.wait_for(lock, wait, [&iter]() { return iter->second != Completion::PENDING; });
+    if (iter->second == Completion::PENDING) {
+        // the proxy now waits for the message table lock, nobody waits here
+        iter->second = Completion::ABANDONED;
+        return false;
+    }
+    bool const success = iter->second == Completion::SUCCESS;
+    _completions.erase(iter);
+    lock.unlock();
+
+    if (success) {
+        // the proxy does not read the messages, drop them in the background
+        LOGS(_log, LOG_LVL_DEBUG, messageTable << " completed, results are read right away");
+        MessageTable msgTable(messageTable, _resultDbPool);
+        std::thread([msgTable]() mutable {
+            try {
+                msgTable.drop();
+            } catch (std::exception const& exc) {
+                LOGS(_log, LOG_LVL_WARN, "Failed to drop message table: " << exc.what());
+            }
+        }).detach();
+    }
+    return success;
+}
+
+void
+Czar::_completeQuery(std::string const& messageTable, bool success) {
+    std::lock_guard<std::mutex> lock(_completionMutex);
+    auto iter = _completions.find(messageTable);
+    if (iter == _completions.end()) {
+        return;
+    }
+    if (iter->second == Completion::ABANDONED) {
+        _completions.erase(iter);
+        return;
+    }
+    iter->second = success ? Completion::SUCCESS : Completion::FAILED;
+    _completionCv.notify_all();
+}
+
 void
 Czar::_cleanupQueryHistory() {
     std::lock_guard<std::mutex> lock(_mutex);
@@ -338,12 +538,17 @@ Czar::_makeAsyncResult(std::string const& asyncResultTable,
                        QueryId queryId,
                        std::string const& resultLoc) {
 
-    sql::SqlConnection sqlConn(_czarConfig.getMySqlResultConfig());
     LOGS(_log, LOG_LVL_DEBUG, "creating async result table " << asyncResultTable);
 
     sql::SqlErrorObject sqlErr;
+    auto sqlConn = _resultDbPool->acquire("asyncResult", sqlErr);
+    if (sqlConn == nullptr) {
+        SqlError exc(ERR_LOC, "Failure connecting to result database", sqlErr);
+        LOGS(_log, LOG_LVL_ERROR, exc.message());
+        throw exc;
+    }
     std::string resultLocEscaped;
-    if (not sqlConn.escapeString(resultLoc, resultLocEscaped,sqlErr)) {
+    if (not sqlConn->escapeString(resultLoc, resultLocEscaped,sqlErr)) {
         SqlError exc(ERR_LOC, "Failure in escapString", sqlErr);
         LOGS(_log, LOG_LVL_ERROR, exc.message());
         throw exc;
@@ -352,7 +557,7 @@ Czar::_makeAsyncResult(std::string const& asyncResultTable,
     std::string query = (boost::format(::createAsyncResultTmpl)
                     % asyncResultTable % queryId % resultLocEscaped).str();
 
-    if (not sqlConn.runQuery(query, sqlErr)) {
+    if (not sqlConn->runQuery(query, sqlErr)) {
         SqlError exc(ERR_LOC, "Failure creating async result table", sqlErr);
         LOGS(_log, LOG_LVL_ERROR, exc.message());
         throw exc;
@@ -24,13 +24,19 @@
 
 // System headers
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
+// Third-party headers
+#include <boost/asio.hpp>
+
 #include "qdisp/QdispPool.h"
 // Third-party headers
 
@@ -39,8 +45,11 @@
 #include "ccontrol/UserQueryFactory.h"
 #include "czar/CzarConfig.h"
 #include "czar/SubmitResult.h"
+#include "czar/WorkloadCapture.h"
 #include "global/stringTypes.h"
 #include "mysql/MySqlConfig.h"
+#include "qhttp/Server.h"
+#include "sql/SqlConnectionPool.h"
 #include "util/ConfigStore.h"
 
 namespace lsst {
@@ -63,6 +72,8 @@ public:
     Czar(Czar const&) = delete;
     Czar& operator=(Czar const&) = delete;
 
+    ~Czar();
+
     /**
      * Submit query for execution.
      *
@@ -83,6 +94,19 @@ public:
      */
     void killQuery(std::string const& query, std::string const& clientId);
 
+    /**
+     * Wait for a query returned by submitQuery() to complete, for at most
+     * the configured proxy completion wait.
+     *
+     * A query that completed without errors by then has its message table
+     * dropped, only its result table is left to read. Otherwise its message
+     * table must be read and dropped once unlocked, as before.
+     *
+     * @param messageTable: Message table returned by submitQuery().
+     * @return true if the query completed without errors.
+     */
+    bool waitQuery(std::string const& messageTable);
+
     /**
      * Make new instance.
      *
@@ -111,6 +135,9 @@ private:
     /// Private constructor for singleton.
     Czar(std::string const& configPath, std::string const& czarName);
 
+    /// Serve the metrics of the czar at /metrics on 'port'.
+    void _startMetricsServer(unsigned short port);
+
     /// Clean query maps from expired entries, _mutex must be locked
     void _cleanupQueryHistoryLocked();
 
@@ -122,6 +149,10 @@ private:
                              int threadId,
                              ccontrol::UserQuery::Ptr const& uq);
 
+    /// Record the completion of the query using 'messageTable', once its
+    /// messages are saved and the table is unlocked.
+    void _completeQuery(std::string const& messageTable, bool success);
+
     /// Create and fill async result table
     void _makeAsyncResult(std::string const& asyncResultTable,
                           QueryId queryId,
@@ -138,12 +169,25 @@ private:
     CzarConfig const _czarConfig;
 
     std::atomic<uint64_t> _idCounter;   ///< Query/task identifier for next query
+    sql::SqlConnectionPool::Ptr _resultDbPool; ///< Connections to the result database
     std::unique_ptr<ccontrol::UserQueryFactory> _uqFactory;
     ClientToQuery _clientToQuery;       ///< maps client ID to query
     IdToQuery _idToQuery;               ///< maps query ID to query (for currently running queries)
     std::mutex _mutex;                  ///< protects _uqFactory, _clientToQuery, and _idToQuery
 
     qdisp::QdispPool::Ptr _qdispPool; ///< Thread pool for handling Responses from XrdSsi.
+
+    std::unique_ptr<WorkloadCapture> _capture; ///< Records the user queries, if set.
+
+    /// State of a query the proxy may call waitQuery() for.
+    enum class Completion { PENDING, SUCCESS, FAILED, ABANDONED };
+    std::map<std::string, Completion> _completions; ///< Keyed by message table
+    std::mutex _completionMutex;                    ///< protects _completions
+    std::condition_variable _completionCv;
+
+    boost::asio::io_service _metricsIoService; ///< Runs the metrics HTTP server.
+    qhttp::Server::Ptr _metricsServer;
+    std::thread _metricsThread;
 };
 
 }}} // namespace lsst::qserv::czar
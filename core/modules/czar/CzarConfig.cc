@@ -87,11 +87,58 @@ CzarConfig::CzarConfig(util::ConfigStore const& configStore)
                               configStore.get("qstatus.db", "qservStatusData")),
       _xrootdFrontendUrl(configStore.get("frontend.xrootd", "localhost:1094")),
       _emptyChunkPath(configStore.get("partitioner.emptyChunkPath", ".")),
+      _secondaryIndexPath(configStore.get("partitioner.secondaryIndexPath")),
       _largeResultConcurrentMerges(configStore.getInt("tuning.largeResultConcurrentMerges", 3)),
+      _mergeShards(configStore.getInt("tuning.mergeShards", 1)),
+      _aggMaxGroups(configStore.getInt("tuning.aggMaxGroups", 100000)),
+      _workerAggFold(configStore.getInt("tuning.workerAggFold", 1)),
+      _semiJoinMaxKeys(configStore.getInt("tuning.semiJoinMaxKeys", 0)),
+      _topKMaxRows(configStore.getInt("tuning.topKMaxRows", 100000)),
+      _sortedRunDir(configStore.get("tuning.sortedRunDir", "/tmp")),
+      _passThroughMemoryTableMB(configStore.getInt("tuning.passThroughMemoryTableMB", 64)),
+      _mergeJobIdPartitions(configStore.getInt("tuning.mergeJobIdPartitions", 16)),
+      _resultSink(configStore.get("tuning.resultSink", "mysql")),
+      _resultSinkDir(configStore.get("tuning.resultSinkDir", "/tmp")),
+      _resultSinkMemoryMB(configStore.getInt("tuning.resultSinkMemoryMB", 256)),
+      _mergeBufferPoolMB(configStore.getInt("tuning.mergeBufferPoolMB", 512)),
+      _selectStmtCacheSize(configStore.getInt("tuning.selectStmtCacheSize", 1000)),
+      _resultCacheMB(configStore.getInt("tuning.resultCacheMB", 0)),
+      _resultCacheEntryMB(configStore.getInt("tuning.resultCacheEntryMB", 100)),
+      _resultCacheTtlSecs(configStore.getInt("tuning.resultCacheTtlSecs", 300)),
+      _secondaryIndexCacheSize(configStore.getInt("tuning.secondaryIndexCacheSize", 100000)),
+      _maxQueryCost(configStore.getInt("tuning.maxQueryCost", 0)),
+      _interactiveDeadlineMs(configStore.getInt("tuning.interactiveDeadlineMs", 10000)),
+      _admissionMaxInteractive(configStore.getInt("tuning.admissionMaxInteractive", 0)),
+      _admissionMaxScan(configStore.getInt("tuning.admissionMaxScan", 0)),
+      _admissionMaxAsync(configStore.getInt("tuning.admissionMaxAsync", 0)),
+      _admissionMaxQueued(configStore.getInt("tuning.admissionMaxQueued", 1000)),
+      _admissionMaxWaitSecs(configStore.getInt("tuning.admissionMaxWaitSecs", 600)),
+      _admissionMaxRunningJobs(configStore.getInt("tuning.admissionMaxRunningJobs", 0)),
+      _admissionMaxRunningCost(configStore.getInt("tuning.admissionMaxRunningCost", 0)),
+      _clusterMaxRunningJobs(configStore.getInt("tuning.clusterMaxRunningJobs", 0)),
+      _czarLoadPeriodSecs(configStore.getInt("tuning.czarLoadPeriodSecs", 5)),
       _xrootdCBThreadsMax(configStore.getInt("tuning.xrootdCBThreadsMax", 500)),
       _xrootdCBThreadsInit(configStore.getInt("tuning.xrootdCBThreadsInit", 50)),
       _qMetaSecsBetweenChunkCompletionUpdates(configStore.getInt(
-                                               "tuning.qMetaSecsBetweenChunkCompletionUpdates", 60)) {
+                                               "tuning.qMetaSecsBetweenChunkCompletionUpdates", 60)),
+      _stragglerPercentile(configStore.getInt("tuning.stragglerPercentile", 95)),
+      _stragglerFactor(configStore.getInt("tuning.stragglerFactor", 3)),
+      _scanAffinityOrder(configStore.getInt("tuning.scanAffinityOrder", 1)),
+      _maxResponseReads(configStore.getInt("tuning.maxResponseReads", 64)),
+      _replicaSelection(configStore.getInt("tuning.replicaSelection", 0)),
+      _replicaCheckSecs(configStore.getInt("tuning.replicaCheckSecs", 30)),
+      _workerKeepAliveSecs(configStore.getInt("tuning.workerKeepAliveSecs", 240)),
+      _qMetaMaxBatchRows(configStore.getInt("tuning.qMetaMaxBatchRows", 1000)),
+      _qMetaQueueSize(configStore.getInt("tuning.qMetaQueueSize", 10000)),
+      _qMetaQueueMaxRetries(configStore.getInt("tuning.qMetaQueueMaxRetries", 5)),
+      _qMetaProgressFlushSecs(configStore.getInt("tuning.qMetaProgressFlushSecs", 10)),
+      _proxyCompletionWaitMs(configStore.getInt("tuning.proxyCompletionWaitMs", 0)),
+      _resultDbMaxConnections(configStore.getInt("resultdb.maxconnections", 100)),
+      _metricsPort(configStore.getInt("metrics.port", 0)),
+      _traceSampleEvery(configStore.getInt("metrics.traceSampleEvery", 0)),
+      _traceFile(configStore.get("metrics.traceFile", "")),
+      _captureFile(configStore.get("capture.file", "")),
+      _captureTiming(configStore.getInt("capture.timing", 1)) {
 }
 
 std::ostream& operator<<(std::ostream &out, CzarConfig const& czarConfig) {
@@ -69,6 +69,57 @@ public:
         return _mySqlResultConfig;
     }
 
+    /* Get the number of connections to the czar result database shared by
+     * the czar components.
+     *
+     * @return the number of connections
+     */
+    int getResultDbMaxConnections() const {
+        return _resultDbMaxConnections;
+    }
+
+    /* Get the port of the HTTP server exporting the czar metrics
+     *
+     * @return the port, 0 if metrics are not exported.
+     */
+    int getMetricsPort() const {
+        return _metricsPort;
+    }
+
+    /* Get how often user queries are traced, one out of every N queries
+     * records the time spent in each stage on the czar and the workers.
+     *
+     * @return N, 0 if no query is traced.
+     */
+    int getTraceSampleEvery() const {
+        return _traceSampleEvery;
+    }
+
+    /* Get the file the traces of traced queries are appended to, one JSON
+     * object per line.
+     *
+     * @return the path, empty if traces are only logged.
+     */
+    std::string const& getTraceFile() const {
+        return _traceFile;
+    }
+
+    /* Get the file the workload of the czar is captured in, the text, hints
+     * and submission time of every user query, for qserv-replay.py.
+     *
+     * @return the path, empty if the workload is not captured.
+     */
+    std::string const& getCaptureFile() const {
+        return _captureFile;
+    }
+
+    /* @return true if the completion and time spent in each stage of the
+     * captured queries is captured too.
+     */
+    bool getCaptureTiming() const {
+        return _captureTiming != 0;
+    }
+
     std::string const& getLogConfig() const {
         return _logConfig;
     }
@@ -110,6 +161,18 @@ public:
         return _emptyChunkPath;
     }
 
+    /* Get the path to the secondary index files
+     *
+     * Each file holds the secondary index of one director table, for the
+     * tables without one the index in qservMeta is used.
+     *
+     * @return path to directory where the secondary index files reside,
+     *         empty if qservMeta holds all secondary indexes
+     */
+    std::string const& getSecondaryIndexPath() const {
+        return _secondaryIndexPath;
+    }
+
     /* Get hostname and port for xrootd manager
      *
      * "localhost:1094" is the most reasonable default, even though it is
@@ -129,6 +192,231 @@ public:
          return _largeResultConcurrentMerges;
     }
 
+    /* Get the number of shard tables each result merge loads into in parallel.
+     *
+     * @return the number of merge shard tables, 1 loads into a single table.
+     */
+    int getMergeShards() const {
+        return _mergeShards;
+    }
+
+    /* Get the maximum number of groups to fold aggregates for in memory.
+     *
+     * @return the maximum number of groups, 0 disables in-memory folding.
+     */
+    int getAggMaxGroups() const {
+        return _aggMaxGroups;
+    }
+
+    /* Get whether the workers are asked to fold the partial aggregates of
+     * the chunks of a query into one result.
+     *
+     * @return true to ask the workers, the jobs of these queries are then
+     *         never retried.
+     */
+    bool getWorkerAggFold() const {
+        return _workerAggFold != 0;
+    }
+
+    /* Get the number of keys the selective side of a join may have for the
+     * join to be run as a semi-join, restricted to these keys.
+     *
+     * @return the maximum number of keys, 0 never runs semi-joins.
+     */
+    int getSemiJoinMaxKeys() const {
+        return _semiJoinMaxKeys;
+    }
+
+    /* Get the largest LIMIT of an ORDER BY ... LIMIT query whose rows are ranked in memory.
+     *
+     * @return the maximum number of rows, 0 always loads every row.
+     */
+    int getTopKMaxRows() const {
+        return _topKMaxRows;
+    }
+
+    /* Get the directory of the sorted chunk results of ORDER BY queries waiting to be merged.
+     *
+     * @return the directory, empty sorts the result table instead.
+     */
+    std::string const& getSortedRunDir() const {
+        return _sortedRunDir;
+    }
+
+    /* Get the size up to which results needing no merge step are kept in memory.
+     *
+     * @return the size in MB, 0 always writes these results to disk.
+     */
+    int getPassThroughMemoryTableMB() const {
+        return _passThroughMemoryTableMB;
+    }
+
+    /* Get the number of partitions, by job attempt, of a merge table on disk.
+     *
+     * @return the number of partitions, 0 or 1 does not partition merge tables.
+     */
+    int getMergeJobIdPartitions() const {
+        return _mergeJobIdPartitions;
+    }
+
+    /* Get where result rows are stored until the merge step.
+     *
+     * @return "mysql" to load them into the result table as they arrive,
+     *         "columnar" to hold them on the czar until every chunk is in.
+     */
+    std::string const& getResultSink() const {
+        return _resultSink;
+    }
+
+    /* Get the directory of the rows a columnar result sink holds past its memory limit.
+     *
+     * @return the directory, empty always uses the mysql result sink.
+     */
+    std::string const& getResultSinkDir() const {
+        return _resultSinkDir;
+    }
+
+    /* Get the memory a columnar result sink may hold rows in before writing them to disk.
+     *
+     * @return the size in MB.
+     */
+    int getResultSinkMemoryMB() const {
+        return _resultSinkMemoryMB;
+    }
+
+    /* Get the cap on memory held by the pool of result message buffers.
+     *
+     * @return the cap in MB, 0 disables keeping idle buffers.
+     */
+    int getMergeBufferPoolMB() const {
+        return _mergeBufferPoolMB;
+    }
+
+    /* Get the number of parsed SELECT statements kept for queries sent again.
+     *
+     * @return the number of statements, 0 disables the cache.
+     */
+    int getSelectStmtCacheSize() const {
+        return _selectStmtCacheSize;
+    }
+
+    /* Get the size of the result tables kept to answer identical SELECT queries.
+     *
+     * @return the size in MB, 0 disables the cache.
+     */
+    int getResultCacheMB() const {
+        return _resultCacheMB;
+    }
+
+    /* Get the size above which a result table is not kept by the result cache.
+     *
+     * @return the size in MB.
+     */
+    int getResultCacheEntryMB() const {
+        return _resultCacheEntryMB;
+    }
+
+    /* Get the time a result table kept by the result cache answers queries.
+     *
+     * @return the time in seconds.
+     */
+    int getResultCacheTtlSecs() const {
+        return _resultCacheTtlSecs;
+    }
+
+    /* Get the number of director keys whose chunk and subchunk are kept
+     * after a secondary index lookup.
+     *
+     * @return the number of keys, 0 disables the cache.
+     */
+    int getSecondaryIndexCacheSize() const {
+        return _secondaryIndexCacheSize;
+    }
+
+    /* Get the highest estimated cost of a query that is accepted, in full
+     * chunk scans of the fastest tables.
+     *
+     * @return the cost, 0 accepts every query.
+     */
+    int getMaxQueryCost() const {
+        return _maxQueryCost;
+    }
+
+    /* Get the time the workers are given to run each task of an interactive
+     * query.
+     *
+     * @return the deadline in milliseconds, 0 sends no deadline.
+     */
+    int getInteractiveDeadlineMs() const {
+        return _interactiveDeadlineMs;
+    }
+
+    /* Get the number of interactive, scan and async queries that may run at once.
+     *
+     * @return the number of queries, 0 for no limit.
+     */
+    int getAdmissionMaxInteractive() const {
+        return _admissionMaxInteractive;
+    }
+    int getAdmissionMaxScan() const {
+        return _admissionMaxScan;
+    }
+    int getAdmissionMaxAsync() const {
+        return _admissionMaxAsync;
+    }
+
+    /* Get the number of queries of a class that may wait to start.
+     *
+     * @return the number of queries.
+     */
+    int getAdmissionMaxQueued() const {
+        return _admissionMaxQueued;
+    }
+
+    /* Get the time a query may wait to start before it is rejected.
+     *
+     * @return the time in seconds.
+     */
+    int getAdmissionMaxWaitSecs() const {
+        return _admissionMaxWaitSecs;
+    }
+
+    /* Get the number of chunk jobs of running scan and async queries above
+     * which another one waits to start.
+     *
+     * @return the number of jobs, 0 for no limit.
+     */
+    int getAdmissionMaxRunningJobs() const {
+        return _admissionMaxRunningJobs;
+    }
+
+    /* Get the estimated cost of running scan and async queries above which
+     * another one waits to start.
+     *
+     * @return the cost, 0 for no limit.
+     */
+    int getAdmissionMaxRunningCost() const {
+        return _admissionMaxRunningCost;
+    }
+
+    /* Get the number of chunk jobs of running scan and async queries that
+     * all the czars together may have, shared between them by demand.
+     *
+     * @return the number of jobs, 0 for no cluster-wide limit.
+     */
+    int getClusterMaxRunningJobs() const {
+        return _clusterMaxRunningJobs;
+    }
+
+    /* Get the time between two updates of the load this czar advertises in
+     * QMeta, and of its share of the cluster-wide job budget.
+     *
+     * @return the time in seconds, 0 to not advertise the load.
+     */
+    int getCzarLoadPeriodSecs() const {
+        return _czarLoadPeriodSecs;
+    }
+
     /* Get the maximum number of threads for xrootd to use.
      *
      * @return the maximum number of threads for xrootd to use.
@@ -152,6 +440,111 @@ public:
     int getQMetaSecondsBetweenChunkUpdates() const {
         return _qMetaSecsBetweenChunkCompletionUpdates;
     }
+
+    /* Get the percentile of completed job run times that straggling jobs are compared to.
+     *
+     * @return the percentile, 0 never runs straggling jobs again.
+     */
+    int getStragglerPercentile() const {
+        return _stragglerPercentile;
+    }
+
+    /* Get how many times that percentile a job must run to be a straggler.
+     *
+     * @return the factor.
+     */
+    int getStragglerFactor() const {
+        return _stragglerFactor;
+    }
+
+    /* Get whether the jobs of scan queries are sent in the order the worker
+     * scans will reach their chunks, instead of chunk id order.
+     *
+     * @return true to order the jobs by the worker scan cursors.
+     */
+    bool getScanAffinityOrder() const {
+        return _scanAffinityOrder != 0;
+    }
+
+    /* Get the maximum number of response buffers of a query that may be
+     * read from the workers or merged at once.
+     *
+     * @return the number of buffers, 0 means no limit.
+     */
+    int getMaxResponseReads() const {
+        return _maxResponseReads;
+    }
+
+    /* Get whether the czar picks the worker of each job among the replicas
+     * of its chunk, instead of leaving it to the xrootd redirector.
+     *
+     * @return true to send jobs to the least loaded replica.
+     */
+    bool getReplicaSelection() const {
+        return _replicaSelection != 0;
+    }
+
+    /* Get the seconds between checks of the CSS version, which reload the
+     * chunk replicas once it changed.
+     *
+     * @return the number of seconds.
+     */
+    int getReplicaCheckSecs() const {
+        return _replicaCheckSecs;
+    }
+
+    /* Get the seconds a connection to a worker may stay unused before the
+     * czar pings the worker to keep it open.
+     *
+     * @return the number of seconds, 0 to neither warm up nor keep open the
+     *         connections.
+     */
+    int getWorkerKeepAliveSecs() const {
+        return _workerKeepAliveSecs;
+    }
+
+    /* Get the maximum number of chunks QMeta writes with one statement.
+     *
+     * @return the number of chunks.
+     */
+    int getQMetaMaxBatchRows() const {
+        return _qMetaMaxBatchRows;
+    }
+
+    /* Get the number of QMeta updates that may wait to be written before
+     * query execution is held up.
+     *
+     * @return the number of updates, 0 writes them synchronously.
+     */
+    int getQMetaQueueSize() const {
+        return _qMetaQueueSize;
+    }
+
+    /* Get how many times a failed QMeta update is tried again.
+     *
+     * @return the number of retries.
+     */
+    int getQMetaQueueMaxRetries() const {
+        return _qMetaQueueMaxRetries;
+    }
+
+    /* Get the time between writes of the progress of running queries, which
+     * is otherwise kept in memory.
+     *
+     * @return the number of seconds, 0 writes every progress update.
+     */
+    int getQMetaProgressFlushSecs() const {
+        return _qMetaProgressFlushSecs;
+    }
+
+    /* Get the time the proxy waits, right after submitting a query, for it
+     * to complete so that its results are read without reading its messages.
+     *
+     * @return the time in milliseconds, 0 only checks for completion.
+     */
+    int getProxyCompletionWaitMs() const {
+        return _proxyCompletionWaitMs;
+    }
 private:
 
     CzarConfig(util::ConfigStore const& ConfigStore);
@@ -166,10 +559,57 @@ private:
     mysql::MySqlConfig const _mySqlQstatusDataConfig;
     std::string const _xrootdFrontendUrl;
     std::string const _emptyChunkPath;
+    std::string const _secondaryIndexPath;
     int const _largeResultConcurrentMerges;
+    int const _mergeShards;
+    int const _aggMaxGroups;
+    int const _workerAggFold;
+    int const _semiJoinMaxKeys;
+    int const _topKMaxRows;
+    std::string const _sortedRunDir;
+    int const _passThroughMemoryTableMB;
+    int const _mergeJobIdPartitions;
+    std::string const _resultSink;
+    std::string const _resultSinkDir;
+    int const _resultSinkMemoryMB;
+    int const _mergeBufferPoolMB;
+    int const _selectStmtCacheSize;
+    int const _resultCacheMB;
+    int const _resultCacheEntryMB;
+    int const _resultCacheTtlSecs;
+    int const _secondaryIndexCacheSize;
+    int const _maxQueryCost;
+    int const _interactiveDeadlineMs;
+    int const _admissionMaxInteractive;
+    int const _admissionMaxScan;
+    int const _admissionMaxAsync;
+    int const _admissionMaxQueued;
+    int const _admissionMaxWaitSecs;
+    int const _admissionMaxRunningJobs;
+    int const _admissionMaxRunningCost;
+    int const _clusterMaxRunningJobs;
+    int const _czarLoadPeriodSecs;
     int const _xrootdCBThreadsMax;
     int const _xrootdCBThreadsInit;
     int const _qMetaSecsBetweenChunkCompletionUpdates;
+    int const _stragglerPercentile;
+    int const _stragglerFactor;
+    int const _scanAffinityOrder;
+    int const _maxResponseReads;
+    int const _replicaSelection;
+    int const _replicaCheckSecs;
+    int const _workerKeepAliveSecs;
+    int const _qMetaMaxBatchRows;
+    int const _qMetaQueueSize;
+    int const _qMetaQueueMaxRetries;
+    int const _qMetaProgressFlushSecs;
+    int const _proxyCompletionWaitMs;
+    int const _resultDbMaxConnections;
+    int const _metricsPort;
+    int const _traceSampleEvery;
+    std::string const _traceFile;
+    std::string const _captureFile;
+    int const _captureTiming;
 };
 
 }}} // namespace lsst::qserv::czar
@@ -24,6 +24,13 @@
 #include "czar/MessageTable.h"
 
 // System headers
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
 
 // Third-party headers
 #include "boost/format.hpp"
@@ -43,37 +50,212 @@ namespace {
 LOG_LOGGER _log = LOG_GET("lsst.qserv.czar.MessageTable");
 
 #define MAX_MESSAGE_LEN "1024" // string, for splicing into templates below
+size_t const maxMessageLen = 1024;
 
 std::string const createTmpl("CREATE TABLE IF NOT EXISTS %1% "
     "(chunkId INT, code SMALLINT, message VARCHAR(" MAX_MESSAGE_LEN "), "
-    "severity ENUM ('INFO', 'ERROR'), timeStamp FLOAT)"
+    "severity ENUM ('INFO', 'ERROR'), timeStamp FLOAT, msgCount INT DEFAULT 1)"
     "ENGINE=MEMORY");
 
 std::string const createAndLockTmpl(createTmpl + "; LOCK TABLES %1% WRITE;");
 
-std::string const writeTmpl("INSERT INTO %1% (chunkId, code, message, severity, timeStamp) "
-    "VALUES (%2%, %3%, '%4$." MAX_MESSAGE_LEN "s', '%5%', %6%)");
+std::string const writeTmpl("INSERT INTO %1% (chunkId, code, message, severity, timeStamp, msgCount) "
+    "VALUES ");
+
+std::string const valuesTmpl("(%1%, %2%, '%3%', '%4%', %5%, %6%)");
+
+std::string const countTmpl("UPDATE %1% SET msgCount=%2% "
+    "WHERE chunkId=%3% AND code=%4% AND severity='%5%' AND message='%6%'");
+
+/// Largest INSERT statement, well below the default max_allowed_packet.
+size_t const maxInsertBytes = 512*1024;
+
+/// Time between two writes of the messages that came in.
+std::chrono::seconds const writeInterval(1);
 
 // mysql can only unlock all locked tables,
 // there is no command to unlock single table
 std::string const unlockTmpl("UNLOCK TABLES");
 
+std::string const dropTmpl("DROP TABLE IF EXISTS %1%");
+
 }
 
 namespace lsst {
 namespace qserv {
 namespace czar {
 
+/// Writer keeps track of the messages of a query written to the table, and
+/// writes those that came in since, from its thread or when unlocking.
+class MessageTable::Writer {
+public:
+    Writer(std::string const& tableName, sql::SqlConnectionPool::Lease const& sqlConn)
+        : _tableName(tableName), _sqlConn(sqlConn) {}
+
+    Writer(Writer const&) = delete;
+    Writer& operator=(Writer const&) = delete;
+
+    ~Writer() { stop(); }
+
+    /// Write the messages of 'msgStore' every writeInterval until stop().
+    void start(std::shared_ptr<qdisp::MessageStore> const& msgStore) {
+        _thread = std::thread([this, msgStore]() {
+            std::unique_lock<std::mutex> lock(_mtx);
+            while (not _cv.wait_for(lock, ::writeInterval, [this]() { return _stop; })) {
+                lock.unlock();
+                try {
+                    write(*msgStore);
+                } catch (std::exception const& exc) {
+                    // What is left gets written, or the error reported, by unlock().
+                    LOGS(_log, LOG_LVL_WARN, "stopped writing messages to " << _tableName
+                         << ": " << exc.what());
+                    return;
+                }
+                lock.lock();
+            }
+        });
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            _stop = true;
+        }
+        _cv.notify_all();
+        if (_thread.joinable()) {
+            _thread.join();
+        }
+    }
+
+    /// Write the messages of 'msgStore' added since the last call, and the
+    /// counts of the rows they repeat.
+    void write(qdisp::MessageStore const& msgStore) {
+        std::lock_guard<std::mutex> lock(_writeMtx);
+        for (auto const& qm : msgStore.getMessages(_next)) {
+            ++_next;
+            std::string description = qm.description.substr(0, ::maxMessageLen);
+            auto key = std::make_tuple(qm.chunkId, qm.code, static_cast<int>(qm.severity), description);
+            auto iter = _index.find(key);
+            if (iter != _index.end()) {
+                Row& row = _rows[iter->second];
+                ++row.count;
+                _markDirty(iter->second);
+                continue;
+            }
+            LOGS(_log, LOG_LVL_DEBUG, "Insert in message table: ["
+                 << qm.description << ", " << qm.chunkId << ", " << qm.code
+                 << ", " << qm.severity << ", " << qm.timestamp << "]");
+            _index.emplace(std::move(key), _rows.size());
+            _rows.push_back(Row{qm.chunkId, qm.code, qm.severity, std::move(description),
+                                qm.timestamp, 1, 0, false});
+            _markDirty(_rows.size() - 1);
+        }
+        if (_dirty.empty()) {
+            return;
+        }
+
+        // New rows, in as few statements as fit.
+        std::string const insert = (boost::format(::writeTmpl) % _tableName).str();
+        std::string query;
+        std::vector<size_t> inQuery;
+        for (size_t idx : _dirty) {
+            Row const& row = _rows[idx];
+            if (row.written > 0) continue;
+            std::string const values = (boost::format(::valuesTmpl) % row.chunkId % row.code
+                    % _sqlConn->escapeString(row.description) % _severity(row) % row.timestamp
+                    % row.count).str();
+            if (not query.empty() and query.size() + values.size() >= ::maxInsertBytes) {
+                _run(query, inQuery);
+                query.clear();
+                inQuery.clear();
+            }
+            query += query.empty() ? insert : ", ";
+            query += values;
+            inQuery.push_back(idx);
+        }
+        if (not query.empty()) {
+            _run(query, inQuery);
+        }
+
+        // Rows already in the table that were repeated since.
+        for (size_t idx : _dirty) {
+            Row const& row = _rows[idx];
+            if (row.written == 0 or row.written == row.count) continue;
+            std::string const update = (boost::format(::countTmpl) % _tableName % row.count
+                    % row.chunkId % row.code % _severity(row)
+                    % _sqlConn->escapeString(row.description)).str();
+            _run(update, {idx});
+        }
+        for (size_t idx : _dirty) {
+            _rows[idx].dirty = false;
+        }
+        _dirty.clear();
+    }
+
+private:
+    /// A row of the table, standing for identical messages of a chunk.
+    struct Row {
+        int chunkId;
+        int code;
+        MessageSeverity severity;
+        std::string description;
+        std::time_t timestamp; ///< Of the first message.
+        int count;             ///< Number of messages.
+        int written;           ///< msgCount in the table, 0 if the row is not there yet.
+        bool dirty;            ///< In _dirty.
+    };
+
+    static char const* _severity(Row const& row) {
+        return row.severity == MSG_INFO ? "INFO" : "ERROR";
+    }
+
+    void _markDirty(size_t idx) {
+        if (not _rows[idx].dirty) {
+            _rows[idx].dirty = true;
+            _dirty.push_back(idx);
+        }
+    }
+
+    /// Run 'query', which writes the rows 'idxs' as they are now.
+    void _run(std::string const& query, std::vector<size_t> const& idxs) {
+        sql::SqlErrorObject sqlErr;
+        if (not _sqlConn->runQuery(query, sqlErr)) {
+            SqlError exc(ERR_LOC, "Failure updating message table", sqlErr);
+            LOGS(_log, LOG_LVL_ERROR, exc.message());
+            throw exc;
+        }
+        for (size_t idx : idxs) {
+            _rows[idx].written = _rows[idx].count;
+        }
+    }
+
+    std::string const _tableName;
+    sql::SqlConnectionPool::Lease const _sqlConn; ///< The connection holding the table lock.
+
+    std::mutex _writeMtx; ///< Protects the members below, one write at a time.
+    size_t _next{0};      ///< Index in the MessageStore of the first message not seen.
+    std::vector<Row> _rows;
+    std::map<std::tuple<int, int, int, std::string>, size_t> _index; ///< Rows by content.
+    std::vector<size_t> _dirty; ///< Rows which differ from the table.
+
+    std::mutex _mtx; ///< Protects _stop.
+    std::condition_variable _cv;
+    bool _stop{false};
+    std::thread _thread;
+};
+
+
 // Constructors
 MessageTable::MessageTable(std::string const& tableName,
-                           mysql::MySqlConfig const& resultConfig)
+                           sql::SqlConnectionPool::Ptr const& resultDbPool)
     : _tableName(tableName),
-      _sqlConn(std::make_shared<sql::SqlConnection>(resultConfig)) {
+      _resultDbPool(resultDbPool) {
 }
 
 // Create the table, do not lock
 void
 MessageTable::create() {
+    _connect("creating");
     std::string query = (boost::format(::createTmpl) % _tableName).str();
     sql::SqlErrorObject sqlErr;
     LOGS(_log, LOG_LVL_DEBUG, "creating message table " << _tableName);
@@ -82,11 +264,16 @@ MessageTable::create() {
         LOGS(_log, LOG_LVL_ERROR, exc.message());
         throw exc;
     }
+    // nothing is locked, the connection can go back to the pool
+    _sqlConn.reset();
 }
 
 // Create and lock the table
 void
 MessageTable::lock() {
+    _connect("locking");
+    // until the table is unlocked the connection must not be reused
+    sql::SqlConnectionPool::discard(_sqlConn);
     std::string query = (boost::format(::createAndLockTmpl) % _tableName).str();
     sql::SqlErrorObject sqlErr;
     LOGS(_log, LOG_LVL_DEBUG, "locking message table " << _tableName);
@@ -97,9 +284,20 @@ MessageTable::lock() {
     }
 }
 
+// Write the messages in the background
+void
+MessageTable::startWriting(ccontrol::UserQuery::Ptr const& userQuery) {
+    if (not userQuery or _writer or not _sqlConn) {
+        return;
+    }
+    _writer = std::make_shared<Writer>(_tableName, _sqlConn);
+    _writer->start(userQuery->getMessageStore());
+}
+
 // Release lock on message table so that proxy can proceed
 void
 MessageTable::unlock(ccontrol::UserQuery::Ptr const& userQuery) {
+    _connect("unlocking");
     _saveQueryMessages(userQuery);
 
     sql::SqlErrorObject sqlErr;
@@ -109,6 +307,37 @@ MessageTable::unlock(ccontrol::UserQuery::Ptr const& userQuery) {
         LOGS(_log, LOG_LVL_ERROR, exc.message());
         throw exc;
     }
+    sql::SqlConnectionPool::discard(_sqlConn, false);
+}
+
+// Drop the table
+void
+MessageTable::drop() {
+    _connect("dropping");
+    std::string query = (boost::format(::dropTmpl) % _tableName).str();
+    sql::SqlErrorObject sqlErr;
+    LOGS(_log, LOG_LVL_DEBUG, "dropping message table " << _tableName);
+    if (not _sqlConn->runQuery(query, sqlErr)) {
+        SqlError exc(ERR_LOC, "Failure dropping message table", sqlErr);
+        LOGS(_log, LOG_LVL_ERROR, exc.message());
+        throw exc;
+    }
+    _sqlConn.reset();
+}
+
+// lease a connection unless there is one already
+void
+MessageTable::_connect(std::string const& what) {
+    if (_sqlConn) {
+        return;
+    }
+    sql::SqlErrorObject sqlErr;
+    _sqlConn = _resultDbPool->acquire("messageTable", sqlErr);
+    if (not _sqlConn) {
+        SqlError exc(ERR_LOC, "Failure connecting for " + what + " message table", sqlErr);
+        LOGS(_log, LOG_LVL_ERROR, exc.message());
+        throw exc;
+    }
 }
 
 // store all messages from current session to the table
@@ -117,27 +346,13 @@ MessageTable::_saveQueryMessages(ccontrol::UserQuery::Ptr const& userQuery) {
     if (not userQuery) {
         return;
     }
-
-    auto msgStore = userQuery->getMessageStore();
-
-    // copy all messages from query message store to a message table
-    int msgCount = msgStore->messageCount();
-    for (int i = 0; i != msgCount; ++ i) {
-        const qdisp::QueryMessage& qm = msgStore->getMessage(i);
-        LOGS(_log, LOG_LVL_DEBUG, "Insert in message table: ["
-             << qm.description << ", " << qm.chunkId << ", " << qm.code
-             << ", " << qm.severity << ", " << qm.timestamp << "]");
-
-        char const* severity = (qm.severity == MSG_INFO ? "INFO" : "ERROR");
-        std::string query = (boost::format(::writeTmpl) % _tableName % qm.chunkId % qm.code %
-            _sqlConn->escapeString(qm.description) % severity % qm.timestamp).str();
-        sql::SqlErrorObject sqlErr;
-        if (not _sqlConn->runQuery(query, sqlErr)) {
-            SqlError exc(ERR_LOC, "Failure updating message table", sqlErr);
-            LOGS(_log, LOG_LVL_ERROR, exc.message());
-            throw exc;
-        }
+    if (not _writer) {
+        _writer = std::make_shared<Writer>(_tableName, _sqlConn);
     }
+    // the background writes end before the last ones
+    _writer->stop();
+    _writer->write(*userQuery->getMessageStore());
+    _writer.reset();
 }
 
 }}} // namespace lsst::qserv::czar
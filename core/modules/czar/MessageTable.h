@@ -31,15 +31,9 @@
 // Qserv headers
 #include "ccontrol/UserQuery.h"
 #include "global/stringTypes.h"
-#include "mysql/MySqlConfig.h"
+#include "sql/SqlConnectionPool.h"
 
 
-namespace lsst {
-namespace qserv {
-namespace sql {
-class SqlConnection;
-}}}
-
 namespace lsst {
 namespace qserv {
 namespace czar {
@@ -51,13 +45,19 @@ namespace czar {
  *
  *  @brief Class representing message table in results database.
  *
+ *  Messages go to the table in multi-row inserts. Identical messages of a
+ *  chunk (same code, severity and text) take a single row, whose msgCount
+ *  column tells how many there were, with the time of the first one. Once
+ *  startWriting() is called the messages are written as they come in, so
+ *  that unlock() only has the last ones left to write.
  */
 
 class MessageTable  {
 public:
 
-    // Constructor takes table name including database name
-    explicit MessageTable(std::string const& tableName, mysql::MySqlConfig const& resultConfig);
+    // Constructor takes table name including database name, and the pool
+    // of connections to the result database
+    MessageTable(std::string const& tableName, sql::SqlConnectionPool::Ptr const& resultDbPool);
 
     /// Create the table, do not lock
     void create();
@@ -65,18 +65,31 @@ public:
     /// Create and lock the table
     void lock();
 
+    /// Write the messages of 'userQuery' to the locked table from a thread
+    /// of its own, until unlock() is called.
+    void startWriting(ccontrol::UserQuery::Ptr const& userQuery);
+
     /// Release lock on message table so that proxy can proceed
     void unlock(ccontrol::UserQuery::Ptr const& userQuery);
 
+    /// Drop the table, once the proxy no longer reads it
+    void drop();
+
 protected:
 
 private:
+    class Writer;
 
     /// store all messages from current session to the table
     void _saveQueryMessages(ccontrol::UserQuery::Ptr const& userQuery);
 
+    /// lease a connection unless there is one already
+    void _connect(std::string const& what);
+
     std::string const _tableName;
-    std::shared_ptr<sql::SqlConnection> _sqlConn;
+    sql::SqlConnectionPool::Ptr _resultDbPool;
+    sql::SqlConnectionPool::Lease _sqlConn;  ///< shared by copies, holds the table lock
+    std::shared_ptr<Writer> _writer;         ///< shared by copies, null until startWriting()
 
 };
 
@@ -47,6 +47,7 @@ struct SubmitResult {
     std::string resultTable;   ///< Result table name
     std::string messageTable;  ///< Message table name
     std::string orderBy;       ///< Order by clause for proxy-side SELECT
+    bool dropResult = true;    ///< false if the result table is left to the result cache
 };
 
 }}} // namespace lsst::qserv::czar
@@ -0,0 +1,112 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "czar/WorkloadCapture.h"
+
+// System headers
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.czar.WorkloadCapture");
+
+/// @return the current time in milliseconds since the epoch.
+long long nowMs() {
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+} // annonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace czar {
+
+WorkloadCapture::WorkloadCapture(std::string const& path, bool timing)
+    : _path(path), _timing(timing), _out(path, std::ios::app) {
+    if (!_out) {
+        LOGS(_log, LOG_LVL_ERROR, "WorkloadCapture can not open " << _path);
+    } else {
+        LOGS(_log, LOG_LVL_INFO, "WorkloadCapture appending user queries to " << _path);
+    }
+}
+
+
+void WorkloadCapture::submitted(std::string const& queryId, std::string const& query,
+                                std::map<std::string, std::string> const& hints) {
+    std::ostringstream os;
+    os << "Q\t" << nowMs() << "\t" << escape(queryId) << "\t" << escape(query);
+    for (auto const& hint : hints) {
+        os << "\t" << escape(hint.first) << "\t" << escape(hint.second);
+    }
+    os << "\n";
+    _write(os.str());
+}
+
+
+void WorkloadCapture::completed(std::string const& queryId, bool success, Timing const& timing) {
+    if (!_timing) {
+        return;
+    }
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(3)
+       << "T\t" << nowMs() << "\t" << escape(queryId) << "\t" << (success ? 1 : 0)
+       << "\t" << timing.planMs << "\t" << timing.execMs << "\t" << timing.finalizeMs << "\n";
+    _write(os.str());
+}
+
+
+std::string WorkloadCapture::escape(std::string const& field) {
+    std::string out;
+    out.reserve(field.size());
+    for (char c : field) {
+        switch (c) {
+        case '\\': out += "\\\\"; break;
+        case '\t': out += "\\t"; break;
+        case '\n': out += "\\n"; break;
+        default: out += c; break;
+        }
+    }
+    return out;
+}
+
+
+void WorkloadCapture::_write(std::string const& record) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    if (!_out) {
+        return;
+    }
+    // Flushed by record, so that the workload is there if the czar dies.
+    _out << record << std::flush;
+    if (!_out) {
+        LOGS(_log, LOG_LVL_WARN, "WorkloadCapture failed to append to " << _path);
+    }
+}
+
+}}} // namespace lsst::qserv::czar
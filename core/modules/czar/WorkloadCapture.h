@@ -0,0 +1,84 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_CZAR_WORKLOADCAPTURE_H
+#define LSST_QSERV_CZAR_WORKLOADCAPTURE_H
+
+// System headers
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace lsst {
+namespace qserv {
+namespace czar {
+
+/// WorkloadCapture appends the user queries submitted to the czar to a file,
+/// for qserv-replay.py to submit them again to a test cluster. There is one
+/// line per record, of tab separated fields in which tab, newline and
+/// backslash are escaped with a backslash:
+///
+///     Q <submit ms since epoch> <user query id> <query> [<hint> <value>]...
+///     T <completion ms since epoch> <user query id> <1 on success, 0 otherwise>
+///       <planning ms> <execution ms> <finalization ms>
+///
+/// T records are only written if timing is captured.
+class WorkloadCapture {
+public:
+    /// Time spent in each stage of a user query.
+    struct Timing {
+        double planMs{0}; ///< Parsing and planning, until the query could be submitted.
+        double execMs{0}; ///< Dispatch of the jobs and merge of their results.
+        double finalizeMs{0}; ///< Saving the messages and unlocking the message table.
+    };
+
+    /// @param path - file the records are appended to.
+    /// @param timing - true if T records are written.
+    WorkloadCapture(std::string const& path, bool timing);
+    WorkloadCapture(WorkloadCapture const&) = delete;
+    WorkloadCapture& operator=(WorkloadCapture const&) = delete;
+
+    bool getTiming() const { return _timing; }
+
+    /// Record the submission of user query 'queryId'.
+    void submitted(std::string const& queryId, std::string const& query,
+                   std::map<std::string, std::string> const& hints);
+
+    /// Record the completion of user query 'queryId', if timing is captured.
+    void completed(std::string const& queryId, bool success, Timing const& timing);
+
+    /// @return 'field' with tab, newline and backslash escaped.
+    static std::string escape(std::string const& field);
+
+private:
+    void _write(std::string const& record);
+
+    std::string const _path;
+    bool const _timing;
+    std::mutex _mtx; ///< Protects _out.
+    std::ofstream _out;
+};
+
+}}} // namespace lsst::qserv::czar
+
+#endif // LSST_QSERV_CZAR_WORKLOADCAPTURE_H
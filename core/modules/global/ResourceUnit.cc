@@ -26,7 +26,9 @@
 // System headers
 #include <cassert>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <limits>
 #include <sstream>
 
 namespace lsst {
@@ -132,10 +134,57 @@ ResourceUnit::prefix(UnitType const& r) {
 std::string ResourceUnit::makePath(int chunk, std::string const& db) {
     return "/" + prefix(UnitType::DBCHUNK) + "/" + db + "/" + std::to_string(chunk);
 }
+std::string ResourceUnit::makePath(int chunk, std::string const& db, std::string const& id) {
+    return makePath(chunk, db) + "/" + id;
+}
 std::string ResourceUnit::makeWorkerPath(std::string const& id) {
     return "/" + prefix(UnitType::WORKER) + "/" + id;
 }
 
+bool ResourceUnit::parseDbChunk(char const* path, std::size_t len, DbChunkRef& ref) {
+    static char const chkPrefix[] = "/chk/";
+    std::size_t const prefixLen = sizeof(chkPrefix) - 1;
+    if (len <= prefixLen || std::memcmp(path, chkPrefix, prefixLen) != 0) {
+        return false;
+    }
+    char const* const end = path + len;
+    char const* const db = path + prefixLen;
+    char const* cur = static_cast<char const*>(std::memchr(db, _pathSep, end - db));
+    if (cur == nullptr || cur == db) {
+        return false;
+    }
+    std::size_t const dbLen = cur - db;
+    ++cur;
+    bool const negative = (cur != end && *cur == '-');
+    if (negative) ++cur;
+    if (cur == end || *cur < '0' || *cur > '9') {
+        return false;
+    }
+    long chunk = 0;
+    for (; cur != end && *cur >= '0' && *cur <= '9'; ++cur) {
+        chunk = chunk * 10 + (*cur - '0');
+        if (chunk > std::numeric_limits<int>::max()) {
+            return false;
+        }
+    }
+    // The chunk number may be followed by keys or by the worker.
+    if (cur != end && *cur != _varSep && *cur != _pathSep) {
+        return false;
+    }
+    ref.db = db;
+    ref.dbLen = dbLen;
+    ref.chunk = static_cast<int>(negative ? -chunk : chunk);
+    ref.worker = nullptr;
+    ref.workerLen = 0;
+    if (cur != end && *cur == _pathSep) {
+        char const* const worker = cur + 1;
+        char const* keys = static_cast<char const*>(std::memchr(worker, _varSep, end - worker));
+        ref.worker = worker;
+        ref.workerLen = ((keys == nullptr) ? end : keys) - worker;
+    }
+    return true;
+}
+
 void
 ResourceUnit::setAsDbChunk(std::string const& db, int chunk) {
     _unitType = DBCHUNK;
@@ -248,6 +297,12 @@ ResourceUnit::_ingestKeyStr(std::string const& keyStr) {
     }
 }
 
+bool ResourceUnit::Checker::operator()(DbChunkRef const& ref) {
+    ResourceUnit ru;
+    ru.setAsDbChunk(std::string(ref.db, ref.dbLen), ref.chunk);
+    return (*this)(ru);
+}
+
 std::ostream& operator<<(std::ostream& os, ResourceUnit const& ru) {
     return os << "Resource(" << ru.path() << ")";
 }
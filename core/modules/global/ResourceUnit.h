@@ -25,6 +25,7 @@
 #define LSST_QSERV_RESOURCEUNIT_H
 
 // System headers
+#include <cstddef>
 #include <map>
 #include <string>
 
@@ -48,6 +49,16 @@ public:
     class Checker;
     enum UnitType {GARBAGE, DBCHUNK, CQUERY, UNKNOWN, RESULT, WORKER};
 
+    /// Database and chunk of a DBCHUNK path. 'db' and 'worker' point into
+    /// the path, which must outlive them, and are not null-terminated.
+    struct DbChunkRef {
+        char const* db = nullptr;
+        std::size_t dbLen = 0;
+        int chunk = -1;
+        char const* worker = nullptr; ///< Worker the path is for, see makePath().
+        std::size_t workerLen = 0;    ///< 0 if any worker with the chunk may answer.
+    };
+
     ResourceUnit() : _unitType(GARBAGE), _chunk(-1) {}
 
     explicit ResourceUnit(std::string const& path);
@@ -70,9 +81,22 @@ public:
     /// @return the path of the database/chunk resource
     static std::string makePath(int chunk, std::string const& db);
 
+    /// @return the path of the database/chunk resource on the worker 'id'
+    ///         only, "/chk/<db>/<chunk>/<id>", to pick among its replicas.
+    static std::string makePath(int chunk, std::string const& db, std::string const& id);
+
     /// @return the path of the worker-specific resource
     static std::string makeWorkerPath(std::string const& id);
 
+    /// Parse a "/chk/<db>/<chunk>[/<worker>][?<keys>]" path without allocating, for
+    /// the worker to route its requests.
+    /// @return false if 'path' is not such a path, the ResourceUnit
+    ///         constructor then tells what it is.
+    static bool parseDbChunk(char const* path, std::size_t len, DbChunkRef& ref);
+    static bool parseDbChunk(std::string const& path, DbChunkRef& ref) {
+        return parseDbChunk(path.data(), path.size(), ref);
+    }
+
     // Setup a path of a certain type.
     void setAsDbChunk(std::string const& db, int chunk=DUMMY_CHUNK);
 
@@ -111,6 +135,9 @@ class ResourceUnit::Checker {
 public:
     virtual ~Checker() {}
     virtual bool operator()(ResourceUnit const& ru) = 0;
+    /// Check a parsed DBCHUNK path, through operator()(ResourceUnit const&)
+    /// unless overridden.
+    virtual bool operator()(DbChunkRef const& ref);
 };
 
 }} // namespace lsst::qserv
@@ -91,6 +91,36 @@ BOOST_AUTO_TEST_CASE(DbChunk) {
     BOOST_CHECK_EQUAL(r[1].path(), "/chk/bar/968");
 }
 
+BOOST_AUTO_TEST_CASE(ParseDbChunk) {
+    // The same db and chunk as the constructor, without allocating.
+    ResourceUnit::DbChunkRef ref;
+    std::string path = "/chk/qservTest_case01_qserv/123";
+    BOOST_REQUIRE(ResourceUnit::parseDbChunk(path, ref));
+    BOOST_CHECK_EQUAL(std::string(ref.db, ref.dbLen), "qservTest_case01_qserv");
+    BOOST_CHECK_EQUAL(ref.chunk, 123);
+    BOOST_CHECK(ResourceUnit::parseDbChunk(std::string("/chk/abc/1234567890?k=v"), ref));
+    BOOST_CHECK_EQUAL(ref.chunk, 1234567890);
+    BOOST_CHECK_EQUAL(ref.workerLen, 0u);
+
+    // A path for one of the replicas names the worker.
+    path = ResourceUnit::makePath(77, "LSST", "worker-2");
+    BOOST_CHECK_EQUAL(path, "/chk/LSST/77/worker-2");
+    std::string const withKeys = path + "?k=v";
+    BOOST_REQUIRE(ResourceUnit::parseDbChunk(withKeys, ref));
+    BOOST_CHECK_EQUAL(std::string(ref.db, ref.dbLen), "LSST");
+    BOOST_CHECK_EQUAL(ref.chunk, 77);
+    BOOST_CHECK_EQUAL(std::string(ref.worker, ref.workerLen), "worker-2");
+    ResourceUnit ru(path);
+    BOOST_CHECK_EQUAL(ru.unitType(), ResourceUnit::DBCHUNK);
+    BOOST_CHECK_EQUAL(ru.chunk(), 77);
+
+    for (auto const& garbage : {"/chk/qservTest_case01_qserv", "/chk/abc/", "/chk//1", "/chk2/abc/1",
+                                "/q/Foo/123", "/worker/worker-1", "/chk/abc/12x", "/chk/abc/99999999999"}) {
+        BOOST_CHECK_MESSAGE(!ResourceUnit::parseDbChunk(std::string(garbage), ref),
+                            std::string("Expected no db/chunk: ") + garbage);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(Old) {
     ResourceUnit cq("/q/Foo/123");
     ResourceUnit res("/result/1234567890abcde");
@@ -26,6 +26,7 @@
 
 // System Headers
 #include <errno.h>
+#include <sys/stat.h>
 #include <unordered_map>
 
 // LSST headers
@@ -48,6 +49,30 @@ namespace memman {
 namespace {
 std::mutex                                cacheMutex;
 std::unordered_map<std::string, MemFile*> fileCache;
+
+// Return the identity of the current contents of a file, or a zeroed stamp if
+// the file could not be stat'ed.
+//
+MemFile::Stamp fileStamp(std::string const& fPath) {
+    MemFile::Stamp stamp = {0, 0, 0, 0};
+    struct stat sBuff;
+    if (!stat(fPath.c_str(), &sBuff)) {
+        stamp.dev   = static_cast<uint64_t>(sBuff.st_dev);
+        stamp.ino   = static_cast<uint64_t>(sBuff.st_ino);
+        stamp.size  = static_cast<uint64_t>(sBuff.st_size);
+        stamp.mtime = static_cast<int64_t>(sBuff.st_mtime);
+    }
+    return stamp;
+}
+}
+
+/******************************************************************************/
+/*                        b y t e s T o R e s e r v e                         */
+/******************************************************************************/
+
+uint64_t MemFile::bytesToReserve() {
+    std::lock_guard<std::mutex> guard(_fileMutex);
+    return (_isReserved ? 0 : _memInfo.size());
 }
 
 /******************************************************************************/
@@ -85,7 +110,7 @@ MemFile::MLResult MemFile::memLock() {
 
     // Only call if _isMapped was true. The only line that sets it to false is protected by _mlockFileMutex.
     if (rc == 0) {
-        rc = _memory.memLock(_memInfo, _isFlex);
+        rc = _memory.memLock(_memInfo, _isFlex, _numaNode);
         if (rc == 0) {
             std::lock_guard<std::mutex> guardSet(_fileMutex);
             _mlocking = false;
@@ -183,7 +208,7 @@ uint32_t MemFile::numFiles() {
 /******************************************************************************/
   
 MemFile::MFResult MemFile::obtain(std::string const& fPath,
-                                  Memory& mem, bool isFlex) {
+                                  Memory& mem, bool isFlex, int numaNode) {
 
     std::lock_guard<std::mutex> guard(cacheMutex);
 
@@ -191,15 +216,26 @@ MemFile::MFResult MemFile::obtain(std::string const& fPath,
     // the same memory object (error if not). If so, up the reference count and
     // return the object as it may be shared. Note: it->second == MemFile*!
     //
+    // A table rewritten in place (e.g. packed by the replication system) is
+    // a different file even though the path is the same. The stale object is
+    // detached from the cache so that it goes away with its last reference,
+    // and a new object is made with the size of the new file.
+    //
+    Stamp stamp = fileStamp(fPath);
     auto it = fileCache.find(fPath);
     if (it != fileCache.end()) {
         if (&(it->second->_memory) != &mem) {
             MFResult errResult(nullptr, EXDEV);
             return errResult;
         }
-        it->second->_refs++;
-        MFResult aokResult(it->second,0);
-        return aokResult;
+        if (it->second->_stamp == stamp) {
+            it->second->_refs++;
+            MFResult aokResult(it->second,0);
+            return aokResult;
+        }
+        LOGS(_log, LOG_LVL_INFO, "memman file changed, detaching " << fPath);
+        it->second->_isDetached = true;
+        fileCache.erase(it);
     }
 
     // Validate the file and get its size
@@ -212,7 +248,7 @@ MemFile::MFResult MemFile::obtain(std::string const& fPath,
 
     // Get a new file object and insert it into the map
     //
-    MemFile* mfP = new MemFile(fPath, mem, mInfo, isFlex);
+    MemFile* mfP = new MemFile(fPath, mem, mInfo, stamp, isFlex, numaNode);
     fileCache.insert({fPath, mfP});
 
     // Return the pointer to the file object
@@ -236,9 +272,9 @@ void MemFile::release() {
          _refs--;
          if (_refs > 0) return;
 
-         // Remove the object from our cache
+         // Remove the object from our cache unless it was replaced there
          //
-         fileCache.erase(_fPath);
+         if (!_isDetached) fileCache.erase(_fPath);
     }
 
     // We lock the file mutex. We also get the size of the file as memRel()
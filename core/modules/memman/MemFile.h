@@ -47,6 +47,23 @@ namespace memman {
 class MemFile {
 public:
 
+    //-----------------------------------------------------------------------------
+    //! @brief Identity of the contents of a file when its object was made. A
+    //!        file whose stamp has changed is given a new object by obtain().
+    //-----------------------------------------------------------------------------
+
+    struct Stamp {
+        uint64_t dev;
+        uint64_t ino;
+        uint64_t size;
+        int64_t  mtime;
+
+        bool operator==(Stamp const& other) const {
+            return dev == other.dev && ino == other.ino &&
+                   size == other.size && mtime == other.mtime;
+        }
+    };
+
     //-----------------------------------------------------------------------------
     //! @brief Lock database file in memory.
     //!
@@ -86,6 +103,14 @@ public:
 
     static uint32_t numFiles();
 
+    //-----------------------------------------------------------------------------
+    //! @brief Get the amount of memory memMap() still has to reserve.
+    //!
+    //! @return The file size or zero if memory is already reserved for it.
+    //-----------------------------------------------------------------------------
+
+    uint64_t    bytesToReserve();
+
     //-----------------------------------------------------------------------------
     //! @brief Obtain an object describing a in-memory file.
     //!
@@ -93,9 +118,13 @@ public:
     //! @param  fPath   - The path to the file.
     //! @param  mem     - Reference to the memory object to use for the file.
     //! @param  isFlex  - Tag file as flexible or not (only if new file).
+    //! @param  numaNode- NUMA node for the file pages, -1 for none (only if
+    //!                   new file).
     //!
     //! @return MFResult  When mfP is zero or retc is not zero, the MemFile
     //!                   object could not be obtained and retc holds errno.
+    //!                   A file changed since it was cached (different inode,
+    //!                   size or modification time) gets a new object.
     //-----------------------------------------------------------------------------
 
     struct MFResult {
@@ -105,7 +134,8 @@ public:
         MFResult(MemFile* mfp, int rc) : mfP(mfp), retc(rc) {}
     };
 
-    static MFResult obtain(std::string const& fPath, Memory& mem, bool isFlex);
+    static MFResult obtain(std::string const& fPath, Memory& mem, bool isFlex,
+                           int numaNode=-1);
 
     //-----------------------------------------------------------------------------
     //! @brief Release this table. Upon return it may not be references by
@@ -121,14 +151,19 @@ private:
     //! @param  fPath   - The path to the file.
     //! @param  mem     - Reference to the associated memory object.
     //! @param  mInfo   - Initial value of the MemInfo object for the file.
+    //! @param  stamp   - Identity of the contents of the file.
     //! @param  isFlex  - Tag file as flexible or not (for statistical reasons).
+    //! @param  numaNode- NUMA node the pages are moved to once locked.
     //-----------------------------------------------------------------------------
 
     MemFile(std::string const& fPath,
             Memory&            mem,
             MemInfo const&     minfo,
-            bool               isFlex)
-           : _fPath(fPath), _memory(mem), _memInfo(minfo), _isFlex(isFlex) {}
+            Stamp const&       stamp,
+            bool               isFlex,
+            int                numaNode)
+           : _fPath(fPath), _memory(mem), _memInfo(minfo), _stamp(stamp),
+             _isFlex(isFlex), _numaNode(numaNode) {}
 
    ~MemFile() {}
 
@@ -136,11 +171,14 @@ private:
     std::string _fPath;
     Memory&     _memory;
     MemInfo     _memInfo;              // Protected by _fileMutex
+    Stamp const _stamp;                // Set once at object creation
     int         _refs = 1;             // Protected by cacheMutex
+    bool        _isDetached = false;   // Ditto, replaced in the cache
     bool        _isMapped   = false;   // Protected by _fileMutex
     bool        _isReserved = false;   // Ditto
     bool        _isLocked   = false;   // Ditto
     bool const  _isFlex;               // Set once at object creation
+    int const   _numaNode;             // Ditto
 
     std::mutex  _mlockFileMutex;       // Protects _isLocked
     std::atomic<bool> _mlocking{false}; // Flag indicating mlock is being called.
@@ -30,6 +30,7 @@
 // Qserv Headers
 #include "memman/MemFile.h"
 #include "memman/Memory.h"
+#include "util/Numa.h"
 
 namespace lsst {
 namespace qserv {
@@ -62,9 +63,11 @@ int MemFileSet::add(std::string const& tabname, int chunk,
 
     std::string fPath(_memory.filePath(tabname, chunk, iFile));
 
-    // Obtain a memory file object for this table and chunk
+    // Obtain a memory file object for this table and chunk, its pages go to
+    // the NUMA node whose threads scan the chunk.
     //
-    MemFile::MFResult mfResult = MemFile::obtain(fPath, _memory, !mustLK);
+    int numaNode = util::Numa::get().nodeForChunk(chunk);
+    MemFile::MFResult mfResult = MemFile::obtain(fPath, _memory, !mustLK, numaNode);
     if (mfResult.mfP == 0) return mfResult.retc;
 
     // Add to the appropriate file set
@@ -78,6 +81,19 @@ int MemFileSet::add(std::string const& tabname, int chunk,
     return 0;
 }
   
+/******************************************************************************/
+/*                        b y t e s T o R e s e r v e                         */
+/******************************************************************************/
+
+uint64_t MemFileSet::bytesToReserve() {
+
+    uint64_t totBytes = 0;
+
+    for (auto mfP : _lockFiles) {totBytes += mfP->bytesToReserve();}
+    for (auto mfP : _flexFiles) {totBytes += mfP->bytesToReserve();}
+    return totBytes;
+}
+
 /******************************************************************************/
 /*                               l o c k A l l                                */
 /******************************************************************************/
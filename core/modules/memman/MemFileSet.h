@@ -63,6 +63,14 @@ public:
 
     int    add(std::string const& tabname, int chunk, bool iFile, bool mustLK);
 
+    //-----------------------------------------------------------------------------
+    //! @brief Get the amount of memory mapAll() still has to reserve.
+    //!
+    //! @return The number of bytes of the files that have no memory reserved.
+    //-----------------------------------------------------------------------------
+
+    uint64_t bytesToReserve();
+
     //-----------------------------------------------------------------------------
     //! @brief Determine ownership.
     //!
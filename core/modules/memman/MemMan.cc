@@ -30,6 +30,7 @@
 #include "memman/MemMan.h"
 #include "memman/MemManNone.h"
 #include "memman/MemManReal.h"
+#include "util/Metrics.h"
 
 /******************************************************************************/
 /*                        G l o b a l   S t a t i c s                         */
@@ -80,11 +81,12 @@ namespace memman {
 /*                                C r e a t e                                 */
 /******************************************************************************/
   
-MemMan *MemMan::create(uint64_t maxBytes, std::string const &dbPath) {
+MemMan *MemMan::create(uint64_t maxBytes, std::string const &dbPath,
+                       Options const& options) {
 
     // Return a memory manager implementation
     //
-    return new MemManReal(dbPath, maxBytes);
+    return new MemManReal(dbPath, maxBytes, options);
 }
 
 
@@ -103,11 +105,52 @@ std::string MemMan::Statistics::logString() {
     os << " FlexLock=" << numFlexLock;
     os << " Locks=" << numLocks;
     os << " Errors=" << numErrors;
+    os << " Prefetches=" << numPrefetches;
+    os << " Prefetched=" << bytesPrefetched;
+    os << " Retained=" << numRetained;
+    os << " RetainHits=" << numRetainHits;
+    os << " RetainMiss=" << numRetainMiss;
+    os << " Evictions=" << numEvictions;
+    os << " Mlocks=" << numMlocks;
+    if (secondsMlock > 0) {
+        os << " MlockMB/sec=" << bytesMlocked/(1048576.0*secondsMlock);
+        os << " MinMlockMB/sec=" << minMBSecMlock;
+    }
 
     return os.str();
 }
 
 
+void MemMan::Statistics::writeMetrics(std::ostream& os) const {
+    using util::MetricsRegistry;
+    auto metric = [&os](std::string const& name, char const* type, char const* help, double val) {
+        MetricsRegistry::writeHeader(os, "qserv_memman_" + name, type, help);
+        MetricsRegistry::writeValue(os, "qserv_memman_" + name, "", val);
+    };
+    metric("lock_max_bytes", "gauge", "Maximum number of bytes to lock", bytesLockMax);
+    metric("locked_bytes", "gauge", "Number of bytes locked", bytesLocked);
+    metric("reserved_bytes", "gauge", "Number of bytes reserved", bytesReserved);
+    metric("map_errors_total", "counter", "Number of mmap() calls that failed", numMapErrors);
+    metric("lock_errors_total", "counter", "Number of mlock() calls that failed", numLokErrors);
+    metric("file_sets", "gauge", "Number of active file sets", numFSets);
+    metric("files", "gauge", "Number of active files", numFiles);
+    metric("required_files_total", "counter", "Number of required files encountered", numReqdFiles);
+    metric("flexible_files_total", "counter", "Number of flexible files encountered", numFlexFiles);
+    metric("flexible_locked_total", "counter", "Number of flexible files that were locked", numFlexLock);
+    metric("locks_total", "counter", "Number of calls to lock()", numLocks);
+    metric("errors_total", "counter", "Number of calls that failed", numErrors);
+    metric("prefetches_total", "counter", "Number of prefetch() calls that read ahead", numPrefetches);
+    metric("prefetched_bytes_total", "counter", "Number of bytes read ahead", bytesPrefetched);
+    metric("retained", "gauge", "Number of unlocked chunks kept locked", numRetained);
+    metric("retain_hits_total", "counter", "Number of prepare() calls on a retained chunk", numRetainHits);
+    metric("retain_misses_total", "counter", "Number of prepare() calls on other chunks", numRetainMiss);
+    metric("evictions_total", "counter", "Number of retained chunks evicted", numEvictions);
+    metric("mlocks_total", "counter", "Number of files locked", numMlocks);
+    metric("mlocked_bytes_total", "counter", "Number of bytes in the files locked", bytesMlocked);
+    metric("mlock_seconds_total", "counter", "Seconds spent locking files", secondsMlock);
+}
+
+
 std::string MemMan::Status::logString() {
     std::stringstream os;
     os <<  "MemManHandle ";
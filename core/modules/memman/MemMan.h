@@ -27,6 +27,7 @@
 // System headers
 #include <cstdint>
 #include <memory>
+#include <ostream>
 #include <string>
 #include <vector>
 
@@ -90,12 +91,27 @@ public:
     //!
     //! @param  maxBytes   - Maximum amount of memory that can be used
     //! @param  dbPath     - Path to directory where the database resides
+    //! @param  options    - How files are mapped, locked and retained.
     //!
     //! @return !0: The pointer to the memory manager.
     //! @return  0: A manager could not be created.
     //-----------------------------------------------------------------------------
 
-    static MemMan* create(uint64_t maxBytes, std::string const& dbPath);
+    struct Options {
+        bool retain{false};   //!< Unlocked chunks stay locked until prepare()
+                              //!< needs their memory.
+        bool populate{false}; //!< Fault in all pages of a file before mlock()
+        bool hugePages{false};//!< Ask for transparent huge pages where the
+                              //!< file system supports them.
+        int  faultThreads{1}; //!< Threads faulting in a file when populating
+    };
+
+    static MemMan* create(uint64_t maxBytes, std::string const& dbPath,
+                          Options const& options);
+
+    static MemMan* create(uint64_t maxBytes, std::string const& dbPath) {
+                          return create(maxBytes, dbPath, Options());
+                         }
 
     //-----------------------------------------------------------------------------
     //! @brief Lock a set of tables in memory passed to the prepare() method.
@@ -145,6 +161,23 @@ public:
 
     virtual Handle prepare(std::vector<TableInfo> const& tables, int chunk) = 0;
 
+    //-----------------------------------------------------------------------------
+    //! @brief Start reading a set of tables into the file system cache so that
+    //!        a later prepare() and lock() of the same tables find their pages
+    //!        in memory. Nothing is locked or reserved and the call does not
+    //!        wait for the reads to complete.
+    //!
+    //! @param  tables - Reference to the tables to process. Tables that would
+    //!                  not be locked (i.e. NOLOCK) are skipped.
+    //! @param  chunk  - The chunk number associated with the tables.
+    //!
+    //! @return The number of bytes whose reading was started. Zero is returned
+    //!         when the tables would not fit in the memory still available
+    //!         for locking.
+    //-----------------------------------------------------------------------------
+
+    virtual uint64_t prefetch(std::vector<TableInfo> const& tables, int chunk) = 0;
+
     //-----------------------------------------------------------------------------
     //! @brief Unlock a set of tables previously locked by the lock() or were
     //!        prepared for locking by prepare().
@@ -154,7 +187,9 @@ public:
     //! @return false: The resource was not found.
     //! @return true:  The the memory associated with the resource has been
     //!                release. If this is the last usage of the resource,
-    //!                the memory associated with the resource is unlocked.
+    //!                the memory associated with the resource is unlocked,
+    //!                unless the manager retains locked chunks. Then it stays
+    //!                locked until prepare() needs the memory.
     //-----------------------------------------------------------------------------
 
     virtual bool  unlock(Handle handle) = 0;
@@ -186,7 +221,18 @@ public:
         uint32_t numFlexLock;  //!< Number  flexible files that were locked
         uint32_t numLocks;     //!< Number of calls to lock()
         uint32_t numErrors;    //!< Number of calls that failed
+        uint32_t numPrefetches;  //!< Number of prefetch() calls that read ahead
+        uint64_t bytesPrefetched;//!< Number of bytes read ahead by prefetch()
+        uint32_t numRetained;  //!< Current number of unlocked chunks kept locked
+        uint32_t numRetainHits;//!< Number of prepare() calls on a retained chunk
+        uint32_t numRetainMiss;//!< Number of prepare() calls on other chunks
+        uint32_t numEvictions; //!< Number of retained chunks evicted
+        uint32_t numMlocks;    //!< Number of files locked
+        uint64_t bytesMlocked; //!< Number of bytes in the files locked
+        double   secondsMlock; //!< Seconds spent locking files
+        double   minMBSecMlock;//!< Lowest MB/sec locking a file, 0 if none
         std::string logString(); //!< Returns a string suitable for logging.
+        void writeMetrics(std::ostream& os) const; //!< Writes them as metrics.
     };
 
     virtual Statistics getStatistics() = 0;
@@ -213,6 +259,30 @@ public:
 
     virtual Status getStatus(Handle handle) = 0;
 
+    //-----------------------------------------------------------------------------
+    //! @brief Change the maximum amount of memory that can be locked.
+    //!
+    //! Lowering it releases retained chunks until the reserved memory fits.
+    //! Tables locked for queries stay locked until they are unlocked, but no
+    //! memory is reserved for new requests until the reserved memory fits.
+    //!
+    //! @param  maxBytes - The new maximum number of bytes.
+    //-----------------------------------------------------------------------------
+
+    virtual void setMaxBytes(uint64_t maxBytes) = 0;
+
+    //-----------------------------------------------------------------------------
+    //! @brief Obtain the path of the file holding a table's data.
+    //!
+    //! @param  dbTable - The name of the table as "db/table".
+    //! @param  chunk   - The chunk number of the table.
+    //!
+    //! @return The file path or an empty string if tables are not managed as
+    //!         files.
+    //-----------------------------------------------------------------------------
+
+    virtual std::string filePath(std::string const& dbTable, int chunk) = 0;
+
     //-----------------------------------------------------------------------------
 
     MemMan & operator=(const MemMan&) = delete;
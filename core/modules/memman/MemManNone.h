@@ -45,6 +45,10 @@ public:
 
     int    lock(Handle handle, bool strict=false) override {return 0;}
 
+    uint64_t prefetch(std::vector<TableInfo> const& tables, int chunk) override {
+               (void)tables; (void)chunk; return 0;
+           }
+
     Handle prepare(std::vector<TableInfo> const& tables, int chunk) override {
                (void)chunk;
                if (_alwaysLock) return HandleType::ISEMPTY;
@@ -64,6 +68,12 @@ public:
 
     Status getStatus(Handle handle) override {(void)handle; return _status;}
 
+    void setMaxBytes(uint64_t maxBytes) override {_myStats.bytesLockMax = maxBytes;}
+
+    std::string filePath(std::string const& dbTable, int chunk) override {
+               (void)dbTable; (void)chunk; return std::string();
+           }
+
     MemManNone & operator=(const MemManNone&) = delete;
     MemManNone(const MemManNone&) = delete;
 
@@ -52,7 +52,45 @@ lsst::qserv::memman::MemMan::Handle handleNum
 namespace lsst {
 namespace qserv {
 namespace memman {
-  
+
+/******************************************************************************/
+/*                        _ e v i c t R e t a i n e d                         */
+/******************************************************************************/
+
+// Must be called with hanMutex held and _retained not empty.
+
+void MemManReal::_evictRetained() {
+
+    // Evict the least recently used file set. Its files are unlocked unless
+    // they are also part of a file set in use.
+    //
+    delete _retained.back();
+    _retained.pop_back();
+    _numEvictions++;
+}
+
+/******************************************************************************/
+/*                         _ t a k e R e t a i n e d                          */
+/******************************************************************************/
+
+// Must be called with hanMutex held.
+
+bool MemManReal::_takeRetained(int chunk) {
+
+    // A file set about to use the chunk's files already holds a reference to
+    // them, so dropping the retained file set releases only the files that
+    // are no longer wanted.
+    //
+    for (auto it = _retained.begin(); it != _retained.end(); it++) {
+        if ((*it)->status().chunk == chunk) {
+            delete *it;
+            _retained.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
 /******************************************************************************/
 /*                         g e t S t a t i s t i c s                          */
 /******************************************************************************/
@@ -72,8 +110,14 @@ MemMan::Statistics MemManReal::getStatistics() {
     stats.numMapErrors = mStats.numMapErrors;
     stats.numLokErrors = mStats.numLokErrors;
     stats.numFlexLock  = mStats.numFlexFiles;
+    stats.numMlocks    = mStats.numMlocks;
+    stats.bytesMlocked = mStats.bytesMlocked;
+    stats.secondsMlock = mStats.secondsMlock;
+    stats.minMBSecMlock= mStats.minMBSecMlock;
     stats.numLocks     = _numLocks;
     stats.numErrors    = _numErrors;
+    stats.numPrefetches  = _numPrefetches;
+    stats.bytesPrefetched= _bytesPrefetched;
     stats.numFiles     = MemFile::numFiles();
 
     // The following requires a lock
@@ -82,6 +126,10 @@ MemMan::Statistics MemManReal::getStatistics() {
     stats.numFSets = hanCache.size();
     stats.numReqdFiles = _numReqdFiles;
     stats.numFlexFiles = _numFlexFiles;
+    stats.numRetained  = _retained.size();
+    stats.numRetainHits= _numRetainHits;
+    stats.numRetainMiss= _numRetainMiss;
+    stats.numEvictions = _numEvictions;
     hanMutex.unlock();
     return stats;
 }
@@ -156,6 +204,51 @@ int MemManReal::lock(MemMan::Handle handle, bool strict) {
     return rc;
 }
   
+/******************************************************************************/
+/*                              p r e f e t c h                               */
+/******************************************************************************/
+
+uint64_t MemManReal::prefetch(std::vector<TableInfo> const& tables, int chunk) {
+
+    std::vector<std::string> fPaths;
+    uint64_t totSize = 0;
+
+    // Collect the files that a later prepare() would lock and their size. A
+    // missing file simply means there is nothing to read ahead for it.
+    //
+    for (auto&& tab : tables) {
+        for (bool isIndex : {false, true}) {
+            auto lockType = (isIndex ? tab.theIndex : tab.theData);
+            if (lockType == TableInfo::LockType::NOLOCK) continue;
+            std::string fPath = _memory.filePath(tab.tableName, chunk, isIndex);
+            MemInfo fInfo = _memory.fileInfo(fPath);
+            if (!fInfo.isValid()) continue;
+            totSize += fInfo.size();
+            fPaths.push_back(fPath);
+        }
+    }
+
+    // Reading ahead more than can be locked would only push out of the page
+    // cache the pages of the chunks being worked on. Retained chunks give up
+    // their memory when it is needed so it counts as available.
+    //
+    uint64_t bytesFree = _memory.bytesFree();
+    {   std::lock_guard<std::mutex> guard(hanMutex);
+        for (auto fsP : _retained) bytesFree += fsP->status().bytesLock;
+    }
+    if (totSize == 0 || totSize > bytesFree) return 0;
+
+    uint64_t bytesRead = 0;
+    for (auto&& fPath : fPaths) {
+        if (_memory.readAhead(fPath) == 0) {
+            bytesRead += _memory.fileInfo(fPath).size();
+        }
+    }
+    _numPrefetches++;
+    _bytesPrefetched += bytesRead;
+    return bytesRead;
+}
+
 /******************************************************************************/
 /*                               p r e p a r e                                */
 /******************************************************************************/
@@ -205,6 +298,17 @@ MemMan::Handle MemManReal::prepare(std::vector<TableInfo> const& tables, int chu
     if (retc == 0) {
        std::lock_guard<std::mutex> guard(hanMutex);
 
+       // Retained chunks only hold memory that no request needs. Take over
+       // the chunk's retained files, if any, and evict the least recently
+       // used chunks until this file set fits.
+       //
+       if (_retain) {
+          if (_takeRetained(chunk)) _numRetainHits++;
+             else if (fileSet->bytesToReserve() > 0) _numRetainMiss++;
+          while (!_retained.empty()
+             &&  fileSet->bytesToReserve() > _memory.bytesFree()) _evictRetained();
+       }
+
        // Lock all required tables and any flexible tables we can. Upon success
        // (with global mutex held) update statistics, generate a file handle,
        // add it to the handle cache, and return the handle.
@@ -227,6 +331,21 @@ MemMan::Handle MemManReal::prepare(std::vector<TableInfo> const& tables, int chu
     return HandleType::INVALID;
 }
 
+/******************************************************************************/
+/*                           s e t M a x B y t e s                            */
+/******************************************************************************/
+
+void MemManReal::setMaxBytes(uint64_t maxBytes) {
+
+    _memory.setMaxBytes(maxBytes);
+
+    // Retained chunks are the first to go when memory shrinks.
+    //
+    std::lock_guard<std::mutex> guard(hanMutex);
+    while (!_retained.empty()
+       &&  _memory.statistics().bytesReserved > maxBytes) _evictRetained();
+}
+
 /******************************************************************************/
 /*                                u n l o c k                                 */
 /******************************************************************************/
@@ -258,6 +377,17 @@ bool MemManReal::unlock(Handle handle) {
     // file set lock. It will be unlocked by the destructor.
     //
     fsP->serialize(true);
+
+    // When retaining, a file set that got locked stays locked as the most
+    // recently used one, replacing an older one for the same chunk.
+    //
+    if (_retain && fsP->status().bytesLock > 0) {
+        fsP->serialize(false);
+        std::lock_guard<std::mutex> guard(hanMutex);
+        _takeRetained(fsP->status().chunk);
+        _retained.push_front(fsP);
+        return true;
+    }
     delete fsP;
     return true;
 }
@@ -281,6 +411,10 @@ void MemManReal::unlockAll() {
             it = hanCache.erase(it);
          } else it++;
     }
+
+    // Retained file sets are always ours.
+    //
+    while(!_retained.empty()) _evictRetained();
 }
 }}} // namespace lsst:qserv:memman
 
@@ -27,6 +27,7 @@
 // System headers
 #include <atomic>
 #include <mutex>
+#include <list>
 #include <unordered_map>
 
 // Qserv Headers
@@ -46,6 +47,8 @@ public:
 
     int    lock(Handle handle, bool strict=false) override;
 
+    uint64_t prefetch(std::vector<TableInfo> const& tables, int chunk) override;
+
     Handle prepare(std::vector<TableInfo> const& tables, int chunk) override;
 
     bool   unlock(Handle handle) override;
@@ -56,23 +59,43 @@ public:
 
     Status     getStatus(Handle handle) override;
 
+    void       setMaxBytes(uint64_t maxBytes) override;
+
+    std::string filePath(std::string const& dbTable, int chunk) override
+                        {return _memory.filePath(dbTable, chunk);}
+
     MemManReal & operator=(const MemManReal&) = delete;
     MemManReal(const MemManReal&) = delete;
 
-    MemManReal(std::string const& dbPath, uint64_t maxBytes)
-              : _memory(dbPath, maxBytes), _numErrors(0), _numLkerrs(0),
-                _numLocks(0), _numReqdFiles(0), _numFlexFiles(0) {}
+    MemManReal(std::string const& dbPath, uint64_t maxBytes,
+               Options const& options=Options())
+              : _memory(dbPath, maxBytes, options.populate, options.hugePages,
+                        options.faultThreads),
+                _numErrors(0), _numLkerrs(0),
+                _numLocks(0), _numReqdFiles(0), _numFlexFiles(0),
+                _numPrefetches(0), _bytesPrefetched(0), _retain(options.retain) {}
 
     ~MemManReal() override {unlockAll();}
 
 private:
 
+    void   _evictRetained();
+    bool   _takeRetained(int chunk);
+
+
     Memory           _memory;
     std::atomic_uint _numErrors;
     std::atomic_uint _numLkerrs;
     uint32_t         _numLocks;      // Under control of hanMutex
     uint32_t         _numReqdFiles;  // Ditto
     uint32_t         _numFlexFiles;  // Ditto
+    std::atomic_uint _numPrefetches;
+    std::atomic<uint64_t> _bytesPrefetched;
+    bool const       _retain;        // Set at construction time
+    std::list<MemFileSet*> _retained; // Under control of hanMutex, newest first
+    uint32_t         _numRetainHits{0}; // Ditto
+    uint32_t         _numRetainMiss{0}; // Ditto
+    uint32_t         _numEvictions{0};  // Ditto
 };
 
 }}} // namespace lsst:qserv:memman
@@ -25,16 +25,21 @@
 #include "memman/Memory.h"
 
 // System Headers
+#include <algorithm>
 #include <errno.h>
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <thread>
+#include <vector>
 
 // LSST headers
 #include "lsst/log/Log.h"
 
 // qserv headers
+#include "util/Metrics.h"
+#include "util/Numa.h"
 #include "util/Timer.h"
 
 namespace {
@@ -47,6 +52,47 @@ namespace memman {
 
 std::mutex Memory::_mlockMtx;
 
+/******************************************************************************/
+/*                              _ f a u l t I n                               */
+/******************************************************************************/
+
+#ifndef MADV_POPULATE_READ
+#define MADV_POPULATE_READ 22
+#endif
+
+void Memory::_faultIn(MemInfo const& mInfo) {
+
+    // Fault in a range of pages, with a single call when the kernel supports
+    // it or by reading a byte of each page otherwise.
+    //
+    auto faultRange = [](char* addr, uint64_t len) {
+        if (madvise(addr, len, MADV_POPULATE_READ) == 0) return;
+        uint64_t const pageSize = sysconf(_SC_PAGESIZE);
+        char sum = 0;
+        for (uint64_t off = 0; off < len; off += pageSize) {
+            sum += *static_cast<volatile char*>(addr + off);
+        }
+        (void)sum;
+    };
+
+    // Large files are split in page aligned slices, one per fault thread,
+    // so that the reads of the slices overlap.
+    //
+    char* addr = static_cast<char*>(mInfo._memAddr);
+    uint64_t const pageSize = sysconf(_SC_PAGESIZE);
+    uint64_t slice = (mInfo._memSize / _faultThreads + pageSize - 1) / pageSize * pageSize;
+    if (_faultThreads == 1 || slice < pageSize*256) {
+        faultRange(addr, mInfo._memSize);
+        return;
+    }
+    std::vector<std::thread> threads;
+    for (uint64_t off = 0; off < mInfo._memSize; off += slice) {
+        uint64_t len = std::min(slice, mInfo._memSize - off);
+        threads.emplace_back(faultRange, addr + off, len);
+    }
+    for (auto& thrd : threads) thrd.join();
+}
+
 /******************************************************************************/
 /*                              f i l e I n f o                               */
 /******************************************************************************/
@@ -98,9 +144,10 @@ std::string Memory::filePath(std::string const& dbTable,
 /******************************************************************************/
 /*                               m e m L o c k                                */
 /******************************************************************************/
-util::TimerHistogram mlockHisto("mlock Hist", {1, 10, 20, 40});
+util::Histogram::Ptr const mlockHisto = util::MetricsRegistry::get().histogram(
+        "qserv_memman_mlock_seconds", "Time to fault in and lock a file", {0.1, 1, 10, 20, 40});
 
-int Memory::memLock(MemInfo& mInfo, bool isFlex) {
+int Memory::memLock(MemInfo& mInfo, bool isFlex, int numaNode) {
 
     // Verify that this is a valid mapping
     //
@@ -108,8 +155,16 @@ int Memory::memLock(MemInfo& mInfo, bool isFlex) {
 
     // Lock this map into memory. Return success if this worked.
     //
+    // Populating is done before getting the mlock mutex, so that it overlaps
+    // the locking of other files. mlock() then only pins resident pages. The
+    // time it took counts as locking time.
+    //
     int result = 0;
     util::Timer timer;
+    util::Timer faultTimer;
+    faultTimer.start();
+    if (_populate) _faultIn(mInfo);
+    faultTimer.stop();
     {
         std::lock_guard<std::mutex> lg(_mlockMtx);
         LOGS(_log, LOG_LVL_DEBUG, "mlock start");
@@ -117,14 +172,25 @@ int Memory::memLock(MemInfo& mInfo, bool isFlex) {
         result = mlock(mInfo._memAddr, mInfo._memSize);
         timer.stop();
     }
-    mInfo._mlockTime = timer.getElapsed();
-    auto logMsg = mlockHisto.addTime(mInfo._mlockTime, LOG_CHECK_DEBUG() ? "a":"");
-    LOGS(_log, LOG_LVL_DEBUG, logMsg);
+    mInfo._mlockTime = faultTimer.getElapsed() + timer.getElapsed();
+    mlockHisto->observe(mInfo._mlockTime);
+    LOGS(_log, LOG_LVL_DEBUG, "mlock done " << mInfo._mlockTime << "s");
 
     if (!result) {
+        // The pages are resident now, move them next to the threads that
+        // will scan them.
+        //
+        if (numaNode >= 0) util::Numa::get().placeMemory(mInfo._memAddr, mInfo._memSize, numaNode);
         std::lock_guard<std::mutex> guard(_memMutex);
         _lokBytes += mInfo._memSize;
         if (isFlex) _flexNum++;
+        _numMlocks++;
+        _mlockBytes += mInfo._memSize;
+        _mlockSeconds += mInfo._mlockTime;
+        if (mInfo._mlockTime > 0) {
+            double mbSec = mInfo._memSize/(1048576.0*mInfo._mlockTime);
+            if (_mlockMinMBSec == 0 || mbSec < _mlockMinMBSec) _mlockMinMBSec = mbSec;
+        }
         return 0;
     }
 
@@ -168,11 +234,14 @@ MemInfo Memory::mapFile(std::string const& fPath) {
     //
     mInfo._memAddr = mmap(0, mInfo._memSize, PROT_READ, MAP_SHARED, fdNum, 0);
 
-    // Diagnose any errors or update statistics.
+    // Diagnose any errors or update statistics. Huge pages are only a hint;
+    // most file systems do not support them for file mappings and refuse it.
     //
     if (mInfo._memAddr == MAP_FAILED) {
         mInfo.setErrCode(errno);
         _numMapErrs++;
+    } else if (_hugePages) {
+        madvise(mInfo._memAddr, mInfo._memSize, MADV_HUGEPAGE);
     }
 
     // Close the file and return result
@@ -181,6 +250,23 @@ MemInfo Memory::mapFile(std::string const& fPath) {
     return mInfo;
 }
 
+/******************************************************************************/
+/*                             r e a d A h e a d                              */
+/******************************************************************************/
+
+int Memory::readAhead(std::string const& fPath) {
+
+    int fdNum = open(fPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fdNum < 0) return errno;
+
+    // The advice only queues the reads. The pages are not locked and are
+    // dropped like any other page cache page when memory becomes short.
+    //
+    int rc = posix_fadvise(fdNum, 0, 0, POSIX_FADV_WILLNEED);
+    close(fdNum);
+    return rc;
+}
+
 /******************************************************************************/
 /*                                m e m R e l                                 */
 /******************************************************************************/
@@ -150,12 +150,13 @@ public:
     //!
     //! @param  mInfo  - The memory mapping returned by mapFile().
     //! @param  isFlex - When true account for flexible files in the statistics.
+    //! @param  numaNode - NUMA node the locked pages are moved to, if not -1.
     //!
     //! @return =0     - Memory was locked.
     //! @return !0     - Memory not locked, retuned value is the errno.
     //-----------------------------------------------------------------------------
 
-    int     memLock(MemInfo& mInfo, bool isFlex);
+    int     memLock(MemInfo& mInfo, bool isFlex, int numaNode=-1);
 
     //-----------------------------------------------------------------------------
     //! @brief Map a database file in memory.
@@ -169,6 +170,18 @@ public:
 
     MemInfo mapFile(std::string const& fPath);
 
+    //-----------------------------------------------------------------------------
+    //! @brief Ask the kernel to start reading a database file into the page
+    //!        cache. The call does not wait for the read nor lock anything.
+    //!
+    //! @param  fPath  - Path of the database file to be read ahead.
+    //!
+    //! @return =0     - Read ahead was started.
+    //! @return !0     - Read ahead failed, retuned value is the errno.
+    //-----------------------------------------------------------------------------
+
+    int     readAhead(std::string const& fPath);
+
     //-----------------------------------------------------------------------------
     //! @brief Unlock a memory object.
     //!
@@ -203,6 +216,17 @@ public:
                           else _rsvBytes -= memSZ;
                       }
 
+    //-----------------------------------------------------------------------------
+    //! @brief Change the number of bytes being managed.
+    //!
+    //! @param  memSZ   - Size of memory to manage in bytes.
+    //-----------------------------------------------------------------------------
+
+    void    setMaxBytes(uint64_t memSZ) {
+                       std::lock_guard<std::mutex> guard(_memMutex);
+                       _maxBytes = memSZ;
+                      }
+
     //-----------------------------------------------------------------------------
     //! @bried Obtain memory statistics.
     //!
@@ -216,14 +240,22 @@ public:
         uint32_t numMapErrors;   //!< Number of mmap()  calls that failed
         uint32_t numLokErrors;   //!< Number of mlock() calls that failed
         uint32_t numFlexFiles;   //!< Number of Flexible files encountered
+        uint32_t numMlocks;      //!< Number of files locked
+        uint64_t bytesMlocked;   //!< Number of bytes in the files locked
+        double   secondsMlock;   //!< Seconds spent locking files
+        double   minMBSecMlock;  //!< Lowest MB/sec locking a file, 0 if none
     };
 
     MemStats statistics() {
         MemStats mStats;
-        mStats.bytesMax      = _maxBytes;
         _memMutex.lock();
+        mStats.bytesMax      = _maxBytes;
         mStats.bytesReserved = _rsvBytes;
         mStats.bytesLocked   = _lokBytes;
+        mStats.numMlocks     = _numMlocks;
+        mStats.bytesMlocked  = _mlockBytes;
+        mStats.secondsMlock  = _mlockSeconds;
+        mStats.minMBSecMlock = _mlockMinMBSec;
         _memMutex.unlock();
         mStats.numMapErrors  = _numMapErrs;
         mStats.numLokErrors  = _numLokErrs;
@@ -236,24 +268,38 @@ public:
     //!
     //! @param  dbDir  - Directory path to where managed files reside.
     //! @param  memSZ  - Size of memory to manage in bytes.
+    //! @param  populate - When true, fault in all pages before locking them.
+    //! @param  hugePages- When true, ask for transparent huge pages.
+    //! @param  faultThreads - Number of threads faulting in a file's pages.
     //-----------------------------------------------------------------------------
 
-    Memory(std::string const& dbDir, uint64_t memSZ)
+    Memory(std::string const& dbDir, uint64_t memSZ, bool populate=false,
+           bool hugePages=false, int faultThreads=1)
           : _dbDir(dbDir), _maxBytes(memSZ), _lokBytes(0), _rsvBytes(0),
-            _numMapErrs(0), _numLokErrs(0), _flexNum(0) {}
+            _numMapErrs(0), _numLokErrs(0), _flexNum(0), _populate(populate),
+            _hugePages(hugePages), _faultThreads(faultThreads < 1 ? 1 : faultThreads) {}
 
     ~Memory() {}
 
 private:
 
+    void               _faultIn(MemInfo const& mInfo);
+
     std::string        _dbDir;
     std::mutex         _memMutex;
-    uint64_t           _maxBytes;    // Set at construction time
+    uint64_t           _maxBytes;    // Protected by _memMutex
     uint64_t           _lokBytes;    // Protected by _memMutex
     uint64_t           _rsvBytes;    // Ditto
     std::atomic_uint   _numMapErrs;
     std::atomic_uint   _numLokErrs;
     std::atomic_uint   _flexNum;
+    bool const         _populate;    // Set at construction time
+    bool const         _hugePages;   // Ditto
+    int const          _faultThreads;// Ditto
+    uint32_t           _numMlocks{0};     // Protected by _memMutex
+    uint64_t           _mlockBytes{0};    // Ditto
+    double             _mlockSeconds{0};  // Ditto
+    double             _mlockMinMBSec{0}; // Ditto
 
     static std::mutex  _mlockMtx;    // Prevent multiple concurrent mlock calls.
 };
@@ -75,13 +75,17 @@ LocalInfile::LocalInfile(char const* filename,
                          std::shared_ptr<RowBuffer> rowBuffer)
     : _filename(filename),
       _rowBuffer(rowBuffer) {
-    // Should have buffer >= sizeof(single row)
-    const int defaultBuffer = infileBufferSize;
-    _buffer = new char[defaultBuffer];
-    _bufferSize = defaultBuffer;
+    assert(_rowBuffer);
+    _buffer = 0;
+    _bufferSize = 0;
     _leftover = 0;
     _leftoverSize = 0;
-    assert(_rowBuffer);
+    if (!_rowBuffer->fetchesDirect()) {
+        // Should have buffer >= sizeof(single row)
+        const int defaultBuffer = infileBufferSize;
+        _buffer = new char[defaultBuffer];
+        _bufferSize = defaultBuffer;
+    }
 }
 
 LocalInfile::~LocalInfile() {
@@ -92,6 +96,10 @@ LocalInfile::~LocalInfile() {
 
 int LocalInfile::read(char* buf, unsigned int bufLen) {
     assert(_rowBuffer);
+    if (!_buffer) {
+        // The row buffer fills the buffer of mysql, nothing is copied here.
+        return _rowBuffer->fetch(buf, bufLen);
+    }
     // Read into *buf
     unsigned copySize = bufLen;
     unsigned copied = 0;
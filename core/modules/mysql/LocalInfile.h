@@ -76,7 +76,7 @@ public:
     inline bool isValid() const { return static_cast<bool>(_rowBuffer); }
 
 private:
-    char* _buffer; ///< Internal buffer for passing to mysql
+    char* _buffer; ///< Internal buffer for passing to mysql, null if the row buffer fetches directly
     int _bufferSize; ///< Allocated size of internal buffer
     char* _leftover; ///< Ptr to bytes not yet sent to mysql
     unsigned _leftoverSize; ///< Size of bytes not yet sent in _leftover
@@ -118,6 +118,7 @@ bool MySqlConnection::checkConnection(mysql::MySqlConfig const& mysqlconfig) {
 void
 MySqlConnection::closeMySqlConn() {
     // Close mysql connection and set deallocated pointer to null
+    _closeStatements();
     mysql_close(_mysql);
     _mysql = nullptr;
 }
@@ -150,6 +151,22 @@ MySqlConnection::queryUnbuffered(std::string const& query) {
     return true;
 }
 
+MYSQL_RES*
+MySqlConnection::queryBuffered(std::string const& query) {
+    {
+        std::lock_guard<std::mutex> lock(_interruptMutex);
+        _isExecuting = true;
+        _interrupted = false;
+    }
+    MYSQL_RES* res = nullptr;
+    if (mysql_real_query(_mysql, query.c_str(), query.length()) == 0) {
+        res = mysql_store_result(_mysql);
+    }
+    std::lock_guard<std::mutex> lock(_interruptMutex);
+    _isExecuting = false;
+    return res;
+}
+
 /// Cancel existing query
 /// @return 0 on success.
 /// 1 indicates error in connecting. (may try again)
@@ -191,11 +208,84 @@ MySqlConnection::selectDb(std::string const& dbName) {
     return true;
 }
 
+bool
+MySqlConnection::changeUser(std::string const& username, std::string const& dbName) {
+    // The server drops the statements of the session, the handles must go too.
+    _closeStatements();
+    if (!_isConnected ||
+        mysql_change_user(_mysql, username.c_str(), _sqlConfig->password.c_str(),
+                          dbName.empty() ? nullptr : dbName.c_str())) {
+        return false;
+    }
+    _sqlConfig->username = username;
+    _sqlConfig->dbName = dbName;
+    return true;
+}
+
+void
+MySqlConnection::setStatementCacheSize(size_t size) {
+    _stmtCacheSize = size;
+    while (_stmts.size() > _stmtCacheSize) {
+        if (_stmts.back().second != nullptr) {
+            mysql_stmt_close(_stmts.back().second);
+        }
+        _stmtIndex.erase(_stmts.back().first);
+        _stmts.pop_back();
+    }
+}
+
+MYSQL_STMT*
+MySqlConnection::prepareCached(std::string const& query) {
+    if (_stmtCacheSize == 0 || _mysql == nullptr) {
+        return nullptr;
+    }
+    auto iter = _stmtIndex.find(query);
+    if (iter != _stmtIndex.end()) {
+        ++_stmtHits;
+        _stmts.splice(_stmts.begin(), _stmts, iter->second);
+        return _stmts.front().second;
+    }
+    MYSQL_STMT* stmt = mysql_stmt_init(_mysql);
+    if (stmt != nullptr && mysql_stmt_prepare(stmt, query.c_str(), query.size()) != 0) {
+        LOGS(_log, LOG_LVL_DEBUG, "not prepared: " << mysql_stmt_error(stmt));
+        mysql_stmt_close(stmt);
+        stmt = nullptr;
+    }
+    // Queries that cannot be prepared are remembered so they are not tried again.
+    _stmts.emplace_front(query, stmt);
+    _stmtIndex[query] = _stmts.begin();
+    setStatementCacheSize(_stmtCacheSize);
+    return stmt;
+}
+
+bool
+MySqlConnection::executeStatement(MYSQL_STMT* stmt) {
+    {
+        std::lock_guard<std::mutex> lock(_interruptMutex);
+        _isExecuting = true;
+        _interrupted = false;
+    }
+    bool ok = (mysql_stmt_execute(stmt) == 0);
+    std::lock_guard<std::mutex> lock(_interruptMutex);
+    _isExecuting = false;
+    return ok;
+}
+
 ////////////////////////////////////////////////////////////////////////
 // MySqlConnection
 // private:
 ////////////////////////////////////////////////////////////////////////
 
+void MySqlConnection::_closeStatements() {
+    for (auto const& elem : _stmts) {
+        if (elem.second != nullptr) {
+            mysql_stmt_close(elem.second);
+        }
+    }
+    _stmts.clear();
+    _stmtIndex.clear();
+}
+
 MYSQL* MySqlConnection::_connectHelper() {
     // We must call mysql_library_init() exactly once before calling mysql_init
     // because it is not thread safe. Both mysql_library_init and mysql_init
@@ -30,9 +30,13 @@
 // System headers
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <utility>
 
 // Third-party headers
 #include "boost/utility.hpp"
@@ -72,6 +76,13 @@ public:
     MySqlConfig const& getMySqlConfig() const { return *_sqlConfig; }
 
     bool queryUnbuffered(std::string const& query);
+
+    /// Run 'query' and read its whole result into client memory. Unlike the
+    /// result of queryUnbuffered(), it stays valid while other queries run on
+    /// this connection.
+    /// @return the result, to be freed with mysql_free_result(), or nullptr
+    ///         if the query failed.
+    MYSQL_RES* queryBuffered(std::string const& query);
     int cancel();
 
     MYSQL_RES* getResult() { return _mysql_res; }
@@ -85,8 +96,32 @@ public:
     MySqlConfig const& getConfig() const { return *_sqlConfig; }
     bool selectDb(std::string const& dbName);
 
+    /// Switch to 'username' and 'dbName', which also resets the session: open
+    /// transactions are rolled back, temporary tables dropped, table locks
+    /// released and session variables reset. The password is unchanged.
+    /// Prepared statements are closed.
+    /// @return false if the connection is broken or the user was refused.
+    bool changeUser(std::string const& username, std::string const& dbName);
+
+    /// Keep up to 'size' prepared statements, 0 closes them all.
+    void setStatementCacheSize(size_t size);
+
+    /// @return the statement prepared for 'query', preparing it unless it was
+    ///         used recently, or nullptr if MySQL cannot prepare it, such as
+    ///         for several statements. The statement belongs to this
+    ///         connection and is valid until the next call.
+    MYSQL_STMT* prepareCached(std::string const& query);
+
+    /// Execute 'stmt' from prepareCached(), it can be cancelled by cancel().
+    /// @return false on error, see mysql_stmt_error().
+    bool executeStatement(MYSQL_STMT* stmt);
+
+    /// @return the number of prepareCached() calls answered from the cache.
+    uint64_t getStatementCacheHits() const { return _stmtHits; }
+
 private:
     MYSQL* _connectHelper();
+    void _closeStatements();
     static std::mutex _mysqlShared;
     static bool _mysqlReady;
 
@@ -97,6 +132,12 @@ private:
     bool _isExecuting; ///< true during mysql_real_query and mysql_use_result
     bool _interrupted; ///< true if cancellation requested
     std::mutex _interruptMutex;
+
+    size_t _stmtCacheSize{0};
+    /// Query text and its statement, nullptr if it cannot be prepared, most recently used first.
+    std::list<std::pair<std::string, MYSQL_STMT*>> _stmts;
+    std::map<std::string, decltype(_stmts)::iterator> _stmtIndex;
+    uint64_t _stmtHits{0};
 };
 
 }}} // namespace lsst::qserv::mysql
@@ -0,0 +1,107 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "mysql/MySqlConnectionPool.h"
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+namespace {
+LOG_LOGGER _log = LOG_GET("lsst.qserv.mysql.MySqlConnectionPool");
+}
+
+namespace lsst {
+namespace qserv {
+namespace mysql {
+
+std::unique_ptr<MySqlConnection> MySqlConnectionPool::acquire(std::string const& username,
+                                                              std::string const& dbName) {
+    while (true) {
+        std::unique_ptr<MySqlConnection> conn;
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            if (_idle.empty()) {
+                break;
+            }
+            auto best = _idle.begin();
+            int bestScore = -1;
+            for (auto iter = _idle.begin(); iter != _idle.end(); ++iter) {
+                MySqlConfig const& cfg = (*iter)->getMySqlConfig();
+                int score = (cfg.dbName == dbName ? 2 : 0) + (cfg.username == username ? 1 : 0);
+                if (score > bestScore) {
+                    best = iter;
+                    bestScore = score;
+                }
+            }
+            conn = std::move(*best);
+            _idle.erase(best);
+        }
+        // Switching user is also the health check, a dead connection fails it.
+        // A kept session is checked by selecting its database again.
+        MySqlConfig const& cfg = conn->getMySqlConfig();
+        bool const keep = _keepSession && cfg.username == username && cfg.dbName == dbName;
+        if (keep ? conn->selectDb(dbName) : conn->changeUser(username, dbName)) {
+            std::lock_guard<std::mutex> lock(_mtx);
+            ++_stats.reused;
+            return conn;
+        }
+        LOGS(_log, LOG_LVL_WARN, "dropping pooled connection: " << conn->getError());
+        std::lock_guard<std::mutex> lock(_mtx);
+        ++_stats.dropped;
+    }
+
+    MySqlConfig config(_config);
+    config.username = username;
+    config.dbName = dbName;
+    std::unique_ptr<MySqlConnection> conn(new MySqlConnection(config));
+    if (!conn->connect()) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(_mtx);
+    ++_stats.opened;
+    return conn;
+}
+
+
+void MySqlConnectionPool::release(std::unique_ptr<MySqlConnection> conn) {
+    if (conn == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(_mtx);
+    if (!conn->connected() || conn->getResult() != nullptr || _idle.size() >= _maxIdle) {
+        ++_stats.dropped;
+        return; // Closed outside of the pool when conn goes out of scope.
+    }
+    _idle.push_front(std::move(conn));
+}
+
+
+MySqlConnectionPool::Stats MySqlConnectionPool::getStats() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    Stats stats = _stats;
+    stats.idle = _idle.size();
+    return stats;
+}
+
+}}} // namespace lsst::qserv::mysql
@@ -0,0 +1,94 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_QSERV_MYSQL_MYSQLCONNECTIONPOOL_H
+#define LSST_QSERV_MYSQL_MYSQLCONNECTIONPOOL_H
+
+// System headers
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Qserv headers
+#include "mysql/MySqlConfig.h"
+#include "mysql/MySqlConnection.h"
+
+namespace lsst {
+namespace qserv {
+namespace mysql {
+
+/// MySqlConnectionPool keeps the connections of finished queries open so that
+/// the next query skips connecting and authenticating. A borrowed connection
+/// is switched to the user and database of the query, which also resets the
+/// session so nothing leaks between queries, and a connection that fails the
+/// switch is closed and replaced. Idle connections already on the requested
+/// database, then with the same user, are preferred.
+///
+/// With keepSession, a connection already of the same user on the same
+/// database keeps its session, so that its prepared statements survive.
+class MySqlConnectionPool {
+public:
+    using Ptr = std::shared_ptr<MySqlConnectionPool>;
+
+    struct Stats {
+        uint64_t reused{0};  ///< Connections taken from the pool.
+        uint64_t opened{0};  ///< Connections opened because none was idle.
+        uint64_t dropped{0}; ///< Connections closed as broken or unneeded.
+        size_t idle{0};      ///< Connections currently idle.
+    };
+
+    /// @param config - how to connect, username and dbName are set per query.
+    /// @param maxIdle - connections kept open, normally the thread pool size.
+    /// @param keepSession - true to not reset the session of a connection
+    ///                      that already has the user and database.
+    MySqlConnectionPool(MySqlConfig const& config, size_t maxIdle, bool keepSession=false)
+        : _config(config), _maxIdle(maxIdle), _keepSession(keepSession) {}
+
+    MySqlConnectionPool(MySqlConnectionPool const&) = delete;
+    MySqlConnectionPool& operator=(MySqlConnectionPool const&) = delete;
+
+    /// @return a connection for 'username' on 'dbName', or nullptr if no
+    ///         connection could be made.
+    std::unique_ptr<MySqlConnection> acquire(std::string const& username, std::string const& dbName);
+
+    /// Give back a connection from acquire(). It is closed if it still holds a
+    /// result or the pool already has maxIdle connections.
+    void release(std::unique_ptr<MySqlConnection> conn);
+
+    Stats getStats() const;
+
+private:
+    MySqlConfig const _config;
+    size_t const _maxIdle;
+    bool const _keepSession;
+
+    mutable std::mutex _mtx; ///< Protects members below.
+    std::list<std::unique_ptr<MySqlConnection>> _idle; ///< Most recently released first.
+    Stats _stats;
+};
+
+}}} // namespace lsst::qserv::mysql
+
+#endif // LSST_QSERV_MYSQL_MYSQLCONNECTIONPOOL_H
@@ -77,6 +77,11 @@ public:
     /// fetched. Returning less than bufLen does NOT indicate EOF.
     virtual unsigned fetch(char* buffer, unsigned bufLen) = 0;
 
+    /// @return true if fetch() fills any size of buffer and only returns 0
+    /// once there are no bytes left, so that LocalInfile can give it the
+    /// buffer of mysql instead of one of its own.
+    virtual bool fetchesDirect() const { return false; }
+
     /// Construct a RowBuffer tied to a MySQL query result
     static Ptr newResRowBuffer(MYSQL_RES* result);
 
@@ -0,0 +1,228 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "mysql/StatementResult.h"
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "util/NumberFormat.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.mysql.StatementResult");
+
+/// Initial size of the buffers of text columns, larger values are fetched again.
+size_t const TEXT_BUFFER_SIZE = 256;
+
+} // anonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace mysql {
+
+StatementResult::Ptr StatementResult::create(MYSQL_STMT* stmt) {
+    MYSQL_RES* meta = mysql_stmt_result_metadata(stmt);
+    if (meta == nullptr) {
+        return nullptr; // Not a SELECT
+    }
+    Ptr result(new StatementResult(stmt, meta));
+    unsigned int const numFields = mysql_num_fields(meta);
+    MYSQL_FIELD const* fields = mysql_fetch_fields(meta);
+    result->_cols.resize(numFields);
+    for (unsigned int j = 0; j < numFields; ++j) {
+        MYSQL_FIELD const& field = fields[j];
+        Column& col = result->_cols[j];
+        bool const zerofill = (field.flags & ZEROFILL_FLAG) != 0;
+        // A FLOAT(M,D) or DOUBLE(M,D) column is shown with D decimals.
+        bool const fixedDecimals = field.decimals < NOT_FIXED_DEC;
+        switch (field.type) {
+        case MYSQL_TYPE_TINY:
+        case MYSQL_TYPE_SHORT:
+        case MYSQL_TYPE_LONG:
+        case MYSQL_TYPE_INT24:
+        case MYSQL_TYPE_LONGLONG:
+            if (zerofill) {
+                return nullptr;
+            }
+            col.kind = (field.flags & UNSIGNED_FLAG) ? Kind::UINT : Kind::INT;
+            break;
+        case MYSQL_TYPE_DOUBLE:
+            if (zerofill || fixedDecimals) {
+                return nullptr;
+            }
+            col.kind = Kind::DOUBLE;
+            break;
+        case MYSQL_TYPE_FLOAT:
+            if (zerofill || fixedDecimals) {
+                return nullptr;
+            }
+            col.kind = Kind::FLOAT;
+            break;
+        case MYSQL_TYPE_NULL:
+        case MYSQL_TYPE_DECIMAL:
+        case MYSQL_TYPE_NEWDECIMAL:
+        case MYSQL_TYPE_VARCHAR:
+        case MYSQL_TYPE_VAR_STRING:
+        case MYSQL_TYPE_STRING:
+        case MYSQL_TYPE_ENUM:
+        case MYSQL_TYPE_SET:
+        case MYSQL_TYPE_TINY_BLOB:
+        case MYSQL_TYPE_MEDIUM_BLOB:
+        case MYSQL_TYPE_LONG_BLOB:
+        case MYSQL_TYPE_BLOB:
+            // Sent as text in both protocols.
+            col.kind = Kind::TEXT;
+            col.text.resize(TEXT_BUFFER_SIZE);
+            break;
+        default:
+            LOGS(_log, LOG_LVL_DEBUG, "column " << field.name << " type " << field.type
+                 << " is read with the text protocol");
+            return nullptr;
+        }
+    }
+    if (!result->_bind()) {
+        return nullptr;
+    }
+    return result;
+}
+
+
+StatementResult::StatementResult(MYSQL_STMT* stmt, MYSQL_RES* meta)
+    : _stmt(stmt), _meta(meta) {
+}
+
+
+StatementResult::~StatementResult() {
+    mysql_stmt_free_result(_stmt);
+    mysql_free_result(_meta);
+}
+
+
+/// Bind the buffers of _cols to the statement, again after a text buffer grew.
+bool StatementResult::_bind() {
+    size_t const numFields = _cols.size();
+    _binds.assign(numFields, MYSQL_BIND());
+    for (size_t j = 0; j < numFields; ++j) {
+        Column& col = _cols[j];
+        MYSQL_BIND& bind = _binds[j];
+        bind.is_null = &col.isNull;
+        bind.length = &col.length;
+        bind.error = &col.truncated;
+        switch (col.kind) {
+        case Kind::INT:
+        case Kind::UINT:
+            bind.buffer_type = MYSQL_TYPE_LONGLONG;
+            bind.buffer = &col.intVal;
+            bind.is_unsigned = (col.kind == Kind::UINT);
+            break;
+        case Kind::DOUBLE:
+            bind.buffer_type = MYSQL_TYPE_DOUBLE;
+            bind.buffer = &col.doubleVal;
+            break;
+        case Kind::FLOAT:
+            bind.buffer_type = MYSQL_TYPE_FLOAT;
+            bind.buffer = &col.floatVal;
+            break;
+        case Kind::TEXT:
+            bind.buffer_type = MYSQL_TYPE_STRING;
+            bind.buffer = col.text.data();
+            bind.buffer_length = col.text.size();
+            break;
+        }
+    }
+    _numbers.resize(numFields * util::NumberFormat::BUFFER_SIZE);
+    _row.resize(numFields);
+    _lengths.resize(numFields);
+    if (mysql_stmt_bind_result(_stmt, _binds.data()) != 0) {
+        LOGS(_log, LOG_LVL_WARN, "binding results failed: " << mysql_stmt_error(_stmt));
+        return false;
+    }
+    return true;
+}
+
+
+bool StatementResult::fetch(MYSQL_ROW& row, unsigned long*& lengths) {
+    int rc = mysql_stmt_fetch(_stmt);
+    if (rc == MYSQL_NO_DATA) {
+        return false;
+    }
+    if (rc == 1) {
+        _error = true;
+        return false;
+    }
+    bool rebind = false;
+    for (size_t j = 0; j < _cols.size(); ++j) {
+        Column& col = _cols[j];
+        if (col.isNull) {
+            _row[j] = nullptr;
+            _lengths[j] = 0;
+            continue;
+        }
+        char* buf = &_numbers[j * util::NumberFormat::BUFFER_SIZE];
+        switch (col.kind) {
+        case Kind::INT:
+            _lengths[j] = util::NumberFormat::formatInt(col.intVal, buf);
+            break;
+        case Kind::UINT:
+            _lengths[j] = util::NumberFormat::formatUInt(static_cast<unsigned long long>(col.intVal), buf);
+            break;
+        case Kind::DOUBLE:
+            _lengths[j] = util::NumberFormat::formatDouble(col.doubleVal, buf);
+            break;
+        case Kind::FLOAT:
+            _lengths[j] = util::NumberFormat::formatFloat(col.floatVal, buf);
+            break;
+        case Kind::TEXT:
+            if (col.length > col.text.size()) {
+                // Too long for the buffer, fetch it again into a larger one.
+                col.text.resize(col.length);
+                MYSQL_BIND& bind = _binds[j];
+                bind.buffer = col.text.data();
+                bind.buffer_length = col.text.size();
+                if (mysql_stmt_fetch_column(_stmt, &bind, j, 0) != 0) {
+                    _error = true;
+                    return false;
+                }
+                rebind = true;
+            }
+            buf = col.text.data();
+            _lengths[j] = col.length;
+            break;
+        }
+        _row[j] = buf;
+    }
+    // The library keeps the bound addresses, they must be given again once
+    // a buffer moved.
+    if (rebind && !_bind()) {
+        _error = true;
+        return false;
+    }
+    row = _row.data();
+    lengths = _lengths.data();
+    return true;
+}
+
+}}} // namespace lsst::qserv::mysql
@@ -0,0 +1,102 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_MYSQL_STATEMENTRESULT_H
+#define LSST_QSERV_MYSQL_STATEMENTRESULT_H
+
+// System headers
+#include <memory>
+#include <string>
+#include <vector>
+
+// Third-party headers
+#include <mysql/mysql.h>
+
+namespace lsst {
+namespace qserv {
+namespace mysql {
+
+/// StatementResult reads the rows of a prepared statement, which arrive in
+/// the binary protocol, and gives them in the text form of mysql_fetch_row().
+/// Integer and floating point values are formatted here from their binary
+/// value, saving the server the conversion to text. Other columns are sent
+/// as text by the server, or converted by the client library.
+class StatementResult {
+public:
+    using Ptr = std::unique_ptr<StatementResult>;
+
+    /// @param stmt - a prepared statement, its results are bound to this object.
+    /// @return a result for 'stmt', or nullptr if it has a column whose text
+    ///         could differ from that of the text protocol, such as a date or
+    ///         a ZEROFILL integer.
+    static Ptr create(MYSQL_STMT* stmt);
+
+    /// Discards the rows not fetched.
+    ~StatementResult();
+
+    StatementResult(StatementResult const&) = delete;
+    StatementResult& operator=(StatementResult const&) = delete;
+
+    MYSQL_STMT* getStatement() const { return _stmt; }
+
+    /// @return the fields of the result, as for SchemaFactory::newFromResult().
+    MYSQL_RES* getMetadata() const { return _meta; }
+    int getNumFields() const { return _cols.size(); }
+
+    /// Fetch the next row of the executed statement. NULL values are nullptr.
+    /// @return false at the end of the rows, or on error if isError().
+    bool fetch(MYSQL_ROW& row, unsigned long*& lengths);
+
+    bool isError() const { return _error; }
+
+private:
+    enum class Kind { INT, UINT, DOUBLE, FLOAT, TEXT };
+
+    /// Buffers bound to one result column.
+    struct Column {
+        Kind kind{Kind::TEXT};
+        long long intVal{0};
+        double doubleVal{0.0};
+        float floatVal{0.0f};
+        std::vector<char> text;
+        unsigned long length{0};
+        my_bool isNull{0};
+        my_bool truncated{0};
+    };
+
+    StatementResult(MYSQL_STMT* stmt, MYSQL_RES* meta);
+
+    bool _bind();
+
+    MYSQL_STMT* _stmt;
+    MYSQL_RES* _meta;
+    std::vector<Column> _cols;
+    std::vector<MYSQL_BIND> _binds;
+    std::vector<char> _numbers; ///< Text of the numeric values of the current row
+    std::vector<char*> _row;
+    std::vector<unsigned long> _lengths;
+    bool _error{false};
+};
+
+}}} // namespace lsst::qserv::mysql
+
+#endif // LSST_QSERV_MYSQL_STATEMENTRESULT_H
@@ -23,6 +23,7 @@
 
 #include "parser/QSMySqlListener.h"
 
+#include <algorithm>
 #include <cxxabi.h>
 #include <sstream>
 #include <string>
@@ -2392,7 +2393,12 @@ public:
         ASSERT_EXECUTION_CONDITION(!_functionName.empty(), "Function name unpopulated", _ctx);
         ASSERT_EXECUTION_CONDITION(!_args.empty(), "Function arguments unpopulated", _ctx);
         auto funcExpr = query::FuncExpr::newWithArgs(_functionName, _args);
-        auto valueFactor = query::ValueFactor::newFuncFactor(funcExpr);
+        // APPROX_COUNT_DISTINCT is not a MySQL function, it is an aggregate
+        // implemented by Qserv (see query::AggOp).
+        string upperName(_functionName);
+        transform(upperName.begin(), upperName.end(), upperName.begin(), ::toupper);
+        auto valueFactor = (upperName == "APPROX_COUNT_DISTINCT") ?
+                query::ValueFactor::newAggFactor(funcExpr) : query::ValueFactor::newFuncFactor(funcExpr);
         lockedParent()->handleUdfFunctionCall(valueFactor);
     }
 
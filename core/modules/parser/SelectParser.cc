@@ -37,6 +37,8 @@
 #include "parser/SelectParser.h"
 
 // System headers
+#include <atomic>
+#include <chrono>
 #include <cstdio>
 #include <functional>
 #include <strings.h>
@@ -96,6 +98,17 @@ VecPairStr getTokenPairs(antlr4::CommonTokenStream & tokens, QSMySqlLexer & lexe
     return ret;
 }
 
+// Parse counts and times of the antlr4 parser, see SelectParser::getParseStats.
+std::atomic<uint64_t> sllParses{0};
+std::atomic<uint64_t> llParses{0};
+std::atomic<uint64_t> sllMicros{0};
+std::atomic<uint64_t> llMicros{0};
+
+uint64_t microsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+}
+
 }
 
 namespace lsst {
@@ -309,9 +322,35 @@ public:
         CommonTokenStream tokens(&lexer);
         tokens.fill();
         LOGS(_log, LOG_LVL_TRACE, "Parsed tokens:" << util::printable(getTokenPairs(tokens, lexer)));
+        // Try the faster SLL prediction first, bailing out on the first
+        // error, and only parse again with full LL prediction if it fails.
+        // SLL fails on a few valid statements, but when it succeeds the
+        // parse tree is the one LL would build.
         QSMySqlParser parser(&tokens);
-        parser.setErrorHandler(std::make_shared<Antlr4ErrorStrategy>(_statement));
-        tree::ParseTree *tree = parser.root();
+        auto const parseStart = std::chrono::steady_clock::now();
+        auto start = parseStart;
+        parser.getInterpreter<atn::ParserATNSimulator>()->setPredictionMode(atn::PredictionMode::SLL);
+        parser.removeErrorListeners();
+        parser.setErrorHandler(std::make_shared<BailErrorStrategy>());
+        tree::ParseTree *tree = nullptr;
+        try {
+            tree = parser.root();
+            ++sllParses;
+            sllMicros += microsSince(start);
+        } catch (ParseCancellationException const&) {
+            sllMicros += microsSince(start);
+            LOGS(_log, LOG_LVL_DEBUG, "SLL prediction failed, parsing again with LL prediction");
+            start = std::chrono::steady_clock::now();
+            tokens.seek(0);
+            parser.reset();
+            parser.addErrorListener(&ConsoleErrorListener::INSTANCE);
+            parser.setErrorHandler(std::make_shared<Antlr4ErrorStrategy>(_statement));
+            parser.getInterpreter<atn::ParserATNSimulator>()->setPredictionMode(atn::PredictionMode::LL);
+            tree = parser.root();
+            ++llParses;
+            llMicros += microsSince(start);
+        }
+        LOGS(_log, LOG_LVL_DEBUG, "parse took " << microsSince(parseStart) << "us");
         tree::ParseTreeWalker walker;
         walker.walk(_listener.get(), tree);
     }
@@ -387,6 +426,45 @@ SelectParser::SelectParser(std::string const& statement, AntlrVersion v)
 }
 
 
+SelectParser::ParseStats SelectParser::getParseStats() {
+    ParseStats stats;
+    stats.sllParses = sllParses;
+    stats.llParses = llParses;
+    stats.sllMicros = sllMicros;
+    stats.llMicros = llMicros;
+    return stats;
+}
+
+
+void SelectParser::warmUp() {
+    // Statements using the most common constructs of user queries.
+    static std::vector<std::string> const statements = {
+        "SELECT objectId, ra_PS, decl_PS FROM LSST.Object WHERE objectId IN (1, 2, 3)",
+        "SELECT COUNT(*) AS n, AVG(ra_PS) FROM LSST.Object "
+            "WHERE qserv_areaspec_box(0, 0, 1, 1) AND uFlux_PS BETWEEN 1e-30 AND 2e-30 "
+            "GROUP BY chunkId ORDER BY n DESC LIMIT 10",
+        "SELECT o1.objectId, o2.objectId, "
+            "scisql_angSep(o1.ra_PS, o1.decl_PS, o2.ra_PS, o2.decl_PS) AS dist "
+            "FROM LSST.Object o1, LSST.Object o2 "
+            "WHERE scisql_angSep(o1.ra_PS, o1.decl_PS, o2.ra_PS, o2.decl_PS) < 0.1 "
+            "AND o1.objectId <> o2.objectId",
+        "SELECT s.sourceId, o.ra_PS FROM LSST.Source s JOIN LSST.Object o USING (objectId) "
+            "WHERE o.objectId = 2 OR (s.flags & 4) = 0 AND NOT s.x > 1.5"
+    };
+    auto start = std::chrono::steady_clock::now();
+    for (auto const& statement : statements) {
+        try {
+            makeSelectStmt(statement, ANTLR4);
+        } catch (std::exception const& e) {
+            // The prediction cache is still built by the parse, even if
+            // building the statement failed.
+            LOGS(_log, LOG_LVL_DEBUG, "warm up parse failed for " << statement << ": " << e.what());
+        }
+    }
+    LOGS(_log, LOG_LVL_INFO, "parser warm up took " << microsSince(start) << "us");
+}
+
+
 void SelectParser::setup() {
     _aParser->setup();
     _aParser->run();
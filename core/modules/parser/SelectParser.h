@@ -32,6 +32,7 @@
   */
 
 // System headers
+#include <cstdint>
 #include <memory>
 #include <sstream>
 
@@ -76,6 +77,22 @@ public:
     /// This function calls SelectParser::setup; so it may throw any exception thrown by that function.
     static std::shared_ptr<query::SelectStmt> makeSelectStmt(std::string const& statement, AntlrVersion v);
 
+    /// Parse counts and times of the antlr4 parser, over all instances.
+    struct ParseStats {
+        uint64_t sllParses{0}; ///< Statements parsed with SLL prediction
+        uint64_t llParses{0};  ///< Statements parsed again with LL prediction after SLL failed
+        uint64_t sllMicros{0}; ///< Time spent in SLL parses, including failed ones
+        uint64_t llMicros{0};  ///< Time spent in LL parses
+    };
+
+    /// @return the parse counts and times since the process started.
+    static ParseStats getParseStats();
+
+    /// Parse a few typical statements with the antlr4 parser, so that its
+    /// prediction cache, shared by all instances, is built before the first
+    /// user query arrives. Does not throw.
+    static void warmUp();
+
     /// Setup the parser and parse into a SelectStmt
     /// May throw a ParseException (including adapter_order_error and adapter_execution_error)
     void setup();
@@ -25,8 +25,14 @@
 #define LSST_QSERV_PROTO_FAKEPROTOCOLFIXTURE_H
 
 // System headers
+#include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
+
+// Qserv headers
+#include "proto/worker.pb.h"
 
 namespace lsst {
 namespace qserv {
@@ -37,6 +43,16 @@ namespace proto {
 /// only to be used for test code.
 class FakeProtocolFixture {
 public:
+    /// One column of the Result messages made by makeResult().
+    struct FakeColumn {
+        enum Kind { INTEGER, REAL, STRING };
+        Kind kind;
+        std::string sqlType;   ///< e.g. "BIGINT", "DOUBLE", "VARCHAR(32)"
+        int mysqlType;         ///< MYSQL_TYPE_* of sqlType, < 0 to leave it unset.
+        unsigned width;        ///< Characters of STRING values.
+        double nullRatio;      ///< Fraction of the values that are NULL.
+    };
+
     FakeProtocolFixture() : _counter(0) {}
 
     TaskMsg* makeTaskMsg() {
@@ -94,8 +110,86 @@ public:
         p->set_largeresult(false);
         return p;
     }
+    /// @return a Result with 'rows' rows of pseudo-random values of 'columns',
+    /// as one ColumnBlock per column if 'columnar', else as RowBundles.
+    /// About 'escapeRatio' of the STRING values hold a character that must be
+    /// escaped for LOAD DATA INFILE.
+    Result* makeResult(std::vector<FakeColumn> const& columns, unsigned rows,
+                       bool columnar, double escapeRatio=0.0) {
+        Result* r(new Result());
+        r->set_continues(false);
+        r->set_session(123456);
+        r->set_queryid(49);
+        r->set_jobid(0);
+        r->set_attemptcount(0);
+        r->set_largeresult(false);
+        r->set_transmitsize(0);
+        r->set_rowcount(rows);
+        for (size_t c = 0; c < columns.size(); ++c) {
+            auto cs = r->mutable_rowschema()->add_columnschema();
+            cs->set_name("c" + std::to_string(c));
+            cs->set_deprecated_hasdefault(false);
+            cs->set_sqltype(columns[c].sqlType);
+            if (columns[c].mysqlType >= 0) cs->set_mysqltype(columns[c].mysqlType);
+            if (columnar) r->add_columnblock();
+        }
+        RowBundle* row = nullptr;
+        for (unsigned i = 0; i < rows; ++i) {
+            if (!columnar) row = r->add_row();
+            for (size_t c = 0; c < columns.size(); ++c) {
+                bool const isNull = _uniform() < columns[c].nullRatio;
+                std::string const value = isNull ? std::string() : _makeValue(columns[c], escapeRatio);
+                if (columnar) {
+                    ColumnBlock* block = r->mutable_columnblock(c);
+                    block->mutable_values()->append(value);
+                    block->add_offsets(block->values().size());
+                    if (isNull) {
+                        std::string& bitmap = *block->mutable_nullbitmap();
+                        bitmap.resize(std::max<size_t>(bitmap.size(), i / 8 + 1), '\0');
+                        bitmap[i / 8] |= static_cast<char>(1 << (i % 8));
+                    }
+                } else {
+                    row->add_column(value);
+                    row->add_isnull(isNull);
+                }
+            }
+        }
+        return r;
+    }
+
 private:
+    std::string _makeValue(FakeColumn const& column, double escapeRatio) {
+        switch (column.kind) {
+        case FakeColumn::INTEGER:
+            return std::to_string(static_cast<int64_t>(_next() >> 20) - (int64_t(1) << 43));
+        case FakeColumn::REAL:
+            return std::to_string((_uniform() - 0.5) * 360.0);
+        case FakeColumn::STRING:
+            break;
+        }
+        std::string value(column.width, 'a');
+        for (auto& ch : value) {
+            ch = static_cast<char>('a' + _next() % 26);
+        }
+        if (!value.empty() && _uniform() < escapeRatio) {
+            char const specials[] = {'\t', '\n', '\\', '\0'};
+            value[_next() % value.size()] = specials[_next() % sizeof(specials)];
+        }
+        return value;
+    }
+
+    /// xorshift64*, so that the same calls make the same messages everywhere.
+    uint64_t _next() {
+        _seed ^= _seed >> 12;
+        _seed ^= _seed << 25;
+        _seed ^= _seed >> 27;
+        return _seed * 2685821657736338717ULL;
+    }
+
+    double _uniform() { return (_next() >> 11) * (1.0 / 9007199254740992.0); }
+
     int _counter;
+    uint64_t _seed{88172645463325252ULL};
 };
 
 }}} // lsst::qserv::proto
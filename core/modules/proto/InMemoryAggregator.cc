@@ -0,0 +1,411 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "proto/InMemoryAggregator.h"
+
+// System headers
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+
+// Third-party headers
+#include <mysql/mysql.h>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "util/HyperLogLog.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.proto.InMemoryAggregator");
+
+/// DECIMAL values with more digits than this are not folded, which leaves
+/// room in the 128 bit mantissa for sums and scale adjustments.
+int const MAX_DECIMAL_DIGITS = 30;
+
+__int128 pow10(int n) {
+    __int128 val = 1;
+    for (int j = 0; j < n; ++j) val *= 10;
+    return val;
+}
+
+/// Bring 'a' and 'b' to the same scale.
+void alignScale(__int128& a, int& aScale, __int128& b, int& bScale) {
+    if (aScale < bScale) {
+        a *= pow10(bScale - aScale);
+        aScale = bScale;
+    } else if (bScale < aScale) {
+        b *= pow10(aScale - bScale);
+        bScale = aScale;
+    }
+}
+
+} // annonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace proto {
+
+InMemoryAggregator::InMemoryAggregator(FoldVector const& fold, size_t maxGroups)
+    : _fold(fold), _maxGroups(maxGroups) {
+}
+
+
+bool InMemoryAggregator::setSchema(proto::RowSchema const& schema) {
+    if (static_cast<size_t>(schema.columnschema_size()) != _fold.size()) {
+        LOGS(_log, LOG_LVL_DEBUG, "column count " << schema.columnschema_size()
+             << " does not match fold count " << _fold.size());
+        return false;
+    }
+    _schema = schema;
+    _kinds.clear();
+    for (size_t col = 0; col < _fold.size(); ++col) {
+        if (_fold[col] == Fold::KEY) {
+            _kinds.push_back(Kind::RAW);
+            continue;
+        }
+        if (_fold[col] == Fold::HLL) {
+            _kinds.push_back(Kind::SKETCH);
+            continue;
+        }
+        proto::ColumnSchema const& cs = schema.columnschema(col);
+        if (!cs.has_mysqltype()) {
+            return false;
+        }
+        switch (cs.mysqltype()) {
+        case MYSQL_TYPE_TINY:
+        case MYSQL_TYPE_SHORT:
+        case MYSQL_TYPE_LONG:
+        case MYSQL_TYPE_INT24:
+        case MYSQL_TYPE_LONGLONG:
+            _kinds.push_back(Kind::INT);
+            break;
+        case MYSQL_TYPE_FLOAT:
+        case MYSQL_TYPE_DOUBLE:
+            _kinds.push_back(Kind::REAL);
+            break;
+        case MYSQL_TYPE_DECIMAL:
+        case MYSQL_TYPE_NEWDECIMAL:
+            _kinds.push_back(Kind::DECIMAL);
+            break;
+        default:
+            LOGS(_log, LOG_LVL_DEBUG, "column " << cs.name() << " type " << cs.mysqltype()
+                 << " cannot be folded");
+            return false;
+        }
+    }
+    return true;
+}
+
+
+bool InMemoryAggregator::fold(int jobIdAttempt, proto::Result const& result) {
+    int const rowCount = (result.columnblock_size() > 0) ? result.rowcount() : result.row_size();
+    // Parse everything before touching the groups, so that a failure leaves
+    // the groups as they were.
+    std::vector<std::pair<std::string, Row>> parsed(rowCount);
+    for (int j = 0; j < rowCount; ++j) {
+        if (!_parseRow(result, j, parsed[j].first, parsed[j].second)) {
+            return false;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(_mtx);
+    Groups& groups = _jobGroups[jobIdAttempt];
+    std::set<std::string> newKeys;
+    for (auto const& elem : parsed) {
+        if (groups.find(elem.first) == groups.end()) {
+            newKeys.insert(elem.first);
+        }
+    }
+    if (_groupCount + newKeys.size() > _maxGroups) {
+        LOGS(_log, LOG_LVL_INFO, "too many groups to fold " << _groupCount << "+" << newKeys.size()
+             << " max=" << _maxGroups);
+        if (groups.empty()) _jobGroups.erase(jobIdAttempt);
+        return false;
+    }
+    for (auto& elem : parsed) {
+        auto iter = groups.find(elem.first);
+        if (iter == groups.end()) {
+            groups.emplace(std::move(elem.first), std::move(elem.second));
+        } else {
+            _combine(iter->second, elem.second);
+        }
+    }
+    _groupCount += newKeys.size();
+    _foldedRows += rowCount;
+    return true;
+}
+
+
+void InMemoryAggregator::erase(std::set<int> const& jobIdAttempts) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    for (int jobIdAttempt : jobIdAttempts) {
+        auto iter = _jobGroups.find(jobIdAttempt);
+        if (iter != _jobGroups.end()) {
+            _groupCount -= iter->second.size();
+            _jobGroups.erase(iter);
+        }
+    }
+}
+
+
+void InMemoryAggregator::extractAll(proto::Result& result) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    Groups all;
+    for (auto& jobElem : _jobGroups) {
+        for (auto& elem : jobElem.second) {
+            auto iter = all.find(elem.first);
+            if (iter == all.end()) {
+                all.emplace(elem.first, std::move(elem.second));
+            } else {
+                _combine(iter->second, elem.second);
+            }
+        }
+    }
+    _jobGroups.clear();
+    _groupCount = 0;
+    _fillResult(all, result);
+}
+
+
+void InMemoryAggregator::extractEach(std::function<void(int, proto::Result&)> const& func) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    for (auto const& jobElem : _jobGroups) {
+        proto::Result result;
+        _fillResult(jobElem.second, result);
+        func(jobElem.first, result);
+    }
+    _jobGroups.clear();
+    _groupCount = 0;
+}
+
+
+size_t InMemoryAggregator::getGroupCount() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _groupCount;
+}
+
+
+uint64_t InMemoryAggregator::getFoldedRowCount() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _foldedRows;
+}
+
+
+bool InMemoryAggregator::_parseRow(proto::Result const& result, int rowIdx,
+                                   std::string& key, Row& row) const {
+    bool const columnar = result.columnblock_size() > 0;
+    size_t const colCount = columnar ? result.columnblock_size() : result.row(rowIdx).column_size();
+    if (colCount != _fold.size()) {
+        return false;
+    }
+    row.resize(colCount);
+    for (size_t col = 0; col < colCount; ++col) {
+        char const* data = nullptr;
+        size_t len = 0;
+        bool isNull = false;
+        if (columnar) {
+            proto::ColumnBlock const& block = result.columnblock(col);
+            std::string const& nullBitmap = block.nullbitmap();
+            size_t byteIdx = rowIdx / 8;
+            isNull = byteIdx < nullBitmap.size() && (nullBitmap[byteIdx] & (1 << (rowIdx % 8)));
+            uint32_t begin = (rowIdx == 0) ? 0 : block.offsets(rowIdx - 1);
+            data = block.values().data() + begin;
+            len = block.offsets(rowIdx) - begin;
+        } else {
+            proto::RowBundle const& rb = result.row(rowIdx);
+            isNull = rb.isnull(col);
+            data = rb.column(col).data();
+            len = rb.column(col).size();
+        }
+        Cell& cell = row[col];
+        cell.isNull = isNull;
+        if (_fold[col] == Fold::KEY) {
+            // Null flag and length make the key unambiguous.
+            uint32_t keyLen = isNull ? 0 : len;
+            key += isNull ? 'N' : 'V';
+            key.append(reinterpret_cast<char const*>(&keyLen), sizeof(keyLen));
+            if (!isNull) {
+                key.append(data, len);
+                cell.raw.assign(data, len);
+            }
+        } else if (!isNull && !_parseCell(col, data, len, cell)) {
+            LOGS(_log, LOG_LVL_WARN, "could not parse column " << col << " value "
+                 << std::string(data, len));
+            return false;
+        }
+    }
+    return true;
+}
+
+
+bool InMemoryAggregator::_parseCell(size_t col, char const* data, size_t len, Cell& cell) const {
+    std::string str(data, len);
+    char* end = nullptr;
+    errno = 0;
+    switch (_kinds[col]) {
+    case Kind::INT:
+        cell.intVal = std::strtoll(str.c_str(), &end, 10);
+        return errno == 0 && end != str.c_str() && *end == '\0';
+    case Kind::REAL:
+        cell.realVal = std::strtod(str.c_str(), &end);
+        return errno == 0 && end != str.c_str() && *end == '\0';
+    case Kind::DECIMAL: {
+        size_t pos = 0;
+        bool negative = false;
+        if (pos < len && (data[pos] == '-' || data[pos] == '+')) {
+            negative = data[pos] == '-';
+            ++pos;
+        }
+        __int128 val = 0;
+        int digits = 0;
+        int scale = 0;
+        bool inFraction = false;
+        for (; pos < len; ++pos) {
+            char c = data[pos];
+            if (c == '.' && !inFraction) {
+                inFraction = true;
+            } else if (c >= '0' && c <= '9') {
+                val = val * 10 + (c - '0');
+                if (inFraction) ++scale;
+                if (++digits > MAX_DECIMAL_DIGITS) return false;
+            } else {
+                return false;
+            }
+        }
+        if (digits == 0) return false;
+        cell.decVal = negative ? -val : val;
+        cell.scale = scale;
+        return true;
+    }
+    case Kind::SKETCH:
+        if (!util::HyperLogLog::isSketch(data, len)) return false;
+        cell.raw.assign(data, len);
+        return true;
+    default:
+        return false;
+    }
+}
+
+
+void InMemoryAggregator::_combine(Row& into, Row const& from) const {
+    for (size_t col = 0; col < _fold.size(); ++col) {
+        if (_fold[col] != Fold::KEY) {
+            _combineCell(col, into[col], from[col]);
+        }
+    }
+}
+
+
+/// NULL values are ignored, as they are by SQL aggregate functions. The
+/// result is NULL only if all values were NULL.
+void InMemoryAggregator::_combineCell(size_t col, Cell& into, Cell const& from) const {
+    if (from.isNull) return;
+    if (into.isNull) {
+        into = from;
+        return;
+    }
+    Fold const fold = _fold[col];
+    switch (_kinds[col]) {
+    case Kind::INT:
+        if (fold == Fold::SUM) into.intVal += from.intVal;
+        else if (fold == Fold::MIN) into.intVal = std::min(into.intVal, from.intVal);
+        else if (fold == Fold::MAX) into.intVal = std::max(into.intVal, from.intVal);
+        break;
+    case Kind::REAL:
+        if (fold == Fold::SUM) into.realVal += from.realVal;
+        else if (fold == Fold::MIN) into.realVal = std::min(into.realVal, from.realVal);
+        else if (fold == Fold::MAX) into.realVal = std::max(into.realVal, from.realVal);
+        break;
+    case Kind::DECIMAL: {
+        __int128 fromVal = from.decVal;
+        int fromScale = from.scale;
+        alignScale(into.decVal, into.scale, fromVal, fromScale);
+        if (fold == Fold::SUM) into.decVal += fromVal;
+        else if (fold == Fold::MIN) into.decVal = std::min(into.decVal, fromVal);
+        else if (fold == Fold::MAX) into.decVal = std::max(into.decVal, fromVal);
+        break;
+    }
+    case Kind::SKETCH: {
+        util::HyperLogLog hll(into.raw[0]);
+        if (hll.merge(into.raw.data(), into.raw.size())
+            && hll.merge(from.raw.data(), from.raw.size())) {
+            into.raw = hll.serialize();
+        } else {
+            LOGS(_log, LOG_LVL_WARN, "column " << col << " sketches of different precisions");
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+
+void InMemoryAggregator::_fillResult(Groups const& groups, proto::Result& result) const {
+    *result.mutable_rowschema() = _schema;
+    for (auto const& elem : groups) {
+        proto::RowBundle* rb = result.add_row();
+        for (size_t col = 0; col < _fold.size(); ++col) {
+            Cell const& cell = elem.second[col];
+            rb->add_isnull(cell.isNull);
+            rb->add_column(cell.isNull ? std::string() : _format(col, cell));
+        }
+    }
+    result.set_rowcount(result.row_size());
+}
+
+
+std::string InMemoryAggregator::_format(size_t col, Cell const& cell) const {
+    switch (_kinds[col]) {
+    case Kind::INT:
+        return std::to_string(cell.intVal);
+    case Kind::REAL: {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.17g", cell.realVal);
+        return buf;
+    }
+    case Kind::DECIMAL: {
+        __int128 val = cell.decVal;
+        bool const negative = val < 0;
+        if (negative) val = -val;
+        std::string digits;
+        do {
+            digits += static_cast<char>('0' + static_cast<int>(val % 10));
+            val /= 10;
+        } while (val != 0);
+        while (digits.size() <= static_cast<size_t>(cell.scale)) digits += '0';
+        std::reverse(digits.begin(), digits.end());
+        if (cell.scale > 0) digits.insert(digits.size() - cell.scale, ".");
+        return negative ? "-" + digits : digits;
+    }
+    default:
+        return cell.raw;
+    }
+}
+
+}}} // namespace lsst::qserv::proto
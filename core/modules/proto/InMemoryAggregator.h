@@ -0,0 +1,134 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_PROTO_INMEMORYAGGREGATOR_H
+#define LSST_QSERV_PROTO_INMEMORYAGGREGATOR_H
+
+// System headers
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Qserv headers
+#include "proto/worker.pb.h"
+
+namespace lsst {
+namespace qserv {
+namespace proto {
+
+/// InMemoryAggregator folds the partial aggregates of chunk results into
+/// one row per group, so that the merge table only receives the folded rows
+/// instead of every row sent by the workers. Rows are grouped by the values
+/// of their KEY columns; the other columns are combined with SUM, MIN or MAX,
+/// or are HyperLogLog sketches that are merged.
+/// The merge statement still runs over the folded rows, which keeps HAVING,
+/// ORDER BY and the final expression types in MySQL's hands.
+///
+/// Groups are kept per job attempt so that the rows of an invalid attempt
+/// can still be discarded after they were folded.
+///
+/// It is used by the czar to fold the results it merges, and by the workers
+/// to fold the results of the chunks of one user query before sending them.
+class InMemoryAggregator {
+public:
+    /// How the per-chunk values of a column are combined with each other.
+    /// KEY values are not combined, rows only fold together when all of
+    /// their KEY values are equal. HLL values are serialized HyperLogLog
+    /// sketches, combined by merging them. The values match those of
+    /// TaskMsg::AggFold.
+    enum class Fold { KEY, SUM, MIN, MAX, HLL };
+    typedef std::vector<Fold> FoldVector;
+
+    /// @param fold - how to combine each result column.
+    /// @param maxGroups - fold() refuses results that would make the total
+    ///                    number of groups kept exceed this.
+    InMemoryAggregator(FoldVector const& fold, size_t maxGroups);
+
+    InMemoryAggregator(InMemoryAggregator const&) = delete;
+    InMemoryAggregator& operator=(InMemoryAggregator const&) = delete;
+
+    /// Check that the parallel columns described by 'schema' can be folded.
+    /// @return false if there is a column count mismatch or a column that
+    ///         is not KEY has a type that cannot be combined exactly.
+    bool setSchema(proto::RowSchema const& schema);
+
+    /// Fold the rows of 'result' into the groups of 'jobIdAttempt'.
+    /// @return false, leaving all groups unchanged, if the rows could not
+    ///         be parsed or would make the group count exceed maxGroups.
+    bool fold(int jobIdAttempt, proto::Result const& result);
+
+    /// Discard the groups of the given job attempts.
+    void erase(std::set<int> const& jobIdAttempts);
+
+    /// Combine the groups of all job attempts into 'result', one row per
+    /// group, and clear them.
+    void extractAll(proto::Result& result);
+
+    /// Call 'func' with the groups of each job attempt, one row per group,
+    /// and clear them.
+    void extractEach(std::function<void(int jobIdAttempt, proto::Result& result)> const& func);
+
+    size_t getGroupCount() const;
+    uint64_t getFoldedRowCount() const;
+
+private:
+    /// How a column value is stored while it is being accumulated.
+    enum class Kind { RAW, INT, REAL, DECIMAL, SKETCH };
+
+    /// Accumulated value of one column of a group.
+    struct Cell {
+        bool isNull{true};
+        int64_t intVal{0};
+        double realVal{0.0};
+        __int128 decVal{0}; ///< DECIMAL mantissa, value is decVal / 10^scale
+        int scale{0};
+        std::string raw; ///< Value of a KEY column or a serialized sketch
+    };
+    using Row = std::vector<Cell>;
+    using Groups = std::unordered_map<std::string, Row>;
+
+    bool _parseRow(proto::Result const& result, int rowIdx, std::string& key, Row& row) const;
+    bool _parseCell(size_t col, char const* data, size_t len, Cell& cell) const;
+    void _combine(Row& into, Row const& from) const;
+    void _combineCell(size_t col, Cell& into, Cell const& from) const;
+    void _fillResult(Groups const& groups, proto::Result& result) const;
+    std::string _format(size_t col, Cell const& cell) const;
+
+    FoldVector const _fold;
+    size_t const _maxGroups;
+    proto::RowSchema _schema;
+    std::vector<Kind> _kinds; ///< Kind of each column, set by setSchema()
+
+    mutable std::mutex _mtx; ///< Protects members below
+    std::map<int, Groups> _jobGroups; ///< Groups for each job attempt
+    size_t _groupCount{0}; ///< Total number of groups in _jobGroups
+    uint64_t _foldedRows{0}; ///< Number of worker rows folded so far
+};
+
+}}} // namespace lsst::qserv::proto
+
+#endif // LSST_QSERV_PROTO_INMEMORYAGGREGATOR_H
@@ -0,0 +1,104 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "proto/ResultCompression.h"
+
+// System headers
+#include <stdexcept>
+
+// Third-party headers
+#include <zlib.h>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+namespace {
+LOG_LOGGER _log = LOG_GET("lsst.qserv.proto.ResultCompression");
+}
+
+namespace lsst {
+namespace qserv {
+namespace proto {
+
+const size_t ResultCompression::MIN_COMPRESS_SIZE = 1024;
+
+
+ResultCompression::Codec ResultCompression::codecFromName(std::string const& name) {
+    if (name.empty() || name == "none") return ProtoHeader::NONE;
+    if (name == "zlib") return ProtoHeader::ZLIB;
+    throw std::invalid_argument("ResultCompression: unknown codec '" + name + "'");
+}
+
+
+std::string ResultCompression::codecName(Codec codec) {
+    switch (codec) {
+    case ProtoHeader::NONE: return "none";
+    case ProtoHeader::ZLIB: return "zlib";
+    }
+    return "unknown";
+}
+
+
+bool ResultCompression::compress(Codec codec, int level, std::string const& in, std::string& out) {
+    if (codec == ProtoHeader::NONE || in.size() < MIN_COMPRESS_SIZE) return false;
+    if (codec == ProtoHeader::ZLIB) {
+        uLongf outLen = compressBound(in.size());
+        out.resize(outLen);
+        int rc = compress2(reinterpret_cast<Bytef*>(&out[0]), &outLen,
+                           reinterpret_cast<Bytef const*>(in.data()), in.size(), level);
+        if (rc != Z_OK) {
+            LOGS(_log, LOG_LVL_WARN, "compress2 failed rc=" << rc << " size=" << in.size());
+            out.clear();
+            return false;
+        }
+        if (outLen >= in.size()) {
+            out.clear();
+            return false;
+        }
+        out.resize(outLen);
+        return true;
+    }
+    return false;
+}
+
+
+bool ResultCompression::decompress(Codec codec, char const* in, size_t inLen,
+                                   size_t outLen, std::vector<char>& out) {
+    if (codec == ProtoHeader::ZLIB) {
+        out.resize(outLen);
+        uLongf destLen = outLen;
+        int rc = uncompress(reinterpret_cast<Bytef*>(out.data()), &destLen,
+                            reinterpret_cast<Bytef const*>(in), inLen);
+        if (rc != Z_OK || destLen != outLen) {
+            LOGS(_log, LOG_LVL_ERROR, "uncompress failed rc=" << rc << " expected=" << outLen
+                 << " got=" << destLen);
+            return false;
+        }
+        return true;
+    }
+    LOGS(_log, LOG_LVL_ERROR, "decompress unsupported codec " << codec);
+    return false;
+}
+
+}}} // namespace lsst::qserv::proto
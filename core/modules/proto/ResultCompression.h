@@ -0,0 +1,75 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_QSERV_PROTO_RESULTCOMPRESSION_H
+#define LSST_QSERV_PROTO_RESULTCOMPRESSION_H
+ /**
+  * @file
+  *
+  * @brief Compression of serialized Result messages.
+  *
+  */
+
+// System headers
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "proto/worker.pb.h"
+
+namespace lsst {
+namespace qserv {
+namespace proto {
+
+/// ResultCompression compresses serialized Result messages on the worker
+/// and restores them on the czar. The codec is recorded in
+/// ProtoHeader.compression so that the czar knows how to read the message.
+class ResultCompression {
+public:
+    using Codec = ProtoHeader::Compression;
+
+    /// Messages smaller than this are not worth compressing.
+    static const size_t MIN_COMPRESS_SIZE;
+
+    /// @return the codec for a configuration name ("none" or "zlib").
+    /// @throws std::invalid_argument if the name is not recognized.
+    static Codec codecFromName(std::string const& name);
+
+    /// @return the configuration name of a codec.
+    static std::string codecName(Codec codec);
+
+    /// Compress 'in' into 'out' using 'codec' at compression 'level'.
+    /// @return false if the codec failed or would not make the message smaller,
+    ///         in which case the message should be sent uncompressed.
+    static bool compress(Codec codec, int level, std::string const& in, std::string& out);
+
+    /// Decompress 'inLen' bytes at 'in' into 'out', which is resized to
+    /// 'outLen', the size of the original message.
+    /// @return false if the data could not be decompressed to exactly 'outLen' bytes.
+    static bool decompress(Codec codec, char const* in, size_t inLen,
+                           size_t outLen, std::vector<char>& out);
+};
+
+}}} // namespace lsst::qserv::proto
+
+#endif // LSST_QSERV_PROTO_RESULTCOMPRESSION_H
@@ -68,11 +68,23 @@ struct ScanInfo {
     /// Threshold priority values. Scan priorities are not limited to these values.
     enum Rating { FASTEST = 0, FAST = 10, MEDIUM = 20, SLOW = 30, SLOWEST = 100 };
 
+    /// How the tables are read, which decides whether the worker locks
+    /// their data files, their index files, or both.
+    enum Access {
+        SCAN = 0,  ///< Full scan of the data files.
+        INDEX = 1, ///< Lookups through the indexes (secondary index, objectId).
+        MIXED = 2  ///< Index lookups joined with scans (near-neighbor).
+    };
+
     void sortTablesSlowestFirst();
-    int compareTables(ScanInfo const& rhs);
+    int compareTables(ScanInfo const& rhs) const;
 
     ScanTableInfo::ListOf infoTables;
     int scanRating{Rating::FASTEST};
+    Access access{Access::SCAN};
+    /// Tables read through their indexes, kept when the scan tables of a
+    /// small query are dropped.
+    ScanTableInfo::ListOf indexTables;
 };
 
 
@@ -0,0 +1,75 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_PROTO_TASKMSGARENA_H
+#define LSST_QSERV_PROTO_TASKMSGARENA_H
+
+// System headers
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+
+// Third-party headers
+#include <google/protobuf/arena.h>
+
+// Qserv headers
+#include "proto/worker.pb.h"
+
+namespace lsst {
+namespace qserv {
+namespace proto {
+
+/// A TaskMsg and the arena holding it. The decoded message takes several
+/// times its wire size, the first block is sized for that, so that parsing
+/// a request costs one or two allocations instead of one per string.
+struct TaskMsgArena {
+    explicit TaskMsgArena(size_t wireSize)
+        : arena(options(wireSize)),
+          msg(*google::protobuf::Arena::CreateMessage<TaskMsg>(&arena)) {}
+    TaskMsgArena(TaskMsgArena const&) = delete;
+    TaskMsgArena& operator=(TaskMsgArena const&) = delete;
+
+    static google::protobuf::ArenaOptions options(size_t wireSize) {
+        google::protobuf::ArenaOptions opts;
+        opts.start_block_size = std::max<size_t>(4 * wireSize + 1024, 4096);
+        opts.max_block_size = std::max<size_t>(opts.start_block_size, 1024 * 1024);
+        return opts;
+    }
+
+    google::protobuf::Arena arena; ///< Must be declared before 'msg'.
+    TaskMsg& msg;
+};
+
+/// @return the TaskMsg decoded from 'data' on a TaskMsgArena, which is freed
+///         with the last copy of the pointer, or nullptr if 'data' is not a
+///         complete TaskMsg.
+inline std::shared_ptr<TaskMsg> parseTaskMsg(char const* data, int size) {
+    auto holder = std::make_shared<TaskMsgArena>(size);
+    if (!holder->msg.ParseFromArray(data, size) || !holder->msg.IsInitialized()) {
+        return nullptr;
+    }
+    return std::shared_ptr<TaskMsg>(holder, &holder->msg);
+}
+
+}}} // namespace lsst::qserv::proto
+
+#endif // LSST_QSERV_PROTO_TASKMSGARENA_H
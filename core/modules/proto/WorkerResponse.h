@@ -24,6 +24,9 @@
 #ifndef LSST_QSERV_PROTO_WORKERRESPONSE_H
 #define LSST_QSERV_PROTO_WORKERRESPONSE_H
 
+// Third-party headers
+#include <google/protobuf/arena.h>
+
 // Qserv headers
 #include "proto/worker.pb.h"
 
@@ -31,10 +34,29 @@ namespace lsst {
 namespace qserv {
 namespace proto {
 
+/// @return arena options sized for Result messages, which are usually close to
+///         ProtoHeaderWrap::PROTOBUFFER_DESIRED_LIMIT bytes.
+inline google::protobuf::ArenaOptions makeResultArenaOptions() {
+    google::protobuf::ArenaOptions options;
+    options.start_block_size = 64 * 1024;
+    options.max_block_size = 1024 * 1024;
+    return options;
+}
+
+/// One Result message and its header as received from a worker.
+/// 'result' is parsed onto 'arena', so the rows and strings of the message
+/// are freed together with the WorkerResponse.
 struct WorkerResponse {
+    WorkerResponse()
+        : arena(makeResultArenaOptions()),
+          result(*google::protobuf::Arena::CreateMessage<Result>(&arena)) {}
+    WorkerResponse(WorkerResponse const&) = delete;
+    WorkerResponse& operator=(WorkerResponse const&) = delete;
+
+    google::protobuf::Arena arena; ///< Must be declared before 'result'.
     unsigned char headerSize;
     ProtoHeader protoHeader;
-    Result result;
+    Result& result;
 };
 
 }}} // lsst::qserv::proto
@@ -0,0 +1,207 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+// System headers
+#include <map>
+#include <string>
+#include <vector>
+
+// Third-party headers
+#include <mysql/mysql.h>
+
+// Qserv headers
+#include "proto/worker.pb.h"
+#include "proto/InMemoryAggregator.h"
+#include "util/HyperLogLog.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE InMemoryAggregator
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::proto::Result;
+using lsst::qserv::proto::RowBundle;
+using lsst::qserv::proto::InMemoryAggregator;
+using Fold = InMemoryAggregator::Fold;
+
+struct Fixture {
+    Fixture() {
+        // band, COUNT, SUM(double), MIN(int), SUM(decimal)
+        fold = {Fold::KEY, Fold::SUM, Fold::SUM, Fold::MIN, Fold::SUM};
+        addColumn("band", "CHAR(1)", MYSQL_TYPE_STRING);
+        addColumn("QS1_COUNT", "BIGINT", MYSQL_TYPE_LONGLONG);
+        addColumn("QS2_SUM", "DOUBLE", MYSQL_TYPE_DOUBLE);
+        addColumn("QS3_MIN", "INT", MYSQL_TYPE_LONG);
+        addColumn("QS4_SUM", "DECIMAL(20,2)", MYSQL_TYPE_NEWDECIMAL);
+    }
+
+    void addColumn(std::string const& name, std::string const& sqlType, int mysqlType) {
+        auto cs = result.mutable_rowschema()->add_columnschema();
+        cs->set_name(name);
+        cs->set_deprecated_hasdefault(false);
+        cs->set_sqltype(sqlType);
+        cs->set_mysqltype(mysqlType);
+    }
+
+    void addRow(Result& res, std::vector<std::string> const& values) {
+        RowBundle* rb = res.add_row();
+        for (auto const& val : values) {
+            rb->add_column(val == "NULL" ? "" : val);
+            rb->add_isnull(val == "NULL");
+        }
+    }
+
+    /// @return the rows of 'res' keyed by their first column.
+    std::map<std::string, std::vector<std::string>> rows(Result const& res) {
+        std::map<std::string, std::vector<std::string>> out;
+        for (int j = 0; j < res.row_size(); ++j) {
+            RowBundle const& rb = res.row(j);
+            std::vector<std::string> vals;
+            for (int c = 0; c < rb.column_size(); ++c) {
+                vals.push_back(rb.isnull(c) ? "NULL" : rb.column(c));
+            }
+            out[vals[0]] = vals;
+        }
+        return out;
+    }
+
+    InMemoryAggregator::FoldVector fold;
+    Result result; ///< Holds the schema
+};
+
+
+BOOST_FIXTURE_TEST_SUITE(suite, Fixture)
+
+BOOST_AUTO_TEST_CASE(FoldGroups) {
+    InMemoryAggregator agg(fold, 100);
+    BOOST_REQUIRE(agg.setSchema(result.rowschema()));
+
+    Result r1 = result;
+    addRow(r1, {"g", "10", "1.5", "7", "1.25"});
+    addRow(r1, {"r", "4", "2", "3", "-0.5"});
+    Result r2 = result;
+    addRow(r2, {"g", "5", "0.25", "2", "10"});
+    addRow(r2, {"i", "1", "NULL", "NULL", "NULL"});
+    BOOST_CHECK(agg.fold(10, r1));
+    BOOST_CHECK(agg.fold(20, r2));
+    BOOST_CHECK_EQUAL(agg.getGroupCount(), 4u);
+    BOOST_CHECK_EQUAL(agg.getFoldedRowCount(), 4u);
+
+    Result out;
+    agg.extractAll(out);
+    BOOST_CHECK_EQUAL(agg.getGroupCount(), 0u);
+    auto res = rows(out);
+    BOOST_REQUIRE_EQUAL(res.size(), 3u);
+    BOOST_CHECK(res["g"] == std::vector<std::string>({"g", "15", "1.75", "2", "11.25"}));
+    BOOST_CHECK(res["r"] == std::vector<std::string>({"r", "4", "2", "3", "-0.5"}));
+    BOOST_CHECK(res["i"] == std::vector<std::string>({"i", "1", "NULL", "NULL", "NULL"}));
+}
+
+BOOST_AUTO_TEST_CASE(EraseJobAttempt) {
+    InMemoryAggregator agg(fold, 100);
+    BOOST_REQUIRE(agg.setSchema(result.rowschema()));
+    Result r1 = result;
+    addRow(r1, {"g", "10", "1", "7", "1"});
+    Result r2 = result;
+    addRow(r2, {"g", "5", "1", "2", "1"});
+    BOOST_CHECK(agg.fold(10, r1));
+    BOOST_CHECK(agg.fold(11, r2));
+    agg.erase({11});
+    BOOST_CHECK_EQUAL(agg.getGroupCount(), 1u);
+
+    std::map<int, int> jobRows;
+    agg.extractEach([&jobRows](int jobIdAttempt, Result& res) { jobRows[jobIdAttempt] = res.row_size(); });
+    BOOST_CHECK_EQUAL(jobRows.size(), 1u);
+    BOOST_CHECK_EQUAL(jobRows[10], 1);
+}
+
+BOOST_AUTO_TEST_CASE(Refuse) {
+    InMemoryAggregator agg(fold, 2);
+    BOOST_REQUIRE(agg.setSchema(result.rowschema()));
+    Result r1 = result;
+    addRow(r1, {"g", "1", "1", "1", "1"});
+    addRow(r1, {"r", "1", "1", "1", "1"});
+    BOOST_CHECK(agg.fold(10, r1));
+    // A third group is over the limit and nothing is folded.
+    Result r2 = result;
+    addRow(r2, {"g", "1", "1", "1", "1"});
+    addRow(r2, {"z", "1", "1", "1", "1"});
+    BOOST_CHECK(!agg.fold(10, r2));
+    // Values that do not parse are refused.
+    Result r3 = result;
+    addRow(r3, {"g", "x", "1", "1", "1"});
+    BOOST_CHECK(!agg.fold(10, r3));
+    Result out;
+    agg.extractAll(out);
+    auto res = rows(out);
+    BOOST_CHECK_EQUAL(res.size(), 2u);
+    BOOST_CHECK_EQUAL(res["g"][1], "1");
+
+    // Only numeric columns can be folded.
+    lsst::qserv::proto::RowSchema schema = result.rowschema();
+    schema.mutable_columnschema(3)->set_mysqltype(MYSQL_TYPE_STRING);
+    BOOST_CHECK(!agg.setSchema(schema));
+    schema.mutable_columnschema()->RemoveLast();
+    BOOST_CHECK(!agg.setSchema(schema));
+}
+
+/** @test
+ * HLL columns hold sketches of any column type, which are merged.
+ */
+BOOST_AUTO_TEST_CASE(MergeSketches) {
+    InMemoryAggregator::FoldVector hllFold = {Fold::KEY, Fold::HLL};
+    Result schema;
+    *schema.mutable_rowschema()->add_columnschema() = result.rowschema().columnschema(0);
+    auto cs = schema.mutable_rowschema()->add_columnschema();
+    *cs = result.rowschema().columnschema(0);
+    cs->set_name("QS1_HLL");
+    cs->set_sqltype("VARBINARY(4097)");
+    cs->set_mysqltype(MYSQL_TYPE_VAR_STRING);
+    InMemoryAggregator agg(hllFold, 100);
+    BOOST_REQUIRE(agg.setSchema(schema.rowschema()));
+
+    lsst::qserv::util::HyperLogLog a;
+    lsst::qserv::util::HyperLogLog b;
+    for (int j = 0; j < 3000; ++j) a.add(&j, sizeof(j));
+    for (int j = 2000; j < 5000; ++j) b.add(&j, sizeof(j));
+    Result r1 = schema;
+    addRow(r1, {"g", a.serialize()});
+    Result r2 = schema;
+    addRow(r2, {"g", b.serialize()});
+    BOOST_CHECK(agg.fold(10, r1));
+    BOOST_CHECK(agg.fold(11, r2));
+    Result r3 = schema;
+    addRow(r3, {"g", "not a sketch"});
+    BOOST_CHECK(!agg.fold(12, r3));
+
+    Result out;
+    agg.extractAll(out);
+    auto res = rows(out);
+    BOOST_REQUIRE_EQUAL(res.size(), 1u);
+    BOOST_CHECK(a.merge(b));
+    BOOST_CHECK(res["g"][1] == a.serialize());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
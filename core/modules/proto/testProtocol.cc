@@ -37,6 +37,7 @@
 
 // Qserv headers
 #include "proto/ProtoHeaderWrap.h"
+#include "proto/ResultCompression.h"
 #include "proto/ScanTableInfo.h"
 #include "proto/TaskMsgDigest.h"
 #include "proto/worker.pb.h"
@@ -193,6 +194,30 @@ BOOST_AUTO_TEST_CASE(ProtoHeaderWrap) {
     BOOST_CHECK(compareProtoHeaders(response->protoHeader, *ph));
 }
 
+BOOST_AUTO_TEST_CASE(ResultCompression) {
+    using proto::ResultCompression;
+    BOOST_CHECK_EQUAL(ResultCompression::codecFromName("none"), proto::ProtoHeader::NONE);
+    BOOST_CHECK_EQUAL(ResultCompression::codecFromName("zlib"), proto::ProtoHeader::ZLIB);
+    BOOST_CHECK_THROW(ResultCompression::codecFromName("bogus"), std::invalid_argument);
+
+    std::string msg;
+    for (int i=0; i < 1000; ++i) {
+        msg += "'" + std::to_string(i) + "'\t'some repetitive text'\n";
+    }
+    std::string compressed;
+    BOOST_CHECK(ResultCompression::compress(proto::ProtoHeader::ZLIB, 1, msg, compressed));
+    BOOST_CHECK(compressed.size() < msg.size());
+    std::vector<char> out;
+    BOOST_CHECK(ResultCompression::decompress(proto::ProtoHeader::ZLIB, compressed.data(),
+                                              compressed.size(), msg.size(), out));
+    BOOST_CHECK(std::string(out.begin(), out.end()) == msg);
+    // Wrong expected size must be detected.
+    BOOST_CHECK(!ResultCompression::decompress(proto::ProtoHeader::ZLIB, compressed.data(),
+                                               compressed.size(), msg.size() + 1, out));
+    // Small messages are left alone.
+    BOOST_CHECK(!ResultCompression::compress(proto::ProtoHeader::ZLIB, 1, "short", compressed));
+}
+
 BOOST_AUTO_TEST_CASE(ScanTableInfo) {
     lsst::qserv::proto::ScanTableInfo stiA{"dba", "fruit", false, 1};
     lsst::qserv::proto::ScanTableInfo stiB{"dba", "fruit", true, 1};
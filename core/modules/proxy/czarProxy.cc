@@ -102,6 +102,14 @@ submitQuery(std::string const& query, std::map<std::string, std::string> const&
     return ::_czar->submitQuery(query, hints);
 }
 
+bool
+waitQuery(std::string const& messageTable) {
+    if (not ::_czar) {
+        throw std::runtime_error("czarProxy/waitQuery(): czar instance not initialized");
+    }
+    return ::_czar->waitQuery(messageTable);
+}
+
 void
 killQuery(std::string const& query, std::string const& clientId) {
     if (not ::_czar) {
@@ -70,6 +70,15 @@ void initCzar(std::string const& czarName);
 czar::SubmitResult submitQuery(std::string const& query,
                                std::map<std::string, std::string> const& hints);
 
+/**
+ * Wait shortly for a query returned by submitQuery() to complete.
+ *
+ * @param messageTable: Message table returned by submitQuery().
+ * @return true if the query completed without errors, its message table
+ *         is then already dropped and only its results remain to be read.
+ */
+bool waitQuery(std::string const& messageTable);
+
 /**
  * Process a kill query command (experimental).
  *
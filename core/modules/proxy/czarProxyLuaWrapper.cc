@@ -15,6 +15,7 @@ namespace {
 
 int luaInitCzar(lua_State *L);
 int luaSubmitQuery(lua_State *L);
+int luaWaitQuery(lua_State *L);
 int luaKillQuery(lua_State *L);
 int luaLog(lua_State *L);
 
@@ -34,6 +35,7 @@ luaopen_czarProxy(lua_State* L) {
     } methods[] = {
             {"initCzar", luaInitCzar},
             {"submitQuery", luaSubmitQuery},
+            {"waitQuery", luaWaitQuery},
             {"killQuery", luaKillQuery},
             {"log", luaLog}
     };
@@ -113,6 +115,34 @@ int luaSubmitQuery(lua_State *L) {
         lua_setfield(L, -2, "messageTable");
         lua_pushlstring (L, res.orderBy.data(), res.orderBy.size());
         lua_setfield(L, -2, "orderBy");
+        lua_pushboolean(L, res.dropResult);
+        lua_setfield(L, -2, "dropResult");
+
+        return 1;
+
+    } catch (std::exception const& exc) {
+        lua_pushstring(L, exc.what());
+        lua_error(L);   // lua_error() does not return
+        return 0;
+    }
+}
+
+int luaWaitQuery(lua_State *L) {
+    // called as waitQuery(messageTable:str) -> bool
+    try {
+        if (lua_gettop(L) != 1) {
+            lua_pushstring(L, "One argument expected in waitQuery(messageTable:str)");
+            lua_error(L);   // lua_error() does not return
+        }
+        if (!lua_isstring(L, -1)) {
+            lua_pushstring(L, "waitQuery(messageTable:str) -- incorrect argument type");
+            lua_error(L);   // lua_error() does not return
+        }
+        size_t lenTable;
+        const char* table = lua_tolstring(L, -1, &lenTable);
+
+        bool done = lsst::qserv::proxy::waitQuery(std::string(table, lenTable));
+        lua_pushboolean(L, done);
 
         return 1;
 
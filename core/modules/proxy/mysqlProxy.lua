@@ -24,6 +24,9 @@ ERR_QSERV_RUNTIME  = -4120
 SUCCESS            = 0
 MSG_ERROR          = 2
 
+-- answers to housekeeping queries are reused for this many seconds
+ANSWER_CACHE_SECS  = 60
+
 -------------------------------------------------------------------------------
 --                             error handling                                --
 -------------------------------------------------------------------------------
@@ -207,6 +210,25 @@ function queryType()
         return false
     end
     ---------------------------------------------------------------------------
+    -- Detects local queries whose answer is the same for every client
+    -- connection, so that it may be reused instead of asking MySQL again.
+    -- Anything depending on session state (SET variables, default
+    -- database, connection id, time) must not be listed here.
+    local isCacheable = function(qU)
+        if string.find(qU, "^SELECT @@VERSION $") or
+           string.find(qU, "^SELECT @@VERSION_COMMENT $") or
+           string.find(qU, "^SELECT @@VERSION_COMMENT LIMIT 1 $") or
+           string.find(qU, "^SELECT @@GLOBAL%.[%w_]+ $") or
+           string.find(qU, "^SELECT VERSION%(%) $") or
+           string.find(qU, "^SHOW ENGINES $") or
+           string.find(qU, "^SHOW CHARACTER SET $") or
+           string.find(qU, "^SHOW COLLATION $") or
+           string.find(qU, "^SHOW GLOBAL VARIABLES $") then
+            return true
+        end
+        return false
+    end
+    ---------------------------------------------------------------------------
     local shouldPassToResultDb = function(qU)
         if string.find(qU, "^SELECT DATABASE()") then
             return true
@@ -265,6 +287,7 @@ function queryType()
 
     return {
         isLocal = isLocal,
+        isCacheable = isCacheable,
         shouldPassToResultDb = shouldPassToResultDb,
         isDisallowed = isDisallowed,
         isKill = isKill,
@@ -284,6 +307,8 @@ function queryProcessing()
     local self = { msgTableName = nil,
                    resultTableName = nil,
                    orderByClause = nil,
+                   dropResult = true,
+                   cacheKey = nil,
                    initialized = false }
 
     ---------------------------------------------------------------------------
@@ -339,6 +364,8 @@ function queryProcessing()
         self.resultTableName = res.resultTable
         self.msgTableName = res.messageTable
         self.orderByClause = res.orderBy
+        -- Tables kept by the czar result cache are dropped by the czar
+        self.dropResult = res.dropResult
 
         czarProxy.log("mysql-proxy", "INFO", "Czar response: [result: " .. self.resultTableName ..
                ", message: " .. self.msgTableName ..
@@ -356,6 +383,50 @@ function queryProcessing()
 
     ---------------------------------------------------------------------------
 
+    -- Answers of cacheable queries are shared by all client connections,
+    -- keyed by the normalized query text.
+    if not proxy.global.answers then
+        proxy.global.answers = {}
+    end
+
+    -- Send the saved answer to a cacheable query, or pass the query to
+    -- MySQL and save its answer (in read_query_result with id=5).
+    local processCacheable = function(packet, qU)
+        local answer = proxy.global.answers[qU]
+        if answer and os.time() - answer.time < ANSWER_CACHE_SECS then
+            proxy.response.type = proxy.MYSQLD_PACKET_OK
+            proxy.response.resultset = { fields = answer.fields, rows = answer.rows }
+            return proxy.PROXY_SEND_RESULT
+        end
+        czarProxy.log("mysql-proxy", "INFO", "Processing locally, saving answer: " .. qU)
+        self.cacheKey = qU
+        proxy.queries:append(5, packet, {resultset_is_needed = true})
+        return proxy.PROXY_SEND_QUERY
+    end
+
+    -- Save the answer to the query passed by processCacheable().
+    local saveAnswer = function(resultset)
+        if not self.cacheKey or not resultset.fields then
+            return
+        end
+        local fields = {}
+        for i = 1, #resultset.fields do
+            fields[i] = { type = resultset.fields[i].type, name = resultset.fields[i].name }
+        end
+        local rows = {}
+        for row in resultset.rows do
+            local copy = {}
+            for i = 1, #fields do
+                copy[i] = row[i]
+            end
+            rows[#rows + 1] = copy
+        end
+        proxy.global.answers[self.cacheKey] = { time = os.time(), fields = fields, rows = rows }
+        self.cacheKey = nil
+    end
+
+    ---------------------------------------------------------------------------
+
     local processIgnored = function(q)
         proxy.response.type = proxy.MYSQLD_PACKET_OK
         -- Assemble result
@@ -400,13 +471,27 @@ function queryProcessing()
 
     ---------------------------------------------------------------------------
 
+    -- Returns true if the query completed without errors right after it was
+    -- submitted. Its message table is then dropped by czar, and only results
+    -- are left to fetch.
+    local completedWithoutErrors = function()
+        local ok, res = pcall(czarProxy.waitQuery, self.msgTableName)
+        if (not ok) then
+            czarProxy.log("mysql-proxy", "WARN", "Exception in call to czar method: " .. res)
+            return false
+        end
+        return res
+    end
+
+    ---------------------------------------------------------------------------
+
     local prepForFetchingMessages = function(proxy)
         if not self.resultTableName then
             return err.set(ERR_BAD_RES_TNAME, "Invalid result table name")
         end
 
         -- Severity is stored in a MySQL enum
-        local q1 = "SELECT chunkId, code, message, severity+0, timeStamp FROM " .. self.msgTableName
+        local q1 = "SELECT chunkId, code, message, severity+0, timeStamp, msgCount FROM " .. self.msgTableName
         proxy.queries:append(1, string.char(proxy.COM_QUERY) .. q1,
                              {resultset_is_needed = true})
 
@@ -435,7 +520,7 @@ function queryProcessing()
 
     local dropResults = function(proxy)
 
-        if self.resultTableName ~= "" then
+        if self.resultTableName ~= "" and self.dropResult then
             local q4 = "DROP TABLE " .. self.resultTableName
             proxy.queries:append(4, string.char(proxy.COM_QUERY) .. q4,
                                  {resultset_is_needed = true})
@@ -450,7 +535,10 @@ function queryProcessing()
         sendToQserv = sendToQserv,
         killQservQuery = killQservQuery,
         processLocally = processLocally,
+        processCacheable = processCacheable,
+        saveAnswer = saveAnswer,
         processIgnored = processIgnored,
+        completedWithoutErrors = completedWithoutErrors,
         prepForFetchingMessages = prepForFetchingMessages,
         fetchResults = fetchResults,
         dropResults = dropResults
@@ -485,7 +573,9 @@ function read_query(packet)
         -- check for special queries that can be handled locally
         -- note we make no modifications to proxy.queries,
         -- so the packet will be sent as-is
-        if qType.isLocal(qU) then
+        if qType.isCacheable(qU) then
+            return qProc.processCacheable(packet, qU)
+        elseif qType.isLocal(qU) then
             return qProc.processLocally(qU)
         elseif qType.isIgnored(qU) then
             return qProc.processIgnored(qU)
@@ -510,6 +600,15 @@ function read_query(packet)
             return err.send()
         end
 
+        -- fetch results of a query which is already done without waiting
+        -- for its message table
+        if qProc.completedWithoutErrors() then
+            czarProxy.log("mysql-proxy", "INFO", "Query completed, fetching results")
+            qProc.fetchResults(proxy)
+            qProc.dropResults(proxy)
+            return proxy.PROXY_SEND_QUERY
+        end
+
         -- configure proxy to fetch results from
         -- the appropriate result table
         if qProc.prepForFetchingMessages(proxy) < 0 then
@@ -551,7 +650,8 @@ function read_query_result(inj)
                 end
             else
                 czarProxy.log("mysql-proxy", "INFO", "   chunkId: " .. row[1] .. ", code: " .. row[2] ..
-                              ", msg: " .. tostring(row[3]) .. ", timestamp: " .. row[5])
+                              ", msg: " .. tostring(row[3]) .. ", timestamp: " .. row[5] ..
+                              ", count: " .. row[6])
             end
         end
         if (queryErrorCount > 0) then
@@ -571,5 +671,10 @@ function read_query_result(inj)
         return proxy.PROXY_IGNORE_RESULT
     elseif (inj.type == 2) then
         czarProxy.log("mysql-proxy", "INFO", "q2 - passing")
+    elseif (inj.type == 5) then
+        -- answer of a cacheable local query, passed on to the client
+        if inj.resultset.query_status == proxy.MYSQLD_PACKET_OK then
+            qProc.saveAnswer(inj.resultset)
+        end
     end
 end
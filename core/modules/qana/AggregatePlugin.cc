@@ -31,8 +31,15 @@
 #include "qana/AggregatePlugin.h"
 
 // System headers
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <set>
+#include <sstream>
 #include <string>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 // Third-party headers
 
@@ -40,21 +47,183 @@
 #include "lsst/log/Log.h"
 
 // Qserv headers
+#include "css/CssAccess.h"
+#include "css/ZoneMaps.h"
+#include "global/constants.h"
 #include "qana/CheckAggregation.h"
 #include "query/AggOp.h"
+#include "query/AndTerm.h"
+#include "query/BoolFactor.h"
+#include "query/ColumnRef.h"
+#include "query/CompPredicate.h"
+#include "query/FromList.h"
 #include "query/FuncExpr.h"
+#include "query/InPredicate.h"
 #include "query/QueryContext.h"
 #include "query/QueryTemplate.h"
 #include "query/SelectList.h"
 #include "query/SelectStmt.h"
+#include "query/SqlSQL2Tokens.h"
+#include "query/TableRef.h"
 #include "query/ValueExpr.h"
 #include "query/ValueFactor.h"
+#include "query/WhereClause.h"
 #include "util/common.h"
 
 namespace {
 LOG_LOGGER _log = LOG_GET("lsst.qserv.qana.AggregatePlugin");
+
+using namespace lsst::qserv;
+
+using StatsAnswer = std::vector<std::pair<std::string, std::string>>;
+
+/// Find the chunks a WHERE clause restricts a query to. It may only be
+/// "chunkId = N" or "chunkId IN (N, ...)".
+/// @return false if the WHERE clause is anything else.
+bool whereChunks(query::SelectStmt const& stmt, bool& allChunks, std::set<int>& chunks) {
+    allChunks = true;
+    if (!stmt.hasWhereClause()) return true;
+    auto const& where = stmt.getWhereClause();
+    if (where.getRestrs() && !where.getRestrs()->empty()) return false;
+    auto const andTerm = where.getRootAndTerm();
+    if (!andTerm || andTerm->_terms.size() != 1) return false;
+    auto const factor = std::dynamic_pointer_cast<query::BoolFactor>(andTerm->_terms.front());
+    if (!factor || factor->_hasNot || factor->_terms.size() != 1) return false;
+
+    query::ValueExprPtr column;
+    query::ValueExprPtrVector values;
+    auto const& term = factor->_terms.front();
+    if (auto const comp = std::dynamic_pointer_cast<query::CompPredicate>(term)) {
+        if (comp->op != SqlSQL2Tokens::EQUALS_OP) return false;
+        column = comp->left;
+        values.push_back(comp->right);
+    } else if (auto const in = std::dynamic_pointer_cast<query::InPredicate>(term)) {
+        if (in->hasNot) return false;
+        column = in->value;
+        values = in->cands;
+    } else {
+        return false;
+    }
+    auto const cr = column ? column->copyAsColumnRef() : nullptr;
+    if (!cr || cr->column != "chunkId") return false;
+    for (auto const& value : values) {
+        std::string const str = value ? value->copyAsLiteral() : std::string();
+        char* end = nullptr;
+        long const chunk = std::strtol(str.c_str(), &end, 10);
+        if (str.empty() || *end != '\0') return false;
+        chunks.insert(chunk);
+    }
+    allChunks = false;
+    return true;
+}
+
+/// @return 'value' as a SQL literal, an integer if it is one, else a DOUBLE.
+std::string sqlValue(long double value) {
+    if (value == std::trunc(value) && std::fabs(value) < 1e18L) {
+        return std::to_string(static_cast<long long>(value));
+    }
+    std::ostringstream os;
+    os.precision(17);
+    os << static_cast<double>(value);
+    std::string str = os.str();
+    if (str.find_first_of("eE") == std::string::npos) str += "e0";
+    return str;
+}
+
+/// Compute the select list of an unfiltered, or chunk restricted, aggregate
+/// query over one chunked table from the per-chunk row counts and column
+/// statistics of the zone map of its database. COUNT, SUM, MIN, MAX and AVG
+/// of a column are supported, as well as COUNT(*).
+/// @return false if the query or the statistics do not allow it.
+bool answerFromStats(query::SelectStmt const& stmt, query::QueryContext& context, StatsAnswer& answer) {
+    if (!context.css || context.unsatisfiable || context.sampleEvery > 1) return false;
+    if (stmt.getDistinct() || stmt.hasGroupBy() || stmt.hasHaving()) return false;
+    if (stmt.hasLimit() && stmt.getLimit() == 0) return false;
+    auto const& tableRefs = stmt.getFromList().getTableRefList();
+    if (tableRefs.size() != 1 || !tableRefs.front()->isSimple()) return false;
+    std::string const& db = tableRefs.front()->getDb();
+    std::string const& table = tableRefs.front()->getTable();
+    if (db.empty() || table.empty() || !context.css->getPartTableParams(db, table).isChunked()) {
+        return false;
+    }
+    bool allChunks = true;
+    std::set<int> restricted;
+    if (!whereChunks(stmt, allChunks, restricted)) return false;
+
+    auto const zoneMap = context.css->getZoneMaps().get(db);
+    auto const rows = zoneMap->getRows(table);
+    if (rows == nullptr) return false;
+    // Every chunk must have statistics, chunks missing from CSS are empty.
+    std::vector<int> chunks;
+    for (auto const& elem : context.css->getChunks(db, table)) {
+        int const chunk = elem.first;
+        if (chunk == DUMMY_CHUNK || (!allChunks && restricted.count(chunk) == 0)) continue;
+        if (rows->count(chunk) == 0) return false;
+        chunks.push_back(chunk);
+    }
+
+    auto const vlist = stmt.getSelectList().getValueExprList();
+    for (auto const& expr : *vlist) {
+        auto const& factorOps = expr->getFactorOps();
+        if (factorOps.size() != 1 || !factorOps.front().factor) return false;
+        auto const& factor = factorOps.front().factor;
+        if (factor->getType() != query::ValueFactor::AGGFUNC) return false;
+        auto const funcExpr = factor->getFuncExpr();
+        if (!funcExpr || funcExpr->params.size() != 1 || !funcExpr->params.front()) return false;
+        std::string name = funcExpr->getName();
+        std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+        auto const& param = funcExpr->params.front();
+
+        int64_t count = 0;
+        std::string value;
+        if (param->isStar()) {
+            if (name != "COUNT") return false;
+            for (int chunk : chunks) count += rows->at(chunk);
+            value = std::to_string(count);
+        } else {
+            auto const cr = param->copyAsColumnRef();
+            if (!cr) return false;
+            auto const ranges = zoneMap->get(table, cr->column);
+            if (ranges == nullptr) return false;
+            long double sum = 0, min = 0, max = 0;
+            bool hasValues = false;
+            for (int chunk : chunks) {
+                auto const iter = ranges->find(chunk);
+                if (iter == ranges->end()) return false;
+                auto const& range = iter->second;
+                if ((name == "SUM" || name == "AVG") && !range.hasSum) return false;
+                count += rows->at(chunk) - range.nullCount;
+                if (!range.hasValues) continue;
+                sum += range.sum;
+                min = hasValues ? std::min(min, range.min) : range.min;
+                max = hasValues ? std::max(max, range.max) : range.max;
+                hasValues = true;
+            }
+            if (name == "COUNT") {
+                value = std::to_string(count);
+            } else if (!hasValues) {
+                value = "NULL";
+            } else if (name == "SUM") {
+                value = sqlValue(sum);
+            } else if (name == "MIN") {
+                value = sqlValue(min);
+            } else if (name == "MAX") {
+                value = sqlValue(max);
+            } else if (name == "AVG") {
+                value = sqlValue(sum / count);
+            } else {
+                return false;
+            }
+        }
+        std::string column = expr->getAlias();
+        if (column.empty()) column = expr->sqlFragment();
+        answer.emplace_back(column, value);
+    }
+    return true;
 }
 
+} // annonymous namespace
+
 namespace lsst {
 namespace qserv {
 namespace qana {
@@ -71,8 +240,11 @@ template <class C>
 class convertAgg {
 public:
     typedef typename C::value_type T;
-    convertAgg(C& pList_, C& mList_, query::AggOp::Mgr& aMgr_)
-        : pList(pList_), mList(mList_), aMgr(aMgr_) {}
+    /// @param scale_ - factor the merged COUNT and SUM values are multiplied
+    ///                 by, to estimate the result of a sampled query.
+    convertAgg(C& pList_, C& mList_, query::AggRecord::FoldVector& fList_, query::AggOp::Mgr& aMgr_,
+               int scale_=1)
+        : pList(pList_), mList(mList_), fList(fList_), aMgr(aMgr_), scale(scale_) {}
     void operator()(T const& e) {
         _makeRecord(*e);
     }
@@ -96,6 +268,7 @@ private:
             query::ValueExprPtr par(e.clone());
             par->setAlias(interName);
             pList.push_back(par);
+            fList.push_back(query::AggRecord::Fold::KEY);
 
             if (!interName.empty()) {
                 query::ValueExprPtr mer = newExprFromAlias(interName);
@@ -121,6 +294,7 @@ private:
             query::ValueFactorPtr newFactor = i->factor->clone();
             if (newFactor->getType() != query::ValueFactor::AGGFUNC) {
                 pList.push_back(query::ValueExpr::newSimple(newFactor));
+                fList.push_back(query::AggRecord::Fold::KEY);
             } else {
                 query::AggRecord r;
                 r.orig = newFactor;
@@ -133,9 +307,19 @@ private:
                     throw std::logic_error("Couldn't process AggRecord");
                 }
                 pList.insert(pList.end(), p->parallel.begin(), p->parallel.end());
+                fList.insert(fList.end(), p->parallelFold.begin(), p->parallelFold.end());
                 query::ValueExpr::FactorOp m;
                 m.factor = p->merge;
                 m.op = i->op;
+                std::string name = newFactor->getFuncExpr()->getName();
+                std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+                if (scale > 1 && (name == "COUNT" || name == "SUM")) {
+                    auto scaled = std::make_shared<query::ValueExpr>();
+                    scaled->getFactorOps().emplace_back(p->merge, query::ValueExpr::MULTIPLY);
+                    scaled->getFactorOps().emplace_back(
+                            query::ValueFactor::newConstFactor(std::to_string(scale)));
+                    m.factor = query::ValueFactor::newExprFactor(scaled);
+                }
                 mergeFactorOps.push_back(m);
             }
         }
@@ -145,7 +329,9 @@ private:
 
     C& pList;
     C& mList;
+    query::AggRecord::FoldVector& fList;
     query::AggOp::Mgr& aMgr;
+    int scale;
 };
 
 
@@ -160,6 +346,14 @@ AggregatePlugin::applyPhysical(QueryPlugin::Plan& plan,
     // Set hasMerge to true if aggregation is detected.
     query::SelectList& oList = plan.stmtOriginal.getSelectList();
 
+    // Aggregates of a whole table may need no chunk at all.
+    context.statsAnswer.clear();
+    if (answerFromStats(plan.stmtOriginal, context, context.statsAnswer)) {
+        LOGS(_log, LOG_LVL_DEBUG, "Aggregates answered from chunk statistics");
+    } else {
+        context.statsAnswer.clear();
+    }
+
     // Get the first out of the parallel statement select list. Assume
     // that the select lists are the same for all statements. This is
     // not necessarily true, unless the plugin is placed early enough
@@ -176,9 +370,12 @@ AggregatePlugin::applyPhysical(QueryPlugin::Plan& plan,
     pList.getValueExprList()->clear();
     mList.getValueExprList()->clear();
     query::AggOp::Mgr m; // Eventually, this can be shared?
+    auto fList = std::make_shared<query::AggRecord::FoldVector>();
     convertAgg<query::ValueExprPtrVector> ca(*pList.getValueExprList(),
                                              *mList.getValueExprList(),
-                                             m);
+                                             *fList,
+                                             m,
+                                             context.sampleEvery);
     std::for_each(vlist->begin(), vlist->end(), ca);
     query::QueryTemplate qt;
     pList.renderTo(qt);
@@ -189,6 +386,13 @@ AggregatePlugin::applyPhysical(QueryPlugin::Plan& plan,
     if (plan.stmtOriginal.getDistinct() || m.hasAggregate()) {
         context.needsMerge = true;
     }
+    // Partial aggregates can be folded together in memory as long as every
+    // parallel column is known. '*' expands to an unknown number of columns.
+    bool hasStar = std::any_of(vlist->begin(), vlist->end(),
+                               [](query::ValueExprPtr const& e) { return e->isStar(); });
+    if (m.hasAggregate() && !plan.stmtOriginal.getDistinct() && !hasStar) {
+        context.aggFold = fList;
+    }
 
     std::shared_ptr<query::OrderByClause> _nullptr;
 
@@ -43,6 +43,8 @@ public:
 
     virtual ~AggregatePlugin() {}
 
+    std::string name() const override { return "Aggregate"; }
+
     void prepare() override {}
 
     void applyPhysical(QueryPlugin::Plan& plan, query::QueryContext&) override;
@@ -47,23 +47,47 @@ ColumnVertexMap::ColumnVertexMap(Vertex& v) {
     _init(v, c.begin(), c.end());
 }
 
+std::size_t ColumnVertexMap::Hash::operator()(
+    query::ColumnRef const* c) const
+{
+    std::hash<std::string> h;
+    std::size_t seed = h(c->column);
+    seed ^= h(c->table) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    seed ^= h(c->db) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    return seed;
+}
+
+bool ColumnVertexMap::Eq::operator()(query::ColumnRef const* a,
+                                     query::ColumnRef const* b) const
+{
+    return ColumnRefEq()(*a, *b);
+}
+
+void ColumnVertexMap::_reindex() {
+    _index.clear();
+    _index.reserve(_entries.size());
+    for (std::size_t i = 0; i < _entries.size(); ++i) {
+        _index.emplace(_entries[i].cr.get(), i);
+    }
+}
+
 std::vector<Vertex*> const& ColumnVertexMap::find(
     query::ColumnRef const& c) const
 {
-    typedef std::vector<Entry>::const_iterator Iter;
     std::vector<Vertex*> static const NONE;
 
-    std::pair<Iter,Iter> p = std::equal_range(
-        _entries.begin(), _entries.end(), c, ColumnRefLt());
-    if (p.first == p.second) {
+    auto i = _index.find(&c);
+    if (i == _index.end()) {
         return NONE;
-    } else if (p.first->isAmbiguous()) {
+    }
+    Entry const& e = _entries[i->second];
+    if (e.isAmbiguous()) {
         query::QueryTemplate qt;
         c.renderTo(qt);
         throw QueryNotEvaluableError("Column reference " + qt.sqlFragment() +
                                      " is ambiguous");
     }
-    return p.first->vertices;
+    return e.vertices;
 }
 
 void ColumnVertexMap::fuse(ColumnVertexMap& m,
@@ -83,6 +107,7 @@ void ColumnVertexMap::fuse(ColumnVertexMap& m,
         o->swap(*i);
     }
     m._entries.clear();
+    m._index.clear();
     // Merge-sort the two sorted runs of entries
     std::inplace_merge(_entries.begin(), middle, _entries.end(), ColumnRefLt());
     // Duplicate column references are now adjacent to eachother in _entries -
@@ -124,6 +149,7 @@ void ColumnVertexMap::fuse(ColumnVertexMap& m,
         // entries at or before cur - erase them.
         _entries.erase(++cur, _entries.end());
     }
+    _reindex();
 }
 
 std::vector<std::string> const ColumnVertexMap::computeCommonColumns(
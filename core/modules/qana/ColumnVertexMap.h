@@ -29,8 +29,11 @@
 
 // System headers
 #include <algorithm>
+#include <cstddef>
+#include <functional>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 // Local headers
@@ -108,6 +111,7 @@ public:
 
     void swap(ColumnVertexMap& m) {
         _entries.swap(m._entries);
+        _index.swap(m._index);
     }
 
     /// `find` returns the vertices for table references corresponding to the
@@ -137,7 +141,22 @@ public:
         ColumnVertexMap const& m) const;
 
 private:
+    /// `Hash` and `Eq` compare the column references pointed to.
+    struct Hash {
+        std::size_t operator()(query::ColumnRef const* c) const;
+    };
+    struct Eq {
+        bool operator()(query::ColumnRef const* a,
+                        query::ColumnRef const* b) const;
+    };
+
+    // rebuild _index from _entries.
+    void _reindex();
+
     std::vector<Entry> _entries; // sorted
+    // position of every entry in _entries, for `find`. The sorted entries
+    // are still needed to fuse maps and compute common columns.
+    std::unordered_map<query::ColumnRef const*, std::size_t, Hash, Eq> _index;
 
     // Not implemented
     ColumnVertexMap(ColumnVertexMap const&);
@@ -221,6 +240,7 @@ inline void ColumnVertexMap::_init(Vertex& v,
         _entries.push_back(Entry(*first, &v));
     }
     std::sort(_entries.begin(), _entries.end(), ColumnRefLt());
+    _reindex();
 }
 
 }}} // namespace lsst::qserv::qana
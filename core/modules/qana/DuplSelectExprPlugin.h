@@ -83,6 +83,8 @@ public:
 
     virtual ~DuplSelectExprPlugin() {}
 
+    std::string name() const override { return "DuplSelectExpr"; }
+
     /**
      * Prevent execution of queries which have duplicated select fields names.
      *
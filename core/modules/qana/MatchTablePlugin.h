@@ -65,6 +65,7 @@ public:
 
     MatchTablePlugin() {}
     virtual ~MatchTablePlugin() {}
+    std::string name() const override { return "MatchTable"; }
 
     void prepare() override {}
     void applyLogical(query::SelectStmt& stmt, query::QueryContext& ctx) override;
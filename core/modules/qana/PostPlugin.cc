@@ -85,21 +85,68 @@ PostPlugin::applyPhysical(QueryPlugin::Plan& plan,
     LOGS(_log, LOG_LVL_DEBUG, "Apply physical");
 
     if (_limit != NOTSET) {
+        // Without ordering or aggregation any _limit rows will do, so the
+        // czar can stop the query as soon as it has merged that many.
+        if (context.hasChunks() && !_orderBy && !context.needsMerge
+            && !plan.stmtOriginal.hasGroupBy() && !plan.stmtOriginal.hasHaving()) {
+            context.rowLimit = _limit;
+        }
+        // With ordering, the czar only needs the first _limit rows of all
+        // chunks, which it can keep as they arrive if every ORDER BY term
+        // is a result column.
+        if (context.hasChunks() && _orderBy && !context.needsMerge
+            && !plan.stmtOriginal.hasGroupBy() && !plan.stmtOriginal.hasHaving()) {
+            std::vector<std::pair<std::string, bool>> order;
+            for (auto const& term : *_orderBy->getTerms()) {
+                auto const& colRef = term.getExpr() ? term.getExpr()->getColumnRef() : nullptr;
+                if (colRef == nullptr) {
+                    order.clear();
+                    break;
+                }
+                order.emplace_back(colRef->column, term.getOrder() == query::OrderByTerm::DESC);
+            }
+            if (!order.empty()) {
+                context.topK = _limit;
+                context.topKOrder = order;
+            }
+        }
         // [ORDER BY ...] LIMIT ... is a special case which require sort on worker and sort/aggregation on czar
         if (context.hasChunks()) {
              LOGS(_log, LOG_LVL_DEBUG, "Add merge operation");
              context.needsMerge = true;
          }
     } else if (_orderBy) {
-        // If there is no LIMIT clause, remove ORDER BY clause from all Czar queries because it is performed by
-        // mysql-proxy (mysql doesn't garantee result order for non ORDER BY queries)
-        LOGS(_log, LOG_LVL_TRACE, "Remove ORDER BY from parallel and merge queries: \""
-             << *_orderBy << "\"");
-        for (auto i = plan.stmtParallel.begin(), e = plan.stmtParallel.end(); i != e; ++i) {
-            (**i).setOrderBy(nullptr);
+        // When every row a chunk returns is a final result row, each chunk
+        // query may sort its own rows and the czar merges the sorted chunk
+        // results into the result table in order, which mysql-proxy then
+        // reads without sorting. A chunk with subchunks returns the rows of
+        // several queries, which would not be in order.
+        std::vector<std::pair<std::string, bool>> order;
+        if (context.hasChunks() && !context.hasSubChunks() && !context.needsMerge
+            && !plan.stmtOriginal.hasGroupBy() && !plan.stmtOriginal.hasHaving()) {
+            for (auto const& term : *_orderBy->getTerms()) {
+                auto const& colRef = term.getExpr() ? term.getExpr()->getColumnRef() : nullptr;
+                if (colRef == nullptr) {
+                    order.clear();
+                    break;
+                }
+                order.emplace_back(colRef->column, term.getOrder() == query::OrderByTerm::DESC);
+            }
         }
-        if (context.needsMerge) {
-            plan.stmtMerge.setOrderBy(nullptr);
+        if (!order.empty()) {
+            LOGS(_log, LOG_LVL_TRACE, "Keep ORDER BY in parallel queries: \"" << *_orderBy << "\"");
+            context.sortedOrder = order;
+        } else {
+            // Otherwise remove ORDER BY clause from all Czar queries because it is performed by
+            // mysql-proxy (mysql doesn't garantee result order for non ORDER BY queries)
+            LOGS(_log, LOG_LVL_TRACE, "Remove ORDER BY from parallel and merge queries: \""
+                 << *_orderBy << "\"");
+            for (auto i = plan.stmtParallel.begin(), e = plan.stmtParallel.end(); i != e; ++i) {
+                (**i).setOrderBy(nullptr);
+            }
+            if (context.needsMerge) {
+                plan.stmtMerge.setOrderBy(nullptr);
+            }
         }
     }
 
@@ -51,6 +51,8 @@ public:
 
     virtual ~PostPlugin() {}
 
+    std::string name() const override { return "Post"; }
+
     /// Prepare the plugin for a query
     void prepare() override {}
 
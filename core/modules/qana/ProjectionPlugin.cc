@@ -0,0 +1,191 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+  * @file
+  *
+  * @brief ProjectionPlugin removes the parallel select list columns
+  * that the merge statement does not need.
+  */
+
+// Class header
+#include "qana/ProjectionPlugin.h"
+
+// System headers
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// Third-party headers
+#include "boost/algorithm/string.hpp"
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "query/AggRecord.h"
+#include "query/GroupByClause.h"
+#include "query/HavingClause.h"
+#include "query/OrderByClause.h"
+#include "query/QueryContext.h"
+#include "query/SelectList.h"
+#include "query/SelectStmt.h"
+#include "query/ValueExpr.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.qana.ProjectionPlugin");
+
+using lsst::qserv::query::ColumnRef;
+using lsst::qserv::query::SelectStmt;
+using lsst::qserv::query::ValueExpr;
+using lsst::qserv::query::ValueExprPtrVector;
+
+/// @return the column references of 'stmt', in its select list if
+///         'withSelectList' is true and in its GROUP BY, HAVING and ORDER BY.
+ColumnRef::Vector findColumnRefs(SelectStmt const& stmt, bool withSelectList) {
+    ValueExprPtrVector exprs;
+    if (withSelectList) {
+        auto const& selectList = *stmt.getSelectList().getValueExprList();
+        exprs.insert(exprs.end(), selectList.begin(), selectList.end());
+    }
+    if (stmt.hasGroupBy()) { stmt.getGroupBy().findValueExprs(exprs); }
+    if (stmt.hasHaving()) { stmt.getHaving().findValueExprs(exprs); }
+    if (stmt.hasOrderBy()) { stmt.getOrderBy().findValueExprs(exprs); }
+    ColumnRef::Vector refs;
+    for (auto const& expr : exprs) {
+        if (expr) { expr->findColumnRefs(refs); }
+    }
+    return refs;
+}
+
+/// Column names are case insensitive.
+std::string nameKey(std::string const& name) {
+    return boost::algorithm::to_lower_copy(name);
+}
+
+/// @return the name of the result column of 'expr'.
+std::string resultName(ValueExpr const& expr) {
+    if (!expr.getAlias().empty()) {
+        return nameKey(expr.getAlias());
+    }
+    auto const& colRef = expr.getColumnRef();
+    return nameKey(colRef ? colRef->column : expr.sqlFragment());
+}
+
+/// @return the text of 'expr' without its alias. Only text without
+///         string constants is case insensitive.
+std::string exprKey(ValueExpr const& expr) {
+    auto copy = expr.clone();
+    copy->setAlias(std::string());
+    std::string text = copy->sqlFragment();
+    return text.find_first_of("'\"") == std::string::npos ? nameKey(text) : text;
+}
+
+} // anonymous namespace
+
+
+namespace lsst {
+namespace qserv {
+namespace qana {
+
+void
+ProjectionPlugin::applyPhysical(QueryPlugin::Plan& plan, query::QueryContext& context) {
+    if (!context.needsMerge || plan.stmtParallel.empty()) {
+        return;
+    }
+    auto isStar = [](query::ValueExprPtr const& e) { return e->isStar(); };
+    auto const& mList = *plan.stmtMerge.getSelectList().getValueExprList();
+    auto const& pList = *plan.stmtParallel.front()->getSelectList().getValueExprList();
+    if (pList.size() < 2 || std::any_of(mList.begin(), mList.end(), isStar)
+        || std::any_of(pList.begin(), pList.end(), isStar)) {
+        return;
+    }
+
+    // Names the parallel statements use themselves must be kept as is.
+    std::set<std::string> parallelNames;
+    for (auto const& stmt : plan.stmtParallel) {
+        for (auto const& ref : findColumnRefs(*stmt, false)) {
+            parallelNames.insert(nameKey(ref->column));
+        }
+    }
+
+    // Columns computing the same expression as an earlier one are read
+    // from that one by the merge statement.
+    std::map<std::string, std::string> renamed;
+    std::map<std::string, std::string> aliasOfExpr;
+    for (auto const& expr : pList) {
+        std::string const& alias = expr->getAlias();
+        if (alias.empty() || parallelNames.count(nameKey(alias)) > 0) {
+            continue;
+        }
+        auto inserted = aliasOfExpr.insert(std::make_pair(exprKey(*expr), alias));
+        if (!inserted.second) {
+            renamed[nameKey(alias)] = inserted.first->second;
+        }
+    }
+    auto mergeRefs = findColumnRefs(plan.stmtMerge, true);
+    std::set<std::string> used(parallelNames);
+    for (auto const& ref : mergeRefs) {
+        auto iter = renamed.find(nameKey(ref->column));
+        if (iter != renamed.end()) {
+            ref->column = iter->second;
+        }
+        used.insert(nameKey(ref->column));
+    }
+
+    std::vector<size_t> kept;
+    for (size_t j = 0; j < pList.size(); ++j) {
+        if (used.count(resultName(*pList[j])) > 0) {
+            kept.push_back(j);
+        }
+    }
+    if (kept.size() == pList.size()) {
+        return;
+    }
+    if (kept.empty()) {
+        kept.push_back(0);
+    }
+    LOGS(_log, LOG_LVL_DEBUG, "parallel select list trimmed from " << pList.size()
+         << " to " << kept.size() << " columns");
+
+    for (auto const& stmt : plan.stmtParallel) {
+        auto& list = *stmt->getSelectList().getValueExprList();
+        query::ValueExprPtrVector trimmed;
+        for (size_t j : kept) {
+            trimmed.push_back(list[j]);
+        }
+        list.swap(trimmed);
+    }
+    if (context.aggFold) {
+        auto fold = std::make_shared<query::AggRecord::FoldVector>();
+        for (size_t j : kept) {
+            fold->push_back(context.aggFold->at(j));
+        }
+        context.aggFold = fold;
+    }
+}
+
+}}} // namespace lsst::qserv::qana
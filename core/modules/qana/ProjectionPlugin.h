@@ -0,0 +1,57 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_QANA_PROJECTIONPLUGIN_H
+#define LSST_QSERV_QANA_PROJECTIONPLUGIN_H
+
+// Qserv headers
+#include "qana/QueryPlugin.h"
+
+
+namespace lsst {
+namespace qserv {
+namespace qana {
+
+
+/// ProjectionPlugin trims the select list of the parallel statements down
+/// to the columns the merge statement reads. Parallel columns computing
+/// the same expression are returned once, and columns no merge clause
+/// refers to are dropped. Queries without a merge step, or with '*' in a
+/// select list, are left alone since the chunk results are then the result.
+class ProjectionPlugin : public QueryPlugin {
+public:
+    // Types
+    typedef std::shared_ptr<ProjectionPlugin> Ptr;
+
+    ProjectionPlugin() {}
+    virtual ~ProjectionPlugin() {}
+    std::string name() const override { return "Projection"; }
+
+    void prepare() override {}
+
+    void applyLogical(query::SelectStmt&, query::QueryContext&) override {}
+    void applyPhysical(QueryPlugin::Plan& plan, query::QueryContext& context) override;
+};
+
+}}} // namespace lsst::qserv::qana
+
+#endif // LSST_QSERV_QANA_PROJECTIONPLUGIN_H
@@ -240,6 +240,7 @@ query::QsRestrictor::PtrVector getSecIndexRestrictors(query::QueryContext& conte
                                                       query::AndTerm::Ptr andTerm) {
     query::QsRestrictor::PtrVector result;
     if (not andTerm) return result;
+    query::InPredicate::Ptr inSource; // IN predicate of the last "sIndex" restrictor
 
     for (auto&& term : andTerm->_terms) {
         auto factor = std::dynamic_pointer_cast<query::BoolFactor>(term);
@@ -260,6 +261,9 @@ query::QsRestrictor::PtrVector getSecIndexRestrictors(query::QueryContext& conte
                     if (lookupSecIndex(context, column_ref)) {
                         auto restrictorType = inPredicate->hasNot ? SECONDARY_INDEX_NOT_IN : SECONDARY_INDEX_IN;
                         restrictor = newRestrictor(restrictorType, context, column_ref, inPredicate->cands);
+                        if (restrictor && restrictorType == SECONDARY_INDEX_IN) {
+                            inSource = inPredicate;
+                        }
                         LOGS(_log, LOG_LVL_DEBUG, "Add SECONDARY_INDEX_IN restrictor: " << *restrictor);
                         break; // Only want one per column.
                     }
@@ -315,6 +319,12 @@ query::QsRestrictor::PtrVector getSecIndexRestrictors(query::QueryContext& conte
             }
         }
     }
+    // With a single "sIndex" restrictor, coming from an IN predicate, the
+    // index lookup tells which of its keys are in each chunk.
+    auto isIn = [](query::QsRestrictor::Ptr const& r) { return r->_name == "sIndex"; };
+    if (inSource && std::count_if(result.begin(), result.end(), isIn) == 1) {
+        inSource->splitByChunk = true;
+    }
     return result;
 }
 
@@ -71,6 +71,8 @@ public:
 
     virtual ~QservRestrictorPlugin() {}
 
+    std::string name() const override { return "QservRestrictor"; }
+
     void prepare() override {}
 
     void applyLogical(query::SelectStmt& stmt, query::QueryContext&) override;
@@ -29,6 +29,8 @@
 #include <deque>
 #include <sstream>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 // Third-party headers
 #include "boost/lexical_cast.hpp"
@@ -72,8 +74,12 @@ std::string const replace(std::string const& s, std::string const& pat, std::str
 class Mapping : public query::QueryTemplate::EntryMapping {
 public:
 
-    Mapping(QueryMapping::ParameterMap const& m, qproc::ChunkSpec const& s)
+    Mapping(QueryMapping::ParameterMap const& m, qproc::ChunkSpec const& s,
+            bool splitKeys=false)
         : _subChunks(s.subChunks.begin(), s.subChunks.end()) {
+        if (splitKeys) {
+            _keyPositions = &s.keyPositions;
+        }
         _chunkString = boost::lexical_cast<std::string>(s.chunkId);
         if (!_subChunks.empty()) {
             _subChunkString = boost::lexical_cast<std::string>(_subChunks.front());
@@ -89,6 +95,12 @@ public:
     virtual ~Mapping() {}
 
     query::QueryTemplate::Entry::Ptr mapEntry(query::QueryTemplate::Entry const& e) const override {
+        if (_keyPositions != nullptr) {
+            if (auto list = dynamic_cast<query::QueryTemplate::ValueListEntry const*>(&e)) {
+                return std::make_shared<query::QueryTemplate::StringEntry>(
+                    list->getValue(*_keyPositions));
+            }
+        }
         auto newE = std::make_shared<query::QueryTemplate::StringEntry>(e.getValue());
 
         // FIXME see if this works
@@ -134,6 +146,7 @@ private:
     std::string _chunkString;
     std::string _subChunkString;
     std::deque<int> _subChunks;
+    Int32Vector const* _keyPositions = nullptr; ///< Keys of the chunk, if the IN list is split
 
     struct MapTuple {
         MapTuple(std::string const& pattern,
@@ -154,7 +167,29 @@ private:
 QueryMapping::QueryMapping() {}
 
 std::string QueryMapping::apply(qproc::ChunkSpec const& s, query::QueryTemplate const& t) const {
-    Mapping m(_subs, s);
+    // The compiled template is built for non-negative numbers, other
+    // substitutions go through the entry mapping.
+    std::vector<std::string> patterns;
+    std::vector<std::string> values;
+    // The IN list of a secondary index constraint is cut down to the keys
+    // found in the chunk, unless subchunk queries may join overlap rows
+    // of other chunks.
+    bool const splitKeys = !s.keyPositions.empty() && !hasSubChunks();
+    bool compilable = s.chunkId >= 0 && !splitKeys;
+    for (auto const& sub : _subs) {
+        patterns.push_back(sub.first);
+        if (sub.second == CHUNK) {
+            values.push_back(std::to_string(s.chunkId));
+        } else if (sub.second == SUBCHUNK && !s.subChunks.empty() && s.subChunks.front() >= 0) {
+            values.push_back(std::to_string(s.subChunks.front()));
+        } else {
+            compilable = false;
+        }
+    }
+    if (compilable) {
+        return t.compile(patterns)->generate(values);
+    }
+    Mapping m(_subs, s, splitKeys);
     std::string str = t.generate(m);
     return str;
 }
@@ -65,6 +65,9 @@ public:
 
     virtual ~QueryPlugin() {}
 
+    /// @return the name of the plugin, without the "Plugin" suffix
+    virtual std::string name() const = 0;
+
     /// Prepare the plugin for a query
     virtual void prepare() {}
 
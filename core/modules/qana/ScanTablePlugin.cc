@@ -70,6 +70,29 @@ ScanTablePlugin::applyLogical(query::SelectStmt& stmt,
 
 void
 ScanTablePlugin::applyFinal(query::QueryContext& context) {
+    // Index restrictors reach the rows through the secondary index and the
+    // objectId indexes, subchunked queries look up the rows of each
+    // subchunk. The workers lock the index files of such queries in memory,
+    // even when they are too small to join a shared scan.
+    bool hasIndexRestrictor = false;
+    if (context.restrictors) {
+        for (auto const& r : *context.restrictors) {
+            if (r->_name == "sIndex" || r->_name == "sIndexBetween") {
+                hasIndexRestrictor = true;
+            }
+        }
+    }
+    if (hasIndexRestrictor) {
+        context.scanInfo.access = proto::ScanInfo::Access::INDEX;
+    } else if (context.hasSubChunks()) {
+        context.scanInfo.access = proto::ScanInfo::Access::MIXED;
+    } else {
+        context.scanInfo.access = proto::ScanInfo::Access::SCAN;
+    }
+    if (context.scanInfo.access != proto::ScanInfo::Access::SCAN) {
+        context.scanInfo.indexTables = context.scanInfo.infoTables;
+    }
+
     int const scanThreshold = _interactiveChunkLimit;
     if (context.chunkCount < scanThreshold) {
         context.scanInfo.infoTables.clear();
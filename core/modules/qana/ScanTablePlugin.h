@@ -48,6 +48,7 @@ public:
 
     explicit ScanTablePlugin(int interactiveChunkLimit) : _interactiveChunkLimit(interactiveChunkLimit) {}
     virtual ~ScanTablePlugin() {}
+    std::string name() const override { return "ScanTable"; }
 
     void prepare() override {}
 
@@ -0,0 +1,380 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+  * @file
+  *
+  * @brief SimplifyPlugin evaluates constant comparisons and merges the
+  * range predicates of the same column in the WHERE clause.
+  */
+
+// Class header
+#include "qana/SimplifyPlugin.h"
+
+// System headers
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "query/AndTerm.h"
+#include "query/BetweenPredicate.h"
+#include "query/BoolFactor.h"
+#include "query/CompPredicate.h"
+#include "query/QueryContext.h"
+#include "query/SelectStmt.h"
+#include "query/SqlSQL2Tokens.h"
+#include "query/ValueExpr.h"
+#include "query/ValueFactor.h"
+#include "query/WhereClause.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.qana.SimplifyPlugin");
+
+using lsst::qserv::query::ValueExpr;
+using lsst::qserv::query::ValueExprPtr;
+
+/// A numeric constant, compared exactly when both sides are integers.
+struct Number {
+    bool isInt{false};
+    int64_t intVal{0};
+    long double realVal{0};
+};
+
+int compare(Number const& a, Number const& b) {
+    if (a.isInt && b.isInt) {
+        return (a.intVal < b.intVal) ? -1 : (b.intVal < a.intVal) ? 1 : 0;
+    }
+    long double x = a.isInt ? a.intVal : a.realVal;
+    long double y = b.isInt ? b.intVal : b.realVal;
+    return (x < y) ? -1 : (y < x) ? 1 : 0;
+}
+
+/// @return false if 's' is not a decimal integer or real literal.
+bool parseNumber(std::string const& s, Number& n) {
+    // strtold also accepts hexadecimal, infinities and NaNs.
+    if (s.empty() || s.find_first_of("xXiInN") != std::string::npos) {
+        return false;
+    }
+    char const* str = s.c_str();
+    char* end = nullptr;
+    errno = 0;
+    long long i = std::strtoll(str, &end, 10);
+    if (errno == 0 && end != str && *end == '\0') {
+        n.isInt = true;
+        n.intVal = i;
+        return true;
+    }
+    errno = 0;
+    long double d = std::strtold(str, &end);
+    if (errno != 0 || end == str || *end != '\0' || !std::isfinite(d)) {
+        return false;
+    }
+    n.isInt = false;
+    n.realVal = d;
+    return true;
+}
+
+/// @return true, with its value in 'n', if 've' is a numeric constant, or
+///         integer constants combined with +, - and *.
+bool evaluate(ValueExpr const& ve, Number& n) {
+    auto const& factorOps = ve.getFactorOps();
+    if (factorOps.empty() || factorOps.back().op != ValueExpr::NONE) {
+        return false;
+    }
+    std::vector<Number> values;
+    for (auto const& factorOp : factorOps) {
+        Number value;
+        if (!factorOp.factor || factorOp.factor->getType() != lsst::qserv::query::ValueFactor::CONST
+            || !parseNumber(factorOp.factor->getConstVal(), value)) {
+            return false;
+        }
+        values.push_back(value);
+    }
+    if (values.size() == 1) {
+        n = values.front();
+        return true;
+    }
+    // Products are computed first, as in SQL.
+    int64_t total = 0;
+    int64_t term = 0;
+    bool negate = false;
+    for (size_t j = 0; j < values.size(); ++j) {
+        if (!values[j].isInt) {
+            return false;
+        }
+        ValueExpr::Op const op = (j == 0) ? ValueExpr::PLUS : factorOps[j - 1].op;
+        if (op == ValueExpr::MULTIPLY) {
+            if (__builtin_mul_overflow(term, values[j].intVal, &term)) return false;
+            continue;
+        }
+        if (op != ValueExpr::PLUS && op != ValueExpr::MINUS) {
+            return false;
+        }
+        if (negate ? __builtin_sub_overflow(total, term, &total)
+                   : __builtin_add_overflow(total, term, &total)) {
+            return false;
+        }
+        negate = (op == ValueExpr::MINUS);
+        term = values[j].intVal;
+    }
+    if (negate ? __builtin_sub_overflow(total, term, &total)
+               : __builtin_add_overflow(total, term, &total)) {
+        return false;
+    }
+    n.isInt = true;
+    n.intVal = total;
+    return true;
+}
+
+enum class Cmp { EQ, NE, LT, LE, GT, GE, OTHER };
+
+Cmp cmpOf(int op) {
+    switch (op) {
+    case SqlSQL2Tokens::EQUALS_OP: return Cmp::EQ;
+    case SqlSQL2Tokens::NOT_EQUALS_OP: return Cmp::NE;
+    case SqlSQL2Tokens::NOT_EQUALS_OP_ALT: return Cmp::NE;
+    case SqlSQL2Tokens::LESS_THAN_OP: return Cmp::LT;
+    case SqlSQL2Tokens::LESS_THAN_OR_EQUALS_OP: return Cmp::LE;
+    case SqlSQL2Tokens::GREATER_THAN_OP: return Cmp::GT;
+    case SqlSQL2Tokens::GREATER_THAN_OR_EQUALS_OP: return Cmp::GE;
+    default: return Cmp::OTHER;
+    }
+}
+
+/// @return the comparison with its operands swapped.
+Cmp flip(Cmp c) {
+    switch (c) {
+    case Cmp::LT: return Cmp::GT;
+    case Cmp::LE: return Cmp::GE;
+    case Cmp::GT: return Cmp::LT;
+    case Cmp::GE: return Cmp::LE;
+    default: return c;
+    }
+}
+
+/// @return true if 'c' holds for two values comparing as 'r'.
+bool holds(Cmp c, int r) {
+    switch (c) {
+    case Cmp::EQ: return r == 0;
+    case Cmp::NE: return r != 0;
+    case Cmp::LT: return r < 0;
+    case Cmp::LE: return r <= 0;
+    case Cmp::GT: return r > 0;
+    case Cmp::GE: return r >= 0;
+    default: return false;
+    }
+}
+
+/// One end of a range, with the constant expression it came from.
+struct Bound {
+    bool isSet{false};
+    Number value;
+    bool inclusive{false};
+    ValueExprPtr expr;
+};
+
+/// The range of a column, set by terms of the global AND.
+struct Range {
+    ValueExprPtr column;
+    Bound lower;
+    Bound upper;
+    std::set<size_t> terms; ///< Positions of the terms in the AND
+
+    /// Restrict the range with 'column c value'.
+    void add(Cmp c, Number const& value, ValueExprPtr const& expr) {
+        if (c == Cmp::EQ || c == Cmp::GT || c == Cmp::GE) {
+            int r = lower.isSet ? compare(value, lower.value) : 1;
+            if (r > 0 || (r == 0 && c == Cmp::GT)) {
+                lower = Bound{true, value, c != Cmp::GT, expr};
+            }
+        }
+        if (c == Cmp::EQ || c == Cmp::LT || c == Cmp::LE) {
+            int r = upper.isSet ? compare(value, upper.value) : -1;
+            if (r < 0 || (r == 0 && c == Cmp::LT)) {
+                upper = Bound{true, value, c != Cmp::LT, expr};
+            }
+        }
+    }
+
+    bool isEmpty() const {
+        if (!lower.isSet || !upper.isSet) {
+            return false;
+        }
+        int r = compare(lower.value, upper.value);
+        return r > 0 || (r == 0 && !(lower.inclusive && upper.inclusive));
+    }
+
+    /// @return the terms restricting the column to the range.
+    std::vector<std::shared_ptr<lsst::qserv::query::BoolTerm>> makeTerms() const {
+        using namespace lsst::qserv::query;
+        std::vector<std::shared_ptr<BoolTerm>> result;
+        auto comp = [this, &result](int op, Bound const& bound) {
+            auto pred = std::make_shared<CompPredicate>(column->clone(), op, bound.expr->clone());
+            result.push_back(std::make_shared<BoolFactor>(pred));
+        };
+        if (lower.isSet && upper.isSet && lower.inclusive && upper.inclusive) {
+            if (compare(lower.value, upper.value) == 0) {
+                comp(SqlSQL2Tokens::EQUALS_OP, lower);
+            } else {
+                auto pred = std::make_shared<BetweenPredicate>();
+                pred->value = column->clone();
+                pred->minValue = lower.expr->clone();
+                pred->maxValue = upper.expr->clone();
+                result.push_back(std::make_shared<BoolFactor>(pred));
+            }
+            return result;
+        }
+        if (lower.isSet) {
+            comp(lower.inclusive ? SqlSQL2Tokens::GREATER_THAN_OR_EQUALS_OP
+                                 : SqlSQL2Tokens::GREATER_THAN_OP, lower);
+        }
+        if (upper.isSet) {
+            comp(upper.inclusive ? SqlSQL2Tokens::LESS_THAN_OR_EQUALS_OP
+                                 : SqlSQL2Tokens::LESS_THAN_OP, upper);
+        }
+        return result;
+    }
+};
+
+/// @return the predicate of 'term' if it is a plain one, nullptr otherwise.
+std::shared_ptr<lsst::qserv::query::BoolFactorTerm>
+plainPredicate(std::shared_ptr<lsst::qserv::query::BoolTerm> const& term) {
+    auto factor = std::dynamic_pointer_cast<lsst::qserv::query::BoolFactor>(term);
+    if (!factor || factor->_hasNot || factor->_terms.size() != 1) {
+        return nullptr;
+    }
+    return factor->_terms.front();
+}
+
+} // anonymous namespace
+
+
+namespace lsst {
+namespace qserv {
+namespace qana {
+
+void
+SimplifyPlugin::applyLogical(query::SelectStmt& stmt, query::QueryContext& context) {
+    if (!stmt.hasWhereClause()) { return; }
+    std::shared_ptr<query::AndTerm> andTerm = stmt.getWhereClause().getRootAndTerm();
+    if (!andTerm) { return; }
+    auto& terms = andTerm->_terms;
+
+    std::map<std::string, Range> ranges; // by column
+    std::set<size_t> tautologies;
+    auto addBound = [&ranges](ValueExprPtr const& column, Cmp c, Number const& value,
+                              ValueExprPtr const& expr, size_t pos) {
+        Range& range = ranges[column->sqlFragment()];
+        if (!range.column) { range.column = column; }
+        range.add(c, value, expr);
+        range.terms.insert(pos);
+    };
+    for (size_t pos = 0; pos < terms.size(); ++pos) {
+        auto pred = plainPredicate(terms[pos]);
+        if (auto comp = std::dynamic_pointer_cast<query::CompPredicate>(pred)) {
+            Cmp c = cmpOf(comp->op);
+            Number left, right;
+            bool const leftConst = comp->left && evaluate(*comp->left, left);
+            bool const rightConst = comp->right && evaluate(*comp->right, right);
+            if (c == Cmp::OTHER || (!leftConst && !rightConst)) {
+                continue;
+            }
+            if (leftConst && rightConst) {
+                if (!holds(c, compare(left, right))) {
+                    LOGS(_log, LOG_LVL_DEBUG, "WHERE clause is unsatisfiable, false term at " << pos);
+                    context.unsatisfiable = true;
+                    return;
+                }
+                tautologies.insert(pos);
+            } else if (c != Cmp::NE && leftConst && comp->right->isColumnRef()) {
+                addBound(comp->right, flip(c), left, comp->left, pos);
+            } else if (c != Cmp::NE && rightConst && comp->left->isColumnRef()) {
+                addBound(comp->left, c, right, comp->right, pos);
+            }
+        } else if (auto between = std::dynamic_pointer_cast<query::BetweenPredicate>(pred)) {
+            Number value, lo, hi;
+            if (between->hasNot || !between->value || !between->minValue || !between->maxValue
+                || !evaluate(*between->minValue, lo) || !evaluate(*between->maxValue, hi)) {
+                continue;
+            }
+            if (evaluate(*between->value, value)) {
+                if (compare(lo, value) > 0 || compare(value, hi) > 0) {
+                    LOGS(_log, LOG_LVL_DEBUG, "WHERE clause is unsatisfiable, false term at " << pos);
+                    context.unsatisfiable = true;
+                    return;
+                }
+                tautologies.insert(pos);
+            } else if (between->value->isColumnRef()) {
+                addBound(between->value, Cmp::GE, lo, between->minValue, pos);
+                addBound(between->value, Cmp::LE, hi, between->maxValue, pos);
+            }
+        }
+    }
+
+    // Terms to drop, and the merged terms replacing the first of each range.
+    std::set<size_t> dropped(tautologies);
+    std::map<size_t, std::vector<std::shared_ptr<query::BoolTerm>>> replacements;
+    for (auto const& elem : ranges) {
+        Range const& range = elem.second;
+        if (range.isEmpty()) {
+            LOGS(_log, LOG_LVL_DEBUG, "WHERE clause is unsatisfiable, empty range of " << elem.first);
+            context.unsatisfiable = true;
+            return;
+        }
+        if (range.terms.size() > 1) {
+            dropped.insert(range.terms.begin(), range.terms.end());
+            replacements[*range.terms.begin()] = range.makeTerms();
+        }
+    }
+    if (dropped.empty()) {
+        return;
+    }
+    query::BoolTerm::PtrVector simplified;
+    for (size_t pos = 0; pos < terms.size(); ++pos) {
+        auto iter = replacements.find(pos);
+        if (iter != replacements.end()) {
+            simplified.insert(simplified.end(), iter->second.begin(), iter->second.end());
+        } else if (dropped.count(pos) == 0) {
+            simplified.push_back(terms[pos]);
+        }
+    }
+    // Keep a true term rather than leaving WHERE without a condition.
+    if (simplified.empty()) {
+        simplified.push_back(terms[*tautologies.begin()]);
+    }
+    LOGS(_log, LOG_LVL_DEBUG, "WHERE clause simplified from " << terms.size()
+         << " to " << simplified.size() << " terms");
+    terms.swap(simplified);
+}
+
+}}} // namespace lsst::qserv::qana
@@ -0,0 +1,65 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_QANA_SIMPLIFYPLUGIN_H
+#define LSST_QSERV_QANA_SIMPLIFYPLUGIN_H
+
+// Qserv headers
+#include "qana/QueryPlugin.h"
+
+
+namespace lsst {
+namespace qserv {
+namespace qana {
+
+
+/// SimplifyPlugin simplifies the terms of the global AND of the WHERE
+/// clause that compare values to numeric constants:
+///
+/// - comparisons of two constants are evaluated, integer arithmetic on
+///   constants (+, -, *) being folded first. True ones are removed, a
+///   false one makes the WHERE clause unsatisfiable;
+/// - the comparisons and BETWEEN predicates bounding the same column
+///   are merged into the tightest ones, and make the WHERE clause
+///   unsatisfiable if their ranges do not intersect.
+///
+/// An unsatisfiable WHERE clause is left as is, and flagged in
+/// QueryContext::unsatisfiable so that no chunk gets dispatched.
+/// Terms under an OR or a NOT are not considered.
+class SimplifyPlugin : public QueryPlugin {
+public:
+    // Types
+    typedef std::shared_ptr<SimplifyPlugin> Ptr;
+
+    SimplifyPlugin() {}
+    virtual ~SimplifyPlugin() {}
+    std::string name() const override { return "Simplify"; }
+
+    void prepare() override {}
+
+    void applyLogical(query::SelectStmt& stmt, query::QueryContext& context) override;
+    void applyPhysical(QueryPlugin::Plan& p, query::QueryContext&) override {}
+};
+
+}}} // namespace lsst::qserv::qana
+
+#endif // LSST_QSERV_QANA_SIMPLIFYPLUGIN_H
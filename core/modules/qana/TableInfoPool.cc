@@ -30,6 +30,7 @@
 // System headers
 #include <algorithm>
 #include <memory>
+#include <mutex>
 #include <utility>
 
 // Third-party headers
@@ -56,15 +57,46 @@ namespace lsst {
 namespace qserv {
 namespace qana {
 
+TableInfoPool::TableInfoPool(std::string const& defaultDb,
+                             css::CssAccess const& css)
+    : _defaultDb(defaultDb), _css(css), _shared(_getShared(css.getVersion())) {
+}
+
+std::shared_ptr<TableInfoPool::Shared>
+TableInfoPool::_getShared(std::string const& version) {
+    if (version.empty()) {
+        return std::make_shared<Shared>();
+    }
+    // Only the entries of the latest version are kept; pools created for
+    // an older one keep theirs alive until they are destroyed.
+    static std::mutex mtx;
+    static std::string latestVersion;
+    static std::shared_ptr<Shared> latest;
+    std::lock_guard<std::mutex> lock(mtx);
+    if (latest == nullptr || version != latestVersion) {
+        latestVersion = version;
+        latest = std::make_shared<Shared>();
+    }
+    return latest;
+}
+
 TableInfo const*
 TableInfoPool::get(std::string const& db, std::string const& table) {
+    std::lock_guard<std::mutex> lock(_shared->mtx);
+    return _get(db, table);
+}
+
+TableInfo const*
+TableInfoPool::_get(std::string const& db, std::string const& table) {
 
     std::string const& db_ = db.empty() ? _defaultDb : db;
 
     // Note that t.kind is irrelevant to the search,
-    // and is set to an arbitrary value.
-    std::unique_ptr<TableInfo const> t(new TableInfo(db, table, TableInfo::DIRECTOR));
-    auto range = std::equal_range(_pool.begin(), _pool.end(), t, TableInfoLt());
+    // and is set to an arbitrary value. Pooled objects carry the
+    // resolved database name, so it is used for the search as well.
+    Pool& pool = _shared->pool;
+    std::unique_ptr<TableInfo const> t(new TableInfo(db_, table, TableInfo::DIRECTOR));
+    auto range = std::equal_range(pool.begin(), pool.end(), t, TableInfoLt());
     if (range.first != range.second) {
         return range.first->get();
     }
@@ -82,9 +114,9 @@ TableInfoPool::get(std::string const& db, std::string const& table) {
         double angSep = m.angSep;
         std::unique_ptr<MatchTableInfo> infoPtr(new MatchTableInfo(db_, table, angSep));
         infoPtr->director.first = dynamic_cast<DirTableInfo const*>(
-            get(db_, m.dirTable1));
+            _get(db_, m.dirTable1));
         infoPtr->director.second = dynamic_cast<DirTableInfo const*>(
-            get(db_, m.dirTable2));
+            _get(db_, m.dirTable2));
         if (!infoPtr->director.first || !infoPtr->director.second) {
             throw InvalidTableError(db_ + "." + table + " is a match table, but"
                                     " does not reference two director tables!");
@@ -116,7 +148,7 @@ TableInfoPool::get(std::string const& db, std::string const& table) {
         // use per-table or per-database overlap value
         double overlap = partParam.overlap != 0.0 ? partParam.overlap : dbStriping.overlap;
         std::unique_ptr<DirTableInfo> infoPtr(new DirTableInfo(db_, table, overlap));
-        std::vector<std::string> v = _css.getPartTableParams(db, table).partitionCols();
+        std::vector<std::string> v = _css.getPartTableParams(db_, table).partitionCols();
         if (v.size() != 3 ||
             v[0].empty() || v[1].empty() || v[2].empty() ||
             v[0] == v[1] || v[1] == v[2] || v[0] == v[2]) {
@@ -138,7 +170,7 @@ TableInfoPool::get(std::string const& db, std::string const& table) {
     }
     std::unique_ptr<ChildTableInfo> infoPtr(new ChildTableInfo(db_, table));
     infoPtr->director = dynamic_cast<DirTableInfo const*>(
-        get(db_, partParam.dirTable));
+        _get(db_, partParam.dirTable));
     if (!infoPtr->director) {
         throw InvalidTableError(db_ + "." + table + " is a child table, but"
                                 " does not reference a director table!");
@@ -155,9 +187,10 @@ TableInfoPool::get(std::string const& db, std::string const& table) {
 TableInfo const*
 TableInfoPool::_insert(std::unique_ptr<TableInfo const> t) {
     if (t != nullptr) {
+        Pool& pool = _shared->pool;
         Pool::iterator iter =
-            std::upper_bound(_pool.begin(), _pool.end(), t, TableInfoLt());
-        iter = _pool.insert(iter, std::move(t));
+            std::upper_bound(pool.begin(), pool.end(), t, TableInfoLt());
+        iter = pool.insert(iter, std::move(t));
         return iter->get();
     }
     return nullptr;
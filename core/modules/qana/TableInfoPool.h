@@ -29,6 +29,7 @@
 
 // System headers
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -55,11 +56,14 @@ namespace qana {
 /// is no facility for removing pool entries, so the lifetime of all retrieved
 /// pointers is that of the pool itself.
 ///
-/// `TableInfoPool` is not currently thread-safe.
+/// When the CSS contents can be identified (see `css::CssAccess::getVersion`),
+/// the objects are shared by all pools created for the same CSS version, so
+/// that queries do not rebuild them from CSS metadata every time. The shared
+/// objects are kept until a pool is created for another version. `get` is
+/// thread-safe, but a given pool is normally used by a single query.
 class TableInfoPool {
 public:
-    TableInfoPool(std::string const& defaultDb, css::CssAccess const& css)
-        : _defaultDb(defaultDb), _css(css) {}
+    TableInfoPool(std::string const& defaultDb, css::CssAccess const& css);
 
     // not implemented
     TableInfoPool(TableInfoPool const&) = delete;
@@ -86,12 +90,25 @@ private:
     // is expected to be small.
     typedef std::vector<std::unique_ptr<TableInfo const>> Pool;
 
+    // Pool entries for the same CSS version, shared between pools.
+    struct Shared {
+        std::mutex mtx; // protects pool
+        Pool pool;
+    };
+
+    // the shared entries for `version`, private ones if it is empty.
+    static std::shared_ptr<Shared> _getShared(std::string const& version);
+
+    // `get` implementation. Precondition: _shared->mtx must be held.
+    TableInfo const* _get(std::string const& db,
+                          std::string const& table);
+
     // save owned TableInfo pointer in pool, return non-owned pointer.
     TableInfo const* _insert(std::unique_ptr<TableInfo const> t);
 
     std::string const _defaultDb;
     css::CssAccess const& _css;
-    Pool _pool;
+    std::shared_ptr<Shared> const _shared;
 };
 
 }}} // namespace lsst::qserv::qana
@@ -42,6 +42,7 @@ public:
 
     TablePlugin() {}
     virtual ~TablePlugin() {}
+    std::string name() const override { return "Table"; }
 
     void prepare() override {}
 
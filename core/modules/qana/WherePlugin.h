@@ -41,6 +41,7 @@ public:
 
     WherePlugin() {}
     virtual ~WherePlugin() {}
+    std::string name() const override { return "Where"; }
 
     void prepare() override {}
 
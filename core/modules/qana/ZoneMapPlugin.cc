@@ -0,0 +1,155 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "qana/ZoneMapPlugin.h"
+
+// System headers
+#include <cstdlib>
+#include <functional>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "css/CssAccess.h"
+#include "css/ZoneMaps.h"
+#include "query/AndTerm.h"
+#include "query/BetweenPredicate.h"
+#include "query/BoolFactor.h"
+#include "query/ColumnRef.h"
+#include "query/CompPredicate.h"
+#include "query/NullPredicate.h"
+#include "query/QueryContext.h"
+#include "query/SelectStmt.h"
+#include "query/SqlSQL2Tokens.h"
+#include "query/ValueExpr.h"
+#include "query/WhereClause.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.qana.ZoneMapPlugin");
+
+using lsst::qserv::css::ColumnRange;
+using lsst::qserv::css::ZoneMap;
+using lsst::qserv::query::QueryContext;
+using lsst::qserv::query::ValueExprPtr;
+
+/// Test whether a chunk may hold rows satisfying a predicate.
+using RangeTest = std::function<bool(ColumnRange const&)>;
+
+/// @return the chunk ranges of the column 'vexpr' refers to, if it is a
+///         column of a table of the dominant database with a zone map.
+ZoneMap::ChunkRanges const* rangesOf(QueryContext& context, ZoneMap const& zoneMap,
+                                     ValueExprPtr const& vexpr) {
+    if (!vexpr) return nullptr;
+    auto cr = vexpr->copyAsColumnRef();
+    if (!cr) return nullptr;
+    auto const tables = context.resolve(cr);
+    // An ambiguous column fails on the workers anyway.
+    if (tables.size() != 1 || tables.begin()->db != context.dominantDb) return nullptr;
+    return zoneMap.get(tables.begin()->table, cr->column);
+}
+
+/// @return true if 'vexpr' is a number, stored in 'val'.
+bool numberOf(ValueExprPtr const& vexpr, long double& val) {
+    if (!vexpr) return false;
+    std::string const str = vexpr->copyAsLiteral();
+    if (str.empty()) return false;
+    char* end = nullptr;
+    val = std::strtold(str.c_str(), &end);
+    return *end == '\0';
+}
+
+/// @return the range test of the comparison operator 'op' for 'val', or of
+///         its mirror image, for "number <op> column", if 'flip'.
+RangeTest compTest(int op, long double val, bool flip) {
+    ColumnRange::Op rop;
+    switch (op) {
+    case SqlSQL2Tokens::EQUALS_OP: rop = ColumnRange::EQ; break;
+    case SqlSQL2Tokens::LESS_THAN_OP: rop = flip ? ColumnRange::GT : ColumnRange::LT; break;
+    case SqlSQL2Tokens::LESS_THAN_OR_EQUALS_OP: rop = flip ? ColumnRange::GE : ColumnRange::LE; break;
+    case SqlSQL2Tokens::GREATER_THAN_OP: rop = flip ? ColumnRange::LT : ColumnRange::GT; break;
+    case SqlSQL2Tokens::GREATER_THAN_OR_EQUALS_OP: rop = flip ? ColumnRange::LE : ColumnRange::GE; break;
+    default: return nullptr;
+    }
+    return [rop, val](ColumnRange const& range) { return range.mayMatch(rop, val); };
+}
+
+} // annonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace qana {
+
+void ZoneMapPlugin::applyPhysical(QueryPlugin::Plan& plan, query::QueryContext& context) {
+    context.prunedChunks.clear();
+    if (!context.css || context.dominantDb.empty() || context.hasSubChunks()
+        || !plan.stmtOriginal.hasWhereClause()) {
+        return;
+    }
+    auto const zoneMap = context.css->getZoneMaps().get(context.dominantDb);
+    if (zoneMap->empty()) return;
+    auto const andTerm = plan.stmtOriginal.getWhereClause().getRootAndTerm();
+    if (!andTerm) return;
+
+    for (auto const& term : andTerm->_terms) {
+        // Every row of the result satisfies each top level term.
+        auto const factor = std::dynamic_pointer_cast<query::BoolFactor>(term);
+        if (!factor || factor->_hasNot || factor->_terms.size() != 1) continue;
+        auto const& factorTerm = factor->_terms.front();
+
+        ZoneMap::ChunkRanges const* ranges = nullptr;
+        RangeTest test;
+        long double val = 0, high = 0;
+        if (auto const comp = std::dynamic_pointer_cast<query::CompPredicate>(factorTerm)) {
+            if ((ranges = rangesOf(context, *zoneMap, comp->left)) != nullptr) {
+                if (numberOf(comp->right, val)) test = compTest(comp->op, val, false);
+            } else if ((ranges = rangesOf(context, *zoneMap, comp->right)) != nullptr) {
+                if (numberOf(comp->left, val)) test = compTest(comp->op, val, true);
+            }
+        } else if (auto const between = std::dynamic_pointer_cast<query::BetweenPredicate>(factorTerm)) {
+            ranges = rangesOf(context, *zoneMap, between->value);
+            if (ranges != nullptr && !between->hasNot
+                && numberOf(between->minValue, val) && numberOf(between->maxValue, high)) {
+                test = [val, high](ColumnRange const& range) { return range.mayMatchBetween(val, high); };
+            }
+        } else if (auto const isNull = std::dynamic_pointer_cast<query::NullPredicate>(factorTerm)) {
+            ranges = rangesOf(context, *zoneMap, isNull->value);
+            if (!isNull->hasNot) {
+                test = [](ColumnRange const& range) { return range.nullCount > 0; };
+            }
+        }
+        if (ranges == nullptr || !test) continue;
+
+        // Chunks missing from the zone map are kept.
+        for (auto const& elem : *ranges) {
+            if (!test(elem.second)) {
+                context.prunedChunks.insert(elem.first);
+            }
+        }
+    }
+    LOGS(_log, LOG_LVL_DEBUG, "ZoneMapPlugin leaves out " << context.prunedChunks.size() << " chunks");
+}
+
+}}} // namespace lsst::qserv::qana
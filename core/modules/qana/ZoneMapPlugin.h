@@ -0,0 +1,55 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_QANA_ZONEMAPPLUGIN_H
+#define LSST_QSERV_QANA_ZONEMAPPLUGIN_H
+
+// Qserv headers
+#include "qana/QueryPlugin.h"
+
+namespace lsst {
+namespace qserv {
+namespace qana {
+
+/// ZoneMapPlugin leaves out the chunks that can not hold a row satisfying
+/// the WHERE clause, according to the per-chunk ranges of the columns in
+/// the zone map of the dominant database (css::ZoneMaps). It looks at the
+/// top level AND terms of the form "column <op> number", with <op> one of
+/// =, <, <=, > or >=, "column BETWEEN number AND number" and
+/// "column IS NULL", on columns of its chunked tables. The chunks to leave
+/// out go to QueryContext::prunedChunks.
+///
+/// Near neighbour queries are left alone, their overlap tables hold rows
+/// of the neighbouring chunks.
+class ZoneMapPlugin : public QueryPlugin {
+public:
+    typedef std::shared_ptr<ZoneMapPlugin> Ptr;
+
+    ZoneMapPlugin() {}
+    std::string name() const override { return "ZoneMap"; }
+
+    void applyPhysical(QueryPlugin::Plan& plan, query::QueryContext& context) override;
+};
+
+}}} // namespace lsst::qserv::qana
+
+#endif // LSST_QSERV_QANA_ZONEMAPPLUGIN_H
@@ -44,10 +44,12 @@
 #include "qana/PostPlugin.h"
 #include "qana/QueryPlugin.h"
 #include "qana/QservRestrictorPlugin.h"
+#include "qana/SimplifyPlugin.h"
 #include "query/ColumnRef.h"
 #include "query/QueryContext.h"
 #include "query/SelectStmt.h"
 #include "query/TestFactory.h"
+#include "query/WhereClause.h"
 #include "util/IterableFormatter.h"
 
 
@@ -340,6 +342,46 @@ BOOST_AUTO_TEST_CASE(DuplicateSelectExpr) {
 }
 
 
+struct SimplifyData {
+    SimplifyData(std::string const& q, std::string const& w, bool u)
+    : query(q), where(w), unsatisfiable(u) {}
+
+    std::string query;
+    std::string where; // expected WHERE clause after simplification
+    bool unsatisfiable;
+};
+
+std::ostream& operator<<(std::ostream& os, SimplifyData const& self) {
+    os << "SimplifyData(query:" << self.query << ", where:" << self.where << ")";
+    return os;
+}
+
+static const std::vector<SimplifyData> SIMPLIFY_QUERIES = {
+    SimplifyData("SELECT a FROM T WHERE x>1 AND x>3 AND y=2", "x>3 AND y=2", false),
+    SimplifyData("SELECT a FROM T WHERE x>=1 AND 10>x", "x>=1 AND x<10", false),
+    SimplifyData("SELECT a FROM T WHERE x>=1 AND x<=1.0", "x=1", false),
+    SimplifyData("SELECT a FROM T WHERE x BETWEEN 1 AND 5 AND x BETWEEN 3 AND 8", "x BETWEEN 3 AND 5", false),
+    SimplifyData("SELECT a FROM T WHERE 1=1 AND y=2", "y=2", false),
+    SimplifyData("SELECT a FROM T WHERE x>1 OR x>3", "x>1 OR x>3", false),
+    SimplifyData("SELECT a FROM T WHERE s='a' AND s='b'", "s='a' AND s='b'", false),
+    SimplifyData("SELECT a FROM T WHERE x BETWEEN 1 AND 5 AND x>5", "x BETWEEN 1 AND 5 AND x>5", true),
+    SimplifyData("SELECT a FROM T WHERE 2+3*4=15 AND y=2", "(2+3 * 4)=15 AND y=2", true),
+};
+
+BOOST_DATA_TEST_CASE(Simplify, SIMPLIFY_QUERIES, data) {
+    auto parser = parser::SelectParser::newInstance(data.query, parser::SelectParser::ANTLR4);
+    parser->setup();
+    auto stmt = parser->getSelectStmt();
+    QueryPlugin::Ptr qp = std::make_shared<qana::SimplifyPlugin>();
+    TestFactory factory;
+    std::shared_ptr<QueryContext> qc = factory.newContext(css, schemaCfg);
+    qp->prepare();
+    qp->applyLogical(*stmt, *qc);
+    BOOST_CHECK_EQUAL(stmt->getWhereClause().getGenerated(), data.where);
+    BOOST_CHECK_EQUAL(qc->unsatisfiable, data.unsatisfiable);
+}
+
+
 BOOST_AUTO_TEST_SUITE_END()
 
 
@@ -44,7 +44,9 @@
 #include <deque>
 #include <functional>
 #include <iostream>
+#include <map>
 #include <sstream>
+#include <thread>
 
 // Third-party headers
 #include "boost/format.hpp"
@@ -63,7 +65,10 @@
 #include "qdisp/JobQuery.h"
 #include "qdisp/MessageStore.h"
 #include "qdisp/QueryRequest.h"
+#include "qdisp/ReplicaSelector.h"
 #include "qdisp/ResponseHandler.h"
+#include "qdisp/ScanCursors.h"
+#include "qdisp/WorkerSessions.h"
 #include "qdisp/XrdSsiMocks.h"
 #include "qmeta/Exceptions.h"
 #include "qmeta/QStatus.h"
@@ -196,6 +201,18 @@ void Executive::queueJobStart(PriorityCommand::Ptr const& cmd, bool scanInteract
 }
 
 
+std::vector<size_t> Executive::dispatchOrder(std::vector<int> const& chunkIds, bool scanInteractive) const {
+    if (_config.scanAffinityOrder && !scanInteractive) {
+        return ScanCursors::instance().order(chunkIds);
+    }
+    std::vector<size_t> positions(chunkIds.size());
+    for (size_t j = 0; j < positions.size(); ++j) {
+        positions[j] = j;
+    }
+    return positions;
+}
+
+
 void Executive::waitForAllJobsToStart() {
     LOGS(_log, LOG_LVL_INFO, _idStr << " waitForAllJobsToStart");
     // Wait for each command to start.
@@ -222,16 +239,36 @@ bool Executive::startQuery(std::shared_ptr<JobQuery> const& jobQuery) {
     //
     if (_cancelled) return false;
 
+    // Send the job to the least loaded replica of its chunk, if there is a
+    // choice, leaving out the workers the job already failed on.
+    //
+    ResourceUnit const& ru = jobQuery->getDescription()->resource();
+    std::string path = ru.path();
+    std::string worker;
+    auto const& selector = _config.replicaSelector;
+    if (selector != nullptr && ru.unitType() == ResourceUnit::DBCHUNK) {
+        worker = selector->select(ru.db(), ru.chunk(), jobQuery->getFailedWorkers());
+        if (!worker.empty()) {
+            path = ResourceUnit::makePath(ru.chunk(), ru.db(), worker);
+            if (_config.workerSessions != nullptr) {
+                _config.workerSessions->used(worker);
+            }
+        }
+    }
+
     // Construct a temporary resource object to pass to ProcessRequest().
     // For now, we don't set any other attributes except the resource name.
     //
-    XrdSsiResource jobResource(jobQuery->getDescription()->resource().path());
+    XrdSsiResource jobResource(path);
 
     // Now construct the actual query request and tie it to the jobQuery. The
     // shared pointer is used by QueryRequest to keep itself alive, sloppy design.
     // Note that JobQuery calls StartQuery that then calls JobQuery, yech!
     //
     QueryRequest::Ptr qr = QueryRequest::create(jobQuery);
+    if (!worker.empty()) {
+        qr->setReplica(selector, worker);
+    }
     jobQuery->setQueryRequest(qr);
 
     // Start the query. The rest is magically done in the background.
@@ -241,13 +278,54 @@ bool Executive::startQuery(std::shared_ptr<JobQuery> const& jobQuery) {
 }
 
 
+void Executive::addUsage(qmeta::QUsage const& usage) {
+    std::lock_guard<std::mutex> lock(_usageMtx);
+    _usage += usage;
+}
+
+
+qmeta::QUsage Executive::getUsage() const {
+    std::lock_guard<std::mutex> lock(_usageMtx);
+    return _usage;
+}
+
+
+bool Executive::startResponseRead(std::function<bool()> const& read) {
+    std::lock_guard<std::mutex> lock(_responseReadsMtx);
+    if (_config.maxResponseReads > 0 && _responseReads >= _config.maxResponseReads) {
+        _queuedReads.push_back(read);
+        return false;
+    }
+    ++_responseReads;
+    return true;
+}
+
+
+void Executive::endResponseRead() {
+    while (true) {
+        std::function<bool()> read;
+        {
+            std::lock_guard<std::mutex> lock(_responseReadsMtx);
+            if (_queuedReads.empty()) {
+                --_responseReads;
+                return;
+            }
+            read = std::move(_queuedReads.front());
+            _queuedReads.pop_front();
+        }
+        // Called without the lock, the read may start or end other reads.
+        if (read()) {
+            return;
+        }
+    }
+}
+
+
 /// Add a JobQuery to this Executive.
 /// Return true if it was successfully added to the map.
 ///
 bool Executive::_addJobToMap(JobQuery::Ptr const& job) {
-    auto entry = std::pair<int, JobQuery::Ptr>(job->getIdInt(), job);
-    std::lock_guard<std::recursive_mutex> lockJobMap(_jobMapMtx);
-    bool res = _jobMap.insert(entry).second;
+    bool res = _jobMap.insert(job->getIdInt(), job);
     _totalJobs = _jobMap.size();
     return res;
 }
@@ -257,19 +335,14 @@ bool Executive::join() {
     // Check to see if _requesters is empty, if not, then sleep on a condition.
     _waitAllUntilEmpty();
     // Okay to merge. probably not the Executive's responsibility
-    struct successF {
-        static bool f(Executive::JobMap::value_type const& entry) {
-            JobStatus::Info const& esI = entry.second->getStatus()->getInfo();
-            LOGS(_log, LOG_LVL_DEBUG, "entry state:" << (void*)entry.second.get() << " " << esI);
-            return (esI.state == JobStatus::RESPONSE_DONE) || (esI.state == JobStatus::COMPLETE);
-        }
-    };
-
     int sCount = 0;
-    {
-        std::lock_guard<std::recursive_mutex> lockJobMap(_jobMapMtx);
-        sCount = std::count_if(_jobMap.begin(), _jobMap.end(), successF::f);
-    }
+    _jobMap.forEach([&sCount](int, JobQuery::Ptr const& job) {
+        JobStatus::Info const& esI = job->getStatus()->getInfo();
+        LOGS(_log, LOG_LVL_DEBUG, "entry state:" << (void*)job.get() << " " << esI);
+        if ((esI.state == JobStatus::RESPONSE_DONE) || (esI.state == JobStatus::COMPLETE)) {
+            ++sCount;
+        }
+    });
     if (sCount == _requestCount) {
         LOGS(_log, LOG_LVL_DEBUG, "Query execution succeeded: " << _requestCount
              << " jobs dispatched and completed.");
@@ -278,7 +351,11 @@ bool Executive::join() {
              << " jobs dispatched, but only " << sCount << " jobs completed");
     }
     _updateProxyMessages();
-    bool empty = (sCount == _requestCount);
+    if (_satisfied && sCount != _requestCount) {
+        LOGS(_log, LOG_LVL_DEBUG, "Query result complete after " << sCount
+             << " jobs, the remaining jobs were squashed");
+    }
+    bool empty = (sCount == _requestCount) || _satisfied;
     _empty.store(empty);
     LOGS(_log, LOG_LVL_DEBUG, "Flag set to _empty=" << empty << ", sCount=" << sCount
          << ", requestCount=" << _requestCount);
@@ -290,32 +367,39 @@ void Executive::markCompleted(int jobId, bool success) {
     std::string idStr = QueryIdHelper::makeIdStr(_id, jobId);
     LOGS(_log, LOG_LVL_DEBUG, "Executive::markCompleted " << idStr
             << " " << success);
+    if (!success && _satisfied) {
+        // Squashed after the result was complete, not an error.
+        _unTrack(jobId);
+        return;
+    }
+    if (success && _config.stragglerPercentile > 0) {
+        auto job = _jobMap.find(jobId);
+        if (job != nullptr) {
+            std::lock_guard<std::mutex> lock(_jobTimesMtx);
+            _jobTimes.push_back(job->getAttemptElapsed());
+        }
+    }
     if (!success) {
-        {
-            std::lock_guard<std::mutex> lock(_incompleteJobsMutex);
-            auto iter = _incompleteJobs.find(jobId);
-            if (iter != _incompleteJobs.end()) {
-                auto jobQuery =  iter->second;
-                err = jobQuery->getDescription()->respHandler()->getError();
+        auto jobQuery = _incompleteJobs.find(jobId);
+        if (jobQuery != nullptr) {
+            err = jobQuery->getDescription()->respHandler()->getError();
+        } else {
+            std::string msg = "Executive::markCompleted failed to find TRACKED " + idStr +
+                    " size=" + std::to_string(_incompleteJobs.size());
+            // If the user query has been cancelled, this is expected for jobs that have not yet
+            // been tracked. Otherwise, this indicates a serious problem.
+            if (!getCancelled()) {
+                LOGS(_log, LOG_LVL_WARN, msg << " " << _getIncompleteJobsString(-1));
+                throw Bug(msg);
             } else {
-                std::string msg = "Executive::markCompleted failed to find TRACKED " + idStr +
-                        " size=" + std::to_string(_incompleteJobs.size());
-                // If the user query has been cancelled, this is expected for jobs that have not yet
-                // been tracked. Otherwise, this indicates a serious problem.
-                if (!getCancelled()) {
-                    LOGS(_log, LOG_LVL_WARN, msg << " " << _getIncompleteJobsString(-1));
-                    throw Bug(msg);
-                } else {
-                    LOGS(_log, LOG_LVL_DEBUG, msg);
-                }
-                return;
+                LOGS(_log, LOG_LVL_DEBUG, msg);
             }
+            return;
         }
         LOGS(_log, LOG_LVL_ERROR, "Executive: error executing " << idStr
              << " " << err << " (status: " << err.getStatus() << ")");
         {
-            std::lock_guard<std::recursive_mutex> lockJobMap(_jobMapMtx);
-            auto job = _jobMap[jobId];
+            auto job = _jobMap.find(jobId);
             std::string id = job->getIdStr() + "<>" + idStr;
             job->getStatus()->updateInfo(id, JobStatus::RESULT_ERROR, err.getCode(), err.getMsg());
         }
@@ -344,12 +428,9 @@ void Executive::squash() {
 
     LOGS(_log, LOG_LVL_DEBUG, getIdStr() << " Executive::squash Trying to cancel all queries...");
     std::deque<JobQuery::Ptr> jobsToCancel;
-    {
-        std::lock_guard<std::recursive_mutex> lockJobMap(_jobMapMtx);
-        for(auto const& jobEntry : _jobMap) {
-            jobsToCancel.push_back(jobEntry.second);
-        }
-    }
+    _jobMap.forEach([&jobsToCancel](int, JobQuery::Ptr const& job) {
+        jobsToCancel.push_back(job);
+    });
 
     for (auto const& job : jobsToCancel) {
             job->cancel();
@@ -357,29 +438,46 @@ void Executive::squash() {
     LOGS_DEBUG(getIdStr() << " Executive::squash done");
 }
 
-int Executive::getNumInflight() {
-    std::unique_lock<std::mutex> lock(_incompleteJobsMutex);
-    return _incompleteJobs.size();
+void Executive::squashSatisfied() {
+    {
+        std::lock_guard<std::recursive_mutex> lock(_cancelled.getMutex());
+        if (_cancelled || _satisfied) {
+            return;
+        }
+        _satisfied = true;
+    }
+    LOGS(_log, LOG_LVL_INFO, getIdStr() << " Executive::squashSatisfied result complete, squashing");
+    // This is called while merging a job's result, and cancelling that job
+    // needs locks its merge may hold, so squash on another thread.
+    auto thisPtr = shared_from_this();
+    std::thread squashThread([thisPtr]() { thisPtr->squash(); });
+    squashThread.detach();
 }
 
 std::string Executive::getProgressDesc() const {
     std::ostringstream os;
-    {
-        std::lock_guard<std::recursive_mutex> lockJobMap(_jobMapMtx);
-        auto first = true;
-        for (auto entry : _jobMap) {
-            JobQuery::Ptr job = entry.second;
-            if (!first) { os << "\n"; }
-            first = false;
-            os << "Ref=" << entry.first << " " << job;
-
-        }
-    }
+    auto first = true;
+    _jobMap.forEach([&os, &first](int jobId, JobQuery::Ptr const& job) {
+        if (!first) { os << "\n"; }
+        first = false;
+        os << "Ref=" << jobId << " " << job;
+    });
     std::string msg_progress = os.str();
     LOGS(_log, LOG_LVL_ERROR, msg_progress);
     return msg_progress;
 }
 
+XrdSsiService* Executive::getSharedXrdSsiService(std::string const& url, XrdSsiErrInfo& eInfo) {
+    static std::mutex mtx;
+    static std::map<std::string, XrdSsiService*> services;
+    std::lock_guard<std::mutex> lock(mtx);
+    XrdSsiService*& service = services[url];
+    if (service == nullptr) {
+        service = XrdSsiProviderClient->GetService(eInfo, url.c_str());
+    }
+    return service;
+}
+
 void Executive::_setup() {
 
     XrdSsiErrInfo eInfo;
@@ -389,7 +487,7 @@ void Executive::_setup() {
     if (_config.serviceUrl.compare(_config.getMockStr()) == 0) {
         _xrdSsiService = new XrdSsiServiceMock(this);
     } else {
-        _xrdSsiService = XrdSsiProviderClient->GetService(eInfo, _config.serviceUrl.c_str()); // Step 1
+        _xrdSsiService = getSharedXrdSsiService(_config.serviceUrl, eInfo); // Step 1
     }
     if (!_xrdSsiService) {
         LOGS(_log, LOG_LVL_DEBUG, _id << " Error obtaining XrdSsiService in Executive: "
@@ -409,39 +507,29 @@ void Executive::_setup() {
   */
 bool Executive::_track(int jobId, std::shared_ptr<JobQuery> const& r) {
     std::string idStr = QueryIdHelper::makeIdStr(_id, jobId);
-    int size = -1;
-    {
-        std::lock_guard<std::mutex> lock(_incompleteJobsMutex);
-        if (_incompleteJobs.find(jobId) != _incompleteJobs.end()) {
-            LOGS(_log, LOG_LVL_WARN, "Attempt for TRACKING " << idStr
-                 << " failed as jobId already found in incomplete jobs. "
-                 << _getIncompleteJobsString(-1));
-            return false;
-        }
-        _incompleteJobs[jobId] = r;
-        size = _incompleteJobs.size();
+    if (!_incompleteJobs.insert(jobId, r)) {
+        LOGS(_log, LOG_LVL_WARN, "Attempt for TRACKING " << idStr
+             << " failed as jobId already found in incomplete jobs. "
+             << _getIncompleteJobsString(-1));
+        return false;
     }
-    LOGS(_log, LOG_LVL_DEBUG, "Success TRACKING " << idStr << " size=" << size);
+    LOGS(_log, LOG_LVL_DEBUG, "Success TRACKING " << idStr << " size=" << _incompleteJobs.size());
     return true;
 }
 
 void Executive::_unTrack(int jobId) {
-    bool untracked = false;
     int incompleteJobs = _totalJobs;
+    bool untracked = _incompleteJobs.erase(jobId, incompleteJobs);
+    if (untracked && incompleteJobs == 0) {
+        // Taking the mutex makes sure a thread in _waitAllUntilEmpty() is
+        // either waiting or will see the map empty.
+        std::lock_guard<std::mutex> lock(_allJobsCompleteMtx);
+        _allJobsComplete.notify_all();
+    }
     std::string s;
-    {
-        std::lock_guard<std::mutex> lock(_incompleteJobsMutex);
-        auto i = _incompleteJobs.find(jobId);
-        if (i != _incompleteJobs.end()) {
-            _incompleteJobs.erase(i);
-            untracked = true;
-            incompleteJobs = _incompleteJobs.size();
-            if (_incompleteJobs.empty()) _allJobsComplete.notify_all();
-        }
-        if (!untracked || LOG_CHECK_LVL(_log, LOG_LVL_DEBUG)) {
-            // Log up to 5 incomplete jobs. Very useful when jobs do not finish.
-            s = _getIncompleteJobsString(5);
-        }
+    if (!untracked || LOG_CHECK_LVL(_log, LOG_LVL_DEBUG)) {
+        // Log up to 5 incomplete jobs. Very useful when jobs do not finish.
+        s = _getIncompleteJobsString(5);
     }
     LOGS(_log, (untracked ? LOG_LVL_DEBUG : LOG_LVL_WARN),
          "Executive UNTRACKING " << QueryIdHelper::makeIdStr(_id, jobId)
@@ -471,7 +559,6 @@ void Executive::_unTrack(int jobId) {
 }
 
 
-/// _incompleteJobsMutex must be held before calling this function.
 /// @return: a string containing a list of incomplete jobs containing up to 'maxToList' jobs.
 ///          If maxToList is less than 0, all jobs are printed
 std::string Executive::_getIncompleteJobsString(int maxToList) {
@@ -479,9 +566,12 @@ std::string Executive::_getIncompleteJobsString(int maxToList) {
     int c = 0;
     if (maxToList < 0) maxToList = _incompleteJobs.size();
     os << "_incompleteJobs listing first" << maxToList << " of size=" << _incompleteJobs.size() << " ";
-    for(auto j = _incompleteJobs.begin(), e = _incompleteJobs.end(); j != e && c < maxToList; ++j, ++c) {
-        os << j->first << " ";
-    }
+    _incompleteJobs.forEach([&os, &c, maxToList](int jobId, JobQuery::Ptr const&) {
+        if (c < maxToList) {
+            os << jobId << " ";
+            ++c;
+        }
+    });
     return os.str();
 }
 
@@ -494,22 +584,17 @@ std::string Executive::_getIncompleteJobsString(int maxToList) {
  * @see python module lsst.qserv.czar.proxy.unlock()
  */
 void Executive::_updateProxyMessages() {
-    {
-        std::lock_guard<std::recursive_mutex> lockJobMap(_jobMapMtx);
-        for (auto const& entry : _jobMap) {
-            JobQuery::Ptr const& job = entry.second;
-            auto const& info = job->getStatus()->getInfo();
-            std::ostringstream os;
-            os << info.state << " " << info.stateCode;
-            if (!info.stateDesc.empty()) {
-                os << " (" << info.stateDesc << ")";
-            }
-            os << " " << info.stateTime;
-            _messageStore->addMessage(job->getDescription()->resource().chunk(),
-                    info.state, os.str());
-
+    _jobMap.forEach([this](int, JobQuery::Ptr const& job) {
+        auto const& info = job->getStatus()->getInfo();
+        std::ostringstream os;
+        os << info.state << " " << info.stateCode;
+        if (!info.stateDesc.empty()) {
+            os << " (" << info.stateDesc << ")";
         }
-    }
+        os << " " << info.stateTime;
+        _messageStore->addMessage(job->getDescription()->resource().chunk(),
+                info.state, os.str());
+    });
     {
         std::lock_guard<std::mutex> lock(_errorsMutex);
         if (not _multiError.empty()) {
@@ -522,7 +607,7 @@ void Executive::_updateProxyMessages() {
 /// Typically the requesters are handled by markCompleted().
 /// _reapRequesters() deals with cases that involve errors.
 void Executive::_waitAllUntilEmpty() {
-    std::unique_lock<std::mutex> lock(_incompleteJobsMutex);
+    std::unique_lock<std::mutex> lock(_allJobsCompleteMtx);
     int lastCount = -1;
     int count;
     int moreDetailThreshold = 5;
@@ -547,6 +632,46 @@ void Executive::_waitAllUntilEmpty() {
             }
         }
         _allJobsComplete.wait_for(lock, statePrintDelay);
+        if (_config.stragglerPercentile > 0 && !_incompleteJobs.empty()) {
+            lock.unlock();
+            _retryStragglers();
+            lock.lock();
+        }
+    }
+}
+
+
+/// Run again the jobs that take much longer than most jobs of this query,
+/// hoping the new attempt goes to a less loaded worker holding a replica.
+void Executive::_retryStragglers() {
+    // Job times say little until enough jobs completed, and only the
+    // tail of the query benefits.
+    size_t const minCompleted = 10;
+    if (getCancelled() || _incompleteJobs.size() * 2 > _totalJobs) {
+        return;
+    }
+    std::chrono::milliseconds threshold;
+    {
+        std::lock_guard<std::mutex> lock(_jobTimesMtx);
+        if (_jobTimes.size() < minCompleted) {
+            return;
+        }
+        size_t idx = std::min(_jobTimes.size() - 1,
+                              (_jobTimes.size() * _config.stragglerPercentile) / 100);
+        std::nth_element(_jobTimes.begin(), _jobTimes.begin() + idx, _jobTimes.end());
+        threshold = _jobTimes[idx] * _config.stragglerFactor;
+    }
+    std::vector<JobQuery::Ptr> stragglers;
+    _incompleteJobs.forEach([&stragglers, threshold](int, JobQuery::Ptr const& job) {
+        if (!job->getStragglerRetried() && job->getAttemptElapsed() > threshold) {
+            stragglers.push_back(job);
+        }
+    });
+    for (auto const& job : stragglers) {
+        if (job->retryStraggler()) {
+            LOGS(_log, LOG_LVL_INFO, job->getIdStr() << " straggler retried, threshold="
+                 << threshold.count() << "ms");
+        }
     }
 }
 
@@ -556,12 +681,10 @@ std::ostream& operator<<(std::ostream& os, Executive::JobMap::value_type const&
     return os;
 }
 
-/// precondition: _requestersMutex is held by current thread.
 void Executive::_printState(std::ostream& os) {
-    for (auto const& entry : _incompleteJobs) {
-        JobQuery::Ptr job = entry.second;
+    _incompleteJobs.forEach([&os](int, JobQuery::Ptr const& job) {
         os << *job << "\n";
-    }
+    });
 }
 
 
@@ -28,6 +28,9 @@
 
 // System headers
 #include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
 #include <mutex>
 #include <sstream>
 #include <unordered_map>
@@ -41,6 +44,8 @@
 #include "qdisp/JobStatus.h"
 #include "qdisp/ResponseHandler.h"
 #include "qdisp/QdispPool.h"
+#include "qdisp/ShardedJobMap.h"
+#include "qmeta/QUsage.h"
 #include "util/EventThread.h"
 #include "util/InstanceCount.h"
 #include "util/MultiError.h"
@@ -48,6 +53,7 @@
 #include "util/ThreadPool.h"
 
 // Forward declarations
+class XrdSsiErrInfo;
 class XrdSsiService;
 
 namespace lsst {
@@ -61,6 +67,8 @@ namespace qdisp {
 class JobQuery;
 class LargeResultMgr;
 class MessageStore;
+class ReplicaSelector;
+class WorkerSessions;
 
 
 /// class Executive manages the execution of jobs for a UserQuery, while
@@ -78,6 +86,21 @@ public:
 
         std::string serviceUrl; ///< XrdSsi service URL, e.g. localhost:1094
         int secondsBetweenChunkUpdates; ///< Seconds between QMeta chunk updates.
+        /// Percentile of completed job times used to spot stragglers, 0 never retries them.
+        int stragglerPercentile{0};
+        /// A job is a straggler after running this many times that percentile.
+        int stragglerFactor{3};
+        /// Send the jobs of scan queries in the order the worker scans reach
+        /// their chunks, see ScanCursors.
+        bool scanAffinityOrder{false};
+        /// Response buffers of the query that may be read from the workers or
+        /// merged at once, 0 means no limit.
+        int maxResponseReads{0};
+        /// Picks the worker of each job among the replicas of its chunk,
+        /// null leaves it to the xrootd redirector.
+        std::shared_ptr<ReplicaSelector> replicaSelector;
+        /// Keeps the connections to the workers open, may be null.
+        std::shared_ptr<WorkerSessions> workerSessions;
         static std::string getMockStr() {return "Mock";};
     };
 
@@ -95,6 +118,11 @@ public:
     /// Queue a job to be sent to a worker so it can be started.
     void queueJobStart(PriorityCommand::Ptr const& cmd, bool scanInteractive);
 
+    /// @return the positions in 'chunkIds' in the order their jobs should be
+    ///         queued. Jobs of scan queries follow the worker scans when
+    ///         Config::scanAffinityOrder is set, the order is kept otherwise.
+    std::vector<size_t> dispatchOrder(std::vector<int> const& chunkIds, bool scanInteractive) const;
+
     /// Waits for all jobs on _jobStartCmdList to start. This should not be called
     /// before ALL jobs have been added to the pool.
     void waitForAllJobsToStart();
@@ -110,6 +138,10 @@ public:
     /// Squash all the jobs.
     void squash();
 
+    /// Squash the remaining jobs because the result is already complete,
+    /// the query still succeeds.
+    void squashSatisfied();
+
     bool getEmpty() { return _empty; }
 
     void setQueryId(QueryId id);
@@ -117,7 +149,7 @@ public:
     std::string const& getIdStr() const { return _idStr; }
 
     /// @return number of items in flight.
-    int getNumInflight(); // non-const, requires a mutex.
+    int getNumInflight() const { return _incompleteJobs.size(); }
 
     /// @return a description of the current execution progress.
     std::string getProgressDesc() const;
@@ -127,10 +159,31 @@ public:
 
     XrdSsiService* getXrdSsiService() { return _xrdSsiService; }
 
+    /// @return the XrdSsiService of 'url', shared by every query of the czar
+    ///         so that the sessions it keeps to the workers outlive the
+    ///         queries, or nullptr with the reason in 'eInfo'.
+    static XrdSsiService* getSharedXrdSsiService(std::string const& url, XrdSsiErrInfo& eInfo);
+
     std::shared_ptr<QdispPool> getQdispPool() { return _qdispPool; }
 
     bool startQuery(std::shared_ptr<JobQuery> const& jobQuery);
 
+    /// Add resources used by a job attempt to those of the query.
+    void addUsage(qmeta::QUsage const& usage);
+
+    /// @return the resources used by the job attempts so far.
+    qmeta::QUsage getUsage() const;
+
+    /// Take one of the query's response reads, held by a job from asking a
+    /// worker for a buffer until the buffer is processed. If none is left,
+    /// 'read' is queued and called by endResponseRead() with the read handed
+    /// over, 'read' returns false if it did not use it.
+    /// @return true if the caller took a read and should call 'read' itself.
+    bool startResponseRead(std::function<bool()> const& read);
+
+    /// Give back a response read, handing it to the oldest queued read.
+    void endResponseRead();
+
     std::mutex sumMtx; // TEMPORARY-timing
     int cancelLockQSEASum{0}; // TEMPORARY-timing
     int jobQueryQSEASum{0}; // TEMPORARY-timing
@@ -152,6 +205,7 @@ private:
     void _updateProxyMessages();
 
     void _waitAllUntilEmpty();
+    void _retryStragglers();
 
     // for debugging
     void _printState(std::ostream& os);
@@ -160,8 +214,8 @@ private:
     std::atomic<bool> _empty{true};
     std::shared_ptr<MessageStore> _messageStore; ///< MessageStore for logging
     XrdSsiService* _xrdSsiService; ///< RPC interface
-    JobMap _jobMap; ///< Contains information about all jobs.
-    JobMap _incompleteJobs; ///< Map of incomplete jobs.
+    ShardedJobMap _jobMap; ///< Contains information about all jobs.
+    ShardedJobMap _incompleteJobs; ///< Map of incomplete jobs.
     /// How many jobs are used in this query. 1 avoids possible 0 of 0 jobs completed race condition.
     /// The correct value is set when it is available.
     std::atomic<int> _totalJobs{1};
@@ -174,15 +228,18 @@ private:
 
     std::atomic<int> _requestCount; ///< Count of submitted jobs
     util::Flag<bool> _cancelled{false}; ///< Has execution been cancelled.
+    /// Set under the _cancelled mutex when the jobs were squashed because
+    /// the result was complete.
+    std::atomic<bool> _satisfied{false};
 
     // Mutexes
-    std::mutex _incompleteJobsMutex; ///< protect incompleteJobs map.
+    /// Only used to wait on _allJobsComplete, the job maps have their own.
+    std::mutex _allJobsCompleteMtx;
 
     /** Used to record execution errors */
     mutable std::mutex _errorsMutex;
 
-    std::condition_variable _allJobsComplete;
-    mutable std::recursive_mutex _jobMapMtx;
+    std::condition_variable _allJobsComplete; ///< Notified when _incompleteJobs becomes empty.
 
     QueryId _id{0}; ///< Unique identifier for this query.
     std::string _idStr{QueryIdHelper::makeIdStr(0, true)};
@@ -194,6 +251,16 @@ private:
     /// Minimum number of seconds between QMeta chunk updates (set by config)
     std::chrono::seconds _secondsBetweenQMetaUpdates{60};
     std::mutex _lastQMetaMtx; ///< protects _lastQMetaUpdate.
+
+    std::mutex _jobTimesMtx; ///< protects _jobTimes.
+    std::vector<std::chrono::milliseconds> _jobTimes; ///< Run time of the last attempt of completed jobs.
+
+    mutable std::mutex _usageMtx; ///< protects _usage.
+    qmeta::QUsage _usage; ///< Resources used on the workers by all job attempts.
+
+    std::mutex _responseReadsMtx; ///< protects _responseReads and _queuedReads.
+    int _responseReads{0}; ///< Response reads taken, at most _config.maxResponseReads.
+    std::deque<std::function<bool()>> _queuedReads; ///< Jobs waiting for a response read.
 };
 
 class MarkCompleteFunc {
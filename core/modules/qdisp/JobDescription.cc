@@ -79,13 +79,38 @@ bool JobDescription::incrAttemptCountScrubResults() {
 void JobDescription::buildPayload() {
     std::ostringstream os;
     _taskMsgFactory->serializeMsg(*_chunkQuerySpec, _chunkResultName, _queryId, _jobId, _attemptCount, os);
-    _payloads[_attemptCount] = os.str();
+    auto payload = std::make_shared<std::string const>(os.str());
+    std::lock_guard<std::mutex> lock(_payloadMtx);
+    _payload = std::move(payload);
+}
+
+
+std::shared_ptr<std::string const> JobDescription::takePayload() {
+    {
+        std::lock_guard<std::mutex> lock(_payloadMtx);
+        if (_payload != nullptr) {
+            std::shared_ptr<std::string const> payload;
+            payload.swap(_payload);
+            return payload;
+        }
+    }
+    // Already taken for this attempt, build it again.
+    buildPayload();
+    std::lock_guard<std::mutex> lock(_payloadMtx);
+    std::shared_ptr<std::string const> payload;
+    payload.swap(_payload);
+    return payload;
 }
 
 
 bool JobDescription::verifyPayload() const {
+    std::shared_ptr<std::string const> payload;
+    {
+        std::lock_guard<std::mutex> lock(_payloadMtx);
+        payload = _payload;
+    }
     proto::ProtoImporter<proto::TaskMsg> pi;
-    if (!_mock && !pi.messageAcceptable(_payloads.at(_attemptCount))) {
+    if (!_mock && (payload == nullptr || !pi.messageAcceptable(*payload))) {
         LOGS(_log, LOG_LVL_DEBUG, _qIdStr << " Error serializing TaskMsg.");
         return false;
     }
@@ -103,8 +128,13 @@ int JobDescription::getScanRating() const {
 }
 
 
+bool JobDescription::getFoldOnWorker() const {
+    return _taskMsgFactory != nullptr && _taskMsgFactory->getFoldOnWorker();
+}
+
+
 std::ostream& operator<<(std::ostream& os, JobDescription const& jd) {
-    os << "job(id=" << jd._jobId << " payloads.size=" << jd._payloads.size()
+    os << "job(id=" << jd._jobId
        << " ru=" << jd._resource.path() << " attemptCount="  << jd._attemptCount << ")";
     return os;
 }
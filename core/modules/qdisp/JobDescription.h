@@ -28,8 +28,11 @@
 #define LSST_QSERV_QDISP_JOBDESCRIPTION_H_
 
 // System headers
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <sstream>
+#include <string>
 
 // Qserv headers
 #include "global/constants.h"
@@ -54,6 +57,10 @@ namespace qdisp {
 class ResponseHandler;
 
 /** Description of a job managed by the executive
+ *
+ * Only the inputs of the job's TaskMsg are kept for the life of the query.
+ * The payload of an attempt is built when the attempt starts and is handed
+ * to the QueryRequest sending it, and built again if it is asked for later.
  */
 class JobDescription {
 public:
@@ -75,12 +82,17 @@ public:
     void buildPayload(); ///< Must be run after construction to avoid problems with unit tests.
     int id() const { return _jobId; }
     ResourceUnit const& resource() const { return _resource; }
-    std::string const& payload()  { return _payloads[_attemptCount]; }
+    /// @return the payload of the current attempt, which this object no
+    /// longer holds. The caller keeps it for as long as the buffer is in use.
+    std::shared_ptr<std::string const> takePayload();
     std::shared_ptr<ResponseHandler> respHandler() { return _respHandler; }
     int getAttemptCount() const { return _attemptCount; }
 
     bool getScanInteractive() const;
     int getScanRating() const;
+    /// @return true if the worker may fold the results of this job into
+    ///         those of another job, which makes it unsafe to retry.
+    bool getFoldOnWorker() const;
 
     /// @returns true when _attemptCount is incremented correctly and the payload is built.
     /// If the starting value of _attemptCount was greater than or equal to zero, that
@@ -98,15 +110,14 @@ private:
     QueryId _queryId;
     int _jobId; ///< Job's Id number.
     std::string const _qIdStr;
-    int _attemptCount{-1}; ///< Start at -1 so that first attempt will be 0, see incrAttemptCount().
+    std::atomic<int> _attemptCount{-1}; ///< Start at -1 so that first attempt will be 0, see incrAttemptCount().
     ResourceUnit _resource; ///< path, e.g. /q/LSST/23125
 
-    /// _payloads - encoded requests, one per attempt. No guarantee that xrootd is done
-    /// with the payload buffer, so hang onto all of them until the query is finished.
-    /// Also, using a map so the strings wont be moved.
-    /// The xrootd callback function QueryRequest::GetRequest should
-    /// return something other than a char*.
-    std::map<int, std::string> _payloads;
+    /// Encoded request of the current attempt, until it is taken by the
+    /// QueryRequest sending it. The QueryRequest keeps it until xrootd is
+    /// done with the buffer.
+    std::shared_ptr<std::string const> _payload;
+    mutable std::mutex _payloadMtx; ///< Protects _payload
     std::shared_ptr<ResponseHandler> _respHandler; // probably MergingHandler
     std::shared_ptr<qproc::TaskMsgFactory> _taskMsgFactory;
     std::shared_ptr<qproc::ChunkQuerySpec> _chunkQuerySpec;
@@ -70,17 +70,38 @@ bool JobQuery::runJob() {
         LOGS(_log, LOG_LVL_ERROR, _idStr << "runJob failed executive==nullptr");
         return false;
     }
+    // Claim the job for this attempt. A retry may start from within
+    // startQuery() of the previous attempt, which has then left STARTING.
+    State prev = _state.load();
+    do {
+        if (prev == State::CANCELLED) {
+            LOGS(_log, LOG_LVL_DEBUG, _idStr << " runJob job was cancelled");
+            return false;
+        }
+        if (prev == State::STARTING) {
+            // The attempt being started takes the place of this one.
+            LOGS(_log, LOG_LVL_WARN, _idStr << " runJob another attempt is starting");
+            return true;
+        }
+    } while (!_state.compare_exchange_weak(prev, State::STARTING));
+
     bool cancelled = executive->getCancelled();
     bool handlerReset = _jobDescription->respHandler()->reset();
     if (!cancelled && handlerReset) {
         auto criticalErr = [this, &executive](std::string const& msg) {
             LOGS(_log, LOG_LVL_ERROR, _idStr << " " << msg << " "
                  << _jobDescription << " Canceling user query!");
+            _leaveStarting(State::IDLE);
             executive->squash(); // This should kill all jobs in this user query.
         };
 
         LOGS(_log, LOG_LVL_DEBUG, _idStr << " runJob checking attempt=" << _jobDescription->getAttemptCount());
-        std::lock_guard<std::recursive_mutex> lock(_rmutex);
+        if (_jobDescription->getAttemptCount() >= 0 && _jobDescription->getFoldOnWorker()) {
+            // The rows of the failed attempt may have been folded into the
+            // result of another job, which a retry would count twice.
+            criticalErr("can not retry a job the worker folds");
+            return false;
+        }
         if (_jobDescription->getAttemptCount() < _getMaxAttempts()) {
             bool okCount = _jobDescription->incrAttemptCountScrubResults();
             if (!okCount) {
@@ -99,57 +120,124 @@ bool JobQuery::runJob() {
 
         // At this point we are all set to actually run the query. We create a
         // a shared pointer to this object to prevent it from escaping while we
-        // are trying to start this whole process. We also make sure we record
-        // whether or not we are in SSI as cancellation handling differs.
-        //
+        // are trying to start this whole process. The job is IN_SSI before
+        // the request exists, so that the request may retry from its callbacks.
         LOGS(_log, LOG_LVL_DEBUG, _idStr << " runJob calls StartQuery()");
         std::shared_ptr<JobQuery> jq(shared_from_this());
-        _inSsi = true;
+        _attemptStart = std::chrono::steady_clock::now().time_since_epoch().count();
+        if (!_leaveStarting(State::IN_SSI)) {
+            return false; // cancel() took care of the job.
+        }
         if (executive->startQuery(jq)) {
-           _jobStatus->updateInfo(_idStr, JobStatus::REQUEST);
-           return true;
+            _jobStatus->updateInfo(_idStr, JobStatus::REQUEST);
+            // cancel() may have missed the new request.
+            if (_state == State::CANCELLED) {
+                auto qr = getQueryRequest();
+                if (qr != nullptr) qr->cancel();
+            }
+            return true;
         }
-        _inSsi = false;
+        State inSsi = State::IN_SSI;
+        _state.compare_exchange_strong(inSsi, State::IDLE);
+    } else {
+        _leaveStarting(State::IDLE);
     }
     LOGS(_log, LOG_LVL_WARN, _idStr << " runJob failed. cancelled=" << cancelled
               << " reset=" << handlerReset);
     return false;
 }
 
+
+void JobQuery::addFailedWorker(std::string const& worker) {
+    if (worker.empty()) return;
+    std::lock_guard<std::mutex> lock(_failedWorkersMtx);
+    _failedWorkers.insert(worker);
+}
+
+
+std::set<std::string> JobQuery::getFailedWorkers() const {
+    std::lock_guard<std::mutex> lock(_failedWorkersMtx);
+    return _failedWorkers;
+}
+
+
+/// Move _state from STARTING to 'next'.
+/// @return false if the job was cancelled meanwhile.
+bool JobQuery::_leaveStarting(State next) {
+    State starting = State::STARTING;
+    if (_state.compare_exchange_strong(starting, next)) {
+        return true;
+    }
+    LOGS(_log, LOG_LVL_DEBUG, _idStr << " cancelled while starting");
+    return false;
+}
+
+
 /// Cancel response handling. Return true if this is the first time cancel has been called.
 bool JobQuery::cancel() {
     LOGS(_log, LOG_LVL_DEBUG, _idStr << " JobQuery::cancel()");
-    if (_cancelled.exchange(true) == false) {
-        std::lock_guard<std::recursive_mutex> lock(_rmutex);
-        // If _inSsi is true then this query request has been passed to SSI and
-        // _queryRequestPtr cannot be a nullptr. Cancellation is complicated.
-        bool cancelled = false;
-        if (_inSsi) {
-            LOGS(_log, LOG_LVL_DEBUG, _idStr << " cancel QueryRequest in progress");
-            if (_queryRequestPtr->cancel()) {
-                LOGS(_log, LOG_LVL_DEBUG, _idStr << " cancelled by QueryRequest");
-                cancelled = true;
-            } else {
-                LOGS(_log, LOG_LVL_DEBUG, _idStr << " QueryRequest could not cancel");
-            }
+    State const prev = _state.exchange(State::CANCELLED);
+    if (prev == State::CANCELLED) {
+        LOGS(_log, LOG_LVL_DEBUG, _idStr << " cancel, skipping, already cancelled.");
+        return false;
+    }
+    // If the job was IN_SSI then its query request has been passed to SSI.
+    // A request created after this point is cancelled by runJob().
+    bool cancelled = false;
+    auto qr = getQueryRequest();
+    if (prev == State::IN_SSI && qr != nullptr) {
+        LOGS(_log, LOG_LVL_DEBUG, _idStr << " cancel QueryRequest in progress");
+        if (qr->cancel()) {
+            LOGS(_log, LOG_LVL_DEBUG, _idStr << " cancelled by QueryRequest");
+            cancelled = true;
+        } else {
+            LOGS(_log, LOG_LVL_DEBUG, _idStr << " QueryRequest could not cancel");
         }
-        if (!cancelled) {
-            std::ostringstream os;
-            os << _idStr <<" cancel QueryRequest=" << _queryRequestPtr ;
-            LOGS(_log, LOG_LVL_DEBUG, os.str());
-            getDescription()->respHandler()->errorFlush(os.str(), -1);
-            auto executive = _executive.lock();
-            if (executive == nullptr) {
-                LOGS(_log, LOG_LVL_ERROR, " can't markComplete cancelled, executive == nullptr");
-                return false;
-            }
-            executive->markCompleted(getIdInt(), false);
+    }
+    if (!cancelled) {
+        std::ostringstream os;
+        os << _idStr <<" cancel QueryRequest=" << qr;
+        LOGS(_log, LOG_LVL_DEBUG, os.str());
+        getDescription()->respHandler()->errorFlush(os.str(), -1);
+        auto executive = _executive.lock();
+        if (executive == nullptr) {
+            LOGS(_log, LOG_LVL_ERROR, " can't markComplete cancelled, executive == nullptr");
+            return false;
         }
-        _jobDescription->respHandler()->processCancel();
-        return true;
+        executive->markCompleted(getIdInt(), false);
     }
-    LOGS(_log, LOG_LVL_DEBUG, _idStr << " cancel, skipping, already cancelled.");
-    return false;
+    _jobDescription->respHandler()->processCancel();
+    return true;
+}
+
+
+std::chrono::milliseconds JobQuery::getAttemptElapsed() const {
+    auto const start = _attemptStart.load();
+    if (start == 0) {
+        return std::chrono::milliseconds(0);
+    }
+    auto const now = std::chrono::steady_clock::now().time_since_epoch().count();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::duration(now - start));
+}
+
+
+bool JobQuery::retryStraggler() {
+    // Keep an attempt for errors, as the retry may land on the same worker.
+    if (_state != State::IN_SSI || _getRunAttemptsCount() + 1 >= _getMaxAttempts()
+        || _jobDescription->getFoldOnWorker()) {
+        return false;
+    }
+    // Once results arrive the worker is doing its part, restarting would waste it.
+    if (_jobStatus->getInfo().state != JobStatus::REQUEST) {
+        return false;
+    }
+    auto qr = getQueryRequest();
+    if (qr == nullptr || _stragglerRetried.exchange(true)) {
+        return false;
+    }
+    LOGS(_log, LOG_LVL_INFO, _idStr << " retrying straggler after " << getAttemptElapsed().count() << "ms");
+    return qr->retry();
 }
 
 
@@ -28,8 +28,11 @@
 
 // System headers
 #include <atomic>
+#include <chrono>
 #include <memory>
 #include <mutex>
+#include <set>
+#include <string>
 
 // Qserv headers
 #include "qdisp/Executive.h"
@@ -69,12 +72,10 @@ public:
     JobStatus::Ptr getStatus() { return _jobStatus; }
 
     void setQueryRequest(std::shared_ptr<QueryRequest> const& qr) {
-        std::lock_guard<std::recursive_mutex> lock(_rmutex);
-        _queryRequestPtr = qr;
+        std::atomic_store(&_queryRequestPtr, qr);
     }
     std::shared_ptr<QueryRequest> getQueryRequest() {
-        std::lock_guard<std::recursive_mutex> lock(_rmutex);
-        return _queryRequestPtr;
+        return std::atomic_load(&_queryRequestPtr);
     }
 
     std::shared_ptr<MarkCompleteFunc> getMarkCompleteFunc() { return _markCompleteFunc; }
@@ -82,6 +83,21 @@ public:
     bool cancel();
     bool isQueryCancelled();
 
+    /// @return how long the current attempt has been running, 0 before it starts.
+    std::chrono::milliseconds getAttemptElapsed() const;
+
+    /// Give up on the current attempt, if the worker has not responded yet,
+    /// and run the job again. This is done at most once per job, leaving
+    /// attempts for errors. Jobs the worker folds are never retried.
+    /// @return true if a new attempt was started.
+    bool retryStraggler();
+    bool getStragglerRetried() const { return _stragglerRetried; }
+
+    /// Record that an attempt failed on 'worker', the next attempts go to
+    /// other replicas of the chunk, see ReplicaSelector.
+    void addFailedWorker(std::string const& worker);
+    std::set<std::string> getFailedWorkers() const;
+
     Executive::Ptr getExecutive() { return _executive.lock(); }
 
     std::shared_ptr<QdispPool> getQdispPool() { return _qdispPool; }
@@ -99,8 +115,21 @@ protected:
         _jobDescription->respHandler()->setJobQuery(shared_from_this());
     }
 
+    /// Lifecycle of the job. Each transition is a compare-and-swap on
+    /// _state, so that only the thread making it acts on it:
+    ///   IDLE -> STARTING      runJob() prepares the first attempt.
+    ///   IN_SSI -> STARTING    runJob() prepares a retry.
+    ///   STARTING -> IN_SSI    the attempt is handed to the executive.
+    ///   STARTING -> IDLE      the attempt could not be prepared.
+    ///   IN_SSI -> IDLE        the executive did not start the attempt.
+    ///   any -> CANCELLED      cancel(), final.
+    /// STARTING is held by one thread only, which owns the attempt count and
+    /// payload of _jobDescription until it leaves that state.
+    enum class State { IDLE, STARTING, IN_SSI, CANCELLED };
+
+    bool _leaveStarting(State next);
+
     int _getRunAttemptsCount() const {
-        std::lock_guard<std::recursive_mutex> lock(_rmutex);
         return _jobDescription->getAttemptCount();
     }
     int _getMaxAttempts() const { return 5; } // Arbitrary value until solid value with reason determined.
@@ -118,16 +147,17 @@ protected:
     QueryId const _qid; // User query id
     std::string const _idStr; ///< Identifier string for logging.
 
-    // Values that need mutex protection
-    mutable std::recursive_mutex _rmutex; ///< protects _jobDescription,
-                                          ///< _queryRequestPtr, and _inSsi
+    std::atomic<State> _state{State::IDLE};
 
-    // SSI items
+    // SSI items, only accessed with std::atomic_load() and std::atomic_store().
     std::shared_ptr<QueryRequest> _queryRequestPtr;
-    bool _inSsi{false};
+    /// When the current attempt was sent, in steady_clock ticks, 0 before the first one.
+    std::atomic<std::chrono::steady_clock::rep> _attemptStart{0};
+    std::atomic<bool> _stragglerRetried{false}; ///< Set by retryStraggler().
+
+    mutable std::mutex _failedWorkersMtx; ///< Protects _failedWorkers.
+    std::set<std::string> _failedWorkers; ///< Workers attempts failed on.
 
-    // Cancellation
-    std::atomic<bool> _cancelled {false}; ///< Lock to make sure cancel() is only called once.
     util::InstanceCount _instC{"JobQuery"};
 
     std::shared_ptr<QdispPool> _qdispPool;
@@ -73,6 +73,14 @@ QueryMessage MessageStore::getMessage(int idx) const {
     return _queryMessages.at(idx);
 }
 
+std::vector<QueryMessage> MessageStore::getMessages(size_t begin) const {
+    std::lock_guard<std::mutex> lock(_storeMutex);
+    if (begin >= _queryMessages.size()) {
+        return std::vector<QueryMessage>();
+    }
+    return std::vector<QueryMessage>(_queryMessages.begin() + begin, _queryMessages.end());
+}
+
 int MessageStore::messageCount() const {
     return _queryMessages.size();
 }
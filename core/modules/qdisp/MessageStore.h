@@ -103,11 +103,16 @@ public:
      */
     void addErrorMessage(std::string const& description);
     QueryMessage getMessage(int idx) const;
+
+    /// @return a copy of the messages from index 'begin' on, which may be
+    ///         taken while messages are being added.
+    std::vector<QueryMessage> getMessages(size_t begin) const;
+
     int messageCount() const ;
     int messageCount(int code) const;
 
 private:
-    std::mutex _storeMutex;
+    mutable std::mutex _storeMutex;
     std::vector<QueryMessage> _queryMessages;
 };
 
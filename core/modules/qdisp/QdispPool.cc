@@ -24,6 +24,10 @@
 // Class header
 #include "qdisp/QdispPool.h"
 
+// System headers
+#include <algorithm>
+
+// LSST headers
 #include "lsst/log/Log.h"
 
 // Qserv headers
@@ -43,12 +47,46 @@ std::ostream& operator<<(std::ostream& os, PriorityQueue const& pq) {
         PriorityQueue::PriQ::Ptr const& que = elem.second;
         os << "(pr=" << que->getPriority()
            << ":sz="  << que->size()
-           << ":r="   << que->running << ")";
+           << ":r="   << que->running
+           << ":lim=" << que->getLimit()
+           << ":rt="  << que->getRunTimeMs() << "ms)";
     }
     return os;
 }
 
 
+/// Must be called with the PriorityQueue mutex held.
+bool PriorityQueue::PriQ::recordRunTime(double runTimeMs) {
+    double const alpha = 0.1;          // weight of the newest run time
+    double const overloadFactor = 2.0; // run time over the baseline that means overloaded
+    double const baselineDrift = 1.02; // baseline increase per window, to follow slower normal loads
+    _runTimeMs = (_runTimeMs == 0.0) ? runTimeMs : alpha * runTimeMs + (1.0 - alpha) * _runTimeMs;
+    if (++_finished < adjustWindow) {
+        return false;
+    }
+    _finished = 0;
+    if (_baselineMs == 0.0 || _runTimeMs < _baselineMs) {
+        _baselineMs = _runTimeMs;
+    } else {
+        _baselineMs *= baselineDrift;
+    }
+    int oldLimit = _limit;
+    if (_runTimeMs > overloadFactor * _baselineMs) {
+        _limit = std::max(_minRunning, (_limit * 3) / 4);
+    } else if (size() > 0 && running + 1 >= _limit) {
+        // Commands are waiting and this priority used all its threads,
+        // counting the one that just finished.
+        _limit = std::min(_maxRunning, _limit + 1);
+    }
+    if (_limit == oldLimit) {
+        return false;
+    }
+    LOGS(_log, LOG_LVL_INFO, "priQ pr=" << _priority << " limit " << oldLimit << "->" << _limit
+         << " runTime=" << _runTimeMs << "ms baseline=" << _baselineMs << "ms");
+    return true;
+}
+
+
 ///< @Return true if the queue could be added.
 bool PriorityQueue::addPriQueue(int priority, int minRunning, int maxRunning) {
     std::lock_guard<std::mutex> lock(_mtx);
@@ -66,6 +104,7 @@ bool PriorityQueue::addPriQueue(int priority, int minRunning, int maxRunning) {
 
 /// The pool needs to be able to place commands in this queue for shutdown.
 void PriorityQueue::queCmd(util::Command::Ptr const& cmd) {
+    bool wake = false;
     {
         std::lock_guard<std::mutex> lock(_mtx);
         auto iter = _queues.find(_defaultPriority);
@@ -73,13 +112,14 @@ void PriorityQueue::queCmd(util::Command::Ptr const& cmd) {
             throw Bug("PriorityQueue default priority queue not found a!");
         }
         iter->second->queCmd(cmd);
-        _changed = true;
+        wake = _wakeOne();
     }
-    _cv.notify_all();
+    if (wake) _cv.notify_one();
 }
 
 
 void PriorityQueue::queCmd(PriorityCommand::Ptr const& cmd, int priority) {
+    bool wake = false;
     {
         std::lock_guard<std::mutex> lock(_mtx);
         auto iter = _queues.find(priority);
@@ -95,9 +135,21 @@ void PriorityQueue::queCmd(PriorityCommand::Ptr const& cmd, int priority) {
         cmd->_priority = priority;
         iter->second->queCmd(cmd);
         LOGS (_log, LOG_LVL_DEBUG, "priQue p=" << priority << *this);
-        _changed = true;
+        wake = _wakeOne();
+    }
+    if (wake) _cv.notify_one();
+}
+
+
+/// One command can be run by one thread, so only one waiting thread is
+/// woken for it. Waking all of them, as many as the pool has threads, only
+/// had them contend for _mtx before going back to sleep.
+bool PriorityQueue::_wakeOne() {
+    if (_wakeups < _waiting) {
+        ++_wakeups;
+        return true;
     }
-    _cv.notify_all();
+    return false;
 }
 
 
@@ -105,7 +157,6 @@ util::Command::Ptr PriorityQueue::getCmd(bool wait){
     util::Command::Ptr ptr;
     std::unique_lock<std::mutex> uLock(_mtx);
     while (true) {
-        _changed = false;
         LOGS (_log, LOG_LVL_DEBUG, "priQueGet " << *this);
 
         /// Make sure minimum number of jobs running per priority.
@@ -127,7 +178,7 @@ util::Command::Ptr PriorityQueue::getCmd(bool wait){
         for (auto const& elem : _queues) {
             PriQ::Ptr const& que = elem.second;
             // If this queue has no running threads, or
-            if (que->running < que->getMaxRunning()) {
+            if (que->running < que->getLimit()) {
                 ptr = que->getCmd(false); // no wait
                 if (ptr != nullptr) {
                     return ptr;
@@ -138,7 +189,10 @@ util::Command::Ptr PriorityQueue::getCmd(bool wait){
         // If nothing was found, wait or return nullptr.
         if (wait) {
             LOGS (_log, LOG_LVL_DEBUG, "getCmd wait " << *this);
-            _cv.wait(uLock, [this](){ return _changed; });
+            ++_waiting;
+            _cv.wait(uLock, [this](){ return _wakeups > 0; });
+            --_waiting;
+            --_wakeups;
         } else {
             return ptr;
         }
@@ -153,13 +207,28 @@ void PriorityQueue::prepareShutdown() {
 
 
 void PriorityQueue::_incrDecrRunningCount(util::Command::Ptr const& cmd, int incrDecr) {
-    std::lock_guard<std::mutex> lock(_mtx);
+    std::unique_lock<std::mutex> lock(_mtx);
     PriorityCommand::Ptr priCmd = std::dynamic_pointer_cast<PriorityCommand>(cmd);
     if (priCmd != nullptr) {
         int priority = priCmd->_priority;
         auto iter = _queues.find(priority);
         if (iter != _queues.end()) {
             iter->second->running += incrDecr;
+            bool raised = false;
+            if (incrDecr > 0) {
+                priCmd->_startTime = std::chrono::steady_clock::now();
+            } else {
+                int oldLimit = iter->second->getLimit();
+                std::chrono::duration<double, std::milli> runTime =
+                        std::chrono::steady_clock::now() - priCmd->_startTime;
+                raised = iter->second->recordRunTime(runTime.count())
+                         && iter->second->getLimit() > oldLimit;
+            }
+            if (raised && _wakeOne()) {
+                // A waiting thread may now run a command of this priority.
+                lock.unlock();
+                _cv.notify_one();
+            }
             return;
         }
     } else if (cmd != nullptr) {
@@ -24,6 +24,7 @@
 #define LSST_QSERV_QDISP_QDISPPOOL_H
 
 // System headers
+#include <chrono>
 #include <map>
 
 // Third-party headers
@@ -47,6 +48,7 @@ public:
     friend PriorityQueue;
 private:
     int _priority{0}; // Need to know what queue this was placed on.
+    std::chrono::steady_clock::time_point _startTime; ///< When a thread started running this.
 };
 
 
@@ -60,21 +62,42 @@ public:
     using Ptr = std::shared_ptr<PriorityQueue>;
 
     /// A queue for handling all messages of a given priority.
+    /// The number of its commands allowed to run at once, the limit, is
+    /// adjusted between minRunning and maxRunning by AIMD: it is cut by a
+    /// quarter when commands take much longer to run than the fastest run
+    /// time seen lately, a sign that workers or the network are overloaded,
+    /// and raised by one while commands are waiting and run times are normal.
     class PriQ : public util::CommandQueue {
     public:
         using Ptr = std::shared_ptr<PriQ>;
         explicit PriQ(int priority, int minRunning, int maxRunning) :
-            _priority(priority), _minRunning(minRunning), _maxRunning(maxRunning) {}
+            _priority(priority), _minRunning(minRunning), _maxRunning(maxRunning),
+            _limit(maxRunning) {}
         ~PriQ() override = default;
         int getPriority() const { return _priority; }
         int getMinRunning() const { return _minRunning; }
         int getMaxRunning() const { return _maxRunning; }
+        /// @return the number of commands of this priority allowed to run now.
+        int getLimit() const { return _limit; }
+        /// @return the smoothed run time of the commands, in milliseconds.
+        double getRunTimeMs() const { return _runTimeMs; }
+
+        /// Record the run time of a finished command, and adjust the limit
+        /// once every adjustWindow commands.
+        /// @return true if the limit changed.
+        bool recordRunTime(double runTimeMs);
 
         std::atomic<int> running{0}; ///< number of jobs of this priority currently running.
+
+        static int const adjustWindow = 20; ///< Commands finished between adjustments.
     private:
         int const _priority;   ///< priority value of this queue
         int const _minRunning; ///< minimum number of threads (unless nothing on this queue to run)
         int const _maxRunning; ///< maximum number of threads for this PriQ to use.
+        int _limit; ///< current maximum number of threads, between _minRunning and _maxRunning.
+        double _runTimeMs{0.0}; ///< moving average of command run times.
+        double _baselineMs{0.0}; ///< lowest _runTimeMs seen lately, 0 until known.
+        int _finished{0}; ///< commands finished since the last adjustment.
     };
 
 
@@ -101,15 +124,22 @@ public:
     void commandStart(util::Command::Ptr const& cmd) override;
     void commandFinish(util::Command::Ptr const& cmd) override;
 
+    /// @return the queue sizes, running counts, limits and run times.
     std::string statsStr();
 
 private:
     void _incrDecrRunningCount(util::Command::Ptr const& cmd, int incrDecr);
 
+    /// Reserve a wakeup for one waiting thread not already woken.
+    /// Precondition: _mtx must be held.
+    /// @return true if _cv must be notified once _mtx is released.
+    bool _wakeOne();
+
     std::mutex _mtx;
     std::condition_variable _cv;
     bool _shuttingDown{false};
-    bool _changed{false};
+    int _waiting{0}; ///< Threads waiting in getCmd().
+    int _wakeups{0}; ///< Waiting threads notified that are not awake yet.
 
     std::map<int, PriQ::Ptr> _queues;
     int _defaultPriority{1};
@@ -153,6 +183,8 @@ public:
         _pool->shutdownPool();
     }
 
+    std::string statsStr() { return _prQueue->statsStr(); }
+
 private:
     void _setup(bool unitTest);
 
@@ -46,7 +46,7 @@
 #include "qdisp/JobStatus.h"
 #include "qdisp/ResponseHandler.h"
 #include "util/common.h"
-#include "util/Timer.h"
+#include "util/Profiler.h"
 
 namespace {
 LOG_LOGGER _log = LOG_GET("lsst.qserv.qdisp.QueryRequest");
@@ -57,157 +57,53 @@ namespace qserv {
 namespace qdisp {
 
 
-// Run action() when the system expects to have time to accept data.
-class QueryRequest::AskForResponseDataCmd : public PriorityCommand {
-public:
-    typedef std::shared_ptr<AskForResponseDataCmd> Ptr;
-    enum class State { STARTED0, DATAREADY1, DONE2 };
-    AskForResponseDataCmd(QueryRequest::Ptr const& qr, JobQuery::Ptr const& jq)
-        : _qRequest(qr), _jQuery(jq), _idStr(jq->getIdStr()) {}
-
-    void action(util::CmdData *data) override {
-        // If everything is ok, call GetResponseData to have XrdSsi ask the worker for the data.
-        util::Timer tWaiting;
-        util::Timer tTotal;
-        {
-            tTotal.start();
-            auto jq = _jQuery.lock();
-            auto qr = _qRequest.lock();
-            if (jq == nullptr || qr == nullptr) {
-                LOGS(_log, LOG_LVL_WARN, _idStr << " AskForResp null before GetResponseData");
-                // No way to call _errorFinish().
-                _setState(State::DONE2);
-                return;
-            }
-
-            if (qr->isQueryCancelled()) {
-                LOGS(_log, LOG_LVL_DEBUG, _idStr << " AskForResp query was cancelled");
-                qr->_errorFinish(true);
-                _setState(State::DONE2);
-                return;
-            }
-            std::vector<char>& buffer = jq->getDescription()->respHandler()->nextBuffer();
-            LOGS(_log, LOG_LVL_DEBUG, _idStr << " AskForResp GetResponseData size=" << buffer.size());
-            tWaiting.start();
-            qr->GetResponseData(&buffer[0], buffer.size());
-        }
-
-        // Wait for XrdSsi to call ProcessResponseData with the data,
-        // which will notify this wait with a call to receivedProcessResponseDataParameters.
-        {
-            std::unique_lock<std::mutex> uLock(_mtx);
-            // TODO: make timed wait, check for wedged, if weak pointers dead, log and give up.
-            _cv.wait(uLock, [this](){ return _state != State::STARTED0; });
-            tWaiting.stop();
-            // _mtx is locked at this point.
-            LOGS(_log, LOG_LVL_DEBUG, _idStr << " AskForResp should be DATAREADY1 " << (int)_state);
-            if (_state == State::DONE2) {
-                // There was a problem. End the stream associated
-                auto qr = _qRequest.lock();
-                if (qr != nullptr) {
-                    qr->_errorFinish();
-                }
-                LOGS(_log, LOG_LVL_INFO, _idStr << " AskForResp returning early");
-                return;
-            }
-        }
-
-        // Actually process the data.
-        // If more data needs to be sent, _processData will make a new AskForResponseDataCmd
-        // object and queue it.
-        {
-            auto jq = _jQuery.lock();
-            auto qr = _qRequest.lock();
-            if (jq == nullptr || qr == nullptr) {
-                _setState(State::DONE2);
-                LOGS(_log, LOG_LVL_WARN, _idStr << " AskForResp null before processData");
-                return;
-            }
-            qr->_processData(jq, _blen, _last);
-            // _processData will have created another AskForResponseDataCmd object if needed.
-            tTotal.stop();
-        }
-        _setState(State::DONE2);
-        LOGS(_log, LOG_LVL_DEBUG, _idStr << " Ask data is done wait=" << tWaiting.getElapsed() <<
-                " total=" << tTotal.getElapsed());
-    }
-
-    void notifyDataSuccess(int blen, bool last) {
-        {
-            std::lock_guard<std::mutex> lg(_mtx);
-            _blen = blen;
-            _last = last;
-            _state = State::DATAREADY1;
-        }
-        _cv.notify_all();
-    }
-
-    void notifyFailed() {
-        LOGS(_log, LOG_LVL_INFO, _idStr << "notifyFailed");
-        _setState(State::DONE2);
-        _cv.notify_all();
-    }
-
-    State getState() const {
-        std::lock_guard<std::mutex> lg(_mtx);
-        return _state;
-    }
-
-private:
-    void _setState(State const state) {
-        std::lock_guard<std::mutex> lg(_mtx);
-        _state = State::DONE2;
-    }
-
-
-    std::weak_ptr<QueryRequest> _qRequest;
-    std::weak_ptr<JobQuery> _jQuery;
-    std::string _idStr;
-    mutable std::mutex _mtx;
-    std::condition_variable _cv;
-    State _state = State::STARTED0;
-
-    int _blen{-1};
-    bool _last{true};
-};
-
-
 ////////////////////////////////////////////////////////////////////////
 // QueryRequest
 ////////////////////////////////////////////////////////////////////////
 QueryRequest::QueryRequest(JobQuery::Ptr const& jobQuery) :
   _jobQuery(jobQuery),
   _jobIdStr(jobQuery->getIdStr()),
-  _qdispPool(_jobQuery->getQdispPool()){
+  _qdispPool(_jobQuery->getQdispPool()),
+  _executive(_jobQuery->getExecutive()) {
     LOGS(_log, LOG_LVL_DEBUG, _jobIdStr <<" New QueryRequest");
 }
 
 QueryRequest::~QueryRequest() {
     LOGS(_log, LOG_LVL_DEBUG, _jobIdStr << " ~QueryRequest");
-    if (_askForResponseDataCmd != nullptr) {
-        // This shouldn't really happen, but we really don't want to leave this blocking the pool.
-        LOGS(_log, LOG_LVL_WARN, _jobIdStr << " ~QueryRequest cleaning up _askForResponseDataCmd");
-        _askForResponseDataCmd->notifyFailed();
+    if (_holdsResponseRead) {
+        // This shouldn't really happen, but the other jobs of the query must not wait for it.
+        LOGS(_log, LOG_LVL_WARN, _jobIdStr << " ~QueryRequest giving back its response read");
+        _endResponseRead();
     }
     if (!_finishedCalled) {
         LOGS(_log, LOG_LVL_WARN, _jobIdStr << " ~QueryRequest cleaning up calling Finished");
         Finished(true);
     }
+    _releaseReplica(nullptr, false, false);
 }
 
 // content of request data
 char* QueryRequest::GetRequest(int& requestLength) {
-    std::lock_guard<std::mutex> lock(_finishStatusMutex);
-    auto jq = _jobQuery;
+    auto jq = _getJobQuery();
     if (_finishStatus != ACTIVE || jq == nullptr) {
         LOGS(_log, LOG_LVL_DEBUG, _jobIdStr << " QueryRequest::GetRequest called after job finished (cancelled?)");
         requestLength = 0;
         return const_cast<char*>("");
     }
-    requestLength = jq->getDescription()->payload().size();
+    auto payload = std::atomic_load(&_payload);
+    if (payload == nullptr) {
+        payload = jq->getDescription()->takePayload();
+        std::atomic_store(&_payload, payload);
+    }
+    requestLength = payload->size();
     LOGS(_log, LOG_LVL_DEBUG, _jobIdStr << " Requesting, payload size: " << requestLength);
     // Andy promises that his code won't corrupt it.
-    return const_cast<char*>(jq->getDescription()->payload().data());
+    return const_cast<char*>(payload->data());
+}
+
+
+void QueryRequest::RelRequestBuffer() {
+    std::atomic_store(&_payload, std::shared_ptr<std::string const>());
 }
 
 // precondition: rInfo.rType != isNone
@@ -215,6 +111,7 @@ char* QueryRequest::GetRequest(int& requestLength) {
 // Callback function for XrdSsiRequest.
 //
 bool QueryRequest::ProcessResponse(XrdSsiErrInfo  const& eInfo, XrdSsiRespInfo const& rInfo) {
+    util::ThreadRole role("ssi-callback");
     LOGS(_log, LOG_LVL_DEBUG, _jobIdStr << "workerName=" << GetEndPoint() << " ProcessResponse");
     std::string errorDesc = _jobIdStr + " ";
     if (isQueryCancelled()) {
@@ -224,14 +121,11 @@ bool QueryRequest::ProcessResponse(XrdSsiErrInfo  const& eInfo, XrdSsiRespInfo c
     }
 
     // Make a copy of the _jobQuery shared_ptr in case _jobQuery gets reset by a call to  cancel()
-    auto jq = _jobQuery;
-    {
-        std::lock_guard<std::mutex> lock(_finishStatusMutex);
-        if (_finishStatus != ACTIVE) {
-            LOGS(_log, LOG_LVL_WARN,
-                 _jobIdStr << " QueryRequest::GetRequest called after job finished (cancelled?)");
-            return true;
-        }
+    auto jq = _getJobQuery();
+    if (_finishStatus != ACTIVE || jq == nullptr) {
+        LOGS(_log, LOG_LVL_WARN,
+             _jobIdStr << " QueryRequest::GetRequest called after job finished (cancelled?)");
+        return true;
     }
     if (eInfo.hasError()) {
         std::ostringstream os;
@@ -274,19 +168,82 @@ bool QueryRequest::ProcessResponse(XrdSsiErrInfo  const& eInfo, XrdSsiRespInfo c
 /// Retrieve and process results in using the XrdSsi stream mechanism
 /// Uses a copy of JobQuery::Ptr instead of _jobQuery as a call to cancel() would reset _jobQuery.
 bool QueryRequest::_importStream(JobQuery::Ptr const& jq) {
-    if (_askForResponseDataCmd != nullptr) {
-        LOGS(_log, LOG_LVL_ERROR, "_importStream There's already an _askForResponseDataCmd object!!");
-        // Keep the previous object from wedging the pool.
-        _askForResponseDataCmd->notifyFailed();
+    _askForResponse(jq);
+    return true;
+}
+
+
+/// Ask XrdSsi for the next buffer once the query has a response read left,
+/// see Executive::startResponseRead(). This never waits, a job past the
+/// query's limit is asked for by the job that gives back its read.
+void QueryRequest::_askForResponse(JobQuery::Ptr const& jq) {
+    std::weak_ptr<QueryRequest> weakThis = shared_from_this();
+    std::weak_ptr<JobQuery> weakJq = jq;
+    auto read = [weakThis, weakJq]() {
+        auto qr = weakThis.lock();
+        auto jq = weakJq.lock();
+        return qr != nullptr && jq != nullptr && qr->_getResponseData(jq);
+    };
+    auto exec = _executive.lock();
+    if (exec == nullptr) {
+        read();
+    } else if (exec->startResponseRead(read)) {
+        if (!read()) {
+            exec->endResponseRead();
+        }
+    } else {
+        LOGS(_log, LOG_LVL_DEBUG, _jobIdStr << " response read queued");
     }
-    _askForResponseDataCmd = std::make_shared<AskForResponseDataCmd>(shared_from_this(), jq);
-    _queueAskForResponse(_askForResponseDataCmd, jq);
+}
+
+
+/// Call GetResponseData, holding one of the query's response reads.
+/// @return false if the read was not used.
+bool QueryRequest::_getResponseData(JobQuery::Ptr const& jq) {
+    if (isQueryCancelled()) {
+        LOGS(_log, LOG_LVL_DEBUG, _jobIdStr << " _getResponseData query was cancelled");
+        _errorFinish(true);
+        return false;
+    }
+    if (_finishStatus != ACTIVE) {
+        return false;
+    }
+    std::vector<char>& buffer = jq->getDescription()->respHandler()->nextBuffer();
+    LOGS(_log, LOG_LVL_DEBUG, _jobIdStr << " GetResponseData size=" << buffer.size());
+    _holdsResponseRead = true;
+    _readPending = true;
+    GetResponseData(&buffer[0], buffer.size());
     return true;
 }
 
 
-void QueryRequest::_queueAskForResponse(AskForResponseDataCmd::Ptr const& cmd, JobQuery::Ptr const& jq) {
+/// Give back the response read of this request, if it holds one.
+void QueryRequest::_endResponseRead() {
+    if (_holdsResponseRead.exchange(false)) {
+        auto exec = _executive.lock();
+        if (exec != nullptr) {
+            exec->endResponseRead();
+        }
+    }
+}
+
+
+/// Queue the merge of the buffer XrdSsi filled, merging may wait on the
+/// result database and XrdSsi callback threads must not be held up by it.
+void QueryRequest::_queueMerge(JobQuery::Ptr const& jq, int blen, bool last) {
     // ScanInfo::Rating { FASTEST = 0, FAST = 10, MEDIUM = 20, SLOW = 30, SLOWEST = 100 };
+    std::weak_ptr<QueryRequest> weakThis = shared_from_this();
+    std::weak_ptr<JobQuery> weakJq = jq;
+    std::string const idStr = _jobIdStr;
+    auto cmd = std::make_shared<PriorityCommand>([weakThis, weakJq, idStr, blen, last](util::CmdData*) {
+        auto qr = weakThis.lock();
+        auto jq = weakJq.lock();
+        if (qr == nullptr || jq == nullptr) {
+            LOGS(_log, LOG_LVL_WARN, idStr << " null before processData");
+            return;
+        }
+        qr->_processData(jq, blen, last);
+    });
 
     int rating = jq->getDescription()->getScanRating();
     if (jq->getDescription()->getScanInteractive()) {
@@ -317,49 +274,34 @@ void QueryRequest::_queueAskForResponse(AskForResponseDataCmd::Ptr const& cmd, J
 
 /// Process an incoming error.
 bool QueryRequest::_importError(std::string const& msg, int code) {
-    auto jq = _jobQuery;
-    {
-        std::lock_guard<std::mutex> lock(_finishStatusMutex);
-        if (_finishStatus != ACTIVE || jq == nullptr) {
-            LOGS_WARN(_jobIdStr << " QueryRequest::_importError code=" << code
-                      << " msg=" << msg << " not passed");
-            return false;
-        }
-        jq->getDescription()->respHandler()->errorFlush(msg, code);
+    auto jq = _getJobQuery();
+    if (_finishStatus != ACTIVE || jq == nullptr) {
+        LOGS_WARN(_jobIdStr << " QueryRequest::_importError code=" << code
+                  << " msg=" << msg << " not passed");
+        return false;
     }
+    jq->getDescription()->respHandler()->errorFlush(msg, code);
     _errorFinish();
     return true;
 }
 
 
-void QueryRequest::_setHoldState(HoldState state) {
-    if (state != _holdState) {
-        LOGS(_log, LOG_LVL_DEBUG, _jobIdStr << " holdState changed from " << _holdState << " to " << state);
-    }
-    _holdState = state;
-}
-
-
 XrdSsiRequest::PRD_Xeq QueryRequest::ProcessResponseData(XrdSsiErrInfo const& eInfo,
                                                          char *buff, int blen, bool last) { // Step 7
+    util::ThreadRole role("ssi-callback");
     // buff is ignored here. It points to jq->getDescription()->respHandler()->_mBuf, which
     // is accessed directly by the respHandler. _mBuf is a member of MergingHandler.
     LOGS(_log, LOG_LVL_DEBUG, _jobIdStr << " ProcessResponseData with buflen=" << blen
                               << " " << (last ? "(last)" : "(more)"));
-    if (_askForResponseDataCmd == nullptr) {
+    if (!_readPending.exchange(false)) {
         LOGS(_log, LOG_LVL_ERROR, _jobIdStr <<
-             " ProcessResponseData called with invalid _askForResponseDataCmd!!!");
+             " ProcessResponseData called without a GetResponseData call!!!");
         return XrdSsiRequest::PRD_Normal;
     }
 
     // Work with a copy of _jobQuery so it doesn't get reset underneath us by a call to cancel().
-    JobQuery::Ptr jq = _jobQuery;
-    bool jobFinished = false;
-    {
-        std::lock_guard<std::mutex> lock(_finishStatusMutex);
-        jobFinished = _finishStatus != ACTIVE || jq == nullptr;
-    }
-    if (jobFinished) {
+    JobQuery::Ptr jq = _getJobQuery();
+    if (_finishStatus != ACTIVE || jq == nullptr) {
         LOGS(_log, LOG_LVL_INFO, _jobIdStr << "ProcessResponseData job is inactive.");
         // This job is already dead.
         _errorFinish();
@@ -380,9 +322,6 @@ XrdSsiRequest::PRD_Xeq QueryRequest::ProcessResponseData(XrdSsiErrInfo const& eI
              << " " << reason << ")");
         jq->getDescription()->respHandler()->errorFlush(
             "Couldn't retrieve response data:" + reason + " " + _jobIdStr, eCode);
-
-        // Let the ask for response command end.
-        _askForResponseDataCmd->notifyFailed();
         _errorFinish();
         // An error occurred, let processing continue so it can be cleaned up soon.
         return XrdSsiRequest::PRD_Normal;
@@ -390,9 +329,13 @@ XrdSsiRequest::PRD_Xeq QueryRequest::ProcessResponseData(XrdSsiErrInfo const& eI
 
     jq->getStatus()->updateInfo(_jobIdStr, JobStatus::RESPONSE_DATA);
 
-    // Handle the response in a separate thread so we can give this one back to XrdSsi.
-    // _askForResponseDataCmd should call QueryRequest::_processData() next.
-    _askForResponseDataCmd->notifyDataSuccess(blen, last);
+    // Headers are decoded on this thread, which then asks for the Result
+    // message right away. Merges go to the pool so this thread goes back to XrdSsi.
+    if (jq->getDescription()->respHandler()->flushMayBlock()) {
+        _queueMerge(jq, blen, last);
+    } else {
+        _processData(jq, blen, last);
+    }
     return XrdSsiRequest::PRD_Normal;
 }
 
@@ -405,9 +348,9 @@ void QueryRequest::_processData(JobQuery::Ptr const& jq, int blen, bool last) {
         return;
     }
 
-    _askForResponseDataCmd.reset(); // No longer need it, and don't want our destructor calling _errorFinish().
     bool largeResult = false;
     bool flushOk = jq->getDescription()->respHandler()->flush(blen, last, largeResult);
+    _endResponseRead(); // The buffer is processed, let other jobs of the query read.
     if (largeResult) {
         if (!_largeResult) LOGS(_log, LOG_LVL_DEBUG, _jobIdStr << " holdState largeResult set to true");
         _largeResult = true; // Once the worker indicates it's a large result, it stays that way.
@@ -426,9 +369,7 @@ void QueryRequest::_processData(JobQuery::Ptr const& jq, int blen, bool last) {
             // having XrdSsi wait for anything.
             return;
         } else {
-            _askForResponseDataCmd = std::make_shared<AskForResponseDataCmd>(shared_from_this(), jq);
-            LOGS(_log, LOG_LVL_DEBUG, _jobIdStr << "queuing askForResponseDataCmd");
-            _queueAskForResponse(_askForResponseDataCmd, jq);
+            _askForResponse(jq);
         }
     } else {
         LOGS(_log, LOG_LVL_DEBUG, _jobIdStr << " ProcessResponse data flush failed");
@@ -446,28 +387,31 @@ void QueryRequest::_processData(JobQuery::Ptr const& jq, int blen, bool last) {
 /// @return true if QueryRequest cancelled successfully.
 bool QueryRequest::cancel() {
     LOGS(_log, LOG_LVL_DEBUG, _jobIdStr << " QueryRequest::cancel");
-    {
-        std::lock_guard<std::mutex> lock(_finishStatusMutex);
-        if (_cancelled) {
-            LOGS(_log, LOG_LVL_DEBUG, _jobIdStr <<" QueryRequest::cancel already cancelled, ignoring");
-            return false; // Don't do anything if already cancelled.
-        }
-        _cancelled = true;
-        _retried.store(true); // Prevent retries.
-        // Only call the following if the job is NOT already done.
-        if (_finishStatus == ACTIVE) {
-            auto jq = _jobQuery;
-            if (jq != nullptr) jq->getStatus()->updateInfo(_jobIdStr, JobStatus::CANCEL);
-        }
+    if (_cancelled.exchange(true)) {
+        LOGS(_log, LOG_LVL_DEBUG, _jobIdStr <<" QueryRequest::cancel already cancelled, ignoring");
+        return false; // Don't do anything if already cancelled.
+    }
+    _retried.store(true); // Prevent retries.
+    // Only call the following if the job is NOT already done.
+    auto jq = _getJobQuery();
+    if (_finishStatus == ACTIVE && jq != nullptr) {
+        jq->getStatus()->updateInfo(_jobIdStr, JobStatus::CANCEL);
     }
     return _errorFinish(true); // return true if errorFinish cancelled
 }
 
 
+/// Used for stragglers, unlike cancel() the job is not given up.
+bool QueryRequest::retry() {
+    LOGS(_log, LOG_LVL_DEBUG, _jobIdStr << " QueryRequest::retry");
+    return _errorFinish(true, true);
+}
+
+
 /// @return true if this object's JobQuery, or its Executive has been cancelled.
 /// It takes time for the Executive to flag all jobs as being cancelled
 bool QueryRequest::isQueryCancelled() {
-    auto jq = _jobQuery;
+    auto jq = _getJobQuery();
     if (jq == nullptr) {
         // Need to check if _jobQuery is null due to cancellation.
         return isQueryRequestCancelled();
@@ -479,7 +423,6 @@ bool QueryRequest::isQueryCancelled() {
 /// @return true if QueryRequest::cancel() has been called.
 /// QueryRequest::isCancelled() is a much better indicator of user query cancellation.
 bool QueryRequest::isQueryRequestCancelled() {
-    std::lock_guard<std::mutex> lock(_finishStatusMutex);
     return _cancelled;
 }
 
@@ -488,19 +431,17 @@ bool QueryRequest::isQueryRequestCancelled() {
 /// This should only be called by _finish or _errorFinish.
 void QueryRequest::cleanup() {
     LOGS_DEBUG(_jobIdStr << " QueryRequest::cleanup()");
-    {
-        std::lock_guard<std::mutex> lock(_finishStatusMutex);
-        if (_finishStatus == ACTIVE) {
-            LOGS_ERROR(_jobIdStr << " QueryRequest::cleanup called before _finish or _errorFinish");
-            return;
-        }
+    _endResponseRead();
+    if (_finishStatus == ACTIVE) {
+        LOGS_ERROR(_jobIdStr << " QueryRequest::cleanup called before _finish or _errorFinish");
+        return;
     }
+    // SSI is done with the request after Finished().
+    std::atomic_store(&_payload, std::shared_ptr<std::string const>());
 
-    // These need to be outside the mutex lock, or you could delete
-    // _finishStatusMutex before it is unlocked.
     // This should reset _jobquery and _keepAlive without risk of either being deleted
-    // before being reset.
-    std::shared_ptr<JobQuery> jq(std::move(_jobQuery));
+    // before being reset, as either may hold the last reference to this object.
+    std::shared_ptr<JobQuery> jq(std::atomic_exchange(&_jobQuery, std::shared_ptr<JobQuery>()));
     std::shared_ptr<QueryRequest> keep(std::move(_keepAlive));
 }
 
@@ -509,24 +450,21 @@ void QueryRequest::cleanup() {
 /// THIS FUNCTION WILL RESULT IN THIS OBJECT BEING DESTROYED, UNLESS there is
 /// a local shared pointer for this QueryRequest and/or its owner JobQuery.
 /// See QueryRequest::cleanup()
+/// @param retryCancelled - run the job again even though the request is cancelled.
 /// @return true if this QueryRequest object had the authority to make changes.
-bool QueryRequest::_errorFinish(bool shouldCancel) {
+bool QueryRequest::_errorFinish(bool shouldCancel, bool retryCancelled) {
     LOGS(_log, LOG_LVL_DEBUG, _jobIdStr << " _errorFinish() shouldCancel=" << shouldCancel);
-    auto jq = _jobQuery;
-    {
-        // Running _errorFinish more than once could cause errors.
-        std::lock_guard<std::mutex> lock(_finishStatusMutex);
-        if (_finishStatus != ACTIVE || jq == nullptr) {
-            // Either _finish or _errorFinish has already been called.
-            LOGS_DEBUG(_jobIdStr << " _errorFinish() job no longer ACTIVE, ignoring "
-                       << " _finishStatus=" << _finishStatus
-                       << " ACTIVE=" << ACTIVE << " jq=" << jq);
-            return false;
-        }
-        _finishStatus = ERROR;
+    // Running _errorFinish more than once could cause errors, only the
+    // call taking the request out of ACTIVE goes on.
+    auto jq = _getJobQuery();
+    if (jq == nullptr || !_leaveActive(ERROR)) {
+        // Either _finish or _errorFinish has already been called.
+        LOGS_DEBUG(_jobIdStr << " _errorFinish() job no longer ACTIVE, ignoring "
+                   << " _finishStatus=" << _finishStatus.load()
+                   << " ACTIVE=" << ACTIVE << " jq=" << jq);
+        return false;
     }
 
-    // Make the calls outside of the mutex lock.
     LOGS(_log, LOG_LVL_DEBUG, _jobIdStr << " calling Finished(shouldCancel=" << shouldCancel << ")");
     bool ok = Finished(shouldCancel);
     _finishedCalled = true;
@@ -536,7 +474,11 @@ bool QueryRequest::_errorFinish(bool shouldCancel) {
         LOGS(_log, LOG_LVL_DEBUG, _jobIdStr << " QueryRequest::_errorFinish ok");
     }
 
-    if (!_retried.exchange(true) && !shouldCancel) {
+    // Errors and stragglers count against the worker, cancellations don't.
+    bool const failed = !shouldCancel || retryCancelled;
+    _releaseReplica(jq, failed, false);
+
+    if (!_retried.exchange(true) && (!shouldCancel || retryCancelled)) {
         // There's a slight race condition here. _jobQuery::runJob() creates a
         // new QueryRequest object which will replace this one in _jobQuery.
         // The replacement could show up before this one's cleanup() is called,
@@ -561,15 +503,11 @@ bool QueryRequest::_errorFinish(bool shouldCancel) {
 /// See QueryRequest::cleanup()
 void QueryRequest::_finish() {
     LOGS_DEBUG(_jobIdStr << " QueryRequest::_finish");
-    {
-        // Running _finish more than once would cause errors.
-        std::lock_guard<std::mutex> lock(_finishStatusMutex);
-        if (_finishStatus != ACTIVE) {
-            // Either _finish or _errorFinish has already been called.
-            LOGS_WARN(_jobIdStr << " QueryRequest::_finish called when not ACTIVE, ignoring");
-            return;
-        }
-        _finishStatus = FINISHED;
+    // Running _finish more than once would cause errors.
+    if (!_leaveActive(FINISHED)) {
+        // Either _finish or _errorFinish has already been called.
+        LOGS_WARN(_jobIdStr << " QueryRequest::_finish called when not ACTIVE, ignoring");
+        return;
     }
 
     bool ok = Finished();
@@ -580,6 +518,7 @@ void QueryRequest::_finish() {
         LOGS(_log, LOG_LVL_DEBUG, _jobIdStr << " QueryRequest::finish Finished() ok.");
     }
 
+    _releaseReplica(_getJobQuery(), true, true);
     _callMarkComplete(true);
     cleanup();
 }
@@ -588,11 +527,31 @@ void QueryRequest::_finish() {
 // Call MarkCompleteFunc only once, it should only be called from _finish() or _errorFinish.
 void QueryRequest::_callMarkComplete(bool success) {
     if (!_calledMarkComplete.exchange(true)) {
-        auto jq = _jobQuery;
+        auto jq = _getJobQuery();
         if (jq != nullptr) jq->getMarkCompleteFunc()->operator()(success);
     }
 }
 
+/// Tell _replicaSelector the request to _worker ended, once. The time of the
+/// attempt is only used when 'measured', and a failure is not retried there.
+void QueryRequest::_releaseReplica(JobQuery::Ptr const& jq, bool measured, bool success) {
+    if (_replicaSelector == nullptr || _replicaReleased.exchange(true)) return;
+    std::chrono::milliseconds elapsed(0);
+    if (measured && jq != nullptr) {
+        elapsed = jq->getAttemptElapsed();
+        if (!success) jq->addFailedWorker(_worker);
+    }
+    _replicaSelector->jobFinished(_worker, elapsed, success);
+}
+
+/// Move _finishStatus from ACTIVE to 'status'.
+/// @return false if the request already left ACTIVE.
+bool QueryRequest::_leaveActive(FinishStatus status) {
+    FinishStatus active = ACTIVE;
+    return _finishStatus.compare_exchange_strong(active, status);
+}
+
+
 std::ostream& operator<<(std::ostream& os, QueryRequest const& qr) {
     os << "QueryRequest " << qr._jobIdStr;
     return os;
@@ -24,10 +24,10 @@
 #define LSST_QSERV_QDISP_QUERYREQUEST_H
 
 // System headers
+#include <atomic>
 #include <exception>
 #include <iostream>
 #include <memory>
-#include <mutex>
 #include <sstream>
 #include <string>
 
@@ -39,6 +39,7 @@
 #include "czar/Czar.h"
 #include "qdisp/JobQuery.h"
 #include "qdisp/QdispPool.h"
+#include "qdisp/ReplicaSelector.h"
 
 namespace lsst {
 namespace qserv {
@@ -107,10 +108,8 @@ public:
     /// @return content of request data
     char* GetRequest(int& requestLength) override;
 
-    /// Called by SSI to release the allocated request payload. As we don't
-    /// own the buffer, so we can't release it. Therefore, we accept the
-    /// default implementation that does nothing.
-    /// void RelRequestBuffer() override;
+    /// Called by SSI to release the request payload once it has been sent.
+    void RelRequestBuffer() override;
 
     /// Called by SSI when a response is ready
     /// precondition: rInfo.rType != isNone
@@ -122,14 +121,20 @@ public:
                            char *buff, int blen, bool last) override;
 
     bool cancel();
+    /// Cancel this request at the worker and run the job again as a new attempt.
+    /// @return true if this request was still active.
+    bool retry();
     bool isQueryCancelled();
     bool isQueryRequestCancelled();
     void doNotRetry() { _retried.store(true); }
+    /// Count this request against 'worker', picked by 'selector', until it ends.
+    void setReplica(std::shared_ptr<ReplicaSelector> const& selector, std::string const& worker) {
+        _replicaSelector = selector;
+        _worker = worker;
+    }
     std::string getSsiErr(XrdSsiErrInfo const& eInfo, int* eCode);
     void cleanup(); ///< Must be called when this object is no longer needed.
 
-    class AskForResponseDataCmd;
-
     friend std::ostream& operator<<(std::ostream& os, QueryRequest const& r);
 private:
     // Private constructor to safeguard enable_shared_from_this construction.
@@ -138,21 +143,23 @@ private:
     void _callMarkComplete(bool success);
     bool _importStream(JobQuery::Ptr const& jq);
     bool _importError(std::string const& msg, int code);
-    bool _errorFinish(bool shouldCancel=false);
+    bool _errorFinish(bool shouldCancel=false, bool retryCancelled=false);
     void _finish();
     void _processData(JobQuery::Ptr const& jq, int blen, bool last);
-    void _queueAskForResponse(std::shared_ptr<AskForResponseDataCmd> const& cmd, JobQuery::Ptr const& jq);
+    void _askForResponse(JobQuery::Ptr const& jq);
+    bool _getResponseData(JobQuery::Ptr const& jq);
+    void _endResponseRead();
+    void _queueMerge(JobQuery::Ptr const& jq, int blen, bool last);
+    void _releaseReplica(JobQuery::Ptr const& jq, bool measured, bool success);
 
-    /// _holdState indicates the data is being held by SSI for a large response using LargeResultMgr.
-    /// If the state is NOT NO_HOLD0, then this instance has decremented the shared semaphore and it
-    /// must increment the semaphore before going away.
-    enum HoldState {NO_HOLD0 = 0, GET_DATA1 = 1, MERGE2 = 2};
-    void _setHoldState(HoldState state);
-    HoldState _holdState{NO_HOLD0};
+    enum FinishStatus { ACTIVE, FINISHED, ERROR };
+
+    JobQuery::Ptr _getJobQuery() const { return std::atomic_load(&_jobQuery); }
+    bool _leaveActive(FinishStatus status);
 
     /// Job information. Not using a weak_ptr as Executive could drop its JobQuery::Ptr before we're done with it.
-    /// A call to cancel() could reset _jobQuery early, so copy or protect _jobQuery with _finishStatusMutex
-    /// as needed. If (_finishStatus == ACTIVE) _jobQuery should be good.
+    /// cleanup() resets _jobQuery, so it is only accessed through _getJobQuery() and std::atomic_exchange().
+    /// If (_finishStatus == ACTIVE) _jobQuery should be good.
     std::shared_ptr<JobQuery> _jobQuery;
 
     std::atomic<bool> _retried {false}; ///< Protect against multiple retries of _jobQuery from a 
@@ -160,9 +167,16 @@ private:
     std::atomic<bool> _calledMarkComplete {false}; ///< Protect against multiple calls to MarkCompleteFunc
                                                    /// from a single QueryRequest.
 
-    std::mutex _finishStatusMutex; ///< used to protect _cancelled, _finishStatus, and _jobQuery.
-    enum FinishStatus { ACTIVE, FINISHED, ERROR } _finishStatus {ACTIVE}; // _finishStatusMutex
-    bool _cancelled {false}; ///< true if cancelled, protected by _finishStatusMutex.
+    /// Request buffer given to SSI, until released. Only accessed with
+    /// std::atomic_load() and std::atomic_store().
+    std::shared_ptr<std::string const> _payload;
+    /// Lifecycle of the request. It leaves ACTIVE once, for FINISHED in
+    /// _finish() or ERROR in _errorFinish(), with a compare-and-swap, and
+    /// only the thread making that transition calls Finished(), retries the
+    /// job or reports its completion. cancel() sets _cancelled first, and
+    /// its _errorFinish() does nothing if the request already left ACTIVE.
+    std::atomic<FinishStatus> _finishStatus {ACTIVE};
+    std::atomic<bool> _cancelled {false}; ///< true once cancel() has been called.
 
     std::shared_ptr<QueryRequest> _keepAlive; ///< Used to keep this object alive during race condition.
     std::string _jobIdStr {QueryIdHelper::makeIdStr(0, 0, true)}; ///< for debugging only.
@@ -172,7 +186,13 @@ private:
 
     bool _largeResult{false}; ///< True if the worker flags this job as having a large result.
     QdispPool::Ptr _qdispPool;
-    std::shared_ptr<AskForResponseDataCmd> _askForResponseDataCmd;
+    std::weak_ptr<Executive> _executive; ///< Holds the query's response reads budget.
+    std::atomic<bool> _holdsResponseRead{false}; ///< True while holding one of the query's response reads.
+    std::atomic<bool> _readPending{false}; ///< True between GetResponseData and ProcessResponseData.
+
+    std::shared_ptr<ReplicaSelector> _replicaSelector; ///< null unless the worker was picked by it.
+    std::string _worker; ///< Worker the request was sent to, if picked by _replicaSelector.
+    std::atomic<bool> _replicaReleased{false}; ///< True once _replicaSelector knows the request ended.
 };
 
 std::ostream& operator<<(std::ostream& os, QueryRequest const& r);
@@ -0,0 +1,163 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "qdisp/ReplicaSelector.h"
+
+// System headers
+#include <algorithm>
+#include <exception>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.qdisp.ReplicaSelector");
+
+/// Weight of the last job time in the moving average.
+double const latencyWeight = 0.2;
+
+} // anonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace qdisp {
+
+ReplicaSelector::ReplicaSelector(LoadFunc const& load, VersionFunc const& version,
+                                 std::chrono::milliseconds checkInterval)
+    : _load(load), _version(version), _checkInterval(checkInterval) {
+}
+
+
+std::string ReplicaSelector::select(std::string const& db, int chunk,
+                                    std::set<std::string> const& avoid) {
+    _refresh(db);
+    std::lock_guard<std::mutex> lock(_mtx);
+    auto dbIter = _replicas.find(db);
+    if (dbIter == _replicas.end()) return std::string();
+    auto chunkIter = dbIter->second.find(chunk);
+    if (chunkIter == dbIter->second.end()) return std::string();
+    std::vector<std::string> const& workers = chunkIter->second;
+    if (workers.size() < 2 && avoid.empty()) return std::string();
+
+    // Workers with no finished job yet are expected to take the average time.
+    double sumLatency = 0;
+    int known = 0;
+    for (auto const& elem : _loads) {
+        if (elem.second.latencyMs > 0) {
+            sumLatency += elem.second.latencyMs;
+            ++known;
+        }
+    }
+    double const defaultLatency = (known > 0) ? sumLatency / known : 1.0;
+
+    // Starting with a different replica for each chunk breaks ties evenly.
+    std::string const* best = nullptr;
+    double bestWait = 0;
+    size_t const n = workers.size();
+    for (size_t j = 0; j < n; ++j) {
+        std::string const& worker = workers[(static_cast<size_t>(chunk) + j) % n];
+        if (avoid.count(worker) > 0) continue;
+        auto loadIter = _loads.find(worker);
+        int const inFlight = (loadIter == _loads.end()) ? 0 : loadIter->second.inFlight;
+        double const latency = (loadIter == _loads.end() || loadIter->second.latencyMs <= 0)
+                               ? defaultLatency : loadIter->second.latencyMs;
+        double const wait = (inFlight + 1) * latency;
+        if (best == nullptr || wait < bestWait) {
+            best = &worker;
+            bestWait = wait;
+        }
+    }
+    if (best == nullptr) return std::string();
+    WorkerLoad& load = _loads[*best];
+    ++load.inFlight;
+    ++load.selected;
+    return *best;
+}
+
+
+void ReplicaSelector::jobFinished(std::string const& worker, std::chrono::milliseconds elapsed,
+                                  bool success) {
+    if (worker.empty()) return;
+    std::lock_guard<std::mutex> lock(_mtx);
+    WorkerLoad& load = _loads[worker];
+    if (load.inFlight > 0) --load.inFlight;
+    if (elapsed.count() <= 0) return;
+    double ms = elapsed.count();
+    if (!success) {
+        ms = std::max(ms, 2 * load.latencyMs);
+    }
+    load.latencyMs = (load.latencyMs <= 0) ? ms : (1 - latencyWeight) * load.latencyMs + latencyWeight * ms;
+}
+
+
+std::map<std::string, ReplicaSelector::WorkerLoad> ReplicaSelector::getLoads() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _loads;
+}
+
+
+/// Read the replicas of 'db' unless they are known and of the current version.
+void ReplicaSelector::_refresh(std::string const& db) {
+    std::lock_guard<std::mutex> loadLock(_loadMtx);
+    auto const now = std::chrono::steady_clock::now();
+    bool known = false;
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        known = _replicas.count(db) > 0;
+    }
+    if (now >= _nextCheck) {
+        _nextCheck = now + _checkInterval;
+        std::string version;
+        try {
+            version = _version();
+        } catch (std::exception const& exc) {
+            LOGS(_log, LOG_LVL_WARN, "ReplicaSelector failed to read the placement version: " << exc.what());
+            return;
+        }
+        if (version.empty() || version != _loadedVersion) {
+            LOGS(_log, LOG_LVL_DEBUG, "ReplicaSelector placement version " << version);
+            _loadedVersion = version;
+            std::lock_guard<std::mutex> lock(_mtx);
+            _replicas.clear();
+            known = false;
+        }
+    }
+    if (known) return;
+
+    Replicas replicas;
+    try {
+        replicas = _load(db);
+    } catch (std::exception const& exc) {
+        // The redirector picks the workers until the next check reads them again.
+        LOGS(_log, LOG_LVL_WARN, "ReplicaSelector failed to read the replicas of " << db << ": "
+             << exc.what());
+        _loadedVersion.clear();
+    }
+    LOGS(_log, LOG_LVL_DEBUG, "ReplicaSelector " << db << " chunks=" << replicas.size());
+    std::lock_guard<std::mutex> lock(_mtx);
+    _replicas[db] = std::move(replicas);
+}
+
+}}} // namespace lsst::qserv::qdisp
@@ -0,0 +1,105 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_QDISP_REPLICASELECTOR_H
+#define LSST_QSERV_QDISP_REPLICASELECTOR_H
+
+// System headers
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace lsst {
+namespace qserv {
+namespace qdisp {
+
+/// ReplicaSelector picks the worker a chunk job is sent to among the
+/// replicas of the chunk, instead of leaving it to the XRootD redirector
+/// which always picks the same one. The least loaded replica is the one
+/// with the shortest expected wait, the jobs it has in flight from this
+/// czar times its recent job time, so large scans spread over the replicas.
+///
+/// The placement of the replicas is read, one database at a time, when a job
+/// of the database is first sent and again once the version of the placement
+/// changed, which is checked every checkInterval.
+class ReplicaSelector {
+public:
+    using Ptr = std::shared_ptr<ReplicaSelector>;
+    /// Workers holding each chunk, by chunk id.
+    using Replicas = std::map<int, std::vector<std::string>>;
+    /// @return the replicas of the chunks of a database.
+    using LoadFunc = std::function<Replicas(std::string const& db)>;
+    /// @return the version of the placement, empty if unknown.
+    using VersionFunc = std::function<std::string()>;
+
+    /// Load of a worker, as seen from this czar.
+    struct WorkerLoad {
+        int inFlight{0};        ///< Jobs sent to it and not finished.
+        double latencyMs{0};    ///< Moving average of the job times, 0 if none finished.
+        uint64_t selected{0};   ///< Jobs sent to it.
+    };
+
+    ReplicaSelector(LoadFunc const& load, VersionFunc const& version,
+                    std::chrono::milliseconds checkInterval=std::chrono::seconds(30));
+
+    ReplicaSelector(ReplicaSelector const&) = delete;
+    ReplicaSelector& operator=(ReplicaSelector const&) = delete;
+
+    /// Pick the worker for a job on 'chunk' of 'db', which is then counted
+    /// in flight until jobFinished() is called for it.
+    /// @param avoid - workers the job failed on.
+    /// @return the worker, or an empty string to let the redirector choose
+    ///         when the chunk has no replica to choose from.
+    std::string select(std::string const& db, int chunk, std::set<std::string> const& avoid);
+
+    /// Record that a job sent to 'worker' by select() finished after 'elapsed'.
+    /// A failure counts as twice the usual time of the worker, at least, and
+    /// a zero 'elapsed', e.g. of a cancelled job, only ends the job.
+    void jobFinished(std::string const& worker, std::chrono::milliseconds elapsed, bool success);
+
+    /// @return the load of each worker jobs were sent to.
+    std::map<std::string, WorkerLoad> getLoads() const;
+
+private:
+    void _refresh(std::string const& db);
+
+    LoadFunc const _load;
+    VersionFunc const _version;
+    std::chrono::milliseconds const _checkInterval;
+
+    std::mutex _loadMtx; ///< One load at a time, protects _nextCheck and _loadedVersion.
+    std::chrono::steady_clock::time_point _nextCheck;
+    std::string _loadedVersion;
+
+    mutable std::mutex _mtx; ///< Protects the members below.
+    std::map<std::string, Replicas> _replicas; ///< Replicas by database.
+    std::map<std::string, WorkerLoad> _loads;  ///< Load by worker.
+};
+
+}}} // namespace lsst::qserv::qdisp
+
+#endif // LSST_QSERV_QDISP_REPLICASELECTOR_H
@@ -67,6 +67,10 @@ public:
     /// @return true if successful (no error)
     virtual bool flush(int bLen, bool& last, bool& largeResult) = 0;
 
+    /// @return true if flush() of the next buffer may block, merging rows,
+    /// in which case it isn't called from an XrdSsi callback thread.
+    virtual bool flushMayBlock() const { return true; }
+
     /// Signal an unrecoverable error condition. No further calls are expected.
     virtual void errorFlush(std::string const& msg, int code) = 0;
 
@@ -0,0 +1,92 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "qdisp/ScanCursors.h"
+
+// System headers
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+
+namespace lsst {
+namespace qserv {
+namespace qdisp {
+
+ScanCursors& ScanCursors::instance() {
+    // Never deleted, results may arrive during static destruction.
+    static ScanCursors* cursors = new ScanCursors();
+    return *cursors;
+}
+
+
+void ScanCursors::update(std::string const& worker, int chunkId, int cursor) {
+    if (worker.empty()) return;
+    std::lock_guard<std::mutex> lock(_mtx);
+    if (chunkId >= 0) {
+        _chunkWorkers[chunkId] = worker;
+    }
+    if (cursor >= 0) {
+        _cursors[worker] = cursor;
+        _lastCursor = cursor;
+    }
+}
+
+
+std::vector<size_t> ScanCursors::order(std::vector<int> const& chunkIds) const {
+    std::vector<size_t> positions(chunkIds.size());
+    std::iota(positions.begin(), positions.end(), 0);
+    std::vector<int> cursors(chunkIds.size(), -1);
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        if (_lastCursor < 0) {
+            return positions;
+        }
+        for (size_t j = 0; j < chunkIds.size(); ++j) {
+            cursors[j] = _lastCursor;
+            auto workerIter = _chunkWorkers.find(chunkIds[j]);
+            if (workerIter != _chunkWorkers.end()) {
+                auto cursorIter = _cursors.find(workerIter->second);
+                if (cursorIter != _cursors.end()) {
+                    cursors[j] = cursorIter->second;
+                }
+            }
+        }
+    }
+    // Distance from the chunk after the cursor, the one being scanned is
+    // reached last since its new tasks wait for the next pass.
+    int64_t span = 1;
+    for (size_t j = 0; j < chunkIds.size(); ++j) {
+        span = std::max<int64_t>(span, std::max(chunkIds[j], cursors[j]) + 1);
+    }
+    std::vector<int64_t> distances(chunkIds.size());
+    for (size_t j = 0; j < chunkIds.size(); ++j) {
+        distances[j] = ((chunkIds[j] - static_cast<int64_t>(cursors[j]) - 1) % span + span) % span;
+    }
+    std::stable_sort(positions.begin(), positions.end(), [&distances](size_t a, size_t b) {
+        return distances[a] < distances[b];
+    });
+    return positions;
+}
+
+}}} // namespace lsst::qserv::qdisp
@@ -0,0 +1,72 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_QDISP_SCANCURSORS_H
+#define LSST_QSERV_QDISP_SCANCURSORS_H
+
+// System headers
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace lsst {
+namespace qserv {
+namespace qdisp {
+
+/// ScanCursors keeps, for each worker, the chunk its shared scan was on when
+/// it last sent a result, and the worker each chunk was answered from.
+///
+/// A worker scans its queued chunks in increasing chunk id order, wrapping
+/// around, and tasks for the chunk being scanned wait for the next pass.
+/// Sending the jobs of a scan query in the order the scan reaches their
+/// chunks lets it join the scan in progress instead of starting another,
+/// so concurrent queries share the tables memman has locked.
+class ScanCursors {
+public:
+    /// @return the czar-wide cursors.
+    static ScanCursors& instance();
+
+    ScanCursors() = default;
+    ScanCursors(ScanCursors const&) = delete;
+    ScanCursors& operator=(ScanCursors const&) = delete;
+
+    /// Record that 'worker' answered for 'chunkId' while its scan was on
+    /// chunk 'cursor'. A negative cursor only records where the chunk is.
+    void update(std::string const& worker, int chunkId, int cursor);
+
+    /// @return the positions in 'chunkIds' in the order the scans of their
+    ///         workers will reach them. Chunks on workers with no known
+    ///         cursor use the cursor reported last. The order is unchanged
+    ///         if no cursor is known.
+    std::vector<size_t> order(std::vector<int> const& chunkIds) const;
+
+private:
+    mutable std::mutex _mtx; ///< Protects all members
+    std::map<std::string, int> _cursors; ///< Scan cursor by worker name.
+    std::map<int, std::string> _chunkWorkers; ///< Worker by chunk id.
+    int _lastCursor{-1}; ///< Cursor reported last by any worker.
+};
+
+}}} // namespace lsst::qserv::qdisp
+
+#endif // LSST_QSERV_QDISP_SCANCURSORS_H
@@ -0,0 +1,81 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "qdisp/ShardedJobMap.h"
+
+// Qserv headers
+#include "util/Timer.h"
+
+namespace {
+
+/// Sampled timing of the shard mutexes of all the Executive job maps.
+lsst::qserv::util::LockTiming jobMapLockTiming("executive_job_map");
+
+} // namespace
+
+namespace lsst {
+namespace qserv {
+namespace qdisp {
+
+bool ShardedJobMap::insert(int jobId, JobPtr const& job) {
+    Shard& shard = _shardOf(jobId);
+    util::LockGuardTimed lock(shard.mtx, jobMapLockTiming);
+    if (!shard.jobs.emplace(jobId, job).second) {
+        return false;
+    }
+    ++_size;
+    return true;
+}
+
+
+ShardedJobMap::JobPtr ShardedJobMap::find(int jobId) const {
+    Shard const& shard = _shardOf(jobId);
+    util::LockGuardTimed lock(shard.mtx, jobMapLockTiming);
+    auto iter = shard.jobs.find(jobId);
+    return (iter == shard.jobs.end()) ? nullptr : iter->second;
+}
+
+
+bool ShardedJobMap::erase(int jobId, int& remaining) {
+    Shard& shard = _shardOf(jobId);
+    util::LockGuardTimed lock(shard.mtx, jobMapLockTiming);
+    if (shard.jobs.erase(jobId) == 0) {
+        remaining = _size;
+        return false;
+    }
+    remaining = --_size;
+    return true;
+}
+
+
+void ShardedJobMap::forEach(std::function<void(int, JobPtr const&)> const& func) const {
+    for (auto const& shard : _shards) {
+        util::LockGuardTimed lock(shard.mtx, jobMapLockTiming);
+        for (auto const& entry : shard.jobs) {
+            func(entry.first, entry.second);
+        }
+    }
+}
+
+}}} // namespace lsst::qserv::qdisp
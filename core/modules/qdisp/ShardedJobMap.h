@@ -0,0 +1,89 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_QDISP_SHARDEDJOBMAP_H
+#define LSST_QSERV_QDISP_SHARDEDJOBMAP_H
+
+// System headers
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace lsst {
+namespace qserv {
+namespace qdisp {
+
+class JobQuery;
+
+/// ShardedJobMap maps job ids to jobs. The map is split into shards, each
+/// with its own mutex, so that the XrdSsi callback threads finishing
+/// different jobs of a query rarely wait on each other.
+class ShardedJobMap {
+public:
+    using JobPtr = std::shared_ptr<JobQuery>;
+
+    ShardedJobMap() = default;
+    ShardedJobMap(ShardedJobMap const&) = delete;
+    ShardedJobMap& operator=(ShardedJobMap const&) = delete;
+
+    /// @return false, leaving the map unchanged, if jobId is already in the map.
+    bool insert(int jobId, JobPtr const& job);
+
+    /// @return the job, nullptr if jobId is not in the map.
+    JobPtr find(int jobId) const;
+
+    /// Remove jobId from the map.
+    /// @param remaining - set to the number of jobs left in the map when
+    ///        jobId was removed, so only one caller sees it drop to 0.
+    /// @return false if jobId was not in the map.
+    bool erase(int jobId, int& remaining);
+
+    /// Call 'func' with each job in the map. Each shard is locked in turn,
+    /// so 'func' must not modify this map.
+    void forEach(std::function<void(int jobId, JobPtr const& job)> const& func) const;
+
+    int size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+private:
+    static int const _shardCount = 32;
+
+    struct Shard {
+        mutable std::mutex mtx;
+        std::unordered_map<int, JobPtr> jobs;
+    };
+
+    Shard& _shardOf(int jobId) { return _shards[static_cast<unsigned>(jobId) % _shardCount]; }
+    Shard const& _shardOf(int jobId) const {
+        return _shards[static_cast<unsigned>(jobId) % _shardCount];
+    }
+
+    std::array<Shard, _shardCount> _shards;
+    std::atomic<int> _size{0}; ///< Number of jobs in all shards.
+};
+
+}}} // namespace lsst::qserv::qdisp
+
+#endif // LSST_QSERV_QDISP_SHARDEDJOBMAP_H
@@ -0,0 +1,116 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "qdisp/WarmupRequest.h"
+
+// Third-party headers
+#include "XrdSsi/XrdSsiErrInfo.hh"
+#include "XrdSsi/XrdSsiResource.hh"
+#include "XrdSsi/XrdSsiService.hh"
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "global/ResourceUnit.h"
+#include "proto/worker.pb.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.qdisp.WarmupRequest");
+
+} // annonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace qdisp {
+
+void WarmupRequest::send(XrdSsiService* service, std::string const& worker) {
+    XrdSsiResource resource(ResourceUnit::makeWorkerPath(worker));
+    service->ProcessRequest(*(new WarmupRequest(worker)), resource);
+}
+
+
+WarmupRequest::WarmupRequest(std::string const& worker) : _worker(worker) {
+    proto::WorkerCommandH header;
+    header.set_command(proto::WorkerCommandH::TEST_ECHO);
+    _frameBuf.serialize(header);
+    proto::WorkerCommandTestEchoM echo;
+    echo.set_value(worker);
+    _frameBuf.serialize(echo);
+}
+
+
+WarmupRequest::~WarmupRequest() {
+}
+
+
+char* WarmupRequest::GetRequest(int& dlen) {
+    dlen = _frameBuf.size();
+    return _frameBuf.data();
+}
+
+
+bool WarmupRequest::ProcessResponse(XrdSsiErrInfo const& eInfo, XrdSsiRespInfo const& rInfo) {
+    if (eInfo.hasError()) {
+        _done(eInfo.Get());
+        return false;
+    }
+    switch (rInfo.rType) {
+    case XrdSsiRespInfo::isData:
+    case XrdSsiRespInfo::isStream:
+        GetResponseData(_buf, sizeof(_buf));
+        return true;
+    default:
+        _done("unexpected response type " + std::to_string(rInfo.rType));
+        return false;
+    }
+}
+
+
+XrdSsiRequest::PRD_Xeq WarmupRequest::ProcessResponseData(XrdSsiErrInfo const& eInfo,
+                                                          char* buff, int blen, bool last) {
+    if (!eInfo.isOK()) {
+        _done(eInfo.Get());
+    } else if (last) {
+        _done(std::string());
+    } else {
+        GetResponseData(_buf, sizeof(_buf));
+    }
+    return XrdSsiRequest::PRD_Normal;
+}
+
+
+/// Release the request and delete it, nothing may use it afterwards.
+void WarmupRequest::_done(std::string const& error) {
+    if (error.empty()) {
+        LOGS(_log, LOG_LVL_DEBUG, "WarmupRequest " << _worker << " answered");
+    } else {
+        LOGS(_log, LOG_LVL_WARN, "WarmupRequest " << _worker << " failed: " << error);
+    }
+    Finished();
+    delete this;
+}
+
+}}} // namespace lsst::qserv::qdisp
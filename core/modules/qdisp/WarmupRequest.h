@@ -0,0 +1,73 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_QDISP_WARMUPREQUEST_H
+#define LSST_QSERV_QDISP_WARMUPREQUEST_H
+
+// System headers
+#include <string>
+
+// Third-party headers
+#include "XrdSsi/XrdSsiRequest.hh"
+
+// Qserv headers
+#include "proto/FrameBuffer.h"
+
+// Forward declarations
+class XrdSsiService;
+
+namespace lsst {
+namespace qserv {
+namespace qdisp {
+
+/// WarmupRequest sends a TEST_ECHO command to the resource of a worker,
+/// which opens the czar's connection to the worker host, through the
+/// redirector, before the jobs of a query need it. See WorkerSessions.
+///
+/// The request deletes itself once the worker answered or it failed.
+class WarmupRequest : public XrdSsiRequest {
+public:
+    /// Send the request to 'worker' through 'service'.
+    static void send(XrdSsiService* service, std::string const& worker);
+
+    WarmupRequest(WarmupRequest const&) = delete;
+    WarmupRequest& operator=(WarmupRequest const&) = delete;
+
+    char* GetRequest(int& dlen) override;
+    bool ProcessResponse(XrdSsiErrInfo const& eInfo, XrdSsiRespInfo const& rInfo) override;
+    XrdSsiRequest::PRD_Xeq ProcessResponseData(XrdSsiErrInfo const& eInfo,
+                                               char* buff, int blen, bool last) override;
+
+private:
+    explicit WarmupRequest(std::string const& worker);
+    ~WarmupRequest() override;
+
+    void _done(std::string const& error);
+
+    std::string const _worker;
+    proto::FrameBuffer _frameBuf;
+    char _buf[1024]; ///< The answer, which is not used.
+};
+
+}}} // namespace lsst::qserv::qdisp
+
+#endif // LSST_QSERV_QDISP_WARMUPREQUEST_H
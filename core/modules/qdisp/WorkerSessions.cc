@@ -0,0 +1,142 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "qdisp/WorkerSessions.h"
+
+// System headers
+#include <algorithm>
+#include <exception>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.qdisp.WorkerSessions");
+
+} // annonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace qdisp {
+
+WorkerSessions::WorkerSessions(WorkersFunc const& workers, VersionFunc const& version,
+                               PingFunc const& ping, std::chrono::milliseconds keepAlive)
+    : _workersFunc(workers), _version(version), _ping(ping), _keepAlive(keepAlive) {
+}
+
+
+WorkerSessions::~WorkerSessions() {
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _stop = true;
+    }
+    _cv.notify_all();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+
+void WorkerSessions::start() {
+    auto const interval = std::max(std::chrono::milliseconds(1000), _keepAlive/4);
+    _thread = std::thread([this, interval]() {
+        check(std::chrono::steady_clock::now());
+        std::unique_lock<std::mutex> lock(_mtx);
+        while (not _cv.wait_for(lock, interval, [this]() { return _stop; })) {
+            lock.unlock();
+            check(std::chrono::steady_clock::now());
+            lock.lock();
+        }
+    });
+}
+
+
+void WorkerSessions::used(std::string const& worker) {
+    auto const now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(_mtx);
+    auto iter = _lastUse.find(worker);
+    if (iter != _lastUse.end()) {
+        iter->second = now;
+    }
+}
+
+
+int WorkerSessions::check(std::chrono::steady_clock::time_point now) {
+    _refresh(now);
+    std::vector<std::string> idle;
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        for (auto& elem : _lastUse) {
+            if (now - elem.second >= _keepAlive) {
+                idle.push_back(elem.first);
+                elem.second = now;
+            }
+        }
+    }
+    for (auto const& worker : idle) {
+        LOGS(_log, LOG_LVL_DEBUG, "WorkerSessions ping " << worker);
+        _ping(worker);
+    }
+    return idle.size();
+}
+
+
+std::vector<std::string> WorkerSessions::getWorkers() const {
+    std::vector<std::string> workers;
+    std::lock_guard<std::mutex> lock(_mtx);
+    for (auto const& elem : _lastUse) {
+        workers.push_back(elem.first);
+    }
+    return workers;
+}
+
+
+/// Read the workers unless they are known and of the current version. New
+/// workers are due for a ping, the others keep their time of last use.
+void WorkerSessions::_refresh(std::chrono::steady_clock::time_point now) {
+    std::string version;
+    std::vector<std::string> workers;
+    try {
+        version = _version();
+        if (_loaded && !version.empty() && version == _loadedVersion) return;
+        workers = _workersFunc();
+    } catch (std::exception const& exc) {
+        LOGS(_log, LOG_LVL_WARN, "WorkerSessions failed to read the workers: " << exc.what());
+        return;
+    }
+    LOGS(_log, LOG_LVL_DEBUG, "WorkerSessions version " << version << " workers=" << workers.size());
+    _loadedVersion = version;
+    _loaded = true;
+
+    std::lock_guard<std::mutex> lock(_mtx);
+    std::map<std::string, std::chrono::steady_clock::time_point> lastUse;
+    for (auto const& worker : workers) {
+        auto iter = _lastUse.find(worker);
+        lastUse[worker] = (iter == _lastUse.end()) ? now - _keepAlive : iter->second;
+    }
+    _lastUse.swap(lastUse);
+}
+
+}}} // namespace lsst::qserv::qdisp
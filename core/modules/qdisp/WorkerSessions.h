@@ -0,0 +1,104 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_QDISP_WORKERSESSIONS_H
+#define LSST_QSERV_QDISP_WORKERSESSIONS_H
+
+// System headers
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lsst {
+namespace qserv {
+namespace qdisp {
+
+/// WorkerSessions keeps the czar's connections to the workers open while
+/// no query uses them, so that the first jobs after an idle period, or to
+/// a worker that just joined, do not pay for the redirector lookup and the
+/// connection setup. Every worker is pinged as soon as it is known, when
+/// the czar starts and again once the worker list changed, and then each
+/// time it went unused for keepAlive.
+///
+/// The workers are read again when their version changed, which is checked
+/// every keepAlive/4.
+class WorkerSessions {
+public:
+    using Ptr = std::shared_ptr<WorkerSessions>;
+    /// @return the ids of the workers.
+    using WorkersFunc = std::function<std::vector<std::string>()>;
+    /// @return the version of the worker list, empty if unknown.
+    using VersionFunc = std::function<std::string()>;
+    /// Send a request to the worker, without waiting for its answer.
+    using PingFunc = std::function<void(std::string const& worker)>;
+
+    WorkerSessions(WorkersFunc const& workers, VersionFunc const& version, PingFunc const& ping,
+                   std::chrono::milliseconds keepAlive);
+
+    /// Stop the thread started by start().
+    ~WorkerSessions();
+
+    WorkerSessions(WorkerSessions const&) = delete;
+    WorkerSessions& operator=(WorkerSessions const&) = delete;
+
+    /// Start a thread calling check(), right away and every keepAlive/4.
+    void start();
+
+    /// Record that a job was just sent to 'worker'.
+    void used(std::string const& worker);
+
+    /// Read the workers if their version changed, then ping those not used
+    /// for keepAlive.
+    /// @return the number of workers pinged.
+    int check(std::chrono::steady_clock::time_point now);
+
+    /// @return the ids of the known workers.
+    std::vector<std::string> getWorkers() const;
+
+private:
+    void _refresh(std::chrono::steady_clock::time_point now);
+
+    WorkersFunc const _workersFunc;
+    VersionFunc const _version;
+    PingFunc const _ping;
+    std::chrono::milliseconds const _keepAlive;
+
+    std::string _loadedVersion; ///< Only used by check().
+    bool _loaded{false};        ///< Only used by check().
+
+    mutable std::mutex _mtx; ///< Protects the members below.
+    /// Time each worker was last used or pinged, by worker id.
+    std::map<std::string, std::chrono::steady_clock::time_point> _lastUse;
+    std::condition_variable _cv;
+    bool _stop{false};
+    std::thread _thread;
+};
+
+}}} // namespace lsst::qserv::qdisp
+
+#endif // LSST_QSERV_QDISP_WORKERSESSIONS_H
@@ -25,21 +25,31 @@
 
 // System headers
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstddef>
+#include <deque>
 #include <errno.h>
+#include <functional>
+#include <map>
 #include <mutex>
+#include <queue>
+#include <random>
 #include <string>
 #include <stdlib.h>
 #include <thread>
 #include <unistd.h>
+#include <vector>
 
 // Third party headers
+#include <mysql/mysql.h>
 #include "XrdSsi/XrdSsiErrInfo.hh"
 #include "XrdSsi/XrdSsiResponder.hh"
 #include "XrdSsi/XrdSsiStream.hh"
 
 // LSST headers
 #include "lsst/log/Log.h"
+#include "proto/FakeProtocolFixture.h"
 #include "proto/ProtoHeaderWrap.h"
 #include "proto/worker.pb.h"
 #include "util/StringHash.h"
@@ -63,8 +73,61 @@ std::atomic<int> finCount(0);
 std::atomic<int> reqCount(0);
 std::atomic<int> totCount(0);
 
+std::atomic<uint64_t> loadRequests(0);
+std::atomic<uint64_t> loadFailures(0);
+std::atomic<uint64_t> loadResponses(0);
+std::atomic<uint64_t> loadBytes(0);
+
 bool _aOK = true;
 
+/// Threads running the replies and stream reads of the load-test mode,
+/// which would need a thread for each of thousands of requests otherwise.
+class Responders {
+public:
+    explicit Responders(int threads) {
+        for (int i = 0; i < std::max(threads, 1); ++i) {
+            _threads.emplace_back(&Responders::_run, this);
+        }
+    }
+
+    void queue(std::function<void()> const& func) {
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            _funcs.push_back(func);
+        }
+        _cv.notify_one();
+    }
+
+    ~Responders() {
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            _stop = true;
+        }
+        _cv.notify_all();
+        for (auto& t : _threads) t.join();
+    }
+
+private:
+    void _run() {
+        std::unique_lock<std::mutex> lock(_mtx);
+        while (true) {
+            _cv.wait(lock, [this]() { return _stop || !_funcs.empty(); });
+            if (_funcs.empty()) return;
+            auto func = std::move(_funcs.front());
+            _funcs.pop_front();
+            lock.unlock();
+            func();
+            lock.lock();
+        }
+    }
+
+    std::mutex _mtx;
+    std::condition_variable _cv;
+    std::deque<std::function<void()>> _funcs;
+    std::vector<std::thread> _threads;
+    bool _stop{false};
+};
+
 enum RespType {RESP_BADREQ, RESP_DATA, RESP_ERROR, RESP_ERRNR,
                RESP_STREAM, RESP_STRERR};
 
@@ -122,12 +185,36 @@ public:
         _isCancelled(false);
     }
 
+    /// Reply for a mock worker of the load-test mode, with an error if
+    /// 'stream' is empty.
+    void ReplyLoad(std::string const& stream) {
+        if (_isCancelled(true)) return;
+        if (stream.empty()) {
+            _ReplyError("Mock worker failure", 18);
+        } else {
+            _msgBuf = stream;
+            _bOff = 0;
+            _bLen = _msgBuf.size();
+            _noData = false;
+            _ReplyStream();
+        }
+        _isCancelled(false);
+    }
+
+    /// Run the stream reads on 'responders' instead of a thread each.
+    void setResponders(Responders* responders) { _responders = responders; }
+
     bool SetBuff(XrdSsiErrInfo& eRef, char* buff, int  blen) override {
 
         // We may have been cancelled while waiting
         //
         if (_isCancelled(true)) return false;
-        std::thread (&Agent::_StrmResp, this, &eRef, buff, blen).detach();
+        if (_responders != nullptr) {
+            XrdSsiErrInfo* eP = &eRef;
+            _responders->queue([this, eP, buff, blen]() { _StrmResp(eP, buff, blen); });
+        } else {
+            std::thread (&Agent::_StrmResp, this, &eRef, buff, blen).detach();
+        }
         _rrMutex.unlock();
         return true;
     }
@@ -182,8 +269,7 @@ private:
     void _ReplyStream() {SetResponse(this);}
 
     void _StrmResp(XrdSsiErrInfo* eP, char* buff, int blen) {
-        std::cerr<<"Stream: cleint asks for " <<blen <<" bytes, have "
-                 <<_bLen <<'\n' <<std::flush;
+        LOGS(_log, LOG_LVL_DEBUG, "Stream: client asks for " << blen << " bytes, have " << _bLen);
         bool last;
 
         // Check for cancellation while we were waiting
@@ -201,18 +287,21 @@ private:
                 memcpy(buff, _msgBuf.data()+_bOff, _bLen);
                 blen = _bLen; _bLen = 0;
                 last = true;
+                if (_responders != nullptr) loadResponses++;
             } else {
                 memcpy(buff, _msgBuf.data()+_bOff,  blen);
                 _bOff += blen; _bLen -= blen;
                 last = false;
             }
         }
+        if (_responders != nullptr && blen > 0) loadBytes += blen;
         _reqP->ProcessResponseData(*eP, buff, blen, last);
         _isCancelled(false);
     }
 
     std::recursive_mutex _rrMutex;
     lsst::qserv::qdisp::QueryRequest* _reqP;
+    Responders* _responders{nullptr};
     std::string _rName;
     std::string _rspBuf;
     std::string _msgBuf;
@@ -223,6 +312,207 @@ private:
     bool        _isFIN;
     bool        _active;
 };
+
+
+/// Builds the result streams of the load-test mode: Result messages of
+/// Load::rowsPerMsg rows with a BIGINT, a DOUBLE and a VARCHAR(Load::rowBytes)
+/// column, each preceded by its wrapped ProtoHeader, as a worker sends them.
+class ResultMaker {
+public:
+    explicit ResultMaker(lsst::qserv::qdisp::XrdSsiServiceMock::Load const& load) : _load(load) {}
+
+    std::string make(lsst::qserv::proto::TaskMsg const& msg, int worker) {
+        namespace proto = lsst::qserv::proto;
+        std::string stream;
+        unsigned int const rowsPerMsg = std::max(_load.rowsPerMsg, 1u);
+        unsigned int done = 0;
+        do {
+            unsigned int const rows = std::min(rowsPerMsg, _load.resultRows - done);
+            done += rows;
+            // Fields serialized after the template replace its values when
+            // the message is parsed.
+            proto::Result tail;
+            tail.set_queryid(msg.queryid());
+            tail.set_jobid(msg.jobid());
+            tail.set_attemptcount(msg.attemptcount());
+            tail.set_continues(done < _load.resultRows);
+            std::string body = _template(rows);
+            tail.AppendPartialToString(&body);
+
+            proto::ProtoHeader header;
+            header.set_protocol(3);
+            header.set_size(body.size());
+            header.set_wname("mock-worker-" + std::to_string(worker));
+            header.set_largeresult(false);
+            header.set_checksum(proto::ProtoHeader::CRC32C);
+            header.set_crc32c(lsst::qserv::util::StringHash::getCrc32c(body.data(), body.size()));
+            std::string headerString;
+            header.SerializeToString(&headerString);
+            stream += proto::ProtoHeaderWrap::wrap(headerString);
+            stream += body;
+        } while (done < _load.resultRows);
+        return stream;
+    }
+
+private:
+    /// @return the serialized Result with 'rows' rows, made once for each count.
+    std::string const& _template(unsigned int rows) {
+        using FakeColumn = lsst::qserv::proto::FakeProtocolFixture::FakeColumn;
+        std::lock_guard<std::mutex> lock(_mtx);
+        auto& entry = _templates[rows];
+        if (entry.empty()) {
+            std::vector<FakeColumn> const columns = {
+                {FakeColumn::INTEGER, "BIGINT", MYSQL_TYPE_LONGLONG, 0, 0.0},
+                {FakeColumn::REAL, "DOUBLE", MYSQL_TYPE_DOUBLE, 0, 0.0},
+                {FakeColumn::STRING, "VARCHAR(" + std::to_string(_load.rowBytes) + ")",
+                 MYSQL_TYPE_VAR_STRING, _load.rowBytes, 0.0}
+            };
+            std::unique_ptr<lsst::qserv::proto::Result> result(_fixture.makeResult(columns, rows, true));
+            result->SerializeToString(&entry);
+        }
+        return entry;
+    }
+
+    lsst::qserv::qdisp::XrdSsiServiceMock::Load const _load;
+    std::mutex _mtx;
+    lsst::qserv::proto::FakeProtocolFixture _fixture;
+    std::map<unsigned int, std::string> _templates;
+};
+
+
+/// The mock workers of the load-test mode. Requests go to the worker of
+/// their chunk, which runs Load::slotsPerWorker of them at once, each for an
+/// exponentially distributed time, and queues the others. One thread keeps
+/// the times the running requests are done and hands their replies to the
+/// Responders.
+class MockWorkers {
+public:
+    typedef lsst::qserv::qdisp::XrdSsiServiceMock::Load Load;
+
+    explicit MockWorkers(std::shared_ptr<Load const> const& load)
+        : _load(load), _workers(std::max(load->workers, 1)), _maker(*load),
+          _responders(load->responderThreads), _rand(load->seed), _latency(1.0 / std::max(load->latencyMs, 1e-3)),
+          _thread(&MockWorkers::_run, this) {}
+
+    ~MockWorkers() {
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            _stop = true;
+        }
+        _cv.notify_all();
+        _thread.join();
+    }
+
+    void submit(Agent* agent, lsst::qserv::proto::TaskMsg const& msg) {
+        Request req{agent, msg.queryid(), msg.jobid(), msg.attemptcount(),
+                    static_cast<int>(msg.chunkid() % _workers.size())};
+        agent->setResponders(&_responders);
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            auto& worker = _workers[req.worker];
+            if (worker.running < _load->slotsPerWorker) {
+                ++worker.running;
+                _start(req);
+            } else {
+                worker.waiting.push_back(req);
+            }
+        }
+        _cv.notify_one();
+    }
+
+private:
+    struct Request {
+        Agent* agent;
+        uint64_t queryId;
+        int jobId;
+        int attemptCount;
+        int worker;
+    };
+
+    struct Worker {
+        int running{0};
+        std::deque<Request> waiting;
+    };
+
+    typedef std::chrono::steady_clock Clock;
+    typedef std::pair<Clock::time_point, uint64_t> Due; ///< time, sequence number
+
+    /// Start running 'req' on its worker, _mtx must be held.
+    void _start(Request const& req) {
+        auto const ms = std::chrono::duration<double, std::milli>(_latency(_rand));
+        Due const due(Clock::now() + std::chrono::duration_cast<Clock::duration>(ms), _seq++);
+        _due.push(due);
+        _running.emplace(due.second, req);
+    }
+
+    void _run() {
+        std::unique_lock<std::mutex> lock(_mtx);
+        while (!_stop) {
+            if (_due.empty()) {
+                _cv.wait(lock);
+                continue;
+            }
+            auto const next = _due.top();
+            if (Clock::now() < next.first) {
+                _cv.wait_until(lock, next.first);
+                continue;
+            }
+            _due.pop();
+            auto it = _running.find(next.second);
+            Request const req = it->second;
+            _running.erase(it);
+            auto& worker = _workers[req.worker];
+            if (worker.waiting.empty()) {
+                --worker.running;
+            } else {
+                _start(worker.waiting.front());
+                worker.waiting.pop_front();
+            }
+            bool const fail = _fail(_rand) < _load->failRate;
+            lock.unlock();
+            _responders.queue([this, req, fail]() { _reply(req, fail); });
+            lock.lock();
+        }
+    }
+
+    void _reply(Request const& req, bool fail) {
+        std::string stream;
+        if (fail) {
+            loadFailures++;
+        } else {
+            lsst::qserv::proto::TaskMsg msg;
+            msg.set_queryid(req.queryId);
+            msg.set_jobid(req.jobId);
+            msg.set_attemptcount(req.attemptCount);
+            stream = _maker.make(msg, req.worker);
+        }
+        req.agent->ReplyLoad(stream);
+    }
+
+    std::shared_ptr<Load const> const _load;
+    std::mutex _mtx;
+    std::condition_variable _cv;
+    std::vector<Worker> _workers;
+    ResultMaker _maker;
+    Responders _responders; ///< After _maker, which its threads use.
+    std::mt19937_64 _rand;
+    std::exponential_distribution<double> _latency;
+    std::uniform_real_distribution<double> _fail;
+    std::priority_queue<Due, std::vector<Due>, std::greater<Due>> _due;
+    std::map<uint64_t, Request> _running;
+    uint64_t _seq{0};
+    bool _stop{false};
+    std::thread _thread; ///< Last, so that it starts after the other members.
+};
+
+std::mutex _workersMtx;
+std::shared_ptr<MockWorkers> _workers; ///< Set in the load-test mode.
+
+std::shared_ptr<MockWorkers> getWorkers() {
+    std::lock_guard<std::mutex> lock(_workersMtx);
+    return _workers;
+}
+
 }
 
 namespace lsst {
@@ -245,6 +535,26 @@ void XrdSsiServiceMock::Reset() {
     canCount = 0;
     finCount = 0;
     reqCount = 0;
+    loadRequests = 0;
+    loadFailures = 0;
+    loadResponses = 0;
+    loadBytes = 0;
+}
+
+void XrdSsiServiceMock::setLoad(std::shared_ptr<Load const> const& load) {
+    std::shared_ptr<MockWorkers> workers;
+    if (load != nullptr) workers = std::make_shared<MockWorkers>(load);
+    std::lock_guard<std::mutex> lock(_workersMtx);
+    _workers = workers;
+}
+
+XrdSsiServiceMock::LoadStats XrdSsiServiceMock::getLoadStats() {
+    LoadStats stats;
+    stats.requests = loadRequests;
+    stats.failures = loadFailures;
+    stats.responses = loadResponses;
+    stats.bytes = loadBytes;
+    return stats;
 }
 
 void XrdSsiServiceMock::setGo(bool go) {_go.exchangeNotify(go);}
@@ -278,6 +588,27 @@ void XrdSsiServiceMock::ProcessRequest(XrdSsiRequest  &reqRef,
         RespType doResp;
         aP->BindRequest(reqRef);
 
+        // In the load-test mode the request is a TaskMsg for a mock worker.
+        //
+        auto workers = getWorkers();
+        if (workers != nullptr) {
+            int reqLen;
+            const char *reqData = r->GetRequest(reqLen);
+            proto::TaskMsg msg;
+            bool const parsed = reqData != nullptr && msg.ParseFromArray(reqData, reqLen);
+            if (reqLen != 0) r->ReleaseRequestBuffer();
+            reqCount++;
+            if (!parsed) {
+                LOGS_DEBUG("Bad TaskMsg from req #" << reqNum);
+                _aOK = false;
+                std::thread (&Agent::Reply, aP, RESP_BADREQ).detach();
+                return;
+            }
+            loadRequests++;
+            workers->submit(aP, msg);
+            return;
+        }
+
         // Get the request data and setup to handle request. Make sure the
         // request string is null terminated (it should be).
         //
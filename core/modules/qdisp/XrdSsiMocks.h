@@ -26,6 +26,11 @@
 #ifndef LSST_QSERV_QDISP_XRDSSIMOCKS_H
 #define LSST_QSERV_QDISP_XRDSSIMOCKS_H
 
+// System headers
+#include <cstdint>
+#include <memory>
+#include <string>
+
 // External headers
 #include "XrdSsi/XrdSsiRequest.hh"
 #include "XrdSsi/XrdSsiResource.hh"
@@ -44,6 +49,29 @@ class Executive;
 class XrdSsiServiceMock : public XrdSsiService
 {
 public:
+    /// Parameters of the load-test mode, in which the mock stands for many
+    /// workers answering the TaskMsg requests of real jobs with result
+    /// streams, see setLoad().
+    struct Load {
+        int workers{1000};             ///< Chunks are spread over the workers by chunk id.
+        int slotsPerWorker{8};         ///< Requests a worker runs at once, the others wait.
+        double latencyMs{50};          ///< Mean of the exponential time a worker takes for a request.
+        unsigned int resultRows{1000}; ///< Rows sent for each request.
+        unsigned int rowsPerMsg{1000}; ///< Rows in each Result message.
+        unsigned int rowBytes{32};     ///< Width of the string column of the rows.
+        double failRate{0};            ///< Fraction of the requests answered with a retryable error.
+        unsigned int seed{1};
+        int responderThreads{8};       ///< Threads sending the responses of all the workers.
+    };
+
+    /// Counts of the load-test mode since the last Reset().
+    struct LoadStats {
+        uint64_t requests{0};
+        uint64_t failures{0};  ///< Requests answered with an error.
+        uint64_t responses{0}; ///< Result streams read to the end by the czar.
+        uint64_t bytes{0};     ///< Bytes of the result streams read.
+    };
+
     void ProcessRequest(XrdSsiRequest &reqRef, XrdSsiResource &resRef) override;
 
     XrdSsiServiceMock(Executive *executive) {};
@@ -66,6 +94,12 @@ public:
 
     static void setRName(std::string const& rname) {_myRName = rname;}
 
+    /// Answer all requests as the mock workers of 'load' would, or as the
+    /// request strings of testQDisp ask when it is null.
+    static void setLoad(std::shared_ptr<Load const> const& load);
+
+    static LoadStats getLoadStats();
+
 private:
     static std::string _myRName;
 };
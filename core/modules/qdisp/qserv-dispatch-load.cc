@@ -0,0 +1,452 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/// qserv-dispatch-load.cc drives the czar dispatch path with thousands of
+/// jobs answered by the load-test mode of XrdSsiServiceMock, which stands for
+/// many workers with a given response latency, result size and failure rate.
+/// The jobs go through a real QdispPool and Executive, and their results
+/// through MergingHandler into an InfileMerger on a local MySQL with MERGE,
+/// or are only decoded with DISPATCH. It reports the dispatch and completion
+/// rates, the context switches of the process and the time spent in
+/// Executive::add() as measures of lock contention, and the memory used for
+/// each job in flight.
+
+// System header
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include <unistd.h>
+
+// Qserv headers
+#include "ccontrol/MergingHandler.h"
+#include "global/constants.h"
+#include "global/MsgReceiver.h"
+#include "global/ResourceUnit.h"
+#include "mysql/MySqlConfig.h"
+#include "proto/ProtoHeaderWrap.h"
+#include "proto/ProtoImporter.h"
+#include "proto/WorkerResponse.h"
+#include "proto/worker.pb.h"
+#include "qdisp/Executive.h"
+#include "qdisp/JobDescription.h"
+#include "qdisp/MessageStore.h"
+#include "qdisp/QdispPool.h"
+#include "qdisp/ResponseHandler.h"
+#include "qdisp/XrdSsiMocks.h"
+#include "qproc/ChunkQuerySpec.h"
+#include "qproc/TaskMsgFactory.h"
+#include "rproc/InfileMerger.h"
+#include "sql/SqlConnection.h"
+#include "sql/SqlErrorObject.h"
+#include "util/CmdLineParser.h"
+#include "util/Timer.h"
+
+namespace global   = lsst::qserv;
+namespace ccontrol = lsst::qserv::ccontrol;
+namespace mysql    = lsst::qserv::mysql;
+namespace proto    = lsst::qserv::proto;
+namespace qdisp    = lsst::qserv::qdisp;
+namespace qproc    = lsst::qserv::qproc;
+namespace rproc    = lsst::qserv::rproc;
+namespace sql      = lsst::qserv::sql;
+namespace util     = lsst::qserv::util;
+
+namespace {
+
+// Command line parameters
+
+std::string  operation;
+unsigned int numJobs;
+unsigned int workers;
+unsigned int slots;
+double       latencyMs;
+unsigned int rowsPerJob;
+unsigned int rowsPerMsg;
+unsigned int rowBytes;
+double       failRate;
+unsigned int responders;
+unsigned int seed;
+bool         interactive;
+std::string  user;
+std::string  password;
+std::string  socketFile;
+std::string  db;
+std::string  jsonFileName;
+
+
+/// Decodes the result streams of the workers the way MergingHandler does,
+/// header after header, without merging the rows.
+class CountingHandler : public qdisp::ResponseHandler {
+public:
+    CountingHandler() { _buffer.resize(proto::ProtoHeaderWrap::PROTO_HEADER_SIZE); }
+
+    std::vector<char>& nextBuffer() override { return _buffer; }
+    size_t nextBufferSize() override { return _buffer.size(); }
+
+    bool flush(int bLen, bool& last, bool& largeResult) override {
+        if (bLen != static_cast<int>(_buffer.size())) {
+            _error = Error(-1, "size mismatch: expected " + std::to_string(_buffer.size())
+                           + " got " + std::to_string(bLen));
+            return false;
+        }
+        auto response = std::make_shared<proto::WorkerResponse>();
+        if (_header) {
+            response->headerSize = static_cast<unsigned char>(_buffer[0]);
+            if (not proto::ProtoHeaderWrap::unwrap(response, _buffer)) {
+                _error = Error(-1, "Error decoding proto header");
+                return false;
+            }
+            largeResult = response->protoHeader.largeresult();
+            _buffer.resize(response->protoHeader.size());
+            _header = false;
+            return true;
+        }
+        if (not proto::ProtoImporter<proto::Result>::setMsgFrom(response->result, _buffer.data(),
+                                                                 _buffer.size())) {
+            _error = Error(-1, "Error decoding result message");
+            return false;
+        }
+        largeResult = response->result.largeresult();
+        if (response->result.continues()) {
+            _buffer.resize(proto::ProtoHeaderWrap::PROTO_HEADER_SIZE);
+            _header = true;
+        } else {
+            _buffer.clear();
+            last = true;
+            _finished = true;
+        }
+        return true;
+    }
+
+    bool flushMayBlock() const override { return false; }
+    void errorFlush(std::string const& msg, int code) override { _error = Error(code, msg); }
+    bool finished() const override { return _finished; }
+
+    bool reset() override {
+        _buffer.resize(proto::ProtoHeaderWrap::PROTO_HEADER_SIZE);
+        _header = true;
+        _finished = false;
+        return true;
+    }
+
+    std::ostream& print(std::ostream& os) const override { return os << "CountingHandler"; }
+    Error getError() const override { return _error; }
+    void prepScrubResults(int jobId, int attempt) override {}
+
+private:
+    std::vector<char> _buffer;
+    bool _header{true};
+    bool _finished{false};
+    Error _error;
+};
+
+
+class ErrorReceiver : public global::MsgReceiver {
+public:
+    void operator()(int code, std::string const& msg) override {
+        std::cerr << "error: code=" << code << " " << msg << std::endl;
+    }
+};
+
+
+/// @return the resident memory of the process in bytes.
+uint64_t residentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size = 0, resident = 0;
+    statm >> size >> resident;
+    return resident * ::sysconf(_SC_PAGESIZE);
+}
+
+
+/// Samples the memory of the process and the jobs in flight while the
+/// jobs run, and notes when the mock workers have seen every job.
+class Sampler {
+public:
+    Sampler(qdisp::Executive::Ptr const& executive, uint64_t baseBytes)
+        : _executive(executive), _baseBytes(baseBytes), _thread(&Sampler::_run, this) {}
+
+    ~Sampler() { stop(); }
+
+    void stop() {
+        _stop = true;
+        if (_thread.joinable()) _thread.join();
+    }
+
+    double dispatchSeconds{0}; ///< Until every job reached a mock worker.
+    int maxInFlight{0};
+    uint64_t maxBytes{0};      ///< Largest memory above the base.
+    double bytesPerJob{0};     ///< Largest memory above the base for each job in flight.
+
+private:
+    void _run() {
+        util::Timer timer;
+        timer.start();
+        while (not _stop) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            timer.stop();
+            if (dispatchSeconds == 0 and qdisp::XrdSsiServiceMock::getLoadStats().requests >= ::numJobs) {
+                dispatchSeconds = timer.getElapsed();
+            }
+            int const inFlight = _executive->getNumInflight();
+            uint64_t const rss = residentBytes();
+            uint64_t const bytes = rss > _baseBytes ? rss - _baseBytes : 0;
+            maxInFlight = std::max(maxInFlight, inFlight);
+            maxBytes = std::max(maxBytes, bytes);
+            if (inFlight > 0) bytesPerJob = std::max(bytesPerJob, static_cast<double>(bytes) / inFlight);
+        }
+    }
+
+    qdisp::Executive::Ptr _executive;
+    uint64_t _baseBytes;
+    std::atomic<bool> _stop{false};
+    std::thread _thread;
+};
+
+
+void writeReport(double dispatchSeconds, double totalSeconds, bool success, Sampler const& sampler,
+                 qdisp::XrdSsiServiceMock::LoadStats const& stats, long switches, long preemptions,
+                 int addJobUs, int trackUs) {
+    double const dispatchRate = dispatchSeconds > 0 ? ::numJobs / dispatchSeconds : 0;
+    double const completionRate = totalSeconds > 0 ? ::numJobs / totalSeconds : 0;
+    double const mbPerSec = totalSeconds > 0 ? stats.bytes / totalSeconds / 1e6 : 0;
+    std::cout << std::fixed << std::setprecision(3)
+              << "jobs                    " << ::numJobs << (success ? "" : " (failed)") << "\n"
+              << "requests                " << stats.requests << " (" << stats.failures << " failed)\n"
+              << "dispatch seconds        " << dispatchSeconds << "\n"
+              << "completion seconds      " << totalSeconds << "\n"
+              << std::setprecision(1)
+              << "dispatch jobs/s         " << dispatchRate << "\n"
+              << "completion jobs/s       " << completionRate << "\n"
+              << "result MB/s             " << mbPerSec << "\n"
+              << "context switches/job    " << static_cast<double>(switches) / ::numJobs
+              << " voluntary, " << static_cast<double>(preemptions) / ::numJobs << " involuntary\n"
+              << "Executive::add us/job   " << static_cast<double>(addJobUs) / ::numJobs
+              << " (tracking " << static_cast<double>(trackUs) / ::numJobs << ")\n"
+              << "max jobs in flight      " << sampler.maxInFlight << "\n"
+              << "max memory MB           " << sampler.maxBytes / 1e6 << "\n"
+              << "memory KB/job in flight " << sampler.bytesPerJob / 1e3 << std::endl;
+    if (::jsonFileName.empty()) return;
+    std::ofstream file(::jsonFileName);
+    file << "{\"operation\":\"" << ::operation << "\",\"jobs\":" << ::numJobs
+         << ",\"workers\":" << ::workers << ",\"slots\":" << ::slots << ",\"latency_ms\":" << ::latencyMs
+         << ",\"rows\":" << ::rowsPerJob << ",\"rows_per_msg\":" << ::rowsPerMsg
+         << ",\"row_bytes\":" << ::rowBytes << ",\"fail_rate\":" << ::failRate
+         << ",\"success\":" << (success ? "true" : "false")
+         << ",\"requests\":" << stats.requests << ",\"failures\":" << stats.failures
+         << ",\"bytes\":" << stats.bytes
+         << ",\"dispatch_seconds\":" << dispatchSeconds << ",\"completion_seconds\":" << totalSeconds
+         << ",\"dispatch_jobs_per_sec\":" << dispatchRate << ",\"completion_jobs_per_sec\":" << completionRate
+         << ",\"voluntary_switches\":" << switches << ",\"involuntary_switches\":" << preemptions
+         << ",\"add_job_us\":" << addJobUs << ",\"track_us\":" << trackUs
+         << ",\"max_in_flight\":" << sampler.maxInFlight << ",\"max_bytes\":" << sampler.maxBytes
+         << ",\"bytes_per_job_in_flight\":" << sampler.bytesPerJob << "}" << std::endl;
+}
+
+
+int run() {
+    auto load = std::make_shared<qdisp::XrdSsiServiceMock::Load>();
+    load->workers = ::workers;
+    load->slotsPerWorker = ::slots;
+    load->latencyMs = ::latencyMs;
+    load->resultRows = ::rowsPerJob;
+    load->rowsPerMsg = ::rowsPerMsg;
+    load->rowBytes = ::rowBytes;
+    load->failRate = ::failRate;
+    load->seed = ::seed;
+    load->responderThreads = ::responders;
+    qdisp::XrdSsiServiceMock::Reset();
+    qdisp::XrdSsiServiceMock::setLoad(load);
+
+    std::shared_ptr<rproc::InfileMerger> merger;
+    rproc::InfileMergerConfig mergerConfig(mysql::MySqlConfig(::user, ::password, ::socketFile, ::db));
+    if (::operation == "MERGE") {
+        mergerConfig.targetTable = ::db + ".dispatch_load_" + std::to_string(::getpid());
+        merger = std::make_shared<rproc::InfileMerger>(mergerConfig);
+    }
+
+    auto qdispPool = std::make_shared<qdisp::QdispPool>();
+    qdisp::Executive::Config exConfig(qdisp::Executive::Config::getMockStr(), 0);
+    auto executive = qdisp::Executive::create(exConfig, std::make_shared<qdisp::MessageStore>(),
+                                              qdispPool, nullptr);
+    executive->setQueryId(1);
+    auto receiver = std::make_shared<ErrorReceiver>();
+    auto taskMsgFactory = std::make_shared<qproc::TaskMsgFactory>(1, 1);
+    auto taggedQueries = std::make_shared<std::vector<std::string> const>(std::vector<std::string>{
+        std::string("SELECT objectId,ra_PS,decl_PS FROM LoadTest.Object_") + global::CHUNK_TAG
+        + " WHERE ra_PS BETWEEN 0 AND 10"});
+
+    struct rusage before, after;
+    ::getrusage(RUSAGE_SELF, &before);
+    Sampler sampler(executive, residentBytes());
+    util::Timer timer;
+    timer.start();
+    for (unsigned int jobId = 0; jobId < ::numJobs; ++jobId) {
+        auto funcBuildJob = [&, jobId](util::CmdData*) {
+            int const chunkId = jobId + 1;
+            auto cs = std::make_shared<qproc::ChunkQuerySpec>("LoadTest", chunkId, proto::ScanInfo(),
+                                                              ::interactive);
+            cs->taggedQueries = taggedQueries;
+            std::string const chunkResultName = "r_1_" + std::to_string(chunkId);
+            std::shared_ptr<qdisp::ResponseHandler> handler;
+            if (merger != nullptr) {
+                handler = std::make_shared<ccontrol::MergingHandler>(receiver, merger, chunkResultName);
+            } else {
+                handler = std::make_shared<CountingHandler>();
+            }
+            global::ResourceUnit ru;
+            ru.setAsDbChunk(cs->db, chunkId);
+            executive->add(qdisp::JobDescription::create(executive->getId(), jobId, ru, handler,
+                                                         taskMsgFactory, cs, chunkResultName));
+        };
+        executive->queueJobStart(std::make_shared<qdisp::PriorityCommand>(funcBuildJob), ::interactive);
+    }
+    executive->waitForAllJobsToStart();
+    bool success = executive->join();
+    timer.stop();
+    ::getrusage(RUSAGE_SELF, &after);
+    sampler.stop();
+    double const dispatchSeconds = sampler.dispatchSeconds > 0 ? sampler.dispatchSeconds : timer.getElapsed();
+
+    if (merger != nullptr) {
+        if (success and not merger->finalize()) {
+            std::cerr << "error: finalize " << merger->getError().getMsg() << std::endl;
+            success = false;
+        }
+        sql::SqlConnection conn(mergerConfig.mySqlConfig);
+        sql::SqlErrorObject errObj;
+        if (not conn.dropTable(merger->getTargetTable(), errObj, false)) {
+            std::cerr << "error: failed to drop " << merger->getTargetTable() << ": "
+                      << errObj.errMsg() << std::endl;
+        }
+    }
+
+    int addJobUs, trackUs;
+    {
+        std::lock_guard<std::mutex> lock(executive->sumMtx);
+        addJobUs = executive->cancelLockQSEASum + executive->addJobQSEASum + executive->trackQSEASum
+                   + executive->endQSEASum;
+        trackUs = executive->trackQSEASum;
+    }
+    writeReport(dispatchSeconds, timer.getElapsed(), success, sampler,
+                qdisp::XrdSsiServiceMock::getLoadStats(),
+                after.ru_nvcsw - before.ru_nvcsw, after.ru_nivcsw - before.ru_nivcsw, addJobUs, trackUs);
+
+    executive.reset();
+    qdisp::XrdSsiServiceMock::setLoad(nullptr);
+    qdispPool->shutdownPool();
+    return success ? 0 : 1;
+}
+} // namespace
+
+int main(int argc, const char* const argv[]) {
+
+    // Verify that the version of the library that we linked against is
+    // compatible with the version of the headers we compiled against.
+
+    GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+    // Parse command line parameters
+    try {
+        util::CmdLineParser parser(
+            argc,
+            argv,
+            "\n"
+            "Usage:\n"
+            "  DISPATCH\n"
+            "  MERGE\n"
+            "  [--jobs=<value>]\n"
+            "  [--workers=<value>]\n"
+            "  [--slots=<value>]\n"
+            "  [--latency-ms=<value>]\n"
+            "  [--rows=<value>]\n"
+            "  [--rows-per-msg=<value>]\n"
+            "  [--row-bytes=<value>]\n"
+            "  [--fail-rate=<value>]\n"
+            "  [--responders=<value>]\n"
+            "  [--seed=<value>]\n"
+            "  [--interactive]\n"
+            "  [--user=<name>]\n"
+            "  [--password=<value>]\n"
+            "  [--socket=<file>]\n"
+            "  [--db=<name>]\n"
+            "  [--json=<file>]\n"
+            "\n"
+            "Flags an options:\n"
+            "  --jobs=<value>         - jobs (chunks) of the query (default: 10000)\n"
+            "  --workers=<value>      - mock workers the chunks are spread over (default: 1000)\n"
+            "  --slots=<value>        - requests each worker runs at once (default: 8)\n"
+            "  --latency-ms=<value>   - mean time a worker takes for a request, exponentially\n"
+            "                           distributed (default: 50)\n"
+            "  --rows=<value>         - rows sent for each job (default: 1000)\n"
+            "  --rows-per-msg=<value> - rows in each Result message (default: 1000)\n"
+            "  --row-bytes=<value>    - width of the string column of the rows (default: 32)\n"
+            "  --fail-rate=<value>    - fraction of the requests answered with an error, the\n"
+            "                           jobs are retried (default: 0)\n"
+            "  --responders=<value>   - threads sending the responses of the workers (default: 8)\n"
+            "  --seed=<value>         - seed of the latencies and failures (default: 1)\n"
+            "  --interactive          - dispatch the jobs as an interactive query\n"
+            "  --user=<name>          - MERGE: MySQL user (default: qsmaster)\n"
+            "  --password=<value>     - MERGE: MySQL password (default: none)\n"
+            "  --socket=<file>        - MERGE: MySQL socket (default: /qserv/data/mysql/mysql.sock)\n"
+            "  --db=<name>            - MERGE: database of the result table (default: qservResult)\n"
+            "  --json=<file>          - also write the results to the file as JSON\n"
+            "\n"
+            "Operations:\n"
+            "  DISPATCH  - decode the results without merging them\n"
+            "  MERGE     - merge the results into MySQL with LOAD DATA INFILE\n");
+
+        ::operation = parser.parameterRestrictedBy(1, {"DISPATCH", "MERGE"});
+
+        ::numJobs     = std::max(1U, parser.option<unsigned int>("jobs", 10000));
+        ::workers     = std::max(1U, parser.option<unsigned int>("workers", 1000));
+        ::slots       = std::max(1U, parser.option<unsigned int>("slots", 8));
+        ::latencyMs   = std::stod(parser.option<std::string>("latency-ms", "50"));
+        ::rowsPerJob  = parser.option<unsigned int>("rows", 1000);
+        ::rowsPerMsg  = std::max(1U, parser.option<unsigned int>("rows-per-msg", 1000));
+        ::rowBytes    = parser.option<unsigned int>("row-bytes", 32);
+        ::failRate    = std::stod(parser.option<std::string>("fail-rate", "0"));
+        ::responders  = std::max(1U, parser.option<unsigned int>("responders", 8));
+        ::seed        = parser.option<unsigned int>("seed", 1);
+        ::interactive = parser.flag("interactive");
+        ::user        = parser.option<std::string>("user", "qsmaster");
+        ::password    = parser.option<std::string>("password", "");
+        ::socketFile  = parser.option<std::string>("socket", "/qserv/data/mysql/mysql.sock");
+        ::db          = parser.option<std::string>("db", "qservResult");
+
+        ::jsonFileName = parser.option<std::string>("json", "");
+
+    } catch (std::exception const& ex) {
+        return 1;
+    }
+    return ::run();
+}
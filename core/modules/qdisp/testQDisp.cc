@@ -40,6 +40,9 @@
 #include "qdisp/JobQuery.h"
 #include "qdisp/MessageStore.h"
 #include "qdisp/QueryRequest.h"
+#include "qdisp/ReplicaSelector.h"
+#include "qdisp/ScanCursors.h"
+#include "qdisp/WorkerSessions.h"
 #include "qdisp/XrdSsiMocks.h"
 #include "qproc/ChunkQuerySpec.h"
 #include "qproc/TaskMsgFactory.h"
@@ -386,6 +389,127 @@ BOOST_AUTO_TEST_CASE(ExecutiveCancel) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(PriQAdaptiveLimit) {
+    qdisp::PriorityQueue::PriQ que(0, 2, 10);
+    int const window = qdisp::PriorityQueue::PriQ::adjustWindow;
+    BOOST_CHECK(que.getLimit() == 10);
+
+    // Steady run times set the baseline and leave the limit alone.
+    for (int j = 0; j < window; ++j) que.recordRunTime(10.0);
+    BOOST_CHECK(que.getLimit() == 10);
+
+    // Run times well above the baseline cut the limit, down to minRunning.
+    for (int j = 0; j < 20*window; ++j) que.recordRunTime(100.0);
+    BOOST_CHECK(que.getLimit() == 2);
+
+    // Fast again with commands waiting and all threads busy, the limit grows by one per window.
+    que.queCmd(std::make_shared<qdisp::PriorityCommand>());
+    que.running = 2;
+    for (int j = 0; j < 40*window && que.getLimit() == 2; ++j) que.recordRunTime(10.0);
+    BOOST_CHECK(que.getLimit() == 3);
+    que.running = 1; // with the finished command, 2 of 3 threads were busy.
+    for (int j = 0; j < window; ++j) que.recordRunTime(10.0);
+    BOOST_CHECK(que.getLimit() == 3); // running is no longer at the limit.
+    que.running = 10;
+    for (int j = 0; j < 20*window; ++j) que.recordRunTime(10.0);
+    BOOST_CHECK(que.getLimit() == 10);
+}
+
+BOOST_AUTO_TEST_CASE(ScanCursorOrder) {
+    qdisp::ScanCursors cursors;
+    std::vector<int> chunkIds = {10, 20, 30, 40, 50};
+    // Nothing known, the order is kept.
+    std::vector<size_t> expected = {0, 1, 2, 3, 4};
+    BOOST_CHECK(cursors.order(chunkIds) == expected);
+
+    // Start after the chunk being scanned, which comes last.
+    cursors.update("w1", 20, 30);
+    expected = {3, 4, 0, 1, 2};
+    BOOST_CHECK(cursors.order(chunkIds) == expected);
+
+    // Chunks of another worker follow its own scan.
+    cursors.update("w1", 30, -1);
+    cursors.update("w1", 40, -1);
+    cursors.update("w2", 10, 5);
+    cursors.update("w2", 50, 5);
+    expected = {0, 3, 1, 4, 2};
+    BOOST_CHECK(cursors.order(chunkIds) == expected);
+}
+
+BOOST_AUTO_TEST_CASE(ReplicaSelect) {
+    int loads = 0;
+    std::string version = "1";
+    auto load = [&loads](std::string const& db) {
+        ++loads;
+        qdisp::ReplicaSelector::Replicas replicas;
+        if (db == "LSST") {
+            replicas[10] = {"w1", "w2"};
+            replicas[11] = {"w1"};
+        }
+        return replicas;
+    };
+    qdisp::ReplicaSelector selector(load, [&version]() { return version; },
+                                    std::chrono::milliseconds(0));
+    std::set<std::string> const none;
+
+    // No choice, the redirector picks the worker.
+    BOOST_CHECK_EQUAL(selector.select("LSST", 11, none), "");
+    BOOST_CHECK_EQUAL(selector.select("LSST", 12, none), "");
+    BOOST_CHECK_EQUAL(selector.select("Other", 10, none), "");
+    BOOST_CHECK_EQUAL(loads, 2);
+
+    // Jobs spread over the replicas, then go to the faster one.
+    BOOST_CHECK_EQUAL(selector.select("LSST", 10, none), "w1");
+    BOOST_CHECK_EQUAL(selector.select("LSST", 10, none), "w2");
+    selector.jobFinished("w1", std::chrono::milliseconds(100), true);
+    selector.jobFinished("w2", std::chrono::milliseconds(1000), true);
+    BOOST_CHECK_EQUAL(selector.select("LSST", 10, none), "w1");
+    BOOST_CHECK_EQUAL(selector.select("LSST", 10, none), "w1");
+    auto loadsByWorker = selector.getLoads();
+    BOOST_CHECK_EQUAL(loadsByWorker["w1"].inFlight, 2);
+    BOOST_CHECK_EQUAL(loadsByWorker["w2"].inFlight, 0);
+    BOOST_CHECK_EQUAL(loadsByWorker["w1"].selected, 3u);
+
+    // A retry avoids the worker the job failed on, even with one replica left.
+    BOOST_CHECK_EQUAL(selector.select("LSST", 10, {"w1"}), "w2");
+    BOOST_CHECK_EQUAL(selector.select("LSST", 11, {"w1"}), "");
+
+    // The replicas are read again once the version changes.
+    BOOST_CHECK_EQUAL(loads, 2);
+    version = "2";
+    selector.select("LSST", 11, none);
+    BOOST_CHECK_EQUAL(loads, 3);
+}
+
+BOOST_AUTO_TEST_CASE(WorkerSessionPings) {
+    std::vector<std::string> workers = {"w1", "w2"};
+    std::string version = "1";
+    std::vector<std::string> pinged;
+    qdisp::WorkerSessions sessions([&workers]() { return workers; }, [&version]() { return version; },
+                                   [&pinged](std::string const& w) { pinged.push_back(w); },
+                                   std::chrono::seconds(60));
+    auto const t0 = std::chrono::steady_clock::now();
+
+    // Every worker is warmed up first, then pinged once idle for a minute.
+    BOOST_CHECK_EQUAL(sessions.check(t0), 2);
+    BOOST_CHECK(pinged == std::vector<std::string>({"w1", "w2"}));
+    BOOST_CHECK_EQUAL(sessions.check(t0 + std::chrono::seconds(30)), 0);
+    sessions.used("w1");
+    pinged.clear();
+    BOOST_CHECK_EQUAL(sessions.check(t0 + std::chrono::seconds(60)), 1);
+    BOOST_CHECK(pinged == std::vector<std::string>({"w2"}));
+
+    // A new worker is warmed up once the version changes.
+    workers = {"w2", "w3"};
+    sessions.check(t0 + std::chrono::seconds(61));
+    BOOST_CHECK(sessions.getWorkers() == std::vector<std::string>({"w1", "w2"}));
+    version = "2";
+    pinged.clear();
+    BOOST_CHECK_EQUAL(sessions.check(t0 + std::chrono::seconds(62)), 1);
+    BOOST_CHECK(pinged == std::vector<std::string>({"w3"}));
+    BOOST_CHECK(sessions.getWorkers() == workers);
+}
+
 BOOST_AUTO_TEST_CASE(ServiceMock) {
     // Verify that our service object did not see anything unusual.
     BOOST_CHECK(qdisp::XrdSsiServiceMock::isAOK());
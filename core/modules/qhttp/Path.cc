@@ -47,6 +47,9 @@ std::string escapeGroup(std::string const& str)
     return regex_replace(str, escapeRe, R"(\1)");
 }
 
+// Characters which would make a literal path element act as a regexp in the matcher.
+char const* const regexChars = ".[]{}()*+?|^$\\";
+
 struct PathToken
 {
     std::string name;
@@ -57,6 +60,62 @@ struct PathToken
     std::string pattern;
 };
 
+//----- Break a parsed pattern down into whole path elements, each a literal or a plain ":name" parameter.
+//      Anything else (custom or unnamed captures, modifiers, escapes, regexp characters in literals,
+//      empty elements or a trailing slash) leaves the pattern to be matched by its regexp only.
+
+bool splitElements(std::vector<boost::variant<PathToken, std::string>> const& tokens, bool anyEscaped,
+                   std::vector<lsst::qserv::qhttp::Path::Element>& elements)
+{
+    if (anyEscaped) return false;
+
+    // Parameters are marked by a character which cannot appear in a literal pattern element.
+    static char const paramMark = '\0';
+    static std::string const defaultPattern = escapeGroup("[^/]+?");
+    std::string flat;
+    std::vector<std::string> names;
+    for(auto& token: tokens) {
+        if (token.type() == typeid(std::string)) {
+            auto& literal = boost::get<std::string>(token);
+            if (literal.find_first_of(regexChars) != std::string::npos) return false;
+            flat += literal;
+        } else {
+            auto& param = boost::get<PathToken>(token);
+            if (param.prefix != "/" || param.optional || param.repeat || param.pattern != defaultPattern) {
+                return false;
+            }
+            flat += '/';
+            flat += paramMark;
+            names.push_back(param.name);
+        }
+    }
+    if (flat.empty() || flat[0] != '/') return false;
+    if (flat == "/") return true;
+    if (flat.back() == '/') return false;
+
+    auto name = names.begin();
+    size_t begin = 1;
+    while (begin <= flat.size()) {
+        size_t end = flat.find('/', begin);
+        if (end == std::string::npos) end = flat.size();
+        std::string element = flat.substr(begin, end - begin);
+        if (element.empty()) {
+            elements.clear();
+            return false;
+        }
+        if (element.size() == 1 && element[0] == paramMark) {
+            elements.push_back({*name++, true});
+        } else if (element.find(paramMark) != std::string::npos) {
+            elements.clear();
+            return false;
+        } else {
+            elements.push_back({element, false});
+        }
+        begin = end + 1;
+    }
+    return true;
+}
+
 } // anon. namespace
 
 namespace lsst {
@@ -86,6 +145,7 @@ void Path::parse(std::string const& pattern)
     int key = 0;
     std::string path;
     std::vector<boost::variant<PathToken, std::string>> segments;
+    bool anyEscaped = false;
 
     auto end = boost::sregex_iterator{};
     auto last = pattern.begin();
@@ -105,6 +165,7 @@ void Path::parse(std::string const& pattern)
 
         // Handle explicitly escaped characters
         if (escaped.matched) {
+            anyEscaped = true;
 
             // If we let intra-element literal slashes into the path matcher, they would be ambiguous with
             // path element delimiters, which are also represented as literal slashes in the matcher.
@@ -155,6 +216,9 @@ void Path::parse(std::string const& pattern)
         segments.push_back(path);
     }
 
+    elements.clear();
+    elementsOnly = splitElements(segments, anyEscaped, elements);
+
     std::string route = "^";
     for(auto& segment: segments) {
         if (segment.type() == typeid(std::string)) {
@@ -184,7 +248,8 @@ void Path::parse(std::string const& pattern)
 }
 
 
-void Path::updateParamsFromMatch(Request::Ptr const& request, boost::smatch const& pathMatch)
+
+void Path::updateParamsFromMatch(Request::Ptr const& request, boost::smatch const& pathMatch) const
 {
     for(size_t i=0; i<paramNames.size(); ++i) {
         request->params[paramNames[i]] = pathMatch[i+1];
@@ -43,17 +43,28 @@ namespace qhttp {
 //      against the compiled regexp.  The internals of this are a fairly straight port of path-to-regexp
 //      (https://github.com/pillarjs/path-to-regexp), as used by express.js; see that link for
 //      examples of supported path syntax.
+//
+//      Patterns made only of literal path elements and plain ":name" elements (the bulk of REST routes)
+//      are also broken down into elements, which the Router matches without running the regexp.
 
 class Path
 {
 public:
 
+    struct Element {
+        std::string text;   // literal path element, or parameter name if param is true
+        bool param;
+    };
+
     void parse(const std::string &pattern);
-    void updateParamsFromMatch(Request::Ptr const& request, boost::smatch const& pathMatch);
+    void updateParamsFromMatch(Request::Ptr const& request, boost::smatch const& pathMatch) const;
 
     boost::regex regex;
     std::vector<std::string> paramNames;
 
+    bool elementsOnly = false;      // true if the pattern is fully described by elements
+    std::vector<Element> elements;
+
 };
 
 }}} // namespace lsst::qserv::qhttp
@@ -24,11 +24,15 @@
 #include "qhttp/Response.h"
 
 // System headers
+#include <cerrno>
+#include <fcntl.h>
 #include <map>
 #include <memory>
 #include <string>
 #include <sstream>
 #include <string>
+#include <sys/sendfile.h>
+#include <unistd.h>
 
 // Third-party headers
 #include "boost/asio.hpp"
@@ -86,6 +90,8 @@ std::unordered_map<std::string, const std::string> contentTypesByExtension = {
 
 } // anon namespace
 
+#define SENDFILE_MIN_BYTES (64*1024)
+
 
 namespace lsst {
 namespace qserv {
@@ -125,7 +131,7 @@ void Response::send(std::string const& content, std::string const& contentType)
     responseStream << _headers() << "\r\n" << content;
 
     auto self = shared_from_this();
-    asio::async_write(*_socket, _responsebuf,
+    _write(
         [self](boost::system::error_code const& ec, std::size_t sent) {
             if (self->_doneCallback) {
                 self->_doneCallback(ec, sent);
@@ -135,24 +141,54 @@ void Response::send(std::string const& content, std::string const& contentType)
 }
 
 
-void Response::sendFile(fs::path const& path)
+void Response::sendFile(fs::path const& path, std::string const& contentType)
 {
     if (!fs::exists(path)) {
         sendStatus(404);
         return;
     }
 
-    auto ct = contentTypesByExtension.find(path.extension().string());
-    headers["Content-Type"] = (ct != contentTypesByExtension.end()) ? ct->second : "text/plain";
+    headers["Content-Type"] = contentType.empty() ? contentTypeOf(path) : contentType;
+
+    auto const size = fs::file_size(path);
+    headers["Content-Length"] = std::to_string(size);
+
+    //----- Large files are written straight from the page cache to the socket with sendfile(2), once
+    //      the header is out.
+
+    if (size >= SENDFILE_MIN_BYTES) {
+        std::shared_ptr<int> fd(new int(::open(path.c_str(), O_RDONLY)), [](int* fd) {
+            if (*fd >= 0) ::close(*fd);
+            delete fd;
+        });
+        if (*fd < 0) {
+            sendStatus(404);
+            return;
+        }
+
+        std::ostream responseStream(&_responsebuf);
+        responseStream << _headers() << "\r\n";
+
+        auto self = shared_from_this();
+        _write(
+            [self, fd, size](boost::system::error_code const& ec, std::size_t sent) {
+                if (!ec) {
+                    self->_sendFileContent(fd, 0, size, sent);
+                } else if (self->_doneCallback) {
+                    self->_doneCallback(ec, sent);
+                }
+            }
+        );
+        return;
+    }
 
-    headers["Content-Length"] = std::to_string(fs::file_size(path));
     fs::ifstream responseFile(path);
 
     std::ostream responseStream(&_responsebuf);
     responseStream << _headers() << "\r\n" << responseFile.rdbuf();
 
     auto self = shared_from_this();
-    asio::async_write(*_socket, _responsebuf,
+    _write(
         [self](boost::system::error_code const& ec, std::size_t sent) {
             if (self->_doneCallback) {
                 self->_doneCallback(ec, sent);
@@ -162,6 +198,217 @@ void Response::sendFile(fs::path const& path)
 }
 
 
+void Response::_sendFileContent(std::shared_ptr<int> const& fd, off_t offset, off_t size, std::size_t sent)
+{
+    //----- Called on the asio::io_service.  The socket is made non-blocking so that sendfile returns
+    //      when the socket buffer is full, and the rest is sent once asio reports it writable again.
+
+    boost::system::error_code ec;
+    _socket->native_non_blocking(true, ec);
+    while (!ec && offset < size) {
+        ssize_t const bytes = ::sendfile(_socket->native_handle(), *fd, &offset, size - offset);
+        if (bytes > 0) {
+            sent += bytes;
+        } else if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            auto self = shared_from_this();
+            _socket->async_write_some(asio::null_buffers(),
+                [self, fd, offset, size, sent](boost::system::error_code const& ec, std::size_t) {
+                    if (!ec) {
+                        self->_sendFileContent(fd, offset, size, sent);
+                    } else if (self->_doneCallback) {
+                        self->_doneCallback(ec, sent);
+                    }
+                }
+            );
+            return;
+        } else if (bytes == 0) {
+            ec = asio::error::eof; // the file was truncated while being sent
+        } else if (errno != EINTR) {
+            ec = boost::system::error_code(errno, boost::system::system_category());
+        }
+    }
+    if (_doneCallback) {
+        _doneCallback(ec, sent);
+    }
+}
+
+
+std::string Response::contentTypeOf(fs::path const& path)
+{
+    auto ct = contentTypesByExtension.find(path.extension().string());
+    return (ct != contentTypesByExtension.end()) ? ct->second : "text/plain";
+}
+
+
+void Response::sendChunked(ChunkSource const& source, std::string const& contentType)
+{
+    headers["Content-Type"] = contentType;
+    headers["Transfer-Encoding"] = "chunked";
+    headers.erase("Content-Length");
+
+    std::ostream responseStream(&_responsebuf);
+    responseStream << _headers() << "\r\n";
+
+    _sendNextChunk(source);
+}
+
+
+void Response::_sendNextChunk(ChunkSource const& source)
+{
+    // Empty chunks are skipped, as a chunk of zero length ends the body.
+    std::string chunk;
+    bool more = source(chunk);
+    while (more && chunk.empty()) more = source(chunk);
+
+    std::ostream responseStream(&_responsebuf);
+    if (more) {
+        responseStream << std::hex << chunk.size() << std::dec << "\r\n" << chunk << "\r\n";
+    } else {
+        responseStream << "0\r\n\r\n";
+    }
+
+    auto self = shared_from_this();
+    _write(
+        [self, source, more](boost::system::error_code const& ec, std::size_t sent) {
+            if (!ec && more) {
+                if (self->_handlerService) {
+                    self->_handlerService->post([self, source]() { self->_sendNextChunk(source); });
+                } else {
+                    self->_sendNextChunk(source);
+                }
+            } else if (self->_doneCallback) {
+                self->_doneCallback(ec, sent);
+            }
+        }
+    );
+}
+
+
+void Response::startChunked(std::string const& contentType)
+{
+    headers["Content-Type"] = contentType;
+    headers["Transfer-Encoding"] = "chunked";
+    headers.erase("Content-Length");
+    _queueWrite(_headers() + "\r\n", nullptr, false);
+}
+
+
+void Response::writeChunk(std::string const& chunk, WriteCallback const& onWritten)
+{
+    // Empty chunks are skipped, as a chunk of zero length ends the body.
+    if (chunk.empty()) {
+        bool failed;
+        {
+            std::lock_guard<std::mutex> lock(_streamMutex);
+            failed = _streamFailed;
+        }
+        _callWritten(onWritten, !failed);
+        return;
+    }
+    std::ostringstream framed;
+    framed << std::hex << chunk.size() << "\r\n";
+    std::string data = framed.str();
+    data.reserve(data.size() + chunk.size() + 2);
+    data.append(chunk).append("\r\n");
+    _queueWrite(std::move(data), onWritten, false);
+}
+
+
+void Response::finishChunked()
+{
+    _queueWrite("0\r\n\r\n", nullptr, true);
+}
+
+
+void Response::_queueWrite(std::string&& data, WriteCallback const& onWritten, bool last)
+{
+    bool failed;
+    {
+        std::lock_guard<std::mutex> lock(_streamMutex);
+        failed = _streamFailed;
+        if (!failed) {
+            _streamQueue.push_back({std::move(data), onWritten, last});
+        }
+    }
+    // Outside of the lock for the callback, which may write the next chunk.
+    if (failed) {
+        _callWritten(onWritten, false);
+        return;
+    }
+    _writeQueued();
+}
+
+
+void Response::_writeQueued()
+{
+    QueuedWrite next;
+    {
+        std::lock_guard<std::mutex> lock(_streamMutex);
+        if (_streamWriting || _streamQueue.empty()) return;
+        _streamWriting = true;
+        next = std::move(_streamQueue.front());
+        _streamQueue.pop_front();
+    }
+
+    std::ostream responseStream(&_responsebuf);
+    responseStream << next.data;
+
+    auto self = shared_from_this();
+    auto onWritten = next.onWritten;
+    bool const last = next.last;
+    _write(
+        [self, onWritten, last](boost::system::error_code const& ec, std::size_t sent) {
+            std::deque<QueuedWrite> dropped;
+            {
+                std::lock_guard<std::mutex> lock(self->_streamMutex);
+                self->_streamWriting = false;
+                if (ec) {
+                    self->_streamFailed = true;
+                    dropped.swap(self->_streamQueue);
+                }
+            }
+            self->_callWritten(onWritten, !ec);
+            for(auto& write : dropped) {
+                self->_callWritten(write.onWritten, false);
+            }
+            if ((ec || last) && self->_doneCallback) {
+                self->_doneCallback(ec, sent);
+            } else if (!ec) {
+                self->_writeQueued();
+            }
+        }
+    );
+}
+
+
+void Response::_callWritten(WriteCallback const& onWritten, bool ok)
+{
+    if (!onWritten) return;
+    if (_handlerService) {
+        _handlerService->post([onWritten, ok]() { onWritten(ok); });
+    } else {
+        onWritten(ok);
+    }
+}
+
+
+void Response::_write(std::function<void(boost::system::error_code const&, std::size_t)> const& onWritten)
+{
+    //----- Socket operations are only started from the asio::io_service, as the socket may be closed
+    //      there (by a timeout or by Server::stop()) at any time.
+
+    auto self = shared_from_this();
+    auto write = [self, onWritten]() {
+        asio::async_write(*self->_socket, self->_responsebuf, onWritten);
+    };
+    if (_ioService) {
+        _ioService->post(write);
+    } else {
+        write();
+    }
+}
+
+
 std::string Response::_headers() const
 {
     std::ostringstream headerst;
@@ -24,9 +24,11 @@
 #define LSST_QSERV_QHTTP_RESPONSE_H
 
 // System headers
+#include <deque>
 #include <functional>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 
@@ -51,7 +53,34 @@ public:
 
     void send(std::string const& content, std::string const& contentType="text/html");
     void sendStatus(unsigned int status);
-    void sendFile(boost::filesystem::path const& path);
+    void sendFile(boost::filesystem::path const& path, std::string const& contentType=std::string());
+
+    //----- contentTypeOf() returns the Content-Type sendFile would infer for a path (text/plain for
+    //      unknown extensions).  Files of 64 KB or more are sent by sendFile with sendfile(2), without
+    //      being read into memory.
+
+    static std::string contentTypeOf(boost::filesystem::path const& path);
+
+    //----- sendChunked sends a body of unknown length with the chunked transfer encoding.  The source
+    //      is called for each chunk in turn, after the previous one has been written, so the whole body
+    //      need not be held in memory; it returns false (leaving the chunk unused) when the body is
+    //      complete.
+
+    using ChunkSource = std::function<bool(std::string& chunk)>;
+    void sendChunked(ChunkSource const& source, std::string const& contentType="text/html");
+
+    //----- startChunked, writeChunk and finishChunked send a chunked body pushed by the handler instead, for
+    //      handlers which produce it as it becomes available.  startChunked sends the headers, writeChunk
+    //      queues one chunk, and finishChunked ends the body once the queued chunks are sent.  The
+    //      callback given to writeChunk is called once its chunk has been written to the client (with
+    //      false if the connection failed, in which case later chunks are discarded); waiting for it
+    //      before writing the next chunk keeps the memory used by a response to one chunk.  Callbacks
+    //      of blocking handlers are called on the handler pool.  These may be called from any thread.
+
+    using WriteCallback = std::function<void(bool ok)>;
+    void startChunked(std::string const& contentType="text/html");
+    void writeChunk(std::string const& chunk, WriteCallback const& onWritten=nullptr);
+    void finishChunked();
 
     //----- Response status code and additional headers may also be set with these members, and will be
     //      included/observed by the send methods above (sendStatus and sendFile will override status set
@@ -78,12 +107,38 @@ private:
     );
 
     std::string _headers() const;
+    void _sendNextChunk(ChunkSource const& source);
+    void _queueWrite(std::string&& data, WriteCallback const& onWritten, bool last);
+    void _writeQueued();
+    void _callWritten(WriteCallback const& onWritten, bool ok);
+    void _sendFileContent(std::shared_ptr<int> const& fd, off_t offset, off_t size, std::size_t sent);
+    void _write(std::function<void(boost::system::error_code const&, std::size_t)> const& onWritten);
 
     std::shared_ptr<boost::asio::ip::tcp::socket> _socket;
     boost::asio::streambuf _responsebuf;
 
     DoneCallback _doneCallback;
 
+    //----- Set by the Server for responses of blocking handlers: writes are then started on _ioService,
+    //      and chunk sources are called on _handlerService.
+
+    boost::asio::io_service* _ioService = nullptr;
+    boost::asio::io_service* _handlerService = nullptr;
+
+    //----- Data of a pushed chunked body waiting to be written, oldest first.  One write is in progress
+    //      at a time; _streamMutex protects the members below.
+
+    struct QueuedWrite {
+        std::string data;
+        WriteCallback onWritten;
+        bool last;
+    };
+
+    std::mutex _streamMutex;
+    std::deque<QueuedWrite> _streamQueue;
+    bool _streamWriting = false;
+    bool _streamFailed = false;
+
 };
 
 }}} // namespace lsst::qserv::qhttp
@@ -0,0 +1,133 @@
+/*
+ * LSST Data Management System
+ * Copyright 2017 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <https://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "qhttp/Router.h"
+
+// System headers
+#include <string>
+#include <vector>
+
+// Third-party headers
+#include "boost/regex.hpp"
+
+namespace {
+
+//----- Split a request path into its elements, matching what the Path regexps accept: the path must have
+//      a leading slash, and may have one trailing slash.
+
+bool splitPath(std::string const& path, std::vector<std::string>& elements)
+{
+    if (path.empty() || path[0] != '/') return false;
+    size_t end = path.size();
+    if (end > 1 && path[end - 1] == '/') --end;
+    size_t begin = 1;
+    while (begin < end) {
+        size_t next = path.find('/', begin);
+        if (next == std::string::npos || next > end) next = end;
+        elements.emplace_back(path, begin, next - begin);
+        begin = next + 1;
+        if (begin == end && path[next] == '/') {
+            elements.emplace_back();    // "/a//" keeps an empty last element, which nothing matches
+        }
+    }
+    return true;
+}
+
+} // anon. namespace
+
+namespace lsst {
+namespace qserv {
+namespace qhttp {
+
+size_t Router::add(Path const& path)
+{
+    size_t const index = _paths.size();
+    _paths.push_back(path);
+    if (!path.elementsOnly) {
+        _regexPaths.push_back(index);
+        return index;
+    }
+    Node* node = &_root;
+    for(auto& element: path.elements) {
+        auto& child = element.param ? node->param : node->literals[element.text];
+        if (!child) {
+            child.reset(new Node());
+        }
+        node = child.get();
+    }
+    if (node->path < 0) {
+        node->path = index;
+    }
+    return index;
+}
+
+
+int Router::match(Request::Ptr const& request) const
+{
+    std::vector<std::string> elements;
+    int best = -1;
+    if (splitPath(request->path, elements)) {
+        best = _find(_root, elements, 0, -1);
+    }
+
+    //----- Paths matched by regexp only need to be tried if they were added before the one found in the tree.
+
+    boost::smatch pathMatch;
+    for(size_t index: _regexPaths) {
+        if (best >= 0 && index > static_cast<size_t>(best)) break;
+        if (boost::regex_match(request->path, pathMatch, _paths[index].regex)) {
+            _paths[index].updateParamsFromMatch(request, pathMatch);
+            return index;
+        }
+    }
+    if (best >= 0) {
+        auto& pathElements = _paths[best].elements;
+        for(size_t i=0; i<pathElements.size(); ++i) {
+            if (pathElements[i].param) {
+                request->params[pathElements[i].text] = elements[i];
+            }
+        }
+    }
+    return best;
+}
+
+
+//----- Return the lower of 'best' and the index of the first Path matching elements[pos...] from 'node'.
+//      Both a literal and the parameter branch may match an element, so both are followed.
+
+int Router::_find(Node const& node, std::vector<std::string> const& elements, size_t pos, int best) const
+{
+    if (pos == elements.size()) {
+        return (node.path >= 0 && (best < 0 || node.path < best)) ? node.path : best;
+    }
+    auto literal = node.literals.find(elements[pos]);
+    if (literal != node.literals.end()) {
+        best = _find(*literal->second, elements, pos + 1, best);
+    }
+    if (node.param && !elements[pos].empty()) {
+        best = _find(*node.param, elements, pos + 1, best);
+    }
+    return best;
+}
+
+}}} // namespace lsst::qserv::qhttp
@@ -0,0 +1,79 @@
+/*
+ * LSST Data Management System
+ * Copyright 2017 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <https://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_QSERV_QHTTP_ROUTER_H
+#define LSST_QSERV_QHTTP_ROUTER_H
+
+// System headers
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Local headers
+#include "qhttp/Path.h"
+#include "qhttp/Request.h"
+
+namespace lsst {
+namespace qserv {
+namespace qhttp {
+
+
+//----- This is an internal utility class, used by the Server class, that finds the first of the Paths
+//      installed for an HTTP method which matches a request.  Paths broken down into elements (see Path.h)
+//      are kept in a tree with one level per path element, literal elements looked up by hash and
+//      parameters in a single wildcard branch, so a request walks down the tree once instead of running
+//      one regexp per installed Path.  Other Paths are still matched by their regexps.  Either way, the
+//      Path added first wins when several match, as with trying each Path's regexp in turn.
+
+class Router
+{
+public:
+
+    //----- add() installs a Path, and returns its index (the number of Paths added before it).
+
+    size_t add(Path const& path);
+
+    //----- match() returns the index of the first added Path matching request->path, or -1 if there is
+    //      none, and sets request->params from the path elements captured by that Path.
+
+    int match(Request::Ptr const& request) const;
+
+private:
+
+    struct Node {
+        std::unordered_map<std::string, std::unique_ptr<Node>> literals;
+        std::unique_ptr<Node> param;
+        int path = -1;                  // index of the first Path ending at this node, -1 if none
+    };
+
+    int _find(Node const& node, std::vector<std::string> const& elements, size_t pos, int best) const;
+
+    std::vector<Path> _paths;
+    std::vector<size_t> _regexPaths;    // indices of the Paths not in the tree, in order
+    Node _root;
+
+};
+
+}}} // namespace lsst::qserv::qhttp
+
+#endif // LSST_QSERV_QHTTP_ROUTER_H
@@ -26,11 +26,12 @@
 // System headers
 #include <memory>
 #include <string>
+#include <thread>
 
 // Third-party headers
+#include "boost/algorithm/string/predicate.hpp"
 #include "boost/asio.hpp"
 #include "boost/asio/steady_timer.hpp"
-#include "boost/regex.hpp"
 
 // Local headers
 #include "qhttp/AjaxEndpoint.h"
@@ -44,6 +45,7 @@ namespace qserv {
 namespace qhttp {
 
 #define DEFAULT_REQUEST_TIMEOUT_MSECS 300000 // 5 minutes
+#define DEFAULT_IDLE_TIMEOUT_MSECS 30000 // 30 seconds
 
 
 Server::Ptr Server::create(asio::io_service& io_service, unsigned short port)
@@ -63,7 +65,10 @@ Server::Server(asio::io_service& io_service, unsigned short port)
     _io_service(io_service),
     _acceptorEndpoint(ip::tcp::v4(), port),
     _acceptor(io_service),
-    _requestTimeout(std::chrono::milliseconds(DEFAULT_REQUEST_TIMEOUT_MSECS))
+    _requestTimeout(std::chrono::milliseconds(DEFAULT_REQUEST_TIMEOUT_MSECS)),
+    _idleTimeout(std::chrono::milliseconds(DEFAULT_IDLE_TIMEOUT_MSECS)),
+    _maxConnections(0),
+    _numHandlerThreads(0)
 {
 }
 
@@ -74,20 +79,21 @@ Server::~Server()
 }
 
 
-void Server::addHandler(std::string const& method, std::string const& pattern, Handler handler)
+void Server::addHandler(std::string const& method, std::string const& pattern, Handler handler,
+                        bool blocking)
 {
-    auto &handlers = _pathHandlersByMethod[method];
-    handlers.resize(handlers.size() + 1);
-    auto &phandler = handlers.back();
-    phandler.path.parse(pattern);
-    phandler.handler = handler;
+    auto &methodHandlers = _pathHandlersByMethod[method];
+    Path path;
+    path.parse(pattern);
+    methodHandlers.router.add(path);
+    methodHandlers.handlers.push_back({handler, blocking});
 }
 
 
 void Server::addHandlers(std::initializer_list<HandlerSpec> handlers)
 {
     for(auto& handler: handlers) {
-        addHandler(handler.method, handler.pattern, handler.handler);
+        addHandler(handler.method, handler.pattern, handler.handler, handler.blocking);
     }
 }
 
@@ -110,6 +116,24 @@ void Server::setRequestTimeout(std::chrono::milliseconds const& timeout)
 }
 
 
+void Server::setIdleTimeout(std::chrono::milliseconds const& timeout)
+{
+    _idleTimeout = timeout;
+}
+
+
+void Server::setMaxConnections(size_t maxConnections)
+{
+    _maxConnections = maxConnections;
+}
+
+
+void Server::setHandlerThreads(size_t numThreads)
+{
+    _numHandlerThreads = numThreads;
+}
+
+
 void Server::_accept()
 {
     auto socket = std::make_shared<ip::tcp::socket>(_io_service);
@@ -133,13 +157,30 @@ void Server::_accept()
             if (!ec) {
                 boost::system::error_code ignore;
                 socket->set_option(ip::tcp::no_delay(true), ignore);
-                self->_readRequest(socket);
+                if (self->_overConnectionLimit()) {
+                    self->_refuseRequest(socket);
+                } else {
+                    self->_readRequest(socket);
+                }
             }
         }
     );
 }
 
 
+bool Server::_overConnectionLimit()
+{
+    if (_maxConnections == 0) return false;
+    std::lock_guard<std::mutex> lock(_activeSocketsMutex);
+    size_t open = 0;
+    for(auto& weakSocket : _activeSockets) {
+        if (!weakSocket.expired()) ++open;
+    }
+    //----- the count includes the socket waiting for the next connection
+    return open > _maxConnections + 1;
+}
+
+
 void Server::start()
 {
     _acceptor.open(_acceptorEndpoint.protocol());
@@ -147,6 +188,7 @@ void Server::start()
     _acceptor.bind(_acceptorEndpoint);
     _acceptorEndpoint.port(_acceptor.local_endpoint().port()); // preserve assigned port
     _acceptor.listen();
+    _startHandlerThreads();
     _accept();
 }
 
@@ -155,22 +197,59 @@ void Server::stop()
 {
     boost::system::error_code ignore;
     _acceptor.close(ignore);
-    std::lock_guard<std::mutex> lock(_activeSocketsMutex);
-    for(auto& weakSocket : _activeSockets) {
-        auto socket = weakSocket.lock();
-        if (socket) {
-            socket->lowest_layer().shutdown(ip::tcp::socket::shutdown_both, ignore);
-            socket->lowest_layer().close(ignore);
+    {
+        std::lock_guard<std::mutex> lock(_activeSocketsMutex);
+        for(auto& weakSocket : _activeSockets) {
+            auto socket = weakSocket.lock();
+            if (socket) {
+                socket->lowest_layer().shutdown(ip::tcp::socket::shutdown_both, ignore);
+                socket->lowest_layer().close(ignore);
+            }
+        }
+        _activeSockets.clear();
+    }
+    _stopHandlerThreads();
+}
+
+
+void Server::_startHandlerThreads()
+{
+    if (_numHandlerThreads == 0 || !_handlerThreads.empty()) return;
+    _handlerService.reset();
+    _handlerWork.reset(new asio::io_service::work(_handlerService));
+    for (size_t i = 0; i < _numHandlerThreads; ++i) {
+        _handlerThreads.emplace_back([this]() { _handlerService.run(); });
+    }
+}
+
+
+void Server::_stopHandlerThreads()
+{
+    //----- Handlers in progress are allowed to finish (their responses will fail on the closed sockets),
+    //      and those still queued are dropped.  A pool thread releasing the last reference to the
+    //      Server can not join itself, and is detached instead.
+
+    if (_handlerThreads.empty()) return;
+    _handlerWork.reset();
+    _handlerService.stop();
+    for (auto& thread : _handlerThreads) {
+        if (thread.get_id() == std::this_thread::get_id()) {
+            thread.detach();
+        } else {
+            thread.join();
         }
     }
-    _activeSockets.clear();
+    _handlerThreads.clear();
 }
 
 
-void Server::_readRequest(std::shared_ptr<ip::tcp::socket> socket)
+void Server::_readRequest(std::shared_ptr<ip::tcp::socket> socket, bool reused, std::string const& pipelined)
 {
+    //----- A kept connection waits for its next request for up to the idle timeout, unless the client
+    //      has already sent it.
+
     auto timer = std::make_shared<asio::steady_timer>(_io_service);
-    timer->expires_from_now(_requestTimeout);
+    timer->expires_from_now((reused && pipelined.empty()) ? _idleTimeout : _requestTimeout);
     timer->async_wait(
         [socket](boost::system::error_code const& ec) {
             if (!ec) {
@@ -183,34 +262,62 @@ void Server::_readRequest(std::shared_ptr<ip::tcp::socket> socket)
 
     auto self = shared_from_this();
     auto reuseSocket = std::make_shared<bool>(false);
+    auto next = std::make_shared<std::string>();
     auto request = std::shared_ptr<Request>(new Request(socket));
     auto response = std::shared_ptr<Response>(new Response(
         socket,
-        [self, socket, reuseSocket](boost::system::error_code const& ec, std::size_t sent) {
+        [self, socket, reuseSocket, next](boost::system::error_code const& ec, std::size_t sent) {
             if (!ec && *reuseSocket) {
-                self->_readRequest(socket);
+                self->_readRequest(socket, true, *next);
             }
         }
     ));
 
+    request->_requestbuf.sputn(pipelined.data(), pipelined.size());
+
     asio::async_read_until(
         *socket, request->_requestbuf, "\r\n\r\n",
-        [self, socket, reuseSocket, request, response, timer](
+        [self, socket, reuseSocket, next, request, response, timer](
             boost::system::error_code const& ec, size_t bytesRead)
         {
             if (!ec) {
-                size_t bytesBuffered = request->_requestbuf.size() - bytesRead;
                 request->_parseHeader();
                 request->_parseUri();
+
+                auto const connection = request->header.find("Connection");
+                bool const close = (connection != request->header.end())
+                    && boost::iequals(connection->second, "close");
+                bool const keepAlive = (connection != request->header.end())
+                    && boost::iequals(connection->second, "keep-alive");
                 if (request->version == "HTTP/1.1") {
-                    *reuseSocket = true;
+                    *reuseSocket = !close;
+                } else {
+                    *reuseSocket = keepAlive;
+                    if (keepAlive) response->headers["Connection"] = "keep-alive";
                 }
+                if (!*reuseSocket) response->headers["Connection"] = "close";
+
+                //----- Whatever was received past the body belongs to the next (pipelined) requests,
+                //      and it is handed over to them once the response has been sent.
+
+                size_t contentLength = 0;
                 if (request->header.count("Content-Length") > 0) {
+                    contentLength = stoull(request->header["Content-Length"]);
+                }
+                size_t bytesBuffered = request->_requestbuf.size();
+                if (bytesBuffered > contentLength) {
+                    auto data = request->_requestbuf.data();
+                    next->assign(asio::buffers_begin(data) + contentLength, asio::buffers_end(data));
+                    std::string body(asio::buffers_begin(data), asio::buffers_begin(data) + contentLength);
+                    request->_requestbuf.consume(bytesBuffered);
+                    request->_requestbuf.sputn(body.data(), body.size());
+                    bytesBuffered = contentLength;
+                }
+
+                if (contentLength > bytesBuffered) {
                     asio::async_read(
                         *socket, request->_requestbuf,
-                        asio::transfer_exactly(
-                            stoull(request->header["Content-Length"]) - bytesBuffered
-                        ),
+                        asio::transfer_exactly(contentLength - bytesBuffered),
                         [self, socket, request, response, timer](
                             boost::system::error_code const& ec, size_t)
                         {
@@ -225,6 +332,9 @@ void Server::_readRequest(std::shared_ptr<ip::tcp::socket> socket)
                     );
                 } else {
                     timer->cancel();
+                    if (request->header["Content-Type"] == "application/x-www-form-urlencoded") {
+                        request->_parseBody();
+                    }
                     self->_dispatchRequest(request, response);
                 }
             } else {
@@ -235,17 +345,54 @@ void Server::_readRequest(std::shared_ptr<ip::tcp::socket> socket)
 }
 
 
+void Server::_refuseRequest(std::shared_ptr<ip::tcp::socket> socket)
+{
+    //----- The header is read before responding, as closing the socket with a request still unread
+    //      could discard the response.
+
+    auto timer = std::make_shared<asio::steady_timer>(_io_service);
+    timer->expires_from_now(_requestTimeout);
+    timer->async_wait(
+        [socket](boost::system::error_code const& ec) {
+            if (!ec) {
+                boost::system::error_code ignore;
+                socket->lowest_layer().shutdown(ip::tcp::socket::shutdown_both, ignore);
+                socket->lowest_layer().close(ignore);
+            }
+        }
+    );
+
+    auto requestbuf = std::make_shared<asio::streambuf>();
+    asio::async_read_until(
+        *socket, *requestbuf, "\r\n\r\n",
+        [socket, requestbuf, timer](boost::system::error_code const& ec, size_t) {
+            timer->cancel();
+            if (!ec) {
+                auto response = std::shared_ptr<Response>(new Response(socket, nullptr));
+                response->headers["Connection"] = "close";
+                response->sendStatus(503);
+            }
+        }
+    );
+}
+
+
 void Server::_dispatchRequest(Request::Ptr request, Response::Ptr response)
 {
     auto pathHandlersIt = _pathHandlersByMethod.find(request->method);
     if (pathHandlersIt != _pathHandlersByMethod.end()) {
-        boost::smatch pathMatch;
-        for(auto& pathHandler : pathHandlersIt->second) {
-            if (boost::regex_match(request->path, pathMatch, pathHandler.path.regex)) {
-                pathHandler.path.updateParamsFromMatch(request, pathMatch);
+        int const index = pathHandlersIt->second.router.match(request);
+        if (index >= 0) {
+            auto& pathHandler = pathHandlersIt->second.handlers[index];
+            if (pathHandler.blocking && !_handlerThreads.empty()) {
+                response->_ioService = &_io_service;
+                response->_handlerService = &_handlerService;
+                auto const handler = pathHandler.handler;
+                _handlerService.post([handler, request, response]() { handler(request, response); });
+            } else {
                 pathHandler.handler(request, response);
-                return;
             }
+            return;
         }
     }
     response->sendStatus(404);
@@ -30,6 +30,7 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -38,7 +39,7 @@
 
 // Local headers
 #include "qhttp/AjaxEndpoint.h"
-#include "qhttp/Path.h"
+#include "qhttp/Router.h"
 #include "qhttp/Response.h"
 #include "qhttp/Request.h"
 
@@ -67,6 +68,7 @@ public:
         std::string const& method;
         std::string const& pattern;
         Handler handler;
+        bool blocking = false;
     };
 
     //----- create() is a static Server factory method.  Pass in an asio::io_service instance onto which the
@@ -81,9 +83,14 @@ public:
     ~Server();
 
     //----- Methods to install Handlers on a Server.  These must be called before start(), or between calls
-    //      to stop() and start().
-
-    void addHandler(std::string const& method, std::string const& pattern, Handler handler);
+    //      to stop() and start().  A handler installed as blocking (one which may wait on a database, a
+    //      file system, etc.) is called on a thread of the handler pool instead of the asio::io_service
+    //      thread(s), if the pool was given threads with setHandlerThreads(); so are the ChunkSources of
+    //      the chunked responses it sends.  Writes to the client are always posted back to the
+    //      asio::io_service.
+
+    void addHandler(std::string const& method, std::string const& pattern, Handler handler,
+                    bool blocking=false);
     void addHandlers(std::initializer_list<HandlerSpec> handlers);
 
     //----- StaticContent and AjaxEndpoint are specialized Handlers for common use cases (static files served
@@ -99,6 +106,24 @@ public:
 
     void setRequestTimeout(std::chrono::milliseconds const& timeout);
 
+    //----- Connections are kept open after a response for HTTP/1.1 requests (unless the client sent
+    //      "Connection: close"), and for HTTP/1.0 requests with "Connection: keep-alive".  Requests
+    //      pipelined by a client are answered in order.  setIdleTimeout() allows the user to override
+    //      the default 30 second time a kept connection waits for the header of its next request.
+    //      setMaxConnections() sets a limit on the number of open connections, past which new connections
+    //      get a 503 response and are closed (0, the default, means no limit).  Both must be called
+    //      before start(), or between calls to stop() and start().
+
+    void setIdleTimeout(std::chrono::milliseconds const& timeout);
+    void setMaxConnections(size_t maxConnections);
+
+    //----- setHandlerThreads() sets the number of threads of the pool which runs blocking handlers (0,
+    //      the default, runs them on the asio::io_service thread(s) like any other handler).  Requests
+    //      for blocking handlers wait in the pool's queue while all of its threads are busy.  Must be
+    //      called before start(), or between calls to stop() and start().
+
+    void setHandlerThreads(size_t numThreads);
+
     //----- start() opens the server listening socket and installs the head of the asynchronous event
     //      handler chain onto the asio::io_service provided when the Server instance was constructed.
     //      Server execution may be halted either calling stop(), or by calling asio::io_service::stop()
@@ -121,26 +146,46 @@ private:
     Server(boost::asio::io_service& io_service, unsigned short port);
 
     void _accept();
+    bool _overConnectionLimit();
 
-    void _readRequest(std::shared_ptr<boost::asio::ip::tcp::socket> socket);
+    void _readRequest(
+        std::shared_ptr<boost::asio::ip::tcp::socket> socket,
+        bool reused=false,
+        std::string const& pipelined=std::string());
+    void _refuseRequest(std::shared_ptr<boost::asio::ip::tcp::socket> socket);
     void _dispatchRequest(Request::Ptr request, Response::Ptr response);
 
+    void _startHandlerThreads();
+    void _stopHandlerThreads();
+
     struct PathHandler {
-        Path path;
         Handler handler;
+        bool blocking;
+    };
+
+    struct MethodHandlers {
+        Router router;
+        std::vector<PathHandler> handlers;      // by Router index
     };
 
-    std::unordered_map<std::string, std::vector<PathHandler>> _pathHandlersByMethod;
+    std::unordered_map<std::string, MethodHandlers> _pathHandlersByMethod;
 
     boost::asio::io_service& _io_service;
     boost::asio::ip::tcp::endpoint _acceptorEndpoint;
     boost::asio::ip::tcp::acceptor _acceptor;
 
     std::chrono::milliseconds _requestTimeout;
-    
+    std::chrono::milliseconds _idleTimeout;
+    size_t _maxConnections;
+
     std::vector<std::weak_ptr<boost::asio::ip::tcp::socket>> _activeSockets;
     std::mutex _activeSocketsMutex;
 
+    size_t _numHandlerThreads;
+    boost::asio::io_service _handlerService;
+    std::unique_ptr<boost::asio::io_service::work> _handlerWork;
+    std::vector<std::thread> _handlerThreads;
+
 };
 
 }}} // namespace lsst::qserv::qhttp
@@ -23,14 +23,84 @@
 // Class header
 #include "qhttp/StaticContent.h"
 
+// System headers
+#include <ctime>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sstream>
+
 // Third-party headers
 #include "boost/filesystem.hpp"
+#include "boost/filesystem/fstream.hpp"
 #include "boost/algorithm/string.hpp"
 
 namespace fs = boost::filesystem;
 
 namespace {
 
+#define CACHE_MAX_FILE_BYTES (256*1024)
+#define CACHE_MAX_TOTAL_BYTES (32*1024*1024)
+
+char const* const httpDateFormat = "%a, %d %b %Y %H:%M:%S GMT";
+
+std::string httpDate(std::time_t time) {
+    std::tm tm;
+    gmtime_r(&time, &tm);
+    char buf[64];
+    return std::string(buf, std::strftime(buf, sizeof(buf), httpDateFormat, &tm));
+}
+
+// Returns -1 if 'date' is not a valid HTTP date.
+std::time_t parseHttpDate(std::string const& date) {
+    std::tm tm = {};
+    char const* end = strptime(date.c_str(), httpDateFormat, &tm);
+    if ((end == nullptr) || (*end != '\0')) return -1;
+    return timegm(&tm);
+}
+
+// Contents of the small files served by one StaticContent handler, keyed by file path.  An entry
+// is valid as long as the size and modification time of its file are unchanged.
+
+class FileCache {
+public:
+    struct Entry {
+        uintmax_t size;
+        std::time_t mtime;
+        std::string content;
+    };
+
+    bool find(fs::path const& path, uintmax_t size, std::time_t mtime, std::string& content) {
+        std::lock_guard<std::mutex> lock(_mtx);
+        auto it = _entries.find(path.string());
+        if ((it == _entries.end()) || (it->second.size != size) || (it->second.mtime != mtime)) {
+            return false;
+        }
+        content = it->second.content;
+        return true;
+    }
+
+    void insert(fs::path const& path, uintmax_t size, std::time_t mtime, std::string const& content) {
+        std::lock_guard<std::mutex> lock(_mtx);
+        auto& entry = _entries[path.string()];
+        _totalBytes -= entry.content.size();
+        if (_totalBytes + content.size() > CACHE_MAX_TOTAL_BYTES) {
+            _entries.erase(path.string());
+            return;
+        }
+        entry = Entry{size, mtime, content};
+        _totalBytes += content.size();
+    }
+
+private:
+    std::mutex _mtx;
+    std::map<std::string, Entry> _entries;
+    size_t _totalBytes = 0;
+};
+
 // Utility function used to expand and canonicalize a boost filesystem path.
 // Similar to fs::canonical(), but doesn't blow up if the tail
 // of the path doesn't exist on disk right now.  Used below to disallow serving
@@ -77,7 +147,8 @@ namespace qhttp {
 void StaticContent::add(Server& server, std::string const& pattern, std::string const& rootDirectory)
 {
     fs::path rootPath = fs::canonical(rootDirectory);
-    server.addHandler("GET", pattern, [rootPath](Request::Ptr request, Response::Ptr response) {
+    auto cache = std::make_shared<FileCache>();
+    server.addHandler("GET", pattern, [rootPath, cache](Request::Ptr request, Response::Ptr response) {
         fs::path requestPath = rootPath;
         requestPath /= request->path;
         requestPath = normalize(requestPath);
@@ -93,7 +164,70 @@ void StaticContent::add(Server& server, std::string const& pattern, std::string
             }
             requestPath /= "index.htm";
         }
-        response->sendFile(requestPath);
+
+        boost::system::error_code ec;
+        if (!fs::is_regular_file(requestPath, ec)) {
+            response->sendStatus(404);
+            return;
+        }
+        std::string const contentType = Response::contentTypeOf(requestPath);
+
+        //----- Pick the precompressed variant if the client takes it.
+
+        fs::path filePath = requestPath;
+        auto const acceptEncoding = request->header.find("Accept-Encoding");
+        if ((acceptEncoding != request->header.end())
+            && boost::contains(acceptEncoding->second, "gzip")) {
+            fs::path gzPath = requestPath;
+            gzPath += ".gz";
+            if (fs::is_regular_file(gzPath, ec)) {
+                filePath = gzPath;
+                response->headers["Content-Encoding"] = "gzip";
+            }
+            response->headers["Vary"] = "Accept-Encoding";
+        }
+
+        uintmax_t const size = fs::file_size(filePath, ec);
+        std::time_t const mtime = fs::last_write_time(filePath, ec);
+        if (ec) {
+            response->sendStatus(404);
+            return;
+        }
+        std::ostringstream etag;
+        etag << "\"" << std::hex << size << "-" << mtime << "\"";
+        response->headers["ETag"] = etag.str();
+        response->headers["Last-Modified"] = httpDate(mtime);
+
+        //----- If-None-Match takes precedence over If-Modified-Since (RFC 7232, section 6).
+
+        bool notModified = false;
+        auto const ifNoneMatch = request->header.find("If-None-Match");
+        auto const ifModifiedSince = request->header.find("If-Modified-Since");
+        if (ifNoneMatch != request->header.end()) {
+            notModified = (ifNoneMatch->second == "*") || boost::contains(ifNoneMatch->second, etag.str());
+        } else if (ifModifiedSince != request->header.end()) {
+            std::time_t const since = parseHttpDate(ifModifiedSince->second);
+            notModified = (since != -1) && (mtime <= since);
+        }
+        if (notModified) {
+            response->status = 304;
+            response->send("", contentType);
+            return;
+        }
+
+        if (size > CACHE_MAX_FILE_BYTES) {
+            response->sendFile(filePath, contentType);
+            return;
+        }
+        std::string content;
+        if (!cache->find(filePath, size, mtime, content)) {
+            fs::ifstream file(filePath, std::ios::binary);
+            content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            if (content.size() == size) {
+                cache->insert(filePath, size, mtime, content);
+            }
+        }
+        response->send(content, contentType);
     });
 }
 
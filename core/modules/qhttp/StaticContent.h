@@ -45,6 +45,12 @@ public:
     //      several common file extensions (see the file type map near the top of Response.cc for a complete
     //      list of these.)  Note that the Server::addStaticContent() convenience method would typically be
     //      called in preference to calling the add() method here directly.
+    //
+    //      Responses carry ETag and Last-Modified headers, and conditional requests (If-None-Match or
+    //      If-Modified-Since) for unchanged files are answered with 304.  Clients accepting gzip are sent
+    //      the precompressed variant of a file (the same path with ".gz" appended) if there is one.
+    //      Files of up to 256 KB are kept in memory (up to 32 MB in all, per add() call), and reloaded
+    //      when their size or modification time changes.
 
     static void add(Server& server, std::string const& path, std::string const& rootDirectory);
 
@@ -25,6 +25,7 @@
 
 #include <chrono>
 #include <fstream>
+#include <future>
 #include <sstream>
 #include <set>
 #include <string>
@@ -32,6 +33,8 @@
 
 #include "boost/asio.hpp"
 #include "boost/algorithm/string/join.hpp"
+#include "boost/filesystem.hpp"
+#include "boost/filesystem/fstream.hpp"
 #include "boost/range/adaptors.hpp"
 #include "curl/curl.h"
 
@@ -39,6 +42,7 @@
 
 namespace asio = boost::asio;
 namespace ip = boost::asio::ip;
+namespace fs = boost::filesystem;
 
 namespace {
 
@@ -478,6 +482,218 @@ BOOST_FIXTURE_TEST_CASE(percent_decoding, QhttpFixture)
 }
 
 
+BOOST_FIXTURE_TEST_CASE(chunked_content, QhttpFixture)
+{
+    //----- server with handler that sends a body of three chunks, with an empty one in between
+
+    server->addHandler("GET", "/chunked", [](qhttp::Request::Ptr req, qhttp::Response::Ptr resp){
+        auto chunks = std::make_shared<std::vector<std::string>>(
+            std::vector<std::string>{"first,", "", std::string(100000, 'x'), ",last"});
+        auto next = std::make_shared<size_t>(0);
+        resp->sendChunked([chunks, next](std::string& chunk) {
+            if (*next == chunks->size()) return false;
+            chunk = (*chunks)[(*next)++];
+            return true;
+        }, "text/plain");
+    });
+
+    start();
+    CurlEasy curl;
+
+    //----- test that the chunks are reassembled, and that the connection is reused afterwards
+
+    for (int i = 0; i < 2; ++i) {
+        curl.setup("GET", urlPrefix + "chunked", "").perform();
+        long recdResponseCode;
+        BOOST_TEST(curl_easy_getinfo(curl.hcurl, CURLINFO_RESPONSE_CODE, &recdResponseCode) == CURLE_OK);
+        BOOST_TEST(recdResponseCode == 200);
+        BOOST_TEST(curl.recdContent == "first," + std::string(100000, 'x') + ",last");
+    }
+}
+
+
+BOOST_FIXTURE_TEST_CASE(pushed_chunks, QhttpFixture)
+{
+    //----- server with handlers that push 100 chunks, each once the previous one has been written; one
+    //      on the io_service thread, the other on the handler pool
+
+    auto pushChunks = [](qhttp::Request::Ptr req, qhttp::Response::Ptr resp) {
+        resp->startChunked("text/plain");
+        auto next = std::make_shared<std::function<void(int)>>();
+        *next = [resp, next](int i) {
+            if (i == 100) {
+                resp->finishChunked();
+                *next = nullptr;
+                return;
+            }
+            resp->writeChunk(std::to_string(i) + ",", [next, i](bool ok) { if (ok) (*next)(i + 1); });
+        };
+        (*next)(0);
+    };
+    server->setHandlerThreads(2);
+    server->addHandler("GET", "/pushed", pushChunks);
+    server->addHandler("GET", "/pushed-blocking", pushChunks, true);
+
+    start();
+    CurlEasy curl;
+
+    std::string expected;
+    for (int i = 0; i < 100; ++i) expected += std::to_string(i) + ",";
+
+    //----- test that the chunks are reassembled in order, and that the connection is reused afterwards
+
+    for (auto const& path : {"pushed", "pushed-blocking", "pushed"}) {
+        curl.setup("GET", urlPrefix + path, "").perform();
+        long recdResponseCode;
+        BOOST_TEST(curl_easy_getinfo(curl.hcurl, CURLINFO_RESPONSE_CODE, &recdResponseCode) == CURLE_OK);
+        BOOST_TEST(recdResponseCode == 200);
+        BOOST_TEST(curl.recdContent == expected);
+    }
+}
+
+
+BOOST_FIXTURE_TEST_CASE(keep_alive, QhttpFixture)
+{
+    //----- server with handler that echoes the request path and body
+
+    server->addHandler("POST", "/:name", [](qhttp::Request::Ptr req, qhttp::Response::Ptr resp){
+        std::string body(std::istreambuf_iterator<char>(req->content), {});
+        resp->send(req->params["name"] + ":" + body, "text/plain");
+    });
+
+    start();
+
+    boost::system::error_code ec;
+    ip::tcp::endpoint endpoint(ip::address::from_string("127.0.0.1"), server->getPort());
+    ip::tcp::socket socket(service);
+    socket.connect(endpoint, ec);
+    BOOST_TEST(!ec);
+
+    //----- test that three requests written at once get their responses in order over the
+    //      same connection, and that the connection is closed after the last one, which asked
+    //      for it
+
+    std::string req =
+        "POST /a HTTP/1.1\r\nContent-Length: 3\r\n\r\nxyz"
+        "POST /b HTTP/1.1\r\n\r\n"
+        "POST /c HTTP/1.1\r\nConnection: close\r\nContent-Length: 1\r\n\r\nz";
+    asio::write(socket, asio::buffer(req), ec);
+    BOOST_TEST(!ec);
+
+    asio::streambuf respbuf;
+    asio::read(socket, respbuf, asio::transfer_all(), ec);
+    BOOST_TEST((ec == asio::error::eof));
+
+    auto respbegin = asio::buffers_begin(respbuf.data());
+    std::string resp(respbegin, respbegin + respbuf.size());
+    auto a = resp.find("\r\n\r\na:xyz");
+    auto b = resp.find("\r\n\r\nb:");
+    auto c = resp.find("\r\n\r\nc:z");
+    BOOST_TEST(a != std::string::npos);
+    BOOST_TEST(b != std::string::npos);
+    BOOST_TEST(c != std::string::npos);
+    BOOST_TEST((a < b && b < c));
+    BOOST_TEST(resp.find("Connection: close") > b);
+}
+
+
+BOOST_FIXTURE_TEST_CASE(max_connections, QhttpFixture)
+{
+    server->addHandler("GET", "/", [](qhttp::Request::Ptr req, qhttp::Response::Ptr resp){
+        resp->sendStatus(200);
+    });
+
+    server->setMaxConnections(1);
+    start();
+
+    //----- test that a second connection is refused while the first one is open, and accepted
+    //      after it was closed
+
+    boost::system::error_code ec;
+    ip::tcp::endpoint endpoint(ip::address::from_string("127.0.0.1"), server->getPort());
+    ip::tcp::socket socket(service);
+    socket.connect(endpoint, ec);
+    BOOST_TEST(!ec);
+    std::string req = std::string("GET / HTTP/1.1\r\n\r\n");
+    asio::write(socket, asio::buffer(req), ec);
+    BOOST_TEST(!ec);
+    asio::streambuf respbuf;
+    asio::read_until(socket, respbuf, "\r\n\r\n", ec);
+    BOOST_TEST(!ec);
+    auto respbegin = asio::buffers_begin(respbuf.data());
+    std::string resp(respbegin, respbegin + respbuf.size());
+    BOOST_TEST(resp.find("200 OK") != std::string::npos);
+
+    CurlEasy curl;
+    curl.setup("GET", urlPrefix, "").perform();
+    long recdResponseCode;
+    BOOST_TEST(curl_easy_getinfo(curl.hcurl, CURLINFO_RESPONSE_CODE, &recdResponseCode) == CURLE_OK);
+    BOOST_TEST(recdResponseCode == 503);
+
+    socket.close();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    CurlEasy curl2;
+    curl2.setup("GET", urlPrefix, "").perform().validate(200, "text/html");
+}
+
+
+BOOST_FIXTURE_TEST_CASE(blocking_handlers, QhttpFixture)
+{
+    //----- set up a blocking handler which waits until released, sending a chunked response from the
+    //      handler pool, and a regular handler on the io_service thread
+
+    std::promise<void> release;
+    std::shared_future<void> released(release.get_future());
+    std::thread::id chunkThread;
+
+    server->addHandlers({
+        {"GET", "/slow", [released, &chunkThread](qhttp::Request::Ptr req, qhttp::Response::Ptr resp) {
+            released.wait();
+            auto more = std::make_shared<bool>(true);
+            resp->sendChunked([more, &chunkThread](std::string& chunk) {
+                chunkThread = std::this_thread::get_id();
+                chunk = "slow";
+                bool const last = !*more;
+                *more = false;
+                return !last;
+            });
+        }, true},
+        {"GET", "/fast", [](qhttp::Request::Ptr req, qhttp::Response::Ptr resp) {
+            resp->send("fast");
+        }}
+    });
+
+    server->setHandlerThreads(1);
+    start();
+
+    boost::system::error_code ec;
+    ip::tcp::endpoint endpoint(ip::address::from_string("127.0.0.1"), server->getPort());
+    ip::tcp::socket socket(service);
+    socket.connect(endpoint, ec);
+    BOOST_TEST(!ec);
+    std::string req = std::string("GET /slow HTTP/1.1\r\nConnection: close\r\n\r\n");
+    asio::write(socket, asio::buffer(req), ec);
+    BOOST_TEST(!ec);
+
+    //----- test that the regular handler is answered while the blocking one waits, and that the
+    //      blocking one completes once released
+
+    CurlEasy curl;
+    curl.setup("GET", urlPrefix + "fast", "").perform().validate(200, "text/html");
+    BOOST_TEST(curl.recdContent == "fast");
+
+    release.set_value();
+    asio::streambuf respbuf;
+    asio::read(socket, respbuf, asio::transfer_all(), ec);
+    BOOST_TEST((ec == asio::error::eof));
+    auto respbegin = asio::buffers_begin(respbuf.data());
+    std::string resp(respbegin, respbegin + respbuf.size());
+    BOOST_TEST(resp.find("200 OK") != std::string::npos);
+    BOOST_TEST(resp.find("\r\n\r\n4\r\nslow\r\n0\r\n\r\n") != std::string::npos);
+    BOOST_TEST((chunkThread != serviceThread.get_id()));
+}
+
+
 BOOST_FIXTURE_TEST_CASE(static_content, QhttpFixture)
 {
     server->addStaticContent("/*", "core/modules/qhttp/testdata");
@@ -518,6 +734,67 @@ BOOST_FIXTURE_TEST_CASE(static_content, QhttpFixture)
 }
 
 
+BOOST_FIXTURE_TEST_CASE(static_content_caching, QhttpFixture)
+{
+    //----- set up a content directory with a file too large for the cache, and a small file with a
+    //      precompressed variant
+
+    fs::path const dir = fs::temp_directory_path() / fs::unique_path();
+    fs::create_directories(dir);
+    std::string large;
+    for (size_t i = 0; i < 300000; ++i) large += static_cast<char>('a' + i % 26);
+    fs::ofstream(dir / "large.js") << large;
+    fs::ofstream(dir / "small.css") << "body {}";
+    fs::ofstream(dir / "small.css.gz") << "gzipped";
+
+    server->addStaticContent("/*", dir.string());
+    start();
+
+    CurlEasy curl;
+    std::string headers;
+    BOOST_TEST(curl_easy_setopt(curl.hcurl, CURLOPT_HEADERFUNCTION, writeToString) == CURLE_OK);
+    BOOST_TEST(curl_easy_setopt(curl.hcurl, CURLOPT_HEADERDATA, &headers) == CURLE_OK);
+
+    //----- test that a large file is sent whole
+
+    curl.setup("GET", urlPrefix + "large.js", "").perform().validate(200, "application/javascript");
+    BOOST_TEST((curl.recdContent == large));
+
+    //----- test conditional requests against the ETag and Last-Modified headers of a small file
+    //      (served the second time from the cache)
+
+    for (int i = 0; i < 2; ++i) {
+        headers.clear();
+        curl.setup("GET", urlPrefix + "small.css", "").perform().validate(200, "text/css");
+        BOOST_TEST(curl.recdContent == "body {}");
+    }
+    boost::smatch match;
+    BOOST_TEST(boost::regex_search(headers, match, boost::regex("ETag: ([^\r]*)\r")));
+    std::string const etag = match[1];
+    BOOST_TEST(boost::regex_search(headers, match, boost::regex("Last-Modified: ([^\r]*)\r")));
+    std::string const lastModified = match[1];
+
+    curl.setup("GET", urlPrefix + "small.css", "", {"If-None-Match: " + etag}).perform()
+        .validate(304, "text/css");
+    BOOST_TEST(curl.recdContent.empty());
+    curl.setup("GET", urlPrefix + "small.css", "", {"If-Modified-Since: " + lastModified}).perform()
+        .validate(304, "text/css");
+    curl.setup("GET", urlPrefix + "small.css", "", {"If-None-Match: \"other\""}).perform()
+        .validate(200, "text/css");
+    BOOST_TEST(curl.recdContent == "body {}");
+
+    //----- test that the precompressed variant goes to clients accepting gzip
+
+    headers.clear();
+    curl.setup("GET", urlPrefix + "small.css", "", {"Accept-Encoding: gzip, deflate"}).perform()
+        .validate(200, "text/css");
+    BOOST_TEST(curl.recdContent == "gzipped");
+    BOOST_TEST(headers.find("Content-Encoding: gzip") != std::string::npos);
+
+    fs::remove_all(dir);
+}
+
+
 BOOST_FIXTURE_TEST_CASE(relative_url_containment, QhttpFixture)
 {
     server->addStaticContent("/*", "core/modules/qhttp/testdata");
@@ -601,6 +878,48 @@ BOOST_FIXTURE_TEST_CASE(handler_dispatch, QhttpFixture)
 }
 
 
+BOOST_FIXTURE_TEST_CASE(handler_precedence, QhttpFixture)
+{
+    auto testHandler = [](std::string const &name) {
+        return [name](qhttp::Request::Ptr req, qhttp::Response::Ptr resp) {
+            resp->send(name + " " + printParams(req), "text/plain");
+        };
+    };
+
+    //----- Mix patterns matched by the router tree with patterns needing a regexp; the first installed
+    //      matching pattern must win either way.
+
+    server->addHandlers({
+        {"GET", "/api/v1/items/:item",      testHandler("Handler1")},
+        {"GET", "/api/v1/items/special",    testHandler("Handler2")},
+        {"GET", "/api/v1/things/special",   testHandler("Handler3")},
+        {"GET", "/api/v1/things/:thing",    testHandler("Handler4")},
+        {"GET", "/api/v1/nums/:num(\\d+)",  testHandler("Handler5")},
+        {"GET", "/api/v1/nums/:name",       testHandler("Handler6")},
+        {"GET", "/api/v1/:kind/:id/info",   testHandler("Handler7")}
+    });
+
+    start();
+
+    CurlEasy curl;
+
+    curl.setup("GET", urlPrefix + "api/v1/items/special", "").perform().validate(200, "text/plain");
+    BOOST_TEST(curl.recdContent == "Handler1 params[item=special] query[]");
+    curl.setup("GET", urlPrefix + "api/v1/things/special", "").perform().validate(200, "text/plain");
+    BOOST_TEST(curl.recdContent == "Handler3 params[] query[]");
+    curl.setup("GET", urlPrefix + "api/v1/things/other/", "").perform().validate(200, "text/plain");
+    BOOST_TEST(curl.recdContent == "Handler4 params[thing=other] query[]");
+    curl.setup("GET", urlPrefix + "api/v1/nums/42", "").perform().validate(200, "text/plain");
+    BOOST_TEST(curl.recdContent == "Handler5 params[num=42] query[]");
+    curl.setup("GET", urlPrefix + "api/v1/nums/many", "").perform().validate(200, "text/plain");
+    BOOST_TEST(curl.recdContent == "Handler6 params[name=many] query[]");
+    curl.setup("GET", urlPrefix + "api/v1/items/7/info", "").perform().validate(200, "text/plain");
+    BOOST_TEST(curl.recdContent == "Handler7 params[id=7,kind=items] query[]");
+    curl.setup("GET", urlPrefix + "api/v1/items//info", "").perform().validate(404, "text/html");
+    curl.setup("GET", urlPrefix + "api/v1/items/7/other", "").perform().validate(404, "text/html");
+}
+
+
 BOOST_FIXTURE_TEST_CASE(ajax, QhttpFixture)
 {
     auto ajax1 = server->addAjaxEndpoint("/ajax/foo");
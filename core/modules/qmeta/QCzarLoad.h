@@ -0,0 +1,48 @@
+/*
+ * LSST Data Management System
+ * Copyright 2019 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_QMETA_QCZARLOAD_H
+#define LSST_QSERV_QMETA_QCZARLOAD_H
+
+// System headers
+#include <cstdint>
+#include <string>
+
+// Qserv headers
+#include "qmeta/types.h"
+
+namespace lsst {
+namespace qserv {
+namespace qmeta {
+
+/// Load of a czar, as it advertises it in QCzar for the other czars.
+struct QCzarLoad {
+    CzarId czarId{0};
+    std::string czarName;
+    uint32_t runningQueries{0}; ///< Queries dispatching or merging.
+    uint32_t queuedQueries{0}; ///< Queries waiting to be admitted.
+    uint64_t runningJobs{0}; ///< Chunk jobs of the running scan and async queries.
+    uint64_t queuedJobs{0}; ///< Chunk jobs of the queued scan and async queries.
+};
+
+}}} // namespace lsst::qserv::qmeta
+
+#endif // LSST_QSERV_QMETA_QCZARLOAD_H
@@ -49,7 +49,8 @@ QMeta::createFromConfig(std::map<std::string, std::string> const& config) {
                configStore.get("database"));
 
                 LOGS(_log, LOG_LVL_DEBUG, "Create QMeta instance with mysql store");
-                return std::make_shared<QMetaMysql>(mysqlConfig);
+                return std::make_shared<QMetaMysql>(mysqlConfig,
+                                                    configStore.getInt("maxBatchRows", 1000));
         } catch (util::ConfigStoreError const& exc) {
             LOGS(_log, LOG_LVL_DEBUG, "Exception launched while creating MySQL configuration: " << exc.what());
             throw ConfigError(ERR_LOC, exc.what());
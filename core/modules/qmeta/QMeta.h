@@ -30,8 +30,10 @@
 #include <vector>
 
 // Qserv headers
+#include "qmeta/QCzarLoad.h"
 #include "qmeta/QInfo.h"
 #include "qmeta/QStats.h"
+#include "qmeta/QUsage.h"
 #include "qmeta/types.h"
 
 
@@ -116,6 +118,25 @@ public:
      */
     virtual void setCzarActive(CzarId czarId, bool active) = 0;
 
+    /**
+     *  @brief Advertise the load of a czar to the other czars.
+     *
+     *  The time of the update is stored with the load, loads that are not
+     *  updated any more are ignored by getCzarLoads().
+     *
+     *  @param czarId:  Czar ID, non-negative number.
+     *  @param load:    Current load of the czar, its czarId and czarName are ignored.
+     */
+    virtual void updateCzarLoad(CzarId czarId, QCzarLoad const& load) = 0;
+
+    /**
+     *  @brief Return the loads of the active czars.
+     *
+     *  @param maxAgeSec:  Loads updated longer ago than this are left out.
+     *  @return: Loads of the czars, in czar ID order.
+     */
+    virtual std::vector<QCzarLoad> getCzarLoads(unsigned maxAgeSec) = 0;
+
     /**
      *  @brief Cleanup of query status.
      *
@@ -172,6 +193,31 @@ public:
      */
     virtual void finishChunk(QueryId queryId, int chunk) = 0;
 
+    /**
+     *  @brief Assign or re-assign a set of chunks to workers.
+     *
+     *  Same as calling assignChunk() for each chunk, but needs far fewer
+     *  statements. This method will throw if query ID or any chunk number
+     *  is not known.
+     *
+     *  @param queryId:      Query ID, non-negative number.
+     *  @param assignments:  Chunk number and worker xrootd endpoint of each chunk.
+     */
+    virtual void assignChunks(QueryId queryId,
+                              std::vector<std::pair<int, std::string>> const& assignments) = 0;
+
+    /**
+     *  @brief Mark a set of chunks as completed.
+     *
+     *  Same as calling finishChunk() for each chunk, but needs far fewer
+     *  statements. This method will throw if query ID or any chunk number
+     *  is not known.
+     *
+     *  @param queryId:   Query ID, non-negative number.
+     *  @param chunks:    Chunk numbers.
+     */
+    virtual void finishChunks(QueryId queryId, std::vector<int> const& chunks) = 0;
+
     /**
      *  @brief Mark query as completed or failed.
      *
@@ -195,6 +241,18 @@ public:
      */
     virtual void finishQuery(QueryId queryId) = 0;
 
+    /**
+     *  @brief Store the resources a query used on the workers.
+     *
+     *  This should be called when the query completes, the values replace
+     *  those stored before.
+     *  This method will throw if query ID is not known.
+     *
+     *  @param queryId:   Query ID, non-negative number.
+     *  @param usage:     Resources used by all the jobs of the query.
+     */
+    virtual void saveQueryUsage(QueryId queryId, QUsage const& usage) = 0;
+
     /**
      *  @brief Generic interface for finding queries.
      *
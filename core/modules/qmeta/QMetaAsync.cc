@@ -0,0 +1,147 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <https://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "qmeta/QMetaAsync.h"
+
+// Qserv headers
+#include "global/intTypes.h"
+
+namespace lsst {
+namespace qserv {
+namespace qmeta {
+
+QMetaAsync::QMetaAsync(std::shared_ptr<QMeta> const& qMeta, QMetaWriteQueue::Ptr const& queue)
+    : QMeta(), _qMeta(qMeta), _queue(queue) {
+}
+
+CzarId QMetaAsync::getCzarID(std::string const& name) {
+    return _qMeta->getCzarID(name);
+}
+
+CzarId QMetaAsync::registerCzar(std::string const& name) {
+    _queue->flush();
+    return _qMeta->registerCzar(name);
+}
+
+void QMetaAsync::setCzarActive(CzarId czarId, bool active) {
+    _queue->flush();
+    _qMeta->setCzarActive(czarId, active);
+}
+
+void QMetaAsync::updateCzarLoad(CzarId czarId, QCzarLoad const& load) {
+    // load is not tied to query updates, no need to flush the queue
+    _qMeta->updateCzarLoad(czarId, load);
+}
+
+std::vector<QCzarLoad> QMetaAsync::getCzarLoads(unsigned maxAgeSec) {
+    return _qMeta->getCzarLoads(maxAgeSec);
+}
+
+void QMetaAsync::cleanup(CzarId czarId) {
+    _queue->flush();
+    _qMeta->cleanup(czarId);
+}
+
+QueryId QMetaAsync::registerQuery(QInfo const& qInfo, TableNames const& tables) {
+    // callers need the ID, and queued updates must not overtake it
+    return _qMeta->registerQuery(qInfo, tables);
+}
+
+void QMetaAsync::addChunks(QueryId queryId, std::vector<int> const& chunks) {
+    auto qMeta = _qMeta;
+    _queue->push([qMeta, queryId, chunks] { qMeta->addChunks(queryId, chunks); },
+                 QueryIdHelper::makeIdStr(queryId) + " addChunks");
+}
+
+void QMetaAsync::assignChunk(QueryId queryId, int chunk, std::string const& xrdEndpoint) {
+    auto qMeta = _qMeta;
+    _queue->push([qMeta, queryId, chunk, xrdEndpoint] { qMeta->assignChunk(queryId, chunk, xrdEndpoint); },
+                 QueryIdHelper::makeIdStr(queryId) + " assignChunk");
+}
+
+void QMetaAsync::finishChunk(QueryId queryId, int chunk) {
+    auto qMeta = _qMeta;
+    _queue->push([qMeta, queryId, chunk] { qMeta->finishChunk(queryId, chunk); },
+                 QueryIdHelper::makeIdStr(queryId) + " finishChunk");
+}
+
+void QMetaAsync::assignChunks(QueryId queryId,
+                              std::vector<std::pair<int, std::string>> const& assignments) {
+    auto qMeta = _qMeta;
+    _queue->push([qMeta, queryId, assignments] { qMeta->assignChunks(queryId, assignments); },
+                 QueryIdHelper::makeIdStr(queryId) + " assignChunks");
+}
+
+void QMetaAsync::finishChunks(QueryId queryId, std::vector<int> const& chunks) {
+    auto qMeta = _qMeta;
+    _queue->push([qMeta, queryId, chunks] { qMeta->finishChunks(queryId, chunks); },
+                 QueryIdHelper::makeIdStr(queryId) + " finishChunks");
+}
+
+void QMetaAsync::completeQuery(QueryId queryId, QInfo::QStatus qStatus) {
+    auto qMeta = _qMeta;
+    _queue->push([qMeta, queryId, qStatus] { qMeta->completeQuery(queryId, qStatus); },
+                 QueryIdHelper::makeIdStr(queryId) + " completeQuery");
+}
+
+void QMetaAsync::finishQuery(QueryId queryId) {
+    auto qMeta = _qMeta;
+    _queue->push([qMeta, queryId] { qMeta->finishQuery(queryId); },
+                 QueryIdHelper::makeIdStr(queryId) + " finishQuery");
+}
+
+void QMetaAsync::saveQueryUsage(QueryId queryId, QUsage const& usage) {
+    auto qMeta = _qMeta;
+    _queue->push([qMeta, queryId, usage] { qMeta->saveQueryUsage(queryId, usage); },
+                 QueryIdHelper::makeIdStr(queryId) + " saveQueryUsage");
+}
+
+std::vector<QueryId> QMetaAsync::findQueries(CzarId czarId, QInfo::QType qType, std::string const& user,
+                                             std::vector<QInfo::QStatus> const& status,
+                                             int completed, int returned) {
+    _queue->flush();
+    return _qMeta->findQueries(czarId, qType, user, status, completed, returned);
+}
+
+std::vector<QueryId> QMetaAsync::getPendingQueries(CzarId czarId) {
+    _queue->flush();
+    return _qMeta->getPendingQueries(czarId);
+}
+
+QInfo QMetaAsync::getQueryInfo(QueryId queryId) {
+    _queue->flush();
+    return _qMeta->getQueryInfo(queryId);
+}
+
+std::vector<QueryId> QMetaAsync::getQueriesForDb(std::string const& dbName) {
+    _queue->flush();
+    return _qMeta->getQueriesForDb(dbName);
+}
+
+std::vector<QueryId> QMetaAsync::getQueriesForTable(std::string const& dbName,
+                                                    std::string const& tableName) {
+    _queue->flush();
+    return _qMeta->getQueriesForTable(dbName, tableName);
+}
+
+}}} // namespace lsst::qserv::qmeta
@@ -0,0 +1,111 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <https://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_QMETA_QMETAASYNC_H
+#define LSST_QSERV_QMETA_QMETAASYNC_H
+
+// System headers
+#include <memory>
+
+// Qserv headers
+#include "qmeta/QMeta.h"
+#include "qmeta/QMetaWriteQueue.h"
+
+namespace lsst {
+namespace qserv {
+namespace qmeta {
+
+/// @addtogroup qmeta
+
+/**
+ *  @ingroup qmeta
+ *
+ *  @brief QMeta implementation deferring query updates to a write queue.
+ *
+ *  Chunk and query status updates are pushed to a QMetaWriteQueue and return
+ *  immediately, errors they run into are only logged. Czar and query
+ *  registration, cleanup and all lookups go to the wrapped instance right
+ *  away, lookups once the updates queued before them are written.
+ */
+class QMetaAsync : public QMeta {
+public:
+
+    /**
+     *  @param qMeta:  Instance doing the actual work.
+     *  @param queue:  Queue running the updates, may be shared.
+     */
+    QMetaAsync(std::shared_ptr<QMeta> const& qMeta, QMetaWriteQueue::Ptr const& queue);
+
+    virtual ~QMetaAsync() = default;
+
+    CzarId getCzarID(std::string const& name) override;
+    CzarId registerCzar(std::string const& name) override;
+    void setCzarActive(CzarId czarId, bool active) override;
+    void updateCzarLoad(CzarId czarId, QCzarLoad const& load) override;
+    std::vector<QCzarLoad> getCzarLoads(unsigned maxAgeSec) override;
+    void cleanup(CzarId czarId) override;
+    QueryId registerQuery(QInfo const& qInfo, TableNames const& tables) override;
+
+    /// @see QMeta, queued.
+    void addChunks(QueryId queryId, std::vector<int> const& chunks) override;
+
+    /// @see QMeta, queued.
+    void assignChunk(QueryId queryId, int chunk, std::string const& xrdEndpoint) override;
+
+    /// @see QMeta, queued.
+    void finishChunk(QueryId queryId, int chunk) override;
+
+    /// @see QMeta, queued.
+    void assignChunks(QueryId queryId,
+                      std::vector<std::pair<int, std::string>> const& assignments) override;
+
+    /// @see QMeta, queued.
+    void finishChunks(QueryId queryId, std::vector<int> const& chunks) override;
+
+    /// @see QMeta, queued.
+    void completeQuery(QueryId queryId, QInfo::QStatus qStatus) override;
+
+    /// @see QMeta, queued.
+    void finishQuery(QueryId queryId) override;
+
+    /// @see QMeta, queued.
+    void saveQueryUsage(QueryId queryId, QUsage const& usage) override;
+
+    std::vector<QueryId> findQueries(CzarId czarId=0,
+                                     QInfo::QType qType=QInfo::ANY,
+                                     std::string const& user=std::string(),
+                                     std::vector<QInfo::QStatus> const& status=std::vector<QInfo::QStatus>(),
+                                     int completed=-1,
+                                     int returned=-1) override;
+    std::vector<QueryId> getPendingQueries(CzarId czarId) override;
+    QInfo getQueryInfo(QueryId queryId) override;
+    std::vector<QueryId> getQueriesForDb(std::string const& dbName) override;
+    std::vector<QueryId> getQueriesForTable(std::string const& dbName,
+                                            std::string const& tableName) override;
+
+private:
+    std::shared_ptr<QMeta> const _qMeta;
+    QMetaWriteQueue::Ptr const _queue;
+};
+
+}}} // namespace lsst::qserv::qmeta
+
+#endif // LSST_QSERV_QMETA_QMETAASYNC_H
@@ -25,6 +25,7 @@
 
 // System headers
 #include <algorithm>
+#include <map>
 
 // Third-party headers
 #include "boost/lexical_cast.hpp"
@@ -43,8 +44,8 @@ namespace {
 
 // Current version of QMeta schema, to avoid conversion I define it as string,
 // change both when updating schema.
-int const VERSION = 1;
-char const VERSION_STR[] = "1";
+int const VERSION = 3;
+char const VERSION_STR[] = "3";
 
 LOG_LOGGER _log = LOG_GET("lsst.qserv.qmeta.QMetaMysql");
 
@@ -92,8 +93,8 @@ namespace qserv {
 namespace qmeta {
 
 // Constructors
-QMetaMysql::QMetaMysql(mysql::MySqlConfig const& mysqlConf)
-  : QMeta(), _conn(mysqlConf) {
+QMetaMysql::QMetaMysql(mysql::MySqlConfig const& mysqlConf, unsigned maxBatchRows)
+  : QMeta(), _conn(mysqlConf), _maxBatchRows(std::max(maxBatchRows, 1U)) {
     // Check that database is in consistent state
     _checkDb();
 }
@@ -240,6 +241,75 @@ QMetaMysql::setCzarActive(CzarId czarId, bool active) {
     trans.commit();
 }
 
+// Advertise the load of a czar.
+void
+QMetaMysql::updateCzarLoad(CzarId czarId, QCzarLoad const& load) {
+
+    std::lock_guard<std::mutex> sync(_dbMutex);
+
+    QMetaTransaction trans(_conn);
+
+    // run query, zero rows are updated if nothing changed within the same second
+    sql::SqlErrorObject errObj;
+    sql::SqlResults results;
+    std::string const query = "UPDATE QCzar SET loadTime = NOW()"
+            ", runningQueries = " + std::to_string(load.runningQueries) +
+            ", queuedQueries = " + std::to_string(load.queuedQueries) +
+            ", runningJobs = " + std::to_string(load.runningJobs) +
+            ", queuedJobs = " + std::to_string(load.queuedJobs) +
+            " WHERE czarId = " + std::to_string(czarId);
+    LOGS(_log, LOG_LVL_DEBUG, "Executing query: " << query);
+    if (not _conn.runQuery(query, results, errObj)) {
+        LOGS(_log, LOG_LVL_ERROR, "SQL query failed: " << query);
+        throw SqlError(ERR_LOC, errObj);
+    }
+
+    trans.commit();
+}
+
+// Return the loads of the active czars.
+std::vector<QCzarLoad>
+QMetaMysql::getCzarLoads(unsigned maxAgeSec) {
+
+    std::vector<QCzarLoad> result;
+
+    std::lock_guard<std::mutex> sync(_dbMutex);
+
+    QMetaTransaction trans(_conn);
+
+    // run query
+    sql::SqlErrorObject errObj;
+    sql::SqlResults results;
+    std::string const query = "SELECT czarId, czar, runningQueries, queuedQueries, runningJobs, queuedJobs"
+            " FROM QCzar WHERE active = b'1' AND loadTime >= NOW() - INTERVAL " +
+            std::to_string(maxAgeSec) + " SECOND ORDER BY czarId";
+    LOGS(_log, LOG_LVL_DEBUG, "Executing query: " << query);
+    if (not _conn.runQueryStreaming(query, results, errObj)) {
+        LOGS(_log, LOG_LVL_ERROR, "SQL query failed: " << query);
+        throw SqlError(ERR_LOC, errObj);
+    }
+
+    for (auto& row: results) {
+        QCzarLoad load;
+        load.czarId = boost::lexical_cast<CzarId>(row[0].first, row[0].second);
+        load.czarName = std::string(row[1].first, row[1].second);
+        load.runningQueries = boost::lexical_cast<uint32_t>(row[2].first, row[2].second);
+        load.queuedQueries = boost::lexical_cast<uint32_t>(row[3].first, row[3].second);
+        load.runningJobs = boost::lexical_cast<uint64_t>(row[4].first, row[4].second);
+        load.queuedJobs = boost::lexical_cast<uint64_t>(row[5].first, row[5].second);
+        result.push_back(load);
+    }
+    if (not results.checkStreamError(errObj)) {
+        LOGS(_log, LOG_LVL_ERROR, "Failed to extract czar loads from query result");
+        throw SqlError(ERR_LOC, errObj);
+    }
+    results.freeResults();
+
+    trans.commit();
+
+    return result;
+}
+
 // Cleanup of query status.
 void
 QMetaMysql::cleanup(CzarId czarId) {
@@ -352,16 +422,22 @@ QMetaMysql::addChunks(QueryId queryId, std::vector<int> const& chunks) {
 
     QMetaTransaction trans(_conn);
 
-    // register all tables
+    // register all chunks, _maxBatchRows rows per statement
     sql::SqlErrorObject errObj;
-    for (std::vector<int>::const_iterator itr = chunks.begin(); itr != chunks.end(); ++ itr) {
-        std::string query = "INSERT INTO QWorker (queryId, chunk) VALUES (";
-        query += boost::lexical_cast<std::string>(queryId);
-        query += ", ";
-        query += boost::lexical_cast<std::string>(*itr);
-        query += ")";
+    std::string const qIdStr = boost::lexical_cast<std::string>(queryId);
+    for (size_t begin = 0; begin < chunks.size(); begin += _maxBatchRows) {
+        size_t const end = std::min(chunks.size(), begin + _maxBatchRows);
+        std::string query = "INSERT INTO QWorker (queryId, chunk) VALUES ";
+        for (size_t i = begin; i != end; ++i) {
+            if (i != begin) query += ", ";
+            query += "(";
+            query += qIdStr;
+            query += ", ";
+            query += boost::lexical_cast<std::string>(chunks[i]);
+            query += ")";
+        }
 
-        LOGS(_log, LOG_LVL_DEBUG, "Executing query: " << query);
+        LOGS(_log, LOG_LVL_DEBUG, "Executing query: INSERT INTO QWorker, " << end - begin << " rows");
         if (not _conn.runQuery(query, errObj)) {
             LOGS(_log, LOG_LVL_ERROR, "SQL query failed: " << query);
             throw SqlError(ERR_LOC, errObj);
@@ -445,6 +521,51 @@ QMetaMysql::finishChunk(QueryId queryId, int chunk) {
     trans.commit();
 }
 
+// Assign or re-assign a set of chunks to workers.
+void
+QMetaMysql::assignChunks(QueryId queryId,
+                         std::vector<std::pair<int, std::string>> const& assignments) {
+
+    // one statement per worker and batch of chunks
+    std::map<std::string, std::vector<int>> chunksByWorker;
+    for (auto const& assignment: assignments) {
+        chunksByWorker[assignment.second].push_back(assignment.first);
+    }
+
+    std::lock_guard<std::mutex> sync(_dbMutex);
+
+    QMetaTransaction trans(_conn);
+
+    for (auto const& elem: chunksByWorker) {
+        std::string const set = "UPDATE QWorker SET wxrd = '" + _conn.escapeString(elem.first) +
+            "', submitted = NOW()";
+        for (size_t begin = 0; begin < elem.second.size(); begin += _maxBatchRows) {
+            size_t const end = std::min(elem.second.size(), begin + _maxBatchRows);
+            _updateChunks(set, queryId,
+                          std::vector<int>(elem.second.begin() + begin, elem.second.begin() + end));
+        }
+    }
+
+    trans.commit();
+}
+
+// Mark a set of chunks as completed.
+void
+QMetaMysql::finishChunks(QueryId queryId, std::vector<int> const& chunks) {
+
+    std::lock_guard<std::mutex> sync(_dbMutex);
+
+    QMetaTransaction trans(_conn);
+
+    for (size_t begin = 0; begin < chunks.size(); begin += _maxBatchRows) {
+        size_t const end = std::min(chunks.size(), begin + _maxBatchRows);
+        _updateChunks("UPDATE QWorker SET completed = NOW()", queryId,
+                      std::vector<int>(chunks.begin() + begin, chunks.begin() + end));
+    }
+
+    trans.commit();
+}
+
 // Mark query as completed or failed.
 void
 QMetaMysql::completeQuery(QueryId queryId, QInfo::QStatus qStatus) {
@@ -511,6 +632,54 @@ QMetaMysql::finishQuery(QueryId queryId) {
     trans.commit();
 }
 
+// Store the resources a query used on the workers.
+void
+QMetaMysql::saveQueryUsage(QueryId queryId, QUsage const& usage) {
+
+    std::lock_guard<std::mutex> sync(_dbMutex);
+
+    QMetaTransaction trans(_conn);
+
+    std::string query = "UPDATE QInfo SET cpuSeconds = ";
+    query += boost::lexical_cast<std::string>(usage.cpuUs / 1e6);
+    query += ", rowsRead = ";
+    query += boost::lexical_cast<std::string>(usage.rowsRead);
+    query += ", bytesTransmitted = ";
+    query += boost::lexical_cast<std::string>(usage.bytesTransmitted);
+    query += ", memLockedBytes = ";
+    query += boost::lexical_cast<std::string>(usage.memLockedBytes);
+    query += " WHERE queryId = ";
+    query += boost::lexical_cast<std::string>(queryId);
+
+    LOGS(_log, LOG_LVL_DEBUG, "Executing query: " << query);
+    sql::SqlErrorObject errObj;
+    sql::SqlResults results;
+    if (not _conn.runQuery(query, results, errObj)) {
+        LOGS(_log, LOG_LVL_ERROR, "SQL query failed: " << query);
+        throw SqlError(ERR_LOC, errObj);
+    }
+
+    // Unchanged values leave the row unchanged, only a missing query is an error.
+    if (results.getAffectedRows() == 0) {
+        std::string const check = "SELECT queryId FROM QInfo WHERE queryId = "
+                                  + boost::lexical_cast<std::string>(queryId);
+        sql::SqlResults checkResults;
+        if (not _conn.runQuery(check, checkResults, errObj)) {
+            LOGS(_log, LOG_LVL_ERROR, "SQL query failed: " << check);
+            throw SqlError(ERR_LOC, errObj);
+        }
+        std::vector<std::string> ids;
+        if (not checkResults.extractFirstColumn(ids, errObj)) {
+            throw SqlError(ERR_LOC, errObj);
+        }
+        if (ids.empty()) {
+            throw QueryIdError(ERR_LOC, queryId);
+        }
+    }
+
+    trans.commit();
+}
+
 // Generic interface for finding queries.
 std::vector<QueryId>
 QMetaMysql::findQueries(CzarId czarId,
@@ -567,25 +736,23 @@ QMetaMysql::findQueries(CzarId czarId,
         query += *itr;
     }
     LOGS(_log, LOG_LVL_DEBUG, "Executing query: " << query);
-    if (not _conn.runQuery(query, results, errObj)) {
+    if (not _conn.runQueryStreaming(query, results, errObj)) {
         LOGS(_log, LOG_LVL_ERROR, "SQL query failed: " << query);
         throw SqlError(ERR_LOC, errObj);
     }
 
-    // get results of the query
-    std::vector<std::string> ids;
-    if (not results.extractFirstColumn(ids, errObj)) {
+    // convert to numbers as the rows are read
+    for (auto& row: results) {
+        result.push_back(boost::lexical_cast<QueryId>(row[0].first, row[0].second));
+    }
+    if (not results.checkStreamError(errObj)) {
         LOGS(_log, LOG_LVL_ERROR, "Failed to extract query ID from query result");
         throw SqlError(ERR_LOC, errObj);
     }
+    results.freeResults();
 
     trans.commit();
 
-    // convert strings to numbers
-    result.reserve(ids.size());
-    std::transform(ids.begin(), ids.end(), std::back_inserter(result),
-                   boost::lexical_cast<QueryId, std::string>);
-
     return result;
 }
 
@@ -606,25 +773,23 @@ QMetaMysql::getPendingQueries(CzarId czarId) {
     query += boost::lexical_cast<std::string>(czarId);
     query += " AND returned IS NULL";
     LOGS(_log, LOG_LVL_DEBUG, "Executing query: " << query);
-    if (not _conn.runQuery(query, results, errObj)) {
+    if (not _conn.runQueryStreaming(query, results, errObj)) {
         LOGS(_log, LOG_LVL_ERROR, "SQL query failed: " << query);
         throw SqlError(ERR_LOC, errObj);
     }
 
-    // get results of the query
-    std::vector<std::string> ids;
-    if (not results.extractFirstColumn(ids, errObj)) {
+    // convert to numbers as the rows are read
+    for (auto& row: results) {
+        result.push_back(boost::lexical_cast<QueryId>(row[0].first, row[0].second));
+    }
+    if (not results.checkStreamError(errObj)) {
         LOGS(_log, LOG_LVL_ERROR, "Failed to extract query ID from query result");
         throw SqlError(ERR_LOC, errObj);
     }
+    results.freeResults();
 
     trans.commit();
 
-    // convert strings to numbers
-    result.reserve(ids.size());
-    std::transform(ids.begin(), ids.end(), std::back_inserter(result),
-                   boost::lexical_cast<QueryId, std::string>);
-
     return result;
 }
 
@@ -707,25 +872,23 @@ QMetaMysql::getQueriesForDb(std::string const& dbName) {
     query += _conn.escapeString(dbName);
     query += "' AND QInfo.completed IS NULL";
     LOGS(_log, LOG_LVL_DEBUG, "Executing query: " << query);
-    if (not _conn.runQuery(query, results, errObj)) {
+    if (not _conn.runQueryStreaming(query, results, errObj)) {
         LOGS(_log, LOG_LVL_ERROR, "SQL query failed: " << query);
         throw SqlError(ERR_LOC, errObj);
     }
 
-    // get results of the query
-    std::vector<std::string> ids;
-    if (not results.extractFirstColumn(ids, errObj)) {
+    // convert to numbers as the rows are read
+    for (auto& row: results) {
+        result.push_back(boost::lexical_cast<QueryId>(row[0].first, row[0].second));
+    }
+    if (not results.checkStreamError(errObj)) {
         LOGS(_log, LOG_LVL_ERROR, "Failed to extract query ID from query result");
         throw SqlError(ERR_LOC, errObj);
     }
+    results.freeResults();
 
     trans.commit();
 
-    // convert strings to numbers
-    result.reserve(ids.size());
-    std::transform(ids.begin(), ids.end(), std::back_inserter(result),
-                   boost::lexical_cast<QueryId, std::string>);
-
     return result;
 }
 
@@ -749,28 +912,75 @@ QMetaMysql::getQueriesForTable(std::string const& dbName,
     query += _conn.escapeString(tableName);
     query += "' AND QInfo.completed IS NULL";
     LOGS(_log, LOG_LVL_DEBUG, "Executing query: " << query);
-    if (not _conn.runQuery(query, results, errObj)) {
+    if (not _conn.runQueryStreaming(query, results, errObj)) {
         LOGS(_log, LOG_LVL_ERROR, "SQL query failed: " << query);
         throw SqlError(ERR_LOC, errObj);
     }
 
-    // get results of the query
-    std::vector<std::string> ids;
-    if (not results.extractFirstColumn(ids, errObj)) {
+    // convert to numbers as the rows are read
+    for (auto& row: results) {
+        result.push_back(boost::lexical_cast<QueryId>(row[0].first, row[0].second));
+    }
+    if (not results.checkStreamError(errObj)) {
         LOGS(_log, LOG_LVL_ERROR, "Failed to extract query ID from query result");
         throw SqlError(ERR_LOC, errObj);
     }
+    results.freeResults();
 
     trans.commit();
 
-    // convert strings to numbers
-    result.reserve(ids.size());
-    std::transform(ids.begin(), ids.end(), std::back_inserter(result),
-                   boost::lexical_cast<QueryId, std::string>);
-
     return result;
 }
 
+// Update QWorker rows of a set of chunks.
+void
+QMetaMysql::_updateChunks(std::string const& query, QueryId queryId, std::vector<int> const& chunks) {
+
+    std::string chunkList;
+    for (int chunk: chunks) {
+        if (not chunkList.empty()) chunkList += ", ";
+        chunkList += boost::lexical_cast<std::string>(chunk);
+    }
+    std::string const where = " WHERE queryId = " + boost::lexical_cast<std::string>(queryId) +
+        " AND chunk IN (" + chunkList + ")";
+
+    sql::SqlErrorObject errObj;
+    LOGS(_log, LOG_LVL_DEBUG, "Executing query: " << query << where);
+    sql::SqlResults results;
+    if (not _conn.runQuery(query + where, results, errObj)) {
+        LOGS(_log, LOG_LVL_ERROR, "SQL query failed: " << query << where);
+        throw SqlError(ERR_LOC, errObj);
+    }
+    if (results.getAffectedRows() == chunks.size()) {
+        return;
+    } else if (results.getAffectedRows() > chunks.size()) {
+        throw ConsistencyError(ERR_LOC, "More than one row updated for query ID " +
+                               boost::lexical_cast<std::string>(queryId) + " and chunks " +
+                               chunkList + ": " +
+                               boost::lexical_cast<std::string>(results.getAffectedRows()));
+    }
+
+    // Fewer rows changed than chunks given, either some chunk is not known
+    // or a row already had the new values (or a chunk was listed twice).
+    std::string const select = "SELECT chunk FROM QWorker" + where;
+    sql::SqlResults found;
+    if (not _conn.runQuery(select, found, errObj)) {
+        LOGS(_log, LOG_LVL_ERROR, "SQL query failed: " << select);
+        throw SqlError(ERR_LOC, errObj);
+    }
+    std::vector<std::string> foundChunks;
+    if (not found.extractFirstColumn(foundChunks, errObj)) {
+        LOGS(_log, LOG_LVL_ERROR, "Failed to extract chunk numbers from query result");
+        throw SqlError(ERR_LOC, errObj);
+    }
+    for (int chunk: chunks) {
+        if (std::find(foundChunks.begin(), foundChunks.end(),
+                      boost::lexical_cast<std::string>(chunk)) == foundChunks.end()) {
+            throw ChunkIdError(ERR_LOC, queryId, chunk);
+        }
+    }
+}
+
 // Check that all necessary tables exist or create them
 void
 QMetaMysql::_checkDb() {
@@ -49,8 +49,10 @@ public:
 
     /**
      *  @param mysqlConf: Configuration object for mysql connection
+     *  @param maxBatchRows: Maximum number of chunks written by one statement
+     *                       in addChunks(), assignChunks() and finishChunks().
      */
-    QMetaMysql(mysql::MySqlConfig const& mysqlConf);
+    QMetaMysql(mysql::MySqlConfig const& mysqlConf, unsigned maxBatchRows=1000);
 
     // Instances cannot be copied
     QMetaMysql(QMetaMysql const&) = delete;
@@ -91,6 +93,22 @@ public:
      */
     virtual void setCzarActive(CzarId czarId, bool active) override;
 
+    /**
+     *  @brief Advertise the load of a czar to the other czars.
+     *
+     *  @param czarId:  Czar ID, non-negative number.
+     *  @param load:    Current load of the czar.
+     */
+    virtual void updateCzarLoad(CzarId czarId, QCzarLoad const& load) override;
+
+    /**
+     *  @brief Return the loads of the active czars.
+     *
+     *  @param maxAgeSec:  Loads updated longer ago than this are left out.
+     *  @return: Loads of the czars, in czar ID order.
+     */
+    virtual std::vector<QCzarLoad> getCzarLoads(unsigned maxAgeSec) override;
+
     /**
      *  @brief Cleanup of query status.
      *
@@ -117,6 +135,8 @@ public:
     /**
      *  @brief Add list of chunks to query.
      *
+     *  Chunks are inserted with multi-row statements of up to maxBatchRows
+     *  rows each, all in one transaction.
      *  This method will throw if query ID is not known.
      *
      *  @param queryId:   Query ID, non-negative number.
@@ -147,6 +167,29 @@ public:
      */
     virtual void finishChunk(QueryId queryId, int chunk) override;
 
+    /**
+     *  @brief Assign or re-assign a set of chunks to workers.
+     *
+     *  Each batch of up to maxBatchRows chunks is updated by one statement.
+     *  This method will throw if query ID or any chunk number is not known.
+     *
+     *  @param queryId:      Query ID, non-negative number.
+     *  @param assignments:  Chunk number and worker xrootd endpoint of each chunk.
+     */
+    virtual void assignChunks(QueryId queryId,
+                              std::vector<std::pair<int, std::string>> const& assignments) override;
+
+    /**
+     *  @brief Mark a set of chunks as completed.
+     *
+     *  Each batch of up to maxBatchRows chunks is updated by one statement.
+     *  This method will throw if query ID or any chunk number is not known.
+     *
+     *  @param queryId:   Query ID, non-negative number.
+     *  @param chunks:    Chunk numbers.
+     */
+    virtual void finishChunks(QueryId queryId, std::vector<int> const& chunks) override;
+
     /**
      *  @brief Mark query as completed or failed.
      *
@@ -170,6 +213,16 @@ public:
      */
     virtual void finishQuery(QueryId queryId) override;
 
+    /**
+     *  @brief Store the resources a query used on the workers.
+     *
+     *  This method will throw if query ID is not known.
+     *
+     *  @param queryId:   Query ID, non-negative number.
+     *  @param usage:     Resources used by all the jobs of the query.
+     */
+    virtual void saveQueryUsage(QueryId queryId, QUsage const& usage) override;
+
     /**
      *  @brief Generic interface for finding queries.
      *
@@ -255,7 +308,13 @@ protected:
 
 private:
 
+    /// Run a statement updating QWorker rows of 'chunks', throw unless
+    /// exactly one row was updated for each chunk.
+    /// Precondition: _dbMutex must be held.
+    void _updateChunks(std::string const& query, QueryId queryId, std::vector<int> const& chunks);
+
     sql::SqlConnection _conn;
+    unsigned const _maxBatchRows;   ///< Maximum number of chunks per statement
     std::mutex _dbMutex;    ///< Synchronizes access to certain DB operations
 
 };
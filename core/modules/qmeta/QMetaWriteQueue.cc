@@ -0,0 +1,143 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <https://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "qmeta/QMetaWriteQueue.h"
+
+// System headers
+#include <algorithm>
+#include <exception>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "qmeta/Exceptions.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.qmeta.QMetaWriteQueue");
+
+}
+
+namespace lsst {
+namespace qserv {
+namespace qmeta {
+
+QMetaWriteQueue::QMetaWriteQueue(size_t maxPending, unsigned maxRetries,
+                                 std::chrono::milliseconds retryDelay)
+    : _maxPending(std::max(maxPending, size_t(1))), _maxRetries(maxRetries), _retryDelay(retryDelay),
+      _thread(&QMetaWriteQueue::_run, this) {
+}
+
+QMetaWriteQueue::~QMetaWriteQueue() {
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _stop = true;
+    }
+    _workCv.notify_all();
+    _thread.join();
+}
+
+void QMetaWriteQueue::push(Op const& op, std::string const& what, std::string const& coalesceKey) {
+    std::unique_lock<std::mutex> lock(_mtx);
+    if (not coalesceKey.empty()) {
+        auto iter = _coalescing.find(coalesceKey);
+        if (iter != _coalescing.end()) {
+            // keep the position of the waiting item, so order is preserved
+            iter->second->op = op;
+            iter->second->what = what;
+            return;
+        }
+    }
+    _spaceCv.wait(lock, [this] { return _pending.size() < _maxPending; });
+    auto item = std::make_shared<Item>(Item{op, what, coalesceKey, ++_pushedSeq});
+    _pending.push_back(item);
+    if (not coalesceKey.empty()) {
+        _coalescing[coalesceKey] = item;
+    }
+    lock.unlock();
+    _workCv.notify_one();
+}
+
+void QMetaWriteQueue::flush() {
+    std::unique_lock<std::mutex> lock(_mtx);
+    uint64_t const seq = _pushedSeq;
+    _doneCv.wait(lock, [this, seq] { return _doneSeq >= seq; });
+}
+
+uint64_t QMetaWriteQueue::getFailedCount() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _failed;
+}
+
+void QMetaWriteQueue::_run() {
+    std::unique_lock<std::mutex> lock(_mtx);
+    while (true) {
+        _workCv.wait(lock, [this] { return _stop or not _pending.empty(); });
+        if (_pending.empty()) {
+            // _stop is set and everything was written
+            break;
+        }
+        std::deque<std::shared_ptr<Item>> batch;
+        batch.swap(_pending);
+        _coalescing.clear();
+        lock.unlock();
+        _spaceCv.notify_all();
+
+        LOGS(_log, LOG_LVL_DEBUG, "running " << batch.size() << " queued updates");
+        for (auto const& item: batch) {
+            _runOp(*item);
+        }
+
+        lock.lock();
+        _doneSeq = batch.back()->seq;
+        _doneCv.notify_all();
+    }
+}
+
+void QMetaWriteQueue::_runOp(Item const& item) {
+    auto delay = _retryDelay;
+    for (unsigned attempt = 0; ; ++attempt) {
+        try {
+            item.op();
+            return;
+        } catch (SqlError const& exc) {
+            if (attempt >= _maxRetries) {
+                LOGS(_log, LOG_LVL_ERROR, "giving up on " << item.what << " after "
+                     << attempt + 1 << " attempts: " << exc.what());
+                break;
+            }
+            LOGS(_log, LOG_LVL_WARN, item.what << " failed, retrying in " << delay.count()
+                 << " ms: " << exc.what());
+        } catch (std::exception const& exc) {
+            LOGS(_log, LOG_LVL_ERROR, item.what << " failed: " << exc.what());
+            break;
+        }
+        std::this_thread::sleep_for(delay);
+        delay *= 2;
+    }
+    std::lock_guard<std::mutex> lock(_mtx);
+    ++_failed;
+}
+
+}}} // namespace lsst::qserv::qmeta
@@ -0,0 +1,123 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <https://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_QMETA_QMETAWRITEQUEUE_H
+#define LSST_QSERV_QMETA_QMETAWRITEQUEUE_H
+
+// System headers
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace lsst {
+namespace qserv {
+namespace qmeta {
+
+/// @addtogroup qmeta
+
+/**
+ *  @ingroup qmeta
+ *
+ *  @brief Write-behind queue for metadata updates.
+ *
+ *  Operations are run one at a time by a single thread, in the order they
+ *  were pushed, so updates of the same query are applied in order. The
+ *  thread takes all queued operations at once, and an operation pushed with
+ *  the same coalescing key as one still waiting replaces it. An operation
+ *  failing with SqlError is tried again after a delay that doubles each time,
+ *  other errors are logged and the operation dropped.
+ *
+ *  push() blocks while maxPending operations are waiting, which bounds the
+ *  memory used when the database is slow.
+ */
+class QMetaWriteQueue {
+public:
+    typedef std::shared_ptr<QMetaWriteQueue> Ptr;
+    typedef std::function<void()> Op;
+
+    /**
+     *  @param maxPending:  Number of waiting operations at which push() blocks.
+     *  @param maxRetries:  Number of times a failed operation is tried again.
+     *  @param retryDelay:  Delay before the first retry.
+     */
+    QMetaWriteQueue(size_t maxPending, unsigned maxRetries, std::chrono::milliseconds retryDelay);
+
+    QMetaWriteQueue(QMetaWriteQueue const&) = delete;
+    QMetaWriteQueue& operator=(QMetaWriteQueue const&) = delete;
+
+    /// Run the operations still waiting and stop the thread.
+    ~QMetaWriteQueue();
+
+    /**
+     *  @brief Queue an operation.
+     *
+     *  @param op:           The operation.
+     *  @param what:         Description of the operation, for the log.
+     *  @param coalesceKey:  If not empty, replaces a waiting operation pushed
+     *                       with the same key.
+     */
+    void push(Op const& op, std::string const& what, std::string const& coalesceKey=std::string());
+
+    /// Wait until all operations pushed before this call are done.
+    void flush();
+
+    /// @return the number of operations that were dropped after failing.
+    uint64_t getFailedCount() const;
+
+private:
+    struct Item {
+        Op op;
+        std::string what;
+        std::string coalesceKey;
+        uint64_t seq;
+    };
+
+    void _run();
+    void _runOp(Item const& item);
+
+    size_t const _maxPending;
+    unsigned const _maxRetries;
+    std::chrono::milliseconds const _retryDelay;
+
+    mutable std::mutex _mtx;                ///< Protects all members below
+    std::condition_variable _workCv;        ///< Signalled when operations are pushed or on stop
+    std::condition_variable _spaceCv;       ///< Signalled when waiting operations are taken
+    std::condition_variable _doneCv;        ///< Signalled when operations are done
+    std::deque<std::shared_ptr<Item>> _pending;
+    std::unordered_map<std::string, std::shared_ptr<Item>> _coalescing; ///< Waiting items by key
+    uint64_t _pushedSeq{0};                 ///< Sequence number of the last item pushed
+    uint64_t _doneSeq{0};                   ///< Sequence number of the last item done
+    uint64_t _failed{0};
+    bool _stop{false};
+
+    std::thread _thread;
+};
+
+}}} // namespace lsst::qserv::qmeta
+
+#endif // LSST_QSERV_QMETA_QMETAWRITEQUEUE_H
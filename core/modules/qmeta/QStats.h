@@ -23,6 +23,7 @@
 #define LSST_QSERV_QMETA_QSTATS_H
 
 // System headers
+#include <cstdint>
 #include <ctime>
 #include <string>
 
@@ -49,6 +50,8 @@ struct QStats {
     int completedChunks{0}; ///< Number of chunks that have been searched.
     std::time_t begin{0}; ///< Time the query was started.
     std::time_t lastUpdate{0}; ///< Last time this row was updated.
+    uint64_t mergedBytes{0}; ///< Result bytes merged so far, only known to the query's czar.
+    uint64_t mergedRows{0}; ///< Result rows merged so far, only known to the query's czar.
 };
 
 }}} // namespace lsst::qserv::qmeta
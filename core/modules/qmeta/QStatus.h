@@ -23,6 +23,7 @@
 #define LSST_QSERV_QMETA_QSTATUS_H
 
 // System headers
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <string>
@@ -64,6 +65,10 @@ public:
     /// @throw SqlError
     virtual void queryStatsTmpChunkUpdate(QueryId queryId, int completedChunks) = 0;
 
+    /// Add result bytes and rows merged for the query. Implementations
+    /// that do not track them ignore this.
+    virtual void queryStatsTmpMergeUpdate(QueryId queryId, uint64_t bytes, uint64_t rows) {}
+
     /// Get statistics for queryId
     /// @return QStats object containing query completion information.
     /// @throw QueryIdError, SqlError
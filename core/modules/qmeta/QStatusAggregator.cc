@@ -0,0 +1,157 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <https://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "qmeta/QStatusAggregator.h"
+
+// System headers
+#include <ctime>
+#include <utility>
+#include <vector>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "global/intTypes.h"
+#include "qmeta/Exceptions.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.qmeta.QStatusAggregator");
+
+}
+
+namespace lsst {
+namespace qserv {
+namespace qmeta {
+
+QStatusAggregator::QStatusAggregator(QStatus::Ptr const& qStatus, std::chrono::milliseconds flushInterval)
+    : QStatus(), _qStatus(qStatus), _flushInterval(flushInterval),
+      _thread(&QStatusAggregator::_run, this) {
+}
+
+QStatusAggregator::~QStatusAggregator() {
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _stop = true;
+    }
+    _stopCv.notify_all();
+    _thread.join();
+    flush();
+}
+
+void QStatusAggregator::createQueryStatsTmpTable() {
+    _qStatus->createQueryStatsTmpTable();
+}
+
+void QStatusAggregator::queryStatsTmpRegister(QueryId queryId, int totalChunks) {
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        std::time_t const now = std::time(nullptr);
+        _queries[queryId].stats = QStats(queryId, totalChunks, 0, now, now);
+    }
+    _qStatus->queryStatsTmpRegister(queryId, totalChunks);
+}
+
+void QStatusAggregator::queryStatsTmpChunkUpdate(QueryId queryId, int completedChunks) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    auto iter = _queries.find(queryId);
+    if (iter == _queries.end()) {
+        return;
+    }
+    iter->second.stats.completedChunks = completedChunks;
+    iter->second.stats.lastUpdate = std::time(nullptr);
+    iter->second.dirty = true;
+}
+
+void QStatusAggregator::queryStatsTmpMergeUpdate(QueryId queryId, uint64_t bytes, uint64_t rows) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    auto iter = _queries.find(queryId);
+    if (iter == _queries.end()) {
+        return;
+    }
+    iter->second.stats.mergedBytes += bytes;
+    iter->second.stats.mergedRows += rows;
+}
+
+QStats QStatusAggregator::queryStatsTmpGet(QueryId queryId) {
+    QStats stats;
+    if (getLocal(queryId, stats)) {
+        return stats;
+    }
+    return _qStatus->queryStatsTmpGet(queryId);
+}
+
+void QStatusAggregator::queryStatsTmpRemove(QueryId queryId) {
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _queries.erase(queryId);
+    }
+    _qStatus->queryStatsTmpRemove(queryId);
+}
+
+bool QStatusAggregator::getLocal(QueryId queryId, QStats& stats) const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    auto iter = _queries.find(queryId);
+    if (iter == _queries.end()) {
+        return false;
+    }
+    stats = iter->second.stats;
+    return true;
+}
+
+void QStatusAggregator::flush() {
+    std::lock_guard<std::mutex> flushLock(_flushMtx);
+    std::vector<std::pair<QueryId, int>> rows;
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        for (auto& elem: _queries) {
+            if (elem.second.dirty) {
+                elem.second.dirty = false;
+                rows.emplace_back(elem.first, elem.second.stats.completedChunks);
+            }
+        }
+    }
+    for (auto const& row: rows) {
+        // This is not vital, if it fails keep going.
+        try {
+            _qStatus->queryStatsTmpChunkUpdate(row.first, row.second);
+        } catch (SqlError const& exc) {
+            LOGS(_log, LOG_LVL_WARN, QueryIdHelper::makeIdStr(row.first)
+                 << " failed to update QStatsTmp " << exc.what());
+        }
+    }
+}
+
+void QStatusAggregator::_run() {
+    std::unique_lock<std::mutex> lock(_mtx);
+    while (not _stop) {
+        _stopCv.wait_for(lock, _flushInterval, [this] { return _stop; });
+        if (_stop) break;
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
+
+}}} // namespace lsst::qserv::qmeta
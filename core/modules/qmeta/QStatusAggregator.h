@@ -0,0 +1,104 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <https://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_QMETA_QSTATUSAGGREGATOR_H
+#define LSST_QSERV_QMETA_QSTATUSAGGREGATOR_H
+
+// System headers
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Qserv headers
+#include "qmeta/QStatus.h"
+
+namespace lsst {
+namespace qserv {
+namespace qmeta {
+
+/// QStatus implementation keeping the progress of the czar's queries in
+/// memory. Registration and removal go to the wrapped instance right away,
+/// but progress updates only change the in-memory counts, and a thread
+/// writes one row for each query that progressed every flush interval.
+/// Merged bytes and rows are only kept in memory.
+class QStatusAggregator : public QStatus {
+public:
+    typedef std::shared_ptr<QStatusAggregator> Ptr;
+
+    /// @param qStatus - instance writing the rows.
+    /// @param flushInterval - time between writes of the progressed rows.
+    QStatusAggregator(QStatus::Ptr const& qStatus, std::chrono::milliseconds flushInterval);
+
+    /// Write the progressed rows one last time and stop the thread.
+    virtual ~QStatusAggregator();
+
+    /// @see QStatus::createQueryStatsTmpTable()
+    void createQueryStatsTmpTable() override;
+
+    /// @see QStatus::queryStatsTmpRegister(QueryId queryId, int totalChunks)
+    void queryStatsTmpRegister(QueryId queryId, int totalChunks) override;
+
+    /// @see QStatus::queryStatsTmpChunkUpdate(QueryId queryId, int completedChunks)
+    void queryStatsTmpChunkUpdate(QueryId queryId, int completedChunks) override;
+
+    /// @see QStatus::queryStatsTmpMergeUpdate(QueryId queryId, uint64_t bytes, uint64_t rows)
+    void queryStatsTmpMergeUpdate(QueryId queryId, uint64_t bytes, uint64_t rows) override;
+
+    /// @see QStatus::queryStatsTmpGet(QueryId queryId), from memory for
+    /// the queries of this czar.
+    QStats queryStatsTmpGet(QueryId queryId) override;
+
+    /// @see QStatus::queryStatsTmpRemove(QueryId queryId)
+    void queryStatsTmpRemove(QueryId queryId) override;
+
+    /// Get the statistics of a query of this czar without database access.
+    /// @return false if the query is not known to this czar.
+    bool getLocal(QueryId queryId, QStats& stats) const;
+
+    /// Write the rows of the queries that progressed since the last flush.
+    void flush();
+
+private:
+    struct Entry {
+        QStats stats;
+        bool dirty{false}; ///< True if completedChunks changed since the last flush
+    };
+
+    void _run();
+
+    QStatus::Ptr const _qStatus;
+    std::chrono::milliseconds const _flushInterval;
+
+    mutable std::mutex _mtx;           ///< Protects _queries and _stop
+    std::map<QueryId, Entry> _queries;
+    std::condition_variable _stopCv;
+    bool _stop{false};
+    std::mutex _flushMtx;              ///< Keeps the rows of concurrent flushes in order
+
+    std::thread _thread;
+};
+
+}}} // namespace lsst::qserv::qmeta
+
+#endif // LSST_QSERV_QMETA_QSTATUSAGGREGATOR_H
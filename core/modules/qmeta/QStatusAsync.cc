@@ -0,0 +1,69 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <https://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "qmeta/QStatusAsync.h"
+
+// System headers
+#include <string>
+
+// Qserv headers
+#include "global/intTypes.h"
+
+namespace lsst {
+namespace qserv {
+namespace qmeta {
+
+QStatusAsync::QStatusAsync(QStatus::Ptr const& qStatus, QMetaWriteQueue::Ptr const& queue)
+    : QStatus(), _qStatus(qStatus), _queue(queue) {
+}
+
+void QStatusAsync::createQueryStatsTmpTable() {
+    _qStatus->createQueryStatsTmpTable();
+}
+
+void QStatusAsync::queryStatsTmpRegister(QueryId queryId, int totalChunks) {
+    auto qStatus = _qStatus;
+    _queue->push([qStatus, queryId, totalChunks] { qStatus->queryStatsTmpRegister(queryId, totalChunks); },
+                 QueryIdHelper::makeIdStr(queryId) + " queryStatsTmpRegister");
+}
+
+void QStatusAsync::queryStatsTmpChunkUpdate(QueryId queryId, int completedChunks) {
+    auto qStatus = _qStatus;
+    std::string const what = QueryIdHelper::makeIdStr(queryId) + " queryStatsTmpChunkUpdate";
+    _queue->push([qStatus, queryId, completedChunks] {
+                     qStatus->queryStatsTmpChunkUpdate(queryId, completedChunks);
+                 }, what, what);
+}
+
+QStats QStatusAsync::queryStatsTmpGet(QueryId queryId) {
+    _queue->flush();
+    return _qStatus->queryStatsTmpGet(queryId);
+}
+
+void QStatusAsync::queryStatsTmpRemove(QueryId queryId) {
+    auto qStatus = _qStatus;
+    _queue->push([qStatus, queryId] { qStatus->queryStatsTmpRemove(queryId); },
+                 QueryIdHelper::makeIdStr(queryId) + " queryStatsTmpRemove");
+}
+
+}}} // namespace lsst::qserv::qmeta
@@ -0,0 +1,71 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <https://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_QMETA_QSTATUSASYNC_H
+#define LSST_QSERV_QMETA_QSTATUSASYNC_H
+
+// System headers
+#include <memory>
+
+// Qserv headers
+#include "qmeta/QMetaWriteQueue.h"
+#include "qmeta/QStatus.h"
+
+namespace lsst {
+namespace qserv {
+namespace qmeta {
+
+/// QStatus implementation deferring its updates to a write queue.
+/// Progress updates of a query still waiting in the queue are replaced by
+/// newer ones, as only the last count matters.
+class QStatusAsync : public QStatus {
+public:
+    typedef std::shared_ptr<QStatusAsync> Ptr;
+
+    /// @param qStatus - instance doing the actual work.
+    /// @param queue - queue running the updates, may be shared.
+    QStatusAsync(QStatus::Ptr const& qStatus, QMetaWriteQueue::Ptr const& queue);
+
+    virtual ~QStatusAsync() = default;
+
+    /// @see QStatus::createQueryStatsTmpTable(), not queued.
+    void createQueryStatsTmpTable() override;
+
+    /// @see QStatus::queryStatsTmpRegister(QueryId queryId, int totalChunks), queued.
+    void queryStatsTmpRegister(QueryId queryId, int totalChunks) override;
+
+    /// @see QStatus::queryStatsTmpChunkUpdate(QueryId queryId, int completedChunks), queued.
+    void queryStatsTmpChunkUpdate(QueryId queryId, int completedChunks) override;
+
+    /// @see QStatus::queryStatsTmpGet(QueryId queryId), after queued updates are done.
+    QStats queryStatsTmpGet(QueryId queryId) override;
+
+    /// @see QStatus::queryStatsTmpRemove(QueryId queryId), queued.
+    void queryStatsTmpRemove(QueryId queryId) override;
+
+private:
+    QStatus::Ptr const _qStatus;
+    QMetaWriteQueue::Ptr const _queue;
+};
+
+}}} // namespace lsst::qserv::qmeta
+
+#endif // LSST_QSERV_QMETA_QSTATUSASYNC_H
@@ -0,0 +1,51 @@
+/*
+ * LSST Data Management System
+ * Copyright 2019 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_QMETA_QUSAGE_H
+#define LSST_QSERV_QMETA_QUSAGE_H
+
+// System headers
+#include <cstdint>
+
+namespace lsst {
+namespace qserv {
+namespace qmeta {
+
+/// Resources used by a user query on the workers, summed over all the
+/// attempts of its jobs, as kept in QInfo for accounting.
+struct QUsage {
+    uint64_t cpuUs{0}; ///< CPU time of the worker threads running the tasks.
+    uint64_t rowsRead{0}; ///< Rows read by MySQL on the workers.
+    uint64_t bytesTransmitted{0}; ///< Result bytes received by the czar.
+    uint64_t memLockedBytes{0}; ///< Bytes of tables memman locked for the tasks.
+
+    QUsage& operator+=(QUsage const& other) {
+        cpuUs += other.cpuUs;
+        rowsRead += other.rowsRead;
+        bytesTransmitted += other.bytesTransmitted;
+        memLockedBytes += other.memLockedBytes;
+        return *this;
+    }
+};
+
+}}} // namespace lsst::qserv::qmeta
+
+#endif // LSST_QSERV_QMETA_QUSAGE_H
@@ -99,6 +99,8 @@ PYBIND11_MODULE(qmetaLib, mod) {
         .def("addChunks", &QMeta::addChunks)
         .def("assignChunk", &QMeta::assignChunk)
         .def("finishChunk", &QMeta::finishChunk)
+        .def("assignChunks", &QMeta::assignChunks)
+        .def("finishChunks", &QMeta::finishChunks)
         .def("completeQuery", &QMeta::completeQuery)
         .def("finishQuery", &QMeta::finishQuery)
         .def("findQueries", &QMeta::findQueries,
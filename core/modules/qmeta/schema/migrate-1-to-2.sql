@@ -0,0 +1,15 @@
+--
+-- Migration script from version 1 to version 2 of QMeta database:
+--   - QInfo table adds columns for the resources used by the query on workers
+--
+
+
+-- -----------------------------------------------------
+-- Add new columns to table `QInfo`
+-- -----------------------------------------------------
+ALTER TABLE `QInfo` ADD COLUMN (
+  `cpuSeconds` DOUBLE NULL COMMENT 'CPU time of the worker threads running the query tasks, NULL until the query completes.',
+  `rowsRead` BIGINT UNSIGNED NULL COMMENT 'Rows read by MySQL on the workers, from its Handler_read counters.',
+  `bytesTransmitted` BIGINT UNSIGNED NULL COMMENT 'Result bytes sent by the workers to the czar.',
+  `memLockedBytes` BIGINT UNSIGNED NULL COMMENT 'Bytes of tables locked in memory for the query tasks.'
+);
@@ -0,0 +1,16 @@
+--
+-- Migration script from version 2 to version 3 of QMeta database:
+--   - QCzar table adds columns for the load each czar advertises to the others
+--
+
+
+-- -----------------------------------------------------
+-- Add new columns to table `QCzar`
+-- -----------------------------------------------------
+ALTER TABLE `QCzar` ADD COLUMN (
+  `loadTime` TIMESTAMP NULL DEFAULT NULL COMMENT 'Time of the last load update, NULL if never advertised',
+  `runningQueries` INT UNSIGNED NOT NULL DEFAULT 0 COMMENT 'Queries dispatching or merging',
+  `queuedQueries` INT UNSIGNED NOT NULL DEFAULT 0 COMMENT 'Queries waiting for admission',
+  `runningJobs` BIGINT UNSIGNED NOT NULL DEFAULT 0 COMMENT 'Chunk jobs of running scan and async queries',
+  `queuedJobs` BIGINT UNSIGNED NOT NULL DEFAULT 0 COMMENT 'Chunk jobs of queued scan and async queries'
+);
@@ -38,6 +38,7 @@
 #include "QStatusMysql.h"
 #include "sql/SqlConnection.h"
 #include "sql/SqlErrorObject.h"
+#include "sql/SqlResults.h"
 
 // Local headers
 #include "Exceptions.h"
@@ -137,6 +138,45 @@ BOOST_AUTO_TEST_CASE(messWithCzars) {
     BOOST_CHECK_THROW(qMeta->setCzarActive(9999999, true), CzarIdError);
 }
 
+BOOST_AUTO_TEST_CASE(messWithCzarLoads) {
+
+    CzarId cid1 = qMeta->registerCzar("czar-load-1:1000");
+    CzarId cid2 = qMeta->registerCzar("czar-load-2:1000");
+
+    // czars that never advertised their load are not returned
+    for (auto const& load: qMeta->getCzarLoads(60)) {
+        BOOST_CHECK(load.czarId != cid1 and load.czarId != cid2);
+    }
+
+    QCzarLoad load;
+    load.runningQueries = 3;
+    load.queuedQueries = 1;
+    load.runningJobs = 15000;
+    load.queuedJobs = 2000;
+    qMeta->updateCzarLoad(cid1, load);
+    qMeta->updateCzarLoad(cid2, QCzarLoad());
+
+    std::vector<QCzarLoad> loads;
+    for (auto const& load: qMeta->getCzarLoads(60)) {
+        if (load.czarId == cid1 or load.czarId == cid2) loads.push_back(load);
+    }
+    BOOST_REQUIRE_EQUAL(loads.size(), 2U);
+    BOOST_CHECK_EQUAL(loads[0].czarId, cid1);
+    BOOST_CHECK_EQUAL(loads[0].czarName, "czar-load-1:1000");
+    BOOST_CHECK_EQUAL(loads[0].runningQueries, 3U);
+    BOOST_CHECK_EQUAL(loads[0].queuedQueries, 1U);
+    BOOST_CHECK_EQUAL(loads[0].runningJobs, 15000U);
+    BOOST_CHECK_EQUAL(loads[0].queuedJobs, 2000U);
+    BOOST_CHECK_EQUAL(loads[1].czarId, cid2);
+    BOOST_CHECK_EQUAL(loads[1].runningJobs, 0U);
+
+    // inactive czars are not returned
+    qMeta->setCzarActive(cid2, false);
+    for (auto const& load: qMeta->getCzarLoads(60)) {
+        BOOST_CHECK(load.czarId != cid2);
+    }
+}
+
 
 
 BOOST_AUTO_TEST_CASE(messWithQueries) {
@@ -247,6 +287,29 @@ BOOST_AUTO_TEST_CASE(messWithQueries) {
     // no running queries should be there
     queries = qMeta->getPendingQueries(cid1);
     BOOST_CHECK_EQUAL(queries.size(), 0U);
+
+    // store resource usage, twice with the same values
+    QUsage usage;
+    usage.cpuUs = 2500000;
+    usage.rowsRead = 1000;
+    usage.bytesTransmitted = 4096;
+    usage.memLockedBytes = 1 << 20;
+    BOOST_CHECK_THROW(qMeta->saveQueryUsage(99999, usage), QueryIdError);
+    qMeta->saveQueryUsage(qid1, usage);
+    BOOST_CHECK_NO_THROW(qMeta->saveQueryUsage(qid1, usage));
+
+    lsst::qserv::sql::SqlResults results;
+    SqlErrorObject errObj;
+    std::string query = "SELECT cpuSeconds, rowsRead, bytesTransmitted, memLockedBytes FROM QInfo"
+                        " WHERE queryId = " + std::to_string(qid1);
+    BOOST_REQUIRE(sqlConn->runQuery(query, results, errObj));
+    std::vector<std::string> cpu, rows, bytes, mem;
+    BOOST_REQUIRE(results.extractFirst4Columns(cpu, rows, bytes, mem, errObj));
+    BOOST_REQUIRE_EQUAL(cpu.size(), 1U);
+    BOOST_CHECK_EQUAL(std::stod(cpu[0]), 2.5);
+    BOOST_CHECK_EQUAL(rows[0], "1000");
+    BOOST_CHECK_EQUAL(bytes[0], "4096");
+    BOOST_CHECK_EQUAL(mem[0], "1048576");
 }
 
 BOOST_AUTO_TEST_CASE(messWithQueries2) {
@@ -377,6 +440,24 @@ BOOST_AUTO_TEST_CASE(messWithChunks) {
     qMeta->finishChunk(qid1, 20);
     qMeta->finishChunk(qid1, 37);
     BOOST_CHECK_THROW(qMeta->finishChunk(qid1, 42), ChunkIdError);
+
+    // batched versions, more chunks than one statement holds
+    QMetaMysql batchMeta(testDB.sqlConfig, 2);
+    lsst::qserv::QueryId qid2 = batchMeta.registerQuery(qinfo, tables);
+    chunks.push_back(42);
+    chunks.push_back(51);
+    batchMeta.addChunks(qid2, chunks);
+    std::vector<std::pair<int, std::string>> assignments;
+    for (int chunk: chunks) {
+        assignments.emplace_back(chunk, chunk < 40 ? "worker1" : "worker2");
+    }
+    batchMeta.assignChunks(qid2, assignments);
+    batchMeta.assignChunks(qid2, assignments);
+    assignments.emplace_back(99, "worker1");
+    BOOST_CHECK_THROW(batchMeta.assignChunks(qid2, assignments), ChunkIdError);
+    batchMeta.finishChunks(qid2, chunks);
+    chunks.push_back(98);
+    BOOST_CHECK_THROW(batchMeta.finishChunks(qid2, chunks), ChunkIdError);
 }
 
 
@@ -0,0 +1,124 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <https://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// System headers
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <vector>
+
+// Qserv headers
+#include "qmeta/Exceptions.h"
+#include "qmeta/QMetaWriteQueue.h"
+#include "sql/SqlErrorObject.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE QMetaWriteQueue_1
+#include "boost/test/included/unit_test.hpp"
+
+using namespace lsst::qserv::qmeta;
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(ordering) {
+    QMetaWriteQueue queue(100, 0, std::chrono::milliseconds(1));
+    std::vector<int> done;
+    for (int i = 0; i < 50; ++i) {
+        queue.push([&done, i] { done.push_back(i); }, "op");
+    }
+    queue.flush();
+    BOOST_REQUIRE_EQUAL(done.size(), 50u);
+    for (int i = 0; i < 50; ++i) {
+        BOOST_CHECK_EQUAL(done[i], i);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(coalescing) {
+    QMetaWriteQueue queue(100, 0, std::chrono::milliseconds(1));
+    std::promise<void> started, release;
+    std::shared_future<void> released = release.get_future().share();
+    std::vector<int> done;
+    // hold the thread so that the following updates wait
+    queue.push([&started, released] { started.set_value(); released.wait(); }, "block");
+    started.get_future().wait();
+    queue.push([&done] { done.push_back(1); }, "first", "key");
+    queue.push([&done] { done.push_back(2); }, "other");
+    queue.push([&done] { done.push_back(3); }, "second", "key");
+    release.set_value();
+    queue.flush();
+    BOOST_REQUIRE_EQUAL(done.size(), 2u);
+    BOOST_CHECK_EQUAL(done[0], 3);
+    BOOST_CHECK_EQUAL(done[1], 2);
+}
+
+BOOST_AUTO_TEST_CASE(retries) {
+    QMetaWriteQueue queue(100, 2, std::chrono::milliseconds(1));
+    lsst::qserv::sql::SqlErrorObject errObj;
+    errObj.setErrNo(2013);
+    int attempts = 0;
+    queue.push([&attempts, &errObj] {
+        if (++attempts < 3) throw SqlError(ERR_LOC, errObj);
+    }, "flaky");
+    int hopeless = 0;
+    queue.push([&hopeless, &errObj] { ++hopeless; throw SqlError(ERR_LOC, errObj); }, "hopeless");
+    int permanent = 0;
+    queue.push([&permanent] { ++permanent; throw ChunkIdError(ERR_LOC, 1, 2); }, "bad chunk");
+    queue.flush();
+    BOOST_CHECK_EQUAL(attempts, 3);
+    BOOST_CHECK_EQUAL(hopeless, 3);
+    BOOST_CHECK_EQUAL(permanent, 1);
+    BOOST_CHECK_EQUAL(queue.getFailedCount(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(bounded) {
+    QMetaWriteQueue queue(2, 0, std::chrono::milliseconds(1));
+    std::promise<void> started, release;
+    std::shared_future<void> released = release.get_future().share();
+    queue.push([&started, released] { started.set_value(); released.wait(); }, "block");
+    started.get_future().wait();
+    queue.push([] {}, "one");
+    queue.push([] {}, "two");
+    std::atomic<bool> pushed{false};
+    auto pusher = std::async(std::launch::async, [&queue, &pushed] {
+        queue.push([] {}, "three");
+        pushed = true;
+    });
+    BOOST_CHECK(pusher.wait_for(std::chrono::milliseconds(100)) == std::future_status::timeout);
+    BOOST_CHECK(not pushed);
+    release.set_value();
+    pusher.wait();
+    BOOST_CHECK(pushed);
+    queue.flush();
+}
+
+BOOST_AUTO_TEST_CASE(drainOnDestruction) {
+    int done = 0;
+    {
+        QMetaWriteQueue queue(100, 0, std::chrono::milliseconds(1));
+        for (int i = 0; i < 10; ++i) {
+            queue.push([&done] { ++done; }, "op");
+        }
+    }
+    BOOST_CHECK_EQUAL(done, 10);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,125 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 AURA/LSST.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <https://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// System headers
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Qserv headers
+#include "qmeta/Exceptions.h"
+#include "qmeta/QStatusAggregator.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE QStatusAggregator_1
+#include "boost/test/included/unit_test.hpp"
+
+using namespace lsst::qserv::qmeta;
+using lsst::qserv::QueryId;
+
+namespace {
+
+/// Counts the rows written instead of writing them.
+struct CountingQStatus : public QStatus {
+    void createQueryStatsTmpTable() override {}
+    void queryStatsTmpRegister(QueryId queryId, int totalChunks) override {
+        std::lock_guard<std::mutex> lock(mtx);
+        rows[queryId] = QStats(queryId, totalChunks, 0, 0, 0);
+    }
+    void queryStatsTmpChunkUpdate(QueryId queryId, int completedChunks) override {
+        std::lock_guard<std::mutex> lock(mtx);
+        rows[queryId].completedChunks = completedChunks;
+        ++updates;
+    }
+    QStats queryStatsTmpGet(QueryId queryId) override {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto iter = rows.find(queryId);
+        if (iter == rows.end()) throw QueryIdError(ERR_LOC, queryId);
+        return iter->second;
+    }
+    void queryStatsTmpRemove(QueryId queryId) override {
+        std::lock_guard<std::mutex> lock(mtx);
+        rows.erase(queryId);
+    }
+
+    std::mutex mtx;
+    std::map<QueryId, QStats> rows;
+    int updates = 0;
+};
+
+}
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(aggregation) {
+    auto store = std::make_shared<CountingQStatus>();
+    // long interval, the test flushes explicitly
+    QStatusAggregator aggregator(store, std::chrono::hours(1));
+    aggregator.queryStatsTmpRegister(5, 1000);
+    aggregator.queryStatsTmpRegister(6, 10);
+    BOOST_CHECK_EQUAL(store->rows.size(), 2u);
+    for (int i = 1; i <= 1000; ++i) {
+        aggregator.queryStatsTmpChunkUpdate(5, i);
+        aggregator.queryStatsTmpMergeUpdate(5, 100, 2);
+    }
+    BOOST_CHECK_EQUAL(store->updates, 0);
+
+    QStats stats;
+    BOOST_REQUIRE(aggregator.getLocal(5, stats));
+    BOOST_CHECK_EQUAL(stats.totalChunks, 1000);
+    BOOST_CHECK_EQUAL(stats.completedChunks, 1000);
+    BOOST_CHECK_EQUAL(stats.mergedBytes, 100000u);
+    BOOST_CHECK_EQUAL(stats.mergedRows, 2000u);
+    BOOST_CHECK(not aggregator.getLocal(7, stats));
+
+    // one row for the query that progressed, none for the other
+    aggregator.flush();
+    BOOST_CHECK_EQUAL(store->updates, 1);
+    BOOST_CHECK_EQUAL(store->rows[5].completedChunks, 1000);
+    aggregator.flush();
+    BOOST_CHECK_EQUAL(store->updates, 1);
+
+    aggregator.queryStatsTmpRemove(5);
+    BOOST_CHECK(not aggregator.getLocal(5, stats));
+    BOOST_CHECK_EQUAL(store->rows.count(5), 0u);
+    BOOST_CHECK_THROW(aggregator.queryStatsTmpGet(5), QueryIdError);
+}
+
+BOOST_AUTO_TEST_CASE(periodicFlush) {
+    auto store = std::make_shared<CountingQStatus>();
+    {
+        QStatusAggregator aggregator(store, std::chrono::milliseconds(10));
+        aggregator.queryStatsTmpRegister(5, 3);
+        aggregator.queryStatsTmpChunkUpdate(5, 1);
+        for (int i = 0; i < 200 && store->queryStatsTmpGet(5).completedChunks != 1; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        BOOST_CHECK_EQUAL(store->queryStatsTmpGet(5).completedChunks, 1);
+        aggregator.queryStatsTmpChunkUpdate(5, 3);
+    }
+    // the last progress is written when the aggregator goes away
+    BOOST_CHECK_EQUAL(store->queryStatsTmpGet(5).completedChunks, 3);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
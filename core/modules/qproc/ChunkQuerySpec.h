@@ -70,6 +70,9 @@ public:
     DbTableSet subChunkTables;
     std::vector<int> subChunkIds;
     std::vector<std::string> queries;
+    /// Queries, with CHUNK_TAG in place of the chunk id, shared by all the
+    /// chunks of the user query. When set, 'queries' is left empty.
+    std::shared_ptr<std::vector<std::string> const> taggedQueries;
     // Consider promoting the concept of container of ChunkQuerySpec
     // in the hopes of increased code cleanliness.
     std::shared_ptr<ChunkQuerySpec> nextFragment; ///< ad-hoc linked list (consider removal)
@@ -55,6 +55,9 @@ std::ostream& operator<<(std::ostream& os, ChunkSpec const& c) {
     os << "ChunkSpec("
        << "chunkId=" << c.chunkId << ", "
        << "subChunks=" << util::printable(c.subChunks);
+    if (!c.keyPositions.empty()) {
+        os << ", keys=" << c.keyPositions.size();
+    }
     os << ")";
     return os;
 }
@@ -125,6 +128,22 @@ void normalize(ChunkSpecVector& specs) {
     specs.swap(output);
 }
 
+ChunkSpecVector sampleChunks(ChunkSpecVector const& specs, int every) {
+    if (every <= 1) return specs;
+    ChunkSpecVector output;
+    for (auto const& spec : specs) {
+        // splitmix64 finalizer of the run number
+        uint64_t h = static_cast<uint64_t>(spec.chunkId / every) + 0x9e3779b97f4a7c15ULL;
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        h ^= h >> 31;
+        if (spec.chunkId % every == static_cast<int>(h % every)) {
+            output.push_back(spec);
+        }
+    }
+    return output;
+}
+
 ////////////////////////////////////////////////////////////////////////
 // ChunkSpec
 ////////////////////////////////////////////////////////////////////////
@@ -152,6 +171,17 @@ void ChunkSpec::restrict(ChunkSpec const& rhs) {
         rhs.subChunks.begin(), rhs.subChunks.end(),
         std::insert_iterator<Int32Vector>(output, output.end()));
     subChunks.swap(output);
+    // The keys restricted to are those of either side, or both.
+    if (keyPositions.empty()) {
+        keyPositions = rhs.keyPositions;
+    } else if (!rhs.keyPositions.empty()) {
+        Int32Vector positions;
+        std::set_intersection(
+            keyPositions.begin(), keyPositions.end(),
+            rhs.keyPositions.begin(), rhs.keyPositions.end(),
+            std::back_inserter(positions));
+        keyPositions.swap(positions);
+    }
 }
 
 void ChunkSpec::mergeUnion(ChunkSpec const& rhs) {
@@ -164,12 +194,25 @@ void ChunkSpec::mergeUnion(ChunkSpec const& rhs) {
                output.begin());
     output.erase(std::unique(output.begin(), output.end() ), output.end());
     subChunks.swap(output);
+    // A side without keys needs all of them.
+    if (keyPositions.empty() || rhs.keyPositions.empty()) {
+        keyPositions.clear();
+    } else {
+        Int32Vector positions;
+        std::set_union(keyPositions.begin(), keyPositions.end(),
+                       rhs.keyPositions.begin(), rhs.keyPositions.end(),
+                       std::back_inserter(positions));
+        keyPositions.swap(positions);
+    }
 }
 
 void ChunkSpec::normalize() {
     std::sort(subChunks.begin(), subChunks.end() );
     subChunks.erase(std::unique(subChunks.begin(), subChunks.end() ),
                     subChunks.end());
+    std::sort(keyPositions.begin(), keyPositions.end());
+    keyPositions.erase(std::unique(keyPositions.begin(), keyPositions.end()),
+                       keyPositions.end());
 }
 
 bool ChunkSpec::operator<(ChunkSpec const& rhs) const {
@@ -223,6 +266,7 @@ ChunkSpecFragmenter::ChunkSpecFragmenter(ChunkSpec const& s)
 ChunkSpec ChunkSpecFragmenter::get() const {
     ChunkSpec c;
     c.chunkId = _original.chunkId;
+    c.keyPositions = _original.keyPositions;
     Iter posEnd = _pos + GOOD_SUBCHUNK_COUNT;
     Iter end = _original.subChunks.end();
     if (posEnd >= end) {
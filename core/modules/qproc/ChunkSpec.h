@@ -60,6 +60,10 @@ public:
     int32_t chunkId; ///< ChunkId of interest
     /// Subchunks of interest; empty indicates all subchunks are involved.
     Int32Vector subChunks;
+    /// Positions, in the IN list of the secondary index constraint, of the
+    /// keys found in this chunk, sorted; empty if the list is not split.
+    /// Not considered by comparisons.
+    Int32Vector keyPositions;
 
     bool shouldSplit() const;
 
@@ -97,6 +101,13 @@ ChunkSpecVector intersect(ChunkSpecVector const& a, ChunkSpecVector const& b);
 /// Merge and eliminate duplicates.
 void normalize(ChunkSpecVector& specs);
 
+/// Keep a deterministic sample of about one chunk in 'every'. Chunk ids are
+/// split into runs of 'every' consecutive ids and one id of each run is
+/// picked by a hash of the run, so that each chunk is picked with
+/// probability 1/every. Consecutive ids are neighbours along a stripe, which
+/// spreads the sample evenly across the sky.
+ChunkSpecVector sampleChunks(ChunkSpecVector const& specs, int every);
+
 /// An iterating fragmenter to reduce the number of subChunkIds per ChunkSpec
 class ChunkSpecFragmenter {
 public:
@@ -34,9 +34,14 @@
 // System headers
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdio>
 #include <iterator>
+#include <list>
+#include <mutex>
 #include <stdexcept>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
 // Third-party headers
@@ -80,59 +85,128 @@ std::vector<T> convertVec(StringVector const& v) {
     return out;
 }
 template <typename T>
-std::shared_ptr<Region> make(StringVector const& v) {
-    return std::shared_ptr<Region>(new T(convertVec<double>(v)));
+std::shared_ptr<Region> make(std::vector<double> const& v) {
+    return std::shared_ptr<Region>(new T(v));
 }
 template <>
-std::shared_ptr<Region> make<Box>(StringVector const& v) {
-    return lsst::qserv::qproc::getBoxFromParams(convertVec<double>(v));
+std::shared_ptr<Region> make<Box>(std::vector<double> const& v) {
+    return lsst::qserv::qproc::getBoxFromParams(v);
 }
 template <>
-std::shared_ptr<Region> make<Circle>(StringVector const& v) {
-    return lsst::qserv::qproc::getCircleFromParams(convertVec<double>(v));
+std::shared_ptr<Region> make<Circle>(std::vector<double> const& v) {
+    return lsst::qserv::qproc::getCircleFromParams(v);
 }
 template <>
-std::shared_ptr<Region> make<Ellipse>(StringVector const& v) {
-    return lsst::qserv::qproc::getEllipseFromParams(convertVec<double>(v));
+std::shared_ptr<Region> make<Ellipse>(std::vector<double> const& v) {
+    return lsst::qserv::qproc::getEllipseFromParams(v);
 }
 template <>
-std::shared_ptr<Region> make<ConvexPolygon>(StringVector const& v) {
-    return lsst::qserv::qproc::getConvexPolyFromParams(convertVec<double>(v));
+std::shared_ptr<Region> make<ConvexPolygon>(std::vector<double> const& v) {
+    return lsst::qserv::qproc::getConvexPolyFromParams(v);
 }
 
-typedef std::shared_ptr<Region>(*MakeFunc)(StringVector const& v);
+typedef std::shared_ptr<Region>(*MakeFunc)(std::vector<double> const& v);
+
+enum class Shape { BOX, CIRCLE, OTHER };
 
 struct FuncMap {
+    struct Entry {
+        MakeFunc make;
+        Shape shape;
+    };
     FuncMap() {
-        fMap["box"] = make<Box>;
-        fMap["circle"] = make<Circle>;
-        fMap["ellipse"] = make<Ellipse>;
-        fMap["poly"] = make<ConvexPolygon>;
-        fMap["qserv_areaspec_box"] = make<Box>;
-        fMap["qserv_areaspec_circle"] = make<Circle>;
-        fMap["qserv_areaspec_ellipse"] = make<Ellipse>;
-        fMap["qserv_areaspec_poly"] = make<ConvexPolygon>;
+        fMap["box"] = {make<Box>, Shape::BOX};
+        fMap["circle"] = {make<Circle>, Shape::CIRCLE};
+        fMap["ellipse"] = {make<Ellipse>, Shape::OTHER};
+        fMap["poly"] = {make<ConvexPolygon>, Shape::OTHER};
+        fMap["qserv_areaspec_box"] = {make<Box>, Shape::BOX};
+        fMap["qserv_areaspec_circle"] = {make<Circle>, Shape::CIRCLE};
+        fMap["qserv_areaspec_ellipse"] = {make<Ellipse>, Shape::OTHER};
+        fMap["qserv_areaspec_poly"] = {make<ConvexPolygon>, Shape::OTHER};
     }
-    typedef std::map<std::string, MakeFunc> Map;
+    typedef std::map<std::string, Entry> Map;
     Map fMap;
 };
 static FuncMap funcMap;
 
-/*  Computes region covered by a given spherical geometry UDF call
+/// Grid step, in degrees, that box and circle parameters are widened to
+/// before their cover is looked up.
+double const coverQuantumDeg = 0.01;
+
+/// Maximum number of region covers kept by coverCache.
+size_t const coverCacheSize = 10000;
+
+/*  Widen box and circle parameters to the coverQuantumDeg grid
  *
- *  @param c:   Constraint containing name and parameter of UDF call
- *  @return:    Pointer to Region covered by c, or nullptr if empty
+ *  The widened region contains the original one, so its cover holds every
+ *  subchunk the original region touches. The few extra subchunks return no
+ *  rows, as chunk queries keep the exact restrictor.
+ *
+ *  @param shape:   Shape of the region
+ *  @param params:  Region parameters in degrees, widened in place.
  */
-std::shared_ptr<Region> getRegion(lsst::qserv::query::Constraint const& c) {
-    std::shared_ptr<Region> covered_region = nullptr;
-    FuncMap::Map::const_iterator i = funcMap.fMap.find(c.name);
-    if (i != funcMap.fMap.end()) {
-        LOGS(_log, LOG_LVL_TRACE, "Region for " << c << ": " << i->first);
-        covered_region = i->second(c.params);
+void widen(Shape shape, std::vector<double>& params) {
+    double const q = coverQuantumDeg;
+    if (shape == Shape::BOX && params.size() == 4) {
+        // lonMin, latMin, lonMax, latMax
+        params[0] = std::floor(params[0] / q) * q;
+        params[1] = std::max(-90.0, std::floor(params[1] / q) * q);
+        params[2] = std::ceil(params[2] / q) * q;
+        params[3] = std::min(90.0, std::ceil(params[3] / q) * q);
+    } else if (shape == Shape::CIRCLE && params.size() == 3 && params[2] >= 0) {
+        // lon, lat, radius. Rounding the center moves it by at most
+        // q/sqrt(2) degrees of arc, which the radius makes up for.
+        params[0] = std::round(params[0] / q) * q;
+        params[1] = std::max(-90.0, std::min(90.0, std::round(params[1] / q) * q));
+        params[2] = std::ceil((params[2] + q * M_SQRT1_2) / q) * q;
     }
-    return covered_region;
 }
 
+/// CoverCache keeps the subchunk covers of the regions most recently looked
+/// up by any IndexMap, keyed by partitioning and widened region parameters,
+/// so that the many close by regions of cone searches share covers.
+class CoverCache {
+public:
+    typedef std::shared_ptr<SubChunksVector const> CoverPtr;
+
+    explicit CoverCache(size_t maxEntries) : _maxEntries(maxEntries) {}
+
+    /// @return the cover of 'key', nullptr if not cached.
+    CoverPtr get(std::string const& key) {
+        std::lock_guard<std::mutex> lock(_mtx);
+        auto iter = _index.find(key);
+        if (iter == _index.end()) {
+            return nullptr;
+        }
+        _entries.splice(_entries.begin(), _entries, iter->second);
+        return iter->second->second;
+    }
+
+    /// Keep the cover of 'key', dropping the least recently used cover if
+    /// the cache is full.
+    void put(std::string const& key, CoverPtr const& cover) {
+        std::lock_guard<std::mutex> lock(_mtx);
+        if (_index.count(key) > 0) {
+            return;
+        }
+        _entries.emplace_front(key, cover);
+        _index[key] = _entries.begin();
+        if (_entries.size() > _maxEntries) {
+            _index.erase(_entries.back().first);
+            _entries.pop_back();
+        }
+    }
+
+private:
+    typedef std::pair<std::string, CoverPtr> Entry;
+
+    size_t const _maxEntries;
+    std::mutex _mtx; ///< Protects all members below
+    std::list<Entry> _entries; ///< Most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> _index;
+};
+static CoverCache coverCache(coverCacheSize);
+
 lsst::qserv::qproc::ChunkSpec convertSgSubChunks(SubChunks const& sc) {
     lsst::qserv::qproc::ChunkSpec cs;
     cs.chunkId = sc.chunkId;
@@ -147,61 +221,65 @@ lsst::qserv::qproc::ChunkSpec convertSgSubChunks(SubChunks const& sc) {
 namespace lsst {
 namespace qserv {
 namespace qproc {
-typedef std::vector<std::shared_ptr<Region> > RegionPtrVector;
-
 ////////////////////////////////////////////////////////////////////////
 // IndexMap::PartitioningMap definition and implementation
 ////////////////////////////////////////////////////////////////////////
 class IndexMap::PartitioningMap {
 public:
-    class NoRegion : public std::invalid_argument {
-    public:
-        NoRegion() : std::invalid_argument("No region specified")
-            {}
-    };
-    explicit PartitioningMap(css::StripingParams const& sp) {
+    explicit PartitioningMap(css::StripingParams const& sp)
+        : _keyPrefix(std::to_string(sp.stripes) + "/" + std::to_string(sp.subStripes) + ":") {
         _chunker = std::make_shared<lsst::sphgeom::Chunker>(sp.stripes,
                                                             sp.subStripes);
 
     }
-    /// @return un-canonicalized vector<SubChunks> of concatenated region
-    /// results. Regions are assumed to be joined by implicit "OR" and not "AND"
-    /// Throws NoRegion if no region is passed.
-    SubChunksVector getIntersect(RegionPtrVector const& rv) {
-        SubChunksVector scv;
-        bool hasRegion = false;
-        for(RegionPtrVector::const_iterator i=rv.begin(), e=rv.end();
-            i != e;
-            ++i) {
-            if (*i) {
-                SubChunksVector area = getCoverage(**i);
-                scv.insert(scv.end(), area.begin(), area.end());
-                hasRegion = true;
-            } else {
-                // Ignore null-regions
-                continue;
-            }
+
+    /// @return the subchunks intersecting the widened region of 'c', or
+    /// nullptr if 'c' is not a spatial constraint.
+    CoverCache::CoverPtr getCover(query::Constraint const& c) {
+        FuncMap::Map::const_iterator i = funcMap.fMap.find(c.name);
+        if (i == funcMap.fMap.end()) {
+            return nullptr;
         }
-        if (!hasRegion) {
-            throw NoRegion();
+        std::vector<double> params = convertVec<double>(c.params);
+        widen(i->second.shape, params);
+        std::string key = _keyPrefix + i->first + "(";
+        for (double param : params) {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.17g,", param);
+            key += buf;
         }
-        return scv;
+        key += ")";
+        CoverCache::CoverPtr cover = coverCache.get(key);
+        if (!cover) {
+            LOGS(_log, LOG_LVL_TRACE, "Region for " << c << ": " << key);
+            std::shared_ptr<Region> region = i->second.make(params);
+            cover = std::make_shared<SubChunksVector const>(
+                        _chunker->getSubChunksIntersecting(*region));
+            coverCache.put(key, cover);
+        }
+        return cover;
     }
 
-    inline SubChunksVector getCoverage(Region const& r) {
-        return _chunker->getSubChunksIntersecting(r);
-    }
-    ChunkSpecVector getAllChunks() const {
-        Int32Vector allChunks = _chunker->getAllChunks();
+    /// @return all chunks but those of 'emptyChunks', if not nullptr.
+    /// The subchunks of empty chunks are never listed.
+    ChunkSpecVector getAllChunks(css::ChunkBitmap const* emptyChunks) const {
+        css::ChunkBitmap chunks;
+        for (int chunkId : _chunker->getAllChunks()) {
+            chunks.set(chunkId);
+        }
+        if (emptyChunks) {
+            chunks.andNot(*emptyChunks);
+        }
+        IntVector const chunkIds = chunks.getChunks();
         ChunkSpecVector csv;
-        csv.reserve(allChunks.size());
-        for(IntVector::const_iterator i=allChunks.begin(), e=allChunks.end();
-            i != e; ++i) {
-            csv.push_back(ChunkSpec(*i, _chunker->getAllSubChunks(*i)));
+        csv.reserve(chunkIds.size());
+        for (int chunkId : chunkIds) {
+            csv.push_back(ChunkSpec(chunkId, _chunker->getAllSubChunks(chunkId)));
         }
         return csv;
     }
 private:
+    std::string const _keyPrefix; ///< Partitioning part of coverCache keys
     std::shared_ptr<lsst::sphgeom::Chunker> _chunker;
 };
 
@@ -209,14 +287,52 @@ private:
 // IndexMap implementation
 ////////////////////////////////////////////////////////////////////////
 IndexMap::IndexMap(css::StripingParams const& sp,
-                   std::shared_ptr<SecondaryIndex> si)
+                   std::shared_ptr<SecondaryIndex> si,
+                   std::shared_ptr<css::ChunkBitmap const> const& emptyChunks)
     : _pm(std::make_shared<PartitioningMap>(sp)),
-      _si(si) {
+      _si(si),
+      _emptyChunks(emptyChunks) {
 }
 
 // Compute the chunks list for the whole partitioning scheme
 ChunkSpecVector IndexMap::getAllChunks() {
-    return _pm->getAllChunks();
+    return _pm->getAllChunks(_emptyChunks.get());
+}
+
+ChunkSpecVector IndexMap::_dropEmpty(ChunkSpecVector csv) const {
+    if (_emptyChunks) {
+        auto isEmpty = [this](ChunkSpec const& spec) { return _emptyChunks->test(spec.chunkId); };
+        csv.erase(std::remove_if(csv.begin(), csv.end(), isEmpty), csv.end());
+    }
+    return csv;
+}
+
+bool IndexMap::_addCover(query::Constraint const& c, ChunkSpecVector& specs) {
+    std::shared_ptr<SubChunksVector const> cover;
+    try {
+        cover = _pm->getCover(c);
+    } catch(std::invalid_argument& a) {
+        throw QueryProcessingError(a.what());
+    } catch(std::runtime_error& e) {
+        throw QueryProcessingError(e.what());
+    }
+    if (!cover) {
+        return false;
+    }
+    std::transform(cover->begin(), cover->end(),
+                   std::back_inserter(specs), convertSgSubChunks);
+    return true;
+}
+
+std::vector<ChunkSpecVector> IndexMap::getRegionCovers(query::ConstraintVector const& regions) {
+    std::vector<ChunkSpecVector> covers;
+    covers.reserve(regions.size());
+    for (auto const& c : regions) {
+        ChunkSpecVector regionSpecs;
+        _addCover(c, regionSpecs);
+        covers.push_back(_dropEmpty(std::move(regionSpecs)));
+    }
+    return covers;
 }
 
 //  Compute chunks coverage of spatial and secondary index constraints
@@ -228,7 +344,7 @@ ChunkSpecVector IndexMap::getChunks(query::ConstraintVector const& cv) {
     }
     ChunkSpecVector indexSpecs;
     bool hasIndex = true;
-    bool hasRegion = true;
+    bool hasRegion = false;
     try {
         indexSpecs = _si->lookup(cv);
         LOGS(_log, LOG_LVL_TRACE, "Index specs: " << util::printable(indexSpecs));
@@ -237,22 +353,13 @@ ChunkSpecVector IndexMap::getChunks(query::ConstraintVector const& cv) {
         hasIndex = false; // Ok if no index constraints
     }
 
-    // Spatial area lookups
-    RegionPtrVector rv;
-    std::transform(cv.begin(), cv.end(), std::back_inserter(rv), getRegion);
-    SubChunksVector scv;
-    try {
-        scv = _pm->getIntersect(rv);
-    } catch(PartitioningMap::NoRegion& e) {
-        hasRegion = false;
-    } catch(std::invalid_argument& a) {
-        throw QueryProcessingError(a.what());
-    } catch(std::runtime_error& e) {
-        throw QueryProcessingError(e.what());
-    }
+    // Spatial area lookups, regions are joined by implicit "OR"
     ChunkSpecVector regionSpecs;
-    std::transform(scv.begin(), scv.end(),
-                   std::back_inserter(regionSpecs), convertSgSubChunks);
+    for (auto const& c : cv) {
+        if (_addCover(c, regionSpecs)) {
+            hasRegion = true;
+        }
+    }
     LOGS(_log, LOG_LVL_DEBUG, "indexSpecs subChunks " << util::printable(indexSpecs));
     LOGS(_log, LOG_LVL_DEBUG, "regionSpecs subChunks " << util::printable(regionSpecs));
 
@@ -263,11 +370,11 @@ ChunkSpecVector IndexMap::getChunks(query::ConstraintVector const& cv) {
         normalize(regionSpecs);
         intersectSorted(indexSpecs, regionSpecs);
         LOGS(_log, LOG_LVL_DEBUG, "merged subChunks=" << util::printable(regionSpecs));
-        return indexSpecs;
+        return _dropEmpty(std::move(indexSpecs));
     } else if (hasIndex) {
-        return indexSpecs;
+        return _dropEmpty(std::move(indexSpecs));
     } else if (hasRegion) {
-        return regionSpecs;
+        return _dropEmpty(std::move(regionSpecs));
     } else {
         return getAllChunks();
     }
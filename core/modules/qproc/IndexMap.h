@@ -30,7 +30,12 @@
   * @author Daniel L. Wang, SLAC
   */
 
+// System headers
+#include <memory>
+#include <vector>
+
 // Qserv headers
+#include "css/ChunkBitmap.h"
 #include "css/StripingParams.h"
 #include "query/Constraint.h"
 #include "qproc/ChunkSpec.h"
@@ -43,8 +48,12 @@ class SecondaryIndex;
 
 class IndexMap {
 public:
+    /** @param emptyChunks: chunks left out of every chunk list returned,
+     *                      none if nullptr.
+     */
     IndexMap(css::StripingParams const& sp,
-             std::shared_ptr<SecondaryIndex> si);
+             std::shared_ptr<SecondaryIndex> si,
+             std::shared_ptr<css::ChunkBitmap const> const& emptyChunks=nullptr);
 
     /** Compute the chunks list for the whole partitioning scheme
      *
@@ -68,10 +77,30 @@ public:
      */
     ChunkSpecVector getChunks(query::ConstraintVector const& cv);
 
+    /**  Compute the chunks coverage of many spatial constraints at once
+     *
+     *   Covers are kept across queries, for regions widened to a 0.01 degree
+     *   grid, so the many close by regions of cone searches are mostly
+     *   answered without computing a cover.
+     *
+     *   @param regions: spatial constraints, others get an empty cover
+     *   @returns:       the chunks and subchunks covering each region, in
+     *                   the order of 'regions'
+     */
+    std::vector<ChunkSpecVector> getRegionCovers(query::ConstraintVector const& regions);
+
     class PartitioningMap;
 private:
+    /// Add the chunks and subchunks covering the region of 'c' to 'specs'.
+    /// @return false if 'c' is not a spatial constraint.
+    bool _addCover(query::Constraint const& c, ChunkSpecVector& specs);
+
+    /// @return 'csv' without the chunks of _emptyChunks.
+    ChunkSpecVector _dropEmpty(ChunkSpecVector csv) const;
+
     std::shared_ptr<PartitioningMap> _pm;
     std::shared_ptr<SecondaryIndex> _si;
+    std::shared_ptr<css::ChunkBitmap const> _emptyChunks;
 };
 
 }}} // namespace lsst::qserv::qproc
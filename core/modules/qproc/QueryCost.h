@@ -0,0 +1,60 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_QPROC_QUERYCOST_H
+#define LSST_QSERV_QPROC_QUERYCOST_H
+
+// System headers
+#include <cstdint>
+#include <ostream>
+
+namespace lsst {
+namespace qserv {
+namespace qproc {
+
+/// QueryCost is a rough estimate of the work and of the result size of a
+/// user query. CSS keeps no row counts, so it is derived from the number of
+/// chunks, the scan rating of the tables and the shape of the query.
+struct QueryCost {
+    /// Result rows below which a single merge table is enough.
+    static int64_t const SMALL_RESULT_ROWS = 100000;
+    /// Cost up to which chunk jobs of a restricted query are started with
+    /// interactive priority.
+    static constexpr double INTERACTIVE_COST = 100.0;
+
+    int chunkCount{0};
+    int scanRating{0};         ///< Rating of the slowest table scanned
+    bool restricted{false};    ///< Secondary index or spatial constraints limit the rows read
+    int64_t maxResultRows{-1}; ///< Upper bound of the rows the workers send, -1 if unknown
+    double cost{0.0};          ///< Work, in full chunk scans of the fastest tables
+
+    /// @return true if the result is known to take fewer than SMALL_RESULT_ROWS rows.
+    bool isSmallResult() const {
+        return maxResultRows >= 0 && maxResultRows < SMALL_RESULT_ROWS;
+    }
+};
+
+std::ostream& operator<<(std::ostream& os, QueryCost const& qc);
+
+}}} // namespace lsst::qserv::qproc
+
+#endif // LSST_QSERV_QPROC_QUERYCOST_H
@@ -44,6 +44,7 @@
 
 // Third-party headers
 #include <antlr/NoViableAltException.hpp>
+#include "boost/algorithm/string/replace.hpp"
 
 // LSST headers
 #include "lsst/log/Log.h"
@@ -61,12 +62,15 @@
 #include "qana/DuplSelectExprPlugin.h"
 #include "qana/MatchTablePlugin.h"
 #include "qana/PostPlugin.h"
+#include "qana/ProjectionPlugin.h"
 #include "qana/QservRestrictorPlugin.h"
 #include "qana/QueryMapping.h"
 #include "qana/QueryPlugin.h"
 #include "qana/ScanTablePlugin.h"
+#include "qana/SimplifyPlugin.h"
 #include "qana/TablePlugin.h"
 #include "qana/WherePlugin.h"
+#include "qana/ZoneMapPlugin.h"
 #include "qproc/QueryProcessingBug.h"
 #include "query/Constraint.h"
 #include "query/QsRestrictor.h"
@@ -111,6 +115,7 @@ void QuerySession::analyzeQuery(std::string const& sql, std::shared_ptr<query::S
     _isFinal = false;
     _initContext();
     assert(_context.get());
+    _context->sampleEvery = _sampleEvery;
 
     try {
         _preparePlugins();
@@ -152,6 +157,10 @@ bool QuerySession::hasChunks() const {
     return _context->hasChunks();
 }
 
+bool QuerySession::isUnsatisfiable() const {
+    return _context->unsatisfiable;
+}
+
 std::shared_ptr<query::ConstraintVector> QuerySession::getConstraints() const {
     std::shared_ptr<query::ConstraintVector> cv;
     std::shared_ptr<query::QsRestrictor::PtrVector const> p = _context->restrictors;
@@ -182,7 +191,8 @@ std::shared_ptr<query::ConstraintVector> QuerySession::getConstraints() const {
 // return the ORDER BY clause to run on mysql-proxy at result retrieval
 std::string QuerySession::getProxyOrderBy() const {
     std::string orderBy;
-    if (_stmt->hasOrderBy()) {
+    // The result table is already in order when the czar merges sorted chunk results.
+    if (_stmt->hasOrderBy() && _context->sortedOrder.empty()) {
         orderBy = _stmt->getOrderBy().sqlFragment();
     }
     return orderBy;
@@ -202,6 +212,42 @@ void QuerySession::setScanInteractive() {
     }
 }
 
+QueryCost QuerySession::estimateCost() const {
+    QueryCost qc;
+    qc.chunkCount = _context->chunkCount;
+    qc.scanRating = _context->scanInfo.scanRating;
+    std::shared_ptr<query::ConstraintVector> constraints = getConstraints();
+    if (constraints) {
+        for (auto const& c : *constraints) {
+            if (c.name == "sIndex" || c.name == "sIndexBetween"
+                || c.name.compare(0, 15, "qserv_areaspec_") == 0) {
+                qc.restricted = true;
+            }
+        }
+    }
+    // Unrestricted queries read whole chunks, slower rated tables taking longer.
+    qc.cost = qc.chunkCount * (qc.restricted ? 1.0 : 1.0 + qc.scanRating / 10.0);
+
+    // Each chunk query returns one row if it aggregates without GROUP BY,
+    // otherwise at most its LIMIT.
+    int64_t rowsPerChunk = -1;
+    if (getAggFold() && !_stmt->hasGroupBy()) {
+        rowsPerChunk = 1;
+    } else {
+        for (auto const& stmt : _stmtParallel) {
+            if (!stmt->hasLimit()) {
+                rowsPerChunk = -1;
+                break;
+            }
+            rowsPerChunk = std::max<int64_t>(rowsPerChunk, 0) + stmt->getLimit();
+        }
+    }
+    if (rowsPerChunk >= 0) {
+        qc.maxResultRows = rowsPerChunk * std::max(1, qc.chunkCount);
+    }
+    return qc;
+}
+
 void QuerySession::setDummy() {
     _isDummy = true;
     // Clear out chunk counts and _chunks, and replace with dummy chunk.
@@ -233,12 +279,20 @@ QuerySession::getDbStriping() {
     return _context->getDbStriping();
 }
 
-std::shared_ptr<IntSet const>
+std::shared_ptr<css::ChunkBitmap const>
 QuerySession::getEmptyChunks() {
     // FIXME: do we need to catch an exception here?
     return _css->getEmptyChunks().getEmpty(_context->dominantDb);
 }
 
+std::set<int> const& QuerySession::getPrunedChunks() const {
+    return _context->prunedChunks;
+}
+
+std::vector<std::pair<std::string, std::string>> const& QuerySession::getStatsAnswer() const {
+    return _context->statsAnswer;
+}
+
 /// Returns the merge statment, if appropriate.
 /// If a post-execution merge fixup is not needed, return a NULL pointer.
 std::shared_ptr<query::SelectStmt>
@@ -250,6 +304,39 @@ QuerySession::getMergeStmt() const {
     }
 }
 
+/// Returns how partial results may be folded together before the merge
+/// statement runs, or a NULL pointer if they cannot be.
+std::shared_ptr<query::AggRecord::FoldVector const>
+QuerySession::getAggFold() const {
+    if (_context->needsMerge) {
+        return _context->aggFold;
+    } else {
+        return std::shared_ptr<query::AggRecord::FoldVector const>();
+    }
+}
+
+int
+QuerySession::getTopK() const {
+    return _context->topK;
+}
+
+std::vector<std::pair<std::string, bool>> const&
+QuerySession::getTopKOrder() const {
+    return _context->topKOrder;
+}
+
+std::vector<std::pair<std::string, bool>> const&
+QuerySession::getSortedOrder() const {
+    return _context->sortedOrder;
+}
+
+/// Returns the number of merged rows that complete the query, or 0 if all
+/// chunks must be merged.
+int
+QuerySession::getRowLimit() const {
+    return _context->rowLimit;
+}
+
 void QuerySession::finalize() {
     if (_isFinal) {
         return;
@@ -257,6 +344,7 @@ void QuerySession::finalize() {
     QueryPluginPtrVector::iterator i;
     for(i=_plugins->begin(); i != _plugins->end(); ++i) {
         (**i).applyFinal(*_context);
+        _stageDone("final", i->get());
     }
     // Make up for no chunks (chunk-less query): add the dummy chunk.
     if (_chunks.empty()) {
@@ -281,23 +369,28 @@ void QuerySession::_preparePlugins() {
 
     _plugins->push_back(std::make_shared<qana::DuplSelectExprPlugin>());
     _plugins->push_back(std::make_shared<qana::WherePlugin>());
+    _plugins->push_back(std::make_shared<qana::SimplifyPlugin>());
     _plugins->push_back(std::make_shared<qana::AggregatePlugin>());
     _plugins->push_back(std::make_shared<qana::TablePlugin>());
     _plugins->push_back(std::make_shared<qana::MatchTablePlugin>());
     _plugins->push_back(std::make_shared<qana::QservRestrictorPlugin>());
+    _plugins->push_back(std::make_shared<qana::ZoneMapPlugin>());
     _plugins->push_back(std::make_shared<qana::PostPlugin>());
+    _plugins->push_back(std::make_shared<qana::ProjectionPlugin>());
     _plugins->push_back(std::make_shared<qana::ScanTablePlugin>(_interactiveChunkLimit));
 
     QueryPluginPtrVector::iterator i;
     for(i=_plugins->begin(); i != _plugins->end(); ++i) {
         (**i).prepare();
     }
+    _stageDone("prepare");
 }
 
 void QuerySession::_applyLogicPlugins() {
     QueryPluginPtrVector::iterator i;
     for(i=_plugins->begin(); i != _plugins->end(); ++i) {
         (**i).applyLogical(*_stmt, *_context);
+        _stageDone("logical", i->get());
     }
 }
 
@@ -329,6 +422,7 @@ void QuerySession::_generateConcrete() {
          << _stmtMerge->getQueryTemplate() << "\"");
 
     // TableMerger needs to be integrated into this design.
+    _stageDone("concrete");
 }
 
 void QuerySession::_applyConcretePlugins() {
@@ -336,6 +430,13 @@ void QuerySession::_applyConcretePlugins() {
     QueryPluginPtrVector::iterator i;
     for(i=_plugins->begin(); i != _plugins->end(); ++i) {
         (**i).applyPhysical(p, *_context);
+        _stageDone("physical", i->get());
+    }
+}
+
+void QuerySession::_stageDone(char const* stage, qana::QueryPlugin const* plugin) const {
+    if (_stageObserver) {
+        _stageObserver(plugin == nullptr ? std::string(stage) : std::string(stage) + " " + plugin->name());
     }
 }
 
@@ -393,8 +494,36 @@ std::ostream& operator<<(std::ostream& out, QuerySession const& querySession) {
 }
 
 
+std::shared_ptr<std::vector<std::string> const>
+QuerySession::makeTaggedQueries(query::QueryTemplate::Vect const& queryTemplates,
+                                ChunkSpec const& sampleChunkSpec) const {
+    std::vector<std::string> concrete;
+    if (!_context->hasSubChunks()) {
+        concrete = _buildChunkQueries(queryTemplates, sampleChunkSpec);
+    } else {
+        // Subchunk queries are built per fragment, check with the first one.
+        ChunkSpecFragmenter frag(sampleChunkSpec);
+        concrete = _buildChunkQueries(queryTemplates,
+                                      sampleChunkSpec.shouldSplit() ? frag.get() : sampleChunkSpec);
+    }
+    auto tagged = std::make_shared<std::vector<std::string>>();
+    std::string const chunkStr = std::to_string(sampleChunkSpec.chunkId);
+    for (size_t j = 0; j < queryTemplates.size(); ++j) {
+        std::string query = queryTemplates[j].sqlFragment();
+        if (boost::algorithm::replace_all_copy(query, CHUNK_TAG, chunkStr) != concrete[j]) {
+            LOGS(_log, LOG_LVL_DEBUG, "query template does not match chunk query: " << query);
+            return nullptr;
+        }
+        tagged->push_back(std::move(query));
+    }
+    return tagged;
+}
+
+
 ChunkQuerySpec::Ptr QuerySession::buildChunkQuerySpec(query::QueryTemplate::Vect const& queryTemplates,
-                                                 ChunkSpec const& chunkSpec) const {
+                                                 ChunkSpec const& chunkSpec,
+                                                 std::shared_ptr<std::vector<std::string> const> const&
+                                                         taggedQueries) const {
     auto cQSpec = std::make_shared<ChunkQuerySpec>(_context->dominantDb, chunkSpec.chunkId,
                                                   _context->scanInfo, _scanInteractive);
     // Reset subChunkTables
@@ -403,17 +532,17 @@ ChunkQuerySpec::Ptr QuerySession::buildChunkQuerySpec(query::QueryTemplate::Vect
     cQSpec->subChunkTables = sTables;
     // Build queries.
     if (!_context->hasSubChunks()) {
-        cQSpec->queries = _buildChunkQueries(queryTemplates, chunkSpec);
+        _setQueries(*cQSpec, queryTemplates, chunkSpec, taggedQueries);
     } else {
         if (chunkSpec.shouldSplit()) {
             ChunkSpecFragmenter frag(chunkSpec);
             ChunkSpec s = frag.get();
-            cQSpec->queries = _buildChunkQueries(queryTemplates, s);
+            _setQueries(*cQSpec, queryTemplates, s, taggedQueries);
             cQSpec->subChunkIds.assign(s.subChunks.begin(), s.subChunks.end());
             frag.next();
-            cQSpec->nextFragment = _buildFragment(queryTemplates, frag);
+            cQSpec->nextFragment = _buildFragment(queryTemplates, frag, taggedQueries);
         } else {
-            cQSpec->queries = _buildChunkQueries(queryTemplates, chunkSpec);
+            _setQueries(*cQSpec, queryTemplates, chunkSpec, taggedQueries);
             cQSpec->subChunkIds.assign(chunkSpec.subChunks.begin(),
                                       chunkSpec.subChunks.end());
         }
@@ -424,7 +553,8 @@ ChunkQuerySpec::Ptr QuerySession::buildChunkQuerySpec(query::QueryTemplate::Vect
 
 std::shared_ptr<ChunkQuerySpec>
 QuerySession::_buildFragment(query::QueryTemplate::Vect const& queryTemplates,
-                             ChunkSpecFragmenter& f) const {
+                             ChunkSpecFragmenter& f,
+                             std::shared_ptr<std::vector<std::string> const> const& taggedQueries) const {
     std::shared_ptr<ChunkQuerySpec> first;
     std::shared_ptr<ChunkQuerySpec> last;
     while(!f.isDone()) {
@@ -437,10 +567,21 @@ QuerySession::_buildFragment(query::QueryTemplate::Vect const& queryTemplates,
         }
         ChunkSpec s = f.get();
         last->subChunkIds.assign(s.subChunks.begin(), s.subChunks.end());
-        last->queries = _buildChunkQueries(queryTemplates, s);
+        _setQueries(*last, queryTemplates, s, taggedQueries);
         f.next();
     }
     return first;
 }
 
+
+void QuerySession::_setQueries(ChunkQuerySpec& spec, query::QueryTemplate::Vect const& queryTemplates,
+                               ChunkSpec const& chunkSpec,
+                               std::shared_ptr<std::vector<std::string> const> const& taggedQueries) const {
+    if (taggedQueries != nullptr) {
+        spec.taggedQueries = taggedQueries;
+    } else {
+        spec.queries = _buildChunkQueries(queryTemplates, chunkSpec);
+    }
+}
+
 }}} // namespace lsst::qserv::qproc
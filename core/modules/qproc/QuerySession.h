@@ -32,8 +32,11 @@
 
 // System headers
 #include <cstddef>
+#include <functional>
 #include <memory>
+#include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 // Third-party headers
@@ -47,6 +50,8 @@
 #include "qana/QueryPlugin.h"
 #include "qproc/ChunkQuerySpec.h"
 #include "qproc/ChunkSpec.h"
+#include "qproc/QueryCost.h"
+#include "query/AggRecord.h"
 #include "query/Constraint.h"
 #include "query/QueryTemplate.h"
 #include "query/typedefs.h"
@@ -56,6 +61,7 @@
 namespace lsst {
 namespace qserv {
 namespace css {
+    class ChunkBitmap;
     class StripingParams;
 }
 namespace query {
@@ -89,6 +95,18 @@ public:
 
     std::string const& getOriginal() const { return _original; }
 
+    /// Run the query on about one chunk in 'every', scaling COUNT and SUM
+    /// to estimate the result for all chunks. 0 or 1 to use every chunk.
+    /// Must be called before analyzeQuery().
+    void setSampleEvery(int every) { _sampleEvery = every; }
+    int getSampleEvery() const { return _sampleEvery; }
+
+    /// Called with its name as each stage of analyzeQuery() and finalize()
+    /// ends: "prepare", "logical <plugin>", "concrete", "physical <plugin>"
+    /// and "final <plugin>". Used by benchmarks to time the plugins.
+    typedef std::function<void(std::string const& stage)> StageObserver;
+    void setStageObserver(StageObserver const& observer) { _stageObserver = observer; }
+
     /**
      * @brief Analyze SQL query using parsed query
      *
@@ -99,6 +117,8 @@ public:
 
     bool needsMerge() const;
     bool hasChunks() const;
+    /// @return true if the WHERE clause was found to select no rows.
+    bool isUnsatisfiable() const;
 
     std::shared_ptr<query::ConstraintVector> getConstraints() const;
     void addChunk(ChunkSpec const& cs);
@@ -126,13 +146,44 @@ public:
     bool containsTable(std::string const& dbName, std::string const& tableName) const;
     bool validateDominantDb() const;
     css::StripingParams getDbStriping();
-    std::shared_ptr<IntSet const> getEmptyChunks();
+    std::shared_ptr<css::ChunkBitmap const> getEmptyChunks();
+    /// @return the chunks that can not have rows satisfying the WHERE clause.
+    std::set<int> const& getPrunedChunks() const;
+    /// @return the column names and values of the result row, if the
+    ///         query is answered from chunk statistics, else empty.
+    std::vector<std::pair<std::string, std::string>> const& getStatsAnswer() const;
     std::string const& getError() const { return _error; }
 
     std::shared_ptr<query::SelectStmt> getMergeStmt() const;
-
+    std::shared_ptr<query::AggRecord::FoldVector const> getAggFold() const;
+    /// @return the number of merged rows after which the query can stop, 0 if none.
+    int getRowLimit() const;
+    /// @return the number of rows of an ORDER BY ... LIMIT query that the
+    ///         czar can keep in memory, 0 if it cannot.
+    int getTopK() const;
+    /// @return the ORDER BY result columns, and whether each is descending,
+    ///         that go with getTopK().
+    std::vector<std::pair<std::string, bool>> const& getTopKOrder() const;
+    /// @return the ORDER BY result columns, and whether each is descending,
+    ///         in which the czar merges the sorted chunk results. Empty if
+    ///         mysql-proxy sorts the result with getProxyOrderBy().
+    std::vector<std::pair<std::string, bool>> const& getSortedOrder() const;
+
+    /// @return the chunk queries of 'queryTemplates' with CHUNK_TAG in place of
+    ///         the chunk id, or nullptr if substituting the chunk id of
+    ///         'sampleChunkSpec' does not give the queries built for it.
+    std::shared_ptr<std::vector<std::string> const>
+    makeTaggedQueries(query::QueryTemplate::Vect const& queryTemplates,
+                      ChunkSpec const& sampleChunkSpec) const;
+
+    /// Build the queries of one chunk. This only reads the analyzed query,
+    /// so specs for different chunks may be built concurrently.
+    /// @param taggedQueries - if not null, the result of makeTaggedQueries(),
+    ///        used instead of building the queries of each fragment.
     ChunkQuerySpec::Ptr buildChunkQuerySpec(query::QueryTemplate::Vect const& queryTemplates,
-                                       ChunkSpec const& chunkSpec) const;
+                                       ChunkSpec const& chunkSpec,
+                                       std::shared_ptr<std::vector<std::string> const> const&
+                                               taggedQueries=nullptr) const;
 
     /// Finalize a query after chunk coverage has been updated
     void finalize();
@@ -155,6 +206,9 @@ public:
     void setScanInteractive();
     bool getScanInteractive() const { return _scanInteractive; }
 
+    /// @return the estimated cost of the query, once its chunks are added.
+    QueryCost estimateCost() const;
+
     /**
      *  Print query session to stream.
      *
@@ -173,11 +227,17 @@ private:
     void _applyLogicPlugins();
     void _generateConcrete();
     void _applyConcretePlugins();
+    void _stageDone(char const* stage, qana::QueryPlugin const* plugin=nullptr) const;
 
     std::vector<std::string> _buildChunkQueries(query::QueryTemplate::Vect const& queryTemplates,
                                                 ChunkSpec const& chunkSpec) const;
     std::shared_ptr<ChunkQuerySpec> _buildFragment(query::QueryTemplate::Vect const& queryTemplates,
-                                                   ChunkSpecFragmenter& f) const;
+                                                   ChunkSpecFragmenter& f,
+                                                   std::shared_ptr<std::vector<std::string> const> const&
+                                                           taggedQueries) const;
+    void _setQueries(ChunkQuerySpec& spec, query::QueryTemplate::Vect const& queryTemplates,
+                     ChunkSpec const& chunkSpec,
+                     std::shared_ptr<std::vector<std::string> const> const& taggedQueries) const;
 
     // Fields
     std::shared_ptr<css::CssAccess> _css; ///< Metadata access
@@ -229,6 +289,8 @@ private:
     /// Maximum number of chunks in an interactive query. TODO: DM-10273 put in config file.
     int const _interactiveChunkLimit{10};
     bool _scanInteractive{true}; ///< True if the query can be considered interactive.
+    int _sampleEvery{0}; ///< @see setSampleEvery()
+    StageObserver _stageObserver; ///< @see setStageObserver()
 
 };
 
@@ -33,6 +33,24 @@
 
 // System headers
 #include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 // LSST headers
 #include "lsst/log/Log.h"
@@ -56,6 +74,185 @@ LOG_LOGGER _log = LOG_GET("lsst.qserv.qproc.SecondaryIndex");
 
 enum QueryType { IN, NOT_IN, BETWEEN, NOT_BETWEEN };
 
+/// Maximum number of keys in the IN list of one index query.
+size_t const maxBatchKeys = 1000;
+
+/// Maximum number of index queries of one IN lookup running at once.
+size_t const maxParallelBatches = 4;
+
+/// Remove the quotes around a key literal.
+/// @return false if the literal holds escapes or quotes, whose value as
+///         read back from the index is not known without parsing it.
+bool unquote(std::string const& literal, std::string& value) {
+    value = literal;
+    if (value.size() >= 2 && (value[0] == '\'' || value[0] == '"') && value.back() == value[0]) {
+        value = value.substr(1, value.size() - 2);
+    }
+    return value.find_first_of("\\'\"") == std::string::npos;
+}
+
+/// LocationCache keeps the chunk and subchunk of the director keys most
+/// recently looked up in the secondary index. A director key does not move
+/// once loaded, so entries are only dropped to make room for others.
+class LocationCache {
+public:
+    using Location = std::pair<int, int>;
+
+    /// @param maxEntries - number of keys kept, 0 disables the cache.
+    explicit LocationCache(size_t maxEntries) : _maxEntries(maxEntries) {}
+
+    /// @return true, with its location in 'location', if 'key' is cached.
+    bool get(std::string const& key, Location& location) {
+        std::lock_guard<std::mutex> lock(_mtx);
+        auto iter = _index.find(key);
+        if (iter == _index.end()) {
+            return false;
+        }
+        _entries.splice(_entries.begin(), _entries, iter->second);
+        location = iter->second->second;
+        return true;
+    }
+
+    /// Keep the location of 'key', dropping the least recently used key
+    /// if the cache is full.
+    void put(std::string const& key, Location const& location) {
+        if (_maxEntries == 0) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(_mtx);
+        auto iter = _index.find(key);
+        if (iter != _index.end()) {
+            iter->second->second = location;
+            _entries.splice(_entries.begin(), _entries, iter->second);
+            return;
+        }
+        _entries.emplace_front(key, location);
+        _index[key] = _entries.begin();
+        if (_entries.size() > _maxEntries) {
+            _index.erase(_entries.back().first);
+            _entries.pop_back();
+        }
+    }
+
+private:
+    using Entry = std::pair<std::string, Location>;
+
+    size_t const _maxEntries;
+    std::mutex _mtx; ///< Protects all members below
+    std::list<Entry> _entries; ///< Most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> _index;
+};
+
+/// @return true if the keys of the IN constraint of 'cv' can be located
+///         per chunk: the chunk queries then only need the keys of their
+///         chunk (see query::InPredicate::splitByChunk). This is only done
+///         if it is the single "sIndex" constraint.
+bool splitsKeys(lsst::qserv::query::ConstraintVector const& cv) {
+    return 1 == std::count_if(cv.begin(), cv.end(),
+        [](lsst::qserv::query::Constraint const& c) { return c.name == "sIndex"; });
+}
+
+/// Parse an integer key literal.
+/// @return false if the literal is not a decimal integer.
+bool parseKey(std::string const& literal, int64_t& key) {
+    char const* str = literal.c_str();
+    char* end = nullptr;
+    errno = 0;
+    key = std::strtoll(str, &end, 10);
+    return errno == 0 && end != str && *end == '\0';
+}
+
+/**
+ *  IndexFile maps the secondary index file of one director table into
+ *  memory. The file, written by qserv-secondary-index-file.py, holds
+ *  in host byte order:
+ *  - the 8 characters "QSIDX001",
+ *  - the number n of keys, as uint64,
+ *  - the n keys, as int64 in increasing order,
+ *  - the n chunk ids, then the n subchunk ids, as int32 in key order.
+ *  Keeping the keys apart lets a search touch only the key array.
+ */
+class IndexFile {
+public:
+    using Ptr = std::shared_ptr<IndexFile>;
+
+    /// @throw std::runtime_error if the file cannot be mapped or is malformed.
+    explicit IndexFile(std::string const& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open " + path + ": " + std::strerror(errno));
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(_headerSize)) {
+            ::close(fd);
+            throw std::runtime_error("Cannot use " + path + ": too short");
+        }
+        _mapSize = st.st_size;
+        _map = ::mmap(nullptr, _mapSize, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (_map == MAP_FAILED) {
+            throw std::runtime_error("Cannot map " + path + ": " + std::strerror(errno));
+        }
+        char const* data = static_cast<char const*>(_map);
+        uint64_t n = 0;
+        std::memcpy(&n, data + 8, sizeof(n));
+        if (std::memcmp(data, "QSIDX001", 8) != 0
+            || _mapSize != _headerSize + n * (sizeof(int64_t) + 2 * sizeof(int32_t))) {
+            ::munmap(_map, _mapSize);
+            throw std::runtime_error("Cannot use " + path + ": not a secondary index file");
+        }
+        _size = n;
+        _keys = reinterpret_cast<int64_t const*>(data + _headerSize);
+        _chunks = reinterpret_cast<int32_t const*>(_keys + n);
+        _subChunks = _chunks + n;
+        ::madvise(_map, _mapSize, MADV_RANDOM);
+    }
+
+    IndexFile(IndexFile const&) = delete;
+    IndexFile& operator=(IndexFile const&) = delete;
+
+    ~IndexFile() {
+        ::munmap(_map, _mapSize);
+    }
+
+    size_t size() const { return _size; }
+    int64_t key(size_t j) const { return _keys[j]; }
+    int chunkId(size_t j) const { return _chunks[j]; }
+    int subChunkId(size_t j) const { return _subChunks[j]; }
+
+    /// @return the position of the first key not less than 'key'. The loop
+    ///         has no data-dependent branch, the compiler turns the choice
+    ///         into a conditional move.
+    size_t lowerBound(int64_t key) const {
+        if (_size == 0) {
+            return 0;
+        }
+        int64_t const* base = _keys;
+        size_t n = _size;
+        while (n > 1) {
+            size_t half = n / 2;
+            base = (base[half] < key) ? base + half : base;
+            n -= half;
+        }
+        return (base - _keys) + (*base < key);
+    }
+
+    /// @return the position of the first key greater than 'key'.
+    size_t upperBound(int64_t key) const {
+        return (key == std::numeric_limits<int64_t>::max()) ? _size : lowerBound(key + 1);
+    }
+
+private:
+    static size_t const _headerSize = 16;
+
+    void* _map{nullptr};
+    size_t _mapSize{0};
+    size_t _size{0};
+    int64_t const* _keys{nullptr};
+    int32_t const* _chunks{nullptr};
+    int32_t const* _subChunks{nullptr};
+};
+
 } // anonymous namespace
 
 namespace lsst {
@@ -72,19 +269,20 @@ public:
 
 class MySqlBackend : public SecondaryIndex::Backend {
 public:
-    MySqlBackend(mysql::MySqlConfig const& c)
-        : _sqlConnection(c, true) {
+    MySqlBackend(mysql::MySqlConfig const& c, size_t cacheSize)
+        : _sqlConnection(c, true), _cache(cacheSize) {
     }
 
     ChunkSpecVector lookup(query::ConstraintVector const& cv) override {
         ChunkSpecVector output;
         bool hasIndex = false;
+        bool const splitKeys = splitsKeys(cv);
         for(query::ConstraintVector::const_iterator i=cv.begin(), e=cv.end();
             i != e;
             ++i) {
             if (i->name == "sIndex"){
                 hasIndex = true;
-                _sqlLookup(output, i->params, IN);
+                _inLookup(output, i->params, splitKeys);
             } else if (i->name == "sIndexNotIn"){
                 hasIndex = true;
                 _sqlLookup(output, i->params, NOT_IN);
@@ -127,12 +325,15 @@ private:
      *                     secondary index. Use IN or BETWEEN on object ids
      *                     to find chunk ids.
      *
+     *  @param withKey: also select keyColumn, before the chunk and subchunk.
+     *
      *  @return:   the sql query string to run against secondary index in
      *             order to get (chunks, subchunks) couples containing [id_0, ..., id_n]
      */
     static std::string _buildLookupQuery(
         std::vector<std::string> const& params,
-        QueryType const& query_type) {
+        QueryType const& query_type,
+        bool withKey=false) {
 
         LOGS(_log, LOG_LVL_TRACE, "params: " << util::printable(params));
 
@@ -142,7 +343,8 @@ private:
         std::string const& key_column = *(iter++); // params[2]
 
         std::string index_table = _buildIndexTableName(db, table);
-        std::string sql = "SELECT " + std::string(CHUNK_COLUMN) + ", " + std::string(SUB_CHUNK_COLUMN) +
+        std::string sql = "SELECT " + (withKey ? key_column + ", " : std::string())
+                          + std::string(CHUNK_COLUMN) + ", " + std::string(SUB_CHUNK_COLUMN) +
                           " FROM " + index_table +
                           " WHERE " + key_column;
         if (query_type == QueryType::IN || query_type == QueryType::NOT_IN) {
@@ -218,7 +420,283 @@ private:
         }
     }
 
+    /**
+     *  Add the chunks and subchunks of the keys of an IN constraint to an
+     *  existing ChunkSpec vector. Cached keys skip the index, the others
+     *  are looked up in batches of at most maxBatchKeys keys, up to
+     *  maxParallelBatches of them running at once, and then cached.
+     *
+     *  @param output:      existing ChunkSpec vector
+     *  @param params:      parameters used to query secondary index
+     *  @param splitKeys:   also set the key positions of the chunks, unless
+     *                      a key read back from the index can not be
+     *                      matched with a key of the constraint
+     */
+    void _inLookup(ChunkSpecVector& output, StringVector const& params, bool splitKeys) {
+        if (params.size() <= 3) {
+            _sqlLookup(output, params, IN);
+            return;
+        }
+        std::string const keyPrefix = _buildIndexTableName(params[0], params[1])
+                                      + '\0' + params[2] + '\0';
+        std::map<int, Int32Vector> tmp;
+        std::map<int, Int32Vector> keyPositions;
+        std::map<std::string, Int32Vector> missedPositions; // by unquoted value
+        StringVector missed;
+        std::set<std::string> seen;
+        for (auto iter = params.begin() + 3; iter != params.end(); ++iter) {
+            int32_t const position = iter - (params.begin() + 3);
+            std::string value;
+            LocationCache::Location location;
+            bool const unquoted = unquote(*iter, value);
+            if (unquoted && _cache.get(keyPrefix + value, location)) {
+                tmp[location.first].push_back(location.second);
+                keyPositions[location.first].push_back(position);
+                continue;
+            }
+            if (!unquoted) {
+                splitKeys = false;
+            } else {
+                missedPositions[value].push_back(position);
+            }
+            if (seen.insert(*iter).second) {
+                missed.push_back(*iter);
+            }
+        }
+        LOGS(_log, LOG_LVL_DEBUG, "secondary lookup of " << params.size() - 3 << " keys, "
+             << missed.size() << " not cached");
+
+        std::vector<StringVector> batches;
+        for (size_t begin = 0; begin < missed.size(); begin += maxBatchKeys) {
+            size_t end = std::min(begin + maxBatchKeys, missed.size());
+            StringVector batch(params.begin(), params.begin() + 3);
+            batch.insert(batch.end(), missed.begin() + begin, missed.begin() + end);
+            batches.push_back(std::move(batch));
+        }
+        std::vector<std::vector<KeyLocation>> found(batches.size());
+        std::atomic<size_t> next{0};
+        std::mutex errorMtx;
+        std::exception_ptr error;
+        auto work = [this, &batches, &found, &next, &errorMtx, &error]() {
+            for (size_t j = next++; j < batches.size(); j = next++) {
+                try {
+                    found[j] = _keyLookup(batches[j]);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(errorMtx);
+                    if (!error) error = std::current_exception();
+                }
+            }
+        };
+        // Each query opens its own connection, so batches can run at once.
+        std::vector<std::thread> threads;
+        for (size_t t = 1; t < std::min(batches.size(), maxParallelBatches); ++t) {
+            threads.emplace_back(work);
+        }
+        work();
+        for (auto& thrd : threads) {
+            thrd.join();
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+
+        for (auto const& batchFound : found) {
+            for (auto const& keyLocation : batchFound) {
+                int chunkId = std::get<1>(keyLocation);
+                int subChunkId = std::get<2>(keyLocation);
+                tmp[chunkId].push_back(subChunkId);
+                _cache.put(keyPrefix + std::get<0>(keyLocation),
+                           LocationCache::Location(chunkId, subChunkId));
+                auto positions = missedPositions.find(std::get<0>(keyLocation));
+                if (positions == missedPositions.end()) {
+                    // The index holds the key in another form than the query.
+                    splitKeys = false;
+                } else {
+                    Int32Vector& chunkPositions = keyPositions[chunkId];
+                    chunkPositions.insert(chunkPositions.end(),
+                                          positions->second.begin(), positions->second.end());
+                }
+            }
+        }
+        for (auto const& elem : tmp) {
+            output.push_back(ChunkSpec(elem.first, elem.second));
+            if (splitKeys) {
+                output.back().keyPositions = keyPositions[elem.first];
+            }
+        }
+    }
+
+    /// Key, chunk and subchunk of one row of the secondary index.
+    using KeyLocation = std::tuple<std::string, int, int>;
+
+    /// @return the rows of the secondary index holding the keys in 'params'.
+    std::vector<KeyLocation> _keyLookup(StringVector const& params) {
+        std::vector<KeyLocation> found;
+        std::string sql = _buildLookupQuery(params, IN, true);
+        for(std::shared_ptr<sql::SqlResultIter> results = _sqlConnection.getQueryIter(sql);
+            not results->done();
+            ++(*results)) {
+            StringVector const& row = **results;
+            found.emplace_back(row[0], std::stoi(row[1]), std::stoi(row[2]));
+        }
+        return found;
+    }
+
     sql::SqlConnection _sqlConnection;
+    LocationCache _cache;
+};
+
+/// FileBackend looks up director keys in the memory-mapped index files of
+/// a directory, and hands constraints on tables without a file, or on keys
+/// that are not integers, to another backend.
+class FileBackend : public SecondaryIndex::Backend {
+public:
+    FileBackend(std::string const& indexPath,
+                std::shared_ptr<SecondaryIndex::Backend> const& fallback)
+        : _indexPath(indexPath), _fallback(fallback) {
+    }
+
+    ChunkSpecVector lookup(query::ConstraintVector const& cv) override {
+        std::map<int, std::set<int>> found;
+        std::map<int, Int32Vector> keyPositions;
+        bool const splitKeys = splitsKeys(cv);
+        bool hasIndex = false;
+        for (auto const& constraint : cv) {
+            QueryType queryType;
+            if (constraint.name == "sIndex") {
+                queryType = IN;
+            } else if (constraint.name == "sIndexNotIn") {
+                queryType = NOT_IN;
+            } else if (constraint.name == "sIndexBetween") {
+                queryType = BETWEEN;
+            } else if (constraint.name == "sIndexNotBetween") {
+                queryType = NOT_BETWEEN;
+            } else {
+                continue;
+            }
+            hasIndex = true;
+            StringVector const& params = constraint.params;
+            std::vector<int64_t> keys;
+            IndexFile::Ptr file;
+            if (params.size() >= 3) {
+                file = _getFile(params[0], params[1]);
+            }
+            if (!file || !_parseKeys(params, queryType, keys)) {
+                return _fallback->lookup(cv);
+            }
+            _fileLookup(*file, queryType, keys, found,
+                        (splitKeys && queryType == IN) ? &keyPositions : nullptr);
+        }
+        if (!hasIndex) {
+            throw SecondaryIndex::NoIndexConstraint();
+        }
+        ChunkSpecVector output;
+        for (auto const& elem : found) {
+            output.push_back(ChunkSpec(elem.first, Int32Vector(elem.second.begin(), elem.second.end())));
+            if (splitKeys) {
+                output.back().keyPositions = keyPositions[elem.first];
+            }
+        }
+        normalize(output);
+        return output;
+    }
+
+private:
+    /// @return the index file of db.table, nullptr if there is none.
+    IndexFile::Ptr _getFile(std::string const& db, std::string const& table) {
+        std::string path = _indexPath + "/" + sanitizeName(db) + "__" + sanitizeName(table) + ".idx";
+        std::lock_guard<std::mutex> lock(_filesMtx);
+        auto iter = _files.find(path);
+        if (iter != _files.end()) {
+            return iter->second;
+        }
+        // Missing files are looked for again by later queries, so that an
+        // index file written after startup gets used.
+        if (::access(path.c_str(), R_OK) != 0) {
+            return nullptr;
+        }
+        IndexFile::Ptr file;
+        try {
+            file = std::make_shared<IndexFile>(path);
+        } catch (std::runtime_error const& e) {
+            LOGS(_log, LOG_LVL_ERROR, e.what());
+            return nullptr;
+        }
+        LOGS(_log, LOG_LVL_INFO, "secondary index " << path << " holds " << file->size() << " keys");
+        _files[path] = file;
+        return file;
+    }
+
+    /// Parse the keys of a constraint, from params[3] on.
+    /// @return false if a key is not an integer, or a bound is missing.
+    static bool _parseKeys(StringVector const& params, QueryType queryType,
+                           std::vector<int64_t>& keys) {
+        for (auto iter = params.begin() + 3; iter != params.end(); ++iter) {
+            int64_t key;
+            if (!parseKey(*iter, key)) {
+                return false;
+            }
+            keys.push_back(key);
+        }
+        bool const bounded = (queryType == BETWEEN || queryType == NOT_BETWEEN);
+        return !bounded || keys.size() == 2;
+    }
+
+    /// Add the chunk and subchunk of each index entry matching the
+    /// constraint to 'found', and for an IN constraint the position of its
+    /// key to 'keyPositions', unless it is nullptr.
+    static void _fileLookup(IndexFile const& file, QueryType queryType,
+                            std::vector<int64_t>& keys, std::map<int, std::set<int>>& found,
+                            std::map<int, Int32Vector>* keyPositions) {
+        auto add = [&file, &found](size_t begin, size_t end) {
+            for (size_t j = begin; j < end; ++j) {
+                found[file.chunkId(j)].insert(file.subChunkId(j));
+            }
+        };
+        size_t const n = file.size();
+        switch (queryType) {
+        case IN:
+            for (size_t position = 0; position < keys.size(); ++position) {
+                size_t j = file.lowerBound(keys[position]);
+                if (j < n && file.key(j) == keys[position]) {
+                    add(j, j + 1);
+                    if (keyPositions != nullptr) {
+                        (*keyPositions)[file.chunkId(j)].push_back(position);
+                    }
+                }
+            }
+            break;
+        case NOT_IN: {
+            std::sort(keys.begin(), keys.end());
+            size_t begin = 0;
+            for (int64_t key : keys) {
+                size_t j = file.lowerBound(key);
+                add(begin, j);
+                begin = std::max(begin, file.upperBound(key));
+            }
+            add(begin, n);
+            break;
+        }
+        case BETWEEN:
+            if (keys[0] <= keys[1]) {
+                add(file.lowerBound(keys[0]), file.upperBound(keys[1]));
+            }
+            break;
+        case NOT_BETWEEN:
+            if (keys[0] <= keys[1]) {
+                add(0, file.lowerBound(keys[0]));
+                add(file.upperBound(keys[1]), n);
+            } else {
+                add(0, n);
+            }
+            break;
+        }
+    }
+
+    std::string const _indexPath;
+    std::shared_ptr<SecondaryIndex::Backend> const _fallback;
+    std::mutex _filesMtx; ///< Protects _files
+    std::map<std::string, IndexFile::Ptr> _files; ///< Mapped files, by path
 };
 
 class FakeBackend : public SecondaryIndex::Backend {
@@ -245,8 +723,12 @@ private:
     }
 };
 
-SecondaryIndex::SecondaryIndex(mysql::MySqlConfig const& c)
-    : _backend(std::make_shared<MySqlBackend>(c)) {
+SecondaryIndex::SecondaryIndex(mysql::MySqlConfig const& c, size_t cacheSize,
+                               std::string const& indexPath)
+    : _backend(std::make_shared<MySqlBackend>(c, cacheSize)) {
+    if (!indexPath.empty()) {
+        _backend = std::make_shared<FileBackend>(indexPath, _backend);
+    }
 }
 
 SecondaryIndex::SecondaryIndex()
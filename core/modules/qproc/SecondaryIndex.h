@@ -33,6 +33,7 @@
 // System headers
 #include <memory>
 #include <stdexcept>
+#include <string>
 
 // Qserv headers
 #include "mysql/MySqlConfig.h"
@@ -51,7 +52,16 @@ namespace qproc {
  */
 class SecondaryIndex {
 public:
-    explicit SecondaryIndex(mysql::MySqlConfig const& c);
+    /** Construct an instance looking up the index tables through 'c'
+     *
+     *  @param cacheSize: number of director keys whose chunk and subchunk
+     *                    are kept for later IN lookups, 0 disables the cache.
+     *  @param indexPath: directory of the secondary index files, used instead
+     *                    of the index tables for the director tables they
+     *                    cover. Empty if there are none.
+     */
+    explicit SecondaryIndex(mysql::MySqlConfig const& c, size_t cacheSize=0,
+                            std::string const& indexPath=std::string());
 
     /** Construct a fake instance
      *
@@ -33,6 +33,7 @@
 #include "qproc/TaskMsgFactory.h"
 
 // System headers
+#include <cstdint>
 #include <stdexcept>
 
 // Third-party headers
@@ -54,38 +55,61 @@ namespace qserv {
 namespace qproc {
 
 
-std::shared_ptr<proto::TaskMsg> TaskMsgFactory::_makeMsg(ChunkQuerySpec const& chunkQuerySpec,
-                                                        std::string const& chunkResultName,
-                                                        uint64_t queryId, int jobId, int attemptCount) {
-    std::string resultTable("Asdfasfd");
-    if (!chunkResultName.empty()) { resultTable = chunkResultName; }
-    auto taskMsg = std::make_shared<proto::TaskMsg>();
-    // shared
-    taskMsg->set_session(_session);
-    taskMsg->set_db(chunkQuerySpec.db);
-    taskMsg->set_protocol(2);
-    taskMsg->set_queryid(queryId);
-    taskMsg->set_jobid(jobId);
-    taskMsg->set_attemptcount(attemptCount);
+/// Set the fields that are the same for all chunks of the user query.
+void TaskMsgFactory::_fillShared(proto::TaskMsg& taskMsg, ChunkQuerySpec const& chunkQuerySpec,
+                                 uint64_t queryId) {
+    taskMsg.set_session(_session);
+    taskMsg.set_db(chunkQuerySpec.db);
+    taskMsg.set_protocol(3); // Accept row bundles or column blocks.
+    taskMsg.set_queryid(queryId);
+    taskMsg.set_czarid(_czarId);
     // scanTables (for shared scans)
-    // check if more than 1 db in scanInfo
-    std::string db;
     for(auto const& sTbl : chunkQuerySpec.scanInfo.infoTables) {
-        if (db.empty()) {
-            db = sTbl.db;
-        }
+        lsst::qserv::proto::TaskMsg_ScanTable *msgScanTbl = taskMsg.add_scantable();
+        sTbl.copyToScanTable(msgScanTbl);
     }
 
-    for(auto const& sTbl : chunkQuerySpec.scanInfo.infoTables) {
-        lsst::qserv::proto::TaskMsg_ScanTable *msgScanTbl = taskMsg->add_scantable();
-        sTbl.copyToScanTable(msgScanTbl);
+    taskMsg.set_scanpriority(chunkQuerySpec.scanInfo.scanRating);
+    taskMsg.set_scaninteractive(chunkQuerySpec.scanInteractive);
+    // Tables the worker locks the index files of.
+    if (chunkQuerySpec.scanInfo.access != proto::ScanInfo::Access::SCAN) {
+        taskMsg.set_scanaccess(chunkQuerySpec.scanInfo.access);
+        for (auto const& sTbl : chunkQuerySpec.scanInfo.indexTables) {
+            sTbl.copyToScanTable(taskMsg.add_indextable());
+        }
+    }
+    if (_deadlineMs > 0) {
+        taskMsg.set_deadlinems(_deadlineMs);
     }
+    if (_trace) {
+        taskMsg.set_trace(true);
+    }
+    if (_resultMaxBytes > 0) {
+        taskMsg.set_resultminbytes(_resultMinBytes);
+        taskMsg.set_resultmaxbytes(_resultMaxBytes);
+    }
+    if (_aggFold != nullptr) {
+        for (auto fold : *_aggFold) {
+            taskMsg.add_aggfold(static_cast<proto::TaskMsg::AggFold>(fold));
+        }
+    }
+    // Fragments then carry no queries, the worker fills them in from these.
+    if (chunkQuerySpec.taggedQueries != nullptr) {
+        for (auto const& qry : *chunkQuerySpec.taggedQueries) {
+            taskMsg.add_querytemplate(qry);
+        }
+    }
+}
 
-    taskMsg->set_scanpriority(chunkQuerySpec.scanInfo.scanRating);
-    taskMsg->set_scaninteractive(chunkQuerySpec.scanInteractive);
+
+/// Set the fields of one job on one chunk, except for its id and attempt.
+void TaskMsgFactory::_fillJob(proto::TaskMsg& taskMsg, ChunkQuerySpec const& chunkQuerySpec,
+                              std::string const& chunkResultName) {
+    std::string resultTable("Asdfasfd");
+    if (!chunkResultName.empty()) { resultTable = chunkResultName; }
 
     // per-chunk
-    taskMsg->set_chunkid(chunkQuerySpec.chunkId);
+    taskMsg.set_chunkid(chunkQuerySpec.chunkId);
     // per-fragment
     // TODO refactor to simplify
     if (chunkQuerySpec.nextFragment.get()) {
@@ -97,7 +121,7 @@ std::shared_ptr<proto::TaskMsg> TaskMsgFactory::_makeMsg(ChunkQuerySpec const& c
             }
             // Linked fragments will not have valid subChunkTables vectors,
             // So, we reuse the root fragment's vector.
-            _addFragment(*taskMsg, resultTable, chunkQuerySpec.subChunkTables,
+            _addFragment(taskMsg, resultTable, chunkQuerySpec.subChunkTables,
                          sPtr->subChunkIds, sPtr->queries);
             sPtr = sPtr->nextFragment.get();
         }
@@ -106,10 +130,9 @@ std::shared_ptr<proto::TaskMsg> TaskMsgFactory::_makeMsg(ChunkQuerySpec const& c
         for(unsigned int t=0;t<(chunkQuerySpec.queries).size();t++){
             LOGS(_log, LOG_LVL_DEBUG, (chunkQuerySpec.queries).at(t));
         }
-        _addFragment(*taskMsg, resultTable, chunkQuerySpec.subChunkTables,
+        _addFragment(taskMsg, resultTable, chunkQuerySpec.subChunkTables,
                      chunkQuerySpec.subChunkIds, chunkQuerySpec.queries);
     }
-    return taskMsg;
 }
 
 
@@ -142,12 +165,62 @@ void TaskMsgFactory::_addFragment(proto::TaskMsg& taskMsg, std::string const& re
 }
 
 
+/// @return the serialized fields set by _fillJob(), from the retry cache
+///         if the job was retried recently.
+std::string TaskMsgFactory::_jobBytes(ChunkQuerySpec const& s, std::string const& chunkResultName,
+                                      int jobId, int attemptCount) {
+    if (attemptCount > 0) {
+        std::lock_guard<std::mutex> lock(_retryMtx);
+        for (auto iter = _retryJobs.begin(); iter != _retryJobs.end(); ++iter) {
+            if (iter->first == jobId) {
+                _retryJobs.splice(_retryJobs.begin(), _retryJobs, iter);
+                return iter->second;
+            }
+        }
+    }
+    proto::TaskMsg job;
+    _fillJob(job, s, chunkResultName);
+    std::string bytes = job.SerializePartialAsString();
+    if (attemptCount > 0) {
+        std::lock_guard<std::mutex> lock(_retryMtx);
+        _retryJobs.emplace_front(jobId, bytes);
+        if (_retryJobs.size() > RETRY_CACHE_SIZE) _retryJobs.pop_back();
+    }
+    return bytes;
+}
+
+
 void TaskMsgFactory::serializeMsg(ChunkQuerySpec const& s,
                                   std::string const& chunkResultName,
                                   uint64_t queryId, int jobId, int attemptCount,
                                   std::ostream& os) {
-    std::shared_ptr<proto::TaskMsg> m = _makeMsg(s, chunkResultName, queryId, jobId, attemptCount);
-    m->SerializeToOstream(&os);
+    // Everything _fillShared() reads, the scan tables are the same for a
+    // given db in one user query but are included to be safe.
+    std::string key = s.db + "|" + std::to_string(queryId) + "|" + std::to_string(s.scanInteractive)
+        + "|" + std::to_string(s.scanInfo.scanRating) + "|" + std::to_string(s.scanInfo.access);
+    for (auto const& sTbl : s.scanInfo.infoTables) {
+        key += "|" + sTbl.db + "." + sTbl.table + ":" + std::to_string(sTbl.lockInMemory)
+            + ":" + std::to_string(sTbl.scanRating);
+    }
+    for (auto const& sTbl : s.scanInfo.indexTables) {
+        key += "|i:" + sTbl.db + "." + sTbl.table;
+    }
+    key += "|" + std::to_string(reinterpret_cast<uintptr_t>(s.taggedQueries.get()));
+    {
+        std::lock_guard<std::mutex> lock(_sharedMtx);
+        if (key != _sharedKey || _sharedBytes.empty()) {
+            proto::TaskMsg shared;
+            _fillShared(shared, s, queryId);
+            _sharedBytes = shared.SerializePartialAsString();
+            _sharedKey = key;
+        }
+        os << _sharedBytes;
+    }
+    os << _jobBytes(s, chunkResultName, jobId, attemptCount);
+    proto::TaskMsg attempt;
+    attempt.set_jobid(jobId);
+    attempt.set_attemptcount(attemptCount);
+    attempt.SerializePartialToOstream(&os);
 }
 
 }}} // namespace lsst::qserv::qproc
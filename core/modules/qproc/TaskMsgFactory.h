@@ -33,10 +33,14 @@
 
 // System headers
 #include <iostream>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <string>
 
 // Qserv headers
 #include "global/DbTable.h"
+#include "proto/InMemoryAggregator.h"
 #include "proto/worker.pb.h"
 
 namespace lsst {
@@ -47,13 +51,40 @@ class ChunkQuerySpec;
 
 /// TaskMsgFactory is a factory for TaskMsg (protobuf) objects.
 /// All member variables must be thread safe.
+///
+/// The fields that are the same for every chunk of a user query are
+/// serialized once, and each message is those bytes followed by the
+/// serialized per-job fields. Parsing concatenated protobuf messages merges
+/// them, so workers read the same TaskMsg as if it had been built whole.
+///
+/// Messages are built again for every attempt of a job rather than kept.
+/// The per-job fields of jobs that are being retried, other than the attempt
+/// number, are kept in a small least recently used cache so that jobs failing
+/// repeatedly do not have their fragments serialized each time.
 class TaskMsgFactory {
 public:
     using Ptr = std::shared_ptr<TaskMsgFactory>;
 
-    TaskMsgFactory(uint64_t session) : _session(session) {}
+    /// @param deadlineMs - time the workers are given to run each task, 0 for none.
+    /// @param trace - true to have the workers return the time spent in each stage.
+    /// @param resultMinBytes, resultMaxBytes - Result message sizes the workers
+    ///        are asked to keep to, 0 for the worker default.
+    /// @param aggFold - how the workers may fold the result columns of the
+    ///        chunks they hold, null to have every chunk result sent on its own.
+    TaskMsgFactory(uint64_t session, uint32_t czarId=0, uint32_t deadlineMs=0, bool trace=false,
+                   uint32_t resultMinBytes=0, uint32_t resultMaxBytes=0,
+                   std::shared_ptr<proto::InMemoryAggregator::FoldVector const> const& aggFold=nullptr)
+        : _session(session), _czarId(czarId), _deadlineMs(deadlineMs), _trace(trace),
+          _resultMinBytes(resultMinBytes), _resultMaxBytes(resultMaxBytes), _aggFold(aggFold) {}
     virtual ~TaskMsgFactory() {}
 
+    /// @return true if the workers may fold the results of the jobs into
+    ///         those of other jobs, which can then not be retried.
+    bool getFoldOnWorker() const { return _aggFold != nullptr; }
+
+    /// Maximum number of retried jobs whose fields are kept.
+    static size_t const RETRY_CACHE_SIZE = 32;
+
     /// Construct a TaskMsg and serialize it to a stream
     virtual void serializeMsg(ChunkQuerySpec const& s,
                       std::string const& chunkResultName,
@@ -61,9 +92,11 @@ public:
                       std::ostream& os);
 
 private:
-    std::shared_ptr<proto::TaskMsg> _makeMsg(ChunkQuerySpec const& s,
-                                             std::string const& chunkResultName,
-                                             uint64_t queryId, int jobId, int attemptCount);
+    void _fillShared(proto::TaskMsg& taskMsg, ChunkQuerySpec const& s, uint64_t queryId);
+    void _fillJob(proto::TaskMsg& taskMsg, ChunkQuerySpec const& s,
+                  std::string const& chunkResultName);
+    std::string _jobBytes(ChunkQuerySpec const& s, std::string const& chunkResultName,
+                          int jobId, int attemptCount);
 
     void _addFragment(proto::TaskMsg& taskMsg, std::string const& resultName,
                       DbTableSet const& subChunkTables, std::vector<int> const& subChunkIds,
@@ -71,6 +104,21 @@ private:
 
     /// All member variable need to be thread safe.
     uint64_t const _session;
+    uint32_t const _czarId; ///< QMeta id of the czar sending the messages.
+    uint32_t const _deadlineMs; ///< Worker deadline of each task, 0 for none.
+    bool const _trace; ///< True if the query is traced.
+    uint32_t const _resultMinBytes; ///< Smallest Result message size asked for, 0 for none.
+    uint32_t const _resultMaxBytes; ///< Largest Result message size asked for, 0 for none.
+    /// How the workers may fold the result columns, null for not at all.
+    std::shared_ptr<proto::InMemoryAggregator::FoldVector const> const _aggFold;
+
+    std::mutex _sharedMtx; ///< Protects _sharedKey and _sharedBytes
+    std::string _sharedKey; ///< Identifies the fields serialized in _sharedBytes
+    std::string _sharedBytes; ///< Serialized fields common to all chunks
+
+    std::mutex _retryMtx; ///< Protects _retryJobs
+    /// Serialized per-job fields of retried jobs by job id, most recently used first.
+    std::list<std::pair<int, std::string>> _retryJobs;
 };
 
 }}} // namespace lsst::qserv::qproc
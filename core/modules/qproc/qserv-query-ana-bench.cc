@@ -0,0 +1,371 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/// qserv-query-ana-bench.cc measures the time and the heap allocations of
+/// each stage of query analysis on the czar: parsing, every qana plugin,
+/// and the generation of the chunk queries. Queries come from a built-in
+/// corpus of real-world and generated queries, or from a file, and are
+/// analyzed against the CSS map of the unit tests (tests/QueryAnaFixture.h).
+
+// System header
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Qserv headers
+#include "parser/SelectParser.h"
+#include "qproc/ChunkSpec.h"
+#include "qproc/QuerySession.h"
+#include "tests/QueryAnaFixture.h"
+#include "util/CmdLineParser.h"
+
+namespace parser = lsst::qserv::parser;
+namespace qproc  = lsst::qserv::qproc;
+namespace tests  = lsst::qserv::tests;
+namespace util   = lsst::qserv::util;
+
+namespace {
+
+std::atomic<uint64_t> allocCount{0};
+std::atomic<uint64_t> allocBytes{0};
+
+} // namespace
+
+// Count the heap allocations of the whole program.
+
+void* operator new(std::size_t size) {
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add(size, std::memory_order_relaxed);
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+// Command line parameters
+
+std::string  operation;
+std::string  corpusFileName;
+unsigned int iterations;
+unsigned int numChunks;
+unsigned int inSize;
+unsigned int boolDepth;
+unsigned int numColumns;
+std::string  jsonFileName;
+
+
+typedef std::vector<std::pair<std::string, std::string>> Corpus; ///< name, query
+
+
+/// @return a WHERE condition of 2^depth comparisons joined by nested AND and OR.
+std::string makeBoolTree(unsigned depth, unsigned& leaf) {
+    if (depth == 0) {
+        ++leaf;
+        return "rFlux_PS" + std::to_string(leaf % 16) + " > " + std::to_string(leaf);
+    }
+    std::string const left = makeBoolTree(depth - 1, leaf);
+    std::string const right = makeBoolTree(depth - 1, leaf);
+    return "(" + left + ((depth % 2) ? " AND " : " OR ") + right + ")";
+}
+
+
+Corpus makeCorpus() {
+    // Queries of the qproc/testQueryAna* suites, as users write them.
+    Corpus corpus = {
+        {"filter", "SELECT * FROM Object WHERE someField > 5.0;"},
+        {"count", "SELECT count(*) from LSST.Source;"},
+        {"between_order_by", "select * from LSST.Object WHERE ra_PS BETWEEN 150 AND 150.2 "
+            "and decl_PS between 1.6 and 1.7 ORDER BY objectId;"},
+        {"areaspec_aggregate", "select count(*), max(iFlux_PS) from LSST.Object "
+            "where qserv_areaspec_box(0,0,1,1) and iFlux_PS > 100 and col1=col2 and col3=4;"},
+        {"group_by_having", "select count(*) from Object group by flags having count(*) > 3;"},
+        {"functions_order_by", "SELECT objectId, ROUND(iE1_SG, 3), ROUND(ABS(iE1_SG), 3) FROM Object "
+            "WHERE iE1_SG between -0.1 and 0.1 ORDER BY ROUND(ABS(iE1_SG), 3);"},
+        {"secondary_index", "SELECT * FROM Object WHERE objectIdObjTest = 430213989000;"},
+        {"near_neighbour", "SELECT o1.objectId, o2.objectId objectId2 FROM Object o1, Object o2 "
+            "WHERE scisql_angSep(o1.ra_Test, o1.decl_Test, o2.ra_Test, o2.decl_Test) < 0.00001 "
+            "AND o1.objectId <> o2.objectId AND "
+            "ABS( (scisql_fluxToAbMag(o1.gFlux_PS)-scisql_fluxToAbMag(o1.rFlux_PS)) - "
+            "(scisql_fluxToAbMag(o2.gFlux_PS)-scisql_fluxToAbMag(o2.rFlux_PS)) ) < 1;"},
+        {"match_join", "SELECT count(*) FROM Object o "
+            "INNER JOIN RefObjMatch o2t ON (o.objectIdObjTest = o2t.objectId) "
+            "INNER JOIN SimRefObject t ON (o2t.refObjectId = t.refObjectId) "
+            "WHERE closestToObj = 1 OR closestToObj is NULL;"}
+    };
+
+    // Generated queries, sized by the command line.
+    std::string in;
+    for (unsigned i = 0; i < ::inSize; ++i) {
+        in += (i ? "," : "") + std::to_string(430213989000ULL + 7 * i);
+    }
+    corpus.emplace_back("in_list_" + std::to_string(::inSize),
+        "SELECT objectId, ra_PS, decl_PS FROM Object WHERE objectIdObjTest IN (" + in + ");");
+
+    unsigned leaf = 0;
+    corpus.emplace_back("bool_tree_" + std::to_string(::boolDepth),
+        "SELECT objectId FROM Object WHERE qserv_areaspec_box(0,0,10,10) AND "
+        + makeBoolTree(::boolDepth, leaf) + ";");
+
+    std::string columns;
+    for (unsigned i = 0; i < ::numColumns; ++i) {
+        char const* alias = (i % 3 == 0) ? "o" : (i % 3 == 1) ? "o2t" : "t";
+        columns += ", " + std::string(alias) + ".col" + std::to_string(i);
+    }
+    corpus.emplace_back("match_join_" + std::to_string(::numColumns),
+        "SELECT o.objectId, t.refObjectId" + columns + " FROM Object o "
+        "INNER JOIN RefObjMatch o2t ON (o.objectIdObjTest = o2t.objectId) "
+        "INNER JOIN SimRefObject t ON (o2t.refObjectId = t.refObjectId) "
+        "WHERE qserv_areaspec_box(0,0,10,10) AND closestToObj = 1 ORDER BY o.objectId;");
+    return corpus;
+}
+
+
+/// Time and allocations of a stage, summed over all the runs.
+struct Totals {
+    double seconds{0};
+    uint64_t allocs{0};
+    uint64_t bytes{0};
+    void add(Totals const& t) { seconds += t.seconds; allocs += t.allocs; bytes += t.bytes; }
+};
+
+
+/// Attributes the time and the allocations since the previous mark() to a stage.
+class StageClock {
+public:
+    void reset() {
+        _start = std::chrono::steady_clock::now();
+        _allocs = allocCount.load();
+        _bytes = allocBytes.load();
+    }
+
+    void mark(std::string const& stage) {
+        auto const now = std::chrono::steady_clock::now();
+        uint64_t const allocs = allocCount.load();
+        uint64_t const bytes = allocBytes.load();
+        Totals t;
+        t.seconds = std::chrono::duration<double>(now - _start).count();
+        t.allocs = allocs - _allocs;
+        t.bytes = bytes - _bytes;
+        auto it = _index.find(stage);
+        if (it == _index.end()) {
+            it = _index.emplace(stage, stages.size()).first;
+            stages.emplace_back(stage, Totals());
+        }
+        stages[it->second].second.add(t);
+        run.add(t);
+        // Exclude the bookkeeping above from the next stage.
+        reset();
+    }
+
+    std::vector<std::pair<std::string, Totals>> stages; ///< In the order they first ran.
+    Totals run; ///< Of the stages since the caller last cleared it.
+
+private:
+    std::map<std::string, size_t> _index;
+    std::chrono::steady_clock::time_point _start;
+    uint64_t _allocs{0};
+    uint64_t _bytes{0};
+};
+
+
+/// Analyze 'sql' and build its chunk queries, as UserQuerySelect does.
+/// @return an error message, empty on success.
+std::string analyze(tests::QueryAnaFixture& fixture, std::string const& sql, StageClock& clock) {
+    auto qs = std::make_shared<qproc::QuerySession>(fixture.qsTest);
+    qs->setStageObserver([&clock](std::string const& stage) { clock.mark(stage); });
+    clock.reset();
+    auto stmt = qs->parseQuery(sql, parser::SelectParser::ANTLR4);
+    clock.mark("parse");
+    if (stmt == nullptr) return qs->getError();
+    qs->analyzeQuery(sql, stmt);
+    if (not qs->getError().empty()) return qs->getError();
+
+    clock.reset();
+    for (unsigned i = 0; i < ::numChunks; ++i) {
+        qs->addChunk(qproc::ChunkSpec::makeFake(100 + i, true));
+    }
+    clock.mark("add chunks");
+    qs->finalize();
+
+    clock.reset();
+    auto queryTemplates = qs->makeQueryTemplates();
+    std::shared_ptr<std::vector<std::string> const> taggedQueries;
+    if (qs->cQueryBegin() != qs->cQueryEnd()) {
+        taggedQueries = qs->makeTaggedQueries(queryTemplates, *qs->cQueryBegin());
+    }
+    clock.mark("templates");
+    size_t queries = 0;
+    for (auto i = qs->cQueryBegin(), e = qs->cQueryEnd(); i != e; ++i) {
+        queries += qs->buildChunkQuerySpec(queryTemplates, *i, taggedQueries)->queries.size();
+    }
+    clock.mark("chunk queries");
+    return queries > 0 ? std::string() : "no chunk queries";
+}
+
+
+void writeReport(StageClock const& clock, std::vector<std::pair<std::string, Totals>> const& queries,
+                 uint64_t runs) {
+    auto const perRun = [runs](double v) { return runs ? v / runs : 0; };
+    std::cout << std::left << std::setw(28) << "stage" << std::right << std::setw(14) << "us/query"
+              << std::setw(14) << "allocs/query" << std::setw(12) << "KB/query" << std::endl;
+    for (auto const& stage : clock.stages) {
+        Totals const& t = stage.second;
+        std::cout << std::left << std::setw(28) << stage.first << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(14) << perRun(t.seconds * 1e6)
+                  << std::setw(14) << perRun(t.allocs) << std::setw(12) << perRun(t.bytes / 1e3) << std::endl;
+    }
+    std::cout << std::endl << std::left << std::setw(28) << "query" << std::right << std::setw(14) << "us"
+              << std::setw(14) << "allocs" << std::setw(12) << "KB" << std::endl;
+    for (auto const& query : queries) {
+        Totals const& t = query.second;
+        double const n = ::iterations;
+        std::cout << std::left << std::setw(28) << query.first << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(14) << t.seconds * 1e6 / n
+                  << std::setw(14) << t.allocs / n << std::setw(12) << t.bytes / 1e3 / n << std::endl;
+    }
+    if (::jsonFileName.empty()) return;
+    std::ofstream file(::jsonFileName);
+    file << "{\"iterations\":" << ::iterations << ",\"chunks\":" << ::numChunks << ",\"stages\":[";
+    for (size_t i = 0; i < clock.stages.size(); ++i) {
+        Totals const& t = clock.stages[i].second;
+        file << (i ? "," : "") << "{\"name\":\"" << clock.stages[i].first << "\""
+             << ",\"us_per_query\":" << perRun(t.seconds * 1e6) << ",\"allocs_per_query\":" << perRun(t.allocs)
+             << ",\"bytes_per_query\":" << perRun(t.bytes) << "}";
+    }
+    file << "],\"queries\":[";
+    for (size_t i = 0; i < queries.size(); ++i) {
+        Totals const& t = queries[i].second;
+        double const n = ::iterations;
+        file << (i ? "," : "") << "{\"name\":\"" << queries[i].first << "\""
+             << ",\"us\":" << t.seconds * 1e6 / n << ",\"allocs\":" << t.allocs / n
+             << ",\"bytes\":" << t.bytes / n << "}";
+    }
+    file << "]}" << std::endl;
+}
+
+
+int run() {
+    Corpus corpus;
+    if (::operation == "FILE") {
+        std::ifstream file(::corpusFileName);
+        if (not file.good()) {
+            std::cerr << "error: failed to open the query file: " << ::corpusFileName << std::endl;
+            return 1;
+        }
+        std::string line;
+        for (int n = 1; std::getline(file, line); ++n) {
+            if (line.empty() || line[0] == '#') continue;
+            corpus.emplace_back("line_" + std::to_string(n), line);
+        }
+    } else {
+        corpus = makeCorpus();
+    }
+
+    tests::QueryAnaFixture fixture;
+    StageClock clock;
+    std::vector<std::pair<std::string, Totals>> queries;
+    uint64_t runs = 0;
+    for (auto const& query : corpus) {
+        // The first run also fills the caches of the CSS metadata, it is not counted.
+        StageClock warmup;
+        std::string error = analyze(fixture, query.second, warmup);
+        clock.run = Totals();
+        for (unsigned i = 0; i < ::iterations && error.empty(); ++i) {
+            error = analyze(fixture, query.second, clock);
+            ++runs;
+        }
+        if (not error.empty()) {
+            std::cerr << "error: " << query.first << " " << error << std::endl;
+            return 1;
+        }
+        queries.emplace_back(query.first, clock.run);
+    }
+    writeReport(clock, queries, runs);
+    return 0;
+}
+} // namespace
+
+int main(int argc, const char* const argv[]) {
+
+    // Parse command line parameters
+    try {
+        util::CmdLineParser parser(
+            argc,
+            argv,
+            "\n"
+            "Usage:\n"
+            "  CORPUS\n"
+            "  FILE   <query-file-name>\n"
+            "  [--iterations=<value>]\n"
+            "  [--chunks=<value>]\n"
+            "  [--in-size=<value>]\n"
+            "  [--bool-depth=<value>]\n"
+            "  [--columns=<value>]\n"
+            "  [--json=<file>]\n"
+            "\n"
+            "Flags an options:\n"
+            "  --iterations=<value> - times each query is analyzed (default: 10)\n"
+            "  --chunks=<value>     - chunks the chunk queries are built for (default: 100)\n"
+            "  --in-size=<value>    - CORPUS: values of the generated IN list (default: 1000)\n"
+            "  --bool-depth=<value> - CORPUS: depth of the generated AND/OR tree of\n"
+            "                         2^depth comparisons (default: 8)\n"
+            "  --columns=<value>    - CORPUS: columns selected by the generated match table\n"
+            "                         join (default: 50)\n"
+            "  --json=<file>        - also write the results to the file as JSON\n"
+            "\n"
+            "Parameters:\n"
+            "  <query-file-name>  - a file with one query per line, lines starting with #\n"
+            "                       are ignored. Tables are those of the unit tests' CSS map\n");
+
+        ::operation = parser.parameterRestrictedBy(1, {"CORPUS", "FILE"});
+        if (::operation == "FILE") {
+            ::corpusFileName = parser.parameter<std::string>(2);
+        }
+        ::iterations = std::max(1U, parser.option<unsigned int>("iterations", 10));
+        ::numChunks  = std::max(1U, parser.option<unsigned int>("chunks", 100));
+        ::inSize     = std::max(1U, parser.option<unsigned int>("in-size", 1000));
+        ::boolDepth  = parser.option<unsigned int>("bool-depth", 8);
+        ::numColumns = parser.option<unsigned int>("columns", 50);
+
+        ::jsonFileName = parser.option<std::string>("json", "");
+
+    } catch (std::exception const& ex) {
+        return 1;
+    }
+    return ::run();
+}
@@ -55,6 +55,7 @@ namespace test = boost::test_tools;
 using lsst::qserv::qproc::ChunkSpec;
 using lsst::qserv::qproc::ChunkSpecVector;
 using lsst::qserv::IntVector;
+using lsst::qserv::Int32Vector;
 
 namespace {
     ChunkSpec c1 = ChunkSpec::makeFake(101);
@@ -128,6 +129,29 @@ BOOST_AUTO_TEST_CASE(Intersect) {
     std::sort(c1c2.subChunks.begin(), c1c2.subChunks.end());
     BOOST_CHECK_EQUAL(c1c2, nc1c2);
 }
+BOOST_AUTO_TEST_CASE(KeyPositions) {
+    ChunkSpec a(7, {1, 2});
+    a.keyPositions = {4, 0};
+    ChunkSpec b(7, {2, 3});
+    b.keyPositions = {3, 4};
+
+    // Keys of both sides are merged, a side without keys needs all of them.
+    ChunkSpecVector v = {a, b};
+    normalize(v);
+    BOOST_CHECK_EQUAL(v.size(), 1u);
+    BOOST_CHECK(v[0].keyPositions == Int32Vector({0, 3, 4}));
+    ChunkSpec c(7, {});
+    v = {a, c};
+    normalize(v);
+    BOOST_CHECK(v[0].keyPositions.empty());
+
+    // Restricting keeps the keys of either side, or those of both.
+    ChunkSpec ac = a.intersect(ChunkSpec(7, {2}));
+    BOOST_CHECK(ac.subChunks == Int32Vector({2}));
+    BOOST_CHECK(ac.keyPositions == Int32Vector({0, 4}));
+    BOOST_CHECK(a.intersect(b).keyPositions == Int32Vector({4}));
+}
+
 BOOST_AUTO_TEST_CASE(Vector) {
     // Test the intersection where:
     // ChunkSpec is the same
@@ -170,4 +194,24 @@ BOOST_AUTO_TEST_CASE(Vector) {
     ChunkSpecVector v1v2 = intersect(v1, v2);
 }
 
+BOOST_AUTO_TEST_CASE(Sample) {
+    ChunkSpecVector all;
+    for (int chunkId = 0; chunkId < 10000; ++chunkId) {
+        all.push_back(ChunkSpec::makeFake(chunkId));
+    }
+    BOOST_CHECK_EQUAL(sampleChunks(all, 1).size(), all.size());
+
+    // One chunk of each run of 100 consecutive ids.
+    ChunkSpecVector sample = sampleChunks(all, 100);
+    BOOST_REQUIRE_EQUAL(sample.size(), 100U);
+    for (int j = 0; j < 100; ++j) {
+        BOOST_CHECK_EQUAL(sample[j].chunkId / 100, j);
+    }
+    // Deterministic, and the same chunks are picked from a subset.
+    ChunkSpecVector half(all.begin(), all.begin() + 5000);
+    ChunkSpecVector halfSample = sampleChunks(half, 100);
+    BOOST_REQUIRE_EQUAL(halfSample.size(), 50U);
+    BOOST_CHECK(std::equal(halfSample.begin(), halfSample.end(), sample.begin()));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
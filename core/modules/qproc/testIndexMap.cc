@@ -42,8 +42,10 @@
 #include "boost/algorithm/string.hpp"
 
 // Qserv headers
+#include "css/StripingParams.h"
 #include "global/intTypes.h"
 #include "qproc/ChunkSpec.h"
+#include "qproc/IndexMap.h"
 #include "qproc/SecondaryIndex.h"
 #include "query/Constraint.h"
 
@@ -56,6 +58,7 @@ namespace test = boost::test_tools;
 
 using lsst::qserv::qproc::ChunkSpec;
 using lsst::qserv::qproc::ChunkSpecVector;
+using lsst::qserv::qproc::IndexMap;
 using lsst::qserv::qproc::SecondaryIndex;
 using lsst::qserv::query::Constraint;
 using lsst::qserv::query::ConstraintVector;
@@ -121,6 +124,31 @@ BOOST_AUTO_TEST_CASE(SecLookupMultipleObjectIdBETWEEN) {
               std::ostream_iterator<ChunkSpec>(std::cout, ",\n"));
 }
 
+BOOST_AUTO_TEST_CASE(RegionCovers) {
+    lsst::qserv::css::StripingParams sp(85, 12, 1, 0.01);
+    IndexMap im(sp, std::make_shared<SecondaryIndex>());
+    char const* box[4] = {"1.0", "3.0", "1.2", "3.3"};
+    char const* circle[3] = {"10.0", "-5.0", "0.1"};
+    char const* nearCircle[3] = {"10.001", "-5.001", "0.1"};
+    char const* ids[3] = {"111", "112", "113"};
+    ConstraintVector regions;
+    regions.push_back(makeConstraint("qserv_areaspec_box", 4, box));
+    regions.push_back(makeConstraint("qserv_areaspec_circle", 3, circle));
+    regions.push_back(makeConstraint("qserv_areaspec_circle", 3, nearCircle));
+    regions.push_back(makeConstraint("sIndex", 3, ids));
+
+    std::vector<ChunkSpecVector> covers = im.getRegionCovers(regions);
+    BOOST_REQUIRE_EQUAL(covers.size(), 4U);
+    BOOST_CHECK(!covers[0].empty());
+    BOOST_CHECK(!covers[1].empty());
+    // Both circles widen to the same region and share its cover.
+    BOOST_CHECK(covers[1] == covers[2]);
+    BOOST_CHECK(covers[3].empty());
+
+    ChunkSpecVector csv = im.getChunks(ConstraintVector(1, regions[1]));
+    BOOST_CHECK(csv == covers[1]);
+}
+
 #if 0 // TODO
 BOOST_AUTO_TEST_CASE(IndLookupArea) {
     // Lookup area using IndexMap interface
@@ -95,4 +95,37 @@ BOOST_AUTO_TEST_CASE(Avg) {
     BOOST_CHECK_EQUAL(expPar, parallel);
 }
 
+BOOST_AUTO_TEST_CASE(SharedParallelColumn) {
+    // SUM(bMagF2) is needed by both aggregates, but must be computed only once.
+    std::string stmt = "select sum(bMagF2), avg(bMagF2) from LSST.Object where bMagF > 20.0;";
+    std::string expPar = "SELECT sum(bMagF2) AS QS1_SUM,COUNT(bMagF2) AS QS2_COUNT FROM LSST.Object_100 AS QST_1_ WHERE bMagF>20.0";
+    std::string expMerge = "SELECT SUM(QS1_SUM),(SUM(QS1_SUM)/SUM(QS2_COUNT))";
+
+    std::shared_ptr<QuerySession> qs = queryAnaHelper.buildQuerySession(qsTest, stmt, SelectParser::ANTLR4);
+    std::shared_ptr<QueryContext> context = qs->dbgGetContext();
+
+    BOOST_CHECK(context);
+    BOOST_REQUIRE(context->needsMerge);
+    BOOST_REQUIRE(context->aggFold);
+    BOOST_CHECK_EQUAL(context->aggFold->size(), 2u);
+
+    std::string parallel = queryAnaHelper.buildFirstParallelQuery();
+    BOOST_CHECK_EQUAL(expPar, parallel);
+    BOOST_CHECK_EQUAL(expMerge, qs->getMergeStmt()->getQueryTemplate().sqlFragment());
+}
+
+BOOST_AUTO_TEST_CASE(Sampled) {
+    // COUNT and SUM of a sample of one chunk in 100 are scaled, MAX is not.
+    std::string stmt = "select count(*), sum(bMagF2), max(bMagF) from LSST.Object;";
+    std::string expMerge = "SELECT (SUM(QS1_COUNT)*100),(SUM(QS2_SUM)*100),MAX(QS3_MAX)";
+
+    std::shared_ptr<QuerySession> qs = queryAnaHelper.buildQuerySession(qsTest, stmt, SelectParser::ANTLR4, 100);
+    std::shared_ptr<QueryContext> context = qs->dbgGetContext();
+
+    BOOST_CHECK(context);
+    BOOST_REQUIRE(context->needsMerge);
+    BOOST_CHECK_EQUAL(context->sampleEvery, 100);
+    BOOST_CHECK_EQUAL(expMerge, qs->getMergeStmt()->getQueryTemplate().sqlFragment());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
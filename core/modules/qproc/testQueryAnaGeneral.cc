@@ -39,6 +39,7 @@
 #include <map>
 #include <sstream>
 #include <string>
+#include <vector>
 
 // Third-party headers
 #include "boost/algorithm/string.hpp"
@@ -133,6 +134,8 @@ BOOST_AUTO_TEST_CASE(Limit) {
     }
 
     BOOST_CHECK_EQUAL(ss.getLimit(), 2);
+    // Any two rows will do, so the czar may stop after merging two.
+    BOOST_CHECK_EQUAL(context->rowLimit, 2);
 }
 
 BOOST_AUTO_TEST_CASE(OrderBy) {
@@ -628,7 +631,9 @@ BOOST_AUTO_TEST_CASE(Petasky1) {
     // An example slow query from French Petasky colleagues
     std::string stmt = "SELECT objectId as id, COUNT(sourceId) AS c"
         " FROM Source GROUP BY objectId HAVING  c > 1000 LIMIT 10;";
-    queryAnaHelper.buildQuerySession(qsTest, stmt, SelectParser::ANTLR4);
+    std::shared_ptr<QuerySession> qs = queryAnaHelper.buildQuerySession(qsTest, stmt, SelectParser::ANTLR4);
+    // Rows from chunks are partial groups, all of them must be merged.
+    BOOST_CHECK_EQUAL(qs->dbgGetContext()->rowLimit, 0);
 }
 
 BOOST_AUTO_TEST_CASE(Expression) {
@@ -711,6 +716,25 @@ BOOST_AUTO_TEST_CASE(FuncExprPred) {
     BOOST_CHECK_EQUAL(queries[0], expected);
 }
 
+BOOST_AUTO_TEST_CASE(StageObserver) {
+    std::string stmt = "SELECT count(*) FROM Object WHERE someField > 5.0;";
+    auto qs = std::make_shared<QuerySession>(qsTest);
+    std::vector<std::string> stages;
+    qs->setStageObserver([&stages](std::string const& stage) { stages.push_back(stage); });
+    qs->analyzeQuery(stmt, qs->parseQuery(stmt, SelectParser::ANTLR4));
+    BOOST_REQUIRE_EQUAL(qs->getError(), "");
+    qs->addChunk(ChunkSpec::makeFake(100, false));
+    qs->finalize();
+    // prepare, then each of the plugins in the logical, concrete, physical and final stages.
+    BOOST_REQUIRE_EQUAL(stages.size() % 3, 2U);
+    size_t const plugins = (stages.size() - 2) / 3;
+    BOOST_CHECK_EQUAL(stages.front(), "prepare");
+    BOOST_CHECK_EQUAL(stages[1], "logical DuplSelectExpr");
+    BOOST_CHECK_EQUAL(stages[plugins + 1], "concrete");
+    BOOST_CHECK_EQUAL(stages[plugins + 3], "physical Where");
+    BOOST_CHECK_EQUAL(stages.back(), "final ScanTable");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 ////////////////////////////////////////////////////////////////////////
 
@@ -79,9 +79,11 @@ BOOST_AUTO_TEST_CASE(OrderBy) {
     std::string stmt = "SELECT objectId, taiMidPoint "
         "FROM Source "
         "ORDER BY objectId ASC";
-    std::string expectedParallel = "SELECT objectId,taiMidPoint FROM LSST.Source_100 AS QST_1_";
+    // Chunk queries sort their rows, which the czar merges in order.
+    std::string expectedParallel = "SELECT objectId,taiMidPoint FROM LSST.Source_100 AS QST_1_ "
+                                   "ORDER BY objectId ASC";
     std::string expectedMerge = "";
-    std::string expectedProxyOrderBy = "ORDER BY objectId ASC";
+    std::string expectedProxyOrderBy = "";
     check(qsTest, queryAnaHelper, stmt, expectedParallel, expectedMerge, expectedProxyOrderBy);
 }
 
@@ -97,9 +99,10 @@ BOOST_AUTO_TEST_CASE(OrderByTwoField) {
     std::string stmt = "SELECT objectId, taiMidPoint "
         "FROM Source "
         "ORDER BY objectId, taiMidPoint ASC";
-    std::string expectedParallel = "SELECT objectId,taiMidPoint FROM LSST.Source_100 AS QST_1_";
+    std::string expectedParallel = "SELECT objectId,taiMidPoint FROM LSST.Source_100 AS QST_1_ "
+                                   "ORDER BY objectId, taiMidPoint ASC";
     std::string expectedMerge = "";
-    std::string expectedProxyOrderBy = "ORDER BY objectId, taiMidPoint ASC";
+    std::string expectedProxyOrderBy = "";
     check(qsTest, queryAnaHelper, stmt, expectedParallel, expectedMerge, expectedProxyOrderBy);
 }
 
@@ -107,9 +110,10 @@ BOOST_AUTO_TEST_CASE(OrderByThreeField) {
     std::string stmt = "SELECT * "
         "FROM Source "
         "ORDER BY objectId, taiMidPoint, xFlux DESC";
-    std::string expectedParallel = "SELECT * FROM LSST.Source_100 AS QST_1_";
+    std::string expectedParallel = "SELECT * FROM LSST.Source_100 AS QST_1_ "
+                                   "ORDER BY objectId, taiMidPoint, xFlux DESC";
     std::string expectedMerge = "";
-    std::string expectedProxyOrderBy = "ORDER BY objectId, taiMidPoint, xFlux DESC";
+    std::string expectedProxyOrderBy = "";
     check(qsTest, queryAnaHelper, stmt, expectedParallel, expectedMerge, expectedProxyOrderBy);
 }
 
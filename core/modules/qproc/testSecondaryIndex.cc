@@ -0,0 +1,146 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+  * @file
+  *
+  * @brief Test secondary index lookups in index files.
+  */
+
+// System headers
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "mysql/MySqlConfig.h"
+#include "qproc/ChunkSpec.h"
+#include "qproc/SecondaryIndex.h"
+#include "query/Constraint.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE SecondaryIndex
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::mysql::MySqlConfig;
+using lsst::qserv::qproc::ChunkSpecVector;
+using lsst::qserv::qproc::SecondaryIndex;
+using lsst::qserv::query::Constraint;
+using lsst::qserv::query::ConstraintVector;
+
+namespace {
+
+/// Write the index file of LSST.Object in 'dir': keys 10, 20, ... 100,
+/// key 10*i in chunk 100 + i/4 and subchunk i.
+void writeIndexFile(std::string const& dir) {
+    std::vector<int64_t> keys;
+    std::vector<int32_t> chunks;
+    std::vector<int32_t> subChunks;
+    for (int i = 1; i <= 10; ++i) {
+        keys.push_back(10 * i);
+        chunks.push_back(100 + i / 4);
+        subChunks.push_back(i);
+    }
+    uint64_t n = keys.size();
+    std::ofstream out(dir + "/LSST__Object.idx", std::ios::binary);
+    out.write("QSIDX001", 8);
+    out.write(reinterpret_cast<char const*>(&n), sizeof(n));
+    out.write(reinterpret_cast<char const*>(keys.data()), n * sizeof(int64_t));
+    out.write(reinterpret_cast<char const*>(chunks.data()), n * sizeof(int32_t));
+    out.write(reinterpret_cast<char const*>(subChunks.data()), n * sizeof(int32_t));
+}
+
+ConstraintVector makeConstraint(std::string const& name, std::vector<std::string> const& keys) {
+    Constraint constraint;
+    constraint.name = name;
+    constraint.params = {"LSST", "Object", "objectId"};
+    constraint.params.insert(constraint.params.end(), keys.begin(), keys.end());
+    return ConstraintVector(1, constraint);
+}
+
+/// @return "chunk:subchunk,subchunk ..." for each chunk of 'specs'.
+std::string format(ChunkSpecVector const& specs) {
+    std::string str;
+    for (auto const& spec : specs) {
+        str += (str.empty() ? "" : " ") + std::to_string(spec.chunkId) + ":";
+        for (size_t j = 0; j < spec.subChunks.size(); ++j) {
+            str += (j == 0 ? "" : ",") + std::to_string(spec.subChunks[j]);
+        }
+    }
+    return str;
+}
+
+} // anonymous namespace
+
+struct Fixture {
+    Fixture() {
+        char dirTemplate[] = "/tmp/testSecondaryIndex.XXXXXX";
+        dir = ::mkdtemp(dirTemplate);
+        writeIndexFile(dir);
+        index.reset(new SecondaryIndex(MySqlConfig(), 0, dir));
+    }
+
+    ~Fixture() {
+        std::remove((dir + "/LSST__Object.idx").c_str());
+        std::remove(dir.c_str());
+    }
+
+    std::string dir;
+    std::unique_ptr<SecondaryIndex> index;
+};
+
+BOOST_FIXTURE_TEST_SUITE(Suite, Fixture)
+
+BOOST_AUTO_TEST_CASE(FileIn) {
+    ChunkSpecVector specs = index->lookup(makeConstraint("sIndex", {"10", "45", "80", "100", "5"}));
+    BOOST_CHECK_EQUAL(format(specs), "100:1 102:8,10");
+}
+
+BOOST_AUTO_TEST_CASE(FileNotIn) {
+    ChunkSpecVector specs = index->lookup(makeConstraint("sIndexNotIn", {"30", "10", "40", "90", "100"}));
+    BOOST_CHECK_EQUAL(format(specs), "100:2 101:5,6,7 102:8");
+}
+
+BOOST_AUTO_TEST_CASE(FileBetween) {
+    ChunkSpecVector specs = index->lookup(makeConstraint("sIndexBetween", {"25", "50"}));
+    BOOST_CHECK_EQUAL(format(specs), "100:3 101:4,5");
+    specs = index->lookup(makeConstraint("sIndexBetween", {"50", "25"}));
+    BOOST_CHECK(specs.empty());
+}
+
+BOOST_AUTO_TEST_CASE(FileNotBetween) {
+    ChunkSpecVector specs = index->lookup(makeConstraint("sIndexNotBetween", {"20", "90"}));
+    BOOST_CHECK_EQUAL(format(specs), "100:1 102:10");
+}
+
+BOOST_AUTO_TEST_CASE(NoIndexConstraint) {
+    BOOST_CHECK_THROW(index->lookup(makeConstraint("sIndexUnknown", {"10"})),
+                      SecondaryIndex::NoIndexConstraint);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
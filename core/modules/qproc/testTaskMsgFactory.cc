@@ -0,0 +1,110 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+ /**
+  * @file
+  *
+  * @brief Test building TaskMsg payloads for job attempts.
+  */
+
+// System headers
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "proto/worker.pb.h"
+#include "qproc/ChunkQuerySpec.h"
+#include "qproc/TaskMsgFactory.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE TaskMsgFactory
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+using namespace lsst::qserv;
+
+namespace {
+
+qproc::ChunkQuerySpec::Ptr makeSpec(int chunkId) {
+    auto spec = std::make_shared<qproc::ChunkQuerySpec>("LSST", chunkId, proto::ScanInfo(), false);
+    spec->subChunkTables.insert(DbTable("LSST", "Object"));
+    spec->subChunkIds = {1, 2};
+    spec->queries = {"SELECT * FROM LSST.Object_" + std::to_string(chunkId)};
+    spec->nextFragment = std::make_shared<qproc::ChunkQuerySpec>();
+    spec->nextFragment->subChunkIds = {3};
+    spec->nextFragment->queries = spec->queries;
+    return spec;
+}
+
+proto::TaskMsg parse(qproc::TaskMsgFactory& factory, qproc::ChunkQuerySpec const& spec,
+                     int jobId, int attemptCount) {
+    std::ostringstream os;
+    factory.serializeMsg(spec, "r_" + std::to_string(jobId), 7, jobId, attemptCount, os);
+    proto::TaskMsg msg;
+    BOOST_REQUIRE(msg.ParseFromString(os.str()));
+    return msg;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(Attempts) {
+    qproc::TaskMsgFactory factory(1);
+    auto spec = makeSpec(42);
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        proto::TaskMsg msg = parse(factory, *spec, 5, attempt);
+        BOOST_CHECK_EQUAL(msg.jobid(), 5);
+        BOOST_CHECK_EQUAL(msg.attemptcount(), attempt);
+        BOOST_CHECK_EQUAL(msg.chunkid(), 42);
+        BOOST_CHECK_EQUAL(msg.queryid(), 7U);
+        // Retries reuse the job fields, they must not be repeated.
+        BOOST_REQUIRE_EQUAL(msg.fragment_size(), 2);
+        BOOST_CHECK_EQUAL(msg.fragment(0).resulttable(), "r_5");
+        BOOST_CHECK_EQUAL(msg.fragment(0).subchunks().id_size(), 2);
+        BOOST_CHECK_EQUAL(msg.fragment(1).subchunks().id(0), 3);
+        BOOST_CHECK_EQUAL(msg.fragment(1).query(0), "SELECT * FROM LSST.Object_42");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(RetryCache) {
+    qproc::TaskMsgFactory factory(1);
+    std::vector<qproc::ChunkQuerySpec::Ptr> specs;
+    int const jobs = qproc::TaskMsgFactory::RETRY_CACHE_SIZE + 3;
+    for (int j = 0; j < jobs; ++j) {
+        specs.push_back(makeSpec(100 + j));
+        parse(factory, *specs.back(), j, 1);
+    }
+    // Every job gets its own fields, whether or not they are still cached.
+    for (int j = jobs - 1; j >= 0; --j) {
+        proto::TaskMsg msg = parse(factory, *specs[j], j, 2);
+        BOOST_CHECK_EQUAL(msg.jobid(), j);
+        BOOST_CHECK_EQUAL(msg.attemptcount(), 2);
+        BOOST_CHECK_EQUAL(msg.chunkid(), 100 + j);
+        BOOST_CHECK_EQUAL(msg.fragment_size(), 2);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -23,7 +23,8 @@
 /**
   * @file
   *
-  * @brief PassAggOp, CountAggOp, AccumulateOp, AvgAggOp implementations
+  * @brief PassAggOp, CountAggOp, AccumulateOp, AvgAggOp,
+  * ApproxCountDistinctOp implementations
   *
   * @author Daniel L. Wang, SLAC
   */
@@ -61,6 +62,7 @@ public:
         AggRecord::Ptr arp = std::make_shared<AggRecord>();
         arp->orig = orig.clone();
         arp->parallel.push_back(ValueExpr::newSimple(orig.clone()));
+        arp->parallelFold.push_back(AggRecord::Fold::KEY);
         arp->merge = orig.clone();
         // Alias handling left to caller.
         return arp;
@@ -84,6 +86,7 @@ public:
         parallelExpr = ValueExpr::newSimple(orig.clone());
         parallelExpr->setAlias(interName);
         arp->parallel.push_back(parallelExpr);
+        arp->parallelFold.push_back(AggRecord::Fold::SUM);
 
         fe = FuncExpr::newArg1("SUM", interName);
         vf = ValueFactor::newFuncFactor(fe);
@@ -101,9 +104,9 @@ public:
     typedef enum {MIN, MAX, SUM} Type;
     explicit AccumulateOp(AggOp::Mgr& mgr, Type t) : AggOp(mgr) {
         switch(t) {
-        case MIN: accName = "MIN"; break;
-        case MAX: accName = "MAX"; break;
-        case SUM: accName = "SUM"; break;
+        case MIN: accName = "MIN"; fold = AggRecord::Fold::MIN; break;
+        case MAX: accName = "MAX"; fold = AggRecord::Fold::MAX; break;
+        case SUM: accName = "SUM"; fold = AggRecord::Fold::SUM; break;
         }
     }
 
@@ -118,6 +121,7 @@ public:
         parallelExpr = ValueExpr::newSimple(orig.clone());
         parallelExpr->setAlias(interName);
         arp->parallel.push_back(parallelExpr);
+        arp->parallelFold.push_back(fold);
 
         fe = FuncExpr::newArg1(accName, interName);
         vf = ValueFactor::newFuncFactor(fe);
@@ -126,6 +130,7 @@ public:
         return arp;
     }
     std::string accName;
+    AggRecord::Fold fold;
 };
 
 
@@ -147,12 +152,14 @@ public:
         ve = ValueExpr::newSimple(ValueFactor::newFuncFactor(fe));
         ve->setAlias(cAlias);
         arp->parallel.push_back(ve);
+        arp->parallelFold.push_back(AggRecord::Fold::SUM);
 
         std::string sAlias = _mgr.getAggName("SUM");
         fe = FuncExpr::newLike(*origVf->getFuncExpr(), "SUM");
         ve = ValueExpr::newSimple(ValueFactor::newFuncFactor(fe));
         ve->setAlias(sAlias);
         arp->parallel.push_back(ve);
+        arp->parallelFold.push_back(AggRecord::Fold::SUM);
 
         std::shared_ptr<FuncExpr> feSum;
         std::shared_ptr<FuncExpr> feCount;
@@ -175,6 +182,35 @@ public:
 };
 
 
+/// ApproxCountDistinctOp implements APPROX_COUNT_DISTINCT (qserv_hll followed
+/// by qserv_hll_count). The chunk queries return a HyperLogLog sketch of
+/// each group, and merging the sketches estimates the distinct count over
+/// all chunks.
+class ApproxCountDistinctOp : public AggOp {
+public:
+    explicit ApproxCountDistinctOp(AggOp::Mgr& mgr) : AggOp(mgr) {}
+
+    virtual AggRecord::Ptr operator()(ValueFactor const& orig) {
+        AggRecord::Ptr arp = std::make_shared<AggRecord>();
+        std::string interName = _mgr.getAggName("HLL");
+        arp->orig = orig.clone();
+        std::shared_ptr<FuncExpr> fe;
+        std::shared_ptr<ValueExpr> parallelExpr;
+
+        fe = FuncExpr::newLike(*orig.getFuncExpr(), "qserv_hll");
+        parallelExpr = ValueExpr::newSimple(ValueFactor::newFuncFactor(fe));
+        parallelExpr->setAlias(interName);
+        arp->parallel.push_back(parallelExpr);
+        arp->parallelFold.push_back(AggRecord::Fold::HLL);
+
+        fe = FuncExpr::newArg1("qserv_hll_count", interName);
+        // orig alias handled by caller.
+        arp->merge = ValueFactor::newFuncFactor(fe);
+        return arp;
+    }
+};
+
+
 ////////////////////////////////////////////////////////////////////////
 // class AggOp::Mgr
 ////////////////////////////////////////////////////////////////////////
@@ -185,6 +221,7 @@ AggOp::Mgr::Mgr() : _hasAggregate(false) {
     _map["MAX"].reset(new AccumulateOp(*this, AccumulateOp::MAX));
     _map["MIN"].reset(new AccumulateOp(*this, AccumulateOp::MIN));
     _map["SUM"].reset(new AccumulateOp(*this, AccumulateOp::SUM));
+    _map["APPROX_COUNT_DISTINCT"].reset(new ApproxCountDistinctOp(*this));
     _seq = 0; // Note: accessor return ++_seq
 }
 
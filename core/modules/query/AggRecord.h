@@ -31,7 +31,11 @@
 #define LSST_QSERV_QUERY_AGGRECORD_H
 
 
+// System headers
+#include <vector>
+
 // Local headers
+#include "proto/InMemoryAggregator.h"
 #include "query/ValueExpr.h"
 #include "query/ValueFactor.h"
 
@@ -49,12 +53,19 @@ namespace query {
 struct AggRecord {
 public:
     typedef std::shared_ptr<AggRecord> Ptr;
+    /// How the per-chunk values of a parallel expression are combined with
+    /// each other, see proto::InMemoryAggregator::Fold.
+    using Fold = proto::InMemoryAggregator::Fold;
+    typedef proto::InMemoryAggregator::FoldVector FoldVector;
+
     /// Original ValueFactor representing the call (e.g., COUNT(ra_PS))
     ValueFactorPtr orig;
     /// List of expressions to pass for parallel execution.
     /// Some aggregations need more than one aggregation to be computed (per
     /// chunk) in order to compute the final aggregation value (e.g., AVG)
     ValueExprPtrVector parallel;
+    /// Fold for each element of parallel.
+    FoldVector parallelFold;
     /// ValueFactor representing merge step. Not a list, because the original
     /// wasn't a list and we want the final result to correspond.
     ValueFactorPtr merge;
@@ -53,6 +53,7 @@ struct deepCopy {
 
 template <typename List, class Copy>
 inline void copyTerms(List& dest, List const& src) {
+    dest.reserve(dest.size() + src.size());
     std::transform(src.begin(), src.end(), std::back_inserter(dest), Copy());
 }
 
@@ -27,6 +27,8 @@
 
 // System headers
 #include <algorithm>
+#include <memory>
+#include <vector>
 
 // Qserv headers
 #include "query/ColumnRef.h"
@@ -69,10 +71,19 @@ void InPredicate::renderTo(QueryTemplate& qt) const {
     r.applyToQT(value);
     if (hasNot) qt.append("NOT");
     qt.append("IN");
-    ValueExpr::render rComma(qt, true);
     qt.append("(");
-    for (auto& cand : cands) {
-        rComma.applyToQT(cand);
+    if (splitByChunk && !cands.empty()) {
+        std::vector<QueryTemplate> values(cands.size());
+        for (size_t j = 0; j < cands.size(); ++j) {
+            ValueExpr::render rValue(values[j], false);
+            rValue.applyToQT(cands[j]);
+        }
+        qt.append(std::make_shared<QueryTemplate::ValueListEntry>(values));
+    } else {
+        ValueExpr::render rComma(qt, true);
+        for (auto& cand : cands) {
+            rComma.applyToQT(cand);
+        }
     }
     qt.append(")");
 }
@@ -87,10 +98,12 @@ void InPredicate::findValueExprs(std::vector<std::shared_ptr<ValueExpr>>& vector
 BoolFactorTerm::Ptr InPredicate::clone() const {
     InPredicate::Ptr p  = std::make_shared<InPredicate>();
     if (value) p->value = value->clone();
+    p->cands.reserve(cands.size());
     std::transform(cands.begin(), cands.end(),
                    std::back_inserter(p->cands),
                    valueExprCopy());
     p->hasNot = hasNot;
+    p->splitByChunk = splitByChunk;
     return BoolFactorTerm::Ptr(p);
 }
 
@@ -73,6 +73,10 @@ public:
     std::shared_ptr<ValueExpr> value;
     std::vector<std::shared_ptr<ValueExpr>> cands;
     bool hasNot;
+    /// The candidates are director keys located by the secondary index, so
+    /// each chunk query only needs those found in its chunk. They are then
+    /// rendered as a single QueryTemplate::ValueListEntry.
+    bool splitByChunk = false;
 
 protected:
     void dbgPrint(std::ostream& os) const override;
@@ -87,6 +87,12 @@ public:
 ////////////////////////////////////////////////////////////////////////
 // OrderByTerm
 ////////////////////////////////////////////////////////////////////////
+OrderByTerm::Order
+OrderByTerm::getOrder() const {
+    return _order;
+}
+
+
 void
 OrderByTerm::renderTo(QueryTemplate& qt) const {
     ValueExpr::render r(qt, true);
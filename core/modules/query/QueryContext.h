@@ -33,7 +33,9 @@
 
 // System headers
 #include <memory>
+#include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 // Local headers
@@ -41,6 +43,7 @@
 #include "mysql/MySqlConfig.h"
 #include "proto/ScanTableInfo.h"
 #include "qana/QueryMapping.h"
+#include "query/AggRecord.h"
 #include "query/DbTablePair.h"
 #include "query/FromList.h"
 #include "query/TableAlias.h"
@@ -105,6 +108,35 @@ public:
     int chunkCount{0}; //< -1: all, 0: none, N: #chunks
 
     bool needsMerge{false}; ///< Does this query require a merge/post-processing step?
+    /// Set when the WHERE clause can not be true for any row, so that no
+    /// chunk needs to be queried.
+    bool unsatisfiable{false};
+    /// Fold for each parallel select list column, set when partial results
+    /// can be combined on the czar before the merge step.
+    std::shared_ptr<AggRecord::FoldVector> aggFold;
+    /// Number of merged rows that complete the query, set when every row a
+    /// chunk returns is a final result row. 0 if there is no such limit.
+    int rowLimit{0};
+    /// Number of rows an ORDER BY ... LIMIT query returns, set with topKOrder
+    /// when every row a chunk returns is a final result row. 0 otherwise.
+    int topK{0};
+    /// Result column name and true if descending, for each ORDER BY term.
+    std::vector<std::pair<std::string, bool>> topKOrder;
+    /// Result column name and true if descending, for each ORDER BY term of
+    /// a query without LIMIT whose chunk queries sort their rows, so that
+    /// the czar merges them in order. Empty if mysql-proxy sorts the result.
+    std::vector<std::pair<std::string, bool>> sortedOrder;
+    /// The query runs on about one chunk in sampleEvery when more than 1,
+    /// and its COUNT and SUM aggregates are scaled by it.
+    int sampleEvery{0};
+    /// Chunks whose zone map shows that no row satisfies the WHERE clause,
+    /// left out of the query. See qana::ZoneMapPlugin.
+    std::set<int> prunedChunks;
+    /// Column name and SQL value of each select list item of an aggregate
+    /// query over one chunked table, when the per-chunk statistics of its
+    /// zone map give the result. Empty if the query must run on the chunks.
+    /// See qana::AggregatePlugin.
+    std::vector<std::pair<std::string, std::string>> statsAnswer;
 
     css::StripingParams getDbStriping() {
         return css->getDbStriping(dominantDb); }
@@ -36,6 +36,8 @@
 #include "query/QueryTemplate.h"
 
 // System headers
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <sstream>
 
@@ -61,6 +63,38 @@ std::string QueryTemplate::TableEntry::getValue() const {
 }
 
 
+QueryTemplate::ValueListEntry::ValueListEntry(std::vector<QueryTemplate> const& values) {
+    auto entries = std::make_shared<std::vector<EntryPtrVector>>();
+    entries->reserve(values.size());
+    for (auto const& value : values) {
+        entries->push_back(value._entries);
+    }
+    _values = entries;
+}
+
+
+std::string QueryTemplate::ValueListEntry::getValue() const {
+    QueryTemplate qt;
+    for (auto const& value : *_values) {
+        if (!qt._entries.empty()) { qt.append(","); }
+        qt._entries.insert(qt._entries.end(), value.begin(), value.end());
+    }
+    return qt.sqlFragment();
+}
+
+
+std::string QueryTemplate::ValueListEntry::getValue(std::vector<int32_t> const& positions) const {
+    QueryTemplate qt;
+    for (int32_t pos : positions) {
+        if (pos < 0 || static_cast<size_t>(pos) >= _values->size()) { continue; }
+        if (!qt._entries.empty()) { qt.append(","); }
+        auto const& value = (*_values)[pos];
+        qt._entries.insert(qt._entries.end(), value.begin(), value.end());
+    }
+    return qt.sqlFragment();
+}
+
+
 class ColumnEntry : public QueryTemplate::Entry {
 public:
     ColumnEntry(ColumnRef const& cr)
@@ -129,17 +163,20 @@ std::ostream& operator<<(std::ostream& os, QueryTemplate const& queryTemplate) {
 void QueryTemplate::append(std::string const& s) {
     std::shared_ptr<Entry> e = std::make_shared<StringEntry>(s);
     _entries.push_back(e);
+    std::atomic_store(&_compiled, Compiled::Ptr());
 }
 
 
 void QueryTemplate::append(ColumnRef const& cr) {
     std::shared_ptr<Entry> e = std::make_shared<ColumnEntry>(cr);
     _entries.push_back(e);
+    std::atomic_store(&_compiled, Compiled::Ptr());
 }
 
 
 void QueryTemplate::append(QueryTemplate::Entry::Ptr const& e) {
     _entries.push_back(e);
+    std::atomic_store(&_compiled, Compiled::Ptr());
 }
 
 
@@ -152,9 +189,103 @@ std::string QueryTemplate::generate(EntryMapping const& em) const {
 }
 
 
+QueryTemplate::Compiled::Ptr QueryTemplate::compile(std::vector<std::string> const& patterns) const {
+    Compiled::Ptr compiled = std::atomic_load(&_compiled);
+    if (compiled == nullptr || compiled->getPatterns() != patterns) {
+        // Threads racing here compile the same thing, keep either.
+        compiled = std::make_shared<Compiled const>(_entries, patterns);
+        std::atomic_store(&_compiled, compiled);
+    }
+    return compiled;
+}
+
+
 void
 QueryTemplate::clear() {
     _entries.clear();
+    std::atomic_store(&_compiled, Compiled::Ptr());
+}
+
+
+////////////////////////////////////////////////////////////////////////
+// QueryTemplate::Compiled
+////////////////////////////////////////////////////////////////////////
+QueryTemplate::Compiled::Compiled(EntryPtrVector const& entries, std::vector<std::string> const& patterns)
+    : _patterns(patterns) {
+    // Separators are chosen as in sqlFragment(), on the entries with a
+    // digit standing in for every value.
+    std::string lastSample;
+    for (auto const& entry : entries) {
+        std::string const entryStr = entry->getValue();
+        if (entryStr.empty()) {
+            // sqlFragment() gives up on an empty entry.
+            _pieces.clear();
+            _textSize = 0;
+            _slotCount = 0;
+            return;
+        }
+        std::vector<Piece> entryPieces;
+        std::string sample;
+        size_t pos = 0;
+        while (true) {
+            size_t found = std::string::npos;
+            int slot = -1;
+            for (size_t j = 0; j < _patterns.size(); ++j) {
+                if (_patterns[j].empty()) continue;
+                size_t p = entryStr.find(_patterns[j], pos);
+                if (p < found) {
+                    found = p;
+                    slot = j;
+                }
+            }
+            if (slot < 0) break;
+            entryPieces.push_back(Piece{entryStr.substr(pos, found - pos), -1});
+            entryPieces.push_back(Piece{std::string(), slot});
+            sample += entryPieces[entryPieces.size() - 2].text + "0";
+            pos = found + _patterns[slot].size();
+        }
+        entryPieces.push_back(Piece{entryStr.substr(pos), -1});
+        sample += entryPieces.back().text;
+
+        if (!lastSample.empty()
+          && lsst::qserv::sql::sqlShouldSeparate(lastSample, *lastSample.rbegin(), sample.at(0))) {
+            _addText(" ");
+        }
+        for (auto& piece : entryPieces) {
+            if (piece.slot < 0) {
+                _addText(piece.text);
+            } else {
+                _pieces.push_back(std::move(piece));
+                ++_slotCount;
+            }
+        }
+        lastSample = std::move(sample);
+    }
+}
+
+
+void QueryTemplate::Compiled::_addText(std::string const& text) {
+    if (text.empty()) return;
+    if (_pieces.empty() || _pieces.back().slot >= 0) {
+        _pieces.push_back(Piece{text, -1});
+    } else {
+        _pieces.back().text += text;
+    }
+    _textSize += text.size();
+}
+
+
+std::string QueryTemplate::Compiled::generate(std::vector<std::string> const& values) const {
+    size_t valueSize = 0;
+    for (auto const& value : values) {
+        valueSize = std::max(valueSize, value.size());
+    }
+    std::string result;
+    result.reserve(_textSize + _slotCount * valueSize);
+    for (auto const& piece : _pieces) {
+        result += (piece.slot < 0) ? piece.text : values.at(piece.slot);
+    }
+    return result;
 }
 
 
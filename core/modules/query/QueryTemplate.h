@@ -32,6 +32,7 @@
 
 
 // System headers
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -110,6 +111,21 @@ public:
         std::string db;
         std::string table;
     };
+    /// The comma separated values of a list, such as the candidates of an
+    /// IN predicate, of which a chunk query may keep only some (see
+    /// qana::QueryMapping). The values are shared by copies of the entry.
+    class ValueListEntry : public Entry {
+    public:
+        explicit ValueListEntry(std::vector<QueryTemplate> const& values);
+        /// @return all the values.
+        virtual std::string getValue() const;
+        /// @return the values at 'positions', in increasing order.
+        std::string getValue(std::vector<int32_t> const& positions) const;
+        virtual bool isDynamic() const { return true; }
+        size_t size() const { return _values->size(); }
+    private:
+        std::shared_ptr<std::vector<EntryPtrVector> const> _values;
+    };
     /// An abstract mapping from entry to entry
     class EntryMapping {
     public:
@@ -117,6 +133,37 @@ public:
         virtual Entry::Ptr mapEntry(Entry const& e) const = 0;
     };
 
+    /// A QueryTemplate flattened into literal text and slots for the values
+    /// of a set of patterns, e.g. CHUNK_TAG, so that generating a query
+    /// appends strings into one buffer instead of rendering every entry.
+    class Compiled {
+    public:
+        using Ptr = std::shared_ptr<Compiled const>;
+
+        /// @param patterns - substrings of the entries replaced in generate().
+        Compiled(EntryPtrVector const& entries, std::vector<std::string> const& patterns);
+
+        /// @param values - the value of each pattern. The separators between
+        ///        entries were chosen for values starting and ending with a
+        ///        digit, such as chunk and subchunk numbers.
+        /// @return the same string as sqlFragment() after substitution.
+        std::string generate(std::vector<std::string> const& values) const;
+
+        std::vector<std::string> const& getPatterns() const { return _patterns; }
+
+    private:
+        struct Piece {
+            std::string text;
+            int slot; ///< index of the value replacing this piece, -1 for text
+        };
+        void _addText(std::string const& text);
+
+        std::vector<std::string> const _patterns;
+        std::vector<Piece> _pieces;
+        size_t _textSize{0}; ///< Length of all the text pieces
+        int _slotCount{0};
+    };
+
     QueryTemplate() {}
 
     void append(std::string const& s);
@@ -143,6 +190,11 @@ public:
     friend std::ostream& operator<<(std::ostream& os, QueryTemplate const& queryTemplate);
 
     std::string generate(EntryMapping const& em) const;
+
+    /// @return this template compiled for 'patterns', kept until the
+    ///         template changes. Safe to call from several threads.
+    Compiled::Ptr compile(std::vector<std::string> const& patterns) const;
+
     void clear();
 
     template <class T>
@@ -154,6 +206,7 @@ public:
 
 private:
     EntryPtrVector _entries;
+    mutable Compiled::Ptr _compiled; ///< Last compile() result, always accessed atomically
 };
 
 
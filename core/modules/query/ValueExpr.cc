@@ -268,13 +268,14 @@ bool ValueExpr::isFunction() const {
 
 
 ValueExprPtr ValueExpr::clone() const {
-    // First, make a shallow copy
-    ValueExprPtr expr = std::make_shared<ValueExpr>(*this);
-    FactorOpVector::iterator ti = expr->_factorOps.begin();
-    for(FactorOpVector::const_iterator i=_factorOps.begin();
-        i != _factorOps.end(); ++i, ++ti) {
-        // Deep copy (clone) each factor.
-        ti->factor = i->factor->clone();
+    // Build the copy with cloned factors right away, rather than copying
+    // the factor pointers first: clones of large IN lists would otherwise
+    // pay twice for the reference count updates.
+    ValueExprPtr expr = std::make_shared<ValueExpr>();
+    expr->_alias = _alias;
+    expr->_factorOps.reserve(_factorOps.size());
+    for (auto const& factorOp : _factorOps) {
+        expr->_factorOps.emplace_back(factorOp.factor->clone(), factorOp.op);
     }
     return expr;
 }
@@ -136,8 +136,11 @@ void ValueFactor::findColumnRefs(ColumnRef::Vector& vector) const {
 
 
 ValueFactorPtr ValueFactor::clone() const{
-    ValueFactorPtr expr = std::make_shared<ValueFactor>(*this);
-    // Clone refs.
+    // Copy the values, and clone refs without copying the pointers first.
+    ValueFactorPtr expr = std::make_shared<ValueFactor>();
+    expr->_type = _type;
+    expr->_alias = _alias;
+    expr->_constVal = _constVal;
     if (_columnRef.get()) {
         expr->_columnRef = std::make_shared<ColumnRef>(*_columnRef);
     }
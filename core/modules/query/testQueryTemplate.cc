@@ -0,0 +1,121 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// System headers
+#include <string>
+#include <vector>
+
+// Boost unit test header
+#define BOOST_TEST_MODULE QueryTemplate
+#include "boost/test/included/unit_test.hpp"
+
+// Qserv headers
+#include "global/constants.h"
+#include "query/QueryTemplate.h"
+
+namespace test = boost::test_tools;
+using lsst::qserv::CHUNK_TAG;
+using lsst::qserv::query::QueryTemplate;
+
+namespace {
+
+/// Replaces CHUNK_TAG in every entry, like the czar's chunk mapping.
+class ChunkMapping : public QueryTemplate::EntryMapping {
+public:
+    explicit ChunkMapping(std::string const& chunk) : _chunk(chunk) {}
+    QueryTemplate::Entry::Ptr mapEntry(QueryTemplate::Entry const& e) const override {
+        std::string s = e.getValue();
+        std::string const tag(CHUNK_TAG);
+        for (size_t pos = s.find(tag); pos != std::string::npos; pos = s.find(tag, pos)) {
+            s.replace(pos, tag.size(), _chunk);
+            pos += _chunk.size();
+        }
+        return std::make_shared<QueryTemplate::StringEntry>(s);
+    }
+private:
+    std::string _chunk;
+};
+
+QueryTemplate makeTemplate(std::vector<std::string> const& entries) {
+    QueryTemplate qt;
+    for (auto const& entry : entries) {
+        qt.append(entry);
+    }
+    return qt;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(SameAsMapping) {
+    std::string const tag(CHUNK_TAG);
+    std::vector<std::vector<std::string>> templates = {
+        {"SELECT", "o.objectId", ",", "COUNT(*)", "AS", "n", "FROM", "LSST.Object_" + tag, "AS", "o",
+         "WHERE", "o.ra_PS", "BETWEEN", "1", "AND", "2", "GROUP", "BY", "o.objectId"},
+        {"SELECT", "*", "FROM", "LSST.Object_" + tag, "o", ",", "LSST.Source_" + tag, "s",
+         "WHERE", "o.objectId", "=", "s.objectId", "AND", "name", "LIKE", "'%x_'"},
+        {"SELECT", tag, "AS", "chunk", ",", "a_" + tag + "_" + tag, "FROM", "t_" + tag},
+        {"SELECT", "1"},
+    };
+    std::vector<std::string> const patterns = {tag};
+    for (auto const& entries : templates) {
+        QueryTemplate qt = makeTemplate(entries);
+        for (std::string chunk : {"0", "7", "123456"}) {
+            BOOST_CHECK_EQUAL(qt.compile(patterns)->generate({chunk}), qt.generate(ChunkMapping(chunk)));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(Invalidated) {
+    std::vector<std::string> const patterns = {CHUNK_TAG};
+    QueryTemplate qt = makeTemplate({"SELECT", "a", "FROM", std::string("t_") + CHUNK_TAG});
+    auto compiled = qt.compile(patterns);
+    BOOST_CHECK(qt.compile(patterns) == compiled);
+    qt.append("LIMIT");
+    qt.append("5");
+    BOOST_CHECK_EQUAL(qt.compile(patterns)->generate({"3"}), "SELECT a FROM t_3 LIMIT 5");
+    // An empty entry makes an empty query, as with sqlFragment().
+    qt.append("");
+    BOOST_CHECK_EQUAL(qt.compile(patterns)->generate({"3"}), "");
+}
+
+BOOST_AUTO_TEST_CASE(ValueList) {
+    std::vector<QueryTemplate> values = {
+        makeTemplate({"1"}), makeTemplate({"'a b'"}), makeTemplate({"-", "3"})};
+    auto list = std::make_shared<QueryTemplate::ValueListEntry>(values);
+    QueryTemplate qt = makeTemplate({"SELECT", "*", "FROM", "t", "WHERE", "id", "IN", "("});
+    qt.append(list);
+    qt.append(")");
+
+    // All the values are rendered as if they had been appended one by one.
+    QueryTemplate flat = makeTemplate({"SELECT", "*", "FROM", "t", "WHERE", "id", "IN", "(",
+                                       "1", ",", "'a b'", ",", "-", "3", ")"});
+    BOOST_CHECK_EQUAL(qt.sqlFragment(), flat.sqlFragment());
+    BOOST_CHECK_EQUAL(list->size(), 3u);
+    BOOST_CHECK_EQUAL(list->getValue({0, 2}), "1,-3");
+    BOOST_CHECK_EQUAL(list->getValue({1}), "'a b'");
+    BOOST_CHECK_EQUAL(list->getValue({1, 7}), "'a b'");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
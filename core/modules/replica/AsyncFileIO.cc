@@ -0,0 +1,408 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "replica/AsyncFileIO.h"
+
+// System headers
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+// The io_uring interface of the kernel is used directly, the headers of the
+// kernel the code is built against tell if it's there at all.
+#if defined(__linux__) && defined(__has_include)
+#  if __has_include(<linux/io_uring.h>)
+#    include <linux/io_uring.h>
+#    include <signal.h>
+#    include <sys/mman.h>
+#    include <sys/syscall.h>
+#    include <sys/uio.h>
+#    if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(__NR_io_uring_register)
+#      define QSERV_REPLICA_IO_URING 1
+#    endif
+#  endif
+#endif
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.replica.AsyncFileIO");
+
+/// The alignment of the buffers, which matches the pages of the page cache
+size_t const bufferAlignmentBytes = 4096;
+
+} // namespace
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+#ifdef QSERV_REPLICA_IO_URING
+
+/**
+ * The submission and completion queues of an io_uring instance, shared with
+ * the kernel through memory mapped rings.
+ */
+struct AsyncFileIO::Ring {
+
+    /**
+     * Set up the rings and register the buffers
+     *
+     * @return 'false' if the kernel doesn't have io_uring, or won't set it up
+     */
+    bool setup(std::vector<uint8_t*> const& buffers, size_t bufferSizeBytes) {
+
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        fd = ::syscall(__NR_io_uring_setup, buffers.size(), &params);
+        if (fd < 0) {
+            LOGS(_log, LOG_LVL_DEBUG, "io_uring_setup failed: " << std::strerror(errno));
+            return false;
+        }
+        sqRingBytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingBytes = params.cq_off.cqes  + params.cq_entries * sizeof(io_uring_cqe);
+        bool const singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (singleMmap) {
+            sqRingBytes = cqRingBytes = std::max(sqRingBytes, cqRingBytes);
+        }
+        sqRing = ::mmap(nullptr, sqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        fd, IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED) {
+            sqRing = nullptr;
+            return false;
+        }
+        if (singleMmap) {
+            cqRing = sqRing;
+        } else {
+            cqRing = ::mmap(nullptr, cqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            fd, IORING_OFF_CQ_RING);
+            if (cqRing == MAP_FAILED) {
+                cqRing = nullptr;
+                return false;
+            }
+        }
+        sqesBytes = params.sq_entries * sizeof(io_uring_sqe);
+        void* const sqesPtr = ::mmap(nullptr, sqesBytes, PROT_READ | PROT_WRITE,
+                                     MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if (sqesPtr == MAP_FAILED) return false;
+        sqes = static_cast<io_uring_sqe*>(sqesPtr);
+
+        char* const sq = static_cast<char*>(sqRing);
+        sqTail  = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask  = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        char* const cq = static_cast<char*>(cqRing);
+        cqHead  = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail  = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask  = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes    = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        // Registered buffers spare the kernel mapping them at each operation.
+        // The registration counts against RLIMIT_MEMLOCK, and the operations
+        // fall back to vectored ones on the same buffers if it's refused.
+        iovecs.resize(buffers.size());
+        for (size_t i = 0; i < buffers.size(); ++i) {
+            iovecs[i].iov_base = buffers[i];
+            iovecs[i].iov_len  = bufferSizeBytes;
+        }
+        opIovecs.resize(buffers.size());
+        fixedBuffers = ::syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS,
+                                 iovecs.data(), iovecs.size()) == 0;
+        if (not fixedBuffers) {
+            LOGS(_log, LOG_LVL_DEBUG, "io_uring buffers not registered: " << std::strerror(errno));
+        }
+        return true;
+    }
+
+    ~Ring() {
+        if (sqes != nullptr) ::munmap(sqes, sqesBytes);
+        if (cqRing != nullptr and cqRing != sqRing) ::munmap(cqRing, cqRingBytes);
+        if (sqRing != nullptr) ::munmap(sqRing, sqRingBytes);
+        if (fd >= 0) ::close(fd);
+    }
+
+    /// Add an operation to the submission queue, it's submitted by enter()
+    void queue(bool write, size_t buf, int fileFd, uint64_t offset, size_t size, size_t at) {
+
+        unsigned const tail = *sqTail;  // Only this thread moves the tail
+        unsigned const idx  = tail & *sqMask;
+        io_uring_sqe& sqe = sqes[idx];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.fd        = fileFd;
+        sqe.off       = offset;
+        sqe.user_data = buf;
+        if (fixedBuffers) {
+            sqe.opcode    = write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+            sqe.addr      = reinterpret_cast<uint64_t>(static_cast<uint8_t*>(iovecs[buf].iov_base) + at);
+            sqe.len       = size;
+            sqe.buf_index = buf;
+        } else {
+            // The iovec of a buffer is only used by the one operation on it,
+            // and it stays valid until the operation completes.
+            opIovecs[buf].iov_base = static_cast<uint8_t*>(iovecs[buf].iov_base) + at;
+            opIovecs[buf].iov_len  = size;
+            sqe.opcode = write ? IORING_OP_WRITEV : IORING_OP_READV;
+            sqe.addr   = reinterpret_cast<uint64_t>(&opIovecs[buf]);
+            sqe.len    = 1;
+        }
+        sqArray[idx] = idx;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+        ++toSubmit;
+    }
+
+    /// Submit the queued operations and wait for one completion
+    void enter() {
+        while (true) {
+            long const num = ::syscall(__NR_io_uring_enter, fd, toSubmit, 1, IORING_ENTER_GETEVENTS,
+                                       nullptr, _NSIG / 8);
+            if (num >= 0) {
+                toSubmit -= std::min<unsigned>(toSubmit, num);
+                return;
+            }
+            if (errno != EINTR and errno != EAGAIN and errno != EBUSY) {
+                throw std::runtime_error(std::string("AsyncFileIO:  io_uring_enter failed: ") +
+                                         std::strerror(errno));
+            }
+            if (errno != EINTR) {
+                // The completion queue is full, or the kernel is short of memory
+                // for the submissions. Taking completions out makes room.
+                if (peek(nullptr)) return;
+            }
+        }
+    }
+
+    /// @return 'true' if a completion was there, and then it's taken into 'c'
+    bool peek(Completion* c) {
+        unsigned const head = *cqHead;  // Only this thread moves the head
+        if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) return false;
+        if (c == nullptr) return true;
+        io_uring_cqe const& cqe = cqes[head & *cqMask];
+        c->buf    = cqe.user_data;
+        c->result = cqe.res;
+        __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    int fd = -1;
+    bool fixedBuffers = false;
+    unsigned toSubmit = 0;
+
+    void* sqRing = nullptr;
+    void* cqRing = nullptr;
+    size_t sqRingBytes = 0;
+    size_t cqRingBytes = 0;
+    size_t sqesBytes = 0;
+
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+    io_uring_sqe* sqes = nullptr;
+
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    std::vector<iovec> iovecs;      ///< The buffers
+    std::vector<iovec> opIovecs;    ///< The parts of the buffers used by the vectored operations
+};
+
+#else
+
+/// There is no io_uring to build against, the operations are run by blocking calls.
+struct AsyncFileIO::Ring {
+    bool setup(std::vector<uint8_t*> const&, size_t) { return false; }
+    void queue(bool, size_t, int, uint64_t, size_t, size_t) {}
+    void enter() {}
+    bool peek(Completion*) { return false; }
+};
+
+#endif // QSERV_REPLICA_IO_URING
+
+/////////////////////////////
+//    class AsyncFileIO    //
+/////////////////////////////
+
+AsyncFileIO::AsyncFileIO(size_t depth, size_t bufferSizeBytes)
+    :   _bufferSizeBytes(bufferSizeBytes) {
+
+    if (not depth) {
+        throw std::invalid_argument("AsyncFileIO:  the depth can't be 0");
+    }
+    if (not bufferSizeBytes) {
+        throw std::invalid_argument("AsyncFileIO:  the buffer size can't be 0");
+    }
+    _buffers.reserve(depth);
+    for (size_t i = 0; i < depth; ++i) {
+        void* ptr = nullptr;
+        if (::posix_memalign(&ptr, bufferAlignmentBytes, bufferSizeBytes) != 0) {
+            for (auto buf: _buffers) std::free(buf);
+            throw std::bad_alloc();
+        }
+        _buffers.push_back(static_cast<uint8_t*>(ptr));
+    }
+
+    // A single operation in flight gains nothing from the ring
+    if (depth > 1) {
+        _ring.reset(new Ring());
+        if (not _ring->setup(_buffers, _bufferSizeBytes)) _ring.reset();
+    }
+    LOGS(_log, LOG_LVL_DEBUG, "AsyncFileIO  depth: " << depth << "  bufferSizeBytes: " << bufferSizeBytes
+         << "  io_uring: " << (usesUring() ? "yes" : "no"));
+}
+
+
+AsyncFileIO::~AsyncFileIO() {
+
+    // The kernel may still be reading into, or writing from, the buffers
+    try {
+        while (_inFlight != 0) wait();
+    } catch (std::exception const& ex) {
+        LOGS(_log, LOG_LVL_ERROR, "AsyncFileIO  failed to wait for the operations in flight: " << ex.what());
+        _ring.reset();
+        return;  // The buffers are leaked rather than reused by the kernel
+    }
+    _ring.reset();
+    for (auto buf: _buffers) std::free(buf);
+}
+
+
+void AsyncFileIO::read(size_t buf, int fd, uint64_t offset, size_t size, size_t at) {
+    _queue(false, buf, fd, offset, size, at);
+}
+
+
+void AsyncFileIO::write(size_t buf, int fd, uint64_t offset, size_t size, size_t at) {
+    _queue(true, buf, fd, offset, size, at);
+}
+
+
+void AsyncFileIO::_queue(bool write, size_t buf, int fd, uint64_t offset, size_t size, size_t at) {
+
+    if (buf >= _buffers.size() or at > _bufferSizeBytes or size > _bufferSizeBytes - at) {
+        throw std::logic_error(
+                "AsyncFileIO:  operation out of the buffers, buf: " + std::to_string(buf) +
+                ", at: " + std::to_string(at) + ", size: " + std::to_string(size));
+    }
+    ++_inFlight;
+    if (_ring != nullptr) {
+        _ring->queue(write, buf, fd, offset, size, at);
+        return;
+    }
+    uint8_t* const ptr = _buffers[buf] + at;
+    ssize_t num;
+    do {
+        num = write ? ::pwrite(fd, ptr, size, offset) : ::pread(fd, ptr, size, offset);
+    } while (num < 0 and errno == EINTR);
+    _completed.push_back(Completion{buf, num < 0 ? -errno : num});
+}
+
+
+AsyncFileIO::Completion AsyncFileIO::wait() {
+
+    if (_inFlight == 0) {
+        throw std::logic_error("AsyncFileIO:  no operation in flight");
+    }
+    Completion c{0, 0};
+    if (_ring != nullptr) {
+        while (not _ring->peek(&c)) _ring->enter();
+    } else {
+        c = _completed.front();
+        _completed.pop_front();
+    }
+    --_inFlight;
+    return c;
+}
+
+/////////////////////////////////
+//    class AsyncFileReader    //
+/////////////////////////////////
+
+AsyncFileReader::AsyncFileReader(int fd, size_t recordSizeBytes, size_t depth)
+    :   _fd(fd),
+        _io(depth, recordSizeBytes),
+        _records(depth) {
+
+    for (size_t buf = 0; buf < depth; ++buf) _read(buf);
+}
+
+
+ssize_t AsyncFileReader::next(uint8_t const*& data) {
+
+    if (_error != 0) return -_error;
+
+    // The buffer of the record returned by the previous call is free now
+    if (_returned) {
+        _returned = false;
+        _records[_head] = Record();
+        if (not _eof) _read(_head);
+        _head = (_head + 1) % _records.size();
+    }
+
+    Record& record = _records[_head];
+    if (not record.queued) return 0;  // Past the end of the file
+
+    size_t const recordSizeBytes = _io.bufferSize();
+    while (not record.complete) {
+        AsyncFileIO::Completion const c = _io.wait();
+        Record& r = _records[c.buf];
+        if (c.result == -EINTR or c.result == -EAGAIN) {
+            _io.read(c.buf, _fd, r.offset + r.filled, recordSizeBytes - r.filled, r.filled);
+        } else if (c.result < 0) {
+            _error = -c.result;
+            return c.result;
+        } else if (c.result == 0) {
+            r.complete = true;
+        } else {
+            // Reads may come short of the record before the end of the file
+            r.filled += c.result;
+            if (r.filled == recordSizeBytes) {
+                r.complete = true;
+            } else {
+                _io.read(c.buf, _fd, r.offset + r.filled, recordSizeBytes - r.filled, r.filled);
+            }
+        }
+    }
+    if (record.filled < recordSizeBytes) _eof = true;
+    _returned = true;
+    data = _io.buffer(_head);
+    return record.filled;
+}
+
+
+void AsyncFileReader::_read(size_t buf) {
+    Record& record = _records[buf];
+    record.offset = _nextOffset;
+    record.queued = true;
+    _io.read(buf, _fd, _nextOffset, _io.bufferSize());
+    _nextOffset += _io.bufferSize();
+}
+
+}}} // namespace lsst::qserv::replica
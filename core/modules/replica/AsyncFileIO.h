@@ -0,0 +1,213 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_REPLICA_ASYNCFILEIO_H
+#define LSST_QSERV_REPLICA_ASYNCFILEIO_H
+
+// System headers
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <sys/types.h>
+#include <vector>
+
+// This header declarations
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+/**
+ * Class AsyncFileIO keeps up to a number of reads and writes of files in
+ * flight at once, each one into or from one of the same number of buffers
+ * owned by the object. The operations are run by io_uring where the kernel
+ * has it, with the buffers registered with the kernel once. Otherwise, or
+ * when only one operation may be in flight, they're run by blocking pread(2)
+ * and pwrite(2) calls when they're queued, and their completions are
+ * returned in order.
+ *
+ * A buffer may only be used by one operation at a time. The object isn't
+ * thread-safe, it's meant to be driven by one thread.
+ *
+ * @code
+ *   AsyncFileIO io(4, 1024*1024);
+ *   for (size_t buf = 0; buf < io.depth(); ++buf) {
+ *       io.read(buf, fd, buf * io.bufferSize(), io.bufferSize());
+ *   }
+ *   while (io.inFlight() != 0) {
+ *       AsyncFileIO::Completion const c = io.wait();
+ *       ... c.result bytes of io.buffer(c.buf) ...
+ *   }
+ * @endcode
+ */
+class AsyncFileIO {
+
+public:
+
+    /// The outcome of an operation
+    struct Completion {
+        size_t  buf;    ///< The buffer of the operation
+        ssize_t result; ///< The number of bytes read or written, -errno on failure
+    };
+
+    // Default construction and copy semantics are prohibited
+
+    AsyncFileIO() = delete;
+    AsyncFileIO(AsyncFileIO const&) = delete;
+    AsyncFileIO& operator=(AsyncFileIO const&) = delete;
+
+    /**
+     * The normal constructor
+     *
+     * @param depth          - the number of buffers, and of operations in flight
+     * @param bufferSizeBytes - the size of each buffer
+     *
+     * @throws std::invalid_argument if the depth or the buffer size is 0
+     * @throws std::bad_alloc if the buffers can't be allocated
+     */
+    AsyncFileIO(size_t depth, size_t bufferSizeBytes);
+
+    /// Destructor waits for the operations still in flight
+    ~AsyncFileIO();
+
+    /// @return 'true' if the operations are run by io_uring
+    bool usesUring() const { return _ring != nullptr; }
+
+    /// @return the number of buffers
+    size_t depth() const { return _buffers.size(); }
+
+    /// @return the size of each buffer
+    size_t bufferSize() const { return _bufferSizeBytes; }
+
+    /// @return the buffer 'buf', aligned on a page
+    uint8_t* buffer(size_t buf) const { return _buffers[buf]; }
+
+    /// @return the number of operations queued and not returned by wait() yet
+    size_t inFlight() const { return _inFlight; }
+
+    /**
+     * Queue a read of 'size' bytes at 'offset' of file 'fd' into buffer 'buf',
+     * starting 'at' bytes into the buffer
+     *
+     * @throws std::logic_error if the operation doesn't fit into the buffer
+     */
+    void read(size_t buf, int fd, uint64_t offset, size_t size, size_t at=0);
+
+    /**
+     * Queue a write of 'size' bytes of buffer 'buf', starting 'at' bytes
+     * into the buffer, at 'offset' of file 'fd'
+     *
+     * @throws std::logic_error if the operation doesn't fit into the buffer
+     */
+    void write(size_t buf, int fd, uint64_t offset, size_t size, size_t at=0);
+
+    /**
+     * Submit the queued operations and wait for one of them to complete
+     *
+     * @throws std::logic_error if no operation is in flight
+     * @throws std::runtime_error if io_uring fails
+     */
+    Completion wait();
+
+private:
+
+    struct Ring;
+
+    void _queue(bool write, size_t buf, int fd, uint64_t offset, size_t size, size_t at);
+
+    size_t const _bufferSizeBytes;
+
+    std::vector<uint8_t*> _buffers;
+
+    std::unique_ptr<Ring> _ring;    ///< Null if the operations are run by blocking calls
+
+    size_t _inFlight = 0;
+
+    std::deque<Completion> _completed;  ///< Completions of the blocking calls
+};
+
+
+/**
+ * Class AsyncFileReader reads a file in order, one record at a time, with
+ * the reads of the next records already in flight.
+ */
+class AsyncFileReader {
+
+public:
+
+    AsyncFileReader() = delete;
+    AsyncFileReader(AsyncFileReader const&) = delete;
+    AsyncFileReader& operator=(AsyncFileReader const&) = delete;
+
+    /**
+     * The normal constructor, the first reads are queued right away
+     *
+     * @param fd              - the file, which is not closed by the reader
+     * @param recordSizeBytes - the number of bytes read at a time
+     * @param depth           - the number of records read at once
+     */
+    AsyncFileReader(int fd, size_t recordSizeBytes, size_t depth);
+
+    ~AsyncFileReader() = default;
+
+    /// @return 'true' if the records are read by io_uring
+    bool usesUring() const { return _io.usesUring(); }
+
+    /**
+     * Read the next record of the file
+     *
+     * @param data - set to the record, which is valid until the next call
+     *
+     * @return the number of bytes of the record, 0 at the end of the file,
+     *         -errno if it couldn't be read
+     */
+    ssize_t next(uint8_t const*& data);
+
+private:
+
+    /// The read of the record in a buffer
+    struct Record {
+        uint64_t offset = 0;
+        size_t filled = 0;
+        bool queued = false;
+        bool complete = false;
+    };
+
+    /// Queue the read of the next record of the file into buffer 'buf'
+    void _read(size_t buf);
+
+    int const _fd;
+
+    AsyncFileIO _io;
+
+    std::vector<Record> _records;
+
+    size_t _head = 0;           ///< The buffer of the next record
+    bool _returned = false;     ///< Set while the record in the buffer _head is used by the caller
+    uint64_t _nextOffset = 0;   ///< The offset of the next read to be queued
+    bool _eof = false;          ///< Set once a record came short of the end of the file
+    int _error = 0;             ///< The errno of a failed read
+};
+
+}}} // namespace lsst::qserv::replica
+
+#endif // LSST_QSERV_REPLICA_ASYNCFILEIO_H
@@ -0,0 +1,154 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "replica/BandwidthLimiter.h"
+
+// System headers
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <thread>
+
+// Qserv headers
+#include "lsst/log/Log.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.replica.BandwidthLimiter");
+
+/// The period of time (seconds) the bucket is allowed to accumulate tokens for
+double const burstSec = 0.25;
+
+/// The minimum capacity of the bucket (bytes)
+double const minBurstBytes = 1024 * 1024;
+
+/// The minimum fraction of the configured rate allowed when the host
+/// is overloaded
+double const minFactor = 0.1;
+
+/// The interval (seconds) between evaluations of the load of the host
+std::chrono::seconds const loadInterval(5);
+
+/**
+ * @return the fraction of the configured rate allowed at the current
+ *   load of the host (1 if the load can't be determined)
+ */
+double loadFactor() {
+
+    std::ifstream file("/proc/loadavg");
+    double load1min = 0;
+    if (not (file >> load1min)) return 1.;
+
+    unsigned int const numCpus = std::max(1U, std::thread::hardware_concurrency());
+    double const load = load1min / numCpus;
+
+    return load > 1. ? std::max(minFactor, 1. / load) : 1.;
+}
+
+} /// namespace
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+BandwidthLimiter::Ptr BandwidthLimiter::instance(std::string const& workerName) {
+
+    static std::mutex mtx;
+    static std::map<std::string, Ptr> worker2limiter;
+
+    std::lock_guard<std::mutex> lock(mtx);
+    auto itr = worker2limiter.find(workerName);
+    if (itr == worker2limiter.end()) {
+        Ptr const ptr(new BandwidthLimiter());
+        itr = worker2limiter.emplace(workerName, ptr).first;
+    }
+    return itr->second;
+}
+
+BandwidthLimiter::BandwidthLimiter()
+    :   _rate(0),
+        _factor(1.),
+        _tokens(0),
+        _refillTime(Clock::now()),
+        _loadTime(Clock::now()) {
+}
+
+void BandwidthLimiter::setRate(uint64_t bytesPerSec) {
+
+    LOGS(_log, LOG_LVL_DEBUG, "BandwidthLimiter::setRate  bytesPerSec: " << bytesPerSec);
+
+    std::lock_guard<std::mutex> lock(_mtx);
+    _rate = bytesPerSec;
+    _tokens = 0;
+    _refillTime = Clock::now();
+}
+
+uint64_t BandwidthLimiter::rate() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _rate;
+}
+
+uint64_t BandwidthLimiter::effectiveRate() {
+    std::lock_guard<std::mutex> lock(_mtx);
+    refill(lock);
+    return static_cast<uint64_t>(_rate * _factor);
+}
+
+uint64_t BandwidthLimiter::consume(uint64_t bytes) {
+
+    std::lock_guard<std::mutex> lock(_mtx);
+    if (_rate == 0) return 0;
+
+    refill(lock);
+    _tokens -= bytes;
+    if (_tokens >= 0) return 0;
+
+    double const rate = _rate * _factor;
+    return static_cast<uint64_t>(-_tokens / rate * 1e6);
+}
+
+void BandwidthLimiter::refill(std::lock_guard<std::mutex> const& lock) {
+
+    Clock::time_point const now = Clock::now();
+
+    if (now - _loadTime >= loadInterval) {
+        _loadTime = now;
+        double const factor = loadFactor();
+        if (factor != _factor) {
+            LOGS(_log, LOG_LVL_DEBUG, "BandwidthLimiter::refill  factor: " << factor);
+            _factor = factor;
+        }
+    }
+    if (_rate == 0) {
+        _refillTime = now;
+        return;
+    }
+    double const rate = _rate * _factor;
+    double const elapsedSec = std::chrono::duration<double>(now - _refillTime).count();
+    _refillTime = now;
+
+    _tokens = std::min(_tokens + elapsedSec * rate,
+                       std::max(rate * burstSec, minBurstBytes));
+}
+
+}}} // namespace lsst::qserv::replica
@@ -0,0 +1,140 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_REPLICA_BANDWIDTHLIMITER_H
+#define LSST_QSERV_REPLICA_BANDWIDTHLIMITER_H
+
+/**
+ * This header declares class BandwidthLimiter which limits the rate
+ * at which the file server of a worker sends data.
+ */
+
+// System headers
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// This header declarations
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+/**
+  * Class BandwidthLimiter is a token bucket shared by all connections of
+  * the file server of a worker. The bucket is refilled at the configured
+  * rate, and it holds up to a quarter of a second worth of tokens (but no
+  * less than 1 MB) to allow short bursts.
+  *
+  * A connection reports the bytes it has just sent, and it gets back a delay
+  * it should wait before sending more. The bucket is allowed to go into debt,
+  * so the delay is computed after the fact and no data has to be split to fit
+  * the tokens available.
+  *
+  * The rate is automatically reduced while the host is overloaded, which is
+  * when the 1-minute load average exceeds the number of processors. Then
+  * the rate is divided by the ratio of the two (but not below 10% of
+  * the configured rate) to leave more room for the queries.
+  */
+class BandwidthLimiter {
+
+public:
+
+    /// The pointer type for instances of the class
+    typedef std::shared_ptr<BandwidthLimiter> Ptr;
+
+    /**
+     * @param workerName - the name of a worker
+     *
+     * @return the limiter of a worker
+     */
+    static Ptr instance(std::string const& workerName);
+
+    // Copy semantics are prohibited
+
+    BandwidthLimiter(BandwidthLimiter const&) = delete;
+    BandwidthLimiter& operator=(BandwidthLimiter const&) = delete;
+
+    ~BandwidthLimiter() = default;
+
+    /**
+     * Change the rate
+     *
+     * @param bytesPerSec - the maximum rate (0 means no limit)
+     */
+    void setRate(uint64_t bytesPerSec);
+
+    /// @return the maximum rate (0 means no limit)
+    uint64_t rate() const;
+
+    /// @return the rate after taking into account the load of the host
+    /// (0 means no limit)
+    uint64_t effectiveRate();
+
+    /**
+     * Take tokens for the bytes which have been sent
+     *
+     * @param bytes - the number of bytes
+     *
+     * @return the number of microseconds to wait before sending more data
+     */
+    uint64_t consume(uint64_t bytes);
+
+private:
+
+    typedef std::chrono::steady_clock Clock;
+
+    BandwidthLimiter();
+
+    /**
+     * Refill the bucket and reevaluate the load of the host if it's time
+     * to do so
+     *
+     * @param lock - the lock on the mutex
+     */
+    void refill(std::lock_guard<std::mutex> const& lock);
+
+private:
+
+    /// Protects the members below
+    mutable std::mutex _mtx;
+
+    /// The configured rate (0 means no limit)
+    uint64_t _rate;
+
+    /// The fraction of the configured rate allowed at the current load
+    double _factor;
+
+    /// The tokens (bytes) available. It's negative when the bucket is in debt.
+    double _tokens;
+
+    /// When the bucket was refilled last time
+    Clock::time_point _refillTime;
+
+    /// When the load of the host was evaluated last time
+    Clock::time_point _loadTime;
+};
+
+}}} // namespace lsst::qserv::replica
+
+#endif // LSST_QSERV_REPLICA_BANDWIDTHLIMITER_H
@@ -24,7 +24,7 @@
 #include "replica/ChunkLocker.h"
 
 // System headers
-#include <algorithm>
+#include <functional>
 #include <stdexcept>
 #include <tuple>        // std::tie
 
@@ -57,18 +57,44 @@ std::ostream& operator<<(std::ostream& os, Chunk const& chunk) {
 //                ChunkLocker              //
 /////////////////////////////////////////////
 
+size_t const ChunkLocker::numShards;
+
+std::unique_lock<std::mutex> ChunkLocker::lockShard(Shard& shard) {
+
+    std::unique_lock<std::mutex> lock(shard.mtx, std::try_to_lock);
+    if (not lock.owns_lock()) {
+        lock.lock();
+        shard.stats.numContended++;
+    }
+    shard.stats.numAcquired++;
+    return lock;
+}
+
+ChunkLocker::Shard& ChunkLocker::shardOf(Chunk const& chunk) const {
+
+    // Chunks of different families with the same number are usually
+    // locked together by the same job, hence the family is mixed in
+    // to keep them apart.
+
+    size_t const hash = std::hash<std::string>()(chunk.databaseFamily) * 31 + chunk.number;
+    return _shards[hash % numShards];
+}
+
 bool ChunkLocker::isLocked(Chunk const& chunk) const {
-    util::Lock mLock(_mtx, "ChunkLocker::isLocked(chunk)");
-    return _chunk2owner.count(chunk);
+
+    Shard& shard = shardOf(chunk);
+    auto const lock = lockShard(shard);
+    return shard.chunk2owner.count(chunk);
 }
 
 bool ChunkLocker::isLocked(Chunk const& chunk,
                            std::string& owner) const {
 
-    util::Lock mLock(_mtx, "ChunkLocker::isLocked(chunk,owner)");
+    Shard& shard = shardOf(chunk);
+    auto const lock = lockShard(shard);
 
-    auto itr = _chunk2owner.find(chunk);
-    if (itr != _chunk2owner.end()) {
+    auto itr = shard.chunk2owner.find(chunk);
+    if (itr != shard.chunk2owner.end()) {
         owner = itr->second;
         return true;
     }
@@ -77,99 +103,117 @@ bool ChunkLocker::isLocked(Chunk const& chunk,
 
 ChunkLocker::OwnerToChunks ChunkLocker::locked(std::string const& owner) const {
 
-    util::Lock mLock(_mtx, "ChunkLocker::locked");
-
     OwnerToChunks owner2chunks;
-    lockedImpl(mLock,
-               owner,
-               owner2chunks);
-
-    return owner2chunks;
-}
-
-void ChunkLocker::lockedImpl(util::Lock const& mLock,
-                             std::string const& owner,
-                             ChunkLocker::OwnerToChunks& owner2chunks) const {
-
-    for (auto&& entry: _chunk2owner) {
-        Chunk       const& chunk      = entry.first;
-        std::string const& chunkOwner = entry.second;
-
-        if (owner.empty() or (owner == chunkOwner)) {
-            owner2chunks[chunkOwner].push_back(chunk);
+    for (auto&& shard: _shards) {
+        auto const lock = lockShard(shard);
+        for (auto&& entry: shard.owner2chunks) {
+            std::string const& chunkOwner = entry.first;
+            if (owner.empty() or (owner == chunkOwner)) {
+                auto& chunks = owner2chunks[chunkOwner];
+                chunks.insert(chunks.end(), entry.second.begin(), entry.second.end());
+            }
         }
     }
+    return owner2chunks;
 }
 
 bool ChunkLocker::lock(Chunk const&       chunk,
                        std::string const& owner) {
 
-    util::Lock mLock(_mtx, "ChunkLocker::lock");
-
     if (owner.empty()) {
         throw std::invalid_argument("ChunkLocker::lock  empty owner");
     }
-    auto itr = _chunk2owner.find(chunk);
-    if (itr != _chunk2owner.end()) return owner == itr->second;
 
-    _chunk2owner[chunk] = owner;
+    Shard& shard = shardOf(chunk);
+    auto const lock = lockShard(shard);
+
+    auto itr = shard.chunk2owner.find(chunk);
+    if (itr != shard.chunk2owner.end()) {
+        bool const owned = owner == itr->second;
+        if (not owned) shard.stats.numRefused++;
+        return owned;
+    }
+    shard.chunk2owner[chunk] = owner;
+    shard.owner2chunks[owner].insert(chunk);
+    shard.stats.numLocked++;
     return true;
 }
 
 bool ChunkLocker::release(Chunk const& chunk) {
 
-    util::Lock mLock(_mtx, "ChunkLocker::release(chunk)");
-
     // An owner (if set) will be ignored by the current method
 
     std::string owner;
-    return releaseImpl(mLock, chunk, owner);
+    return release(chunk, owner);
 }
 
 bool ChunkLocker::release(Chunk const& chunk,
                           std::string& owner) {
 
-    util::Lock mLock(_mtx, "ChunkLocker::release(chunk,owner)");
-    return releaseImpl(mLock, chunk, owner);
+    Shard& shard = shardOf(chunk);
+    auto const lock = lockShard(shard);
+    return releaseImpl(shard, chunk, owner);
 }
 
-bool ChunkLocker::releaseImpl(util::Lock const& mLock,
+bool ChunkLocker::releaseImpl(Shard& shard,
                               Chunk const& chunk,
                               std::string& owner) {
 
-    auto itr = _chunk2owner.find(chunk);
-    if (itr == _chunk2owner.end()) return false;
+    auto itr = shard.chunk2owner.find(chunk);
+    if (itr == shard.chunk2owner.end()) return false;
 
     // ATTENTION: remove the chunk from this map _only_ after
     //            getting its owner
 
     owner = itr->second;
-    _chunk2owner.erase(itr);
+    shard.chunk2owner.erase(itr);
+
+    auto ownerItr = shard.owner2chunks.find(owner);
+    ownerItr->second.erase(chunk);
+    if (ownerItr->second.empty()) shard.owner2chunks.erase(ownerItr);
 
+    shard.stats.numReleased++;
     return true;
 }
 
 std::list<Chunk> ChunkLocker::release(std::string const& owner) {
 
-    util::Lock mLock(_mtx, "ChunkLocker::release(owner)");
-
     if (owner.empty()) {
         throw std::invalid_argument("ChunkLocker::release  empty owner");
     }
 
     // Get rid of chunks owned by the specified owner, and also collect
-    // those (removed) chunks into a vector to be returned to a caller.
+    // those (removed) chunks into a list to be returned to a caller.
+    // Only the shards whose index has the owner are modified.
+
+    std::list<Chunk> chunks;
+    for (auto&& shard: _shards) {
+        auto const lock = lockShard(shard);
+        auto ownerItr = shard.owner2chunks.find(owner);
+        if (ownerItr == shard.owner2chunks.end()) continue;
+
+        for (auto&& chunk: ownerItr->second) {
+            shard.chunk2owner.erase(chunk);
+            chunks.push_back(chunk);
+        }
+        shard.stats.numReleased += ownerItr->second.size();
+        shard.owner2chunks.erase(ownerItr);
+    }
+    return chunks;
+}
 
-    OwnerToChunks owner2chunks;
-    lockedImpl(mLock,
-               owner,
-               owner2chunks);
+ChunkLocker::Stats ChunkLocker::stats() const {
 
-    std::list<Chunk> chunks = owner2chunks[owner];
-    for (auto&& chunk: chunks) {
-        _chunk2owner.erase(chunk);
+    Stats result;
+    for (auto&& shard: _shards) {
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        result.numAcquired  += shard.stats.numAcquired;
+        result.numContended += shard.stats.numContended;
+        result.numLocked    += shard.stats.numLocked;
+        result.numRefused   += shard.stats.numRefused;
+        result.numReleased  += shard.stats.numReleased;
     }
-    return chunks;
+    return result;
 }
 
 }}} // namespace lsst::qserv::replica
@@ -23,14 +23,15 @@
 #define LSST_QSERV_REPLICA_CHUNKLOCKER_H
 
 // System headers
+#include <array>
+#include <cstdint>
 #include <list>
 #include <map>
+#include <mutex>
 #include <ostream>
+#include <set>
 #include <string>
 
-// Qserv headers
-#include "util/Mutex.h"
-
 // This header declarations
 
 namespace lsst {
@@ -75,6 +76,12 @@ std::ostream& operator<< (std::ostream& os, Chunk const& chunk);
  * Class ChunkLocker provides a thread-safe mechanism allowing
  * owners (represented by unique string-based identifiers) to claim
  * exclusive 'locks' (ownership claims) on chunks.
+ *
+ * Chunks are spread by their hash over a fixed number of shards, each
+ * having its own mutex, so that jobs locking and releasing different
+ * chunks rarely wait for each other. Each shard also indexes its chunks
+ * by owner, so that releasing or listing the chunks of one owner doesn't
+ * look at the chunks of the other ones.
  */
 class ChunkLocker {
 
@@ -86,6 +93,31 @@ public:
     /// A map of chunks to their owners
     typedef std::map<Chunk, std::string> ChunkToOwner;
 
+    /// The number of shards the chunks are spread over
+    static size_t const numShards = 64;
+
+    /**
+     * Structure Stats counts calls to the locker's methods since its
+     * construction. The counters are summed over all shards.
+     */
+    struct Stats {
+
+        /// The number of times a shard mutex was acquired
+        uint64_t numAcquired = 0;
+
+        /// The number of times a shard mutex was found held by another thread
+        uint64_t numContended = 0;
+
+        /// The number of chunks locked
+        uint64_t numLocked = 0;
+
+        /// The number of lock attempts refused because of another owner
+        uint64_t numRefused = 0;
+
+        /// The number of chunks released
+        uint64_t numReleased = 0;
+    };
+
     /// The default constructor
     ChunkLocker() = default;
 
@@ -172,22 +204,41 @@ public:
      */
     std::list<Chunk> release(std::string const& owner);
 
+    /// @return a snapshot of the call and contention counters
+    Stats stats() const;
+
 private:
 
     /**
-     * Find chunks which are locked by a particular owner (if provided),
-     * or by all owners.
+     * Structure Shard holds the chunks whose hash maps to the shard
+     */
+    struct Shard {
+
+        /// Mapping a chunk to its "owner" (the one which holds the lock)
+        ChunkToOwner chunk2owner;
+
+        /// The reverse index of the above map
+        std::map<std::string, std::set<Chunk>> owner2chunks;
+
+        /// The counters of the shard
+        Stats stats;
+
+        /// Protects the members above
+        std::mutex mtx;
+    };
+
+    /**
+     * Lock the mutex of a shard, counting the acquisition and whether
+     * the mutex was held by another thread at the time of the call.
      *
-     * @param mLock  - a lock on a mutex must be made before calling this method
-     * @param owner  - an optional owner. If the owner is not provided then
-     *                 all chunks will be returned
-     * @owner2chunks - collection of chunks to be initialized
+     * @param shard - the shard to be locked
      *
-     * @return a collection of chunks grouped by owners
+     * @return the lock on the shard's mutex
      */
-    void lockedImpl(util::Lock const& mLock,
-                    std::string const& owner,
-                    OwnerToChunks& owner2chunks) const;
+    static std::unique_lock<std::mutex> lockShard(Shard& shard);
+
+    /// @return the shard of a chunk
+    Shard& shardOf(Chunk const& chunk) const;
 
     /**
      * Actual implementation of the chunk release operation, which will attempt
@@ -195,9 +246,9 @@ private:
      * previously 'claimed' the chunk.
      *
      * NOTE: this method is not thread-safe. It's up to its callers to ensure
-     *       proper synchronization context before invoking the method.
+     *       the mutex of the shard is locked before invoking the method.
      *
-     * @param mLock - a lock on a mutex must be made before calling this method
+     * @param shard - the shard of the chunk
      * @param chunk - a chunk to be released
      * @param owner - a reference to a string which will be initialized with
      *                an identifier of an owner which had a claim on the chunk
@@ -205,17 +256,14 @@ private:
      *
      * @return 'true' if the operation was successful
      */
-    bool releaseImpl(util::Lock const& mLock,
-                     Chunk const& chunk,
-                     std::string& owner);
+    static bool releaseImpl(Shard& shard,
+                            Chunk const& chunk,
+                            std::string& owner);
 
 private:
 
-    /// Mapping a chunk to its "owner" (the one which holds the lock)
-    ChunkToOwner _chunk2owner;
-
-    /// For thread safety where it's required
-    mutable util::Mutex _mtx;
+    /// The shards (mutable to allow locking them in the const methods)
+    mutable std::array<Shard, numShards> _shards;
 };
 
 }}} // namespace lsst::qserv::replica
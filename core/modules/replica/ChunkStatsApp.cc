@@ -0,0 +1,173 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "replica/ChunkStatsApp.h"
+
+// System headers
+#include <atomic>
+#include <iostream>
+#include <vector>
+
+// Qserv headers
+#include "replica/ChunkStatsJob.h"
+#include "replica/Controller.h"
+#include "util/BlockPost.h"
+#include "util/TablePrinter.h"
+
+using namespace std;
+
+namespace {
+
+string const description =
+    "This application collects the sizes of the chunk tables of a database at"
+    " the Qserv workers, and the completion times of the tasks which scanned them,"
+    " into the database of the Replication system. Only the sizes of the tables"
+    " modified since the previous collection are reported by the workers unless"
+    " the full collection is requested.";
+
+} /// namespace
+
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+ChunkStatsApp::Ptr ChunkStatsApp::create(int argc, char* argv[]) {
+    return Ptr(
+        new ChunkStatsApp(argc, argv)
+    );
+}
+
+
+ChunkStatsApp::ChunkStatsApp(int argc, char* argv[])
+    :   Application(
+            argc, argv,
+            ::description,
+            true    /* injectDatabaseOptions */,
+            true    /* boostProtobufVersionCheck */,
+            true    /* enableServiceProvider */
+        ) {
+
+    // Configure the command line parser
+
+    parser().required(
+        "database",
+        "The name of a database",
+        _database);
+
+    parser().flag(
+        "full",
+        "The flag for collecting the sizes of all tables rather than of the tables"
+        " modified since the previous collection.",
+        _full);
+
+    parser().flag(
+        "all-workers",
+        "The flag for selecting all workers regardless of their status (DISABLED or READ-ONLY).",
+        _allWorkers);
+
+    parser().option(
+        "tables-page-size",
+        "The number of rows in the table of statistics (0 means no pages).",
+        _pageSize);
+}
+
+
+int ChunkStatsApp::runImpl() {
+
+    atomic<bool> finished{false};
+    auto const job = ChunkStatsJob::create(
+        _database,
+        _full,
+        _allWorkers,
+        Controller::create(serviceProvider()),
+        string(),
+        [&finished] (ChunkStatsJob::Ptr const& job) {
+            finished = true;
+        }
+    );
+    job->start();
+
+    util::BlockPost blockPost(1000,2000);
+    while (not finished) {
+        blockPost.wait();
+    }
+
+    // Analyze and display results
+
+    vector<string>   worker;
+    vector<string>   status;
+    vector<string>   table;
+    vector<uint32_t> chunk;
+    vector<uint64_t> numRows;
+    vector<uint64_t> dataSize;
+    vector<uint64_t> indexSize;
+    vector<uint64_t> tasksCompleted;
+    vector<double>   lastScanSeconds;
+
+    for (auto&& entry: job->getStatsData().workers) {
+        auto const itr = job->getStatsData().stats.find(entry.first);
+        if (not entry.second or itr == job->getStatsData().stats.end() or itr->second.empty()) {
+            worker.push_back(entry.first);
+            status.push_back(entry.second ? "UNCHANGED" : "FAILED");
+            table.push_back("");
+            chunk.push_back(0);
+            numRows.push_back(0);
+            dataSize.push_back(0);
+            indexSize.push_back(0);
+            tasksCompleted.push_back(0);
+            lastScanSeconds.push_back(0);
+            continue;
+        }
+        for (auto&& s: itr->second) {
+            worker.push_back(s.worker);
+            status.push_back(s.hasSize ? "SIZE" : "SCANS");
+            table.push_back(s.table);
+            chunk.push_back(s.chunk);
+            numRows.push_back(s.numRows);
+            dataSize.push_back(s.dataSize);
+            indexSize.push_back(s.indexSize);
+            tasksCompleted.push_back(s.tasksCompleted);
+            lastScanSeconds.push_back(s.lastScanSeconds);
+        }
+    }
+    util::ColumnTablePrinter tableStats("CHUNK STATISTICS:", "  ", false);
+
+    tableStats.addColumn("worker",        worker,          util::ColumnTablePrinter::Alignment::LEFT);
+    tableStats.addColumn("reported",      status,          util::ColumnTablePrinter::Alignment::LEFT);
+    tableStats.addColumn("table",         table,           util::ColumnTablePrinter::Alignment::LEFT);
+    tableStats.addColumn("chunk",         chunk);
+    tableStats.addColumn("rows",          numRows);
+    tableStats.addColumn("data bytes",    dataSize);
+    tableStats.addColumn("index bytes",   indexSize);
+    tableStats.addColumn("tasks",         tasksCompleted);
+    tableStats.addColumn("last scan sec", lastScanSeconds);
+
+    cout << "\n";
+    tableStats.print(cout, false, false, _pageSize);
+    cout << "\n";
+
+    return job->extendedState() == Job::ExtendedState::SUCCESS ? 0 : 1;
+}
+
+}}} // namespace lsst::qserv::replica
@@ -0,0 +1,95 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_REPLICA_CHUNKSTATSAPP_H
+#define LSST_QSERV_REPLICA_CHUNKSTATSAPP_H
+
+// Qserv headers
+#include "replica/Application.h"
+
+// This header declarations
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+/**
+ * Class ChunkStatsApp implements a tool which collects the sizes of the chunk
+ * tables of a database at the Qserv workers, and the completion times of the
+ * tasks which scanned them, into the database of the Replication system.
+ */
+class ChunkStatsApp: public Application {
+
+public:
+
+    /// The pointer type for instances of the class
+    typedef std::shared_ptr<ChunkStatsApp> Ptr;
+
+    /**
+     * The factory method is the only way of creating objects of this class
+     * because of the very base class's inheritance from 'enable_shared_from_this'.
+     *
+     * @param argc
+     *   the number of command-line arguments
+     *
+     * @param argv
+     *   the vector of command-line arguments
+     */
+    static Ptr create(int argc, char* argv[]);
+
+    // Default construction and copy semantics are prohibited
+
+    ChunkStatsApp()=delete;
+    ChunkStatsApp(ChunkStatsApp const&)=delete;
+    ChunkStatsApp& operator=(ChunkStatsApp const&)=delete;
+
+    ~ChunkStatsApp() override=default;
+
+protected:
+
+    /**
+     * @see ChunkStatsApp::create()
+     */
+    ChunkStatsApp(int argc, char* argv[]);
+
+    /**
+     * @see Application::runImpl()
+     */
+    int runImpl() final;
+
+private:
+
+    /// The name of a database
+    std::string _database;
+
+    /// Collect the sizes of all tables rather than of the modified ones
+    bool _full = false;
+
+    /// Engage all known workers regardless of their status
+    bool _allWorkers = false;
+
+    /// The number of rows in the table of statistics (0 means no pages)
+    size_t _pageSize = 20;
+};
+
+}}} // namespace lsst::qserv::replica
+
+#endif /* LSST_QSERV_REPLICA_CHUNKSTATSAPP_H */
@@ -0,0 +1,278 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "replica/ChunkStatsJob.h"
+
+// System headers
+#include <stdexcept>
+
+// Qserv headers
+#include "lsst/log/Log.h"
+#include "replica/Configuration.h"
+#include "replica/DatabaseMySQL.h"
+#include "replica/DatabaseServices.h"
+#include "replica/Performance.h"
+#include "replica/QservMgtServices.h"
+#include "replica/ServiceProvider.h"
+
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.replica.ChunkStatsJob");
+
+} /// namespace
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+Job::Options const& ChunkStatsJob::defaultOptions() {
+    static Job::Options const options{
+        0,      /* priority */
+        false,  /* exclusive */
+        true    /* exclusive */
+    };
+    return options;
+}
+
+
+std::string ChunkStatsJob::typeName() { return "ChunkStatsJob"; }
+
+
+ChunkStatsJob::Ptr ChunkStatsJob::create(std::string const& database,
+                                         bool full,
+                                         bool allWorkers,
+                                         Controller::Ptr const& controller,
+                                         std::string const& parentJobId,
+                                         CallbackType const& onFinish,
+                                         Job::Options const& options) {
+    return ChunkStatsJob::Ptr(
+        new ChunkStatsJob(database,
+                          full,
+                          allWorkers,
+                          controller,
+                          parentJobId,
+                          onFinish,
+                          options));
+}
+
+ChunkStatsJob::ChunkStatsJob(std::string const& database,
+                             bool full,
+                             bool allWorkers,
+                             Controller::Ptr const& controller,
+                             std::string const& parentJobId,
+                             CallbackType const& onFinish,
+                             Job::Options const& options)
+    :   Job(controller,
+            parentJobId,
+            "CHUNK_STATS",
+            options),
+        _database(database),
+        _full(full),
+        _allWorkers(allWorkers),
+        _onFinish(onFinish),
+        _numLaunched(0),
+        _numFinished(0),
+        _numSuccess(0) {
+}
+
+ChunkStatsJobResult const& ChunkStatsJob::getStatsData() const {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "getStatsData");
+
+    if (state() == State::FINISHED) return _statsData;
+
+    throw std::logic_error(
+        "ChunkStatsJob::getStatsData  the method can't be called while the job hasn't finished");
+}
+
+std::list<std::pair<std::string,std::string>> ChunkStatsJob::extendedPersistentState() const {
+    std::list<std::pair<std::string,std::string>> result;
+    result.emplace_back("database",    database());
+    result.emplace_back("full",        full()       ? "1" : "0");
+    result.emplace_back("all_workers", allWorkers() ? "1" : "0");
+    return result;
+}
+
+void ChunkStatsJob::startImpl(util::Lock const& lock) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "startImpl");
+
+    auto self = shared_from_base<ChunkStatsJob>();
+
+    auto const config = controller()->serviceProvider()->config();
+    if (not config->isKnownDatabase(database())) {
+
+        LOGS(_log, LOG_LVL_ERROR, context() << "startImpl  unknown database: " << database());
+
+        setState(lock, State::FINISHED, ExtendedState::CONFIG_ERROR);
+        return;
+    }
+    auto const workerNames = allWorkers() ? config->allWorkers() : config->workers();
+
+    for (auto&& worker: workerNames) {
+
+        // The sizes of the tables modified in the same second as the start of
+        // the previous collection are reported again, since the modification
+        // times of the tables are only known to the second.
+        uint64_t updatedAfter = 0;
+        if (not full()) {
+            try {
+                updatedAfter = controller()->serviceProvider()->databaseServices()->chunkStatsCollectTime(
+                    worker,
+                    database()) / 1000;
+            } catch (database::mysql::Error const& ex) {
+
+                LOGS(_log, LOG_LVL_ERROR, context() << "startImpl  "
+                     << "failed to find the time of the previous collection at worker: " << worker
+                     << ", exception: " << ex.what());
+
+                setState(lock, State::FINISHED, ExtendedState::FAILED);
+                return;
+            }
+        }
+        _statsData.workers[worker] = false;
+        _collectTime[worker] = PerformanceUtils::now();
+        auto const request = controller()->serviceProvider()->qservMgtServices()->getChunkStats(
+            worker,
+            std::vector<std::string>{database()},
+            updatedAfter,
+            id(),
+            [self] (GetChunkStatsQservMgtRequest::Ptr const& request) {
+                self->onRequestFinish(request);
+            }
+        );
+        if (not request) {
+
+            LOGS(_log, LOG_LVL_ERROR, context() << "startImpl  "
+                 << "failed to submit GetChunkStatsQservMgtRequest to Qserv worker: " << worker);
+
+            setState(lock, State::FINISHED, ExtendedState::FAILED);
+            return;
+        }
+        _requests.push_back(request);
+        _numLaunched++;
+    }
+
+    // In case if no workers are present in the Configuration at this time.
+    if (not _numLaunched) setState(lock, State::FINISHED);
+    else                  setState(lock, State::IN_PROGRESS);
+}
+
+void ChunkStatsJob::cancelImpl(util::Lock const& lock) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "cancelImpl");
+
+    for (auto&& ptr: _requests) {
+        ptr->cancel();
+    }
+    _requests.clear();
+
+    _numLaunched = 0;
+    _numFinished = 0;
+    _numSuccess  = 0;
+}
+
+void ChunkStatsJob::notify(util::Lock const& lock) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "notify");
+
+    notifyDefaultImpl<ChunkStatsJob>(lock, _onFinish);
+}
+
+void ChunkStatsJob::onRequestFinish(GetChunkStatsQservMgtRequest::Ptr const& request) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context()
+         << "onRequestFinish  database=" << database()
+         << " worker=" << request->worker()
+         << " state=" << request->state2string());
+
+    // IMPORTANT: the final state is required to be tested twice. The first time
+    // it's done in order to avoid deadlock on the "in-flight" requests reporting
+    // their completion while the job termination is in a progress. And the second
+    // test is made after acquiring the lock to recheck the state in case if it
+    // has transitioned while acquiring the lock.
+
+    if (state() == State::FINISHED) return;
+
+    util::Lock lock(_mtx, context() + "onRequestFinish");
+
+    if (state() == State::FINISHED) return;
+
+    // Update counters and object state if needed.
+
+    _numFinished++;
+
+    if (request->extendedState() == QservMgtRequest::ExtendedState::SUCCESS) {
+
+        ChunkStatsCollection& stats = _statsData.stats[request->worker()];
+        for (auto&& entry: request->entries()) {
+            if (entry.db != database()) continue;
+            ChunkStats s;
+            s.worker          = request->worker();
+            s.database        = entry.db;
+            s.table           = entry.table;
+            s.chunk           = entry.chunk;
+            s.hasSize         = entry.hasSize;
+            s.numRows         = entry.numRows;
+            s.dataSize        = entry.dataSize;
+            s.indexSize       = entry.indexSize;
+            s.updateTime      = entry.updateTime;
+            s.tasksCompleted  = entry.tasksCompleted;
+            s.avgScanSeconds  = entry.avgSeconds;
+            s.lastScanSeconds = entry.lastSeconds;
+            s.collectTime     = _collectTime[request->worker()];
+            stats.push_back(s);
+        }
+
+        // The time of the collection is only saved along with its results,
+        // so that a failed collection is repeated in full the next time.
+        try {
+            controller()->serviceProvider()->databaseServices()->saveChunkStats(
+                request->worker(),
+                database(),
+                _collectTime[request->worker()],
+                stats);
+            _statsData.workers[request->worker()] = true;
+            _numSuccess++;
+        } catch (std::exception const& ex) {
+            LOGS(_log, LOG_LVL_ERROR, context() << "onRequestFinish  "
+                 << "failed to save the statistics of worker: " << request->worker()
+                 << ", exception: " << ex.what());
+        }
+    }
+
+    LOGS(_log, LOG_LVL_DEBUG, context()
+         << "onRequestFinish  database=" << database()
+         << " worker=" << request->worker()
+         << " _numLaunched=" << _numLaunched
+         << " _numFinished=" << _numFinished
+         << " _numSuccess=" << _numSuccess);
+
+    if (_numFinished == _numLaunched) {
+        finish(lock, _numSuccess == _numLaunched ? ExtendedState::SUCCESS :
+                                                   ExtendedState::FAILED);
+    }
+}
+
+}}} // namespace lsst::qserv::replica
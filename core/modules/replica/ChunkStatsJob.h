@@ -0,0 +1,221 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_REPLICA_CHUNKSTATSJOB_H
+#define LSST_QSERV_REPLICA_CHUNKSTATSJOB_H
+
+// System headers
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <string>
+
+// Qserv headers
+#include "replica/GetChunkStatsQservMgtRequest.h"
+#include "replica/Job.h"
+#include "replica/ReplicaInfo.h"
+
+// This header declarations
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+/**
+ * The structure ChunkStatsJobResult represents a combined result received
+ * from the Qserv worker management services upon a completion of the job.
+ */
+struct ChunkStatsJobResult {
+
+    /// Per-worker flags indicating if the corresponding statistics retrieval
+    /// request succeeded.
+    std::map<std::string, bool> workers;
+
+    /// The statistics reported by the workers, grouped by:
+    ///
+    ///   [worker]
+    std::map<std::string, ChunkStatsCollection> stats;
+};
+
+/**
+  * Class ChunkStatsJob collects the sizes of the chunk tables of a database
+  * at the Qserv workers, and the completion times of the tasks which scanned
+  * them, and saves them in the database of the Replication system.
+  *
+  * The collection is incremental: a worker is only asked for the sizes of
+  * the tables which were modified since the start of the previous collection
+  * from that worker. The completion times are kept by the workers in memory,
+  * they're always reported in full and cost little to compare.
+  */
+class ChunkStatsJob
+    :   public Job  {
+
+public:
+
+    /// The pointer type for instances of the class
+    typedef std::shared_ptr<ChunkStatsJob> Ptr;
+
+    /// The function type for notifications on the completion of the request
+    typedef std::function<void(Ptr)> CallbackType;
+
+    /// @return default options object for this type of a request
+    static Job::Options const& defaultOptions();
+
+    /// @return the unique name distinguishing this class from other types of jobs
+    static std::string typeName();
+
+    /**
+     * Static factory method is needed to prevent issue with the lifespan
+     * and memory management of instances created otherwise (as values or via
+     * low-level pointers).
+     *
+     * @param database    - the name of a database
+     * @param full        - collect the sizes of all tables rather than of the
+     *                      tables modified since the previous collection
+     * @param allWorkers  - engage all known workers regardless of their status
+     * @param controller  - for launching requests
+     * @param parentJobId - (optional) identifier of a parent job
+     * @param onFinish    - (optional) callback function to be called upon a job completion
+     * @param options     - (optional) job options
+     *
+     * @return pointer to the created object
+     */
+    static Ptr create(std::string const& database,
+                      bool full,
+                      bool allWorkers,
+                      Controller::Ptr const& controller,
+                      std::string const& parentJobId,
+                      CallbackType const& onFinish,
+                      Job::Options const& options=defaultOptions());
+
+    // Default construction and copy semantics are prohibited
+
+    ChunkStatsJob() = delete;
+    ChunkStatsJob(ChunkStatsJob const&) = delete;
+    ChunkStatsJob& operator=(ChunkStatsJob const&) = delete;
+
+    ~ChunkStatsJob() final = default;
+
+    /// @return the name of a database defining a scope of the operation
+    std::string const& database() const { return _database; }
+
+    /// @return 'true' if the sizes of all tables are collected
+    bool full() const { return _full; }
+
+    /// @return 'true' if all known workers were engaged
+    bool allWorkers() const { return _allWorkers; }
+
+    /**
+     * @return the result of the operation (when the job finishes)
+     *
+     * IMPORTANT NOTES:
+     * - the method should be invoked only after the job has finished (primary
+     *   status is set to Job::Status::FINISHED). Otherwise exception
+     *   std::logic_error will be thrown
+     *
+     * - the result will be extracted from requests which have successfully
+     *   finished. Please, verify the primary and extended status of the object
+     *   to ensure that all requests have finished.
+     *
+     * @throws std::logic_error - if the job didn't finished at a time
+     *         when the method was called
+     */
+    ChunkStatsJobResult const& getStatsData() const;
+
+    /**
+     * @see Job::extendedPersistentState()
+     */
+    std::list<std::pair<std::string,std::string>> extendedPersistentState() const override;
+
+protected:
+
+    /**
+     * Construct the job with the pointer to the services provider.
+     *
+     * @see ChunkStatsJob::create()
+     */
+    ChunkStatsJob(std::string const& database,
+                  bool full,
+                  bool allWorkers,
+                  Controller::Ptr const& controller,
+                  std::string const& parentJobId,
+                  CallbackType const& onFinish,
+                  Job::Options const& options);
+
+    /**
+      * @see Job::startImpl()
+      */
+    void startImpl(util::Lock const& lock) final;
+
+    /**
+      * @see Job::startImpl()
+      */
+    void cancelImpl(util::Lock const& lock) final;
+
+    /**
+      * @see Job::notify()
+      */
+    void notify(util::Lock const& lock) final;
+
+    /**
+     * The callback function to be invoked on a completion of each request.
+     *
+     * @param request - a pointer to a request
+     */
+    void onRequestFinish(GetChunkStatsQservMgtRequest::Ptr const& request);
+
+protected:
+
+    /// The name of the database
+    std::string const _database;
+
+    /// The flag (if 'true') for collecting the sizes of all tables
+    bool const _full;
+
+    /// The flag (if 'true') for engaging all known workers regardless of their status
+    bool const _allWorkers;
+
+    /// Client-defined function to be called upon the completion of the job
+    CallbackType _onFinish;
+
+    /// A collection of requests implementing the operation
+    std::list<GetChunkStatsQservMgtRequest::Ptr> _requests;
+
+    /// The start times (milliseconds) of the collections, by worker
+    std::map<std::string, uint64_t> _collectTime;
+
+    // The counter of requests which will be updated. They need to be atomic
+    // to avoid race condition between the onFinish() callbacks executed within
+    // the Controller's thread and this thread.
+
+    std::atomic<size_t> _numLaunched;   ///< the total number of requests launched
+    std::atomic<size_t> _numFinished;   ///< the total number of finished requests
+    std::atomic<size_t> _numSuccess;    ///< the number of successfully completed requests
+
+    /// The result of the operation (gets updated as requests are finishing)
+    ChunkStatsJobResult _statsData;
+};
+
+}}} // namespace lsst::qserv::replica
+
+#endif // LSST_QSERV_REPLICA_CHUNKSTATSJOB_H
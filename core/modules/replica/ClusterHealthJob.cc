@@ -30,6 +30,7 @@
 // Qserv headers
 #include "lsst/log/Log.h"
 #include "replica/Controller.h"
+#include "replica/HeartbeatMonitor.h"
 #include "replica/QservMgtServices.h"
 #include "replica/ServiceProvider.h"
 
@@ -168,19 +169,26 @@ void ClusterHealthJob::startImpl(util::Lock const& lock) {
         ? controller()->serviceProvider()->config()->allWorkers()
         : controller()->serviceProvider()->config()->workers();
 
-    for (auto const& worker: workers) {
+    // The Replication services which recently sent heartbeats aren't probed
 
-        auto const replicationRequest = controller()->statusOfWorkerService(
-            worker,
-            [self] (ServiceStatusRequest::Ptr request) {
-                self->onRequestFinish(request);
-            },
-            id(),   /* jobId */
-            timeoutSec()
-        );
-        _requests[replicationRequest->id()] = replicationRequest;
-        ++_numStarted;
+    auto const heartbeatMonitor = controller()->heartbeatMonitor();
 
+    for (auto const& worker: workers) {
+
+        if (heartbeatMonitor->alive(worker)) {
+            _health.updateReplicationState(worker, true);
+        } else {
+            auto const replicationRequest = controller()->statusOfWorkerService(
+                worker,
+                [self] (ServiceStatusRequest::Ptr request) {
+                    self->onRequestFinish(request);
+                },
+                id(),   /* jobId */
+                timeoutSec()
+            );
+            _requests[replicationRequest->id()] = replicationRequest;
+            ++_numStarted;
+        }
         auto const qservRequest = controller()->serviceProvider()->qservMgtServices()->echo(
             worker,
             testData,
@@ -190,7 +198,7 @@ void ClusterHealthJob::startImpl(util::Lock const& lock) {
             },
             timeoutSec()
         );
-        _qservRequests[replicationRequest->id()] = qservRequest;
+        _qservRequests[qservRequest->id()] = qservRequest;
         ++_numStarted;
     }
     
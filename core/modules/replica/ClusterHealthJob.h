@@ -114,7 +114,9 @@ private:
 /**
   * Class ClusterHealthJob represents a tool which will send probes to the Replication
   * worker services and Qserv (if enabled) services of all worker nodes. Upon its
-  * completion the job will report a status of each service.
+  * completion the job will report a status of each service. The Replication
+  * services which recently sent heartbeats to the Controller's HeartbeatMonitor
+  * are reported as up without sending them probes.
   *
   * The job is implemented not to have any side effects on either class of services.
   */
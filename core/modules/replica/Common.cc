@@ -64,6 +64,8 @@ std::string status2string(ExtendedCompletionStatus status) {
         case ExtendedCompletionStatus::EXT_STATUS_NO_ACCESS:        return "EXT_STATUS_NO_ACCESS";
         case ExtendedCompletionStatus::EXT_STATUS_NO_SPACE:         return "EXT_STATUS_NO_SPACE";
         case ExtendedCompletionStatus::EXT_STATUS_FILE_MTIME:       return "EXT_STATUS_FILE_MTIME";
+        case ExtendedCompletionStatus::EXT_STATUS_MYSQL_ERROR:      return "EXT_STATUS_MYSQL_ERROR";
+        case ExtendedCompletionStatus::EXT_STATUS_TOOL_ERROR:       return "EXT_STATUS_TOOL_ERROR";
     }
     throw std::logic_error(
                     "Common::status2string(ExtendedCompletionStatus) - unhandled status: " +
@@ -96,6 +98,8 @@ ExtendedCompletionStatus translate(proto::ReplicationStatusExt status) {
         case proto::ReplicationStatusExt::NO_ACCESS:        return ExtendedCompletionStatus::EXT_STATUS_NO_ACCESS;
         case proto::ReplicationStatusExt::NO_SPACE:         return ExtendedCompletionStatus::EXT_STATUS_NO_SPACE;
         case proto::ReplicationStatusExt::FILE_MTIME:       return ExtendedCompletionStatus::EXT_STATUS_FILE_MTIME;
+        case proto::ReplicationStatusExt::MYSQL_ERROR:      return ExtendedCompletionStatus::EXT_STATUS_MYSQL_ERROR;
+        case proto::ReplicationStatusExt::TOOL_ERROR:       return ExtendedCompletionStatus::EXT_STATUS_TOOL_ERROR;
     }
     throw std::logic_error(
                     "Common::translate(proto::ReplicationStatusExt) - unhandled status: " +
@@ -128,6 +132,8 @@ proto::ReplicationStatusExt translate(ExtendedCompletionStatus status) {
         case ExtendedCompletionStatus::EXT_STATUS_NO_ACCESS:        return proto::ReplicationStatusExt::NO_ACCESS;
         case ExtendedCompletionStatus::EXT_STATUS_NO_SPACE:         return proto::ReplicationStatusExt::NO_SPACE;
         case ExtendedCompletionStatus::EXT_STATUS_FILE_MTIME:       return proto::ReplicationStatusExt::FILE_MTIME;
+        case ExtendedCompletionStatus::EXT_STATUS_MYSQL_ERROR:      return proto::ReplicationStatusExt::MYSQL_ERROR;
+        case ExtendedCompletionStatus::EXT_STATUS_TOOL_ERROR:       return proto::ReplicationStatusExt::TOOL_ERROR;
     }
     throw std::logic_error(
                     "Common::translate(ExtendedCompletionStatus) - unhandled status: " +
@@ -170,7 +176,9 @@ DeleteRequestParams::DeleteRequestParams()
 DeleteRequestParams::DeleteRequestParams(proto::ReplicationRequestDelete const& message)
     :   priority(message.priority()),
         database(message.database()),
-        chunk(message.chunk()) {
+        chunk(message.chunk()),
+        extraChunks(message.extra_chunks().begin(),
+                    message.extra_chunks().end()) {
 }
 
 FindRequestParams::FindRequestParams()
@@ -204,5 +212,53 @@ EchoRequestParams::EchoRequestParams(proto::ReplicationRequestEcho const& messag
         delay(message.delay()) {
 }
 
+IngestRequestParams::IngestRequestParams()
+    :   priority(0),
+        chunk(0),
+        numLoads(0),
+        clusterSubChunks(false) {
+}
+
+IngestRequestParams::IngestRequestParams(proto::ReplicationRequestIngest const& message)
+    :   priority(message.priority()),
+        database(message.database()),
+        chunk(message.chunk()),
+        sourceWorker(message.worker()),
+        numLoads(message.num_loads()),
+        clusterSubChunks(message.cluster_subchunks()) {
+
+    for (int i = 0; i < message.files_size(); ++i) {
+        auto&& file = message.files(i);
+        IngestFileInfo info;
+        info.file    = file.file();
+        info.table   = file.table();
+        info.overlap = file.overlap();
+        files.push_back(info);
+    }
+}
+
+IndexRequestParams::IndexRequestParams()
+    :   priority(0) {
+}
+
+IndexRequestParams::IndexRequestParams(proto::ReplicationRequestIndex const& message)
+    :   priority(message.priority()),
+        database(message.database()),
+        table(message.table()),
+        keyColumn(message.key_column()),
+        chunks(message.chunks().begin(), message.chunks().end()) {
+}
+
+PackRequestParams::PackRequestParams()
+    :   priority(0),
+        chunk(0) {
+}
+
+PackRequestParams::PackRequestParams(proto::ReplicationRequestPack const& message)
+    :   priority(message.priority()),
+        database(message.database()),
+        chunk(message.chunk()) {
+}
+
 
 }}} // namespace lsst::qserv::replica
@@ -31,6 +31,7 @@
 
 // System headers
 #include <string>
+#include <vector>
 
 // Qserv headers
 #include "proto/replication.pb.h"
@@ -72,7 +73,9 @@ enum ExtendedCompletionStatus {
     EXT_STATUS_NO_FILE,         // file doesn't exist
     EXT_STATUS_NO_ACCESS,       // no access to a file or a folder
     EXT_STATUS_NO_SPACE,        // no space left on a device as required by an operation
-    EXT_STATUS_FILE_MTIME       // get/set 'mtime' operation failed
+    EXT_STATUS_FILE_MTIME,      // get/set 'mtime' operation failed
+    EXT_STATUS_MYSQL_ERROR,     // a query to the MySQL server failed
+    EXT_STATUS_TOOL_ERROR       // an external tool run by a request failed
 };
 
 /// Return the string representation of the extended status
@@ -131,6 +134,9 @@ struct DeleteRequestParams {
     unsigned int chunk;
     std::string  sourceWorker;
 
+    /// More chunks of the same database deleted by the request
+    std::vector<unsigned int> extraChunks;
+
     /// The default constructor
     DeleteRequestParams();
 
@@ -188,6 +194,86 @@ struct EchoRequestParams {
     explicit EchoRequestParams(proto::ReplicationRequestEcho const& message);
 };
 
+/**
+ * Structure IngestFileInfo represents a contribution to be loaded into
+ * a table of a chunk by the ingest requests.
+ */
+struct IngestFileInfo {
+
+    /// The name of a file in the database folder of the source worker
+    std::string file;
+
+    /// The base name of a partitioned table (w/o the chunk number)
+    std::string table;
+
+    /// The file is loaded into the overlap table of the chunk
+    bool overlap = false;
+};
+
+/**
+ * Structure IngestRequestParams represents parameters of the chunk
+ * ingest requests.
+ */
+struct IngestRequestParams {
+
+    int          priority;
+    std::string  database;
+    unsigned int chunk;
+    std::string  sourceWorker;
+
+    std::vector<IngestFileInfo> files;
+
+    /// The number of files loaded at the same time (0 means the default
+    /// of the worker)
+    unsigned int numLoads;
+
+    /// Cluster the rows of the tables by subchunk after loading
+    bool clusterSubChunks;
+
+    /// The default constructor
+    IngestRequestParams();
+
+    /// The normal constructor
+    explicit IngestRequestParams(proto::ReplicationRequestIngest const& message);
+};
+
+/**
+ * Structure IndexRequestParams represents parameters of the secondary
+ * index requests.
+ */
+struct IndexRequestParams {
+
+    int          priority;
+    std::string  database;
+    std::string  table;
+    std::string  keyColumn;
+
+    std::vector<unsigned int> chunks;
+
+    /// The default constructor
+    IndexRequestParams();
+
+    /// The normal constructor
+    explicit IndexRequestParams(proto::ReplicationRequestIndex const& message);
+};
+
+/**
+ * Structure PackRequestParams represents parameters of the requests
+ * packing the tables of chunks.
+ */
+struct PackRequestParams {
+
+    int          priority;
+    std::string  database;
+    unsigned int chunk;
+
+    /// The default constructor
+    PackRequestParams();
+
+    /// The normal constructor
+    explicit PackRequestParams(proto::ReplicationRequestPack const& message);
+};
+
 }}} // namespace lsst::qserv::replica
 
 #endif // LSST_QSERV_REPLICA_COMMON_H
@@ -260,6 +260,12 @@ ConfigApp::ConfigApp(int argc, char* argv[])
     ::addCommandOption(updateGeneralCmd, _workerNumProcessingThreads);
     ::addCommandOption(updateGeneralCmd, _fsNumProcessingThreads);
     ::addCommandOption(updateGeneralCmd, _workerFsBufferSizeBytes);
+    ::addCommandOption(updateGeneralCmd, _workerFsMaxStreams);
+    ::addCommandOption(updateGeneralCmd, _workerFsIoDepth);
+    ::addCommandOption(updateGeneralCmd, _workerFsMaxRateBytesPerSec);
+    ::addCommandOption(updateGeneralCmd, _workerFsCompressionLevel);
+    ::addCommandOption(updateGeneralCmd, _workerNumIngestLoads);
+    ::addCommandOption(updateGeneralCmd, _workerIngestDatabase);
 
     // Command-specific parameters, options and flags
 
@@ -511,6 +517,30 @@ void ConfigApp::_dumpGeneralAsTable(string const& indent) const {
     value.      push_back(to_string(_config->workerFsBufferSizeBytes()));
     description.push_back(                  _workerFsBufferSizeBytes.description);
 
+    parameter.  push_back(                  _workerFsMaxStreams.key);
+    value.      push_back(to_string(_config->workerFsMaxStreams()));
+    description.push_back(                  _workerFsMaxStreams.description);
+
+    parameter.  push_back(                  _workerFsIoDepth.key);
+    value.      push_back(to_string(_config->workerFsIoDepth()));
+    description.push_back(                  _workerFsIoDepth.description);
+
+    parameter.  push_back(                  _workerFsMaxRateBytesPerSec.key);
+    value.      push_back(to_string(_config->workerFsMaxRateBytesPerSec()));
+    description.push_back(                  _workerFsMaxRateBytesPerSec.description);
+
+    parameter.  push_back(                  _workerFsCompressionLevel.key);
+    value.      push_back(to_string(_config->workerFsCompressionLevel()));
+    description.push_back(                  _workerFsCompressionLevel.description);
+
+    parameter.  push_back(                  _workerNumIngestLoads.key);
+    value.      push_back(to_string(_config->workerNumIngestLoads()));
+    description.push_back(                  _workerNumIngestLoads.description);
+
+    parameter.  push_back(        _workerIngestDatabase.key);
+    value.      push_back(_config->workerIngestDatabase());
+    description.push_back(        _workerIngestDatabase.description);
+
     util::ColumnTablePrinter table("GENERAL PARAMETERS:", indent, _verticalSeparator);
 
     table.addColumn("parameter",   parameter,   util::ColumnTablePrinter::Alignment::LEFT);
@@ -669,6 +699,12 @@ int ConfigApp::_updateGeneral() {
         _workerNumProcessingThreads .save(_config);
         _fsNumProcessingThreads     .save(_config);
         _workerFsBufferSizeBytes    .save(_config);
+        _workerFsMaxStreams         .save(_config);
+        _workerFsIoDepth            .save(_config);
+        _workerFsMaxRateBytesPerSec .save(_config);
+        _workerFsCompressionLevel   .save(_config);
+        _workerNumIngestLoads       .save(_config);
+        _workerIngestDatabase       .save(_config);
     } catch (std::exception const& ex) {
         LOGS(_log, LOG_LVL_ERROR, context << "operation failed, exception: " << ex.what());
         return 1;
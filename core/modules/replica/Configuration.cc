@@ -126,6 +126,12 @@ std::string  const Configuration::defaultWorkerTechnology             ("TEST");
 size_t       const Configuration::defaultWorkerNumProcessingThreads   (1);
 size_t       const Configuration::defaultFsNumProcessingThreads       (1);
 size_t       const Configuration::defaultWorkerFsBufferSizeBytes      (1048576);
+size_t       const Configuration::defaultWorkerFsMaxStreams           (4);
+size_t       const Configuration::defaultWorkerFsIoDepth              (4);
+size_t       const Configuration::defaultWorkerFsMaxRateBytesPerSec   (0);
+size_t       const Configuration::defaultWorkerFsCompressionLevel     (0);
+size_t       const Configuration::defaultWorkerNumIngestLoads         (4);
+std::string  const Configuration::defaultWorkerIngestDatabase         ("mysql://qsmaster@localhost:3306/qservw_worker");
 std::string  const Configuration::defaultWorkerSvcHost                ("localhost");
 uint16_t     const Configuration::defaultWorkerSvcPort                (50000);
 std::string  const Configuration::defaultWorkerFsHost                 ("localhost");
@@ -182,13 +188,20 @@ Configuration::Configuration()
         _workerNumProcessingThreads (defaultWorkerNumProcessingThreads),
         _fsNumProcessingThreads     (defaultFsNumProcessingThreads),
         _workerFsBufferSizeBytes    (defaultWorkerFsBufferSizeBytes),
+        _workerFsMaxStreams         (defaultWorkerFsMaxStreams),
+        _workerFsIoDepth            (defaultWorkerFsIoDepth),
+        _workerFsMaxRateBytesPerSec (defaultWorkerFsMaxRateBytesPerSec),
+        _workerFsCompressionLevel   (defaultWorkerFsCompressionLevel),
+        _workerNumIngestLoads       (defaultWorkerNumIngestLoads),
+        _workerIngestDatabase       (defaultWorkerIngestDatabase),
         _databaseTechnology         (defaultDatabaseTechnology),
         _databaseHost               (defaultDatabaseHost),
         _databasePort               (defaultDatabasePort),
         _databaseUser               (defaultDatabaseUser),
         _databasePassword           (defaultDatabasePassword),
         _databaseName               (defaultDatabaseName),
-        _databaseServicesPoolSize   (defaultDatabaseServicesPoolSize) {
+        _databaseServicesPoolSize   (defaultDatabaseServicesPoolSize),
+        _snapshot(std::make_shared<Snapshot>()) {
 }
 
 std::string Configuration::context() const {
@@ -199,10 +212,10 @@ std::string Configuration::context() const {
 std::vector<std::string> Configuration::workers(bool isEnabled,
                                                 bool isReadOnly) const {
 
-    util::Lock lock(_mtx, context() + "workers");
+    auto const snapshot = this->snapshot();
 
     std::vector<std::string> names;
-    for (auto&& entry: _workerInfo) {
+    for (auto&& entry: snapshot->workerInfo) {
         auto const& name = entry.first;
         auto const& info = entry.second;
         if (isEnabled) {
@@ -220,9 +233,9 @@ std::vector<std::string> Configuration::workers(bool isEnabled,
 
 
 std::vector<std::string> Configuration::allWorkers() const {
-    util::Lock lock(_mtx, context() + "allWorkers");
+    auto const snapshot = this->snapshot();
     std::vector<std::string> names;
-    for (auto&& entry: _workerInfo) {
+    for (auto&& entry: snapshot->workerInfo) {
         auto const& name = entry.first;
         names.push_back(name);
     }
@@ -232,10 +245,10 @@ std::vector<std::string> Configuration::allWorkers() const {
 
 std::vector<std::string> Configuration::databaseFamilies() const {
 
-    util::Lock lock(_mtx, context() + "databaseFamilies");
+    auto const snapshot = this->snapshot();
 
     std::vector<std::string> families;
-    for (auto&& itr: _databaseFamilyInfo) {
+    for (auto&& itr: snapshot->databaseFamilyInfo) {
         families.push_back(itr.first);
     }
     return families;
@@ -243,17 +256,17 @@ std::vector<std::string> Configuration::databaseFamilies() const {
 
 bool Configuration::isKnownDatabaseFamily(std::string const& name) const {
 
-    util::Lock lock(_mtx, context() + "isKnownDatabaseFamily");
+    auto const snapshot = this->snapshot();
 
-    return _databaseFamilyInfo.count(name);
+    return snapshot->databaseFamilyInfo.count(name);
 }
 
 size_t Configuration::replicationLevel(std::string const& family) const {
 
-    util::Lock lock(_mtx, context() + "databaseFamilies");
+    auto const snapshot = this->snapshot();
 
-    auto const itr = _databaseFamilyInfo.find(family);
-    if (itr == _databaseFamilyInfo.end()) {
+    auto const itr = snapshot->databaseFamilyInfo.find(family);
+    if (itr == snapshot->databaseFamilyInfo.end()) {
         throw std::invalid_argument(
                 "Configuration::replicationLevel  unknown database family: '" +
                 family + "'");
@@ -263,10 +276,10 @@ size_t Configuration::replicationLevel(std::string const& family) const {
 
 DatabaseFamilyInfo Configuration::databaseFamilyInfo(std::string const& name) const {
 
-    util::Lock lock(_mtx, context() + "databaseFamilyInfo");
+    auto const snapshot = this->snapshot();
 
-    auto&& itr = _databaseFamilyInfo.find(name);
-    if (itr == _databaseFamilyInfo.end()) {
+    auto&& itr = snapshot->databaseFamilyInfo.find(name);
+    if (itr == snapshot->databaseFamilyInfo.end()) {
         throw std::invalid_argument(
                 "Configuration::databaseFamilyInfo  unknown database family: '" + name + "'");
     }
@@ -275,15 +288,15 @@ DatabaseFamilyInfo Configuration::databaseFamilyInfo(std::string const& name) co
 
 std::vector<std::string> Configuration::databases(std::string const& family) const {
 
-    util::Lock lock(_mtx, context() + "databases(family)");
+    auto const snapshot = this->snapshot();
 
-    if (not family.empty() and not _databaseFamilyInfo.count(family)) {
+    if (not family.empty() and not snapshot->databaseFamilyInfo.count(family)) {
         throw std::invalid_argument(
                 "Configuration::databases  unknown database family: '" +
                 family + "'");
     }
     std::vector<std::string> names;
-    for (auto&& entry: _databaseInfo) {
+    for (auto&& entry: snapshot->databaseInfo) {
         if (not family.empty() and (family != entry.second.family)) {
             continue;
         }
@@ -294,17 +307,17 @@ std::vector<std::string> Configuration::databases(std::string const& family) con
 
 bool Configuration::isKnownWorker(std::string const& name) const {
 
-    util::Lock lock(_mtx, context() + "isKnownWorker");
+    auto const snapshot = this->snapshot();
 
-    return _workerInfo.count(name) > 0;
+    return snapshot->workerInfo.count(name) > 0;
 }
 
 WorkerInfo Configuration::workerInfo(std::string const& name) const {
 
-    util::Lock lock(_mtx, context() + "workerInfo");
+    auto const snapshot = this->snapshot();
 
-    auto const itr = _workerInfo.find(name);
-    if (itr == _workerInfo.end()) {
+    auto const itr = snapshot->workerInfo.find(name);
+    if (itr == snapshot->workerInfo.end()) {
         throw std::invalid_argument(
                 "Configuration::workerInfo() unknown worker: '" + name + "'");
     }
@@ -313,17 +326,17 @@ WorkerInfo Configuration::workerInfo(std::string const& name) const {
 
 bool Configuration::isKnownDatabase(std::string const& name) const {
 
-    util::Lock lock(_mtx, context() + "isKnownDatabase");
+    auto const snapshot = this->snapshot();
 
-    return _databaseInfo.count(name) > 0;
+    return snapshot->databaseInfo.count(name) > 0;
 }
 
 DatabaseInfo Configuration::databaseInfo(std::string const& name) const {
 
-    util::Lock lock(_mtx, context() + "databaseInfo");
+    auto const snapshot = this->snapshot();
 
-    auto&& itr = _databaseInfo.find(name);
-    if (itr == _databaseInfo.end()) {
+    auto&& itr = snapshot->databaseInfo.find(name);
+    if (itr == snapshot->databaseInfo.end()) {
         throw std::invalid_argument(
                 "Configuration::databaseInfo() unknown database: '" + name + "'");
     }
@@ -385,6 +398,12 @@ std::string Configuration::asString() const {
     ss << context() << "defaultWorkerNumProcessingThreads:    " << defaultWorkerNumProcessingThreads << "\n";
     ss << context() << "defaultFsNumProcessingThreads:        " << defaultFsNumProcessingThreads << "\n";
     ss << context() << "defaultWorkerFsBufferSizeBytes:       " << defaultWorkerFsBufferSizeBytes << "\n";
+    ss << context() << "defaultWorkerFsMaxStreams:            " << defaultWorkerFsMaxStreams << "\n";
+    ss << context() << "defaultWorkerFsIoDepth:               " << defaultWorkerFsIoDepth << "\n";
+    ss << context() << "defaultWorkerFsMaxRateBytesPerSec:    " << defaultWorkerFsMaxRateBytesPerSec << "\n";
+    ss << context() << "defaultWorkerFsCompressionLevel:      " << defaultWorkerFsCompressionLevel << "\n";
+    ss << context() << "defaultWorkerNumIngestLoads:          " << defaultWorkerNumIngestLoads << "\n";
+    ss << context() << "defaultWorkerIngestDatabase:          " << defaultWorkerIngestDatabase << "\n";
     ss << context() << "defaultWorkerSvcHost:                 " << defaultWorkerSvcHost << "\n";
     ss << context() << "defaultWorkerSvcPort:                 " << defaultWorkerSvcPort << "\n";
     ss << context() << "defaultWorkerFsHost:                  " << defaultWorkerFsHost << "\n";
@@ -420,6 +439,12 @@ std::string Configuration::asString() const {
     ss << context() << "_workerNumProcessingThreads:          " << _workerNumProcessingThreads << "\n";
     ss << context() << "_fsNumProcessingThreads:              " << _fsNumProcessingThreads << "\n";
     ss << context() << "_workerFsBufferSizeBytes:             " << _workerFsBufferSizeBytes << "\n";
+    ss << context() << "_workerFsMaxStreams:                  " << _workerFsMaxStreams << "\n";
+    ss << context() << "_workerFsIoDepth:                     " << _workerFsIoDepth << "\n";
+    ss << context() << "_workerFsMaxRateBytesPerSec:          " << _workerFsMaxRateBytesPerSec << "\n";
+    ss << context() << "_workerFsCompressionLevel:            " << _workerFsCompressionLevel << "\n";
+    ss << context() << "_workerNumIngestLoads:                " << _workerNumIngestLoads << "\n";
+    ss << context() << "_workerIngestDatabase:                " << _workerIngestDatabase << "\n";
     ss << context() << "_databaseTechnology:                  " << _databaseTechnology << "\n";
     ss << context() << "_databaseHost:                        " << _databaseHost << "\n";
     ss << context() << "_databasePort:                        " << _databasePort << "\n";
@@ -440,6 +465,13 @@ std::string Configuration::asString() const {
     return ss.str();
 }
 
+void Configuration::publish(util::Lock const& lock) {
+    std::atomic_store(&_snapshot,
+                      std::shared_ptr<Snapshot const>(
+                          std::make_shared<Snapshot>(
+                              Snapshot{_databaseFamilyInfo, _databaseInfo, _workerInfo})));
+}
+
 std::map<std::string, WorkerInfo>::iterator Configuration::safeFindWorker(util::Lock const& lock,
                                                                           std::string const& name,
                                                                           std::string const& context) {
@@ -109,6 +109,12 @@ std::string ConfigurationFile::dump2init(Configuration::Ptr const& config) {
         << "num_svc_processing_threads = " << to_string(config->workerNumProcessingThreads()) << "\n"
         << "num_fs_processing_threads  = " << to_string(config->fsNumProcessingThreads())     << "\n"
         << "fs_buf_size_bytes          = " << to_string(config->workerFsBufferSizeBytes())    << "\n"
+        << "fs_max_streams             = " << to_string(config->workerFsMaxStreams())         << "\n"
+        << "fs_io_depth                = " << to_string(config->workerFsIoDepth())            << "\n"
+        << "fs_max_rate_bytes_per_sec  = " << to_string(config->workerFsMaxRateBytesPerSec()) << "\n"
+        << "fs_compression_level       = " << to_string(config->workerFsCompressionLevel())   << "\n"
+        << "num_ingest_loads           = " << to_string(config->workerNumIngestLoads())       << "\n"
+        << "ingest_db                  = " <<           config->workerIngestDatabase()        << "\n"
         << "\n";
 
     for (auto&& worker: config->allWorkers()) {
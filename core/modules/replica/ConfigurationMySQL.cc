@@ -77,6 +77,43 @@ void readOptionalParameter(database::mysql::Row& row,
     }
 }
 
+/**
+ * Read the version of the configuration from table 'config'
+ *
+ * @return the version, or 0 if the configuration was never modified
+ *   by the Configuration service
+ */
+uint64_t readVersion(database::mysql::Connection::Ptr const& conn) {
+
+    conn->execute(
+        "SELECT " + conn->sqlId("value") + " FROM " + conn->sqlId("config") +
+        " WHERE " + conn->sqlEqual("category", "common") +
+        "   AND " + conn->sqlEqual("param",    "version"));
+
+    uint64_t version = 0;
+    database::mysql::Row row;
+    while (conn->next(row)) {
+        ::readMandatoryParameter(row, "value", version);
+    }
+    return version;
+}
+
+/**
+ * Increment the version of the configuration within the current transaction.
+ * Other processes use the version to find out if they need to reload
+ * the configuration.
+ *
+ * @return the new version
+ */
+uint64_t bumpVersion(database::mysql::Connection::Ptr const& conn) {
+
+    conn->execute(
+        "INSERT INTO " + conn->sqlId("config") + " VALUES ('common','version','1')"
+        " ON DUPLICATE KEY UPDATE " + conn->sqlId("value") + "=" + conn->sqlId("value") + "+1");
+
+    return readVersion(conn);
+}
+
 template<class T>
 void configInsert(std::ostream& os,
                   std::string const& category,
@@ -119,6 +156,12 @@ std::string ConfigurationMySQL::dump2init(Configuration::Ptr const& config) {
     ::configInsert(str, "worker",     "num_svc_processing_threads", config->workerNumProcessingThreads());
     ::configInsert(str, "worker",     "num_fs_processing_threads",  config->fsNumProcessingThreads());
     ::configInsert(str, "worker",     "fs_buf_size_bytes",          config->workerFsBufferSizeBytes());
+    ::configInsert(str, "worker",     "fs_max_streams",             config->workerFsMaxStreams());
+    ::configInsert(str, "worker",     "fs_io_depth",                config->workerFsIoDepth());
+    ::configInsert(str, "worker",     "fs_max_rate_bytes_per_sec",  config->workerFsMaxRateBytesPerSec());
+    ::configInsert(str, "worker",     "fs_compression_level",       config->workerFsCompressionLevel());
+    ::configInsert(str, "worker",     "num_ingest_loads",           config->workerNumIngestLoads());
+    ::configInsert(str, "worker",     "ingest_db",                  config->workerIngestDatabase());
 
     for (auto&& worker: config->allWorkers()) {
         auto&& info = config->workerInfo(worker);
@@ -166,6 +209,7 @@ std::string ConfigurationMySQL::dump2init(Configuration::Ptr const& config) {
 ConfigurationMySQL::ConfigurationMySQL(database::mysql::ConnectionParams const& connectionParams)
     :   Configuration(),
         _connectionParams(connectionParams),
+        _version(0),
         _log(LOG_GET("lsst.qserv.replica.ConfigurationMySQL")) {
 
     loadConfiguration();
@@ -194,9 +238,10 @@ void ConfigurationMySQL::addWorker(WorkerInfo const& info) {
 
         // First update the database
 
+        uint64_t version = 0;
         handler.conn = database::mysql::Connection::open(_connectionParams);
         handler.conn->execute(
-            [&info](decltype(handler.conn) conn) {
+            [&info,&version](decltype(handler.conn) conn) {
                 conn->begin();
                 conn->executeInsertQuery(
                     "config_worker",
@@ -209,6 +254,7 @@ void ConfigurationMySQL::addWorker(WorkerInfo const& info) {
                      info.fsPort,
                      info.dataDir
                 );
+                version = ::bumpVersion(conn);
                 conn->commit();
             }
         );
@@ -218,6 +264,8 @@ void ConfigurationMySQL::addWorker(WorkerInfo const& info) {
         util::Lock lock(_mtx, context_);
 
         _workerInfo[info.name] = info;
+        _noteVersion(lock, version);
+        publish(lock);
 
     } catch (database::mysql::Error const& ex) {
         LOGS(_log, LOG_LVL_ERROR, context_ << ex.what());
@@ -237,11 +285,13 @@ void ConfigurationMySQL::deleteWorker(std::string const& name) {
 
         // First update the database
 
+        uint64_t version = 0;
         handler.conn = database::mysql::Connection::open(_connectionParams);
         handler.conn->execute(
-            [&name](decltype(handler.conn) conn) {
+            [&name,&version](decltype(handler.conn) conn) {
                 conn->begin();
                 conn->execute("DELETE FROM config_worker WHERE " + conn->sqlEqual("name", name));
+                version = ::bumpVersion(conn);
                 conn->commit();
             }
         );
@@ -252,6 +302,8 @@ void ConfigurationMySQL::deleteWorker(std::string const& name) {
 
         auto itr = safeFindWorker(lock, name, context_);
         _workerInfo.erase(itr);
+        _noteVersion(lock, version);
+        publish(lock);
 
     } catch (database::mysql::Error const& ex) {
         LOGS(_log, LOG_LVL_ERROR, context_ << ex.what());
@@ -273,14 +325,16 @@ WorkerInfo ConfigurationMySQL::disableWorker(std::string const& name,
 
         // First update the database state
 
+        uint64_t version = 0;
         handler.conn = database::mysql::Connection::open(_connectionParams);
         handler.conn->execute(
-            [&name,disable](decltype(handler.conn) conn) {
+            [&name,disable,&version](decltype(handler.conn) conn) {
                 conn->begin();
                 conn->executeSimpleUpdateQuery(
                     "config_worker",
                     conn->sqlEqual("name", name),
                     std::make_pair("is_enabled", disable ? 0 : 1));
+                version = ::bumpVersion(conn);
                 conn->commit();
             }
         );
@@ -291,6 +345,8 @@ WorkerInfo ConfigurationMySQL::disableWorker(std::string const& name,
 
         auto itr = safeFindWorker(lock, name, context_);
         itr->second.isEnabled = not disable;
+        _noteVersion(lock, version);
+        publish(lock);
 
     } catch (database::mysql::Error const& ex) {
         LOGS(_log, LOG_LVL_ERROR, context_ << "MySQL error: " << ex.what());
@@ -313,14 +369,16 @@ WorkerInfo ConfigurationMySQL::setWorkerReadOnly(std::string const& name,
 
         // First update the database state
 
+        uint64_t version = 0;
         handler.conn = database::mysql::Connection::open(_connectionParams);
         handler.conn->execute(
-            [&name,readOnly](decltype(handler.conn) conn) {
+            [&name,readOnly,&version](decltype(handler.conn) conn) {
                 conn->begin();
                 conn->executeSimpleUpdateQuery(
                     "config_worker",
                     conn->sqlEqual("name", name),
                     std::make_pair("is_read_only", readOnly ? 1 : 0));
+                version = ::bumpVersion(conn);
                 conn->commit();
             }
         );
@@ -331,6 +389,8 @@ WorkerInfo ConfigurationMySQL::setWorkerReadOnly(std::string const& name,
 
         auto itr = safeFindWorker(lock, name, context_);
         itr->second.isReadOnly = readOnly;
+        _noteVersion(lock, version);
+        publish(lock);
 
     } catch (database::mysql::Error const& ex) {
         LOGS(_log, LOG_LVL_ERROR, context_ << "MySQL error: " << ex.what());
@@ -351,14 +411,16 @@ WorkerInfo ConfigurationMySQL::setWorkerSvcHost(std::string const& name,
     try {
 
         // First update the database
+        uint64_t version = 0;
         handler.conn = database::mysql::Connection::open(_connectionParams);
         handler.conn->execute(
-            [&name,&host](decltype(handler.conn) conn) {
+            [&name,&host,&version](decltype(handler.conn) conn) {
                 conn->begin();
                 conn->executeSimpleUpdateQuery(
                     "config_worker",
                     conn->sqlEqual("name", name),
                     std::make_pair("svc_host", host));
+                version = ::bumpVersion(conn);
                 conn->commit();
             }
         );
@@ -369,6 +431,8 @@ WorkerInfo ConfigurationMySQL::setWorkerSvcHost(std::string const& name,
 
         auto itr = safeFindWorker(lock, name, context_);
         itr->second.svcHost = host;
+        _noteVersion(lock, version);
+        publish(lock);
 
     } catch (database::mysql::Error const& ex) {
         LOGS(_log, LOG_LVL_ERROR, context_ << "MySQL error: " << ex.what());
@@ -389,14 +453,16 @@ WorkerInfo ConfigurationMySQL::setWorkerSvcPort(std::string const& name,
     try {
 
         // First update the database
+        uint64_t version = 0;
         handler.conn = database::mysql::Connection::open(_connectionParams);
         handler.conn->execute(
-            [&name,port](decltype(handler.conn) conn) {
+            [&name,port,&version](decltype(handler.conn) conn) {
                 conn->begin();
                 conn->executeSimpleUpdateQuery(
                     "config_worker",
                     conn->sqlEqual("name", name),
                     std::make_pair("svc_port", port));
+                version = ::bumpVersion(conn);
                 conn->commit();
             }
         );
@@ -407,6 +473,8 @@ WorkerInfo ConfigurationMySQL::setWorkerSvcPort(std::string const& name,
 
         auto itr = safeFindWorker(lock, name, context_);
         itr->second.svcPort = port;
+        _noteVersion(lock, version);
+        publish(lock);
 
     } catch (database::mysql::Error const& ex) {
         LOGS(_log, LOG_LVL_ERROR, context_ << "MySQL error: " << ex.what());
@@ -427,14 +495,16 @@ WorkerInfo ConfigurationMySQL::setWorkerFsHost(std::string const& name,
     try {
 
         // First update the database
+        uint64_t version = 0;
         handler.conn = database::mysql::Connection::open(_connectionParams);
         handler.conn->execute(
-            [&name,&host](decltype(handler.conn) conn) {
+            [&name,&host,&version](decltype(handler.conn) conn) {
                 conn->begin();
                 conn->executeSimpleUpdateQuery(
                     "config_worker",
                     conn->sqlEqual("name", name),
                     std::make_pair("fs_host", host));
+                version = ::bumpVersion(conn);
                 conn->commit();
             }
         );
@@ -445,6 +515,8 @@ WorkerInfo ConfigurationMySQL::setWorkerFsHost(std::string const& name,
 
         auto itr = safeFindWorker(lock, name, context_);
         itr->second.fsHost = host;
+        _noteVersion(lock, version);
+        publish(lock);
 
     } catch (database::mysql::Error const& ex) {
         LOGS(_log, LOG_LVL_ERROR, context_ << "MySQL error: " << ex.what());
@@ -465,14 +537,16 @@ WorkerInfo ConfigurationMySQL::setWorkerFsPort(std::string const& name,
     try {
 
         // First update the database
+        uint64_t version = 0;
         handler.conn = database::mysql::Connection::open(_connectionParams);
         handler.conn->execute(
-            [&name,port](decltype(handler.conn) conn) {
+            [&name,port,&version](decltype(handler.conn) conn) {
                 conn->begin();
                 conn->executeSimpleUpdateQuery(
                     "config_worker",
                     conn->sqlEqual("name", name),
                     std::make_pair("fs_port", port));
+                version = ::bumpVersion(conn);
                 conn->commit();
             }
         );
@@ -483,6 +557,8 @@ WorkerInfo ConfigurationMySQL::setWorkerFsPort(std::string const& name,
     
         auto itr = safeFindWorker(lock, name, context_);
         itr->second.fsPort = port;
+        _noteVersion(lock, version);
+        publish(lock);
 
     } catch (database::mysql::Error const& ex) {
         LOGS(_log, LOG_LVL_ERROR, context_ << "MySQL error: " << ex.what());
@@ -503,14 +579,16 @@ WorkerInfo ConfigurationMySQL::setWorkerDataDir(std::string const& name,
     try {
 
         // First update the database
+        uint64_t version = 0;
         handler.conn = database::mysql::Connection::open(_connectionParams);
         handler.conn->execute(
-            [&name,&dataDir](decltype(handler.conn) conn) {
+            [&name,&dataDir,&version](decltype(handler.conn) conn) {
                 conn->begin();
                 conn->executeSimpleUpdateQuery(
                     "config_worker",
                     conn->sqlEqual("name", name),
                     std::make_pair("data_dir", dataDir));
+                version = ::bumpVersion(conn);
                 conn->commit();
             }
         );
@@ -521,6 +599,8 @@ WorkerInfo ConfigurationMySQL::setWorkerDataDir(std::string const& name,
 
         auto itr = safeFindWorker(lock, name, context_);
         itr->second.dataDir = dataDir;
+        _noteVersion(lock, version);
+        publish(lock);
 
     } catch (database::mysql::Error const& ex) {
         LOGS(_log, LOG_LVL_ERROR, context_ << "MySQL error: " << ex.what());
@@ -553,9 +633,10 @@ DatabaseFamilyInfo ConfigurationMySQL::addDatabaseFamily(DatabaseFamilyInfo cons
     try {
 
         // First update the database
+        uint64_t version = 0;
         handler.conn = database::mysql::Connection::open(_connectionParams);
         handler.conn->execute(
-            [&info](decltype(handler.conn) conn) {
+            [&info,&version](decltype(handler.conn) conn) {
                 conn->begin();
                 conn->executeInsertQuery(
                     "config_database_family",
@@ -564,6 +645,7 @@ DatabaseFamilyInfo ConfigurationMySQL::addDatabaseFamily(DatabaseFamilyInfo cons
                     info.numStripes,
                     info.numSubStripes
                 );
+                version = ::bumpVersion(conn);
                 conn->commit();
             }
         );
@@ -581,6 +663,8 @@ DatabaseFamilyInfo ConfigurationMySQL::addDatabaseFamily(DatabaseFamilyInfo cons
                 static_cast<int32_t>(info.numStripes),
                 static_cast<int32_t>(info.numSubStripes))
         };
+        _noteVersion(lock, version);
+        publish(lock);
         return _databaseFamilyInfo[info.name];
 
     } catch (database::mysql::Error const& ex) {
@@ -604,14 +688,16 @@ void ConfigurationMySQL::deleteDatabaseFamily(std::string const& name) {
     try {
 
         // First update the database
+        uint64_t version = 0;
         handler.conn = database::mysql::Connection::open(_connectionParams);
         handler.conn->execute(
-            [&name](decltype(handler.conn) conn) {
+            [&name,&version](decltype(handler.conn) conn) {
                 conn->begin();
                 conn->execute(
                     "DELETE FROM " + conn->sqlId("config_database_family") +
                     "  WHERE  "    + conn->sqlEqual("name", name)
                 );
+                version = ::bumpVersion(conn);
                 conn->commit();
             }
         );
@@ -633,6 +719,8 @@ void ConfigurationMySQL::deleteDatabaseFamily(std::string const& name) {
                 ++itr;
             }
         }
+        _noteVersion(lock, version);
+        publish(lock);
 
     } catch (database::mysql::Error const& ex) {
         LOGS(_log, LOG_LVL_ERROR, context_ << "MySQL error: " << ex.what());
@@ -661,15 +749,17 @@ DatabaseInfo ConfigurationMySQL::addDatabase(DatabaseInfo const& info) {
     try {
 
         // First update the database
+        uint64_t version = 0;
         handler.conn = database::mysql::Connection::open(_connectionParams);
         handler.conn->execute(
-            [&info](decltype(handler.conn) conn) {
+            [&info,&version](decltype(handler.conn) conn) {
                 conn->begin();
                 conn->executeInsertQuery(
                     "config_database",
                     info.name,
                     info.family
                 );
+                version = ::bumpVersion(conn);
                 conn->commit();
             }
         );
@@ -684,6 +774,8 @@ DatabaseInfo ConfigurationMySQL::addDatabase(DatabaseInfo const& info) {
             {},
             {}
         };
+        _noteVersion(lock, version);
+        publish(lock);
         return _databaseInfo[info.name];
 
     } catch (database::mysql::Error const& ex) {
@@ -707,14 +799,16 @@ void ConfigurationMySQL::deleteDatabase(std::string const& name) {
     try {
 
         // First update the database
+        uint64_t version = 0;
         handler.conn = database::mysql::Connection::open(_connectionParams);
         handler.conn->execute(
-            [&name](decltype(handler.conn) conn) {
+            [&name,&version](decltype(handler.conn) conn) {
                 conn->begin();
                 conn->execute(
                     "DELETE FROM " + conn->sqlId("config_database") +
                     "  WHERE  "    + conn->sqlEqual("database", name)
                 );
+                version = ::bumpVersion(conn);
                 conn->commit();
             }
         );
@@ -727,6 +821,8 @@ void ConfigurationMySQL::deleteDatabase(std::string const& name) {
         util::Lock lock(_mtx, context_);
 
         _databaseInfo.erase(name);
+        _noteVersion(lock, version);
+        publish(lock);
 
     } catch (database::mysql::Error const& ex) {
         LOGS(_log, LOG_LVL_ERROR, context_ << "MySQL error: " << ex.what());
@@ -758,9 +854,10 @@ DatabaseInfo ConfigurationMySQL::addTable(std::string const& database,
     try {
 
         // First update the database
+        uint64_t version = 0;
         handler.conn = database::mysql::Connection::open(_connectionParams);
         handler.conn->execute(
-            [&database,&table,isPartitioned](decltype(handler.conn) conn) {
+            [&database,&table,isPartitioned,&version](decltype(handler.conn) conn) {
                 conn->begin();
                 conn->executeInsertQuery(
                     "config_database_table",
@@ -768,6 +865,7 @@ DatabaseInfo ConfigurationMySQL::addTable(std::string const& database,
                     table,
                     isPartitioned
                 );
+                version = ::bumpVersion(conn);
                 conn->commit();
             }
         );
@@ -782,6 +880,8 @@ DatabaseInfo ConfigurationMySQL::addTable(std::string const& database,
         } else {
             info.regularTables.push_back(table);
         }
+        _noteVersion(lock, version);
+        publish(lock);
         return info;
 
     } catch (database::mysql::Error const& ex) {
@@ -813,15 +913,17 @@ DatabaseInfo ConfigurationMySQL::deleteTable(std::string const& database,
     try {
 
         // First update the database
+        uint64_t version = 0;
         handler.conn = database::mysql::Connection::open(_connectionParams);
         handler.conn->execute(
-            [&database,&table](decltype(handler.conn) conn) {
+            [&database,&table,&version](decltype(handler.conn) conn) {
                 conn->begin();
                 conn->execute(
                     "DELETE FROM " + conn->sqlId("config_database_table") +
                     "  WHERE  "    + conn->sqlEqual("database", database) +
                     "    AND "     + conn->sqlEqual("table",    table)
                 );
+                version = ::bumpVersion(conn);
                 conn->commit();
             }
         );
@@ -847,6 +949,8 @@ DatabaseInfo ConfigurationMySQL::deleteTable(std::string const& database,
         if (rTableItr != info.regularTables.cend()) {
             info.regularTables.erase(rTableItr);
         }
+        _noteVersion(lock, version);
+        publish(lock);
         return info;
 
     } catch (database::mysql::Error const& ex) {
@@ -872,6 +976,7 @@ void ConfigurationMySQL::loadConfiguration() {
                 this->loadConfigurationImpl(lock, conn);
             }
         );
+        publish(lock);
     } catch (database::mysql::Error const& ex) {
         LOGS(_log, LOG_LVL_ERROR, context_ << "MySQL error: " << ex.what());
         throw;
@@ -879,6 +984,66 @@ void ConfigurationMySQL::loadConfiguration() {
 }
 
 
+bool ConfigurationMySQL::refresh() {
+
+    std::string const context_ = context() + std::string(__func__);
+
+    database::mysql::ConnectionHandler handler;
+    try {
+        uint64_t version = 0;
+        handler.conn = database::mysql::Connection::open(_connectionParams);
+        handler.conn->execute(
+            [&version](decltype(handler.conn) conn) {
+                version = ::readVersion(conn);
+            }
+        );
+
+        util::Lock lock(_mtx, context_);
+
+        if (version == _version) return false;
+
+        LOGS(_log, LOG_LVL_INFO, context_ << "  version: " << _version << " -> " << version);
+
+        // The collections are rebuilt from scratch. They're restored from
+        // the last snapshot if the reload fails.
+
+        _workerInfo.clear();
+        _databaseInfo.clear();
+        _databaseFamilyInfo.clear();
+        try {
+            handler.conn->execute(
+                [this, &lock](decltype(handler.conn) conn) {
+                    this->loadConfigurationImpl(lock, conn);
+                }
+            );
+        } catch (database::mysql::Error const&) {
+            auto const last = snapshot();
+            _workerInfo         = last->workerInfo;
+            _databaseInfo       = last->databaseInfo;
+            _databaseFamilyInfo = last->databaseFamilyInfo;
+            throw;
+        }
+        publish(lock);
+        return true;
+
+    } catch (database::mysql::Error const& ex) {
+        LOGS(_log, LOG_LVL_ERROR, context_ << "MySQL error: " << ex.what());
+        throw;
+    }
+}
+
+
+void ConfigurationMySQL::_noteVersion(util::Lock const& lock,
+                                      uint64_t version) {
+
+    // The cached version is only advanced over the change just made by this
+    // object. Changes made by other processes in the meantime haven't been
+    // loaded yet, and refresh() has to find them.
+
+    if (version == _version + 1) _version = version;
+}
+
+
 void ConfigurationMySQL::loadConfigurationImpl(util::Lock const& lock,
                                                database::mysql::Connection::Ptr const& conn) {
 
@@ -902,6 +1067,7 @@ void ConfigurationMySQL::loadConfigurationImpl(util::Lock const& lock,
 
         ::tryParameter(row, "common", "request_buf_size_bytes",     _requestBufferSizeBytes) or
         ::tryParameter(row, "common", "request_retry_interval_sec", _retryTimeoutSec) or
+        ::tryParameter(row, "common", "version",                    _version) or
 
         ::tryParameter(row, "controller", "num_threads",         _controllerThreads) or
         ::tryParameter(row, "controller", "http_server_port",    _controllerHttpPort) or
@@ -921,6 +1087,12 @@ void ConfigurationMySQL::loadConfigurationImpl(util::Lock const& lock,
         ::tryParameter(row, "worker", "num_svc_processing_threads", _workerNumProcessingThreads) or
         ::tryParameter(row, "worker", "num_fs_processing_threads",  _fsNumProcessingThreads) or
         ::tryParameter(row, "worker", "fs_buf_size_bytes",          _workerFsBufferSizeBytes) or
+        ::tryParameter(row, "worker", "fs_max_streams",             _workerFsMaxStreams) or
+        ::tryParameter(row, "worker", "fs_io_depth",                _workerFsIoDepth) or
+        ::tryParameter(row, "worker", "fs_max_rate_bytes_per_sec",  _workerFsMaxRateBytesPerSec) or
+        ::tryParameter(row, "worker", "fs_compression_level",       _workerFsCompressionLevel) or
+        ::tryParameter(row, "worker", "num_ingest_loads",           _workerNumIngestLoads) or
+        ::tryParameter(row, "worker", "ingest_db",                  _workerIngestDatabase) or
         ::tryParameter(row, "worker", "svc_port",                   commonWorkerSvcPort)  or
         ::tryParameter(row, "worker", "fs_port",                    commonWorkerFsPort) or
         ::tryParameter(row, "worker", "data_dir",                   commonWorkerDataDir);
@@ -1025,9 +1197,10 @@ void ConfigurationMySQL::_setImp(std::string const& category,
 
     database::mysql::ConnectionHandler handler;
     try {
+        uint64_t version = 0;
         handler.conn = database::mysql::Connection::open(_connectionParams);
         handler.conn->execute(
-            [&category,&param,&setValueExprFunc](decltype(handler.conn) conn) {
+            [&category,&param,&setValueExprFunc,&version](decltype(handler.conn) conn) {
                 std::ostringstream query;
                 query << "UPDATE  " << conn->sqlId("config")
                       << "  SET   " << setValueExprFunc(conn)
@@ -1035,11 +1208,13 @@ void ConfigurationMySQL::_setImp(std::string const& category,
                       << "    AND " << conn->sqlEqual("param", param);
                 conn->begin();
                 conn->execute(query.str());
+                version = ::bumpVersion(conn);
                 conn->commit();
             }
         );
 
         util::Lock lock(_mtx, context_);
+        _noteVersion(lock, version);
         onSuccess();
 
     } catch (database::mysql::Error const& ex) {
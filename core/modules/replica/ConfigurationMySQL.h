@@ -102,6 +102,15 @@ public:
      */
     std::string configUrl() const final;
 
+    /**
+     * Reload the configuration if the version stored in the database differs
+     * from the one loaded. The version is incremented by each modification
+     * made through this class.
+     *
+     * @see Configuration::refresh()
+     */
+    bool refresh() final;
+
     /**
      * @see Configuration::setRequestBufferSizeBytes()
      */
@@ -325,6 +334,66 @@ public:
              val);
     }
 
+    /**
+     * @see Configuration::setWorkerFsMaxStreams()
+     */
+    void setWorkerFsMaxStreams(size_t val) final {
+        _set(_workerFsMaxStreams,
+             "worker",
+             "fs_max_streams",
+             val);
+    }
+
+    /**
+     * @see Configuration::setWorkerFsIoDepth()
+     */
+    void setWorkerFsIoDepth(size_t val) final {
+        _set(_workerFsIoDepth,
+             "worker",
+             "fs_io_depth",
+             val);
+    }
+
+    /**
+     * @see Configuration::setWorkerFsMaxRateBytesPerSec()
+     */
+    void setWorkerFsMaxRateBytesPerSec(size_t val) final {
+        _set(_workerFsMaxRateBytesPerSec,
+             "worker",
+             "fs_max_rate_bytes_per_sec",
+             val);
+    }
+
+    /**
+     * @see Configuration::setWorkerFsCompressionLevel()
+     */
+    void setWorkerFsCompressionLevel(size_t val) final {
+        _set(_workerFsCompressionLevel,
+             "worker",
+             "fs_compression_level",
+             val);
+    }
+
+    /**
+     * @see Configuration::setWorkerNumIngestLoads()
+     */
+    void setWorkerNumIngestLoads(size_t val) final {
+        _set(_workerNumIngestLoads,
+             "worker",
+             "num_ingest_loads",
+             val);
+    }
+
+    /**
+     * @see Configuration::setWorkerIngestDatabase()
+     */
+    void setWorkerIngestDatabase(std::string const& val) final {
+        _set(_workerIngestDatabase,
+             "worker",
+             "ingest_db",
+             val);
+    }
+
     /**
      * @see Configuration::addDatabaseFamily()
      */
@@ -520,11 +589,27 @@ private:
                  SetValueExprFunc const& setValueExprFunc,
                  std::function<void()> const& onSuccess);
 
+    /**
+     * Record the version of the configuration set by a change made through
+     * this object.
+     *
+     * @param lock
+     *   the lock on a mutex required for the thread safety
+     *
+     * @param version
+     *   the version set in the database by the change
+     */
+    void _noteVersion(util::Lock const& lock,
+                      uint64_t version);
+
 private:
 
     /// Parameters of the connection
     database::mysql::ConnectionParams const _connectionParams;
 
+    /// The version of the configuration loaded from the database
+    uint64_t _version;
+
     /// Message logger
     LOG_LOGGER _log;
 };
@@ -119,6 +119,7 @@ void ConfigurationStore::addWorker(WorkerInfo const& info) {
         }
     }
     _workerInfo[info.name] = info;
+    publish(lock);
 }
 
 
@@ -131,6 +132,7 @@ void ConfigurationStore::deleteWorker(std::string const& name) {
         throw std::invalid_argument("ConfigurationStore::" + std::string(__func__) + "  no such worker: " + name);
     }
     _workerInfo.erase(itr);
+    publish(lock);
 }
 
 
@@ -146,6 +148,8 @@ WorkerInfo ConfigurationStore::disableWorker(std::string const& name,
     }
     itr->second.isEnabled = not disable;
 
+    publish(lock);
+
     return itr->second;
 }
 
@@ -161,6 +165,8 @@ WorkerInfo ConfigurationStore::setWorkerReadOnly(std::string const& name,
     }
     itr->second.isReadOnly = readOnly;
 
+    publish(lock);
+
     return itr->second;
 }
 
@@ -176,6 +182,8 @@ WorkerInfo ConfigurationStore::setWorkerSvcHost(std::string const& name,
     }
     itr->second.svcHost = host;
 
+    publish(lock);
+
     return itr->second;
 }
 
@@ -191,6 +199,8 @@ WorkerInfo ConfigurationStore::setWorkerSvcPort(std::string const& name,
     }
     itr->second.svcPort = port;
 
+    publish(lock);
+
     return itr->second;
 }
 
@@ -206,6 +216,8 @@ WorkerInfo ConfigurationStore::setWorkerFsHost(std::string const& name,
     }
     itr->second.fsHost = host;
 
+    publish(lock);
+
     return itr->second;
 }
 
@@ -221,6 +233,8 @@ WorkerInfo ConfigurationStore::setWorkerFsPort(std::string const& name,
     }
     itr->second.fsPort = port;
 
+    publish(lock);
+
     return itr->second;
 }
 
@@ -237,6 +251,8 @@ WorkerInfo ConfigurationStore::setWorkerDataDir(std::string const& name,
     }
     itr->second.dataDir = dataDir;
 
+    publish(lock);
+
     return itr->second;
 
 }
@@ -272,6 +288,7 @@ DatabaseFamilyInfo ConfigurationStore::addDatabaseFamily(DatabaseFamilyInfo cons
             static_cast<int32_t>(info.numStripes),
             static_cast<int32_t>(info.numSubStripes))
     };
+    publish(lock);
     return _databaseFamilyInfo[info.name];
 }
 
@@ -301,6 +318,7 @@ void ConfigurationStore::deleteDatabaseFamily(std::string const& name) {
             ++itr;
         }
     }
+    publish(lock);
 }
 
 
@@ -328,6 +346,7 @@ DatabaseInfo ConfigurationStore::addDatabase(DatabaseInfo const& info) {
         {},
         {}
     };
+    publish(lock);
     return _databaseInfo[info.name];
 }
 
@@ -348,6 +367,7 @@ void ConfigurationStore::deleteDatabase(std::string const& name) {
         throw std::invalid_argument(context() + std::string(__func__) + "  unknown database");
     }
     _databaseInfo.erase(itr);
+    publish(lock);
 }
 
 
@@ -391,6 +411,7 @@ DatabaseInfo ConfigurationStore::addTable(std::string const& database,
     } else {
         info.regularTables.push_back(table);
     }
+    publish(lock);
     return info;
 }
 
@@ -422,6 +443,7 @@ DatabaseInfo ConfigurationStore::deleteTable(std::string const& database,
                                table);
     if (pTableItr != info.partitionedTables.cend()) {
         info.partitionedTables.erase(pTableItr);
+        publish(lock);
         return info;
     }
     auto rTableItr = std::find(info.regularTables.cbegin(),
@@ -429,6 +451,7 @@ DatabaseInfo ConfigurationStore::deleteTable(std::string const& database,
                                table);
     if (rTableItr != info.regularTables.cend()) {
         info.regularTables.erase(rTableItr);
+        publish(lock);
         return info;
     }
     throw std::invalid_argument(context() + std::string(__func__) + "  unknown table");
@@ -489,6 +512,12 @@ void ConfigurationStore::loadConfiguration(util::ConfigStore const& configStore)
     ::parseKeyVal(configStore, "worker.num_svc_processing_threads", _workerNumProcessingThreads,   defaultWorkerNumProcessingThreads);
     ::parseKeyVal(configStore, "worker.num_fs_processing_threads",  _fsNumProcessingThreads,       defaultFsNumProcessingThreads);
     ::parseKeyVal(configStore, "worker.fs_buf_size_bytes",          _workerFsBufferSizeBytes,      defaultWorkerFsBufferSizeBytes);
+    ::parseKeyVal(configStore, "worker.fs_max_streams",             _workerFsMaxStreams,           defaultWorkerFsMaxStreams);
+    ::parseKeyVal(configStore, "worker.fs_io_depth",                _workerFsIoDepth,              defaultWorkerFsIoDepth);
+    ::parseKeyVal(configStore, "worker.fs_max_rate_bytes_per_sec",  _workerFsMaxRateBytesPerSec,   defaultWorkerFsMaxRateBytesPerSec);
+    ::parseKeyVal(configStore, "worker.fs_compression_level",       _workerFsCompressionLevel,     defaultWorkerFsCompressionLevel);
+    ::parseKeyVal(configStore, "worker.num_ingest_loads",           _workerNumIngestLoads,         defaultWorkerNumIngestLoads);
+    ::parseKeyVal(configStore, "worker.ingest_db",                  _workerIngestDatabase,         defaultWorkerIngestDatabase);
 
 
     // Optional common parameters for workers
@@ -585,6 +614,7 @@ void ConfigurationStore::loadConfiguration(util::ConfigStore const& configStore)
             _databaseInfo[name].regularTables = std::vector<std::string>(begin, end);
         }
     }
+    publish(lock);
     dumpIntoLogger();
 }
 
@@ -213,6 +213,36 @@ public:
      */
     void setWorkerFsBufferSizeBytes(size_t val) final { _set(_workerFsBufferSizeBytes, val); }
 
+    /**
+     * @see Configuration::setWorkerFsMaxStreams()
+     */
+    void setWorkerFsMaxStreams(size_t val) final { _set(_workerFsMaxStreams, val); }
+
+    /**
+     * @see Configuration::setWorkerFsIoDepth()
+     */
+    void setWorkerFsIoDepth(size_t val) final { _set(_workerFsIoDepth, val); }
+
+    /**
+     * @see Configuration::setWorkerFsMaxRateBytesPerSec()
+     */
+    void setWorkerFsMaxRateBytesPerSec(size_t val) final { _set(_workerFsMaxRateBytesPerSec, val); }
+
+    /**
+     * @see Configuration::setWorkerFsCompressionLevel()
+     */
+    void setWorkerFsCompressionLevel(size_t val) final { _set(_workerFsCompressionLevel, val); }
+
+    /**
+     * @see Configuration::setWorkerNumIngestLoads()
+     */
+    void setWorkerNumIngestLoads(size_t val) final { _set(_workerNumIngestLoads, val); }
+
+    /**
+     * @see Configuration::setWorkerIngestDatabase()
+     */
+    void setWorkerIngestDatabase(std::string const& val) final { _set(_workerIngestDatabase, val); }
+
 
     /**
      * @see Configuration::addDatabaseFamily()
@@ -36,12 +36,20 @@
 #include "replica/DatabaseServices.h"
 #include "replica/DeleteRequest.h"
 #include "replica/EchoRequest.h"
+#include "replica/IndexRequest.h"
+#include "replica/PackRequest.h"
+#include "replica/IngestRequest.h"
 #include "replica/FindRequest.h"
 #include "replica/FindAllRequest.h"
+#include "replica/HeartbeatMonitor.h"
 #include "replica/Messenger.h"
 #include "replica/Performance.h"
+#include "replica/PerformanceHistory.h"
+#include "replica/ReplicaDirectory.h"
 #include "replica/ReplicationRequest.h"
+#include "replica/RequestFanOut.h"
 #include "replica/ServiceManagementRequest.h"
+#include "replica/ServiceThrottleRequest.h"
 #include "replica/ServiceProvider.h"
 #include "replica/StatusRequest.h"
 #include "replica/StopRequest.h"
@@ -249,11 +257,36 @@ Controller::Controller(ServiceProvider::Ptr const& serviceProvider)
             boost::asio::ip::host_name(),
             getpid()}),
         _startTime(PerformanceUtils::now()),
-        _serviceProvider(serviceProvider) {
+        _serviceProvider(serviceProvider),
+        _performanceHistory(PerformanceHistory::create()),
+        _replicaDirectory(ReplicaDirectory::create()) {
 
     serviceProvider->databaseServices()->saveState(_identity, _startTime);
 }
 
+std::shared_ptr<HeartbeatMonitor> const& Controller::heartbeatMonitor() {
+
+    util::Lock lock(_mtx, context() + "heartbeatMonitor");
+
+    if (not _heartbeatMonitor) {
+        _heartbeatMonitor = HeartbeatMonitor::create(serviceProvider());
+        _heartbeatMonitor->start(serviceProvider()->config()->allWorkers());
+    }
+    return _heartbeatMonitor;
+}
+
+std::shared_ptr<RequestFanOut> const& Controller::fanOut() {
+
+    util::Lock lock(_mtx, context() + "fanOut");
+
+    if (not _fanOut) {
+        _fanOut = RequestFanOut::create(
+            serviceProvider(),
+            serviceProvider()->config()->workerNumProcessingThreads());
+    }
+    return _fanOut;
+}
+
 std::string Controller::context() const {
     return "R-CONTR " + _identity.id + "  " + _identity.host +
            "[" + std::to_string(_identity.pid) + "]  ";
@@ -320,9 +353,31 @@ DeleteRequest::Ptr Controller::deleteReplica(
                             std::string const& jobId,
                             unsigned int requestExpirationIvalSec) {
 
-    LOGS(_log, LOG_LVL_DEBUG, context() << "deleteReplica");
+    return deleteReplicas(workerName,
+                          database,
+                          std::vector<unsigned int>{chunk},
+                          onFinish,
+                          priority,
+                          keepTracking,
+                          allowDuplicate,
+                          jobId,
+                          requestExpirationIvalSec);
+}
+
+DeleteRequest::Ptr Controller::deleteReplicas(
+                            std::string const& workerName,
+                            std::string const& database,
+                            std::vector<unsigned int> const& chunks,
+                            DeleteRequest::CallbackType const& onFinish,
+                            int  priority,
+                            bool keepTracking,
+                            bool allowDuplicate,
+                            std::string const& jobId,
+                            unsigned int requestExpirationIvalSec) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "deleteReplicas  numChunks=" << chunks.size());
 
-    util::Lock lock(_mtx, context() + "deleteReplica");
+    util::Lock lock(_mtx, context() + "deleteReplicas");
 
     assertIsRunning();
 
@@ -333,7 +388,7 @@ DeleteRequest::Ptr Controller::deleteReplica(
         serviceProvider()->io_service(),
         workerName,
         database,
-        chunk,
+        chunks,
         [controller] (DeleteRequest::Ptr request) {
             controller->finish(request->id());
         },
@@ -364,6 +419,7 @@ FindRequest::Ptr Controller::findReplica(
                         FindRequest::CallbackType const& onFinish,
                         int  priority,
                         bool computeCheckSum,
+                        double sampleRate,
                         bool keepTracking,
                         std::string const& jobId,
                         unsigned int requestExpirationIvalSec) {
@@ -387,6 +443,7 @@ FindRequest::Ptr Controller::findReplica(
         },
         priority,
         computeCheckSum,
+        sampleRate,
         keepTracking,
         serviceProvider()->messenger()
     );
@@ -497,6 +554,154 @@ EchoRequest::Ptr Controller::echo(std::string const& workerName,
     return request;
 }
 
+IngestRequest::Ptr Controller::ingest(std::string const& workerName,
+                                      std::string const& database,
+                                      unsigned int chunk,
+                                      std::string const& sourceWorkerName,
+                                      std::vector<IngestFileInfo> const& files,
+                                      unsigned int numLoads,
+                                      bool clusterSubChunks,
+                                      IngestRequestCallbackType const& onFinish,
+                                      int priority,
+                                      bool keepTracking,
+                                      std::string const& jobId,
+                                      unsigned int requestExpirationIvalSec) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "ingest");
+
+    util::Lock lock(_mtx, context() + "ingest");
+
+    assertIsRunning();
+
+    Controller::Ptr controller = shared_from_this();
+
+    auto const request = IngestRequest::create(
+        serviceProvider(),
+        serviceProvider()->io_service(),
+        workerName,
+        database,
+        chunk,
+        sourceWorkerName,
+        files,
+        numLoads,
+        clusterSubChunks,
+        [controller] (IngestRequest::Ptr request) {
+            controller->finish(request->id());
+        },
+        priority,
+        keepTracking,
+        serviceProvider()->messenger()
+    );
+
+    // Register the request (along with its callback) by its unique
+    // identifier in the local registry. Once it's complete it'll
+    // be automatically removed from the Registry.
+
+    _registry[request->id()] =
+        std::make_shared<RequestWrapperImpl<IngestRequest>>(request, onFinish);
+
+    // Initiate the request
+
+    request->start(controller, jobId, requestExpirationIvalSec);
+
+    return request;
+}
+
+IndexRequest::Ptr Controller::index(std::string const& workerName,
+                                    std::string const& database,
+                                    std::string const& table,
+                                    std::string const& keyColumn,
+                                    std::vector<unsigned int> const& chunks,
+                                    IndexRequestCallbackType const& onFinish,
+                                    int priority,
+                                    bool keepTracking,
+                                    std::string const& jobId,
+                                    unsigned int requestExpirationIvalSec) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "index");
+
+    util::Lock lock(_mtx, context() + "index");
+
+    assertIsRunning();
+
+    Controller::Ptr controller = shared_from_this();
+
+    auto const request = IndexRequest::create(
+        serviceProvider(),
+        serviceProvider()->io_service(),
+        workerName,
+        database,
+        table,
+        keyColumn,
+        chunks,
+        [controller] (IndexRequest::Ptr request) {
+            controller->finish(request->id());
+        },
+        priority,
+        keepTracking,
+        serviceProvider()->messenger()
+    );
+
+    // Register the request (along with its callback) by its unique
+    // identifier in the local registry. Once it's complete it'll
+    // be automatically removed from the Registry.
+
+    _registry[request->id()] =
+        std::make_shared<RequestWrapperImpl<IndexRequest>>(request, onFinish);
+
+    // Initiate the request
+
+    request->start(controller, jobId, requestExpirationIvalSec);
+
+    return request;
+}
+
+PackRequest::Ptr Controller::pack(std::string const& workerName,
+                                  std::string const& database,
+                                  unsigned int chunk,
+                                  PackRequestCallbackType const& onFinish,
+                                  int priority,
+                                  bool keepTracking,
+                                  std::string const& jobId,
+                                  unsigned int requestExpirationIvalSec) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "pack");
+
+    util::Lock lock(_mtx, context() + "pack");
+
+    assertIsRunning();
+
+    Controller::Ptr controller = shared_from_this();
+
+    auto const request = PackRequest::create(
+        serviceProvider(),
+        serviceProvider()->io_service(),
+        workerName,
+        database,
+        chunk,
+        [controller] (PackRequest::Ptr request) {
+            controller->finish(request->id());
+        },
+        priority,
+        keepTracking,
+        true,   /* allowDuplicate */
+        serviceProvider()->messenger()
+    );
+
+    // Register the request (along with its callback) by its unique
+    // identifier in the local registry. Once it's complete it'll
+    // be automatically removed from the Registry.
+
+    _registry[request->id()] =
+        std::make_shared<RequestWrapperImpl<PackRequest>>(request, onFinish);
+
+    // Initiate the request
+
+    request->start(controller, jobId, requestExpirationIvalSec);
+
+    return request;
+}
+
 StopReplicationRequest::Ptr Controller::stopReplication(
                                     std::string const& workerName,
                                     std::string const& targetRequestId,
@@ -822,6 +1027,43 @@ ServiceDrainRequest::Ptr Controller::drainWorkerService(
         requestExpirationIvalSec);
 }
 
+ServiceThrottleRequest::Ptr Controller::throttleWorkerService(
+                                    std::string const& workerName,
+                                    uint64_t maxRateBytesPerSec,
+                                    ServiceThrottleRequest::CallbackType const& onFinish,
+                                    std::string const& jobId,
+                                    unsigned int requestExpirationIvalSec) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "throttleWorkerService  workerName: " << workerName
+         << " maxRateBytesPerSec: " << maxRateBytesPerSec);
+
+    util::Lock lock(_mtx, context() + "throttleWorkerService");
+
+    assertIsRunning();
+
+    auto const controller = shared_from_this();
+    auto const request = ServiceThrottleRequest::create(
+        serviceProvider(),
+        serviceProvider()->io_service(),
+        workerName,
+        maxRateBytesPerSec,
+        [controller] (ServiceThrottleRequest::Ptr request) {
+            controller->finish(request->id());
+        },
+        serviceProvider()->messenger());
+
+    // Register the request (along with its callback) by its unique
+    // identifier in the local registry. Once it's complete it'll
+    // be automatically removed from the Registry.
+
+    _registry[request->id()] =
+        std::make_shared<RequestWrapperImpl<ServiceThrottleRequest>>(request, onFinish);
+
+    request->start(controller, jobId, requestExpirationIvalSec);
+
+    return request;
+}
+
 size_t Controller::numActiveRequests() const {
     util::Lock lock(_mtx, context() + "numActiveRequests");
     return _registry.size();
@@ -846,9 +1088,42 @@ void Controller::finish(std::string const& id) {
         request = _registry[id];
         _registry.erase(id);
     }
+    auto const ptr = request->request();
+    _performanceHistory->record(ptr->type(),
+                                ptr->worker(),
+                                ptr->performance(),
+                                ptr->extendedState() == Request::ExtendedState::SUCCESS);
+    updateReplicaDirectory(ptr);
     request->notify();
 }
 
+void Controller::updateReplicaDirectory(Request::Ptr const& request) {
+
+    if (request->extendedState() != Request::ExtendedState::SUCCESS) return;
+
+    if (request->type() == "REPLICA_CREATE") {
+        auto const ptr = std::dynamic_pointer_cast<ReplicationRequest>(request);
+        if (ptr) _replicaDirectory->update(ptr->responseData());
+
+    } else if (request->type() == "REPLICA_DELETE") {
+        auto const ptr = std::dynamic_pointer_cast<DeleteRequest>(request);
+        if (ptr) {
+            for (auto&& replica: ptr->batchResponseData()) _replicaDirectory->update(replica);
+        }
+    } else if (request->type() == "REPLICA_FIND") {
+        auto const ptr = std::dynamic_pointer_cast<FindRequest>(request);
+        if (ptr) _replicaDirectory->update(ptr->responseData());
+
+    } else if (request->type() == "REPLICA_PACK") {
+        auto const ptr = std::dynamic_pointer_cast<PackRequest>(request);
+        if (ptr) _replicaDirectory->update(ptr->responseData());
+
+    } else if (request->type() == "REPLICA_FIND_ALL") {
+        auto const ptr = std::dynamic_pointer_cast<FindAllRequest>(request);
+        if (ptr) _replicaDirectory->replace(ptr->worker(), ptr->database(), ptr->responseData());
+    }
+}
+
 void Controller::assertIsRunning() const {
     if (not serviceProvider()->isRunning()) {
         throw std::runtime_error("ServiceProvider is not running");
@@ -47,8 +47,11 @@ namespace qserv {
 namespace replica {
 
 // Forward declarations
-
 class ControllerImpl;
+class HeartbeatMonitor;
+class PerformanceHistory;
+class ReplicaDirectory;
+class RequestFanOut;
 
 /**
  * Class ControllerRequestWrapper is the base class for implementing requests
@@ -151,6 +154,27 @@ public:
     /// @return reference to the I/O service for ASYNC requests
     boost::asio::io_service& io_service() { return serviceProvider()->io_service(); }
 
+    /**
+     * @return the monitor of the heartbeats of all workers. The monitor
+     *   is started on the first call to the method, and the heartbeats
+     *   arrive after that.
+     */
+    std::shared_ptr<HeartbeatMonitor> const& heartbeatMonitor();
+
+    /// @return the latency history of the requests finished by the Controller
+    std::shared_ptr<PerformanceHistory> const& performanceHistory() const { return _performanceHistory; }
+
+    /// @return the replicas reported by the requests finished by the Controller
+    std::shared_ptr<ReplicaDirectory> const& replicaDirectory() const { return _replicaDirectory; }
+
+    /**
+     * @return the engine pacing the requests which jobs send to many workers
+     *   at once. It's created on the first call to the method, with the limit
+     *   for each worker set to the number of the processing threads of
+     *   the worker services.
+     */
+    std::shared_ptr<RequestFanOut> const& fanOut();
+
     /**
      * Create and start a new request for creating a replica.
      *
@@ -248,6 +272,29 @@ public:
                                    std::string const& jobId="",
                                    unsigned int requestExpirationIvalSec=0);
 
+    /**
+     * Create and start a new request for deleting replicas of many chunks
+     * of the same database at once. The worker removes the files of all
+     * chunks within a single request.
+     *
+     * @param chunks
+     *   the chunk numbers (can't be empty)
+     *
+     * @see Controller::deleteReplica() for the other parameters
+     *
+     * @return
+     *   a pointer to the new request
+     */
+    DeleteRequestPtr deleteReplicas(std::string const& workerName,
+                                    std::string const& database,
+                                    std::vector<unsigned int> const& chunks,
+                                    DeleteRequestCallbackType const& onFinish=nullptr,
+                                    int  priority=0,
+                                    bool keepTracking=true,
+                                    bool allowDuplicate=true,
+                                    std::string const& jobId="",
+                                    unsigned int requestExpirationIvalSec=0);
+
     /**
      * Create and start a new request for finding a replica.
      *
@@ -275,6 +322,11 @@ public:
      * @param computeCheckSum
      *   (optional) tell worker server to compute check/control sum on each file
      * 
+     * @param sampleRate
+     *   (optional) tell worker server to compare the checksums of this fraction
+     *   of the blocks of each file against the ones recorded when the file was
+     *   replicated. It's ignored if 'computeCheckSum' is set, and 0 disables it.
+     *
      * @param keepTracking
      *   (optional) keep tracking the request before it finishes or fails
      * 
@@ -294,6 +346,7 @@ public:
                                FindRequestCallbackType const& onFinish=nullptr,
                                int  priority=0,
                                bool computeCheckSum=false,
+                               double sampleRate=0,
                                bool keepTracking=true,
                                std::string const& jobId="",
                                unsigned int requestExpirationIvalSec=0);
@@ -380,6 +433,158 @@ public:
                         std::string const& jobId="",
                         unsigned int requestExpirationIvalSec=0);
 
+    /**
+     * Create and start a new request for loading contributions into the chunk
+     * and overlap tables of a database at a worker.
+     *
+     * @param workerName
+     *   the name of a worker node where the tables are loaded
+     *
+     * @param database
+     *   the name of a database
+     *
+     * @param chunk
+     *   the number of a chunk
+     *
+     * @param sourceWorkerName
+     *   the name of a worker node whose file server has the files
+     *
+     * @param files
+     *   the contributions to be loaded
+     *
+     * @param numLoads
+     *   (optional) the number of files loaded at the same time. The default
+     *   of the worker is assumed if set to 0.
+     *
+     * @param clusterSubChunks
+     *   (optional) store the rows of the tables ordered by subchunk, and record
+     *   the row ranges of the subchunks at the worker
+     *
+     * @param onFinish
+     *   (optional) callback function to be called upon the completion of
+     *   the request
+     *
+     * @param priority
+     *   (optional) priority level of the request
+     *
+     * @param keepTracking
+     *   (optional) keep tracking the request before it finishes or fails
+     *
+     * @param jobId
+     *   (optional) identifier of a job issued the request
+     *
+     * @param requestExpirationIvalSec
+     *   (optional) parameter (if differs from 0) allowing to override the default
+     *   value of the corresponding parameter from the Configuration.
+     *
+     * @return
+     *   a pointer to the new request
+     */
+    IngestRequestPtr ingest(std::string const& workerName,
+                            std::string const& database,
+                            unsigned int chunk,
+                            std::string const& sourceWorkerName,
+                            std::vector<IngestFileInfo> const& files,
+                            unsigned int numLoads=0,
+                            bool clusterSubChunks=false,
+                            IngestRequestCallbackType const& onFinish=nullptr,
+                            int  priority=0,
+                            bool keepTracking=true,
+                            std::string const& jobId="",
+                            unsigned int requestExpirationIvalSec=0);
+
+    /**
+     * Create and start a new request for extracting the secondary index
+     * entries of a director table from chunks at a worker.
+     *
+     * @param workerName
+     *   the name of a worker node where the chunks are read
+     *
+     * @param database
+     *   the name of a database
+     *
+     * @param table
+     *   the base name of the director table
+     *
+     * @param keyColumn
+     *   the name of the column with the keys of the table
+     *
+     * @param chunks
+     *   the chunks to be harvested
+     *
+     * @param onFinish
+     *   (optional) callback function to be called upon the completion of
+     *   the request
+     *
+     * @param priority
+     *   (optional) priority level of the request
+     *
+     * @param keepTracking
+     *   (optional) keep tracking the request before it finishes or fails
+     *
+     * @param jobId
+     *   (optional) identifier of a job issued the request
+     *
+     * @param requestExpirationIvalSec
+     *   (optional) parameter (if differs from 0) allowing to override the default
+     *   value of the corresponding parameter from the Configuration.
+     *
+     * @return
+     *   a pointer to the new request
+     */
+    IndexRequestPtr index(std::string const& workerName,
+                          std::string const& database,
+                          std::string const& table,
+                          std::string const& keyColumn,
+                          std::vector<unsigned int> const& chunks,
+                          IndexRequestCallbackType const& onFinish=nullptr,
+                          int  priority=0,
+                          bool keepTracking=true,
+                          std::string const& jobId="",
+                          unsigned int requestExpirationIvalSec=0);
+
+    /**
+     * Create and start a new request for converting the tables of a chunk
+     * at a worker into the packed read-only format.
+     *
+     * @param workerName
+     *   the name of a worker node where the replica is located
+     *
+     * @param database
+     *   the name of a database
+     *
+     * @param chunk
+     *   the number of a chunk
+     *
+     * @param onFinish
+     *   (optional) callback function to be called upon the completion of
+     *   the request
+     *
+     * @param priority
+     *   (optional) priority level of the request
+     *
+     * @param keepTracking
+     *   (optional) keep tracking the request before it finishes or fails
+     *
+     * @param jobId
+     *   (optional) identifier of a job issued the request
+     *
+     * @param requestExpirationIvalSec
+     *   (optional) parameter (if differs from 0) allowing to override the default
+     *   value of the corresponding parameter from the Configuration.
+     *
+     * @return
+     *   a pointer to the new request
+     */
+    PackRequestPtr pack(std::string const& workerName,
+                        std::string const& database,
+                        unsigned int chunk,
+                        PackRequestCallbackType const& onFinish=nullptr,
+                        int  priority=0,
+                        bool keepTracking=true,
+                        std::string const& jobId="",
+                        unsigned int requestExpirationIvalSec=0);
+
     /**
      * Stop an outstanding replication request.
      *
@@ -842,6 +1047,36 @@ public:
                                 std::string const& jobId="",
                                 unsigned int requestExpirationIvalSec=0);
 
+    /**
+     * Change the bandwidth limit of the file server of a worker and return
+     * the state of the worker-side service.
+     *
+     * @param workerName
+     *   the name of a worker node where the service runs
+     *
+     * @param maxRateBytesPerSec
+     *   the maximum rate at which the file server sends data (0 means no limit)
+     *
+     * @param onFinish
+     *   (optional) callback function to be called upon completion of the operation
+     *
+     * @param jobId
+     *   (optional) identifier of a job issued the request
+     *
+     * @param requestExpirationIvalSec
+     *   (optional) parameter (if differs from 0) allowing to override the default
+     *   value of the corresponding parameter from the Configuration.
+     *
+     * @return
+     *   a pointer to the new request
+     */
+    ServiceThrottleRequestPtr throttleWorkerService(
+                                std::string const& workerName,
+                                uint64_t maxRateBytesPerSec,
+                                ServiceThrottleRequestCallbackType const& onFinish=nullptr,
+                                std::string const& jobId="",
+                                unsigned int requestExpirationIvalSec=0);
+
     /**
      * Return requests of a specific type
      *
@@ -897,6 +1132,15 @@ private:
      */
     void finish(std::string const& id);
 
+    /**
+     * Update the replica directory with the replicas reported by
+     * a successfully finished request
+     *
+     * @param request
+     *   a pointer to the request
+     */
+    void updateReplicaDirectory(Request::Ptr const& request);
+
     /**
      * Make sure the server is running
      *
@@ -917,12 +1161,24 @@ private:
     /// The provider of various services
     ServiceProvider::Ptr const _serviceProvider;
 
+    /// The latency history of the finished requests
+    std::shared_ptr<PerformanceHistory> const _performanceHistory;
+
+    /// The replicas reported by the finished requests
+    std::shared_ptr<ReplicaDirectory> const _replicaDirectory;
+
     /// The mutex for enforcing thread safety of the class's public API
     /// and internal operations.
     mutable util::Mutex _mtx;
 
     /// The registry of the on-going requests.
     std::map<std::string, std::shared_ptr<ControllerRequestWrapper>> _registry;
+
+    /// The monitor of the heartbeats (created on demand)
+    std::shared_ptr<HeartbeatMonitor> _heartbeatMonitor;
+
+    /// The engine pacing the requests of jobs (created on demand)
+    std::shared_ptr<RequestFanOut> _fanOut;
 };
 
 }}} // namespace lsst::qserv::replica
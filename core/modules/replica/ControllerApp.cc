@@ -355,6 +355,7 @@ int ControllerApp::runImpl() {
             },
             _priority,
             _computeCheckSum,
+            0,  /* sampleRate */
             not _doNotTrackRequest);
 
     } else if ("FIND_ALL" == _request) {
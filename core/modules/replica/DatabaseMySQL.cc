@@ -505,6 +505,12 @@ void Connection::connectOnce() {
         throw Error(context + "mysql_init failed");
     }
 
+    // Allow 'LOAD DATA LOCAL INFILE' for loading chunk contributions copied
+    // from other workers. This has no effect unless the server allows it too.
+
+    unsigned int const localInfile = 1;
+    mysql_options(_mysql, MYSQL_OPT_LOCAL_INFILE, &localInfile);
+
     // Make a connection attempt
 
     if (nullptr == mysql_real_connect(
@@ -163,10 +163,32 @@ public:
     /**
      * Update the status of replica in the corresponding tables.
      *
+     * Implementations may buffer the update and save it later. Use method
+     * flushReplicaInfo() where the update needs to be seen by a subsequent
+     * query made through another object.
+     *
      * @param info - a replica to be added/updated or deleted
      */
     virtual void saveReplicaInfo(ReplicaInfo const& info) = 0;
 
+    /**
+     * Update the status of many (unrelated) replicas in the corresponding tables
+     * with a few multi-row statements within a single transaction.
+     *
+     * If the collection has several entries for the same replica then the last
+     * one wins.
+     *
+     * @param infos - replicas to be added/updated or deleted
+     */
+    virtual void saveReplicaInfos(std::vector<ReplicaInfo> const& infos) = 0;
+
+    /**
+     * Block until all replica updates submitted (by any thread) via method
+     * saveReplicaInfo() before the call are saved in the database. Updates
+     * submitted after the call are not waited for.
+     */
+    virtual void flushReplicaInfo() = 0;
+
     /**
      * Update the status of multiple replicas using a collection reported
      * by a request. The method will cross-check replicas reported by the
@@ -333,6 +355,69 @@ public:
     virtual size_t numOrphanChunks(std::string const& database,
                            std::vector<std::string> const& uniqueOnWorkers) = 0;
 
+    /**
+     * @return
+     *   the start time (milliseconds since the UNIX Epoch) of the last collection
+     *   of the statistics of the chunk tables of a database at a worker,
+     *   or 0 if they were never collected
+     *
+     * @param worker
+     *   the name of a worker
+     *
+     * @param database
+     *   the name of a database
+     *
+     * @throw std::invalid_argument
+     *   if the worker or the database was not found in the configuration
+     */
+    virtual uint64_t chunkStatsCollectTime(std::string const& worker,
+                                           std::string const& database) = 0;
+
+    /**
+     * Save the statistics of the chunk tables of a database collected at a worker.
+     * Only the rows whose values changed get the new collection time. The rows
+     * of the chunks which no longer have replicas at the worker are removed.
+     *
+     * @param worker
+     *   the name of a worker
+     *
+     * @param database
+     *   the name of a database
+     *
+     * @param collectTime
+     *   the start time (milliseconds since the UNIX Epoch) of the collection
+     *
+     * @param stats
+     *   the statistics reported by the worker. The sizes of the tables are only
+     *   changed for the entries which have them.
+     *
+     * @throw std::invalid_argument
+     *   if the worker or the database was not found in the configuration
+     */
+    virtual void saveChunkStats(std::string const& worker,
+                                std::string const& database,
+                                uint64_t collectTime,
+                                ChunkStatsCollection const& stats) = 0;
+
+    /**
+     * Find the statistics of the chunk tables of a database
+     *
+     * @param stats
+     *   the collection of the statistics found upon a successful completion
+     *
+     * @param database
+     *   the name of a database
+     *
+     * @param table
+     *   (optional) the name of a table, all tables if empty
+     *
+     * @throw std::invalid_argument
+     *   if the database was not found in the configuration
+     */
+    virtual void findChunkStats(ChunkStatsCollection& stats,
+                                std::string const& database,
+                                std::string const& table=std::string()) = 0;
+
 protected:
 
     DatabaseServices() = default;
@@ -27,8 +27,11 @@
 #include <algorithm>
 #include <cstdint>
 #include <ctime>
+#include <iterator>
 #include <limits>
+#include <map>
 #include <stdexcept>
+#include <tuple>
 
 // Qserv headers
 #include "lsst/log/Log.h"
@@ -47,6 +50,10 @@ LOG_LOGGER _log = LOG_GET("lsst.qserv.replica.DatabaseServicesMySQL");
 
 using namespace lsst::qserv::replica;
 
+/// The maximum number of replicas to be inserted, updated or deleted
+/// by one SQL statement
+size_t const maxReplicasPerStatement = 256;
+
 /**
  * Return 'true' if the specified state is found in a collection.
  *
@@ -470,7 +477,7 @@ void DatabaseServicesMySQL::saveReplicaInfo(ReplicaInfo const& info) {
         _conn->execute(
             [&](decltype(_conn) conn) {
                 conn->begin();
-                saveReplicaInfoImpl(lock, info);
+                saveReplicaInfosImpl(lock, {&info});
                 conn->commit();
             }
         );
@@ -512,54 +519,177 @@ void DatabaseServicesMySQL::saveReplicaInfoCollection(std::string const& worker,
     LOGS(_log, LOG_LVL_DEBUG, context + "** DONE **");
 }
 
-void DatabaseServicesMySQL::saveReplicaInfoImpl(util::Lock const& lock,
-                                                ReplicaInfo const& info) {
+void DatabaseServicesMySQL::saveReplicaInfos(std::vector<ReplicaInfo> const& infos) {
+
+    std::string const context = "DatabaseServicesMySQL::saveReplicaInfos  ";
+
+    LOGS(_log, LOG_LVL_DEBUG, context << "num.replicas: " << infos.size());
 
-    std::string const context = "DatabaseServicesMySQL::saveReplicaInfoImpl  ";
+    // The last entry for a replica wins
+
+    std::map<std::tuple<std::string, std::string, unsigned int>, ReplicaInfo const*> key2info;
+    for (auto&& info: infos) {
+        key2info[std::make_tuple(info.worker(), info.database(), info.chunk())] = &info;
+    }
+    std::vector<ReplicaInfo const*> uniqueInfos;
+    uniqueInfos.reserve(key2info.size());
+    for (auto&& entry: key2info) uniqueInfos.push_back(entry.second);
+
+    util::Lock lock(_mtx, context);
 
     try {
+        _conn->execute(
+            [&](decltype(_conn) conn) {
+                conn->begin();
+                saveReplicaInfosImpl(lock, uniqueInfos);
+                conn->commit();
+            }
+        );
+
+    } catch (database::mysql::Error const& ex) {
+        LOGS(_log, LOG_LVL_ERROR, context << "failed, exception: " << ex.what());
+        if (_conn->inTransaction()) _conn->rollback();
+        throw;
+    }
+    LOGS(_log, LOG_LVL_DEBUG, context + "** DONE **");
+}
 
-        // Try inserting if the replica is complete. Delete otherwise.
+void DatabaseServicesMySQL::saveReplicaInfosImpl(util::Lock const& lock,
+                                                 std::vector<ReplicaInfo const*> const& infos) {
 
-        if (info.status() == ReplicaInfo::Status::COMPLETE) {
+    std::string const context = "DatabaseServicesMySQL::saveReplicaInfosImpl  ";
 
-            _conn->executeInsertQuery(
-                "replica",
-                "NULL",                         /* the auto-incremented PK */
-                info.worker(),
-                info.database(),
-                info.chunk(),
-                info.verifyTime());
+    // Replicas which are not complete are removed. This will also cascade
+    // delete the relevant file entries. See details in the schema.
 
-            for (auto&& f: info.fileInfo()) {
-                _conn->executeInsertQuery(
-                    "replica_file",
-                    database::mysql::Function::LAST_INSERT_ID,  /* FK -> PK of the above insert row */
+    std::vector<ReplicaInfo const*> complete;
+    std::vector<ReplicaInfo const*> incomplete;
+    for (auto&& ptr: infos) {
+        if (ptr->status() == ReplicaInfo::Status::COMPLETE) complete.push_back(ptr);
+        else                                                incomplete.push_back(ptr);
+    }
+    deleteReplicaInfosImpl(lock, incomplete);
+
+    for (auto begin = complete.cbegin(); begin != complete.cend();) {
+        auto const end = begin + std::min(
+            ::maxReplicasPerStatement,
+            static_cast<size_t>(std::distance(begin, complete.cend())));
+
+        // Insert new replicas, or update the existing ones in place. Their
+        // identifiers don't change.
+
+        std::string query =
+            "INSERT INTO " + _conn->sqlId("replica") + " VALUES ";
+        for (auto itr = begin; itr != end; ++itr) {
+            ReplicaInfo const* ptr = *itr;
+            query += (itr == begin ? "" : ",") + _conn->sqlPackValues(
+                database::mysql::Keyword::SQL_NULL,     /* the auto-incremented PK */
+                ptr->worker(),
+                ptr->database(),
+                ptr->chunk(),
+                ptr->verifyTime());
+        }
+        query += " ON DUPLICATE KEY UPDATE " + _conn->sqlId("verify_time") + "=VALUES(" +
+                 _conn->sqlId("verify_time") + ")";
+        _conn->execute(query);
+
+        // Fetch identifiers of the replicas
+
+        std::map<std::tuple<std::string, std::string, unsigned int>, uint64_t> key2id;
+        _conn->execute(
+            "SELECT " + _conn->sqlId("id") + "," + _conn->sqlId("worker") + "," +
+                        _conn->sqlId("database") + "," + _conn->sqlId("chunk") +
+            "  FROM "  + _conn->sqlId("replica") +
+            "  WHERE " + sqlReplicaKeysIn(begin, end));
+
+        if (_conn->hasResult()) {
+            database::mysql::Row row;
+            while (_conn->next(row)) {
+                uint64_t     id;
+                std::string  worker;
+                std::string  database;
+                unsigned int chunk;
+                row.get("id",       id);
+                row.get("worker",   worker);
+                row.get("database", database);
+                row.get("chunk",    chunk);
+                key2id[std::make_tuple(worker, database, chunk)] = id;
+            }
+        }
+        std::vector<uint64_t> ids;
+        for (auto&& entry: key2id) ids.push_back(entry.second);
+
+        // Replace the files of the replicas. The unpacked sizes and control sums
+        // of the packed files are only reported by the packing requests, so they
+        // are carried over to the new entries of files which haven't changed.
+
+        std::map<std::pair<uint64_t, std::string>, ReplicaInfo::FileInfo> unpackedFiles;
+        if (not ids.empty()) {
+            _conn->execute(
+                "SELECT " + _conn->sqlId("replica_id") + "," + _conn->sqlId("name") + "," +
+                            _conn->sqlId("cs") + "," + _conn->sqlId("unpacked_size") + "," +
+                            _conn->sqlId("unpacked_cs") +
+                "  FROM "  + _conn->sqlId("replica_file") +
+                "  WHERE " + _conn->sqlIn("replica_id", ids) +
+                "    AND " + _conn->sqlEqual("packed", 1) +
+                "    AND " + _conn->sqlId("unpacked_cs") + "<>''");
+            if (_conn->hasResult()) {
+                database::mysql::Row row;
+                while (_conn->next(row)) {
+                    uint64_t replicaId;
+                    ReplicaInfo::FileInfo file{};
+                    row.get("replica_id",    replicaId);
+                    row.get("name",          file.name);
+                    row.get("cs",            file.cs);
+                    row.get("unpacked_size", file.unpackedSize);
+                    row.get("unpacked_cs",   file.unpackedCs);
+                    unpackedFiles[std::make_pair(replicaId, file.name)] = file;
+                }
+            }
+            _conn->execute(
+                "DELETE FROM " + _conn->sqlId("replica_file") +
+                "  WHERE "     + _conn->sqlIn("replica_id", ids));
+        }
+        std::string filesQuery =
+            "INSERT INTO " + _conn->sqlId("replica_file") + " VALUES ";
+        size_t numFiles = 0;
+        for (auto itr = begin; itr != end; ++itr) {
+            ReplicaInfo const* ptr = *itr;
+            auto const idItr = key2id.find(
+                std::make_tuple(ptr->worker(), ptr->database(), ptr->chunk()));
+            if (idItr == key2id.end()) {
+                throw std::logic_error(
+                        context + "no identifier found for replica of chunk: " +
+                        std::to_string(ptr->chunk()) + " of database: " + ptr->database() +
+                        " at worker: " + ptr->worker());
+            }
+            for (auto&& f: ptr->fileInfo()) {
+                uint64_t    unpackedSize = f.unpackedSize;
+                std::string unpackedCs   = f.unpackedCs;
+                if (f.packed and unpackedCs.empty()) {
+                    auto const fileItr = unpackedFiles.find(std::make_pair(idItr->second, f.name));
+                    if ((fileItr != unpackedFiles.end()) and (fileItr->second.cs == f.cs)) {
+                        unpackedSize = fileItr->second.unpackedSize;
+                        unpackedCs   = fileItr->second.unpackedCs;
+                    }
+                }
+                filesQuery += (numFiles++ ? "," : "") + _conn->sqlPackValues(
+                    idItr->second,
                     f.name,
                     f.size,
                     f.mtime,
                     f.cs,
                     f.beginTransferTime,
-                    f.endTransferTime);
+                    f.endTransferTime,
+                    f.csAlgorithm,
+                    f.packed ? 1 : 0,
+                    unpackedSize,
+                    unpackedCs);
             }
-
-        } else {
-
-            // This query will also cascade delete the relevant file entries
-            // See details in the schema.
-            _conn->execute(
-                "DELETE FROM " + _conn->sqlId("replica") +
-                "  WHERE "     + _conn->sqlEqual("worker",   info.worker()) +
-                "    AND "     + _conn->sqlEqual("database", info.database()) +
-                "    AND "     + _conn->sqlEqual("chunk",    info.chunk()));
         }
+        if (numFiles) _conn->execute(filesQuery);
 
-    } catch (database::mysql::DuplicateKeyError const&) {
-
-        // Replace the replica with a newer version
-
-        deleteReplicaInfoImpl(lock, info.worker(), info.database(), info.chunk());
-        saveReplicaInfoImpl(lock, info);
+        begin = end;
     }
 }
 
@@ -579,14 +709,19 @@ void DatabaseServicesMySQL::saveReplicaInfoCollectionImpl(util::Lock const& lock
 
     LOGS(_log, LOG_LVL_DEBUG, context << "new replicas group: 1");
 
-    WorkerDatabaseChunkMap<ReplicaInfo const*> newReplicas;
+    // Both maps share the dictionary to have their keys compared
+    auto const dictionary = NameDictionary::create();
+
+    FlatWorkerDatabaseChunkMap<ReplicaInfo const*> newReplicas(dictionary);
+    newReplicas.reserve(newReplicaInfoCollection.size());
     for (auto&& replica: newReplicaInfoCollection) {
         
         // Ignore replicas which are not in the specified context
         if (replica.worker() == worker and replica.database() == database) {
-            newReplicas.atWorker(replica.worker())
-                       .atDatabase(replica.database())
-                       .atChunk(replica.chunk()) = &replica;
+            newReplicas.insert(replica.worker(),
+                               replica.database(),
+                               replica.chunk(),
+                               &replica);
         }
     }
     
@@ -595,22 +730,29 @@ void DatabaseServicesMySQL::saveReplicaInfoCollectionImpl(util::Lock const& lock
     std::vector<ReplicaInfo> oldReplicaInfoCollection;
     findWorkerReplicasImpl(lock, oldReplicaInfoCollection, worker, database);
 
-    WorkerDatabaseChunkMap<ReplicaInfo const*> oldReplicas;
+    FlatWorkerDatabaseChunkMap<ReplicaInfo const*> oldReplicas(dictionary);
+    oldReplicas.reserve(oldReplicaInfoCollection.size());
     for (auto&& replica: oldReplicaInfoCollection) {
-        oldReplicas.atWorker(replica.worker())
-                   .atDatabase(replica.database())
-                   .atChunk(replica.chunk()) = &replica;
+        oldReplicas.insert(replica.worker(),
+                           replica.database(),
+                           replica.chunk(),
+                           &replica);
     }
 
-    // Find differences between the collections
+    // Find differences between the collections. The intersects are taken both
+    // ways to get the new and the old replica of each key at the same position.
 
-    WorkerDatabaseChunkMap<ReplicaInfo const*> inBoth;
+    FlatWorkerDatabaseChunkMap<ReplicaInfo const*> inBothNew;
+    FlatWorkerDatabaseChunkMap<ReplicaInfo const*> inBothOld;
     SemanticMaps::intersect(newReplicas,
                             oldReplicas,
-                            inBoth);
+                            inBothNew);
+    SemanticMaps::intersect(oldReplicas,
+                            newReplicas,
+                            inBothOld);
 
-    WorkerDatabaseChunkMap<ReplicaInfo const*> inNewReplicasOnly;
-    WorkerDatabaseChunkMap<ReplicaInfo const*> inOldReplicasOnly;
+    FlatWorkerDatabaseChunkMap<ReplicaInfo const*> inNewReplicasOnly;
+    FlatWorkerDatabaseChunkMap<ReplicaInfo const*> inOldReplicasOnly;
     SemanticMaps::diff2(newReplicas,
                         oldReplicas,
                         inNewReplicasOnly,
@@ -619,77 +761,70 @@ void DatabaseServicesMySQL::saveReplicaInfoCollectionImpl(util::Lock const& lock
     LOGS(_log, LOG_LVL_DEBUG, context << "*** replicas comparison summary *** "
          << " #new: " << newReplicaInfoCollection.size()
          << " #old: " << oldReplicaInfoCollection.size()
-         << " #in-both: " << SemanticMaps::count(inBoth)
+         << " #in-both: " << SemanticMaps::count(inBothNew)
          << " #new-only: " << SemanticMaps::count(inNewReplicasOnly)
          << " #old-only: " << SemanticMaps::count(inOldReplicasOnly));
 
     // Eiminate outdated replicas
-    
-    for (auto&& worker: inOldReplicasOnly.workerNames()) {
 
-        auto const& databases = inOldReplicasOnly.worker(worker);
-        for (auto&& database: databases.databaseNames()) {
-
-            auto const& chunks = databases.database(database);
-            for (auto&& chunk: chunks.chunkNumbers()) {
-                deleteReplicaInfoImpl(lock, worker, database, chunk);
-            }
-        }
+    std::vector<ReplicaInfo const*> replicas2delete;
+    replicas2delete.reserve(inOldReplicasOnly.size());
+    for (auto&& entry: inOldReplicasOnly) {
+        replicas2delete.push_back(entry.value);
     }
+    deleteReplicaInfosImpl(lock, replicas2delete);
 
     // Insert new replicas not present in the old collection
 
-    for (auto&& worker: inNewReplicasOnly.workerNames()) {
-
-        auto const& databases = inNewReplicasOnly.worker(worker);
-        for (auto&& database: databases.databaseNames()) {
-
-            auto const& chunks = databases.database(database);
-            for (auto&& chunk: chunks.chunkNumbers()) {
-                ReplicaInfo const* ptr = chunks.chunk(chunk);
-                saveReplicaInfoImpl(lock, *ptr);
-            }
-        }
+    std::vector<ReplicaInfo const*> replicas2save;
+    replicas2save.reserve(inNewReplicasOnly.size());
+    for (auto&& entry: inNewReplicasOnly) {
+        replicas2save.push_back(entry.value);
     }
 
     // Deep comparision of the replicas in the intersect area to see
     // which of those need to be updated.
 
-   for (auto&& worker: inBoth.workerNames()) {
+    auto oldItr = inBothOld.begin();
+    for (auto&& entry: inBothNew) {
+        ReplicaInfo const* newPtr = entry.value;
+        ReplicaInfo const* oldPtr = (oldItr++)->value;
 
-        auto const& newDatabases = newReplicas.worker(worker);
-        auto const& oldDatabases = oldReplicas.worker(worker);
-
-        auto const& databases = inBoth.worker(worker);
-        for (auto&& database: databases.databaseNames()) {
+        if (*newPtr != *oldPtr) replicas2save.push_back(newPtr);
+    }
+    saveReplicaInfosImpl(lock, replicas2save);
 
-            auto const& newChunks = newDatabases.database(database);
-            auto const& oldChunks = oldDatabases.database(database);
+    LOGS(_log, LOG_LVL_DEBUG, context << "** DONE **");
+}
 
-            auto const& chunks = databases.database(database);
-            for (auto&& chunk: chunks.chunkNumbers()) {
+void DatabaseServicesMySQL::deleteReplicaInfosImpl(util::Lock const& lock,
+                                                   std::vector<ReplicaInfo const*> const& infos) {
 
-                ReplicaInfo const* newPtr = newChunks.chunk(chunk);
-                ReplicaInfo const* oldPtr = oldChunks.chunk(chunk);
+    for (auto begin = infos.cbegin(); begin != infos.cend();) {
+        auto const end = begin + std::min(
+            ::maxReplicasPerStatement,
+            static_cast<size_t>(std::distance(begin, infos.cend())));
 
-                if (*newPtr != *oldPtr) {
-                    deleteReplicaInfoImpl(lock, worker, database, chunk);
-                    saveReplicaInfoImpl(lock, *newPtr);
-                }
-            }
-        }
+        _conn->execute("DELETE FROM " + _conn->sqlId("replica") +
+                       "  WHERE "     + sqlReplicaKeysIn(begin, end));
+        begin = end;
     }
-    LOGS(_log, LOG_LVL_DEBUG, context << "** DONE **");
 }
 
-void DatabaseServicesMySQL::deleteReplicaInfoImpl(util::Lock const& lock,
-                                                  std::string const& worker,
-                                                  std::string const& database,
-                                                  unsigned int chunk) {
-    _conn->execute("DELETE FROM " + _conn->sqlId("replica") +
-                   "  WHERE "     + _conn->sqlEqual("worker",   worker) +
-                   "    AND "     + _conn->sqlEqual("database", database) +
-                   "    AND "     + _conn->sqlEqual("chunk",    chunk));
+std::string DatabaseServicesMySQL::sqlReplicaKeysIn(
+                std::vector<ReplicaInfo const*>::const_iterator begin,
+                std::vector<ReplicaInfo const*>::const_iterator end) const {
+
+    std::string sql = "(" + _conn->sqlId("worker") + "," + _conn->sqlId("database") + "," +
+                      _conn->sqlId("chunk") + ") IN (";
+    for (auto itr = begin; itr != end; ++itr) {
+        ReplicaInfo const* ptr = *itr;
+        sql += (itr == begin ? "" : ",") + _conn->sqlPackValues(
+            ptr->worker(),
+            ptr->database(),
+            ptr->chunk());
+    }
+    return sql + ")";
 }
 
 void DatabaseServicesMySQL::findOldestReplicas(std::vector<ReplicaInfo>& replicas,
@@ -1037,6 +1172,239 @@ size_t DatabaseServicesMySQL::numOrphanChunks(std::string const& database,
 
 }
 
+uint64_t DatabaseServicesMySQL::chunkStatsCollectTime(std::string const& worker,
+                                                      std::string const& database) {
+    std::string const context =
+         "DatabaseServicesMySQL::chunkStatsCollectTime  worker: " + worker +
+         " database: " + database + " ";
+
+    LOGS(_log, LOG_LVL_DEBUG, context);
+
+    util::Lock lock(_mtx, context);
+
+    if (not _configuration->isKnownWorker(worker)) {
+        throw std::invalid_argument(context + "unknown worker");
+    }
+    if (not _configuration->isKnownDatabase(database)) {
+        throw std::invalid_argument(context + "unknown database");
+    }
+    try {
+        uint64_t result = 0;
+        _conn->execute(
+            [&](decltype(_conn) conn) {
+                conn->begin();
+                conn->execute(
+                    "SELECT " + conn->sqlId("collect_time") +
+                    "  FROM "  + conn->sqlId("chunk_stats_worker") +
+                    "  WHERE " + conn->sqlEqual("worker",   worker) +
+                    "    AND " + conn->sqlEqual("database", database));
+
+                // Always do this before extracting results in case of this lambda
+                // function gets executed more than once due to reconnects.
+                result = 0;
+
+                database::mysql::Row row;
+                while (conn->next(row)) row.get("collect_time", result);
+                conn->rollback();
+            }
+        );
+        LOGS(_log, LOG_LVL_DEBUG, context << "** DONE ** collect_time: " << result);
+        return result;
+    } catch (database::mysql::Error const& ex) {
+        LOGS(_log, LOG_LVL_ERROR, context << "failed, exception: " << ex.what());
+        if (_conn->inTransaction()) _conn->rollback();
+        throw;
+    }
+}
+
+void DatabaseServicesMySQL::saveChunkStats(std::string const& worker,
+                                           std::string const& database,
+                                           uint64_t collectTime,
+                                           ChunkStatsCollection const& stats) {
+    std::string const context =
+         "DatabaseServicesMySQL::saveChunkStats  worker: " + worker +
+         " database: " + database + " ";
+
+    LOGS(_log, LOG_LVL_DEBUG, context << "stats.size(): " << stats.size());
+
+    util::Lock lock(_mtx, context);
+
+    if (not _configuration->isKnownWorker(worker)) {
+        throw std::invalid_argument(context + "unknown worker");
+    }
+    if (not _configuration->isKnownDatabase(database)) {
+        throw std::invalid_argument(context + "unknown database");
+    }
+
+    // The sizes and the completion times are saved by separate statements
+    // since either may be missing from an entry. The time of the change of
+    // a row is assigned first, while the old values are still there to be
+    // compared with the new ones.
+
+    std::vector<ChunkStats const*> sizes;
+    std::vector<ChunkStats const*> scans;
+    for (auto&& entry: stats) {
+        if (entry.database != database) {
+            throw std::invalid_argument(context + "entry of another database: " + entry.database);
+        }
+        if (entry.hasSize) sizes.push_back(&entry);
+        if (entry.tasksCompleted != 0) scans.push_back(&entry);
+    }
+    auto changed = [this](std::vector<std::string> const& cols) {
+        std::string cond;
+        for (auto&& col: cols) {
+            cond += (cond.empty() ? "" : " OR ") + _conn->sqlId(col) + "<>VALUES(" + _conn->sqlId(col) + ")";
+        }
+        std::string sql = _conn->sqlId("collect_time") + "=IF(" + cond + ",VALUES(" +
+                          _conn->sqlId("collect_time") + ")," + _conn->sqlId("collect_time") + ")";
+        for (auto&& col: cols) {
+            sql += "," + _conn->sqlId(col) + "=VALUES(" + _conn->sqlId(col) + ")";
+        }
+        return sql;
+    };
+    std::vector<std::string> queries;
+    for (auto begin = sizes.cbegin(); begin != sizes.cend();) {
+        auto const end = begin + std::min(
+            ::maxReplicasPerStatement,
+            static_cast<size_t>(std::distance(begin, sizes.cend())));
+        std::string query =
+            "INSERT INTO " + _conn->sqlId("chunk_stats") + " (" +
+            _conn->sqlId("worker") + "," + _conn->sqlId("database") + "," +
+            _conn->sqlId("table") + "," + _conn->sqlId("chunk") + "," +
+            _conn->sqlId("num_rows") + "," + _conn->sqlId("data_size") + "," +
+            _conn->sqlId("index_size") + "," + _conn->sqlId("update_time") + "," +
+            _conn->sqlId("collect_time") + ") VALUES ";
+        for (auto itr = begin; itr != end; ++itr) {
+            ChunkStats const* ptr = *itr;
+            query += (itr == begin ? "" : ",") + _conn->sqlPackValues(
+                worker, database, ptr->table, ptr->chunk,
+                ptr->numRows, ptr->dataSize, ptr->indexSize, ptr->updateTime,
+                collectTime);
+        }
+        query += " ON DUPLICATE KEY UPDATE " +
+                 changed({"num_rows", "data_size", "index_size", "update_time"});
+        queries.push_back(query);
+        begin = end;
+    }
+    for (auto begin = scans.cbegin(); begin != scans.cend();) {
+        auto const end = begin + std::min(
+            ::maxReplicasPerStatement,
+            static_cast<size_t>(std::distance(begin, scans.cend())));
+        std::string query =
+            "INSERT INTO " + _conn->sqlId("chunk_stats") + " (" +
+            _conn->sqlId("worker") + "," + _conn->sqlId("database") + "," +
+            _conn->sqlId("table") + "," + _conn->sqlId("chunk") + "," +
+            _conn->sqlId("tasks_completed") + "," + _conn->sqlId("avg_scan_seconds") + "," +
+            _conn->sqlId("last_scan_seconds") + "," + _conn->sqlId("collect_time") + ") VALUES ";
+        for (auto itr = begin; itr != end; ++itr) {
+            ChunkStats const* ptr = *itr;
+            query += (itr == begin ? "" : ",") + _conn->sqlPackValues(
+                worker, database, ptr->table, ptr->chunk,
+                ptr->tasksCompleted, ptr->avgScanSeconds, ptr->lastScanSeconds,
+                collectTime);
+        }
+        query += " ON DUPLICATE KEY UPDATE " +
+                 changed({"tasks_completed", "avg_scan_seconds", "last_scan_seconds"});
+        queries.push_back(query);
+        begin = end;
+    }
+
+    // The rows of the chunks which are no longer at the worker
+    queries.push_back(
+        "DELETE " + _conn->sqlId("s") +
+        "  FROM " + _conn->sqlId("chunk_stats") + " AS " + _conn->sqlId("s") +
+        "  LEFT JOIN " + _conn->sqlId("replica") + " AS " + _conn->sqlId("r") +
+        "    ON "  + _conn->sqlId("r") + "." + _conn->sqlId("worker") + "=" +
+                     _conn->sqlId("s") + "." + _conn->sqlId("worker") +
+        "   AND "  + _conn->sqlId("r") + "." + _conn->sqlId("database") + "=" +
+                     _conn->sqlId("s") + "." + _conn->sqlId("database") +
+        "   AND "  + _conn->sqlId("r") + "." + _conn->sqlId("chunk") + "=" +
+                     _conn->sqlId("s") + "." + _conn->sqlId("chunk") +
+        "  WHERE " + _conn->sqlId("s") + "." + _conn->sqlEqual("worker", worker) +
+        "    AND " + _conn->sqlId("s") + "." + _conn->sqlEqual("database", database) +
+        "    AND " + _conn->sqlId("r") + "." + _conn->sqlId("id") + " IS NULL");
+
+    queries.push_back(
+        "INSERT INTO " + _conn->sqlId("chunk_stats_worker") +
+        " VALUES " + _conn->sqlPackValues(worker, database, collectTime) +
+        " ON DUPLICATE KEY UPDATE " + _conn->sqlId("collect_time") + "=VALUES(" +
+        _conn->sqlId("collect_time") + ")");
+
+    try {
+        _conn->execute(
+            [&](decltype(_conn) conn) {
+                conn->begin();
+                for (auto&& query: queries) conn->execute(query);
+                conn->commit();
+            }
+        );
+    } catch (database::mysql::Error const& ex) {
+        LOGS(_log, LOG_LVL_ERROR, context << "failed, exception: " << ex.what());
+        if (_conn->inTransaction()) _conn->rollback();
+        throw;
+    }
+    LOGS(_log, LOG_LVL_DEBUG, context << "** DONE **");
+}
+
+void DatabaseServicesMySQL::findChunkStats(ChunkStatsCollection& stats,
+                                           std::string const& database,
+                                           std::string const& table) {
+    std::string const context =
+         "DatabaseServicesMySQL::findChunkStats  database: " + database +
+         " table: " + table + " ";
+
+    LOGS(_log, LOG_LVL_DEBUG, context);
+
+    util::Lock lock(_mtx, context);
+
+    if (not _configuration->isKnownDatabase(database)) {
+        throw std::invalid_argument(context + "unknown database");
+    }
+    try {
+        _conn->execute(
+            [&](decltype(_conn) conn) {
+                conn->begin();
+                conn->execute(
+                    "SELECT * FROM " + conn->sqlId("chunk_stats") +
+                    "  WHERE " + conn->sqlEqual("database", database) +
+                    (table.empty() ? "" :
+                    "    AND " + conn->sqlEqual("table", table)) +
+                    "  ORDER BY " + conn->sqlId("table") + "," + conn->sqlId("chunk") + "," +
+                                    conn->sqlId("worker"));
+
+                // Always do this before extracting results in case of this lambda
+                // function gets executed more than once due to reconnects.
+                stats.clear();
+
+                database::mysql::Row row;
+                while (conn->next(row)) {
+                    ChunkStats entry;
+                    row.get("worker",            entry.worker);
+                    row.get("database",          entry.database);
+                    row.get("table",             entry.table);
+                    row.get("chunk",             entry.chunk);
+                    row.get("num_rows",          entry.numRows);
+                    row.get("data_size",         entry.dataSize);
+                    row.get("index_size",        entry.indexSize);
+                    row.get("update_time",       entry.updateTime);
+                    row.get("tasks_completed",   entry.tasksCompleted);
+                    row.get("avg_scan_seconds",  entry.avgScanSeconds);
+                    row.get("last_scan_seconds", entry.lastScanSeconds);
+                    row.get("collect_time",      entry.collectTime);
+                    entry.hasSize = entry.updateTime != 0 or entry.dataSize != 0;
+                    stats.push_back(entry);
+                }
+                conn->rollback();
+            }
+        );
+    } catch (database::mysql::Error const& ex) {
+        LOGS(_log, LOG_LVL_ERROR, context << "failed, exception: " << ex.what());
+        if (_conn->inTransaction()) _conn->rollback();
+        throw;
+    }
+    LOGS(_log, LOG_LVL_DEBUG, context << "** DONE ** stats.size(): " << stats.size());
+}
+
 void DatabaseServicesMySQL::findReplicasImpl(util::Lock const& lock,
                                              std::vector<ReplicaInfo>& replicas,
                                              std::string const& query) {
@@ -1176,6 +1544,10 @@ void DatabaseServicesMySQL::findReplicaFilesImpl(util::Lock const& lock,
                 std::string cs;
                 uint64_t    beginCreateTime;
                 uint64_t    endCreateTime;
+                std::string csAlgorithm;
+                bool        packed;
+                uint64_t    unpackedSize;
+                std::string unpackedCs;
     
                 row.get("replica_id",        replicaId);
                 row.get("name",              name);
@@ -1184,6 +1556,10 @@ void DatabaseServicesMySQL::findReplicaFilesImpl(util::Lock const& lock,
                 row.get("cs",                cs);
                 row.get("begin_create_time", beginCreateTime);
                 row.get("end_create_time",   endCreateTime);
+                row.get("cs_algorithm",      csAlgorithm);
+                row.get("packed",            packed);
+                row.get("unpacked_size",     unpackedSize);
+                row.get("unpacked_cs",       unpackedCs);
 
                 // Save files to the current replica if a change in the replica identifier
                 // has been detected (unless just started iterating over the result set).
@@ -1205,7 +1581,11 @@ void DatabaseServicesMySQL::findReplicaFilesImpl(util::Lock const& lock,
                         cs,
                         beginCreateTime,
                         endCreateTime,
-                        size
+                        size,
+                        csAlgorithm,
+                        packed,
+                        unpackedSize,
+                        unpackedCs
                     }
                 );
             }
@@ -122,6 +122,19 @@ public:
                                    std::string const& database,
                                    ReplicaInfoCollection const& newReplicaInfoCollection) final;
 
+    /**
+     * @see DatabaseServices::saveReplicaInfos()
+     */
+    void saveReplicaInfos(std::vector<ReplicaInfo> const& infos) final;
+
+    /**
+     * The updates are saved synchronously by this class. Hence there is
+     * nothing to wait for.
+     *
+     * @see DatabaseServices::flushReplicaInfo()
+     */
+    void flushReplicaInfo() final {}
+
     /**
      * @see DatabaseServices::findOldestReplica()
      */
@@ -171,6 +184,27 @@ public:
     size_t numOrphanChunks(std::string const& database,
                            std::vector<std::string> const& uniqueOnWorkers) final;
 
+    /**
+     * @see DatabaseServices::chunkStatsCollectTime()
+     */
+    uint64_t chunkStatsCollectTime(std::string const& worker,
+                                   std::string const& database) final;
+
+    /**
+     * @see DatabaseServices::saveChunkStats()
+     */
+    void saveChunkStats(std::string const& worker,
+                        std::string const& database,
+                        uint64_t collectTime,
+                        ChunkStatsCollection const& stats) final;
+
+    /**
+     * @see DatabaseServices::findChunkStats()
+     */
+    void findChunkStats(ChunkStatsCollection& stats,
+                        std::string const& database,
+                        std::string const& table=std::string()) final;
+
 private:
 
     /**
@@ -189,13 +223,15 @@ private:
                                 std::string const& database);
 
     /**
-     * Actual implementation of the replica update algorithm.
+     * Actual implementation of the replica update algorithm. Replicas are
+     * processed in groups of a limited size. Each group is saved with
+     * a few multi-row statements.
      *
-     * @param lock - lock on a mutex must be acquired before calling this method
-     * @param info - replica to be added/updated or deleted
+     * @param lock  - lock on a mutex must be acquired before calling this method
+     * @param infos - replicas to be added/updated or deleted (one entry per replica)
      */
-    void saveReplicaInfoImpl(util::Lock const& lock,
-                             ReplicaInfo const& info);
+    void saveReplicaInfosImpl(util::Lock const& lock,
+                              std::vector<ReplicaInfo const*> const& infos);
 
     /**
      * Actual implementation of the multiple replicas update algorithm.
@@ -211,17 +247,25 @@ private:
                                        ReplicaInfoCollection const& newReplicaInfoCollection);
 
     /**
-     * Delete a replica from the database.
+     * Delete replicas from the database. Replicas are processed in groups
+     * of a limited size, one statement per group.
      *
-     * @param lock     - lock on a mutex must be acquired before calling this method
-     * @param worker   - worker name
-     * @param database - database name
-     * @param chunk    - chunk to be removed
+     * @param lock  - lock on a mutex must be acquired before calling this method
+     * @param infos - replicas to be removed
+     */
+    void deleteReplicaInfosImpl(util::Lock const& lock,
+                                std::vector<ReplicaInfo const*> const& infos);
+
+    /**
+     * @param begin - the first replica of a group
+     * @param end   - the replica past the last one of the group
+     *
+     * @return the SQL condition selecting rows of the specified replicas
+     *         from table 'replica':
+     *         (`worker`,`database`,`chunk`) IN ((...),(...),...)
      */
-    void deleteReplicaInfoImpl(util::Lock const& lock,
-                               std::string const& worker,
-                               std::string const& database,
-                               unsigned int chunk);
+    std::string sqlReplicaKeysIn(std::vector<ReplicaInfo const*>::const_iterator begin,
+                                 std::vector<ReplicaInfo const*>::const_iterator end) const;
     /**
      * Fetch replicas satisfying the specified query
      *
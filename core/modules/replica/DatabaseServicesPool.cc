@@ -24,7 +24,10 @@
 #include "replica/DatabaseServicesPool.h"
 
 // System headers
+#include <algorithm>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 // Qserv headers
 #include "lsst/log/Log.h"
@@ -34,6 +37,9 @@ namespace {
 
 LOG_LOGGER _log = LOG_GET("lsst.qserv.replica.DatabaseServicesPool");
 
+/// The maximum number of replica updates saved by one transaction
+size_t const maxReplicaInfoBatchSize = 1024;
+
 } /// namespace
 
 namespace lsst {
@@ -85,7 +91,12 @@ DatabaseServicesPool::Ptr DatabaseServicesPool::create(Configuration::Ptr const&
 }
 
 DatabaseServicesPool::DatabaseServicesPool(Configuration::Ptr const& configuration)
-    :   DatabaseServices() {
+    :   DatabaseServices(),
+        // Leave at least one service for other operations
+        _numReplicaInfoWriters(std::max(static_cast<size_t>(1),
+                                        configuration->databaseServicesPoolSize() / 2)),
+        _replicaInfoWritersStarted(false),
+        _lastReplicaInfoSeq(0) {
 
     for (size_t i = 0; i < configuration->databaseServicesPoolSize(); ++i) {
         _availableServices.push_back(DatabaseServices::create(configuration));
@@ -141,14 +152,121 @@ void DatabaseServicesPool::updateRequestState(Request const& request,
 
 void DatabaseServicesPool::saveReplicaInfo(ReplicaInfo const& info) {
 
+    std::string const context = "DatabaseServicesPool::saveReplicaInfo  ";
+
+    LOGS(_log, LOG_LVL_DEBUG, context);
+
+    std::unique_lock<std::mutex> lock(_replicaInfoMtx);
+
+    if (not _replicaInfoWritersStarted) {
+        _replicaInfoWritersStarted = true;
+        auto self = shared_from_base<DatabaseServicesPool>();
+        for (size_t i = 0; i < _numReplicaInfoWriters; ++i) {
+            std::thread([self]() { self->replicaInfoWriter(); }).detach();
+        }
+    }
+
+    // Replace the previous update of the replica (if any) which hasn't
+    // been picked by a writer yet.
+
+    uint64_t const seq = ++_lastReplicaInfoSeq;
+    _unsavedReplicaInfoSeqs.insert(seq);
+
+    ReplicaKey const key = std::make_tuple(info.worker(), info.database(), info.chunk());
+    auto itr = _pendingReplicaInfo.find(key);
+    if (itr == _pendingReplicaInfo.end()) {
+        _pendingReplicaInfo.emplace(key, PendingReplicaInfo{info, seq});
+    } else {
+        _unsavedReplicaInfoSeqs.erase(itr->second.seq);
+        itr->second = PendingReplicaInfo{info, seq};
+    }
+    lock.unlock();
+    _replicaInfoPending.notify_one();
+}
+
+void DatabaseServicesPool::saveReplicaInfos(std::vector<ReplicaInfo> const& infos) {
+
     ServiceAllocator service(shared_from_base<DatabaseServicesPool>());
-    service()->saveReplicaInfo(info);
+    service()->saveReplicaInfos(infos);
+}
+
+void DatabaseServicesPool::flushReplicaInfo() {
+
+    std::string const context = "DatabaseServicesPool::flushReplicaInfo  ";
+
+    LOGS(_log, LOG_LVL_DEBUG, context);
+
+    std::unique_lock<std::mutex> lock(_replicaInfoMtx);
+
+    uint64_t const seq = _lastReplicaInfoSeq;
+    _replicaInfoSaved.wait(lock, [this, seq]() {
+        return _unsavedReplicaInfoSeqs.empty() or (*_unsavedReplicaInfoSeqs.begin() > seq);
+    });
+}
+
+void DatabaseServicesPool::replicaInfoWriter() {
+
+    std::string const context = "DatabaseServicesPool::replicaInfoWriter  ";
+
+    while (true) {
+
+        // Pick the updates of replicas which aren't being saved by other writers
+
+        std::vector<ReplicaInfo> infos;
+        std::vector<ReplicaKey> keys;
+        std::vector<uint64_t> seqs;
+        {
+            std::unique_lock<std::mutex> lock(_replicaInfoMtx);
+            _replicaInfoPending.wait(lock, [this]() {
+                for (auto&& entry: _pendingReplicaInfo) {
+                    if (not _replicaInfoInProgress.count(entry.first)) return true;
+                }
+                return false;
+            });
+            for (auto itr = _pendingReplicaInfo.begin();
+                 (itr != _pendingReplicaInfo.end()) and (infos.size() < ::maxReplicaInfoBatchSize);) {
+                if (_replicaInfoInProgress.count(itr->first)) {
+                    ++itr;
+                    continue;
+                }
+                _replicaInfoInProgress.insert(itr->first);
+                infos.push_back(itr->second.info);
+                keys.push_back(itr->first);
+                seqs.push_back(itr->second.seq);
+                itr = _pendingReplicaInfo.erase(itr);
+            }
+        }
+        LOGS(_log, LOG_LVL_DEBUG, context << "num.replicas: " << infos.size());
+
+        // Failed updates can't be reported to the clients which submitted
+        // them. They will be fixed by the next scan of the replicas.
+
+        try {
+            ServiceAllocator service(shared_from_base<DatabaseServicesPool>());
+            service()->saveReplicaInfos(infos);
+        } catch (std::exception const& ex) {
+            LOGS(_log, LOG_LVL_ERROR, context << "failed to save " << infos.size()
+                 << " replicas, exception: " << ex.what());
+        }
+        {
+            std::unique_lock<std::mutex> lock(_replicaInfoMtx);
+            for (auto&& key: keys) _replicaInfoInProgress.erase(key);
+            for (auto&& seq: seqs) _unsavedReplicaInfoSeqs.erase(seq);
+        }
+
+        // More updates may be ready for writers after releasing the replicas
+
+        _replicaInfoPending.notify_all();
+        _replicaInfoSaved.notify_all();
+    }
 }
 
 void DatabaseServicesPool::saveReplicaInfoCollection(std::string const& worker,
                                                      std::string const& database,
                                                      ReplicaInfoCollection const& newReplicaInfoCollection) {
 
+    flushReplicaInfo();
+
     ServiceAllocator service(shared_from_base<DatabaseServicesPool>());
     service()->saveReplicaInfoCollection(worker,
                                          database,
@@ -159,6 +277,8 @@ void DatabaseServicesPool::findOldestReplicas(std::vector<ReplicaInfo>& replicas
                                               size_t maxReplicas,
                                               bool enabledWorkersOnly) {
 
+    flushReplicaInfo();
+
     ServiceAllocator service(shared_from_base<DatabaseServicesPool>());
     service()->findOldestReplicas(replicas,
                                   maxReplicas,
@@ -170,6 +290,8 @@ void DatabaseServicesPool::findReplicas(std::vector<ReplicaInfo>& replicas,
                                         std::string const& database,
                                         bool enabledWorkersOnly) {
 
+    flushReplicaInfo();
+
     ServiceAllocator service(shared_from_base<DatabaseServicesPool>());
     service()->findReplicas(replicas,
                             chunk,
@@ -181,6 +303,8 @@ void DatabaseServicesPool::findWorkerReplicas(std::vector<ReplicaInfo>& replicas
                                               std::string const& worker,
                                               std::string const& database) {
 
+    flushReplicaInfo();
+
     ServiceAllocator service(shared_from_base<DatabaseServicesPool>());
     service()->findWorkerReplicas(replicas,
                                   worker,
@@ -189,6 +313,9 @@ void DatabaseServicesPool::findWorkerReplicas(std::vector<ReplicaInfo>& replicas
 
 uint64_t DatabaseServicesPool::numWorkerReplicas(std::string const& worker,
                                                  std::string const& database) {
+
+    flushReplicaInfo();
+
     ServiceAllocator service(shared_from_base<DatabaseServicesPool>());
     return service()->numWorkerReplicas(worker,
                                         database);
@@ -199,6 +326,8 @@ void DatabaseServicesPool::findWorkerReplicas(std::vector<ReplicaInfo>& replicas
                                               std::string const& worker,
                                               std::string const& databaseFamily) {
 
+    flushReplicaInfo();
+
     ServiceAllocator service(shared_from_base<DatabaseServicesPool>());
     service()->findWorkerReplicas(replicas,
                                   chunk,
@@ -210,6 +339,8 @@ std::map<unsigned int, size_t> DatabaseServicesPool::actualReplicationLevel(
                                     std::string const& database,
                                     std::vector<std::string> const& workersToExclude) {
 
+    flushReplicaInfo();
+
     ServiceAllocator service(shared_from_base<DatabaseServicesPool>());
     return service()->actualReplicationLevel(database,
                                              workersToExclude);
@@ -219,12 +350,50 @@ std::map<unsigned int, size_t> DatabaseServicesPool::actualReplicationLevel(
 size_t DatabaseServicesPool::numOrphanChunks(std::string const& database,
                                              std::vector<std::string> const& uniqueOnWorkers) {
 
+    flushReplicaInfo();
+
     ServiceAllocator service(shared_from_base<DatabaseServicesPool>());
     return service()->numOrphanChunks(database,
                                       uniqueOnWorkers);
 }
 
 
+uint64_t DatabaseServicesPool::chunkStatsCollectTime(std::string const& worker,
+                                                     std::string const& database) {
+
+    ServiceAllocator service(shared_from_base<DatabaseServicesPool>());
+    return service()->chunkStatsCollectTime(worker,
+                                            database);
+}
+
+
+void DatabaseServicesPool::saveChunkStats(std::string const& worker,
+                                          std::string const& database,
+                                          uint64_t collectTime,
+                                          ChunkStatsCollection const& stats) {
+
+    // The rows of the chunks which no longer have replicas are removed
+    flushReplicaInfo();
+
+    ServiceAllocator service(shared_from_base<DatabaseServicesPool>());
+    service()->saveChunkStats(worker,
+                              database,
+                              collectTime,
+                              stats);
+}
+
+
+void DatabaseServicesPool::findChunkStats(ChunkStatsCollection& stats,
+                                          std::string const& database,
+                                          std::string const& table) {
+
+    ServiceAllocator service(shared_from_base<DatabaseServicesPool>());
+    service()->findChunkStats(stats,
+                              database,
+                              table);
+}
+
+
 DatabaseServices::Ptr DatabaseServicesPool::allocateService() {
 
     std::string const context = "DatabaseServicesPool::allocateService  ";
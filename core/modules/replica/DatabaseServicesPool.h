@@ -30,8 +30,11 @@
 
 // System headers
 #include <condition_variable>
+#include <map>
 #include <mutex>
 #include <list>
+#include <set>
+#include <tuple>
 
 // Qserv headers
 #include "replica/DatabaseServices.h"
@@ -45,6 +48,12 @@ namespace replica {
 /**
   * Class DatabaseServicesPool is a pool of service objects.
   *
+  * Replica updates submitted with method saveReplicaInfo() are buffered
+  * and saved in batches by a few writer threads using the service objects
+  * of the pool. Updates to the same replica are coalesced while waiting
+  * in the buffer. The methods of the class which read replicas wait for
+  * the updates submitted before the call to be saved.
+  *
   * @see class DatabaseServices
   */
 class DatabaseServicesPool
@@ -117,6 +126,16 @@ public:
      */
     void saveReplicaInfo(ReplicaInfo const& info) final;
 
+    /**
+     * @see DatabaseServices::saveReplicaInfos()
+     */
+    void saveReplicaInfos(std::vector<ReplicaInfo> const& infos) final;
+
+    /**
+     * @see DatabaseServices::flushReplicaInfo()
+     */
+    void flushReplicaInfo() final;
+
     /**
      * @see DatabaseServices::saveReplicaInfoCollection()
      */
@@ -173,6 +192,27 @@ public:
     size_t numOrphanChunks(std::string const& database,
                            std::vector<std::string> const& uniqueOnWorkers) final;
 
+    /**
+     * @see DatabaseServices::chunkStatsCollectTime()
+     */
+    uint64_t chunkStatsCollectTime(std::string const& worker,
+                                   std::string const& database) final;
+
+    /**
+     * @see DatabaseServices::saveChunkStats()
+     */
+    void saveChunkStats(std::string const& worker,
+                        std::string const& database,
+                        uint64_t collectTime,
+                        ChunkStatsCollection const& stats) final;
+
+    /**
+     * @see DatabaseServices::findChunkStats()
+     */
+    void findChunkStats(ChunkStatsCollection& stats,
+                        std::string const& database,
+                        std::string const& table=std::string()) final;
+
 private:
     /**
      * Construct the object.
@@ -203,8 +243,25 @@ private:
      */
     void releaseService(DatabaseServices::Ptr const& service);
 
+    /**
+     * The main loop of a thread saving the buffered replica updates
+     */
+    void replicaInfoWriter();
+
 private:
 
+    /// The key of a replica: worker, database and chunk
+    typedef std::tuple<std::string, std::string, unsigned int> ReplicaKey;
+
+    /// A replica update waiting in the buffer
+    struct PendingReplicaInfo {
+
+        ReplicaInfo info;
+
+        /// The sequence number of the latest update of the replica
+        uint64_t seq;
+    };
+
     /// Service objects which are available
     std::list<DatabaseServices::Ptr> _availableServices;
 
@@ -218,6 +275,35 @@ private:
     /// The condition variable for notifying clients waiting for the next
     /// available service.
     std::condition_variable _available;
+
+    /// The number of writer threads to be launched by the first replica update
+    size_t const _numReplicaInfoWriters;
+
+    /// The flag is set after launching the writer threads
+    bool _replicaInfoWritersStarted;
+
+    /// The sequence number of the last replica update submitted
+    uint64_t _lastReplicaInfoSeq;
+
+    /// Replica updates waiting to be picked by writers
+    std::map<ReplicaKey, PendingReplicaInfo> _pendingReplicaInfo;
+
+    /// Replicas which are being saved by writers. Their subsequent updates
+    /// are held in the buffer until then to preserve the order of the updates.
+    std::set<ReplicaKey> _replicaInfoInProgress;
+
+    /// The sequence numbers of the updates which haven't been saved yet
+    std::set<uint64_t> _unsavedReplicaInfoSeqs;
+
+    /// The mutex guarding the replica updates buffer
+    std::mutex _replicaInfoMtx;
+
+    /// The condition variable for notifying writers on new updates
+    std::condition_variable _replicaInfoPending;
+
+    /// The condition variable for notifying clients waiting for updates
+    /// to be saved
+    std::condition_variable _replicaInfoSaved;
 };
 
 }}} // namespace lsst::qserv::replica
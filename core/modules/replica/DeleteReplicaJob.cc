@@ -88,9 +88,25 @@ DeleteReplicaJob::Ptr DeleteReplicaJob::create(std::string const& databaseFamily
                                                    std::string const& parentJobId,
                                                    CallbackType const& onFinish,
                                                    Job::Options const& options) {
+    return DeleteReplicaJob::create(databaseFamily,
+                                    std::vector<unsigned int>{chunk},
+                                    worker,
+                                    controller,
+                                    parentJobId,
+                                    onFinish,
+                                    options);
+}
+
+DeleteReplicaJob::Ptr DeleteReplicaJob::create(std::string const& databaseFamily,
+                                                   std::vector<unsigned int> const& chunks,
+                                                   std::string const& worker,
+                                                   Controller::Ptr const& controller,
+                                                   std::string const& parentJobId,
+                                                   CallbackType const& onFinish,
+                                                   Job::Options const& options) {
     return DeleteReplicaJob::Ptr(
         new DeleteReplicaJob(databaseFamily,
-                             chunk,
+                             chunks,
                              worker,
                              controller,
                              parentJobId,
@@ -99,7 +115,7 @@ DeleteReplicaJob::Ptr DeleteReplicaJob::create(std::string const& databaseFamily
 }
 
 DeleteReplicaJob::DeleteReplicaJob(std::string const& databaseFamily,
-                                   unsigned int chunk,
+                                   std::vector<unsigned int> const& chunks,
                                    std::string const& worker,
                                    Controller::Ptr const& controller,
                                    std::string const& parentJobId,
@@ -110,9 +126,15 @@ DeleteReplicaJob::DeleteReplicaJob(std::string const& databaseFamily,
             "DELETE_REPLICA",
             options),
         _databaseFamily(databaseFamily),
-        _chunk(chunk),
+        _chunks(chunks),
         _worker(worker),
-        _onFinish(onFinish) {
+        _onFinish(onFinish),
+        _numQservPending(0) {
+
+    if (chunks.empty()) {
+        throw std::invalid_argument(
+                "DeleteReplicaJob::" + std::string(__func__) + "  no chunks to delete");
+    }
 }
 
 DeleteReplicaJobResult const& DeleteReplicaJob::getReplicaData() const {
@@ -130,6 +152,9 @@ std::list<std::pair<std::string,std::string>> DeleteReplicaJob::extendedPersiste
     result.emplace_back("database_family", databaseFamily());
     result.emplace_back("chunk",           std::to_string(chunk()));
     result.emplace_back("worker",          worker());
+    if (_chunks.size() > 1) {
+        result.emplace_back("num_chunks", std::to_string(_chunks.size()));
+    }
     return result;
 }
 
@@ -165,11 +190,15 @@ void DeleteReplicaJob::startImpl(util::Lock const& lock) {
     //    see if the chunk is available on a source node.
 
     try {
-        controller()->serviceProvider()->databaseServices()->findWorkerReplicas(
-            _replicas,
-            chunk(),
-            worker(),
-            databaseFamily());
+        for (auto chunk: chunks()) {
+            std::vector<ReplicaInfo> replicas;
+            controller()->serviceProvider()->databaseServices()->findWorkerReplicas(
+                replicas,
+                chunk,
+                worker(),
+                databaseFamily());
+            _replicas.insert(_replicas.end(), replicas.begin(), replicas.end());
+        }
 
     } catch (std::invalid_argument const& ex) {
 
@@ -221,12 +250,14 @@ void DeleteReplicaJob::startImpl(util::Lock const& lock) {
 
     } else {
 
-        // Notify Qserv first. Then start once a confirmation is received
+        // Notify Qserv first (for each chunk). Then start once all confirmations
+        // are received
 
-        std::vector<std::string> databases;
+        std::map<unsigned int, std::vector<std::string>> chunk2databases;
         for (auto&& replica: _replicas) {
-            databases.push_back(replica.database());
+            chunk2databases[replica.chunk()].push_back(replica.database());
         }
+        _numQservPending = chunk2databases.size();
 
         auto self = shared_from_base<DeleteReplicaJob>();
 
@@ -235,37 +266,41 @@ void DeleteReplicaJob::startImpl(util::Lock const& lock) {
                                     // corresponding worker management service for
                                     // specific detail on what "remove" means in
                                     // that service's context.
-        qservRemoveReplica(
-            lock,
-            chunk(),
-            databases,
-            worker(),
-            force,
-            [self] (RemoveReplicaQservMgtRequest::Ptr const& request) {
-
-                util::Lock lock(self->_mtx, self->context() + "startImpl:qservRemoveReplica");
-
-                switch (request->extendedState()) {
-
-                    // If there is a solid confirmation from Qserv on source node that the replica
-                    // is not being used and it won't be used then it's safe to proceed with
-                    // the second stage of requests to actually eliminate replica's
-                    // files from the source worker.
-                    case QservMgtRequest::ExtendedState::SUCCESS:
-                        self->beginDeleteReplica(lock);
-                        return;
-
-                    // Otherwise set an appropriate status of the operation, finish them
-                    // job and notify the caller.
-                    case QservMgtRequest::ExtendedState::SERVER_CHUNK_IN_USE:
-                        self->finish(lock, ExtendedState::QSERV_CHUNK_IN_USE);
-                        break;
-                    default:
-                        self->finish(lock, ExtendedState::QSERV_FAILED);
-                        break;
+        for (auto&& entry: chunk2databases) {
+            qservRemoveReplica(
+                lock,
+                entry.first,
+                entry.second,
+                worker(),
+                force,
+                [self] (RemoveReplicaQservMgtRequest::Ptr const& request) {
+
+                    util::Lock lock(self->_mtx, self->context() + "startImpl:qservRemoveReplica");
+
+                    if (self->state() == State::FINISHED) return;
+
+                    switch (request->extendedState()) {
+
+                        // If there is a solid confirmation from Qserv on source node that the replica
+                        // is not being used and it won't be used then it's safe to proceed with
+                        // the second stage of requests to actually eliminate replica's
+                        // files from the source worker.
+                        case QservMgtRequest::ExtendedState::SUCCESS:
+                            if (0 == --(self->_numQservPending)) self->beginDeleteReplica(lock);
+                            return;
+
+                        // Otherwise set an appropriate status of the operation, finish them
+                        // job and notify the caller.
+                        case QservMgtRequest::ExtendedState::SERVER_CHUNK_IN_USE:
+                            self->finish(lock, ExtendedState::QSERV_CHUNK_IN_USE);
+                            break;
+                        default:
+                            self->finish(lock, ExtendedState::QSERV_FAILED);
+                            break;
+                    }
                 }
-            }
-        );
+            );
+        }
     }
     setState(lock, State::IN_PROGRESS);
 }
@@ -306,14 +341,19 @@ void DeleteReplicaJob::beginDeleteReplica(util::Lock const& lock) {
     auto self = shared_from_base<DeleteReplicaJob>();
 
     // VERY IMPORTANT: the requests are sent for participating databases
-    // only because some catalogs may not have a full coverage
+    // only because some catalogs may not have a full coverage. The chunks
+    // of each database are deleted by a single request.
 
+    std::map<std::string, std::vector<unsigned int>> database2chunks;
     for (auto&& replica: _replicas) {
+        database2chunks[replica.database()].push_back(replica.chunk());
+    }
+    for (auto&& entry: database2chunks) {
         DeleteRequest::Ptr ptr =
-            controller()->deleteReplica(
+            controller()->deleteReplicas(
                 worker(),
-                replica.database(),
-                chunk(),
+                entry.first,
+                entry.second,
                 [self] (DeleteRequest::Ptr ptr) {
                     self->onRequestFinish(ptr);
                 },
@@ -348,8 +388,10 @@ void DeleteReplicaJob::onRequestFinish(DeleteRequest::Ptr const& request) {
 
     // Update stats
     if (request->extendedState() == Request::ExtendedState::SUCCESS) {
-        _replicaData.replicas.push_back(request->responseData());
-        _replicaData.chunks[chunk()][request->database()][worker()] = request->responseData();
+        for (auto&& replicaInfo: request->batchResponseData()) {
+            _replicaData.replicas.push_back(replicaInfo);
+            _replicaData.chunks[replicaInfo.chunk()][request->database()][worker()] = replicaInfo;
+        }
     }
 
     // Evaluate the status of on-going operations to see if the job
@@ -61,7 +61,9 @@ struct DeleteReplicaJobResult {
 
 /**
   * Class DeleteReplicaJob represents a tool which will delete a chunk replica
-  * from a worker.
+  * from a worker. A job may also delete replicas of many chunks from the same
+  * worker at once, in which case a single request deleting all chunks is sent
+  * for each database.
   */
 class DeleteReplicaJob
     :   public Job  {
@@ -103,6 +105,23 @@ public:
                       CallbackType const& onFinish,
                       Job::Options const& options = defaultOptions());
 
+    /**
+     * Create a job deleting replicas of many chunks from the same worker
+     *
+     * @param chunks - the chunk numbers (can't be empty)
+     *
+     * @see DeleteReplicaJob::create() for the other parameters
+     *
+     * @throws std::invalid_argument - if no chunks were given
+     */
+    static Ptr create(std::string const& databaseFamily,
+                      std::vector<unsigned int> const& chunks,
+                      std::string const& worker,
+                      Controller::Ptr const& controller,
+                      std::string const& parentJobId,
+                      CallbackType const& onFinish,
+                      Job::Options const& options = defaultOptions());
+
     // Default construction and copy semantics are prohibited
 
     DeleteReplicaJob() = delete;
@@ -114,8 +133,11 @@ public:
     /// @return the name of a database family
     std::string const& databaseFamily() const { return _databaseFamily; }
 
-    ///@return the chunk number
-    unsigned int chunk() const { return _chunk; }
+    ///@return the chunk number (the first one if many chunks are deleted)
+    unsigned int chunk() const { return _chunks.front(); }
+
+    /// @return all chunks deleted by the job
+    std::vector<unsigned int> const& chunks() const { return _chunks; }
 
     /// @return the name of a source worker where the affected replica is residing
     std::string const& worker() const { return _worker; }
@@ -152,7 +174,7 @@ protected:
      * @see DeleteReplicaJob::create()
      */
     DeleteReplicaJob(std::string const& databaseFamily,
-                     unsigned int chunk,
+                     std::vector<unsigned int> const& chunks,
                      std::string const& worker,
                      Controller::Ptr const& controller,
                      std::string const& parentJobId,
@@ -194,8 +216,8 @@ protected:
     /// The name of a database family
     std::string const _databaseFamily;
 
-    /// The chunk number
-    unsigned int const _chunk;
+    /// The chunk numbers
+    std::vector<unsigned int> const _chunks;
 
     /// The name of a worker where the affected replica is residing
     std::string const _worker;
@@ -209,6 +231,9 @@ protected:
     /// A collection of the replica deletion requests implementing the operation
     std::vector<DeleteRequest::Ptr> _requests;
 
+    /// The number of chunks still waiting for the confirmation from Qserv
+    size_t _numQservPending;
+
     /// The result of the operation (gets updated as requests are finishing)
     DeleteReplicaJobResult _replicaData;
 };
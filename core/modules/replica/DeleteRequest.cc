@@ -54,7 +54,7 @@ DeleteRequest::Ptr DeleteRequest::create(ServiceProvider::Ptr const& serviceProv
                                          boost::asio::io_service& io_service,
                                          std::string const& worker,
                                          std::string const& database,
-                                         unsigned int  chunk,
+                                         std::vector<unsigned int> const& chunks,
                                          CallbackType const& onFinish,
                                          int  priority,
                                          bool keepTracking,
@@ -66,7 +66,7 @@ DeleteRequest::Ptr DeleteRequest::create(ServiceProvider::Ptr const& serviceProv
             io_service,
             worker,
             database,
-            chunk,
+            chunks,
             onFinish,
             priority,
             keepTracking,
@@ -78,7 +78,7 @@ DeleteRequest::DeleteRequest(ServiceProvider::Ptr const& serviceProvider,
                              boost::asio::io_service& io_service,
                              std::string const& worker,
                              std::string const& database,
-                             unsigned int  chunk,
+                             std::vector<unsigned int> const& chunks,
                              CallbackType const& onFinish,
                              int  priority,
                              bool keepTracking,
@@ -93,10 +93,15 @@ DeleteRequest::DeleteRequest(ServiceProvider::Ptr const& serviceProvider,
                          allowDuplicate,
                          messenger),
         _database(database),
-        _chunk(chunk),
+        _chunks(chunks),
         _onFinish(onFinish) {
 
     Request::serviceProvider()->assertDatabaseIsValid(database);
+
+    if (chunks.empty()) {
+        throw std::invalid_argument(
+                "DeleteRequest::" + std::string(__func__) + "  no chunks to delete");
+    }
 }
 
 void DeleteRequest::startImpl(util::Lock const& lock) {
@@ -119,7 +124,9 @@ void DeleteRequest::startImpl(util::Lock const& lock) {
     message.set_priority(priority());
     message.set_database(database());
     message.set_chunk(chunk());
-
+    for (size_t i = 1; i < _chunks.size(); ++i) {
+        message.add_extra_chunks(_chunks[i]);
+    }
     buffer()->serialize(message);
 
     send(lock);
@@ -246,6 +253,12 @@ void DeleteRequest::analyze(bool success,
 
     _replicaInfo = ReplicaInfo(&(message.replica_info()));
 
+    _batchReplicaInfo.clear();
+    _batchReplicaInfo.push_back(_replicaInfo);
+    for (auto&& info: message.extra_replica_info()) {
+        _batchReplicaInfo.emplace_back(&info);
+    }
+
     // Extract target request type-specific parameters from the response
     if (message.has_request()) {
         _targetRequestParams = DeleteRequestParams(message.request());
@@ -254,8 +267,10 @@ void DeleteRequest::analyze(bool success,
 
         case proto::ReplicationStatus::SUCCESS:
 
-            // Save the replica state
-            serviceProvider()->databaseServices()->saveReplicaInfo(_replicaInfo);
+            // Save the replica states
+            for (auto&& info: _batchReplicaInfo) {
+                serviceProvider()->databaseServices()->saveReplicaInfo(info);
+            }
 
             finish(lock, SUCCESS);
             break;
@@ -322,6 +337,9 @@ std::list<std::pair<std::string,std::string>> DeleteRequest::extendedPersistentS
     std::list<std::pair<std::string,std::string>> result;
     result.emplace_back("database", database());
     result.emplace_back("chunk",    std::to_string(chunk()));
+    if (_chunks.size() > 1) {
+        result.emplace_back("num_chunks", std::to_string(_chunks.size()));
+    }
     return result;
 }
 
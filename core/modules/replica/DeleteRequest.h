@@ -26,6 +26,7 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 // Qserv headers
 #include "proto/replication.pb.h"
@@ -68,7 +69,10 @@ public:
     // Trivial get methods
 
     std::string const& database() const { return _database; }
-    unsigned int       chunk() const    { return _chunk; }
+    unsigned int       chunk() const    { return _chunks.front(); }
+
+    /// @return all chunks deleted by the request (the first one is chunk())
+    std::vector<unsigned int> const& chunks() const { return _chunks; }
 
     /// @return parameters of a target request
     DeleteRequestParams const& targetRequestParams() const { return _targetRequestParams; }
@@ -79,6 +83,12 @@ public:
      */
     ReplicaInfo const& responseData() const { return _replicaInfo; }
 
+    /**
+     * @return request-specific extended data for all chunks of the request
+     * (in the same order as the chunks)
+     */
+    ReplicaInfoCollection const& batchResponseData() const { return _batchReplicaInfo; }
+
     /**
      * Create a new request with specified parameters.
      *
@@ -90,7 +100,7 @@ public:
      * @param worker           - the identifier of a worker node (the one where the chunk is supposed
      *                           to be located) at a destination of the chunk
      * @param database         - the name of a database
-     * @param chunk            - the number of a chunk to replicate (implies all relevant tables)
+     * @param chunks           - the numbers of chunks to delete (implies all relevant tables)
      * @param onFinish         - an optional callback function to be called upon a completion of the request.
      * @param priority         - a priority level of the request
      * @param keepTracking     - keep tracking the request before it finishes or fails
@@ -98,12 +108,14 @@ public:
      * @param messenger        - an interface for communicating with workers
      *
      * @return pointer to the created object
+     *
+     * @throws std::invalid_argument - if no chunks were given
      */
     static Ptr create(ServiceProvider::Ptr const& serviceProvider,
                       boost::asio::io_service& io_service,
                       std::string const& worker,
                       std::string const& database,
-                      unsigned int  chunk,
+                      std::vector<unsigned int> const& chunks,
                       CallbackType const& onFinish,
                       int  priority,
                       bool keepTracking,
@@ -121,7 +133,7 @@ private:
                   boost::asio::io_service& io_service,
                   std::string const& worker,
                   std::string const& database,
-                  unsigned int  chunk,
+                  std::vector<unsigned int> const& chunks,
                   CallbackType const& onFinish,
                   int  priority,
                   bool keepTracking,
@@ -180,8 +192,8 @@ private:
     /// The name of a database to which the deleted chunk belongs to
     std::string const _database;
 
-    /// The number of a chunk to be deleted
-    unsigned int const _chunk;
+    /// The numbers of chunks to be deleted
+    std::vector<unsigned int> const _chunks;
 
     CallbackType _onFinish;
 
@@ -190,6 +202,9 @@ private:
 
     /// Extended information on a status of the operation
     ReplicaInfo _replicaInfo;
+
+    /// Extended information on all chunks of the operation
+    ReplicaInfoCollection _batchReplicaInfo;
 };
 
 }}} // namespace lsst::qserv::replica
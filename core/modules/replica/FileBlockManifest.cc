@@ -0,0 +1,262 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "replica/FileBlockManifest.h"
+
+// System headers
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+
+// Qserv headers
+#include "lsst/log/Log.h"
+#include "util/StringHash.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.replica.FileBlockManifest");
+
+/// The minimum period of time (seconds) between saving the manifests
+std::time_t const saveIntervalSec = 60;
+
+/**
+ * Read a block of a file
+ *
+ * @return the number of bytes read
+ *
+ * @throws std::runtime_error - if the block couldn't be read
+ */
+size_t readBlock(int fd,
+                 std::string const& path,
+                 std::vector<char>& buf,
+                 uint64_t block) {
+
+    ssize_t const num = ::pread(fd, buf.data(), buf.size(), block * buf.size());
+    if (num < 0) {
+        throw std::runtime_error(
+                "failed to read file: " + path + ", error: " + std::strerror(errno));
+    }
+    return num;
+}
+
+} /// namespace
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+size_t const FileBlockManifest::BLOCK_SIZE = 4 * 1024 * 1024;
+
+std::string const FileBlockManifest::FILE_NAME = ".replica_block_manifest";
+
+FileBlockManifest::Ptr FileBlockManifest::instance(std::string const& workerName,
+                                                   std::string const& dataDir) {
+
+    static std::mutex mtx;
+    static std::map<std::string, Ptr> worker2manifest;
+
+    std::lock_guard<std::mutex> lock(mtx);
+    auto itr = worker2manifest.find(workerName);
+    if (itr == worker2manifest.end()) {
+        Ptr const ptr(new FileBlockManifest(dataDir + "/" + FILE_NAME));
+        itr = worker2manifest.emplace(workerName, ptr).first;
+    }
+    return itr->second;
+}
+
+std::vector<uint32_t> FileBlockManifest::compute(std::string const& path) {
+
+    int const fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error(
+                "failed to open file: " + path + ", error: " + std::strerror(errno));
+    }
+    std::vector<uint32_t> crcs;
+    std::vector<char> buf(BLOCK_SIZE);
+    try {
+        for (uint64_t block = 0;; ++block) {
+            size_t const num = ::readBlock(fd, path, buf, block);
+            if (0 == num) break;
+            crcs.push_back(util::StringHash::getCrc32c(buf.data(), num));
+            if (num < buf.size()) break;
+        }
+    } catch (std::runtime_error const&) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+    return crcs;
+}
+
+size_t FileBlockManifest::sample(std::string const& path,
+                                 std::vector<uint32_t> const& crcs,
+                                 double sampleRate,
+                                 std::mt19937_64& generator) {
+
+    if (crcs.empty()) return 0;
+
+    // Each block is picked with the probability of the sample rate, and
+    // a random block is picked if none was.
+
+    std::vector<uint64_t> blocks;
+    std::bernoulli_distribution pick(std::min(1., std::max(0., sampleRate)));
+    for (uint64_t block = 0; block < crcs.size(); ++block) {
+        if (pick(generator)) blocks.push_back(block);
+    }
+    if (blocks.empty()) {
+        blocks.push_back(std::uniform_int_distribution<uint64_t>(0, crcs.size() - 1)(generator));
+    }
+
+    int const fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error(
+                "failed to open file: " + path + ", error: " + std::strerror(errno));
+    }
+    size_t numMismatched = 0;
+    std::vector<char> buf(BLOCK_SIZE);
+    try {
+        for (auto block: blocks) {
+            size_t const num = ::readBlock(fd, path, buf, block);
+            if (util::StringHash::getCrc32c(buf.data(), num) != crcs[block]) ++numMismatched;
+        }
+    } catch (std::runtime_error const&) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+    return numMismatched;
+}
+
+FileBlockManifest::FileBlockManifest(std::string const& fileName)
+    :   _fileName(fileName),
+        _changed(false),
+        _saveTime(std::time(nullptr)) {
+    load();
+}
+
+bool FileBlockManifest::find(std::string const& path,
+                             FileCsCache::Stat const& stat,
+                             std::vector<uint32_t>& crcs) {
+
+    std::lock_guard<std::mutex> lock(_mtx);
+    auto const itr = _entries.find(path);
+    if (itr == _entries.end()) return false;
+    if (not (itr->second.stat == stat)) {
+        _entries.erase(itr);
+        _changed = true;
+        return false;
+    }
+    crcs = itr->second.crcs;
+    return true;
+}
+
+bool FileBlockManifest::build(std::string const& path) {
+
+    FileCsCache::Stat stat{0, 0, 0};
+    int const err = FileCsCache::stat(path, stat);
+    if (err != 0) {
+        LOGS(_log, LOG_LVL_WARN, "FileBlockManifest::build  failed to check the status of file: "
+             << path << ", error: " << std::strerror(err));
+        return false;
+    }
+    std::vector<uint32_t> crcs;
+    try {
+        crcs = compute(path);
+    } catch (std::runtime_error const& ex) {
+        LOGS(_log, LOG_LVL_WARN, "FileBlockManifest::build  " << ex.what());
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(_mtx);
+    _entries[path] = Entry{stat, std::move(crcs)};
+    _changed = true;
+    return true;
+}
+
+void FileBlockManifest::save(bool force) {
+
+    std::lock_guard<std::mutex> lock(_mtx);
+
+    std::time_t const now = std::time(nullptr);
+    if (not _changed or (not force and (now < _saveTime + saveIntervalSec))) return;
+
+    // Write a new file and then replace the old one, so that the file
+    // is never left partially written.
+    std::string const tmpFileName = _fileName + ".tmp";
+    {
+        std::ofstream out(tmpFileName, std::ios::trunc);
+        for (auto&& elem: _entries) {
+            Entry const& entry = elem.second;
+            out << entry.stat.inode << " " << entry.stat.size << " " << entry.stat.mtime << " "
+                << entry.crcs.size();
+            for (auto crc: entry.crcs) out << " " << crc;
+            out << " " << elem.first << "\n";
+        }
+        out.close();
+        if (not out) {
+            LOGS(_log, LOG_LVL_ERROR, "FileBlockManifest::save  failed to write file: " << tmpFileName);
+            std::remove(tmpFileName.c_str());
+            return;
+        }
+    }
+    if (std::rename(tmpFileName.c_str(), _fileName.c_str()) != 0) {
+        LOGS(_log, LOG_LVL_ERROR, "FileBlockManifest::save  failed to rename file: " << tmpFileName
+             << " into: " << _fileName << ", error: " << std::strerror(errno));
+        std::remove(tmpFileName.c_str());
+        return;
+    }
+    _changed  = false;
+    _saveTime = now;
+
+    LOGS(_log, LOG_LVL_DEBUG, "FileBlockManifest::save  file: " << _fileName
+         << ", entries: " << _entries.size());
+}
+
+void FileBlockManifest::load() {
+
+    std::ifstream in(_fileName);
+    if (not in) return;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream is(line);
+        std::string path;
+        Entry entry;
+        size_t numBlocks = 0;
+        if (not (is >> entry.stat.inode >> entry.stat.size >> entry.stat.mtime >> numBlocks)) {
+            continue;
+        }
+        entry.crcs.resize(numBlocks);
+        for (auto&& crc: entry.crcs) is >> crc;
+        if (is >> path) _entries[path] = std::move(entry);
+    }
+    LOGS(_log, LOG_LVL_DEBUG, "FileBlockManifest::load  file: " << _fileName
+         << ", entries: " << _entries.size());
+}
+
+}}} // namespace lsst::qserv::replica
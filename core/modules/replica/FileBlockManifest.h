@@ -0,0 +1,194 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_REPLICA_FILEBLOCKMANIFEST_H
+#define LSST_QSERV_REPLICA_FILEBLOCKMANIFEST_H
+
+/**
+ * This header declares class FileBlockManifest which keeps the checksums
+ * of the fixed-size blocks of the files of a worker.
+ */
+
+// System headers
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "replica/FileCsCache.h"
+
+// This header declarations
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+/**
+  * Class FileBlockManifest remembers the CRC32C checksums of the blocks of
+  * BLOCK_SIZE bytes of the files of a worker. The manifest of a file is made
+  * when the file is created by a replication request, and it's used for
+  * verifying the file by reading a random sample of its blocks rather than
+  * the whole file. As with class FileCsCache, a manifest is only valid while
+  * the inode number, the size and the mtime of the file are unchanged.
+  *
+  * The manifests are persisted in a file at the data directory of the worker.
+  * The file is loaded when the manifests of the worker are requested for
+  * the first time, and it's saved when it has changed, though not more often
+  * than once a minute.
+  */
+class FileBlockManifest {
+
+public:
+
+    /// The pointer type for instances of the class
+    typedef std::shared_ptr<FileBlockManifest> Ptr;
+
+    /// The size of a block (bytes)
+    static size_t const BLOCK_SIZE;
+
+    /// The name of the file (at the data directory of a worker) where
+    /// the manifests are persisted
+    static std::string const FILE_NAME;
+
+    /**
+     * @param workerName - the name of a worker
+     * @param dataDir    - the data directory of the worker
+     *
+     * @return the manifests of the worker
+     */
+    static Ptr instance(std::string const& workerName,
+                        std::string const& dataDir);
+
+    /**
+     * Compute the checksums of all blocks of a file
+     *
+     * @param path - the absolute path of a file
+     *
+     * @return the checksums of the blocks (in the order of the blocks)
+     *
+     * @throws std::runtime_error - if the file couldn't be open or read
+     */
+    static std::vector<uint32_t> compute(std::string const& path);
+
+    /**
+     * Read a random sample of the blocks of a file and compare their
+     * checksums against the manifest. At least one block is read from each
+     * non-empty file.
+     *
+     * @param path       - the absolute path of a file
+     * @param crcs       - the checksums of the blocks from the manifest
+     * @param sampleRate - the fraction of the blocks to be read (from 0 to 1)
+     * @param generator  - the source of the random numbers
+     *
+     * @return the number of the blocks whose checksums didn't match
+     *
+     * @throws std::runtime_error - if the file couldn't be open or read
+     */
+    static size_t sample(std::string const& path,
+                         std::vector<uint32_t> const& crcs,
+                         double sampleRate,
+                         std::mt19937_64& generator);
+
+    // Default construction and copy semantics are prohibited
+
+    FileBlockManifest() = delete;
+    FileBlockManifest(FileBlockManifest const&) = delete;
+    FileBlockManifest& operator=(FileBlockManifest const&) = delete;
+
+    ~FileBlockManifest() = default;
+
+    /**
+     * Find the manifest of a file. A manifest recorded for different
+     * attributes of the file is removed.
+     *
+     * @param path - the absolute path of a file
+     * @param stat - the current attributes of the file
+     * @param crcs - the checksums of the blocks to be set
+     *
+     * @return 'true' if the manifest is known
+     */
+    bool find(std::string const& path,
+              FileCsCache::Stat const& stat,
+              std::vector<uint32_t>& crcs);
+
+    /**
+     * Compute and record the manifest of a file. Failures are logged,
+     * and the file is left without a manifest.
+     *
+     * @param path - the absolute path of a file
+     *
+     * @return 'true' if the manifest was recorded
+     */
+    bool build(std::string const& path);
+
+    /**
+     * Write the manifests into their file if they have changed since they
+     * were saved last time.
+     *
+     * @param force - save now even if the manifests were saved less than
+     *   a minute ago
+     */
+    void save(bool force=false);
+
+private:
+
+    /// The manifest of a file
+    struct Entry {
+        FileCsCache::Stat     stat;
+        std::vector<uint32_t> crcs;
+    };
+
+    /**
+     * Construct the object and load the manifests from the file (if any)
+     *
+     * @param fileName - the file where the manifests are persisted
+     */
+    explicit FileBlockManifest(std::string const& fileName);
+
+    /// Load the manifests from the file. Malformed lines are ignored.
+    void load();
+
+private:
+
+    /// The file where the manifests are persisted
+    std::string const _fileName;
+
+    /// Protects the members below
+    std::mutex _mtx;
+
+    /// Manifests by the absolute paths of the files
+    std::map<std::string, Entry> _entries;
+
+    /// The manifests have changed since they were saved
+    bool _changed;
+
+    /// When the manifests were saved last time (seconds since UNIX Epoch)
+    std::time_t _saveTime;
+};
+
+}}} // namespace lsst::qserv::replica
+
+#endif // LSST_QSERV_REPLICA_FILEBLOCKMANIFEST_H
@@ -23,8 +23,14 @@
 // Class header
 #include "replica/FileClient.h"
 
+// System headers
+#include <algorithm>
+#include <arpa/inet.h>  // ntohl
+#include <cstring>
+
 // Third party headers
 #include <boost/bind.hpp>
+#include <zlib.h>
 
 // Qserv headers
 #include "lsst/log/Log.h"
@@ -39,6 +45,13 @@ namespace {
 
 LOG_LOGGER _log = LOG_GET("lsst.qserv.replica.FileClient");
 
+/// The size of the header of a compressed record
+size_t const recordHeaderBytes = 2 * sizeof(uint32_t);
+
+/// The limit for the size of the content of a compressed record, which
+/// protects the client from the malformed headers
+size_t const maxRecordBytes = 16 * 1024 * 1024;
+
 } /// namespace
 
 namespace lsst {
@@ -49,14 +62,22 @@ FileClient::Ptr FileClient::instance(ServiceProvider::Ptr const& serviceProvider
                                      std::string const& workerName,
                                      std::string const& databaseName,
                                      std::string const& fileName,
-                                     bool readContent) {
+                                     bool readContent,
+                                     uint64_t offset,
+                                     uint64_t length,
+                                     uint32_t blockSize,
+                                     std::vector<uint32_t> const& blockCrcs) {
     try {
         FileClient::Ptr ptr(
             new FileClient(serviceProvider,
                            workerName,
                            databaseName,
                            fileName,
-                           readContent));
+                           readContent,
+                           offset,
+                           length,
+                           blockSize,
+                           blockCrcs));
 
         if (ptr->openImpl()) return ptr;
 
@@ -74,17 +95,29 @@ FileClient::FileClient(ServiceProvider::Ptr const& serviceProvider,
                        std::string const& workerName,
                        std::string const& databaseName,
                        std::string const& fileName,
-                       bool readContent)
+                       bool readContent,
+                       uint64_t offset,
+                       uint64_t length,
+                       uint32_t blockSize,
+                       std::vector<uint32_t> const& blockCrcs)
     :   _workerInfo(serviceProvider->config()->workerInfo(workerName)),
         _databaseInfo(serviceProvider->config()->databaseInfo(databaseName)),
         _fileName(fileName),
         _readContent(readContent),
+        _offset(offset),
+        _length(length),
+        _blockSize(blockSize),
+        _blockCrcs(blockCrcs),
+        _compressionLevel(serviceProvider->config()->workerFsCompressionLevel()),
         _bufferPtr(new ProtocolBuffer(serviceProvider->config()->requestBufferSizeBytes())),
         _io_service(),
         _socket(_io_service),
         _size(0),
         _mtime(0),
-        _eof(false) {
+        _crc32c(0),
+        _eof(false),
+        _compressed(false),
+        _contentPos(0) {
 }
 
 std::string const& FileClient::worker() const {
@@ -155,6 +188,13 @@ bool FileClient::openImpl() {
         request.set_database(database());
         request.set_file(file());
         request.set_send_content(_readContent);
+        request.set_offset(_offset);
+        request.set_length(_length);
+        if (_blockSize != 0) {
+            request.set_block_size(_blockSize);
+            for (auto crc: _blockCrcs) request.add_block_crc32c(crc);
+        }
+        request.set_compression_level(_compressionLevel);
 
         _bufferPtr->serialize(request);
 
@@ -235,6 +275,10 @@ bool FileClient::openImpl() {
         if (response.available()) {
             _size  = response.size();
             _mtime = response.mtime();
+            _changedBlocks.assign(response.changed_blocks().begin(),
+                                  response.changed_blocks().end());
+            _crc32c = response.crc32c();
+            _compressed = response.compressed();
             return true;
         }
 
@@ -267,6 +311,25 @@ size_t FileClient::read(uint8_t* buf, size_t bufSize) {
                     context + "  zero buffer pointer or buffer size passed into the method");
     }
 
+    if (not _compressed) return receive(buf, bufSize);
+
+    size_t num = 0;
+    while (num < bufSize) {
+        if (_contentPos == _content.size()) {
+            if (not receiveRecord()) break;
+            continue;
+        }
+        size_t const bytes = std::min(bufSize - num, _content.size() - _contentPos);
+        std::memcpy(buf + num, _content.data() + _contentPos, bytes);
+        _contentPos += bytes;
+        num += bytes;
+    }
+    return num;
+}
+
+
+size_t FileClient::receive(uint8_t* buf, size_t bytes) {
+
     // If EOF was detected earlier
     if (_eof) return 0;
 
@@ -276,9 +339,9 @@ size_t FileClient::read(uint8_t* buf, size_t bufSize) {
         _socket,
         boost::asio::buffer(
             buf,
-            bufSize
+            bytes
         ),
-        boost::asio::transfer_at_least(bufSize),
+        boost::asio::transfer_at_least(bytes),
         ec
     );
     if (ec.value() != 0) {
@@ -294,7 +357,7 @@ size_t FileClient::read(uint8_t* buf, size_t bufSize) {
                         _workerInfo.svcHost + ":" + std::to_string(_workerInfo.fsPort) +
                         ", database: " + database() +
                         ", file: " + file() +
-                        ", bufSize: " + std::to_string(bufSize) +
+                        ", bufSize: " + std::to_string(bytes) +
                         ", error code: " + std::to_string(ec.value()) +
                         ", error message: " + ec.message());
         }
@@ -304,4 +367,45 @@ size_t FileClient::read(uint8_t* buf, size_t bufSize) {
     return num;
 }
 
+
+bool FileClient::receiveRecord() {
+
+    static std::string const context = "FileClient::receiveRecord  ";
+
+    uint32_t header[2];
+    size_t const headerBytes = receive(reinterpret_cast<uint8_t*>(header), recordHeaderBytes);
+    if (headerBytes == 0) return false;
+
+    std::string const error =
+        context + "malformed record received from the server: " +
+        _workerInfo.svcHost + ":" + std::to_string(_workerInfo.fsPort) +
+        ", database: " + database() +
+        ", file: " + file();
+
+    if (headerBytes != recordHeaderBytes) throw FileClientError(error);
+
+    size_t const contentBytes = ntohl(header[0]);
+    size_t const storedBytes  = ntohl(header[1]);
+    if ((contentBytes == 0) or (contentBytes > maxRecordBytes) or (storedBytes > contentBytes)) {
+        throw FileClientError(error);
+    }
+    _content.resize(contentBytes);
+    _contentPos = 0;
+
+    // The record which couldn't be compressed goes straight into the content
+    if (storedBytes == contentBytes) {
+        if (receive(_content.data(), contentBytes) != contentBytes) throw FileClientError(error);
+        return true;
+    }
+    _record.resize(storedBytes);
+    if (receive(_record.data(), storedBytes) != storedBytes) throw FileClientError(error);
+
+    uLongf bytes = contentBytes;
+    int const rc = ::uncompress(_content.data(), &bytes, _record.data(), storedBytes);
+    if ((rc != Z_OK) or (bytes != contentBytes)) {
+        throw FileClientError(error + ", uncompress rc: " + std::to_string(rc));
+    }
+    return true;
+}
+
 }}} // namespace lsst::qserv::replica
@@ -33,6 +33,7 @@
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 // Qserv headers
 #include "replica/Configuration.h"
@@ -104,6 +105,76 @@ public:
                         true /* readContent */);
     }
 
+    /**
+     * Open a byte range of a file. This is the same as the above method
+     * FileClient::open() except that FileClient::read() will only return
+     * the content of the range. The size reported by FileClient::size() is
+     * still the size of the whole file.
+     *
+     * @param serviceProvider - for configuration, etc. services
+     * @param workerName      - the name of a worker where the file resides
+     * @param databaseName    - the name of a database the file belongs to
+     * @param fileName        - the file to read
+     * @param offset          - the first byte of the range
+     * @param length          - the number of bytes in the range, 0 for the rest
+     *                          of the file
+     */
+    static Ptr openRange(ServiceProvider::Ptr const& serviceProvider,
+                         std::string const& workerName,
+                         std::string const& databaseName,
+                         std::string const& fileName,
+                         uint64_t offset,
+                         uint64_t length) {
+
+        return instance(serviceProvider,
+                        workerName,
+                        databaseName,
+                        fileName,
+                        true /* readContent */,
+                        offset,
+                        length);
+    }
+
+    /**
+     * Open a byte range of a file for the delta transfer into a copy of
+     * the file which already exists at a client. The server compares
+     * the checksums of the blocks of the range with the ones of the client's
+     * copy and FileClient::read() only returns the blocks which differ,
+     * in the order of their indexes. The indexes of the blocks are reported
+     * by FileClient::changedBlocks().
+     *
+     * @param serviceProvider - for configuration, etc. services
+     * @param workerName      - the name of a worker where the file resides
+     * @param databaseName    - the name of a database the file belongs to
+     * @param fileName        - the file to read
+     * @param offset          - the first byte of the range
+     * @param length          - the number of bytes in the range, 0 for the rest
+     *                          of the file
+     * @param blockSize       - the size of the blocks (bytes)
+     * @param blockCrcs       - the CRC-32C checksums of the blocks of the range
+     *                          in the client's copy, which may have less blocks
+     *                          than the range
+     */
+    static Ptr openDelta(ServiceProvider::Ptr const& serviceProvider,
+                         std::string const& workerName,
+                         std::string const& databaseName,
+                         std::string const& fileName,
+                         uint64_t offset,
+                         uint64_t length,
+                         uint32_t blockSize,
+                         std::vector<uint32_t> const& blockCrcs) {
+
+        return instance(serviceProvider,
+                        workerName,
+                        databaseName,
+                        fileName,
+                        true /* readContent */,
+                        offset,
+                        length,
+                        blockSize,
+                        blockCrcs);
+    }
+
     /**
      * Open a file and return a smart pointer to an object of this class.
      * If the operation is successful then a valid pointer will be returned.
@@ -154,8 +225,20 @@ public:
     /// @return the last modification time (mtime) of the file
     std::time_t mtime() const { return _mtime; }
 
+    /// @return the indexes of the blocks of the range to be read in
+    /// the delta transfer mode
+    std::vector<uint32_t> const& changedBlocks() const { return _changedBlocks; }
+
+    /// @return the CRC-32C checksum of the whole range (as reported by
+    /// a server) in the delta transfer mode
+    uint32_t crc32c() const { return _crc32c; }
+
+    /// @return 'true' if the server agreed to compress the content
+    bool compressed() const { return _compressed; }
+
     /**
      * Read (up to, but not exceeding) the specified number of bytes into a buffer.
+     * The content compressed by the server is decompressed by the method.
      *
      * The method will throw the FileClientError exception should any error
      * occurs during the operation. Illegal parameters (zero buffer pointer
@@ -181,12 +264,20 @@ private:
      * @param databaseName    - the name of a database the file belongs to
      * @param fileName        - the file to read or examine
      * @param readContent     - the mode in which the file will be used
+     * @param offset          - the first byte of the content to be read
+     * @param length          - the number of bytes to be read, 0 for the rest of the file
+     * @param blockSize       - the block size for the delta transfer, 0 to read the whole range
+     * @param blockCrcs       - the checksums of the blocks of the client's copy
      */
     static Ptr instance(ServiceProvider::Ptr const& serviceProvider,
                         std::string const& workerName,
                         std::string const& databaseName,
                         std::string const& fileName,
-                        bool readContent);
+                        bool readContent,
+                        uint64_t offset=0,
+                        uint64_t length=0,
+                        uint32_t blockSize=0,
+                        std::vector<uint32_t> const& blockCrcs=std::vector<uint32_t>());
 
     /**
      * Construct an object with the specified configuration.
@@ -199,12 +290,20 @@ private:
      * @param databaseName    - the name of a database the file belongs to
      * @param fileName        - the file to read or examine
      * @param readContent     - indicates if a file is open for reading its content
+     * @param offset          - the first byte of the content to be read
+     * @param length          - the number of bytes to be read, 0 for the rest of the file
+     * @param blockSize       - the block size for the delta transfer, 0 to read the whole range
+     * @param blockCrcs       - the checksums of the blocks of the client's copy
      */
     FileClient(ServiceProvider::Ptr const& serviceProvider,
                std::string const& workerName,
                std::string const& databaseName,
                std::string const& fileName,
-               bool readContent);
+               bool readContent,
+               uint64_t offset,
+               uint64_t length,
+               uint32_t blockSize,
+               std::vector<uint32_t> const& blockCrcs);
 
     /**
      * Try opening the file
@@ -213,6 +312,28 @@ private:
      */
     bool openImpl();
 
+    /**
+     * Receive the specified number of bytes from the server unless
+     * the server closes the connection before that.
+     *
+     * @param buf   - a pointer to a buffer where the data will be placed
+     * @param bytes - the number of bytes to be received
+     *
+     * @return the actual number of bytes received
+     *
+     * @throw FileClientError on errors other than the end of the stream
+     */
+    size_t receive(uint8_t* buf, size_t bytes);
+
+    /**
+     * Receive and decompress the next record of the compressed content
+     *
+     * @return 'false' if there are no more records
+     *
+     * @throw FileClientError on errors
+     */
+    bool receiveRecord();
+
 private:
 
     /// Cached worker descriptors obtained from the Configuration
@@ -228,6 +349,17 @@ private:
     // its content
     bool const _readContent;
 
+    /// The range of the content to be read
+    uint64_t const _offset;
+    uint64_t const _length;
+
+    /// The parameters of the delta transfer
+    uint32_t const _blockSize;
+    std::vector<uint32_t> const _blockCrcs;
+
+    /// The compression level of the content requested from the server
+    uint32_t const _compressionLevel;
+
     /// Buffer for data moved over the network
     std::unique_ptr<ProtocolBuffer> _bufferPtr;
 
@@ -242,8 +374,24 @@ private:
     /// The last modification time (mtime) of the file
     std::time_t _mtime;
 
+    /// The blocks to be read and the checksum of the range in the delta
+    /// transfer mode (as reported by a server)
+    std::vector<uint32_t> _changedBlocks;
+    uint32_t _crc32c;
+
     /// The flag which will be set after hitting the end of the input stream
     bool _eof;
+
+    /// The content is sent by the server in compressed records
+    bool _compressed;
+
+    /// The record received from the server in the compressed mode
+    std::vector<uint8_t> _record;
+
+    /// The decompressed content of the record, and the number of bytes
+    /// of it which have already been read
+    std::vector<uint8_t> _content;
+    size_t _contentPos;
 };
 
 }}} // namespace lsst::qserv::replica
@@ -0,0 +1,173 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "replica/FileCsCache.h"
+
+// System headers
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+// Qserv headers
+#include "lsst/log/Log.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.replica.FileCsCache");
+
+/// The minimum period of time (seconds) between saving the cache
+std::time_t const saveIntervalSec = 60;
+
+/// The value stored instead of an empty algorithm so that each line
+/// has the same number of fields
+std::string const noAlgorithm = "-";
+
+} /// namespace
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+std::string const FileCsCache::FILE_NAME = ".replica_cs_cache";
+
+FileCsCache::Ptr FileCsCache::instance(std::string const& workerName,
+                                       std::string const& dataDir) {
+
+    static std::mutex mtx;
+    static std::map<std::string, Ptr> worker2cache;
+
+    std::lock_guard<std::mutex> lock(mtx);
+    auto itr = worker2cache.find(workerName);
+    if (itr == worker2cache.end()) {
+        Ptr const ptr(new FileCsCache(dataDir + "/" + FILE_NAME));
+        itr = worker2cache.emplace(workerName, ptr).first;
+    }
+    return itr->second;
+}
+
+int FileCsCache::stat(std::string const& path, Stat& stat) {
+    struct ::stat st;
+    if (::stat(path.c_str(), &st) != 0) return errno;
+    stat.inode = st.st_ino;
+    stat.size  = st.st_size;
+    stat.mtime = st.st_mtime;
+    return 0;
+}
+
+FileCsCache::FileCsCache(std::string const& fileName)
+    :   _fileName(fileName),
+        _changed(false),
+        _saveTime(std::time(nullptr)) {
+    load();
+}
+
+bool FileCsCache::find(std::string const& path,
+                       Stat const& stat,
+                       std::string& cs,
+                       std::string& csAlgorithm) {
+
+    std::lock_guard<std::mutex> lock(_mtx);
+    auto const itr = _entries.find(path);
+    if (itr == _entries.end()) return false;
+    if (not (itr->second.stat == stat)) {
+        _entries.erase(itr);
+        _changed = true;
+        return false;
+    }
+    cs          = itr->second.cs;
+    csAlgorithm = itr->second.csAlgorithm;
+    return true;
+}
+
+void FileCsCache::update(std::string const& path,
+                         Stat const& stat,
+                         std::string const& cs,
+                         std::string const& csAlgorithm) {
+
+    std::lock_guard<std::mutex> lock(_mtx);
+    _entries[path] = Entry{stat, cs, csAlgorithm};
+    _changed = true;
+}
+
+void FileCsCache::save(bool force) {
+
+    std::lock_guard<std::mutex> lock(_mtx);
+
+    std::time_t const now = std::time(nullptr);
+    if (not _changed or (not force and (now < _saveTime + saveIntervalSec))) return;
+
+    // Write a new file and then replace the old one, so that the file
+    // is never left partially written.
+    std::string const tmpFileName = _fileName + ".tmp";
+    {
+        std::ofstream out(tmpFileName, std::ios::trunc);
+        for (auto&& elem: _entries) {
+            Entry const& entry = elem.second;
+            out << entry.stat.inode << " " << entry.stat.size << " " << entry.stat.mtime << " "
+                << (entry.csAlgorithm.empty() ? noAlgorithm : entry.csAlgorithm) << " "
+                << entry.cs << " " << elem.first << "\n";
+        }
+        out.close();
+        if (not out) {
+            LOGS(_log, LOG_LVL_ERROR, "FileCsCache::save  failed to write file: " << tmpFileName);
+            std::remove(tmpFileName.c_str());
+            return;
+        }
+    }
+    if (std::rename(tmpFileName.c_str(), _fileName.c_str()) != 0) {
+        LOGS(_log, LOG_LVL_ERROR, "FileCsCache::save  failed to rename file: " << tmpFileName
+             << " into: " << _fileName << ", error: " << std::strerror(errno));
+        std::remove(tmpFileName.c_str());
+        return;
+    }
+    _changed  = false;
+    _saveTime = now;
+
+    LOGS(_log, LOG_LVL_DEBUG, "FileCsCache::save  file: " << _fileName
+         << ", entries: " << _entries.size());
+}
+
+void FileCsCache::load() {
+
+    std::ifstream in(_fileName);
+    if (not in) return;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream is(line);
+        std::string path;
+        Entry entry;
+        if (is >> entry.stat.inode >> entry.stat.size >> entry.stat.mtime
+               >> entry.csAlgorithm >> entry.cs >> path) {
+            if (entry.csAlgorithm == noAlgorithm) entry.csAlgorithm.clear();
+            _entries[path] = entry;
+        }
+    }
+    LOGS(_log, LOG_LVL_DEBUG, "FileCsCache::load  file: " << _fileName
+         << ", entries: " << _entries.size());
+}
+
+}}} // namespace lsst::qserv::replica
@@ -0,0 +1,183 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_REPLICA_FILECSCACHE_H
+#define LSST_QSERV_REPLICA_FILECSCACHE_H
+
+/**
+ * This header declares class FileCsCache which keeps the control sums
+ * of the files of a worker between requests.
+ */
+
+// System headers
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// This header declarations
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+/**
+  * Class FileCsCache remembers the control sums computed for the files of
+  * a worker, along with the inode number, the size and the mtime of each file
+  * at the time the control sum was computed. A control sum is only reported
+  * back while all three are unchanged, so the files which haven't changed
+  * since the previous scan of a worker don't have to be read again.
+  *
+  * The cache is persisted in a file at the data directory of the worker.
+  * It's loaded when the cache of the worker is requested for the first time,
+  * and it's saved when it has changed, though not more often than once
+  * a minute.
+  */
+class FileCsCache {
+
+public:
+
+    /// The pointer type for instances of the class
+    typedef std::shared_ptr<FileCsCache> Ptr;
+
+    /// The attributes of a file which invalidate its control sum
+    struct Stat {
+        uint64_t    inode;
+        uint64_t    size;
+        std::time_t mtime;
+
+        bool operator==(Stat const& other) const {
+            return inode == other.inode and size == other.size and mtime == other.mtime;
+        }
+    };
+
+    /// The name of the file (at the data directory of a worker) where
+    /// the cache is persisted
+    static std::string const FILE_NAME;
+
+    /**
+     * @param workerName - the name of a worker
+     * @param dataDir    - the data directory of the worker
+     *
+     * @return the cache of the worker
+     */
+    static Ptr instance(std::string const& workerName,
+                        std::string const& dataDir);
+
+    /**
+     * Get the attributes of a file with a single call to stat(2)
+     *
+     * @param path - the absolute path of a file
+     * @param stat - the attributes to be set
+     *
+     * @return 0 on success, or the value of errno otherwise (ENOENT if
+     *   the file doesn't exist)
+     */
+    static int stat(std::string const& path, Stat& stat);
+
+    // Default construction and copy semantics are prohibited
+
+    FileCsCache() = delete;
+    FileCsCache(FileCsCache const&) = delete;
+    FileCsCache& operator=(FileCsCache const&) = delete;
+
+    ~FileCsCache() = default;
+
+    /**
+     * Find the control sum of a file. An entry recorded for different
+     * attributes of the file is removed.
+     *
+     * @param path        - the absolute path of a file
+     * @param stat        - the current attributes of the file
+     * @param cs          - the control sum to be set
+     * @param csAlgorithm - the algorithm of the control sum to be set
+     *
+     * @return 'true' if the control sum is known
+     */
+    bool find(std::string const& path,
+              Stat const& stat,
+              std::string& cs,
+              std::string& csAlgorithm);
+
+    /**
+     * Record the control sum of a file
+     *
+     * @param path        - the absolute path of a file
+     * @param stat        - the attributes of the file before it was read
+     * @param cs          - the control sum
+     * @param csAlgorithm - the algorithm of the control sum
+     */
+    void update(std::string const& path,
+                Stat const& stat,
+                std::string const& cs,
+                std::string const& csAlgorithm);
+
+    /**
+     * Write the cache into its file if it has changed since it was saved
+     * last time.
+     *
+     * @param force - save now even if the cache was saved less than
+     *   a minute ago
+     */
+    void save(bool force=false);
+
+private:
+
+    /// An entry of the cache
+    struct Entry {
+        Stat        stat;
+        std::string cs;
+        std::string csAlgorithm;
+    };
+
+    /**
+     * Construct the cache and load its entries from the file (if any)
+     *
+     * @param fileName - the file where the cache is persisted
+     */
+    explicit FileCsCache(std::string const& fileName);
+
+    /// Load the entries from the file. Malformed lines are ignored.
+    void load();
+
+private:
+
+    /// The file where the cache is persisted
+    std::string const _fileName;
+
+    /// Protects the members below
+    std::mutex _mtx;
+
+    /// Entries by the absolute paths of the files
+    std::map<std::string, Entry> _entries;
+
+    /// The cache has changed since it was saved
+    bool _changed;
+
+    /// When the cache was saved last time (seconds since UNIX Epoch)
+    std::time_t _saveTime;
+};
+
+}}} // namespace lsst::qserv::replica
+
+#endif // LSST_QSERV_REPLICA_FILECSCACHE_H
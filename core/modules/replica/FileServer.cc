@@ -31,6 +31,7 @@
 
 // Qserv headers
 #include "lsst/log/Log.h"
+#include "replica/BandwidthLimiter.h"
 #include "replica/Configuration.h"
 #include "replica/ServiceProvider.h"
 
@@ -67,6 +68,10 @@ FileServer::FileServer(ServiceProvider::Ptr const& serviceProvider,
     // Set the socket reuse option to allow recycling ports after catastrophic
     // failures.
     _acceptor.set_option(boost::asio::socket_base::reuse_address(true));
+
+    // The initial limit can be changed later by the worker's service
+    BandwidthLimiter::instance(_workerName)->setRate(
+        serviceProvider->config()->workerFsMaxRateBytesPerSec());
 }
 
 void FileServer::run() {
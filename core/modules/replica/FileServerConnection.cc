@@ -24,19 +24,26 @@
 #include "replica/FileServerConnection.h"
 
 // System headers
+#include <algorithm>
 #include <cerrno>
 #include <cstring>
 #include <ctime>
 #include <stdexcept>
+#include <arpa/inet.h>  // htonl
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
 
 // Third party headers
 #include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
+#include <zlib.h>
 
 // Qserv headers
 #include "lsst/log/Log.h"
 #include "replica/Configuration.h"
 #include "replica/ServiceProvider.h"
+#include "util/StringHash.h"
 
 namespace fs    = boost::filesystem;
 namespace proto = lsst::qserv::proto;
@@ -49,6 +56,12 @@ LOG_LOGGER _log = LOG_GET("lsst.qserv.replica.FileServerConnection");
 /// network operations.
 size_t const maxFileBufSizeBytes = 16 * 1024 * 1024;
 
+/// The highest compression level of zlib
+uint32_t const maxCompressionLevel = 9;
+
+/// The size of the header of a compressed record
+size_t const recordHeaderBytes = 2 * sizeof(uint32_t);
+
 } /// namespace
 
 namespace {
@@ -129,13 +142,20 @@ FileServerConnection::FileServerConnection(ServiceProvider::Ptr const& servicePr
         _workerName(workerName),
         _workerInfo(serviceProvider->config()->workerInfo(workerName)),
         _socket(io_service),
+        _limiter(BandwidthLimiter::instance(workerName)),
+        _throttleTimer(io_service),
         _bufferPtr(
             std::make_shared<ProtocolBuffer>(
                 serviceProvider->config()->requestBufferSizeBytes())),
         _fileName(),
         _filePtr(0),
+        _useSendfile(false),
+        _fileOffset(0),
+        _bytesLeft(0),
+        _segments(),
         _fileBufSize(serviceProvider->config()->workerFsBufferSizeBytes()),
-        _fileBuf(0) {
+        _fileBuf(0),
+        _compressionLevel(0) {
 
     if (not _fileBufSize or (_fileBufSize > maxFileBufSizeBytes)) {
         throw std::invalid_argument(
@@ -209,6 +229,8 @@ void FileServerConnection::requestReceived(boost::system::error_code const& ec,
     bool        available = false;
     uint64_t    size      = 0;
     std::time_t mtime     = 0;
+    std::vector<uint32_t> changedBlocks;
+    uint32_t    rangeCrc  = 0;
     do {
         if (not _serviceProvider->config()->isKnownDatabase(request.database())) {
             LOGS(_log, LOG_LVL_ERROR, context << "requestReceived  unknown database: "
@@ -245,6 +267,12 @@ void FileServerConnection::requestReceived(boost::system::error_code const& ec,
         // If the file content was requested then open the file and leave
         // its descriptor open.
 
+        if (request.offset() > size) {
+            LOGS(_log, LOG_LVL_ERROR, context << "requestReceived  offset: " << request.offset()
+                 << " is past the end of file: " << file << ", size: " << size);
+            break;
+        }
+
         _fileName = file.string();
         if (request.send_content()) {
             _filePtr  = std::fopen(file.string().c_str(), "rb");
@@ -254,6 +282,45 @@ void FileServerConnection::requestReceived(boost::system::error_code const& ec,
                      << ", file: " << file);
                 break;
             }
+
+            // Only the requested range of the file is sent. Clients fetch ranges
+            // of large files over many connections at once.
+            uint64_t const rangeBytes = size - request.offset();
+            _bytesLeft = (request.length() == 0) ? rangeBytes : std::min(request.length(), rangeBytes);
+            _fileOffset = request.offset();
+            if (std::fseek(_filePtr, _fileOffset, SEEK_SET) != 0) {
+                LOGS(_log, LOG_LVL_ERROR, context
+                     << "requestReceived  file seek error: " << std::strerror(errno)
+                     << ", file: " << file);
+                std::fclose(_filePtr);
+                _filePtr = 0;
+                break;
+            }
+
+            // A client which already has a copy of the file only needs
+            // the blocks of the range which are different in its copy.
+            _segments.clear();
+            if (request.block_size() != 0) {
+                if (not findChangedBlocks(request, changedBlocks, rangeCrc)) {
+                    std::fclose(_filePtr);
+                    _filePtr = 0;
+                    break;
+                }
+            } else {
+                _segments.emplace_back(_fileOffset, _bytesLeft);
+            }
+            _bytesLeft = 0;
+#ifdef __linux__
+            // The file is sent as is, so the kernel can move it to the socket
+            // without copying it into the user space.
+            _useSendfile = true;
+#endif
+            // Compressed records are made from the buffered reads
+            _compressionLevel = std::min(request.compression_level(), maxCompressionLevel);
+            if (_compressionLevel != 0) {
+                _useSendfile = false;
+                _recordBuf.resize(recordHeaderBytes + ::compressBound(_fileBufSize));
+            }
         }
         available = true;
 
@@ -265,6 +332,11 @@ void FileServerConnection::requestReceived(boost::system::error_code const& ec,
     response.set_available(available);
     response.set_size(size);
     response.set_mtime(mtime);
+    response.set_compressed(_compressionLevel != 0);
+    if (request.block_size() != 0) {
+        for (auto block: changedBlocks) response.add_changed_blocks(block);
+        response.set_crc32c(rangeCrc);
+    }
 
     _bufferPtr->resize();
     _bufferPtr->serialize(response);
@@ -308,20 +380,27 @@ void FileServerConnection::responseSent(boost::system::error_code const& ec,
     if (not _filePtr) return;
 
     // The file is open. Begin streaming its content.
-    sendData();
+    if (_useSendfile) sendFileData();
+    else              sendData();
 }
 
 void FileServerConnection::sendData() {
 
     LOGS(_log, LOG_LVL_DEBUG, context << "sendData  file: " << _fileName);
 
+    if (not nextSegment()) {
+        std::fclose(_filePtr);
+        return;
+    }
+
     // Read next record if possible (a failure or EOF)
 
     size_t const bytes =
         std::fread(_fileBuf,
                    sizeof(uint8_t),
-                   _fileBufSize,
+                   std::min<uint64_t>(_fileBufSize, _bytesLeft),
                    _filePtr);
+    _bytesLeft -= bytes;
     if (not bytes) {
         if (std::ferror(_filePtr)) {
             LOGS(_log, LOG_LVL_ERROR, context
@@ -339,11 +418,17 @@ void FileServerConnection::sendData() {
 
     // Send the record
 
+    uint8_t const* record = _fileBuf;
+    size_t recordBytes = bytes;
+    if (_compressionLevel != 0) {
+        recordBytes = compressRecord(bytes);
+        record = _recordBuf.data();
+    }
     boost::asio::async_write(
         _socket,
         boost::asio::buffer(
-            _fileBuf,
-            bytes
+            record,
+            recordBytes
         ),
         boost::bind(
             &FileServerConnection::dataSent,
@@ -361,7 +446,225 @@ void FileServerConnection::dataSent(boost::system::error_code const& ec,
 
     if (::isErrorCode(ec, "dataSent")) return;
 
+    if (throttle(bytes_transferred)) return;
+    sendData();
+}
+
+void FileServerConnection::sendFileData() {
+
+    LOGS(_log, LOG_LVL_DEBUG, context << "sendFileData  file: " << _fileName);
+
+#ifdef __linux__
+    // sendfile(2) must not block the thread running the I/O service. The flag
+    // only affects the synchronous operations on the native socket, the
+    // asynchronous operations of Boost ASIO behave the same either way.
+    boost::system::error_code ec;
+    if (not _socket.native_non_blocking()) {
+        _socket.native_non_blocking(true, ec);
+        if (::isErrorCode(ec, "sendFileData")) {
+            std::fclose(_filePtr);
+            return;
+        }
+    }
+    while (true) {
+        if (not nextSegment()) {
+            std::fclose(_filePtr);
+            return;
+        }
+        off_t offset = _fileOffset;
+        ssize_t const bytes = ::sendfile(_socket.native_handle(),
+                                         ::fileno(_filePtr),
+                                         &offset,
+                                         std::min<uint64_t>(_fileBufSize, _bytesLeft));
+        if (bytes > 0) {
+            _fileOffset = offset;
+            _bytesLeft -= bytes;
+            if (throttle(bytes)) return;
+            break;
+        }
+        if (bytes == 0) {
+            LOGS(_log, LOG_LVL_INFO, context << "sendFileData  <CLOSE> file: " << _fileName);
+            std::fclose(_filePtr);
+            return;
+        }
+        if (errno == EINTR) continue;
+        if ((errno == EAGAIN) or (errno == EWOULDBLOCK)) break;
+        if ((errno == EINVAL) or (errno == ENOSYS)) {
+
+            // The file system or the socket doesn't support this. Continue with
+            // the buffered reads from where sendfile(2) has stopped.
+            LOGS(_log, LOG_LVL_DEBUG, context << "sendFileData  sendfile not supported: "
+                 << std::strerror(errno) << ", file: " << _fileName);
+            _useSendfile = false;
+            _socket.native_non_blocking(false, ec);
+            if (std::fseek(_filePtr, _fileOffset, SEEK_SET) != 0) {
+                LOGS(_log, LOG_LVL_ERROR, context
+                     << "sendFileData  file seek error: " << std::strerror(errno)
+                     << ", file: " << _fileName);
+                std::fclose(_filePtr);
+                return;
+            }
+            sendData();
+            return;
+        }
+        LOGS(_log, LOG_LVL_ERROR, context
+             << "sendFileData  sendfile error: " << std::strerror(errno)
+             << ", file: " << _fileName);
+        std::fclose(_filePtr);
+        return;
+    }
+
+    waitWritable();
+#else
+    _useSendfile = false;
     sendData();
+#endif
+}
+
+bool FileServerConnection::nextSegment() {
+
+    while (not _bytesLeft) {
+        if (_segments.empty()) {
+            LOGS(_log, LOG_LVL_INFO, context << "nextSegment  <CLOSE> file: " << _fileName);
+            return false;
+        }
+        _fileOffset = _segments.front().first;
+        _bytesLeft  = _segments.front().second;
+        _segments.pop_front();
+
+        // The buffered reads continue from the current position of the file
+        if (not _useSendfile and std::fseek(_filePtr, _fileOffset, SEEK_SET) != 0) {
+            LOGS(_log, LOG_LVL_ERROR, context
+                 << "nextSegment  file seek error: " << std::strerror(errno)
+                 << ", file: " << _fileName);
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t FileServerConnection::compressRecord(size_t bytes) {
+
+    uint8_t* const data = _recordBuf.data() + recordHeaderBytes;
+    uLongf dataBytes = _recordBuf.size() - recordHeaderBytes;
+    int const rc = ::compress2(data, &dataBytes, _fileBuf, bytes, _compressionLevel);
+    if ((rc != Z_OK) or (dataBytes >= bytes)) {
+
+        // The record is stored as is if it can't be made smaller
+        if (rc != Z_OK) {
+            LOGS(_log, LOG_LVL_WARN, context << "compressRecord  compress2 failed, rc: " << rc
+                 << ", file: " << _fileName);
+        }
+        std::memcpy(data, _fileBuf, bytes);
+        dataBytes = bytes;
+    }
+    uint32_t* const header = reinterpret_cast<uint32_t*>(_recordBuf.data());
+    header[0] = htonl(bytes);
+    header[1] = htonl(dataBytes);
+
+    return recordHeaderBytes + dataBytes;
+}
+
+bool FileServerConnection::findChangedBlocks(proto::ReplicationFileRequest const& request,
+                                             std::vector<uint32_t>& changedBlocks,
+                                             uint32_t& rangeCrc) {
+
+    uint64_t const blockSize = request.block_size();
+    uint64_t const rangeBegin = _fileOffset;
+    uint64_t const rangeEnd = _fileOffset + _bytesLeft;
+
+    // The range is read once, one record at a time, computing the checksums
+    // of its blocks and of the whole range.
+    for (uint64_t blockBegin = rangeBegin; blockBegin < rangeEnd; blockBegin += blockSize) {
+        uint64_t const blockEnd = std::min(blockBegin + blockSize, rangeEnd);
+        uint32_t blockCrc = 0;
+        for (uint64_t pos = blockBegin; pos < blockEnd;) {
+            size_t const bytes = std::fread(_fileBuf,
+                                            sizeof(uint8_t),
+                                            std::min<uint64_t>(_fileBufSize, blockEnd - pos),
+                                            _filePtr);
+            if (not bytes) {
+                LOGS(_log, LOG_LVL_ERROR, context
+                     << "findChangedBlocks  file read error: " << std::strerror(errno)
+                     << ", file: " << _fileName);
+                return false;
+            }
+            char const* ptr = reinterpret_cast<char const*>(_fileBuf);
+            blockCrc = util::StringHash::getCrc32c(ptr, bytes, blockCrc);
+            rangeCrc = util::StringHash::getCrc32c(ptr, bytes, rangeCrc);
+            pos += bytes;
+        }
+        int const block = (blockBegin - rangeBegin) / blockSize;
+        if ((block < request.block_crc32c_size()) and (request.block_crc32c(block) == blockCrc)) continue;
+
+        // Adjacent blocks are sent as one segment
+        changedBlocks.push_back(block);
+        if (not _segments.empty() and
+            (_segments.back().first + _segments.back().second == blockBegin)) {
+            _segments.back().second += blockEnd - blockBegin;
+        } else {
+            _segments.emplace_back(blockBegin, blockEnd - blockBegin);
+        }
+    }
+    LOGS(_log, LOG_LVL_DEBUG, context << "findChangedBlocks  file: " << _fileName
+         << ", offset: " << rangeBegin << ", changed blocks: " << changedBlocks.size());
+    return true;
+}
+
+void FileServerConnection::socketWritable(boost::system::error_code const& ec) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context << "socketWritable");
+
+    if (::isErrorCode(ec, "socketWritable")) {
+        std::fclose(_filePtr);
+        return;
+    }
+    sendFileData();
+}
+
+void FileServerConnection::waitWritable() {
+
+    // Send the next record when the socket can take it. Waiting after each
+    // record also lets other connections of the service make progress.
+
+    _socket.async_write_some(
+        boost::asio::null_buffers(),
+        boost::bind(
+            &FileServerConnection::socketWritable,
+            shared_from_this(),
+            boost::asio::placeholders::error
+        )
+    );
+}
+
+bool FileServerConnection::throttle(size_t bytes) {
+
+    uint64_t const delayUs = _limiter->consume(bytes);
+    if (not delayUs) return false;
+
+    LOGS(_log, LOG_LVL_DEBUG, context << "throttle  delay: " << delayUs << " us");
+
+    _throttleTimer.expires_from_now(boost::posix_time::microseconds(delayUs));
+    _throttleTimer.async_wait(
+        boost::bind(
+            &FileServerConnection::throttleExpired,
+            shared_from_this(),
+            boost::asio::placeholders::error
+        )
+    );
+    return true;
+}
+
+void FileServerConnection::throttleExpired(boost::system::error_code const& ec) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context << "throttleExpired");
+
+    if (::isErrorCode(ec, "throttleExpired")) {
+        std::fclose(_filePtr);
+        return;
+    }
+    if (_useSendfile) waitWritable();
+    else              sendData();
 }
 
 }}} // namespace lsst::qserv::replica
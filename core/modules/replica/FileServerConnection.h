@@ -32,13 +32,18 @@
 
 // System headers
 #include <cstdio>       // std::FILE, C-style file I/O
+#include <deque>
 #include <memory>
+#include <sys/types.h>  // off_t
+#include <utility>
+#include <vector>
 
 // Third party headers
 #include <boost/asio.hpp>
 
 // Qserv headers
 #include "proto/replication.pb.h"
+#include "replica/BandwidthLimiter.h"
 #include "replica/Configuration.h"
 #include "replica/ProtocolBuffer.h"
 #include "replica/ServiceProvider.h"
@@ -188,6 +193,78 @@ private:
     void dataSent(boost::system::error_code const& ec,
                   size_t bytes_transferred);
 
+    /**
+     * Send the next record of the currently open file straight from the page
+     * cache into the socket with sendfile(2), without copying it through
+     * the record buffer. If the kernel can't do this for the file then switch
+     * to sendData() for the rest of the file.
+     */
+    void sendFileData();
+
+    /**
+     * The callback on the socket becoming writable again, or on a failure.
+     *
+     * @param ec - error code to be evaluated
+     */
+    void socketWritable(boost::system::error_code const& ec);
+
+    /**
+     * Begin waiting (asynchronously) for the socket to become writable
+     * before sending the next record with sendfile(2)
+     */
+    void waitWritable();
+
+    /**
+     * Pause sending the file if the bandwidth limit of the worker has been
+     * reached. The transfer is resumed by throttleExpired().
+     *
+     * @param bytes - the number of bytes which have just been sent
+     *
+     * @return 'true' if the transfer has been paused
+     */
+    bool throttle(size_t bytes);
+
+    /**
+     * The callback on the expiration of the throttling timer
+     *
+     * @param ec - error code to be evaluated
+     */
+    void throttleExpired(boost::system::error_code const& ec);
+
+    /**
+     * Move on to the next segment of the file to be sent once the current
+     * one has been sent.
+     *
+     * @return 'false' if there are no more segments, or on a failure
+     */
+    bool nextSegment();
+
+    /**
+     * Compress the record of the file buffer into the record buffer,
+     * preceded by the header of the record.
+     *
+     * @param bytes - the number of bytes in the file buffer
+     *
+     * @return the number of bytes of the record to be sent
+     */
+    size_t compressRecord(size_t bytes);
+
+    /**
+     * Read the requested range of the open file and compare the checksums
+     * of its blocks with those of the client's copy. The blocks which differ
+     * (or are missing in the client's copy) are queued as the segments to be
+     * sent.
+     *
+     * @param request       - the request carrying the client's checksums
+     * @param changedBlocks - the indexes of the blocks to be sent
+     * @param rangeCrc      - the CRC-32C checksum of the whole range
+     *
+     * @return 'false' on a file read error
+     */
+    bool findChangedBlocks(proto::ReplicationFileRequest const& request,
+                           std::vector<uint32_t>& changedBlocks,
+                           uint32_t& rangeCrc);
+
 private:
 
     ServiceProvider::Ptr const _serviceProvider;
@@ -202,6 +279,12 @@ private:
     /// A socket for communication with clients
     boost::asio::ip::tcp::socket _socket;
 
+    /// The bandwidth limiter shared by all connections of the worker's server
+    BandwidthLimiter::Ptr const _limiter;
+
+    /// The timer for pausing the transfer when the bandwidth limit is reached
+    boost::asio::deadline_timer _throttleTimer;
+
     /// Buffer management class facilitating serialization/de-serialization
     /// of data sent over the network
     std::shared_ptr<ProtocolBuffer> const _bufferPtr;
@@ -211,12 +294,33 @@ private:
 
     /// For a file during on-going transfer
     std::FILE* _filePtr;
+
+    /// True while the file is sent with sendfile(2) rather than by sendData()
+    bool _useSendfile;
+
+    /// The offset of the next byte to be sent with sendfile(2)
+    off_t _fileOffset;
+
+    /// The number of bytes of the current segment still to be sent
+    uint64_t _bytesLeft;
+
+    /// The segments (the offsets and the lengths) of the file still to be
+    /// sent after the current one. This is the whole requested range, or
+    /// the changed blocks of the range in the delta transfer mode.
+    std::deque<std::pair<uint64_t, uint64_t>> _segments;
     
     /// The file record buffer size (bytes)
     size_t _fileBufSize;
 
     /// The file record buffer
     uint8_t* _fileBuf;
+
+    /// The zlib compression level of the records (0 if the records
+    /// are sent as is)
+    uint32_t _compressionLevel;
+
+    /// The buffer for the compressed records
+    std::vector<uint8_t> _recordBuf;
 };
 
 }}} // namespace lsst::qserv::replica
@@ -25,16 +25,28 @@
 
 // System headers
 #include <algorithm>
+#include <atomic>
 #include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
 #include <cstring>
 #include <cstdio>
+#include <fcntl.h>
+#include <mutex>
+#include <new>
 #include <stdexcept>
 #include <sys/types.h>  // struct passwd
 #include <pwd.h>        // getpwuid
 #include <unistd.h>     // geteuid
 
 // Qserv headers
+#include "replica/AsyncFileIO.h"
 #include "replica/Configuration.h"
+#include "util/Command.h"
+#include "util/EventThread.h"
+#include "util/StringHash.h"
+#include "util/ThreadPool.h"
 
 namespace {
 
@@ -191,6 +203,31 @@ uint64_t FileUtils::compute_cs(std::string const& fileName,
     return cs;
 }
 
+bool FileUtils::isPackedMyISAM(std::string const& fileName) {
+
+    // The signature written by 'myisampack', followed by the version
+    // of the packed format
+    uint8_t const magic[] = {254, 254, 8};
+
+    std::string dataFileName = fileName;
+    auto const dot = dataFileName.rfind('.');
+    if ((dot != std::string::npos) and (dataFileName.find('/', dot) == std::string::npos)) {
+        dataFileName.erase(dot);
+    }
+    dataFileName += ".MYD";
+
+    std::FILE* fp = std::fopen(dataFileName.c_str(), "rb");
+    if (not fp) return false;
+
+    uint8_t buf[4];
+    bool const packed =
+        (std::fread(buf, sizeof(uint8_t), sizeof(buf), fp) == sizeof(buf)) and
+        (std::memcmp(buf, magic, sizeof(magic)) == 0);
+    std::fclose(fp);
+
+    return packed;
+}
+
 std::string FileUtils::getEffectiveUser() {
     return std::string(getpwuid(geteuid())->pw_name);
 }
@@ -200,11 +237,11 @@ std::string FileUtils::getEffectiveUser() {
 /////////////////////////////////////
 
 FileCsComputeEngine::FileCsComputeEngine(std::string const& fileName,
-                                         size_t recordSizeBytes)
+                                         size_t recordSizeBytes,
+                                         size_t ioDepth)
     :   _fileName(fileName),
         _recordSizeBytes(recordSizeBytes),
-        _fp(0),
-        _buf(0),
+        _fd(-1),
         _bytes(0),
         _cs(0) {
 
@@ -215,57 +252,59 @@ FileCsComputeEngine::FileCsComputeEngine(std::string const& fileName,
         throw std::invalid_argument(
                         "FileCsComputeEngine:  invalid record size " + std::to_string(_recordSizeBytes));
     }
-    _fp = std::fopen(_fileName.c_str(), "rb");
-    if (not _fp) {
+    if (not ioDepth) {
+        throw std::invalid_argument("FileCsComputeEngine:  the I/O depth can't be 0");
+    }
+    _fd = ::open(_fileName.c_str(), O_RDONLY);
+    if (_fd < 0) {
         throw std::runtime_error(
             std::string("FileCsComputeEngine:  file open error: ") + std::strerror(errno) +
             std::string(", file: ") + _fileName);
     }
-    _buf = new uint8_t[_recordSizeBytes];
+#ifdef POSIX_FADV_SEQUENTIAL
+    ::posix_fadvise(_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    try {
+        _reader.reset(new AsyncFileReader(_fd, _recordSizeBytes, ioDepth));
+    } catch (...) {
+        ::close(_fd);
+        throw;
+    }
 }
 
 
 FileCsComputeEngine::~FileCsComputeEngine() {
-    if (_fp)  std::fclose(_fp);
-    if (_buf) delete [] _buf;
+    // The reader waits for its reads in flight before the file is closed
+    _reader.reset();
+    if (_fd >= 0) ::close(_fd);
 }
 
 bool FileCsComputeEngine::execute() {
 
-    if (not _fp) {
+    if (_fd < 0) {
         throw std::logic_error("FileCsComputeEngine:  file is already closed");
     }
-    size_t const num = std::fread(_buf, sizeof(uint8_t), _recordSizeBytes, _fp);
-    if (num) {
+    uint8_t const* buf = nullptr;
+    ssize_t const num = _reader->next(buf);
+    if (num > 0) {
         _bytes += num;
-        for (uint8_t *ptr = _buf, *end = _buf + num; ptr != end; ++ptr) {
+        for (uint8_t const *ptr = buf, *end = buf + num; ptr != end; ++ptr) {
             _cs += (uint64_t)(*ptr);
         }
         return false;
     }
+    _reader.reset();
+    ::close(_fd);
+    _fd = -1;
 
     // I/O error?
-    if (std::ferror(_fp)) {
-        const std::string err =
-            std::string("FileCsComputeEngine:  file read error: ") + std::strerror(errno) +
-            std::string(", file: ") + _fileName;
-
-        fclose(_fp);
-        _fp = nullptr;
-
-        delete [] _buf;
-        _buf = nullptr;
-
-        throw std::runtime_error(err);
+    if (num < 0) {
+        throw std::runtime_error(
+            std::string("FileCsComputeEngine:  file read error: ") + std::strerror(-num) +
+            std::string(", file: ") + _fileName);
     }
 
     // EOF
-    std::fclose(_fp);
-    _fp = nullptr;
-
-    delete [] _buf;
-    _buf = nullptr;
-
     return true;
 }
 
@@ -344,4 +383,207 @@ bool MultiFileCsComputeEngine::execute() {
     return false;
 }
 
+/////////////////////////////////////////
+//    class ParallelCsComputeEngine    //
+/////////////////////////////////////////
+
+struct ParallelCsComputeEngine::State {
+
+    /// The result of processing one file
+    struct File {
+        bool done = false;
+        uint64_t bytes = 0;
+        uint32_t cs = 0;
+        std::string error;
+    };
+
+    State(size_t recordSizeBytes_, size_t ioDepth_, size_t numFiles)
+        :   recordSizeBytes(recordSizeBytes_),
+            ioDepth(ioDepth_),
+            files(numFiles) {
+    }
+
+    size_t const recordSizeBytes;
+    size_t const ioDepth;
+
+    /// Set by the engine's destructor to stop the threads
+    std::atomic<bool> cancelled{false};
+
+    std::mutex mtx;                 ///< Protects the members below
+    std::condition_variable cv;     ///< Notified each time a file is done
+    std::vector<File> files;        ///< In the order of the engine's file names
+    size_t numDone = 0;
+};
+
+namespace {
+
+/// The alignment of the record buffers, which matches the pages
+/// of the page cache.
+size_t const recordAlignmentBytes = 4096;
+
+/**
+ * @return the pool of threads shared by all instances of ParallelCsComputeEngine,
+ * with at least the specified number of threads. The pool is never destroyed
+ * because its threads may still be reading files abandoned by the engines
+ * when the process exits.
+ */
+util::ThreadPool::Ptr csComputePool(size_t numThreads) {
+    static std::mutex mtx;
+    static util::ThreadPool::Ptr* pool = nullptr;
+    std::lock_guard<std::mutex> lock(mtx);
+    if (pool == nullptr) {
+        pool = new util::ThreadPool::Ptr(
+            util::ThreadPool::newThreadPool(numThreads, std::make_shared<util::CommandQueue>()));
+    } else if ((*pool)->getTargetThrdCount() < numThreads) {
+        (*pool)->resize(numThreads);
+    }
+    return *pool;
+}
+
+/**
+ * Compute the checksum of a file and store the result in the file's slot
+ * of the engine's state. This runs in the threads of the pool.
+ */
+void computeFileCs(std::shared_ptr<ParallelCsComputeEngine::State> const& state,
+                   size_t idx,
+                   std::string const& fileName) {
+
+    if (state->cancelled) return;
+
+    uint64_t bytes = 0;
+    uint32_t cs = 0;
+    std::string error;
+
+    int const fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = std::string("ParallelCsComputeEngine:  file open error: ") + std::strerror(errno) +
+                std::string(", file: ") + fileName;
+    } else {
+#ifdef POSIX_FADV_SEQUENTIAL
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+        // The next records are read while the checksum of the current one
+        // is computed. The reader waits for its reads in flight when it's
+        // destroyed, before the file is closed.
+        try {
+            AsyncFileReader reader(fd, state->recordSizeBytes, state->ioDepth);
+            while (not state->cancelled) {
+                uint8_t const* buf = nullptr;
+                ssize_t const num = reader.next(buf);
+                if (num == 0) break;
+                if (num < 0) {
+                    error = std::string("ParallelCsComputeEngine:  file read error: ") +
+                            std::strerror(-num) + std::string(", file: ") + fileName;
+                    break;
+                }
+                cs = util::StringHash::getCrc32c(reinterpret_cast<char const*>(buf), num, cs);
+                bytes += num;
+            }
+        } catch (std::bad_alloc const&) {
+            error = "ParallelCsComputeEngine:  failed to allocate the record buffers of " +
+                    std::to_string(state->recordSizeBytes) + " bytes, file: " + fileName;
+        } catch (std::exception const& ex) {
+            error = std::string("ParallelCsComputeEngine:  ") + ex.what() + ", file: " + fileName;
+        }
+        ::close(fd);
+    }
+    if (state->cancelled) return;
+
+    std::lock_guard<std::mutex> lock(state->mtx);
+    ParallelCsComputeEngine::State::File& file = state->files[idx];
+    file.done  = true;
+    file.bytes = bytes;
+    file.cs    = cs;
+    file.error = error;
+    ++(state->numDone);
+    state->cv.notify_all();
+}
+
+} // namespace
+
+std::string const ParallelCsComputeEngine::ALGORITHM = "crc32c";
+
+ParallelCsComputeEngine::~ParallelCsComputeEngine() {
+    _state->cancelled = true;
+}
+
+ParallelCsComputeEngine::ParallelCsComputeEngine(std::vector<std::string> const& fileNames,
+                                                 size_t numThreads,
+                                                 size_t recordSizeBytes,
+                                                 size_t ioDepth)
+    :   _fileNames(fileNames) {
+
+    if (not numThreads) {
+        throw std::invalid_argument("ParallelCsComputeEngine:  the number of threads can't be 0");
+    }
+    if (not ioDepth) {
+        throw std::invalid_argument("ParallelCsComputeEngine:  the I/O depth can't be 0");
+    }
+    if (not recordSizeBytes or (recordSizeBytes > FileUtils::MAX_RECORD_SIZE_BYTES)) {
+        throw std::invalid_argument(
+                        "ParallelCsComputeEngine:  invalid record size " + std::to_string(recordSizeBytes));
+    }
+
+    // Round the record size up to the alignment of the buffers
+    size_t const alignedRecordSizeBytes =
+        (recordSizeBytes + recordAlignmentBytes - 1) / recordAlignmentBytes * recordAlignmentBytes;
+
+    _state = std::make_shared<State>(alignedRecordSizeBytes, ioDepth, _fileNames.size());
+
+    util::CommandQueue::Ptr const queue = csComputePool(numThreads)->getQueue();
+    for (size_t idx = 0; idx < _fileNames.size(); ++idx) {
+        std::shared_ptr<State> const state = _state;
+        std::string const fileName = _fileNames[idx];
+        queue->queCmd(std::make_shared<util::Command>(
+            [state, idx, fileName](util::CmdData*) {
+                computeFileCs(state, idx, fileName);
+            }
+        ));
+    }
+}
+
+size_t ParallelCsComputeEngine::bytes(std::string const& fileName) const {
+
+    auto const itr = std::find(_fileNames.begin(), _fileNames.end(), fileName);
+    if (_fileNames.end() == itr) {
+        throw std::invalid_argument(
+                "ParallelCsComputeEngine::bytes()  unknown file: " + fileName);
+    }
+    std::lock_guard<std::mutex> lock(_state->mtx);
+    State::File const& file = _state->files[itr - _fileNames.begin()];
+    if (not file.done) {
+        throw std::logic_error(
+            "ParallelCsComputeEngine::bytes()  the file hasn't been processed: " + fileName);
+    }
+    return file.bytes;
+}
+
+uint32_t ParallelCsComputeEngine::cs(std::string const& fileName) const {
+
+    auto const itr = std::find(_fileNames.begin(), _fileNames.end(), fileName);
+    if (_fileNames.end() == itr) {
+        throw std::invalid_argument(
+                "ParallelCsComputeEngine::cs()  unknown file: " + fileName);
+    }
+    std::lock_guard<std::mutex> lock(_state->mtx);
+    State::File const& file = _state->files[itr - _fileNames.begin()];
+    if (not file.done) {
+        throw std::logic_error(
+            "ParallelCsComputeEngine::cs()  the file hasn't been processed: " + fileName);
+    }
+    return file.cs;
+}
+
+bool ParallelCsComputeEngine::execute() {
+
+    std::unique_lock<std::mutex> lock(_state->mtx);
+    _state->cv.wait_for(lock, std::chrono::milliseconds(100), [this]() {
+        return _state->numDone == _state->files.size();
+    });
+    for (auto&& file: _state->files) {
+        if (file.done and not file.error.empty()) throw std::runtime_error(file.error);
+    }
+    return _state->numDone == _state->files.size();
+}
+
 }}} // namespace lsst::qserv::replica
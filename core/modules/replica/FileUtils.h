@@ -38,6 +38,7 @@ namespace qserv {
 namespace replica {
 
 // Forward declarations
+class AsyncFileReader;
 class DatabaseInfo;
 
 /**
@@ -55,6 +56,9 @@ public:
     /// The maximum number of bytes to be read during file I/O operations
     static constexpr size_t MAX_RECORD_SIZE_BYTES = 1024*1024*1024;
 
+    /// The default number of records of a file read at once
+    static constexpr size_t DEFAULT_IO_DEPTH = 4;
+
     // Default construction and copy semantics are prohibited
 
     FileUtils() = delete;
@@ -123,6 +127,18 @@ public:
     static uint64_t compute_cs(std::string const& fileName,
                                size_t recordSizeBytes=DEFAULT_RECORD_SIZE_BYTES);
 
+    /**
+     * Check if a MyISAM table was compressed by 'myisampack'. The data file
+     * (.MYD) of such tables begins with the signature of the packed format.
+     *
+     * @param fileName - the path name of any file of the table. The data file
+     *                   next to it is read.
+     *
+     * @return 'true' if the file is packed, 'false' if it isn't or if it
+     * couldn't be read
+     */
+    static bool isPackedMyISAM(std::string const& fileName);
+
     /// @return user account under which the current process runs
     static std::string getEffectiveUser();
 };
@@ -164,8 +180,9 @@ public:
      *
      * Exceptions:
      *   std::runtime_error    - if there was a problem with opening or reading the file
-     *   std::invalid_argument - if the file name is empty or if the record size
-     *                           is 0 or too huge (more than FileUtils::MAX_RECORD_SIZE_BYTES)
+     *   std::invalid_argument - if the file name is empty, if the record size
+     *                           is 0 or too huge (more than FileUtils::MAX_RECORD_SIZE_BYTES),
+     *                           or if the I/O depth is 0
      *
      * At each iteration of the engine (when method FileCsComputeEngine::execute()
      * is called) the engine will read up to 'recordSizeBytes' bytes from
@@ -175,12 +192,17 @@ public:
      *
      * The engine will close a file immediately after reaching its EOF.
      *
+     * The next records of the file are read ahead while the current one
+     * is processed, see class AsyncFileReader.
+     *
      * @param fileName        - the name of a file to read
      * @param recordSizeBytes - desired record size
+     * @param ioDepth         - the number of records read at once
      *
      */
     explicit FileCsComputeEngine(std::string const& fileName,
-                                 size_t recordSizeBytes=FileUtils::DEFAULT_RECORD_SIZE_BYTES);
+                                 size_t recordSizeBytes=FileUtils::DEFAULT_RECORD_SIZE_BYTES,
+                                 size_t ioDepth=FileUtils::DEFAULT_IO_DEPTH);
 
     /// @return the name of the file
     std::string const& fileName() const { return _fileName; }
@@ -210,11 +232,11 @@ private:
     /// The desired record size when reading from the file
     size_t const _recordSizeBytes;
 
-    /// The file pointer
-    std::FILE* _fp;
+    /// The file descriptor
+    int _fd;
 
-    /// The record buffer
-    uint8_t* _buf;
+    /// The reader of the records (owns the record buffers)
+    std::unique_ptr<AsyncFileReader> _reader;
 
     /// The number of bytes read so far
     size_t _bytes;
@@ -321,6 +343,100 @@ private:
     std::map<std::string, std::unique_ptr<FileCsComputeEngine>> _processed;
 };
 
+/**
+ * Class ParallelCsComputeEngine computes the CRC-32C checksums and measures
+ * the sizes of files in a collection. Unlike MultiFileCsComputeEngine the files
+ * are read in large records by a pool of threads shared by all engines
+ * of the process, so that the files of many chunks are processed at once.
+ * The checksums are computed with the SSE4.2 crc32 instruction where the CPU
+ * has it.
+ *
+ * The checksums aren't comparable with the control sums computed by
+ * FileUtils::compute_cs(), and they're reported along with the name
+ * of the algorithm ParallelCsComputeEngine::ALGORITHM.
+ */
+class ParallelCsComputeEngine {
+
+public:
+
+    /// The name of the checksum algorithm
+    static std::string const ALGORITHM;
+
+    /// The default number of bytes to be read from a file at a time
+    static constexpr size_t DEFAULT_RECORD_SIZE_BYTES = 4*1024*1024;
+
+    // Default construction and copy semantics are prohibited
+
+    ParallelCsComputeEngine() = delete;
+    ParallelCsComputeEngine(ParallelCsComputeEngine const&) = delete;
+    ParallelCsComputeEngine& operator=(ParallelCsComputeEngine const&) = delete;
+
+    /// Destructor (files which are still waiting to be processed are abandoned)
+    ~ParallelCsComputeEngine();
+
+    /**
+     * The normal constructor. The files are queued to the pool right away.
+     *
+     * @param fileNames       - files to be processed
+     * @param numThreads      - the minimum number of threads in the pool
+     * @param recordSizeBytes - record size (for reading from files)
+     * @param ioDepth         - the number of records of a file read at once
+     *
+     * @throws std::invalid_argument
+     *   if the number of threads or the I/O depth is 0, or the record size
+     *   is 0 or too huge (more than FileUtils::MAX_RECORD_SIZE_BYTES)
+     */
+    ParallelCsComputeEngine(std::vector<std::string> const& fileNames,
+                            size_t numThreads,
+                            size_t recordSizeBytes=DEFAULT_RECORD_SIZE_BYTES,
+                            size_t ioDepth=FileUtils::DEFAULT_IO_DEPTH);
+
+    /// @return the names of the files
+    std::vector<std::string> const& fileNames() const { return _fileNames; }
+
+    /**
+     * @return the number of bytes of the specified file
+     *
+     * @throws std::invalid_argument unknown file name
+     * @throws std::logic_error the file hasn't been processed
+     *
+     * @param fileName - the name of a file
+     */
+    size_t bytes(std::string const& fileName) const;
+
+    /**
+     * @return the checksum of the specified file
+     *
+     * @throws std::invalid_argument unknown file name
+     * @throws std::logic_error the file hasn't been processed
+     *
+     * @param fileName - the name of a file
+     */
+    uint32_t cs(std::string const& fileName) const;
+
+    /**
+     * Wait (for a short period of time) for the files to be processed
+     *
+     * Exceptions:
+     *   std::runtime_error - there was a problem with opening or reading a file
+     *
+     * @return 'true' (meaning 'done') when all files have been processed
+     */
+    bool execute();
+
+    /// The state of the engine shared with the threads of the pool
+    struct State;
+
+private:
+
+    /// The names of files to be processed
+    std::vector<std::string> const _fileNames;
+
+    /// The state shared with the threads, which may still hold it after
+    /// the engine is destroyed
+    std::shared_ptr<State> _state;
+};
+
 }}} // namespace lsst::qserv::replica
 
 #endif // LSST_QSERV_REPLICA_FILEUTILS_H
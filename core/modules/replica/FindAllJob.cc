@@ -30,6 +30,8 @@
 // Qserv headers
 #include "lsst/log/Log.h"
 #include "replica/Configuration.h"
+#include "replica/ReplicaDirectory.h"
+#include "replica/RequestFanOut.h"
 #include "replica/ServiceProvider.h"
 
 namespace {
@@ -58,6 +60,7 @@ std::string FindAllJob::typeName() { return "FindAllJob"; }
 FindAllJob::Ptr FindAllJob::create(std::string const& databaseFamily,
                                    bool saveReplicaInfo,
                                    bool allWorkers,
+                                   bool fromDirectory,
                                    Controller::Ptr const& controller,
                                    std::string const& parentJobId,
                                    CallbackType const& onFinish,
@@ -66,6 +69,7 @@ FindAllJob::Ptr FindAllJob::create(std::string const& databaseFamily,
         new FindAllJob(databaseFamily,
                        saveReplicaInfo,
                        allWorkers,
+                       fromDirectory,
                        controller,
                        parentJobId,
                        onFinish,
@@ -75,6 +79,7 @@ FindAllJob::Ptr FindAllJob::create(std::string const& databaseFamily,
 FindAllJob::FindAllJob(std::string const& databaseFamily,
                        bool saveReplicaInfo,
                        bool allWorkers,
+                       bool fromDirectory,
                        Controller::Ptr const& controller,
                        std::string const& parentJobId,
                        CallbackType const& onFinish,
@@ -86,6 +91,7 @@ FindAllJob::FindAllJob(std::string const& databaseFamily,
         _databaseFamily(databaseFamily),
         _saveReplicaInfo(saveReplicaInfo),
         _allWorkers(allWorkers),
+        _fromDirectory(fromDirectory),
         _databases(controller->serviceProvider()->config()->databases(databaseFamily)),
         _onFinish(onFinish),
         _numLaunched(0),
@@ -108,6 +114,7 @@ std::list<std::pair<std::string,std::string>> FindAllJob::extendedPersistentStat
     result.emplace_back("database_family",   databaseFamily());
     result.emplace_back("save_replica_info", saveReplicaInfo() ? "1" : "0");
     result.emplace_back("all_workers",       allWorkers()      ? "1" : "0");
+    result.emplace_back("from_directory",    fromDirectory()   ? "1" : "0");
     return result;
 }
 
@@ -120,23 +127,46 @@ void FindAllJob::startImpl(util::Lock const& lock) {
     auto const workerNames = allWorkers() ?
         controller()->serviceProvider()->config()->allWorkers() :
         controller()->serviceProvider()->config()->workers();
-    
+
+    // The replicas reported by the recent requests of all jobs are good
+    // enough, if the directory has them for all workers and databases
+
+    auto const directory = controller()->replicaDirectory();
+    if (fromDirectory() and not _databases.empty() and directory->covers(workerNames, _databases)) {
+        for (auto&& worker: workerNames) {
+            for (auto&& database: _databases) {
+                _replicaData.replicas.push_back(directory->replicas(worker, database));
+                for (auto&& info: _replicaData.replicas.back()) {
+                    _replicaData.chunks.atChunk(info.chunk())
+                                       .atDatabase(info.database())
+                                       .atWorker(info.worker()) = info;
+                }
+                _workerDatabaseSuccess[worker][database] = true;
+            }
+        }
+        LOGS(_log, LOG_LVL_DEBUG, context() << "startImpl  replicas taken from the directory");
+
+        summarize(lock);
+        setState(lock, State::FINISHED, ExtendedState::SUCCESS);
+        return;
+    }
+
+    // The requests are launched by the fan-out engine of the Controller
+    // as the limits on the number of requests in flight allow.
+
+    auto const fanOut = controller()->fanOut();
+
     for (auto&& worker: workerNames) {
         _replicaData.workers[worker] = false;
         for (auto&& database: _databases) {
             _workerDatabaseSuccess[worker][database]= false;
-            _requests.push_back(
-                controller()->findAllReplicas(
-                    worker,
-                    database,
-                    saveReplicaInfo(),
-                    [self] (FindAllRequest::Ptr request) {
-                        self->onRequestFinish(request);
-                    },
-                    options(lock).priority,
-                    true,   /* keepTracking*/
-                    id()    /* jobId */
-                )
+            fanOut->submit(
+                id(),
+                worker,
+                options(lock).priority,
+                [self, worker, database] (RequestFanOut::DoneType const& done) {
+                    self->launchRequest(worker, database, done);
+                }
             );
             _numLaunched++;
         }
@@ -153,6 +183,10 @@ void FindAllJob::cancelImpl(util::Lock const& lock) {
 
     LOGS(_log, LOG_LVL_DEBUG, context() << "cancelImpl");
 
+    // The requests which haven't been launched yet won't be
+
+    controller()->fanOut()->cancel(id());
+
     // To ensure no lingering "side effects" will be left after cancelling this
     // job the request cancellation should be also followed (where it makes a sense)
     // by stopping the request at corresponding worker service.
@@ -182,6 +216,42 @@ void FindAllJob::notify(util::Lock const& lock) {
     notifyDefaultImpl<FindAllJob>(lock, _onFinish);
 }
 
+void FindAllJob::launchRequest(std::string const& worker,
+                               std::string const& database,
+                               RequestFanOut::DoneType const& done) {
+
+    // The job may have finished while the request was waiting for its turn
+
+    if (state() == State::FINISHED) {
+        done();
+        return;
+    }
+
+    util::Lock lock(_mtx, context() + "launchRequest");
+
+    if (state() == State::FINISHED) {
+        done();
+        return;
+    }
+
+    auto const self = shared_from_base<FindAllJob>();
+
+    _requests.push_back(
+        controller()->findAllReplicas(
+            worker,
+            database,
+            saveReplicaInfo(),
+            [self, done] (FindAllRequest::Ptr request) {
+                done();
+                self->onRequestFinish(request);
+            },
+            options(lock).priority,
+            true,   /* keepTracking*/
+            id()    /* jobId */
+        )
+    );
+}
+
 void FindAllJob::onRequestFinish(FindAllRequest::Ptr const& request) {
 
     LOGS(_log, LOG_LVL_DEBUG, context()
@@ -226,123 +296,127 @@ void FindAllJob::onRequestFinish(FindAllRequest::Ptr const& request) {
      // before finalizing the object state and notifying clients.
 
      if (_numFinished == _numLaunched) {
+        summarize(lock);
+        finish(lock, _numSuccess == _numLaunched ? ExtendedState::SUCCESS :
+                                                   ExtendedState::FAILED);
+    }
+}
 
-         // Compute the final state of the workers participated in the operation
+void FindAllJob::summarize(util::Lock const& lock) {
 
-         for (auto const& workerEntry: _workerDatabaseSuccess) {
-            auto const& worker = workerEntry.first;
-            _replicaData.workers[worker] = true;
-            for (auto const& databaseEntry: workerEntry.second) {
-                bool const success  = databaseEntry.second;
-                if (not success) {
-                    _replicaData.workers[worker] = false;
-                    break;
-                }
+    // Compute the final state of the workers participated in the operation
+
+    for (auto const& workerEntry: _workerDatabaseSuccess) {
+        auto const& worker = workerEntry.first;
+        _replicaData.workers[worker] = true;
+        for (auto const& databaseEntry: workerEntry.second) {
+            bool const success  = databaseEntry.second;
+            if (not success) {
+                _replicaData.workers[worker] = false;
+                break;
             }
-         }
+        }
+    }
 
-         // Databases participating in a chunk
+    // Databases participating in a chunk
 
-         for (auto chunk: _replicaData.chunks.chunkNumbers()) {
-             for (auto&& database: _replicaData.chunks.chunk(chunk).databaseNames()) {
-                 _replicaData.databases[chunk].push_back(database);
-             }
-         }
+    for (auto chunk: _replicaData.chunks.chunkNumbers()) {
+        for (auto&& database: _replicaData.chunks.chunk(chunk).databaseNames()) {
+            _replicaData.databases[chunk].push_back(database);
+        }
+    }
 
-         // Workers hosting complete chunks
+    // Workers hosting complete chunks
 
-         for (auto chunk: _replicaData.chunks.chunkNumbers()) {
-             auto chunkMap = _replicaData.chunks.chunk(chunk);
+    for (auto chunk: _replicaData.chunks.chunkNumbers()) {
+        auto const& chunkMap = _replicaData.chunks.chunk(chunk);
 
-             for (auto&& database: chunkMap.databaseNames()) {
-                 auto databaseMap = chunkMap.database(database);
+        for (auto&& database: chunkMap.databaseNames()) {
+            auto const& databaseMap = chunkMap.database(database);
 
-                 for (auto &&worker: databaseMap.workerNames()) {
-                     ReplicaInfo const& replica = databaseMap.worker(worker);
+            for (auto &&worker: databaseMap.workerNames()) {
+                ReplicaInfo const& replica = databaseMap.worker(worker);
 
-                     if (replica.status() == ReplicaInfo::Status::COMPLETE) {
-                         _replicaData.complete[chunk][database].push_back(worker);
-                     }
-                 }
-             }
-         }
+                if (replica.status() == ReplicaInfo::Status::COMPLETE) {
+                    _replicaData.complete[chunk][database].push_back(worker);
+                }
+            }
+        }
+    }
 
-         // Compute the 'collocation' status of chunks on all participating workers
-         //
-         // ATTENTION: this algorithm won't consider the actual status of
-         //            chunk replicas (if they're complete, corrupts, etc.).
+    // Compute the 'collocation' status of chunks on all participating workers
+    //
+    // ATTENTION: this algorithm won't consider the actual status of
+    //            chunk replicas (if they're complete, corrupts, etc.).
 
-         for (auto chunk: _replicaData.chunks.chunkNumbers()) {
-             auto chunkMap = _replicaData.chunks.chunk(chunk);
+    for (auto chunk: _replicaData.chunks.chunkNumbers()) {
+        auto const& chunkMap = _replicaData.chunks.chunk(chunk);
 
-             // Build a list of participating databases for this chunk,
-             // and build a list of databases for each worker where the chunk
-             // is present.
-             //
-             // NOTE: Single-database chunks are always collocated. Note that
-             //       the loop over databases below has exactly one iteration.
+        // Build a list of participating databases for this chunk,
+        // and build a list of databases for each worker where the chunk
+        // is present.
+        //
+        // NOTE: Single-database chunks are always collocated. Note that
+        //       the loop over databases below has exactly one iteration.
 
-             std::map<std::string, size_t> worker2numDatabases;
+        std::map<std::string, size_t> worker2numDatabases;
 
-             for (auto&& database: chunkMap.databaseNames()) {
-                 auto databaseMap = chunkMap.database(database);
+        for (auto&& database: chunkMap.databaseNames()) {
+            auto const& databaseMap = chunkMap.database(database);
 
-                 for (auto&& worker: databaseMap.workerNames()) {
-                     worker2numDatabases[worker]++;
-                 }
-             }
+            for (auto&& worker: databaseMap.workerNames()) {
+                worker2numDatabases[worker]++;
+            }
+        }
 
-             // Crosscheck the number of databases present on each worker
-             // against the number of all databases participated within
-             // the chunk and decide for which of those workers the 'colocation'
-             // requirement is met.
+        // Crosscheck the number of databases present on each worker
+        // against the number of all databases participated within
+        // the chunk and decide for which of those workers the 'colocation'
+        // requirement is met.
 
-             for (auto&& entry: worker2numDatabases) {
-                 std::string const& worker       = entry.first;
-                 size_t      const  numDatabases = entry.second;
+        for (auto&& entry: worker2numDatabases) {
+            std::string const& worker       = entry.first;
+            size_t      const  numDatabases = entry.second;
 
-                 _replicaData.isColocated[chunk][worker] =
-                    _replicaData.databases[chunk].size() == numDatabases;
-            }
+            _replicaData.isColocated[chunk][worker] =
+                _replicaData.databases[chunk].size() == numDatabases;
         }
+    }
 
-        // Compute the 'goodness' status of each chunk
+    // Compute the 'goodness' status of each chunk
 
-        for (auto&& chunk2workers: _replicaData.isColocated) {
-            unsigned int const chunk = chunk2workers.first;
+    for (auto&& chunk2workers: _replicaData.isColocated) {
+        unsigned int const chunk = chunk2workers.first;
 
-            for (auto&& worker2collocated: chunk2workers.second) {
-                std::string const& worker = worker2collocated.first;
-                bool        const  isColocated = worker2collocated.second;
+        for (auto&& worker2collocated: chunk2workers.second) {
+            std::string const& worker = worker2collocated.first;
+            bool        const  isColocated = worker2collocated.second;
 
-                // Start with the "as good as collocated" assumption, then drill down
-                // into chunk participation in all databases on that worker to see
-                // if this will change.
-                //
-                // NOTE: watch for a little optimization if the replica is not
-                //       collocated.
+            // Start with the "as good as collocated" assumption, then drill down
+            // into chunk participation in all databases on that worker to see
+            // if this will change.
+            //
+            // NOTE: watch for a little optimization if the replica is not
+            //       collocated.
 
-                bool isGood = isColocated;
-                if (isGood) {
+            bool isGood = isColocated;
+            if (isGood) {
 
-                    auto chunkMap = _replicaData.chunks.chunk(chunk);
+                auto const& chunkMap = _replicaData.chunks.chunk(chunk);
 
-                    for (auto&& database: chunkMap.databaseNames()) {
-                        auto databaseMap = chunkMap.database(database);
+                for (auto&& database: chunkMap.databaseNames()) {
+                    auto const& databaseMap = chunkMap.database(database);
 
-                        for (auto&& thisWorker: databaseMap.workerNames()) {
-                            if (worker == thisWorker) {
-                                ReplicaInfo const& replica = databaseMap.worker(thisWorker);
-                                isGood = isGood and (replica.status() == ReplicaInfo::Status::COMPLETE);
-                            }
+                    for (auto&& thisWorker: databaseMap.workerNames()) {
+                        if (worker == thisWorker) {
+                            ReplicaInfo const& replica = databaseMap.worker(thisWorker);
+                            isGood = isGood and (replica.status() == ReplicaInfo::Status::COMPLETE);
                         }
                     }
                 }
-                _replicaData.isGood[chunk][worker] = isGood;
             }
+            _replicaData.isGood[chunk][worker] = isGood;
         }
-        finish(lock, _numSuccess == _numLaunched ? ExtendedState::SUCCESS :
-                                                   ExtendedState::FAILED);
     }
 }
 
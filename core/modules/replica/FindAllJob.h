@@ -33,6 +33,7 @@
 #include "replica/Job.h"
 #include "replica/FindAllRequest.h"
 #include "replica/ReplicaInfo.h"
+#include "replica/RequestFanOut.h"
 #include "replica/SemanticMaps.h"
 
 // Forward declarations
@@ -136,6 +137,10 @@ public:
      * @param databaseFamily  - name of a database family
      * @param saveReplicaInfo - save replica info in a database
      * @param allWorkers      - engage all known workers regardless of their status
+     * @param fromDirectory   - take the replicas from the replica directory of
+     *                          the Controller if it has recent listings of all
+     *                          databases of the family at all workers, instead
+     *                          of asking the workers
      * @param controller      - for launching requests
      * @param parentJobId     - optional identifier of a parent job
      * @param onFinish        - callback function to be called upon a completion of the job
@@ -146,6 +151,7 @@ public:
     static Ptr create(std::string const& databaseFamily,
                       bool saveReplicaInfo,
                       bool allWorkers,
+                      bool fromDirectory,
                       Controller::Ptr const& controller,
                       std::string const& parentJobId=std::string(),
                       CallbackType const& onFinish=nullptr,
@@ -168,6 +174,9 @@ public:
     /// @return 'true' if all known workers were engaged
     bool allWorkers() const { return _allWorkers; }
 
+    /// @return 'true' if the replicas may be taken from the replica directory
+    bool fromDirectory() const { return _fromDirectory; }
+
     /**
      * Return the result of the operation.
      *
@@ -202,6 +211,7 @@ protected:
     FindAllJob(std::string const& databaseFamily,
                bool saveReplicaInfo,
                bool allWorkers,
+               bool fromDirectory,
                Controller::Ptr const& controller,
                std::string const& parentJobId,
                CallbackType const& onFinish,
@@ -222,6 +232,17 @@ protected:
       */
     void notify(util::Lock const& lock) final;
 
+    /**
+     * Launch a request when the fan-out engine of the Controller allows.
+     *
+     * @param worker   - the name of a worker
+     * @param database - the name of a database
+     * @param done     - the function to be called when the request finishes
+     */
+    void launchRequest(std::string const& worker,
+                       std::string const& database,
+                       RequestFanOut::DoneType const& done);
+
     /**
      * The callback function to be invoked on a completion of each request.
      *
@@ -229,6 +250,14 @@ protected:
      */
     void onRequestFinish(FindAllRequest::Ptr const& request);
 
+    /**
+     * Compute the summary members of the result (all but the replicas
+     * and the chunks) once all replicas have been collected
+     *
+     * @param lock - the lock must be acquired by a caller of the method
+     */
+    void summarize(util::Lock const& lock);
+
 protected:
 
     /// The name of a database family defining a scope of the operation
@@ -240,13 +269,16 @@ protected:
     /// The flag (if 'true') for engaging all known workers regardless of their status
     bool const _allWorkers;
 
+    /// The flag (if 'true') for taking the replicas from the replica directory
+    bool const _fromDirectory;
+
     /// Members of the family
     std::vector<std::string> const _databases;
 
     /// Client-defined function to be called upon the completion of the job
     CallbackType _onFinish;
 
-    /// A collection of requests implementing the operation
+    /// A collection of the requests launched so far
     std::list<FindAllRequest::Ptr> _requests;
 
     /// Per-worker and per database flags indicating if the corresponding replica
@@ -58,6 +58,7 @@ FindRequest::Ptr FindRequest::create(ServiceProvider::Ptr const& serviceProvider
                                      CallbackType const& onFinish,
                                      int priority,
                                      bool computeCheckSum,
+                                     double sampleRate,
                                      bool keepTracking,
                                      std::shared_ptr<Messenger> const& messenger) {
     return FindRequest::Ptr(
@@ -69,6 +70,7 @@ FindRequest::Ptr FindRequest::create(ServiceProvider::Ptr const& serviceProvider
                         onFinish,
                         priority,
                         computeCheckSum,
+                        sampleRate,
                         keepTracking,
                         messenger));
 }
@@ -81,6 +83,7 @@ FindRequest::FindRequest(ServiceProvider::Ptr const& serviceProvider,
                            CallbackType const& onFinish,
                            int  priority,
                            bool computeCheckSum,
+                           double sampleRate,
                            bool keepTracking,
                            std::shared_ptr<Messenger> const& messenger)
     :   RequestMessenger(serviceProvider,
@@ -94,6 +97,7 @@ FindRequest::FindRequest(ServiceProvider::Ptr const& serviceProvider,
         _database(database),
         _chunk(chunk),
         _computeCheckSum(computeCheckSum),
+        _sampleRate(sampleRate),
         _onFinish(onFinish) {
 
     Request::serviceProvider()->assertDatabaseIsValid(database);
@@ -110,7 +114,8 @@ void FindRequest::startImpl(util::Lock const& lock) {
          << " worker: "          << worker()
          << " database: "        << database()
          << " chunk: "           << chunk()
-         << " computeCheckSum: " << (computeCheckSum() ? "true" : "false"));
+         << " computeCheckSum: " << (computeCheckSum() ? "true" : "false")
+         << " sampleRate: "      << sampleRate());
 
     // Serialize the Request message header and the request itself into
     // the network buffer.
@@ -129,6 +134,7 @@ void FindRequest::startImpl(util::Lock const& lock) {
     message.set_database(database());
     message.set_chunk(chunk());
     message.set_compute_cs(computeCheckSum());
+    message.set_sample_rate(sampleRate());
 
     buffer()->serialize(message);
 
@@ -320,6 +326,7 @@ std::list<std::pair<std::string,std::string>> FindRequest::extendedPersistentSta
     std::list<std::pair<std::string,std::string>> result;
     result.emplace_back("database", database());
     result.emplace_back("chunk",    std::to_string(chunk()));
+    if (sampleRate() > 0) result.emplace_back("sample_rate", std::to_string(sampleRate()));
     return result;
 }
 
@@ -70,6 +70,7 @@ public:
     std::string const& database() const        { return _database; }
     unsigned int       chunk() const           { return _chunk; }
     bool               computeCheckSum() const { return _computeCheckSum; }
+    double             sampleRate() const      { return _sampleRate; }
 
     /// @return target request specific parameters
     FindRequestParams const& targetRequestParams() const { return _targetRequestParams; }
@@ -98,6 +99,9 @@ public:
      *                           the request.
      * @param priority         - a priority level of the request
      * @param computeCheckSum  - tell a worker server to compute check/control sum on each file
+     * @param sampleRate       - tell a worker server to compare the checksums of this fraction
+     *                           of the blocks of each file against the ones recorded when
+     *                           the file was replicated (0 disables the sampling)
      * @param keepTracking     - keep tracking the request before it finishes or fails
      * @param messenger        - an interface for communicating with workers
      *
@@ -111,6 +115,7 @@ public:
                       CallbackType const& onFinish,
                       int  priority,
                       bool computeCheckSum,
+                      double sampleRate,
                       bool keepTracking,
                       std::shared_ptr<Messenger> const& messenger);
 
@@ -127,6 +132,7 @@ private:
                 CallbackType const& onFinish,
                 int  priority,
                 bool computeCheckSum,
+                double sampleRate,
                 bool keepTracking,
                 std::shared_ptr<Messenger> const& messenger);
 
@@ -193,6 +199,9 @@ private:
     /// of each file of the chunk replica
     bool const _computeCheckSum;
 
+    /// The fraction of the blocks of each file to be verified by the sampling
+    double const _sampleRate;
+
     CallbackType _onFinish;
 
     /// Request-specific parameters of the target request
@@ -121,10 +121,12 @@ void FixUpJob::startImpl(util::Lock const& lock) {
     bool const saveReplicInfo = true;           // always save the replica info in a database because
                                                 // the algorithm depends on it.
     bool const allWorkers = false;              // only consider enabled workers
+    bool const fromDirectory = false;           // the replicas will be fixed, ask the workers
     _findAllJob = FindAllJob::create(
         databaseFamily(),
         saveReplicInfo,
         allWorkers,
+        fromDirectory,
         controller(),
         id(),
         [self] (FindAllJob::Ptr job) {
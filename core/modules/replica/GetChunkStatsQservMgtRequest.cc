@@ -0,0 +1,189 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "replica/GetChunkStatsQservMgtRequest.h"
+
+// System headers
+#include <stdexcept>
+
+// Third party headers
+#include "XrdSsi/XrdSsiProvider.hh"
+#include "XrdSsi/XrdSsiService.hh"
+
+// Qserv headers
+#include "global/ResourceUnit.h"
+#include "lsst/log/Log.h"
+#include "replica/Configuration.h"
+#include "replica/ServiceProvider.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.replica.GetChunkStatsQservMgtRequest");
+
+} /// namespace
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+GetChunkStatsQservMgtRequest::Ptr GetChunkStatsQservMgtRequest::create(
+                                        ServiceProvider::Ptr const& serviceProvider,
+                                        std::string const& worker,
+                                        std::vector<std::string> const& databases,
+                                        uint64_t updatedAfter,
+                                        GetChunkStatsQservMgtRequest::CallbackType const& onFinish) {
+    return GetChunkStatsQservMgtRequest::Ptr(
+        new GetChunkStatsQservMgtRequest(serviceProvider,
+                                         worker,
+                                         databases,
+                                         updatedAfter,
+                                         onFinish));
+ }
+
+GetChunkStatsQservMgtRequest::GetChunkStatsQservMgtRequest(
+                                ServiceProvider::Ptr const& serviceProvider,
+                                std::string const& worker,
+                                std::vector<std::string> const& databases,
+                                uint64_t updatedAfter,
+                                GetChunkStatsQservMgtRequest::CallbackType const& onFinish)
+    :   QservMgtRequest(serviceProvider,
+                        "QSERV_GET_CHUNK_STATS",
+                        worker),
+        _databases(databases),
+        _updatedAfter(updatedAfter),
+        _onFinish(onFinish),
+        _qservRequest(nullptr) {
+}
+
+wpublish::GetChunkStatsQservRequest::EntryCollection const& GetChunkStatsQservMgtRequest::entries() const {
+    if (not ((state() == State::FINISHED) and (extendedState() == ExtendedState::SUCCESS))) {
+        throw std::logic_error(
+                "GetChunkStatsQservMgtRequest::entries  entries aren't available in state: " +
+                state2string(state(), extendedState()));
+    }
+    return _entries;
+}
+
+std::list<std::pair<std::string,std::string>> GetChunkStatsQservMgtRequest::extendedPersistentState() const {
+    std::list<std::pair<std::string,std::string>> result;
+    std::string databases;
+    for (auto&& database: _databases) {
+        if (not databases.empty()) databases += ",";
+        databases += database;
+    }
+    result.emplace_back("databases",     databases);
+    result.emplace_back("updated_after", std::to_string(updatedAfter()));
+    return result;
+}
+
+void GetChunkStatsQservMgtRequest::startImpl(util::Lock const& lock) {
+
+    // Check if configuration parameters are valid
+
+    for (auto&& database: databases()) {
+        if (not serviceProvider()->config()->isKnownDatabase(database)) {
+
+            LOGS(_log, LOG_LVL_ERROR, context() << "start  ** MISCONFIGURED ** "
+                 << " database: '" << database << "'");
+
+            finish(lock, ExtendedState::CONFIG_ERROR);
+            return;
+        }
+    }
+
+    // Submit the actual request
+
+    auto const request = shared_from_base<GetChunkStatsQservMgtRequest>();
+
+    _qservRequest = wpublish::GetChunkStatsQservRequest::create(
+        databases(),
+        updatedAfter(),
+        [request] (wpublish::GetChunkStatsQservRequest::Status status,
+                   std::string const& error,
+                   wpublish::GetChunkStatsQservRequest::EntryCollection const& entries) {
+
+            // IMPORTANT: the final state is required to be tested twice. The first time
+            // it's done in order to avoid deadlock on the "in-flight" callbacks reporting
+            // their completion while the request termination is in a progress. And the second
+            // test is made after acquiring the lock to recheck the state in case if it
+            // has transitioned while acquiring the lock.
+
+            if (request->state() == State::FINISHED) return;
+        
+            util::Lock lock(request->_mtx, request->context() + "startImpl[callback]");
+        
+            if (request->state() == State::FINISHED) return;
+
+            switch (status) {
+
+                case wpublish::GetChunkStatsQservRequest::Status::SUCCESS:
+
+                    request->_entries = entries;
+                    request->finish(lock, QservMgtRequest::ExtendedState::SUCCESS);
+                    break;
+
+                case wpublish::GetChunkStatsQservRequest::Status::ERROR:
+
+                    request->finish(lock, QservMgtRequest::ExtendedState::SERVER_ERROR, error);
+                    break;
+
+                default:
+                    throw std::logic_error(
+                                    "GetChunkStatsQservMgtRequest:  unhandled server status: " +
+                                    wpublish::GetChunkStatsQservRequest::status2str(status));
+            }
+        }
+    );
+    XrdSsiResource resource(ResourceUnit::makeWorkerPath(worker()));
+    service()->ProcessRequest(*_qservRequest, resource);
+}
+
+void GetChunkStatsQservMgtRequest::finishImpl(util::Lock const& lock) {
+
+    switch (extendedState()) {
+
+        case ExtendedState::CANCELLED:
+        case ExtendedState::TIMEOUT_EXPIRED:
+
+            // And if the SSI request is still around then tell it to stop
+
+            if (_qservRequest) {
+                bool const cancel = true;
+                _qservRequest->Finished(cancel);
+            }
+            break;
+
+        default:
+            break;
+    }
+    _qservRequest = nullptr;
+}
+
+void GetChunkStatsQservMgtRequest::notify(util::Lock const& lock) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "notify");
+
+    notifyDefaultImpl<GetChunkStatsQservMgtRequest>(lock, _onFinish);
+}
+
+}}} // namespace lsst::qserv::replica
@@ -0,0 +1,156 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_REPLICA_GET_CHUNK_STATS_QSERVMGTREQUEST_H
+#define LSST_QSERV_REPLICA_GET_CHUNK_STATS_QSERVMGTREQUEST_H
+
+// System headers
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Third party headers
+
+// Qserv headers
+#include "replica/QservMgtRequest.h"
+#include "replica/ServiceProvider.h"
+#include "wpublish/GetChunkStatsQservRequest.h"
+
+// This header declarations
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+/**
+  * Class GetChunkStatsQservMgtRequest implements a request retrieving the sizes
+  * of the chunk tables of Qserv workers and the completion times of the tasks
+  * which scanned them.
+  */
+class GetChunkStatsQservMgtRequest
+    :   public QservMgtRequest  {
+
+public:
+
+    /// The pointer type for instances of the class
+    typedef std::shared_ptr<GetChunkStatsQservMgtRequest> Ptr;
+
+    /// The function type for notifications on the completion of the request
+    typedef std::function<void(Ptr)> CallbackType;
+
+    // Default construction and copy semantics are prohibited
+
+    GetChunkStatsQservMgtRequest() = delete;
+    GetChunkStatsQservMgtRequest(GetChunkStatsQservMgtRequest const&) = delete;
+    GetChunkStatsQservMgtRequest& operator=(GetChunkStatsQservMgtRequest const&) = delete;
+
+    ~GetChunkStatsQservMgtRequest() final = default;
+
+    /**
+     * Static factory method is needed to prevent issues with the lifespan
+     * and memory management of instances created otherwise (as values or via
+     * low-level pointers).
+     *
+     * @param serviceProvider - reference to a provider of services
+     * @param worker          - the name of a worker
+     * @param databases       - the databases of the tables
+     * @param updatedAfter    - (optional) only report the sizes of the tables modified
+     *                          at or after this time (seconds), of all tables if 0
+     * @param onFinish        - (optional) callback function to be called upon request completion
+     *
+     * @return pointer to the created object
+     */
+    static Ptr create(ServiceProvider::Ptr const& serviceProvider,
+                      std::string const& worker,
+                      std::vector<std::string> const& databases,
+                      uint64_t updatedAfter = 0,
+                      CallbackType const& onFinish = nullptr);
+
+    /// @return the databases of the tables
+    std::vector<std::string> const& databases() const { return _databases; }
+
+    /// @return the time (seconds) of the oldest modification of the tables to be reported
+    uint64_t updatedAfter() const { return _updatedAfter; }
+
+    /**
+     * @return collection of the tables reported from the corresponding Qserv worker
+     *
+     * ATTENTION: the method will throw exception std::logic_error if called
+     *            before the request finishes or if it's finished with any
+     *            status but SUCCESS.
+     */
+    wpublish::GetChunkStatsQservRequest::EntryCollection const& entries() const;
+
+    /**
+     * @see QservMgtRequest::extendedPersistentState()
+     */
+    std::list<std::pair<std::string,std::string>> extendedPersistentState() const override;
+
+private:
+
+    /**
+     * Construct the request with the pointer to the services provider
+     *
+     * @see GetChunkStatsQservMgtRequest::created()
+     */
+    GetChunkStatsQservMgtRequest(ServiceProvider::Ptr const& serviceProvider,
+                                 std::string const& worker,
+                                 std::vector<std::string> const& databases,
+                                 uint64_t updatedAfter,
+                                 CallbackType const& onFinish);
+
+    /**
+      * @see QservMgtRequest::startImpl
+      */
+    void startImpl(util::Lock const& lock) final;
+
+    /**
+      * @see QservMgtRequest::finishImpl
+      */
+    void finishImpl(util::Lock const& lock) final;
+
+    /**
+      * @see QservMgtRequest::notify
+      */
+    void notify(util::Lock const& lock) final;
+
+private:
+
+    /// The databases of the tables
+    std::vector<std::string> const _databases;
+
+    /// The time (seconds) of the oldest modification of the tables to be reported
+    uint64_t const _updatedAfter;
+
+    /// The callback function for sending a notification upon request completion
+    CallbackType _onFinish;
+
+    /// A request to the remote services
+    wpublish::GetChunkStatsQservRequest::Ptr _qservRequest;
+
+    /// A collection of the tables reported by the Qserv worker
+    wpublish::GetChunkStatsQservRequest::EntryCollection _entries;
+};
+
+}}} // namespace lsst::qserv::replica
+
+#endif // LSST_QSERV_REPLICA_GET_CHUNK_STATS_QSERVMGTREQUEST_H
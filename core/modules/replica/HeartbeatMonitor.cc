@@ -0,0 +1,390 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "replica/HeartbeatMonitor.h"
+
+// System headers
+#include <stdexcept>
+
+// Third party headers
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+// Qserv headers
+#include "lsst/log/Log.h"
+#include "proto/replication.pb.h"
+#include "replica/Common.h"             // Generators::uniqueId()
+#include "replica/Configuration.h"
+#include "replica/Performance.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.replica.HeartbeatMonitor");
+
+/// The number of intervals without heartbeats after which a worker
+/// is no longer considered alive
+unsigned int const missedIntervals = 3;
+
+} /// namespace
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+struct HeartbeatMonitor::Channel {
+
+    Channel(std::string const& worker_,
+            boost::asio::io_service& io_service,
+            size_t bufferCapacityBytes)
+        :   worker(worker_),
+            resolver(io_service),
+            socket(io_service),
+            timer(io_service),
+            buffer(bufferCapacityBytes) {
+    }
+
+    std::string const worker;
+
+    boost::asio::ip::tcp::resolver resolver;
+    boost::asio::ip::tcp::socket   socket;
+    boost::asio::deadline_timer    timer;
+
+    ProtocolBuffer buffer;
+
+    /// 'true' while the connection is established
+    bool connected = false;
+};
+
+HeartbeatMonitor::Ptr HeartbeatMonitor::create(ServiceProvider::Ptr const& serviceProvider,
+                                               unsigned int intervalMs) {
+    return Ptr(new HeartbeatMonitor(serviceProvider, intervalMs));
+}
+
+HeartbeatMonitor::HeartbeatMonitor(ServiceProvider::Ptr const& serviceProvider,
+                                   unsigned int intervalMs)
+    :   _serviceProvider(serviceProvider),
+        _intervalMs(intervalMs),
+        _stopped(false) {
+
+    if (0 == intervalMs) {
+        throw std::invalid_argument("HeartbeatMonitor::" + std::string(__func__) +
+                                    "  the interval can't be 0");
+    }
+}
+
+void HeartbeatMonitor::start(std::vector<std::string> const& workers) {
+
+    util::Lock lock(_mtx, context() + "start");
+
+    _stopped = false;
+    for (auto&& worker: workers) {
+        if (_channels.count(worker)) continue;
+
+        auto const channel = std::make_shared<Channel>(
+            worker,
+            _serviceProvider->io_service(),
+            _serviceProvider->config()->requestBufferSizeBytes());
+        _channels[worker] = channel;
+        resolve(lock, channel);
+    }
+}
+
+void HeartbeatMonitor::stop() {
+
+    util::Lock lock(_mtx, context() + "stop");
+
+    _stopped = true;
+    for (auto&& entry: _channels) {
+        auto const& channel = entry.second;
+        boost::system::error_code ec;
+        channel->resolver.cancel();
+        channel->timer.cancel(ec);
+        channel->socket.close(ec);
+    }
+    _channels.clear();
+}
+
+std::map<std::string, HeartbeatMonitor::Heartbeat> HeartbeatMonitor::heartbeats() const {
+    util::Lock lock(_mtx, context() + "heartbeats");
+    return _heartbeats;
+}
+
+bool HeartbeatMonitor::alive(std::string const& worker) const {
+
+    util::Lock lock(_mtx, context() + "alive");
+
+    auto const itr = _heartbeats.find(worker);
+    if (itr == _heartbeats.end()) return false;
+
+    return PerformanceUtils::now() - itr->second.receiveTime < ::missedIntervals * _intervalMs;
+}
+
+void HeartbeatMonitor::resolve(util::Lock const& lock,
+                               ChannelPtr const& channel) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "resolve  worker=" << channel->worker);
+
+    auto const info = _serviceProvider->config()->workerInfo(channel->worker);
+
+    boost::asio::ip::tcp::resolver::query query(
+        info.svcHost,
+        std::to_string(info.svcPort)
+    );
+    channel->resolver.async_resolve(
+        query,
+        boost::bind(
+            &HeartbeatMonitor::resolved,
+            shared_from_this(),
+            channel,
+            boost::asio::placeholders::error,
+            boost::asio::placeholders::iterator
+        )
+    );
+}
+
+void HeartbeatMonitor::resolved(ChannelPtr const& channel,
+                                boost::system::error_code const& ec,
+                                boost::asio::ip::tcp::resolver::iterator iter) {
+
+    util::Lock lock(_mtx, context() + "resolved");
+
+    if (_stopped or (ec == boost::asio::error::operation_aborted)) return;
+
+    if (ec.value() != 0) {
+        restart(lock, channel);
+        return;
+    }
+    boost::asio::async_connect(
+        channel->socket,
+        iter,
+        boost::bind(
+            &HeartbeatMonitor::connected,
+            shared_from_this(),
+            channel,
+            boost::asio::placeholders::error,
+            boost::asio::placeholders::iterator
+        )
+    );
+}
+
+void HeartbeatMonitor::connected(ChannelPtr const& channel,
+                                 boost::system::error_code const& ec,
+                                 boost::asio::ip::tcp::resolver::iterator iter) {
+
+    util::Lock lock(_mtx, context() + "connected");
+
+    if (_stopped or (ec == boost::asio::error::operation_aborted)) return;
+
+    if (ec.value() != 0) {
+        restart(lock, channel);
+        return;
+    }
+    channel->connected = true;
+
+    // Subscribe to the heartbeats
+
+    proto::ReplicationRequestHeader hdr;
+    hdr.set_id(Generators::uniqueId());
+    hdr.set_type(proto::ReplicationRequestHeader::SERVICE);
+    hdr.set_service_type(proto::ReplicationServiceRequestType::SERVICE_HEARTBEAT);
+
+    proto::ReplicationServiceHeartbeatRequest request;
+    request.set_interval_ms(_intervalMs);
+
+    channel->buffer.resize();
+    channel->buffer.serialize(hdr);
+    channel->buffer.serialize(request);
+
+    boost::asio::async_write(
+        channel->socket,
+        boost::asio::buffer(
+            channel->buffer.data(),
+            channel->buffer.size()
+        ),
+        boost::bind(
+            &HeartbeatMonitor::subscribed,
+            shared_from_this(),
+            channel,
+            boost::asio::placeholders::error,
+            boost::asio::placeholders::bytes_transferred
+        )
+    );
+}
+
+void HeartbeatMonitor::subscribed(ChannelPtr const& channel,
+                                  boost::system::error_code const& ec,
+                                  size_t bytes_transferred) {
+
+    util::Lock lock(_mtx, context() + "subscribed");
+
+    if (_stopped or (ec == boost::asio::error::operation_aborted)) return;
+
+    if (ec.value() != 0) {
+        restart(lock, channel);
+        return;
+    }
+    wait(lock, channel, ::missedIntervals * _intervalMs);
+    receive(lock, channel);
+}
+
+void HeartbeatMonitor::receive(util::Lock const& lock,
+                               ChannelPtr const& channel) {
+
+    // Only the frame is read asynchronously. The rest of the heartbeat
+    // is read in the handler since the worker sends it all at once.
+
+    size_t const bytes = sizeof(uint32_t);
+    channel->buffer.resize(bytes);
+
+    boost::asio::async_read(
+        channel->socket,
+        boost::asio::buffer(
+            channel->buffer.data(),
+            bytes
+        ),
+        boost::asio::transfer_at_least(bytes),
+        boost::bind(
+            &HeartbeatMonitor::received,
+            shared_from_this(),
+            channel,
+            boost::asio::placeholders::error,
+            boost::asio::placeholders::bytes_transferred
+        )
+    );
+}
+
+void HeartbeatMonitor::received(ChannelPtr const& channel,
+                                boost::system::error_code const& ec,
+                                size_t bytes_transferred) {
+
+    util::Lock lock(_mtx, context() + "received");
+
+    if (_stopped or (ec == boost::asio::error::operation_aborted)) return;
+
+    if ((ec.value() != 0) or not readHeartbeat(lock, channel)) {
+        restart(lock, channel);
+        return;
+    }
+    wait(lock, channel, ::missedIntervals * _intervalMs);
+    receive(lock, channel);
+}
+
+bool HeartbeatMonitor::readHeartbeat(util::Lock const& lock,
+                                     ChannelPtr const& channel) {
+
+    auto& buffer = channel->buffer;
+
+    auto const read = [&channel, &buffer] (size_t bytes) -> bool {
+        buffer.resize(bytes);
+        boost::system::error_code ec;
+        boost::asio::read(
+            channel->socket,
+            boost::asio::buffer(
+                buffer.data(),
+                bytes
+            ),
+            boost::asio::transfer_at_least(bytes),
+            ec
+        );
+        return ec.value() == 0;
+    };
+    try {
+        proto::ReplicationResponseHeader hdr;
+        size_t bytes = buffer.parseLength();
+        if (not read(bytes)) return false;
+        buffer.parse(hdr, bytes);
+
+        if (not read(sizeof(uint32_t))) return false;
+        bytes = buffer.parseLength();
+
+        proto::ReplicationServiceResponse response;
+        if (not read(bytes)) return false;
+        buffer.parse(response, bytes);
+
+        Heartbeat& heartbeat = _heartbeats[channel->worker];
+        heartbeat.receiveTime                = PerformanceUtils::now();
+        heartbeat.running                    = response.service_state() ==
+                                               proto::ReplicationServiceResponse::RUNNING;
+        heartbeat.numNewRequests             = response.num_new_requests();
+        heartbeat.numInProgressRequests      = response.num_in_progress_requests();
+        heartbeat.numFinishedRequests        = response.num_finished_requests();
+        heartbeat.fsEffectiveRateBytesPerSec = response.fs_effective_rate_bytes_per_sec();
+        heartbeat.loadAverage                = response.load_average();
+
+    } catch (std::exception const& ex) {
+        LOGS(_log, LOG_LVL_ERROR, context() << "readHeartbeat  worker=" << channel->worker
+             << "  failed: " << ex.what());
+        return false;
+    }
+    return true;
+}
+
+void HeartbeatMonitor::wait(util::Lock const& lock,
+                            ChannelPtr const& channel,
+                            unsigned int timeoutMs) {
+
+    // Setting the expiration time cancels the previous wait (if any)
+
+    channel->timer.expires_from_now(boost::posix_time::milliseconds(timeoutMs));
+    channel->timer.async_wait(
+        boost::bind(
+            &HeartbeatMonitor::expired,
+            shared_from_this(),
+            channel,
+            boost::asio::placeholders::error
+        )
+    );
+}
+
+void HeartbeatMonitor::expired(ChannelPtr const& channel,
+                               boost::system::error_code const& ec) {
+
+    util::Lock lock(_mtx, context() + "expired");
+
+    if (_stopped or (ec == boost::asio::error::operation_aborted)) return;
+
+    if (channel->connected) {
+        LOGS(_log, LOG_LVL_DEBUG, context() << "expired  no heartbeats from worker="
+             << channel->worker);
+        restart(lock, channel);
+    } else {
+        resolve(lock, channel);
+    }
+}
+
+void HeartbeatMonitor::restart(util::Lock const& lock,
+                               ChannelPtr const& channel) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "restart  worker=" << channel->worker);
+
+    // The pending operations on the socket (if any) complete with
+    // boost::asio::error::operation_aborted, and their handlers do nothing.
+
+    boost::system::error_code ec;
+    channel->socket.close(ec);
+    channel->connected = false;
+
+    wait(lock, channel, 1000 * _serviceProvider->config()->retryTimeoutSec());
+}
+
+}}} // namespace lsst::qserv::replica
@@ -0,0 +1,213 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_REPLICA_HEARTBEATMONITOR_H
+#define LSST_QSERV_REPLICA_HEARTBEATMONITOR_H
+
+// System headers
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Third party headers
+#include <boost/asio.hpp>
+
+// Qserv headers
+#include "replica/ProtocolBuffer.h"
+#include "replica/ServiceProvider.h"
+#include "util/Mutex.h"
+
+// This header declarations
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+/**
+ * Class HeartbeatMonitor keeps a connection to the replication service of
+ * each worker, over which the worker pushes the status of the service
+ * (the heartbeats) at a fixed interval. This tells the liveness and the load
+ * of the workers without sending them requests.
+ *
+ * The connections are re-established after failures and when no heartbeat
+ * was received for three intervals.
+ */
+class HeartbeatMonitor
+    :   public std::enable_shared_from_this<HeartbeatMonitor> {
+
+public:
+
+    /// The pointer type for instances of the class
+    typedef std::shared_ptr<HeartbeatMonitor> Ptr;
+
+    /**
+     * Structure Heartbeat represents the last heartbeat received from a worker
+     */
+    struct Heartbeat {
+
+        /// When the heartbeat was received (milliseconds since UNIX Epoch)
+        uint64_t receiveTime = 0;
+
+        /// 'true' if the service was running (not suspended)
+        bool running = false;
+
+        // The number of requests in each queue
+
+        uint32_t numNewRequests        = 0;
+        uint32_t numInProgressRequests = 0;
+        uint32_t numFinishedRequests   = 0;
+
+        /// The bandwidth limit (bytes per second) of the file server, 0 if none
+        uint64_t fsEffectiveRateBytesPerSec = 0;
+
+        /// The 1-minute load average of the worker host
+        double loadAverage = 0;
+    };
+
+    /**
+     * The factory method for instances of the class
+     *
+     * @param serviceProvider - provider of various services
+     * @param intervalMs      - the interval (milliseconds) between heartbeats
+     *
+     * @return pointer to the new object
+     */
+    static Ptr create(ServiceProvider::Ptr const& serviceProvider,
+                      unsigned int intervalMs=1000);
+
+    // Default construction and copy semantics are prohibited
+
+    HeartbeatMonitor() = delete;
+    HeartbeatMonitor(HeartbeatMonitor const&) = delete;
+    HeartbeatMonitor& operator=(HeartbeatMonitor const&) = delete;
+
+    ~HeartbeatMonitor() = default;
+
+    /// @return the interval (milliseconds) between heartbeats
+    unsigned int intervalMs() const { return _intervalMs; }
+
+    /**
+     * Connect to the workers which aren't monitored yet
+     *
+     * @param workers - the names of the workers
+     */
+    void start(std::vector<std::string> const& workers);
+
+    /// Close all connections
+    void stop();
+
+    /// @return the last heartbeat of each worker which sent any
+    std::map<std::string, Heartbeat> heartbeats() const;
+
+    /**
+     * @param worker - the name of a worker
+     *
+     * @return 'true' if a heartbeat was received from the worker within
+     *   the last three intervals
+     */
+    bool alive(std::string const& worker) const;
+
+private:
+
+    /// The connection to one worker
+    struct Channel;
+    typedef std::shared_ptr<Channel> ChannelPtr;
+
+    /// @see HeartbeatMonitor::create()
+    HeartbeatMonitor(ServiceProvider::Ptr const& serviceProvider,
+                     unsigned int intervalMs);
+
+    // The chain of asynchronous operations of a channel. Each step
+    // is abandoned if the monitor was stopped.
+
+    void resolve(util::Lock const& lock, ChannelPtr const& channel);
+
+    void resolved(ChannelPtr const& channel,
+                  boost::system::error_code const& ec,
+                  boost::asio::ip::tcp::resolver::iterator iter);
+
+    void connected(ChannelPtr const& channel,
+                   boost::system::error_code const& ec,
+                   boost::asio::ip::tcp::resolver::iterator iter);
+
+    void subscribed(ChannelPtr const& channel,
+                    boost::system::error_code const& ec,
+                    size_t bytes_transferred);
+
+    void receive(util::Lock const& lock, ChannelPtr const& channel);
+
+    void received(ChannelPtr const& channel,
+                  boost::system::error_code const& ec,
+                  size_t bytes_transferred);
+
+    /**
+     * Read the rest of a heartbeat after its frame was received
+     *
+     * @return 'true' if the heartbeat was read and recorded
+     */
+    bool readHeartbeat(util::Lock const& lock, ChannelPtr const& channel);
+
+    /**
+     * Restart the timer of a channel
+     *
+     * @param lock      - a lock on a mutex must be acquired before calling this method
+     * @param channel   - the channel
+     * @param timeoutMs - the timeout (milliseconds)
+     */
+    void wait(util::Lock const& lock, ChannelPtr const& channel, unsigned int timeoutMs);
+
+    /**
+     * The callback on the expiration of the timer of a channel. It either ends
+     * the wait before reconnecting or, if the channel is connected, closes
+     * the channel since the worker stopped sending heartbeats.
+     */
+    void expired(ChannelPtr const& channel, boost::system::error_code const& ec);
+
+    /// Close a channel and reconnect after a delay
+    void restart(util::Lock const& lock, ChannelPtr const& channel);
+
+    /// @return the context string for debugging and diagnostic printouts
+    std::string context() const { return "HEARTBEAT-MONITOR  "; }
+
+private:
+
+    ServiceProvider::Ptr const _serviceProvider;
+
+    unsigned int const _intervalMs;
+
+    /// 'true' once stop() was called
+    bool _stopped;
+
+    /// The connections (by worker)
+    std::map<std::string, ChannelPtr> _channels;
+
+    /// The last heartbeats (by worker)
+    std::map<std::string, Heartbeat> _heartbeats;
+
+    /// Protects the members above and the state of the channels
+    mutable util::Mutex _mtx;
+};
+
+}}} // namespace lsst::qserv::replica
+
+#endif // LSST_QSERV_REPLICA_HEARTBEATMONITOR_H
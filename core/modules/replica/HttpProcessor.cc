@@ -24,6 +24,7 @@
 #include "replica/HttpProcessor.h"
 
 // System headers
+#include <algorithm>
 #include <atomic>
 #include <map>
 #include <iomanip>
@@ -35,9 +36,14 @@
 
 // Qserv headers
 #include "util/BlockPost.h"
+#include "util/StringHash.h"
 #include "replica/Controller.h"
 #include "replica/DatabaseServices.h"
 #include "replica/Performance.h"
+#include "replica/PerformanceHistory.h"
+#include "replica/ReplicaInfo.h"
+#include "replica/ServiceManagementRequest.h"
+#include "replica/ServiceThrottleRequest.h"
 
 
 using namespace std::placeholders;
@@ -98,13 +104,26 @@ void HttpProcessor::_initialize() {
         {"PUT",    "/replication/test/:id", std::bind(&HttpProcessor::_testUpdate, self, _1, _2)},
         {"DELETE", "/replication/test/:id", std::bind(&HttpProcessor::_testDelete, self, _1, _2)},
 
+        // Handlers querying the database are run by the server's handler pool
+        // (marked as blocking), so they don't hold up other requests.
+
         // Replication level summary
-        {"GET",    "/replication/v1/level", std::bind(&HttpProcessor::_getReplicationLevel, self, _1, _2)},
+        {"GET",    "/replication/v1/level", std::bind(&HttpProcessor::_getReplicationLevel, self, _1, _2), true},
 
         // Status of all workers or a particular worker
-        {"GET",    "/replication/v1/worker",       std::bind(&HttpProcessor::_listWorkerStatuses, self, _1, _2)},
+        {"GET",    "/replication/v1/worker",       std::bind(&HttpProcessor::_listWorkerStatuses, self, _1, _2), true},
         {"GET",    "/replication/v1/worker/:name", std::bind(&HttpProcessor::_getWorkerStatus,    self, _1, _2)},
 
+        // Replicas of all workers or a particular worker
+        {"GET",    "/replication/v1/replica", std::bind(&HttpProcessor::_listReplicas, self, _1, _2), true},
+
+        // Bandwidth limits of the file servers of workers
+        {"GET",    "/replication/v1/throttle", std::bind(&HttpProcessor::_getThrottle,    self, _1, _2)},
+        {"PUT",    "/replication/v1/throttle", std::bind(&HttpProcessor::_updateThrottle, self, _1, _2)},
+
+        // Latencies of the requests sent to workers
+        {"GET",    "/replication/v1/performance", std::bind(&HttpProcessor::_getPerformance, self, _1, _2)},
+
     });
     controller()->serviceProvider()->httpServer()->start();
 }
@@ -115,6 +134,51 @@ std::string HttpProcessor::context() const {
 }
 
 
+void HttpProcessor::_sendCached(qhttp::Request::Ptr const& req,
+                                qhttp::Response::Ptr const& resp,
+                                std::string const& key,
+                                uint64_t ttlMs,
+                                std::function<std::string()> const& make) {
+
+    std::shared_ptr<CachedResponse> entry;
+    {
+        util::Lock lock(_cacheMtx, "HttpProcessor::_sendCached");
+        auto& ptr = _cache[key];
+        if (ptr == nullptr) ptr = std::make_shared<CachedResponse>();
+        entry = ptr;
+    }
+
+    // Only one request at a time makes the content of an entry. The other
+    // ones waiting on the lock get the new content once it's ready.
+
+    util::Lock lock(entry->mtx, "HttpProcessor::_sendCached[" + key + "]");
+
+    uint64_t const now = PerformanceUtils::now();
+    if (entry->etag.empty() or (now - entry->timeMs >= ttlMs)) {
+        entry->content = make();
+        entry->timeMs  = now;
+
+        std::ostringstream etag;
+        etag << "\"" << std::hex
+             << util::StringHash::getCrc32c(entry->content.data(), entry->content.size())
+             << "\"";
+        entry->etag = etag.str();
+    }
+    uint64_t const maxAgeSec = (ttlMs - std::min(ttlMs, now - entry->timeMs)) / 1000;
+
+    resp->headers["ETag"] = entry->etag;
+    resp->headers["Cache-Control"] = "max-age=" + std::to_string(maxAgeSec);
+
+    auto const itr = req->header.find("If-None-Match");
+    if ((itr != req->header.end()) and (itr->second == entry->etag)) {
+        resp->status = 304;
+        resp->send("", "application/json");
+        return;
+    }
+    resp->send(entry->content, "application/json");
+}
+
+
 void HttpProcessor::_testCreate(qhttp::Request::Ptr req,
                                 qhttp::Response::Ptr resp) {
     debug("_testCreate");
@@ -154,19 +218,13 @@ void HttpProcessor::_getReplicationLevel(qhttp::Request::Ptr req,
                                          qhttp::Response::Ptr resp) {
     debug("_getReplicationLevel");
 
-    util::Lock lock(_replicationLevelMtx, "HttpProcessor::_getReplicationLevel");
-
-    // Check if a cached report can be used
-    //
     // TODO: add a cache control parameter to the class's constructor
+    _sendCached(req, resp, "level", 240 * 1000,
+                std::bind(&HttpProcessor::_makeReplicationLevelReport, this));
+}
 
-    if (not _replicationLevelReport.empty()) {
-        uint64_t lastReportAgeMs = PerformanceUtils::now() - _replicationLevelReportTimeMs;
-        if (lastReportAgeMs < 240 * 1000) {
-            resp->send(_replicationLevelReport, "application/json");
-            return;
-        }
-    }
+
+std::string HttpProcessor::_makeReplicationLevelReport() {
 
     auto const config = controller()->serviceProvider()->config();
 
@@ -328,12 +386,7 @@ void HttpProcessor::_getReplicationLevel(qhttp::Request::Ptr req,
             resultJson["families"][family]["databases"][database] = databaseJson;
         }
     }
-    
-    // Update the cache
-    _replicationLevelReport = resultJson.dump();
-    _replicationLevelReportTimeMs = PerformanceUtils::now();
-
-    resp->send(_replicationLevelReport, "application/json");
+    return resultJson.dump();
 }
 
 
@@ -341,6 +394,13 @@ void HttpProcessor::_listWorkerStatuses(qhttp::Request::Ptr req,
                                         qhttp::Response::Ptr resp) {
     debug("_listWorkerStatuses");
 
+    _sendCached(req, resp, "worker", 5 * 1000,
+                std::bind(&HttpProcessor::_makeWorkerStatuses, this));
+}
+
+
+std::string HttpProcessor::_makeWorkerStatuses() {
+
     HealthMonitorTask::WorkerResponseDelay delays =
         _healthMonitorTask->workerResponseDelay();
 
@@ -371,7 +431,7 @@ void HttpProcessor::_listWorkerStatuses(qhttp::Request::Ptr req,
         }
         resultJson.push_back(workerJson);
     }
-    resp->send(resultJson.dump(), "application/json");
+    return resultJson.dump();
 }
 
 
@@ -381,4 +441,204 @@ void HttpProcessor::_getWorkerStatus(qhttp::Request::Ptr req,
     resp->send(json::array(), "application/json");
 }
 
+
+void HttpProcessor::_listReplicas(qhttp::Request::Ptr req,
+                                  qhttp::Response::Ptr resp) {
+    debug("_listReplicas");
+
+    auto const config = controller()->serviceProvider()->config();
+
+    // The optional filters
+
+    std::vector<std::string> workers   = config->allWorkers();
+    std::vector<std::string> databases = config->databases();
+
+    auto const workerItr = req->query.find("worker");
+    if (workerItr != req->query.end()) {
+        if (not config->isKnownWorker(workerItr->second)) {
+            resp->sendStatus(404);
+            return;
+        }
+        workers = {workerItr->second};
+    }
+    auto const databaseItr = req->query.find("database");
+    if (databaseItr != req->query.end()) {
+        if (not config->isKnownDatabase(databaseItr->second)) {
+            resp->sendStatus(404);
+            return;
+        }
+        databases = {databaseItr->second};
+    }
+
+    // The JSON array is sent in chunks, one for the replicas of each database
+    // on each worker, so only those are held in memory at any time.
+
+    struct State {
+        std::vector<std::string> workers;
+        std::vector<std::string> databases;
+        size_t next;
+        bool   first;
+    };
+    auto const state = std::make_shared<State>(State{workers, databases, 0, true});
+    size_t const numSteps = workers.size() * databases.size();
+
+    auto const self = shared_from_this();
+    resp->sendChunked(
+        [self, state, numSteps] (std::string& chunk) -> bool {
+
+            if (state->next > numSteps) return false;
+            if (state->next == numSteps) {
+                chunk = state->first ? "[]" : "]";
+                state->next++;
+                return true;
+            }
+            std::string const& worker   = state->workers  [state->next / state->databases.size()];
+            std::string const& database = state->databases[state->next % state->databases.size()];
+            state->next++;
+
+            std::vector<ReplicaInfo> replicas;
+            try {
+                self->controller()->serviceProvider()->databaseServices()->findWorkerReplicas(
+                    replicas, worker, database);
+            } catch (std::exception const& ex) {
+                self->error("_listReplicas  failed to find replicas of worker: " + worker +
+                            ", database: " + database + ", error: " + ex.what());
+            }
+            chunk.clear();
+            for (auto&& replica: replicas) {
+
+                json replicaJson;
+                replicaJson["worker"]      = replica.worker();
+                replicaJson["database"]    = replica.database();
+                replicaJson["chunk"]       = replica.chunk();
+                replicaJson["status"]      = ReplicaInfo::status2string(replica.status());
+                replicaJson["verify_time"] = replica.verifyTime();
+                replicaJson["files"]       = json::array();
+                for (auto&& file: replica.fileInfo()) {
+                    json fileJson;
+                    fileJson["name"]  = file.name;
+                    fileJson["size"]  = file.size;
+                    fileJson["mtime"] = file.mtime;
+                    fileJson["cs"]    = file.cs;
+                    replicaJson["files"].push_back(fileJson);
+                }
+                chunk += state->first ? "[" : ",";
+                chunk += replicaJson.dump();
+                state->first = false;
+            }
+            return true;
+        },
+        "application/json"
+    );
+}
+
+
+void HttpProcessor::_getThrottle(qhttp::Request::Ptr req,
+                                 qhttp::Response::Ptr resp) {
+    debug("_getThrottle");
+    resp->send(_throttleWorkers(-1), "application/json");
+}
+
+
+void HttpProcessor::_updateThrottle(qhttp::Request::Ptr req,
+                                    qhttp::Response::Ptr resp) {
+    debug("_updateThrottle");
+
+    auto const config = controller()->serviceProvider()->config();
+
+    int64_t maxRateBytesPerSec = -1;
+    try {
+        json const requestJson = json::parse(req->content);
+        if (requestJson.count("cluster_rate")) {
+            size_t const numWorkers = std::max<size_t>(1, config->workers().size());
+            maxRateBytesPerSec = requestJson["cluster_rate"].get<uint64_t>() / numWorkers;
+        } else if (requestJson.count("worker_rate")) {
+            maxRateBytesPerSec = requestJson["worker_rate"].get<uint64_t>();
+        }
+    } catch (std::exception const& ex) {
+        error("_updateThrottle  failed to parse the request: " + std::string(ex.what()));
+    }
+    if (maxRateBytesPerSec < 0) {
+        resp->sendStatus(400);
+        return;
+    }
+
+    // The limit is saved in the configuration for the workers to be restarted
+    // with it, and sent to the running workers to take effect at once.
+    config->setWorkerFsMaxRateBytesPerSec(maxRateBytesPerSec);
+
+    resp->send(_throttleWorkers(maxRateBytesPerSec), "application/json");
+}
+
+
+std::string HttpProcessor::_throttleWorkers(int64_t maxRateBytesPerSec) {
+
+    std::vector<std::string> const workers =
+        controller()->serviceProvider()->config()->workers();
+
+    std::atomic<size_t> numFinished(0);
+    std::vector<ServiceManagementRequestBase::Ptr> requests;
+    for (auto&& worker: workers) {
+        if (maxRateBytesPerSec < 0) {
+            requests.push_back(
+                controller()->statusOfWorkerService(
+                    worker,
+                    [&numFinished] (ServiceStatusRequest::Ptr const& ptr) { numFinished++; }));
+        } else {
+            requests.push_back(
+                controller()->throttleWorkerService(
+                    worker,
+                    maxRateBytesPerSec,
+                    [&numFinished] (ServiceThrottleRequest::Ptr const& ptr) { numFinished++; }));
+        }
+    }
+    util::BlockPost blockPost(100, 200);
+    while (numFinished < requests.size()) blockPost.wait();
+
+    json resultJson = json::array();
+    for (auto&& request: requests) {
+
+        json workerJson;
+        workerJson["worker"] = request->worker();
+
+        bool const success = request->extendedState() == Request::ExtendedState::SUCCESS;
+        workerJson["success"] = success ? 1 : 0;
+        if (success) {
+            ServiceState const& state = request->getServiceState();
+            workerJson["max_rate"]       = state.fsMaxRateBytesPerSec;
+            workerJson["effective_rate"] = state.fsEffectiveRateBytesPerSec;
+        }
+        resultJson.push_back(workerJson);
+    }
+    return resultJson.dump();
+}
+
+
+void HttpProcessor::_getPerformance(qhttp::Request::Ptr req,
+                                    qhttp::Response::Ptr resp) {
+    debug("_getPerformance");
+
+    json resultJson;
+    resultJson["requests"] = json::array();
+    for (auto&& summary: controller()->performanceHistory()->summaries()) {
+
+        json summaryJson;
+        summaryJson["type"]          = summary.type;
+        summaryJson["worker"]        = summary.worker;
+        summaryJson["num_success"]   = summary.numSuccess;
+        summaryJson["num_failed"]    = summary.numFailed;
+        summaryJson["p50_ms"]        = summary.p50Ms;
+        summaryJson["p90_ms"]        = summary.p90Ms;
+        summaryJson["p99_ms"]        = summary.p99Ms;
+        summaryJson["worker_p90_ms"] = summary.workerP90Ms;
+        summaryJson["per_interval"]  = summary.numPerInterval;
+        summaryJson["slow"]          = summary.slow ? 1 : 0;
+
+        resultJson["requests"].push_back(summaryJson);
+    }
+    resultJson["slow_workers"] = controller()->performanceHistory()->slowWorkers();
+
+    resp->send(resultJson.dump(), "application/json");
+}
+
 }}} // namespace lsst::qserv::replica
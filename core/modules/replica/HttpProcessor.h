@@ -24,8 +24,10 @@
 
 // System headers
 #include <functional>
+#include <map>
 #include <memory>
 #include <set>
+#include <string>
 
 // Qserv headers
 #include "qhttp/Server.h"
@@ -163,6 +165,25 @@ private:
         LOGS(_log, LOG_LVL_ERROR, context() << msg);
     }
 
+    /**
+     * Send the cached content of a response, or make and cache the content
+     * if it's older than the specified time to live. The entity tag of
+     * the content is sent with the response, and the content itself isn't
+     * when a client already has it (the status of the response is 304
+     * "Not Modified" in that case).
+     *
+     * @param req    request received from a client
+     * @param resp   response to be sent back
+     * @param key    the key of the response in the cache
+     * @param ttlMs  the time to live of the cached content (milliseconds)
+     * @param make   the function making the content
+     */
+    void _sendCached(qhttp::Request::Ptr const& req,
+                     qhttp::Response::Ptr const& resp,
+                     std::string const& key,
+                     uint64_t ttlMs,
+                     std::function<std::string()> const& make);
+
     // --------------------------------------
     // Callbacks for processing test requests
     // --------------------------------------
@@ -235,6 +256,9 @@ private:
     void _getReplicationLevel(qhttp::Request::Ptr req,
                               qhttp::Response::Ptr resp);
 
+    /// @return the report on the replication levels (a JSON object)
+    std::string _makeReplicationLevelReport();
+
     /**
      * Process a request which return status of all workers.
      *
@@ -244,6 +268,66 @@ private:
     void _listWorkerStatuses(qhttp::Request::Ptr req,
                              qhttp::Response::Ptr resp);
 
+    /// @return the status of all workers (a JSON array)
+    std::string _makeWorkerStatuses();
+
+    /**
+     * Process a request which returns the replicas of all workers, or
+     * a particular worker (the optional query parameter "worker"), for all
+     * databases or a particular database (the optional query parameter
+     * "database"). The response is streamed with the chunked transfer
+     * encoding.
+     *
+     * @param req   request received from a client
+     * @param resp  response to be sent back
+     */
+    void _listReplicas(qhttp::Request::Ptr req,
+                       qhttp::Response::Ptr resp);
+
+    /**
+     * Process a request which returns the bandwidth limits of the file
+     * servers of the enabled workers.
+     *
+     * @param req   request received from a client
+     * @param resp  response to be sent back
+     */
+    void _getThrottle(qhttp::Request::Ptr req,
+                      qhttp::Response::Ptr resp);
+
+    /**
+     * Process a request which changes the bandwidth limits of the file
+     * servers of the enabled workers. The body of the request is a JSON
+     * object with either the limit of each worker ("worker_rate") or the
+     * limit for the whole cluster ("cluster_rate") which is shared evenly
+     * by the workers (bytes per second, 0 means no limit).
+     *
+     * @param req   request received from a client
+     * @param resp  response to be sent back
+     */
+    void _updateThrottle(qhttp::Request::Ptr req,
+                         qhttp::Response::Ptr resp);
+
+    /**
+     * Send the bandwidth limit (or the status request if no limit is given)
+     * to the enabled workers and wait for their replies.
+     *
+     * @param maxRateBytesPerSec  the new limit of each worker (if not negative)
+     *
+     * @return the states of the file servers of the workers (a JSON array)
+     */
+    std::string _throttleWorkers(int64_t maxRateBytesPerSec);
+
+    /**
+     * Process a request which returns the latency percentiles and the recent
+     * numbers of the requests of each type sent to each worker, along with
+     * the workers considered slow.
+     *
+     * @param req   request received from a client
+     * @param resp  response to be sent back
+     */
+    void _getPerformance(qhttp::Request::Ptr req,
+                         qhttp::Response::Ptr resp);
+
 private:
 
     /// The reference to the Replication Framework's Controller
@@ -264,14 +348,27 @@ private:
     ReplicationTask::Ptr   const& _replicationTask;
     DeleteWorkerTask::Ptr  const& _deleteWorkerTask;
 
-    /// The cache for the latest state of the replication levels report
-    std::string _replicationLevelReport;
-    
-    /// The timestamp for when the last report was made
-    uint64_t _replicationLevelReportTimeMs;
+    /// The cached content of an expensive read-only response
+    struct CachedResponse {
+
+        /// The content (a JSON document)
+        std::string content;
+
+        /// The entity tag of the content (empty if there is no content yet)
+        std::string etag;
+
+        /// When the content was made (milliseconds since UNIX Epoch)
+        uint64_t timeMs = 0;
+
+        /// Mutex guarding the entry while its content is being made
+        util::Mutex mtx;
+    };
+
+    /// The cached responses by their keys
+    std::map<std::string, std::shared_ptr<CachedResponse>> _cache;
 
-    /// Mutex guarding the cache with the replication levels report
-    util::Mutex _replicationLevelMtx;
+    /// Mutex guarding the map of the cached responses
+    util::Mutex _cacheMtx;
 
     /// Message logger
     LOG_LOGGER _log;
@@ -0,0 +1,142 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "replica/IndexApp.h"
+
+// System headers
+#include <atomic>
+#include <iostream>
+
+// Qserv headers
+#include "replica/Controller.h"
+#include "replica/IndexJob.h"
+#include "util/BlockPost.h"
+
+using namespace std;
+
+namespace {
+
+string const description =
+    "This application builds the secondary index of a director table. The workers"
+    " extract the entries of the chunks in parallel, and the sorted runs of the workers"
+    " are merged into the index file of the Czar, or loaded into the index table"
+    " of a MySQL database, in one pass.";
+
+} /// namespace
+
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+IndexApp::Ptr IndexApp::create(int argc, char* argv[]) {
+    return Ptr(
+        new IndexApp(argc, argv)
+    );
+}
+
+
+IndexApp::IndexApp(int argc, char* argv[])
+    :   Application(
+            argc, argv,
+            ::description,
+            true    /* injectDatabaseOptions */,
+            true    /* boostProtobufVersionCheck */,
+            true    /* enableServiceProvider */
+        ) {
+
+    // Configure the command line parser
+
+    parser().required(
+        "database",
+        "The name of a database",
+        _database);
+
+    parser().required(
+        "table",
+        "The name of the director table",
+        _table);
+
+    parser().option(
+        "key-column",
+        "The name of the column with the keys of the director table.",
+        _keyColumn);
+
+    parser().option(
+        "index-file",
+        "The path of the index file to be written. The entries are loaded"
+        " into table <database>__<table> of the index database if the path"
+        " is empty.",
+        _indexFile);
+
+    parser().option(
+        "index-db",
+        "The URL of the MySQL database of the index table. The table"
+        " is created if needed, and it must be empty.",
+        _indexDatabase);
+}
+
+
+int IndexApp::runImpl() {
+
+    atomic<bool> finished{false};
+    auto const job = IndexJob::create(
+        _database,
+        _table,
+        _keyColumn,
+        _indexFile.empty() ? IndexJob::INDEX_TABLE : IndexJob::INDEX_FILE,
+        _indexFile.empty() ? _indexDatabase : _indexFile,
+        Controller::create(serviceProvider()),
+        string(),
+        [&finished] (IndexJob::Ptr const& job) {
+            finished = true;
+        }
+    );
+    job->start();
+
+    util::BlockPost blockPost(1000,2000);
+    while (not finished) {
+        blockPost.wait();
+    }
+
+    // Analyze and display results
+
+    IndexJobResult const& resultData = job->getResultData();
+
+    cout << "\n"
+         << "STATE:   " << job->state2string(job->state(), job->extendedState()) << "\n"
+         << "ENTRIES: " << resultData.numRecords << "\n"
+         << "\n";
+
+    for (auto&& entry: resultData.workers) {
+        auto const itr = resultData.workerRecords.find(entry.first);
+        cout << "  " << entry.first
+             << "  chunks: "  << entry.second.size()
+             << "  entries: " << (itr == resultData.workerRecords.end() ? 0 : itr->second) << "\n";
+    }
+    cout << endl;
+
+    return job->extendedState() == Job::ExtendedState::SUCCESS ? 0 : 1;
+}
+
+}}} // namespace lsst::qserv::replica
@@ -0,0 +1,702 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "replica/IndexJob.h"
+
+// System headers
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+// Third party headers
+#include <boost/filesystem.hpp>
+
+// Qserv headers
+#include "lsst/log/Log.h"
+#include "replica/Configuration.h"
+#include "replica/DatabaseMySQL.h"
+#include "replica/FileClient.h"
+#include "replica/ServiceProvider.h"
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.replica.IndexJob");
+
+namespace replica = lsst::qserv::replica;
+
+/// The magic string of the index files
+char const indexFileMagic[] = "QSIDX001";
+
+/// The size of the header of the index files (the magic string and
+/// the number of keys)
+size_t const indexFileHeaderSize = 16;
+
+/// The size of the stream buffers of the output files
+size_t const outBufSize = 1024 * 1024;
+
+/// The number of entries loaded into the index table by each statement
+uint64_t const rowsPerLoad = 1000000;
+
+/// The number of entries merged between the checks for the job
+/// to be cancelled
+uint64_t const recordsPerCheck = 1000000;
+
+/**
+ * Class RemoteRunReader reads a run from the file server of a worker
+ */
+class RemoteRunReader
+    :   public replica::SecondaryIndexRunReader {
+
+public:
+
+    RemoteRunReader(replica::ServiceProvider::Ptr const& serviceProvider,
+                    std::string const& worker,
+                    std::string const& database,
+                    std::string const& file,
+                    size_t bufSize)
+        :   _context("worker: " + worker + ", database: " + database + ", file: " + file),
+            _file(replica::FileClient::open(serviceProvider, worker, database, file)),
+            _buf(std::max(bufSize, sizeof(replica::SecondaryIndexRecord))),
+            _begin(0),
+            _end(0) {
+
+        if (not _file) {
+            throw std::runtime_error("failed to open the run of " + _context);
+        }
+    }
+
+    bool read(replica::SecondaryIndexRecord& record) override {
+
+        // Records may straddle the reads from the file server
+
+        if (_end - _begin < sizeof(record)) {
+            std::memmove(_buf.data(), _buf.data() + _begin, _end - _begin);
+            _end -= _begin;
+            _begin = 0;
+            try {
+                while (_end < sizeof(record)) {
+                    size_t const num = _file->read(_buf.data() + _end, _buf.size() - _end);
+                    if (num == 0) break;
+                    _end += num;
+                }
+            } catch (replica::FileClientError const& ex) {
+                throw std::runtime_error("failed to read the run of " + _context + ", error: " + ex.what());
+            }
+            if (_end == 0) return false;
+            if (_end < sizeof(record)) {
+                throw std::runtime_error("truncated run of " + _context);
+            }
+        }
+        std::memcpy(&record, _buf.data() + _begin, sizeof(record));
+        _begin += sizeof(record);
+        return true;
+    }
+
+private:
+
+    std::string const _context;
+
+    replica::FileClient::Ptr const _file;
+
+    std::vector<uint8_t> _buf;
+
+    /// The unread bytes of the buffer
+    size_t _begin;
+    size_t _end;
+};
+
+/**
+ * Class IndexFileSection writes a section of the index file
+ * starting at the specified offset.
+ */
+class IndexFileSection {
+
+public:
+
+    /**
+     * @param path     - the path to the file
+     * @param truncate - create (or truncate) the file instead of updating it
+     * @param offset   - the offset of the section
+     */
+    IndexFileSection(std::string const& path,
+                     bool truncate,
+                     uint64_t offset)
+        :   _path(path),
+            _fp(std::fopen(path.c_str(), truncate ? "wb" : "r+b")),
+            _buf(::outBufSize) {
+
+        if ((_fp == nullptr) or (std::fseek(_fp, offset, SEEK_SET) != 0)) {
+            std::string const error = std::strerror(errno);
+            if (_fp != nullptr) std::fclose(_fp);
+            throw std::runtime_error("failed to open file: " + _path + ", error: " + error);
+        }
+        std::setvbuf(_fp, _buf.data(), _IOFBF, _buf.size());
+    }
+
+    IndexFileSection(IndexFileSection const&) = delete;
+    IndexFileSection& operator=(IndexFileSection const&) = delete;
+
+    ~IndexFileSection() {
+        if (_fp != nullptr) std::fclose(_fp);
+    }
+
+    void write(void const* data, size_t size) {
+        if (std::fwrite(data, size, 1, _fp) != 1) {
+            throw std::runtime_error("failed to write file: " + _path + ", error: " + std::strerror(errno));
+        }
+    }
+
+    void close() {
+        int const result = std::fclose(_fp);
+        _fp = nullptr;
+        if (result != 0) {
+            throw std::runtime_error("failed to close file: " + _path + ", error: " + std::strerror(errno));
+        }
+    }
+
+private:
+
+    std::string const _path;
+
+    std::FILE* _fp;
+
+    std::vector<char> _buf;
+};
+
+} /// namespace
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+std::string IndexJob::destination2string(Destination destination) {
+    switch (destination) {
+        case INDEX_FILE:  return "INDEX_FILE";
+        case INDEX_TABLE: return "INDEX_TABLE";
+    }
+    throw std::logic_error(
+            "IndexJob::destination2string  unhandled destination: " + std::to_string(destination));
+}
+
+Job::Options const& IndexJob::defaultOptions() {
+    static Job::Options const options{
+        0,      /* priority */
+        false,  /* exclusive */
+        true    /* preemptable */
+    };
+    return options;
+}
+
+
+std::string IndexJob::typeName() { return "IndexJob"; }
+
+
+IndexJob::Ptr IndexJob::create(std::string const& database,
+                               std::string const& table,
+                               std::string const& keyColumn,
+                               Destination destination,
+                               std::string const& destinationPath,
+                               Controller::Ptr const& controller,
+                               std::string const& parentJobId,
+                               CallbackType const& onFinish,
+                               Job::Options const& options) {
+    return IndexJob::Ptr(
+        new IndexJob(database,
+                     table,
+                     keyColumn,
+                     destination,
+                     destinationPath,
+                     controller,
+                     parentJobId,
+                     onFinish,
+                     options));
+}
+
+IndexJob::IndexJob(std::string const& database,
+                   std::string const& table,
+                   std::string const& keyColumn,
+                   Destination destination,
+                   std::string const& destinationPath,
+                   Controller::Ptr const& controller,
+                   std::string const& parentJobId,
+                   CallbackType const& onFinish,
+                   Job::Options const& options)
+    :   Job(controller,
+            parentJobId,
+            "INDEX",
+            options),
+        _database(database),
+        _table(table),
+        _keyColumn(keyColumn),
+        _destination(destination),
+        _destinationPath(destinationPath),
+        _onFinish(onFinish),
+        _numLaunched(0),
+        _numFinished(0),
+        _numSuccess(0) {
+
+    controller->serviceProvider()->assertDatabaseIsValid(database);
+}
+
+IndexJobResult const& IndexJob::getResultData() const {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "getResultData");
+
+    if (state() == State::FINISHED) return _resultData;
+
+    throw std::logic_error(
+        "IndexJob::getResultData  the method can't be called while the job hasn't finished");
+}
+
+std::list<std::pair<std::string,std::string>> IndexJob::extendedPersistentState() const {
+    std::list<std::pair<std::string,std::string>> result;
+    result.emplace_back("database",         database());
+    result.emplace_back("table",            table());
+    result.emplace_back("key_column",       keyColumn());
+    result.emplace_back("destination",      destination2string(destination()));
+    result.emplace_back("destination_path", destinationPath());
+    return result;
+}
+
+void IndexJob::startImpl(util::Lock const& lock) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "startImpl");
+
+    // Launch the chained job to get chunk disposition
+
+    auto self = shared_from_base<IndexJob>();
+
+    bool const saveReplicInfo = false;          // the replicas are only needed for planning
+    bool const allWorkers = false;              // only consider enabled workers
+    bool const fromDirectory = true;            // plan from the replicas known to the Controller
+                                                // if they're recent enough
+    _findAllJob = FindAllJob::create(
+        controller()->serviceProvider()->config()->databaseInfo(database()).family,
+        saveReplicInfo,
+        allWorkers,
+        fromDirectory,
+        controller(),
+        id(),
+        [self] (FindAllJob::Ptr job) {
+            self->onPrecursorJobFinish();
+        }
+    );
+    _findAllJob->start();
+
+    setState(lock, State::IN_PROGRESS);
+}
+
+void IndexJob::cancelImpl(util::Lock const& lock) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "cancelImpl");
+
+    if ((nullptr != _findAllJob) and (_findAllJob->state() != State::FINISHED)) {
+        _findAllJob->cancel();
+    }
+    _findAllJob = nullptr;
+
+    // The requests which haven't been launched yet won't be
+
+    controller()->fanOut()->cancel(id());
+
+    for (auto&& ptr: _requests) ptr->cancel();
+    _requests.clear();
+
+    _numLaunched = 0;
+    _numFinished = 0;
+    _numSuccess  = 0;
+}
+
+void IndexJob::notify(util::Lock const& lock) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "notify");
+
+    notifyDefaultImpl<IndexJob>(lock, _onFinish);
+}
+
+void IndexJob::onPrecursorJobFinish() {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "onPrecursorJobFinish");
+
+    // IMPORTANT: the final state is required to be tested twice. The first time
+    // it's done in order to avoid deadlock on the "in-flight" requests reporting
+    // their completion while the job termination is in a progress. And the second
+    // test is made after acquiring the lock to recheck the state in case if it
+    // has transitioned while acquiring the lock.
+
+    if (state() == State::FINISHED) return;
+
+    util::Lock lock(_mtx, context() + "onPrecursorJobFinish");
+
+    if (state() == State::FINISHED) return;
+
+    if (_findAllJob->extendedState() != ExtendedState::SUCCESS) {
+        finish(lock, ExtendedState::FAILED);
+        return;
+    }
+
+    // Each chunk is harvested by one of the workers having a complete replica
+    // of the chunk. The one with the fewest chunks assigned so far is taken
+    // to spread the work evenly across the workers.
+    //
+    // NOTE: the 'overflow' chunk has no rows.
+
+    FindAllJobResult const& replicaData = _findAllJob->getReplicaData();
+
+    std::map<std::string, std::vector<unsigned int>>& worker2chunks = _resultData.workers;
+
+    for (auto&& chunkEntry: replicaData.databases) {
+        unsigned int const chunk = chunkEntry.first;
+        auto const& databases = chunkEntry.second;
+
+        if (chunk == overflowChunkNumber) continue;
+        if (databases.end() == std::find(databases.begin(), databases.end(), database())) continue;
+
+        std::string worker;
+        auto const chunkItr = replicaData.complete.find(chunk);
+        if (chunkItr != replicaData.complete.end()) {
+            auto const databaseItr = chunkItr->second.find(database());
+            if (databaseItr != chunkItr->second.end()) {
+                size_t minNumChunks = 0;
+                for (auto&& candidate: databaseItr->second) {
+                    auto const itr = worker2chunks.find(candidate);
+                    size_t const numChunks = itr == worker2chunks.end() ? 0 : itr->second.size();
+                    if (worker.empty() or numChunks < minNumChunks) {
+                        worker = candidate;
+                        minNumChunks = numChunks;
+                    }
+                }
+            }
+        }
+        if (worker.empty()) {
+            LOGS(_log, LOG_LVL_ERROR, context() << "onPrecursorJobFinish"
+                 << "  no complete replica of chunk: " << chunk
+                 << " database: " << database());
+            finish(lock, ExtendedState::FAILED);
+            return;
+        }
+        worker2chunks[worker].push_back(chunk);
+    }
+
+    // The requests are launched by the fan-out engine of the Controller
+    // as the limits on the number of requests in flight allow.
+
+    auto const self = shared_from_base<IndexJob>();
+    auto const fanOut = controller()->fanOut();
+
+    for (auto&& entry: worker2chunks) {
+        std::string const worker = entry.first;
+        std::vector<unsigned int> const chunks = entry.second;
+        fanOut->submit(
+            id(),
+            worker,
+            options(lock).priority,
+            [self, worker, chunks] (RequestFanOut::DoneType const& done) {
+                self->launchRequest(worker, chunks, done);
+            }
+        );
+        _numLaunched++;
+    }
+
+    // An empty index is written if the table has no chunks
+
+    if (not _numLaunched) std::thread(&IndexJob::merge, self).detach();
+}
+
+void IndexJob::launchRequest(std::string const& worker,
+                             std::vector<unsigned int> const& chunks,
+                             RequestFanOut::DoneType const& done) {
+
+    // The job may have finished while the request was waiting for its turn
+
+    if (state() == State::FINISHED) {
+        done();
+        return;
+    }
+
+    util::Lock lock(_mtx, context() + "launchRequest");
+
+    if (state() == State::FINISHED) {
+        done();
+        return;
+    }
+
+    auto const self = shared_from_base<IndexJob>();
+
+    _requests.push_back(
+        controller()->index(
+            worker,
+            database(),
+            table(),
+            keyColumn(),
+            chunks,
+            [self, done] (IndexRequest::Ptr request) {
+                done();
+                self->onRequestFinish(request);
+            },
+            options(lock).priority,
+            true,   /* keepTracking*/
+            id()    /* jobId */
+        )
+    );
+}
+
+void IndexJob::onRequestFinish(IndexRequest::Ptr const& request) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context()
+         << "onRequestFinish  worker=" << request->worker()
+         << " state=" << request->state2string());
+
+    // IMPORTANT: the final state is required to be tested twice. The first time
+    // it's done in order to avoid deadlock on the "in-flight" requests reporting
+    // their completion while the job termination is in a progress. And the second
+    // test is made after acquiring the lock to recheck the state in case if it
+    // has transitioned while acquiring the lock.
+
+    if (state() == State::FINISHED) return;
+
+    util::Lock lock(_mtx, context() + "onRequestFinish[" + request->id() + "]");
+
+    if (state() == State::FINISHED) return;
+
+    _numFinished++;
+    if (request->extendedState() == Request::ExtendedState::SUCCESS) {
+        _numSuccess++;
+        IndexRequest::IndexInfo const info = request->indexInfo();
+        _runs[request->worker()] = info;
+        _resultData.workerRecords[request->worker()] = info.numRecords;
+    }
+
+    LOGS(_log, LOG_LVL_DEBUG, context()
+         << "onRequestFinish  worker=" << request->worker()
+         << " _numLaunched=" << _numLaunched
+         << " _numFinished=" << _numFinished
+         << " _numSuccess=" << _numSuccess);
+
+    if (_numFinished == _numLaunched) {
+        if (_numSuccess != _numLaunched) {
+            finish(lock, ExtendedState::FAILED);
+            return;
+        }
+
+        // The merge takes as long as it takes to pull the runs from
+        // the workers. It's not done in the threads of the Controller.
+
+        std::thread(&IndexJob::merge, shared_from_base<IndexJob>()).detach();
+    }
+}
+
+void IndexJob::merge() {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "merge  runs: " << _runs.size());
+
+    uint64_t numRecords = 0;
+    std::string error;
+    try {
+        auto const serviceProvider = controller()->serviceProvider();
+        size_t const bufSize = serviceProvider->config()->workerFsBufferSizeBytes();
+
+        std::vector<SecondaryIndexRunReader::Ptr> runs;
+        uint64_t numReported = 0;
+        for (auto&& entry: _runs) {
+            runs.push_back(
+                std::make_shared<RemoteRunReader>(serviceProvider,
+                                                  entry.first,
+                                                  database(),
+                                                  entry.second.file,
+                                                  bufSize));
+            numReported += entry.second.numRecords;
+        }
+        SecondaryIndexRunMerger merger(runs);
+
+        numRecords = destination() == INDEX_FILE ? writeFile(merger, numReported) : loadTable(merger);
+
+    } catch (std::exception const& ex) {
+        error = ex.what();
+    }
+
+    if (state() == State::FINISHED) return;
+
+    util::Lock lock(_mtx, context() + "merge");
+
+    if (state() == State::FINISHED) return;
+
+    if (not error.empty()) {
+        LOGS(_log, LOG_LVL_ERROR, context() << "merge  " << error);
+        finish(lock, ExtendedState::FAILED);
+        return;
+    }
+    _resultData.numRecords = numRecords;
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "merge  records: " << numRecords);
+
+    finish(lock, ExtendedState::SUCCESS);
+}
+
+uint64_t IndexJob::writeFile(SecondaryIndexRunReader& runs, uint64_t numRecords) {
+
+    // The keys, the chunks and the subchunks are written in one pass
+    // through three streams into the file, each one positioned at its
+    // own section. The file is renamed once complete.
+
+    std::string const tmpPath = destinationPath() + ".tmp";
+
+    uint64_t const chunksOffset    = ::indexFileHeaderSize + numRecords * sizeof(int64_t);
+    uint64_t const subChunksOffset = chunksOffset + numRecords * sizeof(int32_t);
+
+    ::IndexFileSection keys(tmpPath, true, 0);
+    ::IndexFileSection chunks(tmpPath, false, chunksOffset);
+    ::IndexFileSection subChunks(tmpPath, false, subChunksOffset);
+
+    keys.write(::indexFileMagic, std::strlen(::indexFileMagic));
+    keys.write(&numRecords, sizeof(numRecords));
+
+    uint64_t num = 0;
+    SecondaryIndexRecord record;
+    SecondaryIndexRecord prev;
+    std::string const wrongNumRecords =
+        "the runs don't have the number of entries reported by the workers: " +
+        std::to_string(numRecords);
+
+    while (runs.read(record)) {
+        if (num != 0 and record.key == prev.key) {
+            throw std::runtime_error("duplicate key: " + std::to_string(record.key));
+        }
+        if (num == numRecords) throw std::runtime_error(wrongNumRecords);
+        if (num % ::recordsPerCheck == 0 and state() == State::FINISHED) {
+            throw std::runtime_error("the job was cancelled");
+        }
+        keys.write(&record.key, sizeof(record.key));
+        chunks.write(&record.chunk, sizeof(record.chunk));
+        subChunks.write(&record.subChunk, sizeof(record.subChunk));
+        prev = record;
+        ++num;
+    }
+    if (num != numRecords) throw std::runtime_error(wrongNumRecords);
+
+    keys.close();
+    chunks.close();
+    subChunks.close();
+
+    fs::rename(fs::path(tmpPath), fs::path(destinationPath()));
+
+    return num;
+}
+
+uint64_t IndexJob::loadTable(SecondaryIndexRunReader& runs) {
+
+    auto const conn = database::mysql::Connection::open(
+        database::mysql::ConnectionParams::parse(
+            destinationPath(),
+            "localhost",
+            3306,
+            "qsmaster",
+            ""));
+
+    // The table is expected to be empty, and the keys are known to be
+    // unique by the time they're loaded. Loading them in the order of
+    // the primary key only appends to the InnoDB tree.
+
+    std::string const indexTable = conn->sqlId(database() + "__" + table());
+
+    conn->execute("CREATE TABLE IF NOT EXISTS " + indexTable + " (" +
+                  conn->sqlId(keyColumn()) + " BIGINT NOT NULL PRIMARY KEY," +
+                  " `chunkId` INT, `subChunkId` INT) ENGINE = INNODB");
+
+    conn->execute("SELECT 1 FROM " + indexTable + " LIMIT 1");
+    database::mysql::Row row;
+    if (conn->next(row)) {
+        throw std::runtime_error("the index table isn't empty: " + indexTable);
+    }
+    conn->execute("SET SESSION unique_checks = 0");
+
+    fs::path const tmpPath =
+        fs::temp_directory_path() / fs::unique_path("qserv-replica-index-%%%%-%%%%-%%%%.tsv");
+
+    auto const removeTmpFile = [&tmpPath]() {
+        boost::system::error_code ec;
+        fs::remove(tmpPath, ec);
+    };
+
+    uint64_t num = 0;
+    try {
+        SecondaryIndexRecord record;
+        SecondaryIndexRecord prev;
+        bool more = runs.read(record);
+        while (more) {
+
+            // Each batch of the entries is written into the same temporary
+            // file, and loaded from it.
+
+            std::FILE* fp = std::fopen(tmpPath.string().c_str(), "w");
+            if (fp == nullptr) {
+                throw std::runtime_error("failed to create file: " + tmpPath.string() +
+                                         ", error: " + std::strerror(errno));
+            }
+            std::vector<char> buf(::outBufSize);
+            std::setvbuf(fp, buf.data(), _IOFBF, buf.size());
+
+            uint64_t numRows = 0;
+            bool failed = false;
+            for (; more and numRows < ::rowsPerLoad; more = runs.read(record)) {
+                if (num != 0 and record.key == prev.key) {
+                    std::fclose(fp);
+                    throw std::runtime_error("duplicate key: " + std::to_string(record.key));
+                }
+                if (std::fprintf(fp, "%lld\t%d\t%d\n",
+                                 static_cast<long long>(record.key),
+                                 static_cast<int>(record.chunk),
+                                 static_cast<int>(record.subChunk)) < 0) {
+                    failed = true;
+                    break;
+                }
+                prev = record;
+                ++num;
+                ++numRows;
+            }
+            if ((std::fclose(fp) != 0) or failed) {
+                throw std::runtime_error("failed to write file: " + tmpPath.string() +
+                                         ", error: " + std::strerror(errno));
+            }
+            if (state() == State::FINISHED) {
+                throw std::runtime_error("the job was cancelled");
+            }
+            conn->execute("LOAD DATA LOCAL INFILE " + conn->sqlValue(tmpPath.string()) +
+                          " INTO TABLE " + indexTable);
+        }
+
+    } catch (...) {
+        removeTmpFile();
+        throw;
+    }
+    removeTmpFile();
+
+    return num;
+}
+
+}}} // namespace lsst::qserv::replica
@@ -0,0 +1,299 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_REPLICA_INDEXJOB_H
+#define LSST_QSERV_REPLICA_INDEXJOB_H
+
+// System headers
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "replica/FindAllJob.h"
+#include "replica/IndexRequest.h"
+#include "replica/Job.h"
+#include "replica/RequestFanOut.h"
+#include "replica/SecondaryIndexRun.h"
+
+// This header declarations
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+/**
+ * The structure IndexJobResult represents a combined result received
+ * from worker services upon a completion of the job.
+ */
+struct IndexJobResult {
+
+    /// The chunks harvested by each worker
+    std::map<std::string, std::vector<unsigned int>> workers;
+
+    /// The number of entries reported by each worker
+    std::map<std::string, uint64_t> workerRecords;
+
+    /// The number of entries written into the index
+    uint64_t numRecords = 0;
+};
+
+/**
+  * Class IndexJob represents a tool which builds the secondary index of
+  * a director table. Each chunk of the table is assigned to one of the workers
+  * having a complete replica of the chunk, and the workers write the entries
+  * of their chunks, sorted by the key, into a run file each (in parallel).
+  * The runs are pulled from the file servers of the workers and merged in one
+  * sorted pass, which either writes the mmap-able index file read by the Czar
+  * (see qproc::SecondaryIndex), or loads the entries in the order of the primary
+  * key of the index table in the specified MySQL database.
+  */
+class IndexJob
+    :   public Job  {
+
+public:
+
+    /// The pointer type for instances of the class
+    typedef std::shared_ptr<IndexJob> Ptr;
+
+    /// The function type for notifications on the completion of the request
+    typedef std::function<void(Ptr)> CallbackType;
+
+    /// The destinations of the index
+    enum Destination {
+        INDEX_FILE,     // the index file of the Czar
+        INDEX_TABLE     // the index table of the MySQL database
+    };
+
+    /// @return the string representation of the destination
+    static std::string destination2string(Destination destination);
+
+    /// @return default options object for this type of a request
+    static Job::Options const& defaultOptions();
+
+    /// @return the unique name distinguishing this class from other types of jobs
+    static std::string typeName();
+
+    /**
+     * Static factory method is needed to prevent issue with the lifespan
+     * and memory management of instances created otherwise (as values or via
+     * low-level pointers).
+     *
+     * @param database        - the name of a database
+     * @param table           - the base name of the director table
+     * @param keyColumn       - the name of the column with the keys of the table
+     * @param destination     - where the index is written
+     * @param destinationPath - the path of the index file (INDEX_FILE), or the URL of
+     *                          the MySQL database of the index table (INDEX_TABLE).
+     *                          The name of the table is <database>__<table>.
+     * @param controller      - for launching requests
+     * @param parentJobId     - optional identifier of a parent job
+     * @param onFinish        - callback function to be called upon a completion of the job
+     * @param options         - job options
+     *
+     * @return pointer to the created object
+     */
+    static Ptr create(std::string const& database,
+                      std::string const& table,
+                      std::string const& keyColumn,
+                      Destination destination,
+                      std::string const& destinationPath,
+                      Controller::Ptr const& controller,
+                      std::string const& parentJobId=std::string(),
+                      CallbackType const& onFinish=nullptr,
+                      Job::Options const& options=defaultOptions());
+
+    // Default construction and copy semantics are prohibited
+
+    IndexJob() = delete;
+    IndexJob(IndexJob const&) = delete;
+    IndexJob& operator=(IndexJob const&) = delete;
+
+    ~IndexJob() final = default;
+
+    // Trivial get methods
+
+    std::string const& database()        const { return _database; }
+    std::string const& table()           const { return _table; }
+    std::string const& keyColumn()       const { return _keyColumn; }
+    Destination        destination()     const { return _destination; }
+    std::string const& destinationPath() const { return _destinationPath; }
+
+    /**
+     * Return the result of the operation.
+     *
+     * IMPORTANT NOTES:
+     * - the method should be invoked only after the job has finished (primary
+     *   status is set to Job::Status::FINISHED). Otherwise exception
+     *   std::logic_error will be thrown
+     *
+     * - the index is complete only if the job has finished with the extended
+     *   status Job::ExtendedState::SUCCESS.
+     *
+     * @return the data structure to be filled upon the completion of the job.
+     *
+     * @throws std::logic_error - if the job isn't finished at the time
+     *                            when the method was called
+     */
+    IndexJobResult const& getResultData() const;
+
+    /**
+     * @see Job::extendedPersistentState()
+     */
+    std::list<std::pair<std::string,std::string>> extendedPersistentState() const override;
+
+protected:
+
+    /**
+     * Construct the job with the pointer to the services provider.
+     *
+     * @see IndexJob::create()
+     */
+    IndexJob(std::string const& database,
+             std::string const& table,
+             std::string const& keyColumn,
+             Destination destination,
+             std::string const& destinationPath,
+             Controller::Ptr const& controller,
+             std::string const& parentJobId,
+             CallbackType const& onFinish,
+             Job::Options const& options);
+
+    /**
+      * @see Job::startImpl()
+      */
+    void startImpl(util::Lock const& lock) final;
+
+    /**
+      * @see Job::startImpl()
+      */
+    void cancelImpl(util::Lock const& lock) final;
+
+    /**
+      * @see Job::notify()
+      */
+    void notify(util::Lock const& lock) final;
+
+    /**
+     * The callback function to be invoked on a completion of the precursor job
+     * which harvests info on replicas across the cluster.
+     */
+    void onPrecursorJobFinish();
+
+    /**
+     * Launch a request when the fan-out engine of the Controller allows.
+     *
+     * @param worker - the name of a worker
+     * @param chunks - the chunks to be harvested by the worker
+     * @param done   - the function to be called when the request finishes
+     */
+    void launchRequest(std::string const& worker,
+                       std::vector<unsigned int> const& chunks,
+                       RequestFanOut::DoneType const& done);
+
+    /**
+     * The callback function to be invoked on a completion of each request.
+     *
+     * @param request - a pointer to a request
+     */
+    void onRequestFinish(IndexRequest::Ptr const& request);
+
+    /**
+     * Merge the runs of the workers into the destination, and finish the job.
+     * This runs in a thread of its own started when all requests have succeeded.
+     */
+    void merge();
+
+    /**
+     * Write the index file
+     *
+     * @param runs       - the merged runs
+     * @param numRecords - the total number of entries in the runs
+     *
+     * @return the number of entries written
+     *
+     * @throws std::runtime_error - if the file couldn't be written, or if
+     *                              the runs had duplicate keys
+     */
+    uint64_t writeFile(SecondaryIndexRunReader& runs, uint64_t numRecords);
+
+    /**
+     * Load the entries into the index table
+     *
+     * @param runs - the merged runs
+     *
+     * @return the number of entries loaded
+     *
+     * @throws std::runtime_error - if the entries couldn't be loaded, or if
+     *                              the runs had duplicate keys
+     */
+    uint64_t loadTable(SecondaryIndexRunReader& runs);
+
+protected:
+
+    /// The name of a database
+    std::string const _database;
+
+    /// The base name of the director table
+    std::string const _table;
+
+    /// The name of the column with the keys of the table
+    std::string const _keyColumn;
+
+    /// Where the index is written
+    Destination const _destination;
+
+    /// The path of the index file, or the URL of the MySQL database
+    std::string const _destinationPath;
+
+    /// Client-defined function to be called upon the completion of the job
+    CallbackType _onFinish;
+
+    /// The chained job to be completed first in order to figure out
+    /// replica disposition.
+    FindAllJob::Ptr _findAllJob;
+
+    /// A collection of the requests launched so far
+    std::list<IndexRequest::Ptr> _requests;
+
+    /// The runs reported by the workers. The collection isn't modified
+    /// after the merge has started.
+    std::map<std::string, IndexRequest::IndexInfo> _runs;
+
+    // The counter of requests which will be updated. They need to be atomic
+    // to avoid race condition between the onFinish() callbacks executed within
+    // the Controller's thread and this thread.
+
+    std::atomic<size_t> _numLaunched;   ///< the total number of requests launched
+    std::atomic<size_t> _numFinished;   ///< the total number of finished requests
+    std::atomic<size_t> _numSuccess;    ///< the number of successfully completed requests
+
+    /// The result of the operation (gets updated as requests are finishing)
+    IndexJobResult _resultData;
+};
+
+}}} // namespace lsst::qserv::replica
+
+#endif // LSST_QSERV_REPLICA_INDEXJOB_H
@@ -0,0 +1,347 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "replica/IndexRequest.h"
+
+// System headers
+#include <stdexcept>
+
+// Third party headers
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+// Qserv headers
+#include "lsst/log/Log.h"
+#include "replica/Controller.h"
+#include "replica/DatabaseServices.h"
+#include "replica/Messenger.h"
+#include "replica/ProtocolBuffer.h"
+#include "replica/ServiceProvider.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.replica.IndexRequest");
+
+} /// namespace
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+IndexRequest::Ptr IndexRequest::create(ServiceProvider::Ptr const& serviceProvider,
+                                       boost::asio::io_service& io_service,
+                                       std::string const& worker,
+                                       std::string const& database,
+                                       std::string const& table,
+                                       std::string const& keyColumn,
+                                       std::vector<unsigned int> const& chunks,
+                                       CallbackType const& onFinish,
+                                       int priority,
+                                       bool keepTracking,
+                                       std::shared_ptr<Messenger> const& messenger) {
+    return IndexRequest::Ptr(
+        new IndexRequest(serviceProvider,
+                         io_service,
+                         worker,
+                         database,
+                         table,
+                         keyColumn,
+                         chunks,
+                         onFinish,
+                         priority,
+                         keepTracking,
+                         messenger));
+}
+
+IndexRequest::IndexRequest(ServiceProvider::Ptr const& serviceProvider,
+                           boost::asio::io_service& io_service,
+                           std::string const& worker,
+                           std::string const& database,
+                           std::string const& table,
+                           std::string const& keyColumn,
+                           std::vector<unsigned int> const& chunks,
+                           CallbackType const& onFinish,
+                           int  priority,
+                           bool keepTracking,
+                           std::shared_ptr<Messenger> const& messenger)
+    :   RequestMessenger(serviceProvider,
+                         io_service,
+                         "REPLICA_INDEX",
+                         worker,
+                         priority,
+                         keepTracking,
+                         false /* allowDuplicate */,
+                         messenger),
+        _database(database),
+        _table(table),
+        _keyColumn(keyColumn),
+        _chunks(chunks),
+        _onFinish(onFinish) {
+
+    serviceProvider->assertDatabaseIsValid(database);
+}
+
+IndexRequest::IndexInfo IndexRequest::indexInfo() const {
+    util::Lock lock(_mtx, context() + "indexInfo");
+    return _indexInfo;
+}
+
+void IndexRequest::startImpl(util::Lock const& lock) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "startImpl "
+         << " worker: "   << worker()
+         << " database: " << database()
+         << " table: "    << table()
+         << " chunks: "   << chunks().size());
+
+    // Serialize the Request message header and the request itself into
+    // the network buffer.
+
+    buffer()->resize();
+
+    proto::ReplicationRequestHeader hdr;
+    hdr.set_id(id());
+    hdr.set_type(proto::ReplicationRequestHeader::REPLICA);
+    hdr.set_replica_type(proto::ReplicationReplicaRequestType::REPLICA_INDEX);
+
+    buffer()->serialize(hdr);
+
+    proto::ReplicationRequestIndex message;
+    message.set_priority(  priority());
+    message.set_database(  database());
+    message.set_table(     table());
+    message.set_key_column(keyColumn());
+
+    for (auto chunk: chunks()) message.add_chunks(chunk);
+
+    buffer()->serialize(message);
+
+    send(lock);
+}
+
+void IndexRequest::wait(util::Lock const& lock) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "wait");
+
+    // Allways need to set the interval before launching the timer.
+
+    timer().expires_from_now(boost::posix_time::seconds(timerIvalSec()));
+    timer().async_wait(
+        boost::bind(
+            &IndexRequest::awaken,
+            shared_from_base<IndexRequest>(),
+            boost::asio::placeholders::error
+        )
+    );
+}
+
+void IndexRequest::awaken(boost::system::error_code const& ec) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "awaken");
+
+    if (isAborted(ec)) return;
+
+    // IMPORTANT: the final state is required to be tested twice. The first time
+    // it's done in order to avoid deadlock on the "in-flight" callbacks reporting
+    // their completion while the request termination is in a progress. And the second
+    // test is made after acquiring the lock to recheck the state in case if it
+    // has transitioned while acquiring the lock.
+
+    if (state() == State::FINISHED) return;
+
+    util::Lock lock(_mtx, context() + "awaken");
+
+    if (state() == State::FINISHED) return;
+
+    // Serialize the Status message header and the request itself into
+    // the network buffer.
+
+    buffer()->resize();
+
+    proto::ReplicationRequestHeader hdr;
+    hdr.set_id(id());
+    hdr.set_type(proto::ReplicationRequestHeader::REQUEST);
+    hdr.set_management_type(proto::ReplicationManagementRequestType::REQUEST_STATUS);
+
+    buffer()->serialize(hdr);
+
+    proto::ReplicationRequestStatus message;
+    message.set_id(id());
+    message.set_replica_type(proto::ReplicationReplicaRequestType::REPLICA_INDEX);
+
+    buffer()->serialize(message);
+
+    send(lock);
+}
+
+void IndexRequest::send(util::Lock const& lock) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "send");
+
+    auto self = shared_from_base<IndexRequest>();
+
+    messenger()->send<proto::ReplicationResponseIndex>(
+        worker(),
+        id(),
+        buffer(),
+        [self] (std::string const& id,
+                bool success,
+                proto::ReplicationResponseIndex const& response) {
+
+            self->analyze(success,
+                          response);
+        }
+    );
+}
+
+void IndexRequest::analyze(bool success,
+                            proto::ReplicationResponseIndex const& message) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "analyze  success=" << (success ? "true" : "false"));
+
+    // This method is called on behalf of an asynchronous callback fired
+    // upon a completion of the request within method send() - the only
+    // client of analyze(). So, we should take care of proper locking and watch
+    // for possible state transition which might occur while the async I/O was
+    // still in a progress.
+
+    // IMPORTANT: the final state is required to be tested twice. The first time
+    // it's done in order to avoid deadlock on the "in-flight" callbacks reporting
+    // their completion while the request termination is in a progress. And the second
+    // test is made after acquiring the lock to recheck the state in case if it
+    // has transitioned while acquiring the lock.
+
+    if (state() == State::FINISHED) return;
+
+    util::Lock lock(_mtx, context() + "analyze");
+
+    if (state() == State::FINISHED) return;
+
+    if (not success) {
+        finish(lock, CLIENT_ERROR);
+        return;
+    }
+
+    // Always use  the latest status reported by the remote server
+
+    setExtendedServerStatus(lock, replica::translate(message.status_ext()));
+
+    // Performance counters are updated from either of two sources,
+    // depending on the availability of the 'target' performance counters
+    // filled in by the 'STATUS' queries. If the later is not available
+    // then fallback to the one of the current request.
+
+    if (message.has_target_performance()) {
+        mutablePerformance().update(message.target_performance());
+    } else {
+        mutablePerformance().update(message.performance());
+    }
+
+    // Always extract the progress regardless of the completion status
+    // reported by the worker service.
+
+    if (message.has_index_info()) {
+        auto&& info = message.index_info();
+        _indexInfo.numChunks  = info.num_chunks();
+        _indexInfo.chunksRead = info.chunks_read();
+        _indexInfo.numRecords = info.num_records();
+        _indexInfo.file       = info.file();
+
+        LOGS(_log, LOG_LVL_DEBUG, context() << "analyze"
+             << "  chunks read: " << _indexInfo.chunksRead << "/" << _indexInfo.numChunks
+             << "  records: "     << _indexInfo.numRecords);
+    }
+
+    // Extract target request type-specific parameters from the response
+    if (message.has_request()) {
+        _targetRequestParams = IndexRequestParams(message.request());
+    }
+    switch (message.status()) {
+
+        case proto::ReplicationStatus::SUCCESS:
+
+            finish(lock, SUCCESS);
+            break;
+
+        case proto::ReplicationStatus::QUEUED:
+            if (keepTracking()) wait(lock);
+            else                finish(lock, SERVER_QUEUED);
+            break;
+
+        case proto::ReplicationStatus::IN_PROGRESS:
+            if (keepTracking()) wait(lock);
+            else                finish(lock, SERVER_IN_PROGRESS);
+            break;
+
+        case proto::ReplicationStatus::IS_CANCELLING:
+            if (keepTracking()) wait(lock);
+            else                finish(lock, SERVER_IS_CANCELLING);
+            break;
+
+        case proto::ReplicationStatus::BAD:
+
+            // The run file of the table is being written by another request
+
+            if (extendedServerStatus() == ExtendedCompletionStatus::EXT_STATUS_DUPLICATE) {
+                setDuplicateRequestId(lock, message.duplicate_request_id());
+            }
+            finish(lock, SERVER_BAD);
+            break;
+
+        case proto::ReplicationStatus::FAILED:
+            finish(lock, SERVER_ERROR);
+            break;
+
+        case proto::ReplicationStatus::CANCELLED:
+            finish(lock, SERVER_CANCELLED);
+            break;
+
+        default:
+            throw std::logic_error(
+                    "IndexRequest::analyze() unknown status '" +
+                    proto::ReplicationStatus_Name(message.status()) + "' received from server");
+    }
+}
+
+void IndexRequest::notify(util::Lock const& lock) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "notify");
+
+    notifyDefaultImpl<IndexRequest>(lock, _onFinish);
+}
+
+void IndexRequest::savePersistentState(util::Lock const& lock) {
+    LOGS(_log, LOG_LVL_DEBUG, context() << "savePersistentState");
+    controller()->serviceProvider()->databaseServices()->saveState(*this, performance(lock));
+}
+
+std::list<std::pair<std::string,std::string>> IndexRequest::extendedPersistentState() const {
+    std::list<std::pair<std::string,std::string>> result;
+    result.emplace_back("database",   database());
+    result.emplace_back("table",      table());
+    result.emplace_back("key_column", keyColumn());
+    result.emplace_back("num_chunks", std::to_string(chunks().size()));
+    return result;
+}
+
+}}} // namespace lsst::qserv::replica
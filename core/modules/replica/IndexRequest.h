@@ -0,0 +1,215 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_REPLICA_INDEXREQUEST_H
+#define LSST_QSERV_REPLICA_INDEXREQUEST_H
+
+// System headers
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "proto/replication.pb.h"
+#include "replica/Common.h"
+#include "replica/RequestMessenger.h"
+
+// This header declarations
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+// Forward declarations
+class Messenger;
+
+/**
+  * Class IndexRequest represents Controller-side requests for extracting
+  * the secondary index entries of a director table from chunks at a worker.
+  * The worker writes the entries sorted by the key into a run file in
+  * the database folder, whose name (along with the progress of the request)
+  * is available through method indexInfo().
+  */
+class IndexRequest
+    :   public RequestMessenger  {
+
+public:
+
+    /// The pointer type for instances of the class
+    typedef std::shared_ptr<IndexRequest> Ptr;
+
+    /// The function type for notifications on the completion of the request
+    typedef std::function<void(Ptr)> CallbackType;
+
+    /// The progress of the request at the worker
+    struct IndexInfo {
+        uint32_t    numChunks  = 0;
+        uint32_t    chunksRead = 0;
+        uint64_t    numRecords = 0;
+        std::string file;
+    };
+
+    // Default construction and copy semantics are prohibited
+
+    IndexRequest() = delete;
+    IndexRequest(IndexRequest const&) = delete;
+    IndexRequest& operator=(IndexRequest const&) = delete;
+
+    ~IndexRequest() final = default;
+
+    // Trivial get methods
+
+    std::string const&               database()  const { return _database; }
+    std::string const&               table()     const { return _table; }
+    std::string const&               keyColumn() const { return _keyColumn; }
+    std::vector<unsigned int> const& chunks()    const { return _chunks; }
+
+    /// @return target request specific parameters
+    IndexRequestParams const& targetRequestParams() const { return _targetRequestParams; }
+
+    /**
+     * @return the latest progress of the request reported by the worker
+     *
+     * Note that the counters are final, and the name of the run file is set,
+     * only if the operation finishes with status FINISHED::SUCCESS
+     */
+    IndexInfo indexInfo() const;
+
+    /**
+     * Create a new request with specified parameters.
+     *
+     * Static factory method is needed to prevent issue with the lifespan
+     * and memory management of instances created otherwise (as values or via
+     * low-level pointers).
+     *
+     * @param serviceProvider  - provider of various services
+     * @param worker           - identifier of a worker node where the chunks are read
+     * @param database         - the name of a database
+     * @param table            - the base name of the director table
+     * @param keyColumn        - the name of the column with the keys of the table
+     * @param chunks           - the chunks to be harvested
+     * @param onFinish         - (optional) callback function to call upon completion of the request
+     * @param priority         - priority level of the request
+     * @param keepTracking     - keep tracking the request before it finishes or fails
+     * @param messenger        - interface for communicating with workers
+     *
+     * @return pointer to the created object
+     */
+    static Ptr create(ServiceProvider::Ptr const& serviceProvider,
+                      boost::asio::io_service& io_service,
+                      std::string const& worker,
+                      std::string const& database,
+                      std::string const& table,
+                      std::string const& keyColumn,
+                      std::vector<unsigned int> const& chunks,
+                      CallbackType const& onFinish,
+                      int  priority,
+                      bool keepTracking,
+                      std::shared_ptr<Messenger> const& messenger);
+
+private:
+
+    /**
+     * Construct the request with the pointer to the services provider.
+     */
+    IndexRequest(ServiceProvider::Ptr const& serviceProvider,
+                 boost::asio::io_service& io_service,
+                 std::string const& worker,
+                 std::string const& database,
+                 std::string const& table,
+                 std::string const& keyColumn,
+                 std::vector<unsigned int> const& chunks,
+                 CallbackType const& onFinish,
+                 int  priority,
+                 bool keepTracking,
+                 std::shared_ptr<Messenger> const& messenger);
+
+    /**
+      * @see Request::startImpl()
+      */
+    void startImpl(util::Lock const& lock) final;
+
+    /**
+     * Start the timer before attempting the previously failed
+     * or successful (if a status check is needed) step.
+     *
+     * @param lock - a lock on a mutex must be acquired before calling this method
+     */
+    void wait(util::Lock const& lock);
+
+    /**
+     * Callback handler for the asynchronous operation
+     *
+     * @param ec - error code to be checked
+     */
+    void awaken(boost::system::error_code const& ec);
+
+    /**
+     * Send the serialized content of the buffer to a worker
+     *
+     * @param lock - a lock on a mutex must be acquired before calling this method
+     */
+    void send(util::Lock const& lock);
+
+    /**
+     * Process the completion of the requested operation
+     *
+     * @param success - flag indicating if the response succeeded
+     * @param message - response from a worker (if success)
+     */
+    void analyze(bool success,
+                 lsst::qserv::proto::ReplicationResponseIndex const& message);
+
+    /**
+     * @see Request::notify()
+     */
+    void notify(util::Lock const& lock) final;
+
+    /**
+     * @see Request::savePersistentState()
+     */
+    void savePersistentState(util::Lock const& lock) final;
+
+    /**
+     * @see Request::extendedPersistentState()
+     */
+    std::list<std::pair<std::string,std::string>> extendedPersistentState() const override;
+
+private:
+
+    std::string               const _database;
+    std::string               const _table;
+    std::string               const _keyColumn;
+    std::vector<unsigned int> const _chunks;
+
+    CallbackType _onFinish;
+
+    /// Request-specific parameters of the target request
+    IndexRequestParams _targetRequestParams;
+
+    /// The progress reported by a worker service
+    IndexInfo _indexInfo;
+};
+
+}}} // namespace lsst::qserv::replica
+
+#endif // LSST_QSERV_REPLICA_INDEXREQUEST_H
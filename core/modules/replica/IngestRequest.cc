@@ -0,0 +1,369 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "replica/IngestRequest.h"
+
+// System headers
+#include <stdexcept>
+
+// Third party headers
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+// Qserv headers
+#include "lsst/log/Log.h"
+#include "replica/Controller.h"
+#include "replica/DatabaseServices.h"
+#include "replica/Messenger.h"
+#include "replica/ProtocolBuffer.h"
+#include "replica/ServiceProvider.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.replica.IngestRequest");
+
+} /// namespace
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+IngestRequest::Ptr IngestRequest::create(ServiceProvider::Ptr const& serviceProvider,
+                                         boost::asio::io_service& io_service,
+                                         std::string const& worker,
+                                         std::string const& database,
+                                         unsigned int chunk,
+                                         std::string const& sourceWorker,
+                                         std::vector<IngestFileInfo> const& files,
+                                         unsigned int numLoads,
+                                         bool clusterSubChunks,
+                                         CallbackType const& onFinish,
+                                         int priority,
+                                         bool keepTracking,
+                                         std::shared_ptr<Messenger> const& messenger) {
+    return IngestRequest::Ptr(
+        new IngestRequest(serviceProvider,
+                          io_service,
+                          worker,
+                          database,
+                          chunk,
+                          sourceWorker,
+                          files,
+                          numLoads,
+                          clusterSubChunks,
+                          onFinish,
+                          priority,
+                          keepTracking,
+                          messenger));
+}
+
+IngestRequest::IngestRequest(ServiceProvider::Ptr const& serviceProvider,
+                             boost::asio::io_service& io_service,
+                             std::string const& worker,
+                             std::string const& database,
+                             unsigned int chunk,
+                             std::string const& sourceWorker,
+                             std::vector<IngestFileInfo> const& files,
+                             unsigned int numLoads,
+                             bool clusterSubChunks,
+                             CallbackType const& onFinish,
+                             int  priority,
+                             bool keepTracking,
+                             std::shared_ptr<Messenger> const& messenger)
+    :   RequestMessenger(serviceProvider,
+                         io_service,
+                         "REPLICA_INGEST",
+                         worker,
+                         priority,
+                         keepTracking,
+                         false /* allowDuplicate */,
+                         messenger),
+        _database(database),
+        _chunk(chunk),
+        _sourceWorker(sourceWorker),
+        _files(files),
+        _numLoads(numLoads),
+        _clusterSubChunks(clusterSubChunks),
+        _onFinish(onFinish) {
+
+    serviceProvider->assertDatabaseIsValid(database);
+    serviceProvider->assertWorkerIsValid(sourceWorker);
+}
+
+IngestRequest::IngestInfo IngestRequest::ingestInfo() const {
+    util::Lock lock(_mtx, context() + "ingestInfo");
+    return _ingestInfo;
+}
+
+void IngestRequest::startImpl(util::Lock const& lock) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "startImpl "
+         << " worker: "       << worker()
+         << " database: "     << database()
+         << " chunk: "        << chunk()
+         << " sourceWorker: " << sourceWorker()
+         << " files: "        << files().size());
+
+    // Serialize the Request message header and the request itself into
+    // the network buffer.
+
+    buffer()->resize();
+
+    proto::ReplicationRequestHeader hdr;
+    hdr.set_id(id());
+    hdr.set_type(proto::ReplicationRequestHeader::REPLICA);
+    hdr.set_replica_type(proto::ReplicationReplicaRequestType::REPLICA_INGEST);
+
+    buffer()->serialize(hdr);
+
+    proto::ReplicationRequestIngest message;
+    message.set_priority( priority());
+    message.set_database( database());
+    message.set_chunk(    chunk());
+    message.set_worker(   sourceWorker());
+    message.set_num_loads(numLoads());
+    message.set_cluster_subchunks(clusterSubChunks());
+
+    for (auto&& info: files()) {
+        auto file = message.add_files();
+        file->set_file(   info.file);
+        file->set_table(  info.table);
+        file->set_overlap(info.overlap);
+    }
+    buffer()->serialize(message);
+
+    send(lock);
+}
+
+void IngestRequest::wait(util::Lock const& lock) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "wait");
+
+    // Allways need to set the interval before launching the timer.
+
+    timer().expires_from_now(boost::posix_time::seconds(timerIvalSec()));
+    timer().async_wait(
+        boost::bind(
+            &IngestRequest::awaken,
+            shared_from_base<IngestRequest>(),
+            boost::asio::placeholders::error
+        )
+    );
+}
+
+void IngestRequest::awaken(boost::system::error_code const& ec) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "awaken");
+
+    if (isAborted(ec)) return;
+
+    // IMPORTANT: the final state is required to be tested twice. The first time
+    // it's done in order to avoid deadlock on the "in-flight" callbacks reporting
+    // their completion while the request termination is in a progress. And the second
+    // test is made after acquiring the lock to recheck the state in case if it
+    // has transitioned while acquiring the lock.
+
+    if (state() == State::FINISHED) return;
+
+    util::Lock lock(_mtx, context() + "awaken");
+
+    if (state() == State::FINISHED) return;
+
+    // Serialize the Status message header and the request itself into
+    // the network buffer.
+
+    buffer()->resize();
+
+    proto::ReplicationRequestHeader hdr;
+    hdr.set_id(id());
+    hdr.set_type(proto::ReplicationRequestHeader::REQUEST);
+    hdr.set_management_type(proto::ReplicationManagementRequestType::REQUEST_STATUS);
+
+    buffer()->serialize(hdr);
+
+    proto::ReplicationRequestStatus message;
+    message.set_id(id());
+    message.set_replica_type(proto::ReplicationReplicaRequestType::REPLICA_INGEST);
+
+    buffer()->serialize(message);
+
+    send(lock);
+}
+
+void IngestRequest::send(util::Lock const& lock) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "send");
+
+    auto self = shared_from_base<IngestRequest>();
+
+    messenger()->send<proto::ReplicationResponseIngest>(
+        worker(),
+        id(),
+        buffer(),
+        [self] (std::string const& id,
+                bool success,
+                proto::ReplicationResponseIngest const& response) {
+
+            self->analyze(success,
+                          response);
+        }
+    );
+}
+
+void IngestRequest::analyze(bool success,
+                            proto::ReplicationResponseIngest const& message) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "analyze  success=" << (success ? "true" : "false"));
+
+    // This method is called on behalf of an asynchronous callback fired
+    // upon a completion of the request within method send() - the only
+    // client of analyze(). So, we should take care of proper locking and watch
+    // for possible state transition which might occur while the async I/O was
+    // still in a progress.
+
+    // IMPORTANT: the final state is required to be tested twice. The first time
+    // it's done in order to avoid deadlock on the "in-flight" callbacks reporting
+    // their completion while the request termination is in a progress. And the second
+    // test is made after acquiring the lock to recheck the state in case if it
+    // has transitioned while acquiring the lock.
+
+    if (state() == State::FINISHED) return;
+
+    util::Lock lock(_mtx, context() + "analyze");
+
+    if (state() == State::FINISHED) return;
+
+    if (not success) {
+        finish(lock, CLIENT_ERROR);
+        return;
+    }
+
+    // Always use  the latest status reported by the remote server
+
+    setExtendedServerStatus(lock, replica::translate(message.status_ext()));
+
+    // Performance counters are updated from either of two sources,
+    // depending on the availability of the 'target' performance counters
+    // filled in by the 'STATUS' queries. If the later is not available
+    // then fallback to the one of the current request.
+
+    if (message.has_target_performance()) {
+        mutablePerformance().update(message.target_performance());
+    } else {
+        mutablePerformance().update(message.performance());
+    }
+
+    // Always extract the progress regardless of the completion status
+    // reported by the worker service.
+
+    if (message.has_ingest_info()) {
+        auto&& info = message.ingest_info();
+        _ingestInfo.numFiles      = info.num_files();
+        _ingestInfo.filesRead     = info.files_read();
+        _ingestInfo.filesLoaded   = info.files_loaded();
+        _ingestInfo.bytesRead     = info.bytes_read();
+        _ingestInfo.rowsLoaded    = info.rows_loaded();
+        _ingestInfo.numTables     = info.num_tables();
+        _ingestInfo.tablesIndexed = info.tables_indexed();
+
+        LOGS(_log, LOG_LVL_DEBUG, context() << "analyze"
+             << "  files loaded: " << _ingestInfo.filesLoaded << "/" << _ingestInfo.numFiles
+             << "  rows: "         << _ingestInfo.rowsLoaded
+             << "  tables indexed: " << _ingestInfo.tablesIndexed << "/" << _ingestInfo.numTables);
+    }
+
+    // Extract target request type-specific parameters from the response
+    if (message.has_request()) {
+        _targetRequestParams = IngestRequestParams(message.request());
+    }
+    switch (message.status()) {
+
+        case proto::ReplicationStatus::SUCCESS:
+
+            finish(lock, SUCCESS);
+            break;
+
+        case proto::ReplicationStatus::QUEUED:
+            if (keepTracking()) wait(lock);
+            else                finish(lock, SERVER_QUEUED);
+            break;
+
+        case proto::ReplicationStatus::IN_PROGRESS:
+            if (keepTracking()) wait(lock);
+            else                finish(lock, SERVER_IN_PROGRESS);
+            break;
+
+        case proto::ReplicationStatus::IS_CANCELLING:
+            if (keepTracking()) wait(lock);
+            else                finish(lock, SERVER_IS_CANCELLING);
+            break;
+
+        case proto::ReplicationStatus::BAD:
+
+            // The chunk is being loaded by another request
+
+            if (extendedServerStatus() == ExtendedCompletionStatus::EXT_STATUS_DUPLICATE) {
+                setDuplicateRequestId(lock, message.duplicate_request_id());
+            }
+            finish(lock, SERVER_BAD);
+            break;
+
+        case proto::ReplicationStatus::FAILED:
+            finish(lock, SERVER_ERROR);
+            break;
+
+        case proto::ReplicationStatus::CANCELLED:
+            finish(lock, SERVER_CANCELLED);
+            break;
+
+        default:
+            throw std::logic_error(
+                    "IngestRequest::analyze() unknown status '" +
+                    proto::ReplicationStatus_Name(message.status()) + "' received from server");
+    }
+}
+
+void IngestRequest::notify(util::Lock const& lock) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "notify");
+
+    notifyDefaultImpl<IngestRequest>(lock, _onFinish);
+}
+
+void IngestRequest::savePersistentState(util::Lock const& lock) {
+    LOGS(_log, LOG_LVL_DEBUG, context() << "savePersistentState");
+    controller()->serviceProvider()->databaseServices()->saveState(*this, performance(lock));
+}
+
+std::list<std::pair<std::string,std::string>> IngestRequest::extendedPersistentState() const {
+    std::list<std::pair<std::string,std::string>> result;
+    result.emplace_back("database",      database());
+    result.emplace_back("chunk",         std::to_string(chunk()));
+    result.emplace_back("source_worker", sourceWorker());
+    result.emplace_back("num_files",     std::to_string(files().size()));
+    result.emplace_back("num_loads",     std::to_string(numLoads()));
+    result.emplace_back("cluster_subchunks", clusterSubChunks() ? "1" : "0");
+    return result;
+}
+
+}}} // namespace lsst::qserv::replica
@@ -0,0 +1,230 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_REPLICA_INGESTREQUEST_H
+#define LSST_QSERV_REPLICA_INGESTREQUEST_H
+
+// System headers
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "proto/replication.pb.h"
+#include "replica/Common.h"
+#include "replica/RequestMessenger.h"
+
+// This header declarations
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+// Forward declarations
+class Messenger;
+
+/**
+  * Class IngestRequest represents Controller-side requests for loading
+  * contributions into the chunk and overlap tables of a database at a worker.
+  * The files are pulled by the worker from the file server of the source
+  * worker. While the request is being tracked, the progress reported by
+  * the worker is available through method ingestInfo().
+  */
+class IngestRequest
+    :   public RequestMessenger  {
+
+public:
+
+    /// The pointer type for instances of the class
+    typedef std::shared_ptr<IngestRequest> Ptr;
+
+    /// The function type for notifications on the completion of the request
+    typedef std::function<void(Ptr)> CallbackType;
+
+    /// The progress of the ingest at the worker
+    struct IngestInfo {
+        uint32_t numFiles      = 0;
+        uint32_t filesRead     = 0;
+        uint32_t filesLoaded   = 0;
+        uint64_t bytesRead     = 0;
+        uint64_t rowsLoaded    = 0;
+        uint32_t numTables     = 0;
+        uint32_t tablesIndexed = 0;
+    };
+
+    // Default construction and copy semantics are prohibited
+
+    IngestRequest() = delete;
+    IngestRequest(IngestRequest const&) = delete;
+    IngestRequest& operator=(IngestRequest const&) = delete;
+
+    ~IngestRequest() final = default;
+
+    // Trivial get methods
+
+    std::string const&                 database()     const { return _database; }
+    unsigned int                       chunk()        const { return _chunk; }
+    std::string const&                 sourceWorker() const { return _sourceWorker; }
+    std::vector<IngestFileInfo> const& files()        const { return _files; }
+    unsigned int                       numLoads()     const { return _numLoads; }
+    bool                               clusterSubChunks() const { return _clusterSubChunks; }
+
+    /// @return target request specific parameters
+    IngestRequestParams const& targetRequestParams() const { return _targetRequestParams; }
+
+    /**
+     * @return the latest progress of the ingest reported by the worker
+     *
+     * Note that the counters are final only if the operation finishes with
+     * status FINISHED::SUCCESS
+     */
+    IngestInfo ingestInfo() const;
+
+    /**
+     * Create a new request with specified parameters.
+     *
+     * Static factory method is needed to prevent issue with the lifespan
+     * and memory management of instances created otherwise (as values or via
+     * low-level pointers).
+     *
+     * @param serviceProvider  - provider of various services
+     * @param worker           - identifier of a worker node where the tables are loaded
+     * @param database         - the name of a database
+     * @param chunk            - the chunk number
+     * @param sourceWorker     - identifier of a worker node whose file server has the files
+     * @param files            - the contributions to be loaded
+     * @param numLoads         - the number of files loaded at the same time
+     *                           (0 means the default of the worker)
+     * @param clusterSubChunks - store the rows of the tables ordered by subchunk,
+     *                           and record the row ranges of the subchunks
+     * @param onFinish         - (optional) callback function to call upon completion of the request
+     * @param priority         - priority level of the request
+     * @param keepTracking     - keep tracking the request before it finishes or fails
+     * @param messenger        - interface for communicating with workers
+     *
+     * @return pointer to the created object
+     */
+    static Ptr create(ServiceProvider::Ptr const& serviceProvider,
+                      boost::asio::io_service& io_service,
+                      std::string const& worker,
+                      std::string const& database,
+                      unsigned int chunk,
+                      std::string const& sourceWorker,
+                      std::vector<IngestFileInfo> const& files,
+                      unsigned int numLoads,
+                      bool clusterSubChunks,
+                      CallbackType const& onFinish,
+                      int  priority,
+                      bool keepTracking,
+                      std::shared_ptr<Messenger> const& messenger);
+
+private:
+
+    /**
+     * Construct the request with the pointer to the services provider.
+     */
+    IngestRequest(ServiceProvider::Ptr const& serviceProvider,
+                  boost::asio::io_service& io_service,
+                  std::string const& worker,
+                  std::string const& database,
+                  unsigned int chunk,
+                  std::string const& sourceWorker,
+                  std::vector<IngestFileInfo> const& files,
+                  unsigned int numLoads,
+                  bool clusterSubChunks,
+                  CallbackType const& onFinish,
+                  int  priority,
+                  bool keepTracking,
+                  std::shared_ptr<Messenger> const& messenger);
+
+    /**
+      * @see Request::startImpl()
+      */
+    void startImpl(util::Lock const& lock) final;
+
+    /**
+     * Start the timer before attempting the previously failed
+     * or successful (if a status check is needed) step.
+     *
+     * @param lock - a lock on a mutex must be acquired before calling this method
+     */
+    void wait(util::Lock const& lock);
+
+    /**
+     * Callback handler for the asynchronous operation
+     *
+     * @param ec - error code to be checked
+     */
+    void awaken(boost::system::error_code const& ec);
+
+    /**
+     * Send the serialized content of the buffer to a worker
+     *
+     * @param lock - a lock on a mutex must be acquired before calling this method
+     */
+    void send(util::Lock const& lock);
+
+    /**
+     * Process the completion of the requested operation
+     *
+     * @param success - flag indicating if the response succeeded
+     * @param message - response from a worker (if success)
+     */
+    void analyze(bool success,
+                 lsst::qserv::proto::ReplicationResponseIngest const& message);
+
+    /**
+     * @see Request::notify()
+     */
+    void notify(util::Lock const& lock) final;
+
+    /**
+     * @see Request::savePersistentState()
+     */
+    void savePersistentState(util::Lock const& lock) final;
+
+    /**
+     * @see Request::extendedPersistentState()
+     */
+    std::list<std::pair<std::string,std::string>> extendedPersistentState() const override;
+
+private:
+
+    std::string                 const _database;
+    unsigned int                const _chunk;
+    std::string                 const _sourceWorker;
+    std::vector<IngestFileInfo> const _files;
+    unsigned int                const _numLoads;
+    bool                        const _clusterSubChunks;
+
+    CallbackType _onFinish;
+
+    /// Request-specific parameters of the target request
+    IngestRequestParams _targetRequestParams;
+
+    /// The progress reported by a worker service
+    IngestInfo _ingestInfo;
+};
+
+}}} // namespace lsst::qserv::replica
+
+#endif // LSST_QSERV_REPLICA_INGESTREQUEST_H
@@ -24,7 +24,9 @@
 #include "replica/MessengerConnector.h"
 
 // System headers
+#include <iterator>
 #include <stdexcept>
+#include <vector>
 
 // Third party headers
 #include <boost/bind.hpp>
@@ -40,6 +42,10 @@ namespace {
 
 LOG_LOGGER _log = LOG_GET("lsst.qserv.replica.MessengerConnector");
 
+/// The maximum number of requests sent to a worker and still waiting
+/// for their responses
+size_t const maxInFlightRequests = 64;
+
 } /// namespace
 
 namespace lsst {
@@ -77,6 +83,9 @@ MessengerConnector::MessengerConnector(ServiceProvider::Ptr const& serviceProvid
         _resolver(io_service),
         _socket(io_service),
         _timer(io_service),
+        _generation(0),
+        _sending(false),
+        _receiving(false),
         _inBuffer(serviceProvider->config()->requestBufferSizeBytes()) {
 }
 
@@ -104,13 +113,17 @@ void MessengerConnector::stop() {
                 _socket.cancel();
                 _socket.close();
                 _timer.cancel();
-    
-                // Make sure the current request's owner gets notified
-    
-                if (_currentRequest != nullptr) {
-                    requests2notify.push_back(_currentRequest);
-                    _currentRequest = nullptr;
-                }
+
+                ++_generation;
+                _sending   = false;
+                _receiving = false;
+                _sendBatch.clear();
+
+                // Make sure the owners of the requests which are in flight
+                // get notified
+
+                for (auto&& entry: _inFlight) requests2notify.push_back(entry.second);
+                _inFlight.clear();
 
                 // Also cancel the queued requests and notify their owners
                 
@@ -144,13 +157,11 @@ void MessengerConnector::cancel(std::string const& id) {
         }
     );
 
-    // Also, if the request is already being processed then terminate all
-    // communications with a worker. This will automatically abort the request.
+    // If the request has already been sent then forget about it. Its response
+    // will be discarded when it arrives, and other requests which are in flight
+    // over the same connection aren't affected.
 
-    if (_currentRequest and (_currentRequest->id() == id)) {
-        _currentRequest = nullptr;
-        if (_state == STATE_COMMUNICATING) restart(lock);
-    }
+    _inFlight.erase(id);
 }
 
 bool MessengerConnector::exists(std::string const& id) const {
@@ -198,10 +209,11 @@ void MessengerConnector::sendImpl(MessageWrapperBase::Ptr const& ptr) {
     }
 }
 
-void MessengerConnector::restart(util::Lock const& lock) {
+void MessengerConnector::restart(util::Lock const& lock,
+                                 std::list<MessageWrapperBase::Ptr>& requests2notify) {
 
     LOGS(_log, LOG_LVL_DEBUG, context() << "restart"
-         << "  _currentRequest=" << (_currentRequest ? _currentRequest->id() : ""));
+         << "  _inFlight.size=" << _inFlight.size());
 
     // Cancel any asynchronous operation(s) if not in the initial state
 
@@ -224,13 +236,24 @@ void MessengerConnector::restart(util::Lock const& lock) {
             throw std::logic_error(
                 "incomplete implementation of method MessengerConnector::restart");
     }
+
+    // The responses to the requests which are in flight are lost with
+    // the connection. Completions of the asynchronous operations launched
+    // over the connection are ignored.
+
+    for (auto&& entry: _inFlight) requests2notify.push_back(entry.second);
+    _inFlight.clear();
+    _sendBatch.clear();
+    _sending   = false;
+    _receiving = false;
+    ++_generation;
+
     resolve(lock);
 }
 
 void MessengerConnector::resolve(util::Lock const& lock) {
 
-    LOGS(_log, LOG_LVL_DEBUG, context() << "resolve"
-         << "  _currentRequest=" << (_currentRequest ? _currentRequest->id() : ""));
+    LOGS(_log, LOG_LVL_DEBUG, context() << "resolve");
 
     if (_state != STATE_INITIAL) return;
 
@@ -253,8 +276,7 @@ void MessengerConnector::resolve(util::Lock const& lock) {
 void MessengerConnector::resolved(boost::system::error_code const& ec,
                                   boost::asio::ip::tcp::resolver::iterator iter) {
 
-    LOGS(_log, LOG_LVL_DEBUG, context() << "resolved"
-         << "  _currentRequest=" << (_currentRequest ? _currentRequest->id() : ""));
+    LOGS(_log, LOG_LVL_DEBUG, context() << "resolved");
 
     if (isAborted(ec)) return;
 
@@ -270,8 +292,7 @@ void MessengerConnector::resolved(boost::system::error_code const& ec,
 void MessengerConnector::connect(util::Lock const& lock,
                                  boost::asio::ip::tcp::resolver::iterator iter) {
 
-    LOGS(_log, LOG_LVL_DEBUG, context() << "connect"
-         << "  _currentRequest=" << (_currentRequest ? _currentRequest->id() : ""));
+    LOGS(_log, LOG_LVL_DEBUG, context() << "connect");
 
     boost::asio::async_connect(
         _socket,
@@ -288,8 +309,7 @@ void MessengerConnector::connect(util::Lock const& lock,
 void MessengerConnector::connected(boost::system::error_code const& ec,
                                    boost::asio::ip::tcp::resolver::iterator iter) {
 
-    LOGS(_log, LOG_LVL_DEBUG, context() << "connected"
-         << "  _currentRequest=" << (_currentRequest ? _currentRequest->id() : ""));
+    LOGS(_log, LOG_LVL_DEBUG, context() << "connected");
 
     if (isAborted(ec)) return;
 
@@ -305,8 +325,7 @@ void MessengerConnector::connected(boost::system::error_code const& ec,
 
 void MessengerConnector::waitBeforeRestart(util::Lock const& lock) {
 
-    LOGS(_log, LOG_LVL_DEBUG, context() << "waitBeforeRestart"
-         << "  _currentRequest=" << (_currentRequest ? _currentRequest->id() : ""));
+    LOGS(_log, LOG_LVL_DEBUG, context() << "waitBeforeRestart");
 
     // Allways need to set the interval before launching the timer.
 
@@ -323,100 +342,124 @@ void MessengerConnector::waitBeforeRestart(util::Lock const& lock) {
 void MessengerConnector::awakenForRestart(boost::system::error_code const& ec) {
 
     LOGS(_log, LOG_LVL_DEBUG, context() << "awakenForRestart"
-         << "  _currentRequest=" << (_currentRequest ? _currentRequest->id() : "")
          << "  _requests.size=" << _requests.size());
 
     if (isAborted(ec)) return;
 
-    util::Lock lock(_mtx, context() + "awakenForRestart");
+    std::list<MessageWrapperBase::Ptr> requests2notify;
+    {
+        util::Lock lock(_mtx, context() + "awakenForRestart");
 
-    if (_state != STATE_CONNECTING) return;
+        if (_state != STATE_CONNECTING) return;
 
-    restart(lock);
+        restart(lock, requests2notify);
+    }
+    for (auto&& ptr: requests2notify) ptr->parseAndNotify();
 }
 
 void MessengerConnector::sendRequest(util::Lock const& lock) {
 
     LOGS(_log, LOG_LVL_DEBUG, context() << "sendRequest"
-         << "  _currentRequest=" << (_currentRequest ? _currentRequest->id() : ""));
+         << "  _inFlight.size=" << _inFlight.size()
+         << "  _requests.size=" << _requests.size());
+
+    // Check if there is an outstanding write
 
-    // Check if there is an outstanding send request
+    if (_sending) return;
 
-    if (_currentRequest) return;
+    // Pull as many requests from the front of the queue as allowed, and send
+    // them all with a single write. The frames of the requests delimit them, and
+    // the worker reads them one after another. The requests don't wait for
+    // the responses to the earlier ones.
 
-    // Pull a request (if any) from the from of the queue
+    std::vector<boost::asio::const_buffer> buffers;
+    while (not _requests.empty() and (_inFlight.size() < ::maxInFlightRequests)) {
 
-    if (_requests.empty()) return;
+        MessageWrapperBase::Ptr const ptr = _requests.front();
+        _requests.pop_front();
+
+        _inFlight[ptr->id()] = ptr;
+        _sendBatch.push_back(ptr);
+        buffers.emplace_back(ptr->requestBufferPtr()->data(),
+                             ptr->requestBufferPtr()->size());
+    }
+    if (buffers.empty()) return;
 
-    _currentRequest = _requests.front();
-    _requests.pop_front();
+    _sending = true;
 
-    // Send the message
+    // The buffers stay valid while the requests are in the batch
 
     boost::asio::async_write(
         _socket,
-        boost::asio::buffer(
-            _currentRequest->requestBufferPtr()->data(),
-            _currentRequest->requestBufferPtr()->size()
-        ),
+        buffers,
         boost::bind(
             &MessengerConnector::requestSent,
             shared_from_this(),
+            _generation,
             boost::asio::placeholders::error,
             boost::asio::placeholders::bytes_transferred
         )
     );
 }
 
-void MessengerConnector::requestSent(boost::system::error_code const& ec,
+void MessengerConnector::requestSent(uint64_t generation,
+                                     boost::system::error_code const& ec,
                                      size_t bytes_transferred) {
 
     LOGS(_log, LOG_LVL_DEBUG, context() << "requestSent"
-         << "  _currentRequest=" << (_currentRequest ? _currentRequest->id() : ""));
+         << "  _sendBatch.size=" << _sendBatch.size());
 
-    util::Lock lock(_mtx, context() + "requestSent");
-
-    // Check if the request was cancelled while still in flight.
-    // If that happens then _currentRequest should already be nullified
-    // and request removed from all data structures.
+    std::list<MessageWrapperBase::Ptr> requests2notify;
+    {
+        util::Lock lock(_mtx, context() + "requestSent");
 
-    if (isAborted(ec)) {
-        LOGS(_log, LOG_LVL_DEBUG, context() << "requestSent  isAborted -> restart");
+        // Check if the connection was restarted or stopped while the requests
+        // were in flight. In that case the requests were already either put back
+        // into the queue or failed, and other requests may be being sent.
 
-        restart(lock);
-        return;
-    }
-    if (_currentRequest) {
+        if (isAborted(ec) or (generation != _generation)) {
+            LOGS(_log, LOG_LVL_DEBUG, context() << "requestSent  ** ABANDONED **");
+            return;
+        }
+        _sending = false;
 
-        // The request is still valid
         if (ec.value() != 0) {
 
-            // If something bad happened along the line then make sure this request
-            // will be the first to be served before restarting the communication.
+            // If something bad happened along the line then make sure the requests
+            // of the batch (unless cancelled) will be the first to be served before
+            // restarting the communication.
 
-            _requests.push_front(_currentRequest);
-            _currentRequest = nullptr;
+            for (auto itr = _sendBatch.rbegin(); itr != _sendBatch.rend(); ++itr) {
+                if (_inFlight.erase((*itr)->id())) _requests.push_front(*itr);
+            }
+            _sendBatch.clear();
 
-            LOGS(_log, LOG_LVL_DEBUG, context() << "requestSent  request is valid, but failed -> restart");
+            LOGS(_log, LOG_LVL_DEBUG, context() << "requestSent  failed -> restart");
 
-            restart(lock);
+            restart(lock, requests2notify);
 
         } else {
 
-            // Go wait for a server response
+            _sendBatch.clear();
+
+            // Go wait for the server responses, and send more requests
+            // if any were queued in the meantime
 
             receiveResponse(lock);
+            sendRequest(lock);
         }
-
-    } else {
-        LOGS(_log, LOG_LVL_DEBUG, context() << "requestSent  no current request (cancelled?)");
     }
+    for (auto&& ptr: requests2notify) ptr->parseAndNotify();
 }
 
 void MessengerConnector::receiveResponse(util::Lock const& lock) {
 
     LOGS(_log, LOG_LVL_DEBUG, context() << "receiveResponse"
-         << "  _currentRequest=" << (_currentRequest ? _currentRequest->id() : ""));
+         << "  _inFlight.size=" << _inFlight.size());
+
+    // Check if there is an outstanding read, or if there is nothing to wait for
+
+    if (_receiving or _inFlight.empty()) return;
 
     // Start with receiving the fixed length frame carrying
     // the size (in bytes) the length of the subsequent message.
@@ -429,6 +472,8 @@ void MessengerConnector::receiveResponse(util::Lock const& lock) {
     size_t const bytes = sizeof(uint32_t);
     _inBuffer.resize(bytes);
 
+    _receiving = true;
+
     boost::asio::async_read(
         _socket,
         boost::asio::buffer(
@@ -439,17 +484,19 @@ void MessengerConnector::receiveResponse(util::Lock const& lock) {
         boost::bind(
             &MessengerConnector::responseReceived,
             shared_from_this(),
+            _generation,
             boost::asio::placeholders::error,
             boost::asio::placeholders::bytes_transferred
         )
     );
 }
 
-void MessengerConnector::responseReceived(boost::system::error_code const& ec,
+void MessengerConnector::responseReceived(uint64_t generation,
+                                          boost::system::error_code const& ec,
                                           size_t bytes_transferred) {
 
     LOGS(_log, LOG_LVL_DEBUG, context() << "responseReceived"
-         << "  _currentRequest=" << (_currentRequest ? _currentRequest->id() : "")
+         << "  _inFlight.size=" << _inFlight.size()
          << " error_code=" << ec);
 
     // The notification if any should be happening outside the lock guard
@@ -462,100 +509,95 @@ void MessengerConnector::responseReceived(boost::system::error_code const& ec,
     // the notification in a separate (new) thread.
 
     MessageWrapperBase::Ptr request2notify;
+    std::list<MessageWrapperBase::Ptr> requests2notify;
     {
         util::Lock lock(_mtx, context() + "responseReceived");
 
-        // Check if the request was cancelled while still in flight.
-        // If that happens then _currentRequest should already be nullified
-        // and request removed from all data structures.
+        // Check if the connection was restarted or stopped while waiting
+        // for the response.
 
-        if (isAborted(ec)) {
-            restart(lock);
-            return;
-        }
-
-        if (_currentRequest) {
-
-            // At this point we're done with the current request, regardless of its completion
-            // status, or any failures to pull or digest the response data. Hence, removing
-            // completely it and getting ready to notify a caller.
-
-            std::swap(request2notify, _currentRequest);
+        if (isAborted(ec) or (generation != _generation)) return;
 
-            // The requst is still valid
-            if (ec.value() != 0) {
+        _receiving = false;
 
-                // Failed to get any response from a worker
+        if (ec.value() != 0) {
 
-                restart(lock);
+            // Failed to get any response from a worker
 
-            } else {
+            restart(lock, requests2notify);
 
-                // Receive response header into the temporary buffer
+        } else {
 
-                if (syncReadVerifyHeader(lock,
-                                         _inBuffer,
-                                         _inBuffer.parseLength(),
-                                         request2notify->id()).value() != 0) {
+            // Receive response header into the temporary buffer, and then
+            // the frame of the response body
 
-                    // Failed to receive the header
+            std::string id;
+            size_t bytes;
+            if ((syncReadHeader(lock,
+                                _inBuffer,
+                                _inBuffer.parseLength(),
+                                id).value() != 0) or
+                (syncReadFrame(lock,
+                               _inBuffer,
+                               bytes).value() != 0)) {
 
-                    restart(lock);
+                restart(lock, requests2notify);
 
-                } else {
+            } else {
 
-                    // Read the response frame
+                // The responses may arrive in any order. They're matched with
+                // the requests by their identifiers.
 
-                    size_t bytes;
-                    if (syncReadFrame(lock,
-                                      _inBuffer,
-                                      bytes).value() != 0) {
+                auto const itr = _inFlight.find(id);
+                if (itr == _inFlight.end()) {
 
-                        // Failed to read the frame
+                    // The request was cancelled after it was sent. Just read
+                    // the response and forget about it.
 
-                        restart(lock);
+                    LOGS(_log, LOG_LVL_DEBUG, context() << "responseReceived"
+                         << "  discarding the response to id=" << id);
 
-                    } else {
+                    if (syncReadMessageImpl(lock,
+                                            _inBuffer,
+                                            bytes).value() != 0) {
+                        restart(lock, requests2notify);
+                    }
 
-                        LOGS(_log, LOG_LVL_DEBUG, context() << "responseReceived"
-                             << "  _currentRequest=" << request2notify->id()
-                             << " bytes=" << bytes);
+                } else {
 
-                        // Receive response body into a buffer inside the wrapper
+                    // At this point we're done with the request, regardless of its
+                    // completion status, or any failures to pull the response data.
 
-                        if (syncReadMessageImpl(lock,
-                                                request2notify->responseBuffer(),
-                                                bytes).value() != 0) {
+                    request2notify = itr->second;
+                    _inFlight.erase(itr);
 
-                            // Failed to read the message body
+                    LOGS(_log, LOG_LVL_DEBUG, context() << "responseReceived"
+                         << "  id=" << id
+                         << " bytes=" << bytes);
 
-                            restart(lock);
+                    // Receive response body into a buffer inside the wrapper
 
-                        } else {
+                    if (syncReadMessageImpl(lock,
+                                            request2notify->responseBuffer(),
+                                            bytes).value() != 0) {
 
-                            // Finally, success!
+                        restart(lock, requests2notify);
 
-                            request2notify->setSuccess(true);
+                    } else {
 
-                            // Initiate the next request (if any) processing
+                        // Finally, success!
 
-                            sendRequest(lock);
-                        }
+                        request2notify->setSuccess(true);
                     }
                 }
-            }
 
-        } else {
+                // Keep receiving responses to the remaining requests (if any),
+                // and initiate the next requests (if any) processing
 
-            // We're here because there is no '_currentRequest'.
-            // The request submission had a chance to finish (successfully or not)
-            // before the cancellation attempt was made. So, we just forget about
-            // this request and send no notification to a caller.
-
-            if (ec.value() != 0) {
-                restart(lock);
-            } else {
-                sendRequest(lock);
+                if (_state == STATE_COMMUNICATING) {
+                    receiveResponse(lock);
+                    sendRequest(lock);
+                }
             }
         }
     }
@@ -564,6 +606,7 @@ void MessengerConnector::responseReceived(boost::system::error_code const& ec,
     // deadlocks.
 
     if (request2notify) request2notify->parseAndNotify();
+    for (auto&& ptr: requests2notify) ptr->parseAndNotify();
 }
 
 boost::system::error_code MessengerConnector::syncReadFrame(util::Lock const& lock,
@@ -583,17 +626,16 @@ boost::system::error_code MessengerConnector::syncReadFrame(util::Lock const& lo
         ec
     );
     LOGS(_log, LOG_LVL_DEBUG, context() << "syncReadFrame"
-         << "  _currentRequest=" << (_currentRequest ? _currentRequest->id() : "")
          << " error_code=" << ec);
 
     if (ec.value() == 0) bytes = buf.parseLength();
     return ec;
 }
 
-boost::system::error_code MessengerConnector::syncReadVerifyHeader(util::Lock const& lock,
-                                                                   replica::ProtocolBuffer& buf,
-                                                                   size_t bytes,
-                                                                   std::string const& id) {
+boost::system::error_code MessengerConnector::syncReadHeader(util::Lock const& lock,
+                                                             replica::ProtocolBuffer& buf,
+                                                             size_t bytes,
+                                                             std::string& id) {
     boost::system::error_code const ec =
         syncReadMessageImpl(lock,
                             buf,
@@ -601,11 +643,7 @@ boost::system::error_code MessengerConnector::syncReadVerifyHeader(util::Lock co
     if (ec.value() == 0) {
         proto::ReplicationResponseHeader hdr;
         buf.parse(hdr, bytes);
-        if (id != hdr.id()) {
-            throw std::logic_error(
-                    "MessengerConnector::syncReadVerifyHeader  got unexpected id: " + hdr.id() +
-                    " instead of: " + id);
-        }
+        id = hdr.id();
     }
     return ec;
 }
@@ -626,7 +664,6 @@ boost::system::error_code MessengerConnector::syncReadMessageImpl(util::Lock con
         ec
     );
     LOGS(_log, LOG_LVL_DEBUG, context() << "syncReadMessageImpl"
-         << "  _currentRequest=" << (_currentRequest ? _currentRequest->id() : "")
          << " error_code=" << ec);
 
     return ec;
@@ -653,7 +690,10 @@ MessageWrapperBase::Ptr MessengerConnector::find(util::Lock const& lock,
                                 return ptr->id() == id;
                             });
 
-    return _requests.end() == itr ? MessageWrapperBase::Ptr() : *itr;
+    if (_requests.end() != itr) return *itr;
+
+    auto const inFlightItr = _inFlight.find(id);
+    return _inFlight.end() == inFlightItr ? MessageWrapperBase::Ptr() : inFlightItr->second;
 }
 
 }}} // namespace lsst::qserv::replica
@@ -25,9 +25,11 @@
 // System headers
 #include <functional>
 #include <list>
+#include <map>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 // Third party headers
 #include <boost/asio.hpp>
@@ -337,9 +339,15 @@ private:
      * NOTE: This method is called internally when there is a doubt that
      *       it's possible to do a clean recovery from a failure.
      *
-     * @param lock - a lock on a mutex must be acquired before calling this method
+     * The requests which were in flight are moved into the output list. Their
+     * responses are lost with the connection, and their owners are supposed
+     * to be notified on the failures after releasing the lock.
+     *
+     * @param lock            - a lock on a mutex must be acquired before calling this method
+     * @param requests2notify - the list to be extended with the failed requests
      */
-    void restart(util::Lock const& lock);
+    void restart(util::Lock const& lock,
+                 std::list<MessageWrapperBase::Ptr>& requests2notify);
 
     /**
      * Start resolving the destination worker host & port
@@ -392,24 +400,28 @@ private:
     void awakenForRestart(boost::system::error_code const& ec);
 
     /**
-     * Lookup for the next available request and begin sending it
-     * unless there is another ongoing request at a time of the call.
+     * Pull the queued requests (up to a limit on the number of requests
+     * in flight) and begin sending them with a single write unless there
+     * is another ongoing write at a time of the call.
      * 
      * @param lock - a lock on a mutex must be acquired before calling this method
      */
     void sendRequest(util::Lock const& lock);
 
     /**
-     * Callback handler fired upon a completion of the request sending
+     * Callback handler fired upon a completion of the requests sending
      *
+     * @param generation         - the generation of the connection the write was made to
      * @param ec                 - error code to be checked
      * @param bytes_transferred  - the number of bytes sent
      */
-    void requestSent(boost::system::error_code const& ec,
+    void requestSent(uint64_t generation,
+                     boost::system::error_code const& ec,
                      size_t bytes_transferred);
 
     /**
-     * Begin receiving a response
+     * Begin receiving a response unless there is another ongoing read,
+     * or no requests are in flight at a time of the call.
      * 
      * @param lock - a lock on a mutex must be acquired before calling this method
      */
@@ -418,10 +430,12 @@ private:
     /**
      * Callback handler fired upon a completion of the response receiving
      *
+     * @param generation         - the generation of the connection the read was made from
      * @param ec                 - error code to be checked
      * @param bytes_transferred  - the number of bytes sent
      */
-    void responseReceived(boost::system::error_code const& ec,
+    void responseReceived(uint64_t generation,
+                          boost::system::error_code const& ec,
                           size_t bytes_transferred);
 
     /**
@@ -441,24 +455,21 @@ private:
 
    /**
      * Synchronously read a response header of a known size. Then parse it
-     * and analyze it to ensure its content matches expectations. Return
-     * the completion status of the operation.
-     *
-     * The method will throw exception std::logic_error if the header's
-     * content won't match expectations.
+     * and extract the identifier of the request the response is meant for.
+     * Return the completion status of the operation.
      *
      * @param lock  - a lock on a mutex must be acquired before calling this method
      * @param buf   - the buffer to use
      * @param bytes - a expected length of the message (obtained from a preceding frame)
      *                to be received into the network buffer from the network.
-     * @param id    - a unique identifier of a request to match the 'id' in a response header
+     * @param id    - a unique identifier of a request found in a response header
      *
      * @return the completion code of the operation
      */
-    boost::system::error_code syncReadVerifyHeader(util::Lock const& lock,
-                                                   ProtocolBuffer& buf,
-                                                   size_t bytes,
-                                                   std::string const& id);
+    boost::system::error_code syncReadHeader(util::Lock const& lock,
+                                             ProtocolBuffer& buf,
+                                             size_t bytes,
+                                             std::string& id);
 
     /**
      * Synchronously read a message of a known size into the specified buffer.
@@ -536,9 +547,24 @@ private:
     /// The queue (FIFO) of requests
     std::list<MessageWrapperBase::Ptr> _requests;
 
-    /// The currently processed (being sent) request (if any, otherwise
-    /// the pointer is set to nullptr)
-    MessageWrapperBase::Ptr _currentRequest;
+    /// The requests which have been sent (or are being sent) and are waiting
+    /// for responses. The responses may arrive in any order.
+    std::map<std::string, MessageWrapperBase::Ptr> _inFlight;
+
+    /// The requests of the ongoing write. Keeping them here guarantees
+    /// their buffers stay valid until the write finishes.
+    std::vector<MessageWrapperBase::Ptr> _sendBatch;
+
+    /// The counter incremented each time the connection is restarted
+    /// or stopped. Completions of the asynchronous operations launched
+    /// over the previous connections are ignored.
+    uint64_t _generation;
+
+    /// The flag is set while a write is in progress
+    bool _sending;
+
+    /// The flag is set while a read is in progress
+    bool _receiving;
 
     /// The intermediate buffer for messages received from a worker
     ProtocolBuffer _inBuffer;
@@ -0,0 +1,124 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "replica/PackApp.h"
+
+// System headers
+#include <atomic>
+#include <iostream>
+
+// Qserv headers
+#include "replica/Controller.h"
+#include "replica/PackJob.h"
+#include "util/BlockPost.h"
+
+using namespace std;
+
+namespace {
+
+string const description =
+    "This application converts the chunk tables of a database into the packed"
+    " (compressed, read-only) format of MyISAM at all workers having complete"
+    " replicas of the chunks. The database is expected not to be modified"
+    " afterwards. The replicas which are already packed are left as they are.";
+
+} /// namespace
+
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+PackApp::Ptr PackApp::create(int argc, char* argv[]) {
+    return Ptr(
+        new PackApp(argc, argv)
+    );
+}
+
+
+PackApp::PackApp(int argc, char* argv[])
+    :   Application(
+            argc, argv,
+            ::description,
+            true    /* injectDatabaseOptions */,
+            true    /* boostProtobufVersionCheck */,
+            true    /* enableServiceProvider */
+        ) {
+
+    // Configure the command line parser
+
+    parser().required(
+        "database",
+        "The name of a database",
+        _database);
+}
+
+
+int PackApp::runImpl() {
+
+    atomic<bool> finished{false};
+    auto const job = PackJob::create(
+        _database,
+        Controller::create(serviceProvider()),
+        string(),
+        [&finished] (PackJob::Ptr const& job) {
+            finished = true;
+        }
+    );
+    job->start();
+
+    util::BlockPost blockPost(1000,2000);
+    while (not finished) {
+        blockPost.wait();
+    }
+
+    // Analyze and display results
+
+    PackJobResult const& resultData = job->getResultData();
+
+    cout << "\n"
+         << "STATE:    " << job->state2string(job->state(), job->extendedState()) << "\n"
+         << "REPLICAS: " << resultData.replicas.size() << "\n"
+         << "\n";
+
+    for (auto&& entry: resultData.workers) {
+        cout << "  " << entry.first << "  " << (entry.second ? "SUCCEEDED" : "FAILED") << "\n";
+    }
+    cout << endl;
+
+    for (auto&& info: resultData.replicas) {
+        uint64_t size = 0;
+        uint64_t unpackedSize = 0;
+        for (auto&& file: info.fileInfo()) {
+            size         += file.size;
+            unpackedSize += file.unpackedSize;
+        }
+        cout << "  " << info.chunk() << "  " << info.worker()
+             << "  size: " << size << "  unpacked: " << unpackedSize << "\n";
+    }
+    cout << endl;
+
+    return job->extendedState() == Job::ExtendedState::SUCCESS ? 0 : 1;
+}
+
+}}} // namespace lsst::qserv::replica
@@ -0,0 +1,86 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_REPLICA_PACKAPP_H
+#define LSST_QSERV_REPLICA_PACKAPP_H
+
+// Qserv headers
+#include "replica/Application.h"
+
+// This header declarations
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+/**
+ * Class PackApp implements a tool which converts the chunk tables of
+ * a finalized database into the packed read-only format at all workers
+ * having complete replicas of the chunks.
+ */
+class PackApp: public Application {
+
+public:
+
+    /// The pointer type for instances of the class
+    typedef std::shared_ptr<PackApp> Ptr;
+
+    /**
+     * The factory method is the only way of creating objects of this class
+     * because of the very base class's inheritance from 'enable_shared_from_this'.
+     *
+     * @param argc
+     *   the number of command-line arguments
+     *
+     * @param argv
+     *   the vector of command-line arguments
+     */
+    static Ptr create(int argc, char* argv[]);
+
+    // Default construction and copy semantics are prohibited
+
+    PackApp()=delete;
+    PackApp(PackApp const&)=delete;
+    PackApp& operator=(PackApp const&)=delete;
+
+    ~PackApp() override=default;
+
+protected:
+
+    /**
+     * @see PackApp::create()
+     */
+    PackApp(int argc, char* argv[]);
+
+    /**
+     * @see Application::runImpl()
+     */
+    int runImpl() final;
+
+private:
+
+    /// The name of a database
+    std::string _database;
+};
+
+}}} // namespace lsst::qserv::replica
+
+#endif /* LSST_QSERV_REPLICA_PACKAPP_H */
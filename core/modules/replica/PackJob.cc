@@ -0,0 +1,312 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "replica/PackJob.h"
+
+// System headers
+#include <algorithm>
+#include <stdexcept>
+
+// Qserv headers
+#include "lsst/log/Log.h"
+#include "replica/Configuration.h"
+#include "replica/ServiceProvider.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.replica.PackJob");
+
+namespace replica = lsst::qserv::replica;
+
+/// @return 'true' if all files of the replica are in the packed format
+bool isPacked(replica::ReplicaInfo const& info) {
+    auto const& files = info.fileInfo();
+    return not files.empty() and
+           std::all_of(files.begin(), files.end(),
+                       [] (replica::ReplicaInfo::FileInfo const& file) { return file.packed; });
+}
+
+} /// namespace
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+Job::Options const& PackJob::defaultOptions() {
+    static Job::Options const options{
+        -1,     /* priority */
+        false,  /* exclusive */
+        true    /* preemptable */
+    };
+    return options;
+}
+
+std::string PackJob::typeName() { return "PackJob"; }
+
+PackJob::Ptr PackJob::create(std::string const& database,
+                             Controller::Ptr const& controller,
+                             std::string const& parentJobId,
+                             CallbackType const& onFinish,
+                             Job::Options const& options) {
+    return PackJob::Ptr(
+        new PackJob(database,
+                    controller,
+                    parentJobId,
+                    onFinish,
+                    options));
+}
+
+PackJob::PackJob(std::string const& database,
+                 Controller::Ptr const& controller,
+                 std::string const& parentJobId,
+                 CallbackType const& onFinish,
+                 Job::Options const& options)
+    :   Job(controller,
+            parentJobId,
+            "PACK",
+            options),
+        _database(database),
+        _onFinish(onFinish),
+        _numLaunched(0),
+        _numFinished(0),
+        _numSuccess(0) {
+
+    controller->serviceProvider()->assertDatabaseIsValid(database);
+}
+
+PackJobResult const& PackJob::getResultData() const {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "getResultData");
+
+    if (state() == State::FINISHED) return _resultData;
+
+    throw std::logic_error(
+        "PackJob::getResultData  the method can't be called while the job hasn't finished");
+}
+
+std::list<std::pair<std::string,std::string>> PackJob::extendedPersistentState() const {
+    std::list<std::pair<std::string,std::string>> result;
+    result.emplace_back("database", database());
+    return result;
+}
+
+void PackJob::startImpl(util::Lock const& lock) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "startImpl");
+
+    // Launch the chained job to get chunk disposition. The replicas are
+    // taken from the workers themselves since the ones already packed are
+    // going to be skipped.
+
+    auto self = shared_from_base<PackJob>();
+
+    bool const saveReplicInfo = true;
+    bool const allWorkers = false;              // only consider enabled workers
+    bool const fromDirectory = false;
+
+    _findAllJob = FindAllJob::create(
+        controller()->serviceProvider()->config()->databaseInfo(database()).family,
+        saveReplicInfo,
+        allWorkers,
+        fromDirectory,
+        controller(),
+        id(),
+        [self] (FindAllJob::Ptr job) {
+            self->onPrecursorJobFinish();
+        }
+    );
+    _findAllJob->start();
+
+    setState(lock, State::IN_PROGRESS);
+}
+
+void PackJob::cancelImpl(util::Lock const& lock) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "cancelImpl");
+
+    if ((nullptr != _findAllJob) and (_findAllJob->state() != State::FINISHED)) {
+        _findAllJob->cancel();
+    }
+    _findAllJob = nullptr;
+
+    // The requests which haven't been launched yet won't be
+
+    controller()->fanOut()->cancel(id());
+
+    for (auto&& ptr: _requests) ptr->cancel();
+    _requests.clear();
+
+    _numLaunched = 0;
+    _numFinished = 0;
+    _numSuccess  = 0;
+}
+
+void PackJob::notify(util::Lock const& lock) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "notify");
+
+    notifyDefaultImpl<PackJob>(lock, _onFinish);
+}
+
+void PackJob::onPrecursorJobFinish() {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "onPrecursorJobFinish");
+
+    // IMPORTANT: the final state is required to be tested twice. The first time
+    // it's done in order to avoid deadlock on the "in-flight" requests reporting
+    // their completion while the job termination is in a progress. And the second
+    // test is made after acquiring the lock to recheck the state in case if it
+    // has transitioned while acquiring the lock.
+
+    if (state() == State::FINISHED) return;
+
+    util::Lock lock(_mtx, context() + "onPrecursorJobFinish");
+
+    if (state() == State::FINISHED) return;
+
+    if (_findAllJob->extendedState() != ExtendedState::SUCCESS) {
+        finish(lock, ExtendedState::FAILED);
+        return;
+    }
+
+    // Every complete replica of a chunk of the database which hasn't been
+    // packed yet gets a request. The requests are launched by the fan-out
+    // engine of the Controller as the limits on the number of requests
+    // in flight allow.
+
+    FindAllJobResult const& replicaData = _findAllJob->getReplicaData();
+
+    auto const self = shared_from_base<PackJob>();
+    auto const fanOut = controller()->fanOut();
+
+    for (auto&& chunkEntry: replicaData.complete) {
+        unsigned int const chunk = chunkEntry.first;
+
+        auto const databaseItr = chunkEntry.second.find(database());
+        if (databaseItr == chunkEntry.second.end()) continue;
+
+        for (auto&& worker: databaseItr->second) {
+
+            ReplicaInfo const& info =
+                replicaData.chunks.chunk(chunk).database(database()).worker(worker);
+            if (isPacked(info)) {
+                _resultData.replicas.push_back(info);
+                _resultData.chunks[chunk][worker] = info;
+                continue;
+            }
+            _resultData.workers[worker] = true;
+            fanOut->submit(
+                id(),
+                worker,
+                options(lock).priority,
+                [self, worker, chunk] (RequestFanOut::DoneType const& done) {
+                    self->launchRequest(worker, chunk, done);
+                }
+            );
+            _numLaunched++;
+        }
+    }
+
+    // Nothing to be packed
+
+    if (not _numLaunched) finish(lock, ExtendedState::SUCCESS);
+}
+
+void PackJob::launchRequest(std::string const& worker,
+                            unsigned int chunk,
+                            RequestFanOut::DoneType const& done) {
+
+    // The job may have finished while the request was waiting for its turn
+
+    if (state() == State::FINISHED) {
+        done();
+        return;
+    }
+
+    util::Lock lock(_mtx, context() + "launchRequest");
+
+    if (state() == State::FINISHED) {
+        done();
+        return;
+    }
+
+    auto const self = shared_from_base<PackJob>();
+
+    _requests.push_back(
+        controller()->pack(
+            worker,
+            database(),
+            chunk,
+            [self, done] (PackRequest::Ptr request) {
+                done();
+                self->onRequestFinish(request);
+            },
+            options(lock).priority,
+            true,   /* keepTracking*/
+            id()    /* jobId */
+        )
+    );
+}
+
+void PackJob::onRequestFinish(PackRequest::Ptr const& request) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context()
+         << "onRequestFinish  worker=" << request->worker()
+         << " chunk=" << request->chunk()
+         << " state=" << request->state2string());
+
+    // IMPORTANT: the final state is required to be tested twice. The first time
+    // it's done in order to avoid deadlock on the "in-flight" requests reporting
+    // their completion while the job termination is in a progress. And the second
+    // test is made after acquiring the lock to recheck the state in case if it
+    // has transitioned while acquiring the lock.
+
+    if (state() == State::FINISHED) return;
+
+    util::Lock lock(_mtx, context() + "onRequestFinish[" + request->id() + "]");
+
+    if (state() == State::FINISHED) return;
+
+    _numFinished++;
+    if (request->extendedState() == Request::ExtendedState::SUCCESS) {
+        _numSuccess++;
+        ReplicaInfo const& info = request->responseData();
+        _resultData.replicas.push_back(info);
+        _resultData.chunks[request->chunk()][request->worker()] = info;
+    } else {
+        _resultData.workers[request->worker()] = false;
+    }
+
+    LOGS(_log, LOG_LVL_DEBUG, context()
+         << "onRequestFinish  worker=" << request->worker()
+         << " _numLaunched=" << _numLaunched
+         << " _numFinished=" << _numFinished
+         << " _numSuccess=" << _numSuccess);
+
+    if (_numFinished == _numLaunched) {
+        finish(lock, _numSuccess == _numLaunched ? ExtendedState::SUCCESS
+                                                 : ExtendedState::FAILED);
+    }
+}
+
+}}} // namespace lsst::qserv::replica
@@ -0,0 +1,224 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_REPLICA_PACKJOB_H
+#define LSST_QSERV_REPLICA_PACKJOB_H
+
+// System headers
+#include <atomic>
+#include <functional>
+#include <list>
+#include <map>
+#include <string>
+
+// Qserv headers
+#include "replica/FindAllJob.h"
+#include "replica/Job.h"
+#include "replica/PackRequest.h"
+#include "replica/ReplicaInfo.h"
+#include "replica/RequestFanOut.h"
+
+// This header declarations
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+/**
+ * The structure PackJobResult represents a combined result received
+ * from worker services upon a completion of the job.
+ */
+struct PackJobResult {
+
+    /// Results reported by workers upon the successful completion
+    /// of the corresponding requests
+    std::list<ReplicaInfo> replicas;
+
+    /// Results grouped by: chunk number, worker
+    std::map<unsigned int,                  // chunk
+             std::map<std::string,          // worker
+                      ReplicaInfo>> chunks;
+
+    /// Per-worker flags indicating if all requests sent to the worker
+    /// succeeded.
+    std::map<std::string, bool> workers;
+};
+
+/**
+  * Class PackJob represents a tool which converts the chunk tables of
+  * a database into the packed (compressed, read-only) format of MyISAM
+  * once the database has been finalized and published. All complete replicas
+  * of the chunks of the database are packed, except the ones which already
+  * are. The replicas of the database which are incomplete are left as they are.
+  */
+class PackJob
+    :   public Job  {
+
+public:
+
+    /// The pointer type for instances of the class
+    typedef std::shared_ptr<PackJob> Ptr;
+
+    /// The function type for notifications on the completion of the request
+    typedef std::function<void(Ptr)> CallbackType;
+
+    /// @return default options object for this type of a request
+    static Job::Options const& defaultOptions();
+
+    /// @return the unique name distinguishing this class from other types of jobs
+    static std::string typeName();
+
+    /**
+     * Static factory method is needed to prevent issue with the lifespan
+     * and memory management of instances created otherwise (as values or via
+     * low-level pointers).
+     *
+     * @param database    - the name of a database
+     * @param controller  - for launching requests
+     * @param parentJobId - optional identifier of a parent job
+     * @param onFinish    - callback function to be called upon a completion of the job
+     * @param options     - job options
+     *
+     * @return pointer to the created object
+     */
+    static Ptr create(std::string const& database,
+                      Controller::Ptr const& controller,
+                      std::string const& parentJobId=std::string(),
+                      CallbackType const& onFinish=nullptr,
+                      Job::Options const& options=defaultOptions());
+
+    // Default construction and copy semantics are prohibited
+
+    PackJob() = delete;
+    PackJob(PackJob const&) = delete;
+    PackJob& operator=(PackJob const&) = delete;
+
+    ~PackJob() final = default;
+
+    /// @return the name of a database
+    std::string const& database() const { return _database; }
+
+    /**
+     * Return the result of the operation.
+     *
+     * IMPORTANT NOTES:
+     * - the method should be invoked only after the job has finished (primary
+     *   status is set to Job::Status::FINISHED). Otherwise exception
+     *   std::logic_error will be thrown
+     *
+     * - the result will be extracted from requests which have successfully
+     *   finished. Please, verify the primary and extended status of the object
+     *   to ensure that all requests have finished.
+     *
+     * @return the data structure to be filled upon the completion of the job.
+     *
+     * @throws std::logic_error - if the job isn't finished at the time
+     *                            when the method was called
+     */
+    PackJobResult const& getResultData() const;
+
+    /**
+     * @see Job::extendedPersistentState()
+     */
+    std::list<std::pair<std::string,std::string>> extendedPersistentState() const override;
+
+protected:
+
+    /**
+     * Construct the job with the pointer to the services provider.
+     *
+     * @see PackJob::create()
+     */
+    PackJob(std::string const& database,
+            Controller::Ptr const& controller,
+            std::string const& parentJobId,
+            CallbackType const& onFinish,
+            Job::Options const& options);
+
+    /**
+      * @see Job::startImpl()
+      */
+    void startImpl(util::Lock const& lock) final;
+
+    /**
+      * @see Job::startImpl()
+      */
+    void cancelImpl(util::Lock const& lock) final;
+
+    /**
+      * @see Job::notify()
+      */
+    void notify(util::Lock const& lock) final;
+
+    /**
+     * The callback function to be invoked on a completion of the precursor job
+     * which harvests info on replicas across the cluster.
+     */
+    void onPrecursorJobFinish();
+
+    /**
+     * Launch a request when the fan-out engine of the Controller allows.
+     *
+     * @param worker - the name of a worker
+     * @param chunk  - the number of a chunk to be packed
+     * @param done   - the function to be called when the request finishes
+     */
+    void launchRequest(std::string const& worker,
+                       unsigned int chunk,
+                       RequestFanOut::DoneType const& done);
+
+    /**
+     * The callback function to be invoked on a completion of each request.
+     *
+     * @param request - a pointer to a request
+     */
+    void onRequestFinish(PackRequest::Ptr const& request);
+
+protected:
+
+    /// The name of a database
+    std::string const _database;
+
+    /// Client-defined function to be called upon the completion of the job
+    CallbackType _onFinish;
+
+    /// The chained job to be completed first in order to figure out
+    /// replica disposition.
+    FindAllJob::Ptr _findAllJob;
+
+    /// A collection of the requests launched so far
+    std::list<PackRequest::Ptr> _requests;
+
+    // The counter of requests which will be updated. They need to be atomic
+    // to avoid race condition between the onFinish() callbacks executed within
+    // the Controller's thread and this thread.
+
+    std::atomic<size_t> _numLaunched;   ///< the total number of requests launched
+    std::atomic<size_t> _numFinished;   ///< the total number of finished requests
+    std::atomic<size_t> _numSuccess;    ///< the number of successfully completed requests
+
+    /// The result of the operation (gets updated as requests are finishing)
+    PackJobResult _resultData;
+};
+
+}}} // namespace lsst::qserv::replica
+
+#endif // LSST_QSERV_REPLICA_PACKJOB_H
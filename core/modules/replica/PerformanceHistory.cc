@@ -0,0 +1,185 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "replica/PerformanceHistory.h"
+
+// System headers
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <stdexcept>
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+size_t const PerformanceHistory::minSamples     = 10;
+size_t const PerformanceHistory::minWorkers     = 3;
+double const PerformanceHistory::slownessFactor = 3.0;
+
+void PerformanceHistory::Histogram::add(uint64_t valueMs) {
+    size_t const bucket = static_cast<size_t>(4 * std::log2(static_cast<double>(valueMs) + 1));
+    ++counts[std::min(bucket, numBuckets - 1)];
+    ++total;
+}
+
+void PerformanceHistory::Histogram::merge(Histogram const& other) {
+    for (size_t i = 0; i < numBuckets; ++i) counts[i] += other.counts[i];
+    total += other.total;
+}
+
+uint64_t PerformanceHistory::Histogram::percentile(double fraction) const {
+    if (0 == total) return 0;
+    uint64_t const rank = static_cast<uint64_t>(std::ceil(fraction * total));
+    uint64_t sum = 0;
+    size_t bucket = 0;
+    for (; bucket < numBuckets - 1; ++bucket) {
+        sum += counts[bucket];
+        if (sum >= rank) break;
+    }
+    return static_cast<uint64_t>(std::ceil(std::pow(2., (bucket + 1) / 4.))) - 1;
+}
+
+PerformanceHistory::Ptr PerformanceHistory::create(unsigned int intervalSec,
+                                                   size_t numIntervals) {
+    return Ptr(new PerformanceHistory(intervalSec, numIntervals));
+}
+
+PerformanceHistory::PerformanceHistory(unsigned int intervalSec,
+                                       size_t numIntervals)
+    :   _intervalSec(intervalSec),
+        _numIntervals(numIntervals) {
+
+    if (0 == intervalSec or 0 == numIntervals) {
+        throw std::invalid_argument("PerformanceHistory::" + std::string(__func__) +
+                                    "  the interval and the number of intervals can't be 0");
+    }
+}
+
+void PerformanceHistory::record(std::string const& type,
+                                std::string const& worker,
+                                Performance const& performance,
+                                bool success) {
+
+    if (0 == performance.c_start_time) return;
+
+    uint64_t const now = PerformanceUtils::now();
+    uint64_t const interval = now / 1000 / _intervalSec;
+
+    util::Lock lock(_mtx, context() + "record");
+
+    auto& slots = _slots[Key(type, worker)];
+    if (slots.empty()) slots.resize(_numIntervals);
+
+    Slot& slot = slots[interval % _numIntervals];
+    if (slot.interval != interval) {
+        slot = Slot();
+        slot.interval = interval;
+    }
+    if (success) ++slot.numSuccess;
+    else         ++slot.numFailed;
+
+    uint64_t const finishTime = performance.c_finish_time ? performance.c_finish_time : now;
+    slot.latency.add(finishTime - std::min(finishTime, performance.c_start_time));
+
+    if (performance.w_start_time and performance.w_finish_time >= performance.w_start_time) {
+        slot.execution.add(performance.w_finish_time - performance.w_start_time);
+    }
+}
+
+std::vector<PerformanceHistory::Summary> PerformanceHistory::summaries() const {
+    util::Lock lock(_mtx, context() + "summaries");
+    return summaries(lock);
+}
+
+std::vector<std::string> PerformanceHistory::slowWorkers() const {
+
+    util::Lock lock(_mtx, context() + "slowWorkers");
+
+    std::set<std::string> workers;
+    for (auto&& summary: summaries(lock)) {
+        if (summary.slow) workers.insert(summary.worker);
+    }
+    return std::vector<std::string>(workers.begin(), workers.end());
+}
+
+std::vector<PerformanceHistory::Summary> PerformanceHistory::summaries(util::Lock const& lock) const {
+
+    uint64_t const last = PerformanceUtils::now() / 1000 / _intervalSec;
+    uint64_t const first = last + 1 - std::min<uint64_t>(last + 1, _numIntervals);
+
+    std::vector<Summary> result;
+    std::map<std::string, std::vector<uint64_t>> type2p90;
+
+    for (auto&& entry: _slots) {
+
+        Summary summary;
+        summary.type   = entry.first.first;
+        summary.worker = entry.first.second;
+
+        Histogram latency;
+        Histogram execution;
+        for (uint64_t interval = first; interval <= last; ++interval) {
+            Slot const& slot = entry.second[interval % _numIntervals];
+            if (slot.interval != interval) {
+                summary.numPerInterval.push_back(0);
+                continue;
+            }
+            summary.numSuccess += slot.numSuccess;
+            summary.numFailed  += slot.numFailed;
+            summary.numPerInterval.push_back(slot.numSuccess + slot.numFailed);
+            latency.merge(slot.latency);
+            execution.merge(slot.execution);
+        }
+        if (0 == latency.total) continue;
+
+        summary.p50Ms = latency.percentile(0.5);
+        summary.p90Ms = latency.percentile(0.9);
+        summary.p99Ms = latency.percentile(0.99);
+        summary.workerP90Ms = execution.percentile(0.9);
+
+        if (latency.total >= minSamples) type2p90[summary.type].push_back(summary.p90Ms);
+
+        result.push_back(summary);
+    }
+
+    // Compare the workers with enough requests of each type against
+    // the median of their latencies
+
+    std::map<std::string, uint64_t> type2median;
+    for (auto&& entry: type2p90) {
+        auto& p90s = entry.second;
+        if (p90s.size() < minWorkers) continue;
+        std::nth_element(p90s.begin(), p90s.begin() + p90s.size() / 2, p90s.end());
+        type2median[entry.first] = std::max<uint64_t>(1, p90s[p90s.size() / 2]);
+    }
+    for (auto&& summary: result) {
+        auto const itr = type2median.find(summary.type);
+        if (itr == type2median.end()) continue;
+        if (summary.numSuccess + summary.numFailed < minSamples) continue;
+        summary.slow = summary.p90Ms > slownessFactor * itr->second;
+    }
+    return result;
+}
+
+}}} // namespace lsst::qserv::replica
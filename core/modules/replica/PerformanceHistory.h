@@ -0,0 +1,203 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_REPLICA_PERFORMANCEHISTORY_H
+#define LSST_QSERV_REPLICA_PERFORMANCEHISTORY_H
+
+// System headers
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Qserv headers
+#include "replica/Performance.h"
+#include "util/Mutex.h"
+
+// This header declarations
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+/**
+ * Class PerformanceHistory aggregates the performance counters of the finished
+ * requests into rolling latency histograms for each type of request and each
+ * worker. The histograms cover a fixed number of the most recent intervals,
+ * from which the percentiles of the latencies and the number of requests in
+ * each interval are reported.
+ *
+ * A worker is considered slow if the 90th percentile of the latencies of
+ * the requests of some type exceeds the median of those of all workers
+ * by the factor slownessFactor.
+ */
+class PerformanceHistory {
+
+public:
+
+    /// The pointer type for instances of the class
+    typedef std::shared_ptr<PerformanceHistory> Ptr;
+
+    /// The number of requests needed for the latencies of a worker to be judged
+    static size_t const minSamples;
+
+    /// The number of workers needed for their median latency to be meaningful
+    static size_t const minWorkers;
+
+    /// The ratio to the median latency above which a worker is considered slow
+    static double const slownessFactor;
+
+    /**
+     * Structure Summary represents the performance of the requests of one type
+     * sent to one worker over the intervals covered by the history.
+     */
+    struct Summary {
+
+        std::string type;
+        std::string worker;
+
+        uint64_t numSuccess = 0;
+        uint64_t numFailed  = 0;
+
+        // The percentiles of the latencies (milliseconds) seen by the Controller,
+        // from the start of the requests till their completion
+
+        uint64_t p50Ms = 0;
+        uint64_t p90Ms = 0;
+        uint64_t p99Ms = 0;
+
+        /// The 90th percentile of the execution times (milliseconds) at the worker
+        uint64_t workerP90Ms = 0;
+
+        /// The number of requests finished in each interval (the oldest first)
+        std::vector<uint64_t> numPerInterval;
+
+        /// 'true' if the worker is considered slow for this type of requests
+        bool slow = false;
+    };
+
+    /**
+     * The factory method for instances of the class
+     *
+     * @param intervalSec  - the length (seconds) of an interval
+     * @param numIntervals - the number of intervals covered by the history
+     *
+     * @return pointer to the new object
+     *
+     * @throws std::invalid_argument - if any parameter is 0
+     */
+    static Ptr create(unsigned int intervalSec=60,
+                      size_t numIntervals=15);
+
+    // Default construction and copy semantics are prohibited
+
+    PerformanceHistory() = delete;
+    PerformanceHistory(PerformanceHistory const&) = delete;
+    PerformanceHistory& operator=(PerformanceHistory const&) = delete;
+
+    ~PerformanceHistory() = default;
+
+    /**
+     * Record a finished request. The requests which were never started
+     * are ignored.
+     *
+     * @param type        - the type of the request
+     * @param worker      - the name of the worker
+     * @param performance - the performance counters of the request
+     * @param success     - 'true' if the request succeeded
+     */
+    void record(std::string const& type,
+                std::string const& worker,
+                Performance const& performance,
+                bool success);
+
+    /// @return the summaries for all types of requests and workers seen
+    std::vector<Summary> summaries() const;
+
+    /// @return the names of the workers considered slow for any type of requests
+    std::vector<std::string> slowWorkers() const;
+
+private:
+
+    /// The number of buckets of a histogram
+    static size_t const numBuckets = 128;
+
+    /**
+     * Structure Histogram counts the values in the buckets of exponentially
+     * growing width. There are four buckets for each power of 2.
+     */
+    struct Histogram {
+
+        std::array<uint32_t, numBuckets> counts{};
+        uint64_t total = 0;
+
+        void add(uint64_t valueMs);
+        void merge(Histogram const& other);
+
+        /// @return the upper bound of the bucket where the percentile falls
+        uint64_t percentile(double fraction) const;
+    };
+
+    /// The requests finished in one interval
+    struct Slot {
+        uint64_t  interval = 0;
+        uint64_t  numSuccess = 0;
+        uint64_t  numFailed  = 0;
+        Histogram latency;
+        Histogram execution;
+    };
+
+    /// (type, worker)
+    typedef std::pair<std::string, std::string> Key;
+
+    /// @see PerformanceHistory::create()
+    PerformanceHistory(unsigned int intervalSec,
+                       size_t numIntervals);
+
+    /**
+     * Compute the summaries and mark the slow workers
+     *
+     * @param lock - a lock on a mutex must be acquired before calling this method
+     */
+    std::vector<Summary> summaries(util::Lock const& lock) const;
+
+    /// @return the context string for debugging and diagnostic printouts
+    std::string context() const { return "PERFORMANCE-HISTORY  "; }
+
+private:
+
+    unsigned int const _intervalSec;
+    size_t const _numIntervals;
+
+    /// The slots of the intervals (by type and worker), each indexed by
+    /// the interval number modulo the number of intervals
+    std::map<Key, std::vector<Slot>> _slots;
+
+    /// Protects the slots
+    mutable util::Mutex _mtx;
+};
+
+}}} // namespace lsst::qserv::replica
+
+#endif // LSST_QSERV_REPLICA_PERFORMANCEHISTORY_H
@@ -40,6 +40,9 @@ namespace {
 
 LOG_LOGGER _log = LOG_GET("lsst.qserv.replica.PurgeJob");
 
+/// The maximum number of chunks deleted from a worker by one child job
+size_t const maxChunksPerJob = 64;
+
 } /// namespace
 
 namespace lsst {
@@ -137,10 +140,13 @@ void PurgeJob::startImpl(util::Lock const& lock) {
     bool const saveReplicInfo = true;           // always save the replica info in a database because
                                                 // the algorithm depends on it.
     bool const allWorkers = false;              // only consider enabled workers
+    bool const fromDirectory = true;            // plan from the replicas known to the Controller
+                                                // if they're recent enough
     _findAllJob = FindAllJob::create(
         _databaseFamily,
         saveReplicInfo,
         allWorkers,
+        fromDirectory,
         controller(),
         id(),
         [self] (FindAllJob::Ptr job) {
@@ -283,10 +289,10 @@ void PurgeJob::onPrecursorJobFinish() {
     std::map<std::string, size_t> worker2occupancy;
 
     for (auto chunk: replicaData.chunks.chunkNumbers()) {
-        auto chunkMap = replicaData.chunks.chunk(chunk);
+        auto const& chunkMap = replicaData.chunks.chunk(chunk);
 
         for (auto&& database: chunkMap.databaseNames()) {
-            auto databaseMap = chunkMap.database(database);
+            auto const& databaseMap = chunkMap.database(database);
 
             for (auto&& worker: databaseMap.workerNames()) {
                 worker2occupancy[worker]++;
@@ -305,6 +311,11 @@ void PurgeJob::onPrecursorJobFinish() {
 
     auto self = shared_from_base<PurgeJob>();
 
+    // The chunks to be deleted from each worker. The deletions are batched
+    // into jobs removing many chunks at once after the plan is made.
+
+    std::map<std::string, std::vector<unsigned int>> worker2chunks;
+
     for (auto&& chunk2replicas: chunk2numReplicas2delete) {
 
         unsigned int const chunk              = chunk2replicas.first;
@@ -370,26 +381,10 @@ void PurgeJob::onPrecursorJobFinish() {
 
             goodWorkersOfThisChunk.remove(targetWorker);
 
-            // Finally, launch and register for further tracking deletion
-            // a job which will affect all participating databases
-
-            auto ptr = DeleteReplicaJob::create(
-                databaseFamily(),
-                chunk,
-                targetWorker,
-                controller(),
-                id(),
-                [self] (DeleteReplicaJob::Ptr const& job) {
-                    self->onDeleteJobFinish(job);
-                },
-                options(lock)   // inherit from the current job
-            );
-            ptr->start();
-
-            _chunk2jobs[chunk][targetWorker] = ptr;
-            _jobs.push_back(ptr);
+            // Finally, schedule the deletion which will affect all participating
+            // databases
 
-            _numLaunched++;
+            worker2chunks[targetWorker].push_back(chunk);
 
             // Reduce the worker occupancy count by the number of databases participating
             // in the replica of the chunk, so that it will be taken into
@@ -401,6 +396,39 @@ void PurgeJob::onPrecursorJobFinish() {
     }
     if (state() != State::FINISHED) {
 
+        // Launch and register for further tracking the deletion jobs
+
+        for (auto&& entry: worker2chunks) {
+            std::string const& worker = entry.first;
+            auto const& chunks = entry.second;
+
+            for (size_t begin = 0; begin < chunks.size(); begin += ::maxChunksPerJob) {
+                std::vector<unsigned int> const batch(
+                    chunks.begin() + begin,
+                    chunks.begin() + std::min(begin + ::maxChunksPerJob, chunks.size()));
+
+                auto ptr = DeleteReplicaJob::create(
+                    databaseFamily(),
+                    batch,
+                    worker,
+                    controller(),
+                    id(),
+                    [self] (DeleteReplicaJob::Ptr const& job) {
+                        self->onDeleteJobFinish(job);
+                    },
+                    options(lock)   // inherit from the current job
+                );
+                for (auto chunk: batch) {
+                    _chunk2jobs[chunk][worker] = ptr;
+                }
+                _jobs.push_back(ptr);
+                _numLaunched++;
+            }
+        }
+        for (auto&& ptr: _jobs) {
+            ptr->start();
+        }
+
         // ATTENTION: if the job submission algorithm didn't launch any
         // child jobs while leaving this object in the unfinished state
         // then we must evaluate reasons and take proper actions. Otherwise
@@ -431,7 +459,8 @@ void PurgeJob::onDeleteJobFinish(DeleteReplicaJob::Ptr const& job) {
          << "onDeleteJobFinish"
          << "  databaseFamily=" << job->databaseFamily()
          << "  worker="         << job->worker()
-         << "  chunk="          << job->chunk());
+         << "  chunk="          << job->chunk()
+         << "  numChunks="      << job->chunks().size());
 
     // IMPORTANT: the final state is required to be tested twice. The first time
     // it's done in order to avoid deadlock on the "in-flight" requests reporting
@@ -440,14 +469,14 @@ void PurgeJob::onDeleteJobFinish(DeleteReplicaJob::Ptr const& job) {
     // has transitioned while acquiring the lock.
 
     if (state() == State::FINISHED) {
-        release(job->chunk());
+        for (auto chunk: job->chunks()) release(chunk);
         return;
     }
 
     util::Lock lock(_mtx, context() + "onDeleteJobFinish");
 
     if (state() == State::FINISHED) {
-        release(job->chunk());
+        for (auto chunk: job->chunks()) release(chunk);
         return;
     }
 
@@ -470,23 +499,28 @@ void PurgeJob::onDeleteJobFinish(DeleteReplicaJob::Ptr const& job) {
 
         // Merge the replica info into the dictionary
 
-        for (auto&& databaseEntry: jobReplicaData.chunks.at(job->chunk())) {
-            std::string const& database = databaseEntry.first;
-            _replicaData.chunks[job->chunk()][database][job->worker()] =
-                jobReplicaData.chunks.at(job->chunk()).at(database).at(job->worker());
+        for (auto&& chunkEntry: jobReplicaData.chunks) {
+            unsigned int const chunk = chunkEntry.first;
+            for (auto&& databaseEntry: chunkEntry.second) {
+                std::string const& database = databaseEntry.first;
+                _replicaData.chunks[chunk][database][job->worker()] =
+                    databaseEntry.second.at(job->worker());
+            }
         }
         _replicaData.workers[job->worker()] = true;
     } else {
         _replicaData.workers[job->worker()] = false;
     }
 
-    // Make sure the chunk is released if this was the last
-    // job in its scope.
+    // Make sure the chunks are released if this was the last
+    // job in their scope.
 
-    _chunk2jobs.at(job->chunk()).erase(job->worker());
-    if (_chunk2jobs.at(job->chunk()).empty()) {
-        _chunk2jobs.erase(job->chunk());
-        release(job->chunk());
+    for (auto chunk: job->chunks()) {
+        _chunk2jobs.at(chunk).erase(job->worker());
+        if (_chunk2jobs.at(chunk).empty()) {
+            _chunk2jobs.erase(chunk);
+            release(chunk);
+        }
     }
 
     // Evaluate the status of on-going operations to see if the job
@@ -105,6 +105,10 @@ public:
         /// server-side error.
         SERVER_ERROR,
 
+        /// Server reports that the request was made against a state of
+        /// the remote resources which has changed since.
+        SERVER_STALE,
+
         /// Expired due to a timeout (as per the Configuration)
         TIMEOUT_EXPIRED,
 
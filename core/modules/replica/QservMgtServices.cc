@@ -266,6 +266,56 @@ GetReplicasQservMgtRequest::Ptr QservMgtServices::getReplicas(
 }
 
 
+GetChunkStatsQservMgtRequest::Ptr QservMgtServices::getChunkStats(
+                                        std::string const& worker,
+                                        std::vector<std::string> const& databases,
+                                        uint64_t updatedAfter,
+                                        std::string const& jobId,
+                                        GetChunkStatsQservMgtRequest::CallbackType const& onFinish,
+                                        unsigned int requestExpirationIvalSec) {
+
+    GetChunkStatsQservMgtRequest::Ptr request;
+
+    // Make sure the XROOTD/SSI service is available before attempting
+    // any operations on requests
+
+    XrdSsiService* service = xrdSsiService();
+    if (not service) {
+        return request;
+    } else {
+
+        util::Lock lock(_mtx, "QservMgtServices::getChunkStats");
+
+        auto const manager = shared_from_this();
+
+        request = GetChunkStatsQservMgtRequest::create(
+            serviceProvider(),
+            worker,
+            databases,
+            updatedAfter,
+            [manager] (QservMgtRequest::Ptr const& request) {
+                manager->finish(request->id());
+            }
+        );
+
+        // Register the request (along with its callback) by its unique
+        // identifier in the local registry. Once it's complete it'll
+        // be automatically removed from the Registry.
+        _registry[request->id()] =
+            std::make_shared<QservMgtRequestWrapperImpl<GetChunkStatsQservMgtRequest>>(
+                request, onFinish);
+    }
+
+    // Initiate the request in the lock-free zone to avoid blocking the service
+    // from initiating other requests which this one is starting.
+    request->start(service,
+                   jobId,
+                   requestExpirationIvalSec);
+
+    return request;
+}
+
+
 SetReplicasQservMgtRequest::Ptr QservMgtServices::setReplicas(
                                         std::string const& worker,
                                         QservReplicaCollection const& newReplicas,
@@ -315,6 +365,59 @@ SetReplicasQservMgtRequest::Ptr QservMgtServices::setReplicas(
     return request;
 }
 
+SetReplicasQservMgtRequest::Ptr QservMgtServices::setReplicasDiff(
+                                        std::string const& worker,
+                                        QservReplicaCollection const& addedReplicas,
+                                        QservReplicaCollection const& removedReplicas,
+                                        std::uint64_t baseRevision,
+                                        bool force,
+                                        std::string const& jobId,
+                                        SetReplicasQservMgtRequest::CallbackType const& onFinish,
+                                        unsigned int requestExpirationIvalSec) {
+
+    SetReplicasQservMgtRequest::Ptr request;
+
+    // Make sure the XROOTD/SSI service is available before attempting
+    // any operations on requests
+
+    XrdSsiService* service = xrdSsiService();
+    if (not service) {
+        return request;
+    } else {
+
+        util::Lock lock(_mtx, "QservMgtServices::setReplicasDiff");
+    
+        auto const manager = shared_from_this();
+    
+        request = SetReplicasQservMgtRequest::createDiff(
+            serviceProvider(),
+            worker,
+            addedReplicas,
+            removedReplicas,
+            baseRevision,
+            force,
+            [manager] (QservMgtRequest::Ptr const& request) {
+                manager->finish(request->id());
+            }
+        );
+    
+        // Register the request (along with its callback) by its unique
+        // identifier in the local registry. Once it's complete it'll
+        // be automatically removed from the Registry.
+        _registry[request->id()] =
+            std::make_shared<QservMgtRequestWrapperImpl<SetReplicasQservMgtRequest>>(
+                request, onFinish);
+    }
+
+    // Initiate the request in the lock-free zone to avoid blocking the service
+    // from initiating other requests which this one is starting.
+    request->start(service,
+                   jobId,
+                   requestExpirationIvalSec);
+
+    return request;
+}
+
 TestEchoQservMgtRequest::Ptr QservMgtServices::echo(
                                     std::string const& worker,
                                     std::string const& data,
@@ -29,6 +29,7 @@
 
 // Qserv headers
 #include "replica/AddReplicaQservMgtRequest.h"
+#include "replica/GetChunkStatsQservMgtRequest.h"
 #include "replica/GetReplicasQservMgtRequest.h"
 #include "replica/RemoveReplicaQservMgtRequest.h"
 #include "replica/ServiceProvider.h"
@@ -179,6 +180,32 @@ public:
 
 
 
+    /**
+     * Fetch the sizes of the chunk tables of a Qserv worker and the completion
+     * times of the tasks which scanned them
+     *
+     * @param worker          - the name of a worker
+     * @param databases       - the databases of the tables
+     * @param updatedAfter    - only report the sizes of the tables modified at or
+     *                          after this time (seconds), of all tables if 0
+     * @param jobId           - an optional identifier of a job specifying a context
+     *                          in which a request will be executed.
+     * @param onFinish        - callback function to be called upon request completion
+     * @param requestExpirationIvalSec - an optional parameter (if differs from 0)
+     *                          allowing to override the default value of
+     *                          the corresponding parameter from the Configuration.
+     *
+     * @return pointer to the request object if the request was made. Return
+     *         nullptr otherwise.
+     */
+    GetChunkStatsQservMgtRequest::Ptr getChunkStats(
+                                            std::string const& worker,
+                                            std::vector<std::string> const& databases,
+                                            uint64_t updatedAfter = 0,
+                                            std::string const& jobId="",
+                                            GetChunkStatsQservMgtRequest::CallbackType const& onFinish = nullptr,
+                                            unsigned int requestExpirationIvalSec=0);
+
     /**
      * Enable a collection of replicas at a Qserv worker
      *
@@ -204,6 +231,36 @@ public:
                                             SetReplicasQservMgtRequest::CallbackType const& onFinish = nullptr,
                                             unsigned int requestExpirationIvalSec=0);
 
+    /**
+     * Add and remove replicas at a Qserv worker, provided the worker's
+     * inventory is still at the revision the diff was made against.
+     *
+     * @param worker          - the name of a worker
+     * @param addedReplicas   - collection of replicas to be added (NOTE: useCount field is ignored)
+     * @param removedReplicas - collection of replicas to be removed (NOTE: useCount field is ignored)
+     * @param baseRevision    - revision of the worker's inventory the diff was made against
+     * @param force           - proceed with the operation even if some replicas affected by
+     *                          the operation are in use.
+     * @param onFinish        - callback function to be called upon request completion
+     * @param jobId           - an optional identifier of a job specifying a context
+     *                          in which a request will be executed.
+     * @param requestExpirationIvalSec - an optional parameter (if differs from 0)
+     *                          allowing to override the default value of
+     *                          the corresponding parameter from the Configuration.
+     *
+     * @return pointer to the request object if the request was made. Return
+     *         nullptr otherwise.
+     */
+    SetReplicasQservMgtRequest::Ptr setReplicasDiff(
+                                            std::string const& worker,
+                                            QservReplicaCollection const& addedReplicas,
+                                            QservReplicaCollection const& removedReplicas,
+                                            std::uint64_t baseRevision,
+                                            bool force = false,
+                                            std::string const& jobId="",
+                                            SetReplicasQservMgtRequest::CallbackType const& onFinish = nullptr,
+                                            unsigned int requestExpirationIvalSec=0);
+
     /**
      * Send a data string to a Qserv worker and get the same string in response
      *
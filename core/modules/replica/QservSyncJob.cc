@@ -25,7 +25,9 @@
 
 // System headers
 #include <future>
+#include <set>
 #include <stdexcept>
+#include <utility>
 
 // Qserv headers
 #include "lsst/log/Log.h"
@@ -45,6 +47,9 @@ namespace lsst {
 namespace qserv {
 namespace replica {
 
+std::map<std::string, QservSyncJob::WorkerInventory> QservSyncJob::_workerInventories;
+util::Mutex QservSyncJob::_workerInventoriesMtx;
+
 Job::Options const& QservSyncJob::defaultOptions() {
     static Job::Options const options{
         2,      /* priority */
@@ -118,8 +123,6 @@ void QservSyncJob::startImpl(util::Lock const& lock) {
 
     auto const databases        = controller()->serviceProvider()->config()->databases(databaseFamily());
     auto const databaseServices = controller()->serviceProvider()->databaseServices();
-    auto const qservMgtServices = controller()->serviceProvider()->qservMgtServices();
-    auto const self             = shared_from_base<QservSyncJob>();
 
     for (auto&& worker: controller()->serviceProvider()->config()->workers()) {
 
@@ -160,18 +163,8 @@ void QservSyncJob::startImpl(util::Lock const& lock) {
 
         // Submit a request to the worker
 
-        _requests.push_back(
-            qservMgtServices->setReplicas(
-                worker,
-                newReplicas,
-                force(),
-                id(),   /* jobId */
-                [self] (SetReplicasQservMgtRequest::Ptr const& request) {
-                    self->onRequestFinish(request);
-                },
-                _requestExpirationIvalSec
-            )
-        );
+        _newReplicas[worker] = std::move(newReplicas);
+        launch(lock, worker);
         _numLaunched++;
     }
 
@@ -220,16 +213,41 @@ void QservSyncJob::onRequestFinish(SetReplicasQservMgtRequest::Ptr const& reques
 
     if (state() == State::FINISHED) return;
 
+    std::string const& worker = request->worker();
+
+    // The worker's inventory has changed since the diff was made. Push
+    // the whole collection to the worker instead.
+
+    if (request->extendedState() == QservMgtRequest::ExtendedState::SERVER_STALE) {
+
+        LOGS(_log, LOG_LVL_DEBUG, context()
+             << "onRequestFinish  worker=" << worker
+             << " has changed since revision " << request->baseRevision()
+             << ", current revision: " << request->revision());
+        {
+            util::Lock inventoriesLock(_workerInventoriesMtx, context() + "onRequestFinish");
+            _workerInventories.erase(worker);
+        }
+        launch(lock, worker);
+        return;
+    }
+
     // Update counters and object state if needed.
 
     _numFinished++;
     if (request->extendedState() == QservMgtRequest::ExtendedState::SUCCESS) {
         _numSuccess++;
-        _replicaData.prevReplicas[request->worker()] = request->replicas();
-        _replicaData.newReplicas [request->worker()] = request->newReplicas();
-        _replicaData.workers     [request->worker()] = true;
+        _replicaData.prevReplicas[worker] = request->diff() ? _baseReplicas[worker] : request->replicas();
+        _replicaData.newReplicas [worker] = _newReplicas[worker];
+        _replicaData.workers     [worker] = true;
+
+        util::Lock inventoriesLock(_workerInventoriesMtx, context() + "onRequestFinish");
+        _workerInventories[worker] = WorkerInventory{request->revision(), _newReplicas[worker]};
     } else {
-        _replicaData.workers     [request->worker()] = false;
+        _replicaData.workers     [worker] = false;
+
+        util::Lock inventoriesLock(_workerInventoriesMtx, context() + "onRequestFinish");
+        _workerInventories.erase(worker);
     }
 
     LOGS(_log, LOG_LVL_DEBUG, context()
@@ -244,4 +262,80 @@ void QservSyncJob::onRequestFinish(SetReplicasQservMgtRequest::Ptr const& reques
     }
 }
 
+void QservSyncJob::launch(util::Lock const& lock,
+                          std::string const& worker) {
+
+    auto const qservMgtServices = controller()->serviceProvider()->qservMgtServices();
+    auto const self             = shared_from_base<QservSyncJob>();
+    auto const onFinish = [self] (SetReplicasQservMgtRequest::Ptr const& request) {
+        self->onRequestFinish(request);
+    };
+    QservReplicaCollection const& newReplicas = _newReplicas[worker];
+
+    bool acknowledged = false;
+    WorkerInventory inventory;
+    {
+        util::Lock inventoriesLock(_workerInventoriesMtx, context() + "launch");
+        auto const itr = _workerInventories.find(worker);
+        if (itr != _workerInventories.end()) {
+            inventory = itr->second;
+            acknowledged = true;
+        }
+    }
+    if (not acknowledged) {
+        _baseReplicas.erase(worker);
+        _requests.push_back(
+            qservMgtServices->setReplicas(
+                worker,
+                newReplicas,
+                force(),
+                id(),   /* jobId */
+                onFinish,
+                _requestExpirationIvalSec
+            )
+        );
+        return;
+    }
+
+    // Compare the new collection with the acknowledged one
+
+    std::set<std::pair<std::string, unsigned int>> prevSet;
+    for (auto&& replica: inventory.replicas) prevSet.emplace(replica.database, replica.chunk);
+
+    std::set<std::pair<std::string, unsigned int>> newSet;
+    QservReplicaCollection addedReplicas;
+    for (auto&& replica: newReplicas) {
+        newSet.emplace(replica.database, replica.chunk);
+        if (not prevSet.count(std::make_pair(replica.database, replica.chunk))) {
+            addedReplicas.push_back(replica);
+        }
+    }
+    QservReplicaCollection removedReplicas;
+    for (auto&& replica: inventory.replicas) {
+        if (not newSet.count(std::make_pair(replica.database, replica.chunk))) {
+            removedReplicas.push_back(replica);
+        }
+    }
+
+    LOGS(_log, LOG_LVL_DEBUG, context()
+         << "launch  worker=" << worker
+         << " revision=" << inventory.revision
+         << " added=" << addedReplicas.size()
+         << " removed=" << removedReplicas.size());
+
+    _baseReplicas[worker] = std::move(inventory.replicas);
+    _requests.push_back(
+        qservMgtServices->setReplicasDiff(
+            worker,
+            addedReplicas,
+            removedReplicas,
+            inventory.revision,
+            force(),
+            id(),   /* jobId */
+            onFinish,
+            _requestExpirationIvalSec
+        )
+    );
+}
+
 }}} // namespace lsst::qserv::replica
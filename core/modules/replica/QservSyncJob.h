@@ -24,6 +24,7 @@
 
 // System headers
 #include <atomic>
+#include <cstdint>
 #include <functional>
 #include <list>
 #include <map>
@@ -32,6 +33,7 @@
 // Qserv headers
 #include "replica/Job.h"
 #include "replica/SetReplicasQservMgtRequest.h"
+#include "util/Mutex.h"
 
 // This header declarations
 
@@ -50,7 +52,9 @@ struct QservSyncJobResult {
     std::map<std::string, bool> workers;
 
     /// Previous replica disposition as reported by workers upon the successful
-    /// completion of the corresponding requests
+    /// completion of the corresponding requests. For the workers which were
+    /// only sent a diff it's the disposition they acknowledged last time,
+    /// and the 'useCount' of the replicas isn't known.
     std::map<std::string, QservReplicaCollection> prevReplicas;
 
     /// New replica disposition pushed to workers upon the successful completion
@@ -64,6 +68,12 @@ struct QservSyncJobResult {
   * system. The job will contact all workers. And the scope of the job is
   * is limited to a database family.
   *
+  * Once a worker has acknowledged a disposition of replicas, the job only
+  * sends the replicas added and removed since then, along with the revision
+  * of the worker's inventory reported with the acknowledgement. If the worker
+  * has changed its inventory in the meantime (or has been restarted) it
+  * rejects the diff, and the job falls back to pushing the whole collection.
+  *
   * ATTENTION: The current implementation of the job's algorithm assumes
   * that the latest state of replicas is already recorded in the Replication
   * System's database.
@@ -185,6 +195,31 @@ protected:
      */
     void onRequestFinish(SetReplicasQservMgtRequest::Ptr const& request);
 
+private:
+
+    /**
+     * Submit a request pushing the new collection of replicas to a worker,
+     * or only the diff if the worker has acknowledged a collection before.
+     *
+     * @param lock   - a lock on a mutex must be acquired before calling this method
+     * @param worker - the name of a worker
+     */
+    void launch(util::Lock const& lock,
+                std::string const& worker);
+
+    /// The collection of replicas a worker has acknowledged last time
+    struct WorkerInventory {
+        std::uint64_t revision;
+        QservReplicaCollection replicas;
+    };
+
+    /// The collections acknowledged by workers (by worker). A worker's entry
+    /// is removed if any request sent to the worker fails.
+    static std::map<std::string, WorkerInventory> _workerInventories;
+
+    /// Protects the collections acknowledged by workers
+    static util::Mutex _workerInventoriesMtx;
+
 protected:
 
     /// The name of the database family
@@ -212,6 +247,12 @@ protected:
 
     /// The result of the operation (gets updated as requests are finishing)
     QservSyncJobResult _replicaData;
+
+    /// New replica disposition to be pushed to each worker
+    std::map<std::string, QservReplicaCollection> _newReplicas;
+
+    /// The acknowledged disposition the diffs sent to workers were made against
+    std::map<std::string, QservReplicaCollection> _baseReplicas;
 };
 
 }}} // namespace lsst::qserv::replica
@@ -57,27 +57,30 @@ void printPlan(RebalanceJobResult const& r) {
          << "  totalWorkers:    " << r.totalWorkers    << "  (not counting workers which failed to report chunks)\n"
          << "  totalGoodChunks: " << r.totalGoodChunks << "  (good chunks reported by the precursor job)\n"
          << "  avgChunks:       " << r.avgChunks       << "\n"
+         << "  bytesToMove:     " << r.bytesToMove     << "\n"
+         << "  numStages:       " << r.numStages       << "\n"
+         << "  imbalance:       " << r.imbalanceBefore << " -> " << r.imbalanceAfter
+         << "  (load deviation of the most loaded worker from the average)\n"
          << "\n";
 
+    vector<unsigned int> columnStage;
     vector<unsigned int> columnChunk;
+    vector<uint64_t>     columnBytes;
     vector<string>       columnSourceWorker;
     vector<string>       columnDestinationWorker;
 
-    for (auto&& chunkEntry: r.plan) {
-        auto const chunkNumber = chunkEntry.first;
-
-        for (auto&& sourceWorkerEntry: chunkEntry.second) {
-            auto&& sourceWorker      = sourceWorkerEntry.first;
-            auto&& destinationWorker = sourceWorkerEntry.second;
-
-            columnChunk            .push_back(chunkNumber);
-            columnSourceWorker     .push_back(sourceWorker);
-            columnDestinationWorker.push_back(destinationWorker);
-        }
+    for (auto&& move: r.moves) {
+        columnStage            .push_back(move.stage);
+        columnChunk            .push_back(move.chunk);
+        columnBytes            .push_back(move.bytes);
+        columnSourceWorker     .push_back(move.sourceWorker);
+        columnDestinationWorker.push_back(move.destinationWorker);
     }
     util::ColumnTablePrinter table("", "  ", false);
 
+    table.addColumn("stage",              columnStage );
     table.addColumn("chunk",              columnChunk );
+    table.addColumn("bytes",              columnBytes );
     table.addColumn("source worker",      columnSourceWorker,      util::ColumnTablePrinter::LEFT);
     table.addColumn("destination worker", columnDestinationWorker, util::ColumnTablePrinter::LEFT);
 
@@ -120,10 +120,13 @@ void RebalanceJob::startImpl(util::Lock const& lock) {
     bool const saveReplicInfo = true;           // always save the replica info in a database because
                                                 // the algorithm depends on it.
     bool const allWorkers = false;              // only consider enabled workers
+    bool const fromDirectory = true;            // plan from the replicas known to the Controller
+                                                // if they're recent enough
     _findAllJob = FindAllJob::create(
         databaseFamily(),
         saveReplicInfo,
         allWorkers,
+        fromDirectory,
         controller(),
         id(),
         [self] (FindAllJob::Ptr job) {
@@ -148,6 +151,7 @@ void RebalanceJob::cancelImpl(util::Lock const& lock) {
     _findAllJob = nullptr;
 
     _jobs.clear();
+    _stages.clear();
 
     for (auto&& ptr: _activeJobs) ptr->cancel();
     _activeJobs.clear();
@@ -244,216 +248,73 @@ void RebalanceJob::onPrecursorJobFinish() {
         return;
     }
 
-    // This map is populated with all workers which have responded to the FindAll
-    // requests. It's meant to tell the planner which workers to avoid when looking for
-    // a new home for a chunk to be moved elsewhere from an overpopulated
-    // worker.
+    // Prepare the re-balance plan. The planner weights chunks by their sizes,
+    // so that moving chunks is only planned where the improvement of the
+    // balance of the workers justifies the bytes moved.
     //
-    // IMPORTANT: the map be updated by the planner as it will be deciding
-    // on new destinations for the moved chunks.
+    // The good chunks (of all databases of the family) of a worker can be
+    // moved. Other chunks are registered to avoid collisions. The claimed
+    // destination workers are recorded by the planner.
 
-    std::map<std::string,                   // worker
-             std::map<unsigned int,         // chunk
-                      bool>> worker2chunks;
+    RebalancePlanner planner{RebalancePlanner::Parameters()};
 
     for (auto&& entry: replicaData.workers) {
         std::string const& worker   = entry.first;
         bool        const  reported = entry.second;
-        if (reported) {
-            worker2chunks[worker] = std::map<unsigned int,bool>();
-        }
+        if (reported) planner.addWorker(worker);
     }
     for (auto chunk: replicaData.chunks.chunkNumbers()) {
 
         // skip the special chunk which must be present on all workers
         if (chunk == replica::overflowChunkNumber) continue;
 
-        auto chunkMap = replicaData.chunks.chunk(chunk);
+        auto const& chunkMap = replicaData.chunks.chunk(chunk);
 
+        std::map<std::string, uint64_t> worker2bytes;
         for (auto&& database: chunkMap.databaseNames()) {
-            auto databaseMap = chunkMap.database(database);
+            auto const& databaseMap = chunkMap.database(database);
 
             for (auto&& worker: databaseMap.workerNames()) {
-                worker2chunks[worker][chunk] = true;
+                uint64_t& bytes = worker2bytes[worker];
+                for (auto&& f: databaseMap.worker(worker).fileInfo()) {
+                    bytes += f.size;
+                }
             }
         }
-    }
-
-    // Get a disposition of good chunks across workers. This map will be used
-    // on the next step as a foundation for two collections: overpopulated ('source')
-    // and underpopulated ('destination') workers.
-    //
-    // NOTE: this algorithm will also create entries for workers which don't
-    // have any good (or any) chunks. We need to included those later into
-    // a collection of the underpopulated workers.
-
-    std::map<std::string,
-             std::vector<unsigned int>> worker2goodChunks;
-
-    for (auto&& entry: replicaData.workers) {
-        std::string const& worker   = entry.first;
-        bool        const  reported = entry.second;
-        if (reported) {
-            worker2goodChunks[worker] = std::vector<unsigned int>();
-        }
-    }
-    for (auto&& chunkEntry: replicaData.isGood) {
-
-        unsigned int const chunk = chunkEntry.first;
-
-        // skip the special chunk which must be present on all workers
-        if (chunk == replica::overflowChunkNumber) continue;
-
-        for (auto&& workerEntry: chunkEntry.second) {
-            std::string const& worker = workerEntry.first;
-            bool        const  isGood = workerEntry.second;
-            if (isGood) {
-                worker2goodChunks[worker].push_back(chunk);
+        for (auto&& entry: worker2bytes) {
+            std::string const& worker = entry.first;
+
+            // Ignore workers which failed to report chunks
+            auto const reportedItr = replicaData.workers.find(worker);
+            if ((reportedItr == replicaData.workers.end()) or not reportedItr->second) continue;
+
+            bool isGood = false;
+            auto const chunkItr = replicaData.isGood.find(chunk);
+            if (chunkItr != replicaData.isGood.end()) {
+                auto const workerItr = chunkItr->second.find(worker);
+                isGood = (workerItr != chunkItr->second.end()) and workerItr->second;
             }
+            planner.addReplica(worker, chunk, entry.second, isGood);
         }
     }
 
-    // Get a disposition of the source workers along with chunks located
-    // on the workers. The candidate worker must be strictly
-    // above the previously computed average.
-    //
-    // NOTE: this collection will be sorted (descending order) based on
-    // the total number of chunks per each worker entry.
-
-    std::vector<std::pair<std::string,
-                          std::vector<unsigned int>>> sourceWorkers;
-
-    for (auto&& entry: worker2goodChunks) {
-        size_t const numChunks = entry.second.size();
-        if (numChunks > _replicaData.avgChunks) {
-            sourceWorkers.push_back(entry);
-        }
-    }
-    if (not sourceWorkers.size()) {
-
-        LOGS(_log, LOG_LVL_DEBUG, context() << "onPrecursorJobFinish:  "
-             << "no overloaded 'source' workers found");
-
-        finish(lock, ExtendedState::SUCCESS);
-        return;
-    }
-    std::sort(
-        sourceWorkers.begin(),
-        sourceWorkers.end(),
-        [] (std::pair<std::string, std::vector<unsigned int>> const& a,
-            std::pair<std::string, std::vector<unsigned int>> const& b) {
-            return b.second.size() < a.second.size();
-        }
-    );
-
-    // Get a disposition of the destination workers along with the number
-    // of available slots for chunks which can be hosted by the workers
-    // before they'll hist the average. The number of good chunks on each
-    // such (candidate) worker must be strictly below the previously computed
-    // average.
-
-    std::vector<std::pair<std::string,
-                          size_t>> destinationWorkers;
-
-    for (auto&& entry: worker2goodChunks) {
-        std::string const worker    = entry.first;
-        size_t      const numChunks = entry.second.size();
-
-        if (numChunks < _replicaData.avgChunks) {
-            destinationWorkers.push_back(
-                std::make_pair(worker,
-                               _replicaData.avgChunks - numChunks));
-        }
-    }
-    if (not destinationWorkers.size()) {
-
-        LOGS(_log, LOG_LVL_DEBUG, context() << "onPrecursorJobFinish:  "
-             << "no under-loaded 'destination' workers found");
-
-        finish(lock, ExtendedState::SUCCESS);
-        return;
-    }
-
-    // Prepare the re-balance plan based on the following considerations:
-    //
-    // - use the above formed map 'worker2chunks' to avoid chunk collisions
-    //   and to record claimed destination workers
-    //
-    // - use and update the above formed map 'destinationWorkers'
-    //   to find a candidate worker with fewer number of chunks
-    //
-    // - the algorithm will go over all chunks of each eligible (source) worker
-    //   to see if it's possible to find a new home for a chunk until
-    //   the number of extra chunks parameter is exhausted. Note. it's okay
-    //   if it won't be possible to solve this problem for any chunk
-    //   of the source worker - this will be just reported into the log
-    //   stream before moving to the next worker. This problem will be
-    //   resolved on the next iteration of the job after taking a fresh
-    //   snapshot of chunk disposition. Possible infinite loops (over job
-    //   iterations) can be resolved by setting some reasonable limit onto
-    //   the total number of iterations before this job will be supposed
-    //   to 'succced' in one way or another. Perhaps a special status
-    //   flag for this job could be introduced to let a caller know about
-    //   this situation.
-    //
-    // ATTENTION: this algorithm may need to be optimized for performance
-
     _replicaData.plan.clear();
+    _replicaData.moves = planner.plan();
 
-    for (auto&& sourceWorkerEntry: sourceWorkers) {
-
-        std::string               const& sourceWorker   = sourceWorkerEntry.first;
-        std::vector<unsigned int> const& chunks         = sourceWorkerEntry.second;
-
-        // This number (below) will get decremented in the chunks loop later when
-        // looking for chunks to be moved elsewhere.
-        size_t numExtraChunks = chunks.size() - _replicaData.avgChunks;
-
-        LOGS(_log, LOG_LVL_DEBUG, context() << "onPrecursorJobFinish: "
-             << " sourceWorker: " << sourceWorker
-             << " numExtraChunks: " << numExtraChunks);
-
-        for (unsigned int chunk: chunks) {
-
-            if (not numExtraChunks) break;
-
-            // Always sort the collection in the descending order to make sure
-            // least populated workers are considered first
-            std::sort(
-                destinationWorkers.begin(),
-                destinationWorkers.end(),
-                [] (std::pair<std::string, size_t> const& a,
-                    std::pair<std::string, size_t> const& b) {
-                    return b.second < a.second;
-                }
-            );
-
-            // Search for a candidate worker where to move this chunk to
-            //
-            // IMPLEMENTTION NOTES: using non-constant references in the loop to allow
-            // updates to the number of slots
-
-            for (auto&& destinationWorkerEntry: destinationWorkers) {
-                std::string const& destinationWorker = destinationWorkerEntry.first;
-                size_t&            numSlots          = destinationWorkerEntry.second;
-
-                // Are there any available slots on the worker?
-                if (not numSlots) continue;
-
-                // Skip this worker if it already has this chunk
-                if (worker2chunks[destinationWorker].count(chunk)) continue;
-
-                // Found the one. Update
-
-                _replicaData.plan[chunk][sourceWorker] = destinationWorker;
-                worker2chunks[destinationWorker][chunk] = true;
-                numSlots--;
-
-                --numExtraChunks;
-                break;
-            }
-        }
+    for (auto&& move: _replicaData.moves) {
+        _replicaData.plan[move.chunk][move.sourceWorker] = move.destinationWorker;
     }
+    _replicaData.bytesToMove     = planner.bytesToMove();
+    _replicaData.numStages       = planner.numStages();
+    _replicaData.imbalanceBefore = planner.imbalanceBefore();
+    _replicaData.imbalanceAfter  = planner.imbalanceAfter();
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "onPrecursorJobFinish:  "
+         << "moves: " << _replicaData.moves.size()
+         << " bytesToMove: " << _replicaData.bytesToMove
+         << " numStages: " << _replicaData.numStages
+         << " imbalanceBefore: " << _replicaData.imbalanceBefore
+         << " imbalanceAfter: " << _replicaData.imbalanceAfter);
 
     // Finish right away if the 'estimate' mode requested.
     if (estimateOnly()) {
@@ -470,58 +331,51 @@ void RebalanceJob::onPrecursorJobFinish() {
     }
 
     // Pre-create chunk movement jobs according to the migration
-    // plan.
+    // plan. The jobs of the next stage won't be launched before all jobs
+    // of the previous one finish.
 
     auto self = shared_from_base<RebalanceJob>();
 
-    for (auto&& chunkEntry: _replicaData.plan) {
-        unsigned int const chunk = chunkEntry.first;
-        for (auto&& sourceWorkerEntry: chunkEntry.second) {
-            std::string const& sourceWorker      = sourceWorkerEntry.first;
-            std::string const& destinationWorker = sourceWorkerEntry.second;
-
-            auto job = MoveReplicaJob::create(
-                databaseFamily(),
-                chunk,
-                sourceWorker,
-                destinationWorker,
-                true,   /* purge */
-                controller(),
-                id(),
-                [self](MoveReplicaJob::Ptr job) {
-                    self->onJobFinish(job);
-                }
-            );
-            _jobs.push_back(job);
-        }
+    std::vector<std::list<MoveReplicaJob::Ptr>> stages;
+    for (auto&& move: _replicaData.moves) {
+        auto job = MoveReplicaJob::create(
+            databaseFamily(),
+            move.chunk,
+            move.sourceWorker,
+            move.destinationWorker,
+            true,   /* purge */
+            controller(),
+            id(),
+            [self](MoveReplicaJob::Ptr job) {
+                self->onJobFinish(job);
+            }
+        );
+        if (stages.size() <= move.stage) stages.resize(move.stage + 1);
+        stages[move.stage].push_back(job);
     }
+    _stages.assign(stages.begin(), stages.end());
 
     // ATTENTION: this condition needs to be evaluated to prevent
     // getting into the 'zombie' state.
 
-    if (not _jobs.size()) {
+    if (_stages.empty()) {
         finish(lock, ExtendedState::SUCCESS);
         return;
     }
 
-    // Otherwise start the first batch of jobs. The number of jobs in
-    // the batch is determined by the number of source workers in
-    // the above prepared plan multiplied by the number of worker-side
+    // Otherwise start the first batch of jobs of the first stage. The number
+    // of jobs run by each worker is limited by the number of worker-side
     // processing threads.
 
-    std::set<std::string> uniqueDestinationWorkers;
-    for (auto&& ptr: _jobs) {
-        uniqueDestinationWorkers.insert(ptr->destinationWorker());
-    }
-    size_t const numJobs = uniqueDestinationWorkers.size() *
-        controller()->serviceProvider()->config()->workerNumProcessingThreads();
+    _jobs = _stages.front();
+    _stages.pop_front();
 
-    size_t const numJobsLaunched = launchNextJobs(lock, numJobs);
+    size_t const numJobsLaunched = launchNextJobs(lock, _jobs.size());
     if (0 != numJobsLaunched) {
         _numLaunched += numJobsLaunched;
     } else {
         LOGS(_log, LOG_LVL_ERROR, context()
-             << "onPrecursorJobFinish  unexpected failure when launching " << numJobs
+             << "onPrecursorJobFinish  unexpected failure when launching " << _jobs.size()
              << " replica migration jobs");
         _jobs.clear();
         finish(lock, ExtendedState::FAILED);
@@ -590,9 +444,20 @@ void RebalanceJob::onJobFinish(MoveReplicaJob::Ptr const& job) {
         }
     }
 
-    // Try to submit one more job
+    // Proceed to the next stage after all jobs of the current one finish
+
+    if (_jobs.empty() and _activeJobs.empty() and not _stages.empty()) {
+
+        LOGS(_log, LOG_LVL_DEBUG, context() << "onJobFinish  starting the next stage,"
+             << " stages left: " << _stages.size());
+
+        _jobs = _stages.front();
+        _stages.pop_front();
+    }
+
+    // Try to submit more jobs (as many as the workers would take)
 
-    size_t const numJobsLaunched = launchNextJobs(lock, 1);
+    size_t const numJobsLaunched = launchNextJobs(lock, _jobs.size());
     if (numJobsLaunched != 0) {
         _numLaunched += numJobsLaunched;
     } else {
@@ -600,7 +465,7 @@ void RebalanceJob::onJobFinish(MoveReplicaJob::Ptr const& job) {
         // Evaluate the status of on-going operations to see if the job
         // has finished.
 
-        if (_numFinished == _numLaunched) {
+        if ((_numFinished == _numLaunched) and _jobs.empty() and _stages.empty()) {
             finish(lock, _numSuccess == _numLaunched ? ExtendedState::SUCCESS
                                                      : ExtendedState::FAILED);
         }
@@ -627,6 +492,10 @@ size_t RebalanceJob::launchNextJobs(util::Lock const& lock,
     // by evaluating best candidates using an algorithm explained
     // within the loop below.
     
+    // The limit for the number of jobs run by each worker at both ends
+    size_t const maxJobsPerWorker =
+        controller()->serviceProvider()->config()->workerNumProcessingThreads();
+
     size_t numJobsLaunched = 0;
     for (size_t i = 0; i < numJobs; ++i) {
 
@@ -646,6 +515,9 @@ size_t RebalanceJob::launchNextJobs(util::Lock const& lock,
         MoveReplicaJob::Ptr job;
 
         for (auto&& ptr: _jobs) {            
+            if ((numAtDest[ptr->destinationWorker()] >= maxJobsPerWorker) or
+                (numAtSrc [ptr->sourceWorker()]      >= maxJobsPerWorker)) continue;
+
             size_t const load = numAtDest[ptr->destinationWorker()] +
                                 numAtSrc [ptr->sourceWorker()];
             if (load <= minLoad) {
@@ -28,12 +28,14 @@
 #include <list>
 #include <map>
 #include <string>
+#include <vector>
 
 // Qserv headers
 #include "replica/Job.h"
 #include "replica/FindAllJob.h"
 #include "replica/ReplicaInfo.h"
 #include "replica/MoveReplicaJob.h"
+#include "replica/RebalancePlanner.h"
 
 // This header declarations
 
@@ -81,11 +83,19 @@ struct RebalanceJobResult {
              std::map<std::string,          // source worker
                       std::string>> plan;   // destination worker
 
+    /// The moves of the plan (along with their sizes) ordered by stages
+    std::vector<RebalancePlanner::Move> moves;
+
     // Parameters of the planner
 
     size_t totalWorkers    {0};     // not counting workers which failed to report chunks
     size_t totalGoodChunks {0};     // good chunks reported by the precursor job
     size_t avgChunks       {0};     // per worker average
+
+    uint64_t     bytesToMove     {0};   // the total number of bytes to be moved
+    unsigned int numStages       {0};   // the number of stages in the plan
+    double       imbalanceBefore {0};   // load deviation of the most loaded worker before the moves
+    double       imbalanceAfter  {0};   // load deviation of the most loaded worker after the moves
 };
 
 /**
@@ -113,6 +123,14 @@ struct RebalanceJobResult {
   * - the operation won't affect the number of replicas, it will only
   *   move replicas between workers
   *
+  * - chunks are weighted by their sizes, and the moves are planned only
+  *   while the improvement of the balance justifies the bytes moved
+  *   (see class RebalancePlanner)
+  *
+  * - the moves are executed in stages which limit the number of bytes
+  *   transferred by each worker. The next stage begins after all moves
+  *   of the previous one finish.
+  *
   * - when re-balancing is over then investigate two options: finish it and launch
   *   it again externally using some sort of a scheduler, or have an internal ASYNC
   *   timer (based on Boost ASIO).
@@ -277,9 +295,12 @@ protected:
     /// replica disposition.
     FindAllJob::Ptr _findAllJob;
 
-    /// Replica creation jobs which are ready to be launched
+    /// Replica creation jobs of the current stage which are ready to be launched
     std::list<MoveReplicaJob::Ptr> _jobs;
 
+    /// Replica creation jobs of the next stages of the plan
+    std::list<std::list<MoveReplicaJob::Ptr>> _stages;
+
     /// Jobs which are already active
     std::list<MoveReplicaJob::Ptr> _activeJobs;
 
@@ -0,0 +1,241 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "replica/RebalancePlanner.h"
+
+// System headers
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+// Qserv headers
+#include "lsst/log/Log.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.replica.RebalancePlanner");
+
+} /// namespace
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+RebalancePlanner::RebalancePlanner(Parameters const& parameters)
+    :   _parameters(parameters),
+        _planned(false),
+        _imbalanceBefore(0),
+        _imbalanceAfter(0),
+        _bytesToMove(0),
+        _numStages(0) {
+}
+
+void RebalancePlanner::addWorker(std::string const& worker) {
+    _goodReplicas[worker];
+    _chunks[worker];
+}
+
+void RebalancePlanner::addReplica(std::string const& worker,
+                                  unsigned int chunk,
+                                  uint64_t bytes,
+                                  bool isGood) {
+    addWorker(worker);
+    _chunks[worker].insert(chunk);
+    if (isGood) _goodReplicas[worker][chunk] = bytes;
+}
+
+void RebalancePlanner::setChunkHeat(unsigned int chunk,
+                                    double heat) {
+    _chunkHeat[chunk] = heat;
+}
+
+double RebalancePlanner::load(unsigned int chunk,
+                              uint64_t bytes) const {
+    auto const itr = _chunkHeat.find(chunk);
+    return bytes * (itr == _chunkHeat.end() ? 1. : itr->second);
+}
+
+double RebalancePlanner::avgLoad() const {
+    if (_loads.empty()) return 0;
+    double total = 0;
+    for (auto&& entry: _loads) total += entry.second;
+    return total / _loads.size();
+}
+
+double RebalancePlanner::imbalance() const {
+    double const avg = avgLoad();
+    if (avg <= 0) return 0;
+    double maxLoad = 0;
+    for (auto&& entry: _loads) maxLoad = std::max(maxLoad, entry.second);
+    return (maxLoad - avg) / avg;
+}
+
+std::vector<RebalancePlanner::Move> const& RebalancePlanner::plan() {
+
+    if (_planned) {
+        throw std::logic_error("RebalancePlanner::plan  the plan was already computed");
+    }
+    _planned = true;
+
+    for (auto&& workerEntry: _goodReplicas) {
+        double& workerLoad = _loads[workerEntry.first];
+        workerLoad = 0;
+        for (auto&& chunkEntry: workerEntry.second) {
+            workerLoad += load(chunkEntry.first, chunkEntry.second);
+        }
+    }
+    _imbalanceBefore = imbalance();
+
+    double const avg = avgLoad();
+    double const maxLoad = avg * (1 + _parameters.tolerance);
+
+    // Replicas which were moved in by the plan aren't moved again
+    std::set<std::pair<std::string, unsigned int>> movedIn;
+
+    // Workers which have no chunk to give away
+    std::set<std::string> exhausted;
+
+    while (true) {
+
+        // The most loaded worker among the ones above the tolerance
+
+        std::string sourceWorker;
+        for (auto&& entry: _loads) {
+            if (exhausted.count(entry.first) or (entry.second <= maxLoad)) continue;
+            if (sourceWorker.empty() or (entry.second > _loads[sourceWorker])) {
+                sourceWorker = entry.first;
+            }
+        }
+        if (sourceWorker.empty()) break;
+
+        double const sourceLoad = _loads[sourceWorker];
+
+        // Destination candidates ordered by their loads (least loaded first)
+
+        std::vector<std::pair<double, std::string>> destinations;
+        for (auto&& entry: _loads) {
+            if (entry.first != sourceWorker) destinations.emplace_back(entry.second, entry.first);
+        }
+        std::sort(destinations.begin(), destinations.end());
+
+        // Moving a chunk of load 'l' from worker 's' to worker 'd' reduces
+        // the sum of squared deviations of the loads by:
+        //
+        //   2 * l * (Ls - Ld - l)
+
+        double bestScore = 0;
+        unsigned int bestChunk = 0;
+        uint64_t bestBytes = 0;
+        std::string bestDestination;
+
+        for (auto&& chunkEntry: _goodReplicas[sourceWorker]) {
+            unsigned int const chunk = chunkEntry.first;
+            uint64_t     const bytes = chunkEntry.second;
+
+            if (movedIn.count(std::make_pair(sourceWorker, chunk))) continue;
+
+            double const l = load(chunk, bytes);
+            for (auto&& destination: destinations) {
+                if (_chunks[destination.second].count(chunk)) continue;
+
+                double const gain  = 2 * l * (sourceLoad - destination.first - l);
+                double const score = gain / (bytes + 1);
+                if (score > bestScore) {
+                    bestScore       = score;
+                    bestChunk       = chunk;
+                    bestBytes       = bytes;
+                    bestDestination = destination.second;
+                }
+
+                // Other destinations have higher loads
+                break;
+            }
+        }
+        if (bestDestination.empty()) {
+            exhausted.insert(sourceWorker);
+            continue;
+        }
+
+        LOGS(_log, LOG_LVL_DEBUG, "RebalancePlanner::plan  chunk: " << bestChunk
+             << " " << sourceWorker << " -> " << bestDestination << " bytes: " << bestBytes);
+
+        double const l = load(bestChunk, bestBytes);
+
+        _loads[sourceWorker]    -= l;
+        _loads[bestDestination] += l;
+
+        _goodReplicas[sourceWorker].erase(bestChunk);
+        _chunks[sourceWorker].erase(bestChunk);
+        _goodReplicas[bestDestination][bestChunk] = bestBytes;
+        _chunks[bestDestination].insert(bestChunk);
+        movedIn.insert(std::make_pair(bestDestination, bestChunk));
+
+        _moves.push_back(Move{bestChunk, sourceWorker, bestDestination, bestBytes, 0});
+        _bytesToMove += bestBytes;
+    }
+    _imbalanceAfter = imbalance();
+
+    stage();
+
+    return _moves;
+}
+
+void RebalancePlanner::stage() {
+
+    auto const budget = [this](std::string const& worker) -> double {
+        auto const itr = _parameters.bandwidth.find(worker);
+        double const bandwidth = itr == _parameters.bandwidth.end() ?
+            _parameters.defaultBandwidth : itr->second;
+        return bandwidth * _parameters.stageDurationSec;
+    };
+
+    // Bytes sent or received by each worker in each stage
+
+    std::vector<std::map<std::string, double>> stageBytes;
+
+    for (auto&& move: _moves) {
+        unsigned int stage = 0;
+        for (; stage < stageBytes.size(); ++stage) {
+            double const srcBytes = stageBytes[stage][move.sourceWorker];
+            double const dstBytes = stageBytes[stage][move.destinationWorker];
+            if ((srcBytes == 0 and dstBytes == 0) or
+                ((srcBytes + move.bytes <= budget(move.sourceWorker)) and
+                 (dstBytes + move.bytes <= budget(move.destinationWorker)))) break;
+        }
+        if (stage == stageBytes.size()) stageBytes.emplace_back();
+
+        stageBytes[stage][move.sourceWorker]      += move.bytes;
+        stageBytes[stage][move.destinationWorker] += move.bytes;
+        move.stage = stage;
+    }
+    std::stable_sort(
+        _moves.begin(),
+        _moves.end(),
+        [] (Move const& a, Move const& b) {
+            return a.stage < b.stage;
+        }
+    );
+    _numStages = stageBytes.size();
+}
+
+}}} // namespace lsst::qserv::replica
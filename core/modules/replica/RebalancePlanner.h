@@ -0,0 +1,207 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_REPLICA_REBALANCEPLANNER_H
+#define LSST_QSERV_REPLICA_REBALANCEPLANNER_H
+
+/**
+ * This header declares class RebalancePlanner which computes the moves
+ * of chunk replicas between workers for RebalanceJob.
+ */
+
+// System headers
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// This header declarations
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+/**
+  * Class RebalancePlanner computes a staged plan for moving chunk replicas
+  * between workers to even out the load of the workers.
+  *
+  * The load of a chunk is its size (bytes of all databases of a family
+  * at a worker) multiplied by its heat (a relative frequency of scans of
+  * the chunk, 1 by default). The load of a worker is the sum of the loads
+  * of its 'good' chunks.
+  *
+  * The planner repeatedly picks the most loaded worker and moves the chunk
+  * which yields the largest reduction of the sum of squared deviations of
+  * the worker loads per byte moved to the least loaded worker which doesn't
+  * have the chunk. It stops when the most loaded worker is within the
+  * tolerance above the average load, or when no move reduces the imbalance.
+  * This way small deviations don't trigger the (costly) moves.
+  *
+  * The moves are then split into stages. The number of bytes sent or received
+  * by a worker within a stage is limited by the bandwidth of the worker
+  * multiplied by the duration of a stage. A chunk which is larger than that
+  * is put into a stage of its own.
+  */
+class RebalancePlanner {
+
+public:
+
+    /// Parameters of the planner
+    struct Parameters {
+
+        /// The maximum deviation (a fraction of the average load) of the most
+        /// loaded worker which would not require moving any chunks away from it
+        double tolerance = 0.05;
+
+        /// The transfer bandwidth (bytes per second) of the workers which
+        /// aren't found in the map below
+        double defaultBandwidth = 100e6;
+
+        /// The transfer bandwidth (bytes per second) of specific workers
+        std::map<std::string, double> bandwidth;
+
+        /// The desired duration (seconds) of a stage
+        unsigned int stageDurationSec = 600;
+    };
+
+    /// A move of a chunk replica
+    struct Move {
+        unsigned int chunk;
+        std::string  sourceWorker;
+        std::string  destinationWorker;
+        uint64_t     bytes;
+        unsigned int stage;     // the stages are numbered starting from 0
+    };
+
+    // Default construction and copy semantics are prohibited
+
+    RebalancePlanner() = delete;
+    RebalancePlanner(RebalancePlanner const&) = delete;
+    RebalancePlanner& operator=(RebalancePlanner const&) = delete;
+
+    /**
+     * @param parameters - parameters of the planner
+     */
+    explicit RebalancePlanner(Parameters const& parameters);
+
+    ~RebalancePlanner() = default;
+
+    /**
+     * Register a worker which may not have any chunks
+     *
+     * @param worker - the name of a worker
+     */
+    void addWorker(std::string const& worker);
+
+    /**
+     * Register a chunk replica at a worker. Only 'good' replicas may be moved
+     * and contribute to the load of the worker. Other replicas are registered
+     * to prevent collisions.
+     *
+     * @param worker - the name of a worker
+     * @param chunk  - the chunk number
+     * @param bytes  - the size of the replica
+     * @param isGood - the flag indicating a 'good' replica
+     */
+    void addReplica(std::string const& worker,
+                    unsigned int chunk,
+                    uint64_t bytes,
+                    bool isGood);
+
+    /**
+     * Set the heat of a chunk. It should be set before calling method plan().
+     *
+     * @param chunk - the chunk number
+     * @param heat  - the relative frequency of scans of the chunk
+     */
+    void setChunkHeat(unsigned int chunk,
+                      double heat);
+
+    /**
+     * Compute the plan. The method can be called only once.
+     *
+     * @return the moves ordered by their stages
+     *
+     * @throws std::logic_error if the method was already called
+     */
+    std::vector<Move> const& plan();
+
+    /// @return the average load of the workers
+    double avgLoad() const;
+
+    /// @return the deviation of the most loaded worker from the average load
+    /// (a fraction of the average load) before the planned moves
+    double imbalanceBefore() const { return _imbalanceBefore; }
+
+    /// @return the deviation of the most loaded worker from the average load
+    /// (a fraction of the average load) after the planned moves
+    double imbalanceAfter() const { return _imbalanceAfter; }
+
+    /// @return the total number of bytes to be moved
+    uint64_t bytesToMove() const { return _bytesToMove; }
+
+    /// @return the number of stages in the plan
+    unsigned int numStages() const { return _numStages; }
+
+private:
+
+    /// @return the load of a chunk of the specified size
+    double load(unsigned int chunk,
+                uint64_t bytes) const;
+
+    /// @return the deviation of the most loaded worker from the average load
+    double imbalance() const;
+
+    /// Split the moves into stages
+    void stage();
+
+private:
+
+    Parameters const _parameters;
+
+    /// The sizes of the 'good' replicas which may be moved
+    std::map<std::string,                       // worker
+             std::map<unsigned int,             // chunk
+                      uint64_t>> _goodReplicas; // bytes
+
+    /// All chunks of the workers
+    std::map<std::string,
+             std::set<unsigned int>> _chunks;
+
+    std::map<unsigned int, double> _chunkHeat;
+
+    /// The current loads of the workers
+    std::map<std::string, double> _loads;
+
+    bool _planned;
+
+    std::vector<Move> _moves;
+
+    double       _imbalanceBefore;
+    double       _imbalanceAfter;
+    uint64_t     _bytesToMove;
+    unsigned int _numStages;
+};
+
+}}} // namespace lsst::qserv::replica
+
+#endif // LSST_QSERV_REPLICA_REBALANCEPLANNER_H
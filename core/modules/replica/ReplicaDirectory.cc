@@ -0,0 +1,344 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "replica/ReplicaDirectory.h"
+
+// System headers
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+// Qserv headers
+#include "lsst/log/Log.h"
+#include "replica/Performance.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.replica.ReplicaDirectory");
+
+} /// namespace
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+unsigned int const ReplicaDirectory::defaultMaxAgeSec = 600;
+
+uint32_t const ReplicaDirectory::NameTable::npos = std::numeric_limits<uint32_t>::max();
+
+uint32_t const ReplicaDirectory::maxNames = 1 << 16;
+
+size_t const ReplicaDirectory::minDeadFiles = 1024;
+
+uint32_t ReplicaDirectory::NameTable::id(std::string const& name) {
+    auto const itr = _ids.find(name);
+    if (itr != _ids.end()) return itr->second;
+    uint32_t const id = _names.size();
+    _names.push_back(name);
+    _ids[name] = id;
+    return id;
+}
+
+uint32_t ReplicaDirectory::NameTable::find(std::string const& name) const {
+    auto const itr = _ids.find(name);
+    return itr == _ids.end() ? npos : itr->second;
+}
+
+ReplicaDirectory::Ptr ReplicaDirectory::create() {
+    return Ptr(new ReplicaDirectory());
+}
+
+ReplicaDirectory::ReplicaDirectory()
+    :   _numDeadFiles(0) {
+}
+
+void ReplicaDirectory::update(ReplicaInfo const& replica) {
+    util::Lock lock(_mtx, context() + "update");
+    updateImpl(lock, replica);
+}
+
+void ReplicaDirectory::replace(std::string const& worker,
+                               std::string const& database,
+                               ReplicaInfoCollection const& replicas) {
+
+    util::Lock lock(_mtx, context() + "replace");
+
+    uint32_t const workerId   = nameId(lock, worker,   _workers);
+    uint32_t const databaseId = nameId(lock, database, _databases);
+
+    // Going backwards guarantees that the replica taking the place of
+    // the removed one has already been looked at
+
+    for (size_t i = _replicaWorker.size(); i-- > 0;) {
+        if ((_replicaWorker[i] == workerId) and (_replicaDatabase[i] == databaseId)) {
+            removeImpl(lock, i);
+        }
+    }
+    for (auto&& replica: replicas) {
+        if ((replica.worker() == worker) and (replica.database() == database)) {
+            updateImpl(lock, replica);
+        }
+    }
+    _listingTime[std::make_pair(workerId, databaseId)] = PerformanceUtils::now();
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "replace  worker=" << worker
+         << " database=" << database << " numReplicas=" << _replicaWorker.size()
+         << " numFiles=" << _fileName.size() - _numDeadFiles);
+}
+
+bool ReplicaDirectory::covers(std::vector<std::string> const& workers,
+                              std::vector<std::string> const& databases,
+                              unsigned int maxAgeSec) const {
+
+    util::Lock lock(_mtx, context() + "covers");
+
+    uint64_t const now = PerformanceUtils::now();
+    for (auto&& worker: workers) {
+        uint32_t const workerId = _workers.find(worker);
+        if (workerId == NameTable::npos) return false;
+        for (auto&& database: databases) {
+            uint32_t const databaseId = _databases.find(database);
+            if (databaseId == NameTable::npos) return false;
+            auto const itr = _listingTime.find(std::make_pair(workerId, databaseId));
+            if (itr == _listingTime.end()) return false;
+            if (now - std::min(now, itr->second) > 1000ULL * maxAgeSec) return false;
+        }
+    }
+    return true;
+}
+
+ReplicaInfoCollection ReplicaDirectory::replicas(std::string const& worker,
+                                                 std::string const& database) const {
+
+    util::Lock lock(_mtx, context() + "replicas");
+
+    ReplicaInfoCollection result;
+
+    uint32_t const workerId   = _workers.find(worker);
+    uint32_t const databaseId = _databases.find(database);
+    if ((workerId == NameTable::npos) or (databaseId == NameTable::npos)) return result;
+
+    for (size_t i = 0, size = _replicaWorker.size(); i < size; ++i) {
+        if ((_replicaWorker[i] == workerId) and (_replicaDatabase[i] == databaseId)) {
+            result.push_back(replicaImpl(lock, i));
+        }
+    }
+    return result;
+}
+
+size_t ReplicaDirectory::numReplicas() const {
+    util::Lock lock(_mtx, context() + "numReplicas");
+    return _replicaWorker.size();
+}
+
+size_t ReplicaDirectory::numFiles() const {
+    util::Lock lock(_mtx, context() + "numFiles");
+    return _fileName.size() - _numDeadFiles;
+}
+
+uint32_t ReplicaDirectory::nameId(util::Lock const& lock,
+                                  std::string const& name,
+                                  NameTable& table) {
+
+    uint32_t const id = table.id(name);
+    if (id >= maxNames) {
+        throw std::range_error(
+                "ReplicaDirectory::" + std::string(__func__) +
+                "  too many names of workers or databases, failed on: " + name);
+    }
+    return id;
+}
+
+void ReplicaDirectory::updateImpl(util::Lock const& lock,
+                                  ReplicaInfo const& replica) {
+
+    uint32_t const workerId   = nameId(lock, replica.worker(),   _workers);
+    uint32_t const databaseId = nameId(lock, replica.database(), _databases);
+
+    auto const itr = _index.find(key(workerId, databaseId, replica.chunk()));
+
+    if (replica.status() == ReplicaInfo::Status::NOT_FOUND) {
+        if (itr != _index.end()) removeImpl(lock, itr->second);
+        return;
+    }
+
+    auto const& fileInfo = replica.fileInfo();
+
+    size_t index;
+    if (itr == _index.end()) {
+        index = _replicaWorker.size();
+        _replicaWorker.push_back(workerId);
+        _replicaDatabase.push_back(databaseId);
+        _replicaChunk.push_back(replica.chunk());
+        _replicaStatus.push_back(0);
+        _replicaVerifyTime.push_back(0);
+        _replicaFirstFile.push_back(0);
+        _replicaNumFiles.push_back(0);
+        _index[key(workerId, databaseId, replica.chunk())] = index;
+    } else {
+        index = itr->second;
+    }
+    _replicaStatus[index]     = replica.status();
+    _replicaVerifyTime[index] = replica.verifyTime();
+
+    // The files are rewritten in place if their number hasn't changed.
+    // Otherwise they're appended to the arrays, and the old ones are left
+    // till the arrays are compacted.
+
+    if (_replicaNumFiles[index] != fileInfo.size()) {
+        _numDeadFiles += _replicaNumFiles[index];
+        _replicaFirstFile[index] = _fileName.size();
+        _replicaNumFiles[index]  = fileInfo.size();
+        resizeFiles(lock, _fileName.size() + fileInfo.size());
+    }
+    setFiles(lock, _replicaFirstFile[index], fileInfo);
+
+    compact(lock);
+}
+
+void ReplicaDirectory::removeImpl(util::Lock const& lock,
+                                  size_t index) {
+
+    _index.erase(key(_replicaWorker[index], _replicaDatabase[index], _replicaChunk[index]));
+    _numDeadFiles += _replicaNumFiles[index];
+
+    size_t const last = _replicaWorker.size() - 1;
+    if (index != last) {
+        _replicaWorker[index]     = _replicaWorker[last];
+        _replicaDatabase[index]   = _replicaDatabase[last];
+        _replicaChunk[index]      = _replicaChunk[last];
+        _replicaStatus[index]     = _replicaStatus[last];
+        _replicaVerifyTime[index] = _replicaVerifyTime[last];
+        _replicaFirstFile[index]  = _replicaFirstFile[last];
+        _replicaNumFiles[index]   = _replicaNumFiles[last];
+        _index[key(_replicaWorker[index], _replicaDatabase[index], _replicaChunk[index])] = index;
+    }
+    _replicaWorker.pop_back();
+    _replicaDatabase.pop_back();
+    _replicaChunk.pop_back();
+    _replicaStatus.pop_back();
+    _replicaVerifyTime.pop_back();
+    _replicaFirstFile.pop_back();
+    _replicaNumFiles.pop_back();
+}
+
+void ReplicaDirectory::setFiles(util::Lock const& lock,
+                                size_t first,
+                                ReplicaInfo::FileInfoCollection const& fileInfo) {
+
+    for (size_t i = 0, size = fileInfo.size(); i < size; ++i) {
+        auto const& file = fileInfo[i];
+        _fileName[first + i]        = _strings.id(file.name);
+        _fileSize[first + i]        = file.size;
+        _fileMtime[first + i]       = file.mtime;
+        _fileCs[first + i]          = _strings.id(file.cs);
+        _fileCsAlgorithm[first + i] = _strings.id(file.csAlgorithm);
+        _filePacked[first + i]      = file.packed ? 1 : 0;
+    }
+}
+
+void ReplicaDirectory::resizeFiles(util::Lock const& lock,
+                                   size_t size) {
+    _fileName.resize(size);
+    _fileSize.resize(size);
+    _fileMtime.resize(size);
+    _fileCs.resize(size);
+    _fileCsAlgorithm.resize(size);
+    _filePacked.resize(size);
+}
+
+void ReplicaDirectory::compact(util::Lock const& lock) {
+
+    if ((_numDeadFiles < minDeadFiles) or (2 * _numDeadFiles < _fileName.size())) return;
+
+    // Move the files of the replicas to the front of the arrays, in the order
+    // of the replicas. The ranges of the files never move up the arrays, so
+    // the files of a replica are copied before they're overwritten.
+
+    std::vector<uint32_t> order(_replicaWorker.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [this] (uint32_t a, uint32_t b) {
+        return _replicaFirstFile[a] < _replicaFirstFile[b];
+    });
+
+    size_t next = 0;
+    for (uint32_t index: order) {
+        size_t const first = _replicaFirstFile[index];
+        size_t const num   = _replicaNumFiles[index];
+        for (size_t i = 0; i < num; ++i) {
+            _fileName[next + i]        = _fileName[first + i];
+            _fileSize[next + i]        = _fileSize[first + i];
+            _fileMtime[next + i]       = _fileMtime[first + i];
+            _fileCs[next + i]          = _fileCs[first + i];
+            _fileCsAlgorithm[next + i] = _fileCsAlgorithm[first + i];
+            _filePacked[next + i]      = _filePacked[first + i];
+        }
+        _replicaFirstFile[index] = next;
+        next += num;
+    }
+    resizeFiles(lock, next);
+    _fileName.shrink_to_fit();
+    _fileSize.shrink_to_fit();
+    _fileMtime.shrink_to_fit();
+    _fileCs.shrink_to_fit();
+    _fileCsAlgorithm.shrink_to_fit();
+    _filePacked.shrink_to_fit();
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "compact  numDeadFiles=" << _numDeadFiles
+         << " numFiles=" << next);
+
+    _numDeadFiles = 0;
+}
+
+ReplicaInfo ReplicaDirectory::replicaImpl(util::Lock const& lock,
+                                          size_t index) const {
+
+    size_t const first = _replicaFirstFile[index];
+    size_t const num   = _replicaNumFiles[index];
+
+    ReplicaInfo::FileInfoCollection fileInfo;
+    fileInfo.reserve(num);
+    for (size_t i = first; i < first + num; ++i) {
+        fileInfo.push_back(ReplicaInfo::FileInfo({
+            _strings.name(_fileName[i]),
+            _fileSize[i],
+            _fileMtime[i],
+            _strings.name(_fileCs[i]),
+            0,              /* beginTransferTime */
+            0,              /* endTransferTime */
+            _fileSize[i],   /* inSize */
+            _strings.name(_fileCsAlgorithm[i]),
+            _filePacked[i] != 0,
+            0,              /* unpackedSize: kept in the database only */
+            ""              /* unpackedCs */
+        }));
+    }
+    return ReplicaInfo(static_cast<ReplicaInfo::Status>(_replicaStatus[index]),
+                       _workers.name(_replicaWorker[index]),
+                       _databases.name(_replicaDatabase[index]),
+                       _replicaChunk[index],
+                       _replicaVerifyTime[index],
+                       fileInfo);
+}
+
+}}} // namespace lsst::qserv::replica
@@ -0,0 +1,272 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_REPLICA_REPLICADIRECTORY_H
+#define LSST_QSERV_REPLICA_REPLICADIRECTORY_H
+
+// System headers
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Qserv headers
+#include "replica/ReplicaInfo.h"
+#include "util/Mutex.h"
+
+// This header declarations
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+/**
+ * Class ReplicaDirectory keeps the replicas known to the Controller in
+ * a compact form. The names of the workers, databases and files, and
+ * the control sums of the files, are interned. The attributes of the replicas
+ * and of their files are stored in separate arrays, and the files of a replica
+ * occupy a contiguous range of the file arrays.
+ *
+ * The directory is updated from the complete listings of the replicas of
+ * a database at a worker (as reported by the FIND-ALL requests), and from
+ * the replicas reported by the requests creating, deleting or finding
+ * individual replicas. The directory is said to cover a worker and a database
+ * if it has their complete listing, which is kept up to date by the other
+ * requests since then.
+ *
+ * The times of the transfers of the files, and the sizes of the input files,
+ * aren't kept. The replicas made out of the directory have those set to 0
+ * and to the sizes of the files respectively.
+ */
+class ReplicaDirectory {
+
+public:
+
+    /// The pointer type for instances of the class
+    typedef std::shared_ptr<ReplicaDirectory> Ptr;
+
+    /// The default age (seconds) of the listings beyond which they aren't trusted
+    static unsigned int const defaultMaxAgeSec;
+
+    /**
+     * The factory method for instances of the class
+     *
+     * @return pointer to the new object
+     */
+    static Ptr create();
+
+    // Copy semantics are prohibited
+
+    ReplicaDirectory(ReplicaDirectory const&) = delete;
+    ReplicaDirectory& operator=(ReplicaDirectory const&) = delete;
+
+    ~ReplicaDirectory() = default;
+
+    /**
+     * Add a replica, or replace the known one. A replica whose status is
+     * NOT_FOUND gets removed from the directory.
+     *
+     * @param replica - the replica reported by a worker
+     */
+    void update(ReplicaInfo const& replica);
+
+    /**
+     * Replace all replicas of a database at a worker with a complete listing
+     * reported by the worker, and note the time of the listing.
+     *
+     * @param worker   - the name of the worker
+     * @param database - the name of the database
+     * @param replicas - all replicas of the database at the worker
+     */
+    void replace(std::string const& worker,
+                 std::string const& database,
+                 ReplicaInfoCollection const& replicas);
+
+    /**
+     * @param workers   - the names of the workers
+     * @param databases - the names of the databases
+     * @param maxAgeSec - the maximum age (seconds) of the listings
+     *
+     * @return 'true' if the directory has the listings of all databases at
+     *   all workers, none of which is older than the specified age
+     */
+    bool covers(std::vector<std::string> const& workers,
+                std::vector<std::string> const& databases,
+                unsigned int maxAgeSec=defaultMaxAgeSec) const;
+
+    /**
+     * @param worker   - the name of the worker
+     * @param database - the name of the database
+     *
+     * @return the known replicas of the database at the worker
+     */
+    ReplicaInfoCollection replicas(std::string const& worker,
+                                   std::string const& database) const;
+
+    /// @return the number of the replicas in the directory
+    size_t numReplicas() const;
+
+    /// @return the number of the files of the replicas in the directory
+    size_t numFiles() const;
+
+private:
+
+    /**
+     * Class NameTable assigns consecutive identifiers to the names
+     */
+    class NameTable {
+
+    public:
+
+        /// The identifier returned by find() for the names not in the table
+        static uint32_t const npos;
+
+        /// @return the identifier of a name, which is added if needed
+        uint32_t id(std::string const& name);
+
+        /// @return the identifier of a name, or npos if it's not in the table
+        uint32_t find(std::string const& name) const;
+
+        /// @return the name of an identifier
+        std::string const& name(uint32_t id) const { return _names[id]; }
+
+    private:
+
+        std::vector<std::string> _names;
+        std::unordered_map<std::string, uint32_t> _ids;
+    };
+
+    /// The limit for the identifiers of the workers and databases, which share
+    /// a 64-bit key with the chunk numbers
+    static uint32_t const maxNames;
+
+    /// The number of the files no longer used which triggers compacting
+    /// the file arrays
+    static size_t const minDeadFiles;
+
+    /// @see ReplicaDirectory::create()
+    ReplicaDirectory();
+
+    /// @return the key of a replica in the index
+    static uint64_t key(uint32_t worker,
+                        uint32_t database,
+                        unsigned int chunk) {
+        return (uint64_t(worker) << 48) | (uint64_t(database) << 32) | chunk;
+    }
+
+    /**
+     * @param lock - a lock on a mutex must be acquired before calling this method
+     * @param name - the name of a worker or a database
+     * @param table - the table of the names
+     *
+     * @return the identifier of the name
+     *
+     * @throws std::range_error - if the table has too many names
+     */
+    static uint32_t nameId(util::Lock const& lock,
+                           std::string const& name,
+                           NameTable& table);
+
+    /// @see ReplicaDirectory::update()
+    void updateImpl(util::Lock const& lock,
+                    ReplicaInfo const& replica);
+
+    /**
+     * Remove a replica. The last replica takes its place in the arrays.
+     *
+     * @param lock  - a lock on a mutex must be acquired before calling this method
+     * @param index - the index of the replica
+     */
+    void removeImpl(util::Lock const& lock,
+                    size_t index);
+
+    /**
+     * Store the files of a replica in the file arrays, starting at a given index
+     *
+     * @param lock     - a lock on a mutex must be acquired before calling this method
+     * @param first    - the index of the first file
+     * @param fileInfo - the files
+     */
+    void setFiles(util::Lock const& lock,
+                  size_t first,
+                  ReplicaInfo::FileInfoCollection const& fileInfo);
+
+    /// Resize the file arrays
+    void resizeFiles(util::Lock const& lock,
+                     size_t size);
+
+    /// Drop the files which are no longer used by any replica
+    void compact(util::Lock const& lock);
+
+    /// @return the replica made of its entry in the arrays
+    ReplicaInfo replicaImpl(util::Lock const& lock,
+                            size_t index) const;
+
+    /// @return the context string for debugging and diagnostic printouts
+    std::string context() const { return "REPLICA-DIRECTORY  "; }
+
+private:
+
+    NameTable _workers;
+    NameTable _databases;
+
+    /// The names of the files, the control sums and their algorithms
+    NameTable _strings;
+
+    // The replicas
+
+    std::vector<uint32_t> _replicaWorker;
+    std::vector<uint32_t> _replicaDatabase;
+    std::vector<uint32_t> _replicaChunk;
+    std::vector<uint8_t>  _replicaStatus;
+    std::vector<uint64_t> _replicaVerifyTime;
+    std::vector<uint32_t> _replicaFirstFile;
+    std::vector<uint32_t> _replicaNumFiles;
+
+    // The files of the replicas
+
+    std::vector<uint32_t>    _fileName;
+    std::vector<uint64_t>    _fileSize;
+    std::vector<std::time_t> _fileMtime;
+    std::vector<uint32_t>    _fileCs;
+    std::vector<uint32_t>    _fileCsAlgorithm;
+    std::vector<uint8_t>     _filePacked;
+
+    /// The number of the files no longer used by any replica
+    size_t _numDeadFiles;
+
+    /// The indexes of the replicas by their keys
+    std::unordered_map<uint64_t, uint32_t> _index;
+
+    /// The times (milliseconds) of the listings (by worker and database)
+    std::map<std::pair<uint32_t, uint32_t>, uint64_t> _listingTime;
+
+    /// Protects the members above
+    mutable util::Mutex _mtx;
+};
+
+}}} // namespace lsst::qserv::replica
+
+#endif // LSST_QSERV_REPLICA_REPLICADIRECTORY_H
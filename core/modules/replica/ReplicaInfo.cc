@@ -66,6 +66,10 @@ void setInfoImpl(replica::ReplicaInfo const& ri,
         fileInfo->set_begin_transfer_time(fi.beginTransferTime);
         fileInfo->set_end_transfer_time(fi.endTransferTime);
         fileInfo->set_in_size(fi.inSize);
+        fileInfo->set_cs_algorithm(fi.csAlgorithm);
+        fileInfo->set_packed(fi.packed);
+        fileInfo->set_unpacked_size(fi.unpackedSize);
+        fileInfo->set_unpacked_cs(fi.unpackedCs);
     }
 }
 }  // namespace
@@ -146,7 +150,11 @@ ReplicaInfo::ReplicaInfo(proto::ReplicationReplicaInfo const* info) {
                 fileInfo.cs(),
                 fileInfo.begin_transfer_time(),
                 fileInfo.end_transfer_time(),
-                fileInfo.in_size()
+                fileInfo.in_size(),
+                fileInfo.cs_algorithm(),
+                fileInfo.packed(),
+                fileInfo.unpacked_size(),
+                fileInfo.unpacked_cs()
             })
         );
     }
@@ -227,6 +235,10 @@ ostream& operator<<(ostream& os, ReplicaInfo::FileInfo const& fi) {
         << " mtime: "  << fi.mtime
         << " inSize: " << fi.inSize
         << " cs: "     << fi.cs
+        << " csAlgorithm: " << fi.csAlgorithm
+        << " packed: "   << (fi.packed ? "true" : "false")
+        << " unpackedSize: " << fi.unpackedSize
+        << " unpackedCs: "   << fi.unpackedCs
         << " beginTransferTime: " << fi.beginTransferTime
         << " endTransferTime: "   << fi.endTransferTime
         << " completed [%]: "     << completedPercent
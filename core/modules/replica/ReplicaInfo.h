@@ -89,6 +89,49 @@ public:
         /// The size of the input file
         uint64_t inSize;
 
+        /// The algorithm of the control/check sum. It's empty for the sum
+        /// of bytes computed by FileUtils::compute_cs().
+        std::string csAlgorithm;
+
+        /// The file belongs to a table packed into the compressed read-only
+        /// format. Its size and control sum are those of the packed file.
+        bool packed;
+
+        /// The size of the file before it was packed (0 if not known)
+        uint64_t unpackedSize;
+
+        /// The control/check sum (same algorithm) of the file before it was
+        /// packed. It's only known to the packing requests and is kept by
+        /// the persistent state of the Controller for later comparisons.
+        std::string unpackedCs;
+
+        /**
+         * @param other - object to be compared with
+         * @return 'true' if the control/check sums of both objects are defined,
+         * computed with the same algorithm, and both files are either packed
+         * or not, so that they can be compared
+         */
+        bool csComparable(FileInfo const& other) const {
+            return
+                not cs.empty() and not other.cs.empty() and
+                csAlgorithm == other.csAlgorithm and
+                packed == other.packed;
+        }
+
+        /**
+         * @return the file as it was before packing. For a packed file the size
+         * and the control sum are replaced with the unpacked ones, which may
+         * not be known. Other files are returned as they are.
+         */
+        FileInfo unpacked() const {
+            if (not packed) return *this;
+            FileInfo file = *this;
+            file.size   = unpackedSize;
+            file.cs     = unpackedCs;
+            file.packed = false;
+            return file;
+        }
+
         /**
          * Comparison operator
          *
@@ -97,9 +140,10 @@ public:
          */
         bool operator==(FileInfo const& other) const {
             return
-                name == other.name and
-                size == other.size and
-                cs   == other.cs;
+                name        == other.name and
+                size        == other.size and
+                cs          == other.cs   and
+                csAlgorithm == other.csAlgorithm;
         }
 
         /**
@@ -427,6 +471,33 @@ struct QservReplica {
 /// The type definition for a collection of Qserv replicas
 typedef std::vector<QservReplica> QservReplicaCollection;
 
+/**
+ * Structure ChunkStats represents the size of one table of one chunk at
+ * a Qserv worker, and the completion times of the tasks which scanned it
+ * there, as reported by the worker management services.
+ */
+struct ChunkStats {
+    std::string  worker;
+    std::string  database;
+    std::string  table;
+    unsigned int chunk = 0;
+
+    bool     hasSize = false;       ///< the size was reported
+    uint64_t numRows = 0;
+    uint64_t dataSize = 0;          ///< bytes
+    uint64_t indexSize = 0;         ///< bytes
+    uint64_t updateTime = 0;        ///< seconds since the UNIX Epoch, 0 if not known
+
+    uint64_t tasksCompleted = 0;
+    double   avgScanSeconds = 0;    ///< weighted average of the completion times
+    double   lastScanSeconds = 0;   ///< completion time of the last task
+
+    uint64_t collectTime = 0;       ///< milliseconds since the UNIX Epoch of the last change
+};
+
+/// The type definition for a collection of chunk statistics
+typedef std::vector<ChunkStats> ChunkStatsCollection;
+
 }}} // namespace lsst::qserv::replica
 
 #endif // LSST_QSERV_REPLICA_REPLICAINFO_H
@@ -33,6 +33,7 @@
 #include "lsst/log/Log.h"
 #include "replica/Configuration.h"
 #include "replica/ErrorReporting.h"
+#include "replica/PerformanceHistory.h"
 #include "replica/ServiceProvider.h"
 #include "util/BlockPost.h"
 
@@ -123,10 +124,13 @@ void ReplicateJob::startImpl(util::Lock const& lock) {
     bool const saveReplicInfo = true;           // always save the replica info in a database because
                                                 // the algorithm depends on it.
     bool const allWorkers = false;              // only consider enabled workers
+    bool const fromDirectory = true;            // plan from the replicas known to the Controller
+                                                // if they're recent enough
     _findAllJob = FindAllJob::create(
         databaseFamily(),
         saveReplicInfo,
         allWorkers,
+        fromDirectory,
         controller(),
         id(),
         [self] (FindAllJob::Ptr job) {
@@ -264,10 +268,10 @@ void ReplicateJob::onPrecursorJobFinish() {
     std::map<std::string, std::set<unsigned int>> worker2chunks;
 
     for (auto chunk: replicaData.chunks.chunkNumbers()) {
-        auto chunkMap = replicaData.chunks.chunk(chunk);
+        auto const& chunkMap = replicaData.chunks.chunk(chunk);
 
         for (auto&& database: chunkMap.databaseNames()) {
-            auto databaseMap = chunkMap.database(database);
+            auto const& databaseMap = chunkMap.database(database);
 
             for (auto&& worker: databaseMap.workerNames()) {
                 worker2chunks[worker].insert(chunk);
@@ -285,6 +289,26 @@ void ReplicateJob::onPrecursorJobFinish() {
             workers.push_back(worker);
         }
     }
+
+    // The workers which recently were much slower than the others in
+    // processing requests are avoided as destinations, unless no other
+    // workers are left.
+
+    std::vector<std::string> const slowWorkers =
+        controller()->performanceHistory()->slowWorkers();
+
+    std::vector<std::string> fastWorkers;
+    for (auto&& worker: workers) {
+        if (not std::binary_search(slowWorkers.begin(), slowWorkers.end(), worker)) {
+            fastWorkers.push_back(worker);
+        }
+    }
+    if (not fastWorkers.empty() and fastWorkers.size() != workers.size()) {
+        LOGS(_log, LOG_LVL_INFO, context()
+             << "onPrecursorJobFinish  avoiding " << (workers.size() - fastWorkers.size())
+             << " slow worker(s) as destinations of new replicas");
+        workers = fastWorkers;
+    }
     if (not workers.size()) {
 
         LOGS(_log, LOG_LVL_ERROR, context()
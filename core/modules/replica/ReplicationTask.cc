@@ -58,10 +58,15 @@ bool ReplicationTask::onRun() {
 
     bool const saveReplicaInfo = true;
     bool const allWorkers = false;
+    bool const fromDirectory = false;
 
-    launch<FindAllJob>(saveReplicaInfo, allWorkers);
+    launch<FindAllJob>(saveReplicaInfo, allWorkers, fromDirectory);
     sync(_qservSyncTimeoutSec);
 
+    // The statistics are collected after the replicas were found, so that
+    // the ones of the chunks which are no longer at the workers get removed.
+    collectChunkStats();
+
     launch<FixUpJob>();
     sync(_qservSyncTimeoutSec);
 
@@ -0,0 +1,288 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "replica/RequestFanOut.h"
+
+// System headers
+#include <atomic>
+#include <stdexcept>
+
+// Qserv headers
+#include "lsst/log/Log.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.replica.RequestFanOut");
+
+} /// namespace
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+size_t const RequestFanOut::defaultMaxTotal = 1024;
+
+RequestFanOut::Ptr RequestFanOut::create(ServiceProvider::Ptr const& serviceProvider,
+                                         size_t maxPerWorker,
+                                         size_t maxTotal) {
+    return Ptr(new RequestFanOut(serviceProvider, maxPerWorker, maxTotal));
+}
+
+RequestFanOut::RequestFanOut(ServiceProvider::Ptr const& serviceProvider,
+                             size_t maxPerWorker,
+                             size_t maxTotal)
+    :   _serviceProvider(serviceProvider),
+        _maxPerWorker(maxPerWorker),
+        _maxTotal(maxTotal),
+        _numQueued(0),
+        _numInFlight(0) {
+
+    if (0 == maxPerWorker or 0 == maxTotal) {
+        throw std::invalid_argument("RequestFanOut::" + std::string(__func__) +
+                                    "  the limits can't be 0");
+    }
+}
+
+void RequestFanOut::setLimits(size_t maxPerWorker,
+                              size_t maxTotal) {
+
+    if (0 == maxPerWorker or 0 == maxTotal) {
+        throw std::invalid_argument("RequestFanOut::" + std::string(__func__) +
+                                    "  the limits can't be 0");
+    }
+    std::vector<Launch> launches;
+    {
+        util::Lock lock(_mtx, context() + "setLimits");
+        _maxPerWorker = maxPerWorker;
+        _maxTotal = maxTotal;
+        dispatch(lock, launches);
+    }
+    launch(launches);
+}
+
+size_t RequestFanOut::maxPerWorker() const {
+    util::Lock lock(_mtx, context() + "maxPerWorker");
+    return _maxPerWorker;
+}
+
+size_t RequestFanOut::maxTotal() const {
+    util::Lock lock(_mtx, context() + "maxTotal");
+    return _maxTotal;
+}
+
+void RequestFanOut::submit(std::string const& jobId,
+                           std::string const& worker,
+                           int priority,
+                           LaunchType const& launch) {
+
+    std::vector<Launch> launches;
+    {
+        util::Lock lock(_mtx, context() + "submit");
+
+        Lane& lane = _lanes[priority];
+        auto itr = lane.queues.find(worker);
+        if (itr == lane.queues.end()) {
+            itr = lane.queues.emplace(worker, WorkerQueue()).first;
+            itr->second.position = lane.workers.insert(lane.workers.end(), worker);
+        }
+        itr->second.operations.push_back(Operation{jobId, launch});
+        ++_numQueued;
+
+        dispatch(lock, worker, launches);
+    }
+    this->launch(launches);
+}
+
+size_t RequestFanOut::cancel(std::string const& jobId) {
+
+    util::Lock lock(_mtx, context() + "cancel");
+
+    size_t numDropped = 0;
+    for (auto laneItr = _lanes.begin(); laneItr != _lanes.end();) {
+        Lane& lane = laneItr->second;
+        for (auto itr = lane.queues.begin(); itr != lane.queues.end();) {
+            auto& operations = itr->second.operations;
+            for (auto opItr = operations.begin(); opItr != operations.end();) {
+                if (opItr->jobId == jobId) {
+                    opItr = operations.erase(opItr);
+                    ++numDropped;
+                } else {
+                    ++opItr;
+                }
+            }
+            if (operations.empty()) {
+                lane.workers.erase(itr->second.position);
+                itr = lane.queues.erase(itr);
+            } else {
+                ++itr;
+            }
+        }
+        if (lane.queues.empty()) laneItr = _lanes.erase(laneItr);
+        else                     ++laneItr;
+    }
+    _numQueued -= numDropped;
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "cancel  jobId=" << jobId
+         << " numDropped=" << numDropped);
+
+    return numDropped;
+}
+
+size_t RequestFanOut::numQueued() const {
+    util::Lock lock(_mtx, context() + "numQueued");
+    return _numQueued;
+}
+
+size_t RequestFanOut::numInFlight() const {
+    util::Lock lock(_mtx, context() + "numInFlight");
+    return _numInFlight;
+}
+
+size_t RequestFanOut::numInFlight(std::string const& worker) const {
+    util::Lock lock(_mtx, context() + "numInFlight");
+    auto const itr = _inFlight.find(worker);
+    return itr == _inFlight.end() ? 0 : itr->second;
+}
+
+void RequestFanOut::dispatch(util::Lock const& lock,
+                             std::vector<Launch>& launches) {
+
+    // Each round over the workers of a lane takes at most one operation
+    // of a worker. The rounds go on while they take anything, and then
+    // the lane of the next priority gets the slots left.
+
+    for (auto laneItr = _lanes.begin();
+         laneItr != _lanes.end() and _numInFlight < _maxTotal;) {
+
+        Lane& lane = laneItr->second;
+        bool taken = true;
+        while (taken and _numInFlight < _maxTotal and not lane.workers.empty()) {
+            taken = false;
+            size_t const numWorkers = lane.workers.size();
+            for (size_t i = 0; i < numWorkers and _numInFlight < _maxTotal; ++i) {
+                std::string const worker = lane.workers.front();
+                if (allowed(lock, worker)) {
+                    take(lock, lane, worker, launches);
+                    taken = true;
+                } else {
+                    lane.workers.splice(lane.workers.end(), lane.workers, lane.workers.begin());
+                }
+            }
+        }
+        if (lane.workers.empty()) laneItr = _lanes.erase(laneItr);
+        else                      ++laneItr;
+    }
+}
+
+void RequestFanOut::dispatch(util::Lock const& lock,
+                             std::string const& worker,
+                             std::vector<Launch>& launches) {
+
+    for (auto laneItr = _lanes.begin();
+         laneItr != _lanes.end() and allowed(lock, worker);) {
+
+        Lane& lane = laneItr->second;
+        if (lane.queues.count(worker)) take(lock, lane, worker, launches);
+
+        if (lane.workers.empty()) laneItr = _lanes.erase(laneItr);
+        else                      ++laneItr;
+    }
+}
+
+void RequestFanOut::take(util::Lock const& lock,
+                         Lane& lane,
+                         std::string const& worker,
+                         std::vector<Launch>& launches) {
+
+    auto const itr = lane.queues.find(worker);
+    auto& operations = itr->second.operations;
+
+    launches.push_back(Launch{worker, std::move(operations.front().launch)});
+    operations.pop_front();
+
+    --_numQueued;
+    ++_numInFlight;
+    ++_inFlight[worker];
+
+    if (operations.empty()) {
+        lane.workers.erase(itr->second.position);
+        lane.queues.erase(itr);
+    } else {
+        lane.workers.splice(lane.workers.end(), lane.workers, itr->second.position);
+    }
+}
+
+bool RequestFanOut::allowed(util::Lock const& lock,
+                            std::string const& worker) const {
+
+    if (_numInFlight >= _maxTotal) return false;
+    auto const itr = _inFlight.find(worker);
+    return itr == _inFlight.end() or itr->second < _maxPerWorker;
+}
+
+void RequestFanOut::launch(std::vector<Launch> const& launches) {
+
+    auto const self = shared_from_this();
+    for (auto&& entry: launches) {
+        std::string const worker = entry.worker;
+        LaunchType  const launch = entry.launch;
+        _serviceProvider->io_service().post([self, worker, launch] () {
+
+            // The slot is released by the first call to 'done' only
+
+            auto const finished = std::make_shared<std::atomic<bool>>(false);
+            DoneType const done = [self, worker, finished] () {
+                if (not finished->exchange(true)) self->onDone(worker);
+            };
+            try {
+                launch(done);
+            } catch (std::exception const& ex) {
+                LOGS(_log, LOG_LVL_ERROR, self->context() << "launch  worker=" << worker
+                     << " failed: " << ex.what());
+                done();
+            }
+        });
+    }
+}
+
+void RequestFanOut::onDone(std::string const& worker) {
+
+    std::vector<Launch> launches;
+    {
+        util::Lock lock(_mtx, context() + "onDone");
+
+        // Other workers may only be waiting for the slot if all slots were taken
+
+        bool const saturated = _numInFlight >= _maxTotal;
+
+        --_numInFlight;
+        auto const itr = _inFlight.find(worker);
+        if (0 == --(itr->second)) _inFlight.erase(itr);
+
+        if (saturated) dispatch(lock, launches);
+        else           dispatch(lock, worker, launches);
+    }
+    launch(launches);
+}
+
+}}} // namespace lsst::qserv::replica
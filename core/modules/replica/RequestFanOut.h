@@ -0,0 +1,262 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_REPLICA_REQUESTFANOUT_H
+#define LSST_QSERV_REPLICA_REQUESTFANOUT_H
+
+// System headers
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "replica/ServiceProvider.h"
+#include "util/Mutex.h"
+
+// This header declarations
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+/**
+ * Class RequestFanOut paces the requests which jobs send to many workers
+ * at once. The operations submitted by the jobs are queued in priority
+ * lanes and launched as long as the number of the operations in flight
+ * stays within the limits set for each worker and for all workers.
+ *
+ * Within a lane the workers are served in a round-robin order, so that
+ * the jobs of different kinds which share a worker also share its limit.
+ * The operations of a lane are launched only when no operation of a higher
+ * priority lane is waiting for the same worker.
+ *
+ * The operations are launched in the threads of the I/O service, never
+ * in the context of the caller of submit(), or of the completion which
+ * freed the slot. The mutex of the object is never held while launching
+ * an operation, and the results of the operations are collected by
+ * the jobs themselves.
+ */
+class RequestFanOut
+    :   public std::enable_shared_from_this<RequestFanOut> {
+
+public:
+
+    /// The pointer type for instances of the class
+    typedef std::shared_ptr<RequestFanOut> Ptr;
+
+    /// The function to be called when a launched operation has finished
+    typedef std::function<void()> DoneType;
+
+    /**
+     * The function launching an operation. It must arrange for 'done'
+     * to be called when the operation finishes, or call it right away
+     * if nothing was launched. Extra calls to 'done' are ignored.
+     */
+    typedef std::function<void(DoneType const& done)> LaunchType;
+
+    /// The default limit for the number of operations in flight for all workers
+    static size_t const defaultMaxTotal;
+
+    /**
+     * The factory method for instances of the class
+     *
+     * @param serviceProvider - provider of various services
+     * @param maxPerWorker    - the maximum number of operations in flight for a worker
+     * @param maxTotal        - the maximum number of operations in flight for all workers
+     *
+     * @return pointer to the new object
+     *
+     * @throws std::invalid_argument - if any limit is 0
+     */
+    static Ptr create(ServiceProvider::Ptr const& serviceProvider,
+                      size_t maxPerWorker,
+                      size_t maxTotal=defaultMaxTotal);
+
+    // Default construction and copy semantics are prohibited
+
+    RequestFanOut() = delete;
+    RequestFanOut(RequestFanOut const&) = delete;
+    RequestFanOut& operator=(RequestFanOut const&) = delete;
+
+    ~RequestFanOut() = default;
+
+    /**
+     * Change the limits. The operations in flight aren't affected, and raising
+     * the limits launches the queued operations which are now allowed.
+     *
+     * @throws std::invalid_argument - if any limit is 0
+     */
+    void setLimits(size_t maxPerWorker,
+                   size_t maxTotal);
+
+    /// @return the maximum number of operations in flight for a worker
+    size_t maxPerWorker() const;
+
+    /// @return the maximum number of operations in flight for all workers
+    size_t maxTotal() const;
+
+    /**
+     * Queue an operation, and launch it if the limits allow
+     *
+     * @param jobId    - an identifier of the job which submitted the operation
+     * @param worker   - the name of the worker targeted by the operation
+     * @param priority - the priority lane (larger values mean higher priority)
+     * @param launch   - the function launching the operation
+     */
+    void submit(std::string const& jobId,
+                std::string const& worker,
+                int priority,
+                LaunchType const& launch);
+
+    /**
+     * Drop the operations of a job which haven't been launched yet
+     *
+     * @param jobId - an identifier of the job
+     *
+     * @return the number of the operations dropped
+     */
+    size_t cancel(std::string const& jobId);
+
+    /// @return the number of operations waiting to be launched
+    size_t numQueued() const;
+
+    /// @return the number of operations in flight for all workers
+    size_t numInFlight() const;
+
+    /// @return the number of operations in flight for a worker
+    size_t numInFlight(std::string const& worker) const;
+
+private:
+
+    /// An operation waiting to be launched
+    struct Operation {
+        std::string jobId;
+        LaunchType  launch;
+    };
+
+    /// The operations of a lane waiting for a worker
+    struct WorkerQueue {
+        std::deque<Operation> operations;
+
+        /// The position of the worker in the round-robin order of the lane
+        std::list<std::string>::iterator position;
+    };
+
+    /// The operations of one priority level
+    struct Lane {
+        std::map<std::string, WorkerQueue> queues;
+
+        /// The round-robin order of the workers which have operations queued
+        std::list<std::string> workers;
+    };
+
+    /// The lanes, the highest priority first
+    typedef std::map<int, Lane, std::greater<int>> Lanes;
+
+    /// An operation to be launched after releasing the lock
+    struct Launch {
+        std::string worker;
+        LaunchType  launch;
+    };
+
+    /// @see RequestFanOut::create()
+    RequestFanOut(ServiceProvider::Ptr const& serviceProvider,
+                  size_t maxPerWorker,
+                  size_t maxTotal);
+
+    /**
+     * Take the operations allowed by the limits off the lanes
+     *
+     * @param lock     - a lock on a mutex must be acquired before calling this method
+     * @param launches - the operations to be launched
+     */
+    void dispatch(util::Lock const& lock,
+                  std::vector<Launch>& launches);
+
+    /**
+     * Take the next operation of a worker off the lanes, if the limits allow
+     *
+     * @param lock     - a lock on a mutex must be acquired before calling this method
+     * @param worker   - the name of the worker
+     * @param launches - the operation to be launched (if any) is added here
+     */
+    void dispatch(util::Lock const& lock,
+                  std::string const& worker,
+                  std::vector<Launch>& launches);
+
+    /**
+     * Take the first operation of a worker off a lane, and account for it
+     * in the numbers of operations in flight. The worker is moved to the end
+     * of the round-robin order of the lane, or removed from the lane if it
+     * has no more operations there.
+     *
+     * @param lock     - a lock on a mutex must be acquired before calling this method
+     * @param lane     - the lane
+     * @param worker   - the name of a worker which has operations queued in the lane
+     * @param launches - the operation is added here
+     */
+    void take(util::Lock const& lock,
+              Lane& lane,
+              std::string const& worker,
+              std::vector<Launch>& launches);
+
+    /// @return 'true' if the limits allow one more operation for the worker
+    bool allowed(util::Lock const& lock,
+                 std::string const& worker) const;
+
+    /// Post the operations into the I/O service
+    void launch(std::vector<Launch> const& launches);
+
+    /// Release the slot of an operation which has finished
+    void onDone(std::string const& worker);
+
+    /// @return the context string for debugging and diagnostic printouts
+    std::string context() const { return "REQUEST-FAN-OUT  "; }
+
+private:
+
+    ServiceProvider::Ptr const _serviceProvider;
+
+    size_t _maxPerWorker;
+    size_t _maxTotal;
+
+    Lanes _lanes;
+
+    /// The number of operations waiting in the lanes
+    size_t _numQueued;
+
+    /// The number of operations in flight for all workers
+    size_t _numInFlight;
+
+    /// The number of operations in flight (by worker)
+    std::map<std::string, size_t> _inFlight;
+
+    /// Protects the members above
+    mutable util::Mutex _mtx;
+};
+
+}}} // namespace lsst::qserv::replica
+
+#endif // LSST_QSERV_REPLICA_REQUESTFANOUT_H
@@ -67,6 +67,36 @@ typedef std::shared_ptr<FindAllRequest> FindAllRequestPtr;
 typedef std::function<void(FindRequestPtr)>    FindRequestCallbackType;
 typedef std::function<void(FindAllRequestPtr)> FindAllRequestCallbackType;
 
+////////////////////////////
+// Chunk ingest requests //
+////////////////////////////
+
+class IngestRequest;
+
+typedef std::shared_ptr<IngestRequest> IngestRequestPtr;
+
+typedef std::function<void(IngestRequestPtr)> IngestRequestCallbackType;
+
+/////////////////////////////
+// Secondary index requests //
+/////////////////////////////
+
+class IndexRequest;
+
+typedef std::shared_ptr<IndexRequest> IndexRequestPtr;
+
+typedef std::function<void(IndexRequestPtr)> IndexRequestCallbackType;
+
+////////////////////////////////////////////
+// Requests packing the tables of a chunk //
+////////////////////////////////////////////
+
+class PackRequest;
+
+typedef std::shared_ptr<PackRequest> PackRequestPtr;
+
+typedef std::function<void(PackRequestPtr)> PackRequestCallbackType;
+
 /////////////////////////////////////////////////////////
 // Protocol and Replication framework testing requests //
 ////////////////////////////////////////////////////////
@@ -166,6 +196,12 @@ typedef std::function<void(ServiceStatusRequestPtr)>   ServiceStatusRequestCallb
 typedef std::function<void(ServiceRequestsRequestPtr)> ServiceRequestsRequestCallbackType;
 typedef std::function<void(ServiceDrainRequestPtr)>    ServiceDrainRequestCallbackType;
 
+class ServiceThrottleRequest;
+
+typedef std::shared_ptr<ServiceThrottleRequest> ServiceThrottleRequestPtr;
+
+typedef std::function<void(ServiceThrottleRequestPtr)> ServiceThrottleRequestCallbackType;
+
 }}} // namespace lsst::qserv::replica
 
 #endif // LSST_QSERV_REPLICA_REQUESTTYPESFWD_H
@@ -0,0 +1,142 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "replica/SecondaryIndexRun.h"
+
+// System headers
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+/// The size of the stream buffers of the files
+size_t const bufSize = 1024 * 1024;
+
+/// The top of the heap is the smallest key, the ties are broken by
+/// the order of the runs.
+bool greater(std::pair<lsst::qserv::replica::SecondaryIndexRecord, size_t> const& lhs,
+             std::pair<lsst::qserv::replica::SecondaryIndexRecord, size_t> const& rhs) {
+    if (lhs.first.key != rhs.first.key) return lhs.first.key > rhs.first.key;
+    return lhs.second > rhs.second;
+}
+
+} /// namespace
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+SecondaryIndexFileRunReader::SecondaryIndexFileRunReader(std::string const& path)
+    :   _path(path),
+        _fp(std::fopen(path.c_str(), "rb")),
+        _buf(::bufSize) {
+
+    if (_fp == nullptr) {
+        throw std::runtime_error(
+                "SecondaryIndexFileRunReader  failed to open file: " + _path +
+                ", error: " + std::strerror(errno));
+    }
+    std::setvbuf(_fp, _buf.data(), _IOFBF, _buf.size());
+}
+
+SecondaryIndexFileRunReader::~SecondaryIndexFileRunReader() {
+    std::fclose(_fp);
+}
+
+bool SecondaryIndexFileRunReader::read(SecondaryIndexRecord& record) {
+    if (std::fread(&record, sizeof(record), 1, _fp) == 1) return true;
+    if (std::ferror(_fp)) {
+        throw std::runtime_error(
+                "SecondaryIndexFileRunReader  failed to read file: " + _path +
+                ", error: " + std::strerror(errno));
+    }
+    return false;
+}
+
+SecondaryIndexRunWriter::SecondaryIndexRunWriter(std::string const& path)
+    :   _path(path),
+        _fp(std::fopen(path.c_str(), "wb")),
+        _buf(::bufSize) {
+
+    if (_fp == nullptr) {
+        throw std::runtime_error(
+                "SecondaryIndexRunWriter  failed to create file: " + _path +
+                ", error: " + std::strerror(errno));
+    }
+    std::setvbuf(_fp, _buf.data(), _IOFBF, _buf.size());
+}
+
+SecondaryIndexRunWriter::~SecondaryIndexRunWriter() {
+    if (_fp != nullptr) std::fclose(_fp);
+}
+
+void SecondaryIndexRunWriter::write(SecondaryIndexRecord const& record) {
+    if (std::fwrite(&record, sizeof(record), 1, _fp) != 1) {
+        throw std::runtime_error(
+                "SecondaryIndexRunWriter  failed to write file: " + _path +
+                ", error: " + std::strerror(errno));
+    }
+}
+
+void SecondaryIndexRunWriter::close() {
+    if (_fp == nullptr) return;
+    int const result = std::fclose(_fp);
+    _fp = nullptr;
+    if (result != 0) {
+        throw std::runtime_error(
+                "SecondaryIndexRunWriter  failed to close file: " + _path +
+                ", error: " + std::strerror(errno));
+    }
+}
+
+SecondaryIndexRunMerger::SecondaryIndexRunMerger(std::vector<SecondaryIndexRunReader::Ptr> const& runs)
+    :   _runs(runs) {
+
+    for (size_t i = 0; i < _runs.size(); ++i) {
+        SecondaryIndexRecord record;
+        if (_runs[i]->read(record)) _heap.emplace_back(record, i);
+    }
+    std::make_heap(_heap.begin(), _heap.end(), ::greater);
+}
+
+bool SecondaryIndexRunMerger::read(SecondaryIndexRecord& record) {
+
+    if (_heap.empty()) return false;
+
+    std::pop_heap(_heap.begin(), _heap.end(), ::greater);
+    record = _heap.back().first;
+
+    // Replace the record with the next one of the same run
+
+    size_t const run = _heap.back().second;
+    if (_runs[run]->read(_heap.back().first)) {
+        std::push_heap(_heap.begin(), _heap.end(), ::greater);
+    } else {
+        _heap.pop_back();
+    }
+    return true;
+}
+
+}}} // namespace lsst::qserv::replica
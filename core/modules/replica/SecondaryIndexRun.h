@@ -0,0 +1,194 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_REPLICA_SECONDARYINDEXRUN_H
+#define LSST_QSERV_REPLICA_SECONDARYINDEXRUN_H
+
+/**
+ * This header declares the sorted runs of the secondary index entries
+ * written by the workers and merged by the Controller.
+ *
+ * A run is a file of fixed size records (the key of a row of a director
+ * table, its chunk and its subchunk), in host byte order, sorted by the key.
+ */
+
+// System headers
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// This header declarations
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+/**
+ * Structure SecondaryIndexRecord represents an entry of the secondary index
+ */
+struct SecondaryIndexRecord {
+    int64_t key;
+    int32_t chunk;
+    int32_t subChunk;
+};
+
+/// The records are ordered by their keys
+inline bool operator<(SecondaryIndexRecord const& lhs, SecondaryIndexRecord const& rhs) {
+    return lhs.key < rhs.key;
+}
+
+/**
+ * Class SecondaryIndexRunReader is the base class for the sources
+ * of the sorted records.
+ */
+class SecondaryIndexRunReader {
+
+public:
+
+    /// The pointer type for instances of the class
+    typedef std::shared_ptr<SecondaryIndexRunReader> Ptr;
+
+    virtual ~SecondaryIndexRunReader() = default;
+
+    /**
+     * Read the next record of the run
+     *
+     * @param record - the record to be initialized
+     *
+     * @return 'false' if past the last record of the run
+     *
+     * @throws std::runtime_error - if the run couldn't be read
+     */
+    virtual bool read(SecondaryIndexRecord& record) = 0;
+};
+
+/**
+ * Class SecondaryIndexFileRunReader reads a run from a local file
+ */
+class SecondaryIndexFileRunReader
+    :   public SecondaryIndexRunReader {
+
+public:
+
+    /**
+     * @param path - the path to the file
+     *
+     * @throws std::runtime_error - if the file couldn't be opened
+     */
+    explicit SecondaryIndexFileRunReader(std::string const& path);
+
+    SecondaryIndexFileRunReader() = delete;
+    SecondaryIndexFileRunReader(SecondaryIndexFileRunReader const&) = delete;
+    SecondaryIndexFileRunReader& operator=(SecondaryIndexFileRunReader const&) = delete;
+
+    ~SecondaryIndexFileRunReader() override;
+
+    /// @see SecondaryIndexRunReader::read()
+    bool read(SecondaryIndexRecord& record) override;
+
+private:
+
+    std::string const _path;
+
+    std::FILE* _fp;
+
+    /// The stream buffer of the file
+    std::vector<char> _buf;
+};
+
+/**
+ * Class SecondaryIndexRunWriter writes a run into a local file. The records
+ * are expected to be written in the order of their keys.
+ */
+class SecondaryIndexRunWriter {
+
+public:
+
+    /**
+     * @param path - the path to the file, which is truncated if it exists
+     *
+     * @throws std::runtime_error - if the file couldn't be created
+     */
+    explicit SecondaryIndexRunWriter(std::string const& path);
+
+    SecondaryIndexRunWriter() = delete;
+    SecondaryIndexRunWriter(SecondaryIndexRunWriter const&) = delete;
+    SecondaryIndexRunWriter& operator=(SecondaryIndexRunWriter const&) = delete;
+
+    /// The file is closed (if it's still open) w/o reporting errors
+    ~SecondaryIndexRunWriter();
+
+    /// @throws std::runtime_error - if the record couldn't be written
+    void write(SecondaryIndexRecord const& record);
+
+    /// @throws std::runtime_error - if the file couldn't be flushed
+    void close();
+
+private:
+
+    std::string const _path;
+
+    std::FILE* _fp;
+
+    /// The stream buffer of the file
+    std::vector<char> _buf;
+};
+
+/**
+ * Class SecondaryIndexRunMerger merges sorted runs into one sorted sequence
+ * of records. Since the merger is a run itself, the merge of many runs may be
+ * done in a few passes, each one reading a limited number of runs.
+ */
+class SecondaryIndexRunMerger
+    :   public SecondaryIndexRunReader {
+
+public:
+
+    /**
+     * @param runs - the runs to be merged
+     *
+     * @throws std::runtime_error - if the runs couldn't be read
+     */
+    explicit SecondaryIndexRunMerger(std::vector<SecondaryIndexRunReader::Ptr> const& runs);
+
+    SecondaryIndexRunMerger() = delete;
+    SecondaryIndexRunMerger(SecondaryIndexRunMerger const&) = delete;
+    SecondaryIndexRunMerger& operator=(SecondaryIndexRunMerger const&) = delete;
+
+    ~SecondaryIndexRunMerger() override = default;
+
+    /// @see SecondaryIndexRunReader::read()
+    bool read(SecondaryIndexRecord& record) override;
+
+private:
+
+    std::vector<SecondaryIndexRunReader::Ptr> const _runs;
+
+    /// The next record of each non-empty run, arranged as a min-heap
+    std::vector<std::pair<SecondaryIndexRecord, size_t>> _heap;
+};
+
+}}} // namespace lsst::qserv::replica
+
+#endif // LSST_QSERV_REPLICA_SECONDARYINDEXRUN_H
@@ -25,14 +25,19 @@
 /**
  * This header declares tools for constructing the header-only views for nested
  * Standard Library's maps. Also a few ready to use algorithms are provided
- * for some most commonly used map.
+ * for some most commonly used map. The flat variant of the worker-database-chunk
+ * map keeps its elements in a sorted vector, and its algorithms are linear merges.
  */
 
 // System headers
+#include <algorithm>
+#include <cstdint>
 #include <iosfwd>
 #include <map>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 
@@ -594,6 +599,278 @@ size_t count(WorkerDatabaseChunkMap<T> const& d) {
 
 }  // namespace SemanticMaps
 
+/**
+ * Class NameDictionary interns names of workers and databases as small
+ * integer identifiers. The identifiers are assigned in the order the names
+ * are first seen, which is why maps whose keys are compared with each other
+ * have to share the same dictionary.
+ */
+class NameDictionary {
+
+public:
+
+    typedef std::shared_ptr<NameDictionary> Ptr;
+
+    /// The largest number of names which could be interned
+    static size_t const maxSize = 1 << 16;
+
+    static Ptr create() { return std::make_shared<NameDictionary>(); }
+
+    /**
+     * @return
+     *   the identifier of the name (interned at the first call)
+     *
+     * @throws std::range_error
+     *   if the dictionary is full
+     */
+    uint16_t id(std::string const& name) {
+        auto itr = _ids.find(name);
+        if (itr != _ids.end()) return itr->second;
+        if (_names.size() >= maxSize) {
+            throw std::range_error(
+                    "NameDictionary::id  too many names, the limit is: " + std::to_string(maxSize));
+        }
+        uint16_t const id = _names.size();
+        _ids[name] = id;
+        _names.push_back(name);
+        return id;
+    }
+
+    /**
+     * @return
+     *   the name for the identifier
+     *
+     * @throws std::out_of_range
+     *   if no such identifier was assigned
+     */
+    std::string const& name(uint16_t id) const { return _names.at(id); }
+
+    size_t size() const { return _names.size(); }
+
+private:
+
+    std::unordered_map<std::string, uint16_t> _ids;
+    std::vector<std::string> _names;
+};
+
+/**
+ * Class template FlatWorkerDatabaseChunkMap is a flat alternative to
+ * WorkerDatabaseChunkMap. Worker and database names are interned by
+ * a NameDictionary, and each element is stored under a single 64-bit key
+ * packing the worker (16 bits), the database (16 bits) and the chunk number
+ * (32 bits) in a vector sorted by the key. The set operations provided
+ * in namespace SemanticMaps for these maps are linear merges of the vectors.
+ *
+ * Elements are appended by method insert() and the vector gets sorted
+ * the next time the elements are read. Like with method atChunk() of
+ * the nested map, a later insert of the same key replaces the value.
+ *
+ * @note
+ *   the elements are ordered by the identifiers of the names, not
+ *   alphabetically by the names.
+ */
+template <typename T>
+class FlatWorkerDatabaseChunkMap {
+
+public:
+
+    typedef uint64_t KeyType;
+
+    struct Entry {
+        KeyType key;
+        T value;
+    };
+
+    typedef typename std::vector<Entry>::const_iterator const_iterator;
+
+    static KeyType key(uint16_t worker, uint16_t database, unsigned int chunk) {
+        return (KeyType(worker) << 48) | (KeyType(database) << 32) | KeyType(uint32_t(chunk));
+    }
+
+    explicit FlatWorkerDatabaseChunkMap(NameDictionary::Ptr const& dictionary = NameDictionary::create())
+        :   _dictionary(dictionary),
+            _sorted(true) {
+    }
+
+    FlatWorkerDatabaseChunkMap(FlatWorkerDatabaseChunkMap const&) = default;
+    FlatWorkerDatabaseChunkMap& operator=(FlatWorkerDatabaseChunkMap const&) = default;
+
+    ~FlatWorkerDatabaseChunkMap() = default;
+
+    NameDictionary::Ptr const& dictionary() const { return _dictionary; }
+
+    void insert(std::string const& worker,
+                std::string const& database,
+                unsigned int chunk,
+                T const& value) {
+        insert(key(_dictionary->id(worker), _dictionary->id(database), chunk), value);
+    }
+
+    /// Insert an element with a key built by the same dictionary
+    void insert(KeyType key, T const& value) {
+        if (_sorted and not _entries.empty() and key <= _entries.back().key) _sorted = false;
+        _entries.push_back(Entry{key, value});
+    }
+
+    /// Pre-allocate space for the elements
+    void reserve(size_t num) { _entries.reserve(num); }
+
+    size_t size() const { _sort(); return _entries.size(); }
+
+    bool empty() const { return _entries.empty(); }
+
+    void clear() { _entries.clear(); _sorted = true; }
+
+    const_iterator begin() const { _sort(); return _entries.begin(); }
+    const_iterator end()   const { _sort(); return _entries.end(); }
+
+    std::string const& worker(Entry const& entry) const {
+        return _dictionary->name(entry.key >> 48);
+    }
+
+    std::string const& database(Entry const& entry) const {
+        return _dictionary->name((entry.key >> 32) & 0xffff);
+    }
+
+    static unsigned int chunk(Entry const& entry) { return entry.key & 0xffffffff; }
+
+private:
+
+    /// Sort the elements by their keys and keep the last value of each key
+    void _sort() const {
+        if (_sorted) return;
+        std::stable_sort(_entries.begin(), _entries.end(),
+                         [](Entry const& a, Entry const& b) { return a.key < b.key; });
+        auto out = _entries.begin();
+        for (auto itr = _entries.begin(); itr != _entries.end(); ++itr) {
+            auto next = itr + 1;
+            if (next != _entries.end() and next->key == itr->key) continue;
+            if (out != itr) *out = std::move(*itr);
+            ++out;
+        }
+        _entries.erase(out, _entries.end());
+        _sorted = true;
+    }
+
+    NameDictionary::Ptr _dictionary;
+
+    // The elements are sorted lazily by the const accessors
+    mutable std::vector<Entry> _entries;
+    mutable bool _sorted;
+};
+
+namespace SemanticMaps {
+
+/// @throws std::invalid_argument if the maps don't share the same name dictionary
+template<typename T>
+void checkSameDictionary(FlatWorkerDatabaseChunkMap<T> const& one,
+                       FlatWorkerDatabaseChunkMap<T> const& two,
+                       std::string const& func) {
+    if (one.dictionary() != two.dictionary()) {
+        throw std::invalid_argument(
+                "SemanticMaps::" + func + "  maps with different name dictionaries can't be compared");
+    }
+}
+
+/**
+ * One-directional comparison of flat dictionaries of: worker-database-chunk
+ *
+ * @see diff(WorkerDatabaseChunkMap<T> const&,WorkerDatabaseChunkMap<T> const&,WorkerDatabaseChunkMap<T>&)
+ *
+ * @throws std::invalid_argument
+ *   if the maps don't share the same name dictionary
+ */
+template<typename T>
+bool diff(FlatWorkerDatabaseChunkMap<T> const& one,
+          FlatWorkerDatabaseChunkMap<T> const& two,
+          FlatWorkerDatabaseChunkMap<T>& inFirstOnly) {
+
+    checkSameDictionary(one, two, "diff");
+
+    inFirstOnly = FlatWorkerDatabaseChunkMap<T>(one.dictionary());
+
+    auto itr1 = one.begin();
+    auto itr2 = two.begin();
+    while (itr1 != one.end()) {
+        if (itr2 == two.end() or itr1->key < itr2->key) {
+            inFirstOnly.insert(itr1->key, itr1->value);
+            ++itr1;
+        } else if (itr2->key < itr1->key) {
+            ++itr2;
+        } else {
+            ++itr1;
+            ++itr2;
+        }
+    }
+    return not inFirstOnly.empty();
+}
+
+/**
+ * Bi-directional comparison of flat dictionaries of: worker-database-chunk
+ *
+ * @see diff2(WorkerDatabaseChunkMap<T> const&,WorkerDatabaseChunkMap<T> const&,WorkerDatabaseChunkMap<T>&,WorkerDatabaseChunkMap<T>&)
+ *
+ * @throws std::invalid_argument
+ *   if the maps don't share the same name dictionary
+ */
+template<typename T>
+bool diff2(FlatWorkerDatabaseChunkMap<T> const& one,
+           FlatWorkerDatabaseChunkMap<T> const& two,
+           FlatWorkerDatabaseChunkMap<T>& inFirstOnly,
+           FlatWorkerDatabaseChunkMap<T>& inSecondOnly) {
+
+    bool const notEqual1 = diff<T>(one, two, inFirstOnly);
+    bool const notEqual2 = diff<T>(two, one, inSecondOnly);
+
+    return notEqual1 or notEqual2;
+}
+
+/**
+ * Find an intersection of two flat dictionaries of: worker-database-chunk
+ *
+ * The values are taken from the first map. The elements of intersect(one,two)
+ * and intersect(two,one) have the same keys in the same order, which allows
+ * comparing the values of both maps by walking the results side by side.
+ *
+ * @throws std::invalid_argument
+ *   if the maps don't share the same name dictionary
+ */
+template<typename T>
+void intersect(FlatWorkerDatabaseChunkMap<T> const& one,
+               FlatWorkerDatabaseChunkMap<T> const& two,
+               FlatWorkerDatabaseChunkMap<T>& inBoth) {
+
+    checkSameDictionary(one, two, "intersect");
+
+    inBoth = FlatWorkerDatabaseChunkMap<T>(one.dictionary());
+
+    auto itr1 = one.begin();
+    auto itr2 = two.begin();
+    while (itr1 != one.end() and itr2 != two.end()) {
+        if (itr1->key < itr2->key) {
+            ++itr1;
+        } else if (itr2->key < itr1->key) {
+            ++itr2;
+        } else {
+            inBoth.insert(itr1->key, itr1->value);
+            ++itr1;
+            ++itr2;
+        }
+    }
+}
+
+/**
+ * Count the elements of a flat dictionary
+ * @param d input dictionary to be tested
+ * @return  the total number of elements
+ */
+template<typename T>
+size_t count(FlatWorkerDatabaseChunkMap<T> const& d) {
+    return d.size();
+}
+
+}  // namespace SemanticMaps
+
 }}} // namespace lsst::qserv::replica
 
 #endif // LSST_QSERV_REPLICA_SEMANTICMAPS_H
@@ -129,6 +129,9 @@ void ServiceState::set(proto::ReplicationServiceResponse const& message) {
     numInProgressRequests = message.num_in_progress_requests();
     numFinishedRequests   = message.num_finished_requests();
 
+    fsMaxRateBytesPerSec       = message.fs_max_rate_bytes_per_sec();
+    fsEffectiveRateBytesPerSec = message.fs_effective_rate_bytes_per_sec();
+
     for (int num = message.new_requests_size(), idx = 0; idx < num; ++idx) {
         newRequests.emplace_back(message.new_requests(idx));
     }
@@ -151,7 +154,9 @@ std::ostream& operator<<(std::ostream& os, ServiceState const& ss) {
         << "    start time [ms]:            " << ss.startTime << " (" << secondsAgo << " seconds ago)\n"
         << "    total new requests:         " << ss.numNewRequests << "\n"
         << "    total in-progress requests: " << ss.numInProgressRequests << "\n"
-        << "    total finished requests:    " << ss.numFinishedRequests << "\n";
+        << "    total finished requests:    " << ss.numFinishedRequests << "\n"
+        << "    fs max rate [B/s]:          " << ss.fsMaxRateBytesPerSec << "\n"
+        << "    fs effective rate [B/s]:    " << ss.fsEffectiveRateBytesPerSec << "\n";
 
     os  << "\n  New:\n";
     ::dumpRequestInfo(os, ss.newRequests);
@@ -218,6 +223,7 @@ void ServiceManagementRequestBase::startImpl(util::Lock const& lock) {
     hdr.set_service_type(_requestType);
 
     buffer()->serialize(hdr);
+    serializeBody(lock);
 
     // Send the message
 
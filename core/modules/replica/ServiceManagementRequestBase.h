@@ -69,6 +69,13 @@ struct ServiceState {
     uint32_t numInProgressRequests;
     uint32_t numFinishedRequests;
 
+    /// The configured bandwidth limit of the worker's file server
+    /// (bytes per second, 0 means no limit)
+    uint64_t fsMaxRateBytesPerSec;
+
+    /// The limit after taking into account the load of the worker's host
+    uint64_t fsEffectiveRateBytesPerSec;
+
     std::vector<proto::ReplicationServiceResponseInfo> newRequests;
     std::vector<proto::ReplicationServiceResponseInfo> inProgressRequests;
     std::vector<proto::ReplicationServiceResponseInfo> finishedRequests;
@@ -137,6 +144,15 @@ protected:
                                  std::string const& worker,
                                  proto::ReplicationServiceRequestType requestType,
                                  std::shared_ptr<Messenger> const& messenger);
+
+    /**
+     * Serialize the body of the request (if any) into the network buffer
+     * after the request header. Requests of most types have no body.
+     *
+     * @param lock - the lock on the mutex
+     */
+    virtual void serializeBody(util::Lock const& lock) {}
+
 private:
 
     /**
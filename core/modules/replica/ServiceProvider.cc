@@ -41,6 +41,10 @@ namespace {
 
 LOG_LOGGER _log = LOG_GET("lsst.qserv.replica.ServiceProvider");
 
+/// The interval (seconds) between checks of the configuration for changes
+/// made by other processes
+unsigned int const configRefreshIvalSec = 10;
+
 } /// namespace
 
 namespace lsst {
@@ -58,12 +62,15 @@ ServiceProvider::Ptr ServiceProvider::create(std::string const& configUrl) {
     ptr->_qservMgtServices = QservMgtServices::create(ptr);
     ptr->_messenger        = Messenger::create(ptr, ptr->_io_service);
     ptr->_httpServer       = qhttp::Server::create(ptr->_io_service, ptr->config()->controllerHttpPort());
+    ptr->_httpServer->setHandlerThreads(ptr->config()->controllerHttpThreads());
 
     return ptr;
 }
 
 ServiceProvider::ServiceProvider(std::string const& configUrl)
-    :   _configuration(Configuration::load(configUrl)),
+    :   _configRefreshTimer(_io_service),
+        _configRefreshStopped(true),
+        _configuration(Configuration::load(configUrl)),
         _databaseServices(DatabaseServicesPool::create(_configuration)) {
 }
 
@@ -99,6 +106,10 @@ void ServiceProvider::run() {
             )
         );
     }
+
+    util::Lock refreshLock(_configRefreshMtx, context() + "run");
+    _configRefreshStopped = false;
+    scheduleConfigRefresh(refreshLock);
 }
 
 bool ServiceProvider::isRunning() const {
@@ -122,6 +133,13 @@ void ServiceProvider::stop() {
 
     _messenger->stop();
 
+    {
+        util::Lock refreshLock(_configRefreshMtx, context() + "stop");
+        _configRefreshStopped = true;
+        boost::system::error_code ec;
+        _configRefreshTimer.cancel(ec);
+    }
+
     // Destroying this object will let the I/O service to (eventually) finish
     // all on-going work and shut down all service threads. In that case there
     // is no need to stop the service explicitly (which is not a good idea anyway
@@ -170,6 +188,35 @@ void ServiceProvider::assertDatabaseIsValid(std::string const& name) {
     }
 }
 
+void ServiceProvider::scheduleConfigRefresh(util::Lock const& lock) {
+
+    auto self = shared_from_this();
+
+    _configRefreshTimer.expires_from_now(boost::posix_time::seconds(configRefreshIvalSec));
+    _configRefreshTimer.async_wait(
+        [self] (boost::system::error_code const& ec) {
+            self->onConfigRefresh(ec);
+        }
+    );
+}
+
+void ServiceProvider::onConfigRefresh(boost::system::error_code const& ec) {
+
+    if (ec == boost::asio::error::operation_aborted) return;
+
+    // Failures to reach the configuration store are reported, and the
+    // configuration loaded earlier stays in effect.
+
+    try {
+        _configuration->refresh();
+    } catch (std::exception const& ex) {
+        LOGS(_log, LOG_LVL_ERROR, context() << "onConfigRefresh  " << ex.what());
+    }
+
+    util::Lock lock(_configRefreshMtx, context() + "onConfigRefresh");
+    if (not _configRefreshStopped) scheduleConfigRefresh(lock);
+}
+
 std::string ServiceProvider::context() const {
     return "SERVICE-PROVIDER  ";
 }
@@ -167,6 +167,17 @@ private:
     /// @return the context string for debugging and diagnostic printouts
     std::string context() const;
 
+    /**
+     * Start the timer for the next check of the configuration for changes
+     * made by other processes.
+     *
+     * @param lock - a lock on _configRefreshMtx must be acquired before calling this method
+     */
+    void scheduleConfigRefresh(util::Lock const& lock);
+
+    /// The callback on the expiration of the configuration refresh timer
+    void onConfigRefresh(boost::system::error_code const& ec);
+
 private:
 
     // The BOOST ASIO communication services & threads which run them
@@ -175,6 +186,12 @@ private:
     std::unique_ptr<boost::asio::io_service::work> _work;
     std::vector<std::unique_ptr<std::thread>> _threads;
 
+    // The periodic refresh of the configuration while the services are running
+
+    boost::asio::deadline_timer _configRefreshTimer;
+    bool _configRefreshStopped;
+    util::Mutex _configRefreshMtx;
+
     /// Configuration manager
     ConfigurationPtr const _configuration;
 
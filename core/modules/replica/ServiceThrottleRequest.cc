@@ -0,0 +1,90 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "replica/ServiceThrottleRequest.h"
+
+// Qserv headers
+#include "lsst/log/Log.h"
+#include "proto/replication.pb.h"
+#include "replica/ProtocolBuffer.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.replica.ServiceThrottleRequest");
+
+} /// namespace
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+ServiceThrottleRequest::Ptr ServiceThrottleRequest::create(
+                                    ServiceProvider::Ptr const& serviceProvider,
+                                    boost::asio::io_service& io_service,
+                                    std::string const& worker,
+                                    uint64_t maxRateBytesPerSec,
+                                    CallbackType const& onFinish,
+                                    std::shared_ptr<Messenger> const& messenger) {
+    return ServiceThrottleRequest::Ptr(
+        new ServiceThrottleRequest(
+            serviceProvider,
+            io_service,
+            worker,
+            maxRateBytesPerSec,
+            onFinish,
+            messenger));
+}
+
+ServiceThrottleRequest::ServiceThrottleRequest(
+                                    ServiceProvider::Ptr const& serviceProvider,
+                                    boost::asio::io_service& io_service,
+                                    std::string const& worker,
+                                    uint64_t maxRateBytesPerSec,
+                                    CallbackType const& onFinish,
+                                    std::shared_ptr<Messenger> const& messenger)
+    :   ServiceManagementRequestBase(serviceProvider,
+                                     io_service,
+                                     "SERVICE_THROTTLE",
+                                     worker,
+                                     proto::ReplicationServiceRequestType::SERVICE_THROTTLE,
+                                     messenger),
+        _maxRateBytesPerSec(maxRateBytesPerSec),
+        _onFinish(onFinish) {
+}
+
+void ServiceThrottleRequest::serializeBody(util::Lock const& lock) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "serializeBody  maxRateBytesPerSec: "
+         << _maxRateBytesPerSec);
+
+    proto::ReplicationServiceThrottleRequest message;
+    message.set_max_rate_bytes_per_sec(_maxRateBytesPerSec);
+
+    buffer()->serialize(message);
+}
+
+void ServiceThrottleRequest::notify(util::Lock const& lock) {
+    notifyDefaultImpl<ServiceThrottleRequest>(lock, _onFinish);
+}
+
+}}} // namespace lsst::qserv::replica
@@ -0,0 +1,132 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_REPLICA_SERVICETHROTTLEREQUEST_H
+#define LSST_QSERV_REPLICA_SERVICETHROTTLEREQUEST_H
+
+/**
+ * This header declares class ServiceThrottleRequest which changes
+ * the bandwidth limit of the file server of a worker.
+ */
+
+// System headers
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+// Qserv headers
+#include "replica/ServiceManagementRequestBase.h"
+
+// This header declarations
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+// Forward declarations
+class Messenger;
+
+/**
+  * Class ServiceThrottleRequest sets the maximum rate at which the file
+  * server of a worker sends data over all its connections. The state of
+  * the worker-side service reported back by the request includes the new
+  * limit.
+  */
+class ServiceThrottleRequest
+    :   public ServiceManagementRequestBase {
+
+public:
+
+    /// The pointer type for instances of the class
+    typedef std::shared_ptr<ServiceThrottleRequest> Ptr;
+
+    /// The function type for notifications on the completion of the request
+    typedef std::function<void(Ptr)> CallbackType;
+
+    // Default construction and copy semantics are prohibited
+
+    ServiceThrottleRequest() = delete;
+    ServiceThrottleRequest(ServiceThrottleRequest const&) = delete;
+    ServiceThrottleRequest& operator=(ServiceThrottleRequest const&) = delete;
+
+    ~ServiceThrottleRequest() final = default;
+
+    /**
+     * Create a new request with specified parameters.
+     *
+     * Static factory method is needed to prevent issue with the lifespan
+     * and memory management of instances created otherwise (as values or via
+     * low-level pointers).
+     *
+     * @param serviceProvider    - provides various services for the application
+     * @param io_service         - network communication service (BOOST ASIO)
+     * @param worker             - identifier of a worker node (the one to be affected by the request)
+     * @param maxRateBytesPerSec - the new limit (0 means no limit)
+     * @param onFinish           - callback function to be called upon a completion of the request
+     * @param messenger          - messenger service for workers
+     */
+    static Ptr create(ServiceProvider::Ptr const& serviceProvider,
+                      boost::asio::io_service& io_service,
+                      std::string const& worker,
+                      uint64_t maxRateBytesPerSec,
+                      CallbackType const& onFinish,
+                      std::shared_ptr<Messenger> const& messenger);
+
+    /// @return the requested limit (bytes per second, 0 means no limit)
+    uint64_t maxRateBytesPerSec() const { return _maxRateBytesPerSec; }
+
+private:
+
+    /**
+     * Construct the request
+     *
+     * @see ServiceThrottleRequest::create()
+     */
+    ServiceThrottleRequest(ServiceProvider::Ptr const& serviceProvider,
+                           boost::asio::io_service& io_service,
+                           std::string const& worker,
+                           uint64_t maxRateBytesPerSec,
+                           CallbackType const& onFinish,
+                           std::shared_ptr<Messenger> const& messenger);
+
+    /**
+     * @see ServiceManagementRequestBase::serializeBody()
+     */
+    void serializeBody(util::Lock const& lock) final;
+
+    /**
+     * @see Request::notify()
+     */
+    void notify(util::Lock const& lock) final;
+
+private:
+
+    /// The requested limit
+    uint64_t const _maxRateBytesPerSec;
+
+    /// Registered callback to be called when the operation finishes
+    CallbackType _onFinish;
+};
+
+}}} // namespace lsst::qserv::replica
+
+#endif // LSST_QSERV_REPLICA_SERVICETHROTTLEREQUEST_H
@@ -61,6 +61,24 @@ SetReplicasQservMgtRequest::Ptr SetReplicasQservMgtRequest::create(
                                        onFinish));
  }
 
+SetReplicasQservMgtRequest::Ptr SetReplicasQservMgtRequest::createDiff(
+                                        ServiceProvider::Ptr const& serviceProvider,
+                                        std::string const& worker,
+                                        QservReplicaCollection const& addedReplicas,
+                                        QservReplicaCollection const& removedReplicas,
+                                        std::uint64_t baseRevision,
+                                        bool force,
+                                        SetReplicasQservMgtRequest::CallbackType const& onFinish) {
+    return SetReplicasQservMgtRequest::Ptr(
+        new SetReplicasQservMgtRequest(serviceProvider,
+                                       worker,
+                                       addedReplicas,
+                                       removedReplicas,
+                                       baseRevision,
+                                       force,
+                                       onFinish));
+}
+
 SetReplicasQservMgtRequest::SetReplicasQservMgtRequest(
                                 ServiceProvider::Ptr const& serviceProvider,
                                 std::string const& worker,
@@ -72,8 +90,32 @@ SetReplicasQservMgtRequest::SetReplicasQservMgtRequest(
                         worker),
         _newReplicas(newReplicas),
         _force(force),
+        _diff(false),
+        _baseRevision(0),
+        _onFinish(onFinish),
+        _qservRequest(nullptr),
+        _revision(0) {
+}
+
+SetReplicasQservMgtRequest::SetReplicasQservMgtRequest(
+                                ServiceProvider::Ptr const& serviceProvider,
+                                std::string const& worker,
+                                QservReplicaCollection const& addedReplicas,
+                                QservReplicaCollection const& removedReplicas,
+                                std::uint64_t baseRevision,
+                                bool force,
+                                SetReplicasQservMgtRequest::CallbackType const& onFinish)
+    :   QservMgtRequest(serviceProvider,
+                        "QSERV_SET_REPLICAS",
+                        worker),
+        _newReplicas(addedReplicas),
+        _force(force),
+        _diff(true),
+        _removedReplicas(removedReplicas),
+        _baseRevision(baseRevision),
         _onFinish(onFinish),
-        _qservRequest(nullptr) {
+        _qservRequest(nullptr),
+        _revision(0) {
 }
 
 QservReplicaCollection const& SetReplicasQservMgtRequest::replicas() const {
@@ -85,10 +127,26 @@ QservReplicaCollection const& SetReplicasQservMgtRequest::replicas() const {
     return _replicas;
 }
 
+std::uint64_t SetReplicasQservMgtRequest::revision() const {
+    if (not ((state() == State::FINISHED) and
+             ((extendedState() == ExtendedState::SUCCESS) or
+              (extendedState() == ExtendedState::SERVER_STALE)))) {
+        throw std::logic_error(
+                "SetReplicasQservMgtRequest::revision  the revision isn't available in state: " +
+                state2string(state(), extendedState()));
+    }
+    return _revision;
+}
+
 std::list<std::pair<std::string,std::string>> SetReplicasQservMgtRequest::extendedPersistentState() const {
     std::list<std::pair<std::string,std::string>> result;
     result.emplace_back("num_replicas", std::to_string(newReplicas().size()));
     result.emplace_back("force", force() ? "1" : "0");
+    result.emplace_back("diff", diff() ? "1" : "0");
+    if (diff()) {
+        result.emplace_back("num_removed_replicas", std::to_string(removedReplicas().size()));
+        result.emplace_back("base_revision", std::to_string(baseRevision()));
+    }
     return result;
 }
 
@@ -110,21 +168,22 @@ void SetReplicasQservMgtRequest::setReplicas(
 
 void SetReplicasQservMgtRequest::startImpl(util::Lock const& lock) {
 
-    wpublish::SetChunkListQservRequest::ChunkCollection chunks;
-    for (auto&& chunkEntry: newReplicas()) {
-        chunks.push_back(
-            wpublish::SetChunkListQservRequest::Chunk{
-                chunkEntry.chunk,
-                chunkEntry.database,
-                0  /* UNUSED: use_count */
-            }
-        );
-    }
+    auto const toChunks = [] (QservReplicaCollection const& replicas) {
+        wpublish::SetChunkListQservRequest::ChunkCollection chunks;
+        for (auto&& chunkEntry: replicas) {
+            chunks.push_back(
+                wpublish::SetChunkListQservRequest::Chunk{
+                    chunkEntry.chunk,
+                    chunkEntry.database,
+                    0  /* UNUSED: use_count */
+                }
+            );
+        }
+        return chunks;
+    };
     auto const request = shared_from_base<SetReplicasQservMgtRequest>();
 
-    _qservRequest = wpublish::SetChunkListQservRequest::create(
-        chunks,
-        force(),
+    auto const onFinish =
         [request] (wpublish::SetChunkListQservRequest::Status status,
                    std::string const& error,
                    wpublish::SetChunkListQservRequest::ChunkCollection const& collection) {
@@ -141,23 +200,50 @@ void SetReplicasQservMgtRequest::startImpl(util::Lock const& lock) {
         
             if (request->state() == State::FINISHED) return;
 
+            request->_revision = request->_qservRequest->revision();
+
             switch (status) {
                 case wpublish::SetChunkListQservRequest::Status::SUCCESS:
                     request->setReplicas(lock, collection);
                     request->finish(lock, QservMgtRequest::ExtendedState::SUCCESS);
                     break;
 
+                case wpublish::SetChunkListQservRequest::Status::INVALID:
+                    request->finish(lock, QservMgtRequest::ExtendedState::SERVER_BAD, error);
+                    break;
+
+                case wpublish::SetChunkListQservRequest::Status::IN_USE:
+                    request->finish(lock, QservMgtRequest::ExtendedState::SERVER_CHUNK_IN_USE, error);
+                    break;
+
                 case wpublish::SetChunkListQservRequest::Status::ERROR:
                     request->finish(lock, QservMgtRequest::ExtendedState::SERVER_ERROR, error);
                     break;
 
+                case wpublish::SetChunkListQservRequest::Status::STALE:
+                    request->finish(lock, QservMgtRequest::ExtendedState::SERVER_STALE, error);
+                    break;
+
                 default:
                     throw std::logic_error(
                         "SetReplicasQservMgtRequest:  unhandled server status: " +
                         wpublish::SetChunkListQservRequest::status2str(status));
             }
-        }
-    );
+        };
+
+    if (diff()) {
+        _qservRequest = wpublish::SetChunkListQservRequest::createDiff(
+            toChunks(newReplicas()),
+            toChunks(removedReplicas()),
+            baseRevision(),
+            force(),
+            onFinish);
+    } else {
+        _qservRequest = wpublish::SetChunkListQservRequest::create(
+            toChunks(newReplicas()),
+            force(),
+            onFinish);
+    }
     XrdSsiResource resource(ResourceUnit::makeWorkerPath(worker()));
     service()->ProcessRequest(*_qservRequest, resource);
 }
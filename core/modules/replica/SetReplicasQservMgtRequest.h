@@ -23,6 +23,7 @@
 #define LSST_QSERV_REPLICA_SETREPLICASQSERVMGTREQUEST_H
 
 // System headers
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -91,16 +92,75 @@ public:
                       bool force = false,
                       CallbackType const& onFinish = nullptr);
 
-    /// @return collection of new replicas to be set at the Qserv worker
+    /**
+     * Static factory method for the 'diff' mode, in which the worker only
+     * adds and removes the specified replicas, and only if its inventory
+     * is still at the revision the diff was made against. Otherwise
+     * the request finishes with status SERVER_STALE.
+     *
+     * @param serviceProvider
+     *   reference to a provider of services
+     *
+     * @param worker
+     *   name of a worker
+     *
+     * @param addedReplicas
+     *   collection of replicas to be added (NOTE: useCount field is ignored)
+     *
+     * @param removedReplicas
+     *   collection of replicas to be removed (NOTE: useCount field is ignored)
+     *
+     * @param baseRevision
+     *   revision of the worker's inventory the diff was made against
+     *
+     * @param force
+     *   proceed with the operation even if some replicas affected by
+     *   the operation are in use.
+     *
+     * @param onFinish
+     *   callback function to be called upon request completion
+     */
+    static Ptr createDiff(ServiceProvider::Ptr const& serviceProvider,
+                          std::string const& worker,
+                          QservReplicaCollection const& addedReplicas,
+                          QservReplicaCollection const& removedReplicas,
+                          std::uint64_t baseRevision,
+                          bool force = false,
+                          CallbackType const& onFinish = nullptr);
+
+    /// @return collection of new replicas to be set at the Qserv worker,
+    ///         or the replicas to be added in the 'diff' mode
     QservReplicaCollection const& newReplicas() const { return _newReplicas; }
 
     /// @return flag indicating (if set) the 'force' mode of the operation
     bool force() const { return _force; }
 
+    /// @return flag indicating (if set) the 'diff' mode of the operation
+    bool diff() const { return _diff; }
+
+    /// @return collection of replicas to be removed in the 'diff' mode
+    QservReplicaCollection const& removedReplicas() const { return _removedReplicas; }
+
+    /// @return revision of the worker's inventory the diff was made against
+    std::uint64_t baseRevision() const { return _baseRevision; }
+
+    /**
+      * @return
+      *   revision of the worker's inventory reported by the worker after
+      *   the operation. A diff made against the new collection of replicas
+      *   needs this revision.
+      *
+      * @note
+      *   the method will throw exception std::logic_error if called
+      *   before the request finishes or if it's finished with any but SUCCESS
+      *   or SERVER_STALE status.
+      */
+    std::uint64_t revision() const;
+
     /**
       * @return
       *   previous collection of replicas which was set at the corresponding
-      *   Qserv worker before the operation.
+      *   Qserv worker before the operation. It's empty in the 'diff' mode.
       *
       * @note
       *   the method will throw exception std::logic_error if called
@@ -141,6 +201,15 @@ private:
                                bool force,
                                CallbackType const& onFinish);
 
+    /// @see SetReplicasQservMgtRequest::createDiff()
+    SetReplicasQservMgtRequest(ServiceProvider::Ptr const& serviceProvider,
+                               std::string const& worker,
+                               QservReplicaCollection const& addedReplicas,
+                               QservReplicaCollection const& removedReplicas,
+                               std::uint64_t baseRevision,
+                               bool force,
+                               CallbackType const& onFinish);
+
     /**
      * Carry over results of the request into a local collection.
      *
@@ -176,6 +245,12 @@ private:
     /// Flag indicating to report (if set) the 'force' mode of the operation
     bool const _force;
 
+    // Parameters of the 'diff' mode
+
+    bool const _diff;
+    QservReplicaCollection const _removedReplicas;
+    std::uint64_t const _baseRevision;
+
     /// The callback function for sending a notification upon request completion
     CallbackType _onFinish;
 
@@ -184,6 +259,9 @@ private:
 
     /// A collection of replicas reported by the Qservr worker
     QservReplicaCollection _replicas;
+
+    /// The revision of the inventory reported by the Qserv worker
+    std::uint64_t _revision;
 };
 
 }}} // namespace lsst::qserv::replica
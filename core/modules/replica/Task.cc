@@ -28,6 +28,8 @@
 #include <thread>
 
 // Qserv headers
+#include "replica/ChunkStatsJob.h"
+#include "replica/Configuration.h"
 #include "replica/QservSyncJob.h"
 #include "util/BlockPost.h"
 
@@ -122,6 +124,41 @@ void Task::sync(unsigned int qservSyncTimeoutSec,
 }
 
 
+void Task::collectChunkStats() {
+
+    info(ChunkStatsJob::typeName());
+
+    auto self = shared_from_this();
+
+    std::vector<Job::Ptr> jobs;
+    _numFinishedJobs = 0;
+
+    std::string const parentJobId;  // no parent for these jobs
+    bool const full = false;
+    bool const allWorkers = false;
+
+    for (auto&& family: serviceProvider()->config()->databaseFamilies()) {
+        for (auto&& database: serviceProvider()->config()->databases(family)) {
+            auto job = ChunkStatsJob::create(
+                database,
+                full,
+                allWorkers,
+                controller(),
+                parentJobId,
+                [self](ChunkStatsJob::Ptr const& job) {
+                    self->_numFinishedJobs++;
+                }
+            );
+            job->start();
+            jobs.push_back(job);
+        }
+    }
+    track<Job>(ChunkStatsJob::typeName(),
+               jobs,
+               _numFinishedJobs);
+}
+
+
 void Task::_startImpl() {
 
     // By design of this class, any but TaskStopped exceptions thrown
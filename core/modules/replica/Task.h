@@ -318,6 +318,17 @@ protected:
     void sync(unsigned int qservSyncTimeoutSec,
               bool forceQservSync=false);
 
+    /**
+     * Launch the jobs collecting the statistics of the chunk tables of each
+     * known database from the Qserv workers.
+     *
+     * @throws
+     *   TaskStopped when the task cancellation request was detected
+     *
+     * @see ChunkStatsJob
+     */
+    void collectChunkStats();
+
     /**
      * Track the completion of all jobs. Also monitor the task cancellation
      * condition while tracking the jobs. When such condition will be seen
@@ -80,6 +80,15 @@ VerifyApp::VerifyApp(int argc, char* argv[])
         "Also compute and store in the database check/control sums for"
         " all files of the found replica.",
         _computeCheckSum);
+
+    parser().option(
+        "sample-rate",
+        "The fraction of the 4 MB blocks of each file to be read back and"
+        " compared with the block checksums recorded when the file was"
+        " replicated. Files replicated before the checksums were recorded"
+        " are only checked by their size and modification time. A value of 0"
+        " disables the sampling, and a value of 1 reads all blocks.",
+        _sampleRate);
 }
 
 
@@ -92,6 +101,7 @@ int VerifyApp::runImpl() {
     auto const job = VerifyJob::create (
         _maxReplicas,
         _computeCheckSum,
+        _sampleRate,
         [] (VerifyJob::Ptr const& job,
             ReplicaDiff const& selfReplicaDiff,
             vector<ReplicaDiff> const& otherReplicaDiff) {
@@ -83,6 +83,10 @@ private:
     /// the replica's files.
     bool _computeCheckSum  = false;
 
+    /// The fraction of the blocks of each file to be read back and compared
+    /// with the block manifest recorded when the file was replicated
+    double _sampleRate = 0;
+
 };
 
 }}} // namespace lsst::qserv::replica
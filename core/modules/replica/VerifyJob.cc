@@ -99,11 +99,28 @@ ReplicaDiff::ReplicaDiff(ReplicaInfo const& replica1,
         ReplicaInfo::FileInfo const& file1 = file2info1[name];
         ReplicaInfo::FileInfo const& file2 = file2info2[name];
 
+        if (file1.packed != file2.packed) {
+
+            // A packed replica is compared with the other one by the size and
+            // the control sum its files had before packing, where those are known.
+            // Packing always changes the mtime.
+            ReplicaInfo::FileInfo const unpacked1 = file1.unpacked();
+            ReplicaInfo::FileInfo const unpacked2 = file2.unpacked();
+
+            _fileSizeMismatch = _fileSizeMismatch or
+                (unpacked1.size and unpacked2.size and (unpacked1.size != unpacked2.size));
+
+            _fileCsMismatch = _fileCsMismatch or
+                (unpacked1.csComparable(unpacked2) and (unpacked1.cs != unpacked2.cs));
+            continue;
+        }
+
         _fileSizeMismatch = _fileSizeMismatch or (file1.size != file2.size);
 
         // Control sums are considered only if they're both defined
+        // and computed with the same algorithm
         _fileCsMismatch = _fileCsMismatch or
-            ((not file1.cs.empty() and not file2.cs.empty()) and (file1.cs != file2.cs));
+            (file1.csComparable(file2) and (file1.cs != file2.cs));
 
         _fileMtimeMismatch = _fileMtimeMismatch or (file1.mtime != file2.mtime);
     }
@@ -182,6 +199,7 @@ std::string VerifyJob::typeName() { return "VerifyJob"; }
 
 VerifyJob::Ptr VerifyJob::create(size_t maxReplicas,
                                  bool computeCheckSum,
+                                 double sampleRate,
                                  CallbackTypeOnDiff const& onReplicaDifference,
                                  Controller::Ptr const& controller,
                                  std::string const& parentJobId,
@@ -190,6 +208,7 @@ VerifyJob::Ptr VerifyJob::create(size_t maxReplicas,
     return VerifyJob::Ptr(
         new VerifyJob(maxReplicas,
                       computeCheckSum,
+                      sampleRate,
                       onReplicaDifference,
                       controller,
                       parentJobId,
@@ -199,6 +218,7 @@ VerifyJob::Ptr VerifyJob::create(size_t maxReplicas,
 
 VerifyJob::VerifyJob(size_t maxReplicas,
                      bool computeCheckSum,
+                     double sampleRate,
                      CallbackTypeOnDiff const& onReplicaDifference,
                      Controller::Ptr const& controller,
                      std::string const& parentJobId,
@@ -210,6 +230,7 @@ VerifyJob::VerifyJob(size_t maxReplicas,
             options),
         _maxReplicas(maxReplicas),
         _computeCheckSum(computeCheckSum),
+        _sampleRate(sampleRate),
         _onFinish(onFinish),
         _onReplicaDifference(onReplicaDifference) {
 
@@ -223,6 +244,7 @@ std::list<std::pair<std::string,std::string>> VerifyJob::extendedPersistentState
     std::list<std::pair<std::string,std::string>> result;
     result.emplace_back("max_replicas",      std::to_string(maxReplicas()));
     result.emplace_back("compute_check_sum", computeCheckSum() ? "1" : "0");
+    result.emplace_back("sample_rate",       std::to_string(sampleRate()));
     return result;
 }
 
@@ -260,6 +282,7 @@ void VerifyJob::startImpl(util::Lock const& lock) {
             },
             options(lock).priority,     /* inherited from the one of the current job */
             computeCheckSum(),
+            sampleRate(),
             true,                       /* keepTracking*/
             id()                        /* jobId */
         );
@@ -411,6 +434,7 @@ void VerifyJob::onRequestFinish(FindRequest::Ptr request) {
             },
             options(lock).priority, /* inherited from the one of the current job */
             computeCheckSum(),
+            sampleRate(),
             true,                   /* keepTracking*/
             id()                    /* jobId */
         );
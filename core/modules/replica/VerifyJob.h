@@ -170,6 +170,10 @@ public:
      * @param computeCheckSum
      *   compute check/control sum on each file if set to 'true'
      *
+     * @param sampleRate
+     *   the fraction of the blocks of each file to be read back and compared
+     *   with the block manifest of the file (0 to disable the sampling)
+     *
      @ @param onReplicaDifference
      *   callback function to be called when two replicas won't match
      *
@@ -193,6 +197,7 @@ public:
      */
     static Ptr create(size_t maxReplicas,
                       bool computeCheckSum,
+                      double sampleRate,
                       CallbackTypeOnDiff const& onReplicaDifference,
                       Controller::Ptr const& controller,
                       std::string const& parentJobId = std::string(),
@@ -213,6 +218,9 @@ public:
     /// @return true if file check/control sums need to be recomputed
     bool computeCheckSum() const { return _computeCheckSum; }
 
+    /// @return the fraction of the blocks of each file to be verified
+    double sampleRate() const { return _sampleRate; }
+
     /**
      * @see Job::extendedPersistentState()
      */
@@ -227,6 +235,7 @@ protected:
      */
     VerifyJob(size_t maxReplicas,
               bool computeCheckSum,
+              double sampleRate,
               CallbackTypeOnDiff const& onReplicaDifference,
               Controller::Ptr const& controller,
               std::string const& parentJobId,
@@ -274,6 +283,9 @@ protected:
     /// This option will be passed on to the worker services
     bool const _computeCheckSum;
 
+    /// This option will be passed on to the worker services
+    double const _sampleRate;
+
     /// Client-defined function to be called upon the completion of the job
     CallbackType _onFinish;
 
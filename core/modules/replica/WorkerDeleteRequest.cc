@@ -24,6 +24,14 @@
 #include "replica/WorkerDeleteRequest.h"
 
 // System headers
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <fcntl.h>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
 
 // Third party headers
 #include <boost/filesystem.hpp>
@@ -42,6 +50,32 @@ namespace {
 
 LOG_LOGGER _log = LOG_GET("lsst.qserv.replica.WorkerDeleteRequest");
 
+/// The maximum number of threads removing the files of a request
+size_t const numUnlinkThreads = 4;
+
+/// The maximum number of files removed per second by all requests
+unsigned int const maxUnlinksPerSec = 2000;
+
+std::mutex pacerMtx;
+std::chrono::steady_clock::time_point pacerNextSlot;
+
+/**
+ * Wait for the next slot allowed by the rate limit shared by all
+ * requests of the worker
+ */
+void pace() {
+
+    auto const step = std::chrono::microseconds(1000000 / maxUnlinksPerSec);
+
+    std::chrono::steady_clock::time_point slot;
+    {
+        std::lock_guard<std::mutex> lock(pacerMtx);
+        slot = std::max(pacerNextSlot, std::chrono::steady_clock::now());
+        pacerNextSlot = slot + step;
+    }
+    std::this_thread::sleep_until(slot);
+}
+
 } /// namespace
 
 namespace lsst {
@@ -58,14 +92,16 @@ WorkerDeleteRequest::Ptr WorkerDeleteRequest::create(
                                     std::string const& id,
                                     int                priority,
                                     std::string const& database,
-                                    unsigned int       chunk) {
+                                    unsigned int       chunk,
+                                    std::vector<unsigned int> const& extraChunks) {
     return WorkerDeleteRequest::Ptr(
         new WorkerDeleteRequest(serviceProvider,
                                 worker,
                                 id,
                                 priority,
                                 database,
-                                chunk));
+                                chunk,
+                                extraChunks));
 }
 
 WorkerDeleteRequest::WorkerDeleteRequest(ServiceProvider::Ptr const& serviceProvider,
@@ -73,7 +109,8 @@ WorkerDeleteRequest::WorkerDeleteRequest(ServiceProvider::Ptr const& serviceProv
                                          std::string const& id,
                                          int                priority,
                                          std::string const& database,
-                                         unsigned int       chunk)
+                                         unsigned int       chunk,
+                                         std::vector<unsigned int> const& extraChunks)
     :   WorkerRequest (serviceProvider,
                        worker,
                        "DELETE",
@@ -81,6 +118,7 @@ WorkerDeleteRequest::WorkerDeleteRequest(ServiceProvider::Ptr const& serviceProv
                        priority),
         _database(database),
         _chunk(chunk),
+        _extraChunks(extraChunks),
         // This status will be returned in all contexts
         _replicaInfo(ReplicaInfo::Status::NOT_FOUND,
                      worker,
@@ -88,6 +126,15 @@ WorkerDeleteRequest::WorkerDeleteRequest(ServiceProvider::Ptr const& serviceProv
                      chunk,
                      PerformanceUtils::now(),
                      ReplicaInfo::FileInfoCollection{}) {
+
+    for (auto extraChunk: extraChunks) {
+        _extraReplicaInfo.emplace_back(ReplicaInfo::Status::NOT_FOUND,
+                                       worker,
+                                       database,
+                                       extraChunk,
+                                       _replicaInfo.verifyTime(),
+                                       ReplicaInfo::FileInfoCollection{});
+    }
 }
 
 void WorkerDeleteRequest::setInfo(proto::ReplicationResponseDelete& response) const {
@@ -106,6 +153,10 @@ void WorkerDeleteRequest::setInfo(proto::ReplicationResponseDelete& response) co
 
     response.set_allocated_replica_info(_replicaInfo.info());
 
+    for (auto&& replicaInfo: _extraReplicaInfo) {
+        replicaInfo.setInfo(response.add_extra_replica_info());
+    }
+
     // Same comment on the ownership transfer applies here
 
     auto protoRequestPtr = new proto::ReplicationRequestDelete();
@@ -113,7 +164,9 @@ void WorkerDeleteRequest::setInfo(proto::ReplicationResponseDelete& response) co
     protoRequestPtr->set_priority(priority());
     protoRequestPtr->set_database(database());
     protoRequestPtr->set_chunk(   chunk());
-
+    for (auto extraChunk: extraChunks()) {
+        protoRequestPtr->add_extra_chunks(extraChunk);
+    }
     response.set_allocated_request(protoRequestPtr);
 }
 
@@ -121,7 +174,8 @@ bool WorkerDeleteRequest::execute() {
 
     LOGS(_log, LOG_LVL_DEBUG, context() << "execute"
         << "  db: "    << database()
-        << "  chunk: " << chunk());
+        << "  chunk: " << chunk()
+        << "  extra chunks: " << extraChunks().size());
 
     return WorkerRequest::execute();
 }
@@ -136,7 +190,8 @@ WorkerDeleteRequestPOSIX::Ptr WorkerDeleteRequestPOSIX::create(
                                         std::string const& id,
                                         int                priority,
                                         std::string const& database,
-                                        unsigned int       chunk) {
+                                        unsigned int       chunk,
+                                        std::vector<unsigned int> const& extraChunks) {
 
     return WorkerDeleteRequestPOSIX::Ptr(
         new WorkerDeleteRequestPOSIX(
@@ -145,7 +200,8 @@ WorkerDeleteRequestPOSIX::Ptr WorkerDeleteRequestPOSIX::create(
                 id,
                 priority,
                 database,
-                chunk));
+                chunk,
+                extraChunks));
 }
 
 WorkerDeleteRequestPOSIX::WorkerDeleteRequestPOSIX(
@@ -154,33 +210,40 @@ WorkerDeleteRequestPOSIX::WorkerDeleteRequestPOSIX(
                                 std::string const& id,
                                 int                priority,
                                 std::string const& database,
-                                unsigned int       chunk)
+                                unsigned int       chunk,
+                                std::vector<unsigned int> const& extraChunks)
     :   WorkerDeleteRequest(
             serviceProvider,
             worker,
             id,
             priority,
             database,
-            chunk) {
+            chunk,
+            extraChunks) {
 }
 
 bool WorkerDeleteRequestPOSIX::execute() {
 
     LOGS(_log, LOG_LVL_DEBUG, context() << "execute"
          << "  db: "    << database()
-         << "  chunk: " << chunk());
+         << "  chunk: " << chunk()
+         << "  extra chunks: " << extraChunks().size());
 
     util::Lock lock(_mtx, context() + "execute");
 
     WorkerInfo   const workerInfo    = _serviceProvider->config()->workerInfo(worker());
     DatabaseInfo const databaseInfo  = _serviceProvider->config()->databaseInfo(database());
 
-    std::vector<std::string> const files =
-        FileUtils::partitionedFiles(databaseInfo, chunk());
+    std::vector<std::string> files = FileUtils::partitionedFiles(databaseInfo, chunk());
+    for (auto extraChunk: extraChunks()) {
+        auto const chunkFiles = FileUtils::partitionedFiles(databaseInfo, extraChunk);
+        files.insert(files.end(), chunkFiles.begin(), chunkFiles.end());
+    }
 
     // The data folder will be locked while performing the operation
 
-    int numFilesDeleted = 0;
+    std::atomic<size_t> numFilesDeleted(0);
+    std::vector<std::string> failedFiles;
 
     WorkerRequest::ErrorContext errorContext;
     boost::system::error_code   ec;
@@ -199,16 +262,56 @@ bool WorkerDeleteRequestPOSIX::execute() {
                     ExtendedCompletionStatus::EXT_STATUS_NO_FOLDER,
                     "the directory does not exists: " + dataDir.string());
 
-        for (const auto &name: files) {
-            const fs::path file = dataDir / fs::path(name);
-            if (fs::remove(file, ec)) ++numFilesDeleted;
+        if (not errorContext.failed) {
+
+            // The files are removed relative to the open directory, which
+            // spares the kernel resolving the full path of each file
+
+            int const dirFd = ::open(dataDir.c_str(), O_RDONLY | O_DIRECTORY);
             errorContext = errorContext
                 or reportErrorIf(
-                        ec.value() != 0,
-                        ExtendedCompletionStatus::EXT_STATUS_FILE_DELETE,
-                        "failed to delete file: " + file.string());
+                        dirFd < 0,
+                        ExtendedCompletionStatus::EXT_STATUS_FOLDER_STAT,
+                        "failed to open directory: " + dataDir.string());
+
+            if (dirFd >= 0) {
+
+                std::atomic<size_t> nextFile(0);
+                std::mutex failedFilesMtx;
+
+                auto const unlinkFiles = [&] () {
+                    for (size_t i; (i = nextFile++) < files.size();) {
+                        ::pace();
+                        if (0 == ::unlinkat(dirFd, files[i].c_str(), 0)) {
+                            ++numFilesDeleted;
+                        } else if (errno != ENOENT) {
+                            std::lock_guard<std::mutex> failedFilesLock(failedFilesMtx);
+                            failedFiles.push_back(files[i]);
+                        }
+                    }
+                };
+                std::vector<std::thread> threads;
+                for (size_t i = 0; i < std::min(numUnlinkThreads, files.size()); ++i) {
+                    threads.emplace_back(unlinkFiles);
+                }
+                for (auto&& thread: threads) thread.join();
+
+                ::close(dirFd);
+            }
+            for (auto&& name: failedFiles) {
+                errorContext = errorContext
+                    or reportErrorIf(
+                            true,
+                            ExtendedCompletionStatus::EXT_STATUS_FILE_DELETE,
+                            "failed to delete file: " + (dataDir / fs::path(name)).string());
+            }
         }
     }
+    LOGS(_log, LOG_LVL_DEBUG, context() << "execute"
+         << "  numFiles: " << files.size()
+         << "  numFilesDeleted: " << numFilesDeleted
+         << "  numFilesFailed: " << failedFiles.size());
+
     if (errorContext.failed) {
         setStatus(lock, STATUS_FAILED, errorContext.extendedStatus);
         return true;
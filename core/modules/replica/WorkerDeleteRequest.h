@@ -25,6 +25,7 @@
 
 // System headers
 #include <string>
+#include <vector>
 
 // Qserv headers
 #include "proto/replication.pb.h"
@@ -63,6 +64,7 @@ public:
      * @param priority         - indicates the importance of the request
      * @param database         - the name of a database
      * @param chunk            - the chunk number
+     * @param extraChunks      - more chunks of the database to be deleted
      *
      * @return pointer to the created object
      */
@@ -71,7 +73,8 @@ public:
                           std::string const& id,
                           int priority,
                           std::string const& database,
-                          unsigned int chunk);
+                          unsigned int chunk,
+                          std::vector<unsigned int> const& extraChunks);
 
     // Default construction and copy semantics are prohibited
 
@@ -86,7 +89,9 @@ public:
     std::string const& database() const { return _database; }
 
     unsigned int chunk() const { return _chunk; }
-    
+
+    std::vector<unsigned int> const& extraChunks() const { return _extraChunks; }
+
     /**
      * Extract request status into the Protobuf response object.
      *
@@ -111,7 +116,8 @@ protected:
                         std::string const& id,
                         int priority,
                         std::string const& database,
-                        unsigned int chunk);
+                        unsigned int chunk,
+                        std::vector<unsigned int> const& extraChunks);
 protected:
 
     /// The name of a database
@@ -120,14 +126,25 @@ protected:
     /// The number of a chunk
     unsigned int const _chunk;
 
+    /// More chunks to be deleted
+    std::vector<unsigned int> const _extraChunks;
+
     /// Extended status of the replica deletion request
     ReplicaInfo _replicaInfo;
+
+    /// Extended status of the extra chunks
+    ReplicaInfoCollection _extraReplicaInfo;
 };
 
 /**
   * Class WorkerDeleteRequestPOSIX provides an actual implementation for
   * the replica deletion based on the direct manipulation of files on
   * a POSIX file system.
+  *
+  * The files of all chunks of a request are removed by a few threads
+  * calling unlinkat() relative to the open directory of the database.
+  * The rate of the removals is limited for all requests of the worker,
+  * so that the file system isn't overwhelmed by a big purge.
   */
 class WorkerDeleteRequestPOSIX
     :   public WorkerDeleteRequest {
@@ -148,6 +165,7 @@ public:
      * @param priority         - indicates the importance of the request
      * @param database         - the name of a database
      * @param chunk            - the chunk number
+     * @param extraChunks      - more chunks of the database to be deleted
      *
      * @return pointer to the created object
      */
@@ -156,7 +174,8 @@ public:
                       std::string const& id,
                       int priority,
                       std::string const& database,
-                      unsigned int chunk);
+                      unsigned int chunk,
+                      std::vector<unsigned int> const& extraChunks);
 
     // Default construction and copy semantics are prohibited
 
@@ -183,7 +202,8 @@ private:
                              std::string const& id,
                              int priority,
                              std::string const& database,
-                             unsigned int chunk);
+                             unsigned int chunk,
+                             std::vector<unsigned int> const& extraChunks);
 };
 
 /**
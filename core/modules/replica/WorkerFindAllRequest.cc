@@ -24,7 +24,9 @@
 #include "replica/WorkerFindAllRequest.h"
 
 // System headers
+#include <cstring>
 #include <map>
+#include <set>
 
 // Third party headers
 #include <boost/filesystem.hpp>
@@ -32,6 +34,7 @@
 // Qserv headers
 #include "lsst/log/Log.h"
 #include "replica/Configuration.h"
+#include "replica/FileCsCache.h"
 #include "replica/FileUtils.h"
 #include "replica/Performance.h"
 #include "replica/ServiceProvider.h"
@@ -185,6 +188,7 @@ bool WorkerFindAllRequestPOSIX::execute() {
     boost::system::error_code   ec;
 
     std::map<unsigned int, ReplicaInfo::FileInfoCollection> chunk2fileInfoCollection;
+    std::set<std::string> packedTables;     // the base names of the packed tables
     {
         util::Lock dataFolderLock(_mtxDataFolderOperations, context() + "execute");
 
@@ -199,6 +203,7 @@ bool WorkerFindAllRequestPOSIX::execute() {
                     not fs::exists(stat),
                     ExtendedCompletionStatus::EXT_STATUS_NO_FOLDER,
                     "the directory does not exists: " + dataDir.string());
+        FileCsCache::Ptr const csCache = FileCsCache::instance(worker(), workerInfo.dataDir);
         try {
             for (fs::directory_entry &entry: fs::directory_iterator(dataDir)) {
                 std::tuple<std::string, unsigned int, std::string> parsed;
@@ -214,33 +219,48 @@ bool WorkerFindAllRequestPOSIX::execute() {
                         << "  chunk: "    << std::get<1>(parsed)
                         << "  ext: "      << std::get<2>(parsed));
 
-                    uint64_t const size = fs::file_size(entry.path(), ec);
+                    // One stat(2) gets the size, mtime and the inode number of
+                    // the file, and the latter are used for finding the control sum
+                    // of the file if it was computed by an earlier request and
+                    // the file hasn't changed since then.
+
+                    FileCsCache::Stat fileStat{0, 0, 0};
+                    int const err = FileCsCache::stat(entry.path().string(), fileStat);
                     errorContext = errorContext
                         or reportErrorIf(
-                                ec.value() != 0,
+                                err != 0,
                                 ExtendedCompletionStatus::EXT_STATUS_FILE_SIZE,
-                                "failed to read file size: " + entry.path().string());
+                                "failed to read file size and mtime: " + entry.path().string() +
+                                ", error: " + std::strerror(err));
 
-                    std::time_t const mtime = fs::last_write_time(entry.path(), ec);
-                    errorContext = errorContext
-                        or reportErrorIf(
-                                ec.value() != 0,
-                                ExtendedCompletionStatus::EXT_STATUS_FILE_MTIME,
-                                "failed to read file mtime: " + entry.path().string());
+                    // The control sum is never computed for this type of requests
+                    std::string cs;
+                    std::string csAlgorithm;
+                    if (err == 0) csCache->find(entry.path().string(), fileStat, cs, csAlgorithm);
 
                     unsigned const chunk = std::get<1>(parsed);
 
                     chunk2fileInfoCollection[chunk].emplace_back(
                         ReplicaInfo::FileInfo({
                             entry.path().filename().string(),
-                            size,
-                            mtime,
-                            "",     /* cs is never computed for this type of requests */
-                            0,      /* beginTransferTime */
-                            0,      /* endTransferTime */
-                            size    /* inSize */
+                            fileStat.size,
+                            fileStat.mtime,
+                            cs,
+                            0,              /* beginTransferTime */
+                            0,              /* endTransferTime */
+                            fileStat.size,  /* inSize */
+                            csAlgorithm,
+                            false,          /* packed: set below */
+                            0,              /* unpackedSize */
+                            ""              /* unpackedCs */
                         })
                     );
+
+                    // Only the data file of a table tells if the table is packed
+                    if (std::get<2>(parsed) == "MYD" and
+                        FileUtils::isPackedMyISAM(entry.path().string())) {
+                        packedTables.insert(entry.path().stem().string());
+                    }
                 }
             }
         } catch (fs::filesystem_error const& ex) {
@@ -251,6 +271,7 @@ bool WorkerFindAllRequestPOSIX::execute() {
                         "failed to read the directory: " + dataDir.string() +
                         ", error: " + std::string(ex.what()));
         }
+        csCache->save();
     }
     if (errorContext.failed) {
         setStatus(lock, STATUS_FAILED, errorContext.extendedStatus);
@@ -264,6 +285,11 @@ bool WorkerFindAllRequestPOSIX::execute() {
         FileUtils::partitionedFiles(databaseInfo, 0).size();
 
     for (auto&& entry: chunk2fileInfoCollection) {
+        if (not packedTables.empty()) {
+            for (auto&& file: entry.second) {
+                file.packed = packedTables.count(fs::path(file.name).stem().string()) != 0;
+            }
+        }
         unsigned int const chunk    = entry.first;
         size_t       const numFiles = entry.second.size();
         _replicaInfoCollection.emplace_back(
@@ -24,6 +24,9 @@
 #include "replica/WorkerFindRequest.h"
 
 // System headers
+#include <algorithm>
+#include <cstring>
+#include <random>
 
 // Third party headers
 #include <boost/filesystem.hpp>
@@ -31,6 +34,8 @@
 // Qserv headers
 #include "lsst/log/Log.h"
 #include "replica/Configuration.h"
+#include "replica/FileBlockManifest.h"
+#include "replica/FileCsCache.h"
 #include "replica/FileUtils.h"
 #include "replica/Performance.h"
 #include "replica/ServiceProvider.h"
@@ -58,7 +63,8 @@ WorkerFindRequest::Ptr WorkerFindRequest::create(
                                 int                priority,
                                 std::string const& database,
                                 unsigned int       chunk,
-                                bool               computeCheckSum) {
+                                bool               computeCheckSum,
+                                double             sampleRate) {
     return WorkerFindRequest::Ptr(
         new WorkerFindRequest(
                 serviceProvider,
@@ -67,7 +73,8 @@ WorkerFindRequest::Ptr WorkerFindRequest::create(
                 priority,
                 database,
                 chunk,
-                computeCheckSum));
+                computeCheckSum,
+                sampleRate));
 }
 
 WorkerFindRequest::WorkerFindRequest(
@@ -77,7 +84,8 @@ WorkerFindRequest::WorkerFindRequest(
                         int                priority,
                         std::string const& database,
                         unsigned int       chunk,
-                        bool               computeCheckSum)
+                        bool               computeCheckSum,
+                        double             sampleRate)
     :   WorkerRequest(
             serviceProvider,
             worker,
@@ -86,7 +94,8 @@ WorkerFindRequest::WorkerFindRequest(
             priority),
         _database(database),
         _chunk(chunk),
-        _computeCheckSum(computeCheckSum) {
+        _computeCheckSum(computeCheckSum),
+        _sampleRate(sampleRate) {
 
     serviceProvider->assertDatabaseIsValid(database);
 }
@@ -115,6 +124,7 @@ void WorkerFindRequest::setInfo(proto::ReplicationResponseFind& response) const
     protoRequestPtr->set_database(  database());
     protoRequestPtr->set_chunk(     chunk());
     protoRequestPtr->set_compute_cs(computeCheckSum());
+    protoRequestPtr->set_sample_rate(sampleRate());
 
     response.set_allocated_request(protoRequestPtr);
 }
@@ -152,7 +162,8 @@ WorkerFindRequestPOSIX::Ptr WorkerFindRequestPOSIX::create(
                                     int                priority,
                                     std::string const& database,
                                     unsigned int       chunk,
-                                    bool               computeCheckSum) {
+                                    bool               computeCheckSum,
+                                    double             sampleRate) {
     return WorkerFindRequestPOSIX::Ptr(
         new WorkerFindRequestPOSIX(
                 serviceProvider,
@@ -161,7 +172,8 @@ WorkerFindRequestPOSIX::Ptr WorkerFindRequestPOSIX::create(
                 priority,
                 database,
                 chunk,
-                computeCheckSum));
+                computeCheckSum,
+                sampleRate));
 }
 
 WorkerFindRequestPOSIX::WorkerFindRequestPOSIX(
@@ -171,7 +183,8 @@ WorkerFindRequestPOSIX::WorkerFindRequestPOSIX(
                             int                priority,
                             std::string const& database,
                             unsigned int       chunk,
-                            bool               computeCheckSum)
+                            bool               computeCheckSum,
+                            double             sampleRate)
     :   WorkerFindRequest(
             serviceProvider,
             worker,
@@ -179,7 +192,8 @@ WorkerFindRequestPOSIX::WorkerFindRequestPOSIX(
             priority,
             database,
             chunk,
-            computeCheckSum) {
+            computeCheckSum,
+            sampleRate) {
 }
 
 bool WorkerFindRequestPOSIX::execute() {
@@ -255,6 +269,10 @@ bool WorkerFindRequestPOSIX::execute() {
         ReplicaInfo::FileInfoCollection fileInfoCollection; // file info if not using the incremental processing
         std::vector<std::string>        files;              // file paths registered for the incremental processing
 
+        FileBlockManifest::Ptr manifest;        // the block manifests of the files (if sampling)
+        std::mt19937_64 generator(std::random_device{}());
+        bool corrupt = false;                   // set if any sampled block didn't match
+
         for (auto&& file: FileUtils::partitionedFiles(databaseInfo, chunk())) {
 
             fs::path        const path = dataDir / file;
@@ -294,13 +312,89 @@ bool WorkerFindRequestPOSIX::execute() {
                             "",     /* cs */
                             0,      /* beginTransferTime */
                             0,      /* endTransferTime */
-                            size    /* inSize */
+                            size,   /* inSize */
+                            "",     /* csAlgorithm */
+                            FileUtils::isPackedMyISAM(path.string()),
+                            0,      /* unpackedSize */
+                            ""      /* unpackedCs */
                         })
                     );
+
+                    // Read back a random sample of the blocks of the file and
+                    // compare them with the ones recorded when the file was
+                    // replicated. The files without the manifest are only
+                    // checked by their size and mtime.
+
+                    if ((_sampleRate > 0) and not errorContext.failed) {
+
+                        if (not manifest) manifest = FileBlockManifest::instance(worker(), workerInfo.dataDir);
+
+                        FileCsCache::Stat fileStat{0, 0, 0};
+                        std::vector<uint32_t> crcs;
+                        if ((FileCsCache::stat(path.string(), fileStat) == 0) and
+                            manifest->find(path.string(), fileStat, crcs)) {
+                            try {
+                                if (FileBlockManifest::sample(path.string(), crcs, _sampleRate, generator) != 0) {
+                                    LOGS(_log, LOG_LVL_ERROR, context() << "execute"
+                                         << "  corrupt blocks in file: " << path.string());
+                                    corrupt = true;
+                                }
+                            } catch (std::exception const& ex) {
+                                errorContext = errorContext
+                                    or reportErrorIf(
+                                            true,
+                                            ExtendedCompletionStatus::EXT_STATUS_FILE_READ,
+                                            "failed to sample file: " + path.string() +
+                                            ", error: " + ex.what());
+                            }
+                        } else {
+                            LOGS(_log, LOG_LVL_DEBUG, context() << "execute"
+                                 << "  no block manifest for file: " << path.string());
+                        }
+                    }
                 } else {
 
-                    // Register this file for the incremental processing
-                    files.push_back(path.string());
+                    // The control sums of the files which haven't changed since
+                    // they were computed are taken from the cache
+
+                    if (not _csCache) _csCache = FileCsCache::instance(worker(), workerInfo.dataDir);
+
+                    FileCsCache::Stat fileStat{0, 0, 0};
+                    int const err = FileCsCache::stat(path.string(), fileStat);
+                    errorContext = errorContext
+                        or reportErrorIf(
+                                err != 0,
+                                ExtendedCompletionStatus::EXT_STATUS_FILE_STAT,
+                                "failed to check the status of file: " + path.string() +
+                                ", error: " + std::strerror(err));
+
+                    std::string cs;
+                    std::string csAlgorithm;
+                    if ((err == 0) and
+                        _csCache->find(path.string(), fileStat, cs, csAlgorithm) and
+                        (csAlgorithm == ParallelCsComputeEngine::ALGORITHM)) {
+
+                        _cachedFileInfoCollection.emplace_back(
+                            ReplicaInfo::FileInfo({
+                                file,
+                                fileStat.size,
+                                fileStat.mtime,
+                                cs,
+                                0,              /* beginTransferTime */
+                                0,              /* endTransferTime */
+                                fileStat.size,  /* inSize */
+                                csAlgorithm,
+                                FileUtils::isPackedMyISAM(path.string()),
+                                0,              /* unpackedSize */
+                                ""              /* unpackedCs */
+                            })
+                        );
+                    } else {
+
+                        // Register this file for the incremental processing
+                        files.push_back(path.string());
+                        _file2stat[path.string()] = fileStat;
+                    }
                 }
             }
         }
@@ -319,6 +413,7 @@ bool WorkerFindRequestPOSIX::execute() {
                                         chunk()).size() == fileInfoCollection.size() ?
                                             ReplicaInfo::Status::COMPLETE :
                                             ReplicaInfo::Status::INCOMPLETE;
+            if (corrupt) status = ReplicaInfo::Status::CORRUPT;
 
             // Fill in the info on the chunk before finishing the operation
             _replicaInfo = ReplicaInfo(
@@ -334,8 +429,14 @@ bool WorkerFindRequestPOSIX::execute() {
             return true;
         }
 
-        // Otherwise proceed with the incremental approach
-        _csComputeEnginePtr.reset(new MultiFileCsComputeEngine(files));
+        // Otherwise hash the files on the threads shared by all requests, and
+        // keep checking if they're done.
+        _csComputeEnginePtr.reset(
+            new ParallelCsComputeEngine(
+                files,
+                _serviceProvider->config()->workerNumProcessingThreads(),
+                ParallelCsComputeEngine::DEFAULT_RECORD_SIZE_BYTES,
+                std::max<size_t>(1, _serviceProvider->config()->workerFsIoDepth())));
     }
 
     // Next (or the first) iteration in the incremental approach
@@ -362,22 +463,33 @@ bool WorkerFindRequestPOSIX::execute() {
                             ExtendedCompletionStatus::EXT_STATUS_FILE_MTIME,
                             "failed to read file mtime: " + path.string());
 
+                std::string const cs = std::to_string(_csComputeEnginePtr->cs(file));
                 fileInfoCollection.emplace_back(
                     ReplicaInfo::FileInfo({
                         path.filename().string(),
                         size,
                         mtime,
-                        std::to_string(_csComputeEnginePtr->cs(file)),
+                        cs,
                         0,      /* beginTransferTime */
                         0,      /* endTransferTime */
-                        size    /* inSize */
+                        size,   /* inSize */
+                        ParallelCsComputeEngine::ALGORITHM,
+                        FileUtils::isPackedMyISAM(file),
+                        0,      /* unpackedSize */
+                        ""      /* unpackedCs */
                     })
                 );
+                _csCache->update(file, _file2stat[file], cs, ParallelCsComputeEngine::ALGORITHM);
             }
             if (errorContext.failed) {
                 setStatus(lock, STATUS_FAILED, errorContext.extendedStatus);
                 return true;
             }
+            if (_csCache) _csCache->save();
+
+            fileInfoCollection.insert(fileInfoCollection.end(),
+                                      _cachedFileInfoCollection.begin(),
+                                      _cachedFileInfoCollection.end());
 
             // Fnalize the operation
 
@@ -388,7 +500,7 @@ bool WorkerFindRequestPOSIX::execute() {
             if (fileInfoCollection.size())
                 status = FileUtils::partitionedFiles(
                                         databaseInfo,
-                                        chunk()).size() == fileNames.size() ?
+                                        chunk()).size() == fileInfoCollection.size() ?
                                             ReplicaInfo::Status::COMPLETE :
                                             ReplicaInfo::Status::INCOMPLETE;
 
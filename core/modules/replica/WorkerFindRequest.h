@@ -24,9 +24,11 @@
 #define LSST_QSERV_REPLICA_WORKERFINDREQUEST_H
 
 // System headers
+#include <map>
 #include <string>
 
 // Qserv headers
+#include "replica/FileCsCache.h"
 #include "replica/ReplicaInfo.h"
 #include "replica/WorkerRequest.h"
 
@@ -37,7 +39,7 @@ namespace qserv {
 namespace replica {
 
 // Forward declarations
-class MultiFileCsComputeEngine;
+class ParallelCsComputeEngine;
 
 /**
   * Class WorkerFindRequest represents a context and a state of replica lookup
@@ -67,6 +69,8 @@ public:
      * @param chunk            - the chunk number
      * @param computeCheckSum  - flag indicating if check/control sums should be
      *                           computed on all files of the chunk
+     * @param sampleRate       - the fraction of the blocks of each file to be
+     *                           checked against the block manifest (0 to skip)
      *
      * @return pointer to the created object
      */
@@ -76,7 +80,8 @@ public:
                       int priority,
                       std::string const& database,
                       unsigned int chunk,
-                      bool computeCheckSum);
+                      bool computeCheckSum,
+                      double sampleRate);
 
     // Default construction and copy semantics are prohibited
 
@@ -94,6 +99,8 @@ public:
 
     bool computeCheckSum() const { return _computeCheckSum; }
 
+    double sampleRate() const { return _sampleRate; }
+
     /**
      * Extract request status into the Protobuf response object.
      *
@@ -120,7 +127,8 @@ protected:
                       int priority,
                       std::string const& database,
                       unsigned int chunk,
-                      bool computeCheckSum);
+                      bool computeCheckSum,
+                      double sampleRate);
 protected:
 
     /// The name of a database
@@ -133,6 +141,10 @@ protected:
     /// computed on all files of the chunk
     bool const _computeCheckSum;
 
+    /// The fraction of the blocks of each file to be checked against
+    /// the block manifest of the file
+    double const _sampleRate;
+
     /// Result of the operation
     ReplicaInfo _replicaInfo;
 };
@@ -163,6 +175,8 @@ public:
      * @param chunk            - the chunk number
      * @param computeCheckSum  - flag indicating if check/control sums should be
      *                           computed on all files of the chunk
+     * @param sampleRate       - the fraction of the blocks of each file to be
+     *                           checked against the block manifest (0 to skip)
      *
      * @return pointer to the created object
      */
@@ -172,7 +186,8 @@ public:
                       int priority,
                       std::string const& database,
                       unsigned int chunk,
-                      bool computeCheckSum);
+                      bool computeCheckSum,
+                      double sampleRate);
 
     // Default construction and copy semantics are prohibited
 
@@ -200,12 +215,23 @@ private:
                            int priority,
                            std::string const& database,
                            unsigned int chunk,
-                           bool computeCheckSum);
+                           bool computeCheckSum,
+                           double sampleRate);
 
 private:
     
-    /// The engine for incremental control sum calculation
-    std::unique_ptr<MultiFileCsComputeEngine> _csComputeEnginePtr;
+    /// The engine computing the control sums of the files
+    std::unique_ptr<ParallelCsComputeEngine> _csComputeEnginePtr;
+
+    /// The control sums of the worker's files computed earlier
+    FileCsCache::Ptr _csCache;
+
+    /// The files whose control sums were found in the cache
+    ReplicaInfo::FileInfoCollection _cachedFileInfoCollection;
+
+    /// The attributes of the files passed to the engine, as they were
+    /// before the files were read
+    std::map<std::string, FileCsCache::Stat> _file2stat;
 };
 
 /**
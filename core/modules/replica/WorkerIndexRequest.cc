@@ -0,0 +1,488 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "replica/WorkerIndexRequest.h"
+
+// System headers
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+// Third party headers
+#include <boost/filesystem.hpp>
+
+// Qserv headers
+#include "lsst/log/Log.h"
+#include "replica/Performance.h"
+#include "replica/ServiceProvider.h"
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.replica.WorkerIndexRequest");
+
+/// The run files are prefixed with this string
+std::string const runFilePrefix = "_index_";
+
+/// The maximum number of records sorted in memory before they're written
+/// into a temporary run (256 MB)
+size_t const maxRunRecords = 16 * 1024 * 1024;
+
+/// The maximum number of temporary runs read at a time by a merge pass
+size_t const maxMergeFanIn = 64;
+
+} /// namespace
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+/////////////////////////////////////////////////////////////
+///////////////////// WorkerIndexRequest ////////////////////
+/////////////////////////////////////////////////////////////
+
+WorkerIndexRequest::Ptr WorkerIndexRequest::create(
+                                ServiceProvider::Ptr const& serviceProvider,
+                                std::string const& worker,
+                                std::string const& id,
+                                int                priority,
+                                std::string const& database,
+                                std::string const& table,
+                                std::string const& keyColumn,
+                                std::vector<unsigned int> const& chunks) {
+    return WorkerIndexRequest::Ptr(
+        new WorkerIndexRequest(
+                serviceProvider,
+                worker,
+                id,
+                priority,
+                database,
+                table,
+                keyColumn,
+                chunks));
+}
+
+WorkerIndexRequest::WorkerIndexRequest(
+                                ServiceProvider::Ptr const& serviceProvider,
+                                std::string const& worker,
+                                std::string const& id,
+                                int                priority,
+                                std::string const& database,
+                                std::string const& table,
+                                std::string const& keyColumn,
+                                std::vector<unsigned int> const& chunks)
+    :   WorkerRequest (
+            serviceProvider,
+            worker,
+            "INDEX",
+            id,
+            priority),
+        _database(database),
+        _table(table),
+        _keyColumn(keyColumn),
+        _chunks(chunks) {
+
+    serviceProvider->assertDatabaseIsValid(database);
+
+    _progress.numChunks = _chunks.size();
+}
+
+std::string WorkerIndexRequest::runFile() const {
+    return ::runFilePrefix + table() + ".run";
+}
+
+void WorkerIndexRequest::setInfo(proto::ReplicationResponseIndex& response) const {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "setInfo");
+
+    util::Lock lock(_mtx, context() + "setInfo");
+
+    // Return the performance of the target request
+
+    response.set_allocated_target_performance(performance().info());
+
+    // Note the ownership transfer of the intermediate Protobuf objects
+    // in the calls below. The Protobuf run-time will take care of deleting
+    // them.
+
+    auto protoInfoPtr = new proto::ReplicationIndexInfo();
+    {
+        std::lock_guard<std::mutex> progressLock(_progressMtx);
+
+        protoInfoPtr->set_num_chunks( _progress.numChunks);
+        protoInfoPtr->set_chunks_read(_progress.chunksRead);
+        protoInfoPtr->set_num_records(_progress.numRecords);
+        protoInfoPtr->set_file(       _progress.file);
+    }
+    response.set_allocated_index_info(protoInfoPtr);
+
+    auto protoRequestPtr = new proto::ReplicationRequestIndex();
+
+    protoRequestPtr->set_priority(  priority());
+    protoRequestPtr->set_database(  database());
+    protoRequestPtr->set_table(     table());
+    protoRequestPtr->set_key_column(keyColumn());
+
+    for (auto chunk: chunks()) protoRequestPtr->add_chunks(chunk);
+
+    response.set_allocated_request(protoRequestPtr);
+}
+
+bool WorkerIndexRequest::execute() {
+
+   LOGS(_log, LOG_LVL_DEBUG, context() << "execute"
+         << "  db: "     << database()
+         << "  table: "  << table()
+         << "  chunks: " << chunks().size());
+
+    bool const complete = WorkerRequest::execute();
+    if (complete) {
+        std::lock_guard<std::mutex> progressLock(_progressMtx);
+        _progress.chunksRead = _progress.numChunks;
+        _progress.file       = runFile();
+    }
+    return complete;
+}
+
+///////////////////////////////////////////////////////////////
+///////////////////// WorkerIndexRequestFS ////////////////////
+///////////////////////////////////////////////////////////////
+
+WorkerIndexRequestFS::Ptr WorkerIndexRequestFS::create(
+                                    ServiceProvider::Ptr const& serviceProvider,
+                                    std::string const& worker,
+                                    std::string const& id,
+                                    int                priority,
+                                    std::string const& database,
+                                    std::string const& table,
+                                    std::string const& keyColumn,
+                                    std::vector<unsigned int> const& chunks) {
+    return WorkerIndexRequestFS::Ptr(
+        new WorkerIndexRequestFS(
+                serviceProvider,
+                worker,
+                id,
+                priority,
+                database,
+                table,
+                keyColumn,
+                chunks));
+}
+
+WorkerIndexRequestFS::WorkerIndexRequestFS(
+                                    ServiceProvider::Ptr const& serviceProvider,
+                                    std::string const& worker,
+                                    std::string const& id,
+                                    int                priority,
+                                    std::string const& database,
+                                    std::string const& table,
+                                    std::string const& keyColumn,
+                                    std::vector<unsigned int> const& chunks)
+    :   WorkerIndexRequest(
+                serviceProvider,
+                worker,
+                id,
+                priority,
+                database,
+                table,
+                keyColumn,
+                chunks),
+        _workerInfo(serviceProvider->config()->workerInfo(worker)),
+        _connectionParams(
+            database::mysql::ConnectionParams::parse(
+                serviceProvider->config()->workerIngestDatabase(),
+                "localhost",
+                3306,
+                "qsmaster",
+                "")),
+        _finished(false),
+        _stop(false) {
+
+    DatabaseInfo const databaseInfo = serviceProvider->config()->databaseInfo(database);
+    if (databaseInfo.partitionedTables.end() == std::find(databaseInfo.partitionedTables.begin(),
+                                                          databaseInfo.partitionedTables.end(),
+                                                          table)) {
+        throw std::invalid_argument(
+                context() + "not a partitioned table: " + table +
+                " of database: " + database);
+    }
+    if (keyColumn.empty()) {
+        throw std::invalid_argument(context() + "the key column is empty");
+    }
+}
+
+WorkerIndexRequestFS::~WorkerIndexRequestFS() {
+    stopHarvest();
+}
+
+bool WorkerIndexRequestFS::execute() {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "execute"
+         << "  database: " << database()
+         << "  table: "    << table());
+
+    // The thread reads the chunks on its own. Wait for it without holding
+    // the lock, which is shared by all requests.
+
+    if (_driver.joinable()) {
+        std::unique_lock<std::mutex> harvestLock(_harvestMtx);
+        _harvestCv.wait_for(harvestLock, std::chrono::milliseconds(100), [this]() { return _finished; });
+    }
+
+    util::Lock lock(_mtx, context() + "execute");
+
+    // Abort the operation right away if that's the case
+
+    if (_status == STATUS_IS_CANCELLING) {
+        stopHarvest();
+        setStatus(lock, STATUS_CANCELLED);
+        throw WorkerRequestCancelled();
+    }
+
+    // Start reading the chunks (again, if the request was stopped or rolled back)
+
+    if (not _driver.joinable()) {
+        {
+            std::lock_guard<std::mutex> harvestLock(_harvestMtx);
+            _finished     = false;
+            _stop         = false;
+            _harvestError = WorkerRequest::ErrorContext();
+        }
+        {
+            std::lock_guard<std::mutex> progressLock(_progressMtx);
+            _progress.chunksRead = 0;
+            _progress.numRecords = 0;
+            _progress.file.clear();
+        }
+        _driver = std::thread(&WorkerIndexRequestFS::harvest, this);
+        return false;
+    }
+
+    WorkerRequest::ErrorContext errorContext;
+    {
+        std::lock_guard<std::mutex> harvestLock(_harvestMtx);
+        if (not _finished) return false;
+        errorContext = _harvestError;
+    }
+    _driver.join();
+
+    if (errorContext.failed) {
+        setStatus(lock, STATUS_FAILED, errorContext.extendedStatus);
+    } else {
+        std::lock_guard<std::mutex> progressLock(_progressMtx);
+        _progress.file = runFile();
+        setStatus(lock, STATUS_SUCCEEDED);
+    }
+    return true;
+}
+
+void WorkerIndexRequestFS::harvest() {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "harvest"
+         << "  chunks: " << chunks().size());
+
+    WorkerRequest::ErrorContext errorContext;
+
+    database::mysql::Connection::Ptr conn;
+    try {
+        conn = database::mysql::Connection::open(_connectionParams);
+    } catch (database::mysql::Error const& ex) {
+        errorContext = errorContext
+            or reportErrorIf(
+                true,
+                ExtendedCompletionStatus::EXT_STATUS_MYSQL_ERROR,
+                std::string("failed to connect to the database server, error: ") + ex.what());
+    }
+    try {
+        for (auto chunk: chunks()) {
+            if (errorContext.failed or stopped()) break;
+            errorContext = errorContext or readChunk(conn, chunk);
+            if (_records.size() >= ::maxRunRecords) spill();
+        }
+        if (not errorContext.failed and not stopped()) {
+            spill();
+            merge();
+        }
+
+    } catch (std::runtime_error const& ex) {
+        errorContext = errorContext
+            or reportErrorIf(
+                true,
+                ExtendedCompletionStatus::EXT_STATUS_FILE_WRITE,
+                std::string("failed to write the run of table: ") + table() +
+                ", database: " + database() + ", error: " + ex.what());
+    }
+
+    // The temporary runs aren't needed anymore, and they're of no use
+    // if the operation failed.
+
+    for (auto&& run: _runs) {
+        boost::system::error_code ec;
+        fs::remove(fs::path(run), ec);
+    }
+    _runs.clear();
+    _records.clear();
+    _records.shrink_to_fit();
+    {
+        std::lock_guard<std::mutex> harvestLock(_harvestMtx);
+        _harvestError = errorContext;
+        _finished     = true;
+    }
+    _harvestCv.notify_all();
+}
+
+WorkerRequest::ErrorContext WorkerIndexRequestFS::readChunk(
+                                        database::mysql::Connection::Ptr const& conn,
+                                        unsigned int chunk) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "readChunk  chunk: " << chunk);
+
+    WorkerRequest::ErrorContext errorContext;
+
+    std::string const chunkTable = table() + "_" + std::to_string(chunk);
+    uint64_t numRecords = 0;
+    try {
+        conn->execute("SELECT " + conn->sqlId(keyColumn()) + ",`chunkId`,`subChunkId` FROM " +
+                      conn->sqlId(database()) + "." + conn->sqlId(chunkTable));
+
+        database::mysql::Row row;
+        while (conn->next(row)) {
+            SecondaryIndexRecord record;
+            errorContext = errorContext
+                or reportErrorIf(
+                    not (row.get(0, record.key) and
+                         row.get(1, record.chunk) and
+                         row.get(2, record.subChunk)),
+                    ExtendedCompletionStatus::EXT_STATUS_MYSQL_ERROR,
+                    "NULL found in the key or the location of a row of table: " + chunkTable +
+                    ", database: " + database());
+            if (errorContext.failed) return errorContext;
+            _records.push_back(record);
+            ++numRecords;
+        }
+
+    } catch (database::mysql::Error const& ex) {
+        return errorContext
+            or reportErrorIf(
+                true,
+                ExtendedCompletionStatus::EXT_STATUS_MYSQL_ERROR,
+                "failed to read table: " + chunkTable +
+                ", database: " + database() + ", error: " + ex.what());
+    }
+    std::lock_guard<std::mutex> progressLock(_progressMtx);
+    ++_progress.chunksRead;
+    _progress.numRecords += numRecords;
+
+    return errorContext;
+}
+
+void WorkerIndexRequestFS::spill() {
+
+    // An empty run is still written if no records were found, so that
+    // the merge always has an input.
+
+    if (_records.empty() and not _runs.empty()) return;
+
+    std::sort(_records.begin(), _records.end());
+
+    fs::path const path = fs::path(_workerInfo.dataDir) / database() /
+                          (runFile() + "." + std::to_string(_runs.size()));
+    _runs.push_back(path.string());
+
+    SecondaryIndexRunWriter writer(path.string());
+    for (auto&& record: _records) writer.write(record);
+    writer.close();
+
+    _records.clear();
+}
+
+void WorkerIndexRequestFS::merge() {
+
+    fs::path const dataDir = fs::path(_workerInfo.dataDir) / database();
+
+    // The intermediate passes bring the number of runs down to the fan-in
+    // of the final pass.
+
+    size_t numPasses = 0;
+    while (_runs.size() > ::maxMergeFanIn) {
+        if (stopped()) return;
+
+        std::vector<std::string> const inputs(_runs.begin(), _runs.begin() + ::maxMergeFanIn);
+
+        std::vector<SecondaryIndexRunReader::Ptr> readers;
+        for (auto&& input: inputs) {
+            readers.push_back(std::make_shared<SecondaryIndexFileRunReader>(input));
+        }
+        fs::path const path = dataDir / (runFile() + ".m" + std::to_string(numPasses++));
+        _runs.push_back(path.string());
+
+        SecondaryIndexRunMerger merger(readers);
+        SecondaryIndexRunWriter writer(path.string());
+        SecondaryIndexRecord record;
+        while (merger.read(record)) writer.write(record);
+        writer.close();
+
+        for (auto&& input: inputs) {
+            boost::system::error_code ec;
+            fs::remove(fs::path(input), ec);
+        }
+        _runs.erase(_runs.begin(), _runs.begin() + ::maxMergeFanIn);
+    }
+    if (stopped()) return;
+
+    fs::path const path = dataDir / runFile();
+    if (_runs.size() == 1) {
+        fs::rename(fs::path(_runs.front()), path);
+        _runs.clear();
+        return;
+    }
+    std::vector<SecondaryIndexRunReader::Ptr> readers;
+    for (auto&& run: _runs) {
+        readers.push_back(std::make_shared<SecondaryIndexFileRunReader>(run));
+    }
+    SecondaryIndexRunMerger merger(readers);
+    SecondaryIndexRunWriter writer(path.string());
+    SecondaryIndexRecord record;
+    while (merger.read(record)) writer.write(record);
+    writer.close();
+}
+
+bool WorkerIndexRequestFS::stopped() {
+    std::lock_guard<std::mutex> harvestLock(_harvestMtx);
+    return _stop;
+}
+
+void WorkerIndexRequestFS::stopHarvest() {
+    {
+        std::lock_guard<std::mutex> harvestLock(_harvestMtx);
+        _stop = true;
+    }
+
+    // A chunk which is being read is read to the end before the thread
+    // notices the flag. The thread removes its temporary runs.
+
+    if (_driver.joinable()) _driver.join();
+}
+
+}}} // namespace lsst::qserv::replica
@@ -0,0 +1,309 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_REPLICA_WORKERINDEXREQUEST_H
+#define LSST_QSERV_REPLICA_WORKERINDEXREQUEST_H
+
+// System headers
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Qserv headers
+#include "proto/replication.pb.h"
+#include "replica/Common.h"
+#include "replica/Configuration.h"
+#include "replica/DatabaseMySQL.h"
+#include "replica/SecondaryIndexRun.h"
+#include "replica/WorkerRequest.h"
+
+// This header declarations
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+/**
+  * Class WorkerIndexRequest represents a context and a state of the secondary
+  * index requests within the worker servers. It can also be used for testing
+  * the framework operation as its implementation won't make any changes to
+  * any files or databases.
+  *
+  * Real implementations of the request processing must derive from this class.
+  */
+class WorkerIndexRequest
+    :   public WorkerRequest {
+
+public:
+
+    /// Pointer to self
+    typedef std::shared_ptr<WorkerIndexRequest> Ptr;
+
+    /**
+     * Static factory method is needed to prevent issue with the lifespan
+     * and memory management of instances created otherwise (as values or via
+     * low-level pointers).
+     *
+     * @param serviceProvider  - a host of services for various communications
+     * @param worker           - the name of a worker
+     * @param id               - an identifier of a client request
+     * @param priority         - indicates the importance of the request
+     * @param database         - the name of a database
+     * @param table            - the base name of the director table
+     * @param keyColumn        - the name of the column with the keys of the table
+     * @param chunks           - the chunks to be harvested
+     *
+     * @return pointer to the created object
+     */
+    static Ptr create(ServiceProvider::Ptr const& serviceProvider,
+                      std::string const& worker,
+                      std::string const& id,
+                      int priority,
+                      std::string const& database,
+                      std::string const& table,
+                      std::string const& keyColumn,
+                      std::vector<unsigned int> const& chunks);
+
+    // Default construction and copy semantics are prohibited
+
+    WorkerIndexRequest() = delete;
+    WorkerIndexRequest(WorkerIndexRequest const&) = delete;
+    WorkerIndexRequest& operator=(WorkerIndexRequest const&) = delete;
+
+    /// Destructor
+    ~WorkerIndexRequest() override = default;
+
+    // Trivial get methods
+
+    std::string const& database() const { return _database; }
+
+    std::string const& table() const { return _table; }
+
+    std::string const& keyColumn() const { return _keyColumn; }
+
+    std::vector<unsigned int> const& chunks() const { return _chunks; }
+
+    /// @return the name of the run file in the database folder of the worker
+    std::string runFile() const;
+
+    /**
+     * Extract request status into the Protobuf response object.
+     *
+     * @param response
+     *   Protobuf response to be initialized
+     */
+    void setInfo(proto::ReplicationResponseIndex& response) const;
+
+    /**
+     * @see WorkerRequest::execute
+     */
+    bool execute() override;
+
+protected:
+
+    /**
+     * The normal constructor of the class
+     *
+     * @see WorkerIndexRequest::create()
+     */
+    WorkerIndexRequest(ServiceProvider::Ptr const& serviceProvider,
+                       std::string const& worker,
+                       std::string const& id,
+                       int priority,
+                       std::string const& database,
+                       std::string const& table,
+                       std::string const& keyColumn,
+                       std::vector<unsigned int> const& chunks);
+
+protected:
+
+    /// The name of a database
+    std::string const _database;
+
+    /// The base name of the director table
+    std::string const _table;
+
+    /// The name of the column with the keys of the table
+    std::string const _keyColumn;
+
+    /// The chunks to be harvested
+    std::vector<unsigned int> const _chunks;
+
+    /// The progress of the request, updated while the chunks are being read
+    struct Progress {
+        uint32_t    numChunks  = 0;
+        uint32_t    chunksRead = 0;
+        uint64_t    numRecords = 0;
+        std::string file;
+    } _progress;
+
+    /// Protects _progress
+    mutable std::mutex _progressMtx;
+};
+
+/**
+  * Class WorkerIndexRequestFS provides an actual implementation for the secondary
+  * index requests. The key, chunkId and subChunkId of all rows of the chunk
+  * tables are read from the MySQL server of the worker. The records are sorted
+  * in memory and written into temporary runs of a bounded size, which are then
+  * merged into the run file of the request in the database folder of the worker.
+  * A run file left by a previous request for the same table is replaced.
+  */
+class WorkerIndexRequestFS
+    :   public WorkerIndexRequest {
+
+public:
+
+    /// Pointer to self
+    typedef std::shared_ptr<WorkerIndexRequestFS> Ptr;
+
+    /**
+     * Static factory method is needed to prevent issue with the lifespan
+     * and memory management of instances created otherwise (as values or via
+     * low-level pointers).
+     *
+     * @see WorkerIndexRequest::create()
+     *
+     * @throws std::invalid_argument - if the table is not a partitioned table
+     *                                 of the database, or if the key column
+     *                                 is empty
+     */
+    static Ptr create(ServiceProvider::Ptr const& serviceProvider,
+                      std::string const& worker,
+                      std::string const& id,
+                      int priority,
+                      std::string const& database,
+                      std::string const& table,
+                      std::string const& keyColumn,
+                      std::vector<unsigned int> const& chunks);
+
+    // Default construction and copy semantics are prohibited
+
+    WorkerIndexRequestFS() = delete;
+    WorkerIndexRequestFS(WorkerIndexRequestFS const&) = delete;
+    WorkerIndexRequestFS& operator=(WorkerIndexRequestFS const&) = delete;
+
+    /// Destructor (non trivial one is needed to release resources)
+    ~WorkerIndexRequestFS() override;
+
+    /**
+     * @see WorkerIndexRequest::execute
+     */
+    bool execute() override;
+
+protected:
+
+    /**
+     * The normal constructor of the class
+     *
+     * @see WorkerIndexRequestFS::create()
+     */
+    WorkerIndexRequestFS(ServiceProvider::Ptr const& serviceProvider,
+                         std::string const& worker,
+                         std::string const& id,
+                         int priority,
+                         std::string const& database,
+                         std::string const& table,
+                         std::string const& keyColumn,
+                         std::vector<unsigned int> const& chunks);
+
+private:
+
+    /**
+     * Read the chunks, write the temporary runs and merge them into
+     * the run file. This runs in the thread started by the first call
+     * to execute().
+     */
+    void harvest();
+
+    /**
+     * Read the records of a chunk into the buffer
+     *
+     * @param conn  - the connection to the MySQL server
+     * @param chunk - the chunk to be read
+     *
+     * @return the error context of the operation
+     */
+    WorkerRequest::ErrorContext readChunk(std::shared_ptr<database::mysql::Connection> const& conn,
+                                          unsigned int chunk);
+
+    /**
+     * Sort the records of the buffer and write them into a new temporary run
+     *
+     * @throws std::runtime_error - if the run couldn't be written
+     */
+    void spill();
+
+    /**
+     * Merge the temporary runs into the run file. The runs are merged
+     * in passes reading a limited number of files at a time.
+     *
+     * @throws std::runtime_error - if the runs couldn't be merged
+     */
+    void merge();
+
+    /// @return 'true' if the thread was told to stop
+    bool stopped();
+
+    /// Stop and join the thread, and remove the temporary runs
+    void stopHarvest();
+
+private:
+
+    /// Cached descriptor of the worker obtained from the Configuration
+    WorkerInfo const _workerInfo;
+
+    /// The connection parameters of the MySQL server of the worker
+    database::mysql::ConnectionParams const _connectionParams;
+
+    /// The thread running harvest()
+    std::thread _driver;
+
+    /// Protects the members below
+    std::mutex _harvestMtx;
+
+    /// Notified when the driver finishes
+    std::condition_variable _harvestCv;
+
+    /// True once the driver has finished
+    bool _finished;
+
+    /// Tells the driver to stop after the current chunk
+    bool _stop;
+
+    /// The error reported by the driver
+    WorkerRequest::ErrorContext _harvestError;
+
+    /// The temporary runs written so far (used by the driver only)
+    std::vector<std::string> _runs;
+
+    /// The records read since the last temporary run (used by the driver only)
+    std::vector<SecondaryIndexRecord> _records;
+};
+
+/// Class WorkerIndexRequestFS provides the actual implementation
+typedef WorkerIndexRequestFS WorkerIndexRequestPOSIX;
+
+}}} // namespace lsst::qserv::replica
+
+#endif // LSST_QSERV_REPLICA_WORKERINDEXREQUEST_H
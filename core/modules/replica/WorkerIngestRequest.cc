@@ -0,0 +1,684 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "replica/WorkerIngestRequest.h"
+
+// System headers
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+
+// Third party headers
+#include <boost/filesystem.hpp>
+
+// Qserv headers
+#include "global/constants.h"
+#include "lsst/log/Log.h"
+#include "replica/FileClient.h"
+#include "replica/Performance.h"
+#include "replica/ServiceProvider.h"
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.replica.WorkerIngestRequest");
+
+/// Temporary files of the contributions are prefixed with this string
+std::string const tmpFilePrefix = "_ingest_";
+
+} /// namespace
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+//////////////////////////////////////////////////////////////
+///////////////////// WorkerIngestRequest ////////////////////
+//////////////////////////////////////////////////////////////
+
+WorkerIngestRequest::Ptr WorkerIngestRequest::create(
+                                ServiceProvider::Ptr const& serviceProvider,
+                                std::string const& worker,
+                                std::string const& id,
+                                int                priority,
+                                std::string const& database,
+                                unsigned int       chunk,
+                                std::string const& sourceWorker,
+                                std::vector<IngestFileInfo> const& files,
+                                unsigned int       numLoads,
+                                bool               clusterSubChunks) {
+    return WorkerIngestRequest::Ptr(
+        new WorkerIngestRequest(
+                serviceProvider,
+                worker,
+                id,
+                priority,
+                database,
+                chunk,
+                sourceWorker,
+                files,
+                numLoads,
+                clusterSubChunks));
+}
+
+WorkerIngestRequest::WorkerIngestRequest(
+                                ServiceProvider::Ptr const& serviceProvider,
+                                std::string const& worker,
+                                std::string const& id,
+                                int                priority,
+                                std::string const& database,
+                                unsigned int       chunk,
+                                std::string const& sourceWorker,
+                                std::vector<IngestFileInfo> const& files,
+                                unsigned int       numLoads,
+                                bool               clusterSubChunks)
+    :   WorkerRequest (
+            serviceProvider,
+            worker,
+            "INGEST",
+            id,
+            priority),
+        _database(database),
+        _chunk(chunk),
+        _sourceWorker(sourceWorker),
+        _files(files),
+        _numLoads(numLoads != 0 ? numLoads : serviceProvider->config()->workerNumIngestLoads()),
+        _clusterSubChunks(clusterSubChunks) {
+
+    serviceProvider->assertWorkerIsValid(sourceWorker);
+    serviceProvider->assertDatabaseIsValid(database);
+
+    std::set<std::string> tables;
+    for (auto&& info: _files) tables.insert(chunkTable(info));
+
+    _progress.numFiles  = _files.size();
+    _progress.numTables = tables.size();
+}
+
+std::string WorkerIngestRequest::chunkTable(IngestFileInfo const& info) const {
+    return info.table + (info.overlap ? "FullOverlap" : "") + "_" + std::to_string(chunk());
+}
+
+void WorkerIngestRequest::setInfo(proto::ReplicationResponseIngest& response) const {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "setInfo");
+
+    util::Lock lock(_mtx, context() + "setInfo");
+
+    // Return the performance of the target request
+
+    response.set_allocated_target_performance(performance().info());
+
+    // Note the ownership transfer of the intermediate Protobuf objects
+    // in the calls below. The Protobuf run-time will take care of deleting
+    // them.
+
+    auto protoInfoPtr = new proto::ReplicationIngestInfo();
+    {
+        std::lock_guard<std::mutex> progressLock(_progressMtx);
+
+        protoInfoPtr->set_num_files(     _progress.numFiles);
+        protoInfoPtr->set_files_read(    _progress.filesRead);
+        protoInfoPtr->set_files_loaded(  _progress.filesLoaded);
+        protoInfoPtr->set_bytes_read(    _progress.bytesRead);
+        protoInfoPtr->set_rows_loaded(   _progress.rowsLoaded);
+        protoInfoPtr->set_num_tables(    _progress.numTables);
+        protoInfoPtr->set_tables_indexed(_progress.tablesIndexed);
+    }
+    response.set_allocated_ingest_info(protoInfoPtr);
+
+    auto protoRequestPtr = new proto::ReplicationRequestIngest();
+
+    protoRequestPtr->set_priority( priority());
+    protoRequestPtr->set_database( database());
+    protoRequestPtr->set_chunk(    chunk());
+    protoRequestPtr->set_worker(   sourceWorker());
+    protoRequestPtr->set_num_loads(numLoads());
+    protoRequestPtr->set_cluster_subchunks(clusterSubChunks());
+
+    for (auto&& info: files()) {
+        auto file = protoRequestPtr->add_files();
+        file->set_file(   info.file);
+        file->set_table(  info.table);
+        file->set_overlap(info.overlap);
+    }
+    response.set_allocated_request(protoRequestPtr);
+}
+
+bool WorkerIngestRequest::execute() {
+
+   LOGS(_log, LOG_LVL_DEBUG, context() << "execute"
+         << "  sourceWorker: " << sourceWorker()
+         << "  db: "           << database()
+         << "  chunk: "        << chunk()
+         << "  files: "        << files().size());
+
+    bool const complete = WorkerRequest::execute();
+    if (complete) {
+        std::lock_guard<std::mutex> progressLock(_progressMtx);
+        _progress.filesRead     = _progress.numFiles;
+        _progress.filesLoaded   = _progress.numFiles;
+        _progress.tablesIndexed = _progress.numTables;
+    }
+    return complete;
+}
+
+////////////////////////////////////////////////////////////////
+///////////////////// WorkerIngestRequestFS ////////////////////
+////////////////////////////////////////////////////////////////
+
+WorkerIngestRequestFS::Ptr WorkerIngestRequestFS::create(
+                                    ServiceProvider::Ptr const& serviceProvider,
+                                    std::string const& worker,
+                                    std::string const& id,
+                                    int                priority,
+                                    std::string const& database,
+                                    unsigned int       chunk,
+                                    std::string const& sourceWorker,
+                                    std::vector<IngestFileInfo> const& files,
+                                    unsigned int       numLoads,
+                                    bool               clusterSubChunks) {
+    return WorkerIngestRequestFS::Ptr(
+        new WorkerIngestRequestFS(
+                serviceProvider,
+                worker,
+                id,
+                priority,
+                database,
+                chunk,
+                sourceWorker,
+                files,
+                numLoads,
+                clusterSubChunks));
+}
+
+WorkerIngestRequestFS::WorkerIngestRequestFS(
+                                    ServiceProvider::Ptr const& serviceProvider,
+                                    std::string const& worker,
+                                    std::string const& id,
+                                    int                priority,
+                                    std::string const& database,
+                                    unsigned int       chunk,
+                                    std::string const& sourceWorker,
+                                    std::vector<IngestFileInfo> const& files,
+                                    unsigned int       numLoads,
+                                    bool               clusterSubChunks)
+    :   WorkerIngestRequest(
+                serviceProvider,
+                worker,
+                id,
+                priority,
+                database,
+                chunk,
+                sourceWorker,
+                files,
+                numLoads,
+                clusterSubChunks),
+        _workerInfo(serviceProvider->config()->workerInfo(worker)),
+        _connectionParams(
+            database::mysql::ConnectionParams::parse(
+                serviceProvider->config()->workerIngestDatabase(),
+                "localhost",
+                3306,
+                "qsmaster",
+                "")),
+        _bufSize(serviceProvider->config()->workerFsBufferSizeBytes()),
+        _finished(false),
+        _stop(false) {
+
+    // The files are only loaded into the tables of the chunk, and they're
+    // read from the database folder of the source worker.
+
+    DatabaseInfo const databaseInfo = serviceProvider->config()->databaseInfo(database);
+    for (auto&& info: files) {
+        if (databaseInfo.partitionedTables.end() == std::find(databaseInfo.partitionedTables.begin(),
+                                                              databaseInfo.partitionedTables.end(),
+                                                              info.table)) {
+            throw std::invalid_argument(
+                    context() + "not a partitioned table: " + info.table +
+                    " of database: " + database);
+        }
+        if (info.file.empty() or (info.file.find('/') != std::string::npos)) {
+            throw std::invalid_argument(
+                    context() + "not a file name: '" + info.file + "'");
+        }
+    }
+}
+
+WorkerIngestRequestFS::~WorkerIngestRequestFS() {
+    stopIngest();
+}
+
+bool WorkerIngestRequestFS::execute() {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "execute"
+         << "  sourceWorker: " << sourceWorker()
+         << "  database: "     << database()
+         << "  chunk: "        << chunk());
+
+    // The threads load the files on their own. Wait for them without holding
+    // the lock, which is shared by all requests.
+
+    if (_driver.joinable()) {
+        std::unique_lock<std::mutex> ingestLock(_ingestMtx);
+        _ingestCv.wait_for(ingestLock, std::chrono::milliseconds(100), [this]() { return _finished; });
+    }
+
+    util::Lock lock(_mtx, context() + "execute");
+
+    // Abort the operation right away if that's the case
+
+    if (_status == STATUS_IS_CANCELLING) {
+        stopIngest();
+        setStatus(lock, STATUS_CANCELLED);
+        throw WorkerRequestCancelled();
+    }
+
+    // Start the ingest (again, if the request was stopped or rolled back)
+
+    if (not _driver.joinable()) {
+        {
+            std::lock_guard<std::mutex> ingestLock(_ingestMtx);
+            _queue.assign(files().begin(), files().end());
+            _finished    = false;
+            _stop        = false;
+            _ingestError = WorkerRequest::ErrorContext();
+        }
+        {
+            std::lock_guard<std::mutex> progressLock(_progressMtx);
+            _progress.filesRead     = 0;
+            _progress.filesLoaded   = 0;
+            _progress.bytesRead     = 0;
+            _progress.rowsLoaded    = 0;
+            _progress.tablesIndexed = 0;
+        }
+        _driver = std::thread(&WorkerIngestRequestFS::ingest, this);
+        return false;
+    }
+
+    WorkerRequest::ErrorContext errorContext;
+    {
+        std::lock_guard<std::mutex> ingestLock(_ingestMtx);
+        if (not _finished) return false;
+        errorContext = _ingestError;
+    }
+    _driver.join();
+
+    if (errorContext.failed) {
+        setStatus(lock, STATUS_FAILED, errorContext.extendedStatus);
+    } else {
+        setStatus(lock, STATUS_SUCCEEDED);
+    }
+    return true;
+}
+
+void WorkerIngestRequestFS::ingest() {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "ingest"
+         << "  files: " << files().size() << "  loads: " << numLoads());
+
+    // The tables are created after the 'overflow' chunk tables which every
+    // worker has
+
+    std::map<std::string, std::string> chunkTable2template;
+    std::map<std::string, IngestFileInfo> chunkTable2info;
+    for (auto&& info: files()) {
+        chunkTable2template[chunkTable(info)] =
+            info.table + (info.overlap ? "FullOverlap" : "") + "_" + std::to_string(overflowChunkNumber);
+        chunkTable2info[chunkTable(info)] = info;
+    }
+
+    database::mysql::Connection::Ptr conn;
+    try {
+        conn = database::mysql::Connection::open(_connectionParams);
+
+        // Non-unique indexes aren't updated while the files are loaded, they're
+        // built afterwards in one pass over each table.
+
+        for (auto&& entry: chunkTable2template) {
+            std::string const table = conn->sqlId(database()) + "." + conn->sqlId(entry.first);
+            conn->execute("CREATE TABLE IF NOT EXISTS " + table + " LIKE " +
+                          conn->sqlId(database()) + "." + conn->sqlId(entry.second));
+            conn->execute("ALTER TABLE " + table + " DISABLE KEYS");
+        }
+
+    } catch (database::mysql::Error const& ex) {
+        fail(reportErrorIf(
+                true,
+                ExtendedCompletionStatus::EXT_STATUS_MYSQL_ERROR,
+                "failed to prepare the tables of chunk: " + std::to_string(chunk()) +
+                ", database: " + database() + ", error: " + ex.what()));
+    }
+
+    if (not stopped()) {
+        std::vector<std::thread> loaders;
+        size_t const numLoaders = std::max<size_t>(1, std::min<size_t>(numLoads(), files().size()));
+        for (size_t i = 0; i < numLoaders; ++i) {
+            loaders.emplace_back(&WorkerIngestRequestFS::loadFiles, this);
+        }
+        for (auto&& loader: loaders) loader.join();
+    }
+
+    if (not stopped()) {
+        try {
+            for (auto&& entry: chunkTable2template) {
+                conn->execute("ALTER TABLE " + conn->sqlId(database()) + "." +
+                              conn->sqlId(entry.first) + " ENABLE KEYS");
+
+                std::lock_guard<std::mutex> progressLock(_progressMtx);
+                ++_progress.tablesIndexed;
+
+                if (stopped()) break;
+            }
+
+        } catch (database::mysql::Error const& ex) {
+            fail(reportErrorIf(
+                    true,
+                    ExtendedCompletionStatus::EXT_STATUS_MYSQL_ERROR,
+                    "failed to build the indexes of chunk: " + std::to_string(chunk()) +
+                    ", database: " + database() + ", error: " + ex.what()));
+        }
+    }
+    if (not stopped()) {
+        try {
+            for (auto&& entry: chunkTable2info) {
+                updateLayout(conn, entry.first, entry.second);
+                if (stopped()) break;
+            }
+
+        } catch (database::mysql::Error const& ex) {
+            fail(reportErrorIf(
+                    true,
+                    ExtendedCompletionStatus::EXT_STATUS_MYSQL_ERROR,
+                    "failed to cluster the tables of chunk: " + std::to_string(chunk()) +
+                    " by subchunk, database: " + database() + ", error: " + ex.what()));
+        }
+    }
+    {
+        std::lock_guard<std::mutex> ingestLock(_ingestMtx);
+        _finished = true;
+    }
+    _ingestCv.notify_all();
+}
+
+void WorkerIngestRequestFS::loadFiles() {
+
+    database::mysql::Connection::Ptr conn;
+    try {
+        conn = database::mysql::Connection::open(_connectionParams);
+    } catch (database::mysql::Error const& ex) {
+        fail(reportErrorIf(
+                true,
+                ExtendedCompletionStatus::EXT_STATUS_MYSQL_ERROR,
+                std::string("failed to connect to the database server, error: ") + ex.what()));
+        return;
+    }
+    std::vector<uint8_t> buf(_bufSize);
+    while (true) {
+        IngestFileInfo info;
+        {
+            std::lock_guard<std::mutex> ingestLock(_ingestMtx);
+            if (_stop or _queue.empty()) break;
+            info = _queue.front();
+            _queue.pop_front();
+        }
+        WorkerRequest::ErrorContext const errorContext = loadFile(conn, info, buf);
+        if (errorContext.failed) {
+            fail(errorContext);
+            break;
+        }
+    }
+}
+
+WorkerRequest::ErrorContext WorkerIngestRequestFS::loadFile(
+                                        database::mysql::Connection::Ptr const& conn,
+                                        IngestFileInfo const& info,
+                                        std::vector<uint8_t>& buf) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "loadFile"
+         << "  file: "    << info.file
+         << "  table: "   << info.table
+         << "  overlap: " << (info.overlap ? "1" : "0"));
+
+    WorkerRequest::ErrorContext errorContext;
+
+    fs::path const tmpFile = fs::path(_workerInfo.dataDir) / database() / (::tmpFilePrefix + info.file);
+    {
+        std::lock_guard<std::mutex> ingestLock(_ingestMtx);
+        _tmpFiles.insert(tmpFile.string());
+    }
+    auto const removeTmpFile = [&]() {
+        boost::system::error_code ec;
+        fs::remove(tmpFile, ec);
+        std::lock_guard<std::mutex> ingestLock(_ingestMtx);
+        _tmpFiles.erase(tmpFile.string());
+    };
+
+    // Copy the file from the source worker
+
+    FileClient::Ptr const inFilePtr = FileClient::open(_serviceProvider,
+                                                       sourceWorker(),
+                                                       database(),
+                                                       info.file);
+    errorContext = errorContext
+        or reportErrorIf(
+            not inFilePtr,
+            ExtendedCompletionStatus::EXT_STATUS_FILE_ROPEN,
+            "failed to open input file on remote worker: " + sourceWorker() +
+            ", database: " + database() +
+            ", file: " + info.file);
+    if (errorContext.failed) {
+        removeTmpFile();
+        return errorContext;
+    }
+
+    std::FILE* fp = std::fopen(tmpFile.string().c_str(), "wb");
+    errorContext = errorContext
+        or reportErrorIf(
+            fp == nullptr,
+            ExtendedCompletionStatus::EXT_STATUS_FILE_CREATE,
+            "failed to create temporary file: " + tmpFile.string() +
+            ", error: " + std::strerror(errno));
+    if (errorContext.failed) {
+        removeTmpFile();
+        return errorContext;
+    }
+    try {
+        while (size_t const num = inFilePtr->read(buf.data(), buf.size())) {
+            errorContext = errorContext
+                or reportErrorIf(
+                    std::fwrite(buf.data(), sizeof(uint8_t), num, fp) != num,
+                    ExtendedCompletionStatus::EXT_STATUS_FILE_WRITE,
+                    "failed to write into temporary file: " + tmpFile.string() +
+                    ", error: " + std::strerror(errno));
+            if (errorContext.failed) break;
+            {
+                std::lock_guard<std::mutex> progressLock(_progressMtx);
+                _progress.bytesRead += num;
+            }
+            if (stopped()) break;
+        }
+
+    } catch (FileClientError const& ex) {
+        errorContext = errorContext
+            or reportErrorIf(
+                true,
+                ExtendedCompletionStatus::EXT_STATUS_FILE_READ,
+                "failed to read input file from remote worker: " + sourceWorker() +
+                ", database: " + database() +
+                ", file: " + info.file);
+    }
+    std::fclose(fp);
+
+    if (errorContext.failed or stopped()) {
+        removeTmpFile();
+        return errorContext;
+    }
+    {
+        std::lock_guard<std::mutex> progressLock(_progressMtx);
+        ++_progress.filesRead;
+    }
+
+    // Load the file into its table
+
+    try {
+        conn->execute("LOAD DATA LOCAL INFILE " + conn->sqlValue(tmpFile.string()) +
+                      " INTO TABLE " + conn->sqlId(database()) + "." + conn->sqlId(chunkTable(info)));
+
+        int64_t numRows = 0;
+        conn->executeSingleValueSelect("SELECT ROW_COUNT() AS `num_rows`", "num_rows", numRows);
+
+        std::lock_guard<std::mutex> progressLock(_progressMtx);
+        ++_progress.filesLoaded;
+        _progress.rowsLoaded += std::max<int64_t>(0, numRows);
+
+    } catch (database::mysql::Error const& ex) {
+        errorContext = errorContext
+            or reportErrorIf(
+                true,
+                ExtendedCompletionStatus::EXT_STATUS_MYSQL_ERROR,
+                "failed to load file: " + info.file +
+                " into table: " + chunkTable(info) +
+                ", database: " + database() + ", error: " + ex.what());
+    }
+    removeTmpFile();
+    return errorContext;
+}
+
+void WorkerIngestRequestFS::updateLayout(database::mysql::Connection::Ptr const& conn,
+                                         std::string const& table,
+                                         IngestFileInfo const& info) {
+
+    std::string const qualifiedTable = conn->sqlId(database()) + "." + conn->sqlId(table);
+    std::string const layoutTable = conn->sqlId("qservw_worker") + "." + conn->sqlId("SubChunkLayout");
+    std::string const where =
+        conn->sqlEqual("db",      database()) + " AND " +
+        conn->sqlEqual("tbl",     info.table) + " AND " +
+        conn->sqlEqual("chunk",   chunk())    + " AND " +
+        conn->sqlEqual("overlap", info.overlap ? 1 : 0);
+
+    // Rows appended to a table break its order, the layout recorded before
+    // no longer holds.
+
+    bool hasColumn = false;
+    if (clusterSubChunks()) {
+        uint64_t numColumns = 0;
+        conn->executeSingleValueSelect(
+            "SELECT COUNT(*) AS `num` FROM `information_schema`.`COLUMNS` WHERE " +
+            conn->sqlEqual("TABLE_SCHEMA", database()) + " AND " +
+            conn->sqlEqual("TABLE_NAME",   table) + " AND " +
+            conn->sqlEqual("COLUMN_NAME",  std::string(SUB_CHUNK_COLUMN)),
+            "num", numColumns);
+        hasColumn = numColumns != 0;
+    }
+    if (not hasColumn) {
+        conn->execute("DELETE FROM " + layoutTable + " WHERE " + where);
+        return;
+    }
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "updateLayout  table: " << table);
+
+    // MyISAM keeps the rows in the order given by ALTER TABLE ... ORDER BY until
+    // more rows are added. The index lets the rows of a subchunk be read as one
+    // range of the table.
+
+    uint64_t numIndexes = 0;
+    conn->executeSingleValueSelect(
+        "SELECT COUNT(*) AS `num` FROM `information_schema`.`STATISTICS` WHERE " +
+        conn->sqlEqual("TABLE_SCHEMA", database()) + " AND " +
+        conn->sqlEqual("TABLE_NAME",   table) + " AND " +
+        conn->sqlEqual("COLUMN_NAME",  std::string(SUB_CHUNK_COLUMN)) + " AND " +
+        conn->sqlEqual("SEQ_IN_INDEX", 1),
+        "num", numIndexes);
+    conn->execute("ALTER TABLE " + qualifiedTable +
+                  (numIndexes == 0 ? " ADD INDEX (" + conn->sqlId(SUB_CHUNK_COLUMN) + ")," : "") +
+                  " ORDER BY " + conn->sqlId(SUB_CHUNK_COLUMN));
+
+    std::vector<std::pair<uint32_t, uint64_t>> subChunk2rows;
+    conn->execute("SELECT " + conn->sqlId(SUB_CHUNK_COLUMN) + ",COUNT(*) FROM " + qualifiedTable +
+                  " GROUP BY " + conn->sqlId(SUB_CHUNK_COLUMN) +
+                  " ORDER BY " + conn->sqlId(SUB_CHUNK_COLUMN));
+    database::mysql::Row row;
+    while (conn->next(row)) {
+        uint32_t subChunk;
+        uint64_t numRows;
+        row.get(0, subChunk);
+        row.get(1, numRows);
+        subChunk2rows.emplace_back(subChunk, numRows);
+    }
+    std::string values;
+    uint64_t firstRow = 0;
+    for (auto&& entry: subChunk2rows) {
+        values += (values.empty() ? "" : ",") + conn->sqlPackValues(
+            database(),
+            info.table,
+            chunk(),
+            info.overlap ? 1 : 0,
+            entry.first,
+            firstRow,
+            entry.second);
+        firstRow += entry.second;
+    }
+    conn->begin();
+    conn->execute("DELETE FROM " + layoutTable + " WHERE " + where);
+    if (not values.empty()) {
+        conn->execute("INSERT INTO " + layoutTable + " VALUES " + values);
+    }
+    conn->commit();
+}
+
+void WorkerIngestRequestFS::fail(WorkerRequest::ErrorContext const& errorContext) {
+    std::lock_guard<std::mutex> ingestLock(_ingestMtx);
+    _ingestError = _ingestError or errorContext;
+    _stop = true;
+}
+
+bool WorkerIngestRequestFS::stopped() {
+    std::lock_guard<std::mutex> ingestLock(_ingestMtx);
+    return _stop;
+}
+
+void WorkerIngestRequestFS::stopIngest() {
+    {
+        std::lock_guard<std::mutex> ingestLock(_ingestMtx);
+        _stop = true;
+    }
+
+    // A file which is being loaded is loaded to the end before the threads
+    // notice the flag.
+
+    if (_driver.joinable()) _driver.join();
+
+    std::lock_guard<std::mutex> ingestLock(_ingestMtx);
+    for (auto&& file: _tmpFiles) {
+        boost::system::error_code ec;
+        fs::remove(fs::path(file), ec);
+    }
+    _tmpFiles.clear();
+}
+
+}}} // namespace lsst::qserv::replica
@@ -0,0 +1,373 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_REPLICA_WORKERINGESTREQUEST_H
+#define LSST_QSERV_REPLICA_WORKERINGESTREQUEST_H
+
+// System headers
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Qserv headers
+#include "proto/replication.pb.h"
+#include "replica/Common.h"
+#include "replica/Configuration.h"
+#include "replica/DatabaseMySQL.h"
+#include "replica/WorkerRequest.h"
+
+// This header declarations
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+/**
+  * Class WorkerIngestRequest represents a context and a state of the chunk
+  * ingest requests within the worker servers. It can also be used for testing
+  * the framework operation as its implementation won't make any changes to
+  * any files or databases.
+  *
+  * Real implementations of the request processing must derive from this class.
+  */
+class WorkerIngestRequest
+    :   public WorkerRequest {
+
+public:
+
+    /// Pointer to self
+    typedef std::shared_ptr<WorkerIngestRequest> Ptr;
+
+    /**
+     * Static factory method is needed to prevent issue with the lifespan
+     * and memory management of instances created otherwise (as values or via
+     * low-level pointers).
+     *
+     * @param serviceProvider  - a host of services for various communications
+     * @param worker           - the name of a worker
+     * @param id               - an identifier of a client request
+     * @param priority         - indicates the importance of the request
+     * @param database         - the name of a database
+     * @param chunk            - the chunk number
+     * @param sourceWorker     - the name of a worker whose file server has the files
+     * @param files            - the contributions to be loaded
+     * @param numLoads         - the number of files loaded at the same time
+     *                           (0 means the default of the Configuration)
+     * @param clusterSubChunks - store the rows of the tables ordered by subchunk,
+     *                           and record the row ranges of the subchunks
+     *
+     * @return pointer to the created object
+     */
+    static Ptr create(ServiceProvider::Ptr const& serviceProvider,
+                      std::string const& worker,
+                      std::string const& id,
+                      int priority,
+                      std::string const& database,
+                      unsigned int chunk,
+                      std::string const& sourceWorker,
+                      std::vector<IngestFileInfo> const& files,
+                      unsigned int numLoads,
+                      bool clusterSubChunks);
+
+    // Default construction and copy semantics are prohibited
+
+    WorkerIngestRequest() = delete;
+    WorkerIngestRequest(WorkerIngestRequest const&) = delete;
+    WorkerIngestRequest& operator=(WorkerIngestRequest const&) = delete;
+
+    /// Destructor
+    ~WorkerIngestRequest() override = default;
+
+    // Trivial get methods
+
+    std::string const& database() const { return _database; }
+
+    unsigned int chunk() const { return _chunk; }
+
+    std::string const& sourceWorker() const { return _sourceWorker; }
+
+    std::vector<IngestFileInfo> const& files() const { return _files; }
+
+    unsigned int numLoads() const { return _numLoads; }
+
+    bool clusterSubChunks() const { return _clusterSubChunks; }
+
+    /**
+     * Extract request status into the Protobuf response object.
+     *
+     * @param response
+     *   Protobuf response to be initialized
+     */
+    void setInfo(proto::ReplicationResponseIngest& response) const;
+
+    /**
+     * @see WorkerRequest::execute
+     */
+    bool execute() override;
+
+protected:
+
+    /**
+     * The normal constructor of the class
+     *
+     * @see WorkerIngestRequest::create()
+     */
+    WorkerIngestRequest(ServiceProvider::Ptr const& serviceProvider,
+                        std::string const& worker,
+                        std::string const& id,
+                        int priority,
+                        std::string const& database,
+                        unsigned int chunk,
+                        std::string const& sourceWorker,
+                        std::vector<IngestFileInfo> const& files,
+                        unsigned int numLoads,
+                        bool clusterSubChunks);
+
+    /**
+     * @param info - a contribution to be loaded
+     *
+     * @return the name of the table of the chunk into which the file is loaded
+     */
+    std::string chunkTable(IngestFileInfo const& info) const;
+
+protected:
+
+    /// The name of a database
+    std::string const _database;
+
+    /// The number of a chunk
+    unsigned int const _chunk;
+
+    /// The name of a worker whose file server has the files
+    std::string const _sourceWorker;
+
+    /// The contributions to be loaded
+    std::vector<IngestFileInfo> const _files;
+
+    /// The number of files loaded at the same time
+    unsigned int const _numLoads;
+
+    /// Cluster the rows of the tables by subchunk after loading
+    bool const _clusterSubChunks;
+
+    /// The progress of the request, updated while the files are being loaded
+    struct Progress {
+        uint32_t numFiles      = 0;
+        uint32_t filesRead     = 0;
+        uint32_t filesLoaded   = 0;
+        uint64_t bytesRead     = 0;
+        uint64_t rowsLoaded    = 0;
+        uint32_t numTables     = 0;
+        uint32_t tablesIndexed = 0;
+    } _progress;
+
+    /// Protects _progress
+    mutable std::mutex _progressMtx;
+};
+
+/**
+  * Class WorkerIngestRequestFS provides an actual implementation for the chunk
+  * ingest requests. The files are read from the file server of the source worker
+  * into temporary files in the database folder of the worker, and they're loaded
+  * into the chunk and overlap tables with 'LOAD DATA LOCAL INFILE' over as many
+  * connections to the MySQL server of the worker as the number of loads of
+  * the request. The tables are created (if needed) with their indexes disabled,
+  * and the indexes are built after all files have been loaded.
+  *
+  * The files are expected in the default format of 'LOAD DATA INFILE'.
+  *
+  * If the request clusters the subchunks, the rows of each table which has
+  * a subchunk column are then stored ordered by subchunk, with an index on the
+  * column, and the range of rows of every subchunk is recorded in table
+  * 'SubChunkLayout' of the worker's database 'qservw_worker'. Queries on
+  * subchunks then read each subchunk as one range of the chunk table instead
+  * of copying it into an in-memory table. The layout of a table loaded without
+  * the option is forgotten, as the new rows aren't in order.
+  */
+class WorkerIngestRequestFS
+    :   public WorkerIngestRequest {
+
+public:
+
+    /// Pointer to self
+    typedef std::shared_ptr<WorkerIngestRequestFS> Ptr;
+
+    /**
+     * Static factory method is needed to prevent issue with the lifespan
+     * and memory management of instances created otherwise (as values or via
+     * low-level pointers).
+     *
+     * @see WorkerIngestRequest::create()
+     *
+     * @throws std::invalid_argument - if a file refers to a table which is not
+     *                                 a partitioned table of the database, or
+     *                                 if a file name has a path
+     */
+    static Ptr create(ServiceProvider::Ptr const& serviceProvider,
+                      std::string const& worker,
+                      std::string const& id,
+                      int priority,
+                      std::string const& database,
+                      unsigned int chunk,
+                      std::string const& sourceWorker,
+                      std::vector<IngestFileInfo> const& files,
+                      unsigned int numLoads,
+                      bool clusterSubChunks);
+
+    // Default construction and copy semantics are prohibited
+
+    WorkerIngestRequestFS() = delete;
+    WorkerIngestRequestFS(WorkerIngestRequestFS const&) = delete;
+    WorkerIngestRequestFS& operator=(WorkerIngestRequestFS const&) = delete;
+
+    /// Destructor (non trivial one is needed to release resources)
+    ~WorkerIngestRequestFS() override;
+
+    /**
+     * @see WorkerIngestRequest::execute
+     */
+    bool execute() override;
+
+protected:
+
+    /**
+     * The normal constructor of the class
+     *
+     * @see WorkerIngestRequestFS::create()
+     */
+    WorkerIngestRequestFS(ServiceProvider::Ptr const& serviceProvider,
+                          std::string const& worker,
+                          std::string const& id,
+                          int priority,
+                          std::string const& database,
+                          unsigned int chunk,
+                          std::string const& sourceWorker,
+                          std::vector<IngestFileInfo> const& files,
+                          unsigned int numLoads,
+                          bool clusterSubChunks);
+
+private:
+
+    /**
+     * Create the tables, load the files over the connections of as many
+     * threads as the number of loads, and build the indexes. This runs in
+     * the thread started by the first call to execute().
+     */
+    void ingest();
+
+    /**
+     * Load files until none are left, the request is stopped or a file
+     * fails. This runs in the threads started by ingest().
+     */
+    void loadFiles();
+
+    /**
+     * Copy a file from the source worker into a temporary file, load it
+     * into its table and remove the temporary file.
+     *
+     * @param conn - the connection of the thread to the MySQL server
+     * @param info - the contribution to be loaded
+     * @param buf  - the record buffer of the thread
+     *
+     * @return the error context of the operation
+     */
+    WorkerRequest::ErrorContext loadFile(std::shared_ptr<database::mysql::Connection> const& conn,
+                                         IngestFileInfo const& info,
+                                         std::vector<uint8_t>& buf);
+
+    /**
+     * Cluster a loaded table by subchunk and record the row ranges of its
+     * subchunks, or forget the layout recorded before if the request doesn't
+     * cluster the subchunks or the table has no subchunk column.
+     *
+     * @param conn  - the connection to the MySQL server
+     * @param table - the name of the table of the chunk
+     * @param info  - a contribution loaded into the table
+     *
+     * @throws database::mysql::Error - if a query failed
+     */
+    void updateLayout(std::shared_ptr<database::mysql::Connection> const& conn,
+                      std::string const& table,
+                      IngestFileInfo const& info);
+
+    /**
+     * Record the first error of the threads and tell them to stop.
+     *
+     * @param errorContext - the error to be recorded
+     */
+    void fail(WorkerRequest::ErrorContext const& errorContext);
+
+    /// @return 'true' if the threads were told to stop
+    bool stopped();
+
+    /**
+     * Stop and join the threads, and remove the temporary files left
+     * by them.
+     */
+    void stopIngest();
+
+private:
+
+    /// Cached descriptor of the worker obtained from the Configuration
+    WorkerInfo const _workerInfo;
+
+    /// The connection parameters of the MySQL server of the worker
+    database::mysql::ConnectionParams const _connectionParams;
+
+    /// The size of the record buffer of each thread
+    size_t const _bufSize;
+
+    /// The thread running ingest()
+    std::thread _driver;
+
+    /// Protects the members below
+    std::mutex _ingestMtx;
+
+    /// Notified when the driver finishes
+    std::condition_variable _ingestCv;
+
+    /// Files not taken by a loader yet
+    std::deque<IngestFileInfo> _queue;
+
+    /// Temporary files being written or loaded by the loaders
+    std::set<std::string> _tmpFiles;
+
+    /// True once the driver has finished
+    bool _finished;
+
+    /// Tells the threads to stop after their current file
+    bool _stop;
+
+    /// The first error reported by the threads
+    WorkerRequest::ErrorContext _ingestError;
+};
+
+/// Class WorkerIngestRequestFS provides the actual implementation
+typedef WorkerIngestRequestFS WorkerIngestRequestPOSIX;
+
+}}} // namespace lsst::qserv::replica
+
+#endif // LSST_QSERV_REPLICA_WORKERINGESTREQUEST_H
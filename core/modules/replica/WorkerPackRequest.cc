@@ -0,0 +1,463 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "replica/WorkerPackRequest.h"
+
+// System headers
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <spawn.h>
+#include <stdexcept>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Third party headers
+#include <boost/filesystem.hpp>
+
+// Qserv headers
+#include "lsst/log/Log.h"
+#include "replica/Configuration.h"
+#include "replica/DatabaseMySQL.h"
+#include "replica/FileCsCache.h"
+#include "replica/FileUtils.h"
+#include "replica/Performance.h"
+#include "replica/ServiceProvider.h"
+
+extern char** environ;
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.replica.WorkerPackRequest");
+
+/// The tools of MySQL (found in the PATH of the worker) which pack
+/// the tables and rebuild their indexes
+char const* const packTool  = "myisampack";
+char const* const checkTool = "myisamchk";
+
+/// The maximum number of bytes of the output of a failed tool to be logged
+size_t const maxToolOutputBytes = 4096;
+
+/**
+ * Run an external tool and wait before it finishes. Its standard output
+ * and error streams are collected into a string.
+ *
+ * @param args   - the name of the tool followed by its arguments
+ * @param output - the output of the tool
+ *
+ * @return an empty string on success, or the reason of the failure
+ */
+std::string runTool(std::vector<std::string> const& args,
+                    std::string& output) {
+
+    int fd[2];
+    if (::pipe(fd) != 0) {
+        return std::string("failed to create a pipe, error: ") + std::strerror(errno);
+    }
+    posix_spawn_file_actions_t actions;
+    ::posix_spawn_file_actions_init(&actions);
+    ::posix_spawn_file_actions_addclose(&actions, fd[0]);
+    ::posix_spawn_file_actions_adddup2(&actions, fd[1], STDOUT_FILENO);
+    ::posix_spawn_file_actions_adddup2(&actions, fd[1], STDERR_FILENO);
+    ::posix_spawn_file_actions_addclose(&actions, fd[1]);
+
+    std::vector<char*> argv;
+    for (auto&& arg: args) argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    pid_t pid;
+    int const err = ::posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+    ::posix_spawn_file_actions_destroy(&actions);
+    ::close(fd[1]);
+    if (err != 0) {
+        ::close(fd[0]);
+        return "failed to start " + args[0] + ", error: " + std::strerror(err);
+    }
+    char buf[1024];
+    ssize_t num;
+    while ((num = ::read(fd[0], buf, sizeof(buf))) != 0) {
+        if (num < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (output.size() < maxToolOutputBytes) output.append(buf, num);
+    }
+    ::close(fd[0]);
+
+    int status;
+    while (::waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            return "failed to wait for " + args[0] + ", error: " + std::strerror(errno);
+        }
+    }
+    if (not WIFEXITED(status)) return args[0] + " was terminated";
+    if (WEXITSTATUS(status) != 0) {
+        return args[0] + " failed with exit code " + std::to_string(WEXITSTATUS(status));
+    }
+    return std::string();
+}
+
+/**
+ * Compute the control sums of files on the threads shared by all requests
+ *
+ * @param files      - the path names of the files
+ * @param numThreads - the number of threads of the pool
+ * @param ioDepth    - the number of records of a file read at once
+ * @param csCache    - the cache to be updated with the control sums
+ *
+ * @return the files by their path names (the names of the files are set, but
+ * not their mtime which is to be read separately)
+ *
+ * @throws std::runtime_error if a file couldn't be read
+ */
+std::map<std::string, lsst::qserv::replica::ReplicaInfo::FileInfo> checksum(
+                                std::vector<std::string> const& files,
+                                size_t numThreads,
+                                size_t ioDepth,
+                                lsst::qserv::replica::FileCsCache::Ptr const& csCache) {
+
+    using namespace lsst::qserv::replica;
+
+    std::map<std::string, ReplicaInfo::FileInfo> result;
+    if (files.empty()) return result;
+
+    std::map<std::string, FileCsCache::Stat> file2stat;
+    for (auto&& file: files) {
+        FileCsCache::Stat fileStat{0, 0, 0};
+        int const err = FileCsCache::stat(file, fileStat);
+        if (err != 0) {
+            throw std::runtime_error(
+                    "failed to check the status of file: " + file + ", error: " + std::strerror(err));
+        }
+        file2stat[file] = fileStat;
+    }
+    ParallelCsComputeEngine engine(files, numThreads, ParallelCsComputeEngine::DEFAULT_RECORD_SIZE_BYTES,
+                                   ioDepth);
+    while (not engine.execute()) {}
+
+    for (auto&& file: files) {
+        std::string const cs = std::to_string(engine.cs(file));
+        uint64_t const size = engine.bytes(file);
+        result[file] = ReplicaInfo::FileInfo({
+            fs::path(file).filename().string(),
+            size,
+            file2stat[file].mtime,
+            cs,
+            0,      /* beginTransferTime */
+            0,      /* endTransferTime */
+            size,   /* inSize */
+            ParallelCsComputeEngine::ALGORITHM,
+            false,  /* packed */
+            0,      /* unpackedSize */
+            ""      /* unpackedCs */
+        });
+        csCache->update(file, file2stat[file], cs, ParallelCsComputeEngine::ALGORITHM);
+    }
+    return result;
+}
+
+} /// namespace
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+////////////////////////////////////////////////////////////
+///////////////////// WorkerPackRequest ////////////////////
+////////////////////////////////////////////////////////////
+
+WorkerPackRequest::Ptr WorkerPackRequest::create(ServiceProvider::Ptr const& serviceProvider,
+                                                 std::string const& worker,
+                                                 std::string const& id,
+                                                 int priority,
+                                                 std::string const& database,
+                                                 unsigned int chunk) {
+    return WorkerPackRequest::Ptr(
+        new WorkerPackRequest(serviceProvider,
+                              worker,
+                              id,
+                              priority,
+                              database,
+                              chunk));
+}
+
+WorkerPackRequest::WorkerPackRequest(ServiceProvider::Ptr const& serviceProvider,
+                                     std::string const& worker,
+                                     std::string const& id,
+                                     int priority,
+                                     std::string const& database,
+                                     unsigned int chunk)
+    :   WorkerRequest (serviceProvider,
+                       worker,
+                       "PACK",
+                       id,
+                       priority),
+        _database(database),
+        _chunk(chunk),
+        // This status will be returned in all contexts
+        _replicaInfo(ReplicaInfo::Status::NOT_FOUND,
+                     worker,
+                     database,
+                     chunk,
+                     PerformanceUtils::now(),
+                     ReplicaInfo::FileInfoCollection{}) {
+
+    serviceProvider->assertDatabaseIsValid(database);
+}
+
+void WorkerPackRequest::setInfo(proto::ReplicationResponsePack& response) const {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "setInfo");
+
+    util::Lock lock(_mtx, context() + "setInfo");
+
+    // Return the performance of the target request
+
+    response.set_allocated_target_performance(performance().info());
+
+    // Note the ownership transfer of an intermediate Protobuf object obtained
+    // from ReplicaInfo object in the call below. The Protobuf run-time will take
+    // care of deleting the intermediate object.
+
+    response.set_allocated_replica_info(_replicaInfo.info());
+
+    // Same comment on the ownership transfer applies here
+
+    auto protoRequestPtr = new proto::ReplicationRequestPack();
+
+    protoRequestPtr->set_priority(priority());
+    protoRequestPtr->set_database(database());
+    protoRequestPtr->set_chunk(   chunk());
+
+    response.set_allocated_request(protoRequestPtr);
+}
+
+bool WorkerPackRequest::execute() {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "execute"
+        << "  db: "    << database()
+        << "  chunk: " << chunk());
+
+    return WorkerRequest::execute();
+}
+
+/////////////////////////////////////////////////////////////////
+///////////////////// WorkerPackRequestPOSIX ////////////////////
+/////////////////////////////////////////////////////////////////
+
+WorkerPackRequestPOSIX::Ptr WorkerPackRequestPOSIX::create(
+                                    ServiceProvider::Ptr const& serviceProvider,
+                                    std::string const& worker,
+                                    std::string const& id,
+                                    int priority,
+                                    std::string const& database,
+                                    unsigned int chunk) {
+    return WorkerPackRequestPOSIX::Ptr(
+        new WorkerPackRequestPOSIX(serviceProvider,
+                                   worker,
+                                   id,
+                                   priority,
+                                   database,
+                                   chunk));
+}
+
+WorkerPackRequestPOSIX::WorkerPackRequestPOSIX(ServiceProvider::Ptr const& serviceProvider,
+                                               std::string const& worker,
+                                               std::string const& id,
+                                               int priority,
+                                               std::string const& database,
+                                               unsigned int chunk)
+    :   WorkerPackRequest(serviceProvider,
+                          worker,
+                          id,
+                          priority,
+                          database,
+                          chunk) {
+}
+
+bool WorkerPackRequestPOSIX::execute() {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "execute"
+         << "  db: "    << database()
+         << "  chunk: " << chunk());
+
+    util::Lock lock(_mtx, context() + "execute");
+
+    WorkerInfo   const workerInfo   = _serviceProvider->config()->workerInfo(worker());
+    DatabaseInfo const databaseInfo = _serviceProvider->config()->databaseInfo(database());
+    size_t       const numThreads   = _serviceProvider->config()->workerNumProcessingThreads();
+    size_t       const ioDepth      = std::max<size_t>(1, _serviceProvider->config()->workerFsIoDepth());
+
+    std::vector<std::string> const files = FileUtils::partitionedFiles(databaseInfo, chunk());
+
+    WorkerRequest::ErrorContext errorContext;
+    boost::system::error_code   ec;
+
+    ReplicaInfo::FileInfoCollection fileInfoCollection;
+    {
+        util::Lock dataFolderLock(_mtxDataFolderOperations, context() + "execute");
+
+        fs::path        const dataDir = fs::path(workerInfo.dataDir) / database();
+        fs::file_status const stat    = fs::status(dataDir, ec);
+        errorContext = errorContext
+            or reportErrorIf(
+                    stat.type() == fs::status_error,
+                    ExtendedCompletionStatus::EXT_STATUS_FOLDER_STAT,
+                    "failed to check the status of directory: " + dataDir.string())
+            or reportErrorIf(
+                    not fs::exists(stat),
+                    ExtendedCompletionStatus::EXT_STATUS_NO_FOLDER,
+                    "the directory does not exists: " + dataDir.string());
+
+        if (errorContext.failed) {
+            setStatus(lock, STATUS_FAILED, errorContext.extendedStatus);
+            return true;
+        }
+
+        // Group the files which are present by their tables, and find
+        // the tables which still need to be packed.
+
+        std::map<std::string, std::vector<std::string>> table2files;
+        for (auto&& file: files) {
+            fs::path const path = dataDir / file;
+            if (fs::exists(path, ec)) {
+                table2files[path.stem().string()].push_back(path.string());
+            }
+        }
+        std::vector<std::string> tablesToPack;
+        std::vector<std::string> filesToPack;
+        for (auto&& entry: table2files) {
+            if (not FileUtils::isPackedMyISAM(entry.second.front())) {
+                tablesToPack.push_back(entry.first);
+                filesToPack.insert(filesToPack.end(), entry.second.begin(), entry.second.end());
+            }
+        }
+        FileCsCache::Ptr const csCache = FileCsCache::instance(worker(), workerInfo.dataDir);
+        try {
+
+            // The control sums of the tables before they're packed
+
+            auto const unpacked = ::checksum(filesToPack, numThreads, ioDepth, csCache);
+
+            if (not tablesToPack.empty()) {
+
+                auto const conn = database::mysql::Connection::open(
+                    database::mysql::ConnectionParams::parse(
+                        _serviceProvider->config()->workerIngestDatabase(),
+                        "localhost",
+                        3306,
+                        "qsmaster",
+                        ""));
+
+                for (auto&& table: tablesToPack) {
+
+                    std::string const tablePath = (dataDir / table).string();
+                    std::string const flush =
+                        "FLUSH TABLES " + conn->sqlId(database()) + "." + conn->sqlId(table);
+
+                    conn->execute(flush);
+
+                    std::string output;
+                    std::string err = ::runTool({::packTool, "--silent", tablePath}, output);
+                    if (err.empty()) {
+                        err = ::runTool({::checkTool, "--silent", "--recover", "--quick", tablePath}, output);
+                    }
+                    conn->execute(flush);
+
+                    if (not err.empty()) {
+                        LOGS(_log, LOG_LVL_ERROR, context() << "execute"
+                             << "  table: " << table << "  " << err
+                             << "  output: " << output.substr(0, ::maxToolOutputBytes));
+                    }
+                    errorContext = errorContext
+                        or reportErrorIf(
+                                not err.empty(),
+                                ExtendedCompletionStatus::EXT_STATUS_TOOL_ERROR,
+                                "failed to pack table: " + tablePath + ", " + err);
+                    if (errorContext.failed) break;
+                }
+            }
+
+            // The control sums of all files after packing. The unpacked ones
+            // are known for the tables packed by this request only.
+
+            if (not errorContext.failed) {
+                std::vector<std::string> presentFiles;
+                for (auto&& entry: table2files) {
+                    presentFiles.insert(presentFiles.end(), entry.second.begin(), entry.second.end());
+                }
+                for (auto&& entry: ::checksum(presentFiles, numThreads, ioDepth, csCache)) {
+                    ReplicaInfo::FileInfo file = entry.second;
+                    file.packed = FileUtils::isPackedMyISAM(entry.first);
+                    auto const itr = unpacked.find(entry.first);
+                    if (itr != unpacked.end()) {
+                        file.unpackedSize = itr->second.size;
+                        file.unpackedCs   = itr->second.cs;
+                    }
+                    fileInfoCollection.push_back(file);
+                }
+            }
+
+        } catch (database::mysql::Error const& ex) {
+            errorContext = errorContext
+                or reportErrorIf(
+                        true,
+                        ExtendedCompletionStatus::EXT_STATUS_MYSQL_ERROR,
+                        std::string("failed to close the tables by the database server, error: ") + ex.what());
+
+        } catch (std::exception const& ex) {
+            errorContext = errorContext
+                or reportErrorIf(
+                        true,
+                        ExtendedCompletionStatus::EXT_STATUS_FILE_READ,
+                        ex.what());
+        }
+        csCache->save();
+    }
+    if (errorContext.failed) {
+        setStatus(lock, STATUS_FAILED, errorContext.extendedStatus);
+        return true;
+    }
+
+    ReplicaInfo::Status status = ReplicaInfo::Status::NOT_FOUND;
+    if (fileInfoCollection.size())
+        status = files.size() == fileInfoCollection.size() ?
+                    ReplicaInfo::Status::COMPLETE :
+                    ReplicaInfo::Status::INCOMPLETE;
+
+    _replicaInfo = ReplicaInfo(
+        status,
+        worker(),
+        database(),
+        chunk(),
+        PerformanceUtils::now(),
+        fileInfoCollection);
+
+    setStatus(lock, STATUS_SUCCEEDED);
+    return true;
+}
+
+}}} // namespace lsst::qserv::replica
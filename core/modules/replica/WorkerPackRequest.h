@@ -0,0 +1,199 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_REPLICA_WORKERPACKREQUEST_H
+#define LSST_QSERV_REPLICA_WORKERPACKREQUEST_H
+
+// System headers
+#include <string>
+
+// Qserv headers
+#include "proto/replication.pb.h"
+#include "replica/ReplicaInfo.h"
+#include "replica/WorkerRequest.h"
+
+// This header declarations
+
+namespace lsst {
+namespace qserv {
+namespace replica {
+
+/**
+  * Class WorkerPackRequest represents a context and a state of requests converting
+  * the tables of a chunk into the packed (compressed) read-only format of MyISAM
+  * within the worker servers. It can also be used for testing the framework
+  * operation as its implementation won't make any changes to any files or databases.
+  *
+  * Real implementations of the request processing must derive from this class.
+  */
+class WorkerPackRequest
+    :   public WorkerRequest {
+
+public:
+
+    /// Pointer to self
+    typedef std::shared_ptr<WorkerPackRequest> Ptr;
+
+    /**
+     * Static factory method is needed to prevent issue with the lifespan
+     * and memory management of instances created otherwise (as values or via
+     * low-level pointers).
+     *
+     * @param serviceProvider  - a host of services for various communications
+     * @param worker           - the name of a worker
+     * @param id               - an identifier of a client request
+     * @param priority         - indicates the importance of the request
+     * @param database         - the name of a database
+     * @param chunk            - the chunk number
+     *
+     * @return pointer to the created object
+     */
+    static Ptr create(ServiceProvider::Ptr const& serviceProvider,
+                      std::string const& worker,
+                      std::string const& id,
+                      int priority,
+                      std::string const& database,
+                      unsigned int chunk);
+
+    // Default construction and copy semantics are prohibited
+
+    WorkerPackRequest() = delete;
+    WorkerPackRequest(WorkerPackRequest const&) = delete;
+    WorkerPackRequest& operator=(WorkerPackRequest const&) = delete;
+
+    ~WorkerPackRequest() override = default;
+
+    // Trivial get methods
+
+    std::string const& database() const { return _database; }
+
+    unsigned int chunk() const { return _chunk; }
+
+    /**
+     * Extract request status into the Protobuf response object.
+     *
+     * @param response - Protobuf response to be initialized
+     */
+    void setInfo(proto::ReplicationResponsePack& response) const;
+
+    /**
+     * @see WorkerRequest::execute
+     */
+    bool execute() override;
+
+protected:
+
+    /**
+     * The normal constructor of the class
+     *
+     * @see WorkerPackRequest::create()
+     */
+    WorkerPackRequest(ServiceProvider::Ptr const& serviceProvider,
+                      std::string const& worker,
+                      std::string const& id,
+                      int priority,
+                      std::string const& database,
+                      unsigned int chunk);
+protected:
+
+    /// The name of a database
+    std::string const _database;
+
+    /// The number of a chunk
+    unsigned int const _chunk;
+
+    /// The replica after packing
+    ReplicaInfo _replicaInfo;
+};
+
+/**
+  * Class WorkerPackRequestPOSIX provides an actual implementation for
+  * packing the tables of a chunk with the MyISAM tools of MySQL.
+  *
+  * The files of each table (and of its overlap table) which isn't packed yet
+  * are checksummed, the table is compressed by 'myisampack', and its indexes
+  * are rebuilt by 'myisamchk'. The MySQL server of the worker (as configured
+  * by the ingest database of the workers) is told to close the table before
+  * and after that. The files are checksummed again and both control sums of
+  * each file are reported. The tables are meant to be packed while they're
+  * not used by queries.
+  */
+class WorkerPackRequestPOSIX
+    :   public WorkerPackRequest {
+
+public:
+
+    /// Pointer to self
+    typedef std::shared_ptr<WorkerPackRequestPOSIX> Ptr;
+
+    /**
+     * Static factory method is needed to prevent issue with the lifespan
+     * and memory management of instances created otherwise (as values or via
+     * low-level pointers).
+     *
+     * @see WorkerPackRequest::create()
+     */
+    static Ptr create(ServiceProvider::Ptr const& serviceProvider,
+                      std::string const& worker,
+                      std::string const& id,
+                      int priority,
+                      std::string const& database,
+                      unsigned int chunk);
+
+    // Default construction and copy semantics are prohibited
+
+    WorkerPackRequestPOSIX() = delete;
+    WorkerPackRequestPOSIX(WorkerPackRequestPOSIX const&) = delete;
+    WorkerPackRequestPOSIX& operator=(WorkerPackRequestPOSIX const&) = delete;
+
+    ~WorkerPackRequestPOSIX() override = default;
+
+    /**
+     * @see WorkerPackRequest::execute()
+     */
+    bool execute() override;
+
+private:
+
+    /**
+     * The normal constructor of the class
+     *
+     * @see WorkerPackRequestPOSIX::create()
+     */
+    WorkerPackRequestPOSIX(ServiceProvider::Ptr const& serviceProvider,
+                           std::string const& worker,
+                           std::string const& id,
+                           int priority,
+                           std::string const& database,
+                           unsigned int chunk);
+};
+
+/**
+  * Class WorkerPackRequestFS provides an actual implementation for
+  * packing the tables of a chunk.
+  *
+  * Note, this is just a typedef to class WorkerPackRequestPOSIX.
+  */
+typedef WorkerPackRequestPOSIX WorkerPackRequestFS;
+
+}}} // namespace lsst::qserv::replica
+
+#endif // LSST_QSERV_REPLICA_WORKERPACKREQUEST_H
@@ -25,11 +25,13 @@
 
 // System headers
 #include <algorithm>
+#include <chrono>
 #include <iterator>
 #include <stdexcept>
 
 // Qserv headers
 #include "lsst/log/Log.h"
+#include "replica/BandwidthLimiter.h"
 #include "replica/Configuration.h"
 #include "replica/Performance.h"
 #include "replica/ServiceProvider.h"
@@ -37,9 +39,11 @@
 #include "replica/WorkerEchoRequest.h"
 #include "replica/WorkerFindRequest.h"
 #include "replica/WorkerFindAllRequest.h"
+#include "replica/WorkerIndexRequest.h"
+#include "replica/WorkerPackRequest.h"
+#include "replica/WorkerIngestRequest.h"
 #include "replica/WorkerReplicationRequest.h"
 #include "replica/WorkerRequestFactory.h"
-#include "util/BlockPost.h"
 
 namespace {
 
@@ -67,7 +71,45 @@ bool ifDuplicateRequest(PROTOCOL_RESPONSE_TYPE& response,
         isDuplicate =
             (ptr->database() == request.database()) and
             (ptr->chunk()    == request.chunk());
+
+    } else if (replica::WorkerIngestRequest::Ptr ptr =
+             std::dynamic_pointer_cast<replica::WorkerIngestRequest>(p)) {
+        isDuplicate =
+            (ptr->database() == request.database()) and
+            (ptr->chunk()    == request.chunk());
+
+    } else if (replica::WorkerPackRequest::Ptr ptr =
+             std::dynamic_pointer_cast<replica::WorkerPackRequest>(p)) {
+        isDuplicate =
+            (ptr->database() == request.database()) and
+            (ptr->chunk()    == request.chunk());
+    }
+    if (isDuplicate) {
+        replica::WorkerProcessor::setDefaultResponse(
+            response,
+            proto::ReplicationStatus::BAD,
+            proto::ReplicationStatusExt::DUPLICATE);
+        response.set_duplicate_request_id(p->id());
     }
+    return isDuplicate;
+}
+
+/**
+ * The run file of a table is written by one secondary index request
+ * at a time.
+ */
+bool ifDuplicateIndexRequest(proto::ReplicationResponseIndex& response,
+                             replica::WorkerRequest::Ptr const& p,
+                             proto::ReplicationRequestIndex const& request) {
+
+    replica::WorkerIndexRequest::Ptr ptr =
+        std::dynamic_pointer_cast<replica::WorkerIndexRequest>(p);
+
+    bool const isDuplicate =
+        ptr and
+        (ptr->database() == request.database()) and
+        (ptr->table()    == request.table());
+
     if (isDuplicate) {
         replica::WorkerProcessor::setDefaultResponse(
             response,
@@ -94,6 +136,29 @@ std::string WorkerProcessor::state2string(State state) {
                            " in WorkerProcessor::state2string()");
 }
 
+std::string WorkerProcessor::pool2string(Pool pool) {
+    switch (pool) {
+        case POOL_IO:    return "POOL_IO";
+        case POOL_CPU:   return "POOL_CPU";
+        case POOL_SHORT: return "POOL_SHORT";
+    }
+    throw std::logic_error("unhandled pool " + std::to_string(pool) +
+                           " in WorkerProcessor::pool2string()");
+}
+
+WorkerProcessor::Pool WorkerProcessor::poolOf(WorkerRequest::Ptr const& request) {
+
+    if (std::dynamic_pointer_cast<WorkerReplicationRequest>(request)) return POOL_IO;
+    if (std::dynamic_pointer_cast<WorkerIngestRequest>(request))      return POOL_IO;
+    if (std::dynamic_pointer_cast<WorkerIndexRequest>(request))       return POOL_IO;
+    if (std::dynamic_pointer_cast<WorkerPackRequest>(request))        return POOL_IO;
+
+    auto const ptr = std::dynamic_pointer_cast<WorkerFindRequest>(request);
+    if (ptr and ptr->computeCheckSum()) return POOL_CPU;
+
+    return POOL_SHORT;
+}
+
 proto::ReplicationStatus WorkerProcessor::translate(WorkerRequest::CompletionStatus status) {
     switch (status) {
         case WorkerRequest::STATUS_NONE:          return proto::ReplicationStatus::QUEUED;
@@ -142,11 +207,17 @@ void WorkerProcessor::run() {
                         "The value of the parameter must be greater than 0");
         }
 
-        // Create threads if needed
+        // Create threads if needed. The configured threads are split between
+        // the copying and checksumming requests, each pool taking the other's
+        // requests when it has none of its own. One more thread is reserved
+        // for the short requests, so that they never wait behind the long ones.
+
         if (_threads.empty()) {
             auto const self = shared_from_this();
-            for (size_t i=0; i < numThreads; ++i) {
-                _threads.push_back(WorkerProcessorThread::create(self));
+            for (size_t i=0; i <= numThreads; ++i) {
+                auto const t = WorkerProcessorThread::create(self);
+                _threadPool[t->id()] = i == numThreads ? POOL_SHORT : (i % 2 ? POOL_CPU : POOL_IO);
+                _threads.push_back(t);
             }
         }
 
@@ -172,6 +243,7 @@ void WorkerProcessor::stop() {
         for (auto&& t: _threads) {
             t->stop();
         }
+        _cv.notify_all();
 
         // Begin transitioning to the final state via this intermediate one.
         // The transition will finish asynchronous when all threads will report
@@ -190,7 +262,9 @@ void WorkerProcessor::drain() {
     // Collect identifiers of requests to be affected by the operation
     std::list<std::string> ids;
 
-    for (auto&& ptr: _newRequests)        ids.push_back(ptr->id());
+    for (auto&& queue: _newRequests) {
+        for (auto&& ptr: queue)           ids.push_back(ptr->id());
+    }
     for (auto&& ptr: _inProgressRequests) ids.push_back(ptr->id());
 
     for (auto&& id: ids) dequeueOrCancelImpl(lock, id);
@@ -213,8 +287,10 @@ void WorkerProcessor::enqueueForReplication(
     // existing requests in the active (non-completed) queues. A reason why we're ignoring
     // the completed is that this replica may have already been deleted from this worker.
 
-    for (auto&& ptr: _newRequests) {
-        if (::ifDuplicateRequest(response, ptr, request)) return;
+    for (auto&& queue: _newRequests) {
+        for (auto&& ptr: queue) {
+            if (::ifDuplicateRequest(response, ptr, request)) return;
+        }
     }
     for (auto&& ptr: _inProgressRequests) {
         if (::ifDuplicateRequest(response, ptr,request)) return;
@@ -232,7 +308,7 @@ void WorkerProcessor::enqueueForReplication(
             request.chunk(),
             request.worker()
         );
-        _newRequests.push(ptr);
+        enqueueImpl(lock, ptr);
 
         response.set_status(proto::ReplicationStatus::QUEUED);
         response.set_status_ext(proto::ReplicationStatusExt::NONE);
@@ -256,7 +332,8 @@ void WorkerProcessor::enqueueForDeletion(std::string const& id,
     LOGS(_log, LOG_LVL_DEBUG, context() << "enqueueForDeletion"
         << "  id: "    << id
         << "  db: "    << request.database()
-        << "  chunk: " << request.chunk());
+        << "  chunk: " << request.chunk()
+        << "  extra chunks: " << request.extra_chunks_size());
 
     util::Lock lock(_mtx, context() + "enqueueForDeletion");
 
@@ -264,8 +341,10 @@ void WorkerProcessor::enqueueForDeletion(std::string const& id,
     // existing requests in the active (non-completed) queues. A reason why we're ignoring
     // the completed is that this replica may have already been deleted from this worker.
 
-    for (auto&& ptr : _newRequests) {
-        if (::ifDuplicateRequest(response, ptr, request)) return;
+    for (auto&& queue: _newRequests) {
+        for (auto&& ptr: queue) {
+            if (::ifDuplicateRequest(response, ptr, request)) return;
+        }
     }
     for (auto&& ptr : _inProgressRequests) {
         if (::ifDuplicateRequest(response, ptr, request)) return;
@@ -280,9 +359,11 @@ void WorkerProcessor::enqueueForDeletion(std::string const& id,
             id,
             request.priority(),
             request.database(),
-            request.chunk()
+            request.chunk(),
+            std::vector<unsigned int>(request.extra_chunks().begin(),
+                                      request.extra_chunks().end())
         );
-        _newRequests.push(ptr);
+        enqueueImpl(lock, ptr);
 
         response.set_status(proto::ReplicationStatus::QUEUED);
         response.set_status_ext(proto::ReplicationStatusExt::NONE);
@@ -321,9 +402,10 @@ void WorkerProcessor::enqueueForFind(std::string const& id,
             request.priority(),
             request.database(),
             request.chunk(),
-            request.compute_cs()
+            request.compute_cs(),
+            request.sample_rate()
         );
-        _newRequests.push(ptr);
+        enqueueImpl(lock, ptr);
     
         response.set_status(proto::ReplicationStatus::QUEUED);
         response.set_status_ext(proto::ReplicationStatusExt::NONE);
@@ -360,7 +442,7 @@ void WorkerProcessor::enqueueForFindAll(std::string const& id,
             request.priority(),
             request.database()
         );
-        _newRequests.push(ptr);
+        enqueueImpl(lock, ptr);
     
         response.set_status(proto::ReplicationStatus::QUEUED);
         response.set_status_ext(proto::ReplicationStatusExt::NONE);
@@ -416,7 +498,7 @@ void WorkerProcessor::enqueueForEcho(std::string const& id,
             request.data(),
             request.delay()
         );
-        _newRequests.push(ptr);
+        enqueueImpl(lock, ptr);
     
         response.set_status(proto::ReplicationStatus::QUEUED);
         response.set_status_ext(proto::ReplicationStatusExt::NONE);
@@ -433,6 +515,174 @@ void WorkerProcessor::enqueueForEcho(std::string const& id,
     }
 }
 
+void WorkerProcessor::enqueueForIngest(std::string const& id,
+                                       proto::ReplicationRequestIngest const& request,
+                                       proto::ReplicationResponseIngest& response) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "enqueueForIngest"
+        << "  id: "     << id
+        << "  db: "     << request.database()
+        << "  chunk: "  << request.chunk()
+        << "  worker: " << request.worker()
+        << "  files: "  << request.files_size());
+
+    util::Lock lock(_mtx, context() + "enqueueForIngest");
+
+    // Verify a scope of the request to ensure it won't duplicate or interfere (with)
+    // existing requests in the active (non-completed) queues. The tables of a chunk
+    // are loaded by one request at a time.
+
+    for (auto&& queue: _newRequests) {
+        for (auto&& ptr: queue) {
+            if (::ifDuplicateRequest(response, ptr, request)) return;
+        }
+    }
+    for (auto&& ptr : _inProgressRequests) {
+        if (::ifDuplicateRequest(response, ptr, request)) return;
+    }
+
+    // The code below may catch exceptions if other parameters of the requites
+    // won't pass further validation against the present configuration of the request
+    // processing service.
+    try {
+        IngestRequestParams const params(request);
+        auto const ptr = _requestFactory.createIngestRequest(
+            _worker,
+            id,
+            params.priority,
+            params.database,
+            params.chunk,
+            params.sourceWorker,
+            params.files,
+            params.numLoads,
+            params.clusterSubChunks
+        );
+        enqueueImpl(lock, ptr);
+
+        response.set_status(proto::ReplicationStatus::QUEUED);
+        response.set_status_ext(proto::ReplicationStatusExt::NONE);
+        response.set_allocated_performance(ptr->performance().info());
+
+        setInfo(ptr, response);
+
+    } catch (std::invalid_argument const& ec) {
+        LOGS(_log, LOG_LVL_ERROR, context() << "enqueueForIngest  " << ec.what());
+
+        setDefaultResponse(response,
+                           proto::ReplicationStatus::BAD,
+                           proto::ReplicationStatusExt::INVALID_PARAM);
+    }
+}
+
+void WorkerProcessor::enqueueForIndex(std::string const& id,
+                                      proto::ReplicationRequestIndex const& request,
+                                      proto::ReplicationResponseIndex& response) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "enqueueForIndex"
+        << "  id: "     << id
+        << "  db: "     << request.database()
+        << "  table: "  << request.table()
+        << "  chunks: " << request.chunks_size());
+
+    util::Lock lock(_mtx, context() + "enqueueForIndex");
+
+    // Verify a scope of the request to ensure it won't duplicate or interfere (with)
+    // existing requests in the active (non-completed) queues. The run file of
+    // a table is written by one request at a time.
+
+    for (auto&& queue: _newRequests) {
+        for (auto&& ptr: queue) {
+            if (::ifDuplicateIndexRequest(response, ptr, request)) return;
+        }
+    }
+    for (auto&& ptr : _inProgressRequests) {
+        if (::ifDuplicateIndexRequest(response, ptr, request)) return;
+    }
+
+    // The code below may catch exceptions if other parameters of the requites
+    // won't pass further validation against the present configuration of the request
+    // processing service.
+    try {
+        IndexRequestParams const params(request);
+        auto const ptr = _requestFactory.createIndexRequest(
+            _worker,
+            id,
+            params.priority,
+            params.database,
+            params.table,
+            params.keyColumn,
+            params.chunks
+        );
+        enqueueImpl(lock, ptr);
+
+        response.set_status(proto::ReplicationStatus::QUEUED);
+        response.set_status_ext(proto::ReplicationStatusExt::NONE);
+        response.set_allocated_performance(ptr->performance().info());
+
+        setInfo(ptr, response);
+
+    } catch (std::invalid_argument const& ec) {
+        LOGS(_log, LOG_LVL_ERROR, context() << "enqueueForIndex  " << ec.what());
+
+        setDefaultResponse(response,
+                           proto::ReplicationStatus::BAD,
+                           proto::ReplicationStatusExt::INVALID_PARAM);
+    }
+}
+
+void WorkerProcessor::enqueueForPack(std::string const& id,
+                                     proto::ReplicationRequestPack const& request,
+                                     proto::ReplicationResponsePack& response) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "enqueueForPack"
+        << "  id: "    << id
+        << "  db: "    << request.database()
+        << "  chunk: " << request.chunk());
+
+    util::Lock lock(_mtx, context() + "enqueueForPack");
+
+    // Verify a scope of the request to ensure it won't duplicate or interfere (with)
+    // existing requests in the active (non-completed) queues. The files of a chunk
+    // can't be copied or removed while its tables are being packed.
+
+    for (auto&& queue: _newRequests) {
+        for (auto&& ptr: queue) {
+            if (::ifDuplicateRequest(response, ptr, request)) return;
+        }
+    }
+    for (auto&& ptr : _inProgressRequests) {
+        if (::ifDuplicateRequest(response, ptr, request)) return;
+    }
+
+    // The code below may catch exceptions if other parameters of the requites
+    // won't pass further validation against the present configuration of the request
+    // processing service.
+    try {
+        PackRequestParams const params(request);
+        auto const ptr = _requestFactory.createPackRequest(
+            _worker,
+            id,
+            params.priority,
+            params.database,
+            params.chunk
+        );
+        enqueueImpl(lock, ptr);
+
+        response.set_status(proto::ReplicationStatus::QUEUED);
+        response.set_status_ext(proto::ReplicationStatusExt::NONE);
+        response.set_allocated_performance(ptr->performance().info());
+
+        setInfo(ptr, response);
+
+    } catch (std::invalid_argument const& ec) {
+        LOGS(_log, LOG_LVL_ERROR, context() << "enqueueForPack  " << ec.what());
+
+        setDefaultResponse(response,
+                           proto::ReplicationStatus::BAD,
+                           proto::ReplicationStatusExt::INVALID_PARAM);
+    }
+}
+
 WorkerRequest::Ptr WorkerProcessor::dequeueOrCancelImpl(util::Lock const& lock,
                                                         std::string const& id) {
 
@@ -445,28 +695,30 @@ WorkerRequest::Ptr WorkerProcessor::dequeueOrCancelImpl(util::Lock const& lock,
     // input collection while retaining a valid copy of the pointer to be placed
     // into the next stage  collection.
 
-    for (auto ptr: _newRequests) {
-        if (ptr->id() == id) {
+    for (auto&& queue: _newRequests) {
+        for (auto ptr: queue) {
+            if (ptr->id() == id) {
 
-            // Cancel it and move it into the final queue in case if a client
-            // won't be able to receive the desired status of the request due to
-            // a protocol failure, etc.
+                // Cancel it and move it into the final queue in case if a client
+                // won't be able to receive the desired status of the request due to
+                // a protocol failure, etc.
 
-            ptr->cancel();
+                ptr->cancel();
 
-            switch (ptr->status()) {
+                switch (ptr->status()) {
 
-                case WorkerRequest::STATUS_CANCELLED: {
+                    case WorkerRequest::STATUS_CANCELLED: {
 
-                    _newRequests.remove(id);
-                    _finishedRequests.push_back(ptr);
+                        queue.remove(id);
+                        _finishedRequests.push_back(ptr);
 
-                    return ptr;
+                        return ptr;
+                    }
+                    default:
+                        throw std::logic_error(
+                            "unexpected request status " + WorkerRequest::status2string(ptr->status()) +
+                            " at WorkerProcessor::dequeueOrCancelImpl among new requests");
                 }
-                default:
-                    throw std::logic_error(
-                        "unexpected request status " + WorkerRequest::status2string(ptr->status()) +
-                        " at WorkerProcessor::dequeueOrCancelImpl among new requests");
             }
         }
     }
@@ -548,18 +800,20 @@ WorkerRequest::Ptr WorkerProcessor::checkStatusImpl(util::Lock const& lock,
 
     // Still waiting in the queue?
 
-    for (auto&& ptr: _newRequests) {
-        if (ptr->id() == id) {
-            switch (ptr->status()) {
+    for (auto&& queue: _newRequests) {
+        for (auto&& ptr: queue) {
+            if (ptr->id() == id) {
+                switch (ptr->status()) {
 
-                // This state requirement is strict for the non-active requests
-                case WorkerRequest::STATUS_NONE:
-                    return ptr;
+                    // This state requirement is strict for the non-active requests
+                    case WorkerRequest::STATUS_NONE:
+                        return ptr;
 
-                default:
-                    throw std::logic_error(
-                        "unexpected request status " + WorkerRequest::status2string(ptr->status()) +
-                        " at WorkerProcessor::checkStatusImpl among new requests");
+                    default:
+                        throw std::logic_error(
+                            "unexpected request status " + WorkerRequest::status2string(ptr->status()) +
+                            " at WorkerProcessor::checkStatusImpl among new requests");
+                }
             }
         }
     }
@@ -651,14 +905,20 @@ void WorkerProcessor::setServiceResponse(
             response.set_service_state(proto::ReplicationServiceResponse::SUSPENDED);
             break;
     }
-    response.set_num_new_requests(        _newRequests.size());
+    response.set_num_new_requests(        numNewRequestsImpl(lock));
     response.set_num_in_progress_requests(_inProgressRequests.size());
     response.set_num_finished_requests(   _finishedRequests.size());
 
+    auto const limiter = BandwidthLimiter::instance(_worker);
+    response.set_fs_max_rate_bytes_per_sec(      limiter->rate());
+    response.set_fs_effective_rate_bytes_per_sec(limiter->effectiveRate());
+
     if (extendedReport) {
-        for (auto&& request: _newRequests) {
-            setServiceResponseInfo(request,
-                                   response.add_new_requests());
+        for (auto&& queue: _newRequests) {
+            for (auto&& request: queue) {
+                setServiceResponseInfo(request,
+                                       response.add_new_requests());
+            }
         }
         for (auto&& request: _inProgressRequests) {
             setServiceResponseInfo(request,
@@ -711,6 +971,33 @@ void WorkerProcessor::setServiceResponseInfo(
         info->set_priority(    ptr->priority());
         info->set_database(    ptr->database());
 
+    } else if (
+        auto const ptr = std::dynamic_pointer_cast<WorkerIngestRequest>(request)) {
+
+        info->set_replica_type(proto::ReplicationReplicaRequestType::REPLICA_INGEST);
+        info->set_id(          ptr->id());
+        info->set_priority(    ptr->priority());
+        info->set_database(    ptr->database());
+        info->set_chunk(       ptr->chunk());
+        info->set_worker(      ptr->sourceWorker());
+
+    } else if (
+        auto const ptr = std::dynamic_pointer_cast<WorkerIndexRequest>(request)) {
+
+        info->set_replica_type(proto::ReplicationReplicaRequestType::REPLICA_INDEX);
+        info->set_id(          ptr->id());
+        info->set_priority(    ptr->priority());
+        info->set_database(    ptr->database());
+
+    } else if (
+        auto const ptr = std::dynamic_pointer_cast<WorkerPackRequest>(request)) {
+
+        info->set_replica_type(proto::ReplicationReplicaRequestType::REPLICA_PACK);
+        info->set_id(          ptr->id());
+        info->set_priority(    ptr->priority());
+        info->set_database(    ptr->database());
+        info->set_chunk(       ptr->chunk());
+
     } else {
         throw std::logic_error(
             "unsupported request type: " + request->type() + " id: " + request->id() +
@@ -720,7 +1007,13 @@ void WorkerProcessor::setServiceResponseInfo(
 
 size_t WorkerProcessor::numNewRequests() const {
     util::Lock lock(_mtx, context() + "numNewRequests");
-    return _newRequests.size();
+    return numNewRequestsImpl(lock);
+}
+
+size_t WorkerProcessor::numNewRequestsImpl(util::Lock const& lock) const {
+    size_t num = 0;
+    for (auto&& queue: _newRequests) num += queue.size();
+    return num;
 }
 
 size_t WorkerProcessor::numInProgressRequests() const {
@@ -741,40 +1034,63 @@ WorkerRequest::Ptr WorkerProcessor::fetchNextForProcessing(
         << "  thread: " << processorThread->id()
         << "  timeout: " << timeoutMilliseconds);
 
-    // For generating random intervals within the maximum range of seconds
-    // requested by a client.
+    // The lock is released while waiting. The threads are woken up when
+    // new requests are queued, or when the processor is being stopped.
 
-    util::BlockPost blockPost(0, timeoutMilliseconds);
+    std::unique_lock<util::Mutex> lock(_mtx);
 
-    unsigned int totalElapsedTime = 0;
-    while (totalElapsedTime < timeoutMilliseconds) {
+    Pool const pool = _threadPool.at(processorThread->id());
 
-        // IMPORTANT: make sure no wait is happening within the same
-        // scope where the thread safe block is defined. Otherwise
-        // the queue will be locked for all threads for the duration of
-        // the wait.
+    WorkerRequest::Ptr request;
+    auto const available = [&] () {
+        request = nextImpl(pool);
+        return request != nullptr;
+    };
+    if (timeoutMilliseconds == 0) {
+        _cv.wait(lock, available);
+    } else {
+        _cv.wait_for(lock, std::chrono::milliseconds(timeoutMilliseconds), available);
+    }
+    if (request) {
+        request->start();
+        _inProgressRequests.push_back(request);
+    }
+
+    // Return null pointer if noting has been found within the specified
+    // timeout.
 
-        {
-            util::Lock lock(_mtx, context() + "fetchNextForProcessing");
+    return request;
+}
 
-            if (not _newRequests.empty()) {
+WorkerRequest::Ptr WorkerProcessor::nextImpl(Pool pool) {
 
-                WorkerRequest::Ptr request = _newRequests.top();
-                _newRequests.pop();
+    // The short requests are only served by their own pool. The other pools
+    // begin with their own queue and then take the request of the highest
+    // priority among the remaining ones.
 
-                request->start();
-                _inProgressRequests.push_back(request);
+    auto& home = _newRequests[pool];
+    PriorityQueueType* queue = home.empty() ? nullptr : &home;
 
-                return request;
+    if ((queue == nullptr) and (pool != POOL_SHORT)) {
+        for (auto&& other: _newRequests) {
+            if (other.empty()) continue;
+            if ((queue == nullptr) or WorkerRequestCompare()(queue->top(), other.top())) {
+                queue = &other;
             }
         }
-        totalElapsedTime += blockPost.wait();
     }
+    if (queue == nullptr) return WorkerRequest::Ptr();
 
-    // Return null pointer since noting has been found within the specified
-    // timeout.
+    WorkerRequest::Ptr request = queue->top();
+    queue->pop();
+    return request;
+}
 
-    return WorkerRequest::Ptr();
+void WorkerProcessor::enqueueImpl(util::Lock const& lock,
+                                  WorkerRequest::Ptr const& request) {
+
+    _newRequests[poolOf(request)].push(request);
+    _cv.notify_all();
 }
 
 void
@@ -794,7 +1110,7 @@ WorkerProcessor::processingRefused(WorkerRequest::Ptr const& request) {
             return ptr->id() == request->id();
         }
     );
-    _newRequests.push(request);
+    enqueueImpl(lock, request);
 }
 
 void WorkerProcessor::processingFinished(WorkerRequest::Ptr const& request) {
@@ -893,4 +1209,37 @@ void WorkerProcessor::setInfo(WorkerRequest::Ptr const& request,
     ptr->setInfo(response);
 }
 
+void WorkerProcessor::setInfo(WorkerRequest::Ptr const& request,
+                              proto::ReplicationResponseIngest& response) {
+
+    auto ptr = std::dynamic_pointer_cast<WorkerIngestRequest>(request);
+    if (not ptr) {
+        throw std::logic_error("incorrect dynamic type of request id: " + request->id() +
+                               " in WorkerProcessor::setInfo(WorkerIngestRequest)");
+    }
+    ptr->setInfo(response);
+}
+
+void WorkerProcessor::setInfo(WorkerRequest::Ptr const& request,
+                              proto::ReplicationResponseIndex& response) {
+
+    auto ptr = std::dynamic_pointer_cast<WorkerIndexRequest>(request);
+    if (not ptr) {
+        throw std::logic_error("incorrect dynamic type of request id: " + request->id() +
+                               " in WorkerProcessor::setInfo(WorkerIndexRequest)");
+    }
+    ptr->setInfo(response);
+}
+
+void WorkerProcessor::setInfo(WorkerRequest::Ptr const& request,
+                              proto::ReplicationResponsePack& response) {
+
+    auto ptr = std::dynamic_pointer_cast<WorkerPackRequest>(request);
+    if (not ptr) {
+        throw std::logic_error("incorrect dynamic type of request id: " + request->id() +
+                               " in WorkerProcessor::setInfo(WorkerPackRequest)");
+    }
+    ptr->setInfo(response);
+}
+
 }}} // namespace lsst::qserv::replica
@@ -25,7 +25,10 @@
 
 // System headers
 #include <algorithm>
+#include <array>
+#include <condition_variable>
 #include <list>
+#include <map>
 #include <memory>
 #include <queue>
 #include <stdexcept>
@@ -125,6 +128,26 @@ public:
     /// @return the string representation of the state
     static std::string state2string(State state);
 
+    /**
+     * The pools of threads and the queues of new requests served by them.
+     * Requests copying files and requests computing checksums may take
+     * a long time, and they don't keep the other requests waiting.
+     */
+    enum Pool {
+        POOL_IO,        // replication, ingest and secondary index requests
+        POOL_CPU,       // find requests computing checksums
+        POOL_SHORT      // all other requests
+    };
+
+    /// The number of pools
+    static size_t const numPools = 3;
+
+    /// @return the string representation of the pool
+    static std::string pool2string(Pool pool);
+
+    /// @return the pool a request is queued for
+    static Pool poolOf(WorkerRequest::Ptr const& request);
+
     /**
      * The factory method for objects of the class
      *
@@ -149,6 +172,9 @@ public:
 
     ~WorkerProcessor() = default;
 
+    /// @return the name of the worker served by the processor
+    std::string const& worker() const { return _worker; }
+
     /// @return the state of the processor
     State state() const { return _state; }
 
@@ -249,6 +275,57 @@ public:
                         proto::ReplicationRequestEcho const& request,
                         proto::ReplicationResponseEcho& response);
 
+    /**
+     * Enqueue the chunk ingest request for processing
+     *
+     * @param id
+     *   an identifier of a request
+     *
+     * @param request
+     *   the Protobuf object received from a client
+     *
+     * @param response
+     *   the Protobuf object to be initialized and ready to be sent back
+     *   to the client
+     */
+    void enqueueForIngest(std::string const& id,
+                          proto::ReplicationRequestIngest const& request,
+                          proto::ReplicationResponseIngest& response);
+
+    /**
+     * Enqueue the secondary index request for processing
+     *
+     * @param id
+     *   an identifier of a request
+     *
+     * @param request
+     *   the Protobuf object received from a client
+     *
+     * @param response
+     *   the Protobuf object to be initialized and ready to be sent back
+     *   to the client
+     */
+    void enqueueForIndex(std::string const& id,
+                         proto::ReplicationRequestIndex const& request,
+                         proto::ReplicationResponseIndex& response);
+
+    /**
+     * Enqueue the request packing the tables of a chunk for processing
+     *
+     * @param id
+     *   an identifier of a request
+     *
+     * @param request
+     *   the Protobuf object received from a client
+     *
+     * @param response
+     *   the Protobuf object to be initialized and ready to be sent back
+     *   to the client
+     */
+    void enqueueForPack(std::string const& id,
+                        proto::ReplicationRequestPack const& request,
+                        proto::ReplicationResponsePack& response);
+
     /**
      * Set default values to protocol response which has 3 mandatory fields:
      *
@@ -441,10 +518,14 @@ private:
      * This method is supposed to be called by one of the processing threads
      * when it becomes available.
      *
+     * The thread only gets requests of its pool, or of any other pool except
+     * the one of the short requests when its pool has no requests.
+     *
      * @note
      *   this method will block for a duration of time not exceeding
      *   the client-specified timeout unless it's set to 0. In the later
-     *   case the method will block indefinitely.
+     *   case the method will block indefinitely. The thread is woken up
+     *   as soon as a request is queued.
      *
      * @param processorThread     - reference to a thread which fetches the next request
      * @param timeoutMilliseconds - (optional) amount of time to wait before to finish if
@@ -454,6 +535,33 @@ private:
                                 WorkerProcessorThread::Ptr const& processorThread,
                                 unsigned int timeoutMilliseconds=0);
 
+    /**
+     * Remove and return the next request to be processed by a thread of
+     * the specified pool.
+     *
+     * @param pool - the pool of the thread
+     *
+     * @return - a valid reference to the request object (if any)
+     *           or a reference to nullptr otherwise.
+     */
+    WorkerRequest::Ptr nextImpl(Pool pool);
+
+    /**
+     * Put a new request into the queue of its pool, and wake up
+     * the waiting threads.
+     *
+     * @param lock    - lock which must be acquired before calling this method
+     * @param request - a pointer to the request
+     */
+    void enqueueImpl(util::Lock const& lock,
+                     WorkerRequest::Ptr const& request);
+
+    /**
+     * @param lock - lock which must be acquired before calling this method
+     * @return the total number of new requests in all queues
+     */
+    size_t numNewRequestsImpl(util::Lock const& lock) const;
+
     /**
      * Implement the operation for the specified identifier if such request
      * is still known to the Processor. Return a reference to the request object
@@ -537,6 +645,42 @@ private:
     void setInfo(WorkerRequest::Ptr const& request,
                  proto::ReplicationResponseEcho& response);
 
+    /**
+     * Extract the progress of the ingest from the request and put it into
+     * the response object.
+     *
+     * @param request  - finished request
+     * @param response - Google Protobuf object to be initialized
+     *
+     * @throws std::logic_error if the dynamic type of the request won't match expectations
+     */
+    void setInfo(WorkerRequest::Ptr const& request,
+                 proto::ReplicationResponseIngest& response);
+
+    /**
+     * Extract the progress of the secondary index request and put it into
+     * the response object.
+     *
+     * @param request  - finished request
+     * @param response - Google Protobuf object to be initialized
+     *
+     * @throws std::logic_error if the dynamic type of the request won't match expectations
+     */
+    void setInfo(WorkerRequest::Ptr const& request,
+                 proto::ReplicationResponseIndex& response);
+
+    /**
+     * Extract the replica info of the packing request and put it into
+     * the response object.
+     *
+     * @param request  - finished request
+     * @param response - Google Protobuf object to be initialized
+     *
+     * @throws std::logic_error if the dynamic type of the request won't match expectations
+     */
+    void setInfo(WorkerRequest::Ptr const& request,
+                 proto::ReplicationResponsePack& response);
+
     /**
      * Fill in the information object for the specified request based on its
      * actual type.
@@ -609,11 +753,17 @@ private:
     /// A pool of threads for processing requests
     std::vector<WorkerProcessorThread::Ptr> _threads;
 
+    /// The pool of each thread (by thread identifier)
+    std::map<unsigned int, Pool> _threadPool;
+
     /// Mutex guarding the queues
     mutable util::Mutex _mtx;
 
-    /// New unprocessed requests
-    PriorityQueueType _newRequests;
+    /// For waking up threads waiting for new requests
+    std::condition_variable_any _cv;
+
+    /// New unprocessed requests (by pool)
+    std::array<PriorityQueueType, numPools> _newRequests;
 
     /// Requests which are being processed
     CollectionType _inProgressRequests;
@@ -24,17 +24,24 @@
 #include "replica/WorkerReplicationRequest.h"
 
 // System headers
+#include <algorithm>
 #include <cerrno>
 #include <cstring>
+#include <fcntl.h>
+#include <memory>
 #include <stdexcept>
+#include <unistd.h>
 
 // Qserv headers
 #include "lsst/log/Log.h"
+#include "replica/AsyncFileIO.h"
 #include "replica/Configuration.h"
+#include "replica/FileBlockManifest.h"
 #include "replica/FileClient.h"
 #include "replica/FileUtils.h"
 #include "replica/Performance.h"
 #include "replica/ServiceProvider.h"
+#include "util/StringHash.h"
 
 namespace fs = boost::filesystem;
 
@@ -42,6 +49,10 @@ namespace {
 
 LOG_LOGGER _log = LOG_GET("lsst.qserv.replica.WorkerReplicationRequest");
 
+/// Files are not split into ranges smaller than this when they are copied
+/// over many connections.
+uint64_t const minRangeBytes = 64 * 1024 * 1024;
+
 } /// namespace
 
 namespace lsst {
@@ -412,6 +423,13 @@ bool WorkerReplicationRequestPOSIX::execute () {
         return true;
     }
 
+    // Record the checksums of the blocks of the new files for the sampled
+    // verification of the replica
+
+    auto const manifest = FileBlockManifest::instance(worker(), outWorkerInfo.dataDir);
+    for (auto&& file: files) manifest->build(file2outFile[file].string());
+    manifest->save();
+
     // For now (before finalizing the progress reporting protocol) just return
     // the percentage of the total amount of data moved
 
@@ -423,6 +441,9 @@ bool WorkerReplicationRequestPOSIX::execute () {
 ///////////////////// WorkerReplicationRequestFS ////////////////////
 /////////////////////////////////////////////////////////////////////
 
+size_t     WorkerReplicationRequestFS::_numWorkerStreams = 0;
+std::mutex WorkerReplicationRequestFS::_numWorkerStreamsMtx;
+
 WorkerReplicationRequestFS::Ptr WorkerReplicationRequestFS::create (
                                             ServiceProvider::Ptr const& serviceProvider,
                                             std::string const& worker,
@@ -463,9 +484,13 @@ WorkerReplicationRequestFS::WorkerReplicationRequestFS(
         _databaseInfo(_serviceProvider->config()->databaseInfo(database)),
         _initialized(false),
         _files(FileUtils::partitionedFiles(_databaseInfo, chunk)),
-        _tmpFilePtr(nullptr),
-        _buf(0),
-        _bufSize(serviceProvider->config()->workerFsBufferSizeBytes()) {
+        _bufSize(serviceProvider->config()->workerFsBufferSizeBytes()),
+        _ioDepth(std::max<size_t>(1, serviceProvider->config()->workerFsIoDepth())),
+        _maxStreams(std::max<size_t>(1, serviceProvider->config()->workerFsMaxStreams())),
+        _minRangeBytes(std::max<uint64_t>(::minRangeBytes, _bufSize)),
+        _streamsStarted(false),
+        _numActiveStreams(0),
+        _stopStreams(false) {
 }
 
 WorkerReplicationRequestFS::~WorkerReplicationRequestFS() {
@@ -480,11 +505,17 @@ bool WorkerReplicationRequestFS::execute () {
          << "  database: "     << database()
          << "  chunk: "        << chunk());
 
+    // The streams copy the files on their own. Wait for them without holding
+    // the lock, which is shared by all requests.
+
+    if (_streamsStarted) waitForStreams(std::chrono::milliseconds(100));
+
     util::Lock lock(_mtx, context() + "execute");
 
     // Abort the operation right away if that's the case
 
     if (_status == STATUS_IS_CANCELLING) {
+        releaseResources(lock);
         setStatus(lock, STATUS_CANCELLED);
         throw WorkerRequestCancelled();
     }
@@ -517,13 +548,11 @@ bool WorkerReplicationRequestFS::execute () {
 
         fs::path const outDir = fs::path(_outWorkerInfo.dataDir) / database();
 
-        std::vector<fs::path> tmpFiles;
         std::vector<fs::path> outFiles;
 
         for (auto&& file: _files) {
 
             fs::path const tmpFile = outDir / ("_" + file);
-            tmpFiles.push_back(tmpFile);
 
             fs::path const outFile = outDir / file;
             outFiles.push_back(outFile);
@@ -536,6 +565,8 @@ bool WorkerReplicationRequestFS::execute () {
             _file2descr[file].outFile           = outFile;
             _file2descr[file].beginTransferTime = 0;
             _file2descr[file].endTransferTime   = 0;
+            _file2descr[file].fd                = -1;
+            _file2descr[file].basisSizeBytes    = 0;
         }
 
         // Check input files, check and sanitize the destination folder
@@ -605,24 +636,34 @@ bool WorkerReplicationRequestFS::execute () {
             }
 
             // Check if there are any files with the temporary names at the destination
-            // folder and if so then get rid of them.
+            // folder. The content left in these files by an earlier attempt to copy
+            // the files is kept, and only the blocks which differ from the input
+            // files will be copied again. Anything else is removed.
 
-            for (auto&& file: tmpFiles) {
-                fs::file_status const stat = fs::status(file, ec);
+            for (auto&& file: _files) {
+                fs::path const tmpFile = _file2descr[file].tmpFile;
+                fs::file_status const stat = fs::status(tmpFile, ec);
                 errorContext = errorContext
                     or reportErrorIf(
                             stat.type() == fs::status_error,
                             ExtendedCompletionStatus::EXT_STATUS_FILE_STAT,
-                            "failed to check the status of temporary file: " + file.string());
-
-                if (fs::exists(stat)) {
-                    fs::remove(file, ec);
-                    errorContext = errorContext
-                        or reportErrorIf(
-                                ec.value() != 0,
-                                ExtendedCompletionStatus::EXT_STATUS_FILE_DELETE,
-                                "failed to remove temporary file: " + file.string());
+                            "failed to check the status of temporary file: " + tmpFile.string());
+
+                if (not fs::exists(stat)) continue;
+                if (fs::is_regular_file(stat)) {
+                    uintmax_t const size = fs::file_size(tmpFile, ec);
+                    if ((ec.value() == 0) and (size != 0)) {
+                        _file2descr[file].basisSizeBytes =
+                            std::min<uintmax_t>(size, _file2descr[file].inSizeBytes);
+                        continue;
+                    }
                 }
+                fs::remove(tmpFile, ec);
+                errorContext = errorContext
+                    or reportErrorIf(
+                            ec.value() != 0,
+                            ExtendedCompletionStatus::EXT_STATUS_FILE_DELETE,
+                            "failed to remove temporary file: " + tmpFile.string());
             }
 
             // Make sure a file system at the destination has enough space
@@ -648,18 +689,20 @@ bool WorkerReplicationRequestFS::execute () {
 
                 fs::path const tmpFile = _file2descr[file].tmpFile;
 
-                // Create a file of size 0
+                // Create a file of size 0 unless the earlier content is kept
 
-                std::FILE* tmpFilePtr = std::fopen(tmpFile.string().c_str(), "wb");
-                errorContext = errorContext
-                    or reportErrorIf(
-                            not tmpFilePtr,
-                            ExtendedCompletionStatus::EXT_STATUS_FILE_CREATE,
-                            "failed to open/create temporary file: " + tmpFile.string() +
-                            ", error: " + std::strerror(errno));
-                if (tmpFilePtr) {
-                    std::fflush(tmpFilePtr);
-                    std::fclose(tmpFilePtr);
+                if (_file2descr[file].basisSizeBytes == 0) {
+                    std::FILE* tmpFilePtr = std::fopen(tmpFile.string().c_str(), "wb");
+                    errorContext = errorContext
+                        or reportErrorIf(
+                                not tmpFilePtr,
+                                ExtendedCompletionStatus::EXT_STATUS_FILE_CREATE,
+                                "failed to open/create temporary file: " + tmpFile.string() +
+                                ", error: " + std::strerror(errno));
+                    if (tmpFilePtr) {
+                        std::fflush(tmpFilePtr);
+                        std::fclose(tmpFilePtr);
+                    }
                 }
 
                 // Resize the file (will be filled with \0)
@@ -677,155 +720,435 @@ bool WorkerReplicationRequestFS::execute () {
             return true;
         }
 
-        // Allocate the record buffer
-        _buf = new uint8_t[_bufSize];
-        if (not _buf) {
-            throw std::runtime_error(
-                            "WorkerReplicationRequestFS::execute()  buffer allocation failed");
+        // Setup the ranges of the files to be copied
+        for (auto&& file: _files) {
+            uint64_t const size = _file2descr[file].inSizeBytes;
+            if (size == 0) continue;
+            uint64_t const numRanges = std::max<uint64_t>(
+                1, std::min<uint64_t>(_maxStreams, size / _minRangeBytes));
+            uint64_t const rangeBytes = (size + numRanges - 1) / numRanges;
+            for (uint64_t offset = 0; offset < size; offset += rangeBytes) {
+                _ranges.push_back(Range{file, offset, std::min(rangeBytes, size - offset)});
+            }
         }
+    }
 
-        // Setup the iterator for the name of the very first file to be copied
-        _fileItr = _files.begin();
+    // Begin copying the files as soon as the worker has streams to spare
 
-        if (not openFiles(lock)) return true;
+    if (not _streamsStarted) {
+        bool const started = startStreams(lock);
+        if (not started and (_status != STATUS_FAILED)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        return _status == STATUS_FAILED;
     }
 
-    // Copy the next record from the currently open remote file
-    // into the corresponding temporary files at the destination folder
-    // w/o acquiring the directory lock.
-    //
-    // NOTE: the while loop below is meant to skip files which are empty
+    // Keep updating the stats while the streams are copying the files
 
-    while (_files.end() != _fileItr) {
+    updateInfo(lock);
+    {
+        std::lock_guard<std::mutex> streamLock(_streamMtx);
+        if (_numActiveStreams != 0) return false;
+        errorContext = _streamError;
+    }
+    stopStreams();
 
-        // Copy the next record if any is available
+    // Make sure the number of bytes copied from the remote server
+    // matches expectations.
 
-        size_t num = 0;
-        try {
-            num = _inFilePtr->read(_buf, _bufSize);
-            if (num) {
-                if (num == std::fwrite(_buf, sizeof(uint8_t), num, _tmpFilePtr)) {
+    for (auto&& file: _files) {
+        errorContext = errorContext
+            or reportErrorIf(
+                _file2descr[file].inSizeBytes != _file2descr[file].outSizeBytes,
+                ExtendedCompletionStatus::EXT_STATUS_FILE_READ,
+                "short read of the input file from remote worker: " + _inWorkerInfo.name +
+                ", database: " + _databaseInfo.name +
+                ", file: " + file);
+    }
+    if (errorContext.failed) {
+        setStatus(lock, STATUS_FAILED, errorContext.extendedStatus);
+        releaseResources(lock);
+        return true;
+    }
 
-                    // Update the descriptor (the number of bytes copied so far
-                    // and the control sum)
-                    _file2descr[*_fileItr].outSizeBytes += num;
-                    uint64_t& cs = _file2descr[*_fileItr].cs;
-                    for (uint8_t *ptr = _buf, *end = _buf + num;
-                         ptr != end; ++ptr) { cs += *ptr; }
+    // Finalize the operation, deallocate resources, etc.
+    return finalize(lock);
+}
 
-                    // Keep updating this stats while copying the files
-                    _file2descr[*_fileItr].endTransferTime = PerformanceUtils::now();
-                    updateInfo(lock);
+bool WorkerReplicationRequestFS::startStreams(util::Lock const& lock) {
 
-                    // Keep copying the same file
-                    return false;
-                }
-                errorContext = errorContext
-                    or reportErrorIf(
-                        true,
-                        ExtendedCompletionStatus::EXT_STATUS_FILE_WRITE,
-                        "failed to write into temporary file: " + _file2descr[*_fileItr].tmpFile.string() +
-                        ", error: " + std::strerror(errno));
-            }
+    LOGS(_log, LOG_LVL_DEBUG, context() << "startStreams"
+         << "  sourceWorker: " << sourceWorker()
+         << "  database: "     << database()
+         << "  chunk: "        << chunk()
+         << "  ranges: "       << _ranges.size());
 
-        } catch (FileClientError const& ex) {
-            errorContext = errorContext
-                or reportErrorIf(
-                    true,
-                    ExtendedCompletionStatus::EXT_STATUS_FILE_READ,
-                    "failed to read input file from remote worker: " + _inWorkerInfo.name +
-                    ", database: " + _databaseInfo.name +
-                    ", file: " + *_fileItr);
+    WorkerRequest::ErrorContext errorContext;
+
+    // Take the streams of the request from those of the worker. Empty
+    // files need no stream.
+
+    size_t const wanted = std::min(_maxStreams, _ranges.size());
+    size_t numStreams = 0;
+    if (wanted != 0) {
+        std::lock_guard<std::mutex> workerLock(_numWorkerStreamsMtx);
+        if (_numWorkerStreams < _maxStreams) {
+            numStreams = std::min(wanted, _maxStreams - _numWorkerStreams);
+            _numWorkerStreams += numStreams;
         }
+        if (numStreams == 0) return false;
+    }
 
-        // Make sure the number of bytes copied from the remote server
-        // matches expectations.
+    // The temporary files were created with their final size, each stream
+    // writes its ranges into them at the right offsets.
+
+    for (auto&& file: _files) {
+        FileDescr& descr = _file2descr[file];
+        descr.fd = ::open(descr.tmpFile.string().c_str(), O_RDWR);
         errorContext = errorContext
             or reportErrorIf(
-                _file2descr[*_fileItr].inSizeBytes != _file2descr[*_fileItr].outSizeBytes,
-                ExtendedCompletionStatus::EXT_STATUS_FILE_READ,
-                "short read of the input file from remote worker: " + _inWorkerInfo.name +
-                ", database: " + _databaseInfo.name +
-                ", file: " + *_fileItr);
+                descr.fd < 0,
+                ExtendedCompletionStatus::EXT_STATUS_FILE_OPEN,
+                "failed to open temporary file: " + descr.tmpFile.string() +
+                ", error: " + std::strerror(errno));
+        descr.beginTransferTime = PerformanceUtils::now();
+        descr.endTransferTime   = descr.beginTransferTime;
+    }
+    if (errorContext.failed) {
+        {
+            std::lock_guard<std::mutex> workerLock(_numWorkerStreamsMtx);
+            _numWorkerStreams -= numStreams;
+        }
+        setStatus(lock, STATUS_FAILED, errorContext.extendedStatus);
+        releaseResources(lock);
+        return false;
+    }
+
+    _streamsStarted   = true;
+    _numActiveStreams = numStreams;
+    for (size_t i = 0; i < numStreams; ++i) {
+        _streams.emplace_back(&WorkerReplicationRequestFS::copyRanges, this);
+    }
+    return true;
+}
+
+void WorkerReplicationRequestFS::copyRanges() {
 
+    std::unique_ptr<AsyncFileIO> io;
+    try {
+        io.reset(new AsyncFileIO(_ioDepth, _bufSize));
+    } catch (std::exception const& ex) {
+        std::lock_guard<std::mutex> streamLock(_streamMtx);
+        _streamError = _streamError
+            or reportErrorIf(
+                true,
+                ExtendedCompletionStatus::EXT_STATUS_FILE_WRITE,
+                "failed to set up the record buffers of a stream: " + std::string(ex.what()));
+        _stopStreams = true;
+    }
+    while (io != nullptr) {
+        Range range;
+        {
+            std::lock_guard<std::mutex> streamLock(_streamMtx);
+            if (_stopStreams or _ranges.empty()) break;
+            range = _ranges.front();
+            _ranges.pop_front();
+        }
+        WorkerRequest::ErrorContext const errorContext = copyRange(range, *io);
         if (errorContext.failed) {
-            setStatus(lock, STATUS_FAILED, errorContext.extendedStatus);
-            releaseResources(lock);
-            return true;
+            std::lock_guard<std::mutex> streamLock(_streamMtx);
+            _streamError = _streamError or errorContext;
+            _stopStreams = true;
+            break;
         }
-        // Flush and close the current file
-
-        std::fflush(_tmpFilePtr);
-        std::fclose(_tmpFilePtr);
-        _tmpFilePtr = 0;
-
-        // Keep updating this stats after finishing to copy each file
-        _file2descr[*_fileItr].endTransferTime = PerformanceUtils::now();
-        updateInfo(lock);
-
-        // Move the iterator to the name of the next file to be copied
-        ++_fileItr;
-        if (_files.end() != _fileItr) {
-            if (not openFiles(lock)) {
-                releaseResources(lock);
-                return true;
+    }
+    io.reset();
+    {
+        std::lock_guard<std::mutex> workerLock(_numWorkerStreamsMtx);
+        --_numWorkerStreams;
+    }
+    {
+        std::lock_guard<std::mutex> streamLock(_streamMtx);
+        --_numActiveStreams;
+    }
+    _streamCv.notify_all();
+}
+
+WorkerRequest::ErrorContext WorkerReplicationRequestFS::copyRange(Range const& range,
+                                                                  AsyncFileIO& io) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "copyRange"
+         << "  file: "   << range.file
+         << "  offset: " << range.offset
+         << "  length: " << range.length);
+
+    if (_file2descr[range.file].basisSizeBytes > range.offset) return copyRangeDelta(range, io);
+
+    WorkerRequest::ErrorContext errorContext;
+
+    FileClient::Ptr const inFilePtr = FileClient::openRange(_serviceProvider,
+                                                            _inWorkerInfo.name,
+                                                            _databaseInfo.name,
+                                                            range.file,
+                                                            range.offset,
+                                                            range.length);
+    errorContext = errorContext
+        or reportErrorIf(
+            not inFilePtr,
+            ExtendedCompletionStatus::EXT_STATUS_FILE_ROPEN,
+            "failed to open input file on remote worker: " + _inWorkerInfo.name +
+            ", database: " + _databaseInfo.name +
+            ", file: " + range.file);
+    if (errorContext.failed) return errorContext;
+
+    int const fd = _file2descr[range.file].fd;
+    std::string const tmpFile = _file2descr[range.file].tmpFile.string();
+
+    // The buffers not used by a write, and the size and the control sum
+    // of the record in each buffer being written
+    std::vector<size_t> freeBufs;
+    for (size_t i = io.depth(); i > 0; --i) freeBufs.push_back(i - 1);
+    std::vector<size_t> bytes(io.depth(), 0);
+    std::vector<uint64_t> css(io.depth(), 0);
+
+    // Wait for the next write to complete, and count its record
+    bool stop = false;
+    auto const completeWrite = [&]() {
+        AsyncFileIO::Completion const c = io.wait();
+        freeBufs.push_back(c.buf);
+        if (errorContext.failed) return;
+        errorContext = errorContext
+            or reportErrorIf(
+                c.result != static_cast<ssize_t>(bytes[c.buf]),
+                ExtendedCompletionStatus::EXT_STATUS_FILE_WRITE,
+                "failed to write into temporary file: " + tmpFile +
+                ", error: " + (c.result < 0 ? std::strerror(-c.result) : "short write"));
+        if (errorContext.failed) return;
+
+        std::lock_guard<std::mutex> streamLock(_streamMtx);
+        FileDescr& descr = _file2descr[range.file];
+        descr.outSizeBytes   += bytes[c.buf];
+        descr.cs             += css[c.buf];
+        descr.endTransferTime = PerformanceUtils::now();
+        if (_stopStreams) stop = true;
+    };
+
+    uint64_t copied = 0;
+    try {
+        while (copied < range.length and not errorContext.failed and not stop) {
+            if (freeBufs.empty()) {
+                completeWrite();
+                continue;
             }
+            size_t const buf = freeBufs.back();
+            uint8_t* const data = io.buffer(buf);
+            size_t const num = inFilePtr->read(data, std::min<uint64_t>(io.bufferSize(),
+                                                                        range.length - copied));
+            if (not num) break;
+            freeBufs.pop_back();
+
+            // The control sum is a sum of bytes, so the ranges can be added up
+            // in any order.
+            uint64_t cs = 0;
+            for (uint8_t *ptr = data, *end = data + num;
+                 ptr != end; ++ptr) { cs += *ptr; }
+
+            bytes[buf] = num;
+            css[buf]   = cs;
+            io.write(buf, fd, range.offset + copied, num);
+            copied += num;
         }
+        while (io.inFlight() != 0) completeWrite();
+
+    } catch (FileClientError const& ex) {
+        errorContext = errorContext
+            or reportErrorIf(
+                true,
+                ExtendedCompletionStatus::EXT_STATUS_FILE_READ,
+                "failed to read input file from remote worker: " + _inWorkerInfo.name +
+                ", database: " + _databaseInfo.name +
+                ", file: " + range.file);
+    } catch (std::exception const& ex) {
+        errorContext = errorContext
+            or reportErrorIf(
+                true,
+                ExtendedCompletionStatus::EXT_STATUS_FILE_WRITE,
+                "failed to write into temporary file: " + tmpFile + ", error: " + ex.what());
     }
 
-    // Finalize the operation, deallocate resources, etc.
-    return finalize(lock);
+    // The buffers are used by the next range of the stream
+    try {
+        while (io.inFlight() != 0) io.wait();
+    } catch (std::exception const& ex) {
+        errorContext = errorContext
+            or reportErrorIf(
+                true,
+                ExtendedCompletionStatus::EXT_STATUS_FILE_WRITE,
+                "failed to write into temporary file: " + tmpFile + ", error: " + ex.what());
+    }
+    return errorContext;
 }
 
-bool WorkerReplicationRequestFS::openFiles(util::Lock const& lock) {
+WorkerRequest::ErrorContext WorkerReplicationRequestFS::copyRangeDelta(Range const& range,
+                                                                       AsyncFileIO& io) {
 
-    LOGS(_log, LOG_LVL_DEBUG, context() << "openFiles"
-         << "  sourceWorker: " << sourceWorker()
-         << "  database: "     << database()
-         << "  chunk: "        << chunk()
-         << "  file: "         << *_fileItr);
+    LOGS(_log, LOG_LVL_DEBUG, context() << "copyRangeDelta"
+         << "  file: "   << range.file
+         << "  offset: " << range.offset
+         << "  length: " << range.length);
 
     WorkerRequest::ErrorContext errorContext;
 
-    // Open the input file on the remote server
-    _inFilePtr = FileClient::open(_serviceProvider,
-                                  _inWorkerInfo.name,
-                                  _databaseInfo.name,
-                                  *_fileItr);
+    FileDescr& descr = _file2descr[range.file];
+    int const fd = descr.fd;
+    uint8_t* const buf = io.buffer(0);
+    uint64_t const blockSize = io.bufferSize();
+    uint64_t const rangeEnd = range.offset + range.length;
+    char const* data = reinterpret_cast<char const*>(buf);
+
+    // Compute the checksums of the blocks of the earlier content
+
+    std::vector<uint32_t> blockCrcs;
+    uint64_t const basisEnd = std::min(descr.basisSizeBytes, rangeEnd);
+    for (uint64_t offset = range.offset; offset < basisEnd; offset += blockSize) {
+        size_t const bytes = std::min(blockSize, basisEnd - offset);
+        ssize_t const num = ::pread(fd, buf, bytes, offset);
+        errorContext = errorContext
+            or reportErrorIf(
+                num != static_cast<ssize_t>(bytes),
+                ExtendedCompletionStatus::EXT_STATUS_FILE_READ,
+                "failed to read temporary file: " + descr.tmpFile.string() +
+                ", error: " + std::strerror(errno));
+        if (errorContext.failed) return errorContext;
+        blockCrcs.push_back(util::StringHash::getCrc32c(data, bytes));
+    }
+
+    FileClient::Ptr const inFilePtr = FileClient::openDelta(_serviceProvider,
+                                                            _inWorkerInfo.name,
+                                                            _databaseInfo.name,
+                                                            range.file,
+                                                            range.offset,
+                                                            range.length,
+                                                            blockSize,
+                                                            blockCrcs);
     errorContext = errorContext
         or reportErrorIf(
-            not _inFilePtr,
+            not inFilePtr,
             ExtendedCompletionStatus::EXT_STATUS_FILE_ROPEN,
             "failed to open input file on remote worker: " + _inWorkerInfo.name +
             ", database: " + _databaseInfo.name +
-            ", file: " + *_fileItr);
+            ", file: " + range.file);
+    if (errorContext.failed) return errorContext;
 
-    if (errorContext.failed) {
-        setStatus(lock, STATUS_FAILED, errorContext.extendedStatus);
-        return false;
-    }
+    // Write the changed blocks over the earlier content
 
-    // Reopen a temporary output file locally in the 'append binary mode'
-    // then 'rewind' to the beginning of the file before writing into it.
+    uint64_t const numBlocks = (range.length + blockSize - 1) / blockSize;
+    uint64_t copied = 0;
+    try {
+        for (auto block: inFilePtr->changedBlocks()) {
+            errorContext = errorContext
+                or reportErrorIf(
+                    block >= numBlocks,
+                    ExtendedCompletionStatus::EXT_STATUS_FILE_READ,
+                    "invalid block: " + std::to_string(block) + " reported by remote worker: " +
+                    _inWorkerInfo.name + ", database: " + _databaseInfo.name +
+                    ", file: " + range.file);
+            if (errorContext.failed) return errorContext;
+
+            uint64_t const offset = range.offset + block * blockSize;
+            size_t const bytes = std::min(blockSize, rangeEnd - offset);
+            size_t const num = inFilePtr->read(buf, bytes);
+            errorContext = errorContext
+                or reportErrorIf(
+                    num != bytes,
+                    ExtendedCompletionStatus::EXT_STATUS_FILE_READ,
+                    "short read of the input file from remote worker: " + _inWorkerInfo.name +
+                    ", database: " + _databaseInfo.name +
+                    ", file: " + range.file);
+            if (errorContext.failed) return errorContext;
+
+            ssize_t const written = ::pwrite(fd, buf, num, offset);
+            errorContext = errorContext
+                or reportErrorIf(
+                    written != static_cast<ssize_t>(num),
+                    ExtendedCompletionStatus::EXT_STATUS_FILE_WRITE,
+                    "failed to write into temporary file: " + descr.tmpFile.string() +
+                    ", error: " + std::strerror(errno));
+            if (errorContext.failed) return errorContext;
+            copied += num;
+
+            std::lock_guard<std::mutex> streamLock(_streamMtx);
+            descr.outSizeBytes   += num;
+            descr.endTransferTime = PerformanceUtils::now();
+            if (_stopStreams) return errorContext;
+        }
+
+    } catch (FileClientError const& ex) {
+        errorContext = errorContext
+            or reportErrorIf(
+                true,
+                ExtendedCompletionStatus::EXT_STATUS_FILE_READ,
+                "failed to read input file from remote worker: " + _inWorkerInfo.name +
+                ", database: " + _databaseInfo.name +
+                ", file: " + range.file);
+        return errorContext;
+    }
 
-    fs::path const tmpFile = _file2descr[*_fileItr].tmpFile;
+    // Verify the whole range, including the blocks which were not copied,
+    // and compute its control sum.
 
-    _tmpFilePtr = std::fopen(tmpFile.string().c_str(), "wb");
+    uint32_t crc = 0;
+    uint64_t cs = 0;
+    for (uint64_t offset = range.offset; offset < rangeEnd; offset += blockSize) {
+        size_t const bytes = std::min(blockSize, rangeEnd - offset);
+        ssize_t const num = ::pread(fd, buf, bytes, offset);
+        errorContext = errorContext
+            or reportErrorIf(
+                num != static_cast<ssize_t>(bytes),
+                ExtendedCompletionStatus::EXT_STATUS_FILE_READ,
+                "failed to read temporary file: " + descr.tmpFile.string() +
+                ", error: " + std::strerror(errno));
+        if (errorContext.failed) return errorContext;
+        crc = util::StringHash::getCrc32c(data, bytes, crc);
+        for (uint8_t *ptr = buf, *end = buf + bytes;
+             ptr != end; ++ptr) { cs += *ptr; }
+    }
     errorContext = errorContext
         or reportErrorIf(
-            not _tmpFilePtr,
-            ExtendedCompletionStatus::EXT_STATUS_FILE_OPEN,
-            "failed to open temporary file: " + tmpFile.string() +
-            ", error: " + std::strerror(errno));
-    if (errorContext.failed) {
-        setStatus(lock, STATUS_FAILED, errorContext.extendedStatus);
-        return false;
-    }
-    std::rewind(_tmpFilePtr);
+            crc != inFilePtr->crc32c(),
+            ExtendedCompletionStatus::EXT_STATUS_FILE_READ,
+            "checksum mismatch after the delta transfer of the input file from remote worker: " +
+            _inWorkerInfo.name + ", database: " + _databaseInfo.name +
+            ", file: " + range.file + ", offset: " + std::to_string(range.offset));
+    if (errorContext.failed) return errorContext;
+
+    LOGS(_log, LOG_LVL_DEBUG, context() << "copyRangeDelta"
+         << "  file: "   << range.file
+         << "  offset: " << range.offset
+         << "  copied: " << copied
+         << "  reused: " << range.length - copied);
+
+    std::lock_guard<std::mutex> streamLock(_streamMtx);
+    descr.outSizeBytes   += range.length - copied;
+    descr.cs             += cs;
+    descr.endTransferTime = PerformanceUtils::now();
+    return errorContext;
+}
 
-    _file2descr[*_fileItr].beginTransferTime = PerformanceUtils::now();
+void WorkerReplicationRequestFS::waitForStreams(std::chrono::milliseconds const& timeout) {
+    std::unique_lock<std::mutex> streamLock(_streamMtx);
+    _streamCv.wait_for(streamLock, timeout, [this]() { return _numActiveStreams == 0; });
+}
 
-    return true;
+void WorkerReplicationRequestFS::stopStreams() {
+    {
+        std::lock_guard<std::mutex> streamLock(_streamMtx);
+        _stopStreams = true;
+    }
+    for (auto&& stream: _streams) {
+        if (stream.joinable()) stream.join();
+    }
+    _streams.clear();
 }
 
 bool WorkerReplicationRequestFS::finalize(util::Lock const& lock) {
@@ -843,39 +1166,48 @@ bool WorkerReplicationRequestFS::finalize(util::Lock const& lock) {
     // which may affect other users (like replica lookup operations, etc.). Hence we're
     // acquiring the directory lock to guarantee a consistent view onto the folder.
 
-    util::Lock dataFolderLock(_mtxDataFolderOperations, context() + "finalize");
-
-    // ATTENTION: as per ISO/IEC 9945 the file rename operation will
-    //            remove empty files. Not sure if this should be treated
-    //            in a special way?
-
     WorkerRequest::ErrorContext errorContext;
     boost::system::error_code   ec;
+    {
+        util::Lock dataFolderLock(_mtxDataFolderOperations, context() + "finalize");
 
-    for (auto&& file: _files) {
+        // ATTENTION: as per ISO/IEC 9945 the file rename operation will
+        //            remove empty files. Not sure if this should be treated
+        //            in a special way?
 
-        fs::path const tmpFile = _file2descr[file].tmpFile;
-        fs::path const outFile = _file2descr[file].outFile;
+        for (auto&& file: _files) {
 
-        fs::rename(tmpFile, outFile, ec);
-        errorContext = errorContext
-            or reportErrorIf (
-                    ec.value() != 0,
-                    ExtendedCompletionStatus::EXT_STATUS_FILE_RENAME,
-                    "failed to rename file: " + tmpFile.string());
+            fs::path const tmpFile = _file2descr[file].tmpFile;
+            fs::path const outFile = _file2descr[file].outFile;
 
-        fs::last_write_time(outFile, _file2descr[file].mtime, ec);
-        errorContext = errorContext
-            or reportErrorIf (
-                    ec.value() != 0,
-                    ExtendedCompletionStatus::EXT_STATUS_FILE_MTIME,
-                    "failed to change 'mtime' of file: " + tmpFile.string());
-    }
+            fs::rename(tmpFile, outFile, ec);
+            errorContext = errorContext
+                or reportErrorIf (
+                        ec.value() != 0,
+                        ExtendedCompletionStatus::EXT_STATUS_FILE_RENAME,
+                        "failed to rename file: " + tmpFile.string());
 
+            fs::last_write_time(outFile, _file2descr[file].mtime, ec);
+            errorContext = errorContext
+                or reportErrorIf (
+                        ec.value() != 0,
+                        ExtendedCompletionStatus::EXT_STATUS_FILE_MTIME,
+                        "failed to change 'mtime' of file: " + tmpFile.string());
+        }
+    }
     if (errorContext.failed) {
         setStatus(lock, STATUS_FAILED, errorContext.extendedStatus);
         return true;
     }
+
+    // Record the checksums of the blocks of the new files for the sampled
+    // verification of the replica. The data folder isn't locked while
+    // the files are read.
+
+    auto const manifest = FileBlockManifest::instance(worker(), _outWorkerInfo.dataDir);
+    for (auto&& file: _files) manifest->build(_file2descr[file].outFile.string());
+    manifest->save();
+
     setStatus(lock, STATUS_SUCCEEDED);
     return true;
 }
@@ -885,6 +1217,8 @@ void WorkerReplicationRequestFS::updateInfo(util::Lock const& lock) {
     size_t totalInSizeBytes  = 0;
     size_t totalOutSizeBytes = 0;
 
+    std::lock_guard<std::mutex> streamLock(_streamMtx);
+
     ReplicaInfo::FileInfoCollection fileInfoCollection;
     for (auto&& file: _files) {
         fileInfoCollection.emplace_back(
@@ -895,7 +1229,11 @@ void WorkerReplicationRequestFS::updateInfo(util::Lock const& lock) {
                 std::to_string(_file2descr[file].cs),
                 _file2descr[file].beginTransferTime,
                 _file2descr[file].endTransferTime,
-                _file2descr[file].inSizeBytes
+                _file2descr[file].inSizeBytes,
+                "",     /* csAlgorithm: the sum of bytes */
+                FileUtils::isPackedMyISAM(_file2descr[file].outFile.string()),
+                0,      /* unpackedSize */
+                ""      /* unpackedCs */
             })
         );
         totalInSizeBytes  += _file2descr[file].inSizeBytes;
@@ -921,20 +1259,17 @@ void WorkerReplicationRequestFS::updateInfo(util::Lock const& lock) {
 void
 WorkerReplicationRequestFS::releaseResources(util::Lock const& lock) {
 
-    // Drop a connection to the remote server
-    _inFilePtr.reset();
+    // Stop the streams, which drops their connections to the remote server
+    // and releases their record buffers
+    stopStreams();
 
-    // Close the output file
-    if (_tmpFilePtr) {
-        std::fflush(_tmpFilePtr);
-        std::fclose(_tmpFilePtr);
-        _tmpFilePtr = nullptr;
-    }
-
-    // Release the record buffer
-    if (_buf) {
-        delete [] _buf;
-        _buf = nullptr;
+    // Close the output files
+    for (auto&& elem: _file2descr) {
+        FileDescr& descr = elem.second;
+        if (descr.fd >= 0) {
+            ::close(descr.fd);
+            descr.fd = -1;
+        }
     }
 }
 
@@ -24,10 +24,16 @@
 #define LSST_QSERV_REPLICA_WORKERREPLICATIONREQUEST_H
 
 // System headers
+#include <chrono>
+#include <condition_variable>
 #include <cstdio>               // std::FILE, C-style file I/O
 #include <ctime>
+#include <deque>
 #include <map>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 // Third party headers
 #include <boost/filesystem.hpp>
@@ -46,6 +52,7 @@ namespace qserv {
 namespace replica {
 
 // Forward declarations
+class AsyncFileIO;
 class FileClient;
 
 /**
@@ -278,15 +285,73 @@ protected:
                                std::string const& sourceWorker);
 
 private:
-    
+
+    /// A byte range of an input file copied over one connection
+    struct Range {
+        std::string file;
+        uint64_t offset;
+        uint64_t length;
+    };
+
     /**
-     * Open files associated with the current state of iterator _fileItr.
+     * Split the input files into byte ranges, open the temporary files and
+     * start copying the ranges with as many connections to the source worker
+     * as the per-worker limit on streams allows.
      *
      * @param lock - lock which must be acquired before calling this method
      *
-     * @return 'false' in case of any error
+     * @return 'false' if no stream was available, or in case of any error,
+     *   in which case the status of the request will say which
+     */
+    bool startStreams(util::Lock const& lock);
+
+    /**
+     * Copy ranges until none are left, the request is stopped or a range
+     * fails. This runs in the threads started by startStreams().
+     */
+    void copyRanges();
+
+    /**
+     * Copy one range from the remote file into the temporary file. The next
+     * records are received while the earlier ones are still being written,
+     * in as many buffers as the stream has.
+     *
+     * @param range - the range to be copied
+     * @param io    - the record buffers of the stream, with no operation
+     *                in flight
+     *
+     * @return the error context of the operation
      */
-    bool openFiles(util::Lock const& lock);
+    WorkerRequest::ErrorContext copyRange(Range const& range,
+                                          AsyncFileIO& io);
+
+    /**
+     * Copy one range from the remote file into the temporary file which
+     * already has (some of) the content of the range from an earlier attempt
+     * to copy the file. Only the blocks of the range which are different
+     * are transferred. The range is verified against the checksum computed
+     * by the remote server afterwards.
+     *
+     * @param range - the range to be copied
+     * @param io    - the record buffers of the stream, the size of which is
+     *                also the size of the blocks. Only the first buffer is used.
+     *
+     * @return the error context of the operation
+     */
+    WorkerRequest::ErrorContext copyRangeDelta(Range const& range,
+                                               AsyncFileIO& io);
+
+    /**
+     * Wait for the streams to finish, for up to the specified time.
+     *
+     * @param timeout - the maximum time to wait
+     */
+    void waitForStreams(std::chrono::milliseconds const& timeout);
+
+    /**
+     * Stop and join the streams, and give their slots back to the worker.
+     */
+    void stopStreams();
 
     /**
      * The final stage to be executed just once after copying the content
@@ -338,18 +403,6 @@ private:
     /// Short names of files to be copied
     std::vector<std::string> const _files;
 
-    /// The iterator pointing to the currently processed file.
-    /// If it's set to _files.end() then it means the operation
-    /// has finished.
-    std::vector<std::string>::const_iterator _fileItr;
-
-    /// This object represents the currently open (if any) input file
-    /// on the source worker node
-    std::shared_ptr<FileClient> _inFilePtr;
-
-    /// The file pointer for the temporary output file
-    std::FILE* _tmpFilePtr;
-
     /// The FileDescr structure encapsulates various parameters of a file
     struct FileDescr {
 
@@ -378,17 +431,61 @@ private:
 
         /// When the file transfer ended
         uint64_t endTransferTime;
+
+        /// The descriptor of the temporary file written by the streams, or -1
+        int fd;
+
+        /// The number of bytes of the temporary file left by an earlier attempt
+        /// to copy the file. The blocks of this content which have not changed
+        /// aren't transferred again.
+        uint64_t basisSizeBytes;
     };
 
     /// Cached file descriptions mapping from short file names into
     /// the corresponding parameters
     std::map<std::string, FileDescr> _file2descr;
 
-    /// The buffer for storing file payload read from a remote file service
-    uint8_t* _buf;
-
-    /// The size of the buffer
+    /// The size of the record buffers of each stream
     size_t _bufSize;
+
+    /// The number of record buffers of each stream, which is the number
+    /// of writes of a stream in flight
+    size_t const _ioDepth;
+
+    /// The number of streams allowed for each worker, and the size of a range
+    /// below which a file isn't split any further
+    size_t const _maxStreams;
+    uint64_t const _minRangeBytes;
+
+    /// True once startStreams() has started the streams
+    bool _streamsStarted;
+
+    /// Threads copying the ranges
+    std::vector<std::thread> _streams;
+
+    /// Protects the members below, and _file2descr while the streams run
+    std::mutex _streamMtx;
+
+    /// Notified when a stream finishes
+    std::condition_variable _streamCv;
+
+    /// Ranges not taken by a stream yet
+    std::deque<Range> _ranges;
+
+    /// The number of streams still copying
+    size_t _numActiveStreams;
+
+    /// Tells the streams to stop after their current record
+    bool _stopStreams;
+
+    /// The first error reported by a stream
+    WorkerRequest::ErrorContext _streamError;
+
+    /// The number of streams of all replication requests of the worker
+    static size_t _numWorkerStreams;
+
+    /// Protects _numWorkerStreams
+    static std::mutex _numWorkerStreamsMtx;
 };
 
 
@@ -34,6 +34,9 @@
 #include "replica/WorkerEchoRequest.h"
 #include "replica/WorkerFindAllRequest.h"
 #include "replica/WorkerFindRequest.h"
+#include "replica/WorkerIndexRequest.h"
+#include "replica/WorkerPackRequest.h"
+#include "replica/WorkerIngestRequest.h"
 #include "replica/WorkerReplicationRequest.h"
 
 namespace {
@@ -118,14 +121,16 @@ public:
                                                std::string const& id,
                                                int priority,
                                                std::string const& database,
-                                               unsigned int chunk) const final {
+                                               unsigned int chunk,
+                                               std::vector<unsigned int> const& extraChunks) const final {
         return WorkerDeleteRequest::create(
             _serviceProvider,
             worker,
             id,
             priority,
             database,
-            chunk);
+            chunk,
+            extraChunks);
     }
 
     /**
@@ -138,7 +143,8 @@ public:
                                            int priority,
                                            std::string const& database,
                                            unsigned int chunk,
-                                           bool computeCheckSum) const final {
+                                           bool computeCheckSum,
+                                           double sampleRate) const final {
         return WorkerFindRequest::create(
             _serviceProvider,
             worker,
@@ -146,7 +152,8 @@ public:
             priority,
             database,
             chunk,
-            computeCheckSum);
+            computeCheckSum,
+            sampleRate);
     }
 
     /**
@@ -184,6 +191,75 @@ public:
             data,
             delay);
     }
+
+    /**
+     * Implements the corresponding method of the base class
+     *
+     * @see WorkerReplicationRequestBase::createIngestRequest
+     */
+    WorkerIngestRequestPtr createIngestRequest(std::string const& worker,
+                                               std::string const& id,
+                                               int priority,
+                                               std::string const& database,
+                                               unsigned int chunk,
+                                               std::string const& sourceWorker,
+                                               std::vector<IngestFileInfo> const& files,
+                                               unsigned int numLoads,
+                                               bool clusterSubChunks) const final {
+        return WorkerIngestRequest::create(
+            _serviceProvider,
+            worker,
+            id,
+            priority,
+            database,
+            chunk,
+            sourceWorker,
+            files,
+            numLoads,
+            clusterSubChunks);
+    }
+
+    /**
+     * Implements the corresponding method of the base class
+     *
+     * @see WorkerReplicationRequestBase::createIndexRequest
+     */
+    WorkerIndexRequestPtr createIndexRequest(std::string const& worker,
+                                             std::string const& id,
+                                             int priority,
+                                             std::string const& database,
+                                             std::string const& table,
+                                             std::string const& keyColumn,
+                                             std::vector<unsigned int> const& chunks) const final {
+        return WorkerIndexRequest::create(
+            _serviceProvider,
+            worker,
+            id,
+            priority,
+            database,
+            table,
+            keyColumn,
+            chunks);
+    }
+
+    /**
+     * Implements the corresponding method of the base class
+     *
+     * @see WorkerReplicationRequestBase::createPackRequest
+     */
+    WorkerPackRequestPtr createPackRequest(std::string const& worker,
+                                           std::string const& id,
+                                           int priority,
+                                           std::string const& database,
+                                           unsigned int chunk) const final {
+        return WorkerPackRequest::create(
+            _serviceProvider,
+            worker,
+            id,
+            priority,
+            database,
+            chunk);
+    }
 };
 
 ////////////////////////////////////////////////////////////////////
@@ -250,14 +326,16 @@ public:
                                                std::string const& id,
                                                int priority,
                                                std::string const& database,
-                                               unsigned int chunk) const final {
+                                               unsigned int chunk,
+                                               std::vector<unsigned int> const& extraChunks) const final {
         return WorkerDeleteRequestPOSIX::create(
             _serviceProvider,
             worker,
             id,
             priority,
             database,
-            chunk);
+            chunk,
+            extraChunks);
     }
 
     /**
@@ -270,7 +348,8 @@ public:
                                            int priority,
                                            std::string const& database,
                                            unsigned int chunk,
-                                           bool computeCheckSum) const final {
+                                           bool computeCheckSum,
+                                           double sampleRate) const final {
         return WorkerFindRequestPOSIX::create(
             _serviceProvider,
             worker,
@@ -278,7 +357,8 @@ public:
             priority,
             database,
             chunk,
-            computeCheckSum);
+            computeCheckSum,
+            sampleRate);
     }
 
     /**
@@ -316,6 +396,75 @@ public:
             data,
             delay);
     }
+
+    /**
+     * Implements the corresponding method of the base class
+     *
+     * @see WorkerReplicationRequestBase::createIngestRequest
+     */
+    WorkerIngestRequestPtr createIngestRequest(std::string const& worker,
+                                               std::string const& id,
+                                               int priority,
+                                               std::string const& database,
+                                               unsigned int chunk,
+                                               std::string const& sourceWorker,
+                                               std::vector<IngestFileInfo> const& files,
+                                               unsigned int numLoads,
+                                               bool clusterSubChunks) const final {
+        return WorkerIngestRequestPOSIX::create(
+            _serviceProvider,
+            worker,
+            id,
+            priority,
+            database,
+            chunk,
+            sourceWorker,
+            files,
+            numLoads,
+            clusterSubChunks);
+    }
+
+    /**
+     * Implements the corresponding method of the base class
+     *
+     * @see WorkerReplicationRequestBase::createIndexRequest
+     */
+    WorkerIndexRequestPtr createIndexRequest(std::string const& worker,
+                                             std::string const& id,
+                                             int priority,
+                                             std::string const& database,
+                                             std::string const& table,
+                                             std::string const& keyColumn,
+                                             std::vector<unsigned int> const& chunks) const final {
+        return WorkerIndexRequestPOSIX::create(
+            _serviceProvider,
+            worker,
+            id,
+            priority,
+            database,
+            table,
+            keyColumn,
+            chunks);
+    }
+
+    /**
+     * Implements the corresponding method of the base class
+     *
+     * @see WorkerReplicationRequestBase::createPackRequest
+     */
+    WorkerPackRequestPtr createPackRequest(std::string const& worker,
+                                           std::string const& id,
+                                           int priority,
+                                           std::string const& database,
+                                           unsigned int chunk) const final {
+        return WorkerPackRequestPOSIX::create(
+            _serviceProvider,
+            worker,
+            id,
+            priority,
+            database,
+            chunk);
+    }
 };
 
 /////////////////////////////////////////////////////////////////
@@ -383,14 +532,16 @@ public:
                                                std::string const& id,
                                                int priority,
                                                std::string const& database,
-                                               unsigned int chunk) const final {
+                                               unsigned int chunk,
+                                               std::vector<unsigned int> const& extraChunks) const final {
         return WorkerDeleteRequestFS::create(
             _serviceProvider,
             worker,
             id,
             priority,
             database,
-            chunk);
+            chunk,
+            extraChunks);
     }
 
     /**
@@ -403,7 +554,8 @@ public:
                                            int priority,
                                            std::string const& database,
                                            unsigned int chunk,
-                                           bool computeCheckSum) const final {
+                                           bool computeCheckSum,
+                                           double sampleRate) const final {
         return WorkerFindRequestFS::create(
             _serviceProvider,
             worker,
@@ -411,7 +563,8 @@ public:
             priority,
             database,
             chunk,
-            computeCheckSum);
+            computeCheckSum,
+            sampleRate);
     }
 
     /**
@@ -449,6 +602,75 @@ public:
             data,
             delay);
     }
+
+    /**
+     * Implements the corresponding method of the base class
+     *
+     * @see WorkerReplicationRequestBase::createIngestRequest
+     */
+    WorkerIngestRequestPtr createIngestRequest(std::string const& worker,
+                                               std::string const& id,
+                                               int priority,
+                                               std::string const& database,
+                                               unsigned int chunk,
+                                               std::string const& sourceWorker,
+                                               std::vector<IngestFileInfo> const& files,
+                                               unsigned int numLoads,
+                                               bool clusterSubChunks) const final {
+        return WorkerIngestRequestFS::create(
+            _serviceProvider,
+            worker,
+            id,
+            priority,
+            database,
+            chunk,
+            sourceWorker,
+            files,
+            numLoads,
+            clusterSubChunks);
+    }
+
+    /**
+     * Implements the corresponding method of the base class
+     *
+     * @see WorkerReplicationRequestBase::createIndexRequest
+     */
+    WorkerIndexRequestPtr createIndexRequest(std::string const& worker,
+                                             std::string const& id,
+                                             int priority,
+                                             std::string const& database,
+                                             std::string const& table,
+                                             std::string const& keyColumn,
+                                             std::vector<unsigned int> const& chunks) const final {
+        return WorkerIndexRequestFS::create(
+            _serviceProvider,
+            worker,
+            id,
+            priority,
+            database,
+            table,
+            keyColumn,
+            chunks);
+    }
+
+    /**
+     * Implements the corresponding method of the base class
+     *
+     * @see WorkerReplicationRequestBase::createPackRequest
+     */
+    WorkerPackRequestPtr createPackRequest(std::string const& worker,
+                                           std::string const& id,
+                                           int priority,
+                                           std::string const& database,
+                                           unsigned int chunk) const final {
+        return WorkerPackRequestFS::create(
+            _serviceProvider,
+            worker,
+            id,
+            priority,
+            database,
+            chunk);
+    }
 };
 
 ///////////////////////////////////////////////////////////////
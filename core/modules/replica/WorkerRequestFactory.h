@@ -26,8 +26,10 @@
 // System headers
 #include <memory>
 #include <string>
+#include <vector>
 
 // Qserv headers
+#include "replica/Common.h"
 #include "replica/ServiceProvider.h"
 
 // This header declarations
@@ -42,6 +44,9 @@ class WorkerDeleteRequest;
 class WorkerFindRequest;
 class WorkerFindAllRequest;
 class WorkerEchoRequest;
+class WorkerIngestRequest;
+class WorkerIndexRequest;
+class WorkerPackRequest;
 
 /**
   * Class WorkerRequestFactoryBase is an abstract base class for a family of
@@ -58,6 +63,9 @@ public:
     typedef std::shared_ptr<WorkerFindRequest>        WorkerFindRequestPtr;
     typedef std::shared_ptr<WorkerFindAllRequest>     WorkerFindAllRequestPtr;
     typedef std::shared_ptr<WorkerEchoRequest>        WorkerEchoRequestPtr;
+    typedef std::shared_ptr<WorkerIngestRequest>      WorkerIngestRequestPtr;
+    typedef std::shared_ptr<WorkerIndexRequest>       WorkerIndexRequestPtr;
+    typedef std::shared_ptr<WorkerPackRequest>        WorkerPackRequestPtr;
 
     // The default constructor and copy semantics are prohibited
 
@@ -97,7 +105,8 @@ public:
             std::string const& id,
             int priority,
             std::string const& database,
-            unsigned int chunk) const = 0;
+            unsigned int chunk,
+            std::vector<unsigned int> const& extraChunks) const = 0;
 
    /**
      * Create an instance of the replica lookup request
@@ -112,7 +121,8 @@ public:
             int priority,
             std::string const& database,
             unsigned int chunk,
-            bool computeCheckSum) const = 0;
+            bool computeCheckSum,
+            double sampleRate) const = 0;
 
    /**
      * Create an instance of the replicas lookup request
@@ -140,6 +150,54 @@ public:
             int priority,
             std::string const& data,
             uint64_t delay) const = 0;
+
+    /**
+     * Create an instance of the chunk ingest request
+     *
+     * @see class WorkerIngestRequest
+     *
+     * @return a pointer to the newly created object
+     */
+    virtual WorkerIngestRequestPtr createIngestRequest(
+            std::string const& worker,
+            std::string const& id,
+            int priority,
+            std::string const& database,
+            unsigned int chunk,
+            std::string const& sourceWorker,
+            std::vector<IngestFileInfo> const& files,
+            unsigned int numLoads,
+            bool clusterSubChunks) const = 0;
+
+    /**
+     * Create an instance of the secondary index request
+     *
+     * @see class WorkerIndexRequest
+     *
+     * @return a pointer to the newly created object
+     */
+    virtual WorkerIndexRequestPtr createIndexRequest(
+            std::string const& worker,
+            std::string const& id,
+            int priority,
+            std::string const& database,
+            std::string const& table,
+            std::string const& keyColumn,
+            std::vector<unsigned int> const& chunks) const = 0;
+
+    /**
+     * Create an instance of the request packing the tables of a chunk
+     *
+     * @see class WorkerPackRequest
+     *
+     * @return a pointer to the newly created object
+     */
+    virtual WorkerPackRequestPtr createPackRequest(
+            std::string const& worker,
+            std::string const& id,
+            int priority,
+            std::string const& database,
+            unsigned int chunk) const = 0;
  
 protected:
 
@@ -230,14 +288,16 @@ public:
             std::string const& id,
             int priority,
             std::string const& database,
-            unsigned int chunk) const final {
+            unsigned int chunk,
+            std::vector<unsigned int> const& extraChunks) const final {
 
         return _ptr->createDeleteRequest(
             worker,
             id,
             priority,
             database,
-            chunk);
+            chunk,
+            extraChunks);
     }
 
    /**
@@ -249,7 +309,8 @@ public:
             int priority,
             std::string const& database,
             unsigned int chunk,
-            bool computeCheckSum) const final {
+            bool computeCheckSum,
+            double sampleRate) const final {
         
         return _ptr->createFindRequest(
             worker,
@@ -257,7 +318,8 @@ public:
             priority,
             database,
             chunk,
-            computeCheckSum);
+            computeCheckSum,
+            sampleRate);
     }
 
    /**
@@ -294,6 +356,72 @@ public:
             delay);
     }
 
+    /**
+     * @see WorkerReplicationRequestBase::createIngestRequest()
+     */
+    WorkerIngestRequestPtr createIngestRequest(
+            std::string const& worker,
+            std::string const& id,
+            int priority,
+            std::string const& database,
+            unsigned int chunk,
+            std::string const& sourceWorker,
+            std::vector<IngestFileInfo> const& files,
+            unsigned int numLoads,
+            bool clusterSubChunks) const final {
+
+        return _ptr->createIngestRequest(
+            worker,
+            id,
+            priority,
+            database,
+            chunk,
+            sourceWorker,
+            files,
+            numLoads,
+            clusterSubChunks);
+    }
+
+    /**
+     * @see WorkerReplicationRequestBase::createIndexRequest()
+     */
+    WorkerIndexRequestPtr createIndexRequest(
+            std::string const& worker,
+            std::string const& id,
+            int priority,
+            std::string const& database,
+            std::string const& table,
+            std::string const& keyColumn,
+            std::vector<unsigned int> const& chunks) const final {
+
+        return _ptr->createIndexRequest(
+            worker,
+            id,
+            priority,
+            database,
+            table,
+            keyColumn,
+            chunks);
+    }
+
+    /**
+     * @see WorkerReplicationRequestBase::createPackRequest()
+     */
+    WorkerPackRequestPtr createPackRequest(
+            std::string const& worker,
+            std::string const& id,
+            int priority,
+            std::string const& database,
+            unsigned int chunk) const final {
+
+        return _ptr->createPackRequest(
+            worker,
+            id,
+            priority,
+            database,
+            chunk);
+    }
+
 protected:
 
     /// Pointer to the final implementation of the factory
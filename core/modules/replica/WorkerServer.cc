@@ -24,6 +24,7 @@
 #include "replica/WorkerServer.h"
 
 // System headers
+#include <algorithm>
 
 // Third party headers
 #include <boost/bind.hpp>
@@ -64,12 +65,18 @@ WorkerServer::WorkerServer(ServiceProvider::Ptr const& serviceProvider,
             _io_service,
             boost::asio::ip::tcp::endpoint(
                 boost::asio::ip::tcp::v4(),
-                serviceProvider->config()->workerInfo(workerName).svcPort)) {
+                serviceProvider->config()->workerInfo(workerName).svcPort)),
+        _nextService(0) {
 
     // Set the socket reuse option to allow recycling ports after catastrophic
     // failures.
 
     _acceptor.set_option(boost::asio::socket_base::reuse_address(true));
+
+    unsigned int const numServices = std::max(1U, std::thread::hardware_concurrency());
+    for (unsigned int i = 0; i < numServices; ++i) {
+        _connectionServices.push_back(std::make_unique<boost::asio::io_service>());
+    }
 }
 
 void WorkerServer::run() {
@@ -78,6 +85,15 @@ void WorkerServer::run() {
 
     _processor->run();
 
+    // Launch the threads of the connections. The work objects prevent
+    // the services from finishing while there are no connections.
+
+    for (auto&& service: _connectionServices) {
+        _connectionWork.push_back(std::make_unique<boost::asio::io_service::work>(*service));
+        boost::asio::io_service* const ptr = service.get();
+        _connectionThreads.push_back(std::make_unique<std::thread>([ptr] () { ptr->run(); }));
+    }
+
     // Begin accepting connections before running the service to allow
     // asynchronous operations. Otherwise the service will finish right
     // away.
@@ -85,15 +101,26 @@ void WorkerServer::run() {
     beginAccept();
 
     _io_service.run();
+
+    for (auto&& t: _connectionThreads) t->join();
 }
 
 void WorkerServer::beginAccept() {
 
+    // The reports on all requests known to the processor are made by
+    // the thread of the next service, so that the connection keeps
+    // serving the other requests meanwhile.
+
+    size_t const numServices = _connectionServices.size();
+    size_t const index = _nextService;
+    _nextService = (_nextService + 1) % numServices;
+
     auto const connection =
         WorkerServerConnection::create(
             _serviceProvider,
             _processor,
-            _io_service
+            *(_connectionServices[index]),
+            *(_connectionServices[(index + 1) % numServices])
         );
         
     _acceptor.async_accept(
@@ -25,6 +25,8 @@
 
 // System headers
 #include <memory>
+#include <thread>
+#include <vector>
 
 // Third party headers
 #include <boost/asio.hpp>
@@ -47,6 +49,10 @@ class WorkerRequestFactory;
   * Class WorkerServer is used for handling incoming connections to
   * the worker replication service. Only one instance of this class is
   * allowed per a thread.
+  *
+  * The connections are accepted in the thread calling run(), and they're
+  * spread in a round-robin order over a pool of I/O services, one per core,
+  * each run by its own thread.
   */
 class WorkerServer
     : public std::enable_shared_from_this<WorkerServer>  {
@@ -90,7 +96,8 @@ public:
     WorkerProcessor::Ptr const& processor() const { return _processor; }
 
     /**
-     * Begin listening for and processing incoming connections
+     * Begin listening for and processing incoming connections. The method
+     * never returns.
      */
     void run();
 
@@ -139,6 +146,18 @@ private:
 
     boost::asio::io_service        _io_service;
     boost::asio::ip::tcp::acceptor _acceptor;
+
+    /// The I/O services of the connections, one per core
+    std::vector<std::unique_ptr<boost::asio::io_service>> _connectionServices;
+
+    /// Keep the I/O services of the connections running when they have no work
+    std::vector<std::unique_ptr<boost::asio::io_service::work>> _connectionWork;
+
+    /// The threads running the I/O services of the connections
+    std::vector<std::unique_ptr<std::thread>> _connectionThreads;
+
+    /// The index of the I/O service for the next connection
+    size_t _nextService;
 };
 
 }}} // namespace lsst::qserv::replica
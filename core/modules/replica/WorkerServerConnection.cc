@@ -24,12 +24,16 @@
 #include "replica/WorkerServerConnection.h"
 
 // System headers
+#include <algorithm>
+#include <fstream>
 
 // Third party headers
 #include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
 
 // Qserv headers
 #include "lsst/log/Log.h"
+#include "replica/BandwidthLimiter.h"
 #include "replica/Configuration.h"
 #include "replica/Performance.h"
 #include "replica/ServiceProvider.h"
@@ -99,6 +103,14 @@ bool readMessage(boost::asio::ip::tcp::socket& socket,
     return true;
 }
 
+/// @return the 1-minute load average of the host, 0 if it's not known
+double loadAverage() {
+    std::ifstream file("/proc/loadavg");
+    double load1min = 0;
+    if (not (file >> load1min)) return 0;
+    return load1min;
+}
+
 bool readLength(boost::asio::ip::tcp::socket& socket,
                 ProtocolBufferPtr const& ptr,
                 uint32_t& bytes) {
@@ -120,22 +132,37 @@ namespace replica {
 WorkerServerConnection::Ptr WorkerServerConnection::create(
                                     ServiceProvider::Ptr const& serviceProvider,
                                     WorkerProcessor::Ptr const& processor,
-                                    boost::asio::io_service& io_service) {
+                                    boost::asio::io_service& io_service,
+                                    boost::asio::io_service& reportService) {
     return WorkerServerConnection::Ptr(
         new WorkerServerConnection(
             serviceProvider,
             processor,
-            io_service));
+            io_service,
+            reportService));
 }
 
 WorkerServerConnection::WorkerServerConnection(ServiceProvider::Ptr const& serviceProvider,
                                                WorkerProcessor::Ptr const& processor,
-                                               boost::asio::io_service& io_service)
+                                               boost::asio::io_service& io_service,
+                                               boost::asio::io_service& reportService)
     :   _serviceProvider(serviceProvider),
         _processor(processor),
+        _io_service(io_service),
+        _reportService(reportService),
         _socket(io_service),
         _bufferPtr(std::make_shared<ProtocolBuffer>(
-                       serviceProvider->config()->requestBufferSizeBytes())) {
+                       serviceProvider->config()->requestBufferSizeBytes())),
+        _replyBufferPtr(std::make_shared<ProtocolBuffer>(
+                       serviceProvider->config()->requestBufferSizeBytes())),
+        _sendBufferPtr(std::make_shared<ProtocolBuffer>(
+                       serviceProvider->config()->requestBufferSizeBytes())),
+        _sending(false),
+        _receivePaused(false),
+        _closed(false),
+        _heartbeatIntervalMs(0),
+        _heartbeatPending(false),
+        _heartbeatTimer(io_service) {
 }
 
 void WorkerServerConnection::beginProtocol() {
@@ -146,6 +173,18 @@ void WorkerServerConnection::receive() {
 
     LOGS(_log, LOG_LVL_DEBUG, context << "receive");
 
+    if (_closed) return;
+
+    // Stop reading requests while the replies waiting to be sent exceed
+    // the capacity of the buffer. Reading resumes once the write in progress
+    // has finished (see method sent()).
+
+    if (_sending and
+        (_replyBufferPtr->size() >= _serviceProvider->config()->requestBufferSizeBytes())) {
+        _receivePaused = true;
+        return;
+    }
+
     // Start with receiving the fixed length frame carrying
     // the size (in bytes) the length of the subsequent message.
     //
@@ -179,12 +218,17 @@ void WorkerServerConnection::received(boost::system::error_code const& ec,
 
     LOGS(_log, LOG_LVL_DEBUG, context << "received");
 
-    if (::isErrorCode(ec, "received")) return;
+    if (::isErrorCode(ec, "received")) {
+        close();
+        return;
+    }
 
     // Now read the request header
     proto::ReplicationRequestHeader hdr;
-    if (not ::readMessage(_socket, _bufferPtr, _bufferPtr->parseLength(), hdr)) return;
-
+    if (not ::readMessage(_socket, _bufferPtr, _bufferPtr->parseLength(), hdr)) {
+        close();
+        return;
+    }
 
     // Analyze the header of the request. Note that the header message categorizes
     // requests in two layers:
@@ -192,24 +236,33 @@ void WorkerServerConnection::received(boost::system::error_code const& ec,
     // - then  goes a choice of a specific request within its class. Those specific
     //   request codes are obtained from the corresponding members
 
+    bool processed = false;
     switch (hdr.type()) {
 
-        case proto::ReplicationRequestHeader::REPLICA: processReplicaRequest(   hdr); break;
-        case proto::ReplicationRequestHeader::REQUEST: processManagementRequest(hdr); break;
-        case proto::ReplicationRequestHeader::SERVICE: processServiceRequest(   hdr); break;
+        case proto::ReplicationRequestHeader::REPLICA: processed = processReplicaRequest(   hdr); break;
+        case proto::ReplicationRequestHeader::REQUEST: processed = processManagementRequest(hdr); break;
+        case proto::ReplicationRequestHeader::SERVICE: processed = processServiceRequest(   hdr); break;
 
         default:
             throw std::logic_error(
                   "WorkerServerConnection::received() unhandled request class: '" +
                   proto::ReplicationRequestHeader::RequestType_Name(hdr.type()));
     }
+    if (not processed) {
+        close();
+        return;
+    }
+
+    // Go read the next request while the replies are being sent
+
+    receive();
 }
 
-void WorkerServerConnection::processReplicaRequest(proto::ReplicationRequestHeader& hdr) {
+bool WorkerServerConnection::processReplicaRequest(proto::ReplicationRequestHeader& hdr) {
 
     // Read the request length
     uint32_t bytes;
-    if (not ::readLength(_socket, _bufferPtr, bytes)) return;
+    if (not ::readLength(_socket, _bufferPtr, bytes)) return false;
 
     switch (hdr.replica_type()) {
 
@@ -217,7 +270,7 @@ void WorkerServerConnection::processReplicaRequest(proto::ReplicationRequestHead
 
             // Read the request body
             proto::ReplicationRequestReplicate request;
-            if (not ::readMessage(_socket, _bufferPtr, bytes, request)) return;
+            if (not ::readMessage(_socket, _bufferPtr, bytes, request)) return false;
 
             proto::ReplicationResponseReplicate response;
             _processor->enqueueForReplication(hdr.id(), request, response);
@@ -228,7 +281,7 @@ void WorkerServerConnection::processReplicaRequest(proto::ReplicationRequestHead
 
             // Read the request body
             proto::ReplicationRequestDelete request;
-            if (not ::readMessage(_socket, _bufferPtr, bytes, request)) return;
+            if (not ::readMessage(_socket, _bufferPtr, bytes, request)) return false;
 
             proto::ReplicationResponseDelete response;
             _processor->enqueueForDeletion(hdr.id(), request, response);
@@ -239,7 +292,7 @@ void WorkerServerConnection::processReplicaRequest(proto::ReplicationRequestHead
 
             // Read the request body
             proto::ReplicationRequestFind request;
-            if (not ::readMessage(_socket, _bufferPtr, bytes, request)) return;
+            if (not ::readMessage(_socket, _bufferPtr, bytes, request)) return false;
 
             proto::ReplicationResponseFind response;
             _processor->enqueueForFind(hdr.id(), request, response);
@@ -250,7 +303,7 @@ void WorkerServerConnection::processReplicaRequest(proto::ReplicationRequestHead
 
             // Read the request body
             proto::ReplicationRequestFindAll request;
-            if (not ::readMessage(_socket, _bufferPtr, bytes, request)) return;
+            if (not ::readMessage(_socket, _bufferPtr, bytes, request)) return false;
 
             proto::ReplicationResponseFindAll response;
             _processor->enqueueForFindAll(hdr.id(), request, response);
@@ -261,36 +314,67 @@ void WorkerServerConnection::processReplicaRequest(proto::ReplicationRequestHead
 
             // Read the request body
             proto::ReplicationRequestEcho request;
-            if (not ::readMessage(_socket, _bufferPtr, bytes, request)) return;
+            if (not ::readMessage(_socket, _bufferPtr, bytes, request)) return false;
 
             proto::ReplicationResponseEcho response;
             _processor->enqueueForEcho(hdr.id(), request, response);
             reply(hdr.id(), response);
             break;
         }
+        case proto::ReplicationReplicaRequestType::REPLICA_INGEST: {
+
+            // Read the request body
+            proto::ReplicationRequestIngest request;
+            if (not ::readMessage(_socket, _bufferPtr, bytes, request)) return false;
+
+            proto::ReplicationResponseIngest response;
+            _processor->enqueueForIngest(hdr.id(), request, response);
+            reply(hdr.id(), response);
+            break;
+        }
+        case proto::ReplicationReplicaRequestType::REPLICA_INDEX: {
+
+            // Read the request body
+            proto::ReplicationRequestIndex request;
+            if (not ::readMessage(_socket, _bufferPtr, bytes, request)) return false;
+
+            proto::ReplicationResponseIndex response;
+            _processor->enqueueForIndex(hdr.id(), request, response);
+            reply(hdr.id(), response);
+            break;
+        }
+        case proto::ReplicationReplicaRequestType::REPLICA_PACK: {
+
+            // Read the request body
+            proto::ReplicationRequestPack request;
+            if (not ::readMessage(_socket, _bufferPtr, bytes, request)) return false;
+
+            proto::ReplicationResponsePack response;
+            _processor->enqueueForPack(hdr.id(), request, response);
+            reply(hdr.id(), response);
+            break;
+        }
         default:
             throw std::logic_error(
                   "WorkerServerConnection::processReplicaRequest() unhandled request type: '" +
                   proto::ReplicationReplicaRequestType_Name(hdr.replica_type()));
     }
+    return true;
 }
 
-void WorkerServerConnection::processManagementRequest(proto::ReplicationRequestHeader& hdr) {
+bool WorkerServerConnection::processManagementRequest(proto::ReplicationRequestHeader& hdr) {
 
     // Read the request length
     uint32_t bytes;
-    if (not ::readLength(_socket,
-                         _bufferPtr,
-                         bytes)) {
-        return;
-    }
+    if (not ::readLength(_socket, _bufferPtr, bytes)) return false;
+
     switch (hdr.management_type()) {
 
         case proto::ReplicationManagementRequestType::REQUEST_STOP: {
 
             // Read the request body
             proto::ReplicationRequestStop request;
-            if (not ::readMessage(_socket, _bufferPtr, bytes, request)) return;
+            if (not ::readMessage(_socket, _bufferPtr, bytes, request)) return false;
 
             switch (request.replica_type()) {
 
@@ -324,6 +408,24 @@ void WorkerServerConnection::processManagementRequest(proto::ReplicationRequestH
                     reply(hdr.id(), response);
                     break;
                 }
+                case proto::ReplicationReplicaRequestType::REPLICA_INGEST: {
+                    proto::ReplicationResponseIngest response;
+                    _processor->dequeueOrCancel(hdr.id(), request, response);
+                    reply(hdr.id(), response);
+                    break;
+                }
+                case proto::ReplicationReplicaRequestType::REPLICA_INDEX: {
+                    proto::ReplicationResponseIndex response;
+                    _processor->dequeueOrCancel(hdr.id(), request, response);
+                    reply(hdr.id(), response);
+                    break;
+                }
+                case proto::ReplicationReplicaRequestType::REPLICA_PACK: {
+                    proto::ReplicationResponsePack response;
+                    _processor->dequeueOrCancel(hdr.id(), request, response);
+                    reply(hdr.id(), response);
+                    break;
+                }
                 default:
                     throw std::logic_error(
                         "WorkerServerConnection::processManagementRequest() unhandled request type: '" +
@@ -335,7 +437,7 @@ void WorkerServerConnection::processManagementRequest(proto::ReplicationRequestH
 
             // Read the request body
             proto::ReplicationRequestStatus request;
-            if (not ::readMessage(_socket, _bufferPtr, bytes, request)) return;
+            if (not ::readMessage(_socket, _bufferPtr, bytes, request)) return false;
 
             switch (request.replica_type()) {
 
@@ -369,6 +471,24 @@ void WorkerServerConnection::processManagementRequest(proto::ReplicationRequestH
                     reply(hdr.id(), response);
                     break;
                 }
+                case proto::ReplicationReplicaRequestType::REPLICA_INGEST: {
+                    proto::ReplicationResponseIngest response;
+                    _processor->checkStatus(hdr.id(), request, response);
+                    reply(hdr.id(), response);
+                    break;
+                }
+                case proto::ReplicationReplicaRequestType::REPLICA_INDEX: {
+                    proto::ReplicationResponseIndex response;
+                    _processor->checkStatus(hdr.id(), request, response);
+                    reply(hdr.id(), response);
+                    break;
+                }
+                case proto::ReplicationReplicaRequestType::REPLICA_PACK: {
+                    proto::ReplicationResponsePack response;
+                    _processor->checkStatus(hdr.id(), request, response);
+                    reply(hdr.id(), response);
+                    break;
+                }
                 default:
                     throw std::logic_error(
                         "WorkerServerConnection::processManagementRequest() unhandled request type: '" +
@@ -381,9 +501,10 @@ void WorkerServerConnection::processManagementRequest(proto::ReplicationRequestH
                   "WorkerServerConnection::processManagementRequest() unhandled request type: '" +
                   proto::ReplicationManagementRequestType_Name(hdr.management_type()));
     }
+    return true;
 }
 
-void WorkerServerConnection::processServiceRequest(proto::ReplicationRequestHeader& hdr) {
+bool WorkerServerConnection::processServiceRequest(proto::ReplicationRequestHeader& hdr) {
 
     proto::ReplicationServiceResponse response;
 
@@ -441,30 +562,62 @@ void WorkerServerConnection::processServiceRequest(proto::ReplicationRequestHead
         }
         case proto::ReplicationServiceRequestType::SERVICE_REQUESTS: {
 
-            const bool extendedReport = true;   // to return detailed info on all known
-                                                // replica-related requests
+            // The detailed info on all known replica-related requests may take
+            // a while to collect. It's done off the I/O thread of the connection
+            // while the next requests are served.
+
+            replyLater(hdr.id(), response, false /* drain */);
+            break;
+        }
+        case proto::ReplicationServiceRequestType::SERVICE_DRAIN: {
+            replyLater(hdr.id(), response, true /* drain */);
+            break;
+        }
+        case proto::ReplicationServiceRequestType::SERVICE_THROTTLE: {
+
+            // Read the request body
+            uint32_t bytes;
+            if (not ::readLength(_socket, _bufferPtr, bytes)) return false;
+
+            proto::ReplicationServiceThrottleRequest request;
+            if (not ::readMessage(_socket, _bufferPtr, bytes, request)) return false;
+
+            // The limit is shared by all connections of the worker's file server
+            // and it takes effect on the next record sent by each of them.
+
+            BandwidthLimiter::instance(_processor->worker())->setRate(request.max_rate_bytes_per_sec());
             _processor->setServiceResponse(
                   response,
                   hdr.id(),
-                  proto::ReplicationServiceResponse::SUCCESS,
-                  extendedReport);
+                  proto::ReplicationServiceResponse::SUCCESS);
 
             reply(hdr.id(), response);
             break;
         }
-        case proto::ReplicationServiceRequestType::SERVICE_DRAIN: {
+        case proto::ReplicationServiceRequestType::SERVICE_HEARTBEAT: {
+
+            // Read the request body
+            uint32_t bytes;
+            if (not ::readLength(_socket, _bufferPtr, bytes)) return false;
+
+            proto::ReplicationServiceHeartbeatRequest request;
+            if (not ::readMessage(_socket, _bufferPtr, bytes, request)) return false;
+
+            // The first heartbeat is sent right away. The next ones follow
+            // at the requested interval after each heartbeat is sent (see
+            // method sent()).
 
-            _processor->drain();
+            _heartbeatId         = hdr.id();
+            _heartbeatIntervalMs = std::max(request.interval_ms(), 1U);
 
-            const bool extendedReport = true;   // to return detailed info on all known
-                                                // replica-related requests
             _processor->setServiceResponse(
                   response,
                   hdr.id(),
-                  proto::ReplicationServiceResponse::SUCCESS,
-                  extendedReport);
+                  proto::ReplicationServiceResponse::SUCCESS);
+            response.set_load_average(::loadAverage());
 
             reply(hdr.id(), response);
+            _heartbeatPending = true;
             break;
         }
         default:
@@ -472,17 +625,51 @@ void WorkerServerConnection::processServiceRequest(proto::ReplicationRequestHead
                   "WorkerServerConnection::processServiceRequest() unhandled request type: '" +
                   proto::ReplicationServiceRequestType_Name(hdr.service_type()));
     }
+    return true;
+}
+
+void WorkerServerConnection::replyLater(std::string const& id,
+                                        proto::ReplicationServiceResponse const& response,
+                                        bool drain) {
+
+    auto const self = shared_from_this();
+    _reportService.post([self, id, response = response, drain] () mutable {
+
+        if (drain) self->_processor->drain();
+
+        bool const extendedReport = true;   // to return detailed info on all known
+                                            // replica-related requests
+        self->_processor->setServiceResponse(
+              response,
+              id,
+              proto::ReplicationServiceResponse::SUCCESS,
+              extendedReport);
+
+        // The reply is sent from the I/O thread of the connection
+
+        self->_io_service.post([self, id, response] () {
+            if (not self->_closed) self->reply(id, response);
+        });
+    });
 }
 
 void WorkerServerConnection::send() {
 
     LOGS(_log, LOG_LVL_DEBUG, context << "send");
 
+    if (_closed or _sending or (_replyBufferPtr->size() == 0)) return;
+
+    // The replies accumulated so far go out with a single write. The ones
+    // made while it's in progress are collected in the other buffer.
+
+    std::swap(_replyBufferPtr, _sendBufferPtr);
+    _sending = true;
+
     boost::asio::async_write(
         _socket,
         boost::asio::buffer(
-            _bufferPtr->data(),
-            _bufferPtr->size()
+            _sendBufferPtr->data(),
+            _sendBufferPtr->size()
         ),
         boost::bind(
             &WorkerServerConnection::sent,
@@ -498,11 +685,82 @@ void WorkerServerConnection::sent(boost::system::error_code const& ec,
 
     LOGS(_log, LOG_LVL_DEBUG, context << "sent");
 
-    if (::isErrorCode(ec, "sent")) return;
+    _sending = false;
 
-    // Go wait for another request
+    if (::isErrorCode(ec, "sent")) {
+        close();
+        return;
+    }
+    _sendBufferPtr->resize();
 
-    receive();
+    // Send the replies made in the meantime (if any), and resume reading
+    // requests and sending heartbeats if either was held back
+
+    send();
+    if (_receivePaused) {
+        _receivePaused = false;
+        receive();
+    }
+    if (_heartbeatPending) {
+        _heartbeatPending = false;
+        waitHeartbeat();
+    }
+}
+
+void WorkerServerConnection::close() {
+
+    if (_closed) return;
+    _closed = true;
+
+    boost::system::error_code ec;
+    _heartbeatTimer.cancel(ec);
+    _socket.close(ec);
+}
+
+void WorkerServerConnection::waitHeartbeat() {
+
+    _heartbeatTimer.expires_from_now(boost::posix_time::milliseconds(_heartbeatIntervalMs));
+    _heartbeatTimer.async_wait(
+        boost::bind(
+            &WorkerServerConnection::heartbeat,
+            shared_from_this(),
+            boost::asio::placeholders::error
+        )
+    );
+}
+
+void WorkerServerConnection::heartbeat(boost::system::error_code const& ec) {
+
+    LOGS(_log, LOG_LVL_DEBUG, context << "heartbeat");
+
+    // The timer gets cancelled when the client subscribes again,
+    // or when the connection is closed
+
+    if (ec == boost::asio::error::operation_aborted) return;
+    if (::isErrorCode(ec, "heartbeat") or _closed) return;
+
+    proto::ReplicationServiceResponse response;
+
+    WorkerPerformance performance;
+    performance.setUpdateStart();
+    performance.setUpdateFinish();
+    response.set_allocated_performance(performance.info());
+
+    _processor->setServiceResponse(
+          response,
+          _heartbeatId,
+          proto::ReplicationServiceResponse::SUCCESS);
+    response.set_load_average(::loadAverage());
+
+    // A client which disconnected is detected when the heartbeat
+    // can't be written, and the connection is then closed.
+
+    reply(_heartbeatId, response);
+
+    // The next heartbeat is scheduled after this one is written (see method
+    // sent()), so that they don't pile up for a slow client
+
+    _heartbeatPending = true;
 }
 
 }}} // namespace lsst::qserv::replica
@@ -25,6 +25,7 @@
 
 // System headers
 #include <memory>
+#include <string>
 
 // Third party headers
 #include <boost/asio.hpp>
@@ -53,6 +54,16 @@ namespace replica {
   * to an instance of the WorkerProcessor class. A response resieved from
   * the processor is serialized and sent back (asynchronously) to
   * the client.
+  *
+  * A client may send many requests without waiting for the replies. The requests
+  * are read while the replies to the previous ones are being written, and
+  * the replies are sent in the order in which they're made. That's not always
+  * the order of the requests, since the reports on all requests known to
+  * the processor are made off the I/O thread of the connection. The clients
+  * match the replies to the requests by their identifiers.
+  *
+  * All handlers of a connection are called by the one thread running
+  * the I/O service of the connection.
   */
 class WorkerServerConnection
     :   public std::enable_shared_from_this<WorkerServerConnection> {
@@ -69,13 +80,16 @@ public:
      *
      * @param serviceProvider - provider of various services
      * @param processor       - processor of long (queued) requests
-     * @param io_service      - endpoint for network I/O
+     * @param io_service      - endpoint for network I/O (run by one thread)
+     * @param reportService   - the service for making the reports which may take
+     *                          a while, run by another thread
      *
      * @return pointer to the new object created by the factory
      */
     static Ptr create(ServiceProvider::Ptr const& serviceProvider,
                       WorkerProcessor::Ptr const& processor,
-                      boost::asio::io_service& io_service);
+                      boost::asio::io_service& io_service,
+                      boost::asio::io_service& reportService);
 
     // Default construction and copy semantics are prohibited
 
@@ -95,8 +109,13 @@ public:
      *   - ASYNC: read a frame header of a request
      *   -  SYNC: read the request header (request type, etc.)
      *   -  SYNC: read the request body (depends on a type of the request) 
-     *   - ASYNC: write a frame header of a reply to the request
-     *            then write the reply itself
+     *   - add the reply to the ones waiting to be sent, and go read
+     *     the next request
+     *
+     * The replies waiting to be sent are written (asynchronously) with
+     * a single write whenever no other write is in progress. Reading
+     * the requests is paused while the replies which haven't been sent
+     * exceed the capacity of the buffer.
      *
      * NOTES: A reason why the read phase is split into four steps is
      *        that a client is expected to send all components of the request
@@ -123,7 +142,8 @@ private:
      */
     WorkerServerConnection(ServiceProvider::Ptr const& serviceProvider,
                            WorkerProcessor::Ptr const& processor,
-                           boost::asio::io_service& io_service);
+                           boost::asio::io_service& io_service,
+                           boost::asio::io_service& reportService);
 
     /**
      * Begin reading (asynchronously) the frame header of a new request
@@ -146,22 +166,28 @@ private:
      * Process replication requests (REPLICATE, DELETE, FIND, FIND-ALL)
      *
      * @param hdr - request header to be inspected
+     *
+     * @return 'false' if the request couldn't be read from the client
      */
-    void processReplicaRequest(proto::ReplicationRequestHeader& hdr);
+    bool processReplicaRequest(proto::ReplicationRequestHeader& hdr);
 
     /**
      * Process requests about replication requests (STOP, STATUS)
      *
      * @param hdr - request header to be inspected
+     *
+     * @return 'false' if the request couldn't be read from the client
      */
-    void processManagementRequest(proto::ReplicationRequestHeader& hdr);
+    bool processManagementRequest(proto::ReplicationRequestHeader& hdr);
 
     /**
      * Process requests affecting the service
      *
      * @param hdr - request header to be inspected
+     *
+     * @return 'false' if the request couldn't be read from the client
      */
-    void processServiceRequest(proto::ReplicationRequestHeader& hdr);
+    bool processServiceRequest(proto::ReplicationRequestHeader& hdr);
 
     /**
      * Serialize an identifier of a request into response header
@@ -175,19 +201,32 @@ private:
     void reply(std::string const& id,
                T&& body) {
 
-        _bufferPtr->resize();
-
         proto::ReplicationResponseHeader hdr;
         hdr.set_id(id);
 
-        _bufferPtr->serialize(hdr);
-        _bufferPtr->serialize(body);
+        _replyBufferPtr->serialize(hdr);
+        _replyBufferPtr->serialize(body);
 
         send();
     }
 
     /**
-     * Begin sending (asynchronously) a result back to a client
+     * Make the report on all requests known to the processor in the thread
+     * of the report service, and send it from the I/O thread of the connection
+     * when it's ready.
+     *
+     * @param id       - a unique identifier of a request to which the reply is sent
+     * @param response - the response to be completed with the report
+     * @param drain    - cancel all requests of the processor before making the report
+     */
+    void replyLater(std::string const& id,
+                    proto::ReplicationServiceResponse const& response,
+                    bool drain);
+
+    /**
+     * Begin sending (asynchronously) the accumulated replies back to a client,
+     * unless another write is already in progress. The replies made while
+     * it's in progress are sent when it finishes.
      */
     void send();
 
@@ -200,6 +239,20 @@ private:
     void sent(boost::system::error_code const& ec,
               size_t bytes_transferred);
 
+    /// Close the socket and stop the heartbeats
+    void close();
+
+    /// Wait for the next heartbeat to be sent
+    void waitHeartbeat();
+
+    /**
+     * The callback on the expiration of the heartbeat timer. It sends
+     * the status of the service to the client.
+     *
+     * @param ec - error condition to be checked for
+     */
+    void heartbeat(boost::system::error_code const& ec);
+
 private:
 
     ServiceProvider::Ptr const _serviceProvider;
@@ -208,11 +261,42 @@ private:
     /// get processed.
     WorkerProcessor::Ptr _processor;
 
+    boost::asio::io_service& _io_service;
+    boost::asio::io_service& _reportService;
+
     boost::asio::ip::tcp::socket _socket;
 
     /// Buffer management class facilitating serialization/de-serialization
     /// of data sent over the network
     std::shared_ptr<ProtocolBuffer> _bufferPtr;
+
+    /// The buffer for the replies waiting to be sent to a client
+    std::shared_ptr<ProtocolBuffer> _replyBufferPtr;
+
+    /// The buffer for the replies being sent
+    std::shared_ptr<ProtocolBuffer> _sendBufferPtr;
+
+    /// 'true' while a write is in progress
+    bool _sending;
+
+    /// 'true' if reading the requests was paused by too many replies
+    /// waiting to be sent
+    bool _receivePaused;
+
+    /// 'true' once the connection is closed
+    bool _closed;
+
+    /// The identifier of the heartbeat subscription (if any)
+    std::string _heartbeatId;
+
+    /// The interval (milliseconds) between heartbeats, 0 if not subscribed
+    unsigned int _heartbeatIntervalMs;
+
+    /// 'true' if the next heartbeat is to be scheduled after the write in progress
+    bool _heartbeatPending;
+
+    /// The timer for sending heartbeats
+    boost::asio::deadline_timer _heartbeatTimer;
 };
 
 }}} // namespace lsst::qserv::replica
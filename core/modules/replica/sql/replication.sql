@@ -371,6 +371,15 @@ CREATE TABLE IF NOT EXISTS `replica_file` (
   `begin_create_time`  BIGINT UNSIGNED NOT NULL ,
   `end_create_time`    BIGINT UNSIGNED NOT NULL ,
 
+  `cs_algorithm`  VARCHAR(32)  NOT NULL DEFAULT '' ,   -- empty for the sum of bytes
+
+  -- The size and the control sum of files of packed (read-only) tables before
+  -- they were packed. These are reported by the packing requests only.
+
+  `packed`         BOOLEAN         NOT NULL DEFAULT 0 ,
+  `unpacked_size`  BIGINT UNSIGNED NOT NULL DEFAULT 0 ,
+  `unpacked_cs`    VARCHAR(255)    NOT NULL DEFAULT '' ,
+
   PRIMARY  KEY (`replica_id`,`name`) ,
 
   CONSTRAINT `replica_file_fk_1`
@@ -382,6 +391,87 @@ CREATE TABLE IF NOT EXISTS `replica_file` (
 ENGINE = InnoDB;
 
 
+-- -----------------------------------------------------
+-- Table `chunk_stats`
+-- -----------------------------------------------------
+--
+-- The sizes of the tables of the chunks at the Qserv workers, and the
+-- completion times of the tasks which scanned them there. The rows are
+-- only changed, along with the time of the change, when the values
+-- reported by the workers differ from the ones stored.
+--
+DROP TABLE IF EXISTS `chunk_stats` ;
+
+CREATE TABLE IF NOT EXISTS `chunk_stats` (
+
+  `worker`   VARCHAR(255) NOT NULL ,
+  `database` VARCHAR(255) NOT NULL ,
+  `table`    VARCHAR(255) NOT NULL ,
+  `chunk`    INT UNSIGNED NOT NULL ,
+
+  `num_rows`    BIGINT UNSIGNED NOT NULL DEFAULT 0 ,
+  `data_size`   BIGINT UNSIGNED NOT NULL DEFAULT 0 ,
+  `index_size`  BIGINT UNSIGNED NOT NULL DEFAULT 0 ,
+  `update_time` BIGINT UNSIGNED NOT NULL DEFAULT 0 ,   -- seconds, 0 if not known
+
+  `tasks_completed`   BIGINT UNSIGNED NOT NULL DEFAULT 0 ,
+  `avg_scan_seconds`  DOUBLE          NOT NULL DEFAULT 0 ,
+  `last_scan_seconds` DOUBLE          NOT NULL DEFAULT 0 ,
+
+  `collect_time` BIGINT UNSIGNED NOT NULL ,            -- milliseconds
+
+  PRIMARY KEY (`worker`,`database`,`table`,`chunk`) ,
+  KEY         (`database`,`table`,`chunk`) ,
+  KEY         (`collect_time`) ,
+
+  CONSTRAINT `chunk_stats_fk_1`
+    FOREIGN KEY (`worker` )
+    REFERENCES `config_worker` (`name` )
+    ON DELETE CASCADE
+    ON UPDATE CASCADE ,
+
+  CONSTRAINT `chunk_stats_fk_2`
+    FOREIGN KEY (`database` )
+    REFERENCES `config_database` (`database` )
+    ON DELETE CASCADE
+    ON UPDATE CASCADE
+)
+ENGINE = InnoDB;
+
+
+-- -----------------------------------------------------
+-- Table `chunk_stats_worker`
+-- -----------------------------------------------------
+--
+-- The start times of the last collections of the statistics of the
+-- databases from the workers. The next collection only asks a worker
+-- for the sizes of the tables modified since then.
+--
+DROP TABLE IF EXISTS `chunk_stats_worker` ;
+
+CREATE TABLE IF NOT EXISTS `chunk_stats_worker` (
+
+  `worker`   VARCHAR(255) NOT NULL ,
+  `database` VARCHAR(255) NOT NULL ,
+
+  `collect_time` BIGINT UNSIGNED NOT NULL ,            -- milliseconds
+
+  PRIMARY KEY (`worker`,`database`) ,
+
+  CONSTRAINT `chunk_stats_worker_fk_1`
+    FOREIGN KEY (`worker` )
+    REFERENCES `config_worker` (`name` )
+    ON DELETE CASCADE
+    ON UPDATE CASCADE ,
+
+  CONSTRAINT `chunk_stats_worker_fk_2`
+    FOREIGN KEY (`database` )
+    REFERENCES `config_database` (`database` )
+    ON DELETE CASCADE
+    ON UPDATE CASCADE
+)
+ENGINE = InnoDB;
+
 SET SQL_MODE=@OLD_SQL_MODE ;
 SET FOREIGN_KEY_CHECKS=@OLD_FOREIGN_KEY_CHECKS ;
 SET UNIQUE_CHECKS=@OLD_UNIQUE_CHECKS ;
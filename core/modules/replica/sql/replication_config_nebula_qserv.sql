@@ -55,6 +55,12 @@ INSERT INTO `config` VALUES ('worker', 'fs_port',                    '25001');
 INSERT INTO `config` VALUES ('worker', 'num_svc_processing_threads', '10');
 INSERT INTO `config` VALUES ('worker', 'num_fs_processing_threads',  '16');
 INSERT INTO `config` VALUES ('worker', 'fs_buf_size_bytes',          '1048576');
+INSERT INTO `config` VALUES ('worker', 'fs_max_streams',             '4');
+INSERT INTO `config` VALUES ('worker', 'fs_io_depth',                '4');
+INSERT INTO `config` VALUES ('worker', 'fs_max_rate_bytes_per_sec',  '0');
+INSERT INTO `config` VALUES ('worker', 'fs_compression_level',       '0');
+INSERT INTO `config` VALUES ('worker', 'num_ingest_loads',           '4');
+INSERT INTO `config` VALUES ('worker', 'ingest_db',                  'mysql://qsmaster@localhost:3306/qservw_worker');
 INSERT INTO `config` VALUES ('worker', 'data_dir',                   '/qserv/data/mysql');
 
 -- Preload parameters for runnig all services on the same host
@@ -0,0 +1,173 @@
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+ /**
+  * @brief test AsyncFileIO
+  */
+
+// System headers
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// Third-party headers
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "replica/AsyncFileIO.h"
+#include "replica/FileUtils.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE AsyncFileIO
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+using namespace lsst::qserv::replica;
+
+namespace {
+
+/// A temporary file which is removed at the end of a test
+struct TmpFile {
+
+    TmpFile() {
+        char name[] = "/tmp/testAsyncFileIO.XXXXXX";
+        fd = ::mkstemp(name);
+        BOOST_REQUIRE(fd >= 0);
+        fileName = name;
+    }
+
+    ~TmpFile() {
+        ::close(fd);
+        ::unlink(fileName.c_str());
+    }
+
+    int fd;
+    std::string fileName;
+};
+
+/// @return the content of a file of the specified size
+std::vector<uint8_t> content(size_t size) {
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; ++i) data[i] = static_cast<uint8_t>(i * 7 + i / 251);
+    return data;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(AsyncFileIOWriteRead) {
+
+    LOGS_INFO("AsyncFileIO write and read test begins");
+
+    for (size_t depth: {1, 4}) {
+
+        TmpFile file;
+        size_t const bufSize = 8192;
+        std::vector<uint8_t> const data = content(depth * bufSize);
+
+        // Write the buffers at once, in the reverse order of the offsets
+        AsyncFileIO io(depth, bufSize);
+        BOOST_CHECK_EQUAL(io.depth(), depth);
+        BOOST_CHECK_EQUAL(io.bufferSize(), bufSize);
+        if (depth == 1) BOOST_CHECK(not io.usesUring());
+        for (size_t buf = 0; buf < depth; ++buf) {
+            size_t const offset = (depth - 1 - buf) * bufSize;
+            std::memcpy(io.buffer(buf), data.data() + offset, bufSize);
+            io.write(buf, file.fd, offset, bufSize);
+        }
+        BOOST_CHECK_EQUAL(io.inFlight(), depth);
+        std::vector<bool> completed(depth, false);
+        while (io.inFlight() != 0) {
+            AsyncFileIO::Completion const c = io.wait();
+            BOOST_REQUIRE(c.buf < depth);
+            BOOST_CHECK_EQUAL(c.result, static_cast<ssize_t>(bufSize));
+            completed[c.buf] = true;
+        }
+        for (size_t buf = 0; buf < depth; ++buf) BOOST_CHECK(completed[buf]);
+        BOOST_CHECK_THROW(io.wait(), std::logic_error);
+
+        // Read the halves of the buffers back, past the end of the file for the last one
+        for (size_t buf = 0; buf < depth; ++buf) {
+            std::memset(io.buffer(buf), 0, bufSize);
+            io.read(buf, file.fd, buf * bufSize + bufSize / 2, bufSize / 2, bufSize / 2);
+        }
+        while (io.inFlight() != 0) {
+            AsyncFileIO::Completion const c = io.wait();
+            BOOST_CHECK_EQUAL(c.result, static_cast<ssize_t>(bufSize / 2));
+            BOOST_CHECK(std::memcmp(io.buffer(c.buf) + bufSize / 2,
+                                    data.data() + c.buf * bufSize + bufSize / 2,
+                                    bufSize / 2) == 0);
+        }
+        BOOST_CHECK_THROW(io.write(0, file.fd, 0, bufSize, 1), std::logic_error);
+        BOOST_CHECK_THROW(io.read(depth, file.fd, 0, bufSize), std::logic_error);
+    }
+    BOOST_CHECK_THROW(AsyncFileIO(0, 1024), std::invalid_argument);
+    BOOST_CHECK_THROW(AsyncFileIO(1, 0), std::invalid_argument);
+
+    LOGS_INFO("AsyncFileIO write and read test ends");
+}
+
+BOOST_AUTO_TEST_CASE(AsyncFileReaderTest) {
+
+    LOGS_INFO("AsyncFileReader test begins");
+
+    size_t const recordSize = 4096;
+    for (size_t size: {0UL, 100UL, recordSize, 5 * recordSize, 5 * recordSize + 17}) {
+        TmpFile file;
+        std::vector<uint8_t> const data = content(size);
+        BOOST_REQUIRE_EQUAL(::write(file.fd, data.data(), size), static_cast<ssize_t>(size));
+
+        for (size_t depth: {1, 2, 3, 8}) {
+            AsyncFileReader reader(file.fd, recordSize, depth);
+            std::vector<uint8_t> read;
+            uint8_t const* record = nullptr;
+            ssize_t num;
+            while ((num = reader.next(record)) > 0) {
+                BOOST_CHECK(static_cast<size_t>(num) <= recordSize);
+                read.insert(read.end(), record, record + num);
+            }
+            BOOST_CHECK_EQUAL(num, 0);
+            BOOST_CHECK_EQUAL(reader.next(record), 0);
+            BOOST_CHECK(read == data);
+        }
+
+        // The engine computes the same control sum at any depth
+        uint64_t cs = 0;
+        for (auto b: data) cs += b;
+        for (size_t depth: {1, 4}) {
+            FileCsComputeEngine eng(file.fileName, recordSize, depth);
+            while (not eng.execute()) {}
+            BOOST_CHECK_EQUAL(eng.bytes(), size);
+            BOOST_CHECK_EQUAL(eng.cs(), cs);
+            BOOST_CHECK_THROW(eng.execute(), std::logic_error);
+        }
+    }
+
+    LOGS_INFO("AsyncFileReader test ends");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
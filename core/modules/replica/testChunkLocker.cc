@@ -128,6 +128,20 @@ BOOST_AUTO_TEST_CASE(ChunkLockerTest) {
     BOOST_CHECK(locker.release(chunk1));
     BOOST_CHECK_EQUAL(locker.locked().size(), 0UL);
 
+    // Test the counters
+
+    BOOST_CHECK(locker.lock(chunk1, "qserv"));
+    BOOST_CHECK(not locker.lock(chunk1, "root"));
+    BOOST_CHECK_EQUAL(locker.release("qserv").size(), 1UL);
+
+    ChunkLocker::Stats const stats = locker.stats();
+
+    BOOST_CHECK_EQUAL(stats.numLocked, 5UL);
+    BOOST_CHECK_EQUAL(stats.numReleased, 5UL);
+    BOOST_CHECK_EQUAL(stats.numRefused, 1UL);
+    BOOST_CHECK_EQUAL(stats.numContended, 0UL);
+    BOOST_CHECK(stats.numAcquired > 0UL);
+
     // A this point the locker must be completelly empty
 
     // Run a limited thread safety test if the hardware concurrency permits so.
@@ -79,6 +79,12 @@ BOOST_AUTO_TEST_CASE(ConfigurationTest) {
         {"worker.num_svc_processing_threads", "4"},
         {"worker.num_fs_processing_threads",  "5"},
         {"worker.fs_buf_size_bytes",          "1024"},
+        {"worker.fs_max_streams",             "3"},
+        {"worker.fs_io_depth",                "8"},
+        {"worker.fs_max_rate_bytes_per_sec",  "1000000"},
+        {"worker.fs_compression_level",       "6"},
+        {"worker.num_ingest_loads",           "2"},
+        {"worker.ingest_db",                  "mysql://qsmaster@localhost:13306/qservw_worker"},
         {"worker.svc_port",                   "51000"},
         {"worker.fs_port",                    "52000"},
         {"worker.data_dir",                   "/tmp/{worker}"},
@@ -494,6 +500,12 @@ BOOST_AUTO_TEST_CASE(ConfigurationTest) {
         BOOST_CHECK(config->workerNumProcessingThreads() == 4);
         BOOST_CHECK(config->fsNumProcessingThreads()     == 5);
         BOOST_CHECK(config->workerFsBufferSizeBytes()    == 1024);
+        BOOST_CHECK(config->workerFsMaxStreams()         == 3);
+        BOOST_CHECK(config->workerFsIoDepth()            == 8);
+        BOOST_CHECK(config->workerFsMaxRateBytesPerSec() == 1000000);
+        BOOST_CHECK(config->workerFsCompressionLevel()   == 6);
+        BOOST_CHECK(config->workerNumIngestLoads()       == 2);
+        BOOST_CHECK(config->workerIngestDatabase()       == "mysql://qsmaster@localhost:13306/qservw_worker");
 
         config->setRequestBufferSizeBytes(8193);
         BOOST_CHECK(config->requestBufferSizeBytes() == 8193);
@@ -558,6 +570,21 @@ BOOST_AUTO_TEST_CASE(ConfigurationTest) {
 
         config->setWorkerFsBufferSizeBytes(1025);
         BOOST_CHECK(config->workerFsBufferSizeBytes() == 1025);
+
+        config->setWorkerFsMaxStreams(2);
+        BOOST_CHECK(config->workerFsMaxStreams() == 2);
+
+        config->setWorkerFsIoDepth(16);
+        BOOST_CHECK(config->workerFsIoDepth() == 16);
+
+        config->setWorkerFsMaxRateBytesPerSec(2000000);
+        BOOST_CHECK(config->workerFsMaxRateBytesPerSec() == 2000000);
+
+        config->setWorkerFsCompressionLevel(1);
+        BOOST_CHECK(config->workerFsCompressionLevel() == 1);
+
+        config->setWorkerNumIngestLoads(8);
+        BOOST_CHECK(config->workerNumIngestLoads() == 8);
     });
 
     BOOST_CHECK_THROW(kvMap.at("non-existing-key"), std::out_of_range);
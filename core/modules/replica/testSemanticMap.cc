@@ -394,4 +394,74 @@ BOOST_AUTO_TEST_CASE(SemanticMapsTest) {
     LOGS_INFO("SemanticMaps test ends");
 }
 
+BOOST_AUTO_TEST_CASE(FlatSemanticMapsTest) {
+
+    LOGS_INFO("FlatSemanticMaps test begins");
+
+    auto const dictionary = NameDictionary::create();
+
+    FlatWorkerDatabaseChunkMap<int> one(dictionary);
+    FlatWorkerDatabaseChunkMap<int> two(dictionary);
+
+    // Elements are inserted out of order, and the duplicate key
+    // replaces the previous value.
+    one.insert("B", "c", 5, 5);
+    one.insert("A", "a", 3, 3);
+    one.insert("A", "a", 1, 0);
+    one.insert("A", "a", 2, 2);
+    one.insert("A", "b", 4, 4);
+    one.insert("A", "a", 1, 1);
+
+    two.insert("C", "x", 6, 6);
+    two.insert("A", "a", 1, 10);
+
+    BOOST_CHECK_EQUAL(one.size(), 5U);
+    BOOST_CHECK_EQUAL(two.size(), 2U);
+
+    // The elements are ordered by the identifiers of names in the order
+    // they were first seen.
+    BOOST_CHECK_EQUAL(one.worker(*one.begin()), "B");
+    BOOST_CHECK_EQUAL(one.begin()->value, 5);
+
+    FlatWorkerDatabaseChunkMap<int> inBoth;
+    FlatWorkerDatabaseChunkMap<int> inBothTwo;
+    BOOST_REQUIRE_NO_THROW({
+        SemanticMaps::intersect(one, two, inBoth);
+        SemanticMaps::intersect(two, one, inBothTwo);
+    });
+    BOOST_CHECK_EQUAL(inBoth.size(), 1U);
+    BOOST_CHECK_EQUAL(inBothTwo.size(), 1U);
+    BOOST_CHECK_EQUAL(inBoth.worker(*inBoth.begin()), "A");
+    BOOST_CHECK_EQUAL(inBoth.database(*inBoth.begin()), "a");
+    BOOST_CHECK_EQUAL(inBoth.chunk(*inBoth.begin()), 1U);
+    BOOST_CHECK_EQUAL(inBoth.begin()->value, 1);
+    BOOST_CHECK_EQUAL(inBothTwo.begin()->value, 10);
+
+    FlatWorkerDatabaseChunkMap<int> inOneOnly;
+    FlatWorkerDatabaseChunkMap<int> inTwoOnly;
+    BOOST_REQUIRE_NO_THROW({
+        BOOST_CHECK(SemanticMaps::diff2(one, two, inOneOnly, inTwoOnly));
+    });
+    BOOST_CHECK_EQUAL(SemanticMaps::count(inOneOnly), 4U);
+    BOOST_CHECK_EQUAL(SemanticMaps::count(inTwoOnly), 1U);
+
+    std::vector<int> values;
+    for (auto&& entry: inOneOnly) values.push_back(entry.value);
+    BOOST_CHECK(values == std::vector<int>({5, 2, 3, 4}));
+
+    BOOST_CHECK_EQUAL(inTwoOnly.worker(*inTwoOnly.begin()), "C");
+    BOOST_CHECK_EQUAL(inTwoOnly.database(*inTwoOnly.begin()), "x");
+    BOOST_CHECK_EQUAL(inTwoOnly.chunk(*inTwoOnly.begin()), 6U);
+
+    FlatWorkerDatabaseChunkMap<int> inSelfOnly;
+    BOOST_CHECK(not SemanticMaps::diff(one, one, inSelfOnly));
+
+    // Maps built with different dictionaries can't be compared
+    FlatWorkerDatabaseChunkMap<int> other;
+    other.insert("A", "a", 1, 1);
+    BOOST_CHECK_THROW(SemanticMaps::intersect(one, other, inBoth), std::invalid_argument);
+
+    LOGS_INFO("FlatSemanticMaps test ends");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,329 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "rproc/ColumnarResultSink.h"
+
+// System headers
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.rproc.ColumnarResultSink");
+
+/// @return the number of rows of 'result', whether it holds rows or columns.
+int rowCount(lsst::qserv::proto::Result const& result) {
+    return (result.columnblock_size() > 0) ? result.rowcount() : result.row_size();
+}
+
+/// @return the number of columns of 'result', whether it holds rows or columns.
+int columnCount(lsst::qserv::proto::Result const& result) {
+    if (result.columnblock_size() > 0) {
+        return result.columnblock_size();
+    }
+    return (result.row_size() > 0) ? result.row(0).column_size() : 0;
+}
+
+} // annonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace rproc {
+
+ColumnarResultSink::ColumnarResultSink(std::string const& spillDir, std::string const& prefix,
+                                       uint64_t memoryMaxBytes, size_t blockRows)
+    : _spillDir(spillDir), _prefix(prefix), _memoryMaxBytes(memoryMaxBytes),
+      _blockRows(std::max<size_t>(1, blockRows)) {
+}
+
+
+ColumnarResultSink::~ColumnarResultSink() {
+    for (auto const& elem : _attempts) {
+        if (!elem.second.path.empty()) {
+            _remove(elem.second.path);
+        }
+    }
+}
+
+
+bool ColumnarResultSink::setSchema(proto::RowSchema const& schema) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _schema = schema;
+    return true;
+}
+
+
+bool ColumnarResultSink::add(int jobIdAttempt, proto::Result& result) {
+    int const rows = rowCount(result);
+    std::lock_guard<std::mutex> lock(_mtx);
+    if (rows > 0 && columnCount(result) != _schema.columnschema_size()) {
+        LOGS(_log, LOG_LVL_ERROR, "job attempt " << jobIdAttempt << " has " << columnCount(result)
+             << " columns, expected " << _schema.columnschema_size());
+        return false;
+    }
+    Attempt& attempt = _attempts[jobIdAttempt];
+    if (attempt.open.columnblock_size() != _schema.columnschema_size()) {
+        _newBlock(attempt.open);
+    }
+    uint64_t const memBefore = attempt.memBytes;
+    for (int j = 0; j < rows; ++j) {
+        _appendRow(result, j, attempt);
+        if (static_cast<size_t>(attempt.open.rowcount()) >= _blockRows) {
+            _sealOpen(attempt);
+        }
+    }
+    attempt.rows += rows;
+    attempt.complete = !result.continues();
+    _rows += rows;
+    _memBytes += attempt.memBytes - memBefore;
+    if (_memBytes > _memoryMaxBytes) {
+        return _spillUntilFits();
+    }
+    return true;
+}
+
+
+bool ColumnarResultSink::erase(std::set<int> const& jobIdAttempts) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    for (int jobIdAttempt : jobIdAttempts) {
+        auto iter = _attempts.find(jobIdAttempt);
+        if (iter != _attempts.end()) {
+            _release(iter->second);
+            _attempts.erase(iter);
+        }
+    }
+    return true;
+}
+
+
+bool ColumnarResultSink::flush(LoadFunc const& load) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    bool ok = true;
+    for (auto& elem : _attempts) {
+        int const jobIdAttempt = elem.first;
+        Attempt& attempt = elem.second;
+        if (!attempt.complete) {
+            LOGS(_log, LOG_LVL_WARN, "leaving out incomplete job attempt " << jobIdAttempt);
+            _release(attempt);
+            continue;
+        }
+        // Blocks on disk were added before those still in memory.
+        if (ok && !attempt.path.empty()) {
+            std::ifstream in(attempt.path, std::ios::binary);
+            std::string buf;
+            proto::Result block;
+            uint32_t len = 0;
+            while (ok && in.read(reinterpret_cast<char*>(&len), sizeof(len))) {
+                buf.resize(len);
+                if (!in.read(&buf[0], len) || !block.ParsePartialFromString(buf)) {
+                    LOGS(_log, LOG_LVL_ERROR, "failed to read blocks " << attempt.path);
+                    ok = false;
+                    break;
+                }
+                *block.mutable_rowschema() = _schema;
+                ok = load(jobIdAttempt, block);
+            }
+            if (ok && !in.eof()) {
+                LOGS(_log, LOG_LVL_ERROR, "failed to read blocks " << attempt.path);
+                ok = false;
+            }
+        }
+        _sealOpen(attempt);
+        for (auto& block : attempt.blocks) {
+            if (!ok) break;
+            *block.mutable_rowschema() = _schema;
+            ok = load(jobIdAttempt, block);
+        }
+        _release(attempt);
+    }
+    _attempts.clear();
+    return ok;
+}
+
+
+uint64_t ColumnarResultSink::getBytes() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _memBytes + _diskBytes;
+}
+
+
+uint64_t ColumnarResultSink::getRowCount() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _rows;
+}
+
+
+uint64_t ColumnarResultSink::getSpilledBytes() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _diskBytes;
+}
+
+
+/// Make 'block' an empty block with a ColumnBlock for each column.
+void ColumnarResultSink::_newBlock(proto::Result& block) const {
+    block.Clear();
+    for (int col = 0; col < _schema.columnschema_size(); ++col) {
+        block.add_columnblock();
+    }
+    block.set_rowcount(0);
+}
+
+
+/// Append row 'rowIdx' of 'src', whether it holds rows or columns, to the
+/// open block of 'attempt'.
+/// Precondition: _mtx must be held.
+void ColumnarResultSink::_appendRow(proto::Result const& src, int rowIdx, Attempt& attempt) {
+    proto::Result& block = attempt.open;
+    int const dstIdx = block.rowcount();
+    bool const columnar = src.columnblock_size() > 0;
+    uint64_t bytes = 0;
+    for (int col = 0; col < block.columnblock_size(); ++col) {
+        proto::ColumnBlock* dst = block.mutable_columnblock(col);
+        bool isNull = false;
+        char const* data = nullptr;
+        size_t len = 0;
+        if (columnar) {
+            proto::ColumnBlock const& cb = src.columnblock(col);
+            std::string const& nullBitmap = cb.nullbitmap();
+            size_t byteIdx = rowIdx / 8;
+            isNull = byteIdx < nullBitmap.size() && (nullBitmap[byteIdx] & (1 << (rowIdx % 8)));
+            uint32_t begin = (rowIdx == 0) ? 0 : cb.offsets(rowIdx - 1);
+            data = cb.values().data() + begin;
+            len = cb.offsets(rowIdx) - begin;
+        } else {
+            proto::RowBundle const& rb = src.row(rowIdx);
+            isNull = rb.isnull(col);
+            data = rb.column(col).data();
+            len = rb.column(col).size();
+        }
+        if (isNull) {
+            // The bitmap only reaches the last NULL, later rows are not NULL.
+            std::string* nullBitmap = dst->mutable_nullbitmap();
+            size_t const byteIdx = dstIdx / 8;
+            if (nullBitmap->size() <= byteIdx) {
+                bytes += byteIdx + 1 - nullBitmap->size();
+                nullBitmap->resize(byteIdx + 1, '\0');
+            }
+            (*nullBitmap)[byteIdx] |= (1 << (dstIdx % 8));
+        } else {
+            dst->mutable_values()->append(data, len);
+            bytes += len;
+        }
+        dst->add_offsets(dst->values().size());
+        bytes += sizeof(uint32_t);
+    }
+    block.set_rowcount(dstIdx + 1);
+    attempt.memBytes += bytes;
+}
+
+
+/// Move the open block of 'attempt', if it has rows, to its full blocks.
+/// Precondition: _mtx must be held.
+void ColumnarResultSink::_sealOpen(Attempt& attempt) {
+    if (attempt.open.rowcount() == 0) {
+        return;
+    }
+    attempt.blocks.emplace_back();
+    attempt.blocks.back().Swap(&attempt.open);
+    _newBlock(attempt.open);
+}
+
+
+/// Append the blocks of 'attempt' in memory to its file.
+/// Precondition: _mtx must be held.
+bool ColumnarResultSink::_spill(int jobIdAttempt, Attempt& attempt) {
+    _sealOpen(attempt);
+    if (attempt.path.empty()) {
+        attempt.path = _spillDir + "/" + _prefix + "_" + std::to_string(jobIdAttempt) + ".blk";
+    }
+    std::string data;
+    for (auto const& block : attempt.blocks) {
+        std::string const bytes = block.SerializePartialAsString();
+        uint32_t const len = bytes.size();
+        data.append(reinterpret_cast<char const*>(&len), sizeof(len));
+        data.append(bytes);
+    }
+    std::ofstream out(attempt.path, std::ios::binary | std::ios::app);
+    if (!out.write(data.data(), data.size()) || !out.flush()) {
+        LOGS(_log, LOG_LVL_ERROR, "failed to write blocks " << attempt.path);
+        return false;
+    }
+    attempt.blocks.clear();
+    attempt.diskBytes += data.size();
+    _diskBytes += data.size();
+    _memBytes -= attempt.memBytes;
+    attempt.memBytes = 0;
+    return true;
+}
+
+
+/// Write the blocks of the attempts holding the most memory to disk, until
+/// the blocks left in memory take at most _memoryMaxBytes.
+/// Precondition: _mtx must be held.
+bool ColumnarResultSink::_spillUntilFits() {
+    while (_memBytes > _memoryMaxBytes) {
+        auto largest = _attempts.end();
+        for (auto iter = _attempts.begin(); iter != _attempts.end(); ++iter) {
+            if (largest == _attempts.end() || iter->second.memBytes > largest->second.memBytes) {
+                largest = iter;
+            }
+        }
+        if (largest == _attempts.end() || largest->second.memBytes == 0) {
+            break;
+        }
+        LOGS(_log, LOG_LVL_DEBUG, "spilling " << largest->second.memBytes << " bytes of job attempt "
+             << largest->first);
+        if (!_spill(largest->first, largest->second)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/// Free the rows of 'attempt', in memory and on disk.
+/// Precondition: _mtx must be held.
+void ColumnarResultSink::_release(Attempt& attempt) {
+    _memBytes -= attempt.memBytes;
+    _diskBytes -= attempt.diskBytes;
+    _rows -= attempt.rows;
+    if (!attempt.path.empty()) {
+        _remove(attempt.path);
+    }
+    attempt = Attempt();
+}
+
+
+void ColumnarResultSink::_remove(std::string const& path) {
+    if (std::remove(path.c_str()) != 0 && errno != ENOENT) {
+        LOGS(_log, LOG_LVL_WARN, "failed to remove blocks " << path);
+    }
+}
+
+}}} // namespace lsst::qserv::rproc
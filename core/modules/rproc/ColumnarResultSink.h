@@ -0,0 +1,110 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_RPROC_COLUMNARRESULTSINK_H
+#define LSST_QSERV_RPROC_COLUMNARRESULTSINK_H
+
+// System headers
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "proto/worker.pb.h"
+#include "rproc/ResultSink.h"
+
+namespace lsst {
+namespace qserv {
+namespace rproc {
+
+/// ColumnarResultSink holds the result rows on the czar, outside of MySQL,
+/// until every chunk is in. Each job attempt has its own column blocks,
+/// one ColumnBlock per column of up to blockRows rows, which are written
+/// to a file of the attempt in a local directory once the blocks of all
+/// attempts take more than memoryMaxBytes.
+///
+/// Rows of invalid attempts are dropped without touching MySQL, and the
+/// rows of complete attempts reach the result table with flush(), a block
+/// at a time, instead of in a LOAD DATA for every message. Attempts that
+/// never sent their last message are left out.
+class ColumnarResultSink : public ResultSink {
+public:
+    /// @param spillDir - directory of the files holding blocks past memoryMaxBytes.
+    /// @param prefix - start of the file names, unique to the query.
+    /// @param memoryMaxBytes - bytes of blocks kept in memory, 0 writes every row to disk.
+    /// @param blockRows - largest number of rows in a block.
+    ColumnarResultSink(std::string const& spillDir, std::string const& prefix,
+                       uint64_t memoryMaxBytes, size_t blockRows=10000);
+
+    /// Remove the files left.
+    ~ColumnarResultSink();
+
+    bool setSchema(proto::RowSchema const& schema) override;
+    bool add(int jobIdAttempt, proto::Result& result) override;
+    bool erase(std::set<int> const& jobIdAttempts) override;
+    bool flush(LoadFunc const& load) override;
+    bool holdsRows() const override { return true; }
+    uint64_t getBytes() const override;
+    uint64_t getRowCount() const override;
+
+    /// @return the bytes of the blocks written to disk.
+    uint64_t getSpilledBytes() const;
+
+private:
+    /// Rows of one job attempt.
+    struct Attempt {
+        std::vector<proto::Result> blocks; ///< Full blocks in memory.
+        proto::Result open; ///< Block the next rows go to.
+        uint64_t memBytes{0}; ///< Bytes of 'blocks' and 'open'.
+        std::string path; ///< File of the blocks on disk, empty if none.
+        uint64_t diskBytes{0};
+        uint64_t rows{0};
+        bool complete{false};
+    };
+
+    void _newBlock(proto::Result& block) const;
+    void _appendRow(proto::Result const& src, int rowIdx, Attempt& attempt);
+    void _sealOpen(Attempt& attempt);
+    bool _spill(int jobIdAttempt, Attempt& attempt);
+    bool _spillUntilFits();
+    void _release(Attempt& attempt);
+    static void _remove(std::string const& path);
+
+    std::string const _spillDir;
+    std::string const _prefix;
+    uint64_t const _memoryMaxBytes;
+    size_t const _blockRows;
+    proto::RowSchema _schema;
+
+    mutable std::mutex _mtx; ///< Protects members below
+    std::map<int, Attempt> _attempts; ///< Rows by job attempt
+    uint64_t _memBytes{0};
+    uint64_t _diskBytes{0};
+    uint64_t _rows{0};
+};
+
+}}} // namespace lsst::qserv::rproc
+
+#endif // LSST_QSERV_RPROC_COLUMNARRESULTSINK_H
@@ -0,0 +1,275 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "rproc/InMemoryTopK.h"
+
+// System headers
+#include <cerrno>
+#include <cstdlib>
+#include <iterator>
+
+// Third-party headers
+#include <mysql/mysql.h>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.rproc.InMemoryTopK");
+
+std::vector<bool> descendingOf(lsst::qserv::rproc::InMemoryTopK::Order const& order) {
+    std::vector<bool> desc;
+    for (auto const& term : order) {
+        desc.push_back(term.second);
+    }
+    return desc;
+}
+
+} // annonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace rproc {
+
+InMemoryTopK::InMemoryTopK(Order const& order, size_t k)
+    : _order(order), _k(k), _kept(Less(descendingOf(order))) {
+}
+
+
+bool InMemoryTopK::Less::operator()(EntryPtr const& a, EntryPtr const& b) const {
+    for (size_t j = 0; j < descending.size(); ++j) {
+        Key const& ka = a->keys[j];
+        Key const& kb = b->keys[j];
+        int cmp = 0;
+        if (ka.isNull || kb.isNull) {
+            cmp = (ka.isNull ? 0 : 1) - (kb.isNull ? 0 : 1);
+        } else if (ka.isInt) {
+            cmp = (ka.intVal < kb.intVal) ? -1 : (kb.intVal < ka.intVal) ? 1 : 0;
+        } else {
+            cmp = (ka.realVal < kb.realVal) ? -1 : (kb.realVal < ka.realVal) ? 1 : 0;
+        }
+        if (cmp != 0) {
+            return descending[j] ? cmp > 0 : cmp < 0;
+        }
+    }
+    return false;
+}
+
+
+bool InMemoryTopK::setSchema(proto::RowSchema const& schema) {
+    _schema = schema;
+    _sortCols.clear();
+    _isInt.clear();
+    for (auto const& term : _order) {
+        int found = -1;
+        for (int col = 0; col < schema.columnschema_size(); ++col) {
+            if (schema.columnschema(col).name() == term.first) {
+                found = col;
+                break;
+            }
+        }
+        if (found < 0) {
+            LOGS(_log, LOG_LVL_DEBUG, "sort column " << term.first << " not in result");
+            return false;
+        }
+        proto::ColumnSchema const& cs = schema.columnschema(found);
+        if (!cs.has_mysqltype()) {
+            return false;
+        }
+        switch (cs.mysqltype()) {
+        case MYSQL_TYPE_TINY:
+        case MYSQL_TYPE_SHORT:
+        case MYSQL_TYPE_LONG:
+        case MYSQL_TYPE_INT24:
+        case MYSQL_TYPE_LONGLONG:
+            _isInt.push_back(true);
+            break;
+        case MYSQL_TYPE_FLOAT:
+        case MYSQL_TYPE_DOUBLE:
+            _isInt.push_back(false);
+            break;
+        default:
+            LOGS(_log, LOG_LVL_DEBUG, "sort column " << cs.name() << " type " << cs.mysqltype()
+                 << " cannot be ranked");
+            return false;
+        }
+        _sortCols.push_back(found);
+    }
+    return true;
+}
+
+
+bool InMemoryTopK::add(int jobIdAttempt, proto::Result const& result) {
+    int const rowCount = (result.columnblock_size() > 0) ? result.rowcount() : result.row_size();
+    std::vector<EntryPtr> entries;
+    entries.reserve(rowCount);
+    for (int j = 0; j < rowCount; ++j) {
+        auto entry = std::make_shared<Entry>();
+        entry->jobIdAttempt = jobIdAttempt;
+        if (!_parseRow(result, j, *entry)) {
+            return false;
+        }
+        entries.push_back(std::move(entry));
+    }
+
+    std::lock_guard<std::mutex> lock(_mtx);
+    _addedRows += rowCount;
+    if (result.continues()) {
+        auto& pending = _pending[jobIdAttempt];
+        pending.insert(pending.end(), entries.begin(), entries.end());
+        return true;
+    }
+    auto iter = _pending.find(jobIdAttempt);
+    if (iter != _pending.end()) {
+        entries.insert(entries.end(), iter->second.begin(), iter->second.end());
+        _pending.erase(iter);
+    }
+    _rank(entries);
+    return true;
+}
+
+
+/// Keep the entries that belong in the first _k rows.
+/// Precondition: _mtx must be held.
+void InMemoryTopK::_rank(std::vector<EntryPtr>& entries) {
+    for (auto& entry : entries) {
+        if (_kept.size() >= _k) {
+            auto last = std::prev(_kept.end());
+            if (!_kept.key_comp()(entry, *last)) {
+                continue;
+            }
+            _kept.erase(last);
+        }
+        _kept.insert(std::move(entry));
+    }
+}
+
+
+void InMemoryTopK::erase(std::set<int> const& jobIdAttempts) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    for (int jobIdAttempt : jobIdAttempts) {
+        _pending.erase(jobIdAttempt);
+    }
+    for (auto iter = _kept.begin(); iter != _kept.end();) {
+        if (jobIdAttempts.count((*iter)->jobIdAttempt) > 0) {
+            iter = _kept.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+}
+
+
+void InMemoryTopK::extractAll(proto::Result& result) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    *result.mutable_rowschema() = _schema;
+    for (auto const& entry : _kept) {
+        result.add_row()->Swap(&entry->row);
+    }
+    result.set_rowcount(result.row_size());
+    _kept.clear();
+    _pending.clear();
+}
+
+
+void InMemoryTopK::extractEach(std::function<void(int, proto::Result&)> const& func) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    std::map<int, proto::Result> results;
+    auto addTo = [this, &results](EntryPtr const& entry) {
+        proto::Result& result = results[entry->jobIdAttempt];
+        if (!result.has_rowschema()) {
+            *result.mutable_rowschema() = _schema;
+        }
+        result.add_row()->Swap(&entry->row);
+    };
+    for (auto const& entry : _kept) {
+        addTo(entry);
+    }
+    for (auto const& elem : _pending) {
+        for (auto const& entry : elem.second) {
+            addTo(entry);
+        }
+    }
+    _kept.clear();
+    _pending.clear();
+    for (auto& elem : results) {
+        elem.second.set_rowcount(elem.second.row_size());
+        func(elem.first, elem.second);
+    }
+}
+
+
+uint64_t InMemoryTopK::getAddedRowCount() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _addedRows;
+}
+
+
+bool InMemoryTopK::_parseRow(proto::Result const& result, int rowIdx, Entry& entry) const {
+    bool const columnar = result.columnblock_size() > 0;
+    int const colCount = columnar ? result.columnblock_size() : result.row(rowIdx).column_size();
+    if (colCount != _schema.columnschema_size()) {
+        return false;
+    }
+    if (columnar) {
+        for (int col = 0; col < colCount; ++col) {
+            proto::ColumnBlock const& block = result.columnblock(col);
+            std::string const& nullBitmap = block.nullbitmap();
+            size_t byteIdx = rowIdx / 8;
+            bool isNull = byteIdx < nullBitmap.size() && (nullBitmap[byteIdx] & (1 << (rowIdx % 8)));
+            uint32_t begin = (rowIdx == 0) ? 0 : block.offsets(rowIdx - 1);
+            entry.row.add_isnull(isNull);
+            entry.row.add_column(isNull ? std::string()
+                                 : block.values().substr(begin, block.offsets(rowIdx) - begin));
+        }
+    } else {
+        entry.row = result.row(rowIdx);
+    }
+    entry.keys.resize(_sortCols.size());
+    for (size_t j = 0; j < _sortCols.size(); ++j) {
+        int const col = _sortCols[j];
+        Key& key = entry.keys[j];
+        key.isInt = _isInt[j];
+        key.isNull = entry.row.isnull(col);
+        if (key.isNull) {
+            continue;
+        }
+        std::string const& str = entry.row.column(col);
+        char* end = nullptr;
+        errno = 0;
+        if (key.isInt) {
+            key.intVal = std::strtoll(str.c_str(), &end, 10);
+        } else {
+            key.realVal = std::strtod(str.c_str(), &end);
+        }
+        if (errno != 0 || end == str.c_str() || *end != '\0') {
+            LOGS(_log, LOG_LVL_WARN, "could not parse sort column " << col << " value " << str);
+            return false;
+        }
+    }
+    return true;
+}
+
+}}} // namespace lsst::qserv::rproc
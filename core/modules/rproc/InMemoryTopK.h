@@ -0,0 +1,128 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_RPROC_INMEMORYTOPK_H
+#define LSST_QSERV_RPROC_INMEMORYTOPK_H
+
+// System headers
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Qserv headers
+#include "proto/worker.pb.h"
+
+namespace lsst {
+namespace qserv {
+namespace rproc {
+
+/// InMemoryTopK keeps the first k rows, in ORDER BY order, of all the chunk
+/// results of an ORDER BY ... LIMIT k query, so that the merge table only
+/// receives those k rows instead of up to k rows from every chunk. The merge
+/// statement still sorts and limits the rows that are kept.
+///
+/// Rows of a job attempt are only ranked once its last message arrived, and
+/// the rows of an invalid attempt are removed. The rows they pushed out are
+/// gone, but the retried attempt returns the same rows and pushes out the
+/// same ones again.
+class InMemoryTopK {
+public:
+    /// Result column name and true for a descending sort, for each ORDER BY term.
+    using Order = std::vector<std::pair<std::string, bool>>;
+
+    /// @param order - columns to sort on, most significant first.
+    /// @param k - number of rows to keep.
+    InMemoryTopK(Order const& order, size_t k);
+
+    InMemoryTopK(InMemoryTopK const&) = delete;
+    InMemoryTopK& operator=(InMemoryTopK const&) = delete;
+
+    /// Find the sort columns among the columns described by 'schema'.
+    /// @return false if a sort column is missing or is not numeric, as
+    ///         string order depends on the collation.
+    bool setSchema(proto::RowSchema const& schema);
+
+    /// Add the rows of 'result' to those of 'jobIdAttempt', ranking them
+    /// once 'result' is the last message of the attempt.
+    /// @return false, leaving the kept rows unchanged, if a sort value could
+    ///         not be parsed.
+    bool add(int jobIdAttempt, proto::Result const& result);
+
+    /// Discard the rows of the given job attempts.
+    void erase(std::set<int> const& jobIdAttempts);
+
+    /// Move the rows kept into 'result', in no particular order.
+    void extractAll(proto::Result& result);
+
+    /// Call 'func' with the rows kept and pending of each job attempt, and
+    /// clear them.
+    void extractEach(std::function<void(int jobIdAttempt, proto::Result& result)> const& func);
+
+    uint64_t getAddedRowCount() const;
+
+private:
+    /// Sort value of one column, NULL sorts before any value as in MySQL.
+    struct Key {
+        bool isNull{true};
+        bool isInt{false};
+        int64_t intVal{0};
+        double realVal{0.0};
+    };
+
+    struct Entry {
+        std::vector<Key> keys;
+        proto::RowBundle row;
+        int jobIdAttempt{0};
+    };
+    using EntryPtr = std::shared_ptr<Entry>;
+
+    /// Orders entries so that the ones to keep come first.
+    struct Less {
+        explicit Less(std::vector<bool> const& desc) : descending(desc) {}
+        bool operator()(EntryPtr const& a, EntryPtr const& b) const;
+        std::vector<bool> descending;
+    };
+
+    bool _parseRow(proto::Result const& result, int rowIdx, Entry& entry) const;
+    void _rank(std::vector<EntryPtr>& entries);
+
+    Order const _order;
+    size_t const _k;
+    std::vector<int> _sortCols; ///< Result column of each ORDER BY term, set by setSchema()
+    std::vector<bool> _isInt; ///< True if a sort column holds integers
+    proto::RowSchema _schema;
+
+    mutable std::mutex _mtx; ///< Protects members below
+    std::multiset<EntryPtr, Less> _kept; ///< At most _k rows, best first
+    std::map<int, std::vector<EntryPtr>> _pending; ///< Rows of attempts still sending messages
+    uint64_t _addedRows{0}; ///< Number of worker rows seen so far
+};
+
+}}} // namespace lsst::qserv::rproc
+
+#endif // LSST_QSERV_RPROC_INMEMORYTOPK_H
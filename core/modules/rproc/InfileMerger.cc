@@ -39,8 +39,12 @@
 #include "rproc/InfileMerger.h"
 
 // System headers
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <cstddef>
+#include <cstdlib>
+#include <functional>
 #include <iostream>
 #include <sstream>
 #include <sys/time.h>
@@ -49,6 +53,7 @@
 // Third-party headers
 #include "boost/format.hpp"
 #include "boost/regex.hpp"
+#include "mysql/mysqld_error.h"
 
 // LSST headers
 #include "lsst/log/Log.h"
@@ -59,25 +64,71 @@
 #include "global/intTypes.h"
 #include "proto/WorkerResponse.h"
 #include "proto/ProtoImporter.h"
+#include "query/ColumnRef.h"
+#include "query/GroupByClause.h"
 #include "query/SelectStmt.h"
+#include "query/ValueExpr.h"
+#include "rproc/ColumnarResultSink.h"
 #include "rproc/ProtoRowBuffer.h"
 #include "sql/Schema.h"
 #include "sql/SqlConnection.h"
+#include "sql/SqlConnectionPool.h"
 #include "sql/SqlResults.h"
 #include "sql/SqlErrorObject.h"
 #include "sql/statement.h"
 #include "util/IterableFormatter.h"
+#include "util/Profiler.h"
 #include "util/StringHash.h"
+#include "util/Timer.h"
 
 namespace { // File-scope helpers
 
 LOG_LOGGER _log = LOG_GET("lsst.qserv.rproc.InfileMerger");
 
+/// Sampled time waited for a merge shard when all of them are busy.
+lsst::qserv::util::LockTiming mergeShardLockTiming("merge_shard");
+
 using lsst::qserv::mysql::MySqlConfig;
 using lsst::qserv::rproc::InfileMergerConfig;
 using lsst::qserv::rproc::InfileMergerError;
 using lsst::qserv::util::ErrorCode;
 
+/// Rows loaded at a time from the sorted chunk results.
+size_t const sortedBatchRows = 10000;
+
+/// Append row 'rowIdx' of 'result' to 'dest', whether 'result' holds rows or columns.
+void copyRow(lsst::qserv::proto::Result const& result, int rowIdx, lsst::qserv::proto::Result& dest) {
+    if (result.columnblock_size() == 0) {
+        *dest.add_row() = result.row(rowIdx);
+        return;
+    }
+    lsst::qserv::proto::RowBundle* row = dest.add_row();
+    for (int col = 0; col < result.columnblock_size(); ++col) {
+        lsst::qserv::proto::ColumnBlock const& block = result.columnblock(col);
+        std::string const& nullBitmap = block.nullbitmap();
+        size_t byteIdx = rowIdx / 8;
+        bool isNull = byteIdx < nullBitmap.size() && (nullBitmap[byteIdx] & (1 << (rowIdx % 8)));
+        uint32_t begin = (rowIdx == 0) ? 0 : block.offsets(rowIdx - 1);
+        row->add_isnull(isNull);
+        row->add_column(isNull ? std::string() : block.values().substr(begin, block.offsets(rowIdx) - begin));
+    }
+}
+
+/// @return true if equal values of a column of 'mysqlType' always have the
+///         same text, so that the text may pick the shard of a group.
+bool hasCanonicalText(int mysqlType) {
+    switch (mysqlType) {
+    case MYSQL_TYPE_TINY:
+    case MYSQL_TYPE_SHORT:
+    case MYSQL_TYPE_LONG:
+    case MYSQL_TYPE_INT24:
+    case MYSQL_TYPE_LONGLONG:
+        return true;
+    default:
+        return false;
+    }
+}
+
 /// @return a timestamp id for use in generating temporary result table names.
 std::string getTimeStampId() {
     struct timeval now;
@@ -103,24 +154,74 @@ namespace rproc {
 // InfileMerger public
 ////////////////////////////////////////////////////////////////////////
 InfileMerger::InfileMerger(InfileMergerConfig const& c)
-    : _config(c),
-      _mysqlConn(_config.mySqlConfig) {
+    : _config(c) {
     _alterJobIdColName(); // initialize jobIdColName.
     _fixupTargetName();
+    int const shardCount = std::max(1, _config.mergeShards);
+    for (int j = 0; j < shardCount; ++j) {
+        std::string table = (shardCount == 1) ? _mergeTable : _mergeTable + "_" + std::to_string(j);
+        _shards.emplace_back(new MergeShard(_config.mySqlConfig, table));
+    }
     _maxResultTableSizeMB = _config.mySqlConfig.maxTableSizeMB;
 
-    // Assume worst case of 10,000 bytes per row, what's the earliest row to test?
-    // Subtract that from the count so the first check doesn't happen for a while.
-    // Subsequent checks should happen at reasonable intervals.
-    // At 5000MB max size, the first check is made at 550,000 rows, with subsequent checks
-    // about every 50,000 rows.
-    _sizeCheckRowCount = -100*(_maxResultTableSizeMB);  //  100 = 1,000,000/10,000
-    _checkSizeEveryXRows = 10*_maxResultTableSizeMB;
+    // The size of the result table is estimated from the bytes merged. The
+    // real table size is only read to correct the estimate, the first time
+    // when half the maximum is reached and then after every quarter more.
+    _sizeCheckStepBytes = std::max<uint64_t>(1, _maxResultTableSizeMB * MB_BYTES / 4);
+    _nextSizeCheckBytes = 2 * _sizeCheckStepBytes;
     LOGS(_log, LOG_LVL_DEBUG, "InfileMerger maxResultTableSizeMB=" << _maxResultTableSizeMB
-                              << " sizeCheckRowCount=" << _sizeCheckRowCount
-                              << " checkSizeEveryXRows=" << _checkSizeEveryXRows);
+                              << " nextSizeCheckBytes=" << _nextSizeCheckBytes);
     if (_config.mergeStmt) {
         _config.mergeStmt->setFromListAsTable(_mergeTable);
+        if (_config.aggFold && _config.aggMaxGroups > 0) {
+            _aggregator.reset(new proto::InMemoryAggregator(*_config.aggFold, _config.aggMaxGroups));
+        } else if (_config.topK > 0 && _config.topK <= _config.topKMaxRows) {
+            _topK.reset(new InMemoryTopK(_config.topKOrder, _config.topK));
+        }
+    }
+    if (_config.mergeStmt && shardCount > 1 && _config.mergeStmt->hasGroupBy()
+        && !_config.mergeStmt->hasLimit() && !_config.mergeStmt->hasOrderBy()
+        && !_config.mergeStmt->getDistinct()) {
+        // Each shard can merge its own groups if all rows of a group go to the same shard.
+        query::ValueExprPtrVector groupBy;
+        _config.mergeStmt->getGroupBy().findValueExprs(groupBy);
+        for (auto const& valueExpr : groupBy) {
+            auto const colRef = valueExpr ? valueExpr->getColumnRef() : nullptr;
+            if (colRef == nullptr) {
+                _groupByColumns.clear();
+                break;
+            }
+            _groupByColumns.push_back(colRef->column);
+        }
+    }
+    if (_config.sampleEvery > 1 && _config.mergeStmt && _config.aggFold
+        && !_config.mergeStmt->hasGroupBy()) {
+        // Each chunk result is then a partial total, the spread of which
+        // gives the error of the scaled totals.
+        auto const& fold = *_config.aggFold;
+        if (std::none_of(fold.begin(), fold.end(),
+                         [](query::AggRecord::Fold f) { return f == query::AggRecord::Fold::KEY; })) {
+            for (size_t col = 0; col < fold.size(); ++col) {
+                if (fold[col] == query::AggRecord::Fold::SUM) _sampleCols.push_back(col);
+            }
+        }
+    }
+    if (!_config.mergeStmt && !_config.sortedOrder.empty() && !_config.sortedRunDir.empty()
+        && shardCount == 1) {
+        _sorted.reset(new SortedRunMerger(_config.sortedOrder, _config.sortedRunDir, _config.targetTable));
+    }
+
+    if (_config.resultSink == ResultSink::COLUMNAR && !_config.resultSinkDir.empty()) {
+        _sink.reset(new ColumnarResultSink(_config.resultSinkDir, _config.targetTable,
+                                           _config.resultSinkMemoryMB * MB_BYTES));
+    } else {
+        _sink.reset(new MySqlResultSink(
+            [this](int jobIdAttempt, proto::Result& result) {
+                return _loadResult(result, jobIdAttempt, _getQueryIdStr());
+            },
+            [this](std::set<int> const& jobIdAttempts) {
+                return _deleteTableRows(jobIdAttempts);
+            }));
     }
 
     _invalidJobAttemptMgr.setDeleteFunc([this](InvalidJobAttemptMgr::jASetType const& jobAttempts) -> bool {
@@ -132,8 +233,10 @@ InfileMerger::InfileMerger(InfileMergerConfig const& c)
         return !_needCreateTable;
     });
 
-    if (!_setupConnection()) {
-        throw InfileMergerError(util::ErrorCode::MYSQLCONNECT, "InfileMerger mysql connect failure.");
+    for (auto const& shard : _shards) {
+        if (!shard->setupConnection()) {
+            throw InfileMergerError(util::ErrorCode::MYSQLCONNECT, "InfileMerger mysql connect failure.");
+        }
     }
 }
 
@@ -156,6 +259,7 @@ void InfileMerger::_setQueryIdStr(std::string const& qIdStr) {
 
 
 bool InfileMerger::merge(std::shared_ptr<proto::WorkerResponse> response) {
+    util::ThreadRole role("merge");
     if (!response) {
         return false;
     }
@@ -172,7 +276,7 @@ bool InfileMerger::merge(std::shared_ptr<proto::WorkerResponse> response) {
          << " sizes=" << static_cast<short>(response->headerSize)
          << ", " << response->protoHeader.size()
          << ", rowCount=" << response->result.rowcount()
-         << ", row_size=" << response->result.row_size()
+         << ", row_size=" << ProtoRowBuffer::getRowCount(response->result)
          << ", attemptCount=" << response-> result.attemptcount()
          << ", errCode=" << response->result.has_errorcode()
          << " hasErMsg=" << response->result.has_errormsg() << ")");
@@ -188,26 +292,70 @@ bool InfileMerger::merge(std::shared_ptr<proto::WorkerResponse> response) {
         }
     }
 
-    // Nothing to do if size is zero.
-    if (response->result.row_size() == 0) {
+    // Once the user query has all of its rows, later rows are not needed.
+    if (limitReached()) {
+        LOGS(_log, LOG_LVL_DEBUG, queryIdJobStr << " row limit reached, dropping rows");
         return true;
     }
-    _sizeCheckRowCount += response->result.row_size();
 
-    bool ret = false;
-    // Add columns to rows in virtFile.
+    int const rowSize = ProtoRowBuffer::getRowCount(response->result);
     int resultJobId = makeJobIdAttempt(response->result.jobid(), response->result.attemptcount());
-    ProtoRowBuffer::Ptr pRowBuffer = std::make_shared<ProtoRowBuffer>(response->result,
-                                     resultJobId, _jobIdColName, _jobIdSqlType, _jobIdMysqlType);
-    std::string const virtFile = _infileMgr.prepareSrc(pRowBuffer, queryIdJobStr);
-    std::string const infileStatement = sql::formLoadInfile(_mergeTable, virtFile);
+    bool const continues = response->result.continues();
+    // Rows of an attempt that takes more than one message go to a staging
+    // table until its last message, so that they can be dropped cheaply if
+    // the attempt fails part way.
+    bool const staged = _isStaged(resultJobId);
+    bool stage = false;
+    if (continues || staged) {
+        std::lock_guard<std::mutex> lock(_aggMtx);
+        stage = (_aggregator == nullptr && _topK == nullptr && _sorted == nullptr && _partitionCols.empty()
+                 && !_sink->holdsRows());
+    }
+    // Nothing to do if size is zero, unless it ends a staged attempt.
+    if (rowSize == 0 && !(staged && !continues)) {
+        return true;
+    }
+
+    bool ret = false;
     auto start = std::chrono::system_clock::now();
     // If the job attempt is invalid, exit without adding rows.
     // It will wait here if rows need to be deleted.
-    if (_invalidJobAttemptMgr.incrConcurrentMergeCount(resultJobId)) {
+    // Staged rows only reach the result table with the last message.
+    if (_invalidJobAttemptMgr.incrConcurrentMergeCount(resultJobId, !stage || !continues)) {
         return true;
     }
-    ret = _applyMysql(infileStatement);
+    if (!_sampleCols.empty()) {
+        _recordSample(response->result);
+    }
+    bool folded = false;
+    if (stage) {
+        ret = _mergeStaged(response->result, resultJobId, queryIdJobStr);
+    } else {
+        ret = _foldResult(response->result, resultJobId, folded);
+        if (ret && !folded) {
+            ret = _rankResult(response->result, resultJobId, folded);
+        }
+        if (ret && !folded) {
+            ret = _sortResult(response->result, resultJobId, folded);
+        }
+        if (ret && !folded) {
+            ret = _sinkResult(response->result, resultJobId);
+            if (ret) _countRows(resultJobId, rowSize);
+        }
+    }
+    if (ret) {
+        uint64_t bytes = response->result.transmitsize();
+        if (bytes == 0) {
+            bytes = response->result.ByteSizeLong();
+        }
+        // Rows held by _sink are not in the result table, see _sinkResult().
+        if (!folded && !_sink->holdsRows()) {
+            _estResultBytes += bytes + rowSize * ROW_OVERHEAD_BYTES;
+        }
+        if (_config.onMerged) {
+            _config.onMerged(bytes, rowSize);
+        }
+    }
     if (not ret) {
         LOGS(_log, LOG_LVL_ERROR, "InfileMerger::merge mysql applyMysql failure");
     }
@@ -216,51 +364,578 @@ bool InfileMerger::merge(std::shared_ptr<proto::WorkerResponse> response) {
     auto mergeDur = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
     LOGS(_log, LOG_LVL_DEBUG, queryIdJobStr << " mergeDur=" << mergeDur.count());
     /// Check the size of the result table.
-    if (_sizeCheckRowCount >= _checkSizeEveryXRows) {
-        auto tSize = _getResultTableSizeMB();
-        LOGS(_log, LOG_LVL_DEBUG, queryIdJobStr << "checking ResultTableSize " << _mergeTable
-                                  << " " << tSize
-                                  << " max=" << _maxResultTableSizeMB);
-        _sizeCheckRowCount = 0;
-        if (tSize > _maxResultTableSizeMB) {
-            // Try deleting invalid rows if there are any, then check size again
-            bool validResult = _invalidJobAttemptMgr.holdMergingForRowDelete("Checking size");
-            tSize = _getResultTableSizeMB();
-            if (tSize > _maxResultTableSizeMB || !validResult) {
-                std::ostringstream os;
-                os << queryIdJobStr << " cancelling queryResult table " << _mergeTable;
-                if (!validResult) {
-                    os << " failed to delete invalid rows.";
-                } else {
-                    os << " too large at " << tSize << "MB max allowed=" << _maxResultTableSizeMB;
+    if (!_checkSize(queryIdJobStr)) {
+        return false;
+    }
+    return ret;
+}
+
+
+/// Compare the estimated size of the result table to the maximum, and
+/// occasionally replace the estimate with the real size.
+/// @return false if the result table is too large.
+bool InfileMerger::_checkSize(std::string const& queryIdJobStr) {
+    uint64_t const estBytes = _estResultBytes;
+    bool const overMax = estBytes > _maxResultTableSizeMB * MB_BYTES;
+    if (!overMax && estBytes < _nextSizeCheckBytes) {
+        return true;
+    }
+    // Only one thread needs to read the real size.
+    std::unique_lock<std::mutex> lock(_sizeCheckMtx, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return true;
+    }
+    auto tSize = _getResultTableSizeMB();
+    LOGS(_log, LOG_LVL_DEBUG, queryIdJobStr << "checking ResultTableSize " << _mergeTable
+                              << " " << tSize << " estimateMB=" << estBytes / MB_BYTES
+                              << " max=" << _maxResultTableSizeMB);
+    _correctSizeEstimate(estBytes, tSize);
+    if (tSize > _maxResultTableSizeMB) {
+        // Try deleting invalid rows if there are any, then check size again
+        bool validResult = _invalidJobAttemptMgr.holdMergingForRowDelete("Checking size");
+        tSize = _getResultTableSizeMB();
+        _correctSizeEstimate(_estResultBytes, tSize);
+        if (tSize > _maxResultTableSizeMB || !validResult) {
+            std::ostringstream os;
+            os << queryIdJobStr << " cancelling queryResult table " << _mergeTable;
+            if (!validResult) {
+                os << " failed to delete invalid rows.";
+            } else {
+                os << " too large at " << tSize << "MB max allowed=" << _maxResultTableSizeMB;
+            }
+            LOGS(_log, LOG_LVL_ERROR, os.str());
+            _error = util::Error(-1, os.str(), -1);
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/// Replace the size estimate, which was 'estBytes' when the real size
+/// 'tableSizeMB' was read, keeping what was merged in the meantime.
+/// Precondition: _sizeCheckMtx must be held.
+void InfileMerger::_correctSizeEstimate(uint64_t estBytes, size_t tableSizeMB) {
+    uint64_t const tableBytes = tableSizeMB * MB_BYTES;
+    uint64_t const now = _estResultBytes;
+    uint64_t const sinceRead = (now > estBytes) ? now - estBytes : 0;
+    _estResultBytes = tableBytes + sinceRead;
+    _nextSizeCheckBytes = std::max(_nextSizeCheckBytes.load(), tableBytes) + _sizeCheckStepBytes;
+}
+
+
+/// Load the rows of 'result' into 'table', or one of the shard tables if
+/// 'table' is empty.
+bool InfileMerger::_loadResult(proto::Result& result, int jobIdAttempt, std::string const& queryIdJobStr,
+                               std::string const& table) {
+    if (table.empty() && !_partitionCols.empty()) {
+        return _loadPartitioned(result, jobIdAttempt, queryIdJobStr);
+    }
+    // Add columns to rows in virtFile.
+    ProtoRowBuffer::Ptr pRowBuffer = std::make_shared<ProtoRowBuffer>(result,
+                                     jobIdAttempt, _jobIdColName, _jobIdSqlType, _jobIdMysqlType);
+    std::unique_lock<std::mutex> shardLock;
+    MergeShard& shard = _lockShard(shardLock);
+    std::string const virtFile = shard.infileMgr.prepareSrc(pRowBuffer, queryIdJobStr);
+    std::string const infileStatement = sql::formLoadInfile(table.empty() ? shard.table : table, virtFile);
+    if (_applyMysql(shard, infileStatement)) {
+        return true;
+    }
+    if (table.empty() && _memoryTable && mysql_errno(shard.mysqlConn.getMySql()) == ER_RECORD_FILE_FULL
+        && _memoryTableFull(jobIdAttempt)) {
+        // Load the rows again now that the table is on disk.
+        pRowBuffer = std::make_shared<ProtoRowBuffer>(result,
+                     jobIdAttempt, _jobIdColName, _jobIdSqlType, _jobIdMysqlType);
+        std::string const retryFile = shard.infileMgr.prepareSrc(pRowBuffer, queryIdJobStr);
+        return _applyMysql(shard, sql::formLoadInfile(shard.table, retryFile));
+    }
+    return false;
+}
+
+
+bool InfileMerger::_isStaged(int jobIdAttempt) {
+    std::lock_guard<std::mutex> lock(_stagingMtx);
+    return _staging.find(jobIdAttempt) != _staging.end();
+}
+
+
+/// Load the rows of 'result' into the staging table of its job attempt.
+/// With the last message of the attempt, move the staged rows into the
+/// result table.
+bool InfileMerger::_mergeStaged(proto::Result& result, int jobIdAttempt, std::string const& queryIdJobStr) {
+    std::shared_ptr<StagingTable> st;
+    {
+        std::lock_guard<std::mutex> lock(_stagingMtx);
+        auto& entry = _staging[jobIdAttempt];
+        if (entry == nullptr) {
+            entry = std::make_shared<StagingTable>(_mergeTable + "_a" + std::to_string(jobIdAttempt));
+        }
+        st = entry;
+    }
+    std::lock_guard<std::mutex> stLock(st->mtx);
+    if (st->dropped) {
+        // The attempt was scrubbed while waiting.
+        return true;
+    }
+    if (!st->created) {
+        std::string const createStaging = "CREATE TABLE " + st->table + " LIKE " + _shards[0]->table;
+        if (!_applySqlLocal(createStaging, "createStaging")) {
+            return false;
+        }
+        // Staging tables stay on disk even if the result table is in memory.
+        if (_memoryTable && !_applySqlLocal("ALTER TABLE " + st->table + " ENGINE=MyISAM", "createStaging")) {
+            return false;
+        }
+        st->created = true;
+    }
+    int const rowCount = ProtoRowBuffer::getRowCount(result);
+    if (rowCount > 0 && !_loadResult(result, jobIdAttempt, queryIdJobStr, st->table)) {
+        return false;
+    }
+    st->rows += rowCount;
+    if (result.continues()) {
+        return true;
+    }
+    // The attempt is complete, its rows join the result table.
+    std::string const moveRows = "INSERT INTO " + _shards[0]->table + " SELECT * FROM " + st->table;
+    bool ok = _applySqlLocal(moveRows, "moveStaging");
+    if (!ok && _memoryTable && _error.getCode() == ER_RECORD_FILE_FULL && _memoryTableFull(jobIdAttempt)) {
+        ok = _applySqlLocal(moveRows, "moveStaging");
+        if (ok) _error = util::Error();
+    }
+    if (ok) _countRows(jobIdAttempt, st->rows);
+    _dropStagingTable(*st);
+    {
+        std::lock_guard<std::mutex> lock(_stagingMtx);
+        _staging.erase(jobIdAttempt);
+    }
+    return ok;
+}
+
+
+/// Drop the staging table of 'jobIdAttempt', if it has one.
+void InfileMerger::_dropStaging(int jobIdAttempt) {
+    std::shared_ptr<StagingTable> st;
+    {
+        std::lock_guard<std::mutex> lock(_stagingMtx);
+        auto iter = _staging.find(jobIdAttempt);
+        if (iter == _staging.end()) {
+            return;
+        }
+        st = iter->second;
+        _staging.erase(iter);
+    }
+    // Wait for any load into the table to finish.
+    std::lock_guard<std::mutex> stLock(st->mtx);
+    _dropStagingTable(*st);
+}
+
+
+/// Precondition: st.mtx must be held.
+void InfileMerger::_dropStagingTable(StagingTable& st) {
+    if (st.created && !st.dropped) {
+        _applySqlLocal("DROP TABLE IF EXISTS " + st.table, "dropStaging");
+    }
+    st.dropped = true;
+}
+
+
+/// Set 'folded' to true if the rows of 'result' were folded in memory,
+/// false if they still need to be loaded.
+/// @return false if previously folded groups could not be loaded.
+bool InfileMerger::_foldResult(proto::Result const& result, int jobIdAttempt, bool& folded) {
+    std::lock_guard<std::mutex> lock(_aggMtx);
+    folded = false;
+    if (_aggregator == nullptr) {
+        return true;
+    }
+    if (_aggregator->fold(jobIdAttempt, result)) {
+        folded = true;
+        return true;
+    }
+    // Too many groups or an unexpected value, stop folding.
+    return _spillAggregator();
+}
+
+
+/// Load the groups folded so far, keeping their job attempts so that
+/// invalid ones can still be deleted, and stop folding.
+/// Precondition: _aggMtx must be held.
+bool InfileMerger::_spillAggregator() {
+    LOGS(_log, LOG_LVL_INFO, _getQueryIdStr() << " spilling " << _aggregator->getGroupCount()
+         << " folded groups to " << _mergeTable);
+    bool ok = true;
+    _aggregator->extractEach([this, &ok](int jobIdAttempt, proto::Result& result) {
+        if (result.row_size() > 0 && !_sink->add(jobIdAttempt, result)) {
+            ok = false;
+        }
+    });
+    _aggregator.reset();
+    if (!ok) {
+        LOGS(_log, LOG_LVL_ERROR, _getQueryIdStr() << " failed to load folded groups");
+    }
+    return ok;
+}
+
+
+/// Load the groups of all job attempts combined, one row per group.
+bool InfileMerger::_flushAggregator() {
+    std::lock_guard<std::mutex> lock(_aggMtx);
+    if (_aggregator == nullptr) {
+        return true;
+    }
+    proto::Result result;
+    _aggregator->extractAll(result);
+    LOGS(_log, LOG_LVL_DEBUG, _getQueryIdStr() << " folded " << _aggregator->getFoldedRowCount()
+         << " rows into " << result.row_size() << " groups");
+    _aggregator.reset();
+    if (result.row_size() == 0) {
+        return true;
+    }
+    return _loadResult(result, 0, _getQueryIdStr());
+}
+
+
+/// Set 'ranked' to true if the rows of 'result' are held by _topK, false
+/// if they still need to be loaded.
+/// @return false if rows held by _topK could not be loaded.
+bool InfileMerger::_rankResult(proto::Result const& result, int jobIdAttempt, bool& ranked) {
+    std::lock_guard<std::mutex> lock(_aggMtx);
+    ranked = false;
+    if (_topK == nullptr) {
+        return true;
+    }
+    if (_topK->add(jobIdAttempt, result)) {
+        ranked = true;
+        return true;
+    }
+    // An unexpected sort value, load every row from now on.
+    return _spillTopK();
+}
+
+
+/// Load the rows held by _topK, keeping their job attempts so that invalid
+/// ones can still be deleted, and stop ranking.
+/// Precondition: _aggMtx must be held.
+bool InfileMerger::_spillTopK() {
+    LOGS(_log, LOG_LVL_INFO, _getQueryIdStr() << " spilling top " << _config.topK
+         << " rows to " << _mergeTable);
+    bool ok = true;
+    _topK->extractEach([this, &ok](int jobIdAttempt, proto::Result& result) {
+        if (result.row_size() > 0 && !_sink->add(jobIdAttempt, result)) {
+            ok = false;
+        }
+    });
+    _topK.reset();
+    if (!ok) {
+        LOGS(_log, LOG_LVL_ERROR, _getQueryIdStr() << " failed to load top rows");
+    }
+    return ok;
+}
+
+
+/// Load the first topK rows of all job attempts.
+bool InfileMerger::_flushTopK() {
+    std::lock_guard<std::mutex> lock(_aggMtx);
+    if (_topK == nullptr) {
+        return true;
+    }
+    proto::Result result;
+    _topK->extractAll(result);
+    LOGS(_log, LOG_LVL_DEBUG, _getQueryIdStr() << " kept " << result.row_size() << " of "
+         << _topK->getAddedRowCount() << " rows");
+    _topK.reset();
+    if (result.row_size() == 0) {
+        return true;
+    }
+    return _loadResult(result, 0, _getQueryIdStr());
+}
+
+
+/// Set 'held' to true if the rows of 'result' are held by _sorted, false
+/// if they still need to be loaded.
+/// @return false if the rows held are too large, or could not be loaded.
+bool InfileMerger::_sortResult(proto::Result const& result, int jobIdAttempt, bool& held) {
+    std::lock_guard<std::mutex> lock(_aggMtx);
+    held = false;
+    if (_sorted == nullptr) {
+        return true;
+    }
+    if (!_sorted->add(jobIdAttempt, result)) {
+        // Rows out of order or an unexpected sort value, load every row from
+        // now on and let finalize() sort the result table.
+        return _spillSorted();
+    }
+    held = true;
+    // The rows held are not in the result table, whose size is checked on its own.
+    uint64_t const bytes = _sorted->getBytes();
+    if (bytes > _maxResultTableSizeMB * MB_BYTES) {
+        std::ostringstream os;
+        os << _getQueryIdStr() << " cancelling queryResult table " << _mergeTable
+           << " sorted rows too large at " << bytes / MB_BYTES << "MB max allowed=" << _maxResultTableSizeMB;
+        LOGS(_log, LOG_LVL_ERROR, os.str());
+        _error = util::Error(-1, os.str(), -1);
+        return false;
+    }
+    return true;
+}
+
+
+/// Load the rows held by _sorted, keeping their job attempts so that invalid
+/// ones can still be deleted, and stop holding rows.
+/// Precondition: _aggMtx must be held.
+bool InfileMerger::_spillSorted() {
+    LOGS(_log, LOG_LVL_INFO, _getQueryIdStr() << " spilling " << _sorted->getRowCount()
+         << " sorted rows to " << _mergeTable);
+    bool ok = _sorted->extractEach(sortedBatchRows, [this](int jobIdAttempt, proto::Result& result) {
+        return _sink->add(jobIdAttempt, result);
+    });
+    _sorted.reset();
+    if (!ok) {
+        LOGS(_log, LOG_LVL_ERROR, _getQueryIdStr() << " failed to load sorted rows");
+    }
+    return ok;
+}
+
+
+/// Load the rows of all complete job attempts in ORDER BY order.
+bool InfileMerger::_flushSorted() {
+    std::lock_guard<std::mutex> lock(_aggMtx);
+    if (_sorted == nullptr) {
+        return true;
+    }
+    uint64_t const rows = _sorted->getRowCount();
+    bool const ok = _sorted->merge(sortedBatchRows, [this](proto::Result& result) {
+        return _loadResult(result, 0, _getQueryIdStr());
+    });
+    LOGS(_log, LOG_LVL_DEBUG, _getQueryIdStr() << " merged " << rows << " sorted rows");
+    _sorted.reset();
+    _sortedLoaded = ok;
+    return ok;
+}
+
+
+/// Store the rows of 'result' in _sink.
+/// @return false if they could not be stored, or the rows held by _sink
+///         are too large.
+bool InfileMerger::_sinkResult(proto::Result& result, int jobIdAttempt) {
+    if (!_sink->add(jobIdAttempt, result)) {
+        return false;
+    }
+    if (!_sink->holdsRows()) {
+        return true;
+    }
+    // The rows held are not in the result table, whose size is checked on its own.
+    uint64_t const bytes = _sink->getBytes();
+    if (bytes > _maxResultTableSizeMB * MB_BYTES) {
+        std::ostringstream os;
+        os << _getQueryIdStr() << " cancelling queryResult table " << _mergeTable
+           << " held rows too large at " << bytes / MB_BYTES << "MB max allowed=" << _maxResultTableSizeMB;
+        LOGS(_log, LOG_LVL_ERROR, os.str());
+        _error = util::Error(-1, os.str(), -1);
+        return false;
+    }
+    return true;
+}
+
+
+/// Load the rows of all complete job attempts held by _sink.
+bool InfileMerger::_flushSink() {
+    if (!_sink->holdsRows()) {
+        return true;
+    }
+    uint64_t const rows = _sink->getRowCount();
+    bool const ok = _sink->flush([this](int jobIdAttempt, proto::Result& result) {
+        return _loadResult(result, jobIdAttempt, _getQueryIdStr());
+    });
+    LOGS(_log, LOG_LVL_DEBUG, _getQueryIdStr() << " loaded " << rows << " held rows");
+    return ok;
+}
+
+
+/// @return the ORDER BY clause that sorts the result table in sortedOrder.
+std::string InfileMerger::_sortedOrderSql() const {
+    std::string sql;
+    for (auto const& term : _config.sortedOrder) {
+        sql += sql.empty() ? "ORDER BY " : ", ";
+        sql += "`" + term.first + "`" + (term.second ? " DESC" : "");
+    }
+    return sql;
+}
+
+
+bool InfileMerger::MergeShard::setupConnection() {
+    if (mysqlConn.connect()) {
+        infileMgr.attach(mysqlConn.getMySql());
+        return true;
+    }
+    return false;
+}
+
+
+/// @return a shard that no other thread is loading into, or if all of them
+/// are busy, wait for one. 'lock' holds the shard's mutex on return.
+InfileMerger::MergeShard& InfileMerger::_lockShard(std::unique_lock<std::mutex>& lock) {
+    size_t const count = _shards.size();
+    size_t const start = _nextShard++;
+    for (size_t j = 0; j < count; ++j) {
+        MergeShard& shard = *_shards[(start + j) % count];
+        std::unique_lock<std::mutex> tryLock(shard.mysqlMutex, std::try_to_lock);
+        if (tryLock.owns_lock()) {
+            lock = std::move(tryLock);
+            return shard;
+        }
+    }
+    MergeShard& shard = *_shards[start % count];
+    if (mergeShardLockTiming.sample()) {
+        util::Timer timeToLock;
+        timeToLock.start();
+        lock = std::unique_lock<std::mutex>(shard.mysqlMutex);
+        timeToLock.stop();
+        mergeShardLockTiming.addWait(timeToLock.getElapsed());
+    } else {
+        lock = std::unique_lock<std::mutex>(shard.mysqlMutex);
+    }
+    return shard;
+}
+
+
+/// Load each row of 'result' into the shard picked by its _partitionCols values.
+bool InfileMerger::_loadPartitioned(proto::Result& result, int jobIdAttempt, std::string const& queryIdJobStr) {
+    size_t const count = _shards.size();
+    std::vector<proto::Result> parts(count);
+    int const rowCount = ProtoRowBuffer::getRowCount(result);
+    std::hash<std::string> hashStr;
+    for (int j = 0; j < rowCount; ++j) {
+        size_t hash = 0;
+        for (int col : _partitionCols) {
+            size_t colHash = 0;
+            if (result.columnblock_size() > 0) {
+                proto::ColumnBlock const& block = result.columnblock(col);
+                std::string const& nullBitmap = block.nullbitmap();
+                size_t byteIdx = j / 8;
+                if (!(byteIdx < nullBitmap.size() && (nullBitmap[byteIdx] & (1 << (j % 8))))) {
+                    uint32_t begin = (j == 0) ? 0 : block.offsets(j - 1);
+                    colHash = hashStr(block.values().substr(begin, block.offsets(j) - begin));
                 }
-                LOGS(_log, LOG_LVL_ERROR, os.str());
-                _error = util::Error(-1, os.str(), -1);
-                return false;
+            } else if (!result.row(j).isnull(col)) {
+                colHash = hashStr(result.row(j).column(col));
             }
+            hash = hash * 31 + colHash;
         }
+        copyRow(result, j, parts[hash % count]);
     }
-    return ret;
+    for (size_t j = 0; j < count; ++j) {
+        proto::Result& part = parts[j];
+        if (part.row_size() == 0) {
+            continue;
+        }
+        *part.mutable_rowschema() = result.rowschema();
+        part.set_rowcount(part.row_size());
+        auto pRowBuffer = std::make_shared<ProtoRowBuffer>(part, jobIdAttempt, _jobIdColName,
+                                                           _jobIdSqlType, _jobIdMysqlType);
+        MergeShard& shard = *_shards[j];
+        std::lock_guard<std::mutex> lock(shard.mysqlMutex);
+        std::string const virtFile = shard.infileMgr.prepareSrc(pRowBuffer, queryIdJobStr);
+        if (!_applyMysql(shard, sql::formLoadInfile(shard.table, virtFile))) {
+            return false;
+        }
+    }
+    return true;
 }
 
 
-bool InfileMerger::_applyMysql(std::string const& query) {
-    std::lock_guard<std::mutex> lock(_mysqlMutex);
-    if (!_mysqlConn.connected()) {
+/// Run the merge statement on every shard at the same time, each holding
+/// whole groups, and gather the merged rows into the target table.
+bool InfileMerger::_mergePartitions() {
+    size_t const count = _shards.size();
+    std::vector<std::string> parts;
+    std::vector<std::string> creates;
+    for (size_t j = 0; j < count; ++j) {
+        parts.push_back(_config.targetTable + "_p" + std::to_string(j));
+        auto stmt = _config.mergeStmt->clone();
+        stmt->setFromListAsTable(_shards[j]->table);
+        creates.push_back("CREATE TABLE " + parts[j] + " ENGINE=MyISAM "
+                          + stmt->getQueryTemplate().sqlFragment());
+    }
+    LOGS(_log, LOG_LVL_DEBUG, "Merging " << count << " shards w/" << creates[0]);
+    std::vector<char> merged(count, 0);
+    std::vector<std::thread> threads;
+    for (size_t j = 0; j < count; ++j) {
+        threads.emplace_back([this, j, &creates, &merged]() {
+            MergeShard& shard = *_shards[j];
+            std::lock_guard<std::mutex> lock(shard.mysqlMutex);
+            merged[j] = _applyMysql(shard, creates[j]);
+            if (!merged[j]) {
+                LOGS(_log, LOG_LVL_ERROR, _getQueryIdStr() << " merging " << shard.table << " failed: "
+                     << mysql_error(shard.mysqlConn.getMySql()));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    bool ok = std::all_of(merged.begin(), merged.end(), [](char m) { return m != 0; });
+    if (!ok) {
+        _error = InfileMergerError(util::ErrorCode::MYSQLEXEC, "Error merging shards of " + _mergeTable);
+    } else {
+        // Groups are in a single shard, so the merged rows of the shards just add up.
+        ok = _applySqlLocal("RENAME TABLE " + parts[0] + " TO " + _config.targetTable, "gatherShards");
+        for (size_t j = 1; ok && j < count; ++j) {
+            ok = _applySqlLocal("INSERT INTO " + _config.targetTable + " SELECT * FROM " + parts[j],
+                                "gatherShards");
+        }
+    }
+    for (auto const& part : parts) {
+        sql::SqlErrorObject eObj;
+        _sqlConn->dropTable(part, eObj, false, _config.mySqlConfig.dbName);
+    }
+    return ok;
+}
+
+
+/// Precondition: the shard's mysqlMutex must be held.
+bool InfileMerger::_applyMysql(MergeShard& shard, std::string const& query) {
+    if (!shard.mysqlConn.connected()) {
         // should have connected during construction
         // Try reconnecting--maybe we timed out.
-        if (!_setupConnection()) {
-            LOGS(_log, LOG_LVL_ERROR, "InfileMerger::_applyMysql _setupConnection() failed!!!");
+        if (!shard.setupConnection()) {
+            LOGS(_log, LOG_LVL_ERROR, "InfileMerger::_applyMysql setupConnection() failed!!!");
             return false; // Reconnection failed. This is an error.
         }
     }
 
-    int rc = mysql_real_query(_mysqlConn.getMySql(),
+    int rc = mysql_real_query(shard.mysqlConn.getMySql(),
                               query.data(), query.size());
     return rc == 0;
 }
 
 
+/// Create 'unionTable' as a MERGE table over all the shard tables.
+bool InfileMerger::_unionShards(std::string const& unionTable) {
+    std::string tables;
+    for (auto const& shard : _shards) {
+        if (!tables.empty()) tables += ",";
+        tables += shard->table;
+    }
+    std::string const createUnion = "CREATE TABLE " + unionTable + " LIKE " + _shards[0]->table;
+    std::string const alterUnion = "ALTER TABLE " + unionTable
+        + " ENGINE=MERGE UNION=(" + tables + ") INSERT_METHOD=NO";
+    return _applySqlLocal(createUnion, "createUnion") && _applySqlLocal(alterUnion, "alterUnion");
+}
+
+
+/// Drop the shard tables, only used when there is more than one shard.
+void InfileMerger::_dropShards() {
+    for (auto const& shard : _shards) {
+        sql::SqlErrorObject eObj;
+        if (!_sqlConn->dropTable(shard->table, eObj, false, _config.mySqlConfig.dbName)) {
+            LOGS(_log, LOG_LVL_DEBUG, "Failure cleaning up table " << shard->table);
+        }
+    }
+}
+
+
 bool InfileMerger::finalize() {
     bool finalizeOk = true;
     // TODO: Should check for error condition before continuing.
@@ -272,7 +947,74 @@ bool InfileMerger::finalize() {
         LOGS(_log, LOG_LVL_ERROR, " failed to remove invalid rows.");
         return false;
     }
-    if (_mergeTable != _config.targetTable) {
+    // Attempts still staged never sent their last message.
+    std::vector<int> unfinished;
+    {
+        std::lock_guard<std::mutex> lock(_stagingMtx);
+        for (auto const& elem : _staging) {
+            unfinished.push_back(elem.first);
+        }
+    }
+    for (int jobIdAttempt : unfinished) {
+        LOGS(_log, LOG_LVL_WARN, _getQueryIdStr() << " dropping incomplete job attempt " << jobIdAttempt);
+        _dropStaging(jobIdAttempt);
+    }
+    if (!_flushAggregator()) {
+        _error = InfileMergerError(util::ErrorCode::MYSQLEXEC, "Error loading folded groups");
+        return false;
+    }
+    if (!_flushTopK()) {
+        _error = InfileMergerError(util::ErrorCode::MYSQLEXEC, "Error loading top rows");
+        return false;
+    }
+    if (!_flushSorted()) {
+        _error = InfileMergerError(util::ErrorCode::MYSQLEXEC, "Error loading sorted rows");
+        return false;
+    }
+    if (!_flushSink()) {
+        _error = InfileMergerError(util::ErrorCode::MYSQLEXEC, "Error loading held rows");
+        return false;
+    }
+    // Unless the sorted rows were loaded in order, the result table is sorted here.
+    bool const resort = !_config.sortedOrder.empty() && !_sortedLoaded;
+    bool const sharded = _shards.size() > 1;
+    if (sharded) {
+        std::lock_guard<std::mutex> lockTable(_createTableMutex);
+        if (_needCreateTable) {
+            LOGS(_log, LOG_LVL_DEBUG, "No rows merged, nothing to finalize");
+            _isFinished = true;
+            return true;
+        }
+    }
+    if (sharded && _mergeTable == _config.targetTable) {
+        // Copy the shards into the target table, leaving out the jobId column.
+        std::string const unionTable = _config.targetTable + "_u";
+        std::string columns;
+        for (auto const& col : _resultColumns) {
+            if (!columns.empty()) columns += ",";
+            columns += "`" + col + "`";
+        }
+        finalizeOk = _unionShards(unionTable);
+        if (finalizeOk) {
+            std::string createTarget = "CREATE TABLE " + _config.targetTable
+                + " ENGINE=MyISAM SELECT " + columns + " FROM " + unionTable;
+            if (resort) {
+                createTarget += " " + _sortedOrderSql();
+            }
+            LOGS(_log, LOG_LVL_DEBUG, "Merging shards w/" << createTarget);
+            finalizeOk = _applySqlLocal(createTarget, "createTarget");
+        }
+        sql::SqlErrorObject eObj;
+        _sqlConn->dropTable(unionTable, eObj, false, _config.mySqlConfig.dbName);
+        _dropShards();
+    } else if (!_partitionCols.empty()) {
+        finalizeOk = _mergePartitions();
+        _dropShards();
+    } else if (_mergeTable != _config.targetTable) {
+        // The merge statement reads _mergeTable, which is a MERGE table over the shards if sharded.
+        if (sharded && !_unionShards(_mergeTable)) {
+            return false;
+        }
         // Aggregation needed: Do the aggregation.
         std::string mergeSelect = _config.mergeStmt->getQueryTemplate().sqlFragment();
         // Using MyISAM as single thread writing with no need to recover from errors.
@@ -295,11 +1037,17 @@ bool InfileMerger::finalize() {
         if (!cleanupOk) {
             LOGS(_log, LOG_LVL_DEBUG, "Failure cleaning up table " << _mergeTable);
         }
+        if (sharded) {
+            _dropShards();
+        }
     } else {
         // Remove jobId and attemptCount information from the result table.
         // Returning a view could be faster, but is more complicated.
         std::string sqlDropCol = std::string("ALTER TABLE ") + _mergeTable
                                + " DROP COLUMN " +  _jobIdColName;
+        if (resort) {
+            sqlDropCol += ", " + _sortedOrderSql();
+        }
         LOGS(_log, LOG_LVL_DEBUG, "Removing w/" << sqlDropCol);
         finalizeOk = _applySqlLocal(sqlDropCol, "dropCol Removing");
     }
@@ -314,6 +1062,24 @@ bool InfileMerger::isFinished() const {
 
 
 bool InfileMerger::_deleteInvalidRows(InvalidJobAttemptMgr::jASetType const& jobIdAttempts) {
+    {
+        std::lock_guard<std::mutex> lock(_aggMtx);
+        if (_aggregator) {
+            _aggregator->erase(jobIdAttempts);
+        }
+        if (_topK) {
+            _topK->erase(jobIdAttempts);
+        }
+        if (_sorted) {
+            _sorted->erase(jobIdAttempts);
+        }
+    }
+    return _sink->erase(jobIdAttempts);
+}
+
+
+/// Delete the rows of 'jobIdAttempts' from the result table, or its shards.
+bool InfileMerger::_deleteTableRows(InvalidJobAttemptMgr::jASetType const& jobIdAttempts) {
     // delete several rows at a time
     unsigned int maxSize = 950000; /// default 1mb limit
     auto iter = jobIdAttempts.begin();
@@ -330,12 +1096,14 @@ bool InfileMerger::_deleteInvalidRows(InvalidJobAttemptMgr::jASetType const& job
             invalidStr += std::to_string(*iter);
             ++iter;
         }
-        std::string sqlDelRows = std::string("DELETE FROM ") + _mergeTable
-                + " WHERE " + _jobIdColName + " IN (" + invalidStr + ")";
-        bool ok = _applySqlLocal(sqlDelRows, "deleteInvalidRows");
-        if (!ok) {
-            LOGS(_log, LOG_LVL_ERROR, "Failed to drop columns w/" << sqlDelRows);
-            return false;
+        for (auto const& shard : _shards) {
+            std::string sqlDelRows = std::string("DELETE FROM ") + shard->table
+                    + " WHERE " + _jobIdColName + " IN (" + invalidStr + ")";
+            bool ok = _applySqlLocal(sqlDelRows, "deleteInvalidRows");
+            if (!ok) {
+                LOGS(_log, LOG_LVL_ERROR, "Failed to drop columns w/" << sqlDelRows);
+                return false;
+            }
         }
     }
     return true;
@@ -355,9 +1123,96 @@ int InfileMerger::makeJobIdAttempt(int jobId, int attemptCount) {
 }
 
 
+std::vector<std::pair<std::string, double>> InfileMerger::getSampleErrors() const {
+    std::vector<std::pair<std::string, double>> errors;
+    std::lock_guard<std::mutex> lock(_sampleMtx);
+    double const n = _sampleValues.size();
+    if (n < 2 || _config.sampleEvery <= 1) {
+        return errors;
+    }
+    // The total estimated from n chunks, each picked with probability
+    // f = 1/sampleEvery, has a relative standard error of about
+    // sqrt((1 - f) / n) * stddev / mean of the values of the chunks.
+    double const fpc = 1.0 - 1.0 / _config.sampleEvery;
+    for (size_t j = 0; j < _sampleColNames.size(); ++j) {
+        double sum = 0;
+        double sumSq = 0;
+        for (auto const& elem : _sampleValues) {
+            double const val = elem.second.second[j];
+            sum += val;
+            sumSq += val * val;
+        }
+        double const mean = sum / n;
+        if (mean == 0) continue;
+        double const var = std::max(0.0, (sumSq - n * mean * mean) / (n - 1));
+        errors.emplace_back(_sampleColNames[j], std::sqrt(fpc / n * var) / std::fabs(mean));
+    }
+    return errors;
+}
+
+
+/// Add the values of _sampleCols in 'result' to those of its job attempt.
+/// Values of an earlier attempt of the job are replaced by a later one.
+void InfileMerger::_recordSample(proto::Result const& result) {
+    proto::Result rows;
+    int const rowCount = ProtoRowBuffer::getRowCount(result);
+    for (int j = 0; j < rowCount; ++j) {
+        copyRow(result, j, rows);
+    }
+    std::lock_guard<std::mutex> lock(_sampleMtx);
+    if (_sampleColNames.empty()
+        && result.rowschema().columnschema_size() == static_cast<int>(_config.aggFold->size())) {
+        for (int col : _sampleCols) {
+            _sampleColNames.push_back(result.rowschema().columnschema(col).name());
+        }
+    }
+    auto& entry = _sampleValues[result.jobid()];
+    if (entry.second.empty() || result.attemptcount() > entry.first) {
+        entry.first = result.attemptcount();
+        entry.second.assign(_sampleCols.size(), 0.0);
+    } else if (result.attemptcount() < entry.first) {
+        return;
+    }
+    for (auto const& row : rows.row()) {
+        for (size_t j = 0; j < _sampleCols.size(); ++j) {
+            int const col = _sampleCols[j];
+            if (col < row.column_size() && !row.isnull(col)) {
+                entry.second[j] += std::strtod(row.column(col).c_str(), nullptr);
+            }
+        }
+    }
+}
+
+
 bool InfileMerger::prepScrub(int jobId, int attemptCount) {
     int jobIdAttempt = makeJobIdAttempt(jobId, attemptCount);
-    return _invalidJobAttemptMgr.prepScrub(jobIdAttempt);
+    bool invalidRowsInResult = _invalidJobAttemptMgr.prepScrub(jobIdAttempt);
+    // Rows that had not reached the result table yet go with their table.
+    _dropStaging(jobIdAttempt);
+    _uncountRows(jobIdAttempt);
+    return invalidRowsInResult;
+}
+
+
+/// Add 'rows' rows of 'jobIdAttempt' to the count of merged rows.
+void InfileMerger::_countRows(int jobIdAttempt, int64_t rows) {
+    if (_config.rowLimit <= 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(_attemptRowsMtx);
+    _attemptRows[jobIdAttempt] += rows;
+    _mergedRows += rows;
+}
+
+
+/// Remove the rows of a scrubbed 'jobIdAttempt' from the count of merged rows.
+void InfileMerger::_uncountRows(int jobIdAttempt) {
+    std::lock_guard<std::mutex> lock(_attemptRowsMtx);
+    auto iter = _attemptRows.find(jobIdAttempt);
+    if (iter != _attemptRows.end()) {
+        _mergedRows -= iter->second;
+        _attemptRows.erase(iter);
+    }
 }
 
 
@@ -392,7 +1247,15 @@ bool InfileMerger::_applySqlLocal(std::string const& sql) {
 
 
 bool InfileMerger::_sqlConnect(sql::SqlErrorObject& errObj) {
-    if (_sqlConn == nullptr) {
+    if (_sqlConn == nullptr && _config.sqlConnPool != nullptr) {
+        _sqlConn = _config.sqlConnPool->acquire("merger", errObj);
+        if (_sqlConn == nullptr) {
+            _error = util::Error(errObj.errNo(), "Error connecting to db: " + errObj.printErrMsg(),
+                           util::ErrorCode::MYSQLCONNECT);
+            LOGS(_log, LOG_LVL_ERROR, "InfileMerger error: " << _error.getMsg());
+            return false;
+        }
+    } else if (_sqlConn == nullptr) {
         _sqlConn = std::make_shared<sql::SqlConnection>(_config.mySqlConfig, true);
         if (not _sqlConn->connectToDb(errObj)) {
             _error = util::Error(errObj.errNo(), "Error connecting to db: " + errObj.printErrMsg(),
@@ -408,11 +1271,22 @@ bool InfileMerger::_sqlConnect(sql::SqlErrorObject& errObj) {
 
 
 size_t InfileMerger::_getResultTableSizeMB() {
+    std::string tableNames;
+    for (auto const& shard : _shards) {
+        if (!tableNames.empty()) tableNames += ",";
+        tableNames += "'" + shard->table + "'";
+    }
+    {
+        std::lock_guard<std::mutex> lock(_stagingMtx);
+        for (auto const& elem : _staging) {
+            tableNames += ",'" + elem.second->table + "'";
+        }
+    }
     std::string tableSizeSql = std::string("SELECT table_name, ")
                              + "round(((data_length + index_length) / 1048576), 2) as 'MB' "
                              + "FROM information_schema.TABLES "
                              + "WHERE table_schema = '" + _config.mySqlConfig.dbName
-                             + "' AND table_name = '" + _mergeTable + "'";
+                             + "' AND table_name IN (" + tableNames + ")";
     LOGS(_log, LOG_LVL_DEBUG, "Checking ResultTableSize " << tableSizeSql);
     std::lock_guard<std::mutex> m(_sqlMutex);
     sql::SqlErrorObject errObj;
@@ -427,18 +1301,21 @@ size_t InfileMerger::_getResultTableSizeMB() {
         return 0;
     }
 
-    // There should only be 1 row
+    // There should be 1 row per shard table
     auto iter = results.begin();
     if (iter == results.end()) {
         LOGS(_log, LOG_LVL_ERROR, _getQueryIdStr() << " result table size no rows returned " << _mergeTable);
         return 0;
     }
-    auto& row = *iter;
-    std::string tbName = row[0].first;
-    std::string tbSize = row[1].first;
-    size_t sz = std::stoul(tbSize);
-    LOGS(_log, LOG_LVL_DEBUG,
-         _getQueryIdStr() << " ResultTableSizeMB tbl=" << tbName << " tbSize=" << tbSize);
+    size_t sz = 0;
+    for (; iter != results.end(); ++iter) {
+        auto& row = *iter;
+        std::string tbName = row[0].first;
+        std::string tbSize = row[1].first;
+        sz += std::stoul(tbSize);
+        LOGS(_log, LOG_LVL_DEBUG,
+             _getQueryIdStr() << " ResultTableSizeMB tbl=" << tbName << " tbSize=" << tbSize);
+    }
     return sz;
 }
 
@@ -517,10 +1394,31 @@ bool InfileMerger::_setupTable(proto::WorkerResponse const& response) {
             schema.columns.push_back(scs);
             schema.columns.insert(schema.columns.end(), sch.columns.begin(), sch.columns.end());
         }
-        std::string createStmt = sql::formCreateTable(_mergeTable, schema);
+        _resultColumns.clear();
+        for (auto const& col : sch.columns) {
+            _resultColumns.push_back(col.name);
+        }
+        std::string createStmt = sql::formCreateTable(_shards[0]->table, schema);
         // Specifying engine. There is some question about whether InnoDB or MyISAM is the better
         // choice when multiple threads are writing to the result table.
-        createStmt += " ENGINE=MyISAM";
+        // Rows that need no merge step go straight to the client, so they are
+        // kept in memory while they fit, as are the rows of a small result.
+        if (_canUseMemoryTable(sch)) {
+            std::string const setHeap = "SET SESSION max_heap_table_size = "
+                + std::to_string(_config.memoryTableMaxMB * 1024 * 1024);
+            if (_applySqlLocal(setHeap, "setupTable heap size")) {
+                _memoryTable = true;
+            }
+        }
+        createStmt += _memoryTable ? " ENGINE=MEMORY" : " ENGINE=MyISAM";
+        // The merge table carries no index while rows are loaded. It is only
+        // read once by the merge statement and dropped, so partitioning it
+        // costs nothing in finalize(). A MERGE table cannot cover partitioned
+        // shards.
+        if (_config.mergeStmt && !_memoryTable && _shards.size() == 1 && _config.jobIdPartitions > 1) {
+            createStmt += " PARTITION BY HASH(" + _jobIdColName + ") PARTITIONS "
+                + std::to_string(_config.jobIdPartitions);
+        }
         LOGS(_log, LOG_LVL_DEBUG, _getQueryIdStr() << "InfileMerger query prepared: " << createStmt);
 
         if (not _applySqlLocal(createStmt, "setupTable")) {
@@ -530,6 +1428,55 @@ bool InfileMerger::_setupTable(proto::WorkerResponse const& response) {
             LOGS(_log, LOG_LVL_ERROR, _getQueryIdStr() << "InfileMerger sql error: " << _error.getMsg());
             return false;
         }
+        for (size_t j = 1; j < _shards.size(); ++j) {
+            std::string createShard = "CREATE TABLE " + _shards[j]->table + " LIKE " + _shards[0]->table;
+            if (not _applySqlLocal(createShard, "setupTable shard")) {
+                _error = InfileMergerError(util::ErrorCode::CREATE_TABLE,
+                                           "Error creating table (" + _shards[j]->table + ")");
+                _isFinished = true; // Cannot continue.
+                LOGS(_log, LOG_LVL_ERROR, _getQueryIdStr() << "InfileMerger sql error: " << _error.getMsg());
+                return false;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> aggLock(_aggMtx);
+            if (_aggregator && !_aggregator->setSchema(rs)) {
+                LOGS(_log, LOG_LVL_DEBUG, _getQueryIdStr() << " result columns cannot be folded");
+                _aggregator.reset();
+            }
+            if (_topK && !_topK->setSchema(rs)) {
+                LOGS(_log, LOG_LVL_DEBUG, _getQueryIdStr() << " result rows cannot be ranked");
+                _topK.reset();
+            }
+            if (_sorted && !_sorted->setSchema(rs)) {
+                LOGS(_log, LOG_LVL_DEBUG, _getQueryIdStr() << " result rows cannot be merged in order");
+                _sorted.reset();
+            }
+        }
+        if (!_sink->setSchema(rs)) {
+            _error = InfileMergerError(util::ErrorCode::CREATE_TABLE,
+                                       "Result sink cannot hold the columns of " + _mergeTable);
+            _isFinished = true; // Cannot continue.
+            LOGS(_log, LOG_LVL_ERROR, _getQueryIdStr() << "InfileMerger sink error: " << _error.getMsg());
+            return false;
+        }
+        _partitionCols.clear();
+        for (auto const& name : _groupByColumns) {
+            int found = -1;
+            for (int col = 0; col < rs.columnschema_size(); ++col) {
+                if (rs.columnschema(col).name() == name) {
+                    found = col;
+                    break;
+                }
+            }
+            if (found < 0 || !hasCanonicalText(rs.columnschema(found).mysqltype())) {
+                LOGS(_log, LOG_LVL_DEBUG, _getQueryIdStr() << " groups cannot be split over shards by "
+                     << name);
+                _partitionCols.clear();
+                break;
+            }
+            _partitionCols.push_back(found);
+        }
         _needCreateTable = false;
     } else {
         // Do nothing, table already created.
@@ -539,6 +1486,53 @@ bool InfileMerger::_setupTable(proto::WorkerResponse const& response) {
 }
 
 
+/// @return true if the result table can use the MEMORY engine.
+bool InfileMerger::_canUseMemoryTable(sql::Schema const& schema) const {
+    if ((_config.mergeStmt && !_config.smallResult) || _config.memoryTableMaxMB == 0
+        || _shards.size() != 1) {
+        return false;
+    }
+    for (auto const& col : schema.columns) {
+        // MEMORY tables cannot hold BLOB or TEXT columns.
+        switch (col.colType.mysqlType) {
+        case MYSQL_TYPE_TINY_BLOB:
+        case MYSQL_TYPE_MEDIUM_BLOB:
+        case MYSQL_TYPE_LONG_BLOB:
+        case MYSQL_TYPE_BLOB:
+            return false;
+        default:
+            break;
+        }
+        std::string sqlType = col.colType.sqlType;
+        std::transform(sqlType.begin(), sqlType.end(), sqlType.begin(), ::toupper);
+        if (sqlType.find("BLOB") != std::string::npos || sqlType.find("TEXT") != std::string::npos) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/// Move the MEMORY result table to disk once it is full, removing the rows
+/// of 'jobIdAttempt' that were only partly loaded.
+/// @return true if the rows of 'jobIdAttempt' can be loaded again.
+bool InfileMerger::_memoryTableFull(int jobIdAttempt) {
+    std::lock_guard<std::mutex> lock(_memoryTableMtx);
+    if (_memoryTable) {
+        LOGS(_log, LOG_LVL_INFO, _getQueryIdStr() << " result table " << _shards[0]->table
+             << " is over " << _config.memoryTableMaxMB << "MB, moving it to disk");
+        std::string const alter = "ALTER TABLE " + _shards[0]->table + " ENGINE=MyISAM";
+        if (!_applySqlLocal(alter, "memoryTableFull")) {
+            return false;
+        }
+        _memoryTable = false;
+    }
+    std::string const sqlDelRows = "DELETE FROM " + _shards[0]->table
+        + " WHERE " + _jobIdColName + " = " + std::to_string(jobIdAttempt);
+    return _applySqlLocal(sqlDelRows, "memoryTableFull deleteRows");
+}
+
+
 /// Choose the appropriate target name, depending on whether post-processing is
 /// needed on the result rows.
 void InfileMerger::_fixupTargetName() {
@@ -557,7 +1551,7 @@ void InfileMerger::_fixupTargetName() {
 }
 
 
-bool InvalidJobAttemptMgr::incrConcurrentMergeCount(int jobIdAttempt) {
+bool InvalidJobAttemptMgr::incrConcurrentMergeCount(int jobIdAttempt, bool addsRows) {
     std::unique_lock<std::mutex> uLock(_iJAMtx);
     if (_isJobAttemptInvalid(jobIdAttempt)) {
         LOGS(_log, LOG_LVL_INFO, jobIdAttempt << " invalid, not merging");
@@ -572,7 +1566,9 @@ bool InvalidJobAttemptMgr::incrConcurrentMergeCount(int jobIdAttempt) {
             return true;
         }
     }
-    _jobIdAttemptsHaveRows.insert(jobIdAttempt);
+    if (addsRows) {
+        _jobIdAttemptsHaveRows.insert(jobIdAttempt);
+    }
     ++_concurrentMergeCount;
     // No rows can be deleted until after decrConcurrentMergeCount() is called, which
     // should ensure that all rows added for this job attempt can be deleted by
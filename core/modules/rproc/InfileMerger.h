@@ -30,15 +30,25 @@
 /// (see individual class documentation for more information)
 
 // System headers
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 // Qserv headers
 #include "mysql/LocalInfile.h"
 #include "mysql/MySqlConfig.h"
 #include "mysql/MySqlConnection.h"
+#include "proto/InMemoryAggregator.h"
+#include "rproc/InMemoryTopK.h"
+#include "rproc/ResultSink.h"
+#include "rproc/SortedRunMerger.h"
 #include "sql/SqlConnection.h"
 #include "util/Error.h"
 #include "util/EventThread.h"
@@ -62,6 +72,8 @@ namespace query {
 }
 namespace sql {
     class SqlConnection;
+    class SqlConnectionPool;
+    class Schema;
 }
 }} // End of forward declarations
 
@@ -91,6 +103,57 @@ public:
     mysql::MySqlConfig const mySqlConfig;
     std::string targetTable;
     std::shared_ptr<query::SelectStmt> mergeStmt;
+    /// Number of tables, each with its own connection, that rows are loaded
+    /// into concurrently. They are combined with a MERGE table in finalize().
+    int mergeShards{1};
+    /// How to fold the partial results of each parallel column, or nullptr
+    /// if they cannot be folded before mergeStmt runs.
+    std::shared_ptr<query::AggRecord::FoldVector const> aggFold;
+    /// Maximum number of groups to fold in memory, 0 disables folding.
+    size_t aggMaxGroups{0};
+    /// Without mergeStmt, the result table uses the MEMORY engine until it
+    /// holds this many MB, then moves to disk. 0 always uses disk.
+    size_t memoryTableMaxMB{0};
+    /// True if the planner expects few rows, the merge table of mergeStmt
+    /// then uses the MEMORY engine under memoryTableMaxMB as well.
+    bool smallResult{false};
+    /// Number of partitions, by jobId column, of a merge table on disk, so
+    /// that the rows of an invalid job attempt are deleted from a single
+    /// partition. 0 or 1 does not partition it.
+    int jobIdPartitions{0};
+    /// Rows that complete the user query when every merged row is a final
+    /// result row, 0 if there is no such limit.
+    int64_t rowLimit{0};
+    /// Number of rows of an ORDER BY ... LIMIT query, kept in memory in the
+    /// order of topKOrder as results arrive when at most topKMaxRows. 0 if
+    /// every row must be loaded.
+    int64_t topK{0};
+    std::vector<std::pair<std::string, bool>> topKOrder;
+    int64_t topKMaxRows{0};
+    /// ORDER BY of a query without LIMIT whose chunk queries sort their
+    /// rows. The result table receives the rows in this order, which the
+    /// sorted chunk results are merged in when there is one shard and
+    /// sortedRunDir is set. Otherwise the table is sorted by finalize().
+    std::vector<std::pair<std::string, bool>> sortedOrder;
+    /// Local directory of the files holding the sorted chunk results until
+    /// they are merged, empty to sort the result table instead.
+    std::string sortedRunDir;
+    /// The chunk results are a sample of about one chunk in sampleEvery when
+    /// more than 1, see InfileMerger::getSampleErrors().
+    int sampleEvery{0};
+    /// Where rows not held in memory by the aggregator, top K or sorted
+    /// runs are stored until finalize(). MYSQL loads them into the result
+    /// table as they arrive.
+    ResultSink::Kind resultSink{ResultSink::MYSQL};
+    /// Local directory of the rows a COLUMNAR sink holds past
+    /// resultSinkMemoryMB.
+    std::string resultSinkDir;
+    size_t resultSinkMemoryMB{0};
+    /// Called with the result bytes and rows of each message merged, if set.
+    std::function<void(uint64_t bytes, uint64_t rows)> onMerged;
+    /// Pool to lease the connection for merge and cleanup statements from,
+    /// a connection of its own is opened if null.
+    std::shared_ptr<sql::SqlConnectionPool> sqlConnPool;
 };
 
 
@@ -115,10 +178,11 @@ public:
 
     /// @return true if jobIdAttempt is invalid.
     /// Wait if rows need to be deleted.
-    /// Then, add job-attempt to _jobIdAttemptsHaveRows and increment
-    /// _concurrentMergeCount to keep rows from being deleted before
+    /// Then, add job-attempt to _jobIdAttemptsHaveRows, unless 'addsRows' is
+    /// false because its rows go somewhere other than the result table, and
+    /// increment _concurrentMergeCount to keep rows from being deleted before
     /// decrConcurrentMergeCount is called.
-    bool incrConcurrentMergeCount(int jobIdAttempt);
+    bool incrConcurrentMergeCount(int jobIdAttempt, bool addsRows=true);
     void decrConcurrentMergeCount();
 
 
@@ -151,7 +215,8 @@ private:
 
 /// InfileMerger is a row-based merger that imports rows from result messages
 /// and inserts them into a MySQL table, as specified during construction by
-/// InfileMergerConfig.
+/// InfileMergerConfig. With a COLUMNAR result sink, the rows are held on
+/// the czar until finalize() and then loaded into the table in blocks.
 ///
 /// To use, construct a configured instance, then call merge() to kick off the
 /// merging process, and finalize() to wait for outstanding merging processes
@@ -185,14 +250,73 @@ public:
     bool finalize();
     /// Check if the object has completed all processing.
     bool isFinished() const;
+    /// @return true once config.rowLimit rows have been merged, after which
+    ///         further rows are dropped.
+    bool limitReached() const {
+        return _config.rowLimit > 0 && _mergedRows >= _config.rowLimit;
+    }
 
     bool prepScrub(int jobId, int attempt);
     bool scrubResults(int jobId, int attempt);
     int makeJobIdAttempt(int jobId, int attemptCount);
 
+    /// @return the name of each parallel SUM column of a sampled query
+    ///         without GROUP BY, and the relative standard error of its
+    ///         total over all chunks estimated from the spread of the values
+    ///         of the sampled chunks. Empty if it cannot be estimated.
+    std::vector<std::pair<std::string, double>> getSampleErrors() const;
+
 private:
-    bool _applyMysql(std::string const& query);
+    /// One connection loading rows into its own table, so that several
+    /// LOAD DATA statements for the same user query can run at once.
+    struct MergeShard {
+        MergeShard(mysql::MySqlConfig const& mySqlConfig, std::string const& table_)
+            : mysqlConn(mySqlConfig), table(table_) {}
+        bool setupConnection();
+
+        mysql::MySqlConnection mysqlConn;
+        std::mutex mysqlMutex; ///< Protects mysqlConn and infileMgr
+        mysql::LocalInfile::Mgr infileMgr;
+        std::string const table;
+    };
+
+    MergeShard& _lockShard(std::unique_lock<std::mutex>& lock);
+    bool _loadPartitioned(proto::Result& result, int jobIdAttempt, std::string const& queryIdJobStr);
+    bool _mergePartitions();
+    bool _applyMysql(MergeShard& shard, std::string const& query);
+    bool _unionShards(std::string const& unionTable);
+    void _dropShards();
     bool _merge(std::shared_ptr<proto::WorkerResponse>& response);
+    /// Rows of one job attempt held apart from the result table.
+    struct StagingTable {
+        explicit StagingTable(std::string const& table_) : table(table_) {}
+        std::mutex mtx; ///< Held while loading into or dropping the table.
+        std::string const table;
+        bool created{false};
+        bool dropped{false};
+        int64_t rows{0}; ///< Number of rows loaded into the table.
+    };
+
+    bool _loadResult(proto::Result& result, int jobIdAttempt, std::string const& queryIdJobStr,
+                     std::string const& table=std::string());
+    bool _canUseMemoryTable(sql::Schema const& schema) const;
+    bool _memoryTableFull(int jobIdAttempt);
+    bool _isStaged(int jobIdAttempt);
+    bool _mergeStaged(proto::Result& result, int jobIdAttempt, std::string const& queryIdJobStr);
+    void _dropStaging(int jobIdAttempt);
+    void _dropStagingTable(StagingTable& st);
+    bool _foldResult(proto::Result const& result, int jobIdAttempt, bool& folded);
+    bool _spillAggregator();
+    bool _flushAggregator();
+    bool _rankResult(proto::Result const& result, int jobIdAttempt, bool& ranked);
+    bool _spillTopK();
+    bool _flushTopK();
+    bool _sinkResult(proto::Result& result, int jobIdAttempt);
+    bool _flushSink();
+    bool _sortResult(proto::Result const& result, int jobIdAttempt, bool& held);
+    bool _spillSorted();
+    bool _flushSorted();
+    std::string _sortedOrderSql() const;
     int _readHeader(proto::ProtoHeader& header, char const* buffer, int length);
     int _readResult(proto::Result& result, char const* buffer, int length);
     bool _verifySession(int sessionId);
@@ -206,14 +330,6 @@ private:
     void _setQueryIdStr(std::string const& qIdStr);
     void _fixupTargetName();
 
-    bool _setupConnection() {
-        if (_mysqlConn.connect()) {
-            _infileMgr.attach(_mysqlConn.getMySql());
-            return true;
-        }
-        return false;
-    }
-
     InfileMergerConfig _config; ///< Configuration
     std::shared_ptr<sql::SqlConnection> _sqlConn; ///< SQL connection
     std::string _mergeTable; ///< Table for result loading
@@ -228,10 +344,57 @@ private:
         _jobIdColName = "jobId" + std::to_string(_jobIdColNameAdj++);
     }
 
-    mysql::MySqlConnection _mysqlConn;
-
-    std::mutex _mysqlMutex;
-    lsst::qserv::mysql::LocalInfile::Mgr _infileMgr;
+    std::vector<std::unique_ptr<MergeShard>> _shards; ///< Shard 0 loads into _mergeTable if there is one shard.
+    std::atomic<unsigned int> _nextShard{0}; ///< Where _lockShard() starts looking for a free shard.
+    std::vector<std::string> _resultColumns; ///< Result column names, without the jobId column.
+    /// GROUP BY columns of the merge statement, when the groups can be
+    /// merged on each shard separately.
+    std::vector<std::string> _groupByColumns;
+    /// Result columns whose values pick the shard of a row, so that each
+    /// group is in one shard. Set by _setupTable() from _groupByColumns when
+    /// they all hold integers, rows go to any shard if empty.
+    std::vector<int> _partitionCols;
+
+    /// Folds partial aggregates in memory while set, rows are loaded into
+    /// the merge table as they arrive once it is reset.
+    std::unique_ptr<proto::InMemoryAggregator> _aggregator;
+    /// Keeps the first topK rows while set, rows are loaded into the merge
+    /// table as they arrive once it is reset.
+    std::unique_ptr<InMemoryTopK> _topK;
+    /// Holds the sorted chunk results, in files, while set. Rows are loaded
+    /// into the merge table as they arrive once it is reset.
+    std::unique_ptr<SortedRunMerger> _sorted;
+    bool _sortedLoaded{false}; ///< True once _sorted loaded the rows in order.
+    std::mutex _aggMtx; ///< Protects _aggregator, _topK and _sorted
+
+    /// Stores the rows not held by _aggregator, _topK or _sorted, always
+    /// set. Rows it still holds are loaded into the merge table by finalize().
+    std::unique_ptr<ResultSink> _sink;
+
+    std::atomic<bool> _memoryTable{false}; ///< True while the result table uses the MEMORY engine.
+    std::mutex _memoryTableMtx; ///< Held while moving the result table to disk.
+
+    void _countRows(int jobIdAttempt, int64_t rows);
+    void _uncountRows(int jobIdAttempt);
+
+    std::atomic<int64_t> _mergedRows{0}; ///< Rows added to the result table.
+    std::mutex _attemptRowsMtx; ///< Protects _attemptRows
+    /// Rows each job attempt added to _mergedRows, kept only with a rowLimit
+    /// so that scrubbed attempts can be taken back out.
+    std::map<int, int64_t> _attemptRows;
+
+    void _recordSample(proto::Result const& result);
+
+    /// Parallel columns whose per-chunk values are recorded for
+    /// getSampleErrors(), empty if they are not.
+    std::vector<int> _sampleCols;
+    std::vector<std::string> _sampleColNames; ///< Set by the first result
+    mutable std::mutex _sampleMtx; ///< Protects _sampleColNames and _sampleValues
+    /// The latest attempt and the sums of the _sampleCols values of each job.
+    std::map<int, std::pair<int, std::vector<double>>> _sampleValues;
+
+    std::mutex _stagingMtx; ///< Protects _staging
+    std::map<int, std::shared_ptr<StagingTable>> _staging; ///< Staging tables by job attempt.
 
     std::mutex _queryIdStrMtx; ///< protects _queryIdStr
     std::atomic<bool> _queryIdStrSet{false};
@@ -245,10 +408,20 @@ private:
 
     InvalidJobAttemptMgr _invalidJobAttemptMgr;
     bool _deleteInvalidRows(std::set<int> const& jobIdAttempts);
+    bool _deleteTableRows(std::set<int> const& jobIdAttempts);
+
 
+    bool _checkSize(std::string const& queryIdJobStr);
+    void _correctSizeEstimate(uint64_t estBytes, size_t tableSizeMB);
 
-    int _sizeCheckRowCount{0}; ///< Number of rows read since last size check.
-    int _checkSizeEveryXRows{1000}; ///< Check the size of the result table after every x number of rows.
+    static uint64_t const MB_BYTES = 1024 * 1024;
+    /// Estimated table bytes per row beyond Result.transmitsize, for the
+    /// jobId column and MyISAM row overhead.
+    static uint64_t const ROW_OVERHEAD_BYTES = 16;
+    std::atomic<uint64_t> _estResultBytes{0}; ///< Estimated size of the result table.
+    std::atomic<uint64_t> _nextSizeCheckBytes{0}; ///< Read the real size when the estimate reaches this.
+    uint64_t _sizeCheckStepBytes{1}; ///< Estimate growth between reads of the real size.
+    std::mutex _sizeCheckMtx; ///< Held while reading the real size.
     size_t _maxResultTableSizeMB{5000}; ///< Max result table size.
 };
 
@@ -23,10 +23,14 @@
 #include "rproc/ProtoRowBuffer.h"
 
 // System headers
+#include <algorithm>
 #include <cassert>
 #include <sstream>
 #include <stdexcept>
 #include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 // Third-party headers
 #include <mysql/mysql.h>
@@ -60,6 +64,30 @@ std::string printCharVect(std::vector<char> const& cVect) {
     return str;
 }
 
+/// Write the escaped form of src[i] to destI, see ProtoRowBuffer::escapeString().
+/// @return the position after the bytes written.
+inline char* escapeChar(char* destI, char const* src, size_t i, size_t len) {
+    char const c = src[i];
+    switch(c) {
+      case '\0':   *destI++ = '\\'; *destI++ = '0'; break;
+      case '\b':   *destI++ = '\\'; *destI++ = 'b'; break;
+      case '\n':   *destI++ = '\\'; *destI++ = 'n'; break;
+      case '\r':   *destI++ = '\\'; *destI++ = 'r'; break;
+      case '\t':   *destI++ = '\\'; *destI++ = 't'; break;
+      case '\032': *destI++ = '\\'; *destI++ = 'Z'; break;
+      case '\\':
+          if (i + 1 == len || src[i + 1] == 'N') {
+              // Null (\N) is not treated by escaping in this context.
+              *destI++ = c;
+          } else {
+              *destI++ = '\\'; *destI++ = '\\';
+          }
+          break;
+      default: *destI++ = c; break;
+    }
+    return destI;
+}
+
 } // namespace
 
 
@@ -73,43 +101,182 @@ ProtoRowBuffer::ProtoRowBuffer(proto::Result& res, int jobId, std::string const&
       _rowSep("\n"),
       _nullToken("\\N"),
       _result(res),
+      _columnar(res.columnblock_size() > 0),
       _rowIdx(0),
-      _rowTotal(res.row_size()),
-      _currentRow(0),
+      _rowTotal(getRowCount(res)),
       _jobIdColName(jobIdColName),
       _jobIdSqlType(jobIdSqlType),
       _jobIdMysqlType(jobIdMysqlType) {
     _jobIdStr = std::string("'") + std::to_string(jobId) + "'";
     _initSchema();
-    if (_result.row_size() > 0) {
-        _initCurrentRow();
+}
+
+
+int ProtoRowBuffer::escapeBytes(char* dest, char const* src, size_t len) {
+    char* destI = dest;
+    size_t i = 0;
+#ifdef __SSE2__
+    // Find the bytes that may need escaping 16 at a time, everything
+    // before the first one is copied as is.
+    __m128i const cNul = _mm_set1_epi8('\0');
+    __m128i const cBs = _mm_set1_epi8('\b');
+    __m128i const cNl = _mm_set1_epi8('\n');
+    __m128i const cCr = _mm_set1_epi8('\r');
+    __m128i const cTab = _mm_set1_epi8('\t');
+    __m128i const cCtrlZ = _mm_set1_epi8('\032');
+    __m128i const cBackslash = _mm_set1_epi8('\\');
+    while (i + 16 <= len) {
+        __m128i const chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i));
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, cNul), _mm_cmpeq_epi8(chunk, cBs));
+        hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, cNl));
+        hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, cCr));
+        hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, cTab));
+        hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, cCtrlZ));
+        hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, cBackslash));
+        int const mask = _mm_movemask_epi8(hits);
+        if (mask == 0) {
+            memcpy(destI, src + i, 16);
+            destI += 16;
+            i += 16;
+            continue;
+        }
+        int const clean = __builtin_ctz(mask);
+        memcpy(destI, src + i, clean);
+        destI += clean;
+        i += clean;
+        destI = escapeChar(destI, src, i, len);
+        ++i;
+    }
+#endif
+    for (; i < len; ++i) {
+        destI = escapeChar(destI, src, i, len);
+    }
+    return destI - dest;
+}
+
+
+bool ProtoRowBuffer::isNumericType(int mysqlType) {
+    switch (mysqlType) {
+    case MYSQL_TYPE_TINY:
+    case MYSQL_TYPE_SHORT:
+    case MYSQL_TYPE_LONG:
+    case MYSQL_TYPE_INT24:
+    case MYSQL_TYPE_LONGLONG:
+    case MYSQL_TYPE_FLOAT:
+    case MYSQL_TYPE_DOUBLE:
+    case MYSQL_TYPE_DECIMAL:
+    case MYSQL_TYPE_NEWDECIMAL:
+        return true;
+    default:
+        return false;
     }
 }
 
 
-/// Fetch a up to a single row from from the Result message
+/// Fill the buffer with as many escaped fields as fit
 unsigned ProtoRowBuffer::fetch(char* buffer, unsigned bufLen) {
-    unsigned fetched = 0;
-    if (bufLen <= _currentRow.size()) {
-        memcpy(buffer, &_currentRow[0], bufLen);
-        _currentRow.erase(_currentRow.begin(), _currentRow.begin() + bufLen);
-        fetched = bufLen;
-    } else { // Want more than we have.
-        if (_currentRow.size()) {
-            memcpy(buffer, &_currentRow[0], _currentRow.size());
-            fetched = _currentRow.size();
-            _currentRow.clear();
+    char* dest = buffer;
+    char* const destEnd = buffer + bufLen;
+    if (_carryPos < _carry.size()) {
+        size_t const size = std::min<size_t>(bufLen, _carry.size() - _carryPos);
+        memcpy(dest, &_carry[_carryPos], size);
+        dest += size;
+        _carryPos += size;
+    }
+    while (dest != destEnd && _rowIdx < _rowTotal) {
+        size_t const maxSize = _maxFieldSize();
+        if (maxSize <= static_cast<size_t>(destEnd - dest)) {
+            dest = _writeField(dest);
+        } else {
+            // Does not fit, the rest is fetched from _carry next time.
+            _carry.resize(maxSize);
+            _carry.resize(_writeField(&_carry[0]) - &_carry[0]);
+            size_t const size = std::min<size_t>(destEnd - dest, _carry.size());
+            memcpy(dest, &_carry[0], size);
+            dest += size;
+            _carryPos = size;
+        }
+    }
+    return dest - buffer;
+}
+
+
+bool ProtoRowBuffer::_getValue(int ci, char const*& src, size_t& len) const {
+    if (_columnar) {
+        proto::ColumnBlock const& block = _result.columnblock(ci);
+        std::string const& nullBitmap = block.nullbitmap();
+        size_t byteIdx = _rowIdx / 8;
+        if (byteIdx < nullBitmap.size() && (nullBitmap[byteIdx] & (1 << (_rowIdx % 8)))) {
+            return false;
         }
+        uint32_t begin = (_rowIdx == 0) ? 0 : block.offsets(_rowIdx - 1);
+        src = block.values().data() + begin;
+        len = block.offsets(_rowIdx) - begin;
+        return true;
     }
-    if ((_currentRow.size() == 0) && (_rowIdx < _rowTotal)) {
-        _readNextRow();
+    proto::RowBundle const& rb = _result.row(_rowIdx);
+    if (rb.isnull(ci)) {
+        return false;
     }
-    return fetched;
+    src = rb.column(ci).data();
+    len = rb.column(ci).size();
+    return true;
+}
+
+
+size_t ProtoRowBuffer::_maxFieldSize() const {
+    // a separator is at most as long as the longest one
+    size_t const sepSize = std::max(_colSep.size(), _rowSep.size());
+    if (_fieldIdx == 0) {
+        return sepSize + _jobIdStr.size();
+    }
+    char const* src = nullptr;
+    size_t len = 0;
+    if (not _getValue(_fieldIdx - 1, src, len)) {
+        return sepSize + _nullToken.size();
+    }
+    return sepSize + 2 + (_noEscape[_fieldIdx - 1] ? len : 2 * len);
+}
+
+
+char* ProtoRowBuffer::_writeField(char* dest) {
+    if (_fieldIdx == 0) {
+        if (_rowIdx > 0) {
+            dest = std::copy(_rowSep.begin(), _rowSep.end(), dest);
+        }
+        dest = std::copy(_jobIdStr.begin(), _jobIdStr.end(), dest);
+    } else {
+        int const ci = _fieldIdx - 1;
+        dest = std::copy(_colSep.begin(), _colSep.end(), dest);
+        char const* src = nullptr;
+        size_t len = 0;
+        if (not _getValue(ci, src, len)) {
+            dest = std::copy(_nullToken.begin(), _nullToken.end(), dest);
+        } else {
+            *dest++ = '\'';
+            if (_noEscape[ci]) {
+                memcpy(dest, src, len);
+                dest += len;
+            } else {
+                dest += escapeBytes(dest, src, len);
+            }
+            *dest++ = '\'';
+        }
+    }
+    // columns of a RowBundle and of the blocks are counted the same way
+    int const fieldCount = 1 + (_columnar ? _result.columnblock_size()
+                                          : _result.row(_rowIdx).column_size());
+    if (++_fieldIdx == fieldCount) {
+        _fieldIdx = 0;
+        ++_rowIdx;
+    }
+    return dest;
 }
 
 /// Import schema from the proto message into a Schema object
 void ProtoRowBuffer::_initSchema() {
     _schema.columns.clear();
+    _noEscape.clear();
 
     // Set jobId and attemptCount
     sql::ColSchema jobIdCol;
@@ -129,6 +296,7 @@ void ProtoRowBuffer::_initSchema() {
         if (pcs.has_mysqltype()) {
             cs.colType.mysqlType = pcs.mysqltype();
         }
+        _noEscape.push_back(pcs.has_mysqltype() && isNumericType(pcs.mysqltype()));
         _schema.columns.push_back(cs);
     }
 }
@@ -141,34 +309,11 @@ std::string ProtoRowBuffer::dump() const {
         str += ",colType=" + sCol.colType.sqlType + ":" + std::to_string(sCol.colType.mysqlType) + ")";
     }
     str += ") ";
-    str += "Row " + std::to_string(_rowIdx) + "(";
-    str += printCharVect(_currentRow);
+    str += "Row " + std::to_string(_rowIdx) + " field " + std::to_string(_fieldIdx);
+    str += " carry(" + printCharVect(std::vector<char>(_carry.begin() + _carryPos, _carry.end()));
     str += ")";
     return str;
 }
 
 
-/// Import the next row into the buffer
-void ProtoRowBuffer::_readNextRow() {
-    ++_rowIdx;
-    if (_rowIdx >= _rowTotal) {
-        return;
-    }
-    _currentRow.clear();
-    // Start the new row with a row separator.
-    _currentRow.insert(_currentRow.end(), _rowSep.begin(), _rowSep.end());
-    _copyRowBundle(_currentRow, _result.row(_rowIdx));
-    LOGS(_log, LOG_LVL_TRACE, "_currentrow=" << printCharVect(_currentRow));
-}
-
-
-/// Setup the row byte buffer
-void ProtoRowBuffer::_initCurrentRow() {
-    // Copy row and reserve 2x size.
-    int rowSize = _copyRowBundle(_currentRow, _result.row(_rowIdx));
-    LOGS(_log, LOG_LVL_TRACE, "init _rowIdx=" <<_rowIdx << " _currentrow=" << printCharVect(_currentRow));
-    _currentRow.reserve(rowSize*2); // for future usage
-}
-
-
 }}} // lsst::qserv::mysql
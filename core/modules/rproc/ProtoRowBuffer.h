@@ -25,6 +25,7 @@
 
 // System headers
 #include <limits>
+#include <vector>
 
 
 // Qserv headers
@@ -38,12 +39,17 @@ namespace rproc {
 
 
 /// ProtoRowBuffer is an implementation of RowBuffer designed to allow a
-/// LocalInfile object to use a Protobufs Result message as a row source
+/// LocalInfile object to use a Protobufs Result message as a row source.
+/// Columns are escaped straight into the buffer given to fetch(), which is
+/// the one mysql hands to local_infile_read. Only a field that does not fit
+/// in what is left of that buffer goes through a small carry buffer, whose
+/// remaining bytes start the next fetch().
 class ProtoRowBuffer : public mysql::RowBuffer {
 public:
     ProtoRowBuffer(proto::Result& res, int jobId, std::string const& jobIdColName,
                    std::string const& jobIdSqlType, int jobIdMysqlType);
-    virtual unsigned fetch(char* buffer, unsigned bufLen);
+    unsigned fetch(char* buffer, unsigned bufLen) override;
+    bool fetchesDirect() const override { return true; }
     std::string dump() const override;
 
     /// Escape a bytestring for LOAD DATA INFILE, as specified by MySQL doc:
@@ -94,50 +100,86 @@ public:
         return destI - destBegin;
     }
 
+    /// Same as escapeString(), for contiguous buffers. Bytes are examined
+    /// 16 at a time where SSE2 is available and runs of bytes that need no
+    /// escaping are copied in bulk.
+    /// 'dest' must have room for 2 * len bytes.
+    /// @return the number of bytes written to dest
+    static int escapeBytes(char* dest, char const* src, size_t len);
+
     /// Copy a rawColumn to an STL container
     template <typename T>
     static inline int copyColumn(T& dest, std::string const& rawColumn) {
+        return copyColumn(dest, rawColumn.data(), rawColumn.size());
+    }
+
+    /// Copy 'len' bytes of a raw column value starting at 'src' to an STL container
+    template <typename T>
+    static inline int copyColumn(T& dest, char const* src, size_t len) {
         int existingSize = dest.size();
-        dest.resize(existingSize + 2 + 2 * rawColumn.size());
+        dest.resize(existingSize + 2 + 2 * len);
         dest[existingSize] = '\'';
-        int valSize = escapeString(dest.begin() + existingSize + 1,
-                                   rawColumn.begin(), rawColumn.end());
+        int valSize = escapeBytes(&dest[existingSize + 1], src, len);
         dest[existingSize + 1 + valSize] = '\'';
         dest.resize(existingSize + 2 + valSize);
         return 2 + valSize;
     }
 
-private:
-    void _initCurrentRow();
-    void _initSchema();
-    void _readNextRow();
-    // Copy a row bundle into a destination STL char container
+    /// Copy 'len' bytes of a column value known to need no escaping, such
+    /// as the text of a number, to an STL container
     template <typename T>
-    int _copyRowBundle(T& dest, proto::RowBundle const& rb) {
-        int sizeBefore = dest.size();
-        // Add jobId
-        dest.insert(dest.end(), _jobIdStr.begin(), _jobIdStr.end());
-        for(int ci=0, ce=rb.column_size(); ci != ce; ++ci) {
-            dest.insert(dest.end(), _colSep.begin(), _colSep.end());
-            if (!rb.isnull(ci)) {
-                copyColumn(dest, rb.column(ci));
-            } else {
-                dest.insert(dest.end(), _nullToken.begin(), _nullToken.end() );
-            }
+    static inline int copyColumnNoEscape(T& dest, char const* src, size_t len) {
+        dest.push_back('\'');
+        dest.insert(dest.end(), src, src + len);
+        dest.push_back('\'');
+        return 2 + len;
+    }
+
+    /// @return true if values of columns of 'mysqlType' never contain
+    ///         characters that escapeString() would change.
+    static bool isNumericType(int mysqlType);
+
+    /// @return the number of rows in a Result message, whether the rows
+    ///         are sent as RowBundles or as ColumnBlocks.
+    static int getRowCount(proto::Result const& res) {
+        if (res.columnblock_size() > 0) {
+            return res.rowcount();
         }
-        return dest.size() - sizeBefore;
+        return res.row_size();
     }
 
+private:
+    void _initSchema();
+
+    /// Find the value of column 'ci' of the current row.
+    /// @return false if it is NULL.
+    bool _getValue(int ci, char const*& src, size_t& len) const;
+
+    /// @return the most bytes _writeField() may write for the current field.
+    size_t _maxFieldSize() const;
+
+    /// Write the current field, with the separator before it, to 'dest' and
+    /// move to the next field.
+    /// @return the position after the bytes written.
+    char* _writeField(char* dest);
 
     std::string _colSep; ///< Column separator
     std::string _rowSep; ///< Row separator
     std::string _nullToken; ///< Null indicator (e.g. \N)
     proto::Result& _result; ///< Ref to Resultmessage
 
+    bool const _columnar; ///< True if the rows are stored in column blocks.
+
     sql::Schema _schema; ///< Schema object
+    /// For each column of the Result, true if its values can be copied without escaping.
+    std::vector<bool> _noEscape;
     int _rowIdx; ///< Row index
     int _rowTotal; ///< Total row count
-    std::vector<char> _currentRow; ///< char buffer representing current row.
+    int _fieldIdx{0}; ///< Field of the current row to write next, 0 is the jobId.
+    /// Escaped bytes of a field that did not fit in the buffer given to
+    /// fetch(), the first _carryPos of them are already fetched.
+    std::vector<char> _carry;
+    size_t _carryPos{0};
 
     /// Name and type for jobId column in result table. Passed from InfileMerger.
     std::string _jobIdStr; ///< String form of jobId.
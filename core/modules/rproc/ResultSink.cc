@@ -0,0 +1,48 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "rproc/ResultSink.h"
+
+namespace lsst {
+namespace qserv {
+namespace rproc {
+
+ResultSink::Kind ResultSink::kindFromString(std::string const& name) {
+    if (name == "columnar") {
+        return COLUMNAR;
+    }
+    return MYSQL;
+}
+
+
+bool MySqlResultSink::add(int jobIdAttempt, proto::Result& result) {
+    return _load(jobIdAttempt, result);
+}
+
+
+bool MySqlResultSink::erase(std::set<int> const& jobIdAttempts) {
+    return _erase(jobIdAttempts);
+}
+
+}}} // namespace lsst::qserv::rproc
@@ -0,0 +1,120 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_RPROC_RESULTSINK_H
+#define LSST_QSERV_RPROC_RESULTSINK_H
+
+// System headers
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <string>
+
+// Qserv headers
+#include "proto/worker.pb.h"
+
+namespace lsst {
+namespace qserv {
+namespace rproc {
+
+/// ResultSink is where InfileMerger stores the chunk result rows that are
+/// not folded, ranked or sorted in memory, until finalize() builds the user
+/// result table from them.
+///
+/// A sink either writes the rows to the result table as they arrive, or
+/// holds them on its own until flush() hands them over. The job attempt of
+/// every row is kept, so that the rows of invalid attempts can be removed.
+class ResultSink {
+public:
+    enum Kind {
+        MYSQL,   ///< Rows are loaded into the MySQL result table as they arrive.
+        COLUMNAR ///< Rows are held in columns in memory, and on disk past a limit.
+    };
+
+    /// Takes the rows of a job attempt, job attempt 0 for rows of several.
+    using LoadFunc = std::function<bool(int jobIdAttempt, proto::Result& result)>;
+
+    ResultSink() = default;
+    ResultSink(ResultSink const&) = delete;
+    ResultSink& operator=(ResultSink const&) = delete;
+    virtual ~ResultSink() {}
+
+    /// @return the Kind named by 'name', MYSQL if it is not known.
+    static Kind kindFromString(std::string const& name);
+
+    /// Describe the columns of the rows to be added.
+    /// @return false if the sink cannot hold these columns.
+    virtual bool setSchema(proto::RowSchema const& schema) = 0;
+
+    /// Store the rows of 'result', which is the last message of
+    /// 'jobIdAttempt' unless result.continues() is set.
+    /// @return false if the rows could not be stored.
+    virtual bool add(int jobIdAttempt, proto::Result& result) = 0;
+
+    /// Remove the rows of the given job attempts.
+    /// @return false if rows could not be removed.
+    virtual bool erase(std::set<int> const& jobIdAttempts) = 0;
+
+    /// Call 'load' with the rows held of every complete job attempt, and
+    /// release all rows held.
+    /// @return false if rows could not be read or 'load' failed.
+    virtual bool flush(LoadFunc const& load) = 0;
+
+    /// @return true if rows stay in the sink until flush(), false if add()
+    ///         writes them to the result table.
+    virtual bool holdsRows() const = 0;
+
+    /// @return the bytes of the rows held, in memory or on disk.
+    virtual uint64_t getBytes() const = 0;
+
+    /// @return the number of rows held, in memory or on disk.
+    virtual uint64_t getRowCount() const = 0;
+};
+
+
+/// MySqlResultSink writes the rows to the MySQL result table right away,
+/// through the functions InfileMerger uses for its tables.
+class MySqlResultSink : public ResultSink {
+public:
+    using EraseFunc = std::function<bool(std::set<int> const& jobIdAttempts)>;
+
+    /// @param load - loads rows into the result table.
+    /// @param erase - deletes the rows of job attempts from the result table.
+    MySqlResultSink(LoadFunc const& load, EraseFunc const& erase)
+        : _load(load), _erase(erase) {}
+
+    bool setSchema(proto::RowSchema const& schema) override { return true; }
+    bool add(int jobIdAttempt, proto::Result& result) override;
+    bool erase(std::set<int> const& jobIdAttempts) override;
+    bool flush(LoadFunc const& load) override { return true; }
+    bool holdsRows() const override { return false; }
+    uint64_t getBytes() const override { return 0; }
+    uint64_t getRowCount() const override { return 0; }
+
+private:
+    LoadFunc const _load;
+    EraseFunc const _erase;
+};
+
+}}} // namespace lsst::qserv::rproc
+
+#endif // LSST_QSERV_RPROC_RESULTSINK_H
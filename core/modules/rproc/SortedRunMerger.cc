@@ -0,0 +1,454 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "rproc/SortedRunMerger.h"
+
+// System headers
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+// Third-party headers
+#include <mysql/mysql.h>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.rproc.SortedRunMerger");
+
+/// Copy row 'rowIdx' of 'result' into 'row', whether 'result' holds rows or columns.
+void copyRow(lsst::qserv::proto::Result const& result, int rowIdx, lsst::qserv::proto::RowBundle& row) {
+    if (result.columnblock_size() == 0) {
+        row = result.row(rowIdx);
+        return;
+    }
+    row.Clear();
+    for (int col = 0; col < result.columnblock_size(); ++col) {
+        lsst::qserv::proto::ColumnBlock const& block = result.columnblock(col);
+        std::string const& nullBitmap = block.nullbitmap();
+        size_t byteIdx = rowIdx / 8;
+        bool isNull = byteIdx < nullBitmap.size() && (nullBitmap[byteIdx] & (1 << (rowIdx % 8)));
+        uint32_t begin = (rowIdx == 0) ? 0 : block.offsets(rowIdx - 1);
+        row.add_isnull(isNull);
+        row.add_column(isNull ? std::string() : block.values().substr(begin, block.offsets(rowIdx) - begin));
+    }
+}
+
+} // annonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace rproc {
+
+size_t const SortedRunMerger::maxFanIn = 256;
+
+
+/// Reads the rows of a run file, each a 32 bit length followed by a
+/// serialized RowBundle.
+class SortedRunMerger::Reader {
+public:
+    explicit Reader(std::string const& path) : _in(path, std::ios::binary) {}
+
+    /// Read the next row into 'row'.
+    /// @return false at the end of the run, or if it could not be read.
+    bool next(proto::RowBundle& row) {
+        uint32_t len = 0;
+        if (!_in.read(reinterpret_cast<char*>(&len), sizeof(len))) {
+            _failed = !_in.eof();
+            return false;
+        }
+        _buf.resize(len);
+        if (!_in.read(&_buf[0], len) || !row.ParseFromString(_buf)) {
+            _failed = true;
+            return false;
+        }
+        return true;
+    }
+
+    bool failed() const { return _failed || (!_in.is_open()); }
+
+private:
+    std::ifstream _in;
+    std::string _buf;
+    bool _failed{false};
+};
+
+
+SortedRunMerger::SortedRunMerger(Order const& order, std::string const& runDir, std::string const& prefix)
+    : _order(order), _runDir(runDir), _prefix(prefix) {
+}
+
+
+SortedRunMerger::~SortedRunMerger() {
+    for (auto const& elem : _runs) {
+        _remove(elem.second.path);
+    }
+}
+
+
+bool SortedRunMerger::setSchema(proto::RowSchema const& schema) {
+    _schema = schema;
+    _sortCols.clear();
+    _isInt.clear();
+    for (auto const& term : _order) {
+        int found = -1;
+        for (int col = 0; col < schema.columnschema_size(); ++col) {
+            if (schema.columnschema(col).name() == term.first) {
+                found = col;
+                break;
+            }
+        }
+        if (found < 0) {
+            LOGS(_log, LOG_LVL_DEBUG, "sort column " << term.first << " not in result");
+            return false;
+        }
+        proto::ColumnSchema const& cs = schema.columnschema(found);
+        if (!cs.has_mysqltype()) {
+            return false;
+        }
+        switch (cs.mysqltype()) {
+        case MYSQL_TYPE_TINY:
+        case MYSQL_TYPE_SHORT:
+        case MYSQL_TYPE_LONG:
+        case MYSQL_TYPE_INT24:
+        case MYSQL_TYPE_LONGLONG:
+            _isInt.push_back(true);
+            break;
+        case MYSQL_TYPE_FLOAT:
+        case MYSQL_TYPE_DOUBLE:
+            _isInt.push_back(false);
+            break;
+        default:
+            LOGS(_log, LOG_LVL_DEBUG, "sort column " << cs.name() << " type " << cs.mysqltype()
+                 << " cannot be merged in order");
+            return false;
+        }
+        _sortCols.push_back(found);
+    }
+    return true;
+}
+
+
+bool SortedRunMerger::add(int jobIdAttempt, proto::Result const& result) {
+    int const rowCount = (result.columnblock_size() > 0) ? result.rowcount() : result.row_size();
+    std::string data;
+    Keys keys;
+    proto::RowBundle row;
+
+    std::lock_guard<std::mutex> lock(_mtx);
+    Run& run = _runs[jobIdAttempt];
+    if (run.path.empty()) {
+        run.path = _newPath(std::to_string(jobIdAttempt));
+    }
+    Keys last = run.last;
+    for (int j = 0; j < rowCount; ++j) {
+        copyRow(result, j, row);
+        if (!_parseKeys(row, keys)) {
+            return false;
+        }
+        if ((run.rows > 0 || j > 0) && _compare(last, keys) > 0) {
+            LOGS(_log, LOG_LVL_WARN, "rows of job attempt " << jobIdAttempt << " are not in order");
+            return false;
+        }
+        last.swap(keys);
+        std::string const bytes = row.SerializeAsString();
+        uint32_t const len = bytes.size();
+        data.append(reinterpret_cast<char const*>(&len), sizeof(len));
+        data.append(bytes);
+    }
+    if (!data.empty()) {
+        std::ofstream out(run.path, std::ios::binary | std::ios::app);
+        if (!out.write(data.data(), data.size()) || !out.flush()) {
+            LOGS(_log, LOG_LVL_ERROR, "failed to write run " << run.path);
+            return false;
+        }
+    }
+    run.last.swap(last);
+    run.rows += rowCount;
+    run.complete = !result.continues();
+    _rows += rowCount;
+    _bytes += data.size();
+    return true;
+}
+
+
+void SortedRunMerger::erase(std::set<int> const& jobIdAttempts) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    for (int jobIdAttempt : jobIdAttempts) {
+        auto iter = _runs.find(jobIdAttempt);
+        if (iter != _runs.end()) {
+            _remove(iter->second.path);
+            _runs.erase(iter);
+        }
+    }
+}
+
+
+bool SortedRunMerger::merge(size_t batchRows, std::function<bool(proto::Result&)> const& load) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    std::vector<std::string> paths;
+    for (auto const& elem : _runs) {
+        if (!elem.second.complete) {
+            LOGS(_log, LOG_LVL_WARN, "leaving out incomplete job attempt " << elem.first);
+            _remove(elem.second.path);
+        } else if (elem.second.rows > 0) {
+            paths.push_back(elem.second.path);
+        }
+    }
+    _runs.clear();
+    _rows = 0;
+    _bytes = 0;
+
+    bool ok = true;
+    while (ok && paths.size() > maxFanIn) {
+        // Merge the runs a group at a time into longer runs.
+        std::vector<std::string> next;
+        for (size_t begin = 0; begin < paths.size(); begin += maxFanIn) {
+            size_t const end = std::min(paths.size(), begin + maxFanIn);
+            std::vector<std::string> group(paths.begin() + begin, paths.begin() + end);
+            if (ok) {
+                std::string const path = _newPath("m" + std::to_string(_nextMergedRun++));
+                next.push_back(path);
+                std::ofstream out(path, std::ios::binary);
+                ok = _mergeRuns(group, [&out](proto::RowBundle& row) {
+                    std::string const bytes = row.SerializeAsString();
+                    uint32_t const len = bytes.size();
+                    out.write(reinterpret_cast<char const*>(&len), sizeof(len));
+                    return static_cast<bool>(out.write(bytes.data(), bytes.size()));
+                }) && out.flush();
+            }
+            for (auto const& path : group) {
+                _remove(path);
+            }
+        }
+        paths.swap(next);
+    }
+
+    if (ok) {
+        proto::Result batch;
+        *batch.mutable_rowschema() = _schema;
+        auto flush = [&batch, &load]() {
+            batch.set_rowcount(batch.row_size());
+            bool loaded = load(batch);
+            batch.clear_row();
+            return loaded;
+        };
+        ok = _mergeRuns(paths, [&batch, &flush, batchRows](proto::RowBundle& row) {
+            batch.add_row()->Swap(&row);
+            return static_cast<size_t>(batch.row_size()) < batchRows || flush();
+        });
+        if (ok && batch.row_size() > 0) {
+            ok = flush();
+        }
+    }
+    for (auto const& path : paths) {
+        _remove(path);
+    }
+    return ok;
+}
+
+
+bool SortedRunMerger::extractEach(size_t batchRows, std::function<bool(int, proto::Result&)> const& func) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    bool ok = true;
+    for (auto const& elem : _runs) {
+        if (ok && elem.second.rows > 0) {
+            Reader reader(elem.second.path);
+            proto::Result batch;
+            *batch.mutable_rowschema() = _schema;
+            proto::RowBundle row;
+            while (ok && reader.next(row)) {
+                batch.add_row()->Swap(&row);
+                if (static_cast<size_t>(batch.row_size()) >= batchRows) {
+                    batch.set_rowcount(batch.row_size());
+                    ok = func(elem.first, batch);
+                    batch.clear_row();
+                }
+            }
+            ok = ok && !reader.failed();
+            if (ok && batch.row_size() > 0) {
+                batch.set_rowcount(batch.row_size());
+                ok = func(elem.first, batch);
+            }
+        }
+        _remove(elem.second.path);
+    }
+    _runs.clear();
+    _rows = 0;
+    _bytes = 0;
+    return ok;
+}
+
+
+uint64_t SortedRunMerger::getBytes() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _bytes;
+}
+
+
+uint64_t SortedRunMerger::getRowCount() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _rows;
+}
+
+
+/// Call 'emit' with the rows of the runs in 'paths' in order. The runs are
+/// read together through a tree of losers, whose root holds the run with
+/// the smallest next row and whose other nodes each hold the run that lost
+/// the match at that node, so the next winner is found in log2(runs) steps.
+/// @return false if a run could not be read or 'emit' failed.
+bool SortedRunMerger::_mergeRuns(std::vector<std::string> const& paths,
+                                 std::function<bool(proto::RowBundle&)> const& emit) {
+    int const k = paths.size();
+    if (k == 0) {
+        return true;
+    }
+    std::vector<std::unique_ptr<Reader>> readers;
+    std::vector<proto::RowBundle> heads(k);
+    std::vector<Keys> keys(k);
+    std::vector<bool> done(k, false);
+    for (int j = 0; j < k; ++j) {
+        readers.emplace_back(new Reader(paths[j]));
+    }
+    auto advance = [&](int j) {
+        done[j] = !readers[j]->next(heads[j]);
+        if (done[j]) {
+            return !readers[j]->failed();
+        }
+        return _parseKeys(heads[j], keys[j]);
+    };
+    // Exhausted runs lose every match, ties go to the earlier run.
+    auto less = [&](int a, int b) {
+        if (done[a] || done[b]) {
+            return !done[a] && done[b];
+        }
+        int cmp = _compare(keys[a], keys[b]);
+        return cmp < 0 || (cmp == 0 && a < b);
+    };
+    for (int j = 0; j < k; ++j) {
+        if (!advance(j)) {
+            LOGS(_log, LOG_LVL_ERROR, "failed to read run " << paths[j]);
+            return false;
+        }
+    }
+    // Nodes 1..k-1 are matches, node n >= k is the head of run n - k.
+    std::vector<int> tree(k);
+    std::function<int(int)> play = [&](int node) {
+        if (node >= k) {
+            return node - k;
+        }
+        int a = play(2 * node);
+        int b = play(2 * node + 1);
+        if (less(b, a)) {
+            std::swap(a, b);
+        }
+        tree[node] = b;
+        return a;
+    };
+    int winner = play(1);
+    while (!done[winner]) {
+        if (!emit(heads[winner])) {
+            return false;
+        }
+        if (!advance(winner)) {
+            LOGS(_log, LOG_LVL_ERROR, "failed to read run " << paths[winner]);
+            return false;
+        }
+        for (int node = (winner + k) / 2; node > 0; node /= 2) {
+            if (less(tree[node], winner)) {
+                std::swap(tree[node], winner);
+            }
+        }
+    }
+    return true;
+}
+
+
+/// @return <0, 0 or >0 as the row with keys 'a' sorts before, with or after that with keys 'b'.
+int SortedRunMerger::_compare(Keys const& a, Keys const& b) const {
+    for (size_t j = 0; j < _order.size(); ++j) {
+        Key const& ka = a[j];
+        Key const& kb = b[j];
+        int cmp = 0;
+        if (ka.isNull || kb.isNull) {
+            cmp = (ka.isNull ? 0 : 1) - (kb.isNull ? 0 : 1);
+        } else if (ka.isInt) {
+            cmp = (ka.intVal < kb.intVal) ? -1 : (kb.intVal < ka.intVal) ? 1 : 0;
+        } else {
+            cmp = (ka.realVal < kb.realVal) ? -1 : (kb.realVal < ka.realVal) ? 1 : 0;
+        }
+        if (cmp != 0) {
+            return _order[j].second ? -cmp : cmp;
+        }
+    }
+    return 0;
+}
+
+
+bool SortedRunMerger::_parseKeys(proto::RowBundle const& row, Keys& keys) const {
+    if (row.column_size() != _schema.columnschema_size() || row.isnull_size() != row.column_size()) {
+        return false;
+    }
+    keys.resize(_sortCols.size());
+    for (size_t j = 0; j < _sortCols.size(); ++j) {
+        int const col = _sortCols[j];
+        Key& key = keys[j];
+        key.isInt = _isInt[j];
+        key.isNull = row.isnull(col);
+        if (key.isNull) {
+            continue;
+        }
+        std::string const& str = row.column(col);
+        char* end = nullptr;
+        errno = 0;
+        if (key.isInt) {
+            key.intVal = std::strtoll(str.c_str(), &end, 10);
+        } else {
+            key.realVal = std::strtod(str.c_str(), &end);
+        }
+        if (errno != 0 || end == str.c_str() || *end != '\0') {
+            LOGS(_log, LOG_LVL_WARN, "could not parse sort column " << col << " value " << str);
+            return false;
+        }
+    }
+    return true;
+}
+
+
+std::string SortedRunMerger::_newPath(std::string const& name) {
+    return _runDir + "/" + _prefix + "_" + name + ".run";
+}
+
+
+void SortedRunMerger::_remove(std::string const& path) {
+    if (std::remove(path.c_str()) != 0 && errno != ENOENT) {
+        LOGS(_log, LOG_LVL_WARN, "failed to remove run " << path);
+    }
+}
+
+}}} // namespace lsst::qserv::rproc
@@ -0,0 +1,149 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_RPROC_SORTEDRUNMERGER_H
+#define LSST_QSERV_RPROC_SORTEDRUNMERGER_H
+
+// System headers
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Qserv headers
+#include "proto/worker.pb.h"
+
+namespace lsst {
+namespace qserv {
+namespace rproc {
+
+/// SortedRunMerger merges the chunk results of an ORDER BY query without
+/// LIMIT, whose chunk queries sort their own rows, so that the result table
+/// receives every row in ORDER BY order and mysql-proxy does not have to
+/// sort it again.
+///
+/// The rows of each job attempt are appended to a run file in a local
+/// directory as they arrive, which keeps them out of memory. Once every
+/// chunk is in, merge() reads the complete runs back together, smallest head
+/// row first, passing the rows on in order in a single pass. When there are
+/// more than maxFanIn runs, groups of them are first merged into longer runs.
+///
+/// Runs of invalid attempts are removed, runs of attempts that never sent
+/// their last message are left out.
+class SortedRunMerger {
+public:
+    /// Result column name and true for a descending sort, for each ORDER BY term.
+    using Order = std::vector<std::pair<std::string, bool>>;
+
+    /// Largest number of runs read at the same time.
+    static size_t const maxFanIn;
+
+    /// @param order - columns the rows of each chunk are sorted on, most significant first.
+    /// @param runDir - directory of the run files.
+    /// @param prefix - start of the run file names, unique to the query.
+    SortedRunMerger(Order const& order, std::string const& runDir, std::string const& prefix);
+
+    SortedRunMerger(SortedRunMerger const&) = delete;
+    SortedRunMerger& operator=(SortedRunMerger const&) = delete;
+
+    /// Remove the run files left.
+    ~SortedRunMerger();
+
+    /// Find the sort columns among the columns described by 'schema'.
+    /// @return false if a sort column is missing or is not numeric, as
+    ///         string order depends on the collation.
+    bool setSchema(proto::RowSchema const& schema);
+
+    /// Append the rows of 'result' to the run of 'jobIdAttempt', which is
+    /// complete once 'result' is the last message of the attempt.
+    /// @return false if a sort value could not be parsed, the rows are not
+    ///         in order, or the run could not be written. The rows of
+    ///         'result' are then not in the run.
+    bool add(int jobIdAttempt, proto::Result const& result);
+
+    /// Remove the runs of the given job attempts.
+    void erase(std::set<int> const& jobIdAttempts);
+
+    /// Merge the complete runs and call 'load' with their rows in order, at
+    /// most 'batchRows' at a time. Every run is removed.
+    /// @return false if a run could not be read or 'load' failed.
+    bool merge(size_t batchRows, std::function<bool(proto::Result& result)> const& load);
+
+    /// Call 'func' with the rows of each run, complete or not, in the order
+    /// they were added, at most 'batchRows' at a time. Every run is removed.
+    /// @return false if a run could not be read or 'func' failed.
+    bool extractEach(size_t batchRows, std::function<bool(int jobIdAttempt, proto::Result& result)> const& func);
+
+    /// @return the bytes of rows in the runs.
+    uint64_t getBytes() const;
+    /// @return the number of rows in the runs.
+    uint64_t getRowCount() const;
+
+private:
+    /// Sort value of one column, NULL sorts before any value as in MySQL.
+    struct Key {
+        bool isNull{true};
+        bool isInt{false};
+        int64_t intVal{0};
+        double realVal{0.0};
+    };
+    using Keys = std::vector<Key>;
+
+    /// Rows of one job attempt, in ORDER BY order.
+    struct Run {
+        std::string path;
+        bool complete{false};
+        uint64_t rows{0};
+        Keys last; ///< Keys of the last row, to check the order of the next one.
+    };
+
+    class Reader;
+
+    int _compare(Keys const& a, Keys const& b) const;
+    bool _parseKeys(proto::RowBundle const& row, Keys& keys) const;
+    bool _mergeRuns(std::vector<std::string> const& paths,
+                    std::function<bool(proto::RowBundle& row)> const& emit);
+    std::string _newPath(std::string const& name);
+    static void _remove(std::string const& path);
+
+    Order const _order;
+    std::string const _runDir;
+    std::string const _prefix;
+    std::vector<int> _sortCols; ///< Result column of each ORDER BY term, set by setSchema()
+    std::vector<bool> _isInt; ///< True if a sort column holds integers
+    proto::RowSchema _schema;
+
+    mutable std::mutex _mtx; ///< Protects members below
+    std::map<int, Run> _runs; ///< Runs by job attempt
+    uint64_t _bytes{0};
+    uint64_t _rows{0};
+    unsigned int _nextMergedRun{0};
+};
+
+}}} // namespace lsst::qserv::rproc
+
+#endif // LSST_QSERV_RPROC_SORTEDRUNMERGER_H
@@ -0,0 +1,207 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+// System headers
+#include <map>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// Third-party headers
+#include <mysql/mysql.h>
+
+// Qserv headers
+#include "proto/worker.pb.h"
+#include "rproc/ColumnarResultSink.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE ColumnarResultSink
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::proto::ColumnBlock;
+using lsst::qserv::proto::Result;
+using lsst::qserv::proto::RowBundle;
+using lsst::qserv::rproc::ColumnarResultSink;
+using lsst::qserv::rproc::ResultSink;
+
+struct Fixture {
+    Fixture() {
+        char tmpl[] = "/tmp/testColumnarResultSink.XXXXXX";
+        spillDir = ::mkdtemp(tmpl);
+        addColumn("objectId", "BIGINT", MYSQL_TYPE_LONGLONG);
+        addColumn("name", "CHAR(4)", MYSQL_TYPE_STRING);
+    }
+
+    ~Fixture() {
+        ::rmdir(spillDir.c_str()); // Fails if a file was left behind.
+    }
+
+    void addColumn(std::string const& name, std::string const& sqlType, int mysqlType) {
+        auto cs = result.mutable_rowschema()->add_columnschema();
+        cs->set_name(name);
+        cs->set_deprecated_hasdefault(false);
+        cs->set_sqltype(sqlType);
+        cs->set_mysqltype(mysqlType);
+    }
+
+    void addRow(Result& res, std::vector<std::string> const& values) {
+        RowBundle* rb = res.add_row();
+        for (auto const& val : values) {
+            rb->add_column(val == "NULL" ? "" : val);
+            rb->add_isnull(val == "NULL");
+        }
+        res.set_rowcount(res.row_size());
+    }
+
+    /// @return "jobIdAttempt:value" of column 'col' of the rows passed to
+    ///         load by flush(), in order.
+    std::vector<std::string> flushed(ColumnarResultSink& sink, int col, size_t blockRows) {
+        std::vector<std::string> out;
+        bool ok = sink.flush([&out, col, blockRows](int jobIdAttempt, Result& res) {
+            BOOST_CHECK_EQUAL(res.rowschema().columnschema_size(), 2);
+            BOOST_REQUIRE_EQUAL(res.columnblock_size(), 2);
+            BOOST_CHECK(static_cast<size_t>(res.rowcount()) <= blockRows);
+            ColumnBlock const& block = res.columnblock(col);
+            BOOST_REQUIRE_EQUAL(static_cast<uint32_t>(block.offsets_size()), res.rowcount());
+            for (int j = 0; j < res.rowcount(); ++j) {
+                size_t byteIdx = j / 8;
+                bool isNull = byteIdx < block.nullbitmap().size()
+                              && (block.nullbitmap()[byteIdx] & (1 << (j % 8)));
+                uint32_t begin = (j == 0) ? 0 : block.offsets(j - 1);
+                std::string const val = isNull ? "NULL" : block.values().substr(begin, block.offsets(j) - begin);
+                out.push_back(std::to_string(jobIdAttempt) + ":" + val);
+            }
+            return true;
+        });
+        BOOST_CHECK(ok);
+        return out;
+    }
+
+    std::string spillDir;
+    Result result; ///< Holds the schema
+};
+
+
+BOOST_FIXTURE_TEST_SUITE(suite, Fixture)
+
+BOOST_AUTO_TEST_CASE(Kind) {
+    BOOST_CHECK_EQUAL(ResultSink::kindFromString("columnar"), ResultSink::COLUMNAR);
+    BOOST_CHECK_EQUAL(ResultSink::kindFromString("mysql"), ResultSink::MYSQL);
+    BOOST_CHECK_EQUAL(ResultSink::kindFromString("other"), ResultSink::MYSQL);
+}
+
+BOOST_AUTO_TEST_CASE(HoldInMemory) {
+    ColumnarResultSink sink(spillDir, "q1", 1 << 20, 2);
+    BOOST_REQUIRE(sink.setSchema(result.rowschema()));
+    BOOST_CHECK(sink.holdsRows());
+
+    Result r1 = result;
+    addRow(r1, {"1", "a"});
+    addRow(r1, {"2", "NULL"});
+    addRow(r1, {"3", "c"});
+    Result r2 = result;
+    addRow(r2, {"4", ""});
+    BOOST_CHECK(sink.add(10, r1));
+    BOOST_CHECK(sink.add(20, r2));
+    BOOST_CHECK_EQUAL(sink.getRowCount(), 4u);
+    BOOST_CHECK(sink.getBytes() > 0);
+    BOOST_CHECK_EQUAL(sink.getSpilledBytes(), 0u);
+
+    // NULL and empty values stay apart.
+    BOOST_CHECK(flushed(sink, 1, 2) == std::vector<std::string>({"10:a", "10:NULL", "10:c", "20:"}));
+    BOOST_CHECK_EQUAL(sink.getRowCount(), 0u);
+    BOOST_CHECK_EQUAL(sink.getBytes(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(Spill) {
+    // Every block goes to disk, blocks on disk come back before those in memory.
+    ColumnarResultSink sink(spillDir, "q2", 0, 3);
+    BOOST_REQUIRE(sink.setSchema(result.rowschema()));
+    Result r1 = result;
+    for (int j = 0; j < 5; ++j) {
+        addRow(r1, {std::to_string(j), "x"});
+    }
+    r1.set_continues(true);
+    BOOST_CHECK(sink.add(10, r1));
+    BOOST_CHECK(sink.getSpilledBytes() > 0);
+    Result r2 = result;
+    addRow(r2, {"5", "NULL"});
+    BOOST_CHECK(sink.add(10, r2));
+    BOOST_CHECK_EQUAL(sink.getRowCount(), 6u);
+    BOOST_CHECK(flushed(sink, 0, 3)
+                == std::vector<std::string>({"10:0", "10:1", "10:2", "10:3", "10:4", "10:5"}));
+}
+
+BOOST_AUTO_TEST_CASE(Attempts) {
+    ColumnarResultSink sink(spillDir, "q3", 64, 4);
+    BOOST_REQUIRE(sink.setSchema(result.rowschema()));
+    // Invalid and incomplete attempts are left out, on disk or not.
+    Result r1 = result;
+    for (int j = 0; j < 10; ++j) {
+        addRow(r1, {std::to_string(j), "abcd"});
+    }
+    BOOST_CHECK(sink.add(20, r1));
+    BOOST_CHECK(sink.getSpilledBytes() > 0);
+    BOOST_CHECK(sink.erase({20}));
+    BOOST_CHECK_EQUAL(sink.getRowCount(), 0u);
+    BOOST_CHECK_EQUAL(sink.getBytes(), 0u);
+    Result r2 = result;
+    addRow(r2, {"1", "a"});
+    r2.set_continues(true);
+    BOOST_CHECK(sink.add(30, r2));
+    Result r3 = result;
+    addRow(r3, {"2", "b"});
+    BOOST_CHECK(sink.add(21, r3));
+    BOOST_CHECK(flushed(sink, 1, 4) == std::vector<std::string>({"21:b"}));
+
+    // Rows must match the schema.
+    Result r4 = result;
+    RowBundle* rb = r4.add_row();
+    rb->add_column("1");
+    rb->add_isnull(false);
+    BOOST_CHECK(!sink.add(40, r4));
+}
+
+BOOST_AUTO_TEST_CASE(ColumnarInput) {
+    // Rows sent as columns are held the same way.
+    ColumnarResultSink sink(spillDir, "q4", 1 << 20, 10);
+    BOOST_REQUIRE(sink.setSchema(result.rowschema()));
+    Result r1 = result;
+    ColumnBlock* ids = r1.add_columnblock();
+    ColumnBlock* names = r1.add_columnblock();
+    ids->set_values("12");
+    ids->add_offsets(1);
+    ids->add_offsets(2);
+    names->set_values("ab");
+    names->add_offsets(2);
+    names->add_offsets(2);
+    names->set_nullbitmap(std::string(1, '\x02'));
+    r1.set_rowcount(2);
+    BOOST_CHECK(sink.add(10, r1));
+    BOOST_CHECK(flushed(sink, 1, 10) == std::vector<std::string>({"10:ab", "10:NULL"}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
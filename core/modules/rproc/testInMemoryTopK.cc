@@ -0,0 +1,168 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+// System headers
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+// Third-party headers
+#include <mysql/mysql.h>
+
+// Qserv headers
+#include "proto/worker.pb.h"
+#include "rproc/InMemoryTopK.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE InMemoryTopK
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::proto::Result;
+using lsst::qserv::proto::RowBundle;
+using lsst::qserv::rproc::InMemoryTopK;
+
+struct Fixture {
+    Fixture() {
+        addColumn("objectId", "BIGINT", MYSQL_TYPE_LONGLONG);
+        addColumn("ra", "DOUBLE", MYSQL_TYPE_DOUBLE);
+        addColumn("name", "CHAR(4)", MYSQL_TYPE_STRING);
+    }
+
+    void addColumn(std::string const& name, std::string const& sqlType, int mysqlType) {
+        auto cs = result.mutable_rowschema()->add_columnschema();
+        cs->set_name(name);
+        cs->set_deprecated_hasdefault(false);
+        cs->set_sqltype(sqlType);
+        cs->set_mysqltype(mysqlType);
+    }
+
+    void addRow(Result& res, std::vector<std::string> const& values) {
+        RowBundle* rb = res.add_row();
+        for (auto const& val : values) {
+            rb->add_column(val == "NULL" ? "" : val);
+            rb->add_isnull(val == "NULL");
+        }
+        res.set_rowcount(res.row_size());
+    }
+
+    /// @return column 'col' of every row of 'res', sorted.
+    std::vector<std::string> values(Result const& res, int col) {
+        std::vector<std::string> out;
+        for (int j = 0; j < res.row_size(); ++j) {
+            RowBundle const& rb = res.row(j);
+            out.push_back(rb.isnull(col) ? "NULL" : rb.column(col));
+        }
+        std::sort(out.begin(), out.end());
+        return out;
+    }
+
+    Result result; ///< Holds the schema
+};
+
+
+BOOST_FIXTURE_TEST_SUITE(suite, Fixture)
+
+BOOST_AUTO_TEST_CASE(KeepTop) {
+    InMemoryTopK topK({{"ra", false}}, 3);
+    BOOST_REQUIRE(topK.setSchema(result.rowschema()));
+
+    Result r1 = result;
+    addRow(r1, {"1", "10.5", "a"});
+    addRow(r1, {"2", "3.25", "b"});
+    addRow(r1, {"3", "7", "c"});
+    Result r2 = result;
+    addRow(r2, {"4", "1e-3", "d"});
+    addRow(r2, {"5", "100", "e"});
+    addRow(r2, {"6", "NULL", "f"});
+    BOOST_CHECK(topK.add(10, r1));
+    BOOST_CHECK(topK.add(20, r2));
+    BOOST_CHECK_EQUAL(topK.getAddedRowCount(), 6u);
+
+    // NULL sorts first in ascending order.
+    Result out;
+    topK.extractAll(out);
+    BOOST_CHECK(values(out, 0) == std::vector<std::string>({"2", "4", "6"}));
+}
+
+BOOST_AUTO_TEST_CASE(Descending) {
+    InMemoryTopK topK({{"objectId", true}, {"ra", false}}, 2);
+    BOOST_REQUIRE(topK.setSchema(result.rowschema()));
+    Result r1 = result;
+    addRow(r1, {"7", "2", "a"});
+    addRow(r1, {"9", "5", "b"});
+    addRow(r1, {"9", "1", "c"});
+    addRow(r1, {"NULL", "0", "d"});
+    BOOST_CHECK(topK.add(10, r1));
+    Result out;
+    topK.extractAll(out);
+    BOOST_CHECK(values(out, 2) == std::vector<std::string>({"b", "c"}));
+}
+
+BOOST_AUTO_TEST_CASE(Attempts) {
+    InMemoryTopK topK({{"objectId", false}}, 2);
+    BOOST_REQUIRE(topK.setSchema(result.rowschema()));
+    // Rows of an attempt still sending messages are not ranked yet.
+    Result r1 = result;
+    addRow(r1, {"1", "0", "a"});
+    r1.set_continues(true);
+    BOOST_CHECK(topK.add(10, r1));
+    Result r2 = result;
+    addRow(r2, {"5", "0", "b"});
+    addRow(r2, {"6", "0", "c"});
+    BOOST_CHECK(topK.add(20, r2));
+    Result r3 = result;
+    addRow(r3, {"2", "0", "d"});
+    BOOST_CHECK(topK.add(10, r3));
+    // Attempt 10 pushed out 6 and 5, then is invalid.
+    topK.erase({10});
+    Result r4 = result;
+    addRow(r4, {"1", "0", "a"});
+    addRow(r4, {"2", "0", "d"});
+    BOOST_CHECK(topK.add(11, r4));
+
+    std::map<int, int> jobRows;
+    topK.extractEach([&jobRows](int jobIdAttempt, Result& res) { jobRows[jobIdAttempt] = res.row_size(); });
+    BOOST_CHECK_EQUAL(jobRows.size(), 1u);
+    BOOST_CHECK_EQUAL(jobRows[11], 2);
+}
+
+BOOST_AUTO_TEST_CASE(Refuse) {
+    InMemoryTopK topK({{"ra", false}}, 2);
+    BOOST_REQUIRE(topK.setSchema(result.rowschema()));
+    Result r1 = result;
+    addRow(r1, {"1", "x", "a"});
+    BOOST_CHECK(!topK.add(10, r1));
+    BOOST_CHECK_EQUAL(topK.getAddedRowCount(), 0u);
+
+    // String order depends on the collation, missing columns cannot be ranked.
+    InMemoryTopK byName({{"name", false}}, 2);
+    BOOST_CHECK(!byName.setSchema(result.rowschema()));
+    InMemoryTopK missing({{"decl", false}}, 2);
+    BOOST_CHECK(!missing.setSchema(result.rowschema()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,218 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+// System headers
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// Third-party headers
+#include <mysql/mysql.h>
+
+// Qserv headers
+#include "proto/worker.pb.h"
+#include "rproc/SortedRunMerger.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE SortedRunMerger
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::proto::Result;
+using lsst::qserv::proto::RowBundle;
+using lsst::qserv::rproc::SortedRunMerger;
+
+struct Fixture {
+    Fixture() {
+        char tmpl[] = "/tmp/testSortedRunMerger.XXXXXX";
+        runDir = ::mkdtemp(tmpl);
+        addColumn("objectId", "BIGINT", MYSQL_TYPE_LONGLONG);
+        addColumn("ra", "DOUBLE", MYSQL_TYPE_DOUBLE);
+        addColumn("name", "CHAR(4)", MYSQL_TYPE_STRING);
+    }
+
+    ~Fixture() {
+        ::rmdir(runDir.c_str()); // Fails if a run was left behind.
+    }
+
+    void addColumn(std::string const& name, std::string const& sqlType, int mysqlType) {
+        auto cs = result.mutable_rowschema()->add_columnschema();
+        cs->set_name(name);
+        cs->set_deprecated_hasdefault(false);
+        cs->set_sqltype(sqlType);
+        cs->set_mysqltype(mysqlType);
+    }
+
+    void addRow(Result& res, std::vector<std::string> const& values) {
+        RowBundle* rb = res.add_row();
+        for (auto const& val : values) {
+            rb->add_column(val == "NULL" ? "" : val);
+            rb->add_isnull(val == "NULL");
+        }
+        res.set_rowcount(res.row_size());
+    }
+
+    /// @return column 'col' of the rows passed to load by merge(), in order.
+    std::vector<std::string> merged(SortedRunMerger& merger, int col, size_t batchRows=2) {
+        std::vector<std::string> out;
+        bool ok = merger.merge(batchRows, [&out, col, batchRows](Result& res) {
+            BOOST_CHECK(static_cast<size_t>(res.row_size()) <= batchRows);
+            BOOST_CHECK_EQUAL(res.rowschema().columnschema_size(), 3);
+            for (int j = 0; j < res.row_size(); ++j) {
+                RowBundle const& rb = res.row(j);
+                out.push_back(rb.isnull(col) ? "NULL" : rb.column(col));
+            }
+            return true;
+        });
+        BOOST_CHECK(ok);
+        return out;
+    }
+
+    std::string runDir;
+    Result result; ///< Holds the schema
+};
+
+
+BOOST_FIXTURE_TEST_SUITE(suite, Fixture)
+
+BOOST_AUTO_TEST_CASE(MergeInOrder) {
+    SortedRunMerger merger({{"ra", false}}, runDir, "q1");
+    BOOST_REQUIRE(merger.setSchema(result.rowschema()));
+
+    Result r1 = result;
+    addRow(r1, {"1", "NULL", "a"});
+    addRow(r1, {"2", "3.25", "b"});
+    addRow(r1, {"3", "7", "c"});
+    Result r2 = result;
+    addRow(r2, {"4", "1e-3", "d"});
+    addRow(r2, {"5", "7", "e"});
+    addRow(r2, {"6", "100", "f"});
+    Result r3 = result;
+    addRow(r3, {"7", "5", "g"});
+    BOOST_CHECK(merger.add(10, r1));
+    BOOST_CHECK(merger.add(20, r2));
+    BOOST_CHECK(merger.add(30, r3));
+    BOOST_CHECK_EQUAL(merger.getRowCount(), 7u);
+    BOOST_CHECK(merger.getBytes() > 0);
+
+    // NULL sorts first in ascending order, ties go to the earlier run.
+    BOOST_CHECK(merged(merger, 0) == std::vector<std::string>({"1", "4", "2", "7", "3", "5", "6"}));
+    BOOST_CHECK_EQUAL(merger.getRowCount(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(Descending) {
+    SortedRunMerger merger({{"objectId", true}, {"ra", false}}, runDir, "q2");
+    BOOST_REQUIRE(merger.setSchema(result.rowschema()));
+    Result r1 = result;
+    addRow(r1, {"9", "1", "a"});
+    addRow(r1, {"9", "5", "b"});
+    addRow(r1, {"NULL", "0", "c"});
+    Result r2 = result;
+    addRow(r2, {"9", "2", "d"});
+    addRow(r2, {"7", "2", "e"});
+    BOOST_CHECK(merger.add(10, r1));
+    BOOST_CHECK(merger.add(20, r2));
+    BOOST_CHECK(merged(merger, 2, 10) == std::vector<std::string>({"a", "d", "b", "e", "c"}));
+}
+
+BOOST_AUTO_TEST_CASE(Attempts) {
+    SortedRunMerger merger({{"objectId", false}}, runDir, "q3");
+    BOOST_REQUIRE(merger.setSchema(result.rowschema()));
+    // A run goes on over the messages of its attempt.
+    Result r1 = result;
+    addRow(r1, {"1", "0", "a"});
+    r1.set_continues(true);
+    BOOST_CHECK(merger.add(10, r1));
+    Result r2 = result;
+    addRow(r2, {"3", "0", "b"});
+    BOOST_CHECK(merger.add(10, r2));
+    // Invalid and incomplete attempts are left out.
+    Result r3 = result;
+    addRow(r3, {"2", "0", "c"});
+    BOOST_CHECK(merger.add(20, r3));
+    merger.erase({20});
+    Result r4 = result;
+    addRow(r4, {"0", "0", "d"});
+    r4.set_continues(true);
+    BOOST_CHECK(merger.add(30, r4));
+    Result r5 = result;
+    addRow(r5, {"2", "0", "e"});
+    BOOST_CHECK(merger.add(21, r5));
+    BOOST_CHECK(merged(merger, 2) == std::vector<std::string>({"a", "e", "b"}));
+}
+
+BOOST_AUTO_TEST_CASE(ManyRuns) {
+    // More runs than are read at once are first merged into longer runs.
+    SortedRunMerger merger({{"objectId", false}}, runDir, "q4");
+    BOOST_REQUIRE(merger.setSchema(result.rowschema()));
+    int const runs = SortedRunMerger::maxFanIn * 2 + 3;
+    for (int j = 0; j < runs; ++j) {
+        Result res = result;
+        addRow(res, {std::to_string(j), "0", "a"});
+        addRow(res, {std::to_string(j + runs), "0", "b"});
+        BOOST_CHECK(merger.add(runs - j, res));
+    }
+    std::vector<std::string> out = merged(merger, 0, 100);
+    BOOST_REQUIRE_EQUAL(out.size(), 2u * runs);
+    for (int j = 0; j < 2 * runs; ++j) {
+        BOOST_CHECK_EQUAL(out[j], std::to_string(j));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(Refuse) {
+    SortedRunMerger merger({{"ra", false}}, runDir, "q5");
+    BOOST_REQUIRE(merger.setSchema(result.rowschema()));
+    Result r1 = result;
+    addRow(r1, {"1", "2", "a"});
+    addRow(r1, {"2", "1", "b"});
+    BOOST_CHECK(!merger.add(10, r1));
+    Result r2 = result;
+    addRow(r2, {"1", "x", "a"});
+    BOOST_CHECK(!merger.add(20, r2));
+    Result r3 = result;
+    addRow(r3, {"3", "4", "c"});
+    r3.set_continues(true);
+    BOOST_CHECK(merger.add(30, r3));
+    BOOST_CHECK_EQUAL(merger.getRowCount(), 1u);
+
+    // Rows already in the runs can still be taken out.
+    std::map<int, int> jobRows;
+    BOOST_CHECK(merger.extractEach(10, [&jobRows](int jobIdAttempt, Result& res) {
+        jobRows[jobIdAttempt] += res.row_size();
+        return true;
+    }));
+    BOOST_CHECK_EQUAL(jobRows.size(), 1u);
+    BOOST_CHECK_EQUAL(jobRows[30], 1);
+
+    // String order depends on the collation, missing columns cannot be merged.
+    SortedRunMerger byName({{"name", false}}, runDir, "q6");
+    BOOST_CHECK(!byName.setSchema(result.rowschema()));
+    SortedRunMerger missing({{"decl", false}}, runDir, "q7");
+    BOOST_CHECK(!missing.setSchema(result.rowschema()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,207 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "sql/ChunkStatsCache.h"
+
+// System headers
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "sql/SqlConnection.h"
+
+namespace {
+LOG_LOGGER _log = LOG_GET("lsst.qserv.sql.ChunkStatsCache");
+
+std::string const columns =
+    "`worker`,`database`,`table`,`chunk`,`num_rows`,`data_size`,`index_size`,"
+    "`tasks_completed`,`avg_scan_seconds`,`last_scan_seconds`,`collect_time`";
+}
+
+namespace lsst {
+namespace qserv {
+namespace sql {
+
+ChunkStatsCache::Ptr ChunkStatsCache::create(mysql::MySqlConfig const& config,
+                                             std::chrono::seconds refreshInterval) {
+    return create(std::make_shared<SqlConnection>(config, true), refreshInterval);
+}
+
+
+ChunkStatsCache::Ptr ChunkStatsCache::create(std::shared_ptr<SqlConnection> const& conn,
+                                             std::chrono::seconds refreshInterval) {
+    return Ptr(new ChunkStatsCache(conn, refreshInterval));
+}
+
+
+ChunkStatsCache::ChunkStatsCache(std::shared_ptr<SqlConnection> const& conn,
+                                 std::chrono::seconds refreshInterval)
+    : _conn(conn), _refreshInterval(refreshInterval) {
+}
+
+
+bool ChunkStatsCache::get(std::string const& db, std::string const& table, int chunk, Stats& stats) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _refreshIfStale(lock);
+    auto const itr = _rows.find(Key(db, table, chunk));
+    if (itr == _rows.end()) return false;
+    stats = _merge(itr->second);
+    return true;
+}
+
+
+std::map<int, ChunkStatsCache::Stats> ChunkStatsCache::getTable(std::string const& db,
+                                                                 std::string const& table) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _refreshIfStale(lock);
+    std::map<int, Stats> result;
+    for (auto itr = _rows.lower_bound(Key(db, table, std::numeric_limits<int>::min()));
+         itr != _rows.end() && std::get<0>(itr->first) == db && std::get<1>(itr->first) == table;
+         ++itr) {
+        result[std::get<2>(itr->first)] = _merge(itr->second);
+    }
+    return result;
+}
+
+
+bool ChunkStatsCache::refresh() {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _refresh(lock);
+}
+
+
+void ChunkStatsCache::_refreshIfStale(std::lock_guard<std::mutex> const& lock) {
+    if (!_loaded || std::chrono::steady_clock::now() - _lastRefresh >= _refreshInterval) {
+        _refresh(lock);
+    }
+}
+
+
+bool ChunkStatsCache::_refresh(std::lock_guard<std::mutex> const& lock) {
+    // A failed refresh is retried on the next lookup after the interval.
+    _lastRefresh = std::chrono::steady_clock::now();
+    if (!_read(_loaded ? _maxCollectTime : 0)) return false;
+    _loaded = true;
+
+    std::string const query = "SELECT COUNT(*),IFNULL(SUM(`collect_time` DIV 1000),0) FROM `chunk_stats`";
+    auto results = _conn->getQueryIter(query);
+    if (results->getErrorObject().isSet()) {
+        LOGS(_log, LOG_LVL_ERROR, "failed to check the statistics: "
+             << results->getErrorObject().printErrMsg());
+        return false;
+    }
+    bool consistent = false;
+    for (; !results->done(); ++(*results)) {
+        StringVector const& row = **results;
+        consistent = std::stoull(row[0]) == _numRows && std::stoull(row[1]) == _sumCollectSeconds;
+    }
+    if (consistent) return true;
+
+    LOGS(_log, LOG_LVL_DEBUG, "reading all statistics again, rows: " << _numRows);
+    _rows.clear();
+    _numRows = 0;
+    _sumCollectSeconds = 0;
+    _maxCollectTime = 0;
+    if (!_read(0)) {
+        _loaded = false;
+        return false;
+    }
+    return true;
+}
+
+
+bool ChunkStatsCache::_read(uint64_t after) {
+    std::string query = "SELECT " + columns + " FROM `chunk_stats`";
+    if (after != 0) query += " WHERE `collect_time`>" + std::to_string(after);
+    LOGS(_log, LOG_LVL_DEBUG, "query: " << query);
+
+    auto results = _conn->getQueryIter(query);
+    if (results->getErrorObject().isSet()) {
+        LOGS(_log, LOG_LVL_ERROR, "failed to read the statistics: "
+             << results->getErrorObject().printErrMsg());
+        return false;
+    }
+    size_t numChanged = 0;
+    try {
+        for (; !results->done(); ++(*results)) {
+            StringVector const& row = **results;
+            Row r;
+            r.numRows = std::stoull(row[4]);
+            r.dataSize = std::stoull(row[5]);
+            r.indexSize = std::stoull(row[6]);
+            r.tasksCompleted = std::stoull(row[7]);
+            r.avgScanSeconds = std::stod(row[8]);
+            r.lastScanSeconds = std::stod(row[9]);
+            r.collectTime = std::stoull(row[10]);
+
+            Row& old = _rows[Key(row[1], row[2], std::stoi(row[3]))][row[0]];
+            if (old.collectTime == 0) {
+                ++_numRows;
+            } else {
+                _sumCollectSeconds -= old.collectTime / 1000;
+            }
+            _sumCollectSeconds += r.collectTime / 1000;
+            _maxCollectTime = std::max(_maxCollectTime, r.collectTime);
+            old = r;
+            ++numChanged;
+        }
+    } catch (std::exception const& ex) {
+        // The copy may be partly updated, the check reads it all again.
+        LOGS(_log, LOG_LVL_ERROR, "failed to parse the statistics: " << ex.what());
+        _maxCollectTime = 0;
+        return false;
+    }
+    LOGS(_log, LOG_LVL_DEBUG, "rows changed: " << numChanged << " rows: " << _numRows);
+    return true;
+}
+
+
+ChunkStatsCache::Stats ChunkStatsCache::_merge(Replicas const& replicas) {
+    Stats stats;
+    double scanSeconds = 0;
+    uint64_t lastChange = 0;
+    for (auto const& entry : replicas) {
+        Row const& r = entry.second;
+        ++stats.numReplicas;
+        if (r.dataSize + r.indexSize >= stats.dataSize + stats.indexSize) {
+            stats.numRows = r.numRows;
+            stats.dataSize = r.dataSize;
+            stats.indexSize = r.indexSize;
+        }
+        stats.tasksCompleted += r.tasksCompleted;
+        scanSeconds += r.avgScanSeconds * r.tasksCompleted;
+        if (r.tasksCompleted != 0 && r.collectTime >= lastChange) {
+            lastChange = r.collectTime;
+            stats.lastScanSeconds = r.lastScanSeconds;
+        }
+    }
+    if (stats.tasksCompleted != 0) stats.avgScanSeconds = scanSeconds / stats.tasksCompleted;
+    return stats;
+}
+
+}}} // namespace lsst::qserv::sql
@@ -0,0 +1,135 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_QSERV_SQL_CHUNKSTATSCACHE_H
+#define LSST_QSERV_SQL_CHUNKSTATSCACHE_H
+
+// System headers
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+// Qserv headers
+#include "mysql/MySqlConfig.h"
+
+namespace lsst {
+namespace qserv {
+namespace sql {
+
+class SqlConnection;
+
+/// ChunkStatsCache keeps a copy of the statistics of the chunk tables which
+/// the Replication system collects from the workers into its table
+/// 'chunk_stats', for the planning and the scheduling of the czar and the
+/// workers. A lookup refreshes the copy once it's older than the refresh
+/// interval, and a failed refresh leaves the previous copy in use.
+///
+/// A refresh only reads the rows changed since the latest change already
+/// in the copy. The number of rows and the sum of their times of change are
+/// then compared with the ones of the table, and all rows are read again if
+/// they differ, as they do after rows were removed, or were saved after
+/// a later change was already read.
+class ChunkStatsCache {
+public:
+    typedef std::shared_ptr<ChunkStatsCache> Ptr;
+
+    /// The statistics of one table of one chunk, over its replicas.
+    struct Stats {
+        uint64_t numRows{0};         ///< Of the largest replica.
+        uint64_t dataSize{0};        ///< Bytes, of the largest replica.
+        uint64_t indexSize{0};       ///< Bytes, of the largest replica.
+        uint64_t tasksCompleted{0};  ///< Tasks which scanned the table, at all replicas.
+        double avgScanSeconds{0};    ///< Average over the replicas weighted by their tasks.
+        double lastScanSeconds{0};   ///< Of the replica changed last.
+        unsigned int numReplicas{0};
+    };
+
+    /// @param config - how to connect to the database of the Replication system.
+    /// @param refreshInterval - the age of the copy after which a lookup refreshes it.
+    static Ptr create(mysql::MySqlConfig const& config, std::chrono::seconds refreshInterval);
+
+    /// @param conn - a connection to the database of the Replication system.
+    /// @param refreshInterval - the age of the copy after which a lookup refreshes it.
+    static Ptr create(std::shared_ptr<SqlConnection> const& conn, std::chrono::seconds refreshInterval);
+
+    ChunkStatsCache(ChunkStatsCache const&) = delete;
+    ChunkStatsCache& operator=(ChunkStatsCache const&) = delete;
+
+    ~ChunkStatsCache() = default;
+
+    /// @return true with 'stats' set if the table of the chunk is known.
+    bool get(std::string const& db, std::string const& table, int chunk, Stats& stats);
+
+    /// @return the statistics of the known chunks of a table.
+    std::map<int, Stats> getTable(std::string const& db, std::string const& table);
+
+    /// Read the changes now rather than on the next lookup.
+    /// @return false if they couldn't be read.
+    bool refresh();
+
+private:
+    /// The statistics of one replica.
+    struct Row {
+        uint64_t numRows{0};
+        uint64_t dataSize{0};
+        uint64_t indexSize{0};
+        uint64_t tasksCompleted{0};
+        double avgScanSeconds{0};
+        double lastScanSeconds{0};
+        uint64_t collectTime{0};  ///< Milliseconds since the UNIX Epoch of the last change.
+    };
+
+    /// The rows of the replicas of a table of a chunk, by worker.
+    typedef std::map<std::string, Row> Replicas;
+
+    typedef std::tuple<std::string, std::string, int> Key;  ///< Database, table and chunk.
+
+    ChunkStatsCache(std::shared_ptr<SqlConnection> const& conn, std::chrono::seconds refreshInterval);
+
+    void _refreshIfStale(std::lock_guard<std::mutex> const& lock);
+    bool _refresh(std::lock_guard<std::mutex> const& lock);
+
+    /// Read the rows changed after 'after' (milliseconds) into the copy.
+    bool _read(uint64_t after);
+
+    static Stats _merge(Replicas const& replicas);
+
+    std::shared_ptr<SqlConnection> const _conn;
+    std::chrono::seconds const _refreshInterval;
+
+    std::mutex _mtx;  ///< Protects members below.
+    std::map<Key, Replicas> _rows;
+    uint64_t _numRows{0};
+    uint64_t _sumCollectSeconds{0};  ///< Sum of the times of change, in seconds.
+    uint64_t _maxCollectTime{0};     ///< Latest time of change, in milliseconds.
+    bool _loaded{false};
+    std::chrono::steady_clock::time_point _lastRefresh;
+};
+
+}}} // namespace lsst::qserv::sql
+
+#endif // LSST_QSERV_SQL_CHUNKSTATSCACHE_H
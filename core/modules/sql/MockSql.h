@@ -45,6 +45,14 @@ public:
     virtual bool runQuery(std::string const query, SqlResults&,
                           SqlErrorObject&) {
         return false; }
+    virtual bool runQueryStreaming(std::string const& query, SqlResults&,
+                                   SqlErrorObject&) {
+        return false; }
+    virtual bool loadDataInfile(std::string const& table,
+                                std::vector<std::string> const& columns,
+                                std::shared_ptr<mysql::RowBuffer> const& rowBuffer,
+                                SqlErrorObject&) {
+        return false; }
     virtual std::shared_ptr<SqlResultIter> getQueryIter(std::string const& query);
     virtual bool runQuery(std::string const query, SqlErrorObject&) {
         return false; }
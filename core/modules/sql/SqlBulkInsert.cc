@@ -24,12 +24,59 @@
 #include "sql/SqlBulkInsert.h"
 
 // System headers
+#include <algorithm>
+#include <cstring>
+#include <memory>
 
 // LSST headers
 
 // Qserv headers
+#include "mysql/RowBuffer.h"
 #include "sql/SqlResults.h"
 
+namespace {
+
+/// Hands the bytes of a string to LocalInfile, the string must not change
+/// while it is read.
+class StringRowBuffer : public lsst::qserv::mysql::RowBuffer {
+public:
+    explicit StringRowBuffer(std::string const& data) : _data(data) {}
+
+    unsigned fetch(char* buffer, unsigned bufLen) override {
+        unsigned const size = std::min<size_t>(bufLen, _data.size() - _pos);
+        std::memcpy(buffer, _data.data() + _pos, size);
+        _pos += size;
+        return size;
+    }
+
+    std::string dump() const override {
+        return "StringRowBuffer " + std::to_string(_data.size()) + " bytes";
+    }
+
+private:
+    std::string const& _data;
+    size_t _pos = 0;
+};
+
+/// Append a value escaped for the default LOAD DATA field format
+void appendLoadValue(std::string& buffer, char const* value, unsigned long length) {
+    if (value == nullptr) {
+        buffer += "\\N";
+        return;
+    }
+    for (char const* ptr = value; ptr != value + length; ++ptr) {
+        switch (*ptr) {
+        case '\0': buffer += "\\0"; break;
+        case '\t': buffer += "\\t"; break;
+        case '\n': buffer += "\\n"; break;
+        case '\\': buffer += "\\\\"; break;
+        default: buffer += *ptr; break;
+        }
+    }
+}
+
+} // anonymous namespace
+
 namespace lsst {
 namespace qserv {
 namespace sql {
@@ -37,8 +84,10 @@ namespace sql {
 // Constructors
 SqlBulkInsert::SqlBulkInsert(SqlConnection* conn,
                              std::string const& table,
-                             std::vector<std::string> const& columns)
-    : _conn(conn), _maxSize(0), _insert(), _buffer()
+                             std::vector<std::string> const& columns,
+                             size_t loadDataMinRows)
+    : _conn(conn), _maxSize(0), _table(table), _columns(columns), _insert(), _buffer(),
+      _loadDataMinRows(loadDataMinRows)
 {
     // Build initial INSERT
     _insert = "INSERT INTO ";
@@ -58,6 +107,107 @@ SqlBulkInsert::SqlBulkInsert(SqlConnection* conn,
 bool
 SqlBulkInsert::addRow(std::vector<std::string> const& values, SqlErrorObject& errObj) {
 
+    // get the size of row to be inserted
+    unsigned rowSize = 0;
+    for (auto&& val: values) {
+        rowSize += val.size();
+    }
+    // plus parens and commas as in ",(val,val,val)"
+    rowSize += 2 + values.size();
+
+    if (!_startInsertRow(rowSize, errObj)) {
+        return false;
+    }
+
+    // add values
+    char sep = '(';
+    for (auto&& val: values) {
+        _buffer += sep;
+        _buffer += val;
+        sep = ',';
+    }
+    _buffer += ')';
+
+    return true;
+}
+
+// Insert one more row of unquoted values
+bool
+SqlBulkInsert::addRowView(RowView const& values, SqlErrorObject& errObj) {
+
+    if (!_setMaxSize(errObj)) {
+        return false;
+    }
+    ++_viewRows;
+
+    if (_loadDataMinRows == 0 || _viewRows <= _loadDataMinRows) {
+        // quote, escape and add to INSERT, escaping may double the size
+        unsigned long rowSize = 2;
+        for (auto&& val: values) {
+            rowSize += 3 + 2*val.second;
+        }
+        if (!_startInsertRow(rowSize, errObj)) {
+            return false;
+        }
+        char sep = '(';
+        for (auto&& val: values) {
+            _buffer += sep;
+            if (val.first == nullptr) {
+                _buffer += "NULL";
+            } else {
+                _buffer += '\'';
+                _buffer += _conn->escapeString(std::string(val.first, val.second));
+                _buffer += '\'';
+            }
+            sep = ',';
+        }
+        _buffer += ')';
+        return true;
+    }
+
+    if (_viewRows == _loadDataMinRows + 1) {
+        // rows so far are sent as INSERT, the rest with LOAD DATA
+        if (!_buffer.empty()) {
+            if (!_conn->runQuery(_buffer, errObj)) {
+                return false;
+            }
+            _buffer.clear();
+        }
+        _loadBuffer.reserve(_maxSize);
+    }
+
+    char sep = 0;
+    for (auto&& val: values) {
+        if (sep) _loadBuffer += sep;
+        appendLoadValue(_loadBuffer, val.first, val.second);
+        sep = '\t';
+    }
+    _loadBuffer += '\n';
+
+    if (_loadBuffer.size() >= _maxSize) {
+        return _flushLoadData(errObj);
+    }
+    return true;
+}
+
+// flush buffer
+bool SqlBulkInsert::flush(SqlErrorObject& errObj) {
+    if (!_buffer.empty()) {
+        if (!_conn->runQuery(_buffer, errObj)) {
+            return false;
+        }
+        _buffer.clear();
+    }
+    if (!_flushLoadData(errObj)) {
+        return false;
+    }
+    _viewRows = 0;
+    return true;
+}
+
+bool
+SqlBulkInsert::_setMaxSize(SqlErrorObject& errObj) {
+
     if (_maxSize == 0) {
         // get max. buffer size
         std::string query = "SELECT @@session.max_allowed_packet";
@@ -82,21 +232,23 @@ SqlBulkInsert::addRow(std::vector<std::string> const& values, SqlErrorObject& er
             _maxSize = 16*1024;
         }
     }
+    return true;
+}
 
-    // get the size of row to be inserted
-    unsigned rowSize = 0;
-    for (auto&& val: values) {
-        rowSize += val.size();
+bool
+SqlBulkInsert::_startInsertRow(unsigned long rowSize, SqlErrorObject& errObj) {
+
+    if (!_setMaxSize(errObj)) {
+        return false;
     }
-    // plus parens and commas as in ",(val,val,val)"
-    rowSize += 2 + values.size();
 
     if (!_buffer.empty()) {
         // check new size
         if (_buffer.size() + rowSize > _maxSize) {
-            if (!flush(errObj)) {
+            if (!_conn->runQuery(_buffer, errObj)) {
                 return false;
             }
+            _buffer.clear();
         }
     }
     if (_buffer.empty()) {
@@ -105,27 +257,19 @@ SqlBulkInsert::addRow(std::vector<std::string> const& values, SqlErrorObject& er
     } else {
         _buffer += ',';
     }
-
-    // add values
-    char sep = '(';
-    for (auto&& val: values) {
-        _buffer += sep;
-        _buffer += val;
-        sep = ',';
-    }
-    _buffer += ')';
-
     return true;
 }
 
-// flush buffer
-bool SqlBulkInsert::flush(SqlErrorObject& errObj) {
-    if (!_buffer.empty()) {
-        if (!_conn->runQuery(_buffer, errObj)) {
-            return false;
-        }
-        _buffer.clear();
+bool
+SqlBulkInsert::_flushLoadData(SqlErrorObject& errObj) {
+    if (_loadBuffer.empty()) {
+        return true;
+    }
+    auto rowBuffer = std::make_shared<StringRowBuffer>(_loadBuffer);
+    if (!_conn->loadDataInfile(_table, _columns, rowBuffer, errObj)) {
+        return false;
     }
+    _loadBuffer.clear();
     return true;
 }
 
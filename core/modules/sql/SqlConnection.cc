@@ -35,7 +35,9 @@
 #include "lsst/log/Log.h"
 
 // Qserv headers
+#include "mysql/LocalInfile.h"
 #include "mysql/MySqlConnection.h"
+#include "mysql/RowBuffer.h"
 #include "sql/SqlResults.h"
 
 namespace {
@@ -223,6 +225,61 @@ SqlConnection::runQuery(std::string const query,
     return runQuery(query.data(), query.size(), results, errObj);
 }
 
+bool
+SqlConnection::runQueryStreaming(std::string const& query,
+                                 SqlResults& results,
+                                 SqlErrorObject& errObj) {
+    if (!connectToDb(errObj)) {
+        LOGS(_log, LOG_LVL_ERROR, "runQueryStreaming failed connectToDb: " << query);
+        return false;
+    }
+    MYSQL* mysql = _connection->getMySql();
+    if (mysql_real_query(mysql, query.data(), query.size()) != 0) {
+        return _setErrorObject(errObj, "Unable to execute query: " + query);
+    }
+    MYSQL_RES* result = mysql_use_result(mysql);
+    if (result) {
+        results.addStreamingResult(result, mysql);
+    } else if (mysql_field_count(mysql) != 0) {
+        return _setErrorObject(errObj, "Unable to use result for query: " + query);
+    } else {
+        results.setAffectedRows(mysql_affected_rows(mysql));
+    }
+    return true;
+}
+
+bool
+SqlConnection::loadDataInfile(std::string const& table,
+                              std::vector<std::string> const& columns,
+                              std::shared_ptr<mysql::RowBuffer> const& rowBuffer,
+                              SqlErrorObject& errObj) {
+    if (!connectToDb(errObj)) {
+        LOGS(_log, LOG_LVL_ERROR, "loadDataInfile failed connectToDb: " << table);
+        return false;
+    }
+    // the handler is only attached for this statement, as the connection
+    // may be shared
+    MYSQL* mysql = _connection->getMySql();
+    mysql::LocalInfile::Mgr infileMgr;
+    infileMgr.attach(mysql);
+    std::string query = "LOAD DATA LOCAL INFILE '" + infileMgr.prepareSrc(rowBuffer, table + " ")
+        + "' INTO TABLE " + table;
+    char sep = '(';
+    for (auto const& column: columns) {
+        query += sep;
+        query += '`';
+        query += column;
+        query += '`';
+        sep = ',';
+    }
+    if (not columns.empty()) {
+        query += ')';
+    }
+    bool const ok = runQuery(query, errObj);
+    infileMgr.detachReset(mysql);
+    return ok;
+}
+
 /// with runQueryIter SqlConnection is busy until SqlResultIter is closed
 std::shared_ptr<SqlResultIter>
 SqlConnection::getQueryIter(std::string const& query) {
@@ -48,6 +48,7 @@ namespace lsst {
 namespace qserv {
 namespace mysql {
     class MySqlConnection;
+    class RowBuffer;
 }
 namespace sql {
     class SqlResults;
@@ -92,6 +93,17 @@ public:
     virtual bool runQuery(char const* query, int qSize, SqlErrorObject&);
     virtual bool runQuery(std::string const query, SqlResults&,
                           SqlErrorObject&);
+    /// Run a single statement and stream its rows to 'results' as they are
+    /// iterated over instead of storing them all first. The connection is
+    /// busy until the rows are all read or results.freeResults() is called.
+    virtual bool runQueryStreaming(std::string const& query, SqlResults&,
+                                   SqlErrorObject&);
+    /// Load the tab-separated rows of 'rowBuffer' into 'columns' of 'table'
+    /// with LOAD DATA LOCAL INFILE.
+    virtual bool loadDataInfile(std::string const& table,
+                                std::vector<std::string> const& columns,
+                                std::shared_ptr<mysql::RowBuffer> const& rowBuffer,
+                                SqlErrorObject&);
     /// with runQueryIter SqlConnection is busy until SqlResultIter is closed
     virtual std::shared_ptr<SqlResultIter> getQueryIter(std::string const& query);
     virtual bool runQuery(std::string const query, SqlErrorObject&);
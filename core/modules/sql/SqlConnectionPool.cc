@@ -0,0 +1,181 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "sql/SqlConnectionPool.h"
+
+// System headers
+#include <algorithm>
+#include <utility>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+namespace {
+LOG_LOGGER _log = LOG_GET("lsst.qserv.sql.SqlConnectionPool");
+}
+
+namespace lsst {
+namespace qserv {
+namespace sql {
+
+SqlConnectionPool::Ptr SqlConnectionPool::create(mysql::MySqlConfig const& config, size_t maxConnections,
+                                                 std::chrono::milliseconds maxWait,
+                                                 std::chrono::seconds checkAfterIdle) {
+    return Ptr(new SqlConnectionPool(config, maxConnections, maxWait, checkAfterIdle));
+}
+
+
+SqlConnectionPool::SqlConnectionPool(mysql::MySqlConfig const& config, size_t maxConnections,
+                                     std::chrono::milliseconds maxWait, std::chrono::seconds checkAfterIdle)
+    : _config(config), _maxConnections(std::max(maxConnections, size_t(1))),
+      _maxWait(maxWait), _checkAfterIdle(checkAfterIdle) {
+}
+
+
+SqlConnectionPool::Lease SqlConnectionPool::acquire(std::string const& purpose, SqlErrorObject& errObj) {
+    auto const start = std::chrono::steady_clock::now();
+    bool waited = false;
+    bool overflow = false;
+    std::unique_ptr<SqlConnection> conn;
+    std::unique_lock<std::mutex> lock(_mtx);
+    while (conn == nullptr) {
+        if (not _idle.empty()) {
+            Idle idle = std::move(_idle.front());
+            _idle.pop_front();
+            if (std::chrono::steady_clock::now() - idle.since < _checkAfterIdle) {
+                conn = std::move(idle.conn);
+                break;
+            }
+            // The server may have closed it in the meantime.
+            lock.unlock();
+            SqlErrorObject checkErr;
+            bool const ok = idle.conn->runQuery("SELECT 1", checkErr);
+            if (not ok) {
+                LOGS(_log, LOG_LVL_DEBUG, "idle connection failed check: " << checkErr.errMsg());
+                idle.conn.reset();
+            }
+            lock.lock();
+            if (ok) {
+                conn = std::move(idle.conn);
+            } else {
+                --_numOpen;
+                ++_stats.closed;
+                ++_stats.checkFailures;
+            }
+            continue;
+        }
+        bool const timedOut = waited and std::chrono::steady_clock::now() - start >= _maxWait;
+        if (_numOpen < _maxConnections or timedOut) {
+            overflow = _numOpen >= _maxConnections;
+            if (overflow) {
+                ++_stats.overflows;
+                LOGS(_log, LOG_LVL_WARN, "all " << _maxConnections << " connections leased, "
+                     << purpose << " gets an extra one");
+            } else {
+                ++_numOpen;
+            }
+            lock.unlock();
+            conn = _connect(errObj);
+            lock.lock();
+            if (conn == nullptr) {
+                if (not overflow) --_numOpen;
+                _cv.notify_one();
+                return nullptr;
+            }
+            ++_stats.opened;
+            break;
+        }
+        waited = true;
+        _cv.wait_until(lock, start + _maxWait);
+    }
+
+    PurposeStats& purposeStats = _stats.purposes[purpose];
+    ++purposeStats.leases;
+    ++purposeStats.inUse;
+    ++_stats.inUse;
+    if (waited) {
+        ++purposeStats.waits;
+        purposeStats.waitMs += std::chrono::duration_cast<std::chrono::milliseconds>(
+                                   std::chrono::steady_clock::now() - start).count();
+    }
+    lock.unlock();
+    return Lease(conn.release(), Returner{shared_from_this(), purpose, overflow, false});
+}
+
+
+void SqlConnectionPool::discard(Lease const& lease, bool discard) {
+    auto returner = std::get_deleter<Returner>(lease);
+    if (returner != nullptr) {
+        returner->discard = discard;
+    }
+}
+
+
+SqlConnectionPool::Stats SqlConnectionPool::getStats() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    Stats stats = _stats;
+    stats.idle = _idle.size();
+    return stats;
+}
+
+
+std::unique_ptr<SqlConnection> SqlConnectionPool::_connect(SqlErrorObject& errObj) {
+    std::unique_ptr<SqlConnection> conn(new SqlConnection(_config));
+    if (not conn->connectToDb(errObj)) {
+        LOGS(_log, LOG_LVL_ERROR, "failed to connect: " << errObj.errMsg());
+        return nullptr;
+    }
+    return conn;
+}
+
+
+void SqlConnectionPool::_release(std::unique_ptr<SqlConnection> conn, std::string const& purpose,
+                                 bool overflow, bool discard) {
+    std::unique_lock<std::mutex> lock(_mtx);
+    --_stats.purposes[purpose].inUse;
+    --_stats.inUse;
+    if (overflow or discard) {
+        if (not overflow) --_numOpen;
+        ++_stats.closed;
+        lock.unlock();
+        _cv.notify_one();
+        // close without holding the mutex
+        conn.reset();
+        return;
+    }
+    _idle.push_front(Idle{std::move(conn), std::chrono::steady_clock::now()});
+    lock.unlock();
+    _cv.notify_one();
+}
+
+
+void SqlConnectionPool::Returner::operator()(SqlConnection* conn) {
+    std::unique_ptr<SqlConnection> owned(conn);
+    auto p = pool.lock();
+    if (p != nullptr) {
+        p->_release(std::move(owned), purpose, overflow, discard);
+    }
+}
+
+}}} // namespace lsst::qserv::sql
@@ -0,0 +1,140 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_QSERV_SQL_SQLCONNECTIONPOOL_H
+#define LSST_QSERV_SQL_SQLCONNECTIONPOOL_H
+
+// System headers
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Qserv headers
+#include "mysql/MySqlConfig.h"
+#include "sql/SqlConnection.h"
+#include "sql/SqlErrorObject.h"
+
+namespace lsst {
+namespace qserv {
+namespace sql {
+
+/// SqlConnectionPool shares a bounded set of connections to one database
+/// between the components of a process. A connection is leased for a
+/// purpose, which is only used for the statistics, and goes back to the
+/// pool when the last copy of its lease goes away. A connection idle for
+/// longer than the check interval is checked with a trivial query before
+/// it is leased again, and replaced if that fails.
+///
+/// At most maxConnections are open. When they are all leased, acquire()
+/// waits up to maxWait for one to come back and then opens one more anyway,
+/// so that holders of one lease waiting for a second one cannot deadlock.
+/// Such overflow connections are closed when they come back.
+class SqlConnectionPool : public std::enable_shared_from_this<SqlConnectionPool> {
+public:
+    typedef std::shared_ptr<SqlConnectionPool> Ptr;
+
+    /// A leased connection, given back to the pool when the last copy goes.
+    typedef std::shared_ptr<SqlConnection> Lease;
+
+    struct PurposeStats {
+        uint64_t leases{0};  ///< Connections leased.
+        uint64_t waits{0};   ///< Leases that had to wait for a connection.
+        uint64_t waitMs{0};  ///< Total time spent waiting.
+        size_t inUse{0};     ///< Connections currently leased.
+    };
+
+    struct Stats {
+        uint64_t opened{0};         ///< Connections opened.
+        uint64_t closed{0};         ///< Connections closed.
+        uint64_t checkFailures{0};  ///< Idle connections that failed the check.
+        uint64_t overflows{0};      ///< Connections opened beyond maxConnections.
+        size_t idle{0};             ///< Connections currently idle.
+        size_t inUse{0};            ///< Connections currently leased.
+        std::map<std::string, PurposeStats> purposes;
+    };
+
+    /// @param config - how to connect.
+    /// @param maxConnections - connections open at most, overflow aside.
+    /// @param maxWait - time acquire() waits before opening an overflow connection.
+    /// @param checkAfterIdle - idle time after which a connection is checked.
+    static Ptr create(mysql::MySqlConfig const& config, size_t maxConnections,
+                      std::chrono::milliseconds maxWait, std::chrono::seconds checkAfterIdle);
+
+    SqlConnectionPool(SqlConnectionPool const&) = delete;
+    SqlConnectionPool& operator=(SqlConnectionPool const&) = delete;
+
+    ~SqlConnectionPool() = default;
+
+    /// @return a connected connection, or nullptr with 'errObj' set if none
+    ///         could be opened.
+    Lease acquire(std::string const& purpose, SqlErrorObject& errObj);
+
+    /// Close the connection of 'lease' instead of giving it back, for a
+    /// holder that may leave session state behind (e.g. locked tables).
+    /// Calling it with 'discard' false undoes an earlier call.
+    static void discard(Lease const& lease, bool discard=true);
+
+    Stats getStats() const;
+
+private:
+    struct Idle {
+        std::unique_ptr<SqlConnection> conn;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    /// Deleter of a Lease, gives the connection back to the pool.
+    struct Returner {
+        std::weak_ptr<SqlConnectionPool> pool;
+        std::string purpose;
+        bool overflow;
+        bool discard;
+        void operator()(SqlConnection* conn);
+    };
+
+    SqlConnectionPool(mysql::MySqlConfig const& config, size_t maxConnections,
+                      std::chrono::milliseconds maxWait, std::chrono::seconds checkAfterIdle);
+
+    std::unique_ptr<SqlConnection> _connect(SqlErrorObject& errObj);
+    void _release(std::unique_ptr<SqlConnection> conn, std::string const& purpose,
+                  bool overflow, bool discard);
+
+    mysql::MySqlConfig const _config;
+    size_t const _maxConnections;
+    std::chrono::milliseconds const _maxWait;
+    std::chrono::seconds const _checkAfterIdle;
+
+    mutable std::mutex _mtx;         ///< Protects members below.
+    std::condition_variable _cv;     ///< Signalled when a connection comes back.
+    std::list<Idle> _idle;           ///< Most recently released first.
+    size_t _numOpen{0};               ///< Connections open or being opened, overflow aside.
+    Stats _stats;
+};
+
+}}} // namespace lsst::qserv::sql
+
+#endif // LSST_QSERV_SQL_SQLCONNECTIONPOOL_H
@@ -112,6 +112,7 @@ SqlResults::freeResults() {
         mysql_free_result(_results[i]);
     }
     _results.clear();
+    _streamConn = nullptr;
 }
 
 void
@@ -123,6 +124,23 @@ SqlResults::addResult(MYSQL_RES* r) {
     }
 }
 
+void
+SqlResults::addStreamingResult(MYSQL_RES* r, MYSQL* conn) {
+    addResult(r);
+    if (not _discardImmediately) {
+        _streamConn = conn;
+    }
+}
+
+bool
+SqlResults::checkStreamError(SqlErrorObject& errObj) const {
+    if (_streamConn == nullptr or mysql_errno(_streamConn) == 0) {
+        return true;
+    }
+    errObj.setErrNo(mysql_errno(_streamConn));
+    return errObj.addErrMsg(std::string("Error reading result rows: ") + mysql_error(_streamConn));
+}
+
 bool
 SqlResults::extractFirstColumn(std::vector<std::string>& ret,
                                SqlErrorObject& errObj) {
@@ -132,10 +150,10 @@ SqlResults::extractFirstColumn(std::vector<std::string>& ret,
         while ((row = mysql_fetch_row(_results[i])) != nullptr) {
             ret.push_back(row[0]);
         }
-        mysql_free_result(_results[i]);
     }
-    _results.clear();
-    return true;
+    bool const ok = checkStreamError(errObj);
+    freeResults();
+    return ok;
 }
 
 bool
@@ -149,10 +167,10 @@ SqlResults::extractFirst2Columns(std::vector<std::string>& col1,
             col1.push_back(row[0]);
             col2.push_back(row[1]);
         }
-        mysql_free_result(_results[i]);
     }
-    _results.clear();
-    return true;
+    bool const ok = checkStreamError(errObj);
+    freeResults();
+    return ok;
 }
 
 bool
@@ -168,10 +186,10 @@ SqlResults::extractFirst3Columns(std::vector<std::string>& col1,
             col2.push_back(row[1]);
             col3.push_back(row[2]);
         }
-        mysql_free_result(_results[i]);
     }
-    _results.clear();
-    return true;
+    bool const ok = checkStreamError(errObj);
+    freeResults();
+    return ok;
 }
 
 bool
@@ -189,10 +207,10 @@ SqlResults::extractFirst4Columns(std::vector<std::string>& col1,
             col3.push_back(row[2]);
             col4.push_back(row[3]);
         }
-        mysql_free_result(_results[i]);
     }
-    _results.clear();
-    return true;
+    bool const ok = checkStreamError(errObj);
+    freeResults();
+    return ok;
 }
 
 bool
@@ -90,6 +90,13 @@ public:
     ~SqlResults() {freeResults();}
 
     void addResult(MYSQL_RES* r);
+    /// Add a result of mysql_use_result(), its rows are read from 'conn' as
+    /// they are iterated over, and 'conn' can run nothing else until they
+    /// are all read or freeResults() is called.
+    void addStreamingResult(MYSQL_RES* r, MYSQL* conn);
+    /// Return false and set errObj if reading the rows of a streaming
+    /// result failed, which ends the iteration early.
+    bool checkStreamError(SqlErrorObject& errObj) const;
     void setAffectedRows(unsigned long long count) {
         _affectedRows = count;
     }
@@ -127,6 +134,7 @@ private:
     std::vector<MYSQL_RES*> _results;
     bool _discardImmediately;
     unsigned long long _affectedRows;
+    MYSQL* _streamConn = nullptr; ///< Connection rows of a streaming result come from
 };
 
 }}} // namespace lsst::qserv:: sql
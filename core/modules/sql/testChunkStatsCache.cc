@@ -0,0 +1,142 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// System headers
+#include <memory>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "sql/ChunkStatsCache.h"
+#include "sql/MockSql.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE ChunkStatsCache
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::sql::ChunkStatsCache;
+using lsst::qserv::sql::MockSql;
+using lsst::qserv::sql::SqlResultIter;
+using lsst::qserv::StringVector;
+
+namespace {
+
+/// Answers the queries of the cache from the rows of a 'chunk_stats' table.
+struct StatsSql : public MockSql {
+    typedef std::vector<StringVector> TupleVector;
+    typedef MockSql::Iter<TupleVector::const_iterator> SqlIter;
+
+    virtual std::shared_ptr<SqlResultIter> getQueryIter(std::string const& query) {
+        queries.push_back(query);
+        _result.clear();
+        if (query.find("COUNT(*)") != std::string::npos) {
+            uint64_t sum = 0;
+            for (auto const& row : rows) sum += std::stoull(row[10]) / 1000;
+            _result.push_back({std::to_string(rows.size()), std::to_string(sum)});
+        } else {
+            uint64_t after = 0;
+            auto const pos = query.find("`collect_time`>");
+            if (pos != std::string::npos) after = std::stoull(query.substr(pos + 15));
+            for (auto const& row : rows) {
+                if (std::stoull(row[10]) > after) _result.push_back(row);
+            }
+        }
+        return std::make_shared<SqlIter>(_result.begin(), _result.end());
+    }
+
+    TupleVector rows;
+    std::vector<std::string> queries;
+
+private:
+    TupleVector _result;
+};
+
+StringVector row(std::string const& worker, std::string const& table, int chunk,
+                 uint64_t dataSize, uint64_t tasks, double avgSeconds, uint64_t collectTime) {
+    return {worker, "LSST", table, std::to_string(chunk), "100", std::to_string(dataSize), "10",
+            std::to_string(tasks), std::to_string(avgSeconds), std::to_string(avgSeconds * 2),
+            std::to_string(collectTime)};
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(Merge) {
+    auto sql = std::make_shared<StatsSql>();
+    sql->rows.push_back(row("w1", "Object", 1, 1000, 2, 1.0, 5000));
+    sql->rows.push_back(row("w2", "Object", 1, 2000, 6, 3.0, 6000));
+    sql->rows.push_back(row("w1", "Object", 2, 500, 0, 0, 7000));
+    sql->rows.push_back(row("w1", "Source", 1, 9000, 0, 0, 7000));
+    auto cache = ChunkStatsCache::create(sql, std::chrono::seconds(3600));
+
+    ChunkStatsCache::Stats stats;
+    BOOST_REQUIRE(cache->get("LSST", "Object", 1, stats));
+    BOOST_CHECK_EQUAL(stats.numReplicas, 2U);
+    BOOST_CHECK_EQUAL(stats.dataSize, 2000U);
+    BOOST_CHECK_EQUAL(stats.tasksCompleted, 8U);
+    BOOST_CHECK_CLOSE(stats.avgScanSeconds, 2.5, 0.001);
+    BOOST_CHECK_CLOSE(stats.lastScanSeconds, 6.0, 0.001);
+    BOOST_CHECK(!cache->get("LSST", "Object", 3, stats));
+
+    auto const table = cache->getTable("LSST", "Object");
+    BOOST_CHECK_EQUAL(table.size(), 2U);
+    BOOST_CHECK_EQUAL(table.at(2).dataSize, 500U);
+    BOOST_CHECK_EQUAL(table.at(2).avgScanSeconds, 0);
+
+    // The copy isn't stale yet.
+    size_t const numQueries = sql->queries.size();
+    cache->get("LSST", "Object", 1, stats);
+    BOOST_CHECK_EQUAL(sql->queries.size(), numQueries);
+}
+
+BOOST_AUTO_TEST_CASE(Refresh) {
+    auto sql = std::make_shared<StatsSql>();
+    sql->rows.push_back(row("w1", "Object", 1, 1000, 2, 1.0, 5000));
+    sql->rows.push_back(row("w1", "Object", 2, 1000, 2, 1.0, 5000));
+    auto cache = ChunkStatsCache::create(sql, std::chrono::seconds(3600));
+    BOOST_CHECK(cache->refresh());
+
+    // A change is read on its own.
+    sql->rows[0] = row("w1", "Object", 1, 3000, 4, 2.0, 8000);
+    sql->queries.clear();
+    BOOST_CHECK(cache->refresh());
+    BOOST_REQUIRE_EQUAL(sql->queries.size(), 2U);
+    BOOST_CHECK(sql->queries[0].find("`collect_time`>5000") != std::string::npos);
+    ChunkStatsCache::Stats stats;
+    BOOST_REQUIRE(cache->get("LSST", "Object", 1, stats));
+    BOOST_CHECK_EQUAL(stats.dataSize, 3000U);
+    BOOST_CHECK_EQUAL(stats.tasksCompleted, 4U);
+
+    // A removed row is noticed, and all rows are read again.
+    sql->rows.pop_back();
+    sql->queries.clear();
+    BOOST_CHECK(cache->refresh());
+    BOOST_CHECK_EQUAL(sql->queries.size(), 3U);
+    BOOST_CHECK(!cache->get("LSST", "Object", 2, stats));
+    BOOST_CHECK(cache->get("LSST", "Object", 1, stats));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
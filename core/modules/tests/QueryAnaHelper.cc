@@ -73,9 +73,11 @@ SelectParser::Ptr QueryAnaHelper::getParser(std::string const & stmt,
 
 std::shared_ptr<QuerySession> QueryAnaHelper::buildQuerySession(QuerySession::Test qsTest,
                                                                 std::string const & stmt,
-                                                                SelectParser::AntlrVersion antlrVersion) {
+                                                                SelectParser::AntlrVersion antlrVersion,
+                                                                int sampleEvery) {
 
     querySession = std::make_shared<QuerySession>(qsTest);
+    querySession->setSampleEvery(sampleEvery);
     auto stmtIR = querySession->parseQuery(stmt, antlrVersion);
     if (nullptr == stmtIR) {
         return querySession;
@@ -59,9 +59,11 @@ struct QueryAnaHelper {
     *  @param t:             Test environment required by the object
     *  @param stmt:          sql query to process
     *  @param expectedErr:   expected error message
+    *  @param sampleEvery:   @see qproc::QuerySession::setSampleEvery()
     */
     std::shared_ptr<qproc::QuerySession> buildQuerySession(qproc::QuerySession::Test qsTest,
-            std::string const & stmt, parser::SelectParser::AntlrVersion antlrVersion);
+            std::string const & stmt, parser::SelectParser::AntlrVersion antlrVersion,
+            int sampleEvery=0);
 
     /**
     *  @brief Compute the first parallel query which will be send on
@@ -0,0 +1,168 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/**
+  * @file
+  *
+  * @brief MySQL aggregate UDFs computing and merging HyperLogLog sketches,
+  * which implement APPROX_COUNT_DISTINCT().
+  *
+  * qserv_hll(expr, ...) runs on the workers and returns the serialized
+  * sketch of the distinct values of its arguments within a group, rows
+  * where an argument is NULL are skipped as COUNT(DISTINCT) does.
+  * qserv_hll_count(sketch) runs on the czar and returns the estimated
+  * number of distinct values of the union of the sketches of a group.
+  *
+  * The functions are installed with:
+  *   CREATE AGGREGATE FUNCTION qserv_hll RETURNS STRING SONAME 'qserv_udf.so';
+  *   CREATE AGGREGATE FUNCTION qserv_hll_count RETURNS INTEGER SONAME 'qserv_udf.so';
+  *
+  * Values are hashed as MySQL hands them over: 8 bytes for integers, a
+  * double for reals and the bytes of strings and decimals. Strings equal
+  * under a collation but with different bytes count as distinct values.
+  */
+
+// System headers
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+
+// Third-party headers
+#include <mysql/mysql.h>
+
+// Qserv headers
+#include "util/HyperLogLog.h"
+
+namespace {
+
+using lsst::qserv::util::HyperLogLog;
+
+struct HllState {
+    HyperLogLog hll;
+    std::string buf;    ///< Bytes of the values of a row
+    std::string result; ///< Serialized sketch returned by qserv_hll()
+};
+
+HllState* getState(UDF_INIT* initid) {
+    return reinterpret_cast<HllState*>(initid->ptr);
+}
+
+my_bool initState(UDF_INIT* initid, char* message) {
+    HllState* state = new (std::nothrow) HllState();
+    if (state == nullptr) {
+        std::strcpy(message, "out of memory");
+        return 1;
+    }
+    initid->ptr = reinterpret_cast<char*>(state);
+    return 0;
+}
+
+} // annonymous namespace
+
+extern "C" {
+
+my_bool qserv_hll_init(UDF_INIT* initid, UDF_ARGS* args, char* message) {
+    if (args->arg_count < 1) {
+        std::strcpy(message, "qserv_hll() requires at least one argument");
+        return 1;
+    }
+    for (unsigned int j = 0; j < args->arg_count; ++j) {
+        if (args->arg_type[j] == ROW_RESULT) {
+            std::strcpy(message, "qserv_hll() arguments must be scalar values");
+            return 1;
+        }
+    }
+    initid->maybe_null = 0;
+    initid->max_length = (1U << HyperLogLog::DEFAULT_PRECISION) + 1;
+    return initState(initid, message);
+}
+
+void qserv_hll_deinit(UDF_INIT* initid) {
+    delete getState(initid);
+}
+
+void qserv_hll_clear(UDF_INIT* initid, char* is_null, char* error) {
+    getState(initid)->hll.clear();
+}
+
+void qserv_hll_add(UDF_INIT* initid, UDF_ARGS* args, char* is_null, char* error) {
+    HllState* state = getState(initid);
+    state->buf.clear();
+    for (unsigned int j = 0; j < args->arg_count; ++j) {
+        char const* data = args->args[j];
+        if (data == nullptr) return;
+        unsigned long len = 0;
+        switch (args->arg_type[j]) {
+        case INT_RESULT:  len = sizeof(long long); break;
+        case REAL_RESULT: len = sizeof(double); break;
+        default:          len = args->lengths[j]; break;
+        }
+        if (args->arg_count > 1) {
+            // The length keeps ('a', 'bc') apart from ('ab', 'c').
+            uint32_t const len32 = len;
+            state->buf.append(reinterpret_cast<char const*>(&len32), sizeof(len32));
+        }
+        state->buf.append(data, len);
+    }
+    state->hll.add(state->buf.data(), state->buf.size());
+}
+
+char* qserv_hll(UDF_INIT* initid, UDF_ARGS* args, char* result, unsigned long* length,
+                char* is_null, char* error) {
+    HllState* state = getState(initid);
+    state->result = state->hll.serialize();
+    *length = state->result.size();
+    return &state->result[0];
+}
+
+my_bool qserv_hll_count_init(UDF_INIT* initid, UDF_ARGS* args, char* message) {
+    if (args->arg_count != 1 || args->arg_type[0] != STRING_RESULT) {
+        std::strcpy(message, "qserv_hll_count() requires one sketch argument");
+        return 1;
+    }
+    initid->maybe_null = 0;
+    return initState(initid, message);
+}
+
+void qserv_hll_count_deinit(UDF_INIT* initid) {
+    delete getState(initid);
+}
+
+void qserv_hll_count_clear(UDF_INIT* initid, char* is_null, char* error) {
+    getState(initid)->hll.clear();
+}
+
+void qserv_hll_count_add(UDF_INIT* initid, UDF_ARGS* args, char* is_null, char* error) {
+    char const* data = args->args[0];
+    if (data == nullptr) return;
+    if (!getState(initid)->hll.merge(data, args->lengths[0])) {
+        *error = 1;
+    }
+}
+
+long long qserv_hll_count(UDF_INIT* initid, UDF_ARGS* args, char* is_null, char* error) {
+    return std::llround(getState(initid)->hll.estimate());
+}
+
+} // extern "C"
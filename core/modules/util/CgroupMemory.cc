@@ -0,0 +1,116 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ *
+ */
+
+// Class header
+#include "util/CgroupMemory.h"
+
+// System headers
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+std::string const cgroupRoot = "/sys/fs/cgroup";
+
+/// @return the content of 'path', or an empty string if it cannot be read.
+std::string readFile(std::string const& path) {
+    std::ifstream file(path);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+} // annonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace util {
+
+std::string CgroupMemory::selfDir() {
+    std::string path = parseProcCgroup(readFile("/proc/self/cgroup"));
+    if (path.empty()) {
+        return std::string();
+    }
+    std::string dir = cgroupRoot + (path == "/" ? std::string() : path);
+    // A v1 or hybrid host may list a v2 entry without memory accounting.
+    if (!std::ifstream(dir + "/memory.current")) {
+        return std::string();
+    }
+    return dir;
+}
+
+
+std::string CgroupMemory::parseProcCgroup(std::string const& procCgroup) {
+    std::istringstream lines(procCgroup);
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (line.compare(0, 3, "0::") == 0 && line.size() > 3) {
+            return line.substr(3);
+        }
+    }
+    return std::string();
+}
+
+
+double CgroupMemory::parsePressureAvg10(std::string const& pressure) {
+    std::istringstream lines(pressure);
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (line.compare(0, 5, "some ") != 0) continue;
+        auto pos = line.find("avg10=");
+        if (pos == std::string::npos) break;
+        char const* begin = line.c_str() + pos + 6;
+        char* end = nullptr;
+        double avg10 = std::strtod(begin, &end);
+        if (end == begin) break;
+        return avg10;
+    }
+    return -1.0;
+}
+
+
+uint64_t CgroupMemory::parseBytes(std::string const& bytes) {
+    return std::strtoull(bytes.c_str(), nullptr, 10);
+}
+
+
+CgroupMemory::Usage CgroupMemory::read() const {
+    Usage usage;
+    if (!isValid()) {
+        return usage;
+    }
+    std::string current = readFile(_dir + "/memory.current");
+    if (current.empty()) {
+        return usage;
+    }
+    usage.valid = true;
+    usage.current = parseBytes(current);
+    usage.max = parseBytes(readFile(_dir + "/memory.max"));
+    double avg10 = parsePressureAvg10(readFile(_dir + "/memory.pressure"));
+    usage.someAvg10 = (avg10 < 0.0) ? 0.0 : avg10;
+    return usage;
+}
+
+}}} // namespace lsst::qserv::util
@@ -0,0 +1,76 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ *
+ */
+#ifndef LSST_QSERV_UTIL_CGROUPMEMORY_H
+#define LSST_QSERV_UTIL_CGROUPMEMORY_H
+
+// System headers
+#include <cstdint>
+#include <string>
+
+namespace lsst {
+namespace qserv {
+namespace util {
+
+/// CgroupMemory reads the memory usage, limit and pressure of a cgroup v2
+/// directory, such as the one of this process under /sys/fs/cgroup.
+class CgroupMemory {
+public:
+    struct Usage {
+        bool valid{false};     ///< False if memory.current could not be read.
+        uint64_t current{0};   ///< Bytes charged to the cgroup.
+        uint64_t max{0};       ///< Bytes the cgroup may use, 0 if unlimited.
+        double someAvg10{0.0}; ///< Percent of the last 10s some task waited on memory.
+    };
+
+    /// @return the cgroup v2 directory of this process, or an empty string
+    ///         if the process is not in a cgroup v2 hierarchy.
+    static std::string selfDir();
+
+    /// @return the path of the cgroup v2 entry ("0::<path>") of the content
+    ///         of /proc/<pid>/cgroup, or an empty string if there is none.
+    static std::string parseProcCgroup(std::string const& procCgroup);
+
+    /// @return the avg10 value of the "some" line of a memory.pressure file,
+    ///         or a negative value if it is malformed.
+    static double parsePressureAvg10(std::string const& pressure);
+
+    /// @return the bytes of a memory.current or memory.max file, 0 for "max".
+    static uint64_t parseBytes(std::string const& bytes);
+
+    /// @param dir - cgroup v2 directory, an empty string reads nothing.
+    explicit CgroupMemory(std::string const& dir) : _dir(dir) {}
+
+    bool isValid() const { return !_dir.empty(); }
+    std::string const& getDir() const { return _dir; }
+
+    /// @return the current usage, limit and pressure of the cgroup.
+    Usage read() const;
+
+private:
+    std::string const _dir;
+};
+
+}}} // namespace lsst::qserv::util
+
+#endif // LSST_QSERV_UTIL_CGROUPMEMORY_H
@@ -29,7 +29,9 @@
 // System headers
 #include <atomic>
 #include <cassert>
+#include <condition_variable>
 #include <deque>
+#include <mutex>
 #include <queue>
 #include <thread>
 #include <vector>
@@ -79,27 +81,49 @@ namespace util {
 class CommandQueue {
 public:
     using Ptr = std::shared_ptr<CommandQueue>;
+    CommandQueue() = default;
+    /// @param spinCount - number of times getCmd() looks for a command,
+    ///        yielding in between, before sleeping on an empty queue, so
+    ///        that commands queued in quick succession are taken without a
+    ///        sleep and a wakeup.
+    explicit CommandQueue(unsigned spinCount) : _spinCount(spinCount) {}
     virtual ~CommandQueue() {};
-    /// Queue a command object in a thread safe way and signal any threads
-    /// waiting on the queue that a command is available.
+    /// Queue a command object in a thread safe way and signal one thread
+    /// waiting on the queue, if any, that a command is available.
     virtual void queCmd(Command::Ptr const& cmd) {
-        std::lock_guard<std::mutex> lock(_mx);
-        _qu.push_back(cmd);
-        notify(_qu.size() > 1);
+        {
+            std::lock_guard<std::mutex> lock(_mx);
+            _qu.push_back(cmd);
+            _size = _qu.size();
+            if (_waiting == 0) {
+                return;
+            }
+        }
+        // Only one thread can take the command, waking more would only
+        // have them contend for _mx and go back to sleep.
+        notify(false);
     };
 
     /// Get a command off the queue.
     /// If wait is true, wait until a message is available.
     virtual Command::Ptr getCmd(bool wait=true) {
+        if (wait) {
+            for (unsigned i = 0; i < _spinCount && _size == 0; ++i) {
+                std::this_thread::yield();
+            }
+        }
         std::unique_lock<std::mutex> lock(_mx);
         if (wait) {
+            ++_waiting;
             _cv.wait(lock, [this](){return !_qu.empty();});
+            --_waiting;
         }
         if (_qu.empty()) {
             return nullptr;
         }
         auto cmd = _qu.front();
         _qu.pop_front();
+        _size = _qu.size();
         return cmd;
     };
 
@@ -124,6 +148,11 @@ protected:
     std::deque<Command::Ptr> _qu{};
     std::condition_variable  _cv{};
     mutable std::mutex       _mx{};
+
+private:
+    unsigned const _spinCount{0};
+    std::atomic<size_t> _size{0}; ///< Size of _qu, read without locking _mx while spinning.
+    int _waiting{0}; ///< Threads waiting in getCmd(), protected by _mx.
 };
 
 /// An event driven thread, the event loop is in handleCmds().
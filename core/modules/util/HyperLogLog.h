@@ -0,0 +1,164 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_UTIL_HYPERLOGLOG_H
+#define LSST_QSERV_UTIL_HYPERLOGLOG_H
+
+// System headers
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lsst {
+namespace qserv {
+namespace util {
+
+/// HyperLogLog estimates the number of distinct values it was given, in a
+/// fixed amount of memory. Sketches built over different sets of values can
+/// be merged, the result being the sketch of the union, which is what makes
+/// it possible to compute COUNT(DISTINCT) approximations chunk by chunk.
+///
+/// With the default 2^12 registers the standard error of the estimate is
+/// about 1.6%. The serialized form is one byte with the precision followed
+/// by one byte per register.
+///
+/// The class is header only so that it can be built into the MySQL UDF
+/// plugin without the rest of the Qserv libraries.
+class HyperLogLog {
+public:
+    static int const DEFAULT_PRECISION = 12;
+    static int const MIN_PRECISION = 4;
+    static int const MAX_PRECISION = 16;
+
+    explicit HyperLogLog(int precision=DEFAULT_PRECISION)
+        : _precision(precision < MIN_PRECISION ? int(MIN_PRECISION)
+                     : precision > MAX_PRECISION ? int(MAX_PRECISION) : precision),
+          _registers(std::size_t(1) << _precision, 0) {}
+
+    int getPrecision() const { return _precision; }
+
+    /// Add a value given by its bytes.
+    void add(void const* data, std::size_t len) {
+        addHash(hash(data, len));
+    }
+
+    /// Add a value given by a well mixed 64 bit hash.
+    void addHash(std::uint64_t h) {
+        std::size_t const idx = h >> (64 - _precision);
+        std::uint64_t const rest = (h << _precision) | (std::uint64_t(1) << (_precision - 1));
+        std::uint8_t rank = 1;
+        for (std::uint64_t bit = std::uint64_t(1) << 63; (rest & bit) == 0; bit >>= 1) ++rank;
+        if (rank > _registers[idx]) _registers[idx] = rank;
+    }
+
+    /// Merge 'other' into this sketch.
+    /// @return false, leaving this sketch unchanged, if the precisions differ.
+    bool merge(HyperLogLog const& other) {
+        if (other._precision != _precision) return false;
+        for (std::size_t j = 0; j < _registers.size(); ++j) {
+            _registers[j] = std::max(_registers[j], other._registers[j]);
+        }
+        return true;
+    }
+
+    /// Merge the serialized sketch 'data' into this sketch.
+    /// @return false, leaving this sketch unchanged, if 'data' is not a
+    ///         sketch with the same precision.
+    bool merge(char const* data, std::size_t len) {
+        if (len != _registers.size() + 1 || static_cast<int>(data[0]) != _precision) return false;
+        for (std::size_t j = 0; j < _registers.size(); ++j) {
+            _registers[j] = std::max(_registers[j], static_cast<std::uint8_t>(data[j + 1]));
+        }
+        return true;
+    }
+
+    /// @return the estimated number of distinct values added.
+    double estimate() const {
+        double const m = static_cast<double>(_registers.size());
+        double sum = 0;
+        std::size_t zeros = 0;
+        for (std::uint8_t reg : _registers) {
+            sum += std::ldexp(1.0, -static_cast<int>(reg));
+            if (reg == 0) ++zeros;
+        }
+        double const e = _alpha() * m * m / sum;
+        if (e <= 2.5 * m && zeros > 0) {
+            // Linear counting is more accurate for small cardinalities.
+            return m * std::log(m / static_cast<double>(zeros));
+        }
+        return e;
+    }
+
+    void clear() { std::fill(_registers.begin(), _registers.end(), 0); }
+
+    std::string serialize() const {
+        std::string str(1, static_cast<char>(_precision));
+        str.append(_registers.begin(), _registers.end());
+        return str;
+    }
+
+    /// @return true if 'data' has the size of a serialized sketch of the
+    ///         precision given by its first byte.
+    static bool isSketch(char const* data, std::size_t len) {
+        if (len < 1) return false;
+        int const precision = data[0];
+        return precision >= MIN_PRECISION && precision <= MAX_PRECISION
+               && len == (std::size_t(1) << precision) + 1;
+    }
+
+    /// 64 bit FNV-1a with a final mix, since the leading bits of the hash
+    /// select the register.
+    static std::uint64_t hash(void const* data, std::size_t len) {
+        unsigned char const* p = static_cast<unsigned char const*>(data);
+        std::uint64_t h = 14695981039346656037ULL;
+        for (std::size_t j = 0; j < len; ++j) {
+            h ^= p[j];
+            h *= 1099511628211ULL;
+        }
+        h ^= h >> 30;
+        h *= 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 27;
+        h *= 0x94d049bb133111ebULL;
+        h ^= h >> 31;
+        return h;
+    }
+
+private:
+    double _alpha() const {
+        switch (_registers.size()) {
+        case 16: return 0.673;
+        case 32: return 0.697;
+        case 64: return 0.709;
+        default: return 0.7213 / (1.0 + 1.079 / static_cast<double>(_registers.size()));
+        }
+    }
+
+    int _precision;
+    std::vector<std::uint8_t> _registers;
+};
+
+}}} // namespace lsst::qserv::util
+
+#endif // LSST_QSERV_UTIL_HYPERLOGLOG_H
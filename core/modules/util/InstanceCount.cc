@@ -5,10 +5,14 @@
 #include "util/InstanceCount.h"
 
 // System Headers
+#include <unordered_map>
 
 // LSST headers
 #include "lsst/log/Log.h"
 
+// Qserv headers
+#include "util/Metrics.h"
+
 
 namespace { // File-scope helpers
 
@@ -21,63 +25,88 @@ namespace lsst {
 namespace qserv {
 namespace util {
 
-std::map<std::string, int> InstanceCount::_instances;
-std::recursive_mutex InstanceCount::_mx;
+std::map<std::string, std::unique_ptr<InstanceCount::Slot>> InstanceCount::_slots;
+std::mutex InstanceCount::_mx;
 
 
-InstanceCount::InstanceCount(std::string const& className) :_className{className} {
-    _increment("con");
+InstanceCount::InstanceCount(char const* className) {
+    // Literals have the same address each time, cache their slot by address.
+    thread_local std::unordered_map<char const*, Slot*> cache;
+    Slot*& slot = cache[className];
+    if (slot == nullptr) {
+        slot = _slotFor(className);
+    }
+    _slot = slot;
+    _slot->count.fetch_add(1, std::memory_order_relaxed);
 }
 
 
-InstanceCount::InstanceCount(InstanceCount const& other) : _className{other._className} {
-    _increment("cpy");
+InstanceCount::InstanceCount(std::string const& className) : _slot(_slotFor(className)) {
+    _slot->count.fetch_add(1, std::memory_order_relaxed);
 }
 
 
-InstanceCount::InstanceCount(InstanceCount &&origin) : _className{origin._className} {
-    _increment("mov");
+InstanceCount::InstanceCount(InstanceCount const& other) : _slot(other._slot) {
+    _slot->count.fetch_add(1, std::memory_order_relaxed);
 }
 
 
-void InstanceCount::_increment(std::string const& source) {
-    std::lock_guard<std::recursive_mutex> lg(_mx);
-    std::pair<std::string const, int> entry(_className, 0);
-    auto ret = _instances.insert(entry);
-    auto iter = ret.first;
-    iter->second += 1;
-    LOGS(_log, LOG_LVL_DEBUG, "InstanceCount " << source
-         << " " << iter->first << "=" << iter->second);
+InstanceCount::InstanceCount(InstanceCount &&origin) : _slot(origin._slot) {
+    _slot->count.fetch_add(1, std::memory_order_relaxed);
 }
 
 
 InstanceCount::~InstanceCount() {
-    std::lock_guard<std::recursive_mutex> lg(_mx);
-    auto iter = _instances.find(_className);
-    if (iter != _instances.end()) {
-        iter->second -= 1;
-        LOGS(_log, LOG_LVL_DEBUG, "~InstanceCount " << iter->first << "=" << iter->second << " : " << *this);
-    } else {
-        LOGS(_log, LOG_LVL_ERROR, "~InstanceCount " << _className << " was not found! : " << *this);
+    _slot->count.fetch_sub(1, std::memory_order_relaxed);
+}
+
+
+InstanceCount& InstanceCount::operator=(InstanceCount const& o) {
+    if (o._slot != _slot) {
+        o._slot->count.fetch_add(1, std::memory_order_relaxed);
+        _slot->count.fetch_sub(1, std::memory_order_relaxed);
+        _slot = o._slot;
     }
+    return *this;
+}
+
+
+InstanceCount::Slot* InstanceCount::_slotFor(std::string const& className) {
+    std::lock_guard<std::mutex> lg(_mx);
+    auto& slot = _slots[className];
+    if (slot == nullptr) {
+        slot.reset(new Slot(className));
+        LOGS(_log, LOG_LVL_DEBUG, "InstanceCount counting " << className);
+        if (_slots.size() == 1) {
+            MetricsRegistry::get().addCollector("InstanceCount", &InstanceCount::writeMetrics);
+        }
+    }
+    return slot.get();
 }
 
 
 int InstanceCount::getCount() {
-    std::lock_guard<std::recursive_mutex> lg(_mx);
-    auto iter = _instances.find(_className);
-    if (iter == _instances.end()) {
-        return 0;
+    return _slot->count.load(std::memory_order_relaxed);
+}
+
+
+void InstanceCount::writeMetrics(std::ostream& os) {
+    std::string const name = "qserv_instances";
+    MetricsRegistry::writeHeader(os, name, "gauge", "Number of live instances of a class");
+    std::lock_guard<std::mutex> lg(_mx);
+    for (auto const& entry : _slots) {
+        MetricsRegistry::writeValue(os, name, "class=\"" + MetricsRegistry::escapeLabel(entry.first) + "\"",
+                                    entry.second->count.load(std::memory_order_relaxed));
     }
-    return iter->second;
 }
 
 
 std::ostream& operator<<(std::ostream &os, InstanceCount const& instanceCount) {
-    std::lock_guard<std::recursive_mutex> lg(instanceCount._mx);
-    for (auto const& entry : instanceCount._instances) {
-        if (entry.second != 0) {
-            os << entry.first << "=" << entry.second << " ";
+    std::lock_guard<std::mutex> lg(instanceCount._mx);
+    for (auto const& entry : instanceCount._slots) {
+        int const count = entry.second->count.load(std::memory_order_relaxed);
+        if (count != 0) {
+            os << entry.first << "=" << count << " ";
         }
     }
     return os;
@@ -5,8 +5,11 @@
 #define LSST_QSERV_UTIL_INSTANCECOUNT_H
 
 // System headers
+#include <atomic>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <ostream>
 #include <string>
 
 
@@ -15,26 +18,42 @@ namespace qserv {
 namespace util {
 
 /// This a utility class to track the number of instances of any class where it is a member.
+/// Each class name gets a counter the first time it is used, and construction and
+/// destruction only update that counter, without a mutex. A thread remembers the
+/// counter of each class name literal it has seen, so only the first construction
+/// of a class on a thread looks it up.
 //
 class InstanceCount {
 public:
+    /// @param className - a string literal, or any string that outlives the program.
+    InstanceCount(char const* className);
     InstanceCount(std::string const& className);
     InstanceCount(InstanceCount const& other);
     InstanceCount(InstanceCount &&origin);
     ~InstanceCount();
 
-    InstanceCount& operator=(InstanceCount const& o) = default;
+    InstanceCount& operator=(InstanceCount const& o);
 
     int getCount(); //< Return the number of instances of _className.
 
+    /// Write the number of instances of each class as metrics.
+    static void writeMetrics(std::ostream& os);
+
     friend std::ostream& operator<<(std::ostream &out, InstanceCount const& instanceCount);
 
 private:
-    std::string _className; //< Names of the of which this is a member.
-    static std::map<std::string, int> _instances; //< Map of instances per class name.
-    static std::recursive_mutex _mx; //< Protects _instances.
+    struct Slot {
+        explicit Slot(std::string const& name) : className(name) {}
+        std::string const className;
+        std::atomic<int> count{0};
+    };
+
+    static Slot* _slotFor(std::string const& className);
+
+    Slot* _slot; //< Counter of the class this is a member of.
 
-    void _increment(std::string const& source);
+    static std::map<std::string, std::unique_ptr<Slot>> _slots; //< Slots by class name, never removed.
+    static std::mutex _mx; //< Protects _slots.
 };
 
 }}} // namespace lsst::qserv::util
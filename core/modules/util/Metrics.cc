@@ -0,0 +1,254 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ *
+ */
+
+// Class header
+#include "util/Metrics.h"
+
+// System headers
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+std::atomic<unsigned> nextShard{0};
+
+void writeDouble(std::ostream& os, double val) {
+    if (std::isinf(val)) {
+        os << (val > 0 ? "+Inf" : "-Inf");
+    } else {
+        auto const precision = os.precision(15);
+        os << val;
+        os.precision(precision);
+    }
+}
+
+} // namespace
+
+namespace lsst {
+namespace qserv {
+namespace util {
+
+unsigned metricShard() {
+    thread_local unsigned const shard = nextShard.fetch_add(1, std::memory_order_relaxed) % METRIC_SHARDS;
+    return shard;
+}
+
+
+uint64_t Counter::value() const {
+    uint64_t total = 0;
+    for (auto const& slot : _slots) {
+        total += slot.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+
+Histogram::Histogram(std::vector<double> const& bounds) {
+    std::set<double> boundSet(bounds.begin(), bounds.end());
+    _bounds.assign(boundSet.begin(), boundSet.end());
+    for (unsigned j = 0; j < METRIC_SHARDS; ++j) {
+        _shards.emplace_back(new Shard(_bounds.size() + 1));
+    }
+}
+
+
+std::vector<double> Histogram::exponentialBounds(double first, double factor, unsigned count) {
+    std::vector<double> bounds;
+    double bound = first;
+    for (unsigned j = 0; j < count; ++j) {
+        bounds.push_back(bound);
+        bound *= factor;
+    }
+    return bounds;
+}
+
+
+void Histogram::observe(double val) {
+    // A value equal to a bound belongs to that bucket, as "le" means.
+    size_t const bucket = std::lower_bound(_bounds.begin(), _bounds.end(), val) - _bounds.begin();
+    Shard& shard = *_shards[metricShard()];
+    shard.counts[bucket].fetch_add(1, std::memory_order_relaxed);
+    double sum = shard.sum.load(std::memory_order_relaxed);
+    while (!shard.sum.compare_exchange_weak(sum, sum + val, std::memory_order_relaxed)) {}
+}
+
+
+Histogram::Snapshot Histogram::snapshot() const {
+    Snapshot snap;
+    snap.bounds = _bounds;
+    snap.counts.assign(_bounds.size() + 1, 0);
+    for (auto const& shard : _shards) {
+        for (size_t j = 0; j < snap.counts.size(); ++j) {
+            uint64_t const n = shard->counts[j].load(std::memory_order_relaxed);
+            snap.counts[j] += n;
+            snap.count += n;
+        }
+        snap.sum += shard->sum.load(std::memory_order_relaxed);
+    }
+    return snap;
+}
+
+
+MetricsRegistry& MetricsRegistry::get() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+
+/// Precondition: _mtx must be held.
+MetricsRegistry::Entry& MetricsRegistry::_entry(std::string const& name, std::string const& help) {
+    Entry& entry = _metrics[name];
+    if (entry.help.empty()) entry.help = help;
+    return entry;
+}
+
+
+Counter::Ptr MetricsRegistry::counter(std::string const& name, std::string const& help) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    Entry& entry = _entry(name, help);
+    if (entry.gauge != nullptr || entry.histogram != nullptr) {
+        throw std::invalid_argument("metric " + name + " is not a counter");
+    }
+    if (entry.counter == nullptr) entry.counter = std::make_shared<Counter>();
+    return entry.counter;
+}
+
+
+Gauge::Ptr MetricsRegistry::gauge(std::string const& name, std::string const& help) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    Entry& entry = _entry(name, help);
+    if (entry.counter != nullptr || entry.histogram != nullptr) {
+        throw std::invalid_argument("metric " + name + " is not a gauge");
+    }
+    if (entry.gauge == nullptr) entry.gauge = std::make_shared<Gauge>();
+    return entry.gauge;
+}
+
+
+Histogram::Ptr MetricsRegistry::histogram(std::string const& name, std::string const& help,
+                                          std::vector<double> const& bounds) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    Entry& entry = _entry(name, help);
+    if (entry.counter != nullptr || entry.gauge != nullptr) {
+        throw std::invalid_argument("metric " + name + " is not a histogram");
+    }
+    if (entry.histogram == nullptr) entry.histogram = std::make_shared<Histogram>(bounds);
+    return entry.histogram;
+}
+
+
+void MetricsRegistry::addCollector(std::string const& name, Collector const& collector) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _collectors[name] = collector;
+}
+
+
+void MetricsRegistry::removeCollector(std::string const& name) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _collectors.erase(name);
+}
+
+
+void MetricsRegistry::write(std::ostream& os) const {
+    std::map<std::string, Entry> metrics;
+    std::vector<Collector> collectors;
+    {
+        // Collectors are called without the mutex, they may create metrics.
+        std::lock_guard<std::mutex> lock(_mtx);
+        metrics = _metrics;
+        for (auto const& elem : _collectors) {
+            collectors.push_back(elem.second);
+        }
+    }
+    for (auto const& elem : metrics) {
+        std::string const& name = elem.first;
+        Entry const& entry = elem.second;
+        if (entry.counter != nullptr) {
+            writeHeader(os, name, "counter", entry.help);
+            writeValue(os, name, "", entry.counter->value());
+        } else if (entry.gauge != nullptr) {
+            writeHeader(os, name, "gauge", entry.help);
+            writeValue(os, name, "", entry.gauge->value());
+        } else if (entry.histogram != nullptr) {
+            writeHeader(os, name, "histogram", entry.help);
+            Histogram::Snapshot const snap = entry.histogram->snapshot();
+            uint64_t cumulative = 0;
+            for (size_t j = 0; j < snap.counts.size(); ++j) {
+                cumulative += snap.counts[j];
+                std::ostringstream le;
+                if (j < snap.bounds.size()) {
+                    writeDouble(le, snap.bounds[j]);
+                } else {
+                    le << "+Inf";
+                }
+                writeValue(os, name + "_bucket", "le=\"" + le.str() + "\"", cumulative);
+            }
+            writeValue(os, name + "_sum", "", snap.sum);
+            writeValue(os, name + "_count", "", snap.count);
+        }
+    }
+    for (auto const& collector : collectors) {
+        collector(os);
+    }
+}
+
+
+void MetricsRegistry::writeHeader(std::ostream& os, std::string const& name, std::string const& type,
+                                  std::string const& help) {
+    std::string escaped;
+    for (char c : help) {
+        if (c == '\\') escaped += "\\\\";
+        else if (c == '\n') escaped += "\\n";
+        else escaped += c;
+    }
+    os << "# HELP " << name << " " << escaped << "\n";
+    os << "# TYPE " << name << " " << type << "\n";
+}
+
+
+void MetricsRegistry::writeValue(std::ostream& os, std::string const& name, std::string const& labels,
+                                 double val) {
+    os << name;
+    if (!labels.empty()) os << "{" << labels << "}";
+    os << " ";
+    writeDouble(os, val);
+    os << "\n";
+}
+
+
+std::string MetricsRegistry::escapeLabel(std::string const& val) {
+    std::string escaped;
+    for (char c : val) {
+        if (c == '\\') escaped += "\\\\";
+        else if (c == '"') escaped += "\\\"";
+        else if (c == '\n') escaped += "\\n";
+        else escaped += c;
+    }
+    return escaped;
+}
+
+}}} // namespace lsst::qserv::util
@@ -0,0 +1,190 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ *
+ */
+#ifndef LSST_QSERV_UTIL_METRICS_H
+#define LSST_QSERV_UTIL_METRICS_H
+
+// System headers
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace lsst {
+namespace qserv {
+namespace util {
+
+/// Counters and histograms spread their updates over this many shards. A
+/// thread always updates the same shard, so that threads updating the same
+/// metric seldom write the same cache line and never wait on a mutex.
+unsigned const METRIC_SHARDS = 16;
+
+/// @return the shard of the calling thread, assigned on first use.
+unsigned metricShard();
+
+/// A count that only goes up, such as the number of requests served.
+class Counter {
+public:
+    using Ptr = std::shared_ptr<Counter>;
+
+    Counter() = default;
+    Counter(Counter const&) = delete;
+    Counter& operator=(Counter const&) = delete;
+
+    void add(uint64_t n=1) { _slots[metricShard()].value.fetch_add(n, std::memory_order_relaxed); }
+
+    /// @return the sum of all shards.
+    uint64_t value() const;
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> value{0};
+        char pad[64 - sizeof(std::atomic<uint64_t>)];
+    };
+    Slot _slots[METRIC_SHARDS];
+};
+
+
+/// A value that can go up and down, such as the number of open connections.
+class Gauge {
+public:
+    using Ptr = std::shared_ptr<Gauge>;
+
+    Gauge() = default;
+    Gauge(Gauge const&) = delete;
+    Gauge& operator=(Gauge const&) = delete;
+
+    void set(int64_t val) { _value.store(val, std::memory_order_relaxed); }
+    void add(int64_t n) { _value.fetch_add(n, std::memory_order_relaxed); }
+    int64_t value() const { return _value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> _value{0};
+};
+
+
+/// Counts of observed values, such as durations in seconds, in buckets with
+/// fixed upper bounds, plus the sum and count of all values. Bounds growing
+/// by a constant factor, from exponentialBounds(), keep the relative error
+/// of every bucket the same, as an HDR histogram does.
+class Histogram {
+public:
+    using Ptr = std::shared_ptr<Histogram>;
+
+    struct Snapshot {
+        std::vector<double> bounds;
+        std::vector<uint64_t> counts; ///< Per bucket, the last one counts the values above all bounds.
+        double sum{0.0};
+        uint64_t count{0};
+    };
+
+    /// @param bounds - upper bounds of the buckets, sorted and made unique.
+    explicit Histogram(std::vector<double> const& bounds);
+    Histogram(Histogram const&) = delete;
+    Histogram& operator=(Histogram const&) = delete;
+
+    /// @return 'count' bounds starting at 'first', each 'factor' times the previous one.
+    static std::vector<double> exponentialBounds(double first, double factor, unsigned count);
+
+    void observe(double val);
+
+    /// @return the counts of all shards added up.
+    Snapshot snapshot() const;
+
+private:
+    struct Shard {
+        explicit Shard(size_t buckets) : counts(buckets) {}
+        std::vector<std::atomic<uint64_t>> counts;
+        std::atomic<double> sum{0.0};
+    };
+
+    std::vector<double> _bounds;
+    std::vector<std::unique_ptr<Shard>> _shards; ///< Allocated apart so shards do not share cache lines.
+};
+
+
+/// MetricsRegistry holds the metrics of this process by name, and writes
+/// them in the Prometheus text exposition format. Metrics are created once,
+/// normally at file scope of the code updating them, after which updates do
+/// not involve the registry. Statistics kept elsewhere are written by
+/// collectors, functions called each time the metrics are written.
+class MetricsRegistry {
+public:
+    /// Writes the lines of some metrics, see writeHeader() and writeValue().
+    using Collector = std::function<void(std::ostream& os)>;
+
+    /// @return the registry of this process.
+    static MetricsRegistry& get();
+
+    MetricsRegistry() = default;
+    MetricsRegistry(MetricsRegistry const&) = delete;
+    MetricsRegistry& operator=(MetricsRegistry const&) = delete;
+
+    /// @return the metric called 'name', created if it does not exist yet.
+    /// @throws std::invalid_argument if 'name' is used by a metric of another kind.
+    Counter::Ptr counter(std::string const& name, std::string const& help);
+    Gauge::Ptr gauge(std::string const& name, std::string const& help);
+    Histogram::Ptr histogram(std::string const& name, std::string const& help,
+                             std::vector<double> const& bounds);
+
+    /// Add or replace the collector called 'name'.
+    void addCollector(std::string const& name, Collector const& collector);
+    void removeCollector(std::string const& name);
+
+    /// Write all metrics, in name order, and then the output of the collectors.
+    void write(std::ostream& os) const;
+
+    /// Write the HELP and TYPE lines of a metric, 'type' being "counter" or "gauge".
+    static void writeHeader(std::ostream& os, std::string const& name, std::string const& type,
+                            std::string const& help);
+
+    /// Write one sample line, 'labels' such as "scheduler=\"SchedFast\"" may be empty.
+    static void writeValue(std::ostream& os, std::string const& name, std::string const& labels,
+                           double val);
+
+    /// @return 'val' with backslashes, quotes and newlines escaped for a label.
+    static std::string escapeLabel(std::string const& val);
+
+private:
+    struct Entry {
+        std::string help;
+        Counter::Ptr counter;
+        Gauge::Ptr gauge;
+        Histogram::Ptr histogram;
+    };
+
+    Entry& _entry(std::string const& name, std::string const& help);
+
+    mutable std::mutex _mtx; ///< Protects members below
+    std::map<std::string, Entry> _metrics;
+    std::map<std::string, Collector> _collectors;
+};
+
+}}} // namespace lsst::qserv::util
+
+#endif // LSST_QSERV_UTIL_METRICS_H
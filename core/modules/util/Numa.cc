@@ -0,0 +1,168 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ *
+ */
+
+// Class header
+#include "util/Numa.h"
+
+// System headers
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <map>
+#include <pthread.h>
+#include <sched.h>
+#include <sstream>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.util.Numa");
+
+// From <numaif.h>, which is only installed with libnuma.
+int const MPOL_PREFERRED = 1;
+unsigned const MPOL_MF_MOVE = 1 << 1;
+
+std::string const nodeDir = "/sys/devices/system/node";
+
+/// @return the cpus of each node listed in nodeDir, or a single node with
+///         no cpus if there is no such directory.
+std::vector<std::vector<int>> discoverNodes() {
+    std::map<int, std::vector<int>> nodes;
+    DIR* dir = opendir(nodeDir.c_str());
+    if (dir != nullptr) {
+        while (dirent* entry = readdir(dir)) {
+            char const* name = entry->d_name;
+            if (std::strncmp(name, "node", 4) != 0) continue;
+            char* end = nullptr;
+            long node = std::strtol(name + 4, &end, 10);
+            if (end == name + 4 || *end != '\0') continue;
+            std::ifstream cpuFile(nodeDir + "/" + name + "/cpulist");
+            std::string cpuList;
+            std::getline(cpuFile, cpuList);
+            nodes[node] = lsst::qserv::util::Numa::parseCpuList(cpuList);
+        }
+        closedir(dir);
+    }
+    std::vector<std::vector<int>> cpusOfNodes;
+    for (auto const& elem : nodes) {
+        // Keep node numbers and indexes equal, numbering has no holes in practice.
+        if (elem.first != static_cast<int>(cpusOfNodes.size())) break;
+        cpusOfNodes.push_back(elem.second);
+    }
+    if (cpusOfNodes.empty()) {
+        cpusOfNodes.emplace_back();
+    }
+    return cpusOfNodes;
+}
+
+} // anonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace util {
+
+Numa& Numa::get() {
+    static Numa numa(discoverNodes());
+    return numa;
+}
+
+
+std::vector<int> Numa::parseCpuList(std::string const& cpuList) {
+    std::vector<int> cpus;
+    std::istringstream is(cpuList);
+    std::string range;
+    while (std::getline(is, range, ',')) {
+        if (range.empty()) continue;
+        char* end = nullptr;
+        long first = std::strtol(range.c_str(), &end, 10);
+        long last = first;
+        if (end == range.c_str()) return std::vector<int>();
+        if (*end == '-') {
+            char const* lastStr = end + 1;
+            last = std::strtol(lastStr, &end, 10);
+            if (end == lastStr) return std::vector<int>();
+        }
+        if (*end != '\0' || first < 0 || last < first) return std::vector<int>();
+        for (long cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+
+Numa::Numa(std::vector<std::vector<int>> const& cpusOfNodes) : _cpusOfNodes(cpusOfNodes) {
+    LOGS(_log, LOG_LVL_DEBUG, "NUMA nodes=" << _cpusOfNodes.size());
+}
+
+
+int Numa::nodeForChunk(int chunkId) const {
+    if (!isEnabled() || chunkId < 0) return -1;
+    return chunkId % nodeCount();
+}
+
+
+bool Numa::bindThread(int node) const {
+    if (!isEnabled() || node >= nodeCount()) return false;
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (int j = 0; j < nodeCount(); ++j) {
+        if (node >= 0 && j != node) continue;
+        for (int cpu : _cpusOfNodes[j]) {
+            if (cpu < CPU_SETSIZE) CPU_SET(cpu, &cpuSet);
+        }
+    }
+    if (CPU_COUNT(&cpuSet) == 0) return false;
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+    if (rc != 0) {
+        LOGS(_log, LOG_LVL_WARN, "cannot bind thread to node " << node << " rc=" << rc);
+        return false;
+    }
+    return true;
+}
+
+
+bool Numa::placeMemory(void* addr, size_t len, int node) const {
+    unsigned long const maxNodes = 8 * sizeof(unsigned long);
+    if (!isEnabled() || node < 0 || node >= nodeCount()
+        || static_cast<unsigned long>(node) >= maxNodes || len == 0) {
+        return false;
+    }
+    unsigned long nodeMask = 1UL << node;
+    // The kernel ignores the last bit of maxnode, hence the extra bit.
+    if (syscall(SYS_mbind, addr, len, MPOL_PREFERRED, &nodeMask, maxNodes + 1, MPOL_MF_MOVE) != 0) {
+        LOGS(_log, LOG_LVL_WARN, "cannot place " << len << " bytes on node " << node
+             << " errno=" << errno);
+        return false;
+    }
+    return true;
+}
+
+}}} // namespace lsst::qserv::util
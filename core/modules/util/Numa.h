@@ -0,0 +1,85 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ *
+ */
+#ifndef LSST_QSERV_UTIL_NUMA_H
+#define LSST_QSERV_UTIL_NUMA_H
+
+// System headers
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace lsst {
+namespace qserv {
+namespace util {
+
+/// Numa describes the NUMA nodes of this host, as listed in
+/// /sys/devices/system/node, and places threads and memory on them.
+/// Chunks are spread over the nodes so that the pages of a chunk and the
+/// threads scanning it stay on the same node. Nothing is placed unless
+/// placement was enabled and the host has more than one node. Placement is
+/// a hint, failures are logged and otherwise ignored.
+class Numa {
+public:
+    /// @return the NUMA nodes of this host, discovered on first use.
+    static Numa& get();
+
+    /// Parse a cpulist such as "0-3,8,10-11" into cpu numbers.
+    /// @return the cpus, or an empty vector if 'cpuList' is malformed.
+    static std::vector<int> parseCpuList(std::string const& cpuList);
+
+    /// @param cpusOfNodes - cpus of each node, the node number is the index.
+    explicit Numa(std::vector<std::vector<int>> const& cpusOfNodes);
+
+    Numa(Numa const&) = delete;
+    Numa& operator=(Numa const&) = delete;
+
+    void setEnabled(bool enabled) { _enabled = enabled; }
+
+    /// @return true if threads and memory are placed on nodes.
+    bool isEnabled() const { return _enabled && nodeCount() > 1; }
+
+    int nodeCount() const { return _cpusOfNodes.size(); }
+
+    /// @return the node that scans 'chunkId', or -1 if placement is disabled.
+    int nodeForChunk(int chunkId) const;
+
+    /// Restrict the calling thread to the cpus of 'node'. A negative node
+    /// lets it run on any cpu again.
+    /// @return true if the thread's affinity was changed.
+    bool bindThread(int node) const;
+
+    /// Prefer 'node' for the pages of [addr, addr+len) and move the pages
+    /// already there. 'addr' must be page aligned, as mmap() returns.
+    /// @return true if the policy was applied.
+    bool placeMemory(void* addr, size_t len, int node) const;
+
+private:
+    std::vector<std::vector<int>> const _cpusOfNodes;
+    std::atomic<bool> _enabled{false};
+};
+
+}}} // namespace lsst::qserv::util
+
+#endif // LSST_QSERV_UTIL_NUMA_H
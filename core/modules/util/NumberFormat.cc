@@ -0,0 +1,109 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "util/NumberFormat.h"
+
+// System headers
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+/// Write the fewest of 'minDigits' to 'maxDigits' significant digits of
+/// 'val' that read back to the same value.
+template <typename T>
+size_t formatReal(T val, int minDigits, int maxDigits, char* buf) {
+    size_t const size = lsst::qserv::util::NumberFormat::BUFFER_SIZE;
+    int n = 0;
+    for (int digits = minDigits; digits <= maxDigits; ++digits) {
+        n = std::snprintf(buf, size, "%.*g", digits, static_cast<double>(val));
+        char* end = nullptr;
+        T back = sizeof(T) == sizeof(float) ? std::strtof(buf, &end) : std::strtod(buf, &end);
+        if (back == val) {
+            break;
+        }
+    }
+    char* e = std::strchr(buf, 'e');
+    if (e == nullptr) {
+        return n;
+    }
+    char* src = e + 1;
+    char* dst = e + 1;
+    if (*src == '+') {
+        ++src;
+    } else if (*src == '-') {
+        *dst++ = *src++;
+    }
+    while (*src == '0' && src[1] != '\0') {
+        ++src;
+    }
+    while (*src != '\0') {
+        *dst++ = *src++;
+    }
+    *dst = '\0';
+    return dst - buf;
+}
+
+} // anonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace util {
+
+size_t NumberFormat::formatUInt(uint64_t val, char* buf) {
+    char digits[BUFFER_SIZE];
+    size_t n = 0;
+    do {
+        digits[n++] = '0' + val % 10;
+        val /= 10;
+    } while (val != 0);
+    for (size_t j = 0; j < n; ++j) {
+        buf[j] = digits[n - 1 - j];
+    }
+    buf[n] = '\0';
+    return n;
+}
+
+
+size_t NumberFormat::formatInt(int64_t val, char* buf) {
+    if (val >= 0) {
+        return formatUInt(val, buf);
+    }
+    buf[0] = '-';
+    // Negate as unsigned so that the most negative value does not overflow.
+    return 1 + formatUInt(0 - static_cast<uint64_t>(val), buf + 1);
+}
+
+
+size_t NumberFormat::formatDouble(double val, char* buf) {
+    return formatReal(val, 15, 17, buf);
+}
+
+
+size_t NumberFormat::formatFloat(float val, char* buf) {
+    return formatReal(val, 6, 9, buf);
+}
+
+}}} // namespace lsst::qserv::util
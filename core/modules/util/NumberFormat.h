@@ -0,0 +1,53 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_UTIL_NUMBERFORMAT_H
+#define LSST_QSERV_UTIL_NUMBERFORMAT_H
+
+// System headers
+#include <cstddef>
+#include <cstdint>
+
+namespace lsst {
+namespace qserv {
+namespace util {
+
+/// Text form of numbers as sent in result rows. Each function writes a zero
+/// terminated string of at most BUFFER_SIZE - 1 characters to 'buf', and
+/// returns its length.
+class NumberFormat {
+public:
+    static size_t const BUFFER_SIZE = 32;
+
+    static size_t formatInt(int64_t val, char* buf);
+    static size_t formatUInt(uint64_t val, char* buf);
+
+    /// Floating point values are written with the fewest significant digits
+    /// that read back to the same value, and the exponent as MySQL writes it,
+    /// without '+' or leading zeros, e.g. 1e-5.
+    static size_t formatDouble(double val, char* buf);
+    static size_t formatFloat(float val, char* buf);
+};
+
+}}} // namespace lsst::qserv::util
+
+#endif // LSST_QSERV_UTIL_NUMBERFORMAT_H
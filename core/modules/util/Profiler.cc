@@ -0,0 +1,241 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "util/Profiler.h"
+
+// System headers
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <map>
+#include <mutex>
+#include <signal.h>
+#include <sstream>
+#include <sys/time.h>
+#include <thread>
+#include <vector>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.util.Profiler");
+
+int const MAX_FRAMES = 48;
+size_t const MAX_SAMPLES = 50000;
+
+/// Frames of the signal handler and of the signal trampoline, at the top of
+/// every sample.
+int const SKIP_FRAMES = 2;
+
+struct Sample {
+    char const* role;
+    int depth;
+    void* frames[MAX_FRAMES];
+};
+
+// Initial-exec so that reading it in the signal handler does not allocate.
+__thread char const* threadRole __attribute__((tls_model("initial-exec"))) = nullptr;
+
+std::mutex profileMtx; ///< Held while a profile runs.
+bool handlerInstalled = false; ///< Protected by profileMtx.
+
+// Shared with the signal handler, samples is null when not profiling.
+std::atomic<Sample*> samples{nullptr};
+size_t capacity = 0;
+std::atomic<size_t> nextSample{0};
+std::atomic<int> inHandler{0};
+
+
+void onSigProf(int, siginfo_t*, void*) {
+    int const savedErrno = errno;
+    ++inHandler;
+    Sample* buf = samples.load();
+    if (buf != nullptr) {
+        size_t const i = nextSample.fetch_add(1, std::memory_order_relaxed);
+        if (i < capacity) {
+            buf[i].role = threadRole;
+            buf[i].depth = backtrace(buf[i].frames, MAX_FRAMES);
+        }
+    }
+    --inHandler;
+    errno = savedErrno;
+}
+
+
+/// Install the SIGPROF handler, for good: a signal still pending when a
+/// profile ends would otherwise terminate the process.
+bool installHandler(std::string& error) {
+    if (handlerInstalled) {
+        return true;
+    }
+    struct sigaction old;
+    if (sigaction(SIGPROF, nullptr, &old) != 0) {
+        error = std::string("sigaction failed: ") + std::strerror(errno);
+        return false;
+    }
+    if ((old.sa_flags & SA_SIGINFO) != 0 || (old.sa_handler != SIG_DFL && old.sa_handler != SIG_IGN)) {
+        error = "SIGPROF is handled by another profiler";
+        return false;
+    }
+    struct sigaction sa;
+    std::memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = onSigProf;
+    sa.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGPROF, &sa, nullptr) != 0) {
+        error = std::string("sigaction failed: ") + std::strerror(errno);
+        return false;
+    }
+    // backtrace() loads libgcc on first use, which must not happen in the handler.
+    void* frame;
+    backtrace(&frame, 1);
+    handlerInstalled = true;
+    return true;
+}
+
+
+/// @return the name of the function at 'addr', the library and offset if
+///         it has none.
+std::string symbolize(void* addr) {
+    Dl_info info;
+    if (dladdr(addr, &info) == 0) {
+        std::ostringstream os;
+        os << addr;
+        return os.str();
+    }
+    std::string name;
+    if (info.dli_sname != nullptr) {
+        int status = 0;
+        char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        name = (status == 0 && demangled != nullptr) ? demangled : info.dli_sname;
+        std::free(demangled);
+    } else {
+        std::ostringstream os;
+        char const* base = std::strrchr(info.dli_fname, '/');
+        os << (base == nullptr ? info.dli_fname : base + 1) << "+0x" << std::hex
+           << (static_cast<char*>(addr) - static_cast<char*>(info.dli_fbase));
+        name = os.str();
+    }
+    std::replace(name.begin(), name.end(), ';', ':');
+    return name;
+}
+
+} // annonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace util {
+
+unsigned int const Profiler::MAX_SECONDS;
+unsigned int const Profiler::MAX_HZ;
+
+
+bool Profiler::profile(std::chrono::milliseconds duration, unsigned int hz,
+                       std::string& folded, std::string& error) {
+    std::unique_lock<std::mutex> lock(profileMtx, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        error = "a profile is already running";
+        return false;
+    }
+    hz = std::max(1U, std::min(hz, MAX_HZ));
+    duration = std::max(std::chrono::milliseconds(1),
+                        std::min(duration, std::chrono::milliseconds(MAX_SECONDS * 1000)));
+    if (!installHandler(error)) {
+        return false;
+    }
+
+    // Every CPU may be sampled at hz.
+    size_t const cpus = std::max(1U, std::thread::hardware_concurrency());
+    size_t const expected = hz * cpus * (duration.count() / 1000 + 1);
+    std::vector<Sample> buf(std::min(expected, MAX_SAMPLES));
+    capacity = buf.size();
+    nextSample = 0;
+    samples.store(buf.data());
+
+    struct itimerval timer;
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = 1000000 / hz;
+    timer.it_value = timer.it_interval;
+    bool started = setitimer(ITIMER_PROF, &timer, nullptr) == 0;
+    if (!started) {
+        error = std::string("setitimer failed: ") + std::strerror(errno);
+    } else {
+        LOGS(_log, LOG_LVL_INFO, "profiling for " << duration.count() << " ms at " << hz << " Hz");
+        std::this_thread::sleep_for(duration);
+        std::memset(&timer, 0, sizeof(timer));
+        setitimer(ITIMER_PROF, &timer, nullptr);
+    }
+    samples.store(nullptr);
+    while (inHandler.load() > 0) {
+        std::this_thread::yield();
+    }
+    if (!started) {
+        return false;
+    }
+
+    size_t const taken = nextSample.load();
+    size_t const count = std::min(taken, capacity);
+    if (taken > count) {
+        LOGS(_log, LOG_LVL_WARN, "profile dropped " << taken - count << " samples over " << capacity);
+    }
+    std::map<void*, std::string> names;
+    std::map<std::string, uint64_t> stacks;
+    for (size_t i = 0; i < count; ++i) {
+        Sample const& sample = buf[i];
+        std::string stack = sample.role == nullptr ? "other" : sample.role;
+        for (int j = sample.depth - 1; j >= SKIP_FRAMES; --j) {
+            void* addr = sample.frames[j];
+            auto itr = names.find(addr);
+            if (itr == names.end()) {
+                // Return addresses point after the call, the caller is before it.
+                void* site = (j == SKIP_FRAMES) ? addr : static_cast<char*>(addr) - 1;
+                itr = names.emplace(addr, symbolize(site)).first;
+            }
+            stack += ";" + itr->second;
+        }
+        ++stacks[stack];
+    }
+    std::ostringstream os;
+    for (auto const& elem : stacks) {
+        os << elem.first << " " << elem.second << "\n";
+    }
+    folded = os.str();
+    return true;
+}
+
+
+char const* Profiler::setThreadRole(char const* role) {
+    char const* previous = threadRole;
+    threadRole = role;
+    return previous;
+}
+
+}}} // namespace lsst::qserv::util
@@ -0,0 +1,80 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_UTIL_PROFILER_H
+#define LSST_QSERV_UTIL_PROFILER_H
+
+// System headers
+#include <chrono>
+#include <string>
+
+namespace lsst {
+namespace qserv {
+namespace util {
+
+/// Profiler samples the stacks of the threads of the process as they use
+/// the CPU, with SIGPROF, for a bounded duration. The samples are returned
+/// as folded stacks, one line per distinct stack with the number of times
+/// it was sampled, which flamegraph.pl and similar tools read:
+///
+///     scheduler;start_thread;...;lsst::qserv::wdb::QueryRunner::runQuery() 12
+///
+/// The first frame is the role of the thread when it was sampled, see
+/// ThreadRole, "other" if it has none. One profile runs at a time. Note that
+/// system calls interrupted by the signal may fail with EINTR, those that do
+/// not restart with SA_RESTART.
+class Profiler {
+public:
+    static unsigned int const MAX_SECONDS = 60;
+    static unsigned int const MAX_HZ = 1000;
+
+    /// Sample the stacks for 'duration' at 'hz' samples per CPU second.
+    /// @param folded - set to the folded stacks.
+    /// @param error - set to the reason if false is returned.
+    /// @return false if a profile is already running or the profiler could
+    ///         not be started.
+    static bool profile(std::chrono::milliseconds duration, unsigned int hz,
+                        std::string& folded, std::string& error);
+
+    /// Set the role of the calling thread, reported by profile(). 'role'
+    /// must outlive its use, a string literal.
+    /// @return the previous role, nullptr if none.
+    static char const* setThreadRole(char const* role);
+};
+
+
+/// ThreadRole sets the role of the calling thread for its lifetime, and
+/// restores the previous one afterwards.
+class ThreadRole {
+public:
+    explicit ThreadRole(char const* role) : _previous(Profiler::setThreadRole(role)) {}
+    ~ThreadRole() { Profiler::setThreadRole(_previous); }
+    ThreadRole(ThreadRole const&) = delete;
+    ThreadRole& operator=(ThreadRole const&) = delete;
+
+private:
+    char const* _previous;
+};
+
+}}} // namespace lsst::qserv::util
+
+#endif // LSST_QSERV_UTIL_PROFILER_H
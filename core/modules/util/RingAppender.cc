@@ -0,0 +1,240 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "util/RingAppender.h"
+
+// System headers
+#include <algorithm>
+
+// Third-party headers
+#include <log4cxx/helpers/loglog.h>
+#include <log4cxx/helpers/pool.h>
+#include <log4cxx/helpers/stringhelper.h>
+#include <log4cxx/helpers/synchronized.h>
+#include <log4cxx/helpers/transcoder.h>
+#include <log4cxx/layout.h>
+
+// Qserv headers
+#include "util/Metrics.h"
+
+namespace {
+
+lsst::qserv::util::Counter::Ptr droppedCounter() {
+    static auto counter = lsst::qserv::util::MetricsRegistry::get().counter(
+        "qserv_log_records_dropped_total", "Log records dropped by RingAppender");
+    return counter;
+}
+
+} // annonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace util {
+
+// What IMPLEMENT_LOG4CXX_OBJECT(RingAppender) defines, with names qualified
+// for a class outside of the log4cxx namespace.
+log4cxx::helpers::Class const& RingAppender::getClass() const {
+    return getStaticClass();
+}
+
+
+log4cxx::helpers::Class const& RingAppender::getStaticClass() {
+    static ClazzRingAppender theClass;
+    return theClass;
+}
+
+
+log4cxx::helpers::ClassRegistration const& RingAppender::registerClass() {
+    static log4cxx::helpers::ClassRegistration classReg(RingAppender::getStaticClass);
+    return classReg;
+}
+
+
+RingAppender::RingAppender() {
+}
+
+
+RingAppender::~RingAppender() {
+    close();
+}
+
+
+void RingAppender::setOption(log4cxx::LogString const& option, log4cxx::LogString const& value) {
+    using log4cxx::helpers::StringHelper;
+    if (StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("FILE"), LOG4CXX_STR("file"))) {
+        LOG4CXX_ENCODE_CHAR(file, value);
+        _file = file;
+    } else if (StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("BUFFERSIZE"), LOG4CXX_STR("buffersize"))) {
+        _bufferSize = std::max(1, StringHelper::toInt(value));
+    } else if (StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("RATELIMIT"), LOG4CXX_STR("ratelimit"))) {
+        _rateLimit = std::max(0, StringHelper::toInt(value));
+    } else {
+        AppenderSkeleton::setOption(option, value);
+    }
+}
+
+
+void RingAppender::activateOptions(log4cxx::helpers::Pool& pool) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    if (_thread.joinable()) {
+        return;
+    }
+    _out = stderr;
+    if (!_file.empty()) {
+        _out = std::fopen(_file.c_str(), "a");
+        if (_out == nullptr) {
+            LOG4CXX_DECODE_CHAR(file, _file);
+            log4cxx::helpers::LogLog::error(LOG4CXX_STR("RingAppender can not open ") + file
+                                            + LOG4CXX_STR(", writing to stderr"));
+            _out = stderr;
+        }
+    }
+    _ring.assign(std::max(_bufferSize, size_t(1)), log4cxx::spi::LoggingEventPtr());
+    _thread = std::thread(&RingAppender::_run, this);
+}
+
+
+void RingAppender::close() {
+    {
+        log4cxx::helpers::synchronized sync(mutex);
+        if (closed) {
+            return;
+        }
+        closed = true;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _stop = true;
+    }
+    _cv.notify_all();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+    if (_out != nullptr && _out != stderr) {
+        std::fclose(_out);
+    }
+    _out = nullptr;
+}
+
+
+void RingAppender::flush() {
+    std::unique_lock<std::mutex> lock(_mtx);
+    uint64_t const appended = _appended;
+    _writtenCv.wait(lock, [this, appended]() { return _written >= appended || _stop; });
+}
+
+
+uint64_t RingAppender::getDropped() {
+    return droppedCounter()->value();
+}
+
+
+void RingAppender::append(log4cxx::spi::LoggingEventPtr const& event, log4cxx::helpers::Pool&) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    if (_stop || _count == _ring.size() || !_admit(event)) {
+        ++_dropped;
+        droppedCounter()->add();
+        return;
+    }
+    // The background thread lays the record out, it needs the diagnostic
+    // contexts of this thread.
+    log4cxx::LogString ndc;
+    event->getNDC(ndc);
+    event->getMDCCopy();
+    _ring[(_head + _count) % _ring.size()] = event;
+    ++_count;
+    ++_appended;
+    if (_count == 1) {
+        _cv.notify_one();
+    }
+}
+
+
+bool RingAppender::_admit(log4cxx::spi::LoggingEventPtr const& event) {
+    if (_rateLimit == 0) {
+        return true;
+    }
+    auto const& location = event->getLocationInformation();
+    Bucket& bucket = _buckets[Site(location.getFileName(), location.getLineNumber())];
+    auto const now = std::chrono::steady_clock::now();
+    if (bucket.refilled == std::chrono::steady_clock::time_point()) {
+        bucket.tokens = _rateLimit;
+    } else {
+        double const seconds = std::chrono::duration<double>(now - bucket.refilled).count();
+        bucket.tokens = std::min(double(_rateLimit), bucket.tokens + seconds * _rateLimit);
+    }
+    bucket.refilled = now;
+    if (bucket.tokens < 1) {
+        return false;
+    }
+    bucket.tokens -= 1;
+    return true;
+}
+
+
+void RingAppender::_run() {
+    std::vector<log4cxx::spi::LoggingEventPtr> events;
+    std::unique_lock<std::mutex> lock(_mtx);
+    while (true) {
+        _cv.wait(lock, [this]() { return _count > 0 || _stop; });
+        if (_count == 0 && _dropped == 0) {
+            break; // stopped and drained
+        }
+        events.clear();
+        while (_count > 0) {
+            events.push_back(_ring[_head]);
+            _ring[_head] = log4cxx::spi::LoggingEventPtr();
+            _head = (_head + 1) % _ring.size();
+            --_count;
+        }
+        uint64_t const dropped = _dropped;
+        _dropped = 0;
+        size_t const written = events.size();
+        lock.unlock();
+        _write(events, dropped);
+        lock.lock();
+        _written += written;
+        _writtenCv.notify_all();
+    }
+    _writtenCv.notify_all();
+}
+
+
+void RingAppender::_write(std::vector<log4cxx::spi::LoggingEventPtr>& events, uint64_t dropped) {
+    log4cxx::helpers::Pool pool;
+    log4cxx::LogString buf;
+    for (auto const& event : events) {
+        buf.clear();
+        layout->format(buf, event, pool);
+        LOG4CXX_ENCODE_CHAR(str, buf);
+        std::fwrite(str.data(), 1, str.size(), _out);
+    }
+    events.clear();
+    if (dropped > 0) {
+        std::fprintf(_out, "RingAppender dropped %llu log records\n", (unsigned long long)dropped);
+    }
+    std::fflush(_out);
+}
+
+}}} // namespace lsst::qserv::util
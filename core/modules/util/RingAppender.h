@@ -0,0 +1,131 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_UTIL_RINGAPPENDER_H
+#define LSST_QSERV_UTIL_RINGAPPENDER_H
+
+// System headers
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Third-party headers
+#include <log4cxx/appenderskeleton.h>
+#include <log4cxx/spi/loggingevent.h>
+
+namespace lsst {
+namespace qserv {
+namespace util {
+
+/// The log4cxx macros name these unqualified.
+namespace helpers = log4cxx::helpers;
+
+/// RingAppender is a log4cxx appender that keeps the logging threads off
+/// the formatting and writing of their records. A record is put in a ring
+/// buffer of fixed size, and a background thread lays it out and writes it.
+/// Records that do not fit in the ring, and those of a call site logging
+/// more than RateLimit records per second, are dropped and counted; the
+/// count is written in the log and exported as the
+/// qserv_log_records_dropped_total metric.
+///
+/// It is set up in the log4cxx configuration like the other appenders, with
+/// a layout and these options:
+///
+///     log4j.appender.RING=RingAppender
+///     log4j.appender.RING.File=/path/to/file   # stderr when unset
+///     log4j.appender.RING.BufferSize=65536     # records
+///     log4j.appender.RING.RateLimit=1000       # per call site and second, 0 for none
+///     log4j.appender.RING.layout=org.apache.log4j.PatternLayout
+///
+/// registerClass() must be called before the configuration is read.
+class RingAppender : public log4cxx::AppenderSkeleton {
+public:
+    DECLARE_LOG4CXX_OBJECT(RingAppender)
+    BEGIN_LOG4CXX_CAST_MAP()
+        LOG4CXX_CAST_ENTRY(RingAppender)
+        LOG4CXX_CAST_ENTRY_CHAIN(AppenderSkeleton)
+    END_LOG4CXX_CAST_MAP()
+
+    RingAppender();
+    ~RingAppender();
+
+    void setOption(log4cxx::LogString const& option, log4cxx::LogString const& value) override;
+    void activateOptions(log4cxx::helpers::Pool& pool) override;
+    void close() override;
+    bool requiresLayout() const override { return true; }
+
+    void setFile(std::string const& file) { _file = file; }
+    void setBufferSize(size_t bufferSize) { _bufferSize = bufferSize; }
+    void setRateLimit(unsigned int rateLimit) { _rateLimit = rateLimit; }
+
+    /// Wait until the records appended so far are written.
+    void flush();
+
+    /// @return the number of records dropped by all RingAppenders.
+    static uint64_t getDropped();
+
+protected:
+    void append(log4cxx::spi::LoggingEventPtr const& event, log4cxx::helpers::Pool& pool) override;
+
+private:
+    /// Records a call site may still log, refilled at _rateLimit per second.
+    struct Bucket {
+        double tokens{0};
+        std::chrono::steady_clock::time_point refilled;
+    };
+    /// File name and line number. The file names are those of __FILE__,
+    /// which stay in place.
+    using Site = std::pair<char const*, int>;
+
+    bool _admit(log4cxx::spi::LoggingEventPtr const& event);
+    void _run();
+    void _write(std::vector<log4cxx::spi::LoggingEventPtr>& events, uint64_t dropped);
+
+    std::string _file; ///< Empty for stderr.
+    size_t _bufferSize{65536};
+    unsigned int _rateLimit{1000};
+    std::FILE* _out{nullptr};
+
+    std::mutex _mtx; ///< Protects the members below.
+    std::condition_variable _cv; ///< Signals records in _ring, or _stop.
+    std::condition_variable _writtenCv; ///< Signals _written changed.
+    std::vector<log4cxx::spi::LoggingEventPtr> _ring;
+    size_t _head{0}; ///< Index of the oldest record.
+    size_t _count{0}; ///< Records in _ring.
+    uint64_t _dropped{0}; ///< Records dropped since it was last written.
+    uint64_t _appended{0}; ///< Records put in _ring.
+    uint64_t _written{0}; ///< Records taken out of _ring and written.
+    bool _stop{false};
+    std::map<Site, Bucket> _buckets;
+    std::thread _thread;
+};
+
+}}} // namespace lsst::qserv::util
+
+#endif // LSST_QSERV_UTIL_RINGAPPENDER_H
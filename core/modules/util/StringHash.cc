@@ -26,6 +26,7 @@
 #include "util/StringHash.h"
 
 // System headers
+#include <cstring>
 #include <iostream>
 #include <sstream>
 
@@ -84,6 +85,51 @@ inline std::string wrapHashHex(void const* buffer, int bufferSize) {
     return s.str();
 }
 
+/// Lookup table for the software CRC-32C, reflected polynomial 0x82F63B78.
+struct Crc32cTable {
+    Crc32cTable() {
+        for (std::uint32_t i = 0; i < 256; ++i) {
+            std::uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? (c >> 1) ^ 0x82F63B78 : (c >> 1);
+            }
+            t[i] = c;
+        }
+    }
+    std::uint32_t t[256];
+};
+
+std::uint32_t crc32cSoft(std::uint32_t crc, unsigned char const* p, std::size_t len) {
+    static Crc32cTable const table;
+    while (len--) {
+        crc = table.t[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+
+__attribute__((target("sse4.2")))
+std::uint32_t crc32cHard(std::uint32_t crc, unsigned char const* p, std::size_t len) {
+    std::uint64_t crc64 = crc;
+    while (len >= sizeof(std::uint64_t)) {
+        std::uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        crc64 = __builtin_ia32_crc32di(crc64, word);
+        p += sizeof(word);
+        len -= sizeof(word);
+    }
+    std::uint32_t crc32 = static_cast<std::uint32_t>(crc64);
+    while (len--) {
+        crc32 = __builtin_ia32_crc32qi(crc32, *p++);
+    }
+    return crc32;
+}
+
+bool const hasSse42 = __builtin_cpu_supports("sse4.2");
+
+#endif
+
 } // anonymous namespace
 
 namespace lsst {
@@ -125,4 +171,15 @@ std::string StringHash::getSha256(char const* buffer, int bufferSize) {
     return wrapHash<SHA256, SHA256_DIGEST_LENGTH>(buffer, bufferSize);
 }
 
+std::uint32_t StringHash::getCrc32c(char const* buffer, std::size_t bufferSize, std::uint32_t crc) {
+    auto p = reinterpret_cast<unsigned char const*>(buffer);
+    crc = ~crc;
+#if defined(__x86_64__) && defined(__GNUC__)
+    if (hasSse42) {
+        return ~crc32cHard(crc, p, bufferSize);
+    }
+#endif
+    return ~crc32cSoft(crc, p, bufferSize);
+}
+
 }}} // namespace lsst::qserv::util
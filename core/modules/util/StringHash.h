@@ -25,6 +25,8 @@
 #define LSST_QSERV_UTIL_STRINGHASH_H
 
 // System headers
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace lsst {
@@ -40,6 +42,11 @@ public:
     static std::string getMd5(char const* buffer, int bufferSize);
     static std::string getSha1(char const* buffer, int bufferSize);
     static std::string getSha256(char const* buffer, int bufferSize);
+
+    /// @return the CRC-32C (Castagnoli) checksum of the input buffer, continuing
+    /// from 'crc' so that a checksum can be computed over several buffers.
+    /// The SSE4.2 crc32 instruction is used when the CPU supports it.
+    static std::uint32_t getCrc32c(char const* buffer, std::size_t bufferSize, std::uint32_t crc=0);
 };
 
 }}} // namespace lsst::qserv::util
@@ -26,16 +26,6 @@
 
 // System headers
 #include <cstdio>
-#include <float.h>
-#include <set>
-
-// LSST headers
-#include "lsst/log/Log.h"
-
-namespace {
-LOG_LOGGER _log = LOG_GET("lsst.qserv.util.Timer");
-}
-
 
 namespace lsst {
 namespace qserv {
@@ -62,82 +52,69 @@ std::ostream & Timer::write(std::ostream & os, struct ::timeval const & time) {
     return os;
 }
 
+struct ::timeval Timer::getStartWallTime() const {
+    // Offset the system time by how long ago start() was called.
+    struct ::timespec now;
+    ::clock_gettime(_clock, &now);
+    struct ::timeval wall;
+    ::gettimeofday(&wall, nullptr);
+    int64_t const agoUs = (now.tv_sec - _startTime.tv_sec) * 1000000LL
+                          + (now.tv_nsec - _startTime.tv_nsec) / 1000;
+    int64_t const wallUs = wall.tv_sec * 1000000LL + wall.tv_usec - agoUs;
+    wall.tv_sec = wallUs / 1000000;
+    wall.tv_usec = wallUs % 1000000;
+    return wall;
+}
+
 std::ostream & operator<<(std::ostream & os, Timer const & timer) {
-    Timer::write(os, timer.startTime);
+    Timer::write(os, timer.getStartWallTime());
     os << ' ' << timer.getElapsed();
     return os;
 }
 
 
-LockGuardTimed::LockGuardTimed(std::mutex& mtx, std::string const& note)
-    : _mtx(mtx), _note(note) {
-    timeToLock.start();
-    _mtx.lock();
-    timeToLock.stop();
-    timeHeld.start();
-}
-
-LockGuardTimed::~LockGuardTimed() {
-    _mtx.unlock();
-    timeHeld.stop();
-    LOGS(_log, LOG_LVL_DEBUG, "lockTime " << _note << " toLock=" << timeToLock.getElapsed() <<
-                              " held=" << timeHeld.getElapsed());
+LockTiming::LockTiming(std::string const& name, unsigned sampleEvery)
+    : _sampleEvery(sampleEvery) {
+    // From 1 microsecond to about 4 seconds.
+    auto const bounds = Histogram::exponentialBounds(1e-6, 4, 12);
+    auto& registry = MetricsRegistry::get();
+    _wait = registry.histogram("qserv_lock_" + name + "_wait_seconds", "Sampled time to lock " + name, bounds);
+    _held = registry.histogram("qserv_lock_" + name + "_held_seconds", "Sampled time " + name + " was held",
+                               bounds);
 }
 
 
-TimerHistogram::TimerHistogram(std::string const& label, std::vector<double> const& times) : _label(label) {
-    //sort vector and remove duplicates.
-    std::set<double> timeSet;
-    for (auto& t:times) {
-        timeSet.insert(t);
-    }
-    for (auto& t:timeSet) {
-        _buckets.emplace_back(bucket(t));
-    }
+bool LockTiming::sample() const {
+    // One count per thread for all locks, it is only touched by its thread.
+    thread_local unsigned count = 0;
+    return _sampleEvery > 0 && ++count % _sampleEvery == 0;
 }
 
 
-std::string TimerHistogram::addTime(double time, std::string const& note) {
-    std::lock_guard<std::mutex> lock(_mtx);
-    _total += time;
-    ++_totalCount;
-    bool found = false;
-    for(auto& bkt:_buckets) {
-        if (time < bkt.getMaxVal()) {
-            ++bkt.count;
-            found = true;
-            break;
-        }
-    }
-    if (not found) {
-        ++_overMaxCount;
-    }
-
-    if (note == "") {
-        return "";
+LockGuardTimed::LockGuardTimed(std::mutex& mtx, LockTiming& timing)
+    : _mtx(mtx) {
+    if (!timing.sample()) {
+        _mtx.lock();
+        return;
     }
-    return _getString(note);
-}
-
-
-std::string TimerHistogram::getString(std::string const& note) {
-    std::lock_guard<std::mutex> lock(_mtx);
-    return _getString(note);
+    Timer timeToLock;
+    timeToLock.start();
+    _mtx.lock();
+    timeToLock.stop();
+    _timeHeld.start();
+    _timing = &timing;
+    _timeToLock = timeToLock.getElapsed();
 }
 
-
-/// _mtx must be locked before calling this function.
-///
-std::string TimerHistogram::_getString(std::string const& note) {
-    std::stringstream os;
-    os << _label << " " << note << " avg=" << (_total/_totalCount) << " ";
-    double maxB = -DBL_MAX;
-    for (auto& bkt:_buckets) {
-        os << " <" << bkt.getMaxVal() << "=" << bkt.count;
-        maxB = bkt.getMaxVal();
+LockGuardTimed::~LockGuardTimed() {
+    if (_timing == nullptr) {
+        _mtx.unlock();
+        return;
     }
-    os << " >" << maxB << "=" << _overMaxCount;
-    return os.str();
+    _timeHeld.stop();
+    _mtx.unlock();
+    _timing->addWait(_timeToLock);
+    _timing->addHeld(_timeHeld.getElapsed());
 }
 
 }}} // namespace lsst::qserv::util
@@ -29,98 +29,94 @@
 #include <ostream>
 #include <sys/time.h>
 #include <time.h>
+#include <memory>
 #include <mutex>
+#include <string>
 #include <vector>
 
+// Qserv headers
+#include "util/Metrics.h"
+
 namespace lsst {
 namespace qserv {
 namespace util {
 
-/// A dirt-simple class for instrumenting ops in qserv.
+/// A dirt-simple class for instrumenting ops in qserv. Intervals are measured
+/// on CLOCK_MONOTONIC, so they are not distorted by changes to the system
+/// clock. A coarse Timer reads CLOCK_MONOTONIC_COARSE instead, which is cheaper
+/// but only advances once per kernel tick (1 to 4 milliseconds).
 struct Timer {
-    Timer() {
-        startTime.tv_sec = 0; startTime.tv_usec = 0;
-        stopTime.tv_sec = 0; stopTime.tv_usec = 0;
-    }
+    explicit Timer(bool coarse=false) : _clock(coarse ? CLOCK_MONOTONIC_COARSE : CLOCK_MONOTONIC) {}
 
-    void start() { ::gettimeofday(&startTime, nullptr); }
-    void stop() { ::gettimeofday(&stopTime, nullptr); }
+    void start() { ::clock_gettime(_clock, &_startTime); }
+    void stop() { ::clock_gettime(_clock, &_stopTime); }
 
-    /// Return the difference in wall clock time between the most recent
-    /// calls to start() and stop() in seconds.
+    /// Return the difference in time between the most recent calls to
+    /// start() and stop() in seconds.
     double getElapsed() const {
-        ::time_t seconds = stopTime.tv_sec - startTime.tv_sec;
-        ::suseconds_t usec = stopTime.tv_usec - startTime.tv_usec;
-        return seconds + (usec * 0.000001);
+        return (_stopTime.tv_sec - _startTime.tv_sec) + (_stopTime.tv_nsec - _startTime.tv_nsec) * 1e-9;
     }
 
-    struct ::timeval startTime;
-    struct ::timeval stopTime;
+    /// @return the system time when start() was last called.
+    struct ::timeval getStartWallTime() const;
 
     /// Convert time to an ISO 8601 UTC string with microsecond precision
     /// and write it to the given output stream.
     static std::ostream & write(std::ostream & os,
                                 struct ::timeval const & time);
+
+private:
+    ::clockid_t _clock;
+    struct ::timespec _startTime{0, 0};
+    struct ::timespec _stopTime{0, 0};
 };
 
 std::ostream& operator<<(std::ostream & os, Timer const & tm);
 
-/// This class is used to log how long it takes to lock a mutex
-/// and how long the mutex is held.
-class LockGuardTimed {
+
+/// LockTiming keeps histograms of the time taken to lock a mutex and the time
+/// it is held, as the metrics qserv_lock_<name>_wait_seconds and
+/// qserv_lock_<name>_held_seconds. Only one in 'sampleEvery' acquisitions
+/// made by a thread is timed, so that hot mutexes can be timed in production.
+class LockTiming {
 public:
-    LockGuardTimed(std::mutex& mtx, std::string const& note);
-    LockGuardTimed() = delete;
-    LockGuardTimed(LockGuardTimed const&) = delete;
-    ~LockGuardTimed();
+    static unsigned const DEFAULT_SAMPLE_EVERY = 100;
 
-    LockGuardTimed& operator=(LockGuardTimed const&) = delete;
+    /// @param sampleEvery - 1 times every acquisition, 0 none.
+    explicit LockTiming(std::string const& name, unsigned sampleEvery=DEFAULT_SAMPLE_EVERY);
+    LockTiming(LockTiming const&) = delete;
+    LockTiming& operator=(LockTiming const&) = delete;
+
+    /// @return true if the calling thread should time its next acquisition.
+    bool sample() const;
+
+    void addWait(double seconds) { _wait->observe(seconds); }
+    void addHeld(double seconds) { _held->observe(seconds); }
 
 private:
-    std::mutex& _mtx;
-    std::string _note;
-    Timer timeToLock;
-    Timer timeHeld;
+    unsigned const _sampleEvery;
+    Histogram::Ptr _wait;
+    Histogram::Ptr _held;
 };
 
 
-/// This class is useful for getting an idea of how long something usually takes.
-/// It is also fairly easy to locate an abnormally long call in the log by
-/// searching for the first instance of a particular histogram value.
-class TimerHistogram {
+/// This class locks a mutex for its lifetime and, for the acquisitions
+/// 'timing' samples, records how long it took to lock and how long the
+/// mutex was held.
+class LockGuardTimed {
 public:
-    /// This keeps track of the count of entries with values greater than
-    /// the previous bucket's maxVal and less than this bucket's maxVal.
-    class bucket {
-    public:
-        bucket(double maxV) : _maxVal(maxV) {}
-        bucket() = delete;
-        bucket(bucket const&) = default;
-
-        double getMaxVal() { return _maxVal; }
-        int count{0};
-    private:
-        double _maxVal;
-    };
-
-    TimerHistogram(std::string const& label, std::vector<double> const& times);
-    TimerHistogram() = delete;
-    TimerHistogram(TimerHistogram const&) = delete;
-    TimerHistogram& operator=(TimerHistogram const&) = delete;
-
-    // Add a time to the histogram. If note is != "", return a log worthy string of the histogram.
-    std::string addTime(double time, std::string const& note="");
-    std::string getString(std::string const& note=""); ///< @return a log worthy version of the histogram.
+    LockGuardTimed(std::mutex& mtx, LockTiming& timing);
+    LockGuardTimed() = delete;
+    LockGuardTimed(LockGuardTimed const&) = delete;
+    ~LockGuardTimed();
+
+    LockGuardTimed& operator=(LockGuardTimed const&) = delete;
 
 private:
-    std::string _getString(std::string const& note);
-
-    std::string _label;
-    std::mutex _mtx;
-    std::vector<bucket> _buckets;
-    uint64_t _overMaxCount{0};
-    double _total{0.0};
-    uint64_t _totalCount{0};
+    std::mutex& _mtx;
+    LockTiming* _timing{nullptr}; ///< nullptr if this acquisition is not timed.
+    double _timeToLock{0.0};
+    Timer _timeHeld;
 };
 
 }}} // namespace lsst::qserv::util
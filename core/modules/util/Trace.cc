@@ -0,0 +1,170 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ *
+ */
+
+// Class header
+#include "util/Trace.h"
+
+// System headers
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.util.Trace");
+
+void writeJsonString(std::ostream& os, std::string const& str) {
+    os << '"';
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            os << '\\';
+        }
+        os << c;
+    }
+    os << '"';
+}
+
+} // namespace
+
+namespace lsst {
+namespace qserv {
+namespace util {
+
+std::mutex QueryTrace::_fileMtx;
+std::string QueryTrace::_traceFile;
+
+
+uint64_t traceNowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+
+QueryTrace::Ptr QueryTrace::sample(uint64_t queryId, unsigned sampleEvery) {
+    if (sampleEvery == 0 || queryId % sampleEvery != 0) {
+        return nullptr;
+    }
+    return std::make_shared<QueryTrace>(queryId);
+}
+
+
+void QueryTrace::add(std::string const& name, int jobId, int attempt,
+                     uint64_t startUs, uint64_t durationUs) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _spans.push_back(TraceSpan{name, jobId, attempt, startUs, durationUs});
+}
+
+
+std::vector<TraceSpan> QueryTrace::getSpans() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _spans;
+}
+
+
+std::map<std::string, QueryTrace::Total> QueryTrace::getBreakdown() const {
+    std::map<std::string, Total> totals;
+    std::lock_guard<std::mutex> lock(_mtx);
+    for (auto const& span : _spans) {
+        Total& total = totals[span.name];
+        ++total.count;
+        total.totalUs += span.durationUs;
+        if (span.durationUs > total.maxUs) {
+            total.maxUs = span.durationUs;
+        }
+    }
+    return totals;
+}
+
+
+std::string QueryTrace::breakdownStr() const {
+    std::ostringstream os;
+    os.setf(std::ios::fixed);
+    os.precision(3);
+    bool first = true;
+    for (auto const& elem : getBreakdown()) {
+        if (!first) {
+            os << " ";
+        }
+        first = false;
+        os << elem.first << "=" << elem.second.totalUs / 1000.0 << "ms/" << elem.second.count
+           << "/" << elem.second.maxUs / 1000.0 << "ms";
+    }
+    return os.str();
+}
+
+
+void QueryTrace::writeJson(std::ostream& os) const {
+    os << "{\"queryId\":" << _queryId << ",\"breakdown\":{";
+    bool first = true;
+    for (auto const& elem : getBreakdown()) {
+        if (!first) {
+            os << ",";
+        }
+        first = false;
+        writeJsonString(os, elem.first);
+        os << ":{\"count\":" << elem.second.count << ",\"totalUs\":" << elem.second.totalUs
+           << ",\"maxUs\":" << elem.second.maxUs << "}";
+    }
+    os << "},\"spans\":[";
+    first = true;
+    for (auto const& span : getSpans()) {
+        if (!first) {
+            os << ",";
+        }
+        first = false;
+        os << "{\"name\":";
+        writeJsonString(os, span.name);
+        os << ",\"jobId\":" << span.jobId << ",\"attempt\":" << span.attempt
+           << ",\"startUs\":" << span.startUs << ",\"durationUs\":" << span.durationUs << "}";
+    }
+    os << "]}";
+}
+
+
+void QueryTrace::setTraceFile(std::string const& path) {
+    std::lock_guard<std::mutex> lock(_fileMtx);
+    _traceFile = path;
+}
+
+
+void QueryTrace::writeTraceFile() const {
+    // Format outside the lock, only the append is serialized.
+    std::ostringstream os;
+    writeJson(os);
+    os << "\n";
+    std::lock_guard<std::mutex> lock(_fileMtx);
+    if (_traceFile.empty()) {
+        return;
+    }
+    std::ofstream out(_traceFile, std::ios::app);
+    out << os.str();
+    if (!out) {
+        LOGS(_log, LOG_LVL_WARN, "QueryTrace failed to append to " << _traceFile);
+    }
+}
+
+}}} // namespace lsst::qserv::util
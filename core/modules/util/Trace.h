@@ -0,0 +1,110 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ *
+ */
+#ifndef LSST_QSERV_UTIL_TRACE_H
+#define LSST_QSERV_UTIL_TRACE_H
+
+// System headers
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace lsst {
+namespace qserv {
+namespace util {
+
+/// @return microseconds since the epoch, comparable between hosts with
+///         synchronized clocks.
+uint64_t traceNowUs();
+
+/// Time spent in one stage of a user query, by one job attempt, or by the
+/// whole query when jobId is negative.
+struct TraceSpan {
+    std::string name;
+    int jobId;
+    int attempt;
+    uint64_t startUs;
+    uint64_t durationUs;
+};
+
+
+/// QueryTrace collects the spans of a sampled user query as it goes through
+/// the czar and the workers. The czar records its own stages, and the
+/// workers return theirs with the last result message of each job.
+class QueryTrace {
+public:
+    using Ptr = std::shared_ptr<QueryTrace>;
+
+    /// Time spent in a stage, summed over all the spans of that name.
+    struct Total {
+        unsigned count{0};
+        uint64_t totalUs{0};
+        uint64_t maxUs{0};
+    };
+
+    /// @return a trace for one query out of every 'sampleEvery', chosen by
+    ///         queryId, or nullptr. A 'sampleEvery' of 0 disables tracing.
+    static Ptr sample(uint64_t queryId, unsigned sampleEvery);
+
+    explicit QueryTrace(uint64_t queryId) : _queryId(queryId) {}
+    QueryTrace(QueryTrace const&) = delete;
+    QueryTrace& operator=(QueryTrace const&) = delete;
+
+    uint64_t getQueryId() const { return _queryId; }
+
+    void add(std::string const& name, int jobId, int attempt, uint64_t startUs, uint64_t durationUs);
+
+    std::vector<TraceSpan> getSpans() const;
+
+    /// @return the totals of each stage, by stage name.
+    std::map<std::string, Total> getBreakdown() const;
+
+    /// @return the breakdown as "name=total_ms/count/max_ms ..." for the log.
+    std::string breakdownStr() const;
+
+    /// Write the trace as one JSON object, on a single line.
+    void writeJson(std::ostream& os) const;
+
+    /// Append the traces of all queries to 'path', one JSON object per line.
+    /// An empty path, the default, leaves traces out of any file.
+    static void setTraceFile(std::string const& path);
+
+    /// Append this trace to the trace file, if there is one.
+    void writeTraceFile() const;
+
+private:
+    uint64_t const _queryId;
+    mutable std::mutex _mtx; ///< Protects _spans
+    std::vector<TraceSpan> _spans;
+
+    static std::mutex _fileMtx; ///< Protects _traceFile and appends to it
+    static std::string _traceFile;
+};
+
+}}} // namespace lsst::qserv::util
+
+#endif // LSST_QSERV_UTIL_TRACE_H
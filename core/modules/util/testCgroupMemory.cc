@@ -0,0 +1,95 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/**
+ *
+ * @brief test CgroupMemory
+ *
+ */
+
+// System headers
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+// Qserv headers
+#include "util/CgroupMemory.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE CgroupMemory
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+namespace util = lsst::qserv::util;
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(parseProcCgroup) {
+    BOOST_CHECK_EQUAL(util::CgroupMemory::parseProcCgroup("0::/system.slice/qserv.service\n"),
+                      "/system.slice/qserv.service");
+    BOOST_CHECK_EQUAL(util::CgroupMemory::parseProcCgroup("12:memory:/user\n0::/\n"), "/");
+    BOOST_CHECK_EQUAL(util::CgroupMemory::parseProcCgroup("12:memory:/user\n"), "");
+    BOOST_CHECK_EQUAL(util::CgroupMemory::parseProcCgroup(""), "");
+}
+
+BOOST_AUTO_TEST_CASE(parsePressure) {
+    std::string pressure = "some avg10=12.50 avg60=3.00 avg300=1.00 total=1234\n"
+                           "full avg10=2.00 avg60=1.00 avg300=0.50 total=567\n";
+    BOOST_CHECK_CLOSE(util::CgroupMemory::parsePressureAvg10(pressure), 12.5, 0.001);
+    BOOST_CHECK_LT(util::CgroupMemory::parsePressureAvg10("full avg10=2.00\n"), 0.0);
+    BOOST_CHECK_LT(util::CgroupMemory::parsePressureAvg10("some avg10=x\n"), 0.0);
+    BOOST_CHECK_EQUAL(util::CgroupMemory::parseBytes("1073741824\n"), 1073741824ULL);
+    BOOST_CHECK_EQUAL(util::CgroupMemory::parseBytes("max\n"), 0ULL);
+}
+
+/** @test
+ * Usage is read from the files of a cgroup directory, a missing limit or
+ * pressure file reads as unlimited and no pressure.
+ */
+BOOST_AUTO_TEST_CASE(read) {
+    char dirTemplate[] = "/tmp/testCgroupMemoryXXXXXX";
+    std::string dir = mkdtemp(dirTemplate);
+    BOOST_CHECK(!util::CgroupMemory(dir).read().valid);
+    BOOST_CHECK(!util::CgroupMemory("").read().valid);
+
+    std::ofstream(dir + "/memory.current") << "2000\n";
+    auto usage = util::CgroupMemory(dir).read();
+    BOOST_CHECK(usage.valid);
+    BOOST_CHECK_EQUAL(usage.current, 2000U);
+    BOOST_CHECK_EQUAL(usage.max, 0U);
+    BOOST_CHECK_EQUAL(usage.someAvg10, 0.0);
+
+    std::ofstream(dir + "/memory.max") << "5000\n";
+    std::ofstream(dir + "/memory.pressure") << "some avg10=40.00 avg60=0.00 avg300=0.00 total=9\n";
+    usage = util::CgroupMemory(dir).read();
+    BOOST_CHECK_EQUAL(usage.max, 5000U);
+    BOOST_CHECK_CLOSE(usage.someAvg10, 40.0, 0.001);
+
+    for (auto name : {"/memory.current", "/memory.max", "/memory.pressure"}) {
+        std::remove((dir + name).c_str());
+    }
+    rmdir(dir.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -261,6 +261,30 @@ BOOST_AUTO_TEST_CASE(EventThreadTest) {
 }
 
 
+BOOST_AUTO_TEST_CASE(SpinningQueueTest) {
+    LOGS_DEBUG("SpinningQueue test");
+
+    // Commands are queued in bursts while threads spin and sleep on the
+    // queue, each woken thread must take its command and none may be lost.
+    auto cmdQueue = std::make_shared<CommandQueue>(1000);
+    auto pool = ThreadPool::newThreadPool(8, cmdQueue);
+    std::atomic<int> sum{0};
+    int total = 0;
+    for (int burst = 0; burst < 50; ++burst) {
+        for (int j = 1; j < 20; ++j) {
+            cmdQueue->queCmd(std::make_shared<Command>([&sum, j](CmdData*){ sum += j; }));
+            total += j;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    for (int j = 0; j < 100 && (sum != total || cmdQueue->size() > 0); ++j) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    BOOST_CHECK_EQUAL(sum, total);
+    pool->shutdownPool();
+}
+
+
 BOOST_AUTO_TEST_CASE(InstanceCountTest) {
 
     struct CA {
@@ -290,6 +314,15 @@ BOOST_AUTO_TEST_CASE(InstanceCountTest) {
     BOOST_CHECK(cb.instanceCount.getCount() == 1);
     CA ca0;
     BOOST_CHECK(ca0.instanceCount.getCount() == 1);
+
+    // A name built at run time counts with the literal of the same name.
+    InstanceCount named(std::string("C") + "A");
+    BOOST_CHECK(ca0.instanceCount.getCount() == 2);
+    std::thread thrd([]() { CA ca; BOOST_CHECK(ca.instanceCount.getCount() == 3); });
+    thrd.join();
+    named = cb.instanceCount;
+    BOOST_CHECK(ca0.instanceCount.getCount() == 1);
+    BOOST_CHECK(cb.instanceCount.getCount() == 2);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
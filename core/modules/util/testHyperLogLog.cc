@@ -0,0 +1,99 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/**
+ *
+ * @brief test HyperLogLog
+ *
+ */
+
+// System headers
+#include <cstdint>
+#include <string>
+
+// Qserv headers
+#include "util/HyperLogLog.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE HyperLogLog
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+namespace util = lsst::qserv::util;
+
+namespace {
+
+void addRange(util::HyperLogLog& hll, int64_t begin, int64_t end) {
+    for (int64_t j = begin; j < end; ++j) {
+        hll.add(&j, sizeof(j));
+    }
+}
+
+} // annonymous namespace
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(Estimate) {
+    util::HyperLogLog hll;
+    BOOST_CHECK_EQUAL(hll.estimate(), 0.0);
+    addRange(hll, 0, 100);
+    BOOST_CHECK_CLOSE(hll.estimate(), 100.0, 5.0);
+    // Duplicates don't count.
+    addRange(hll, 0, 100);
+    BOOST_CHECK_CLOSE(hll.estimate(), 100.0, 5.0);
+    addRange(hll, 100, 100000);
+    BOOST_CHECK_CLOSE(hll.estimate(), 100000.0, 5.0);
+}
+
+/** @test
+ * The merge of the sketches of overlapping sets estimates their union.
+ */
+BOOST_AUTO_TEST_CASE(Merge) {
+    util::HyperLogLog a;
+    util::HyperLogLog b;
+    addRange(a, 0, 60000);
+    addRange(b, 40000, 100000);
+    BOOST_CHECK(a.merge(b));
+    BOOST_CHECK_CLOSE(a.estimate(), 100000.0, 5.0);
+
+    util::HyperLogLog other(10);
+    BOOST_CHECK(!a.merge(other));
+}
+
+BOOST_AUTO_TEST_CASE(Serialize) {
+    util::HyperLogLog a;
+    addRange(a, 0, 5000);
+    std::string const str = a.serialize();
+    BOOST_CHECK_EQUAL(str.size(), 4097U);
+    BOOST_CHECK(util::HyperLogLog::isSketch(str.data(), str.size()));
+    BOOST_CHECK(!util::HyperLogLog::isSketch(str.data(), str.size() - 1));
+
+    util::HyperLogLog b;
+    addRange(b, 5000, 10000);
+    BOOST_CHECK(b.merge(str.data(), str.size()));
+    BOOST_CHECK_CLOSE(b.estimate(), 10000.0, 5.0);
+    BOOST_CHECK(!b.merge(str.data(), 10));
+    BOOST_CHECK_EQUAL(b.serialize().substr(0, 1), std::string(1, '\x0c'));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
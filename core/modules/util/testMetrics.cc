@@ -0,0 +1,164 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/**
+ *
+ * @brief test Metrics
+ *
+ */
+
+// System headers
+#include <sstream>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Qserv headers
+#include "util/Metrics.h"
+#include "util/Timer.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE Metrics
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+namespace util = lsst::qserv::util;
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+/** @test
+ * Updates from many threads land on different shards and all add up.
+ */
+BOOST_AUTO_TEST_CASE(counterThreads) {
+    util::Counter counter;
+    util::Histogram histo({1, 10});
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 20; ++t) {
+        threads.emplace_back([&counter, &histo]() {
+            for (int j = 0; j < 1000; ++j) {
+                counter.add();
+                histo.observe(j % 20);
+            }
+        });
+    }
+    for (auto& thrd : threads) {
+        thrd.join();
+    }
+    BOOST_CHECK_EQUAL(counter.value(), 20000U);
+    auto snap = histo.snapshot();
+    BOOST_CHECK_EQUAL(snap.count, 20000U);
+    BOOST_REQUIRE_EQUAL(snap.counts.size(), 3U);
+    BOOST_CHECK_EQUAL(snap.counts[0], 2000U);  // 0 and 1
+    BOOST_CHECK_EQUAL(snap.counts[1], 9000U);  // 2 to 10
+    BOOST_CHECK_EQUAL(snap.counts[2], 9000U);  // 11 to 19
+    BOOST_CHECK_CLOSE(snap.sum, 20.0*50*190, 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(exponentialBounds) {
+    auto bounds = util::Histogram::exponentialBounds(0.001, 10, 4);
+    BOOST_REQUIRE_EQUAL(bounds.size(), 4U);
+    BOOST_CHECK_CLOSE(bounds[0], 0.001, 1e-9);
+    BOOST_CHECK_CLOSE(bounds[3], 1.0, 1e-9);
+}
+
+/** @test
+ * The registry returns the same metric for a name and writes the
+ * Prometheus text format, collectors last.
+ */
+BOOST_AUTO_TEST_CASE(registryWrite) {
+    util::MetricsRegistry registry;
+    auto requests = registry.counter("test_requests_total", "Requests served");
+    BOOST_CHECK(registry.counter("test_requests_total", "") == requests);
+    BOOST_CHECK_THROW(registry.gauge("test_requests_total", ""), std::invalid_argument);
+    requests->add(3);
+    registry.gauge("test_open", "Open connections")->set(-2);
+    auto histo = registry.histogram("test_wait_seconds", "Wait time", {0.5, 1});
+    histo->observe(0.5);
+    histo->observe(2);
+    registry.addCollector("extra", [](std::ostream& os) {
+        util::MetricsRegistry::writeHeader(os, "test_queued", "gauge", "Queued tasks");
+        util::MetricsRegistry::writeValue(os, "test_queued",
+                "scheduler=\"" + util::MetricsRegistry::escapeLabel("a\"b") + "\"", 4);
+    });
+
+    std::ostringstream os;
+    registry.write(os);
+    std::string const expected =
+        "# HELP test_open Open connections\n"
+        "# TYPE test_open gauge\n"
+        "test_open -2\n"
+        "# HELP test_requests_total Requests served\n"
+        "# TYPE test_requests_total counter\n"
+        "test_requests_total 3\n"
+        "# HELP test_wait_seconds Wait time\n"
+        "# TYPE test_wait_seconds histogram\n"
+        "test_wait_seconds_bucket{le=\"0.5\"} 1\n"
+        "test_wait_seconds_bucket{le=\"1\"} 1\n"
+        "test_wait_seconds_bucket{le=\"+Inf\"} 2\n"
+        "test_wait_seconds_sum 2.5\n"
+        "test_wait_seconds_count 2\n"
+        "# HELP test_queued Queued tasks\n"
+        "# TYPE test_queued gauge\n"
+        "test_queued{scheduler=\"a\\\"b\"} 4\n";
+    BOOST_CHECK_EQUAL(os.str(), expected);
+
+    registry.removeCollector("extra");
+    std::ostringstream os2;
+    registry.write(os2);
+    BOOST_CHECK(os2.str().find("test_queued") == std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(timer) {
+    for (bool coarse : {false, true}) {
+        util::Timer timer(coarse);
+        timer.start();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        timer.stop();
+        BOOST_CHECK_GE(timer.getElapsed(), 0.015);
+        BOOST_CHECK_LT(timer.getElapsed(), 5.0);
+    }
+}
+
+/** @test
+ * Only one in 'sampleEvery' acquisitions of a thread is timed.
+ */
+BOOST_AUTO_TEST_CASE(lockTimingSample) {
+    std::mutex mtx;
+    util::LockTiming timing("test_sample", 4);
+    for (int j = 0; j < 40; ++j) {
+        util::LockGuardTimed guard(mtx, timing);
+    }
+    auto& registry = util::MetricsRegistry::get();
+    BOOST_CHECK_EQUAL(registry.histogram("qserv_lock_test_sample_wait_seconds", "", {})->snapshot().count, 10U);
+    BOOST_CHECK_EQUAL(registry.histogram("qserv_lock_test_sample_held_seconds", "", {})->snapshot().count, 10U);
+
+    util::LockTiming never("test_never", 0);
+    for (int j = 0; j < 10; ++j) {
+        util::LockGuardTimed guard(mtx, never);
+    }
+    BOOST_CHECK_EQUAL(registry.histogram("qserv_lock_test_never_wait_seconds", "", {})->snapshot().count, 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
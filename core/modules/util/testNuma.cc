@@ -0,0 +1,78 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/**
+ *
+ * @brief test Numa
+ *
+ */
+
+// System headers
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "util/Numa.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE Numa
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+namespace util = lsst::qserv::util;
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(parseCpuList) {
+    std::vector<int> cpus = util::Numa::parseCpuList("0-3,8,10-11");
+    std::vector<int> expected{0, 1, 2, 3, 8, 10, 11};
+    BOOST_CHECK_EQUAL_COLLECTIONS(cpus.begin(), cpus.end(), expected.begin(), expected.end());
+    BOOST_CHECK(util::Numa::parseCpuList("").empty());
+    BOOST_CHECK(util::Numa::parseCpuList("3-1").empty());
+    BOOST_CHECK(util::Numa::parseCpuList("1,x").empty());
+    BOOST_CHECK(util::Numa::parseCpuList("2-").empty());
+}
+
+/** @test
+ * Chunks are only spread over the nodes once placement is enabled on a host
+ * with several nodes.
+ */
+BOOST_AUTO_TEST_CASE(nodeForChunk) {
+    util::Numa single({{0, 1}});
+    single.setEnabled(true);
+    BOOST_CHECK(!single.isEnabled());
+    BOOST_CHECK_EQUAL(single.nodeForChunk(7), -1);
+
+    util::Numa dual({{0, 1}, {2, 3}});
+    BOOST_CHECK(!dual.isEnabled());
+    BOOST_CHECK_EQUAL(dual.nodeForChunk(7), -1);
+    dual.setEnabled(true);
+    BOOST_CHECK(dual.isEnabled());
+    BOOST_CHECK_EQUAL(dual.nodeCount(), 2);
+    BOOST_CHECK_EQUAL(dual.nodeForChunk(7), 1);
+    BOOST_CHECK_EQUAL(dual.nodeForChunk(8), 0);
+    BOOST_CHECK_EQUAL(dual.nodeForChunk(-1), -1);
+    BOOST_CHECK(!dual.placeMemory(nullptr, 0, 0));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
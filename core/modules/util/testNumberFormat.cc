@@ -0,0 +1,95 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/**
+ *
+ * @brief test NumberFormat
+ *
+ */
+
+// System headers
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <string>
+
+// Qserv headers
+#include "util/NumberFormat.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE NumberFormat
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+namespace util = lsst::qserv::util;
+
+namespace {
+
+std::string fmtInt(int64_t val) {
+    char buf[util::NumberFormat::BUFFER_SIZE];
+    size_t n = util::NumberFormat::formatInt(val, buf);
+    return std::string(buf, n);
+}
+
+std::string fmtDouble(double val) {
+    char buf[util::NumberFormat::BUFFER_SIZE];
+    size_t n = util::NumberFormat::formatDouble(val, buf);
+    return std::string(buf, n);
+}
+
+std::string fmtFloat(float val) {
+    char buf[util::NumberFormat::BUFFER_SIZE];
+    size_t n = util::NumberFormat::formatFloat(val, buf);
+    return std::string(buf, n);
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(integers) {
+    BOOST_CHECK_EQUAL(fmtInt(0), "0");
+    BOOST_CHECK_EQUAL(fmtInt(-42), "-42");
+    BOOST_CHECK_EQUAL(fmtInt(std::numeric_limits<int64_t>::min()), "-9223372036854775808");
+    char buf[util::NumberFormat::BUFFER_SIZE];
+    util::NumberFormat::formatUInt(std::numeric_limits<uint64_t>::max(), buf);
+    BOOST_CHECK_EQUAL(std::string(buf), "18446744073709551615");
+}
+
+/** @test
+ * Values read back exactly, with MySQL's exponent form.
+ */
+BOOST_AUTO_TEST_CASE(reals) {
+    BOOST_CHECK_EQUAL(fmtDouble(0.1), "0.1");
+    BOOST_CHECK_EQUAL(fmtDouble(-2.5), "-2.5");
+    BOOST_CHECK_EQUAL(fmtDouble(1e-5), "1e-5");
+    BOOST_CHECK_EQUAL(fmtDouble(1.5e300), "1.5e300");
+    BOOST_CHECK_EQUAL(fmtFloat(0.1f), "0.1");
+    BOOST_CHECK_EQUAL(fmtFloat(3e38f), "3e38");
+    double const third = 1.0 / 3.0;
+    BOOST_CHECK_EQUAL(std::strtod(fmtDouble(third).c_str(), nullptr), third);
+    float const f = 16777217.0f;
+    BOOST_CHECK_EQUAL(std::strtof(fmtFloat(f).c_str(), nullptr), f);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,108 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/**
+ *
+ * @brief test Profiler
+ *
+ */
+
+// System headers
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <thread>
+
+// Qserv headers
+#include "util/Profiler.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE Profiler
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+namespace util = lsst::qserv::util;
+
+namespace {
+
+std::atomic<bool> spinning{true};
+double volatile sink = 0;
+
+void spin() {
+    util::ThreadRole role("spinner");
+    double x = 0;
+    while (spinning) {
+        for (int i = 0; i < 1000; ++i) x += std::sqrt(i);
+    }
+    sink = x;
+}
+
+} // annonymous namespace
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+/** @test
+ * The samples of a busy thread are reported under its role.
+ */
+BOOST_AUTO_TEST_CASE(folded) {
+    std::thread spinner(spin);
+    std::string folded;
+    std::string error;
+    std::thread other([&error]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        std::string out;
+        BOOST_CHECK(!util::Profiler::profile(std::chrono::milliseconds(10), 100, out, error));
+    });
+    bool const ok = util::Profiler::profile(std::chrono::milliseconds(500), 200, folded, error);
+    other.join();
+    spinning = false;
+    spinner.join();
+    BOOST_REQUIRE(ok);
+    BOOST_CHECK_EQUAL(error, "a profile is already running");
+
+    int spinnerSamples = 0;
+    std::istringstream is(folded);
+    std::string line;
+    while (std::getline(is, line)) {
+        auto const pos = line.rfind(' ');
+        BOOST_REQUIRE(pos != std::string::npos);
+        if (line.compare(0, 8, "spinner;") == 0) {
+            spinnerSamples += std::stoi(line.substr(pos + 1));
+        }
+    }
+    // 100 expected, the timer is coarse on loaded machines.
+    BOOST_CHECK_GT(spinnerSamples, 20);
+}
+
+BOOST_AUTO_TEST_CASE(role) {
+    BOOST_CHECK(util::Profiler::setThreadRole("a") == nullptr);
+    {
+        util::ThreadRole role("b");
+        BOOST_CHECK_EQUAL(util::Profiler::setThreadRole("c"), "b");
+    }
+    BOOST_CHECK_EQUAL(util::Profiler::setThreadRole(nullptr), "a");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
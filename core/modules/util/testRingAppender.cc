@@ -0,0 +1,134 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/**
+ *
+ * @brief test RingAppender
+ *
+ */
+
+// System headers
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+// Third-party headers
+#include <log4cxx/helpers/pool.h>
+#include <log4cxx/logger.h>
+#include <log4cxx/patternlayout.h>
+
+// Qserv headers
+#include "util/RingAppender.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE RingAppender
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+namespace util = lsst::qserv::util;
+
+namespace {
+
+/// @return the lines of file 'fileName'.
+std::vector<std::string> readLines(std::string const& fileName) {
+    std::vector<std::string> lines;
+    std::ifstream in(fileName);
+    std::string line;
+    while (std::getline(in, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+struct Fixture {
+    Fixture() : fileName("/tmp/testRingAppender." + std::to_string(::getpid())) {
+        std::remove(fileName.c_str());
+        appender = new util::RingAppender();
+        appender->setFile(fileName);
+        appender->setLayout(new log4cxx::PatternLayout(LOG4CXX_STR("%m%n")));
+        logger = log4cxx::Logger::getLogger("lsst.qserv.util.testRingAppender");
+        logger->setAdditivity(false);
+        logger->addAppender(appender);
+    }
+
+    ~Fixture() {
+        logger->removeAllAppenders();
+        std::remove(fileName.c_str());
+    }
+
+    std::string fileName;
+    log4cxx::helpers::Pool pool;
+    log4cxx::helpers::ObjectPtrT<util::RingAppender> appender;
+    log4cxx::LoggerPtr logger;
+};
+
+} // annonymous namespace
+
+BOOST_FIXTURE_TEST_SUITE(Suite, Fixture)
+
+/** @test
+ * Records are written in order by the background thread.
+ */
+BOOST_AUTO_TEST_CASE(Written) {
+    appender->setRateLimit(0);
+    appender->activateOptions(pool);
+    for (int j = 0; j < 100; ++j) {
+        LOG4CXX_INFO(logger, "record " << j);
+    }
+    appender->flush();
+    auto lines = readLines(fileName);
+    BOOST_REQUIRE_EQUAL(lines.size(), 100U);
+    BOOST_CHECK_EQUAL(lines[0], "record 0");
+    BOOST_CHECK_EQUAL(lines[99], "record 99");
+}
+
+/** @test
+ * A call site logging over the rate limit has its records dropped and counted.
+ */
+BOOST_AUTO_TEST_CASE(RateLimited) {
+    appender->setRateLimit(10);
+    appender->activateOptions(pool);
+    uint64_t const dropped = util::RingAppender::getDropped();
+    for (int j = 0; j < 1000; ++j) {
+        LOG4CXX_INFO(logger, "record " << j);
+    }
+    LOG4CXX_INFO(logger, "other site");
+    appender->close();
+    auto lines = readLines(fileName);
+    // Some records may be let through as the bucket refills during the loop.
+    BOOST_CHECK_GE(util::RingAppender::getDropped() - dropped, 900U);
+    BOOST_REQUIRE_GE(lines.size(), 12U);
+    BOOST_CHECK_EQUAL(lines[0], "record 0");
+    int otherSite = 0;
+    int droppedLines = 0;
+    for (auto const& line : lines) {
+        if (line == "other site") ++otherSite;
+        if (line.find("RingAppender dropped") == 0) ++droppedLines;
+    }
+    BOOST_CHECK_EQUAL(otherSite, 1);
+    BOOST_CHECK_GE(droppedLines, 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,66 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/**
+ *
+ * @brief test StringHash
+ *
+ */
+
+// System headers
+#include <string>
+
+// Qserv headers
+#include "util/StringHash.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE StringHash
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+namespace util = lsst::qserv::util;
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(md5Hex) {
+    std::string s("abc");
+    BOOST_CHECK_EQUAL(util::StringHash::getMd5Hex(s.data(), s.size()), "900150983cd24fb0d6963f7d28e17f72");
+}
+
+/** @test
+ * Check CRC-32C against the standard check value, including
+ * a checksum computed in pieces and buffers of odd length.
+ */
+BOOST_AUTO_TEST_CASE(crc32c) {
+    std::string s("123456789");
+    BOOST_CHECK_EQUAL(util::StringHash::getCrc32c(s.data(), s.size()), 0xE3069283u);
+    BOOST_CHECK_EQUAL(util::StringHash::getCrc32c(s.data(), 0), 0u);
+    uint32_t crc = util::StringHash::getCrc32c(s.data(), 5);
+    crc = util::StringHash::getCrc32c(s.data() + 5, s.size() - 5, crc);
+    BOOST_CHECK_EQUAL(crc, 0xE3069283u);
+
+    std::string zeros(32, '\0');
+    BOOST_CHECK_EQUAL(util::StringHash::getCrc32c(zeros.data(), zeros.size()), 0x8A9136AAu);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,129 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/**
+ *
+ * @brief test QueryTrace
+ *
+ */
+
+// System headers
+#include <cstdio>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Qserv headers
+#include "util/Trace.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE Trace
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+namespace util = lsst::qserv::util;
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+/** @test
+ * One query out of every sampleEvery is traced, none with 0.
+ */
+BOOST_AUTO_TEST_CASE(sample) {
+    BOOST_CHECK(util::QueryTrace::sample(30, 0) == nullptr);
+    BOOST_CHECK(util::QueryTrace::sample(31, 10) == nullptr);
+    auto trace = util::QueryTrace::sample(30, 10);
+    BOOST_REQUIRE(trace != nullptr);
+    BOOST_CHECK_EQUAL(trace->getQueryId(), 30u);
+    BOOST_CHECK(util::QueryTrace::sample(31, 1) != nullptr);
+}
+
+/** @test
+ * Spans added from several threads are all kept, and summed by stage.
+ */
+BOOST_AUTO_TEST_CASE(breakdown) {
+    util::QueryTrace trace(7);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&trace, t]() {
+            for (int j = 0; j < 100; ++j) {
+                trace.add("mysql", j, 0, 1000, 10 + t);
+                trace.add("merge", j, 0, 2000, 2);
+            }
+        });
+    }
+    for (auto& thrd : threads) {
+        thrd.join();
+    }
+    trace.add("parse", -1, 0, 0, 500);
+
+    BOOST_CHECK_EQUAL(trace.getSpans().size(), 801u);
+    auto const totals = trace.getBreakdown();
+    BOOST_REQUIRE_EQUAL(totals.size(), 3u);
+    auto const& mysql = totals.at("mysql");
+    BOOST_CHECK_EQUAL(mysql.count, 400u);
+    BOOST_CHECK_EQUAL(mysql.totalUs, 100u * (10 + 11 + 12 + 13));
+    BOOST_CHECK_EQUAL(mysql.maxUs, 13u);
+    BOOST_CHECK_EQUAL(totals.at("merge").totalUs, 800u);
+    BOOST_CHECK_EQUAL(totals.at("parse").count, 1u);
+    BOOST_CHECK_EQUAL(trace.breakdownStr(),
+                      "merge=0.800ms/400/0.002ms mysql=4.600ms/400/0.013ms parse=0.500ms/1/0.500ms");
+}
+
+/** @test
+ * Traces are appended to the trace file as one JSON object per line.
+ */
+BOOST_AUTO_TEST_CASE(traceFile) {
+    util::QueryTrace trace(12);
+    trace.add("worker_queue", 3, 1, 100, 25);
+
+    std::ostringstream os;
+    trace.writeJson(os);
+    BOOST_CHECK_EQUAL(os.str(),
+        "{\"queryId\":12,\"breakdown\":{\"worker_queue\":{\"count\":1,\"totalUs\":25,\"maxUs\":25}},"
+        "\"spans\":[{\"name\":\"worker_queue\",\"jobId\":3,\"attempt\":1,\"startUs\":100,\"durationUs\":25}]}");
+
+    // Nothing is written without a trace file.
+    trace.writeTraceFile();
+
+    std::string const path = "/tmp/qserv-testTrace-" + std::to_string(::getpid()) + ".json";
+    std::remove(path.c_str());
+    util::QueryTrace::setTraceFile(path);
+    trace.writeTraceFile();
+    trace.writeTraceFile();
+    util::QueryTrace::setTraceFile("");
+
+    std::ifstream in(path);
+    std::string line;
+    int lines = 0;
+    while (std::getline(in, line)) {
+        BOOST_CHECK_EQUAL(line, os.str());
+        ++lines;
+    }
+    BOOST_CHECK_EQUAL(lines, 2);
+    std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
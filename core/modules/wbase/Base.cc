@@ -98,6 +98,31 @@ std::string const CLEANUP_SUBCHUNK_SCRIPT =
 //    "DROP TABLE IF EXISTS " + SUBCHUNKDB_PREFIX_STR + "%1%_%3%.%2%SelfOverlap_%3%_%4%;"
     "DROP TABLE IF EXISTS " + SUBCHUNKDB_PREFIX_STR + "%1%_%3%.%2%FullOverlap_%3%_%4%;";
 
+// Subchunks of chunk tables stored ordered by subchunk are read in place.
+// The views are merged into the queries, which read the range of rows of
+// the subchunk through the index on the subchunk column.
+// Parameters:
+// %1% database (e.g., LSST)
+// %2% table (e.g., Object)
+// %3% subchunk column name (e.g. x_subChunkId)
+// %4% chunkId (e.g. 2523)
+// %5% subChunkId (e.g., 34)
+std::string const CREATE_SUBCHUNK_VIEW_SCRIPT =
+    "CREATE DATABASE IF NOT EXISTS " + SUBCHUNKDB_PREFIX_STR + "%1%_%4%;"
+    "CREATE OR REPLACE ALGORITHM = MERGE VIEW " + SUBCHUNKDB_PREFIX_STR + "%1%_%4%.%2%_%4%_%5% "
+    "AS SELECT * FROM %1%.%2%_%4% WHERE %3% = %5%;"
+    "CREATE OR REPLACE ALGORITHM = MERGE VIEW " + SUBCHUNKDB_PREFIX_STR + "%1%_%4%.%2%FullOverlap_%4%_%5% "
+    "AS SELECT * FROM %1%.%2%FullOverlap_%4% WHERE %3% = %5%;";
+
+// Parameters:
+// %1% database (e.g., LSST)
+// %2% table (e.g., Object)
+// %3% chunkId (e.g. 2523)
+// %4% subChunkId (e.g., 34)
+std::string const CLEANUP_SUBCHUNK_VIEW_SCRIPT =
+    "DROP VIEW IF EXISTS " + SUBCHUNKDB_PREFIX_STR + "%1%_%3%.%2%_%3%_%4%;"
+    "DROP VIEW IF EXISTS " + SUBCHUNKDB_PREFIX_STR + "%1%_%3%.%2%FullOverlap_%3%_%4%;";
+
 // Parameters:
 // %1% database (e.g., LSST)
 // %2% table (e.g., Object)
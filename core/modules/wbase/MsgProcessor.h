@@ -29,6 +29,7 @@
 #include <memory>
 
 // Qserv headers
+#include "global/intTypes.h"
 
 // Forward declarations
 namespace lsst {
@@ -54,6 +55,10 @@ struct MsgProcessor {
 
     /// Process a managememt command
     virtual void processCommand(std::shared_ptr<wbase::WorkerCommand> const& command) = 0;
+
+    /// Cancel all the tasks of a user query, queued or running
+    /// @return the number of tasks that were cancelled
+    virtual int cancelQuery(QueryId qId) = 0;
 };
 
 }}} // namespace lsst::qserv::wbase
@@ -155,7 +155,7 @@ bool SendChannel::sendError(std::string const& msg, int code) {
 
 
 bool SendChannel::sendFile(int fd, Size fSize) {
-    if (_ssiRequest->replyFile(fSize, fd)) return true;
+    if (_ssiRequest->replyFile(fd, fSize, _release)) return true;
     release();
     return false;
 }
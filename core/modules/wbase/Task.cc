@@ -32,16 +32,19 @@
 #include "wbase/Task.h"
 
 // Third-party headers
+#include "boost/algorithm/string/replace.hpp"
 #include "boost/regex.hpp"
 
 // LSST headers
 #include "lsst/log/Log.h"
 
 // Qserv headers
+#include "global/constants.h"
 #include "proto/TaskMsgDigest.h"
 #include "proto/worker.pb.h"
 #include "wbase/Base.h"
 #include "wbase/SendChannel.h"
+#include "wbase/TaskFold.h"
 
 namespace {
 
@@ -86,6 +89,57 @@ bool Task::ChunkIdGreater::operator()(Task::Ptr const& x, Task::Ptr const& y) {
 }
 
 
+std::mutex TaskShared::_mtx;
+std::map<TaskShared::Key, std::weak_ptr<TaskShared const>> TaskShared::_registry;
+size_t TaskShared::_nextSweep = 64;
+
+
+TaskShared::Ptr TaskShared::get(proto::TaskMsg const& msg) {
+    auto shared = std::make_shared<TaskShared>();
+    shared->queryTemplates.assign(msg.querytemplate().begin(), msg.querytemplate().end());
+    for (auto const& scanTbl : msg.scantable()) {
+        shared->scanInfo.infoTables.push_back(proto::ScanTableInfo(scanTbl));
+    }
+    shared->scanInfo.scanRating = msg.scanpriority();
+    shared->scanInfo.sortTablesSlowestFirst();
+    shared->scanInfo.access = static_cast<proto::ScanInfo::Access>(msg.scanaccess());
+    for (auto const& scanTbl : msg.indextable()) {
+        shared->scanInfo.indexTables.push_back(proto::ScanTableInfo(scanTbl));
+    }
+
+    std::lock_guard<std::mutex> lock(_mtx);
+    auto& entry = _registry[Key(msg.czarid(), msg.queryid())];
+    auto existing = entry.lock();
+    if (existing != nullptr && existing->_sameAs(*shared)) {
+        return existing;
+    }
+    entry = shared;
+    if (_registry.size() >= _nextSweep) {
+        for (auto itr = _registry.begin(); itr != _registry.end();) {
+            itr = itr->second.expired() ? _registry.erase(itr) : std::next(itr);
+        }
+        _nextSweep = 2 * _registry.size() + 64;
+    }
+    return shared;
+}
+
+
+bool TaskShared::_sameAs(TaskShared const& other) const {
+    auto sameTable = [](proto::ScanTableInfo const& a, proto::ScanTableInfo const& b) {
+        return a.db == b.db && a.table == b.table && a.lockInMemory == b.lockInMemory
+               && a.scanRating == b.scanRating;
+    };
+    return queryTemplates == other.queryTemplates && scanInfo.scanRating == other.scanInfo.scanRating
+           && scanInfo.access == other.scanInfo.access
+           && scanInfo.infoTables.size() == other.scanInfo.infoTables.size()
+           && std::equal(scanInfo.infoTables.begin(), scanInfo.infoTables.end(),
+                         other.scanInfo.infoTables.begin(), sameTable)
+           && scanInfo.indexTables.size() == other.scanInfo.indexTables.size()
+           && std::equal(scanInfo.indexTables.begin(), scanInfo.indexTables.end(),
+                         other.scanInfo.indexTables.begin(), sameTable);
+}
+
+
 std::string const Task::defaultUser = "qsmaster";
 IdSet Task::allIds{};
 
@@ -95,11 +149,25 @@ IdSet Task::allIds{};
 /// available to define the action to take when this task is run, so
 /// Command::setFunc() is used set the action later. This is why
 /// the util::CommandThreadPool is not called here.
+///
+/// The task keeps a compact copy of 't': the query templates and scan tables
+/// go to the TaskShared of the user query, and a message decoded on an arena
+/// is copied off it, the arena being sized for a whole decoded request.
 Task::Task(Task::TaskMsgPtr const& t, SendChannel::Ptr const& sc)
-    : msg(t), sendChannel(sc),
+    : sendChannel(sc),
       _qId(t->queryid()), _jId(t->jobid()), _attemptCount(t->attemptcount()),
+      _czarId(t->czarid()),
       _idStr(QueryIdHelper::makeIdStr(_qId, _jId)) {
     hash = hashTaskMsg(*t);
+    _shared = TaskShared::get(*t);
+    if (t->GetArena() != nullptr) {
+        msg = std::make_shared<proto::TaskMsg>(*t);
+    } else {
+        msg = t;
+    }
+    msg->clear_querytemplate();
+    msg->clear_scantable();
+    msg->clear_indextable();
 
     if (t->has_user()) {
         user = t->user();
@@ -111,17 +179,17 @@ Task::Task(Task::TaskMsgPtr const& t, SendChannel::Ptr const& sc)
     allIds.add(std::to_string(_qId) + "_" + std::to_string(_jId));
     LOGS(_log, LOG_LVL_DEBUG, "Task(...) " << _idStr << " this=" << this << " : " << allIds);
 
-    // Determine which major tables this task will use.
-    int const size = msg->scantable_size();
-    for(int j=0; j < size; ++j) {
-        _scanInfo.infoTables.push_back(proto::ScanTableInfo(msg->scantable(j)));
-    }
-    _scanInfo.scanRating = msg->scanpriority();
-    _scanInfo.sortTablesSlowestFirst();
     _scanInteractive = msg->scaninteractive();
+    // The deadline is counted from the arrival on this worker, so that the
+    // clocks of the czar and the worker need not agree.
+    if (msg->deadlinems() > 0) {
+        _deadlineBudget = std::chrono::milliseconds(msg->deadlinems());
+        _deadline = std::chrono::system_clock::now() + _deadlineBudget;
+    }
 }
 
 Task::~Task() {
+    leaveFold(nullptr);
     allIds.remove(std::to_string(_qId) + "_" + std::to_string(_jId));
     LOGS(_log, LOG_LVL_DEBUG, "~Task() " << _idStr << ": " << allIds);
 }
@@ -136,6 +204,31 @@ int Task::getChunkId() {
 }
 
 
+void Task::expandMsg() {
+    std::call_once(_expandOnce, [this]() {
+        for (auto const& tbl : _shared->scanInfo.infoTables) {
+            tbl.copyToScanTable(msg->add_scantable());
+        }
+        for (auto const& tbl : _shared->scanInfo.indexTables) {
+            tbl.copyToScanTable(msg->add_indextable());
+        }
+        if (_shared->queryTemplates.empty()) {
+            return;
+        }
+        std::string const chunkStr = std::to_string(msg->chunkid());
+        for (int j = 0; j < msg->fragment_size(); ++j) {
+            proto::TaskMsg_Fragment* frag = msg->mutable_fragment(j);
+            if (frag->query_size() > 0) {
+                continue;
+            }
+            for (auto const& qTemplate : _shared->queryTemplates) {
+                frag->add_query(boost::algorithm::replace_all_copy(qTemplate, CHUNK_TAG, chunkStr));
+            }
+        }
+    });
+}
+
+
 /// Flag the Task as cancelled, try to stop the SQL query, and try to remove it from the schedule.
 void Task::cancel() {
     if (_cancelled.exchange(true)) {
@@ -226,6 +319,44 @@ std::chrono::milliseconds Task::getRunTime() const {
 }
 
 
+/// @return the amount of time the task waited to be started in milliseconds,
+/// 0 if it was not started yet.
+std::chrono::milliseconds Task::getQueuedTime() const {
+    std::lock_guard<std::mutex> guard(_stateMtx);
+    bool const wasQueued = _queueTime != std::chrono::system_clock::time_point();
+    if (!wasQueued || (_state != State::RUNNING && _state != State::FINISHED)) {
+        return std::chrono::milliseconds{0};
+    }
+    return std::chrono::duration_cast<std::chrono::milliseconds>(_startTime - _queueTime);
+}
+
+
+std::chrono::system_clock::time_point Task::getQueueTime() const {
+    std::lock_guard<std::mutex> guard(_stateMtx);
+    return _queueTime;
+}
+
+
+TaskUsage Task::getUsage() const {
+    std::lock_guard<std::mutex> guard(_stateMtx);
+    return _usage;
+}
+
+
+void Task::setUsage(TaskUsage const& usage) {
+    std::lock_guard<std::mutex> guard(_stateMtx);
+    _usage = usage;
+}
+
+
+bool Task::leaveFold(proto::Result* groups) {
+    if (_fold == nullptr || _foldLeft.exchange(true)) {
+        return false;
+    }
+    return _fold->leave(groups);
+}
+
+
 /// Wait for MemMan to finish reserving resources. The mlock call can take several seconds
 /// and only one mlock call can be running at a time. Further, queries finish slightly faster
 /// if they are mlock'ed in the same order they were scheduled, hence the ulockEvents
@@ -245,6 +376,40 @@ void Task::waitForMemMan() {
 }
 
 
+void Task::unlockMemHandle() {
+    if (_memMan != nullptr && hasMemHandle()) {
+        LOGS(_log, LOG_LVL_DEBUG, _idStr << " unlocking handle=" << _memHandle);
+        _memMan->unlock(_memHandle);
+    }
+}
+
+
+std::vector<memman::TableInfo> Task::getMemTables(bool useFlexibleLock) const {
+    using LockType = memman::TableInfo::LockType;
+    LockType const lck = useFlexibleLock ? LockType::FLEXIBLE : LockType::REQUIRED;
+    proto::ScanInfo const& scanInfo = _shared->scanInfo;
+    LockType const lckTbl = (scanInfo.access == proto::ScanInfo::Access::INDEX) ? LockType::NOLOCK : lck;
+    LockType const lckIdx = (scanInfo.access == proto::ScanInfo::Access::SCAN) ? LockType::NOLOCK : lck;
+    std::vector<memman::TableInfo> tblVect;
+    std::set<std::string> names;
+    for (auto const& tbl : scanInfo.infoTables) {
+        std::string name = tbl.db + "/" + tbl.table;
+        names.insert(name);
+        tblVect.emplace_back(name, lckTbl, lckIdx);
+    }
+    // Tables only read through their indexes, all of them for interactive tasks.
+    if (scanInfo.access != proto::ScanInfo::Access::SCAN) {
+        for (auto const& tbl : scanInfo.indexTables) {
+            std::string name = tbl.db + "/" + tbl.table;
+            if (names.insert(name).second) {
+                tblVect.emplace_back(name, LockType::NOLOCK, lck);
+            }
+        }
+    }
+    return tblVect;
+}
+
+
 memman::MemMan::Status Task::getMemHandleStatus() {
     if (_memMan == nullptr || !hasMemHandle()) {
         return memman::MemMan::Status();
@@ -29,11 +29,14 @@
 #include <atomic>
 #include <chrono>
 #include <deque>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <set>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 // Qserv headers
 #include "global/intTypes.h"
@@ -49,8 +52,10 @@ namespace qserv {
 namespace wbase {
     struct ScriptMeta;
     class SendChannel;
+    class TaskFold;
 }
 namespace proto {
+    class Result;
     class TaskMsg;
     class TaskMsg_Fragment;
 }}} // End of forward declarations
@@ -78,6 +83,15 @@ public:
     virtual ~TaskScheduler() {}
     virtual void taskCancelled(Task*)=0;///< Repeated calls must be harmless.
     virtual bool removeTask(std::shared_ptr<Task> const& task, bool removeRunning)=0;
+    /// @return the chunk the shared scan running the Tasks of 'chunkId' is on, -1 if none.
+    virtual int getScanCursor(int chunkId) { return -1; }
+    /// Called by a running Task between two of its result messages.
+    /// @return true if 'task' should give its pool thread to interactive Tasks
+    ///         waiting for one. It is then marked as preempted.
+    virtual bool preempt(Task& task) { return false; }
+    /// Wait, out of the pool, until the interactive Tasks 'task' was preempted
+    /// for have started, or for the longest pause allowed.
+    virtual void waitPreempted(Task& task) {}
 };
 
 /// Used to find tasks that are in process for debugging with Task::_idStr.
@@ -101,6 +115,46 @@ private:
     mutable std::mutex mx;
 };
 
+/// Resources used by a task, summed per user query on the worker and sent to
+/// the czar with the last Result message of the task.
+struct TaskUsage {
+    std::uint64_t cpuUs{0}; ///< User and system CPU time of the thread running the task.
+    std::uint64_t rowsRead{0}; ///< Rows read by MySQL, from its Handler_read counters.
+    std::uint64_t bytesTransmitted{0}; ///< Bytes of the result messages and their headers.
+    std::uint64_t memLockedBytes{0}; ///< Bytes of the tables memman locked for the task.
+
+    TaskUsage& operator+=(TaskUsage const& other) {
+        cpuUs += other.cpuUs;
+        rowsRead += other.rowsRead;
+        bytesTransmitted += other.bytesTransmitted;
+        memLockedBytes += other.memLockedBytes;
+        return *this;
+    }
+};
+
+/// The parts of the TaskMsgs of a user query that are the same for all its
+/// chunks. The tasks of a query waiting on the worker share one TaskShared
+/// instead of each holding a copy.
+class TaskShared {
+public:
+    using Ptr = std::shared_ptr<TaskShared const>;
+
+    /// @return the TaskShared for 'msg', the one of an earlier task of the
+    ///         same user query if it is still in use and holds the same values.
+    static Ptr get(proto::TaskMsg const& msg);
+
+    std::vector<std::string> queryTemplates; ///< See TaskMsg.querytemplate
+    proto::ScanInfo scanInfo; ///< Scan tables sorted slowest first
+
+private:
+    bool _sameAs(TaskShared const& other) const;
+
+    using Key = std::pair<std::uint32_t, QueryId>; ///< czar id, query id
+    static std::mutex _mtx;
+    static std::map<Key, std::weak_ptr<TaskShared const>> _registry;
+    static size_t _nextSweep; ///< Size of _registry at which expired entries are removed.
+};
+
 /// class Task defines a query task to be done, containing a TaskMsg
 /// (over-the-wire) additional concrete info related to physical
 /// execution conditions.
@@ -147,19 +201,53 @@ public:
     QueryId getQueryId() const { return _qId; }
     int getJobId() const { return _jId; }
     int getAttemptCount() const { return _attemptCount; }
+    std::uint32_t getCzarId() const { return _czarId; }
     bool getScanInteractive() {return _scanInteractive; }
-    proto::ScanInfo& getScanInfo() { return _scanInfo; }
+    proto::ScanInfo const& getScanInfo() const { return _shared->scanInfo; }
     void setOnInteractive(bool val) { _onInteractive = val; }
     bool getOnInteractive() { return _onInteractive; }
+    /// Minutes this task is expected to take based on past tasks, -1 if unknown.
+    void setPredictedMinutes(double val) { _predictedMinutes = val; }
+    double getPredictedMinutes() const { return _predictedMinutes; }
+    /// Number of connections the subchunk queries of this task may run on at
+    /// once, set by the scheduler when the task is started.
+    void setSubChunkThreads(unsigned int val) { _subChunkThreads = val; }
+    unsigned int getSubChunkThreads() const { return _subChunkThreads; }
+    /// @return true if the czar asked for this task to finish by a deadline.
+    bool hasDeadline() const { return _deadline != std::chrono::system_clock::time_point::max(); }
+    /// @return the time this task should be finished by, time_point::max() if none.
+    std::chrono::system_clock::time_point getDeadline() const { return _deadline; }
+    /// @return true if less than half of the time given to this task is left at 'now'.
+    bool deadlineAtRisk(std::chrono::system_clock::time_point const& now) const {
+        return hasDeadline() && now + _deadlineBudget / 2 >= _deadline;
+    }
     bool hasMemHandle() const { return _memHandle != memman::MemMan::HandleType::INVALID; }
     memman::MemMan::Handle getMemHandle() { return _memHandle; }
     memman::MemMan::Status getMemHandleStatus();
     void setMemHandle(memman::MemMan::Handle handle) { _memHandle = handle; }
     void setMemMan(memman::MemMan::Ptr const& memMan) { _memMan = memMan; }
     void waitForMemMan();
+    /// Preempted tasks leave the pool with their tables still locked, their
+    /// scheduler does not unlock them as it does for the other tasks leaving
+    /// the pool, see TaskScheduler::preempt().
+    void setPreempted(bool val) { _preempted = val; }
+    bool getPreempted() const { return _preempted; }
+    /// Unlock the tables of a preempted task once it is done with them.
+    void unlockMemHandle();
+    /// @return the tables of this task as memman needs them to lock its chunk.
+    ///         Data files are locked for scans, index files for lookups.
+    /// @param useFlexibleLock - lock FLEXIBLE instead of REQUIRED.
+    std::vector<memman::TableInfo> getMemTables(bool useFlexibleLock) const;
     bool getSafeToMoveRunning() { return _safeToMoveRunning; }
     void setSafeToMoveRunning(bool val) { _safeToMoveRunning = val; } ///< For testing only.
 
+    /// Put the scan tables back into 'msg' and give its fragments sent without
+    /// queries the query templates of the user query, with the chunk id in
+    /// place of CHUNK_TAG. It is called when the task is about to run, so that
+    /// waiting tasks only hold what is particular to their chunk. Repeated
+    /// calls are harmless.
+    void expandMsg();
+
     static IdSet allIds; // set of all task jobId numbers that are not complete.
     std::string getIdStr() const {return _idStr;}
 
@@ -169,31 +257,59 @@ public:
     // Functions for tracking task state and statistics.
     State getState() const;
     std::chrono::milliseconds getRunTime() const;
+    std::chrono::milliseconds getQueuedTime() const;
+    /// @return when the task was queued, time_point() if it was not.
+    std::chrono::system_clock::time_point getQueueTime() const;
     void queued(std::chrono::system_clock::time_point const& now);
     void started(std::chrono::system_clock::time_point const& now);
     std::chrono::milliseconds finished(std::chrono::system_clock::time_point const& now);
 
+    /// Resources used by this task, set by its TaskQueryRunner before it finishes.
+    TaskUsage getUsage() const;
+    void setUsage(TaskUsage const& usage);
+
+    /// Fold the partial aggregates of this task with those of the other
+    /// tasks of its user query, see TaskFold. Set before the task is queued.
+    void setFold(std::shared_ptr<TaskFold> const& fold) { _fold = fold; }
+    /// @return the TaskFold of this task, nullptr if its rows are not folded.
+    std::shared_ptr<TaskFold> getFold() const { return _fold; }
+    /// Leave the TaskFold of this task, if it did not already, see TaskFold::leave().
+    /// The task leaves with 'groups' null when it is destroyed.
+    bool leaveFold(proto::Result* groups);
+
 private:
     QueryId  const    _qId{0}; //< queryId from czar
     int      const    _jId{0}; //< jobId from czar
     int      const    _attemptCount{0}; // attemptCount from czar
+    std::uint32_t const _czarId{0}; //< QMeta czar id, 0 if the czar did not send it
     std::string const _idStr{QueryIdHelper::makeIdStr(0, 0, true)}; // < for logging only
 
     std::atomic<bool> _cancelled{false};
     std::atomic<bool> _safeToMoveRunning{false}; ///< false until done with waitForMemMan().
+    std::atomic<bool> _preempted{false}; ///< True once the task gave its thread to interactive Tasks.
     TaskQueryRunner::Ptr _taskQueryRunner;
     std::weak_ptr<TaskScheduler> _taskScheduler;
-    proto::ScanInfo _scanInfo;
+    TaskShared::Ptr _shared;
+    std::once_flag _expandOnce;
     bool _scanInteractive; ///< True if the czar thinks this query should be interactive.
     bool _onInteractive{false}; ///< True if the scheduler put this task on the interactive (group) scheduler.
+    double _predictedMinutes{-1.0}; ///< Expected run time, set when the task is queued.
+    unsigned int _subChunkThreads{1}; ///< Subchunk queries run at once, 1 runs them in turn.
+    std::chrono::milliseconds _deadlineBudget{0}; ///< Time given to this task by the czar.
+    /// Arrival time plus _deadlineBudget, time_point::max() if there is no deadline.
+    std::chrono::system_clock::time_point _deadline{std::chrono::system_clock::time_point::max()};
     std::atomic<memman::MemMan::Handle> _memHandle{memman::MemMan::HandleType::INVALID};
     memman::MemMan::Ptr _memMan;
 
-    mutable std::mutex _stateMtx; ///< Mutex to protect state related members _state, _???Time.
+    mutable std::mutex _stateMtx; ///< Mutex to protect state related members _state, _???Time, _usage.
     State _state{State::CREATED};
     std::chrono::system_clock::time_point _queueTime;
     std::chrono::system_clock::time_point _startTime;
     std::chrono::system_clock::time_point _finishTime;
+    TaskUsage _usage;
+
+    std::shared_ptr<TaskFold> _fold; ///< May be null.
+    std::atomic<bool> _foldLeft{false}; ///< True once the task left _fold.
 
     util::InstanceCount _ic{"Task"}; ///< Count of existing Task objects.
 };
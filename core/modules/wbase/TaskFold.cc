@@ -0,0 +1,125 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "wbase/TaskFold.h"
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.wbase.TaskFold");
+
+} // annonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace wbase {
+
+std::mutex TaskFold::_registryMtx;
+std::map<TaskFold::Key, std::weak_ptr<TaskFold>> TaskFold::_registry;
+size_t TaskFold::_nextSweep = 64;
+
+
+TaskFold::Ptr TaskFold::join(proto::TaskMsg const& msg, size_t maxGroups) {
+    if (msg.aggfold_size() == 0 || maxGroups == 0) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(_registryMtx);
+    auto& entry = _registry[Key(msg.czarid(), msg.queryid())];
+    auto taskFold = entry.lock();
+    if (taskFold == nullptr) {
+        proto::InMemoryAggregator::FoldVector fold;
+        for (auto f : msg.aggfold()) {
+            fold.push_back(static_cast<proto::InMemoryAggregator::Fold>(f));
+        }
+        taskFold = std::make_shared<TaskFold>(fold, maxGroups);
+        entry = taskFold;
+        if (_registry.size() >= _nextSweep) {
+            for (auto itr = _registry.begin(); itr != _registry.end();) {
+                itr = itr->second.expired() ? _registry.erase(itr) : std::next(itr);
+            }
+            _nextSweep = 2 * _registry.size() + 64;
+        }
+    }
+    taskFold->_join();
+    return taskFold;
+}
+
+
+TaskFold::TaskFold(proto::InMemoryAggregator::FoldVector const& fold, size_t maxGroups)
+    : _aggregator(fold, maxGroups) {
+}
+
+
+void TaskFold::_join() {
+    std::lock_guard<std::mutex> lock(_mtx);
+    ++_members;
+}
+
+
+bool TaskFold::fold(int jobId, proto::Result const& result) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    if (!_foldable) {
+        return false;
+    }
+    if (!_hasSchema) {
+        _hasSchema = true;
+        if (!_aggregator.setSchema(result.rowschema())) {
+            LOGS(_log, LOG_LVL_INFO, "rows of query " << result.queryid() << " can not be folded");
+            _foldable = false;
+            return false;
+        }
+    }
+    if (!_aggregator.fold(jobId, result)) {
+        return false;
+    }
+    _hasGroups = true;
+    return true;
+}
+
+
+bool TaskFold::leave(proto::Result* groups) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    if (--_members > 0 || !_hasGroups) {
+        return false;
+    }
+    _hasGroups = false;
+    if (groups == nullptr) {
+        LOGS(_log, LOG_LVL_WARN, "discarding " << _aggregator.getGroupCount() << " folded groups");
+        proto::Result discarded;
+        _aggregator.extractAll(discarded);
+        return false;
+    }
+    _aggregator.extractAll(*groups);
+    return true;
+}
+
+
+int TaskFold::getMembers() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _members;
+}
+
+}}} // namespace lsst::qserv::wbase
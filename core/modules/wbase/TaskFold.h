@@ -0,0 +1,98 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_WBASE_TASKFOLD_H
+#define LSST_QSERV_WBASE_TASKFOLD_H
+
+// System headers
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+// Qserv headers
+#include "global/intTypes.h"
+#include "proto/InMemoryAggregator.h"
+#include "proto/worker.pb.h"
+
+namespace lsst {
+namespace qserv {
+namespace wbase {
+
+/// TaskFold folds the partial aggregates of the tasks of one user query on
+/// this worker, those whose TaskMsg has 'aggfold', so that the czar gets one
+/// row per group from the worker instead of one per group and chunk.
+///
+/// Every task joins when it arrives and leaves when it is done. A task that
+/// succeeds folds its rows in and sends its result without them. The last
+/// task to leave sends the rows of all the groups folded with its own, so
+/// that the rows of every task reach the czar exactly once. A task whose rows
+/// can not be folded, for too many groups or too large a result, sends them
+/// itself. The groups of a failed or cancelled last task are lost, the czar
+/// does not retry the jobs of these queries and fails the query instead.
+class TaskFold {
+public:
+    using Ptr = std::shared_ptr<TaskFold>;
+
+    /// Join the TaskFold of the user query of 'msg'.
+    /// @param maxGroups - groups the tasks of the query may fold, 0 disables folding.
+    /// @return the TaskFold, nullptr if the tasks of the query are not folded.
+    static Ptr join(proto::TaskMsg const& msg, size_t maxGroups);
+
+    TaskFold(proto::InMemoryAggregator::FoldVector const& fold, size_t maxGroups);
+    TaskFold(TaskFold const&) = delete;
+    TaskFold& operator=(TaskFold const&) = delete;
+
+    /// Fold the rows of 'result', the whole result of job 'jobId'.
+    /// @return false if they could not be folded, the task then sends them.
+    bool fold(int jobId, proto::Result const& result);
+
+    /// Leave, once the rows of the task were folded or sent.
+    /// @param groups - if not null and the caller is the last task to leave,
+    ///        set to the rows of all the groups folded, which the caller
+    ///        then sends. Otherwise the groups stay for the tasks still there,
+    ///        or are discarded if there are none.
+    /// @return true if rows were put in 'groups'.
+    bool leave(proto::Result* groups);
+
+    int getMembers() const;
+
+private:
+    void _join();
+
+    std::mutex mutable _mtx; ///< Protects the members below.
+    proto::InMemoryAggregator _aggregator;
+    int _members{0}; ///< Tasks that joined and did not leave yet.
+    bool _hasSchema{false}; ///< True once the schema of the rows was given to _aggregator.
+    bool _foldable{true}; ///< False if the rows of the query can not be folded.
+    bool _hasGroups{false}; ///< True if _aggregator holds rows.
+
+    using Key = std::pair<std::uint32_t, QueryId>; ///< czar id, query id
+    static std::mutex _registryMtx;
+    static std::map<Key, std::weak_ptr<TaskFold>> _registry;
+    static size_t _nextSweep; ///< Size of _registry at which expired entries are removed.
+};
+
+}}} // namespace lsst::qserv::wbase
+
+#endif // LSST_QSERV_WBASE_TASKFOLD_H
@@ -56,6 +56,14 @@ public:
     /// The smart pointer type to objects of the class
     using Ptr =  std::shared_ptr<WorkerCommand>;
 
+    /// The order in which the queued commands are run, regardless of
+    /// the order they were received in.
+    enum Priority {
+        HIGH,       ///< cheap lookups which are expected to return right away
+        NORMAL,     ///< changes to the inventory of chunks
+        LOW         ///< commands scanning the tables of the worker
+    };
+
     // The default construction and copy semantics are prohibited
     WorkerCommand& operator=(const WorkerCommand&) = delete;
     WorkerCommand(const WorkerCommand&) = delete;
@@ -75,6 +83,9 @@ public:
      */
     virtual void run ()=0;
 
+    /// @return the priority of the command
+    virtual Priority priority() const { return NORMAL; }
+
 protected:
 
     std::shared_ptr<SendChannel> _sendChannel;  ///< For result reporting
@@ -0,0 +1,156 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// System headers
+#include <map>
+#include <string>
+
+// Third-party headers
+#include <mysql/mysql.h>
+
+// Qserv headers
+#include "proto/worker.pb.h"
+#include "wbase/TaskFold.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE TaskFold
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::proto::Result;
+using lsst::qserv::proto::TaskMsg;
+using lsst::qserv::wbase::TaskFold;
+
+struct Fixture {
+    Fixture() {
+        msg.set_queryid(7);
+        msg.set_czarid(1);
+        msg.set_jobid(0);
+        msg.set_scaninteractive(false);
+        msg.set_attemptcount(0);
+        msg.add_aggfold(TaskMsg::KEY);
+        msg.add_aggfold(TaskMsg::SUM);
+    }
+
+    /// @return a result of "band, COUNT" rows.
+    Result makeResult(std::map<std::string, int> const& counts) {
+        Result res;
+        auto addColumn = [&res](std::string const& name, std::string const& sqlType, int mysqlType) {
+            auto cs = res.mutable_rowschema()->add_columnschema();
+            cs->set_name(name);
+            cs->set_deprecated_hasdefault(false);
+            cs->set_sqltype(sqlType);
+            cs->set_mysqltype(mysqlType);
+        };
+        addColumn("band", "CHAR(1)", MYSQL_TYPE_STRING);
+        addColumn("QS1_COUNT", "BIGINT", MYSQL_TYPE_LONGLONG);
+        for (auto const& elem : counts) {
+            auto rb = res.add_row();
+            rb->add_column(elem.first);
+            rb->add_isnull(false);
+            rb->add_column(std::to_string(elem.second));
+            rb->add_isnull(false);
+        }
+        return res;
+    }
+
+    /// @return the counts of the rows of 'res' by band.
+    std::map<std::string, std::string> counts(Result const& res) {
+        std::map<std::string, std::string> out;
+        for (auto const& rb : res.row()) {
+            out[rb.column(0)] = rb.column(1);
+        }
+        return out;
+    }
+
+    TaskMsg msg;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE(suite, Fixture)
+
+BOOST_AUTO_TEST_CASE(NotFolded) {
+    BOOST_CHECK(TaskFold::join(msg, 0) == nullptr);
+    msg.clear_aggfold();
+    BOOST_CHECK(TaskFold::join(msg, 100) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(LastSendsGroups) {
+    auto a = TaskFold::join(msg, 100);
+    auto b = TaskFold::join(msg, 100);
+    auto c = TaskFold::join(msg, 100);
+    BOOST_REQUIRE(a != nullptr);
+    BOOST_CHECK(a == b && b == c);
+    BOOST_CHECK_EQUAL(a->getMembers(), 3);
+
+    BOOST_REQUIRE(a->fold(1, makeResult({{"g", 2}, {"r", 3}})));
+    Result groups;
+    BOOST_CHECK(!a->leave(&groups));
+    BOOST_REQUIRE(b->fold(2, makeResult({{"r", 4}, {"i", 1}})));
+    BOOST_CHECK(!b->leave(&groups));
+    BOOST_CHECK_EQUAL(groups.row_size(), 0);
+
+    // The last task folds its rows too and sends them with the others.
+    BOOST_REQUIRE(c->fold(3, makeResult({{"g", 5}})));
+    BOOST_REQUIRE(c->leave(&groups));
+    BOOST_CHECK_EQUAL(groups.rowschema().columnschema_size(), 2);
+    std::map<std::string, std::string> expected = {{"g", "7"}, {"i", "1"}, {"r", "7"}};
+    BOOST_CHECK(counts(groups) == expected);
+    BOOST_CHECK_EQUAL(c->getMembers(), 0);
+
+    // Tasks arriving later start over.
+    auto d = TaskFold::join(msg, 100);
+    BOOST_CHECK(d == a);
+    Result more;
+    BOOST_CHECK(!d->leave(&more));
+    BOOST_CHECK_EQUAL(more.row_size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(FailedLastDiscards) {
+    msg.set_queryid(8);
+    auto a = TaskFold::join(msg, 100);
+    auto b = TaskFold::join(msg, 100);
+    BOOST_REQUIRE(a->fold(1, makeResult({{"g", 2}})));
+    BOOST_CHECK(!a->leave(nullptr));
+    BOOST_CHECK(!b->leave(nullptr));
+    auto c = TaskFold::join(msg, 100);
+    Result groups;
+    BOOST_CHECK(!c->leave(&groups));
+    BOOST_CHECK_EQUAL(groups.row_size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(TooManyGroups) {
+    msg.set_queryid(9);
+    auto a = TaskFold::join(msg, 2);
+    auto b = TaskFold::join(msg, 2);
+    BOOST_REQUIRE(a->fold(1, makeResult({{"g", 2}, {"r", 3}})));
+    // The task sends its rows itself.
+    BOOST_CHECK(!b->fold(2, makeResult({{"i", 1}})));
+    BOOST_CHECK(!a->leave(nullptr));
+    Result groups;
+    BOOST_REQUIRE(b->leave(&groups));
+    BOOST_CHECK_EQUAL(groups.row_size(), 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -25,13 +25,17 @@
 #include "wconfig/WorkerConfig.h"
 
 // System headers
+#include <algorithm>
 #include <sstream>
+#include <stdexcept>
 
 // LSST headers
 #include "lsst/log/Log.h"
 
 // Qserv headers
 #include "mysql/MySqlConfig.h"
+#include "proto/ResultCompression.h"
+#include "wconfig/WorkerConfigError.h"
 #include "wsched/BlendScheduler.h"
 
 namespace {
@@ -49,9 +53,18 @@ WorkerConfig::WorkerConfig(const util::ConfigStore& configStore)
     : _mySqlConfig(configStore.getRequired("mysql.username"),
             configStore.get("mysql.password"),
             configStore.getRequired("mysql.socket")),
+      _mySqlPool(configStore.getInt("mysql.pool", 0) != 0),
+      _mySqlStatementCache(configStore.getInt("mysql.statement_cache", 0)),
       _memManClass(configStore.get("memman.class", "MemManReal")),
       _memManSizeMb(configStore.getInt("memman.memory", 1000)),
       _memManLocation(configStore.getRequired("memman.location")),
+      _memManNuma(configStore.getInt("memman.numa", 0) != 0),
+      _memManRetain(configStore.getInt("memman.retain", 0) != 0),
+      _memManPopulate(configStore.getInt("memman.populate", 0) != 0),
+      _memManHugePages(configStore.getInt("memman.hugepages", 0) != 0),
+      _memManFaultThreads(configStore.getInt("memman.fault_threads", 1)),
+      _memManPressure(configStore.getInt("memman.pressure", 0) != 0),
+      _memManPressureThreshold(configStore.getInt("memman.pressure_threshold", 10)),
       _threadPoolSize(configStore.getInt("scheduler.thread_pool_size", wsched::BlendScheduler::getMinPoolSize())),
       _maxGroupSize(configStore.getInt("scheduler.group_size", 1)),
       _requiredTasksCompleted(configStore.getInt("scheduler.required_tasks_completed", 25)),
@@ -63,24 +76,95 @@ WorkerConfig::WorkerConfig(const util::ConfigStore& configStore)
       _maxReserveSnail(configStore.getInt("scheduler.reserve_snail", 2)),
       _maxReserveMed(configStore.getInt("scheduler.reserve_med", 2)),
       _maxReserveFast(configStore.getInt("scheduler.reserve_fast", 2)),
+      _maxLentThreads(configStore.getInt("scheduler.max_lent_threads", 2)),
+      _preemptAfterMs(configStore.getInt("scheduler.preempt_after_ms", 0)),
+      _preemptMaxPauseMs(configStore.getInt("scheduler.preempt_max_pause_ms", 10000)),
       _maxActiveChunksSlow(configStore.getInt("scheduler.maxactivechunks_slow", 2)),
       _maxActiveChunksSnail(configStore.getInt("scheduler.maxactivechunks_snail", 1)),
       _maxActiveChunksMed(configStore.getInt("scheduler.maxactivechunks_med", 4)),
       _maxActiveChunksFast(configStore.getInt("scheduler.maxactivechunks_fast", 4)),
+      _deviceQueues(configStore.getInt("scheduler.device_queues", 0) != 0),
+      _maxActiveChunksRotational(configStore.getInt("scheduler.maxactivechunks_rotational", 1)),
+      _subChunkCache(configStore.getInt("scheduler.subchunk_cache", 0)),
+      _subChunkPrebuild(configStore.getInt("scheduler.subchunk_prebuild", 0) != 0),
+      _subChunkThreads(std::max(1, configStore.getInt("scheduler.subchunk_threads", 1))),
+      _commandThreads(std::max(1, configStore.getInt("scheduler.command_threads", 2))),
       _scanMaxMinutesFast(configStore.getInt("scheduler.scanmaxminutes_fast", 60)),
       _scanMaxMinutesMed(configStore.getInt("scheduler.scanmaxminutes_med", 60*8)),
       _scanMaxMinutesSlow(configStore.getInt("scheduler.scanmaxminutes_slow", 60*12)),
       _scanMaxMinutesSnail(configStore.getInt("scheduler.scanmaxminutes_snail", 60*24)),
-      _maxTasksBootedPerUserQuery(configStore.getInt("scheduler.maxtasksbootedperuserquery", 5)) {
+      _maxTasksBootedPerUserQuery(configStore.getInt("scheduler.maxtasksbootedperuserquery", 5)),
+      _fairShare(_getFairShare(configStore)),
+      _metricsPort(std::max(0, configStore.getInt("metrics.port", 0))),
+      _transmitConfig(_getCompression(configStore), configStore.getInt("results.compression_level", 1),
+                      _getChecksum(configStore)) {
+    _transmitConfig.transmitDepth = std::max(1, configStore.getInt("results.transmit_depth", 2));
+    _transmitConfig.transmitMemoryBudgetMB = configStore.getInt("results.transmit_memory_mb", 0);
+    _transmitConfig.transmitMaxMB = configStore.getInt("results.transmit_max_mb", 0);
+    _transmitConfig.transmitSenders = configStore.getInt("results.transmit_senders", 0);
+    _transmitConfig.transmitStageMB = configStore.getInt("results.transmit_stage_mb", 512);
+    _transmitConfig.flushRows = configStore.getInt("results.flush_rows", 0);
+    _transmitConfig.flushMs = configStore.getInt("results.flush_ms", 0);
+    _transmitConfig.resultCacheMB = configStore.getInt("results.cache_mb", 0);
+    _transmitConfig.aggFoldMaxGroups = std::max(0, configStore.getInt("results.agg_fold_max_groups", 100000));
+    _transmitConfig.spoolDir = configStore.get("results.spool_dir", "");
+    _transmitConfig.nativeScanDir = configStore.get("results.native_scan_dir", "");
+    _transmitConfig.coalesceKB = configStore.getInt("results.coalesce_kb", 64);
+}
+
+proto::ProtoHeader::Compression WorkerConfig::_getCompression(util::ConfigStore const& configStore) {
+    std::string const name = configStore.get("results.compression", "none");
+    try {
+        return proto::ResultCompression::codecFromName(name);
+    } catch (std::invalid_argument const& e) {
+        throw WorkerConfigError("Unrecognized results.compression " + name);
+    }
+}
+
+proto::ProtoHeader::Checksum WorkerConfig::_getChecksum(util::ConfigStore const& configStore) {
+    std::string const name = configStore.get("results.checksum", "crc32c");
+    if (name == "crc32c") return proto::ProtoHeader::CRC32C;
+    if (name == "md5") return proto::ProtoHeader::MD5;
+    throw WorkerConfigError("Unrecognized results.checksum " + name);
+}
+
+wsched::FairShareAdmission::Config WorkerConfig::_getFairShare(util::ConfigStore const& configStore) {
+    wsched::FairShareAdmission::Config config;
+    config.slots = std::max(0, configStore.getInt("scheduler.fair_share_slots", 0));
+    config.maxInFlight = std::max(0, configStore.getInt("scheduler.fair_share_max_inflight", 0));
+    config.maxQueued = std::max(0, configStore.getInt("scheduler.fair_share_max_queued", 0));
+    std::string const weights = configStore.get("scheduler.fair_share_weights", "");
+    try {
+        config.weights = wsched::FairShareAdmission::parseWeights(weights);
+    } catch (std::invalid_argument const& e) {
+        throw WorkerConfigError("Unrecognized scheduler.fair_share_weights " + weights);
+    }
+    return config;
 }
 
 std::ostream& operator<<(std::ostream &out, WorkerConfig const& workerConfig) {
     out << "MemManClass=" << workerConfig._memManClass;
     if (workerConfig._memManClass == "MemManReal") {
         out << "MemManSizeMb=" << workerConfig._memManSizeMb;
+        out << " numa=" << workerConfig._memManNuma;
+        out << " retain=" << workerConfig._memManRetain;
+        out << " populate=" << workerConfig._memManPopulate;
+        out << " hugepages=" << workerConfig._memManHugePages;
+        out << " fault_threads=" << workerConfig._memManFaultThreads;
+        out << " pressure=" << workerConfig._memManPressure;
+        out << " pressure_threshold=" << workerConfig._memManPressureThreshold;
     }
     out << " poolSize=" << workerConfig._threadPoolSize << ", maxGroupSize=" << workerConfig._maxGroupSize;
     out << " requiredTasksCompleted=" << workerConfig._requiredTasksCompleted;
+    out << " mysqlPool=" << workerConfig._mySqlPool << ", statementCache=" << workerConfig._mySqlStatementCache;
+    out << " subchunkCache=" << workerConfig._subChunkCache << ", subchunkPrebuild=" << workerConfig._subChunkPrebuild
+        << ", subchunkThreads=" << workerConfig._subChunkThreads;
+    out << " commandThreads=" << workerConfig._commandThreads;
+    out << " fairShareSlots=" << workerConfig._fairShare.slots
+        << ", maxInFlight=" << workerConfig._fairShare.maxInFlight
+        << ", maxQueued=" << workerConfig._fairShare.maxQueued
+        << ", weights=" << workerConfig._fairShare.weights.size();
+    out << " metricsPort=" << workerConfig._metricsPort;
 
     out << " priority fast=" << workerConfig._priorityFast
         << " med=" << workerConfig._priorityMed
@@ -89,6 +173,22 @@ std::ostream& operator<<(std::ostream &out, WorkerConfig const& workerConfig) {
     out << " Reserved threads fast=" << workerConfig._maxReserveFast
          << " med=" << workerConfig._maxReserveMed << " slow=" << workerConfig._maxReserveSlow;
 
+    out << " compression=" << proto::ResultCompression::codecName(workerConfig._transmitConfig.compression)
+        << " level=" << workerConfig._transmitConfig.compressionLevel
+        << " checksum=" << proto::ProtoHeader::Checksum_Name(workerConfig._transmitConfig.checksum)
+        << " transmitDepth=" << workerConfig._transmitConfig.transmitDepth
+        << " transmitMemoryMB=" << workerConfig._transmitConfig.transmitMemoryBudgetMB
+        << " transmitMaxMB=" << workerConfig._transmitConfig.transmitMaxMB
+        << " transmitSenders=" << workerConfig._transmitConfig.transmitSenders
+        << " transmitStageMB=" << workerConfig._transmitConfig.transmitStageMB
+        << " flushRows=" << workerConfig._transmitConfig.flushRows
+        << " flushMs=" << workerConfig._transmitConfig.flushMs
+        << " cacheMB=" << workerConfig._transmitConfig.resultCacheMB
+        << " aggFoldMaxGroups=" << workerConfig._transmitConfig.aggFoldMaxGroups
+        << " spoolDir=" << workerConfig._transmitConfig.spoolDir
+        << " nativeScanDir=" << workerConfig._transmitConfig.nativeScanDir
+        << " coalesceKB=" << workerConfig._transmitConfig.coalesceKB;
+
     return out;
 }
 
@@ -31,6 +31,8 @@
 // Qserv headers
 #include "mysql/MySqlConfig.h"
 #include "util/ConfigStore.h"
+#include "wdb/TransmitConfig.h"
+#include "wsched/FairShareAdmission.h"
 
 namespace lsst {
 namespace qserv {
@@ -161,6 +163,32 @@ public:
         return _maxReserveSnail;
     }
 
+    /* Get max number of threads reserved by idle schedulers that busy
+     * shared scans may use
+     *
+     * @return max number of lent threads, 0 disables lending
+     */
+    unsigned int getMaxLentThreads() const {
+        return _maxLentThreads;
+    }
+
+    /* Get time interactive tasks wait for a thread before scan tasks are
+     * preempted for them
+     *
+     * @return preemption latency target in milliseconds, 0 disables preemption
+     */
+    unsigned int getPreemptAfterMs() const {
+        return _preemptAfterMs;
+    }
+
+    /* Get longest pause of a preempted scan task
+     *
+     * @return maximum pause in milliseconds
+     */
+    unsigned int getPreemptMaxPauseMs() const {
+        return _preemptMaxPauseMs;
+    }
+
     /* Get selected memory management implementation
      *
      * @return class name implementing selected memory management
@@ -185,6 +213,65 @@ public:
         return _memManSizeMb;
     }
 
+    /* Get whether chunk pages and the threads scanning them are placed on
+     * the same NUMA node
+     *
+     * @return true if NUMA placement is enabled
+     */
+    bool getMemManNuma() const {
+        return _memManNuma;
+    }
+
+    /* Get whether chunks stay locked in unused memory after their last query
+     *
+     * @return true if locked chunks are retained
+     */
+    bool getMemManRetain() const {
+        return _memManRetain;
+    }
+
+    /* Get whether all pages of a chunk file are faulted in before locking it
+     *
+     * @return true if files are populated
+     */
+    bool getMemManPopulate() const {
+        return _memManPopulate;
+    }
+
+    /* Get whether chunk files are mapped with transparent huge pages
+     *
+     * @return true if huge pages are requested
+     */
+    bool getMemManHugePages() const {
+        return _memManHugePages;
+    }
+
+    /* Get the number of threads faulting in the pages of a chunk file
+     *
+     * @return the number of fault in threads per file
+     */
+    int getMemManFaultThreads() const {
+        return _memManFaultThreads;
+    }
+
+    /* Get whether the memman budget follows the memory limit and pressure of
+     * the worker's cgroup
+     *
+     * @return true if memory pressure is monitored
+     */
+    bool getMemManPressure() const {
+        return _memManPressure;
+    }
+
+    /* Get the percent of time tasks may wait on memory before the worker
+     * considers itself under memory pressure
+     *
+     * @return the memory pressure threshold in percent
+     */
+    int getMemManPressureThreshold() const {
+        return _memManPressureThreshold;
+    }
+
     /* Get MySQL configuration for worker MySQL instance
      *
      * @return a structure containing MySQL parameters
@@ -193,6 +280,23 @@ public:
         return _mySqlConfig;
     }
 
+    /* Get whether query connections to the worker MySQL instance are kept
+     * open and reused by later queries
+     *
+     * @return true if connections are pooled
+     */
+    bool getMySqlPool() const {
+        return _mySqlPool;
+    }
+
+    /* Get the number of prepared statements kept on each query connection
+     *
+     * @return number of statements, 0 if queries are not prepared
+     */
+    unsigned int getMySqlStatementCache() const {
+        return _mySqlStatementCache;
+    }
+
     /* Get fast shared scan priority
      *
      * @return fast shared scan priority
@@ -257,6 +361,78 @@ public:
          return _maxActiveChunksSnail;
      }
 
+     /* Get whether scan schedulers queue chunks by the block device holding them
+      *
+      * @return true if scan schedulers use one queue per device.
+      */
+     bool getDeviceQueues() const {
+         return _deviceQueues;
+     }
+
+     /* Get maximum concurrent chunks read from one rotational device.
+      *
+      * @return rotational device maxActiveChunks.
+      */
+     unsigned int getMaxActiveChunksRotational() const {
+         return _maxActiveChunksRotational;
+     }
+
+     /* Get the number of unused subchunk tables kept built
+      *
+      * @return size of the subchunk table cache, 0 if disabled.
+      */
+     unsigned int getSubChunkCache() const {
+         return _subChunkCache;
+     }
+
+     /* Get whether subchunk tables are built when a chunk becomes active
+      *
+      * @return true if the subchunk tables of queued tasks are built ahead.
+      */
+     bool getSubChunkPrebuild() const {
+         return _subChunkPrebuild;
+     }
+
+     /* Get the maximum number of connections for the subchunk queries of a task
+      *
+      * @return number of subchunk queries of a task run at once, 1 runs them in turn.
+      */
+     unsigned int getSubChunkThreads() const {
+         return _subChunkThreads;
+     }
+
+     /* Get the number of threads running the worker management commands
+      *
+      * @return number of threads apart from the pool of the query tasks, at least 1.
+      */
+     unsigned int getCommandThreads() const {
+         return _commandThreads;
+     }
+
+    /* Get the fair-share admission of the tasks of each czar user
+     *
+     * @return slots, per user caps and weights, admission is disabled if no slot limit is set.
+     */
+    wsched::FairShareAdmission::Config const& getFairShare() const {
+        return _fairShare;
+    }
+
+    /* Get the configuration for sending results to the czar
+     *
+     * @return codec and level used to compress result messages, and their checksum type.
+     */
+    wdb::TransmitConfig const& getTransmitConfig() const {
+        return _transmitConfig;
+    }
+
+    /* Get the port of the HTTP server exporting the worker metrics
+     *
+     * @return the port, 0 if metrics are not exported.
+     */
+    unsigned int getMetricsPort() const {
+        return _metricsPort;
+    }
+
 
     /** Overload output operator for current class
      *
@@ -270,11 +446,24 @@ private:
 
     WorkerConfig(util::ConfigStore const& configStore);
 
+    static proto::ProtoHeader::Compression _getCompression(util::ConfigStore const& configStore);
+    static proto::ProtoHeader::Checksum _getChecksum(util::ConfigStore const& configStore);
+    static wsched::FairShareAdmission::Config _getFairShare(util::ConfigStore const& configStore);
+
     mysql::MySqlConfig const _mySqlConfig;
+    bool const _mySqlPool;
+    unsigned int const _mySqlStatementCache;
 
     std::string const _memManClass;
     uint64_t const _memManSizeMb;
     std::string const _memManLocation;
+    bool const _memManNuma;
+    bool const _memManRetain;
+    bool const _memManPopulate;
+    bool const _memManHugePages;
+    int const _memManFaultThreads;
+    bool const _memManPressure;
+    int const _memManPressureThreshold;
 
     unsigned int const _threadPoolSize;
     unsigned int const _maxGroupSize;
@@ -289,17 +478,30 @@ private:
     unsigned int const _maxReserveSnail;
     unsigned int const _maxReserveMed;
     unsigned int const _maxReserveFast;
+    unsigned int const _maxLentThreads;
+    unsigned int const _preemptAfterMs;
+    unsigned int const _preemptMaxPauseMs;
 
     unsigned int const _maxActiveChunksSlow;
     unsigned int const _maxActiveChunksSnail;
     unsigned int const _maxActiveChunksMed;
     unsigned int const _maxActiveChunksFast;
+    bool const _deviceQueues;
+    unsigned int const _maxActiveChunksRotational;
+    unsigned int const _subChunkCache;
+    bool const _subChunkPrebuild;
+    unsigned int const _subChunkThreads;
+    unsigned int const _commandThreads;
 
     unsigned int const _scanMaxMinutesFast;
     unsigned int const _scanMaxMinutesMed;
     unsigned int const _scanMaxMinutesSlow;
     unsigned int const _scanMaxMinutesSnail;
     unsigned int const _maxTasksBootedPerUserQuery;
+    wsched::FairShareAdmission::Config const _fairShare;
+    unsigned int const _metricsPort;
+
+    wdb::TransmitConfig _transmitConfig;
 };
 
 }}} // namespace qserv::core::wconfig
@@ -25,11 +25,14 @@
 #include "wcontrol/Foreman.h"
 
 // System headers
+#include <algorithm>
 #include <cassert>
 #include <deque>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <thread>
 #include <utility>
 
@@ -39,9 +42,14 @@
 // Qserv headers
 #include "mysql/MySqlConfig.h"
 #include "proto/worker.pb.h"
+#include "sql/SqlErrorObject.h"
+#include "util/Numa.h"
+#include "util/Profiler.h"
 #include "wbase/Base.h"
 #include "wbase/SendChannel.h"
+#include "wbase/TaskFold.h"
 #include "wbase/WorkerCommand.h"
+#include "wcontrol/WorkerCommandQueue.h"
 #include "wdb/ChunkResource.h"
 #include "wdb/QueryRunner.h"
 
@@ -56,11 +64,21 @@ namespace wcontrol {
 Foreman::Foreman(Scheduler::Ptr                  const& scheduler,
                  uint                                   poolSize,
                  mysql::MySqlConfig              const& mySqlConfig,
-                 wpublish::QueriesAndChunks::Ptr const& queries)
+                 wpublish::QueriesAndChunks::Ptr const& queries,
+                 wdb::TransmitConfig             const& transmitConfig,
+                 wpublish::ChunkInventory::Ptr   const& chunkInventory,
+                 bool                                   poolConnections,
+                 unsigned int                           subChunkCache,
+                 unsigned int                           statementCache,
+                 wsched::FairShareAdmission::Config const& fairShare,
+                 unsigned int                           commandThreads)
 
     :   _scheduler  (scheduler),
         _mySqlConfig(mySqlConfig),
-        _queries    (queries) {
+        _queries    (queries),
+        _transmitConfig(transmitConfig),
+        _chunkInventory(chunkInventory),
+        _statementCache(statementCache) {
 
     // Make the chunk resource mgr
     // Creating backend makes a connection to the database for making temporary tables.
@@ -68,15 +86,42 @@ Foreman::Foreman(Scheduler::Ptr                  const& scheduler,
     // Previous instances of the worker will terminate when they try to use or create temporary tables.
     // Previous instances of the worker should be terminated before a new worker is started.
     _backend = std::make_shared<wdb::SQLBackend>(_mySqlConfig);
-    _chunkResourceMgr = wdb::ChunkResourceMgr::newMgr(_backend);
+    _chunkResourceMgr = wdb::ChunkResourceMgr::newMgr(_backend, subChunkCache);
 
     assert(_scheduler); // Cannot operate without scheduler.
 
     LOGS(_log, LOG_LVL_DEBUG, "poolSize=" << poolSize);
     _pool = util::ThreadPool::newThreadPool(poolSize, _scheduler);
 
-    _workerCommandQueue = std::make_shared<util::CommandQueue>();
-    _workerCommandPool  = util::ThreadPool::newThreadPool(poolSize, _workerCommandQueue);
+    commandThreads = std::max(1U, commandThreads);
+    _workerCommandQueue = std::make_shared<WorkerCommandQueue>(commandThreads);
+    _workerCommandPool  = util::ThreadPool::newThreadPool(commandThreads, _workerCommandQueue);
+
+    _prebuildQueue = std::make_shared<util::CommandQueue>();
+    _prebuildPool  = util::ThreadPool::newThreadPool(poolSize, _prebuildQueue);
+
+    if (_transmitConfig.transmitMaxMB > 0) {
+        _transmitMgr = std::make_shared<wdb::TransmitMgr>(_transmitConfig.transmitMaxMB * 1000000ULL);
+    }
+    if (_transmitConfig.transmitSenders > 0) {
+        _transmitStage = std::make_shared<wdb::TransmitStage>(_transmitConfig.transmitSenders,
+                                                              _transmitConfig.transmitStageMB * 1000000ULL);
+    }
+    // Cached results can only be invalidated through the chunk inventory.
+    if (_transmitConfig.resultCacheMB > 0 && _chunkInventory != nullptr) {
+        _resultCache = std::make_shared<wdb::ResultCache>(_transmitConfig.resultCacheMB * 1000000ULL);
+    }
+    // One connection per pool thread covers all the queries that can run at once.
+    // Prepared statements only outlive a query if the session is not reset.
+    if (poolConnections) {
+        _connPool = std::make_shared<mysql::MySqlConnectionPool>(_mySqlConfig, poolSize,
+                                                                 _statementCache > 0);
+    }
+    if (fairShare.isEnabled()) {
+        auto scheduler = _scheduler;
+        _admission = std::make_shared<wsched::FairShareAdmission>(fairShare,
+            [scheduler](wbase::Task::Ptr const& task) { scheduler->queCmd(task); });
+    }
 }
 
 Foreman::~Foreman() {
@@ -90,6 +135,7 @@ Foreman::~Foreman() {
 void Foreman::processTask(std::shared_ptr<wbase::Task> const& task) {
 
     auto func = [this, task](util::CmdData*){
+        util::ThreadRole role("scheduler");
         proto::TaskMsg const& msg = *task->msg;
         int const resultProtocol = 2; // See proto/worker.proto Result protocol
         if (!msg.has_protocol() || msg.protocol() < resultProtocol) {
@@ -99,19 +145,99 @@ void Foreman::processTask(std::shared_ptr<wbase::Task> const& task) {
                 task->sendChannel->sendError("Unsupported wire protocol", 1);
             }
         } else {
-            auto qr = wdb::QueryRunner::newQueryRunner(task, _chunkResourceMgr, _mySqlConfig);
+            // Scan from the NUMA node holding the chunk pages, see memman::MemFileSet.
+            util::Numa& numa = util::Numa::get();
+            if (numa.isEnabled()) {
+                numa.bindThread(numa.nodeForChunk(msg.chunkid()));
+            }
+            auto qr = wdb::QueryRunner::newQueryRunner(task, _chunkResourceMgr, _mySqlConfig,
+                                                       _transmitConfig, _transmitMgr);
+            if (_resultCache != nullptr) {
+                auto version = _chunkInventory->version(msg.db(), msg.chunkid());
+                qr->setResultCache(_resultCache, wdb::ResultCache::makeKey(msg, version));
+            }
+            if (_connPool != nullptr) {
+                qr->setConnectionPool(_connPool);
+            }
+            qr->setStatementCache(_statementCache);
+            if (_transmitStage != nullptr) {
+                qr->setTransmitStage(_transmitStage);
+            }
             qr->runQuery();
         }
+        // Tasks removed from a scheduler still run here, so every admitted task frees its slot.
+        if (_admission != nullptr) {
+            _admission->finished(task);
+        }
     };
 
     task->setFunc(func);
+    task->setFold(wbase::TaskFold::join(*task->msg, _transmitConfig.aggFoldMaxGroups));
     _queries->addTask(task);
-    _scheduler->queCmd(task);
+    if (_admission == nullptr) {
+        _scheduler->queCmd(task);
+    } else if (!_admission->add(task)) {
+        task->sendChannel->sendError("Too many tasks waiting for this user, try again later", 1);
+    }
 }
 
 
+void Foreman::prebuildSubChunks(std::vector<std::shared_ptr<wbase::Task>> const& tasks) {
+    // Several tasks of a chunk usually need the same subchunks, merge them.
+    using Key = std::pair<std::string, DbTableSet>;
+    auto subChunks = std::make_shared<std::map<Key, std::set<int>>>();
+    int chunkId = -1;
+    for (auto const& task : tasks) {
+        proto::TaskMsg const& msg = *task->msg;
+        chunkId = msg.chunkid();
+        for (auto const& fragment : msg.fragment()) {
+            if (!fragment.has_subchunks()) {
+                continue;
+            }
+            proto::TaskMsg_Subchunk const& sc = fragment.subchunks();
+            DbTableSet dbTableSet;
+            for (auto const& dbTbl : sc.dbtbl()) {
+                dbTableSet.emplace(dbTbl.db(), dbTbl.tbl());
+            }
+            Key key(sc.has_database() ? sc.database() : msg.db(), dbTableSet);
+            (*subChunks)[key].insert(sc.id().begin(), sc.id().end());
+        }
+    }
+    if (subChunks->empty()) {
+        return;
+    }
+    auto mgr = _chunkResourceMgr;
+    auto func = [mgr, subChunks, chunkId](util::CmdData*) {
+        for (auto const& elem : *subChunks) {
+            IntVector ids(elem.second.begin(), elem.second.end());
+            try {
+                mgr->prebuild(elem.first.first, chunkId, elem.first.second, ids);
+            } catch (sql::SqlErrorObject const& err) {
+                // The tasks build the tables themselves and report the error.
+                LOGS(_log, LOG_LVL_WARN, "prebuildSubChunks chunkId=" << chunkId
+                     << " failed " << err.printErrMsg());
+            }
+        }
+    };
+    _prebuildQueue->queCmd(std::make_shared<util::Command>(func));
+}
+
 void Foreman::processCommand(std::shared_ptr<wbase::WorkerCommand> const& command) {
     _workerCommandQueue->queCmd(command);
 }
 
+int Foreman::cancelQuery(QueryId qId) {
+    // The queue goes first, so that no queued task starts while running ones are cancelled.
+    int count = _scheduler->cancelQuery(qId);
+    count += _queries->cancelQuery(qId);
+    if (_transmitMgr != nullptr) {
+        _transmitMgr->cancelQuery(qId);
+    }
+    if (_transmitStage != nullptr) {
+        _transmitStage->cancelQuery(qId);
+    }
+    LOGS(_log, LOG_LVL_INFO, QueryIdHelper::makeIdStr(qId) << " cancelQuery tasks=" << count);
+    return count;
+}
+
 }}} // namespace
@@ -30,11 +30,18 @@
 
 // Qserv headers
 #include "mysql/MySqlConfig.h"
+#include "mysql/MySqlConnectionPool.h"
 #include "util/EventThread.h"
 #include "wbase/Base.h"
 #include "wbase/MsgProcessor.h"
 //#include "wbase/Task.h"
+#include "wdb/ResultCache.h"
+#include "wdb/TransmitConfig.h"
+#include "wdb/TransmitMgr.h"
+#include "wdb/TransmitStage.h"
+#include "wpublish/ChunkInventory.h"
 #include "wpublish/QueriesAndChunks.h"
+#include "wsched/FairShareAdmission.h"
 
 
 // Forward declarations
@@ -70,6 +77,12 @@ public:
     /// nothing should be harmless, but some Schedulers may work better if cancelled
     /// tasks are removed.
     void taskCancelled(wbase::Task *task) override {}
+
+    /// Cancel all the queued Tasks of the user query 'qId'. They still go through
+    /// getCmd(), so that the usual bookkeeping is done, but ahead of other Tasks
+    /// and without waiting for resources, and they return as soon as they start.
+    /// @return the number of Tasks that were cancelled on the queue.
+    virtual int cancelQuery(QueryId qId) { return 0; }
 };
 
 /// Foreman is used to maintain a thread pool and schedule Tasks for the thread pool.
@@ -85,11 +98,25 @@ public:
      * @param poolSize    - size of the thread pool
      * @param mySqlConfig - configuration object for the MySQL service
      * @param queries     - query statistics collector
+     * @param transmitConfig - how results are sent to the czar
+     * @param chunkInventory - chunks on this worker, required for the result cache
+     * @param poolConnections - reuse MySQL connections across queries
+     * @param subChunkCache - number of unused subchunk tables to keep built
+     * @param statementCache - number of prepared statements kept per connection
+     * @param fairShare - how tasks of each czar user are admitted to the scheduler
+     * @param commandThreads - size of the thread pool of the worker management commands
      */
     Foreman(Scheduler::Ptr                  const& scheduler,
             uint                                   poolSize,
             mysql::MySqlConfig              const& mySqlConfig,
-            wpublish::QueriesAndChunks::Ptr const& queries);
+            wpublish::QueriesAndChunks::Ptr const& queries,
+            wdb::TransmitConfig             const& transmitConfig=wdb::TransmitConfig(),
+            wpublish::ChunkInventory::Ptr   const& chunkInventory=nullptr,
+            bool                                   poolConnections=false,
+            unsigned int                           subChunkCache=0,
+            unsigned int                           statementCache=0,
+            wsched::FairShareAdmission::Config const& fairShare=wsched::FairShareAdmission::Config(),
+            unsigned int                           commandThreads=2);
 
     virtual ~Foreman();
 
@@ -106,12 +133,47 @@ public:
     void processTask(std::shared_ptr<wbase::Task> const& task) override;
 
    /**
-     * Implement the corresponding method of the base class
+     * Implement the corresponding method of the base class. Commands run in
+     * a small pool of their own by priority, so that they aren't delayed by
+     * query tasks nor by the building of subchunk tables.
      *
      * @see MsgProcessor::processCommand()
      */
     void processCommand(std::shared_ptr<wbase::WorkerCommand> const& command) override;
 
+   /**
+     * Implement the corresponding method of the base class. Queued tasks are
+     * taken off the scheduler without locking their tables, running ones have
+     * their MySQL statement killed, and tasks waiting to transmit stop waiting.
+     *
+     * @see MsgProcessor::cancelQuery()
+     */
+    int cancelQuery(QueryId qId) override;
+
+    /// Build the subchunk tables of 'tasks' in the prebuild pool, so
+    /// that they are ready when the tasks run. The tables are only kept if
+    /// the subchunk table cache is enabled.
+    void prebuildSubChunks(std::vector<std::shared_ptr<wbase::Task>> const& tasks);
+
+    /// @return the result transmit controller, for its queue depth and stall
+    ///         time statistics. May be null.
+    wdb::TransmitMgr::Ptr getTransmitMgr() const { return _transmitMgr; }
+
+    /// @return the stage sending the Result messages of all tasks, for its
+    ///         memory and stall time statistics. May be null.
+    wdb::TransmitStage::Ptr getTransmitStage() const { return _transmitStage; }
+
+    /// @return the fair-share admission of tasks, for its per principal
+    ///         statistics. May be null.
+    wsched::FairShareAdmission::Ptr getAdmission() const { return _admission; }
+
+    /// @return the pool of threads running the tasks, which RuntimeConfig resizes.
+    util::ThreadPool::Ptr getThreadPool() const { return _pool; }
+
+    /// @return the query statistics collector, for the completion times of
+    ///         the tasks on each chunk.
+    wpublish::QueriesAndChunks::Ptr getQueriesAndChunks() const { return _queries; }
+
 private:
 
     std::shared_ptr<wdb::SQLBackend>       _backend;
@@ -122,9 +184,19 @@ private:
 
     util::CommandQueue::Ptr _workerCommandQueue;    ///< dedicated queue for the worker commands
     util::ThreadPool::Ptr   _workerCommandPool;     ///< dedicated pool for executing worker commands
+    util::CommandQueue::Ptr _prebuildQueue;         ///< queue for building subchunk tables ahead of tasks
+    util::ThreadPool::Ptr   _prebuildPool;          ///< pool for building subchunk tables ahead of tasks
 
     mysql::MySqlConfig const        _mySqlConfig;
     wpublish::QueriesAndChunks::Ptr _queries;
+    wdb::TransmitConfig const       _transmitConfig;
+    wdb::TransmitMgr::Ptr           _transmitMgr;   ///< null if results.transmit_max_mb is 0
+    wdb::TransmitStage::Ptr         _transmitStage; ///< null if results.transmit_senders is 0
+    wpublish::ChunkInventory::Ptr   _chunkInventory;
+    wdb::ResultCache::Ptr           _resultCache;   ///< null if results.cache_mb is 0
+    mysql::MySqlConnectionPool::Ptr _connPool;      ///< null if mysql.pool is 0
+    unsigned int                    _statementCache{0}; ///< mysql.statement_cache
+    wsched::FairShareAdmission::Ptr _admission;     ///< null if fair-share admission is disabled
 };
 
 }}}  // namespace lsst::qserv::wcontrol
@@ -0,0 +1,142 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "wcontrol/MemPressureMonitor.h"
+
+// System headers
+#include <algorithm>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+namespace {
+LOG_LOGGER _log = LOG_GET("lsst.qserv.wcontrol.MemPressureMonitor");
+}
+
+namespace lsst {
+namespace qserv {
+namespace wcontrol {
+
+MemPressureMonitor::MemPressureMonitor(memman::MemMan::Ptr const& memMan, uint64_t maxBytes,
+                                       double pressureThreshold, PressureFunc const& pressureFunc,
+                                       std::chrono::milliseconds interval,
+                                       util::CgroupMemory const& cgroup)
+    : _memMan(memMan), _maxBytes(maxBytes), _pressureThreshold(pressureThreshold),
+      _pressureFunc(pressureFunc), _interval(interval), _cgroup(cgroup), _budget(maxBytes) {
+}
+
+
+MemPressureMonitor::~MemPressureMonitor() {
+    stop();
+}
+
+
+bool MemPressureMonitor::start() {
+    if (!_cgroup.isValid()) {
+        LOGS(_log, LOG_LVL_WARN, "not in a cgroup v2 hierarchy, memman budget stays fixed");
+        return false;
+    }
+    if (_thread.joinable()) {
+        return true;
+    }
+    LOGS(_log, LOG_LVL_INFO, "watching memory of " << _cgroup.getDir());
+    _thread = std::thread(&MemPressureMonitor::_run, this);
+    return true;
+}
+
+
+void MemPressureMonitor::stop() {
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _stop = true;
+    }
+    _cv.notify_all();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+
+void MemPressureMonitor::_run() {
+    std::unique_lock<std::mutex> lock(_mtx);
+    while (!_stop) {
+        lock.unlock();
+        update(_cgroup.read());
+        lock.lock();
+        _cv.wait_for(lock, _interval, [this]() { return _stop; });
+    }
+}
+
+
+void MemPressureMonitor::setMaxBytes(uint64_t maxBytes) {
+    _maxBytes = maxBytes;
+    uint64_t budget = _budget;
+    while (budget > maxBytes && !_budget.compare_exchange_weak(budget, maxBytes)) {}
+    if (budget > maxBytes) {
+        LOGS(_log, LOG_LVL_INFO, "memman budget " << budget << " -> " << maxBytes << " configured");
+        _memMan->setMaxBytes(maxBytes);
+    }
+}
+
+
+void MemPressureMonitor::update(util::CgroupMemory::Usage const& usage) {
+    if (!usage.valid) {
+        return;
+    }
+    uint64_t const budget = _budget;
+    uint64_t const maxBytes = _maxBytes;
+    uint64_t target = maxBytes;
+    if (usage.max > 0) {
+        // Memory charged to the cgroup that memman did not lock belongs to
+        // mysqld, result buffers and the page cache, leave it 5% headroom.
+        uint64_t const locked = _memMan->getStatistics().bytesLocked;
+        uint64_t const others = (usage.current > locked) ? usage.current - locked : 0;
+        uint64_t const needed = others + usage.max/20;
+        target = std::min(target, (usage.max > needed) ? usage.max - needed : 0);
+    }
+    bool const pressure = usage.someAvg10 >= _pressureThreshold;
+    if (pressure) {
+        target = std::min(target, budget - budget/4);
+    } else if (target > budget) {
+        target = std::min(target, budget + maxBytes/10);
+    }
+
+    if (target != budget) {
+        LOGS(_log, LOG_LVL_INFO, "memman budget " << budget << " -> " << target
+             << " current=" << usage.current << " max=" << usage.max
+             << " some avg10=" << usage.someAvg10);
+        _budget = target;
+        _memMan->setMaxBytes(target);
+    }
+    if (pressure != _underPressure) {
+        LOGS(_log, LOG_LVL_WARN, "memory pressure " << (pressure ? "started" : "ended")
+             << " some avg10=" << usage.someAvg10);
+        _underPressure = pressure;
+        if (_pressureFunc != nullptr) {
+            _pressureFunc(pressure);
+        }
+    }
+}
+
+}}} // namespace lsst::qserv::wcontrol
@@ -0,0 +1,123 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_QSERV_WCONTROL_MEMPRESSUREMONITOR_H
+#define LSST_QSERV_WCONTROL_MEMPRESSUREMONITOR_H
+
+// System headers
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Qserv headers
+#include "memman/MemMan.h"
+#include "util/CgroupMemory.h"
+
+namespace lsst {
+namespace qserv {
+namespace wcontrol {
+
+/// MemPressureMonitor periodically reads the memory usage, limit and pressure
+/// of the worker's cgroup and adjusts the memory memman may lock so the worker
+/// neither leaves memory unused nor gets killed when other processes on the
+/// node grow.
+/// - The budget never exceeds the configured size, nor what the cgroup limit
+///   leaves once the memory charged to the cgroup but not locked by memman and
+///   some headroom are taken out.
+/// - While the share of time tasks wait on memory is above the threshold, the
+///   budget shrinks by a quarter each interval and the pressure callback is
+///   called so that the scan schedulers work on fewer chunks. Once pressure
+///   drops, the budget grows back by a tenth of the configured size per interval.
+/// Lowering the budget first releases the chunks memman retained. Chunks locked
+/// for running queries are unlocked normally, and until the reserved memory fits
+/// the budget no new chunk is locked.
+class MemPressureMonitor {
+public:
+    using Ptr = std::shared_ptr<MemPressureMonitor>;
+    /// Called with true when pressure starts and false when it ends.
+    using PressureFunc = std::function<void(bool underPressure)>;
+
+    /// @param memMan - memory manager whose budget is adjusted.
+    /// @param maxBytes - configured budget, the budget never goes above it.
+    /// @param pressureThreshold - percent of time waiting on memory above which
+    ///                            the node is under pressure.
+    /// @param pressureFunc - called when pressure starts or ends, may be nullptr.
+    /// @param interval - time between two checks.
+    /// @param cgroup - cgroup to watch.
+    MemPressureMonitor(memman::MemMan::Ptr const& memMan, uint64_t maxBytes,
+                       double pressureThreshold, PressureFunc const& pressureFunc,
+                       std::chrono::milliseconds interval=std::chrono::seconds(5),
+                       util::CgroupMemory const& cgroup=util::CgroupMemory(util::CgroupMemory::selfDir()));
+
+    MemPressureMonitor(MemPressureMonitor const&) = delete;
+    MemPressureMonitor& operator=(MemPressureMonitor const&) = delete;
+
+    ~MemPressureMonitor();
+
+    /// Start checking in a thread of its own. Nothing is done if the worker
+    /// is not in a cgroup v2 hierarchy.
+    /// @return true if the thread was started.
+    bool start();
+
+    /// Stop checking, the budget is left as it was last set.
+    void stop();
+
+    /// Adjust the budget to 'usage'. This is what each check does.
+    void update(util::CgroupMemory::Usage const& usage);
+
+    /// Change the configured budget. A budget above it is lowered at once,
+    /// a budget below grows toward it with the next checks, once start()
+    /// succeeded.
+    void setMaxBytes(uint64_t maxBytes);
+    uint64_t getMaxBytes() const { return _maxBytes; }
+
+    uint64_t getBudget() const { return _budget; }
+    bool isUnderPressure() const { return _underPressure; }
+
+private:
+    void _run();
+
+    memman::MemMan::Ptr const _memMan;
+    std::atomic<uint64_t> _maxBytes;
+    double const _pressureThreshold;
+    PressureFunc const _pressureFunc;
+    std::chrono::milliseconds const _interval;
+    util::CgroupMemory const _cgroup;
+
+    std::atomic<uint64_t> _budget;
+    std::atomic<bool> _underPressure{false};
+
+    std::mutex _mtx; ///< Protects _stop.
+    std::condition_variable _cv;
+    bool _stop{false};
+    std::thread _thread;
+};
+
+}}} // namespace lsst::qserv::wcontrol
+
+#endif // LSST_QSERV_WCONTROL_MEMPRESSUREMONITOR_H
@@ -0,0 +1,195 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "wcontrol/RuntimeConfig.h"
+
+// System headers
+#include <cerrno>
+#include <cstdlib>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "wcontrol/MemPressureMonitor.h"
+#include "wsched/BlendScheduler.h"
+#include "wsched/ScanScheduler.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.wcontrol.RuntimeConfig");
+
+std::string const maxActivePrefix = "scheduler.maxactivechunks_";
+std::string const reservePrefix = "scheduler.reserve_";
+std::string const minutesPrefix = "scheduler.scanmaxminutes_";
+std::string const poolSizeName = "scheduler.thread_pool_size";
+std::string const memManName = "memman.memory";
+
+/// @return true if 'name' starts with 'prefix', with the rest in 'suffix'.
+bool splitName(std::string const& name, std::string const& prefix, std::string& suffix) {
+    if (name.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+    suffix = name.substr(prefix.size());
+    return true;
+}
+
+/// @return true if 'str' is a whole integer of at least 'minVal', stored in 'val'.
+bool toInt(std::string const& str, long long minVal, long long& val) {
+    if (str.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    errno = 0;
+    val = std::strtoll(str.c_str(), &end, 10);
+    return errno == 0 && *end == '\0' && val >= minVal;
+}
+
+} // annonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace wcontrol {
+
+RuntimeConfig::RuntimeConfig(std::shared_ptr<wsched::BlendScheduler> const& blend,
+                             std::map<std::string, std::shared_ptr<wsched::ScanScheduler>> const& scans,
+                             util::ThreadPool::Ptr const& pool, memman::MemMan::Ptr const& memMan,
+                             uint64_t memManSizeMb)
+    : _blend(blend), _pool(pool), _memMan(memMan), _memManSizeMb(memManSizeMb) {
+    for (auto const& elem : scans) {
+        _scans[elem.first] = Scan{elem.second, elem.second->getMaxActiveChunks()};
+    }
+}
+
+
+void RuntimeConfig::setMemPressureMonitor(std::shared_ptr<MemPressureMonitor> const& monitor) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _memPressureMonitor = monitor;
+}
+
+
+void RuntimeConfig::setUnderPressure(bool underPressure) {
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _underPressure = underPressure;
+        for (auto const& elem : _scans) {
+            _applyMaxActiveChunks(elem.second);
+        }
+    }
+    _blend->limitsChanged();
+}
+
+
+/// Precondition: _mtx must be held.
+void RuntimeConfig::_applyMaxActiveChunks(Scan const& scan) {
+    scan.sched->setMaxActiveChunks(_underPressure ? scan.maxActiveChunks/2 : scan.maxActiveChunks);
+}
+
+
+RuntimeConfig::Params RuntimeConfig::get() const {
+    Params params;
+    std::lock_guard<std::mutex> lock(_mtx);
+    for (auto const& elem : _scans) {
+        auto const& sched = elem.second.sched;
+        params[maxActivePrefix + elem.first] = std::to_string(elem.second.maxActiveChunks);
+        params[reservePrefix + elem.first] = std::to_string(sched->getMaxReserve());
+        params[minutesPrefix + elem.first] = std::to_string(static_cast<int>(sched->getMaxTimeMinutes()));
+    }
+    params[poolSizeName] = std::to_string(_pool->getTargetThrdCount());
+    params[memManName] = std::to_string(_memManSizeMb);
+    return params;
+}
+
+
+bool RuntimeConfig::set(Params const& params, std::string& error) {
+    std::lock_guard<std::mutex> lock(_mtx);
+
+    // Check every parameter before changing any.
+    std::map<std::string, long long> values;
+    for (auto const& elem : params) {
+        std::string const& name = elem.first;
+        std::string suffix;
+        long long minVal = 0;
+        if (splitName(name, maxActivePrefix, suffix) || splitName(name, minutesPrefix, suffix)) {
+            minVal = 1;
+        } else if (splitName(name, reservePrefix, suffix)) {
+            minVal = 0;
+        } else if (name == poolSizeName) {
+            minVal = wsched::BlendScheduler::getMinPoolSize();
+        } else if (name == memManName) {
+            minVal = 1;
+        } else {
+            error = "unknown parameter " + name;
+            return false;
+        }
+        if (!suffix.empty() && _scans.count(suffix) == 0) {
+            error = "unknown parameter " + name;
+            return false;
+        }
+        long long val = 0;
+        if (!toInt(elem.second, minVal, val)) {
+            error = "parameter " + name + " must be an integer of at least " + std::to_string(minVal)
+                    + ", not '" + elem.second + "'";
+            return false;
+        }
+        values[name] = val;
+    }
+
+    for (auto const& elem : values) {
+        std::string const& name = elem.first;
+        long long const val = elem.second;
+        LOGS(_log, LOG_LVL_INFO, "setting " << name << "=" << val);
+        std::string suffix;
+        if (splitName(name, maxActivePrefix, suffix)) {
+            Scan& scan = _scans[suffix];
+            scan.maxActiveChunks = val;
+            _applyMaxActiveChunks(scan);
+        } else if (splitName(name, reservePrefix, suffix)) {
+            _scans[suffix].sched->setMaxReserveDefault(val);
+        } else if (splitName(name, minutesPrefix, suffix)) {
+            _scans[suffix].sched->setMaxTimeMinutes(val);
+        } else if (name == poolSizeName) {
+            // The schedulers never hand out more Tasks than there are threads.
+            if (val < _pool->getTargetThrdCount()) {
+                _blend->setMaxThreads(val);
+                _pool->resize(val);
+            } else {
+                _pool->resize(val);
+                _blend->setMaxThreads(val);
+            }
+        } else if (name == memManName) {
+            _memManSizeMb = val;
+            uint64_t const bytes = _memManSizeMb*1000000;
+            if (_memPressureMonitor != nullptr) {
+                _memPressureMonitor->setMaxBytes(bytes);
+            } else {
+                _memMan->setMaxBytes(bytes);
+            }
+        }
+    }
+    _blend->limitsChanged();
+    return true;
+}
+
+}}} // namespace lsst::qserv::wcontrol
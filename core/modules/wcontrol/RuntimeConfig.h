@@ -0,0 +1,123 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_QSERV_WCONTROL_RUNTIMECONFIG_H
+#define LSST_QSERV_WCONTROL_RUNTIMECONFIG_H
+
+// System headers
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Qserv headers
+#include "memman/MemMan.h"
+#include "util/ThreadPool.h"
+
+// Forward declarations
+namespace lsst {
+namespace qserv {
+namespace wsched {
+    class BlendScheduler;
+    class ScanScheduler;
+}
+namespace wcontrol {
+    class MemPressureMonitor;
+}}} // End of forward declarations
+
+namespace lsst {
+namespace qserv {
+namespace wcontrol {
+
+/// RuntimeConfig changes the scheduler, thread pool and memman parameters of
+/// a running worker, so that it can be tuned without a restart dropping the
+/// scans in progress. The parameters go by their names in the worker
+/// configuration file:
+///   scheduler.maxactivechunks_<scan>, scheduler.reserve_<scan>,
+///   scheduler.scanmaxminutes_<scan>, scheduler.thread_pool_size, memman.memory
+/// where <scan> is one of the scan schedulers given to the constructor
+/// (fast, med, slow, snail).
+///
+/// Changes take effect with the next Task a scheduler hands out. Tasks
+/// running or holding locked tables are not affected: a smaller thread pool
+/// ends its threads as their Tasks finish, and a smaller memman budget
+/// locks no new chunk until the locked ones fit.
+class RuntimeConfig {
+public:
+    using Ptr = std::shared_ptr<RuntimeConfig>;
+    /// Values of parameters, by name.
+    using Params = std::map<std::string, std::string>;
+
+    /// @param blend - the scheduler of the thread pool.
+    /// @param scans - the scan schedulers, by the suffix of their parameter names.
+    /// @param pool - the threads running the Tasks.
+    /// @param memMan - the memory manager of the scan schedulers.
+    /// @param memManSizeMb - the configured memman budget.
+    RuntimeConfig(std::shared_ptr<wsched::BlendScheduler> const& blend,
+                  std::map<std::string, std::shared_ptr<wsched::ScanScheduler>> const& scans,
+                  util::ThreadPool::Ptr const& pool, memman::MemMan::Ptr const& memMan,
+                  uint64_t memManSizeMb);
+
+    RuntimeConfig(RuntimeConfig const&) = delete;
+    RuntimeConfig& operator=(RuntimeConfig const&) = delete;
+
+    /// Let 'monitor' keep the memman budget, under memman.memory.
+    void setMemPressureMonitor(std::shared_ptr<MemPressureMonitor> const& monitor);
+
+    /// Called by the MemPressureMonitor, the scan schedulers work on half as
+    /// many chunks as set while the worker is under memory pressure.
+    void setUnderPressure(bool underPressure);
+
+    /// @return the current value of every parameter.
+    Params get() const;
+
+    /// Change the parameters in 'params'. Nothing is changed unless every
+    /// one of them is known and has a valid value.
+    /// @param error - set to what is wrong when false is returned.
+    /// @return true if the parameters were changed.
+    bool set(Params const& params, std::string& error);
+
+private:
+    /// The parameters of a scan scheduler.
+    struct Scan {
+        std::shared_ptr<wsched::ScanScheduler> sched;
+        int maxActiveChunks; ///< As set, before halving under pressure.
+    };
+
+    void _applyMaxActiveChunks(Scan const& scan);
+
+    std::shared_ptr<wsched::BlendScheduler> const _blend;
+    util::ThreadPool::Ptr const _pool;
+    memman::MemMan::Ptr const _memMan;
+
+    mutable std::mutex _mtx; ///< Protects the members below.
+    std::map<std::string, Scan> _scans;
+    uint64_t _memManSizeMb;
+    bool _underPressure{false};
+    std::shared_ptr<MemPressureMonitor> _memPressureMonitor;
+};
+
+}}} // namespace lsst::qserv::wcontrol
+
+#endif // LSST_QSERV_WCONTROL_RUNTIMECONFIG_H
@@ -0,0 +1,93 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "wcontrol/WorkerCommandQueue.h"
+
+// System headers
+#include <algorithm>
+
+namespace lsst {
+namespace qserv {
+namespace wcontrol {
+
+WorkerCommandQueue::WorkerCommandQueue(unsigned int numThreads)
+    : _maxLow(std::max(1U, numThreads) - (numThreads > 1 ? 1 : 0)) {
+}
+
+void WorkerCommandQueue::queCmd(util::Command::Ptr const& cmd) {
+    {
+        std::lock_guard<std::mutex> lock(_mx);
+        _queues[_priorityOf(cmd)].push_back(cmd);
+    }
+    notify(false);
+}
+
+util::Command::Ptr WorkerCommandQueue::getCmd(bool wait) {
+    std::unique_lock<std::mutex> lock(_mx);
+    if (wait) {
+        _cv.wait(lock, [this]() { return _ready(); });
+    }
+    for (int priority = wbase::WorkerCommand::HIGH; priority <= wbase::WorkerCommand::LOW; ++priority) {
+        auto& queue = _queues[priority];
+        if (queue.empty()) continue;
+        if (priority == wbase::WorkerCommand::LOW) {
+            if (_runningLow >= _maxLow) break;
+            ++_runningLow;
+        }
+        auto cmd = queue.front();
+        queue.pop_front();
+        return cmd;
+    }
+    return nullptr;
+}
+
+size_t WorkerCommandQueue::size() {
+    std::lock_guard<std::mutex> lock(_mx);
+    size_t result = 0;
+    for (auto const& queue: _queues) result += queue.size();
+    return result;
+}
+
+void WorkerCommandQueue::commandFinish(util::Command::Ptr const& cmd) {
+    if (_priorityOf(cmd) != wbase::WorkerCommand::LOW) return;
+    {
+        std::lock_guard<std::mutex> lock(_mx);
+        --_runningLow;
+        if (_queues[wbase::WorkerCommand::LOW].empty()) return;
+    }
+    notify(false);
+}
+
+wbase::WorkerCommand::Priority WorkerCommandQueue::_priorityOf(util::Command::Ptr const& cmd) {
+    auto const workerCmd = std::dynamic_pointer_cast<wbase::WorkerCommand>(cmd);
+    return workerCmd == nullptr ? wbase::WorkerCommand::NORMAL : workerCmd->priority();
+}
+
+bool WorkerCommandQueue::_ready() const {
+    return not _queues[wbase::WorkerCommand::HIGH].empty() or
+           not _queues[wbase::WorkerCommand::NORMAL].empty() or
+           (not _queues[wbase::WorkerCommand::LOW].empty() and _runningLow < _maxLow);
+}
+
+}}} // namespace lsst::qserv::wcontrol
@@ -0,0 +1,80 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_QSERV_WCONTROL_WORKERCOMMANDQUEUE_H
+#define LSST_QSERV_WCONTROL_WORKERCOMMANDQUEUE_H
+
+// System headers
+#include <deque>
+#include <memory>
+
+// Qserv headers
+#include "util/EventThread.h"
+#include "wbase/WorkerCommand.h"
+
+namespace lsst {
+namespace qserv {
+namespace wcontrol {
+
+/// WorkerCommandQueue is the queue of the thread pool running the worker
+/// management commands, apart from the pool running the query tasks.
+/// Commands are taken in the order of their wbase::WorkerCommand::Priority,
+/// FIFO within a priority, and commands which aren't WorkerCommands have
+/// the NORMAL priority. The LOW priority commands never take the last
+/// thread of the pool, so that lookups and changes of the inventory of
+/// chunks aren't stuck behind rebuilds of the chunk lists.
+class WorkerCommandQueue : public util::CommandQueue {
+public:
+    using Ptr = std::shared_ptr<WorkerCommandQueue>;
+
+    /// @param numThreads - the number of threads of the pool taking commands
+    explicit WorkerCommandQueue(unsigned int numThreads);
+
+    WorkerCommandQueue() = delete;
+    WorkerCommandQueue(WorkerCommandQueue const&) = delete;
+    WorkerCommandQueue& operator=(WorkerCommandQueue const&) = delete;
+
+    ~WorkerCommandQueue() override = default;
+
+    void queCmd(util::Command::Ptr const& cmd) override;
+    util::Command::Ptr getCmd(bool wait=true) override;
+    size_t size() override;
+    void commandFinish(util::Command::Ptr const& cmd) override;
+
+private:
+    /// @return the priority of 'cmd'
+    static wbase::WorkerCommand::Priority _priorityOf(util::Command::Ptr const& cmd);
+
+    /// @return true if a command may be taken now. _mx must be held.
+    bool _ready() const;
+
+    unsigned int const _maxLow; ///< Maximum number of LOW priority commands running.
+    unsigned int _runningLow{0}; ///< Number of LOW priority commands running, protected by _mx.
+
+    /// Queued commands by priority, protected by _mx.
+    std::deque<util::Command::Ptr> _queues[wbase::WorkerCommand::LOW + 1];
+};
+
+}}} // namespace lsst::qserv::wcontrol
+
+#endif // LSST_QSERV_WCONTROL_WORKERCOMMANDQUEUE_H
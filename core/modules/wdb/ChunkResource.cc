@@ -35,6 +35,7 @@
 // System headers
 #include <cstddef>
 #include <mutex>
+#include <tuple>
 
 // Third-party headers
 #include "boost/format.hpp"
@@ -193,8 +194,9 @@ public:
 
 
     /// Acquire a resource, loading if needed
+    /// @param reused - receives the tables that were loaded but unused.
     void acquire(std::string const& db, DbTableSet const& dbTableSet,
-                 IntVector const& sc, SQLBackend::Ptr backend) {
+                 IntVector const& sc, SQLBackend::Ptr backend, ScTableVector& reused) {
         ScTableVector needed;
         std::lock_guard<std::mutex> lock(_mutex);
         backend->memLockRequireOwnership();
@@ -213,6 +215,9 @@ public:
                     needed.push_back(ScTable(_chunkId, dbTbl, *i));
                 } else {
                     last = it->second;
+                    if (last == 0) {
+                        reused.push_back(ScTable(_chunkId, dbTbl, *i));
+                    }
                 }
                 scm[*i] = last + 1; // write new value
             } // All subchunks
@@ -231,33 +236,33 @@ public:
     }
 
 
-    /// Release a resource, flushing if no more users need it.
+    /// Release a resource. The caller decides whether to flush the tables no
+    /// more users need.
+    /// @param idle - receives the tables that are no longer used.
     void release(std::string const& db, DbTableSet const& dbTableSet,
-                 IntVector const& sc, SQLBackend::Ptr backend) {
-        {
-            std::lock_guard<std::mutex> lock(_mutex);
-            backend->memLockRequireOwnership();
-            StringVector::const_iterator ti, te;
-            LOGS(_log, LOG_LVL_DEBUG, "SubChunk release refC=" << _refCount
-                    << " db=" << db
-                    << " dbTableSet[" << util::printable(dbTableSet) << "]"
-                    << " sc[" << util::printable(sc) << "]");
-            for(auto const& dbTbl : dbTableSet) {
-                SubChunkMap& scm = _tableMap[dbTbl]; // Should be in there.
-                IntVector::const_iterator i, e;
-                for(i=sc.begin(), e=sc.end(); i != e; ++i) {
-                    SubChunkMap::iterator it = scm.find(*i); // Should be there
-                    if (it == scm.end()) {
-                        throw Bug("ChunkResource ChunkEntry::release: Error releasing un-acquired resource");
-                    }
-                    scm[*i] = it->second - 1; // write new value
-                } // All subchunks
-            } // All tables
-            --_refCount;
-        }
-        flush(db, backend); // Discard resources no longer needed by anyone.
-        // flush could be detached from the release function, to be called at a
-        // high-water mark and/or on periodic intervals
+                 IntVector const& sc, SQLBackend::Ptr backend, ScTableVector& idle) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        backend->memLockRequireOwnership();
+        StringVector::const_iterator ti, te;
+        LOGS(_log, LOG_LVL_DEBUG, "SubChunk release refC=" << _refCount
+                << " db=" << db
+                << " dbTableSet[" << util::printable(dbTableSet) << "]"
+                << " sc[" << util::printable(sc) << "]");
+        for(auto const& dbTbl : dbTableSet) {
+            SubChunkMap& scm = _tableMap[dbTbl]; // Should be in there.
+            IntVector::const_iterator i, e;
+            for(i=sc.begin(), e=sc.end(); i != e; ++i) {
+                SubChunkMap::iterator it = scm.find(*i); // Should be there
+                if (it == scm.end()) {
+                    throw Bug("ChunkResource ChunkEntry::release: Error releasing un-acquired resource");
+                }
+                scm[*i] = it->second - 1; // write new value
+                if (it->second == 0) {
+                    idle.push_back(ScTable(_chunkId, dbTbl, *i));
+                }
+            } // All subchunks
+        } // All tables
+        --_refCount;
     }
 
     /// Flush resources no longer needed by anybody
@@ -292,13 +297,29 @@ public:
     }
 
 
+    /// Discard a table if nobody uses it.
+    void discardUnused(ScTable const& scTable, SQLBackend::Ptr backend) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        backend->memLockRequireOwnership();
+        SubChunkMap& scm = _tableMap[scTable.dbTable];
+        SubChunkMap::iterator it = scm.find(scTable.subChunkId);
+        if (it == scm.end() || it->second != 0) {
+            return;
+        }
+        scm.erase(it);
+        backend->discard(ScTableVector{scTable});
+    }
+
 private:
     void _release(ScTableVector const& needed) {
         // _mutex should be held.
-        // Release subChunkId for the right table
+        // Release subChunkId for the right table. The tables were not loaded,
+        // so they are forgotten rather than left for a flush or the cache.
         for(auto const& elem : needed) {
             SubChunkMap& scm = _tableMap[elem.dbTable];
-            --scm[elem.subChunkId];
+            if (--scm[elem.subChunkId] == 0) {
+                scm.erase(elem.subChunkId);
+            }
         }
     }
 
@@ -314,9 +335,16 @@ private:
 // ChunkResourceMgr
 ////////////////////////////////////////////////////////////////////////
 
-ChunkResourceMgr::Ptr ChunkResourceMgr::newMgr(SQLBackend::Ptr const& backend) {
+ChunkResourceMgr::Ptr ChunkResourceMgr::newMgr(SQLBackend::Ptr const& backend,
+                                              size_t maxCachedSubChunks) {
     //return std::shared_ptr<ChunkResourceMgr>(new Impl(backend));
-    return std::make_shared<ChunkResourceMgr>(backend);
+    return std::make_shared<ChunkResourceMgr>(backend, maxCachedSubChunks);
+}
+
+
+bool ChunkResourceMgr::CacheKey::operator<(CacheKey const& rhs) const {
+    return std::tie(db, scTable.chunkId, scTable.dbTable, scTable.subChunkId)
+        < std::tie(rhs.db, rhs.scTable.chunkId, rhs.scTable.dbTable, rhs.scTable.subChunkId);
 }
 
 
@@ -339,7 +367,18 @@ void ChunkResourceMgr::release(ChunkResource::Info const& i) {
      std::lock_guard<std::mutex> lock(_mapMutex);
      Map& map = _getMap(i.db);
      ChunkEntry& ce = _getChunkEntry(map, i.chunkId);
-     ce.release(i.db, i.tables, i.subChunkIds, _backend);
+     ScTableVector idle;
+     ce.release(i.db, i.tables, i.subChunkIds, _backend, idle);
+     if (_maxCached == 0) {
+         ce.flush(i.db, _backend); // Discard resources no longer needed by anyone.
+         return;
+     }
+     for (auto const& scTable : idle) {
+         CacheKey key(i.db, scTable);
+         _cached.push_front(key);
+         _cachedIndex[key] = _cached.begin();
+     }
+     _evictCached();
 }
 
 
@@ -349,7 +388,47 @@ void ChunkResourceMgr::acquireUnit(ChunkResource::Info const& i) {
     ChunkEntry& ce = _getChunkEntry(map, i.chunkId);
     // Actually acquire
     LOGS(_log, LOG_LVL_DEBUG, "acquireUnit info=" << i);
-    ce.acquire(i.db, i.tables, i.subChunkIds, _backend);
+    ScTableVector reused;
+    ce.acquire(i.db, i.tables, i.subChunkIds, _backend, reused);
+    // Tables in use are no longer candidates for eviction.
+    for (auto const& scTable : reused) {
+        auto it = _cachedIndex.find(CacheKey(i.db, scTable));
+        if (it != _cachedIndex.end()) {
+            _cached.erase(it->second);
+            _cachedIndex.erase(it);
+        }
+    }
+}
+
+
+void ChunkResourceMgr::prebuild(std::string const& db, int chunkId,
+                                DbTableSet const& dbTableSet, IntVector const& subChunks) {
+    if (dbTableSet.size() * subChunks.size() > _maxCached) {
+        return;
+    }
+    LOGS(_log, LOG_LVL_DEBUG, "prebuild db=" << db << " chunkId=" << chunkId
+         << " subChunks=" << util::printable(subChunks));
+    // The reservation is released right away, leaving the tables in the cache.
+    acquire(db, chunkId, dbTableSet, subChunks);
+}
+
+
+size_t ChunkResourceMgr::getCachedCount() {
+    std::lock_guard<std::mutex> lock(_mapMutex);
+    return _cached.size();
+}
+
+
+void ChunkResourceMgr::_evictCached() {
+    while (_cached.size() > _maxCached) {
+        CacheKey const& key = _cached.back();
+        LOGS(_log, LOG_LVL_DEBUG, "evict db=" << key.db << " chunkId=" << key.scTable.chunkId
+             << " table=" << key.scTable.dbTable << " subChunk=" << key.scTable.subChunkId);
+        ChunkEntry& ce = _getChunkEntry(_getMap(key.db), key.scTable.chunkId);
+        ce.discardUnused(key.scTable, _backend);
+        _cachedIndex.erase(key);
+        _cached.pop_back();
+    }
 }
 
 
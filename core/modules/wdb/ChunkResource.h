@@ -34,6 +34,8 @@
 
 // System headers
 #include <deque>
+#include <list>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <ostream>
@@ -93,6 +95,10 @@ private:
 
 
 /// ChunkResourceMgr is a lightweight manager for holding reservations on subchunks.
+/// Subchunk tables that nobody needs are dropped, unless a cache budget is set.
+/// Then up to that many unused subchunk tables are kept, and the least
+/// recently used ones are dropped first, so that the queries of the next
+/// tasks on the same chunk do not have to build them again.
 class ChunkResourceMgr {
 public:
     using Ptr = std::shared_ptr<ChunkResourceMgr>;
@@ -100,8 +106,11 @@ public:
     typedef std::map<std::string, Map> DbMap;
 
     /// Factory
-    static Ptr newMgr(SQLBackend::Ptr const& backend);
-    ChunkResourceMgr(SQLBackend::Ptr const& backend) : _backend(backend) {}
+    /// @param maxCachedSubChunks - number of unused subchunk tables to keep,
+    ///                             0 drops them as soon as they are unused.
+    static Ptr newMgr(SQLBackend::Ptr const& backend, size_t maxCachedSubChunks=0);
+    ChunkResourceMgr(SQLBackend::Ptr const& backend, size_t maxCachedSubChunks=0)
+        : _backend(backend), _maxCached(maxCachedSubChunks) {}
     virtual ~ChunkResourceMgr() {}
 
     /// Reserve a chunk. Currently, this does not result in any explicit chunk
@@ -132,7 +141,29 @@ public:
     /// @return the reference count for the database and chunkId.
     int getRefCount(std::string const& db, int chunkId);
 
+    /// Build the subchunk tables before the tasks that need them run and
+    /// leave them in the cache. Does nothing if the cache could not hold them.
+    void prebuild(std::string const& db, int chunkId,
+                  DbTableSet const& dbTableSet, IntVector const& subChunks);
+
+    /// @return the number of unused subchunk tables in the cache.
+    size_t getCachedCount();
+
 private:
+    /// An unused subchunk table in the cache.
+    struct CacheKey {
+        CacheKey(std::string const& db_, ScTable const& scTable_) : db(db_), scTable(scTable_) {}
+        bool operator<(CacheKey const& rhs) const;
+
+        std::string db; ///< Database of the ChunkEntry holding the table.
+        ScTable scTable;
+    };
+    using CacheList = std::list<CacheKey>;
+
+    /// precondition: _mapMutex is held (locked by the caller)
+    /// Drop the least recently used tables until the cache fits its budget.
+    void _evictCached();
+
     /// precondition: _mapMutex is held (locked by the caller)
     /// Get the ChunkEntry map for a db, creating if necessary
     Map& _getMap(std::string const& db);
@@ -146,6 +177,10 @@ private:
     // a problem.
     std::shared_ptr<SQLBackend> _backend;
     std::mutex _mapMutex; // Do not alter map without this mutex
+
+    size_t const _maxCached; ///< Budget of the cache, in subchunk tables.
+    CacheList _cached; ///< Unused subchunk tables, most recently used first.
+    std::map<CacheKey, CacheList::iterator> _cachedIndex; ///< Entries of _cached.
 };
 
 }}} // namespace lsst::qserv::wdb
@@ -0,0 +1,325 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "wdb/ColumnarFile.h"
+
+// System headers
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Third-party headers
+#include <mysql/mysql.h>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "mysql/MySqlConnection.h"
+#include "mysql/SchemaFactory.h"
+#include "sql/Schema.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.wdb.ColumnarFile");
+
+char const MAGIC[8] = {'Q', 'S', 'V', 'C', 'O', 'L', '0', '1'};
+uint32_t const FLAG_COMPLETE = 1;
+
+struct FileHeader {
+    char magic[8];
+    uint64_t numRows;
+    uint32_t numCols;
+    uint32_t flags;
+    uint64_t dataOffset; ///< Start of the values of the first column
+};
+
+/// Followed by the name and the sqlType.
+struct ColumnHeader {
+    uint8_t type;
+    uint8_t hasNulls;
+    uint16_t nameLen;
+    int32_t mysqlType;
+    uint32_t sqlTypeLen;
+};
+
+uint64_t align8(uint64_t n) { return (n + 7) & ~uint64_t(7); }
+
+size_t valueSize(lsst::qserv::wdb::ColumnarFile::Type type) {
+    return type == lsst::qserv::wdb::ColumnarFile::Type::FLOAT ? sizeof(float) : 8;
+}
+
+} // anonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace wdb {
+
+ColumnarFile::~ColumnarFile() {
+    if (_addr != nullptr) {
+        munmap(_addr, _size);
+    }
+}
+
+
+std::string ColumnarFile::pathFor(std::string const& dir, std::string const& db, std::string const& table) {
+    return dir + "/" + db + "/" + table + ".qcol";
+}
+
+
+ColumnarFile::Ptr ColumnarFile::open(std::string const& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+        ::close(fd);
+        return nullptr;
+    }
+    std::shared_ptr<ColumnarFile> file(new ColumnarFile());
+    file->_size = st.st_size;
+    void* addr = mmap(nullptr, file->_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        LOGS(_log, LOG_LVL_WARN, "ColumnarFile could not map " << path);
+        return nullptr;
+    }
+    file->_addr = addr;
+
+    char const* base = static_cast<char const*>(addr);
+    FileHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.dataOffset > file->_size) {
+        LOGS(_log, LOG_LVL_WARN, "ColumnarFile invalid header " << path);
+        return nullptr;
+    }
+    file->_numRows = header.numRows;
+    file->_complete = (header.flags & FLAG_COMPLETE) != 0;
+
+    uint64_t pos = sizeof(FileHeader);
+    uint64_t dataPos = header.dataOffset;
+    uint64_t const bitmapSize = align8((header.numRows + 7) / 8);
+    for (uint32_t j = 0; j < header.numCols; ++j) {
+        ColumnHeader ch;
+        if (pos + sizeof(ch) > header.dataOffset) {
+            LOGS(_log, LOG_LVL_WARN, "ColumnarFile truncated columns " << path);
+            return nullptr;
+        }
+        std::memcpy(&ch, base + pos, sizeof(ch));
+        pos += sizeof(ch);
+        if (pos + ch.nameLen + ch.sqlTypeLen > header.dataOffset
+            || ch.type < uint8_t(Type::INT64) || ch.type > uint8_t(Type::FLOAT)) {
+            LOGS(_log, LOG_LVL_WARN, "ColumnarFile invalid column " << j << " " << path);
+            return nullptr;
+        }
+        Column col;
+        col.name.assign(base + pos, ch.nameLen);
+        pos += ch.nameLen;
+        col.sqlType.assign(base + pos, ch.sqlTypeLen);
+        pos += ch.sqlTypeLen;
+        col.type = Type(ch.type);
+        col.mysqlType = ch.mysqlType;
+        uint64_t const valuesSize = align8(header.numRows * valueSize(col.type));
+        uint64_t const end = dataPos + valuesSize + (ch.hasNulls ? bitmapSize : 0);
+        if (end > file->_size) {
+            LOGS(_log, LOG_LVL_WARN, "ColumnarFile truncated values " << path);
+            return nullptr;
+        }
+        col.values = base + dataPos;
+        if (ch.hasNulls) {
+            col.nulls = reinterpret_cast<uint8_t const*>(base + dataPos + valuesSize);
+        }
+        dataPos = end;
+        file->_columns.push_back(col);
+    }
+    return file;
+}
+
+
+bool ColumnarFile::write(std::string const& path, std::vector<ColumnData> const& columns,
+                         uint64_t numRows, bool complete, std::string& err) {
+    std::string header(sizeof(FileHeader), '\0');
+    for (auto const& data : columns) {
+        Column const& col = data.column;
+        size_t const n = (col.type == Type::INT64) ? data.ints.size()
+                       : (col.type == Type::DOUBLE) ? data.doubles.size() : data.floats.size();
+        if (n != numRows || (!data.nulls.empty() && data.nulls.size() != numRows)) {
+            err = "column " + col.name + " does not have " + std::to_string(numRows) + " rows";
+            return false;
+        }
+        ColumnHeader ch;
+        ch.type = uint8_t(col.type);
+        ch.hasNulls = data.nulls.empty() ? 0 : 1;
+        ch.nameLen = col.name.size();
+        ch.mysqlType = col.mysqlType;
+        ch.sqlTypeLen = col.sqlType.size();
+        header.append(reinterpret_cast<char const*>(&ch), sizeof(ch));
+        header += col.name;
+        header += col.sqlType;
+    }
+    header.resize(align8(header.size()), '\0');
+    FileHeader fh;
+    std::memcpy(fh.magic, MAGIC, sizeof(MAGIC));
+    fh.numRows = numRows;
+    fh.numCols = columns.size();
+    fh.flags = complete ? FLAG_COMPLETE : 0;
+    fh.dataOffset = header.size();
+    std::memcpy(&header[0], &fh, sizeof(fh));
+
+    // Write to a temporary file first, so that scans never see a partial file.
+    std::string const tmpPath = path + ".tmp";
+    FILE* out = std::fopen(tmpPath.c_str(), "wb");
+    if (out == nullptr) {
+        err = "cannot create " + tmpPath;
+        return false;
+    }
+    bool ok = std::fwrite(header.data(), 1, header.size(), out) == header.size();
+    std::string const zeros(8, '\0');
+    auto writePadded = [out, &ok, &zeros](void const* data, size_t size) {
+        if (size > 0) {
+            ok = ok && std::fwrite(data, 1, size, out) == size;
+        }
+        size_t pad = align8(size) - size;
+        ok = ok && (pad == 0 || std::fwrite(zeros.data(), 1, pad, out) == pad);
+    };
+    for (auto const& data : columns) {
+        switch (data.column.type) {
+        case Type::INT64: writePadded(data.ints.data(), numRows * sizeof(int64_t)); break;
+        case Type::DOUBLE: writePadded(data.doubles.data(), numRows * sizeof(double)); break;
+        case Type::FLOAT: writePadded(data.floats.data(), numRows * sizeof(float)); break;
+        }
+        if (!data.nulls.empty()) {
+            std::vector<uint8_t> bitmap((numRows + 7) / 8, 0);
+            for (uint64_t row = 0; row < numRows; ++row) {
+                if (data.nulls[row]) {
+                    bitmap[row >> 3] |= 1 << (row & 7);
+                }
+            }
+            writePadded(bitmap.data(), bitmap.size());
+        }
+    }
+    ok = (std::fclose(out) == 0) && ok;
+    if (!ok || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        err = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+
+bool ColumnarFile::buildFromMySql(mysql::MySqlConnection& conn, std::string const& db,
+                                  std::string const& table, std::string const& path, std::string& err) {
+    std::string const query = "SELECT * FROM `" + db + "`.`" + table + "`";
+    if (!conn.queryUnbuffered(query)) {
+        err = conn.getError();
+        return false;
+    }
+    MYSQL_RES* res = conn.getResult();
+    sql::Schema schema = mysql::SchemaFactory::newFromResult(res);
+    MYSQL_FIELD* fields = mysql_fetch_fields(res);
+    unsigned int const numFields = mysql_num_fields(res);
+
+    // Only the columns whose text form can be reproduced exactly are kept.
+    std::vector<ColumnData> columns;
+    std::vector<int> fieldOf;
+    for (unsigned int j = 0; j < numFields; ++j) {
+        ColumnData data;
+        switch (fields[j].type) {
+        case MYSQL_TYPE_TINY:
+        case MYSQL_TYPE_SHORT:
+        case MYSQL_TYPE_LONG:
+        case MYSQL_TYPE_INT24:
+            data.column.type = Type::INT64;
+            break;
+        case MYSQL_TYPE_LONGLONG:
+            if (fields[j].flags & UNSIGNED_FLAG) {
+                continue; // May not fit
+            }
+            data.column.type = Type::INT64;
+            break;
+        case MYSQL_TYPE_DOUBLE:
+            data.column.type = Type::DOUBLE;
+            break;
+        case MYSQL_TYPE_FLOAT:
+            data.column.type = Type::FLOAT;
+            break;
+        default:
+            continue;
+        }
+        data.column.name = schema.columns[j].name;
+        data.column.mysqlType = schema.columns[j].colType.mysqlType;
+        data.column.sqlType = schema.columns[j].colType.sqlType;
+        columns.push_back(data);
+        fieldOf.push_back(j);
+    }
+    bool const complete = (columns.size() == numFields);
+
+    uint64_t numRows = 0;
+    std::vector<bool> hasNull(columns.size(), false);
+    MYSQL_ROW row;
+    while ((row = mysql_fetch_row(res))) {
+        for (size_t c = 0; c < columns.size(); ++c) {
+            ColumnData& data = columns[c];
+            char const* str = row[fieldOf[c]];
+            if (str == nullptr) {
+                if (!hasNull[c]) {
+                    hasNull[c] = true;
+                    data.nulls.assign(numRows, false);
+                }
+            }
+            if (hasNull[c]) {
+                data.nulls.push_back(str == nullptr);
+            }
+            switch (data.column.type) {
+            case Type::INT64: data.ints.push_back(str ? std::strtoll(str, nullptr, 10) : 0); break;
+            case Type::DOUBLE: data.doubles.push_back(str ? std::strtod(str, nullptr) : 0.0); break;
+            case Type::FLOAT: data.floats.push_back(str ? std::strtof(str, nullptr) : 0.0f); break;
+            }
+        }
+        ++numRows;
+    }
+    conn.freeResult();
+    LOGS(_log, LOG_LVL_INFO, "ColumnarFile " << path << " rows=" << numRows
+         << " columns=" << columns.size() << "/" << numFields);
+    return write(path, columns, numRows, complete, err);
+}
+
+
+ColumnarFile::Column const* ColumnarFile::find(std::string const& name) const {
+    for (auto const& col : _columns) {
+        if (strcasecmp(col.name.c_str(), name.c_str()) == 0) {
+            return &col;
+        }
+    }
+    return nullptr;
+}
+
+}}} // namespace lsst::qserv::wdb
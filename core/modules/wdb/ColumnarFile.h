@@ -0,0 +1,123 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_WDB_COLUMNARFILE_H
+#define LSST_QSERV_WDB_COLUMNARFILE_H
+
+// System headers
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Forward declarations
+namespace lsst {
+namespace qserv {
+namespace mysql {
+    class MySqlConnection;
+}}} // End of forward declarations
+
+namespace lsst {
+namespace qserv {
+namespace wdb {
+
+/// ColumnarFile is a read-only copy of the numeric columns of a chunk table,
+/// kept next to it so that simple scans can be answered without MySQL, see
+/// NativeScan. The values of each column are stored one after the other,
+/// followed by a bitmap of the NULL values if there are any. The file is
+/// mapped into memory and read in place.
+///
+/// Files are written with the byte order of the host, by write() or by
+/// buildFromMySql() when the chunk table is loaded or replicated.
+class ColumnarFile {
+public:
+    using Ptr = std::shared_ptr<ColumnarFile const>;
+
+    enum class Type : uint8_t { INT64 = 1, DOUBLE = 2, FLOAT = 3 };
+
+    /// A column, with its type in MySQL for the result schema.
+    struct Column {
+        std::string name;
+        Type type{Type::INT64};
+        int mysqlType{0};      ///< MYSQL_TYPE_* of the table column
+        std::string sqlType;   ///< Type of the table column as given by mysql::SchemaFactory
+        void const* values{nullptr}; ///< numRows values of 'type', set when read
+        uint8_t const* nulls{nullptr}; ///< Bit i set if row i is NULL, nullptr if there are no NULLs
+
+        int64_t const* ints() const { return static_cast<int64_t const*>(values); }
+        double const* doubles() const { return static_cast<double const*>(values); }
+        float const* floats() const { return static_cast<float const*>(values); }
+        bool isNull(uint64_t row) const { return nulls != nullptr && (nulls[row >> 3] >> (row & 7)) & 1; }
+    };
+
+    /// Values of a column to write.
+    struct ColumnData {
+        Column column; ///< values and nulls are ignored
+        std::vector<int64_t> ints;
+        std::vector<double> doubles;
+        std::vector<float> floats;
+        std::vector<bool> nulls; ///< Empty if there are no NULLs
+    };
+
+    ~ColumnarFile();
+    ColumnarFile(ColumnarFile const&) = delete;
+    ColumnarFile& operator=(ColumnarFile const&) = delete;
+
+    /// @return the file at 'path', or nullptr if it is missing or invalid.
+    static Ptr open(std::string const& path);
+
+    /// Write 'columns', all holding 'numRows' values, to 'path'.
+    /// @param complete - true if 'columns' are all the columns of the table.
+    /// @return false with 'err' set on failure.
+    static bool write(std::string const& path, std::vector<ColumnData> const& columns,
+                      uint64_t numRows, bool complete, std::string& err);
+
+    /// Write the integer, FLOAT and DOUBLE columns of 'db'.'table' to 'path'.
+    /// Other columns are left out, and the file is not complete.
+    /// @return false with 'err' set on failure.
+    static bool buildFromMySql(mysql::MySqlConnection& conn, std::string const& db,
+                               std::string const& table, std::string const& path, std::string& err);
+
+    /// @return the path of the file for 'db'.'table' under 'dir'.
+    static std::string pathFor(std::string const& dir, std::string const& db, std::string const& table);
+
+    uint64_t getNumRows() const { return _numRows; }
+    bool isComplete() const { return _complete; } ///< @return true if the file has all the table columns.
+    std::vector<Column> const& getColumns() const { return _columns; }
+
+    /// @return the column named 'name', ignoring case as MySQL does, or nullptr.
+    Column const* find(std::string const& name) const;
+
+private:
+    ColumnarFile() = default;
+
+    void* _addr{nullptr};
+    size_t _size{0};
+    uint64_t _numRows{0};
+    bool _complete{false};
+    std::vector<Column> _columns;
+};
+
+}}} // namespace lsst::qserv::wdb
+
+#endif // LSST_QSERV_WDB_COLUMNARFILE_H
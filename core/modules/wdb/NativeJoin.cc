@@ -0,0 +1,746 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "wdb/NativeJoin.h"
+
+// System headers
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <strings.h>
+
+// Third-party headers
+#include <mysql/mysql.h>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "global/constants.h"
+#include "proto/worker.pb.h"
+#include "util/NumberFormat.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.wdb.NativeJoin");
+
+double const RAD_PER_DEG = M_PI / 180.0;
+double const DEG_PER_RAD = 180.0 / M_PI;
+
+/// The angular separation in degrees of two positions given in degrees, as
+/// computed by scisql_angSep.
+double angSep(double ra1, double decl1, double ra2, double decl2) {
+    double x = std::sin((ra1 - ra2) * RAD_PER_DEG * 0.5);
+    x *= x;
+    double y = std::sin((decl1 - decl2) * RAD_PER_DEG * 0.5);
+    y *= y;
+    double z = std::cos((decl1 + decl2) * RAD_PER_DEG * 0.5);
+    z *= z;
+    return 2.0 * std::asin(std::sqrt(x * (z - y) + y)) * DEG_PER_RAD;
+}
+
+/// Set mask[k] to 1 for the points k within the chord length whose square is
+/// 'chord2' of (x, y, z). It is kept free of branches so that it vectorizes.
+void chordKernel(double x, double y, double z, double const* xs, double const* ys, double const* zs,
+                 size_t n, double chord2, uint8_t* mask) {
+    for (size_t k = 0; k < n; ++k) {
+        double const dx = xs[k] - x;
+        double const dy = ys[k] - y;
+        double const dz = zs[k] - z;
+        mask[k] = (dx * dx + dy * dy + dz * dz <= chord2);
+    }
+}
+
+double realValue(lsst::qserv::wdb::ColumnarFile::Column const& col, uint64_t row) {
+    switch (col.type) {
+    case lsst::qserv::wdb::ColumnarFile::Type::INT64: return static_cast<double>(col.ints()[row]);
+    case lsst::qserv::wdb::ColumnarFile::Type::DOUBLE: return col.doubles()[row];
+    case lsst::qserv::wdb::ColumnarFile::Type::FLOAT: return col.floats()[row];
+    }
+    return 0.0;
+}
+
+template <typename T>
+bool compare(T a, lsst::qserv::wdb::NativeParser::Op op, T b) {
+    using Op = lsst::qserv::wdb::NativeParser::Op;
+    switch (op) {
+    case Op::EQ: return a == b;
+    case Op::NE: return a != b;
+    case Op::LT: return a < b;
+    case Op::LE: return a <= b;
+    case Op::GT: return a > b;
+    case Op::GE: return a >= b;
+    }
+    return false;
+}
+
+/// @return true if 'lon' is in [lonMin, lonMax], all in degrees, the range
+///         wrapping around 0 if lonMin > lonMax as for scisql_s2PtInBox.
+bool inLonRange(double lon, double lonMin, double lonMax) {
+    if (lonMax - lonMin >= 360.0) {
+        return true;
+    }
+    auto reduce = [](double a) {
+        a = std::fmod(a, 360.0);
+        return a < 0.0 ? a + 360.0 : a;
+    };
+    lon = reduce(lon);
+    lonMin = reduce(lonMin);
+    lonMax = reduce(lonMax);
+    if (lonMin <= lonMax) {
+        return lon >= lonMin && lon <= lonMax;
+    }
+    return lon >= lonMin || lon <= lonMax;
+}
+
+/// Split the subchunk table 'db'.'table', as in Subchunks_LSST_100.Object_100_5,
+/// into the chunk or overlap table it was made from and the subchunk.
+/// @return false if it is not a subchunk table.
+bool splitSubChunkTable(std::string const& db, std::string const& table, std::string& chunkDb,
+                        std::string& chunkTable, int64_t& subChunkId) {
+    std::string const prefix = lsst::qserv::SUBCHUNKDB_PREFIX;
+    if (db.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+    size_t const dbSep = db.rfind('_');
+    size_t const subSep = table.rfind('_');
+    if (dbSep == std::string::npos || dbSep < prefix.size() || subSep == std::string::npos) {
+        return false;
+    }
+    std::string const chunk = db.substr(dbSep + 1);
+    std::string const sub = table.substr(subSep + 1);
+    if (chunk.empty() || sub.empty() || chunk.find_first_not_of("0123456789") != std::string::npos
+        || sub.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    chunkTable = table.substr(0, subSep);
+    if (chunkTable.size() <= chunk.size() + 1
+        || chunkTable.compare(chunkTable.size() - chunk.size() - 1, std::string::npos, "_" + chunk) != 0) {
+        return false;
+    }
+    chunkDb = db.substr(prefix.size(), dbSep - prefix.size());
+    subChunkId = std::strtoll(sub.c_str(), nullptr, 10);
+    return !chunkDb.empty();
+}
+
+} // anonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace wdb {
+
+/// Recursive descent parser for the queries NativeJoin can run. Column
+/// references are only checked against the files once the tables are known.
+class NativeJoin::Parser : public NativeParser {
+public:
+    struct Distance {
+        ColumnRef ra1;
+        ColumnRef decl1;
+        ColumnRef ra2;
+        ColumnRef decl2;
+    };
+    struct SelectItem {
+        Output::Kind kind;
+        ColumnRef col;
+        Distance dist;
+        std::string name;
+    };
+    struct TableRef {
+        std::string db;
+        std::string table;
+        std::string alias;
+    };
+    struct Comparison {
+        ColumnRef col;
+        Op op;
+        Literal lit;
+    };
+    struct ColumnComparison {
+        ColumnRef left;
+        Op op;
+        ColumnRef right;
+    };
+    struct Box {
+        ColumnRef ra;
+        ColumnRef decl;
+        std::vector<double> bounds;
+    };
+
+    explicit Parser(std::vector<Token> const& tokens) : NativeParser(tokens) {}
+
+    bool parse() {
+        if (!_keyword("SELECT")) {
+            return false;
+        }
+        do {
+            SelectItem item;
+            if (_function("COUNT")) {
+                if (!_symbol("(") || !_symbol("*") || !_symbol(")")) {
+                    return false;
+                }
+                item.kind = Output::COUNT;
+            } else if (_function("scisql_angSep")) {
+                if (!_distance(item.dist)) {
+                    return false;
+                }
+                item.kind = Output::DISTANCE;
+            } else if (_columnRef(item.col)) {
+                item.kind = Output::COLUMN;
+                item.name = item.col.name;
+            } else {
+                return false;
+            }
+            if (_keyword("AS")) {
+                if (!_name(item.name)) {
+                    return false;
+                }
+            } else if (item.kind != Output::COLUMN) {
+                return false; // MySQL names it by the text of the expression
+            }
+            select.push_back(item);
+        } while (_symbol(","));
+        if (!_keyword("FROM") || !_tableRef(tables[0]) || !_symbol(",") || !_tableRef(tables[1])) {
+            return false;
+        }
+        if (!_keyword("WHERE") || !_conjunction()) {
+            return false;
+        }
+        _symbol(";");
+        return _peek().kind == Token::END;
+    }
+
+    std::vector<SelectItem> select;
+    TableRef tables[2];
+    std::vector<std::pair<Distance, std::pair<Op, Literal>>> distances;
+    std::vector<Comparison> comparisons;
+    std::vector<ColumnComparison> columnComparisons;
+    std::vector<Box> boxes;
+
+private:
+    /// Consume the name of the function 'name' if it is followed by '('.
+    bool _function(char const* name) {
+        if (_peek().kind == Token::IDENT && strcasecmp(_peek().text.c_str(), name) == 0
+            && _peek(1).kind == Token::SYMBOL && _peek(1).text == "(") {
+            ++_pos;
+            return true;
+        }
+        return false;
+    }
+
+    /// The arguments of scisql_angSep.
+    bool _distance(Distance& dist) {
+        return _symbol("(") && _columnRef(dist.ra1) && _symbol(",") && _columnRef(dist.decl1)
+               && _symbol(",") && _columnRef(dist.ra2) && _symbol(",") && _columnRef(dist.decl2)
+               && _symbol(")");
+    }
+
+    bool _tableRef(TableRef& ref) {
+        if (!_name(ref.db) || !_symbol(".") || !_name(ref.table)) {
+            return false;
+        }
+        if (_keyword("AS")) {
+            return _name(ref.alias);
+        }
+        if (_peek().kind == Token::QUOTED || (_peek().kind == Token::IDENT && !_isKeyword(_peek()))) {
+            _name(ref.alias);
+        }
+        return true;
+    }
+
+    /// Conditions joined by AND, possibly in parentheses.
+    bool _conjunction() {
+        do {
+            if (_symbol("(")) {
+                if (!_conjunction() || !_symbol(")")) {
+                    return false;
+                }
+            } else if (!_condition()) {
+                return false;
+            }
+        } while (_keyword("AND"));
+        return true;
+    }
+
+    bool _condition() {
+        Literal lit;
+        Op op;
+        if (_peek().kind == Token::NUMBER || _peek().text == "-" || _peek().text == "+") {
+            // literal op expression, flip it.
+            if (!_literal(lit) || !_op(op)) {
+                return false;
+            }
+            op = flip(op);
+            if (_function("scisql_angSep")) {
+                Distance dist;
+                if (!_distance(dist)) {
+                    return false;
+                }
+                distances.emplace_back(dist, std::make_pair(op, lit));
+                return true;
+            }
+            Comparison cmp;
+            if (!_columnRef(cmp.col)) {
+                return false;
+            }
+            cmp.op = op;
+            cmp.lit = lit;
+            comparisons.push_back(cmp);
+            return true;
+        }
+        if (_function("scisql_angSep")) {
+            Distance dist;
+            if (!_distance(dist) || !_op(op) || !_literal(lit)) {
+                return false;
+            }
+            distances.emplace_back(dist, std::make_pair(op, lit));
+            return true;
+        }
+        if (_function("scisql_s2PtInBox")) {
+            Box box;
+            if (!_symbol("(") || !_columnRef(box.ra) || !_symbol(",") || !_columnRef(box.decl)) {
+                return false;
+            }
+            for (int j = 0; j < 4; ++j) {
+                if (!_symbol(",") || !_literal(lit)) {
+                    return false;
+                }
+                box.bounds.push_back(lit.realVal);
+            }
+            if (!_symbol(")") || !_symbol("=") || !_literal(lit) || !lit.isInt || lit.intVal != 1) {
+                return false;
+            }
+            boxes.push_back(box);
+            return true;
+        }
+        ColumnRef col;
+        if (!_columnRef(col)) {
+            return false;
+        }
+        if (_keyword("BETWEEN")) {
+            Comparison lower{col, Op::GE, Literal()};
+            Comparison upper{col, Op::LE, Literal()};
+            if (!_literal(lower.lit) || !_keyword("AND") || !_literal(upper.lit)) {
+                return false;
+            }
+            comparisons.push_back(lower);
+            comparisons.push_back(upper);
+            return true;
+        }
+        if (!_op(op)) {
+            return false;
+        }
+        if (_peek().kind == Token::NUMBER || _peek().text == "-" || _peek().text == "+") {
+            Comparison cmp{col, op, Literal()};
+            if (!_literal(cmp.lit)) {
+                return false;
+            }
+            comparisons.push_back(cmp);
+            return true;
+        }
+        ColumnComparison cmp{col, op, ColumnRef()};
+        if (!_columnRef(cmp.right)) {
+            return false;
+        }
+        columnComparisons.push_back(cmp);
+        return true;
+    }
+};
+
+
+NativeJoin::Tables::Table const* NativeJoin::Tables::get(std::string const& db, std::string const& table) {
+    std::string const path = ColumnarFile::pathFor(_dir, db, table);
+    auto itr = _tables.find(path);
+    if (itr != _tables.end()) {
+        return itr->second.get();
+    }
+    std::unique_ptr<Table> entry;
+    auto file = ColumnarFile::open(path);
+    ColumnarFile::Column const* subChunkCol = (file == nullptr) ? nullptr : file->find(SUB_CHUNK_COLUMN);
+    if (subChunkCol != nullptr && subChunkCol->type == ColumnarFile::Type::INT64) {
+        entry.reset(new Table());
+        entry->file = file;
+        uint64_t const numRows = file->getNumRows();
+        for (uint64_t row = 0; row < numRows; ++row) {
+            if (!subChunkCol->isNull(row)) {
+                entry->subChunks[subChunkCol->ints()[row]].push_back(row);
+            }
+        }
+    }
+    Table const* result = entry.get();
+    _tables[path] = std::move(entry);
+    return result;
+}
+
+
+NativeJoin::Ptr NativeJoin::plan(std::string const& query, Tables& tables) {
+    std::vector<Parser::Token> tokens;
+    if (!NativeParser::tokenize(query, tokens)) {
+        return nullptr;
+    }
+    Parser parser(tokens);
+    if (!parser.parse() || parser.distances.size() != 1) {
+        return nullptr;
+    }
+    Ptr join(new NativeJoin());
+    static std::vector<uint64_t> const noRows;
+    for (int s = 0; s < 2; ++s) {
+        Parser::TableRef const& ref = parser.tables[s];
+        std::string chunkDb;
+        std::string chunkTable;
+        int64_t subChunkId = 0;
+        if (!splitSubChunkTable(ref.db, ref.table, chunkDb, chunkTable, subChunkId)) {
+            return nullptr;
+        }
+        Tables::Table const* table = tables.get(chunkDb, chunkTable);
+        if (table == nullptr) {
+            return nullptr;
+        }
+        Side& side = join->_sides[s];
+        side.file = table->file;
+        auto itr = table->subChunks.find(subChunkId);
+        side.rows = (itr == table->subChunks.end()) ? &noRows : &itr->second;
+        side.table = ref.table;
+        side.alias = ref.alias;
+    }
+    if (join->_sides[0].alias.empty() && join->_sides[1].alias.empty()
+        && join->_sides[0].table == join->_sides[1].table) {
+        return nullptr;
+    }
+
+    // The distance gives the positions of both tables.
+    Parser::Distance const& dist = parser.distances.front().first;
+    Op op = parser.distances.front().second.first;
+    int s1, s2, t1, t2;
+    Column const *ra1, *decl1, *ra2, *decl2;
+    if (!join->_resolve(dist.ra1, s1, ra1) || !join->_resolve(dist.decl1, t1, decl1)
+        || !join->_resolve(dist.ra2, s2, ra2) || !join->_resolve(dist.decl2, t2, decl2)
+        || s1 != t1 || s2 != t2 || s1 == s2 || (op != Op::LT && op != Op::LE)) {
+        return nullptr;
+    }
+    join->_sides[s1].ra = ra1;
+    join->_sides[s1].decl = decl1;
+    join->_sides[s2].ra = ra2;
+    join->_sides[s2].decl = decl2;
+    join->_radius = parser.distances.front().second.second.realVal;
+    join->_inclusive = (op == Op::LE);
+
+    for (auto const& item : parser.select) {
+        Output out;
+        out.kind = item.kind;
+        out.name = item.name;
+        if (item.kind == Output::COLUMN) {
+            if (!join->_resolve(item.col, out.side, out.col)) {
+                return nullptr;
+            }
+        } else if (item.kind == Output::DISTANCE) {
+            // Only the distance of the join, with the tables in either order.
+            int a, b, c, d;
+            Column const *w, *x, *y, *z;
+            if (!join->_resolve(item.dist.ra1, a, w) || !join->_resolve(item.dist.decl1, b, x)
+                || !join->_resolve(item.dist.ra2, c, y) || !join->_resolve(item.dist.decl2, d, z)
+                || a != b || c != d || a == c || w != join->_sides[a].ra || x != join->_sides[a].decl
+                || y != join->_sides[c].ra || z != join->_sides[c].decl) {
+                return nullptr;
+            }
+        } else if (parser.select.size() != 1) {
+            return nullptr;
+        }
+        join->_outputs.push_back(out);
+    }
+    for (auto const& cmp : parser.comparisons) {
+        int s;
+        Column const* col;
+        if (!join->_resolve(cmp.col, s, col)) {
+            return nullptr;
+        }
+        join->_sides[s].comparisons.emplace_back(col, std::make_pair(cmp.op, cmp.lit));
+    }
+    for (auto const& box : parser.boxes) {
+        int s, t;
+        Column const *ra, *decl;
+        if (!join->_resolve(box.ra, s, ra) || !join->_resolve(box.decl, t, decl) || s != t) {
+            return nullptr;
+        }
+        // Test the box on the positions of the join only, the common case,
+        // which keeps Side to one position.
+        if (ra != join->_sides[s].ra || decl != join->_sides[s].decl) {
+            return nullptr;
+        }
+        join->_sides[s].boxes.push_back(box.bounds);
+    }
+    for (auto const& cmp : parser.columnComparisons) {
+        int s, t;
+        PairComparison pair;
+        if (!join->_resolve(cmp.left, s, pair.left) || !join->_resolve(cmp.right, t, pair.right) || s == t) {
+            return nullptr;
+        }
+        pair.op = cmp.op;
+        if (s == 1) {
+            std::swap(pair.left, pair.right);
+            pair.op = NativeParser::flip(pair.op);
+        }
+        join->_pairComparisons.push_back(pair);
+    }
+    LOGS(_log, LOG_LVL_DEBUG, "NativeJoin " << parser.tables[0].table << " " << parser.tables[1].table
+         << " radius=" << join->_radius << " rows=" << join->_sides[0].rows->size()
+         << "," << join->_sides[1].rows->size());
+    return join;
+}
+
+
+/// Find the column 'ref' among the tables of the join, a column without
+/// qualifier must be in one of them only.
+bool NativeJoin::_resolve(NativeParser::ColumnRef const& ref, int& side, Column const*& col) const {
+    col = nullptr;
+    for (int s = 0; s < 2; ++s) {
+        Side const& sd = _sides[s];
+        if (!ref.qualifier.empty() && ref.qualifier != sd.alias
+            && (!sd.alias.empty() || ref.qualifier != sd.table)) {
+            continue;
+        }
+        Column const* found = sd.file->find(ref.name);
+        if (found != nullptr) {
+            if (col != nullptr) {
+                return false;
+            }
+            col = found;
+            side = s;
+        }
+    }
+    return col != nullptr;
+}
+
+
+/// @return true if 'row' passes the comparisons and boxes of its table.
+/// NULL values pass nothing.
+bool NativeJoin::Side::passes(uint64_t row) const {
+    for (auto const& elem : comparisons) {
+        Column const& col = *elem.first;
+        Op const op = elem.second.first;
+        Literal const& lit = elem.second.second;
+        if (col.isNull(row)) {
+            return false;
+        }
+        bool ok = (col.type == ColumnarFile::Type::INT64 && lit.isInt)
+                  ? compare(col.ints()[row], op, lit.intVal)
+                  : compare(realValue(col, row), op, lit.realVal);
+        if (!ok) {
+            return false;
+        }
+    }
+    if (!boxes.empty()) {
+        double const lon = realValue(*ra, row);
+        double const lat = realValue(*decl, row);
+        for (auto const& box : boxes) {
+            if (lat < box[1] || lat > box[3] || !inLonRange(lon, box[0], box[2])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+
+/// Collect the rows of 'side' that pass, sorted by declination. Rows
+/// without a valid position are left out, scisql_angSep is NULL for them.
+void NativeJoin::_gather(Side const& side, Points& points) const {
+    std::vector<std::pair<double, uint64_t>> sorted;
+    sorted.reserve(side.rows->size());
+    for (uint64_t row : *side.rows) {
+        if (side.ra->isNull(row) || side.decl->isNull(row)) {
+            continue;
+        }
+        double const decl = realValue(*side.decl, row);
+        if (!(decl >= -90.0 && decl <= 90.0) || !std::isfinite(realValue(*side.ra, row))) {
+            continue;
+        }
+        if (side.passes(row)) {
+            sorted.emplace_back(decl, row);
+        }
+    }
+    std::sort(sorted.begin(), sorted.end());
+    size_t const n = sorted.size();
+    points.rows.resize(n);
+    points.ra.resize(n);
+    points.decl.resize(n);
+    points.x.resize(n);
+    points.y.resize(n);
+    points.z.resize(n);
+    for (size_t j = 0; j < n; ++j) {
+        uint64_t const row = sorted[j].second;
+        double const ra = realValue(*side.ra, row);
+        double const decl = sorted[j].first;
+        double const cosDecl = std::cos(decl * RAD_PER_DEG);
+        points.rows[j] = row;
+        points.ra[j] = ra;
+        points.decl[j] = decl;
+        points.x[j] = cosDecl * std::cos(ra * RAD_PER_DEG);
+        points.y[j] = cosDecl * std::sin(ra * RAD_PER_DEG);
+        points.z[j] = std::sin(decl * RAD_PER_DEG);
+    }
+}
+
+
+/// @return true if rows 'left' and 'right' pass the comparisons between the tables.
+bool NativeJoin::_pairPasses(uint64_t left, uint64_t right) const {
+    for (auto const& pair : _pairComparisons) {
+        if (pair.left->isNull(left) || pair.right->isNull(right)) {
+            return false;
+        }
+        bool ok = (pair.left->type == ColumnarFile::Type::INT64 && pair.right->type == ColumnarFile::Type::INT64)
+                  ? compare(pair.left->ints()[left], pair.op, pair.right->ints()[right])
+                  : compare(realValue(*pair.left, left), pair.op, realValue(*pair.right, right));
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+void NativeJoin::fillSchema(proto::RowSchema& schema) const {
+    for (auto const& out : _outputs) {
+        proto::ColumnSchema* cs = schema.add_columnschema();
+        cs->set_name(out.name);
+        cs->set_deprecated_hasdefault(false);
+        switch (out.kind) {
+        case Output::COLUMN:
+            cs->set_sqltype(out.col->sqlType);
+            cs->set_mysqltype(out.col->mysqlType);
+            break;
+        case Output::DISTANCE:
+            cs->set_sqltype("DOUBLE");
+            cs->set_mysqltype(MYSQL_TYPE_DOUBLE);
+            break;
+        case Output::COUNT:
+            cs->set_sqltype("BIGINT(21)");
+            cs->set_mysqltype(MYSQL_TYPE_LONGLONG);
+            break;
+        }
+    }
+}
+
+
+bool NativeJoin::run(RowFunc const& func) const {
+    Points left;
+    Points right;
+    _gather(_sides[0], left);
+    _gather(_sides[1], right);
+
+    // The declination band and the chord length are a little wider than the
+    // radius, the pairs in them being checked with the exact distance.
+    double const band = _radius + 1e-9;
+    double const halfAngle = std::min(std::max(_radius, 0.0), 180.0) * RAD_PER_DEG * 0.5;
+    double const chord = 2.0 * std::sin(halfAngle);
+    double const chord2 = chord * chord * (1.0 + 1e-9) + 1e-15;
+    bool const count = (_outputs.size() == 1 && _outputs.front().kind == Output::COUNT);
+
+    size_t const numFields = _outputs.size();
+    size_t const width = util::NumberFormat::BUFFER_SIZE;
+    std::vector<char> buffer(numFields * width);
+    std::vector<char*> row(numFields);
+    std::vector<unsigned long> lengths(numFields);
+    std::vector<uint8_t> mask;
+    uint64_t numPairs = 0;
+    size_t const n = right.rows.size();
+    size_t lo = 0;
+    size_t hi = 0;
+    for (size_t i = 0; i < left.rows.size(); ++i) {
+        double const decl = left.decl[i];
+        while (lo < n && right.decl[lo] < decl - band) {
+            ++lo;
+        }
+        while (hi < n && right.decl[hi] <= decl + band) {
+            ++hi;
+        }
+        if (hi <= lo) {
+            continue;
+        }
+        size_t const window = hi - lo;
+        if (mask.size() < window) {
+            mask.resize(window);
+        }
+        chordKernel(left.x[i], left.y[i], left.z[i], &right.x[lo], &right.y[lo], &right.z[lo],
+                    window, chord2, mask.data());
+        _pairsTested += window;
+        for (size_t k = 0; k < window; ++k) {
+            if (!mask[k]) {
+                continue;
+            }
+            size_t const j = lo + k;
+            double const d = angSep(left.ra[i], decl, right.ra[j], right.decl[j]);
+            if (!(_inclusive ? d <= _radius : d < _radius)) {
+                continue;
+            }
+            uint64_t const leftRow = left.rows[i];
+            uint64_t const rightRow = right.rows[j];
+            if (!_pairPasses(leftRow, rightRow)) {
+                continue;
+            }
+            if (count) {
+                ++numPairs;
+                continue;
+            }
+            for (size_t f = 0; f < numFields; ++f) {
+                Output const& out = _outputs[f];
+                char* buf = &buffer[f * width];
+                row[f] = buf;
+                if (out.kind == Output::DISTANCE) {
+                    lengths[f] = util::NumberFormat::formatDouble(d, buf);
+                    continue;
+                }
+                uint64_t const r = (out.side == 0) ? leftRow : rightRow;
+                if (out.col->isNull(r)) {
+                    row[f] = nullptr;
+                    lengths[f] = 0;
+                    continue;
+                }
+                switch (out.col->type) {
+                case ColumnarFile::Type::INT64:
+                    lengths[f] = util::NumberFormat::formatInt(out.col->ints()[r], buf);
+                    break;
+                case ColumnarFile::Type::DOUBLE:
+                    lengths[f] = util::NumberFormat::formatDouble(out.col->doubles()[r], buf);
+                    break;
+                case ColumnarFile::Type::FLOAT:
+                    lengths[f] = util::NumberFormat::formatFloat(out.col->floats()[r], buf);
+                    break;
+                }
+            }
+            if (!func(row.data(), lengths.data())) {
+                return false;
+            }
+        }
+    }
+    if (count) {
+        row[0] = buffer.data();
+        lengths[0] = util::NumberFormat::formatInt(static_cast<int64_t>(numPairs), buffer.data());
+        return func(row.data(), lengths.data());
+    }
+    return true;
+}
+
+}}} // namespace lsst::qserv::wdb
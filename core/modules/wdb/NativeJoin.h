@@ -0,0 +1,189 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_WDB_NATIVEJOIN_H
+#define LSST_QSERV_WDB_NATIVEJOIN_H
+
+// System headers
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "wdb/ColumnarFile.h"
+#include "wdb/NativeParser.h"
+#include "wdb/NativeScan.h"
+
+namespace lsst {
+namespace qserv {
+namespace proto {
+    class RowSchema;
+}}}
+
+namespace lsst {
+namespace qserv {
+namespace wdb {
+
+/// NativeJoin answers the subchunk queries of near neighbour joins, two
+/// subchunk tables joined on the angular distance of their positions, from
+/// the ColumnarFile of the chunk and overlap tables instead of the MEMORY
+/// tables ChunkResourceMgr builds for MySQL:
+///
+///     SELECT o1.objectId, o2.objectId AS id2,
+///            scisql_angSep(o1.ra, o1.decl, o2.ra, o2.decl) AS dist
+///     FROM Subchunks_LSST_100.Object_100_5 AS o1,
+///          Subchunks_LSST_100.ObjectFullOverlap_100_5 AS o2
+///     WHERE scisql_angSep(o1.ra, o1.decl, o2.ra, o2.decl) < 0.01
+///           AND o1.objectId <> o2.objectId AND o1.flux > 5
+///
+/// The select list may also be a lone COUNT(*) AS name. Besides the distance,
+/// the WHERE clause may compare a column with a number or with a column of
+/// the other table, and test a position with scisql_s2PtInBox(...) = 1.
+/// Anything else is left to MySQL.
+///
+/// The rows of each table that pass its own comparisons are sorted by
+/// declination into arrays of unit vectors. The first table is then swept in
+/// declination order, each of its rows being compared only with the rows of
+/// the second table in its declination band, by a loop over chord lengths
+/// that the compiler vectorizes. The pairs that are close enough are checked
+/// with the distance scisql_angSep computes.
+///
+/// As for NativeScan, floating point values are given with the fewest digits
+/// that read back to the same value.
+class NativeJoin {
+public:
+    using Ptr = std::unique_ptr<NativeJoin>;
+    using RowFunc = NativeScan::RowFunc;
+
+    class Tables;
+
+    /// @return a join for 'query', or nullptr if it cannot be run natively or
+    ///         one of its tables has no ColumnarFile in 'tables', which must
+    ///         outlive the join.
+    static Ptr plan(std::string const& query, Tables& tables);
+
+    NativeJoin(NativeJoin const&) = delete;
+    NativeJoin& operator=(NativeJoin const&) = delete;
+
+    /// Add the result columns to 'schema', as for a MySQL result.
+    void fillSchema(proto::RowSchema& schema) const;
+
+    int getNumFields() const { return _outputs.size(); }
+
+    /// Call 'func' with each row of the result.
+    /// @return false if 'func' stopped the join.
+    bool run(RowFunc const& func) const;
+
+    /// @return the number of pairs of rows whose distance was tested.
+    uint64_t getPairsTested() const { return _pairsTested; }
+
+private:
+    using Op = NativeParser::Op;
+    using Literal = NativeParser::Literal;
+    using Column = ColumnarFile::Column;
+
+    /// The rows of one table of the join and the comparisons of its own columns.
+    struct Side {
+        ColumnarFile::Ptr file;
+        std::vector<uint64_t> const* rows{nullptr}; ///< Rows of the subchunk
+        std::string table;
+        std::string alias;
+        Column const* ra{nullptr};
+        Column const* decl{nullptr};
+        std::vector<std::pair<Column const*, std::pair<Op, Literal>>> comparisons;
+        std::vector<std::vector<double>> boxes; ///< lonMin, latMin, lonMax, latMax
+
+        bool passes(uint64_t row) const;
+    };
+
+    /// The rows of a Side that pass, sorted by declination.
+    struct Points {
+        std::vector<uint64_t> rows;
+        std::vector<double> ra;
+        std::vector<double> decl;
+        std::vector<double> x;
+        std::vector<double> y;
+        std::vector<double> z;
+    };
+
+    /// A comparison of a column of the first table with one of the second.
+    struct PairComparison {
+        Column const* left{nullptr};
+        Op op{Op::EQ};
+        Column const* right{nullptr};
+    };
+
+    struct Output {
+        enum Kind { COLUMN, DISTANCE, COUNT };
+        Kind kind{COLUMN};
+        std::string name;
+        int side{0};
+        Column const* col{nullptr};
+    };
+
+    class Parser;
+
+    NativeJoin() = default;
+
+    bool _resolve(NativeParser::ColumnRef const& ref, int& side, Column const*& col) const;
+    void _gather(Side const& side, Points& points) const;
+    bool _pairPasses(uint64_t left, uint64_t right) const;
+
+    Side _sides[2];
+    double _radius{0.0};    ///< Degrees
+    bool _inclusive{false}; ///< True if the distance may equal _radius
+    std::vector<PairComparison> _pairComparisons;
+    std::vector<Output> _outputs;
+    mutable uint64_t _pairsTested{0};
+};
+
+
+/// The ColumnarFiles of the chunk and overlap tables of the subchunk queries
+/// of a task, opened once for all of them, with their rows grouped by
+/// subchunk. It is not thread safe.
+class NativeJoin::Tables {
+public:
+    explicit Tables(std::string const& dir) : _dir(dir) {}
+
+    Tables(Tables const&) = delete;
+    Tables& operator=(Tables const&) = delete;
+
+    /// A chunk or overlap table, with its rows grouped by subchunk.
+    struct Table {
+        ColumnarFile::Ptr file;
+        std::map<int64_t, std::vector<uint64_t>> subChunks;
+    };
+
+    /// @return 'db'.'table', or nullptr if it has no file or the file has no
+    ///         subchunk column.
+    Table const* get(std::string const& db, std::string const& table);
+
+private:
+    std::string const _dir;
+    std::map<std::string, std::unique_ptr<Table>> _tables; ///< By path, nullptr if missing
+};
+
+}}} // namespace lsst::qserv::wdb
+
+#endif // LSST_QSERV_WDB_NATIVEJOIN_H
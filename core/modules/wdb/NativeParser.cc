@@ -0,0 +1,208 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "wdb/NativeParser.h"
+
+// System headers
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+
+namespace lsst {
+namespace qserv {
+namespace wdb {
+
+bool NativeParser::tokenize(std::string const& query, std::vector<Token>& tokens) {
+    size_t pos = 0;
+    size_t const len = query.size();
+    while (pos < len) {
+        char c = query[pos];
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            ++pos;
+        } else if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            size_t start = pos;
+            while (pos < len && (std::isalnum(static_cast<unsigned char>(query[pos]))
+                                 || query[pos] == '_' || query[pos] == '$')) {
+                ++pos;
+            }
+            tokens.push_back({Token::IDENT, query.substr(start, pos - start)});
+        } else if (c == '`') {
+            size_t end = query.find('`', pos + 1);
+            if (end == std::string::npos) {
+                return false;
+            }
+            tokens.push_back({Token::QUOTED, query.substr(pos + 1, end - pos - 1)});
+            pos = end + 1;
+        } else if (std::isdigit(static_cast<unsigned char>(c))
+                   || (c == '.' && pos + 1 < len && std::isdigit(static_cast<unsigned char>(query[pos + 1])))) {
+            size_t start = pos;
+            while (pos < len && (std::isdigit(static_cast<unsigned char>(query[pos])) || query[pos] == '.')) {
+                ++pos;
+            }
+            if (pos < len && (query[pos] == 'e' || query[pos] == 'E')) {
+                ++pos;
+                if (pos < len && (query[pos] == '+' || query[pos] == '-')) {
+                    ++pos;
+                }
+                while (pos < len && std::isdigit(static_cast<unsigned char>(query[pos]))) {
+                    ++pos;
+                }
+            }
+            tokens.push_back({Token::NUMBER, query.substr(start, pos - start)});
+        } else if (c == '<' || c == '>' || c == '!') {
+            std::string op(1, c);
+            if (pos + 1 < len && (query[pos + 1] == '=' || (c == '<' && query[pos + 1] == '>'))) {
+                op += query[pos + 1];
+            }
+            if (op == "!") {
+                return false;
+            }
+            tokens.push_back({Token::SYMBOL, op});
+            pos += op.size();
+        } else if (std::strchr(",.*()=;-+", c) != nullptr) {
+            tokens.push_back({Token::SYMBOL, std::string(1, c)});
+            ++pos;
+        } else {
+            return false;
+        }
+    }
+    tokens.push_back({Token::END, ""});
+    return true;
+}
+
+
+NativeParser::Op NativeParser::flip(Op op) {
+    static Op const flipped[] = {Op::EQ, Op::NE, Op::GT, Op::GE, Op::LT, Op::LE};
+    return flipped[static_cast<int>(op)];
+}
+
+
+NativeParser::Token const& NativeParser::_peek(size_t ahead) const {
+    return _tokens[std::min(_pos + ahead, _tokens.size() - 1)];
+}
+
+
+bool NativeParser::_isKeyword(Token const& tok) {
+    static char const* const keywords[] = {"SELECT", "FROM", "AS", "WHERE", "AND", "OR", "NOT",
+        "BETWEEN", "GROUP", "ORDER", "LIMIT", "HAVING", "JOIN", "IS", "IN", "LIKE", "DISTINCT",
+        "UNION", "NULL"};
+    if (tok.kind != Token::IDENT) {
+        return false;
+    }
+    for (char const* kw : keywords) {
+        if (strcasecmp(tok.text.c_str(), kw) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+bool NativeParser::_keyword(char const* kw) {
+    if (_peek().kind == Token::IDENT && strcasecmp(_peek().text.c_str(), kw) == 0) {
+        ++_pos;
+        return true;
+    }
+    return false;
+}
+
+
+bool NativeParser::_symbol(char const* sym) {
+    if (_peek().kind == Token::SYMBOL && _peek().text == sym) {
+        ++_pos;
+        return true;
+    }
+    return false;
+}
+
+
+bool NativeParser::_name(std::string& name) {
+    Token const& tok = _peek();
+    if (tok.kind == Token::QUOTED || (tok.kind == Token::IDENT && !_isKeyword(tok))) {
+        name = tok.text;
+        ++_pos;
+        return true;
+    }
+    return false;
+}
+
+
+bool NativeParser::_columnRef(ColumnRef& col) {
+    if (!_name(col.name)) {
+        return false;
+    }
+    if (_symbol(".")) {
+        col.qualifier = col.name;
+        if (!_name(col.name)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+bool NativeParser::_literal(Literal& lit) {
+    bool negative = false;
+    if (_symbol("-")) {
+        negative = true;
+    } else {
+        _symbol("+");
+    }
+    Token const& tok = _peek();
+    if (tok.kind != Token::NUMBER) {
+        return false;
+    }
+    ++_pos;
+    std::string text = (negative ? "-" : "") + tok.text;
+    if (text.find_first_of(".eE") == std::string::npos) {
+        errno = 0;
+        lit.intVal = std::strtoll(text.c_str(), nullptr, 10);
+        if (errno == ERANGE) {
+            return false; // MySQL would compare as DECIMAL
+        }
+        lit.isInt = true;
+        lit.realVal = static_cast<double>(lit.intVal);
+    } else {
+        lit.realVal = std::strtod(text.c_str(), nullptr);
+    }
+    return true;
+}
+
+
+bool NativeParser::_op(Op& op) {
+    static std::pair<char const*, Op> const ops[] = {{"=", Op::EQ}, {"<>", Op::NE}, {"!=", Op::NE},
+        {"<", Op::LT}, {"<=", Op::LE}, {">", Op::GT}, {">=", Op::GE}};
+    for (auto const& elem : ops) {
+        if (_symbol(elem.first)) {
+            op = elem.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+}}} // namespace lsst::qserv::wdb
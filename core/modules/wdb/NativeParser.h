@@ -0,0 +1,92 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_WDB_NATIVEPARSER_H
+#define LSST_QSERV_WDB_NATIVEPARSER_H
+
+// System headers
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lsst {
+namespace qserv {
+namespace wdb {
+
+/// NativeParser holds the tokens and the pieces of grammar shared by the
+/// recursive descent parsers of the queries run without MySQL, see
+/// NativeScan and NativeJoin. Queries with anything these parsers don't know,
+/// such as strings, are rejected so that they run in MySQL.
+class NativeParser {
+public:
+    struct Token {
+        enum Kind { IDENT, QUOTED, NUMBER, SYMBOL, END };
+        Kind kind;
+        std::string text;
+    };
+
+    enum class Op { EQ, NE, LT, LE, GT, GE };
+
+    /// A numeric literal, integers are kept exact.
+    struct Literal {
+        bool isInt{false};
+        int64_t intVal{0};
+        double realVal{0.0};
+    };
+
+    struct ColumnRef {
+        std::string qualifier;
+        std::string name;
+    };
+
+    /// Split 'query' into tokens, the last one being END.
+    /// @return false if it has anything a native query cannot have, such as strings.
+    static bool tokenize(std::string const& query, std::vector<Token>& tokens);
+
+    /// @return the operator for the operands swapped, GT for LT and so on.
+    static Op flip(Op op);
+
+protected:
+    explicit NativeParser(std::vector<Token> const& tokens) : _tokens(tokens) {}
+
+    /// @return the token 'ahead' tokens past the current one, END past the last.
+    Token const& _peek(size_t ahead=0) const;
+
+    static bool _isKeyword(Token const& tok);
+
+    /// Each of these consumes what it matches and returns true, false means
+    /// the query is not the expected one.
+    bool _keyword(char const* kw);
+    bool _symbol(char const* sym);
+    bool _name(std::string& name);
+    bool _columnRef(ColumnRef& col);
+    bool _literal(Literal& lit);
+    bool _op(Op& op);
+
+    std::vector<Token> const& _tokens;
+    size_t _pos{0};
+};
+
+}}} // namespace lsst::qserv::wdb
+
+#endif // LSST_QSERV_WDB_NATIVEPARSER_H
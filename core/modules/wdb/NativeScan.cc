@@ -0,0 +1,409 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "wdb/NativeScan.h"
+
+// System headers
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "proto/worker.pb.h"
+#include "util/NumberFormat.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.wdb.NativeScan");
+
+/// Rows filtered at a time, small enough for the mask to stay in cache.
+size_t const BLOCK_ROWS = 4096;
+
+// Filter kernels, each ANDs one comparison into 'mask'. They are kept free of
+// branches so that they vectorize.
+
+template <typename T, typename Cmp>
+void cmpKernel(T const* values, size_t n, double lit, uint8_t* mask, Cmp cmp) {
+    for (size_t i = 0; i < n; ++i) {
+        mask[i] &= cmp(static_cast<double>(values[i]), lit);
+    }
+}
+
+template <typename T>
+void realKernel(T const* values, size_t n, int op, double lit, uint8_t* mask) {
+    switch (op) {
+    case 0: cmpKernel(values, n, lit, mask, [](double a, double b) { return a == b; }); break;
+    case 1: cmpKernel(values, n, lit, mask, [](double a, double b) { return a != b; }); break;
+    case 2: cmpKernel(values, n, lit, mask, [](double a, double b) { return a < b; }); break;
+    case 3: cmpKernel(values, n, lit, mask, [](double a, double b) { return a <= b; }); break;
+    case 4: cmpKernel(values, n, lit, mask, [](double a, double b) { return a > b; }); break;
+    case 5: cmpKernel(values, n, lit, mask, [](double a, double b) { return a >= b; }); break;
+    }
+}
+
+void rangeKernel(int64_t const* values, size_t n, int64_t lo, int64_t hi, uint8_t* mask) {
+    for (size_t i = 0; i < n; ++i) {
+        mask[i] &= (values[i] >= lo) & (values[i] <= hi);
+    }
+}
+
+void notEqualKernel(int64_t const* values, size_t n, int64_t val, uint8_t* mask) {
+    for (size_t i = 0; i < n; ++i) {
+        mask[i] &= (values[i] != val);
+    }
+}
+
+/// Clear the mask of the rows that are NULL, starting at row 'begin'.
+void nullKernel(uint8_t const* nulls, uint64_t begin, size_t n, uint8_t* mask) {
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t row = begin + i;
+        mask[i] &= ~(nulls[row >> 3] >> (row & 7)) & 1;
+    }
+}
+
+} // anonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace wdb {
+
+/// Recursive descent parser for the queries NativeScan can run. Column
+/// references are only checked against the file once the table is known.
+class NativeScan::Parser : public NativeParser {
+public:
+    struct Comparison {
+        ColumnRef col;
+        Op op;
+        Literal lit;
+    };
+
+    explicit Parser(std::vector<Token> const& tokens) : NativeParser(tokens) {}
+
+    bool parse() {
+        if (!_keyword("SELECT")) {
+            return false;
+        }
+        if (_symbol("*")) {
+            star = true;
+        } else {
+            do {
+                ColumnRef col;
+                if (!_columnRef(col)) {
+                    return false;
+                }
+                std::string name = col.name;
+                if (_keyword("AS")) {
+                    if (!_name(name)) {
+                        return false;
+                    }
+                }
+                select.emplace_back(col, name);
+            } while (_symbol(","));
+        }
+        if (!_keyword("FROM") || !_name(db) || !_symbol(".") || !_name(table)) {
+            return false;
+        }
+        if (_keyword("AS")) {
+            if (!_name(alias)) {
+                return false;
+            }
+        } else if (_peek().kind == Token::QUOTED || (_peek().kind == Token::IDENT && !_isKeyword(_peek()))) {
+            _name(alias);
+        }
+        if (_keyword("WHERE") && !_conjunction()) {
+            return false;
+        }
+        _symbol(";");
+        return _peek().kind == Token::END;
+    }
+
+    bool star{false};
+    std::vector<std::pair<ColumnRef, std::string>> select; ///< Columns and their result names
+    std::string db;
+    std::string table;
+    std::string alias;
+    std::vector<Comparison> where;
+
+private:
+    /// Comparisons joined by AND, possibly in parentheses.
+    bool _conjunction() {
+        do {
+            if (_symbol("(")) {
+                if (!_conjunction() || !_symbol(")")) {
+                    return false;
+                }
+            } else if (!_comparison()) {
+                return false;
+            }
+        } while (_keyword("AND"));
+        return true;
+    }
+
+    bool _comparison() {
+        Comparison cmp;
+        if (_peek().kind == Token::NUMBER || _peek().text == "-" || _peek().text == "+") {
+            // literal op column, flip it.
+            if (!_literal(cmp.lit) || !_op(cmp.op) || !_columnRef(cmp.col)) {
+                return false;
+            }
+            cmp.op = flip(cmp.op);
+            where.push_back(cmp);
+            return true;
+        }
+        if (!_columnRef(cmp.col)) {
+            return false;
+        }
+        if (_keyword("BETWEEN")) {
+            Comparison upper = cmp;
+            if (!_literal(cmp.lit) || !_keyword("AND") || !_literal(upper.lit)) {
+                return false;
+            }
+            cmp.op = Op::GE;
+            upper.op = Op::LE;
+            where.push_back(cmp);
+            where.push_back(upper);
+            return true;
+        }
+        if (!_op(cmp.op) || !_literal(cmp.lit)) {
+            return false;
+        }
+        where.push_back(cmp);
+        return true;
+    }
+
+};
+
+
+NativeScan::Ptr NativeScan::plan(std::string const& query, std::string const& dir) {
+    std::vector<Parser::Token> tokens;
+    if (!NativeParser::tokenize(query, tokens)) {
+        return nullptr;
+    }
+    Parser parser(tokens);
+    if (!parser.parse()) {
+        return nullptr;
+    }
+    Ptr scan(new NativeScan());
+    scan->_file = ColumnarFile::open(ColumnarFile::pathFor(dir, parser.db, parser.table));
+    if (scan->_file == nullptr) {
+        return nullptr;
+    }
+    ColumnarFile const& file = *scan->_file;
+    auto resolve = [&parser, &file](Parser::ColumnRef const& ref) -> ColumnarFile::Column const* {
+        if (!ref.qualifier.empty() && ref.qualifier != parser.alias
+            && (!parser.alias.empty() || ref.qualifier != parser.table)) {
+            return nullptr;
+        }
+        return file.find(ref.name);
+    };
+
+    if (parser.star) {
+        if (!file.isComplete()) {
+            return nullptr;
+        }
+        for (auto const& col : file.getColumns()) {
+            scan->_outputs.push_back({col.name, &col});
+        }
+    }
+    for (auto const& elem : parser.select) {
+        auto col = resolve(elem.first);
+        if (col == nullptr) {
+            LOGS(_log, LOG_LVL_DEBUG, "NativeScan no column " << elem.first.name << " in " << parser.table);
+            return nullptr;
+        }
+        scan->_outputs.push_back({elem.second, col});
+    }
+    for (auto const& cmp : parser.where) {
+        auto col = resolve(cmp.col);
+        if (col == nullptr || !scan->_addPredicate(col, cmp.op, cmp.lit)) {
+            return nullptr;
+        }
+    }
+    LOGS(_log, LOG_LVL_DEBUG, "NativeScan " << parser.db << "." << parser.table
+         << " columns=" << scan->_outputs.size() << " predicates=" << scan->_predicates.size());
+    return scan;
+}
+
+
+/// Add the comparison of 'col' with 'lit'. Integer columns compared with a
+/// fractional literal get the integer range that matches, as MySQL compares
+/// them exactly.
+bool NativeScan::_addPredicate(ColumnarFile::Column const* col, Op op, Literal const& lit) {
+    Predicate pred;
+    pred.col = col;
+    pred.op = op;
+    pred.realVal = lit.realVal;
+    if (col->type != ColumnarFile::Type::INT64) {
+        _predicates.push_back(pred);
+        return true;
+    }
+    int64_t const minVal = std::numeric_limits<int64_t>::min();
+    int64_t const maxVal = std::numeric_limits<int64_t>::max();
+    double const limit = 9223372036854775808.0; // 2^63
+    // Exact bounds of the integers v with v 'op' lit.
+    int64_t lo = minVal;
+    int64_t hi = maxVal;
+    if (lit.isInt) {
+        int64_t const v = lit.intVal;
+        switch (op) {
+        case Op::EQ: lo = hi = v; break;
+        case Op::NE: lo = v; break;
+        case Op::LT: if (v == minVal) pred.none = true; else hi = v - 1; break;
+        case Op::LE: hi = v; break;
+        case Op::GT: if (v == maxVal) pred.none = true; else lo = v + 1; break;
+        case Op::GE: lo = v; break;
+        }
+    } else {
+        double const v = lit.realVal;
+        if (std::isnan(v)) {
+            return false;
+        }
+        double const fl = std::floor(v);
+        double const cl = std::ceil(v);
+        bool const integral = (fl == v);
+        bool const above = (fl >= limit);     // v > every int64
+        bool const below = (cl < -limit);     // v < every int64
+        switch (op) {
+        case Op::EQ:
+            if (!integral || above || below) pred.none = true; else lo = hi = int64_t(v);
+            break;
+        case Op::NE:
+            if (!integral || above || below) op = Op::GE; else lo = int64_t(v); // GE minVal keeps all
+            break;
+        case Op::LT:
+            if (below || (cl == -limit)) pred.none = true; else if (!above) hi = int64_t(cl) - 1;
+            break;
+        case Op::LE:
+            if (below) pred.none = true; else if (!above) hi = int64_t(fl);
+            break;
+        case Op::GT:
+            if (above) pred.none = true; else if (fl >= -limit) lo = int64_t(fl) + 1;
+            break;
+        case Op::GE:
+            if (above) pred.none = true; else if (!below) lo = int64_t(cl);
+            break;
+        }
+        pred.op = op;
+    }
+    pred.lo = lo;
+    pred.hi = hi;
+    _predicates.push_back(pred);
+    return true;
+}
+
+
+void NativeScan::fillSchema(proto::RowSchema& schema) const {
+    for (auto const& out : _outputs) {
+        proto::ColumnSchema* cs = schema.add_columnschema();
+        cs->set_name(out.name);
+        cs->set_deprecated_hasdefault(false);
+        cs->set_sqltype(out.col->sqlType);
+        cs->set_mysqltype(out.col->mysqlType);
+    }
+}
+
+
+/// Set mask[i] to 1 for the rows begin+i that pass all predicates.
+void NativeScan::_filter(uint64_t begin, size_t n, uint8_t* mask) const {
+    std::memset(mask, 1, n);
+    for (auto const& pred : _predicates) {
+        ColumnarFile::Column const& col = *pred.col;
+        _valuesTested += n;
+        if (pred.none) {
+            std::memset(mask, 0, n);
+            return;
+        }
+        switch (col.type) {
+        case ColumnarFile::Type::INT64:
+            if (pred.op == Op::NE) {
+                notEqualKernel(col.ints() + begin, n, pred.lo, mask);
+            } else {
+                rangeKernel(col.ints() + begin, n, pred.lo, pred.hi, mask);
+            }
+            break;
+        case ColumnarFile::Type::DOUBLE:
+            realKernel(col.doubles() + begin, n, static_cast<int>(pred.op), pred.realVal, mask);
+            break;
+        case ColumnarFile::Type::FLOAT:
+            realKernel(col.floats() + begin, n, static_cast<int>(pred.op), pred.realVal, mask);
+            break;
+        }
+        // A comparison with NULL is never true.
+        if (col.nulls != nullptr) {
+            nullKernel(col.nulls, begin, n, mask);
+        }
+    }
+}
+
+
+bool NativeScan::scan(RowFunc const& func) const {
+    size_t const numFields = _outputs.size();
+    uint64_t const numRows = _file->getNumRows();
+    std::vector<uint8_t> mask(BLOCK_ROWS);
+    size_t const width = util::NumberFormat::BUFFER_SIZE;
+    std::vector<char> buffer(numFields * width);
+    std::vector<char*> row(numFields);
+    std::vector<unsigned long> lengths(numFields);
+    for (uint64_t begin = 0; begin < numRows; begin += BLOCK_ROWS) {
+        size_t const n = std::min<uint64_t>(BLOCK_ROWS, numRows - begin);
+        _filter(begin, n, mask.data());
+        for (size_t i = 0; i < n; ++i) {
+            if (!mask[i]) {
+                continue;
+            }
+            uint64_t const r = begin + i;
+            for (size_t j = 0; j < numFields; ++j) {
+                ColumnarFile::Column const& col = *_outputs[j].col;
+                if (col.isNull(r)) {
+                    row[j] = nullptr;
+                    lengths[j] = 0;
+                    continue;
+                }
+                char* buf = &buffer[j * width];
+                row[j] = buf;
+                switch (col.type) {
+                case ColumnarFile::Type::INT64:
+                    lengths[j] = util::NumberFormat::formatInt(col.ints()[r], buf);
+                    break;
+                case ColumnarFile::Type::DOUBLE:
+                    lengths[j] = util::NumberFormat::formatDouble(col.doubles()[r], buf);
+                    break;
+                case ColumnarFile::Type::FLOAT:
+                    lengths[j] = util::NumberFormat::formatFloat(col.floats()[r], buf);
+                    break;
+                }
+            }
+            if (!func(row.data(), lengths.data())) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+}}} // namespace lsst::qserv::wdb
@@ -0,0 +1,121 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_WDB_NATIVESCAN_H
+#define LSST_QSERV_WDB_NATIVESCAN_H
+
+// System headers
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "wdb/ColumnarFile.h"
+#include "wdb/NativeParser.h"
+
+namespace lsst {
+namespace qserv {
+namespace proto {
+    class RowSchema;
+}}}
+
+namespace lsst {
+namespace qserv {
+namespace wdb {
+
+/// NativeScan answers the simplest chunk queries, a list of columns of one
+/// chunk table filtered by comparisons with numbers, from the ColumnarFile of
+/// the table instead of MySQL:
+///
+///     SELECT a, t.b AS x FROM db.Table_1234 AS t WHERE a > 5 AND b BETWEEN 1 AND 2
+///
+/// The comparisons are evaluated on blocks of rows by loops over the column
+/// values that the compiler vectorizes. Any other query, or one naming a
+/// column the file does not have, is left to MySQL.
+///
+/// Rows are produced in the text form MySQL returns. Floating point values
+/// are given with the fewest digits that read back to the same value, which
+/// may differ from MySQL's text but not in value.
+class NativeScan {
+public:
+    using Ptr = std::unique_ptr<NativeScan>;
+    /// Called with each row, NULL values are nullptr. Return false to stop the scan.
+    using RowFunc = std::function<bool(char** row, unsigned long* lengths)>;
+
+    /// @return a scan for 'query', or nullptr if it cannot be run natively or
+    ///         its table has no ColumnarFile under 'dir'.
+    static Ptr plan(std::string const& query, std::string const& dir);
+
+    NativeScan(NativeScan const&) = delete;
+    NativeScan& operator=(NativeScan const&) = delete;
+
+    /// Add the result columns to 'schema', as for a MySQL result.
+    void fillSchema(proto::RowSchema& schema) const;
+
+    int getNumFields() const { return _outputs.size(); }
+
+    /// Call 'func' with each row of the result.
+    /// @return false if 'func' stopped the scan.
+    bool scan(RowFunc const& func) const;
+
+    /// @return the number of column values tested by the filter kernels.
+    uint64_t getValuesTested() const { return _valuesTested; }
+
+private:
+    using Op = NativeParser::Op;
+    using Literal = NativeParser::Literal;
+
+    /// A comparison of a column with a literal. Integer columns are compared
+    /// on the range [lo, hi], or for NE with lo, so that a fractional literal
+    /// compares as MySQL does.
+    struct Predicate {
+        ColumnarFile::Column const* col{nullptr};
+        Op op{Op::EQ};
+        double realVal{0.0};
+        int64_t lo{0};
+        int64_t hi{0};
+        bool none{false}; ///< True if no row can match.
+    };
+
+    struct Output {
+        std::string name;
+        ColumnarFile::Column const* col{nullptr};
+    };
+
+    class Parser;
+
+    NativeScan() = default;
+
+    bool _addPredicate(ColumnarFile::Column const* col, Op op, Literal const& lit);
+    void _filter(uint64_t begin, size_t n, uint8_t* mask) const;
+
+    ColumnarFile::Ptr _file;
+    std::vector<Output> _outputs;
+    std::vector<Predicate> _predicates;
+    mutable uint64_t _valuesTested{0};
+};
+
+}}} // namespace lsst::qserv::wdb
+
+#endif // LSST_QSERV_WDB_NATIVESCAN_H
@@ -0,0 +1,136 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "wdb/ParallelQueries.h"
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+namespace {
+LOG_LOGGER _log = LOG_GET("lsst.qserv.wdb.ParallelQueries");
+}
+
+namespace lsst {
+namespace qserv {
+namespace wdb {
+
+ParallelQueries::ParallelQueries(std::vector<std::string> const& queries, unsigned int numThreads,
+                                 OpenFunc const& open, CloseFunc const& close)
+    : _queries(queries), _ahead(numThreads), _open(open), _close(close), _slots(queries.size()) {
+    for (unsigned int j = 0; j < numThreads && j < queries.size(); ++j) {
+        _threads.emplace_back(&ParallelQueries::_run, this);
+    }
+}
+
+
+ParallelQueries::~ParallelQueries() {
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _stop = true;
+    }
+    _cv.notify_all();
+    for (auto& thrd : _threads) {
+        thrd.join();
+    }
+    for (auto& slot : _slots) {
+        if (slot.res != nullptr) {
+            mysql_free_result(slot.res);
+        }
+    }
+}
+
+
+MYSQL_RES* ParallelQueries::next(util::Error& error) {
+    std::unique_lock<std::mutex> lock(_mtx);
+    if (_read >= _slots.size()) {
+        error = util::Error(-1, "ParallelQueries: no more results");
+        return nullptr;
+    }
+    Slot& slot = _slots[_read];
+    _cv.wait(lock, [this, &slot]() { return slot.done; });
+    ++_read;
+    MYSQL_RES* res = slot.res;
+    slot.res = nullptr;
+    error = slot.error;
+    lock.unlock();
+    _cv.notify_all(); // A thread may start another query.
+    return res;
+}
+
+
+void ParallelQueries::cancel() {
+    std::lock_guard<std::mutex> lock(_mtx);
+    _stop = true;
+    for (auto conn : _conns) {
+        conn->cancel();
+    }
+    _cv.notify_all();
+}
+
+
+void ParallelQueries::_run() {
+    mysql_thread_init();
+    Conn conn = _open();
+    std::unique_lock<std::mutex> lock(_mtx);
+    if (conn != nullptr) {
+        _conns.insert(conn.get());
+    }
+    while (true) {
+        _cv.wait(lock, [this]() {
+            return _stop || _started >= _slots.size() || _started < _read + _ahead;
+        });
+        if (_started >= _slots.size()) {
+            break;
+        }
+        size_t const j = _started++;
+        Slot result;
+        if (_stop) {
+            // Results are no longer read, but next() must not wait forever.
+            result.error = util::Error(-1, "ParallelQueries: cancelled");
+        } else if (conn == nullptr) {
+            result.error = util::Error(-1, "ParallelQueries: unable to connect to MySQL");
+        } else {
+            lock.unlock();
+            result.res = conn->queryBuffered(_queries[j]);
+            if (result.res == nullptr) {
+                result.error = util::Error(conn->getErrno(), conn->getError());
+                LOGS(_log, LOG_LVL_WARN, "ParallelQueries query failed " << result.error.getMsg());
+            }
+            lock.lock();
+        }
+        result.done = true;
+        _slots[j] = result;
+        _cv.notify_all();
+    }
+    if (conn != nullptr) {
+        _conns.erase(conn.get());
+    }
+    lock.unlock();
+    if (conn != nullptr) {
+        _close(std::move(conn));
+    }
+    mysql_thread_end();
+}
+
+}}} // namespace lsst::qserv::wdb
@@ -0,0 +1,107 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_WDB_PARALLELQUERIES_H
+#define LSST_QSERV_WDB_PARALLELQUERIES_H
+
+// System headers
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Third-party headers
+#include <mysql/mysql.h>
+
+// Qserv headers
+#include "mysql/MySqlConnection.h"
+#include "util/Error.h"
+
+namespace lsst {
+namespace qserv {
+namespace wdb {
+
+/// ParallelQueries runs the subchunk queries of a fragment on several MySQL
+/// connections at once and hands out their results in query order, so that
+/// the task still sends one result stream.
+///
+/// Each result is read whole into client memory, which lets a thread start
+/// its next query at once. Threads stay at most as many queries ahead of the
+/// result being read as there are threads, which bounds that memory.
+class ParallelQueries {
+public:
+    using Conn = std::unique_ptr<mysql::MySqlConnection>;
+    using OpenFunc = std::function<Conn()>; ///< @return a connection, or nullptr on failure.
+    using CloseFunc = std::function<void(Conn)>;
+
+    /// Start the threads.
+    /// @param queries - queries to run, stays owned by the caller.
+    /// @param numThreads - number of threads, each with its own connection.
+    ParallelQueries(std::vector<std::string> const& queries, unsigned int numThreads,
+                    OpenFunc const& open, CloseFunc const& close);
+
+    /// Stop the threads and free the results that were not read.
+    ~ParallelQueries();
+
+    ParallelQueries(ParallelQueries const&) = delete;
+    ParallelQueries& operator=(ParallelQueries const&) = delete;
+
+    /// Wait for the result of the next query, in the order of 'queries'.
+    /// @return the result, to be freed with mysql_free_result(), or nullptr
+    ///         with 'error' set if the query failed or all were read.
+    MYSQL_RES* next(util::Error& error);
+
+    /// Kill the running queries and do not start others.
+    void cancel();
+
+private:
+    /// Result of one query.
+    struct Slot {
+        bool done{false};
+        MYSQL_RES* res{nullptr};
+        util::Error error;
+    };
+
+    void _run();
+
+    std::vector<std::string> const& _queries;
+    unsigned int const _ahead; ///< Queries a thread may start past the one being read.
+    OpenFunc const _open;
+    CloseFunc const _close;
+
+    std::mutex _mtx; ///< Protects members below.
+    std::condition_variable _cv;
+    std::vector<Slot> _slots; ///< One per query.
+    size_t _started{0}; ///< Number of queries started.
+    size_t _read{0}; ///< Number of results handed out by next().
+    bool _stop{false};
+    std::set<mysql::MySqlConnection*> _conns; ///< Connections of the threads, for cancel().
+    std::vector<std::thread> _threads;
+};
+
+}}} // namespace lsst::qserv::wdb
+
+#endif // LSST_QSERV_WDB_PARALLELQUERIES_H
@@ -33,13 +33,18 @@
 
 // System headers
 #include <algorithm>
+#include <cerrno>
 #include <cstddef>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <memory>
 
 // Third-party headers
 #include <boost/algorithm/string/replace.hpp>
 #include <mysql/mysql.h>
+#include <sys/resource.h>
+#include <unistd.h>
 
 // Class header
 #include "wdb/QueryRunner.h"
@@ -57,21 +62,39 @@
 #include "mysql/MySqlConnection.h"
 #include "mysql/SchemaFactory.h"
 #include "proto/ProtoHeaderWrap.h"
+#include "proto/ResultCompression.h"
+#include "proto/WorkerResponse.h"
 #include "proto/worker.pb.h"
 #include "sql/Schema.h"
 #include "sql/SqlErrorObject.h"
 #include "util/common.h"
 #include "util/IterableFormatter.h"
+#include "util/Metrics.h"
 #include "util/MultiError.h"
+#include "util/Profiler.h"
 #include "util/StringHash.h"
 #include "util/Timer.h"
+#include "util/Trace.h"
 #include "util/threadSafe.h"
 #include "wbase/Base.h"
 #include "wbase/SendChannel.h"
+#include "wbase/TaskFold.h"
 #include "wdb/ChunkResource.h"
+#include "wdb/NativeJoin.h"
+#include "wdb/NativeScan.h"
 
 namespace {
 LOG_LOGGER _log = LOG_GET("lsst.qserv.wdb.QueryRunner");
+
+/// @return the user and system CPU time of the calling thread in microseconds.
+uint64_t threadCpuUs() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_THREAD, &usage) != 0) {
+        return 0;
+    }
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000ULL
+           + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
 }
 
 namespace lsst {
@@ -81,8 +104,11 @@ namespace wdb {
 
 QueryRunner::Ptr QueryRunner::newQueryRunner(wbase::Task::Ptr const& task,
                                              ChunkResourceMgr::Ptr const& chunkResourceMgr,
-                                             mysql::MySqlConfig const& mySqlConfig) {
-    Ptr qr{new QueryRunner{task, chunkResourceMgr, mySqlConfig}}; // Private constructor.
+                                             mysql::MySqlConfig const& mySqlConfig,
+                                             TransmitConfig const& transmitConfig,
+                                             TransmitMgr::Ptr const& transmitMgr) {
+    Ptr qr{new QueryRunner{task, chunkResourceMgr, mySqlConfig, transmitConfig,
+                           transmitMgr}}; // Private constructor.
     // Let the Task know this is its QueryRunner.
     bool cancelled = qr->_task->setTaskQueryRunner(qr);
     if (cancelled) {
@@ -96,25 +122,38 @@ QueryRunner::Ptr QueryRunner::newQueryRunner(wbase::Task::Ptr const& task,
 /// and correct setup of enable_shared_from_this.
 QueryRunner::QueryRunner(wbase::Task::Ptr const& task,
                          ChunkResourceMgr::Ptr const& chunkResourceMgr,
-                         mysql::MySqlConfig const& mySqlConfig)
-    : _task(task), _chunkResourceMgr(chunkResourceMgr), _mySqlConfig(mySqlConfig) {
+                         mysql::MySqlConfig const& mySqlConfig,
+                         TransmitConfig const& transmitConfig,
+                         TransmitMgr::Ptr const& transmitMgr)
+    : _task(task), _chunkResourceMgr(chunkResourceMgr), _mySqlConfig(mySqlConfig),
+      _transmitConfig(transmitConfig), _transmitMgr(transmitMgr),
+      _arena(proto::makeResultArenaOptions()) {
     int rc = mysql_thread_init();
     assert(rc == 0);
     assert(_task->msg);
+    _task->expandMsg(); // The task is about to run.
 }
 
 /// Initialize the db connection
 bool QueryRunner::_initConnection() {
     mysql::MySqlConfig localMySqlConfig(_mySqlConfig);
     localMySqlConfig.username = _task->user; // Override with czar-passed username.
-    _mysqlConn.reset(new mysql::MySqlConnection(localMySqlConfig));
+    bool connected = false;
+    if (_connPool != nullptr) {
+        _mysqlConn = _connPool->acquire(localMySqlConfig.username, _dbName);
+        connected = (_mysqlConn != nullptr);
+    } else {
+        _mysqlConn.reset(new mysql::MySqlConnection(localMySqlConfig));
+        connected = _mysqlConn->connect();
+    }
 
-    if (not _mysqlConn->connect()) {
+    if (not connected) {
         LOGS(_log, LOG_LVL_ERROR, _task->getIdStr() << " Unable to connect to MySQL: " << localMySqlConfig);
         util::Error error(-1, "Unable to connect to MySQL; " + localMySqlConfig.toString());
         _multiError.push_back(error);
         return false;
     }
+    _mysqlConn->setStatementCacheSize(_statementCache);
     return true;
 }
 
@@ -127,7 +166,9 @@ void QueryRunner::_setDb() {
 }
 
 
-util::TimerHistogram memWaitHisto("memWait Hist", {1, 5, 10, 20, 40});
+util::Histogram::Ptr const memWaitHisto = util::MetricsRegistry::get().histogram(
+        "qserv_worker_memman_wait_seconds", "Time tasks waited for their tables to be locked",
+        {0.1, 1, 5, 10, 20, 40});
 
 
 bool QueryRunner::runQuery() {
@@ -137,7 +178,13 @@ bool QueryRunner::runQuery() {
     class Release {
     public:
         Release(wbase::Task::Ptr t, wbase::TaskQueryRunner *tqr) : _t{t}, _tqr{tqr} {}
-        ~Release() { _t->freeTaskQueryRunner(_tqr); }
+        ~Release() {
+            if (_t->getPreempted()) {
+                _t->unlockMemHandle(); // Its scheduler left the tables locked, see _yieldToInteractive().
+            }
+            _t->freeTaskQueryRunner(_tqr);
+            _t->leaveFold(nullptr); // Unless the task already left with the folded rows.
+        }
     private:
         wbase::Task::Ptr _t;
         wbase::TaskQueryRunner *_tqr;
@@ -149,19 +196,45 @@ bool QueryRunner::runQuery() {
         return false;
     }
 
+    _cpuStartUs = threadCpuUs();
+    if (_task->msg->trace()) {
+        // The scheduler only keeps the queued time in milliseconds.
+        double const queuedSec = _task->getQueuedTime().count() / 1000.0;
+        _traceAdd("worker_queue", util::traceNowUs() - static_cast<uint64_t>(queuedSec * 1e6), queuedSec);
+    }
+
     // Wait for memman to finish reserving resources. This can take several seconds.
+    uint64_t const memStartUs = util::traceNowUs();
     util::Timer memTimer;
     memTimer.start();
     _task->waitForMemMan();
     memTimer.stop();
-    auto logMsg = memWaitHisto.addTime(memTimer.getElapsed(), _task->getIdStr());
-    LOGS(_log, LOG_LVL_INFO, logMsg);
+    memWaitHisto->observe(memTimer.getElapsed());
+    _traceAdd("memman_wait", memStartUs, memTimer.getElapsed());
+    _usage.memLockedBytes = _task->getMemHandleStatus().bytesLock;
+    LOGS(_log, LOG_LVL_DEBUG, _task->getIdStr() << " memWait " << memTimer.getElapsed() << "s");
 
     if (_task->getCancelled()) {
         LOGS(_log, LOG_LVL_DEBUG, _task->getIdStr() << " runQuery, task was cancelled after locking tables.");
         return false;
     }
 
+    // The result of a folded task depends on the other tasks of its query.
+    _folding = (_task->getFold() != nullptr);
+    if (_resultCache != nullptr && !_folding) {
+        // Waits if a task with the same work is running, so they share its scan.
+        auto entry = _resultCache->getOrRun(_cacheKey);
+        if (entry != nullptr) {
+            // The key covers the protocol, so the entry is in the format the czar asked for.
+            LOGS(_log, LOG_LVL_DEBUG, _task->getIdStr() << " answering from result cache");
+            _columnar = (_task->msg->protocol() == 3);
+            _initMsgs();
+            return _replayCached(*entry);
+        }
+        _cacheEntry = std::make_shared<ResultCache::Entry>();
+        _cacheClaimed = true;
+    }
+
     _setDb();
     LOGS(_log, LOG_LVL_DEBUG,  _task->getIdStr() << " Exec in flight for Db=" << _dbName);
     bool connOk = _initConnection();
@@ -175,6 +248,9 @@ bool QueryRunner::runQuery() {
 
     if (_task->msg->has_protocol()) {
         switch(_task->msg->protocol()) {
+        case 3:
+            _columnar = true; // The czar accepts column blocks.
+            return _dispatchChannel();
         case 2:
             return _dispatchChannel(); // Run the query and send the results back.
         case 1:
@@ -201,11 +277,24 @@ MYSQL_RES* QueryRunner::_primeResult(std::string const& query) {
 
 void QueryRunner::_initMsgs() {
     _protoHeader = std::make_shared<proto::ProtoHeader>();
+    // Without a range from the czar, every message is cut at the desired limit.
+    size_t const hardLimit = proto::ProtoHeaderWrap::PROTOBUFFER_HARD_LIMIT;
+    _msgMaxLimit = proto::ProtoHeaderWrap::PROTOBUFFER_DESIRED_LIMIT;
+    _msgLimit = _msgMaxLimit;
+    if (_task->msg->resultmaxbytes() > 0) {
+        _msgMaxLimit = std::min<size_t>(_task->msg->resultmaxbytes(), hardLimit);
+        _msgLimit = std::min<size_t>(_task->msg->resultminbytes(), _msgMaxLimit);
+        if (_msgLimit == 0) {
+            _msgLimit = _msgMaxLimit;
+        }
+    }
     _initMsg();
 }
 
 void QueryRunner::_initMsg() {
-    _result = std::make_shared<proto::Result>();
+    _result = nullptr;
+    _arena.Reset();
+    _result = google::protobuf::Arena::CreateMessage<proto::Result>(&_arena);
     _result->mutable_rowschema();
     _result->set_continues(0);
     if (_task->msg->has_session()) {
@@ -226,15 +315,32 @@ void QueryRunner::_fillSchema(MYSQL_RES* result) {
     }
 }
 
-/// Fill one row in the Result msg from one row in MYSQL_RES*
+/// Fill the Result msg with the rows of MYSQL_RES*
 /// If the message has gotten larger than the desired message size,
 /// it will be transmitted with a flag set indicating the result
 /// continues in later messages.
 bool QueryRunner::_fillRows(MYSQL_RES* result, int numFields, uint& rowCount, size_t& tSize) {
     MYSQL_ROW row;
-
     while ((row = mysql_fetch_row(result))) {
-        auto lengths = mysql_fetch_lengths(result);
+        if (!_addRow(row, mysql_fetch_lengths(result), numFields, rowCount, tSize)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/// Add one row to the Result msg, transmitting the message with the continues
+/// flag set once it is large or old enough.
+/// @return false if the row is too large to send.
+bool QueryRunner::_addRow(MYSQL_ROW row, unsigned long* lengths, int numFields,
+                          uint& rowCount, size_t& tSize) {
+    unsigned int const flushRows = _transmitConfig.flushRows;
+    auto const flushTime = std::chrono::milliseconds(_transmitConfig.flushMs);
+
+    if (_columnar) {
+        tSize += _appendColumns(row, lengths, numFields, rowCount);
+    } else {
         proto::RowBundle* rawRow =_result->add_row();
         for(int i=0; i < numFields; ++i) {
             if (row[i]) {
@@ -246,48 +352,140 @@ bool QueryRunner::_fillRows(MYSQL_RES* result, int numFields, uint& rowCount, si
             }
         }
         tSize += rawRow->ByteSize();
-        ++rowCount;
+    }
+    if (rowCount == 0) {
+        _msgStart = std::chrono::steady_clock::now();
+    }
+    ++rowCount;
 
-        unsigned int szLimit = std::min(proto::ProtoHeaderWrap::PROTOBUFFER_DESIRED_LIMIT,
-                                        proto::ProtoHeaderWrap::PROTOBUFFER_HARD_LIMIT);
+    bool flush = false;
+    if (_folding) {
+        // The rows are kept in one message to be folded, unless they outgrow it.
+        flush = tSize > _msgMaxLimit;
+        _folding = !flush;
+    } else {
+        // Besides the size limit, send early when the row count or time trigger is hit.
+        // The clock is only read every 64 rows to keep it off the per-row cost.
+        flush = tSize > _msgLimit || (flushRows > 0 && rowCount >= flushRows);
+        if (!flush && flushTime.count() > 0 && rowCount % 64 == 0) {
+            flush = std::chrono::steady_clock::now() - _msgStart >= flushTime;
+        }
+    }
 
-        // Each element needs to be mysql-sanitized
-        if (tSize > szLimit) {
-            if (tSize > proto::ProtoHeaderWrap::PROTOBUFFER_HARD_LIMIT) {
-                LOGS_ERROR("Message single row too large to send using protobuffer");
-                return false;
-            }
-            LOGS(_log, LOG_LVL_DEBUG, _task->getIdStr() << " Large message size=" << tSize
-                 << ", splitting message rowCount=" << rowCount);
-            _transmit(false, rowCount, tSize);
-            rowCount = 0;
-            tSize = 0;
-            _initMsg();
-            // This task is going to have multiple results to return to the czar and
-            // the speed this task can be completed will be limited by the czar's ability to
-            // read in results, which could be very very slow. The upshot of this is the
-            // scheduler for this worker should stop waiting for this task. leavePool()
-            // will tell the scheduler this task is finished and create a new thread in the pool
-            // to replace this thread.
-            auto pet = _task->getAndNullPoolEventThread();
-            if (pet != nullptr) {
-                pet->leavePool();
-            } else {
-                LOGS(_log, LOG_LVL_DEBUG, "Large result PoolEventThread was null. Probably already moved. b");
-            }
+    // Each element needs to be mysql-sanitized
+    if (flush) {
+        if (tSize > proto::ProtoHeaderWrap::PROTOBUFFER_HARD_LIMIT) {
+            LOGS_ERROR("Message single row too large to send using protobuffer");
+            return false;
         }
+        LOGS(_log, LOG_LVL_DEBUG, _task->getIdStr() << " Flushing message size=" << tSize
+             << ", splitting message rowCount=" << rowCount);
+        _transmit(false, rowCount, tSize);
+        rowCount = 0;
+        tSize = 0;
+        // The first message is small so the czar gets rows early, later ones
+        // grow to the largest size the czar asked for.
+        _msgLimit = std::min(_msgLimit * 2, _msgMaxLimit);
+        _initMsg();
+        _leavePool();
+        _yieldToInteractive();
     }
     return true;
 }
 
 
-util::TimerHistogram transmitHisto("transmit Hist", {0.1, 1, 5, 10, 20, 40});
+/// This task is going to have multiple results to return to the czar and
+/// the speed this task can be completed will be limited by the czar's ability to
+/// read in results, which could be very very slow. The upshot of this is the
+/// scheduler for this worker should stop waiting for this task. leavePool()
+/// will tell the scheduler this task is finished and create a new thread in the pool
+/// to replace this thread.
+void QueryRunner::_leavePool() {
+    if (_transmitStage != nullptr) {
+        return; // The stage sends the messages, this thread never waits for the czar.
+    }
+    auto pet = _task->getAndNullPoolEventThread();
+    if (pet != nullptr) {
+        pet->leavePool();
+    } else {
+        LOGS(_log, LOG_LVL_DEBUG, "Large result PoolEventThread was null. Probably already moved. b");
+    }
+}
+
+
+util::Histogram::Ptr const preemptHisto = util::MetricsRegistry::get().histogram(
+        "qserv_worker_preempt_pause_seconds", "Time scan tasks paused for interactive tasks",
+        {0.1, 1, 5, 10, 20, 40});
+
+
+/// A scan task that its scheduler preempts for interactive tasks waiting for
+/// a thread leaves the pool, so that a new thread runs them, and pauses until
+/// they started. The MySQL result being read and the tables locked for the
+/// task are kept, the task then resumes out of the pool where it stopped.
+void QueryRunner::_yieldToInteractive() {
+    if (_transmitStage == nullptr || _task->getOnInteractive() || _task->getPreempted()) {
+        return; // Without a stage, the task left the pool with its first message.
+    }
+    auto scheduler = _task->getTaskScheduler();
+    if (scheduler == nullptr || !scheduler->preempt(*_task)) {
+        return;
+    }
+    auto pet = _task->getAndNullPoolEventThread();
+    if (pet == nullptr) {
+        LOGS(_log, LOG_LVL_DEBUG, _task->getIdStr() << " preempted PoolEventThread was null, already moved");
+        _task->setPreempted(false); // Its scheduler already unlocked its tables.
+        return;
+    }
+    pet->leavePool();
+    uint64_t const pauseStartUs = util::traceNowUs();
+    util::Timer pauseTimer;
+    pauseTimer.start();
+    scheduler->waitPreempted(*_task);
+    pauseTimer.stop();
+    preemptHisto->observe(pauseTimer.getElapsed());
+    _traceAdd("preempted", pauseStartUs, pauseTimer.getElapsed());
+}
+
+
+/// Append one MySQL row to the column blocks of the Result msg, where
+/// 'rowIdx' is the index of the row within the current message.
+/// @return an estimate of the number of bytes added to the message.
+size_t QueryRunner::_appendColumns(MYSQL_ROW row, unsigned long* lengths, int numFields, uint rowIdx) {
+    while (_result->columnblock_size() < numFields) {
+        _result->add_columnblock();
+    }
+    size_t added = 0;
+    for(int i=0; i < numFields; ++i) {
+        proto::ColumnBlock* block = _result->mutable_columnblock(i);
+        if (row[i]) {
+            block->mutable_values()->append(row[i], lengths[i]);
+            added += lengths[i];
+        } else {
+            std::string* nullBitmap = block->mutable_nullbitmap();
+            size_t byteIdx = rowIdx / 8;
+            if (nullBitmap->size() <= byteIdx) {
+                added += byteIdx + 1 - nullBitmap->size();
+                nullBitmap->resize(byteIdx + 1, '\0');
+            }
+            (*nullBitmap)[byteIdx] |= static_cast<char>(1 << (rowIdx % 8));
+        }
+        block->add_offsets(block->values().size());
+        added += sizeof(uint32_t); // Upper bound of the varint size for reasonable offsets.
+    }
+    return added;
+}
+
+
+util::Histogram::Ptr const transmitHisto = util::MetricsRegistry::get().histogram(
+        "qserv_worker_transmit_wait_seconds", "Time tasks waited for result messages in flight",
+        {0.1, 1, 5, 10, 20, 40});
 
 
 /// Transmit result data with its header.
 /// If 'last' is true, this is the last message in the result set
 /// and flags are set accordingly.
 void QueryRunner::_transmit(bool last, uint rowCount, size_t tSize) {
+    util::ThreadRole role("transmit");
     LOGS(_log, LOG_LVL_DEBUG, _task->getIdStr() << " _transmit last=" << last
          << " rowCount=" << rowCount << " tSize=" << tSize);
     std::string resultString;
@@ -298,6 +496,20 @@ void QueryRunner::_transmit(bool last, uint rowCount, size_t tSize) {
     _result->set_rowcount(rowCount);
     _result->set_transmitsize(tSize);
     _result->set_attemptcount(_task->getAttemptCount());
+    _result->clear_span(); // Replayed cache entries carry the spans of the task that made them.
+    if (last) {
+        _usage.cpuUs = threadCpuUs() - _cpuStartUs;
+        proto::ResourceUsage* usage = _result->mutable_usage();
+        usage->set_cpuus(_usage.cpuUs);
+        usage->set_rowsread(_usage.rowsRead);
+        usage->set_memlockedbytes(_usage.memLockedBytes);
+        for (auto const& span : _spans) {
+            proto::TraceSpan* pSpan = _result->add_span();
+            pSpan->set_name(span.name);
+            pSpan->set_startus(span.startUs);
+            pSpan->set_durationus(span.durationUs);
+        }
+    }
     if (!_multiError.empty()) {
         std::string chunkId = std::to_string(_task->msg->chunkid());
         std::string msg = "Error(s) in result for chunk #" + chunkId + ": " + _multiError.toOneLineString();
@@ -305,72 +517,340 @@ void QueryRunner::_transmit(bool last, uint rowCount, size_t tSize) {
         LOGS(_log, LOG_LVL_ERROR, msg);
     }
     _result->SerializeToString(&resultString);
-    _result.reset(); // don't need it anymore and a new one will be made when needed..
+    if (_cacheEntry != nullptr) {
+        // Keep a copy for the result cache, unless the result is too big to be cached.
+        if (!_multiError.empty() || _cacheEntry->bytes + resultString.size() > _resultCache->getMaxEntryBytes()) {
+            _cacheEntry.reset();
+            _releaseCacheClaim(); // Tasks waiting for this result run their own scan.
+        } else {
+            _cacheEntry->results.push_back(resultString);
+            _cacheEntry->bytes += resultString.size();
+        }
+    }
+    // Don't need it anymore, a new one will be made when needed.
+    _result = nullptr;
+    _arena.Reset();
+
+    // Compress the message if configured to, the header carries the codec and original size.
+    size_t const uncompressedSize = resultString.size();
+    _protoHeader->set_compression(proto::ProtoHeader::NONE);
+    std::string compressed;
+    if (proto::ResultCompression::compress(_transmitConfig.compression, _transmitConfig.compressionLevel,
+                                           resultString, compressed)) {
+        _protoHeader->set_compression(_transmitConfig.compression);
+        resultString.swap(compressed);
+        LOGS(_log, LOG_LVL_DEBUG, _task->getIdStr() << " compressed " << uncompressedSize
+             << " to " << resultString.size());
+    }
+
+    _usage.bytesTransmitted += resultString.size();
+    if (last) {
+        _task->setUsage(_usage);
+    }
+
+    if (_spoolFd >= 0) {
+        _transmitSpooled(resultString, uncompressedSize, last);
+        _largeResult = true;
+        return;
+    }
 
-    _transmitHeader(resultString);
+    // Wait for a share of the worker's transmit budget before queuing the header,
+    // the bytes are given back when XrdSsi recycles the Result buffer.
+    auto const czarId = _task->getCzarId();
+    auto const qId = _task->getQueryId();
+    size_t const meteredBytes = resultString.size();
+    bool metered = (_transmitMgr != nullptr) && !_cancelled;
+    if (metered && !_transmitMgr->take(czarId, qId, _task->getScanInteractive(), meteredBytes)) {
+        LOGS(_log, LOG_LVL_DEBUG, _task->getIdStr() << " _transmit query cancelled while waiting");
+        metered = false;
+        _cancelled.store(true);
+    }
+
+    if (_transmitStage != nullptr) {
+        std::function<void()> onRecycle;
+        if (metered) {
+            TransmitMgr::Ptr transmitMgr = _transmitMgr;
+            onRecycle = [transmitMgr, czarId, qId, meteredBytes]() {
+                transmitMgr->release(czarId, qId, meteredBytes);
+            };
+        }
+        _pushStaged(resultString, uncompressedSize, last, onRecycle);
+        _largeResult = true;
+        return;
+    }
+
+    _transmitHeader(resultString, uncompressedSize);
     LOGS(_log, LOG_LVL_DEBUG, "_transmit last=" << last << " " << _task->getIdStr()
          << " resultString=" << util::prettyCharList(resultString, 5));
 
     if (!_cancelled) {
         // StreamBuffer::create invalidates resultString by using std::move()
         xrdsvc::StreamBuffer::Ptr streamBuf(xrdsvc::StreamBuffer::createWithMove(resultString));
+        if (metered) {
+            TransmitMgr::Ptr transmitMgr = _transmitMgr;
+            streamBuf->setRecycleFunc([transmitMgr, czarId, qId, meteredBytes]() {
+                transmitMgr->release(czarId, qId, meteredBytes);
+            });
+        }
         bool sent = _task->sendChannel->sendStream(streamBuf, last);
         if (!sent) {
             LOGS(_log, LOG_LVL_ERROR, _task->getIdStr() << " Failed to transmit message!");
         }
-        // Block on the buffer being sent.
+        _inFlight.push_back(streamBuf);
+        // Keep filling the next message while this one is being sent, unless too many
+        // messages are in flight. The last message must be sent before the task is done.
         auto totalBytes = xrdsvc::StreamBuffer::getTotalBytes();
         LOGS(_log, LOG_LVL_INFO, _task->getIdStr() << " waiting for buffer largeResult=" << _largeResult
-                << " totalBytes=" << totalBytes);
+                << " totalBytes=" << totalBytes << " inFlight=" << _inFlight.size());
+        uint64_t const waitStartUs = util::traceNowUs();
         util::Timer t;
         t.start();
-        streamBuf->waitForDoneWithThis(); // Block until this buffer has been sent.
+        _waitForInFlight(last ? 0 : _transmitConfig.transmitDepth);
         t.stop();
-        auto logMsg = transmitHisto.addTime(t.getElapsed(), _task->getIdStr());
-        LOGS(_log, LOG_LVL_DEBUG, logMsg);
+        transmitHisto->observe(t.getElapsed());
+        _traceAdd("transmit_wait", waitStartUs, t.getElapsed());
     } else {
+        if (metered) _transmitMgr->release(czarId, qId, meteredBytes);
         LOGS(_log, LOG_LVL_DEBUG, "_transmit cancelled");
     }
     _largeResult = true; // Transmits after the first are considered large results.
 }
 
 
-util::TimerHistogram transHeaderHisto("transHeader Hist", {0.1, 1, 5, 10, 20, 40});
-
-
 /// Transmit the protoHeader
-void QueryRunner::_transmitHeader(std::string& msg) {
+void QueryRunner::_transmitHeader(std::string& msg, size_t uncompressedSize) {
     LOGS(_log, LOG_LVL_DEBUG, "_transmitHeader");
+    auto msgBuf = _makeHeader(msg, uncompressedSize);
+    if (!_cancelled) {
+        xrdsvc::StreamBuffer::Ptr streamBuf(xrdsvc::StreamBuffer::createWithMove(msgBuf)); // invalidates msgBuf
+        bool sent = _task->sendChannel->sendStream(streamBuf, false);
+        if (!sent) {
+            LOGS(_log, LOG_LVL_ERROR, _task->getIdStr() << " Failed to transmit header!");
+        }
+        // The header is tiny, it only needs to be tracked so that buffers are waited on in order.
+        _inFlight.push_back(streamBuf);
+    } else {
+        LOGS(_log, LOG_LVL_DEBUG, _task->getIdStr() << " _transmitHeader cancelled");
+    }
+}
+
+
+/// Queue the Result message 'msg' and its header in _transmitStage, which
+/// invalidates 'msg'. This only blocks while the stage is full.
+void QueryRunner::_pushStaged(std::string& msg, size_t uncompressedSize, bool last,
+                              std::function<void()> const& onRecycle) {
+    auto stream = _openStream();
+    if (stream == nullptr) {
+        if (onRecycle) onRecycle();
+        LOGS(_log, LOG_LVL_DEBUG, _task->getIdStr() << " _pushStaged cancelled");
+        return;
+    }
+    auto headerString = _makeHeader(msg, uncompressedSize);
+    xrdsvc::StreamBuffer::Ptr header(xrdsvc::StreamBuffer::createWithMove(headerString));
+    xrdsvc::StreamBuffer::Ptr result(xrdsvc::StreamBuffer::createWithMove(msg));
+    util::Timer t;
+    t.start();
+    if (!_transmitStage->push(stream, header, result, last, onRecycle)) {
+        LOGS(_log, LOG_LVL_DEBUG, _task->getIdStr() << " _pushStaged cancelled while waiting");
+    }
+    t.stop();
+    transmitHisto->observe(t.getElapsed());
+}
+
+
+/// @return the stream of this task in _transmitStage, null once cancelled.
+TransmitStage::StreamPtr QueryRunner::_openStream() {
+    std::lock_guard<std::mutex> lock(_streamMtx);
+    if (_stream == nullptr && !_cancelled) {
+        _stream = _transmitStage->openStream(_task->sendChannel, _task->getQueryId(),
+                                             _transmitConfig.transmitDepth);
+    }
+    return _cancelled ? nullptr : _stream;
+}
+
+
+/// @return the wrapped protoHeader describing the Result message 'msg'.
+std::string QueryRunner::_makeHeader(std::string const& msg, size_t uncompressedSize) {
     // Set header
-    _protoHeader->set_protocol(2); // protocol 2: row-by-row message
+    // protocol 2: row-by-row message, protocol 3: column blocks
+    _protoHeader->set_protocol(_columnar ? 3 : 2);
     _protoHeader->set_size(msg.size());
-    _protoHeader->set_md5(util::StringHash::getMd5(msg.data(), msg.size()));
+    _protoHeader->set_checksum(_transmitConfig.checksum);
+    if (_transmitConfig.checksum == proto::ProtoHeader::CRC32C) {
+        _protoHeader->set_crc32c(util::StringHash::getCrc32c(msg.data(), msg.size()));
+    } else {
+        _protoHeader->set_md5(util::StringHash::getMd5(msg.data(), msg.size()));
+    }
     _protoHeader->set_wname(getHostname());
     _protoHeader->set_largeresult(_largeResult);
+    _protoHeader->set_uncompressedsize(uncompressedSize);
+    _protoHeader->set_queuemillis(_task->getQueuedTime().count());
+    _protoHeader->set_runmillis(_task->getRunTime().count());
+    auto scheduler = _task->getTaskScheduler();
+    int const scanCursor = (scheduler == nullptr) ? -1 : scheduler->getScanCursor(_task->getChunkId());
+    if (scanCursor >= 0) {
+        _protoHeader->set_scancursor(scanCursor);
+    }
     std::string protoHeaderString;
     _protoHeader->SerializeToString(&protoHeaderString);
 
-    // Flush to channel.
     // Make sure protoheader size can be encoded in a byte.
     assert(protoHeaderString.size() < 255);
-    if (!_cancelled) {
-        auto msgBuf = proto::ProtoHeaderWrap::wrap(protoHeaderString);
-        xrdsvc::StreamBuffer::Ptr streamBuf(xrdsvc::StreamBuffer::createWithMove(msgBuf)); // invalidates msgBuf
-        bool sent = _task->sendChannel->sendStream(streamBuf, false);
-        if (!sent) {
-            LOGS(_log, LOG_LVL_ERROR, _task->getIdStr() << " Failed to transmit header!");
+    return proto::ProtoHeaderWrap::wrap(protoHeaderString);
+}
+
+
+/// Open an unlinked spool file in the configured directory.
+/// @return false if the file can't be created, results are then streamed.
+bool QueryRunner::_spoolOpen() {
+    std::string path = _transmitConfig.spoolDir + "/qserv-result-XXXXXX";
+    std::vector<char> tmpl(path.begin(), path.end());
+    tmpl.push_back('\0');
+    int fd = ::mkstemp(tmpl.data());
+    if (fd < 0) {
+        LOGS(_log, LOG_LVL_WARN, _task->getIdStr() << " Unable to create spool file " << path
+             << ": " << std::strerror(errno) << ", streaming results instead");
+        return false;
+    }
+    // The file goes away once the descriptor is closed.
+    ::unlink(tmpl.data());
+    _spoolFd = fd;
+    _spoolSize = 0;
+    return true;
+}
+
+
+/// Append 'data' to the spool file.
+bool QueryRunner::_spoolWrite(std::string const& data) {
+    char const* ptr = data.data();
+    size_t remain = data.size();
+    while (remain > 0) {
+        ssize_t written = ::write(_spoolFd, ptr, remain);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            LOGS(_log, LOG_LVL_ERROR, _task->getIdStr() << " Failed to write spool file: "
+                 << std::strerror(errno));
+            return false;
         }
-        util::Timer t;
-        t.start();
-        streamBuf->waitForDoneWithThis(); // Block until this buffer has been sent.
-        t.stop();
-        auto logMsg = transHeaderHisto.addTime(t.getElapsed(), _task->getIdStr());
-        LOGS(_log, LOG_LVL_DEBUG, logMsg);
-    } else {
-        LOGS(_log, LOG_LVL_DEBUG, _task->getIdStr() << " _transmitHeader cancelled");
+        ptr += written;
+        remain -= written;
+    }
+    _spoolSize += data.size();
+    return true;
+}
+
+
+/// Write a Result message and its header to the spool file, and hand the
+/// whole file to XrdSsi after the last message. Nothing reaches XrdSsi before
+/// that, so this task never waits on the czar while MySQL resources are held.
+void QueryRunner::_transmitSpooled(std::string const& resultString, size_t uncompressedSize, bool last) {
+    if (_cancelled) {
+        LOGS(_log, LOG_LVL_DEBUG, "_transmitSpooled cancelled");
+        return;
+    }
+    if (!_spoolWrite(_makeHeader(resultString, uncompressedSize)) || !_spoolWrite(resultString)) {
+        int const err = errno;
+        ::close(_spoolFd);
+        _spoolFd = -1;
+        _task->sendChannel->sendError("Failed to write result spool file", err);
+        _cancelled.store(true); // Nothing more can be sent for this task.
+        return;
+    }
+    if (!last) return;
+
+    int const fd = _spoolFd;
+    _spoolFd = -1;
+    if (::lseek(fd, 0, SEEK_SET) < 0) {
+        LOGS(_log, LOG_LVL_ERROR, _task->getIdStr() << " Failed to rewind spool file: "
+             << std::strerror(errno));
+    }
+    LOGS(_log, LOG_LVL_DEBUG, _task->getIdStr() << " sending spool file size=" << _spoolSize);
+    // XrdSsi reads from fd until the czar is done, then the channel releases it.
+    _task->sendChannel->setReleaseFunc([fd]() { ::close(fd); });
+    if (!_task->sendChannel->sendFile(fd, _spoolSize)) {
+        LOGS(_log, LOG_LVL_ERROR, _task->getIdStr() << " Failed to transmit spool file!");
     }
 }
 
+
+/// Block until no more than 'maxResults' Result messages are waiting to be sent
+/// by XrdSsi, and the bytes held by all StreamBuffers on the worker are within
+/// the configured budget, or until only the most recent message is in flight.
+/// Buffers are sent in order, so the oldest buffer is always waited on first.
+void QueryRunner::_waitForInFlight(unsigned int maxResults) {
+    // Each Result message is preceded by its header in _inFlight.
+    size_t const maxBuffers = 2 * maxResults;
+    size_t const budget = _transmitConfig.transmitMemoryBudgetMB * 1000000;
+    auto overBudget = [this, budget]() {
+        // Always allow the message just sent to be in flight.
+        return budget > 0 && _inFlight.size() > 2 && xrdsvc::StreamBuffer::getTotalBytes() > budget;
+    };
+    while (!_inFlight.empty() && (_inFlight.size() > maxBuffers || overBudget())) {
+        _inFlight.front()->waitForDoneWithThis();
+        _inFlight.pop_front();
+    }
+}
+
+/// Add 'seconds' spent in stage 'name' to the spans of a traced task. The
+/// time of a stage entered several times is summed into its first span.
+void QueryRunner::_traceAdd(char const* name, uint64_t startUs, double seconds) {
+    if (!_task->msg->trace()) {
+        return;
+    }
+    uint64_t const durationUs = static_cast<uint64_t>(seconds * 1e6);
+    for (auto& span : _spans) {
+        if (span.name == name) {
+            span.durationUs += durationUs;
+            return;
+        }
+    }
+    _spans.push_back(util::TraceSpan{name, _task->getJobId(), _task->getAttemptCount(), startUs, durationUs});
+}
+
+
+/// @return the sum of the Handler_read counters of the MySQL session, 0 if
+///         they could not be read. Reading them adds a few rows of its own.
+uint64_t QueryRunner::_handlerReads() {
+    MYSQL_RES* res = _mysqlConn->queryBuffered("SHOW SESSION STATUS LIKE 'Handler_read%'");
+    if (res == nullptr) {
+        LOGS(_log, LOG_LVL_WARN, _task->getIdStr() << " could not read handler counters: "
+             << _mysqlConn->getError());
+        return 0;
+    }
+    uint64_t reads = 0;
+    while (MYSQL_ROW row = mysql_fetch_row(res)) {
+        if (row[1] != nullptr) {
+            reads += std::strtoull(row[1], nullptr, 10);
+        }
+    }
+    mysql_free_result(res);
+    return reads;
+}
+
+
+/// Send the Result messages of a cached entry with this task's ids.
+bool QueryRunner::_replayCached(ResultCache::Entry const& entry) {
+    size_t const count = entry.results.size();
+    for (size_t j = 0; j < count; ++j) {
+        if (_cancelled) {
+            return false;
+        }
+        _initMsg();
+        if (!_result->ParseFromString(entry.results[j])) {
+            throw Bug("QueryRunner: unreadable Result in result cache");
+        }
+        if (_task->msg->has_session()) {
+            _result->set_session(_task->msg->session());
+        }
+        bool const last = (j + 1 == count);
+        _transmit(last, _result->rowcount(), _result->transmitsize());
+        if (!last) {
+            _leavePool();
+        }
+    }
+    return true;
+}
+
 class ChunkResourceRequest {
 public:
     ChunkResourceRequest(std::shared_ptr<ChunkResourceMgr> const& mgr,
@@ -427,8 +907,16 @@ bool QueryRunner::_dispatchChannel() {
     }
     ChunkResourceRequest req(_chunkResourceMgr, m);
 
+    // Scans may write their results to a spool file so the task does not wait
+    // for the czar to read each message. Interactive queries stream for latency.
+    if (!_transmitConfig.spoolDir.empty() && !_task->getScanInteractive()) {
+        _spoolOpen();
+    }
+
     uint rowCount = 0;
     size_t tSize = 0;
+    uint64_t const readsBefore = _handlerReads();
+    std::unique_ptr<NativeJoin::Tables> nativeTables;
 
     try {
         for(int i=0; i < m.fragment_size(); ++i) {
@@ -437,7 +925,7 @@ bool QueryRunner::_dispatchChannel() {
             }
             proto::TaskMsg_Fragment const& fragment(m.fragment(i));
             std::vector<std::string> queries;
-            for (const std::string queryStr: fragment.query()) {
+            for (auto const& queryStr : fragment.query()) {
                 if (fragment.has_subchunks() && false == fragment.subchunks().id().empty()) {
                     for (auto subchunkId : fragment.subchunks().id()) {
                         std::string s(queryStr);
@@ -448,29 +936,74 @@ bool QueryRunner::_dispatchChannel() {
                     queries.push_back(queryStr);
                 }
             }
+            if (!_transmitConfig.nativeScanDir.empty() && fragment.has_subchunks()) {
+                // Near neighbour joins run natively need no subchunk tables.
+                if (nativeTables == nullptr) {
+                    nativeTables.reset(new NativeJoin::Tables(_transmitConfig.nativeScanDir));
+                }
+                std::vector<NativeJoin::Ptr> joins;
+                for (auto const& query : queries) {
+                    auto join = NativeJoin::plan(query, *nativeTables);
+                    if (join == nullptr) {
+                        joins.clear();
+                        break;
+                    }
+                    joins.push_back(std::move(join));
+                }
+                if (!joins.empty()) {
+                    for (auto const& join : joins) {
+                        if (_cancelled || !_dispatchJoin(*join, firstResult, numFields, rowCount, tSize)) {
+                            erred = true;
+                            break;
+                        }
+                    }
+                    continue;
+                }
+            }
             ChunkResource cr(req.getResourceFragment(i));
+            if (queries.size() == 1 && !_transmitConfig.nativeScanDir.empty()) {
+                auto scan = NativeScan::plan(queries.front(), _transmitConfig.nativeScanDir);
+                if (scan != nullptr) {
+                    if (!_dispatchNative(*scan, firstResult, numFields, rowCount, tSize)) {
+                        erred = true;
+                    }
+                    continue;
+                }
+            }
+            unsigned int const numThreads = std::min<size_t>(_task->getSubChunkThreads(), queries.size());
+            if (numThreads > 1) {
+                if (!_dispatchParallel(queries, numThreads, firstResult, numFields, rowCount, tSize)) {
+                    erred = true;
+                }
+                continue;
+            }
             // Use query fragment as-is, funnel results.
             for(auto const& query : queries) {
+                // Fragments seen before on this connection skip parsing and planning.
+                MYSQL_STMT* stmt = _mysqlConn->prepareCached(query);
+                mysql::StatementResult::Ptr stmtResult;
+                if (stmt != nullptr) {
+                    stmtResult = mysql::StatementResult::create(stmt);
+                }
+                if (stmtResult != nullptr) {
+                    if (!_dispatchPrepared(*stmtResult, firstResult, numFields, rowCount, tSize)) {
+                        erred = true;
+                    }
+                    continue;
+                }
+                uint64_t const sqlStartUs = util::traceNowUs();
                 util::Timer sqlTimer;
                 sqlTimer.start();
                 MYSQL_RES* res = _primeResult(query); // This runs the SQL query.
                 sqlTimer.stop();
+                _traceAdd("mysql", sqlStartUs, sqlTimer.getElapsed());
                 LOGS(_log, LOG_LVL_DEBUG, _task->getIdStr() << " fragment time=" << sqlTimer.getElapsed()
                                                             << " query=" << query);
                 if (!res) {
                     erred = true;
                     continue;
                 }
-                if (firstResult) {
-                    firstResult = false;
-                    _fillSchema(res);
-                    numFields = mysql_num_fields(res);
-                } // TODO: may want to confirm (cheaply) that
-                // successive queries have the same result schema.
-                // TODO fritzm: revisit this error strategy
-                // (see pull-request for DM-216)
-                // Now get rows...
-                if (!_fillRows(res, numFields, rowCount, tSize)) {
+                if (!_sendResult(res, firstResult, numFields, rowCount, tSize)) {
                     erred = true;
                 }
                 _mysqlConn->freeResult();
@@ -480,21 +1013,269 @@ bool QueryRunner::_dispatchChannel() {
         util::Error worker_err(e.errNo(), e.errMsg());
         _multiError.push_back(worker_err);
     }
+    uint64_t const readsAfter = _handlerReads();
+    _usage.rowsRead = (readsAfter > readsBefore) ? readsAfter - readsBefore : 0;
     if (!_cancelled) {
+        if (!_foldRows(erred, numFields, rowCount, tSize)) {
+            erred = true;
+        }
         // Send results.
         _transmit(true, rowCount, tSize);
+        if (!erred && _cacheEntry != nullptr) {
+            _resultCache->put(_cacheKey, _cacheEntry);
+            _cacheClaimed = false;
+        }
     } else {
         erred = true;
         // Send poison error.
         _multiError.push_back(util::Error(-1, "Poisoned."));
         // Do we need to do any cleanup?
     }
+    _releaseCacheClaim();
     return !erred;
 }
 
+
+/// Fold the rows of a task whose user query is folded, see wbase::TaskFold,
+/// and if it is the last of them to finish, add the rows of all the groups
+/// folded to its result. Rows that can't be folded stay in the result.
+/// @return false if the folded rows could not be sent.
+bool QueryRunner::_foldRows(bool erred, int& numFields, uint& rowCount, size_t& tSize) {
+    auto const fold = _task->getFold();
+    if (fold == nullptr) {
+        return true;
+    }
+    bool const failed = erred || !_multiError.empty();
+    if (_folding && !failed && rowCount > 0) {
+        _result->set_queryid(_task->getQueryId());
+        _result->set_rowcount(rowCount);
+        if (fold->fold(_task->getJobId(), *_result)) {
+            _result->clear_row();
+            _result->clear_columnblock();
+            rowCount = 0;
+            tSize = 0;
+        }
+    }
+    _folding = false;
+    proto::Result groups;
+    if (!_task->leaveFold(failed ? nullptr : &groups)) {
+        return true;
+    }
+    int const groupFields = groups.rowschema().columnschema_size();
+    if (numFields < 0) {
+        // The task had no result of its own.
+        *_result->mutable_rowschema() = groups.rowschema();
+        numFields = groupFields;
+    }
+    if (numFields != groupFields) {
+        _multiError.push_back(util::Error(-1, "Folded rows do not match the result schema"));
+        return false;
+    }
+    LOGS(_log, LOG_LVL_DEBUG, _task->getIdStr() << " sending " << groups.row_size() << " folded groups");
+    std::vector<char*> row(numFields);
+    std::vector<unsigned long> lengths(numFields);
+    for (auto& rb : *groups.mutable_row()) {
+        for (int i = 0; i < numFields; ++i) {
+            row[i] = rb.isnull(i) ? nullptr : &(*rb.mutable_column(i))[0];
+            lengths[i] = rb.column(i).size();
+        }
+        if (!_addRow(row.data(), lengths.data(), numFields, rowCount, tSize)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/// Add the rows of 'res' to the result stream, taking the schema from the
+/// first result.
+/// @return false if the rows could not be sent.
+bool QueryRunner::_sendResult(MYSQL_RES* res, bool& firstResult, int& numFields,
+                              uint& rowCount, size_t& tSize) {
+    if (firstResult) {
+        firstResult = false;
+        _fillSchema(res);
+        numFields = mysql_num_fields(res);
+    } // TODO: may want to confirm (cheaply) that
+    // successive queries have the same result schema.
+    // TODO fritzm: revisit this error strategy
+    // (see pull-request for DM-216)
+    // Now get rows...
+    return _fillRows(res, numFields, rowCount, tSize);
+}
+
+
+/// Run the subchunk 'queries' of a fragment on 'numThreads' connections of
+/// their own, and send their results in query order.
+/// @return false if a query failed or its rows could not be sent.
+bool QueryRunner::_dispatchParallel(std::vector<std::string> const& queries, unsigned int numThreads,
+                                    bool& firstResult, int& numFields, uint& rowCount, size_t& tSize) {
+    std::string const user = _task->user;
+    auto open = [this, user]() -> ParallelQueries::Conn {
+        if (_connPool != nullptr) {
+            return _connPool->acquire(user, _dbName);
+        }
+        mysql::MySqlConfig localMySqlConfig(_mySqlConfig);
+        localMySqlConfig.username = user;
+        ParallelQueries::Conn conn(new mysql::MySqlConnection(localMySqlConfig));
+        return conn->connect() ? std::move(conn) : nullptr;
+    };
+    auto close = [this](ParallelQueries::Conn conn) {
+        if (_connPool != nullptr) {
+            _connPool->release(std::move(conn));
+        }
+    };
+    LOGS(_log, LOG_LVL_DEBUG, _task->getIdStr() << " running " << queries.size()
+         << " subchunk queries on " << numThreads << " connections");
+    uint64_t const sqlStartUs = util::traceNowUs();
+    util::Timer sqlTimer;
+    sqlTimer.start();
+    ParallelQueries parallel(queries, numThreads, open, close);
+    {
+        std::lock_guard<std::mutex> lock(_parallelMtx);
+        _parallel = &parallel;
+    }
+    if (_cancelled) {
+        parallel.cancel();
+    }
+    bool ok = true;
+    for (size_t j = 0; j < queries.size(); ++j) {
+        util::Error error;
+        MYSQL_RES* res = parallel.next(error);
+        if (res == nullptr) {
+            _multiError.push_back(error);
+            ok = false;
+            continue;
+        }
+        if (ok && !_cancelled && !_sendResult(res, firstResult, numFields, rowCount, tSize)) {
+            ok = false;
+        }
+        mysql_free_result(res);
+    }
+    {
+        std::lock_guard<std::mutex> lock(_parallelMtx);
+        _parallel = nullptr;
+    }
+    sqlTimer.stop();
+    _traceAdd("mysql", sqlStartUs, sqlTimer.getElapsed());
+    LOGS(_log, LOG_LVL_DEBUG, _task->getIdStr() << " parallel fragment time=" << sqlTimer.getElapsed());
+    return ok;
+}
+
+
+/// Send the rows of 'scan', read from a ColumnarFile instead of MySQL.
+/// @return false if the rows could not be sent.
+bool QueryRunner::_dispatchNative(NativeScan const& scan, bool& firstResult, int& numFields,
+                                  uint& rowCount, size_t& tSize) {
+    if (firstResult) {
+        firstResult = false;
+        scan.fillSchema(*_result->mutable_rowschema());
+        numFields = scan.getNumFields();
+    }
+    uint64_t const scanStartUs = util::traceNowUs();
+    util::Timer scanTimer;
+    scanTimer.start();
+    bool ok = true;
+    scan.scan([this, &ok, numFields, &rowCount, &tSize](char** row, unsigned long* lengths) {
+        if (_cancelled) {
+            return false;
+        }
+        ok = _addRow(row, lengths, numFields, rowCount, tSize);
+        return ok;
+    });
+    scanTimer.stop();
+    _traceAdd("native_scan", scanStartUs, scanTimer.getElapsed());
+    LOGS(_log, LOG_LVL_DEBUG, _task->getIdStr() << " native scan time=" << scanTimer.getElapsed()
+         << " valuesTested=" << scan.getValuesTested());
+    return ok;
+}
+
+
+/// Send the rows of 'join', read from the ColumnarFiles of its tables.
+/// @return false if the rows could not be sent.
+bool QueryRunner::_dispatchJoin(NativeJoin const& join, bool& firstResult, int& numFields,
+                                uint& rowCount, size_t& tSize) {
+    if (firstResult) {
+        firstResult = false;
+        join.fillSchema(*_result->mutable_rowschema());
+        numFields = join.getNumFields();
+    }
+    uint64_t const joinStartUs = util::traceNowUs();
+    util::Timer joinTimer;
+    joinTimer.start();
+    bool ok = true;
+    join.run([this, &ok, numFields, &rowCount, &tSize](char** row, unsigned long* lengths) {
+        if (_cancelled) {
+            return false;
+        }
+        ok = _addRow(row, lengths, numFields, rowCount, tSize);
+        return ok;
+    });
+    joinTimer.stop();
+    _traceAdd("native_join", joinStartUs, joinTimer.getElapsed());
+    LOGS(_log, LOG_LVL_DEBUG, _task->getIdStr() << " native join time=" << joinTimer.getElapsed()
+         << " pairsTested=" << join.getPairsTested());
+    return ok;
+}
+
+
+/// Run the prepared statement of 'stmtResult' and send its rows.
+/// @return false if the statement failed or its rows could not be sent.
+bool QueryRunner::_dispatchPrepared(mysql::StatementResult& stmtResult, bool& firstResult, int& numFields,
+                                    uint& rowCount, size_t& tSize) {
+    MYSQL_STMT* stmt = stmtResult.getStatement();
+    uint64_t const sqlStartUs = util::traceNowUs();
+    util::Timer sqlTimer;
+    sqlTimer.start();
+    bool ok = _mysqlConn->executeStatement(stmt);
+    sqlTimer.stop();
+    _traceAdd("mysql", sqlStartUs, sqlTimer.getElapsed());
+    LOGS(_log, LOG_LVL_DEBUG, _task->getIdStr() << " prepared fragment time=" << sqlTimer.getElapsed()
+         << " cacheHits=" << _mysqlConn->getStatementCacheHits());
+    if (ok) {
+        if (firstResult) {
+            firstResult = false;
+            _fillSchema(stmtResult.getMetadata());
+            numFields = stmtResult.getNumFields();
+        }
+        MYSQL_ROW row;
+        unsigned long* lengths;
+        while (ok && stmtResult.fetch(row, lengths)) {
+            ok = _addRow(row, lengths, numFields, rowCount, tSize);
+        }
+        if (!stmtResult.isError()) {
+            return ok;
+        }
+    }
+    _multiError.push_back(util::Error(mysql_stmt_errno(stmt), mysql_stmt_error(stmt)));
+    return false;
+}
+
+
+/// Let tasks waiting for the result of this one run their own scan, unless
+/// the result was put in the cache.
+void QueryRunner::_releaseCacheClaim() {
+    if (_cacheClaimed) {
+        _cacheClaimed = false;
+        _resultCache->abandon(_cacheKey);
+    }
+}
+
 void QueryRunner::cancel() {
     LOGS(_log, LOG_LVL_WARN, "Trying QueryRunner::cancel() call, experimental");
     _cancelled.store(true);
+    {
+        std::lock_guard<std::mutex> lock(_parallelMtx);
+        if (_parallel != nullptr) {
+            _parallel->cancel();
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(_streamMtx);
+        if (_stream != nullptr) {
+            _transmitStage->cancel(_stream);
+        }
+    }
     if (!_mysqlConn.get()) {
         LOGS(_log, LOG_LVL_WARN, "QueryRunner::cancel() no MysqlConn");
         return;
@@ -520,6 +1301,13 @@ void QueryRunner::cancel() {
 }
 
 QueryRunner::~QueryRunner() {
+    _releaseCacheClaim();
+    if (_connPool != nullptr) {
+        _connPool->release(std::move(_mysqlConn));
+    }
+    if (_spoolFd >= 0) {
+        ::close(_spoolFd); // Never sent, the task was cancelled.
+    }
 }
 
 }}} // namespace lsst::qserv::wdb
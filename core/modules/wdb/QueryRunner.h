@@ -35,14 +35,34 @@
 
 // System headers
 #include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Third-party headers
+#include <google/protobuf/arena.h>
 
 // Qserv headers
 #include "mysql/MySqlConfig.h"
 #include "mysql/MySqlConnection.h"
+#include "mysql/MySqlConnectionPool.h"
+#include "mysql/StatementResult.h"
 #include "util/MultiError.h"
+#include "util/Trace.h"
 #include "wbase/Task.h"
 #include "wdb/ChunkResource.h"
+#include "wdb/NativeJoin.h"
+#include "wdb/NativeScan.h"
+#include "wdb/ParallelQueries.h"
+#include "wdb/ResultCache.h"
+#include "wdb/TransmitConfig.h"
+#include "wdb/TransmitMgr.h"
+#include "wdb/TransmitStage.h"
+#include "xrdsvc/StreamBuffer.h"
 
 namespace lsst {
 namespace qserv {
@@ -62,31 +82,79 @@ public:
     using Ptr = std::shared_ptr<QueryRunner>;
     static QueryRunner::Ptr newQueryRunner(wbase::Task::Ptr const& task,
                                            ChunkResourceMgr::Ptr const& chunkResourceMgr,
-                                           mysql::MySqlConfig const& mySqlConfig);
+                                           mysql::MySqlConfig const& mySqlConfig,
+                                           TransmitConfig const& transmitConfig=TransmitConfig(),
+                                           TransmitMgr::Ptr const& transmitMgr=nullptr);
     // Having more than one copy of this would making tracking its progress difficult.
     QueryRunner(QueryRunner const&) = delete;
     QueryRunner& operator=(QueryRunner const&) = delete;
     ~QueryRunner();
 
+    /// Answer from 'cache' if it has 'key', or wait for the task running the
+    /// same work, otherwise store the result there.
+    void setResultCache(ResultCache::Ptr const& cache, std::string const& key) {
+        _resultCache = cache;
+        _cacheKey = key;
+    }
+
+    /// Borrow the MySQL connection from 'pool' instead of opening one.
+    void setConnectionPool(mysql::MySqlConnectionPool::Ptr const& pool) { _connPool = pool; }
+
+    /// Run queries as prepared statements, keeping up to 'size' of them on
+    /// the connection. 0 runs them as text queries.
+    void setStatementCache(unsigned int size) { _statementCache = size; }
+
+    /// Hand the Result messages to 'stage' instead of sending them from the
+    /// task thread, which then never leaves the pool to wait for the czar.
+    void setTransmitStage(TransmitStage::Ptr const& stage) { _transmitStage = stage; }
+
     bool runQuery() override;
     void cancel() override; ///< Cancel the action (in-progress)
 
 protected:
     QueryRunner(wbase::Task::Ptr const& task,
                 ChunkResourceMgr::Ptr const& chunkResourceMgr,
-                mysql::MySqlConfig const& mySqlConfig);
+                mysql::MySqlConfig const& mySqlConfig,
+                TransmitConfig const& transmitConfig,
+                TransmitMgr::Ptr const& transmitMgr);
 private:
     bool _initConnection();
     void _setDb();
     bool _dispatchChannel(); ///< Dispatch with output sent through a SendChannel
     MYSQL_RES* _primeResult(std::string const& query); ///< Obtain a result handle for a query.
 
+    bool _sendResult(MYSQL_RES* res, bool& firstResult, int& numFields, uint& rowCount, size_t& tSize);
+    bool _dispatchParallel(std::vector<std::string> const& queries, unsigned int numThreads,
+                           bool& firstResult, int& numFields, uint& rowCount, size_t& tSize);
     bool _fillRows(MYSQL_RES* result, int numFields, uint& rowCount, size_t& tsize);
+    bool _addRow(MYSQL_ROW row, unsigned long* lengths, int numFields, uint& rowCount, size_t& tSize);
+    bool _dispatchNative(NativeScan const& scan, bool& firstResult, int& numFields,
+                         uint& rowCount, size_t& tSize);
+    bool _dispatchJoin(NativeJoin const& join, bool& firstResult, int& numFields,
+                       uint& rowCount, size_t& tSize);
+    bool _dispatchPrepared(mysql::StatementResult& stmtResult, bool& firstResult, int& numFields,
+                           uint& rowCount, size_t& tSize);
+    size_t _appendColumns(MYSQL_ROW row, unsigned long* lengths, int numFields, uint rowIdx);
     void _fillSchema(MYSQL_RES* result);
+    bool _foldRows(bool erred, int& numFields, uint& rowCount, size_t& tSize);
     void _initMsgs();
     void _initMsg();
     void _transmit(bool last, uint rowCount, size_t size);
-    void _transmitHeader(std::string& msg);
+    void _transmitHeader(std::string& msg, size_t uncompressedSize);
+    void _pushStaged(std::string& msg, size_t uncompressedSize, bool last,
+                     std::function<void()> const& onRecycle);
+    TransmitStage::StreamPtr _openStream();
+    std::string _makeHeader(std::string const& msg, size_t uncompressedSize);
+    bool _spoolOpen();
+    bool _spoolWrite(std::string const& data);
+    void _transmitSpooled(std::string const& resultString, size_t uncompressedSize, bool last);
+    void _waitForInFlight(unsigned int maxResults);
+    bool _replayCached(ResultCache::Entry const& entry);
+    void _traceAdd(char const* name, uint64_t startUs, double seconds);
+    uint64_t _handlerReads();
+    void _releaseCacheClaim();
+    void _leavePool();
+    void _yieldToInteractive();
 
     ///< Actual task
     wbase::Task::Ptr _task;
@@ -96,13 +164,40 @@ private:
     std::string _dbName;
     std::atomic<bool> _cancelled{false};
     mysql::MySqlConfig const _mySqlConfig;
+    TransmitConfig const _transmitConfig;
+    TransmitMgr::Ptr const _transmitMgr; ///< Worker wide result bandwidth control, may be null.
     std::unique_ptr<mysql::MySqlConnection> _mysqlConn;
+    mysql::MySqlConnectionPool::Ptr _connPool; //< May be null.
+    unsigned int _statementCache{0}; ///< Prepared statements kept on the connection.
 
     util::MultiError _multiError; // Error log
 
     std::shared_ptr<proto::ProtoHeader> _protoHeader;
-    std::shared_ptr<proto::Result> _result;
+    /// Holds _result and everything it allocates, reset for every message so
+    /// filling a message costs a few block allocations instead of one per field.
+    google::protobuf::Arena _arena;
+    proto::Result* _result{nullptr}; //< Current message, owned by _arena.
     bool _largeResult{false}; //< True for all transmits after the first transmit.
+    bool _columnar{false}; //< True if rows are sent as column blocks (protocol 3).
+    bool _folding{false}; //< True while the rows are kept whole to be folded, see wbase::TaskFold.
+    std::chrono::steady_clock::time_point _msgStart; //< When the first row of the current message was read.
+    size_t _msgLimit{0}; //< Bytes of rows that make the current message full.
+    size_t _msgMaxLimit{0}; //< Largest _msgLimit, from the range the czar asked for.
+    ResultCache::Ptr _resultCache; //< May be null.
+    std::string _cacheKey;
+    std::shared_ptr<ResultCache::Entry> _cacheEntry; //< Messages kept for _resultCache, null when not caching.
+    bool _cacheClaimed{false}; //< True while tasks with the same _cacheKey wait for this one.
+    int _spoolFd{-1}; //< Spool file for the results of this task, -1 when streaming.
+    size_t _spoolSize{0}; //< Bytes written to the spool file.
+    std::deque<xrdsvc::StreamBuffer::Ptr> _inFlight; //< Buffers given to XrdSsi, oldest first.
+    TransmitStage::Ptr _transmitStage; //< May be null, messages are then sent by the task thread.
+    std::mutex _streamMtx; //< Protects _stream.
+    TransmitStage::StreamPtr _stream; //< Messages of this task in _transmitStage, opened by the first one.
+    std::mutex _parallelMtx; //< Protects _parallel.
+    ParallelQueries* _parallel{nullptr}; //< Subchunk queries being run on helper connections, for cancel().
+    std::vector<util::TraceSpan> _spans; //< Stages of a traced task, sent with its last message.
+    wbase::TaskUsage _usage; //< Resources used by the task so far.
+    uint64_t _cpuStartUs{0}; //< Thread CPU time when the task started running.
 };
 
 }}} // namespace
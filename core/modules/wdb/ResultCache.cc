@@ -0,0 +1,164 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "wdb/ResultCache.h"
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "proto/TaskMsgDigest.h"
+#include "proto/worker.pb.h"
+
+namespace {
+LOG_LOGGER _log = LOG_GET("lsst.qserv.wdb.ResultCache");
+}
+
+namespace lsst {
+namespace qserv {
+namespace wdb {
+
+std::string ResultCache::makeKey(proto::TaskMsg const& msg, std::uint64_t chunkVersion) {
+    // Clear everything that identifies the user query rather than the work to do.
+    proto::TaskMsg work(msg);
+    work.clear_session();
+    work.set_queryid(0);
+    work.set_jobid(0);
+    work.set_attemptcount(0);
+    work.clear_czarid();
+    for (auto& fragment : *work.mutable_fragment()) {
+        fragment.clear_resulttable();
+    }
+    return proto::hashTaskMsg(work) + ":" + msg.db() + ":" + std::to_string(msg.chunkid())
+        + ":" + std::to_string(chunkVersion);
+}
+
+
+ResultCache::Entry::Ptr ResultCache::get(std::string const& key) {
+    std::lock_guard<std::mutex> lg(_mtx);
+    auto iter = _map.find(key);
+    if (iter == _map.end()) {
+        ++_misses;
+        return nullptr;
+    }
+    ++_hits;
+    _lru.splice(_lru.begin(), _lru, iter->second);
+    return iter->second->second;
+}
+
+
+ResultCache::Entry::Ptr ResultCache::getOrRun(std::string const& key) {
+    std::unique_lock<std::mutex> lock(_mtx);
+    bool waited = false;
+    while (_running.count(key) > 0) {
+        waited = true;
+        _runningCv.wait(lock);
+    }
+    auto iter = _map.find(key);
+    if (iter == _map.end()) {
+        // Nobody has the result, the caller runs the work.
+        ++_misses;
+        _running.insert(key);
+        return nullptr;
+    }
+    ++_hits;
+    if (waited) {
+        ++_shared;
+        LOGS(_log, LOG_LVL_DEBUG, "shared scan key=" << key);
+    }
+    _lru.splice(_lru.begin(), _lru, iter->second);
+    return iter->second->second;
+}
+
+
+void ResultCache::abandon(std::string const& key) {
+    {
+        std::lock_guard<std::mutex> lg(_mtx);
+        if (_running.erase(key) == 0) return;
+    }
+    _runningCv.notify_all();
+}
+
+
+void ResultCache::put(std::string const& key, Entry::Ptr const& entry) {
+    if (entry == nullptr || entry->bytes > getMaxEntryBytes()) {
+        abandon(key);
+        return;
+    }
+    std::unique_lock<std::mutex> lock(_mtx);
+    auto iter = _map.find(key);
+    if (iter != _map.end()) {
+        _bytes -= iter->second->second->bytes;
+        _lru.erase(iter->second);
+        _map.erase(iter);
+    }
+    while (!_lru.empty() && _bytes + entry->bytes > _maxBytes) {
+        auto& victim = _lru.back();
+        _bytes -= victim.second->bytes;
+        _map.erase(victim.first);
+        _lru.pop_back();
+    }
+    _lru.emplace_front(key, entry);
+    _map[key] = _lru.begin();
+    _bytes += entry->bytes;
+    LOGS(_log, LOG_LVL_DEBUG, "put key=" << key << " bytes=" << entry->bytes
+         << " total=" << _bytes << " entries=" << _map.size());
+    bool const wasRunning = _running.erase(key) > 0;
+    lock.unlock();
+    if (wasRunning) {
+        _runningCv.notify_all();
+    }
+}
+
+
+std::size_t ResultCache::getBytes() const {
+    std::lock_guard<std::mutex> lg(_mtx);
+    return _bytes;
+}
+
+
+std::size_t ResultCache::getSize() const {
+    std::lock_guard<std::mutex> lg(_mtx);
+    return _map.size();
+}
+
+
+std::uint64_t ResultCache::getHits() const {
+    std::lock_guard<std::mutex> lg(_mtx);
+    return _hits;
+}
+
+
+std::uint64_t ResultCache::getMisses() const {
+    std::lock_guard<std::mutex> lg(_mtx);
+    return _misses;
+}
+
+
+std::uint64_t ResultCache::getShared() const {
+    std::lock_guard<std::mutex> lg(_mtx);
+    return _shared;
+}
+
+}}} // namespace lsst::qserv::wdb
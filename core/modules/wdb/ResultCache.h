@@ -0,0 +1,120 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_WDB_RESULTCACHE_H
+#define LSST_QSERV_WDB_RESULTCACHE_H
+
+// System headers
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace lsst {
+namespace qserv {
+namespace proto {
+    class TaskMsg;
+}}}
+
+namespace lsst {
+namespace qserv {
+namespace wdb {
+
+/// ResultCache keeps the Result messages of recently run tasks so that a task
+/// identical to one already run, as dashboards often send, can be answered
+/// without touching MySQL.
+///
+/// Entries are keyed by the digest of the TaskMsg with the fields that differ
+/// between user queries cleared, plus the chunk and its ChunkInventory version.
+/// A chunk being added, removed or reloaded changes its version, so stale
+/// entries are never hit and age out of the least recently used list.
+///
+/// Tasks with the same key that run at the same time share one scan of the
+/// chunk: the first one runs and the others wait for its entry.
+class ResultCache {
+public:
+    using Ptr = std::shared_ptr<ResultCache>;
+
+    /// Serialized Result messages of one task, in the order they were sent.
+    /// The query, job and attempt ids are replaced when replayed.
+    struct Entry {
+        using Ptr = std::shared_ptr<Entry const>;
+        std::vector<std::string> results;
+        std::size_t bytes{0};
+    };
+
+    /// @param maxBytes - total size of the cached messages. A single entry may
+    ///                   use at most a tenth of it.
+    explicit ResultCache(std::size_t maxBytes) : _maxBytes(maxBytes) {}
+    ResultCache() = delete;
+    ResultCache(ResultCache const&) = delete;
+    ResultCache& operator=(ResultCache const&) = delete;
+
+    /// @return the cache key for 'msg' against 'chunkVersion' of its chunk.
+    static std::string makeKey(proto::TaskMsg const& msg, std::uint64_t chunkVersion);
+
+    /// @return the entry for 'key', or nullptr if there is none.
+    Entry::Ptr get(std::string const& key);
+
+    /// @return the entry for 'key', waiting for it if another task is running
+    ///         the same work. When nullptr is returned, the caller runs the work
+    ///         and must call put() or abandon() for 'key' once done.
+    Entry::Ptr getOrRun(std::string const& key);
+
+    /// Store 'entry' under 'key', evicting least recently used entries to make room.
+    /// Entries larger than getMaxEntryBytes() are ignored.
+    void put(std::string const& key, Entry::Ptr const& entry);
+
+    /// Give up the work on 'key' taken by getOrRun(), so that a waiting task runs it.
+    void abandon(std::string const& key);
+
+    std::size_t getMaxEntryBytes() const { return _maxBytes / 10; }
+    std::size_t getBytes() const;
+    std::size_t getSize() const;
+    std::uint64_t getHits() const;
+    std::uint64_t getMisses() const;
+    std::uint64_t getShared() const; ///< @return number of entries got by waiting for a running task.
+
+private:
+    using LruList = std::list<std::pair<std::string, Entry::Ptr>>;
+
+    std::size_t const _maxBytes;
+
+    mutable std::mutex _mtx;
+    LruList _lru; ///< most recently used first
+    std::unordered_map<std::string, LruList::iterator> _map;
+    std::unordered_set<std::string> _running; ///< Keys of the work being run.
+    std::condition_variable _runningCv; ///< Notified when work in _running ends.
+    std::size_t _bytes{0};
+    std::uint64_t _hits{0};
+    std::uint64_t _misses{0};
+    std::uint64_t _shared{0};
+};
+
+}}} // namespace lsst::qserv::wdb
+
+#endif // LSST_QSERV_WDB_RESULTCACHE_H
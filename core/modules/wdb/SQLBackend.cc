@@ -27,6 +27,7 @@
 
 // System headers
 #include <iostream>
+#include <sstream>
 
 // Third-party headers
 
@@ -62,8 +63,11 @@ bool SQLBackend::load(ScTableVector const& v, sql::SqlErrorObject& err) {
     for(ScTableVector::const_iterator i=v.begin(), e=v.end();
             i != e; ++i) {
         std::string const* createScript = nullptr;
+        bool const view = i->chunkId != DUMMY_CHUNK && _isClustered(*i);
         if (i->chunkId == DUMMY_CHUNK) {
             createScript = &CREATE_DUMMY_SUBCHUNK_SCRIPT;
+        } else if (view) {
+            createScript = &CREATE_SUBCHUNK_VIEW_SCRIPT;
         } else {
             createScript = &CREATE_SUBCHUNK_SCRIPT;
         }
@@ -75,6 +79,10 @@ bool SQLBackend::load(ScTableVector const& v, sql::SqlErrorObject& err) {
             _discard(v.begin(), i);
             return false;
         }
+        if (view) {
+            std::lock_guard<std::mutex> lock(_viewsMtx);
+            _views.insert(_scTableName(*i));
+        }
     }
     return true;
 }
@@ -96,7 +104,14 @@ void SQLBackend::_discard(ScTableVector::const_iterator begin,
               ScTableVector::const_iterator end) {
     memLockRequireOwnership();
     for(ScTableVector::const_iterator i=begin, e=end; i != e; ++i) {
-        std::string discard = (boost::format(lsst::qserv::wbase::CLEANUP_SUBCHUNK_SCRIPT)
+        bool view = false;
+        {
+            std::lock_guard<std::mutex> lock(_viewsMtx);
+            view = _views.erase(_scTableName(*i)) > 0;
+        }
+        std::string const& cleanupScript = view ? lsst::qserv::wbase::CLEANUP_SUBCHUNK_VIEW_SCRIPT
+                                                : lsst::qserv::wbase::CLEANUP_SUBCHUNK_SCRIPT;
+        std::string discard = (boost::format(cleanupScript)
                 % i->dbTable.db % i->dbTable.table % i->chunkId % i->subChunkId).str();
         sql::SqlErrorObject err;
         if (!_sqlConn.runQuery(discard, err)) {
@@ -105,6 +120,34 @@ void SQLBackend::_discard(ScTableVector::const_iterator begin,
     }
 }
 
+/// @return true if the rows of the chunk table of 'scTable' are stored ordered
+///         by subchunk, as recorded by the replication system when it loaded them.
+bool SQLBackend::_isClustered(ScTable const& scTable) {
+    std::string const sql = "SELECT COUNT(*) FROM qservw_worker.SubChunkLayout WHERE db = '"
+        + _sqlConn.escapeString(scTable.dbTable.db) + "' AND tbl = '"
+        + _sqlConn.escapeString(scTable.dbTable.table) + "' AND chunk = "
+        + std::to_string(scTable.chunkId) + " AND overlap = 0";
+    sql::SqlResults results;
+    sql::SqlErrorObject err;
+    std::string count;
+    if (!_sqlConn.runQuery(sql, results, err) || !results.extractFirstValue(count, err)) {
+        // Workers which have not been migrated yet have no layout.
+        LOGS(_log, LOG_LVL_DEBUG, "isClustered query failed, assuming not clustered. " << sql
+             << " err=" << err.printErrMsg());
+        return false;
+    }
+    return std::stoll(count) > 0;
+}
+
+
+/// @return the name of the table holding the rows of 'scTable'.
+std::string SQLBackend::_scTableName(ScTable const& scTable) {
+    std::ostringstream os;
+    os << scTable;
+    return os.str();
+}
+
+
 /// Run the 'query'. If it fails, terminate the program.
 void SQLBackend::_execLockSql(std::string const& query) {
     LOGS(_log, LOG_LVL_DEBUG, "execLockSql " << query);
@@ -222,6 +265,7 @@ bool FakeBackend::load(ScTableVector const& v, sql::SqlErrorObject& err) {
     for (auto& scTbl : v) {
         std::string key = makeFakeKey(scTbl);
         fakeSet.insert(key);
+        ++loadCount;
     }
     return true;
 }
@@ -27,6 +27,7 @@
 
 // System headers
 #include <atomic>
+#include <mutex>
 #include <set>
 #include <string>
 #include <sys/types.h>
@@ -65,7 +66,8 @@ typedef std::vector<ScTable> ScTableVector;
 
 
 /// This class maintains a connection to the database for making temporary in-memory tables
-/// for subchunks.
+/// for subchunks. The subchunks of chunk tables which the replication system stored ordered
+/// by subchunk get views instead, which read the rows in place.
 /// It is important at startup that any tables from a previous run are deleted. This happens
 /// in the SQLBackend constructor call to SQLBackend::_memLockAcquire(). The reason it is so important
 /// is that the in-memory tables have their schema written to disk but no data, so they are
@@ -99,6 +101,10 @@ protected:
 
     virtual void _discard(ScTableVector::const_iterator begin, ScTableVector::const_iterator end);
 
+    bool _isClustered(ScTable const& scTable);
+
+    static std::string _scTableName(ScTable const& scTable);
+
     /// Run the 'query'. If it fails, terminate the program.
     void _execLockSql(std::string const& query);
 
@@ -123,6 +129,9 @@ protected:
     std::string _lockTbl;
     std::string _lockDbTbl;
     int _uid;
+
+    std::mutex _viewsMtx; ///< Protects _views
+    std::set<std::string> _views; ///< Names of the subchunk tables which are views.
 };
 
 
@@ -148,6 +157,7 @@ public:
         return str;
     }
     std::set<std::string> fakeSet; // set of strings for tracking unique tables.
+    int loadCount{0}; // number of tables loaded, including reloads.
 
 private:
     void _discard(ScTableVector::const_iterator begin, ScTableVector::const_iterator end) override;
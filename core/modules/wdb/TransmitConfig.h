@@ -0,0 +1,88 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_WDB_TRANSMITCONFIG_H
+#define LSST_QSERV_WDB_TRANSMITCONFIG_H
+
+// System headers
+#include <string>
+
+// Qserv headers
+#include "proto/worker.pb.h"
+
+namespace lsst {
+namespace qserv {
+namespace wdb {
+
+/// Value class for configuring how a QueryRunner sends results to the czar.
+class TransmitConfig {
+public:
+    TransmitConfig() {}
+    TransmitConfig(proto::ProtoHeader::Compression compression_, int compressionLevel_,
+                   proto::ProtoHeader::Checksum checksum_)
+        : compression(compression_), compressionLevel(compressionLevel_), checksum(checksum_) {}
+
+    /// Codec used to compress Result messages.
+    proto::ProtoHeader::Compression compression{proto::ProtoHeader::NONE};
+    /// Codec specific compression level, for zlib 1 (fastest) to 9 (best).
+    int compressionLevel{1};
+    /// Checksum used to detect corrupted Result messages.
+    proto::ProtoHeader::Checksum checksum{proto::ProtoHeader::CRC32C};
+    /// Maximum number of Result messages of a task that may be waiting to
+    /// be sent while the task prepares the next one. 1 means no overlap.
+    unsigned int transmitDepth{2};
+    /// Past this many MB held in StreamBuffers by the whole worker, tasks only
+    /// keep their latest message in flight. 0 means no limit.
+    unsigned int transmitMemoryBudgetMB{0};
+    /// MB of Result messages the whole worker may have handed to XrdSsi and not yet
+    /// had recycled, shared fairly between czars and user queries. 0 means no limit.
+    unsigned int transmitMaxMB{0};
+    /// Threads of the worker's TransmitStage, which send the Result messages so
+    /// that tasks don't leave the scheduler pool. 0 sends them from the tasks.
+    unsigned int transmitSenders{0};
+    /// MB of Result messages the TransmitStage may hold before tasks wait. 0 means no limit.
+    unsigned int transmitStageMB{512};
+    /// Send a partial Result message once it holds this many rows. 0 means no limit.
+    unsigned int flushRows{0};
+    /// Send a partial Result message once rows have been collected for this many
+    /// milliseconds, so slow scans return their first rows early. 0 means no limit.
+    unsigned int flushMs{0};
+    /// MB of Result messages kept to answer repeated identical tasks. 0 disables the cache.
+    unsigned int resultCacheMB{0};
+    /// Groups the tasks of a user query may fold their partial aggregates
+    /// into, when the czar asks for it. 0 sends the rows of every task.
+    unsigned int aggFoldMaxGroups{100000};
+    /// Directory where scan results are spooled and sent to the czar as a file.
+    /// Empty means results are always streamed from memory.
+    std::string spoolDir;
+    /// Directory of the ColumnarFile copies of chunk and overlap tables, used
+    /// to answer simple scans and near neighbour joins without MySQL. Empty
+    /// means every query runs in MySQL.
+    std::string nativeScanDir;
+    /// Queued stream buffers that together fit in this many KB are handed to
+    /// XrdSsi as one buffer. 0 disables coalescing.
+    unsigned int coalesceKB{64};
+};
+
+}}} // namespace lsst::qserv::wdb
+
+#endif // LSST_QSERV_WDB_TRANSMITCONFIG_H
@@ -0,0 +1,183 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "wdb/TransmitMgr.h"
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+namespace {
+LOG_LOGGER _log = LOG_GET("lsst.qserv.wdb.TransmitMgr");
+
+/// Subtract 'bytes' from the entry for 'key', removing it if nothing is left.
+template <typename K>
+void subtractBytes(std::map<K, std::size_t>& m, K const& key, std::size_t bytes) {
+    auto iter = m.find(key);
+    if (iter == m.end()) return;
+    if (iter->second <= bytes) {
+        m.erase(iter);
+    } else {
+        iter->second -= bytes;
+    }
+}
+
+template <typename K>
+std::size_t getBytes(std::map<K, std::size_t> const& m, K const& key) {
+    auto iter = m.find(key);
+    return (iter == m.end()) ? 0 : iter->second;
+}
+}
+
+namespace lsst {
+namespace qserv {
+namespace wdb {
+
+bool TransmitMgr::take(std::uint32_t czarId, QueryId qId, bool interactive, std::size_t bytes) {
+    std::unique_lock<std::mutex> uLock(_mtx);
+    if (_isCancelled(qId)) {
+        return false;
+    }
+    std::uint64_t const seq = ++_seq;
+    _waiters.emplace(seq, Waiter{czarId, qId, interactive});
+    if (!_isGranted(seq, bytes)) {
+        LOGS(_log, LOG_LVL_DEBUG, "take waiting czar=" << czarId << " QI=" << qId
+             << " bytes=" << bytes << " inFlight=" << _bytesInFlight << " waiting=" << _waiters.size());
+        auto start = std::chrono::steady_clock::now();
+        _cv.wait(uLock, [this, seq, bytes, qId](){ return _isCancelled(qId) || _isGranted(seq, bytes); });
+        std::chrono::duration<double> stall = std::chrono::steady_clock::now() - start;
+        _totalStall += stall;
+        if (stall > _maxStall) _maxStall = stall;
+        LOGS(_log, LOG_LVL_DEBUG, "take " << (_isCancelled(qId) ? "cancelled" : "granted")
+             << " czar=" << czarId << " QI=" << qId << " after " << stall.count() << "s");
+    }
+    _waiters.erase(seq);
+    bool const granted = !_isCancelled(qId);
+    if (granted) {
+        _bytesInFlight += bytes;
+        _czarBytes[czarId] += bytes;
+        _queryBytes[qId] += bytes;
+    }
+    uLock.unlock();
+    // Another waiter may now be the best candidate.
+    _cv.notify_all();
+    return granted;
+}
+
+
+void TransmitMgr::cancelQuery(QueryId qId) {
+    // Enough to cover the queries that may still have tasks running.
+    std::size_t const maxCancelled = 1000;
+    {
+        std::lock_guard<std::mutex> lg(_mtx);
+        if (!_cancelled.insert(qId).second) return;
+        _cancelledOrder.push_back(qId);
+        if (_cancelledOrder.size() > maxCancelled) {
+            _cancelled.erase(_cancelledOrder.front());
+            _cancelledOrder.pop_front();
+        }
+    }
+    _cv.notify_all();
+}
+
+
+void TransmitMgr::release(std::uint32_t czarId, QueryId qId, std::size_t bytes) {
+    {
+        std::lock_guard<std::mutex> lg(_mtx);
+        _bytesInFlight = (_bytesInFlight > bytes) ? _bytesInFlight - bytes : 0;
+        subtractBytes(_czarBytes, czarId, bytes);
+        subtractBytes(_queryBytes, qId, bytes);
+    }
+    _cv.notify_all();
+}
+
+
+/// @return true if the waiter 'seq' is the one that should go next and there
+///         is room for 'bytes'. _mtx must be held.
+bool TransmitMgr::_isGranted(std::uint64_t seq, std::size_t bytes) const {
+    if (_bytesInFlight > 0 && _bytesInFlight + bytes > _maxBytes) return false;
+    auto best = _waiters.end();
+    for (auto iter = _waiters.begin(); iter != _waiters.end(); ++iter) {
+        if (best == _waiters.end()) {
+            best = iter;
+            continue;
+        }
+        Waiter const& w = iter->second;
+        Waiter const& b = best->second;
+        if (w.interactive != b.interactive) {
+            if (w.interactive) best = iter;
+            continue;
+        }
+        auto wCzar = getBytes(_czarBytes, w.czarId);
+        auto bCzar = getBytes(_czarBytes, b.czarId);
+        if (wCzar != bCzar) {
+            if (wCzar < bCzar) best = iter;
+            continue;
+        }
+        // Ties go to the earlier waiter, which is already 'best' as the map is ordered.
+        if (getBytes(_queryBytes, w.qId) < getBytes(_queryBytes, b.qId)) best = iter;
+    }
+    return best != _waiters.end() && best->first == seq;
+}
+
+
+std::size_t TransmitMgr::getBytesInFlight() const {
+    std::lock_guard<std::mutex> lg(_mtx);
+    return _bytesInFlight;
+}
+
+
+std::size_t TransmitMgr::getWaitCount() const {
+    std::lock_guard<std::mutex> lg(_mtx);
+    return _waiters.size();
+}
+
+
+double TransmitMgr::getTotalStallSec() const {
+    std::lock_guard<std::mutex> lg(_mtx);
+    return _totalStall.count();
+}
+
+
+double TransmitMgr::getMaxStallSec() const {
+    std::lock_guard<std::mutex> lg(_mtx);
+    return _maxStall.count();
+}
+
+
+/// _mtx must be held.
+void TransmitMgr::_dump(std::ostream& os) const {
+    os << "TransmitMgr(inFlight=" << _bytesInFlight << "/" << _maxBytes
+       << " waiting=" << _waiters.size() << " czars=" << _czarBytes.size()
+       << " queries=" << _queryBytes.size() << " stallTotal=" << _totalStall.count()
+       << "s stallMax=" << _maxStall.count() << "s)";
+}
+
+
+std::ostream& operator<<(std::ostream& os, TransmitMgr const& mgr) {
+    std::lock_guard<std::mutex> lg(mgr._mtx);
+    mgr._dump(os);
+    return os;
+}
+
+}}} // namespace lsst::qserv::wdb
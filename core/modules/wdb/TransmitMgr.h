@@ -0,0 +1,112 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_WDB_TRANSMITMGR_H
+#define LSST_QSERV_WDB_TRANSMITMGR_H
+
+// System headers
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <set>
+
+// Qserv headers
+#include "global/intTypes.h"
+
+namespace lsst {
+namespace qserv {
+namespace wdb {
+
+/// TransmitMgr limits the number of result bytes the whole worker has handed
+/// to XrdSsi and not yet had recycled. When the budget is exhausted, tasks
+/// wait in take() and are granted in this order:
+///   - interactive queries before scans,
+///   - the czar with the fewest bytes in flight,
+///   - the user query with the fewest bytes in flight,
+///   - the oldest waiter.
+/// This keeps one busy czar, or one query with a huge result, from starving
+/// everyone else of bandwidth. A request is always granted when nothing is
+/// in flight so messages larger than the budget still get through.
+class TransmitMgr {
+public:
+    using Ptr = std::shared_ptr<TransmitMgr>;
+
+    explicit TransmitMgr(std::size_t maxBytes) : _maxBytes(maxBytes) {}
+    TransmitMgr() = delete;
+    TransmitMgr(TransmitMgr const&) = delete;
+    TransmitMgr& operator=(TransmitMgr const&) = delete;
+
+    /// Block until 'bytes' may be sent for the query 'qId' from czar 'czarId'.
+    /// @return false, without taking the bytes, if 'qId' was cancelled.
+    bool take(std::uint32_t czarId, QueryId qId, bool interactive, std::size_t bytes);
+
+    /// Make the current and future take() calls for 'qId' return false.
+    /// Only the last cancelled queries are remembered.
+    void cancelQuery(QueryId qId);
+
+    /// Return bytes from a previous take() once XrdSsi is done with them.
+    void release(std::uint32_t czarId, QueryId qId, std::size_t bytes);
+
+    std::size_t getMaxBytes() const { return _maxBytes; }
+    std::size_t getBytesInFlight() const;
+    std::size_t getWaitCount() const;
+    /// @return total time, in seconds, all callers have spent blocked in take().
+    double getTotalStallSec() const;
+    /// @return the longest time, in seconds, a single take() has blocked.
+    double getMaxStallSec() const;
+
+    friend std::ostream& operator<<(std::ostream& os, TransmitMgr const& mgr);
+
+private:
+    struct Waiter {
+        std::uint32_t czarId;
+        QueryId qId;
+        bool interactive;
+    };
+
+    bool _isGranted(std::uint64_t seq, std::size_t bytes) const;
+    bool _isCancelled(QueryId qId) const { return _cancelled.count(qId) > 0; }
+    void _dump(std::ostream& os) const;
+
+    std::size_t const _maxBytes;
+
+    mutable std::mutex _mtx;
+    std::condition_variable _cv;
+    std::size_t _bytesInFlight{0};
+    std::map<std::uint32_t, std::size_t> _czarBytes;  ///< bytes in flight per czar
+    std::map<QueryId, std::size_t> _queryBytes;       ///< bytes in flight per user query
+    std::map<std::uint64_t, Waiter> _waiters;         ///< blocked callers by arrival sequence
+    std::uint64_t _seq{0};
+    std::set<QueryId> _cancelled;            ///< cancelled user queries
+    std::deque<QueryId> _cancelledOrder;     ///< _cancelled in the order they were added
+    std::chrono::duration<double> _totalStall{0};
+    std::chrono::duration<double> _maxStall{0};
+};
+
+}}} // namespace lsst::qserv::wdb
+
+#endif // LSST_QSERV_WDB_TRANSMITMGR_H
@@ -0,0 +1,292 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "wdb/TransmitStage.h"
+
+// System headers
+#include <algorithm>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "wbase/SendChannel.h"
+
+namespace {
+LOG_LOGGER _log = LOG_GET("lsst.qserv.wdb.TransmitStage");
+}
+
+namespace lsst {
+namespace qserv {
+namespace wdb {
+
+TransmitStage::TransmitStage(unsigned int numSenders, std::size_t maxBytes) : _maxBytes(maxBytes) {
+    for (unsigned int j = 0; j < std::max(1U, numSenders); ++j) {
+        _senders.emplace_back(&TransmitStage::_run, this);
+    }
+}
+
+
+TransmitStage::~TransmitStage() {
+    shutdown();
+}
+
+
+TransmitStage::StreamPtr TransmitStage::openStream(std::shared_ptr<wbase::SendChannel> const& channel,
+                                                   QueryId qId, unsigned int depth) {
+    auto stream = std::make_shared<Stream>(channel, qId, std::max(1U, depth));
+    std::lock_guard<std::mutex> lock(_mtx);
+    _streams.erase(std::remove_if(_streams.begin(), _streams.end(),
+                                  [](std::weak_ptr<Stream> const& s) { return s.expired(); }),
+                   _streams.end());
+    _streams.push_back(stream);
+    return stream;
+}
+
+
+bool TransmitStage::push(StreamPtr const& stream, xrdsvc::StreamBuffer::Ptr const& header,
+                         xrdsvc::StreamBuffer::Ptr const& result, bool last,
+                         std::function<void()> const& onRecycle) {
+    std::size_t const bytes = result->getSize();
+    std::unique_lock<std::mutex> uLock(_mtx);
+    auto blocked = [this, &stream, bytes]() {
+        return _maxBytes > 0 && !_shutdown && !stream->_cancelled && stream->_bytes > 0
+               && _bytes + bytes > _maxBytes;
+    };
+    if (blocked()) {
+        auto const start = std::chrono::steady_clock::now();
+        _spaceCv.wait(uLock, [&blocked]() { return !blocked(); });
+        _totalStall += std::chrono::steady_clock::now() - start;
+    }
+    if (_shutdown || stream->_cancelled) {
+        uLock.unlock();
+        if (onRecycle) onRecycle();
+        header->Recycle();
+        result->Recycle();
+        return false;
+    }
+    auto sent = std::make_shared<bool>(false);
+    std::weak_ptr<TransmitStage> weakThis = shared_from_this();
+    result->setRecycleFunc([weakThis, stream, bytes, sent, onRecycle]() {
+        if (onRecycle) onRecycle();
+        auto self = weakThis.lock();
+        if (self != nullptr) {
+            self->_recycled(stream, bytes, sent);
+        }
+    });
+    stream->_queued.push_back(Message{header, result, last, sent});
+    stream->_bytes += bytes;
+    _bytes += bytes;
+    ++_queued;
+    _schedule(stream);
+    return true;
+}
+
+
+void TransmitStage::cancel(StreamPtr const& stream) {
+    std::vector<Message> dropped;
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        stream->_cancelled = true;
+        dropped = _drop(*stream);
+    }
+    _spaceCv.notify_all();
+    _discard(dropped);
+}
+
+
+void TransmitStage::cancelQuery(QueryId qId) {
+    std::vector<Message> dropped;
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        for (auto const& weakStream : _streams) {
+            auto stream = weakStream.lock();
+            if (stream != nullptr && stream->qId == qId) {
+                stream->_cancelled = true;
+                auto messages = _drop(*stream);
+                std::move(messages.begin(), messages.end(), std::back_inserter(dropped));
+            }
+        }
+    }
+    LOGS(_log, LOG_LVL_DEBUG, "cancelQuery qId=" << qId << " dropped=" << dropped.size());
+    _spaceCv.notify_all();
+    _discard(dropped);
+}
+
+
+void TransmitStage::shutdown() {
+    std::vector<Message> dropped;
+    std::vector<std::thread> senders;
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _shutdown = true;
+        for (auto const& weakStream : _streams) {
+            auto stream = weakStream.lock();
+            if (stream != nullptr) {
+                auto messages = _drop(*stream);
+                std::move(messages.begin(), messages.end(), std::back_inserter(dropped));
+            }
+        }
+        senders.swap(_senders);
+    }
+    _readyCv.notify_all();
+    _spaceCv.notify_all();
+    _discard(dropped);
+    for (auto& sender : senders) {
+        if (sender.get_id() == std::this_thread::get_id()) {
+            sender.detach(); // The last reference went away in a recycle callback.
+        } else {
+            sender.join();
+        }
+    }
+}
+
+
+std::size_t TransmitStage::getBytes() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _bytes;
+}
+
+
+std::size_t TransmitStage::getQueuedCount() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _queued;
+}
+
+
+double TransmitStage::getTotalStallSec() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _totalStall.count();
+}
+
+
+/// Hand the messages of the ready streams to XrdSsi. A stream is only
+/// handled by one sender at a time, which keeps its messages in order.
+void TransmitStage::_run() {
+    std::unique_lock<std::mutex> uLock(_mtx);
+    while (true) {
+        _readyCv.wait(uLock, [this]() { return _shutdown || !_ready.empty(); });
+        if (_shutdown) {
+            return;
+        }
+        StreamPtr stream = _ready.front();
+        _ready.pop_front();
+        stream->_scheduled = false;
+        stream->_sending = true;
+        bool failed = false;
+        while (!failed && _isReady(*stream)) {
+            Message msg = std::move(stream->_queued.front());
+            stream->_queued.pop_front();
+            --_queued;
+            ++stream->_inFlight;
+            *msg.sent = true;
+            uLock.unlock();
+            bool ok = stream->channel->sendStream(msg.header, false)
+                      && stream->channel->sendStream(msg.result, msg.last);
+            if (!ok) {
+                // XrdSsi won't recycle what it didn't take, and recycling twice is harmless.
+                LOGS(_log, LOG_LVL_ERROR, "Failed to transmit message qId=" << stream->qId);
+                msg.header->Recycle();
+                msg.result->Recycle();
+                failed = true;
+            }
+            uLock.lock();
+        }
+        std::vector<Message> dropped;
+        if (failed) {
+            // Nothing more can be sent on the channel.
+            stream->_cancelled = true;
+            dropped = _drop(*stream);
+        }
+        stream->_sending = false;
+        if (!dropped.empty()) {
+            uLock.unlock();
+            _spaceCv.notify_all();
+            _discard(dropped);
+            uLock.lock();
+        }
+    }
+}
+
+
+/// @return true if 'stream' has a message that may be handed to XrdSsi. _mtx must be held.
+bool TransmitStage::_isReady(Stream const& stream) const {
+    return !stream._cancelled && !stream._queued.empty() && stream._inFlight < stream.depth;
+}
+
+
+/// Give 'stream' to a sender if it has a message that may be sent. _mtx must be held.
+void TransmitStage::_schedule(StreamPtr const& stream) {
+    if (!stream->_sending && !stream->_scheduled && _isReady(*stream)) {
+        stream->_scheduled = true;
+        _ready.push_back(stream);
+        _readyCv.notify_one();
+    }
+}
+
+
+/// Called when the Result message of 'stream' is recycled by XrdSsi or dropped.
+void TransmitStage::_recycled(StreamPtr const& stream, std::size_t bytes, std::shared_ptr<bool> const& sent) {
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _bytes -= bytes;
+        stream->_bytes -= bytes;
+        if (*sent) {
+            --stream->_inFlight;
+        }
+        _schedule(stream);
+    }
+    _spaceCv.notify_all();
+}
+
+
+/// Take the queued messages off 'stream'. _mtx must be held.
+std::vector<TransmitStage::Message> TransmitStage::_drop(Stream& stream) {
+    std::vector<Message> dropped(std::make_move_iterator(stream._queued.begin()),
+                                 std::make_move_iterator(stream._queued.end()));
+    stream._queued.clear();
+    _queued -= dropped.size();
+    return dropped;
+}
+
+
+/// Recycle messages that were never handed to XrdSsi, which gives back their bytes.
+void TransmitStage::_discard(std::vector<Message>& messages) {
+    for (auto& msg : messages) {
+        msg.header->Recycle();
+        msg.result->Recycle();
+    }
+    messages.clear();
+}
+
+
+std::ostream& operator<<(std::ostream& os, TransmitStage const& stage) {
+    std::lock_guard<std::mutex> lock(stage._mtx);
+    os << "TransmitStage senders=" << stage._senders.size() << " maxBytes=" << stage._maxBytes
+       << " bytes=" << stage._bytes << " queued=" << stage._queued
+       << " stallSec=" << stage._totalStall.count();
+    return os;
+}
+
+}}} // namespace lsst::qserv::wdb
@@ -0,0 +1,157 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_WDB_TRANSMITSTAGE_H
+#define LSST_QSERV_WDB_TRANSMITSTAGE_H
+
+// System headers
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+// Qserv headers
+#include "global/intTypes.h"
+#include "xrdsvc/StreamBuffer.h"
+
+namespace lsst {
+namespace qserv {
+namespace wbase {
+class SendChannel;
+}}}
+
+namespace lsst {
+namespace qserv {
+namespace wdb {
+
+/// TransmitStage sends the Result messages of tasks to their czars, so that
+/// the task threads don't wait for the czars to read them. A task opens a
+/// stream and pushes its messages, which a small pool of sender threads hands
+/// to XrdSsi in order, keeping at most 'depth' Result messages of a stream
+/// with XrdSsi. A stream is picked up again when XrdSsi recycles one of its
+/// buffers.
+///
+/// The whole stage holds at most maxBytes of Result messages, queued or with
+/// XrdSsi. Past it, push() blocks until buffers are recycled. A stream holding
+/// nothing is always let through so messages larger than the limit still get
+/// sent.
+class TransmitStage : public std::enable_shared_from_this<TransmitStage> {
+public:
+    using Ptr = std::shared_ptr<TransmitStage>;
+
+    class Stream;
+    using StreamPtr = std::shared_ptr<Stream>;
+
+    TransmitStage(unsigned int numSenders, std::size_t maxBytes);
+    TransmitStage() = delete;
+    TransmitStage(TransmitStage const&) = delete;
+    TransmitStage& operator=(TransmitStage const&) = delete;
+    ~TransmitStage();
+
+    /// @return a new stream of the messages of a task of the query 'qId'.
+    StreamPtr openStream(std::shared_ptr<wbase::SendChannel> const& channel, QueryId qId,
+                         unsigned int depth);
+
+    /// Queue a Result message and its header, 'onRecycle' is called once XrdSsi
+    /// is done with the Result message, or when it is dropped.
+    /// @return false, dropping the message, if the stream was cancelled.
+    bool push(StreamPtr const& stream, xrdsvc::StreamBuffer::Ptr const& header,
+              xrdsvc::StreamBuffer::Ptr const& result, bool last,
+              std::function<void()> const& onRecycle = nullptr);
+
+    /// Drop the queued messages of 'stream' and fail further pushes.
+    void cancel(StreamPtr const& stream);
+
+    /// Cancel the streams of the query 'qId'.
+    void cancelQuery(QueryId qId);
+
+    /// Drop everything queued and stop the sender threads.
+    void shutdown();
+
+    std::size_t getMaxBytes() const { return _maxBytes; }
+    std::size_t getBytes() const;
+    std::size_t getQueuedCount() const;
+    /// @return total time, in seconds, all callers have spent blocked in push().
+    double getTotalStallSec() const;
+
+    friend std::ostream& operator<<(std::ostream& os, TransmitStage const& stage);
+
+private:
+    struct Message {
+        xrdsvc::StreamBuffer::Ptr header;
+        xrdsvc::StreamBuffer::Ptr result;
+        bool last;
+        std::shared_ptr<bool> sent; ///< Set once handed to XrdSsi, protected by _mtx.
+    };
+
+    void _run();
+    bool _isReady(Stream const& stream) const;
+    void _schedule(StreamPtr const& stream);
+    void _recycled(StreamPtr const& stream, std::size_t bytes, std::shared_ptr<bool> const& sent);
+    std::vector<Message> _drop(Stream& stream);
+    static void _discard(std::vector<Message>& messages);
+
+    std::size_t const _maxBytes;
+
+    mutable std::mutex _mtx;
+    std::condition_variable _readyCv;   ///< Senders wait for _ready.
+    std::condition_variable _spaceCv;   ///< push() waits for bytes to be recycled.
+    std::deque<StreamPtr> _ready;       ///< Streams with messages that may be sent.
+    std::vector<std::weak_ptr<Stream>> _streams; ///< Open streams, for cancelQuery().
+    std::size_t _bytes{0};              ///< Bytes of Result messages queued or with XrdSsi.
+    std::size_t _queued{0};             ///< Messages not handed to XrdSsi yet.
+    bool _shutdown{false};
+    std::chrono::duration<double> _totalStall{0};
+    std::vector<std::thread> _senders;
+};
+
+/// The messages of one task, in the order they were pushed.
+class TransmitStage::Stream {
+public:
+    Stream(std::shared_ptr<wbase::SendChannel> const& channel_, QueryId qId_, unsigned int depth_)
+        : channel(channel_), qId(qId_), depth(depth_) {}
+
+    std::shared_ptr<wbase::SendChannel> const channel;
+    QueryId const qId;
+    unsigned int const depth;
+
+private:
+    friend class TransmitStage;
+
+    // Protected by TransmitStage::_mtx
+    std::deque<Message> _queued;
+    unsigned int _inFlight{0};  ///< Result messages with XrdSsi.
+    std::size_t _bytes{0};      ///< Bytes of Result messages queued or with XrdSsi.
+    bool _scheduled{false};     ///< In TransmitStage::_ready.
+    bool _sending{false};       ///< A sender is handing its messages to XrdSsi.
+    bool _cancelled{false};
+};
+
+}}} // namespace lsst::qserv::wdb
+
+#endif // LSST_QSERV_WDB_TRANSMITSTAGE_H
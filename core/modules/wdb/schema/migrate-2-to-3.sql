@@ -0,0 +1,24 @@
+--
+-- Migration script from version 2 to version 3 of the qservw_worker database:
+--
+--  -  add table 'SubChunkLayout' with the row ranges of the subchunks of
+--     the chunk tables stored ordered by subchunk
+--
+
+-- -----------------------------------------------------
+-- Create table `SubChunkLayout`
+-- -----------------------------------------------------
+
+CREATE TABLE IF NOT EXISTS `SubChunkLayout` (
+
+  `db`       CHAR(200)       NOT NULL,
+  `tbl`      CHAR(200)       NOT NULL COMMENT 'Table name w/o the chunk number',
+  `chunk`    INT UNSIGNED    NOT NULL,
+  `overlap`  TINYINT(1)      NOT NULL COMMENT 'The range is in the overlap table',
+  `subChunk` INT UNSIGNED    NOT NULL,
+  `firstRow` BIGINT UNSIGNED NOT NULL COMMENT 'Position of the first row in the table',
+  `numRows`  BIGINT UNSIGNED NOT NULL,
+
+  PRIMARY KEY (`db`,`tbl`,`chunk`,`overlap`,`subChunk`)
+
+) ENGINE=InnoDB;
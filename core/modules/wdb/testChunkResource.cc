@@ -141,4 +141,42 @@ BOOST_AUTO_TEST_CASE(TwoChunk) {
     BOOST_CHECK(backend->fakeSet.size() == 0);
 }
 
+BOOST_AUTO_TEST_CASE(Cache) {
+    auto backend = std::make_shared<FakeBackend>();
+    std::shared_ptr<ChunkResourceMgr> crm = ChunkResourceMgr::newMgr(backend, 6);
+    {
+        ChunkResource cr(crm->acquire(thedb, 7, tables, {1, 2}));
+        BOOST_CHECK(backend->fakeSet.size() == 4); // 2 tables * 2 subchunks
+        BOOST_CHECK(crm->getCachedCount() == 0);
+    }
+    // The unused tables are kept.
+    BOOST_CHECK(crm->getRefCount(thedb, 7) == 0);
+    BOOST_CHECK(backend->fakeSet.size() == 4);
+    BOOST_CHECK(crm->getCachedCount() == 4);
+    {
+        ChunkResource cr(crm->acquire(thedb, 7, tables, {2, 3}));
+        BOOST_CHECK(backend->loadCount == 6); // subchunk 2 was not built again
+        BOOST_CHECK(crm->getCachedCount() == 2);
+    }
+    BOOST_CHECK(backend->fakeSet.size() == 6);
+    BOOST_CHECK(crm->getCachedCount() == 6);
+    {
+        ChunkResource cr(crm->acquire(thedb, 7, tables, {4}));
+        BOOST_CHECK(backend->fakeSet.size() == 8);
+    }
+    // Subchunk 1 was the least recently used.
+    BOOST_CHECK(crm->getCachedCount() == 6);
+    BOOST_CHECK(backend->fakeSet.size() == 6);
+    lsst::qserv::wdb::ScTable sc1(7, lsst::qserv::DbTable(thedb, "hello"), 1);
+    BOOST_CHECK(backend->fakeSet.count(FakeBackend::makeFakeKey(sc1)) == 0);
+
+    // Tables that would not fit are not built ahead.
+    crm->prebuild(thedb, 8, tables, {1, 2, 3, 4});
+    BOOST_CHECK(backend->loadCount == 8);
+    crm->prebuild(thedb, 8, tables, {1});
+    BOOST_CHECK(backend->loadCount == 10);
+    BOOST_CHECK(crm->getRefCount(thedb, 8) == 0);
+    BOOST_CHECK(crm->getCachedCount() == 6);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
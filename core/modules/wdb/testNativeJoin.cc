@@ -0,0 +1,257 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/**
+ * @brief Test the near neighbour joins NativeJoin runs without MySQL.
+ */
+
+// System headers
+#include <cmath>
+#include <cstdlib>
+#include <set>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+// Third-party headers
+#include <mysql/mysql.h>
+
+// Qserv headers
+#include "proto/worker.pb.h"
+#include "wdb/ColumnarFile.h"
+#include "wdb/NativeJoin.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE NativeJoin_1
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::wdb::ColumnarFile;
+using lsst::qserv::wdb::NativeJoin;
+
+namespace {
+
+double const RAD = M_PI / 180.0;
+
+/// scisql_angSep, computed with the dot product this time.
+double angSep(double ra1, double decl1, double ra2, double decl2) {
+    double const dot = std::sin(decl1 * RAD) * std::sin(decl2 * RAD)
+                       + std::cos(decl1 * RAD) * std::cos(decl2 * RAD) * std::cos((ra1 - ra2) * RAD);
+    return std::acos(std::min(1.0, dot)) / RAD;
+}
+
+struct Point {
+    int64_t objectId;
+    double ra;
+    double decl;
+    int64_t subChunkId;
+};
+
+/// Writes LSST.Object_100 and LSST.ObjectFullOverlap_100 with random
+/// positions around RA 0, so that the RA wraps, to a temporary directory.
+/// Subchunk 1 is RA below 0 and subchunk 2 above, the overlap of subchunk 1
+/// has the points of subchunk 2 within 0.1 degrees.
+struct Fixture {
+    Fixture() {
+        char tmpl[] = "/tmp/testNativeJoin-XXXXXX";
+        dir = mkdtemp(tmpl);
+        mkdir((dir + "/LSST").c_str(), 0755);
+        srand(42);
+        for (int64_t j = 1; j <= 600; ++j) {
+            double const ra = std::fmod(359.5 + rand() / (RAND_MAX + 1.0) + 360.0, 360.0);
+            double const decl = -0.5 + rand() / (RAND_MAX + 1.0);
+            chunk.push_back({j, ra, decl, ra > 180.0 ? 1 : 2});
+            if (ra < 0.1) {
+                overlap.push_back({j, ra, decl, 1});
+            }
+        }
+        write("Object_100", chunk);
+        write("ObjectFullOverlap_100", overlap);
+    }
+
+    ~Fixture() {
+        std::string cmd = "rm -rf " + dir;
+        std::system(cmd.c_str());
+    }
+
+    void write(std::string const& table, std::vector<Point> const& points) {
+        std::vector<ColumnarFile::ColumnData> cols(4);
+        char const* const names[] = {"objectId", "ra", "decl", "subChunkId"};
+        for (int c = 0; c < 4; ++c) {
+            bool const isInt = (c == 0 || c == 3);
+            cols[c].column.name = names[c];
+            cols[c].column.type = isInt ? ColumnarFile::Type::INT64 : ColumnarFile::Type::DOUBLE;
+            cols[c].column.mysqlType = isInt ? MYSQL_TYPE_LONGLONG : MYSQL_TYPE_DOUBLE;
+            cols[c].column.sqlType = isInt ? "BIGINT(20)" : "DOUBLE";
+        }
+        for (auto const& p : points) {
+            cols[0].ints.push_back(p.objectId);
+            cols[1].doubles.push_back(p.ra);
+            cols[2].doubles.push_back(p.decl);
+            cols[3].ints.push_back(p.subChunkId);
+        }
+        std::string err;
+        bool ok = ColumnarFile::write(ColumnarFile::pathFor(dir, "LSST", table), cols, points.size(), true, err);
+        BOOST_REQUIRE_MESSAGE(ok, err);
+    }
+
+    /// @return the pairs of 'left' and 'right' closer than 'radius', as "id,id".
+    std::set<std::string> expected(std::vector<Point> const& left, int64_t leftSub,
+                                   std::vector<Point> const& right, int64_t rightSub, double radius) {
+        std::set<std::string> pairs;
+        for (auto const& a : left) {
+            for (auto const& b : right) {
+                if (a.subChunkId == leftSub && b.subChunkId == rightSub && a.objectId != b.objectId
+                    && angSep(a.ra, a.decl, b.ra, b.decl) < radius) {
+                    pairs.insert(std::to_string(a.objectId) + "," + std::to_string(b.objectId));
+                }
+            }
+        }
+        return pairs;
+    }
+
+    /// @return the rows of 'query' as comma separated text, or "none" if it cannot run natively.
+    std::vector<std::string> run(std::string const& query) {
+        std::vector<std::string> rows;
+        NativeJoin::Tables tables(dir);
+        auto join = NativeJoin::plan(query, tables);
+        if (join == nullptr) {
+            rows.push_back("none");
+            return rows;
+        }
+        int const numFields = join->getNumFields();
+        join->run([&rows, numFields](char** row, unsigned long* lengths) {
+            std::string text;
+            for (int j = 0; j < numFields; ++j) {
+                text += (j > 0 ? "," : "");
+                text += (row[j] == nullptr) ? "NULL" : std::string(row[j], lengths[j]);
+            }
+            rows.push_back(text);
+            return true;
+        });
+        return rows;
+    }
+
+    std::string dir;
+    std::vector<Point> chunk;
+    std::vector<Point> overlap;
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(Suite, Fixture)
+
+BOOST_AUTO_TEST_CASE(Pairs) {
+    auto rows = run("SELECT o1.objectId, o2.objectId AS id2 "
+                    "FROM Subchunks_LSST_100.Object_100_1 AS o1, Subchunks_LSST_100.Object_100_1 AS o2 "
+                    "WHERE scisql_angSep(o1.ra,o1.decl,o2.ra,o2.decl) < 0.05 AND o1.objectId<>o2.objectId");
+    std::set<std::string> actual(rows.begin(), rows.end());
+    BOOST_CHECK_EQUAL(actual.size(), rows.size());
+    auto pairs = expected(chunk, 1, chunk, 1, 0.05);
+    BOOST_CHECK(pairs.size() > 50);
+    BOOST_CHECK(actual == pairs);
+
+    // The overlap, with the distance.
+    rows = run("SELECT o1.objectId, o2.objectId, scisql_angSep(o2.ra,o2.decl,o1.ra,o1.decl) AS dist "
+               "FROM Subchunks_LSST_100.Object_100_1 o1, Subchunks_LSST_100.ObjectFullOverlap_100_1 o2 "
+               "WHERE 0.05 > scisql_angSep(o1.ra, o1.decl, o2.ra, o2.decl) AND o1.objectId <> o2.objectId;");
+    pairs = expected(chunk, 1, overlap, 1, 0.05);
+    BOOST_CHECK(!pairs.empty());
+    BOOST_REQUIRE_EQUAL(rows.size(), pairs.size());
+    for (auto const& row : rows) {
+        size_t const sep = row.rfind(',');
+        BOOST_CHECK(pairs.count(row.substr(0, sep)) == 1);
+        double const dist = std::strtod(row.c_str() + sep + 1, nullptr);
+        BOOST_CHECK(dist >= 0.0 && dist < 0.05);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(Count) {
+    auto pairs = expected(chunk, 2, chunk, 2, 0.03);
+    size_t below = 0;
+    for (auto const& p : chunk) {
+        for (auto const& q : chunk) {
+            if (p.subChunkId == 2 && q.subChunkId == 2 && p.objectId < q.objectId && q.objectId <= 300
+                && p.decl >= 0.0 && q.decl >= 0.0 && angSep(p.ra, p.decl, q.ra, q.decl) < 0.03) {
+                ++below;
+            }
+        }
+    }
+    auto rows = run("SELECT COUNT(*) AS QS1_COUNT "
+                    "FROM Subchunks_LSST_100.Object_100_2 AS o1, Subchunks_LSST_100.Object_100_2 AS o2 "
+                    "WHERE scisql_s2PtInBox(o1.ra,o1.decl,0,0,1,1)=1 AND scisql_s2PtInBox(o2.ra,o2.decl,0,0,1,1)=1 "
+                    "AND scisql_angSep(o1.ra,o1.decl,o2.ra,o2.decl)<0.03 AND o1.objectId<o2.objectId "
+                    "AND o2.objectId <= 300");
+    BOOST_REQUIRE_EQUAL(rows.size(), 1u);
+    BOOST_CHECK_EQUAL(rows[0], std::to_string(below));
+    BOOST_CHECK(below > 0 && below < pairs.size());
+
+    // Subchunks without rows give no pairs.
+    rows = run("SELECT COUNT(*) AS n FROM Subchunks_LSST_100.Object_100_7 AS o1, "
+               "Subchunks_LSST_100.ObjectFullOverlap_100_7 AS o2 "
+               "WHERE scisql_angSep(o1.ra,o1.decl,o2.ra,o2.decl) < 1");
+    BOOST_REQUIRE_EQUAL(rows.size(), 1u);
+    BOOST_CHECK_EQUAL(rows[0], "0");
+}
+
+BOOST_AUTO_TEST_CASE(Schema) {
+    NativeJoin::Tables tables(dir);
+    auto join = NativeJoin::plan("SELECT o2.objectId, scisql_angSep(o1.ra,o1.decl,o2.ra,o2.decl) AS d "
+                                 "FROM Subchunks_LSST_100.Object_100_1 AS o1, Subchunks_LSST_100.Object_100_1 AS o2 "
+                                 "WHERE scisql_angSep(o1.ra,o1.decl,o2.ra,o2.decl) <= 0.01", tables);
+    BOOST_REQUIRE(join != nullptr);
+    lsst::qserv::proto::RowSchema schema;
+    join->fillSchema(schema);
+    BOOST_REQUIRE_EQUAL(schema.columnschema_size(), 2);
+    BOOST_CHECK_EQUAL(schema.columnschema(0).name(), "objectId");
+    BOOST_CHECK_EQUAL(schema.columnschema(0).mysqltype(), MYSQL_TYPE_LONGLONG);
+    BOOST_CHECK_EQUAL(schema.columnschema(1).name(), "d");
+    BOOST_CHECK_EQUAL(schema.columnschema(1).sqltype(), "DOUBLE");
+}
+
+BOOST_AUTO_TEST_CASE(Fallback) {
+    std::vector<std::string> const none = {"none"};
+    std::string const from = " FROM Subchunks_LSST_100.Object_100_1 AS o1, Subchunks_LSST_100.Object_100_1 AS o2 ";
+    std::string const near = "scisql_angSep(o1.ra,o1.decl,o2.ra,o2.decl) < 0.1";
+    std::string const queries[] = {
+        "SELECT o1.objectId" + from,
+        "SELECT o1.objectId" + from + "WHERE scisql_angSep(o1.ra,o1.decl,o2.ra,o2.decl) > 0.1",
+        "SELECT o1.objectId" + from + "WHERE scisql_angSep(o1.ra,o1.decl,o1.ra,o1.decl) < 0.1",
+        "SELECT o1.objectId" + from + "WHERE " + near + " OR o1.objectId = 2",
+        "SELECT objectId" + from + "WHERE " + near,
+        "SELECT o1.missing" + from + "WHERE " + near,
+        "SELECT COUNT(*)" + from + "WHERE " + near,
+        "SELECT COUNT(*) AS n, o1.objectId" + from + "WHERE " + near,
+        "SELECT scisql_angSep(o1.ra,o1.decl,o2.ra,o2.decl)" + from + "WHERE " + near,
+        "SELECT o1.objectId" + from + "WHERE " + near + " ORDER BY o1.objectId",
+        "SELECT o1.objectId FROM LSST.Object_100 AS o1, LSST.Object_100 AS o2 WHERE " + near,
+        "SELECT o1.objectId FROM Subchunks_LSST_200.Object_200_1 AS o1, "
+            "Subchunks_LSST_200.Object_200_1 AS o2 WHERE " + near,
+    };
+    for (auto const& query : queries) {
+        BOOST_CHECK_MESSAGE(run(query) == none, query);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
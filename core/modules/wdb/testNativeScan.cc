@@ -0,0 +1,185 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/**
+ * @brief Test ColumnarFile and the queries NativeScan runs without MySQL.
+ */
+
+// System headers
+#include <cstdlib>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+// Third-party headers
+#include <mysql/mysql.h>
+
+// Qserv headers
+#include "proto/worker.pb.h"
+#include "wdb/ColumnarFile.h"
+#include "wdb/NativeScan.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE NativeScan_1
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::wdb::ColumnarFile;
+using lsst::qserv::wdb::NativeScan;
+
+namespace {
+
+/// Writes LSST.Object_100 with 10 rows to a temporary directory:
+/// objectId 1..10, ra 0.5*objectId, flux a FLOAT that is NULL on even rows.
+struct Fixture {
+    Fixture() {
+        char tmpl[] = "/tmp/testNativeScan-XXXXXX";
+        dir = mkdtemp(tmpl);
+        mkdir((dir + "/LSST").c_str(), 0755);
+        std::vector<ColumnarFile::ColumnData> cols(3);
+        cols[0].column.name = "objectId";
+        cols[0].column.type = ColumnarFile::Type::INT64;
+        cols[0].column.mysqlType = MYSQL_TYPE_LONGLONG;
+        cols[0].column.sqlType = "BIGINT(20)";
+        cols[1].column.name = "ra";
+        cols[1].column.type = ColumnarFile::Type::DOUBLE;
+        cols[1].column.mysqlType = MYSQL_TYPE_DOUBLE;
+        cols[1].column.sqlType = "DOUBLE";
+        cols[2].column.name = "flux";
+        cols[2].column.type = ColumnarFile::Type::FLOAT;
+        cols[2].column.mysqlType = MYSQL_TYPE_FLOAT;
+        cols[2].column.sqlType = "FLOAT";
+        for (int j = 1; j <= 10; ++j) {
+            cols[0].ints.push_back(j);
+            cols[1].doubles.push_back(0.5 * j);
+            cols[2].floats.push_back(j % 2 == 0 ? 0.0f : 0.1f * j);
+            cols[2].nulls.push_back(j % 2 == 0);
+        }
+        std::string err;
+        bool ok = ColumnarFile::write(ColumnarFile::pathFor(dir, "LSST", "Object_100"), cols, 10, true, err);
+        BOOST_REQUIRE_MESSAGE(ok, err);
+    }
+
+    ~Fixture() {
+        std::string cmd = "rm -rf " + dir;
+        std::system(cmd.c_str());
+    }
+
+    /// @return the rows of 'query' as comma separated text, or "none" if it cannot run natively.
+    std::vector<std::string> run(std::string const& query) {
+        std::vector<std::string> rows;
+        auto scan = NativeScan::plan(query, dir);
+        if (scan == nullptr) {
+            rows.push_back("none");
+            return rows;
+        }
+        int const numFields = scan->getNumFields();
+        scan->scan([&rows, numFields](char** row, unsigned long* lengths) {
+            std::string text;
+            for (int j = 0; j < numFields; ++j) {
+                text += (j > 0 ? "," : "");
+                text += (row[j] == nullptr) ? "NULL" : std::string(row[j], lengths[j]);
+            }
+            rows.push_back(text);
+            return true;
+        });
+        return rows;
+    }
+
+    std::string dir;
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(Suite, Fixture)
+
+BOOST_AUTO_TEST_CASE(File) {
+    auto file = ColumnarFile::open(ColumnarFile::pathFor(dir, "LSST", "Object_100"));
+    BOOST_REQUIRE(file != nullptr);
+    BOOST_CHECK_EQUAL(file->getNumRows(), 10u);
+    BOOST_CHECK(file->isComplete());
+    auto flux = file->find("FLUX");
+    BOOST_REQUIRE(flux != nullptr);
+    BOOST_CHECK(flux->isNull(1));
+    BOOST_CHECK(!flux->isNull(2));
+    BOOST_CHECK_EQUAL(file->find("objectId")->ints()[9], 10);
+    BOOST_CHECK(ColumnarFile::open(dir + "/LSST/Missing.qcol") == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(Filter) {
+    auto rows = run("SELECT o.objectId, ra AS r FROM LSST.Object_100 AS o WHERE objectId > 7");
+    BOOST_REQUIRE_EQUAL(rows.size(), 3u);
+    BOOST_CHECK_EQUAL(rows[0], "8,4");
+    BOOST_CHECK_EQUAL(rows[2], "10,5");
+
+    rows = run("SELECT objectId FROM LSST.Object_100 WHERE ra BETWEEN 1 AND 2 AND (3 <> objectId)");
+    BOOST_REQUIRE_EQUAL(rows.size(), 2u);
+    BOOST_CHECK_EQUAL(rows[0], "2");
+    BOOST_CHECK_EQUAL(rows[1], "4");
+
+    // Integer columns compare exactly with fractional literals.
+    BOOST_CHECK_EQUAL(run("SELECT objectId FROM LSST.Object_100 WHERE objectId = 2.5").size(), 0u);
+    BOOST_CHECK_EQUAL(run("SELECT objectId FROM LSST.Object_100 WHERE objectId < 2.5").size(), 2u);
+    BOOST_CHECK_EQUAL(run("SELECT objectId FROM LSST.Object_100 WHERE objectId >= -1e30").size(), 10u);
+
+    // NULL never passes a comparison.
+    rows = run("SELECT objectId, flux FROM LSST.Object_100 WHERE flux > 0.25 AND objectId < 6");
+    BOOST_REQUIRE_EQUAL(rows.size(), 2u);
+    BOOST_CHECK_EQUAL(rows[0], "3,0.3");
+    BOOST_CHECK_EQUAL(rows[1], "5,0.5");
+
+    rows = run("SELECT * FROM LSST.Object_100 WHERE objectId = 2;");
+    BOOST_REQUIRE_EQUAL(rows.size(), 1u);
+    BOOST_CHECK_EQUAL(rows[0], "2,1,NULL");
+}
+
+BOOST_AUTO_TEST_CASE(Schema) {
+    auto scan = NativeScan::plan("SELECT ra AS r, objectId FROM LSST.Object_100", dir);
+    BOOST_REQUIRE(scan != nullptr);
+    lsst::qserv::proto::RowSchema schema;
+    scan->fillSchema(schema);
+    BOOST_REQUIRE_EQUAL(schema.columnschema_size(), 2);
+    BOOST_CHECK_EQUAL(schema.columnschema(0).name(), "r");
+    BOOST_CHECK_EQUAL(schema.columnschema(0).sqltype(), "DOUBLE");
+    BOOST_CHECK_EQUAL(schema.columnschema(1).mysqltype(), MYSQL_TYPE_LONGLONG);
+}
+
+BOOST_AUTO_TEST_CASE(Fallback) {
+    std::vector<std::string> const none = {"none"};
+    char const* const queries[] = {
+        "SELECT COUNT(*) FROM LSST.Object_100",
+        "SELECT objectId FROM LSST.Object_100 WHERE ra > 1 OR objectId = 2",
+        "SELECT objectId FROM LSST.Object_100 WHERE name = 'x'",
+        "SELECT objectId FROM LSST.Object_100 ORDER BY objectId",
+        "SELECT missing FROM LSST.Object_100",
+        "SELECT o.objectId FROM LSST.Object_100 AS o, LSST.Source_100 AS s",
+        "SELECT objectId FROM LSST.Object_200",
+        "SELECT x.objectId FROM LSST.Object_100 AS o",
+    };
+    for (auto query : queries) {
+        BOOST_CHECK_MESSAGE(run(query) == none, query);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
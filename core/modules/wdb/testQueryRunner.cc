@@ -133,8 +133,8 @@ BOOST_AUTO_TEST_CASE(Output) {
     lsst::qserv::proto::Result result;
     BOOST_REQUIRE(ProtoImporter<Result>::setMsgFrom(result, cursor, remain));
     result.PrintDebugString();
-    std::string computedMd5 = util::StringHash::getMd5(cursor, remain);
-    BOOST_CHECK_EQUAL(ph.md5(), computedMd5);
+    BOOST_CHECK_EQUAL(ph.checksum(), ProtoHeader::CRC32C);
+    BOOST_CHECK_EQUAL(ph.crc32c(), util::StringHash::getCrc32c(cursor, remain));
     BOOST_CHECK_EQUAL(task->msg->session(), result.session());
 }
 
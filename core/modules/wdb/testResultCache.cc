@@ -0,0 +1,130 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/**
+ * @brief Test ResultCache keys, eviction and shared scans.
+ */
+
+// System headers
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+// Qserv headers
+#include "proto/worker.pb.h"
+#include "wdb/ResultCache.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE ResultCache_1
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::proto::TaskMsg;
+using lsst::qserv::wdb::ResultCache;
+
+namespace {
+
+TaskMsg makeMsg(std::uint64_t queryId, int jobId) {
+    TaskMsg msg;
+    msg.set_session(7);
+    msg.set_db("LSST");
+    msg.set_chunkid(1234);
+    msg.set_queryid(queryId);
+    msg.set_jobid(jobId);
+    msg.set_scaninteractive(true);
+    msg.set_attemptcount(0);
+    auto fragment = msg.add_fragment();
+    fragment->set_resulttable("r_" + std::to_string(queryId));
+    fragment->add_query("SELECT * FROM LSST.Object_1234");
+    return msg;
+}
+
+ResultCache::Entry::Ptr makeEntry(std::size_t bytes) {
+    auto entry = std::make_shared<ResultCache::Entry>();
+    entry->results.push_back(std::string(bytes, 'x'));
+    entry->bytes = bytes;
+    return entry;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(Keys) {
+    auto a = makeMsg(1, 1);
+    auto b = makeMsg(2, 5);
+    // Ids of the user query do not matter, the work and the chunk version do.
+    BOOST_CHECK_EQUAL(ResultCache::makeKey(a, 0), ResultCache::makeKey(b, 0));
+    BOOST_CHECK(ResultCache::makeKey(a, 0) != ResultCache::makeKey(a, 1));
+    b.mutable_fragment(0)->set_query(0, "SELECT * FROM LSST.Object_1234 LIMIT 1");
+    BOOST_CHECK(ResultCache::makeKey(a, 0) != ResultCache::makeKey(b, 0));
+}
+
+BOOST_AUTO_TEST_CASE(Eviction) {
+    ResultCache cache(1000);
+    BOOST_CHECK(cache.get("a") == nullptr);
+    cache.put("a", makeEntry(100));
+    cache.put("b", makeEntry(100));
+    cache.put("tooBig", makeEntry(101));
+    BOOST_CHECK_EQUAL(cache.getSize(), 2u);
+    BOOST_CHECK(cache.get("a") != nullptr); // "b" is now least recently used.
+    for (int j = 0; j < 9; ++j) {
+        cache.put("c" + std::to_string(j), makeEntry(100));
+    }
+    BOOST_CHECK_EQUAL(cache.getBytes(), 1000u);
+    BOOST_CHECK(cache.get("b") == nullptr);
+    BOOST_CHECK(cache.get("a") != nullptr);
+    BOOST_CHECK_EQUAL(cache.getHits(), 2u);
+    BOOST_CHECK_EQUAL(cache.getMisses(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(SharedScan) {
+    ResultCache cache(1000);
+    BOOST_CHECK(cache.getOrRun("a") == nullptr); // This task runs "a".
+    ResultCache::Entry::Ptr shared;
+    std::thread waiter([&cache, &shared]() { shared = cache.getOrRun("a"); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    BOOST_CHECK(shared == nullptr);
+    cache.put("a", makeEntry(100));
+    waiter.join();
+    BOOST_CHECK(shared != nullptr);
+    BOOST_CHECK_EQUAL(cache.getShared(), 1u);
+
+    // After abandon(), a waiting task runs the work itself.
+    BOOST_CHECK(cache.getOrRun("b") == nullptr);
+    bool ran = false;
+    std::thread runner([&cache, &ran]() {
+        ran = (cache.getOrRun("b") == nullptr);
+        cache.put("b", makeEntry(2000)); // Too big to keep, which also ends the run.
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    cache.abandon("b");
+    runner.join();
+    BOOST_CHECK(ran);
+    BOOST_CHECK(cache.getOrRun("b") == nullptr);
+    cache.abandon("b");
+    BOOST_CHECK_EQUAL(cache.getShared(), 1u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
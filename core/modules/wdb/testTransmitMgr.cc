@@ -0,0 +1,127 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/**
+ * @brief Test TransmitMgr ordering and budget.
+ */
+
+// System headers
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Qserv headers
+#include "wdb/TransmitMgr.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE TransmitMgr_1
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::wdb::TransmitMgr;
+
+namespace {
+
+/// Wait until 'count' callers are blocked in mgr.take().
+void waitForWaiters(TransmitMgr& mgr, std::size_t count) {
+    while (mgr.getWaitCount() < count) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(Budget) {
+    TransmitMgr mgr(1000);
+    mgr.take(1, 10, false, 600);
+    BOOST_CHECK_EQUAL(mgr.getBytesInFlight(), 600u);
+    // Larger than the budget, but nothing else is waiting and there is room
+    // once the first message is released.
+    std::thread t([&mgr]() { mgr.take(1, 10, false, 2000); });
+    waitForWaiters(mgr, 1);
+    BOOST_CHECK_EQUAL(mgr.getBytesInFlight(), 600u);
+    mgr.release(1, 10, 600);
+    t.join();
+    BOOST_CHECK_EQUAL(mgr.getBytesInFlight(), 2000u);
+    mgr.release(1, 10, 2000);
+    BOOST_CHECK_EQUAL(mgr.getBytesInFlight(), 0u);
+    BOOST_CHECK_EQUAL(mgr.getWaitCount(), 0u);
+    BOOST_CHECK(mgr.getMaxStallSec() > 0.0);
+    BOOST_CHECK(mgr.getTotalStallSec() >= mgr.getMaxStallSec());
+}
+
+BOOST_AUTO_TEST_CASE(Order) {
+    TransmitMgr mgr(100);
+    // czar 1 is using the whole budget and keeps half of it throughout.
+    mgr.take(1, 10, false, 50);
+    mgr.take(1, 10, false, 50);
+    std::vector<int> order;
+    std::mutex orderMtx;
+    auto taker = [&](std::uint32_t czarId, lsst::qserv::QueryId qId, bool interactive, int tag) {
+        mgr.take(czarId, qId, interactive, 50);
+        {
+            std::lock_guard<std::mutex> lg(orderMtx);
+            order.push_back(tag);
+        }
+        mgr.release(czarId, qId, 50);
+    };
+    std::vector<std::thread> threads;
+    threads.emplace_back(taker, 1, 11, false, 1);
+    waitForWaiters(mgr, 1);
+    threads.emplace_back(taker, 2, 20, false, 2);
+    waitForWaiters(mgr, 2);
+    threads.emplace_back(taker, 1, 12, true, 3);
+    waitForWaiters(mgr, 3);
+    mgr.release(1, 10, 50);
+    for (auto& t : threads) t.join();
+    // Interactive first, then czar 2 which has less in flight than czar 1.
+    BOOST_REQUIRE_EQUAL(order.size(), 3u);
+    BOOST_CHECK_EQUAL(order[0], 3);
+    BOOST_CHECK_EQUAL(order[1], 2);
+    BOOST_CHECK_EQUAL(order[2], 1);
+    BOOST_CHECK_EQUAL(mgr.getBytesInFlight(), 50u);
+}
+
+BOOST_AUTO_TEST_CASE(Cancel) {
+    TransmitMgr mgr(100);
+    BOOST_CHECK(mgr.take(1, 10, false, 100));
+    bool waiterGranted = true;
+    std::thread t([&mgr, &waiterGranted]() { waiterGranted = mgr.take(1, 11, false, 50); });
+    waitForWaiters(mgr, 1);
+    // The waiter gives up without any bytes being released.
+    mgr.cancelQuery(11);
+    t.join();
+    BOOST_CHECK(!waiterGranted);
+    BOOST_CHECK_EQUAL(mgr.getWaitCount(), 0u);
+    BOOST_CHECK_EQUAL(mgr.getBytesInFlight(), 100u);
+    BOOST_CHECK(!mgr.take(1, 11, false, 50));
+    mgr.release(1, 10, 100);
+    BOOST_CHECK(mgr.take(1, 10, false, 50));
+    BOOST_CHECK_EQUAL(mgr.getBytesInFlight(), 50u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
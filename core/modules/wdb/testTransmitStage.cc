@@ -0,0 +1,179 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/**
+ * @brief Test TransmitStage ordering, depth and memory limit.
+ */
+
+// System headers
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Qserv headers
+#include "wbase/SendChannel.h"
+#include "wdb/TransmitStage.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE TransmitStage_1
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::wbase::SendChannel;
+using lsst::qserv::wdb::TransmitStage;
+using lsst::qserv::xrdsvc::StreamBuffer;
+
+namespace {
+
+/// Keeps the buffers it is given, as XrdSsi would until the czar reads them.
+class FakeChannel : public SendChannel {
+public:
+    bool sendStream(StreamBuffer::Ptr const& sBuf, bool last) override {
+        std::lock_guard<std::mutex> lock(mtx);
+        buffers.push_back(sBuf);
+        if (last) ++lastCount;
+        return true;
+    }
+
+    std::size_t size() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return buffers.size();
+    }
+
+    /// Recycle the oldest buffer, XrdSsi's way of saying the czar read it.
+    std::string recycleFront() {
+        StreamBuffer::Ptr sBuf;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            sBuf = buffers.front();
+            buffers.erase(buffers.begin());
+        }
+        std::string data(sBuf->data, sBuf->getSize());
+        sBuf->Recycle();
+        return data;
+    }
+
+    std::mutex mtx;
+    std::vector<StreamBuffer::Ptr> buffers;
+    int lastCount{0};
+};
+
+StreamBuffer::Ptr makeBuf(std::string str) {
+    return StreamBuffer::createWithMove(str);
+}
+
+/// Wait until 'channel' holds 'count' buffers.
+void waitForSize(FakeChannel& channel, std::size_t count) {
+    while (channel.size() < count) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(Depth) {
+    auto stage = std::make_shared<TransmitStage>(2, 0);
+    auto channel = std::make_shared<FakeChannel>();
+    auto stream = stage->openStream(channel, 10, 1);
+    std::atomic<int> recycled{0};
+    auto onRecycle = [&recycled]() { ++recycled; };
+    BOOST_CHECK(stage->push(stream, makeBuf("h1"), makeBuf("r1"), false, onRecycle));
+    BOOST_CHECK(stage->push(stream, makeBuf("h2"), makeBuf("r2"), true, onRecycle));
+    waitForSize(*channel, 2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    // Only one Result message may be with XrdSsi at a time.
+    BOOST_CHECK_EQUAL(channel->size(), 2u);
+    BOOST_CHECK_EQUAL(stage->getQueuedCount(), 1u);
+    BOOST_CHECK_EQUAL(channel->recycleFront(), "h1");
+    BOOST_CHECK_EQUAL(channel->recycleFront(), "r1");
+    BOOST_CHECK_EQUAL(recycled, 1);
+    waitForSize(*channel, 2);
+    BOOST_CHECK_EQUAL(channel->recycleFront(), "h2");
+    BOOST_CHECK_EQUAL(channel->recycleFront(), "r2");
+    BOOST_CHECK_EQUAL(recycled, 2);
+    BOOST_CHECK_EQUAL(channel->lastCount, 1);
+    BOOST_CHECK_EQUAL(stage->getBytes(), 0u);
+    BOOST_CHECK_EQUAL(stage->getQueuedCount(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(MaxBytes) {
+    auto stage = std::make_shared<TransmitStage>(1, 10);
+    auto channel = std::make_shared<FakeChannel>();
+    auto streamA = stage->openStream(channel, 10, 1);
+    auto streamB = stage->openStream(channel, 11, 1);
+    // Larger than the limit, but the stream holds nothing yet.
+    BOOST_CHECK(stage->push(streamA, makeBuf("h"), makeBuf("aaaaaaaa"), false));
+    // Another stream holding nothing is let through too.
+    BOOST_CHECK(stage->push(streamB, makeBuf("h"), makeBuf("bbbbbbbb"), true));
+    BOOST_CHECK_EQUAL(stage->getBytes(), 16u);
+    std::atomic<bool> pushed{false};
+    std::thread t([&]() {
+        stage->push(streamA, makeBuf("h"), makeBuf("cccc"), true);
+        pushed = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    BOOST_CHECK(!pushed);
+    waitForSize(*channel, 4);
+    channel->recycleFront();
+    channel->recycleFront();
+    channel->recycleFront();
+    channel->recycleFront();
+    t.join();
+    BOOST_CHECK(pushed);
+    BOOST_CHECK(stage->getTotalStallSec() > 0.0);
+    waitForSize(*channel, 2);
+    BOOST_CHECK_EQUAL(channel->recycleFront(), "h");
+    BOOST_CHECK_EQUAL(channel->recycleFront(), "cccc");
+    BOOST_CHECK_EQUAL(stage->getBytes(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(Cancel) {
+    auto stage = std::make_shared<TransmitStage>(1, 0);
+    auto channel = std::make_shared<FakeChannel>();
+    auto stream = stage->openStream(channel, 10, 1);
+    std::atomic<int> recycled{0};
+    auto onRecycle = [&recycled]() { ++recycled; };
+    for (int j = 0; j < 3; ++j) {
+        BOOST_CHECK(stage->push(stream, makeBuf("h"), makeBuf("rr"), false, onRecycle));
+    }
+    waitForSize(*channel, 2);
+    stage->cancelQuery(10);
+    // The queued messages are dropped, the one with XrdSsi is not.
+    BOOST_CHECK_EQUAL(recycled, 2);
+    BOOST_CHECK_EQUAL(stage->getQueuedCount(), 0u);
+    BOOST_CHECK(!stage->push(stream, makeBuf("h"), makeBuf("rr"), true, onRecycle));
+    BOOST_CHECK_EQUAL(recycled, 3);
+    channel->recycleFront();
+    channel->recycleFront();
+    BOOST_CHECK_EQUAL(recycled, 4);
+    BOOST_CHECK_EQUAL(stage->getBytes(), 0u);
+    BOOST_CHECK_EQUAL(channel->size(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -114,6 +114,7 @@ void AddChunkGroupCommand::run() {
 
             // Notify QServ and update the database
             _chunkInventory->add(database, _chunk, _mySqlConfig);
+            _chunkInventory->markChanged(database);
 
         } catch (InvalidParamError const& ex) {
             reportError(proto::WorkerCommandChunkGroupR::INVALID, ex.what());
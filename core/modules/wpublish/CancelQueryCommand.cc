@@ -0,0 +1,85 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "wpublish/CancelQueryCommand.h"
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "proto/worker.pb.h"
+#include "wbase/SendChannel.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.wpublish.CancelQueryCommand");
+
+} // annonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace wpublish {
+
+CancelQueryCommand::CancelQueryCommand(std::shared_ptr<wbase::SendChannel>  const& sendChannel,
+                                       std::shared_ptr<wbase::MsgProcessor> const& processor,
+                                       QueryId queryId)
+    :   wbase::WorkerCommand(sendChannel),
+        _processor(processor),
+        _queryId(queryId) {
+}
+
+void CancelQueryCommand::reportError(std::string const& message) {
+
+    LOGS(_log, LOG_LVL_ERROR, "CancelQueryCommand::run  " << message);
+
+    proto::WorkerCommandCancelQueryR reply;
+
+    reply.set_status(proto::WorkerCommandCancelQueryR::ERROR);
+    reply.set_error(message);
+
+    _frameBuf.serialize(reply);
+    std::string str(_frameBuf.data(), _frameBuf.size());
+    _sendChannel->sendStream(xrdsvc::StreamBuffer::createWithMove(str), true);
+}
+
+void CancelQueryCommand::run() {
+
+    LOGS(_log, LOG_LVL_DEBUG, "CancelQueryCommand::run  " << QueryIdHelper::makeIdStr(_queryId));
+
+    if (_processor == nullptr) {
+        reportError("no task processor on this worker");
+        return;
+    }
+    int const tasks = _processor->cancelQuery(_queryId);
+
+    proto::WorkerCommandCancelQueryR reply;
+    reply.set_status(proto::WorkerCommandCancelQueryR::SUCCESS);
+    reply.set_tasks(tasks);
+
+    _frameBuf.serialize(reply);
+    std::string str(_frameBuf.data(), _frameBuf.size());
+    _sendChannel->sendStream(xrdsvc::StreamBuffer::createWithMove(str), true);
+}
+
+}}} // namespace lsst::qserv::wpublish
@@ -0,0 +1,101 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/// CancelQueryCommand.h
+#ifndef LSST_QSERV_WPUBLISH_CANCEL_QUERY_COMMAND_H
+#define LSST_QSERV_WPUBLISH_CANCEL_QUERY_COMMAND_H
+
+// System headers
+#include <memory>
+#include <string>
+
+// Qserv headers
+#include "global/intTypes.h"
+#include "wbase/MsgProcessor.h"
+#include "wbase/WorkerCommand.h"
+
+namespace lsst {
+namespace qserv {
+namespace wpublish {
+
+/**
+  * Class CancelQueryCommand cancels all the tasks of a user query on
+  * the worker, whether they are queued, running or waiting to transmit
+  * their results
+  */
+class CancelQueryCommand
+    :   public wbase::WorkerCommand {
+
+public:
+
+    // The default construction and copy semantics are prohibited
+    CancelQueryCommand() = delete;
+    CancelQueryCommand& operator=(CancelQueryCommand const&) = delete;
+    CancelQueryCommand(CancelQueryCommand const&) = delete;
+
+    /// The destructor
+    ~CancelQueryCommand() override = default;
+
+    /**
+     * The normal constructor of the class
+     *
+     * @param sendChannel - communication channel for reporting results
+     * @param processor   - the processor of the tasks
+     * @param queryId     - the user query to be cancelled
+     */
+    CancelQueryCommand(std::shared_ptr<wbase::SendChannel>  const& sendChannel,
+                       std::shared_ptr<wbase::MsgProcessor> const& processor,
+                       QueryId queryId);
+
+    /**
+     * Implement the corresponding method of the base class
+     *
+     * @see WorkerCommand::run()
+     */
+    void run() override;
+
+    /**
+     * Cancellations aren't delayed by other commands
+     *
+     * @see WorkerCommand::priority()
+     */
+    Priority priority() const override { return HIGH; }
+
+private:
+
+    /**
+     * Report error condition to the logging stream and reply back to
+     * a service caller.
+     *
+     * @param message - message to be reported
+     */
+    void reportError(std::string const& message);
+
+private:
+
+    std::shared_ptr<wbase::MsgProcessor> _processor;
+    QueryId _queryId;
+};
+
+}}} // namespace lsst::qserv::wpublish
+
+#endif // LSST_QSERV_WPUBLISH_CANCEL_QUERY_COMMAND_H
@@ -0,0 +1,132 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "wpublish/CancelQueryQservRequest.h"
+
+// System headers
+#include <stdexcept>
+#include <string>
+
+// Qserv headers
+#include "lsst/log/Log.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.wpublish.CancelQueryQservRequest");
+
+using namespace lsst::qserv;
+
+wpublish::CancelQueryQservRequest::Status translate(proto::WorkerCommandCancelQueryR::Status status) {
+    switch (status) {
+        case proto::WorkerCommandCancelQueryR::SUCCESS:
+            return wpublish::CancelQueryQservRequest::SUCCESS;
+        case proto::WorkerCommandCancelQueryR::ERROR:
+            return wpublish::CancelQueryQservRequest::ERROR;
+    }
+    throw std::domain_error(
+            "CancelQueryQservRequest::translate  no match for Protobuf status: " +
+            proto::WorkerCommandCancelQueryR_Status_Name(status));
+}
+}  // namespace
+
+namespace lsst {
+namespace qserv {
+namespace wpublish {
+
+std::string CancelQueryQservRequest::status2str(Status status) {
+    switch (status) {
+        case SUCCESS: return "SUCCESS";
+        case ERROR:   return "ERROR";
+    }
+    throw std::domain_error(
+            "CancelQueryQservRequest::status2str  no match for status: " +
+            std::to_string(status));
+}
+
+CancelQueryQservRequest::Ptr CancelQueryQservRequest::create(
+                                    QueryId queryId,
+                                    CancelQueryQservRequest::CallbackType onFinish) {
+    return CancelQueryQservRequest::Ptr(new CancelQueryQservRequest(queryId, onFinish));
+}
+
+CancelQueryQservRequest::CancelQueryQservRequest(
+                                    QueryId queryId,
+                                    CancelQueryQservRequest::CallbackType onFinish)
+    :   _queryId(queryId),
+        _onFinish(onFinish) {
+
+    LOGS(_log, LOG_LVL_DEBUG, "CancelQueryQservRequest  ** CONSTRUCTED **");
+}
+
+CancelQueryQservRequest::~CancelQueryQservRequest() {
+    LOGS(_log, LOG_LVL_DEBUG, "CancelQueryQservRequest  ** DELETED **");
+}
+
+void CancelQueryQservRequest::onRequest(proto::FrameBuffer& buf) {
+
+    proto::WorkerCommandH header;
+    header.set_command(proto::WorkerCommandH::CANCEL_QUERY);
+    buf.serialize(header);
+
+    proto::WorkerCommandCancelQueryM message;
+    message.set_queryid(_queryId);
+    buf.serialize(message);
+}
+
+void CancelQueryQservRequest::onResponse(proto::FrameBufferView& view) {
+
+    static std::string const context = "CancelQueryQservRequest  ";
+
+    proto::WorkerCommandCancelQueryR reply;
+    view.parse(reply);
+
+    LOGS(_log, LOG_LVL_DEBUG, context << "** SERVICE REPLY **  status: "
+         << proto::WorkerCommandCancelQueryR_Status_Name(reply.status()));
+
+    if (nullptr != _onFinish) {
+
+        // Clearing the stored callback before the notification guaranties
+        // (exactly) one time notification and breaks the dependency on a caller
+        // object mentioned in the closure, as in GetChunkListQservRequest.
+
+        auto onFinish = std::move(_onFinish);
+        _onFinish = nullptr;
+        onFinish(::translate(reply.status()),
+                 reply.error(),
+                 reply.tasks());
+    }
+}
+
+void CancelQueryQservRequest::onError(std::string const& error) {
+
+    if (nullptr != _onFinish) {
+        auto onFinish = std::move(_onFinish);
+        _onFinish = nullptr;
+        onFinish(Status::ERROR,
+                 error,
+                 0);
+    }
+}
+
+}}} // namespace lsst::qserv::wpublish
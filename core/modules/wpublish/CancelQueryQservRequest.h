@@ -0,0 +1,121 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/// CancelQueryQservRequest.h
+#ifndef LSST_QSERV_WPUBLISH_CANCEL_QUERY_QSERV_REQUEST_H
+#define LSST_QSERV_WPUBLISH_CANCEL_QUERY_QSERV_REQUEST_H
+
+// System headers
+#include <functional>
+#include <memory>
+#include <string>
+
+// Qserv headers
+#include "global/intTypes.h"
+#include "wpublish/QservRequest.h"
+
+namespace lsst {
+namespace qserv {
+namespace wpublish {
+
+/**
+  * Class CancelQueryQservRequest implements the client-side requests
+  * the Qserv worker services for cancelling all the tasks of a user query.
+  */
+class CancelQueryQservRequest
+    :    public QservRequest {
+
+public:
+
+    /// Completion status of the operation
+    enum Status {
+        SUCCESS,    // successful completion of a request
+        ERROR       // an error occured during command execution
+    };
+
+    /// @return string representation of a status
+    static std::string status2str (Status status);
+
+    /// The pointer type for instances of the class
+    typedef std::shared_ptr<CancelQueryQservRequest> Ptr;
+
+    /// The callback function type to be used for notifications on
+    /// the operation completion.
+    using CallbackType =
+        std::function<void(Status,                  // completion status
+                           std::string const&,      // error message
+                           unsigned int)>;          // tasks cancelled (if success)
+
+    /**
+     * Static factory method is needed to prevent issues with the lifespan
+     * and memory management of instances created otherwise (as values or via
+     * low-level pointers).
+     *
+     * @param queryId  - the user query to be cancelled
+     * @param onFinish - optional callback function to be called upon the completion
+     *                   (successful or not) of the request.
+     * @return smart pointer to the object of the class
+     */
+    static Ptr create(QueryId queryId,
+                      CallbackType onFinish = nullptr);
+
+    // Default construction and copy semantics are prohibited
+    CancelQueryQservRequest() = delete;
+    CancelQueryQservRequest(CancelQueryQservRequest const&) = delete;
+    CancelQueryQservRequest& operator=(CancelQueryQservRequest const&) = delete;
+
+    /// Destructor
+    ~CancelQueryQservRequest() override;
+
+protected:
+
+    /**
+     * Normal constructor
+     *
+     * @param queryId  - the user query to be cancelled
+     * @param onFinish - optional callback function to be called upon the completion
+     *                   (successful or not) of the request.
+     */
+    CancelQueryQservRequest(QueryId queryId,
+                            CallbackType onFinish);
+
+    /// Implement the corresponding method of the base class
+    void onRequest(proto::FrameBuffer& buf) override;
+
+    /// Implement the corresponding method of the base class
+    void onResponse(proto::FrameBufferView& view) override;
+
+    /// Implement the corresponding method of the base class
+    void onError(std::string const& error) override;
+
+private:
+
+    QueryId _queryId;
+
+    /// Optional callback function to be called upon the completion
+    /// (successfull or not) of the request.
+    CallbackType _onFinish;
+};
+
+}}} // namespace lsst::qserv::wpublish
+
+#endif // LSST_QSERV_WPUBLISH_CANCEL_QUERY_QSERV_REQUEST_H
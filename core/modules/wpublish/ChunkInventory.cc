@@ -28,6 +28,8 @@
 // System headers
 #include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cstring>
 #include <deque>
 #include <iostream>
 
@@ -44,6 +46,12 @@
 
 #define LOCK_GUARD std::lock_guard<std::mutex> lock(_mtx)
 
+// This macro to appear within each block which runs queries against the tables
+// of the inventory. It never waits for _mtx to be released, and _mtx is only
+// taken once the results of the queries are in memory.
+
+#define UPDATE_GUARD std::lock_guard<std::mutex> updateLock(_updateMtx)
+
 namespace { // File-scope helpers
 
 LOG_LOGGER _log = LOG_GET("lsst.qserv.wpublish.ChunkInventory");
@@ -51,6 +59,15 @@ LOG_LOGGER _log = LOG_GET("lsst.qserv.wpublish.ChunkInventory");
 using lsst::qserv::sql::SqlConnection;
 using lsst::qserv::sql::SqlErrorObject;
 using lsst::qserv::sql::SqlResultIter;
+
+/// @return the FNV-1a hash of the 'len' bytes of a database name at 'db'
+std::size_t hashDbName(char const* db, std::size_t len) {
+    std::uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < len; ++i) {
+        hash = (hash ^ static_cast<unsigned char>(db[i])) * 16777619u;
+    }
+    return hash;
+}
 using lsst::qserv::wpublish::ChunkInventory;
 
 
@@ -111,6 +128,16 @@ void fetchChunks(std::string const& instanceName,
         LOGS(_log, LOG_LVL_WARN, "ChunkInventory couldn't find any published chunks for db: " << db);
 }
 
+/// @return 'dbs' as a quoted list for an IN clause
+std::string quotedList(ChunkInventory::DbSet const& dbs) {
+    std::string list;
+    for (auto const& db: dbs) {
+        if (not list.empty()) list += ",";
+        list += "'" + db + "'";
+    }
+    return list;
+}
+
 /// Fetch a unique identifier of a worker
 void fetchId(std::string const& instanceName,
              SqlConnection& sc,
@@ -148,6 +175,9 @@ public:
             default: return false;
         }
     }
+    virtual bool operator()(lsst::qserv::ResourceUnit::DbChunkRef const& ref) {
+        return chunkInventory.has(ref);
+    }
     lsst::qserv::wpublish::ChunkInventory& chunkInventory;
 };
 
@@ -170,6 +200,9 @@ ChunkInventory::ChunkInventory(ChunkInventory::ExistMap const& existMap,
     :   _existMap(existMap),
         _name(name),
         _id(id) {
+    for (auto const& entry: _existMap) {
+        for (int chunk: entry.second) _indexAdd(entry.first, chunk);
+    }
 }
 
 void ChunkInventory::init(std::string const& name, mysql::MySqlConfig const& mySqlConfig) {
@@ -178,13 +211,93 @@ void ChunkInventory::init(std::string const& name, mysql::MySqlConfig const& myS
     _init(sc);
 }
 
+void ChunkInventory::init(std::string const& name, mysql::MySqlConfig const& mySqlConfig,
+                          DbSet const& dbs) {
+    _name = name;
+    SqlConnection sc(mySqlConfig, true);
+    init(dbs, sc);
+}
+
+void ChunkInventory::init(DbSet const& dbs, SqlConnection& sc) {
+
+    UPDATE_GUARD;
+
+    std::deque<std::string> published;
+    ::fetchDbs(_name, sc, published);
+
+    std::map<std::string, ChunkMap> chunks;
+    for (std::string const& db: dbs) {
+        if (std::find(published.begin(), published.end(), db) != published.end()) {
+            ::fetchChunks(_name, db, sc, chunks[db]);
+        }
+    }
+    std::string id = _id;
+    ::fetchId(_name, sc, id);
+
+    LOCK_GUARD;
+
+    for (std::string const& db: dbs) {
+        auto const itr = chunks.find(db);
+        _load(db, itr == chunks.end() ? nullptr : &(itr->second));
+    }
+    _id = id;
+}
+
 void ChunkInventory::rebuild(std::string const& name, mysql::MySqlConfig const& mySqlConfig) {
     _name = name;
     SqlConnection sc(mySqlConfig, true);
-    _rebuild(sc);
+    _rebuild(sc, std::string());
     _init(sc);
 }
 
+void ChunkInventory::rebuild(std::string const& name, mysql::MySqlConfig const& mySqlConfig,
+                             DbSet const& dbs) {
+    _name = name;
+    if (dbs.empty()) return;
+    SqlConnection sc(mySqlConfig, true);
+    _rebuild(sc, ::quotedList(dbs));
+    init(dbs, sc);
+}
+
+void ChunkInventory::markChanged(std::string const& db) {
+    LOCK_GUARD;
+    _changedDbs.insert(db);
+}
+
+ChunkInventory::DbSet ChunkInventory::changedDbs(mysql::MySqlConfig const& mySqlConfig) const {
+    SqlConnection sc(mySqlConfig, true);
+    return changedDbs(sc);
+}
+
+ChunkInventory::DbSet ChunkInventory::changedDbs(SqlConnection& sc) const {
+
+    std::deque<std::string> published;
+    ::fetchDbs(_name, sc, published);
+
+    LOCK_GUARD;
+
+    // A database is known once it was loaded or cleared, even if it has no chunks
+    DbSet dbs = _changedDbs;
+    for (std::string const& db: published) {
+        if (not _existMap.count(db) and not _generations.count(db)) dbs.insert(db);
+    }
+    for (auto const& entry: _existMap) {
+        if (not entry.second.empty() and
+            std::find(published.begin(), published.end(), entry.first) == published.end()) {
+            dbs.insert(entry.first);
+        }
+    }
+    return dbs;
+}
+
+void ChunkInventory::clearChanged(DbSet const& dbs) {
+    LOCK_GUARD;
+    for (std::string const& db: dbs) {
+        _changedDbs.erase(db);
+        _generations.emplace(db, 0);
+    }
+}
+
 void ChunkInventory::add(std::string const& db, int chunk) {
 
     LOCK_GUARD;
@@ -194,12 +307,14 @@ void ChunkInventory::add(std::string const& db, int chunk) {
     // Adding unconditionally. if the database key doesn't exist then it will
     // be automatically added by this operation.
     _existMap[db].insert(chunk);
+    _indexAdd(db, chunk);
+    _bumpVersion(db, chunk);
 
 }
 
 void ChunkInventory::add(std::string const& db, int chunk, mysql::MySqlConfig const& mySqlConfig) {
 
-    LOCK_GUARD;
+    UPDATE_GUARD;
 
     LOGS(_log, LOG_LVL_DEBUG, "ChunkInventory::add()  db: " << db << ", chunk: " << chunk);
 
@@ -231,9 +346,13 @@ void ChunkInventory::add(std::string const& db, int chunk, mysql::MySqlConfig co
         }
     }
 
+    LOCK_GUARD;
+
     // Adding unconditionally. if the database key doesn't exist then it will
     // be automatically added by this operation.
     _existMap[db].insert(chunk);
+    _indexAdd(db, chunk);
+    _bumpVersion(db, chunk);
 }
 
 void ChunkInventory::remove(std::string const& db, int chunk) {
@@ -248,16 +367,18 @@ void ChunkInventory::remove(std::string const& db, int chunk) {
     auto dbItr = _existMap.find(db);
     if (dbItr == _existMap.end()) return;
 
-    auto chunks   = dbItr->second;
+    auto& chunks  = dbItr->second;
     auto chunkItr = chunks.find(chunk);
     if (chunkItr == chunks.end()) return;
 
-    _existMap[db].erase(chunk);
+    chunks.erase(chunkItr);
+    _indexRemove(db, chunk);
+    _bumpVersion(db, chunk);
 }
 
 void ChunkInventory::remove(std::string const& db, int chunk, mysql::MySqlConfig const& mySqlConfig) {
 
-    LOCK_GUARD;
+    UPDATE_GUARD;
 
     LOGS(_log, LOG_LVL_DEBUG, "ChunkInventory::remove()  db: " << db << ", chunk: " << chunk);
 
@@ -278,37 +399,117 @@ void ChunkInventory::remove(std::string const& db, int chunk, mysql::MySqlConfig
         }
     }
 
+    LOCK_GUARD;
+
     // If no such database or a chunk exsist in the map then simply
     // quite and make no fuss about it.
 
     auto dbItr = _existMap.find(db);
     if (dbItr == _existMap.end()) return;
 
-    auto chunks   = dbItr->second;
+    auto& chunks  = dbItr->second;
     auto chunkItr = chunks.find(chunk);
     if (chunkItr == chunks.end()) return;
 
-    _existMap[db].erase(chunk);
+    chunks.erase(chunkItr);
+    _indexRemove(db, chunk);
+    _bumpVersion(db, chunk);
 }
 
 bool ChunkInventory::has(std::string const& db, int chunk) const {
+    ResourceUnit::DbChunkRef ref;
+    ref.db = db.data();
+    ref.dbLen = db.size();
+    ref.chunk = chunk;
+    return has(ref);
+}
+
+bool ChunkInventory::has(ResourceUnit::DbChunkRef const& ref) const {
 
     LOCK_GUARD;
 
-    auto dbItr = _existMap.find(db);
-    if (dbItr == _existMap.end()) return false;
+    int const id = _findDb(ref.db, ref.dbLen);
+    return id >= 0 && _chunkIndex.count(_key(id, ref.chunk)) != 0;
+}
 
-    auto const& chunks   = dbItr->second;
-    auto        chunkItr = chunks.find(chunk);
-    if (chunkItr == chunks.end()) return false;
+int ChunkInventory::dbId(char const* db, std::size_t len) const {
+    LOCK_GUARD;
+    return _findDb(db, len);
+}
 
-    return true;
+bool ChunkInventory::has(int dbId, int chunk) const {
+    LOCK_GUARD;
+    return dbId >= 0 && _chunkIndex.count(_key(dbId, chunk)) != 0;
 }
 
 std::shared_ptr<ResourceUnit::Checker> ChunkInventory::newValidator() {
     return std::shared_ptr<ResourceUnit::Checker>(new Validator(*this));
 }
 
+std::uint64_t ChunkInventory::version(std::string const& db, int chunk) const {
+
+    LOCK_GUARD;
+
+    std::uint64_t changes = 0;
+    auto dbItr = _changeMap.find(db);
+    if (dbItr != _changeMap.end()) {
+        auto chunkItr = dbItr->second.find(chunk);
+        if (chunkItr != dbItr->second.end()) changes = chunkItr->second;
+    }
+    std::uint64_t generation = 0;
+    auto genItr = _generations.find(db);
+    if (genItr != _generations.end()) generation = genItr->second;
+    return (generation << 32) | changes;
+}
+
+std::uint64_t ChunkInventory::revision() const {
+    LOCK_GUARD;
+    return _revision;
+}
+
+void ChunkInventory::_bumpVersion(std::string const& db, int chunk) {
+    ++_changeMap[db][chunk];
+    ++_revision;
+}
+
+std::uint64_t ChunkInventory::_initialRevision() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+int ChunkInventory::_findDb(char const* db, std::size_t len) const {
+    if (_dbSlots.empty()) return -1;
+    std::size_t const mask = _dbSlots.size() - 1;
+    for (std::size_t i = hashDbName(db, len) & mask; ; i = (i + 1) & mask) {
+        std::uint32_t const slot = _dbSlots[i];
+        if (slot == 0) return -1;
+        std::string const& name = _dbNames[slot - 1];
+        if (name.size() == len && std::memcmp(name.data(), db, len) == 0) return slot - 1;
+    }
+}
+
+std::uint32_t ChunkInventory::_internDb(std::string const& db) {
+    int const id = _findDb(db.data(), db.size());
+    if (id >= 0) return id;
+
+    _dbNames.push_back(db);
+    std::size_t size = _dbSlots.size();
+    if (2 * _dbNames.size() > size) {
+        // Grow, and place all the names again.
+        size = std::max<std::size_t>(16, 2 * size);
+        _dbSlots.assign(size, 0);
+    } else {
+        size = 0; // Only the new name is placed
+    }
+    std::size_t const mask = _dbSlots.size() - 1;
+    for (std::uint32_t j = (size == 0) ? _dbNames.size() - 1 : 0; j < _dbNames.size(); ++j) {
+        std::size_t i = hashDbName(_dbNames[j].data(), _dbNames[j].size()) & mask;
+        while (_dbSlots[i] != 0) i = (i + 1) & mask;
+        _dbSlots[i] = j + 1;
+    }
+    return _dbNames.size() - 1;
+}
+
 void ChunkInventory::dbgPrint(std::ostream& os) const {
 
     LOCK_GUARD;
@@ -340,7 +541,7 @@ void ChunkInventory::dbgPrint(std::ostream& os) const {
 
 void ChunkInventory::_init(SqlConnection& sc) {
 
-    LOCK_GUARD;
+    UPDATE_GUARD;
 
     // Check metadata for databases to track
 
@@ -348,24 +549,61 @@ void ChunkInventory::_init(SqlConnection& sc) {
     ::fetchDbs(_name, sc, dbs);
 
     // get chunkList
-    _existMap.clear();
-    for (std::string const& db: dbs)
-        ::fetchChunks(_name, db, sc, _existMap[db]);
+    ExistMap existMap;
+    for (std::string const& db: dbs) {
+        ::fetchChunks(_name, db, sc, existMap[db]);
+    }
 
     // get unique identifier of a worker
-    ::fetchId(_name, sc, _id);
+    std::string id = _id;
+    ::fetchId(_name, sc, id);
+
+    LOCK_GUARD;
+
+    // The generation of every database known so far changes, so that versions
+    // of chunks of dropped databases are not reused.
+    _existMap.swap(existMap);
+    _chunkIndex.clear();
+    _changeMap.clear();
+    for (auto& entry: _generations) ++entry.second;
+    ++_revision;
+    for (auto const& entry: _existMap) {
+        if (not _generations.count(entry.first)) _generations[entry.first] = 1;
+        for (int chunk: entry.second) _indexAdd(entry.first, chunk);
+    }
+    _id = id;
 }
 
-void ChunkInventory::_rebuild(SqlConnection& sc) {
+void ChunkInventory::_load(std::string const& db, ChunkMap const* published) {
 
-    LOCK_GUARD;
+    auto dbItr = _existMap.find(db);
+    if (dbItr != _existMap.end()) {
+        for (int chunk: dbItr->second) _indexRemove(db, chunk);
+        _existMap.erase(dbItr);
+    }
+    _changeMap.erase(db);
+    ++_generations[db];
+    ++_revision;
+    if (published == nullptr) return;
+
+    ChunkMap& chunks = _existMap[db];
+    chunks = *published;
+    for (int chunk: chunks) _indexAdd(db, chunk);
+}
+
+void ChunkInventory::_rebuild(SqlConnection& sc, std::string const& dbList) {
+
+    UPDATE_GUARD;
 
+    // An empty list rebuilds the rows of all the published databases
+    std::string const dbFilter = dbList.empty() ? std::string() : " WHERE db IN (" + dbList + ")";
+    std::string const schemaFilter = dbList.empty() ? std::string() : " AND TABLE_SCHEMA IN (" + dbList + ")";
     std::vector<std::string> const queries = {
-        "DELETE FROM qservw_" + _name + ".Chunks",
+        "DELETE FROM qservw_" + _name + ".Chunks" + dbFilter,
         "INSERT INTO qservw_" + _name + ".Chunks"
         "  SELECT DISTINCT TABLE_SCHEMA,SUBSTRING_INDEX(TABLE_NAME,'_',-1)"
         "    FROM information_schema.tables"
-        "    WHERE TABLE_SCHEMA IN (SELECT db FROM qservw_" + _name + ".Dbs)"
+        "    WHERE TABLE_SCHEMA IN (SELECT db FROM qservw_" + _name + ".Dbs)" + schemaFilter +
         "          AND TABLE_NAME REGEXP '_[0-9]*$'"
     };
 
@@ -396,6 +634,19 @@ ChunkInventory::ExistMap ChunkInventory::existMap() const {
     return result;
 }
 
+ChunkInventory::ExistMap ChunkInventory::existMap(DbSet const& dbs) const {
+
+    ChunkInventory::ExistMap result;
+
+    LOCK_GUARD;
+
+    for (std::string const& db: dbs) {
+        auto dbItr = _existMap.find(db);
+        if (dbItr != _existMap.end()) result.insert(*dbItr);
+    }
+    return result;
+}
+
 ChunkInventory::ExistMap operator-(ChunkInventory const& lhs, ChunkInventory const& rhs) {
 
     // The comparision will be made based on two self-consistent copies of
@@ -29,6 +29,7 @@
 #define LSST_QSERV_WPUBLISH_CHUNKINVENTORY_H
 
 // System headers
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -36,6 +37,9 @@
 #include <set>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 // Qserv headers
 #include "global/ResourceUnit.h"
@@ -80,6 +84,7 @@ public:
     // These should be converted to unordered_* with C++11
     typedef std::set<int> ChunkMap;
     typedef std::map<std::string, ChunkMap> ExistMap;
+    typedef std::set<std::string> DbSet;
 
     typedef std::shared_ptr<ChunkInventory>       Ptr;
     typedef std::shared_ptr<ChunkInventory const> CPtr;
@@ -90,9 +95,30 @@ public:
 
     void init(std::string const& name, mysql::MySqlConfig const& mysqlConfig);
 
+    /// Load the chunks of 'dbs' from the Chunks table, keeping those of the
+    /// other databases. Databases no longer published are dropped.
+    void init(std::string const& name, mysql::MySqlConfig const& mysqlConfig, DbSet const& dbs);
+    void init(DbSet const& dbs, sql::SqlConnection& sc);
+
     /// Rebuilding the Chunks table
     void rebuild(std::string const& name, mysql::MySqlConfig const& mysqlConfig);
 
+    /// Rebuild the rows of 'dbs' only in the Chunks table, so that only the
+    /// tables of these databases are scanned.
+    void rebuild(std::string const& name, mysql::MySqlConfig const& mysqlConfig, DbSet const& dbs);
+
+    /// Flag 'db' as changed, its tables were added or dropped by the
+    /// replication system and the next incremental rebuild will scan it.
+    void markChanged(std::string const& db);
+
+    /// @return the databases flagged as changed, and those published in or
+    ///         withdrawn from the Dbs table since the inventory was loaded.
+    DbSet changedDbs(mysql::MySqlConfig const& mysqlConfig) const;
+    DbSet changedDbs(sql::SqlConnection& sc) const;
+
+    /// Clear the change flag of 'dbs' once they were reloaded.
+    void clearChanged(DbSet const& dbs);
+
     /// Add the chunk to the inventory if it's not registered yet
     void add(std::string const& db, int chunk);
 
@@ -110,6 +136,30 @@ public:
     /// @return true if the specified db and chunk are in the inventory
     bool has(std::string const& db, int chunk) const;
 
+    /// @return true if the db and chunk of a parsed path are in the
+    ///         inventory. Nothing is allocated, for the request path.
+    bool has(ResourceUnit::DbChunkRef const& ref) const;
+
+    /// @return the number the inventory gave to the database named by the
+    ///         'len' bytes at 'db' when it first saw it, -1 if it never had
+    ///         chunks of it. Numbers are never reused.
+    int dbId(char const* db, std::size_t len) const;
+
+    /// @return true if 'chunk' of the database numbered 'dbId' is in the inventory
+    bool has(int dbId, int chunk) const;
+
+    /// @return a number that changes whenever the specified chunk is added,
+    ///         removed, or the inventory is reloaded. Cached results of the
+    ///         chunk are only valid for the version they were made with.
+    std::uint64_t version(std::string const& db, int chunk) const;
+
+    /// @return a number that changes whenever any chunk is added, removed,
+    ///         or the inventory is reloaded. It starts from the time the
+    ///         inventory was created, so that it's not repeated by a restarted
+    ///         worker. A diff of the chunk list is only valid for the revision
+    ///         it was made against.
+    std::uint64_t revision() const;
+
     /// @return a unique identifier of a worker instance
     std::string const& id() const { return _id; }
 
@@ -125,6 +175,9 @@ public:
     /// @return a copy of the map in a thread-safe way
     ExistMap existMap() const;
 
+    /// @return a copy of the part of the map for 'dbs'
+    ExistMap existMap(DbSet const& dbs) const;
+
     void dbgPrint(std::ostream& os) const;
 
     friend ChunkInventory::ExistMap operator-(ChunkInventory const& lhs, ChunkInventory const& rhs);
@@ -132,19 +185,74 @@ public:
 private:
 
     void _init(sql::SqlConnection& sc);
-    void _rebuild(sql::SqlConnection& sc);
+    void _rebuild(sql::SqlConnection& sc, std::string const& dbList);
+
+    /// Replace the chunks of 'db' with those read from the Chunks table, or
+    /// drop them if 'published' is null. _mtx must be held.
+    void _load(std::string const& db, ChunkMap const* published);
+
+    /// Record a change of the specified chunk, _mtx must be held.
+    void _bumpVersion(std::string const& db, int chunk);
+
+    /// @return the first revision of the inventory
+    static std::uint64_t _initialRevision();
+
+    /// @return the number of 'db', -1 if unknown. _mtx must be held.
+    int _findDb(char const* db, std::size_t len) const;
+
+    /// @return the number of 'db', given one if new. _mtx must be held.
+    std::uint32_t _internDb(std::string const& db);
+
+    static std::uint64_t _key(std::uint32_t dbId, int chunk) {
+        return (static_cast<std::uint64_t>(dbId) << 32) | static_cast<std::uint32_t>(chunk);
+    }
+
+    /// Add or remove a chunk from _chunkIndex, _mtx must be held.
+    std::uint64_t _indexKey(std::string const& db, int chunk) { return _key(_internDb(db), chunk); }
+    void _indexAdd(std::string const& db, int chunk) { _chunkIndex.insert(_indexKey(db, chunk)); }
+    void _indexRemove(std::string const& db, int chunk) { _chunkIndex.erase(_indexKey(db, chunk)); }
 
 private:
 
     ExistMap _existMap;
     std::string _name;
 
+    /// Name of each database seen, by number, for _chunkIndex. Never shrinks.
+    std::vector<std::string> _dbNames;
+
+    /// Open addressing hash table of the names, 1 + the number of the name
+    /// in each used slot, 0 in free ones. Its size is a power of 2, at least
+    /// twice the number of names. Names are looked up without building a
+    /// std::string.
+    std::vector<std::uint32_t> _dbSlots;
+
+    /// Database number and chunk of all the chunks in _existMap, for has()
+    std::unordered_set<std::uint64_t> _chunkIndex;
+
+    /// Number of changes to each chunk since its database was last loaded
+    std::map<std::string, std::map<int, std::uint32_t>> _changeMap;
+
+    /// Number of times each database was loaded from the Chunks table
+    std::map<std::string, std::uint32_t> _generations;
+
+    /// Databases flagged by markChanged()
+    DbSet _changedDbs;
+
+    /// @see ChunkInventory::revision()
+    std::uint64_t _revision = _initialRevision();
+
     /// a unique identifier of a worker
     std::string _id;
 
     /// The mutex is used to safeguard the methods in the multi-threaded
     /// environment
     mutable std::mutex _mtx;
+
+    /// Serializes the methods which query or modify the tables of the
+    /// inventory. It's held while the queries run, and _mtx only once their
+    /// results are to be applied, so that has() and the other lookups of
+    /// the queries and the management commands never wait for MySQL.
+    std::mutex _updateMtx;
 };
 
 /// @return databases and chunks known to 'lhs' and which are not in 'rhs
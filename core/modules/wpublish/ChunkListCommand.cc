@@ -68,12 +68,14 @@ ChunkListCommand::ChunkListCommand(std::shared_ptr<wbase::SendChannel> const& se
                                    std::shared_ptr<ChunkInventory>     const& chunkInventory,
                                    mysql::MySqlConfig                  const& mySqlConfig,
                                    bool rebuild,
-                                   bool reload)
+                                   bool reload,
+                                   bool incremental)
     :   wbase::WorkerCommand(sendChannel),
         _chunkInventory(chunkInventory),
         _mySqlConfig   (mySqlConfig),
         _rebuild       (rebuild),
-        _reload        (reload) {
+        _reload        (reload),
+        _incremental   (incremental) {
 }
 
 void ChunkListCommand::reportError(std::string const& message) {
@@ -97,12 +99,26 @@ void ChunkListCommand::run() {
     proto::WorkerCommandUpdateChunkListR reply;
     reply.set_status(proto::WorkerCommandUpdateChunkListR::SUCCESS);
 
+    // Only the databases changed since the last incremental update are
+    // scanned and compared in the incremental mode.
+    ChunkInventory::DbSet changedDbs;
+    if (_incremental) {
+        try {
+            changedDbs = _chunkInventory->changedDbs(_mySqlConfig);
+        } catch (std::exception const& ex) {
+            reportError("database operation failed: " + std::string(ex.what()));
+            return;
+        }
+        LOGS(_log, LOG_LVL_DEBUG, "ChunkListCommand::run  changed databases: " << changedDbs.size());
+    }
+
     // Rebuild persistent list if requested
     if (_rebuild) {
         ChunkInventory newChunkInventory;
         try {
             xrdsvc::XrdName x;
-            newChunkInventory.rebuild(x.getName(), _mySqlConfig);
+            if (_incremental) newChunkInventory.rebuild(x.getName(), _mySqlConfig, changedDbs);
+            else              newChunkInventory.rebuild(x.getName(), _mySqlConfig);
         } catch (std::exception const& ex) {
             reportError("database operation failed: " + std::string(ex.what()));
             return;
@@ -116,7 +132,8 @@ void ChunkListCommand::run() {
         ChunkInventory newChunkInventory;
         try {
             xrdsvc::XrdName x;
-            newChunkInventory.init(x.getName(), _mySqlConfig);
+            if (_incremental) newChunkInventory.init(x.getName(), _mySqlConfig, changedDbs);
+            else              newChunkInventory.init(x.getName(), _mySqlConfig);
         } catch (std::exception const& ex) {
             reportError("database operation failed: " + std::string(ex.what()));
             return;
@@ -126,10 +143,17 @@ void ChunkListCommand::run() {
 
         // Compare two maps and worker identifiers to see which resources were
         // were added or removed. Then Update the current map and notify XRootD
-        // accordingly.
+        // accordingly. In the incremental mode only the changed databases
+        // of the current map are compared.
 
-        ChunkInventory::ExistMap const removedChunks = *_chunkInventory  - newChunkInventory;
-        ChunkInventory::ExistMap const addedChunks   = newChunkInventory - *_chunkInventory;
+        ChunkInventory const changedChunkInventory(_chunkInventory->existMap(changedDbs),
+                                                   _chunkInventory->name(),
+                                                   _chunkInventory->id());
+        ChunkInventory const& currentChunkInventory =
+            _incremental ? changedChunkInventory : *_chunkInventory;
+
+        ChunkInventory::ExistMap const removedChunks = currentChunkInventory - newChunkInventory;
+        ChunkInventory::ExistMap const addedChunks   = newChunkInventory - currentChunkInventory;
 
         xrdsvc::SsiProviderServer* providerServer = dynamic_cast<xrdsvc::SsiProviderServer*>(XrdSsiProviderLookup);
         XrdSsiCluster*             clusterManager = providerServer->GetClusterManager();
@@ -203,6 +227,9 @@ void ChunkListCommand::run() {
             }
         }
     }
+    if (_incremental and _reload) {
+        _chunkInventory->clearChanged(changedDbs);
+    }
     _frameBuf.serialize(reply);
     std::string str(_frameBuf.data(), _frameBuf.size());
     _sendChannel->sendStream(xrdsvc::StreamBuffer::createWithMove(str), true);
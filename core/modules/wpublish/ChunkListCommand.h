@@ -66,12 +66,14 @@ protected:
      * @param mySqlConfig    - database connection parameters
      * @param rebuild        - rebuild the list from actual database tables
      * @param reload         - reload the list in worker's memory
+     * @param incremental    - only rebuild or reload the changed databases
      */
     ChunkListCommand(std::shared_ptr<wbase::SendChannel> const& sendChannel,
                      std::shared_ptr<ChunkInventory>     const& chunkInventory,
                      mysql::MySqlConfig                  const& mySqlConfig,
                      bool rebuild,
-                     bool reload);
+                     bool reload,
+                     bool incremental);
 
     /**
      * Implement the corresponding method of the base class
@@ -80,6 +82,14 @@ protected:
      */
     void run() override;
 
+    /**
+     * Rebuilding the list scans the tables of the worker, it yields
+     * to other commands
+     *
+     * @see WorkerCommand::priority()
+     */
+    Priority priority() const override { return _rebuild ? LOW : NORMAL; }
+
 private:
 
     /**
@@ -97,6 +107,7 @@ private:
 
     bool _rebuild;
     bool _reload;
+    bool _incremental;
 };
 
 /**
@@ -118,15 +129,18 @@ public:
      * @param sendChannel    - communication channel for reporting results
      * @param chunkInventory - transient collection of available chunks to be reloaded (if requested)
      * @param mySqlConfig    - database connection parameters
+     * @param incremental    - only reload the changed databases
      */
     ReloadChunkListCommand(std::shared_ptr<wbase::SendChannel> const& sendChannel,
                            std::shared_ptr<ChunkInventory>     const& chunkInventory,
-                           mysql::MySqlConfig                  const& mySqlConfig)
+                           mysql::MySqlConfig                  const& mySqlConfig,
+                           bool incremental=false)
         :   ChunkListCommand(sendChannel,
                              chunkInventory,
                              mySqlConfig,
                              false,
-                             true) {
+                             true,
+                             incremental) {
         }
 
     /// The destructor
@@ -155,16 +169,19 @@ public:
      * @param chunkInventory - transient collection of available chunks to be reloaded (if requested)
      * @param mySqlConfig    - database connection parameters
      * @param reload         - reload the list in worker's memory
+     * @param incremental    - only rebuild the changed databases
      */
     RebuildChunkListCommand(std::shared_ptr<wbase::SendChannel> const& sendChannel,
                             std::shared_ptr<ChunkInventory>     const& chunkInventory,
                             mysql::MySqlConfig                  const& mySqlConfig,
-                            bool reload)
+                            bool reload,
+                            bool incremental=false)
         :   ChunkListCommand(sendChannel,
                              chunkInventory,
                              mySqlConfig,
                              true,
-                             reload) {
+                             reload,
+                             incremental) {
         }
 
     /// The destructor
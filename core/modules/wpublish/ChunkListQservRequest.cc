@@ -63,9 +63,11 @@ std::string ChunkListQservRequest::status2str(Status status) {
 
 ChunkListQservRequest::ChunkListQservRequest(bool rebuild,
                                              bool reload,
+                                             bool incremental,
                                              CallbackType onFinish)
     :   _rebuild(rebuild),
         _reload(reload),
+        _incremental(incremental),
         _onFinish(onFinish){
 
     LOGS(_log, LOG_LVL_DEBUG, "ChunkListQservRequest  ** CONSTRUCTED **");
@@ -84,6 +86,7 @@ void ChunkListQservRequest::onRequest(proto::FrameBuffer& buf) {
     proto::WorkerCommandUpdateChunkListM message;
     message.set_rebuild(_rebuild);
     message.set_reload(_reload);
+    message.set_incremental(_incremental);
     buf.serialize(message);
 }
 
@@ -157,31 +160,39 @@ void ChunkListQservRequest::onError(std::string const& error) {
 }
 
 ReloadChunkListQservRequest::Ptr ReloadChunkListQservRequest::create(
-                                            ChunkListQservRequest::CallbackType onFinish) {
+                                            ChunkListQservRequest::CallbackType onFinish,
+                                            bool incremental) {
     return ReloadChunkListQservRequest::Ptr(
-        new ReloadChunkListQservRequest(onFinish));
+        new ReloadChunkListQservRequest(onFinish,
+                                        incremental));
 }
 
 ReloadChunkListQservRequest::ReloadChunkListQservRequest(
-                                            ChunkListQservRequest::CallbackType onFinish)
+                                            ChunkListQservRequest::CallbackType onFinish,
+                                            bool incremental)
    :   ChunkListQservRequest(false,
                              true,
+                             incremental,
                              onFinish) {
 }
 
 RebuildChunkListQservRequest::Ptr RebuildChunkListQservRequest::create(
                                             bool reload,
-                                            ChunkListQservRequest::CallbackType onFinish) {
+                                            ChunkListQservRequest::CallbackType onFinish,
+                                            bool incremental) {
     return RebuildChunkListQservRequest::Ptr(
         new RebuildChunkListQservRequest(reload,
-                                         onFinish));
+                                         onFinish,
+                                         incremental));
 }
 
 RebuildChunkListQservRequest::RebuildChunkListQservRequest(
                                             bool reload,
-                                            ChunkListQservRequest::CallbackType onFinish)
+                                            ChunkListQservRequest::CallbackType onFinish,
+                                            bool incremental)
     :   ChunkListQservRequest(true,
                               reload,
+                              incremental,
                               onFinish) {
 }
 
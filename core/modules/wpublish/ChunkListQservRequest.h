@@ -91,11 +91,14 @@ protected:
      *
      * @param rebuild  - rebuild the list from actual database tables
      * @param reload   - reload the list in worker's memory
+     * @param incremental - only rebuild or reload the databases changed since
+     *                      the last incremental update
      * @param onFinish - optional callback function to be called upon the completion
      *                   (successful or not) of the request.
      */
      ChunkListQservRequest(bool rebuild,
                            bool reload,
+                           bool incremental,
                            CallbackType onFinish = nullptr);
 
     /// Implement the corresponding method of the base class
@@ -115,6 +118,9 @@ private:
     /// Reload the list in worker's memory
     bool _reload;
 
+    /// Only rebuild or reload the changed databases
+    bool _incremental;
+
     /// Optional callback function to be called upon the completion
     /// (successfull or not) of the request.
     CallbackType _onFinish;
@@ -140,8 +146,11 @@ public:
      *
      * @param onFinish - optional callback function to be called upon the completion
      *                   (successful or not) of the request.
+     * @param incremental - only reload the databases changed since the last
+     *                      incremental update
      */
-    static Ptr create(CallbackType onFinish = nullptr);
+    static Ptr create(CallbackType onFinish = nullptr,
+                      bool incremental = false);
 
     // Default construction and copy semantics are prohibited
     ReloadChunkListQservRequest() = delete;
@@ -158,8 +167,10 @@ protected:
      *
      * @param onFinish - optional callback function to be called upon the completion
      *                   (successful or not) of the request.
+     * @param incremental - only reload the changed databases
      */
-     ReloadChunkListQservRequest(CallbackType onFinish);
+     ReloadChunkListQservRequest(CallbackType onFinish,
+                                 bool incremental);
 };
 
 /**
@@ -182,9 +193,12 @@ public:
      * @param reload   - reload the list in worker's memory
      * @param onFinish - optional callback function to be called upon the completion
      *                   (successful or not) of the request.
+     * @param incremental - only rebuild the databases changed since the last
+     *                      incremental update
      */
     static Ptr create(bool reload,
-                      CallbackType onFinish = nullptr);
+                      CallbackType onFinish = nullptr,
+                      bool incremental = false);
 
     // Default construction and copy semantics are prohibited
     RebuildChunkListQservRequest() = delete;
@@ -202,9 +216,11 @@ protected:
      * @param reload   - reload the list in worker's memory
      * @param onFinish - optional callback function to be called upon the completion
      *                   (successful or not) of the request.
+     * @param incremental - only rebuild the changed databases
      */
     RebuildChunkListQservRequest(bool reload,
-                                 CallbackType onFinish);
+                                 CallbackType onFinish,
+                                 bool incremental);
 };
 
 }}} // namespace lsst::qserv::wpublish
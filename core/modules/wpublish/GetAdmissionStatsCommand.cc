@@ -0,0 +1,91 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "wpublish/GetAdmissionStatsCommand.h"
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "proto/worker.pb.h"
+#include "wbase/SendChannel.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.wpublish.GetAdmissionStatsCommand");
+
+} // annonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace wpublish {
+
+GetAdmissionStatsCommand::GetAdmissionStatsCommand(std::shared_ptr<wbase::SendChannel> const& sendChannel,
+                                                   wsched::FairShareAdmission::Ptr     const& admission)
+    :   wbase::WorkerCommand(sendChannel),
+        _admission(admission) {
+}
+
+void GetAdmissionStatsCommand::reportError(std::string const& message) {
+
+    LOGS(_log, LOG_LVL_ERROR, "GetAdmissionStatsCommand::run  " << message);
+
+    proto::WorkerCommandGetAdmissionStatsR reply;
+
+    reply.set_status(proto::WorkerCommandGetAdmissionStatsR::ERROR);
+    reply.set_error(message);
+
+    _frameBuf.serialize(reply);
+    std::string str(_frameBuf.data(), _frameBuf.size());
+    _sendChannel->sendStream(xrdsvc::StreamBuffer::createWithMove(str), true);
+}
+
+void GetAdmissionStatsCommand::run() {
+
+    LOGS(_log, LOG_LVL_DEBUG, "GetAdmissionStatsCommand::run");
+
+    if (_admission == nullptr) {
+        reportError("fair-share admission is disabled on this worker");
+        return;
+    }
+
+    proto::WorkerCommandGetAdmissionStatsR reply;
+    reply.set_status(proto::WorkerCommandGetAdmissionStatsR::SUCCESS);
+
+    for (auto const& stats: _admission->getStats()) {
+        proto::WorkerCommandGetAdmissionStatsR::Principal* ptr = reply.add_principals();
+        ptr->set_name(stats.principal);
+        ptr->set_weight(stats.weight);
+        ptr->set_inflight(stats.inFlight);
+        ptr->set_queued(stats.queued);
+        ptr->set_admitted(stats.admitted);
+        ptr->set_rejected(stats.rejected);
+    }
+
+    _frameBuf.serialize(reply);
+    std::string str(_frameBuf.data(), _frameBuf.size());
+    _sendChannel->sendStream(xrdsvc::StreamBuffer::createWithMove(str), true);
+}
+
+}}} // namespace lsst::qserv::wpublish
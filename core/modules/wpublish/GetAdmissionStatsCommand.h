@@ -0,0 +1,96 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/// GetAdmissionStatsCommand.h
+#ifndef LSST_QSERV_WPUBLISH_GET_ADMISSION_STATS_COMMAND_H
+#define LSST_QSERV_WPUBLISH_GET_ADMISSION_STATS_COMMAND_H
+
+// System headers
+#include <memory>
+#include <string>
+
+// Qserv headers
+#include "wbase/WorkerCommand.h"
+#include "wsched/FairShareAdmission.h"
+
+namespace lsst {
+namespace qserv {
+namespace wpublish {
+
+/**
+  * Class GetAdmissionStatsCommand returns the fair-share admission statistics
+  * of each user of a czar
+  */
+class GetAdmissionStatsCommand
+    :   public wbase::WorkerCommand {
+
+public:
+
+    // The default construction and copy semantics are prohibited
+    GetAdmissionStatsCommand() = delete;
+    GetAdmissionStatsCommand& operator=(GetAdmissionStatsCommand const&) = delete;
+    GetAdmissionStatsCommand(GetAdmissionStatsCommand const&) = delete;
+
+    /// The destructor
+    ~GetAdmissionStatsCommand() override = default;
+
+    /**
+     * The normal constructor of the class
+     *
+     * @param sendChannel - communication channel for reporting results
+     * @param admission   - fair-share admission of tasks, null if it is disabled
+     */
+    GetAdmissionStatsCommand(std::shared_ptr<wbase::SendChannel> const& sendChannel,
+                             wsched::FairShareAdmission::Ptr     const& admission);
+
+    /**
+     * Implement the corresponding method of the base class
+     *
+     * @see WorkerCommand::run()
+     */
+    void run() override;
+
+    /**
+     * A lookup of statistics which doesn't wait for other commands
+     *
+     * @see WorkerCommand::priority()
+     */
+    Priority priority() const override { return HIGH; }
+
+private:
+
+    /**
+     * Report error condition to the logging stream and reply back to
+     * a service caller.
+     *
+     * @param message - message to be reported
+     */
+    void reportError(std::string const& message);
+
+private:
+
+    wsched::FairShareAdmission::Ptr _admission;
+};
+
+}}} // namespace lsst::qserv::wpublish
+
+#endif // LSST_QSERV_WPUBLISH_GET_ADMISSION_STATS_COMMAND_H
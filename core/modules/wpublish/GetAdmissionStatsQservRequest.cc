@@ -0,0 +1,135 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "wpublish/GetAdmissionStatsQservRequest.h"
+
+// System headers
+#include <stdexcept>
+#include <string>
+
+// Qserv headers
+#include "lsst/log/Log.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.wpublish.GetAdmissionStatsQservRequest");
+
+using namespace lsst::qserv;
+
+wpublish::GetAdmissionStatsQservRequest::Status translate(
+                                        proto::WorkerCommandGetAdmissionStatsR::Status status) {
+    switch (status) {
+        case proto::WorkerCommandGetAdmissionStatsR::SUCCESS:
+            return wpublish::GetAdmissionStatsQservRequest::SUCCESS;
+        case proto::WorkerCommandGetAdmissionStatsR::ERROR:
+            return wpublish::GetAdmissionStatsQservRequest::ERROR;
+    }
+    throw std::domain_error(
+            "GetAdmissionStatsQservRequest::translate  no match for Protobuf status: " +
+            proto::WorkerCommandGetAdmissionStatsR_Status_Name(status));
+}
+}  // namespace
+
+namespace lsst {
+namespace qserv {
+namespace wpublish {
+
+std::string GetAdmissionStatsQservRequest::status2str(Status status) {
+    switch (status) {
+        case SUCCESS: return "SUCCESS";
+        case ERROR:   return "ERROR";
+    }
+    throw std::domain_error(
+            "GetAdmissionStatsQservRequest::status2str  no match for status: " +
+            std::to_string(status));
+}
+
+GetAdmissionStatsQservRequest::Ptr GetAdmissionStatsQservRequest::create(
+                                        GetAdmissionStatsQservRequest::CallbackType onFinish) {
+    return GetAdmissionStatsQservRequest::Ptr(new GetAdmissionStatsQservRequest(onFinish));
+}
+
+GetAdmissionStatsQservRequest::GetAdmissionStatsQservRequest(
+                                        GetAdmissionStatsQservRequest::CallbackType onFinish)
+    :   _onFinish(onFinish) {
+
+    LOGS(_log, LOG_LVL_DEBUG, "GetAdmissionStatsQservRequest  ** CONSTRUCTED **");
+}
+
+GetAdmissionStatsQservRequest::~GetAdmissionStatsQservRequest() {
+    LOGS(_log, LOG_LVL_DEBUG, "GetAdmissionStatsQservRequest  ** DELETED **");
+}
+
+void GetAdmissionStatsQservRequest::onRequest(proto::FrameBuffer& buf) {
+
+    proto::WorkerCommandH header;
+    header.set_command(proto::WorkerCommandH::GET_ADMISSION_STATS);
+    buf.serialize(header);
+}
+
+void GetAdmissionStatsQservRequest::onResponse(proto::FrameBufferView& view) {
+
+    static std::string const context = "GetAdmissionStatsQservRequest  ";
+
+    proto::WorkerCommandGetAdmissionStatsR reply;
+    view.parse(reply);
+
+    LOGS(_log, LOG_LVL_DEBUG, context << "** SERVICE REPLY **  status: "
+         << proto::WorkerCommandGetAdmissionStatsR_Status_Name(reply.status()));
+
+    PrincipalCollection principals;
+
+    if (reply.status() == proto::WorkerCommandGetAdmissionStatsR::SUCCESS) {
+        for (auto const& entry: reply.principals()) {
+            principals.push_back(Principal{entry.name(), entry.weight(), entry.inflight(),
+                                           entry.queued(), entry.admitted(), entry.rejected()});
+        }
+        LOGS(_log, LOG_LVL_DEBUG, context << "total principals: " << principals.size());
+    }
+    if (nullptr != _onFinish) {
+
+        // Clearing the stored callback before the notification guaranties
+        // (exactly) one time notification and breaks the dependency on a caller
+        // object mentioned in the closure, as in GetChunkListQservRequest.
+
+        auto onFinish = std::move(_onFinish);
+        _onFinish = nullptr;
+        onFinish(::translate(reply.status()),
+                 reply.error(),
+                 principals);
+    }
+}
+
+void GetAdmissionStatsQservRequest::onError(std::string const& error) {
+
+    if (nullptr != _onFinish) {
+        auto onFinish = std::move(_onFinish);
+        _onFinish = nullptr;
+        onFinish(Status::ERROR,
+                 error,
+                 PrincipalCollection());
+    }
+}
+
+}}} // namespace lsst::qserv::wpublish
@@ -74,6 +74,13 @@ public:
      */
     void run() override;
 
+    /**
+     * A lookup which doesn't wait for the commands changing the inventory
+     *
+     * @see WorkerCommand::priority()
+     */
+    Priority priority() const override { return HIGH; }
+
 private:
 
     /**
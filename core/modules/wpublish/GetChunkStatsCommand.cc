@@ -0,0 +1,200 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "wpublish/GetChunkStatsCommand.h"
+
+// System headers
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <tuple>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "proto/worker.pb.h"
+#include "sql/SqlConnection.h"
+#include "wbase/SendChannel.h"
+#include "wpublish/ChunkInventory.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.wpublish.GetChunkStatsCommand");
+
+/// @return 'true' if the name may be put into a query as is
+bool isValidName(std::string const& name) {
+    return not name.empty() and std::all_of(name.begin(), name.end(), [](char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) or c == '_';
+    });
+}
+
+} // annonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace wpublish {
+
+GetChunkStatsCommand::GetChunkStatsCommand(std::shared_ptr<wbase::SendChannel> const& sendChannel,
+                                           std::shared_ptr<ChunkInventory>     const& chunkInventory,
+                                           mysql::MySqlConfig                  const& mySqlConfig,
+                                           QueriesAndChunks::Ptr               const& queries,
+                                           std::vector<std::string>            const& databases,
+                                           uint64_t updatedAfter)
+    :   wbase::WorkerCommand(sendChannel),
+        _chunkInventory(chunkInventory),
+        _mySqlConfig(mySqlConfig),
+        _queries(queries),
+        _databases(databases),
+        _updatedAfter(updatedAfter) {
+}
+
+void GetChunkStatsCommand::reportError(std::string const& message) {
+
+    LOGS(_log, LOG_LVL_ERROR, "GetChunkStatsCommand::run  " << message);
+
+    proto::WorkerCommandGetChunkStatsR reply;
+
+    reply.set_status(proto::WorkerCommandGetChunkStatsR::ERROR);
+    reply.set_error(message);
+
+    _frameBuf.serialize(reply);
+    std::string str(_frameBuf.data(), _frameBuf.size());
+    _sendChannel->sendStream(xrdsvc::StreamBuffer::createWithMove(str), true);
+}
+
+void GetChunkStatsCommand::run() {
+
+    LOGS(_log, LOG_LVL_DEBUG, "GetChunkStatsCommand::run  databases: " << _databases.size()
+         << " updatedAfter: " << _updatedAfter);
+
+    std::set<std::string> dbs(_databases.begin(), _databases.end());
+    if (dbs.empty() and _chunkInventory != nullptr) {
+        for (auto const& entry: _chunkInventory->existMap()) dbs.insert(entry.first);
+    }
+    std::string dbList;
+    for (auto const& db: dbs) {
+        if (not ::isValidName(db)) {
+            reportError("illegal database name: '" + db + "'");
+            return;
+        }
+        if (not dbList.empty()) dbList += ",";
+        dbList += "'" + db + "'";
+    }
+
+    proto::WorkerCommandGetChunkStatsR reply;
+    reply.set_status(proto::WorkerCommandGetChunkStatsR::SUCCESS);
+
+    // The sizes and the completion times of a table end up in the same entry
+    std::map<std::tuple<std::string, std::string, unsigned int>,
+             proto::WorkerCommandGetChunkStatsR::Entry*> entries;
+    auto entryOf = [&reply, &entries](std::string const& db,
+                                      std::string const& table,
+                                      unsigned int chunk) {
+        auto& ptr = entries[std::make_tuple(db, table, chunk)];
+        if (ptr == nullptr) {
+            ptr = reply.add_entries();
+            ptr->set_chunk(chunk);
+            ptr->set_db(db);
+            ptr->set_table(table);
+            ptr->set_has_size(false);
+            ptr->set_num_rows(0);
+            ptr->set_data_size(0);
+            ptr->set_index_size(0);
+            ptr->set_update_time(0);
+            ptr->set_tasks_completed(0);
+            ptr->set_tasks_booted(0);
+            ptr->set_avg_seconds(0);
+            ptr->set_last_seconds(0);
+        }
+        return ptr;
+    };
+
+    // The chunk tables are the ones with the number of a chunk at the end
+    // of their names, and the row counts of MyISAM tables are exact.
+    if (not dbList.empty()) {
+        std::string query =
+            "SELECT TABLE_SCHEMA,TABLE_NAME,IFNULL(TABLE_ROWS,0),IFNULL(DATA_LENGTH,0),"
+            "IFNULL(INDEX_LENGTH,0),IFNULL(UNIX_TIMESTAMP(UPDATE_TIME),0)"
+            "  FROM information_schema.tables"
+            "  WHERE TABLE_SCHEMA IN (" + dbList + ") AND TABLE_NAME REGEXP '_[0-9]+$'";
+        if (_updatedAfter != 0) {
+            query += " AND UPDATE_TIME >= FROM_UNIXTIME(" + std::to_string(_updatedAfter) + ")";
+        }
+        LOGS(_log, LOG_LVL_DEBUG, "GetChunkStatsCommand::run  query: " << query);
+
+        sql::SqlConnection sc(_mySqlConfig, true);
+        std::shared_ptr<sql::SqlResultIter> resultP = sc.getQueryIter(query);
+        if (resultP->getErrorObject().isSet()) {
+            reportError("failed to read the sizes of the tables, error: " +
+                        resultP->getErrorObject().printErrMsg());
+            return;
+        }
+        try {
+            for (; not resultP->done(); ++(*resultP)) {
+                auto const& row = **resultP;
+                std::string const& name = row[1];
+                std::string::size_type const pos = name.rfind('_');
+                auto ptr = entryOf(row[0], name.substr(0, pos), std::stoul(name.substr(pos + 1)));
+                ptr->set_has_size(true);
+                ptr->set_num_rows(std::stoull(row[2]));
+                ptr->set_data_size(std::stoull(row[3]));
+                ptr->set_index_size(std::stoull(row[4]));
+                ptr->set_update_time(std::stoull(row[5]));
+            }
+        } catch (std::exception const& ex) {
+            reportError("failed to parse the sizes of the tables, error: " + std::string(ex.what()));
+            return;
+        }
+    }
+
+    if (_queries == nullptr) {
+        LOGS(_log, LOG_LVL_DEBUG, "GetChunkStatsCommand::run  query statistics are not collected");
+    } else {
+        for (auto const& entry: _queries->getChunkTableStats()) {
+
+            // Tasks with no scan table have no table to report
+            std::string::size_type const pos = entry.scanTableName.find(':');
+            if (entry.chunkId < 0 or pos == std::string::npos) continue;
+
+            std::string const db = entry.scanTableName.substr(0, pos);
+            if (not dbs.empty() and not dbs.count(db)) continue;
+
+            auto ptr = entryOf(db, entry.scanTableName.substr(pos + 1), entry.chunkId);
+            ptr->set_tasks_completed(entry.data.tasksCompleted);
+            ptr->set_tasks_booted(entry.data.tasksBooted);
+            ptr->set_avg_seconds(entry.data.avgCompletionTime * 60);
+            ptr->set_last_seconds(entry.data.lastCompletionTime * 60);
+        }
+    }
+    LOGS(_log, LOG_LVL_DEBUG, "GetChunkStatsCommand::run  entries: " << reply.entries_size());
+
+    _frameBuf.serialize(reply);
+    std::string str(_frameBuf.data(), _frameBuf.size());
+    _sendChannel->sendStream(xrdsvc::StreamBuffer::createWithMove(str), true);
+}
+
+}}} // namespace lsst::qserv::wpublish
@@ -0,0 +1,116 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/// GetChunkStatsCommand.h
+#ifndef LSST_QSERV_WPUBLISH_GET_CHUNK_STATS_COMMAND_H
+#define LSST_QSERV_WPUBLISH_GET_CHUNK_STATS_COMMAND_H
+
+// System headers
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "mysql/MySqlConfig.h"
+#include "wbase/WorkerCommand.h"
+#include "wpublish/QueriesAndChunks.h"
+
+namespace lsst {
+namespace qserv {
+namespace wpublish {
+
+// Forward declarations
+class ChunkInventory;
+
+/**
+  * Class GetChunkStatsCommand returns the sizes of the tables of each chunk,
+  * as reported by the worker database, and the completion times of the tasks
+  * which scanned them, as collected by QueriesAndChunks
+  */
+class GetChunkStatsCommand
+    :   public wbase::WorkerCommand {
+
+public:
+
+    // The default construction and copy semantics are prohibited
+    GetChunkStatsCommand() = delete;
+    GetChunkStatsCommand& operator=(GetChunkStatsCommand const&) = delete;
+    GetChunkStatsCommand(GetChunkStatsCommand const&) = delete;
+
+    /// The destructor
+    ~GetChunkStatsCommand() override = default;
+
+    /**
+     * The normal constructor of the class
+     *
+     * @param sendChannel    - communication channel for reporting results
+     * @param chunkInventory - chunks known to the application
+     * @param mySqlConfig    - database connection parameters
+     * @param queries        - query statistics collector, null if not known
+     * @param databases      - databases of the tables, all published ones if empty
+     * @param updatedAfter   - only report the sizes of the tables modified at
+     *                         or after this time (seconds), of all tables if 0
+     */
+    GetChunkStatsCommand(std::shared_ptr<wbase::SendChannel> const& sendChannel,
+                         std::shared_ptr<ChunkInventory>     const& chunkInventory,
+                         mysql::MySqlConfig                  const& mySqlConfig,
+                         QueriesAndChunks::Ptr               const& queries,
+                         std::vector<std::string>            const& databases,
+                         uint64_t updatedAfter);
+
+    /**
+     * Implement the corresponding method of the base class
+     *
+     * @see WorkerCommand::run()
+     */
+    void run() override;
+
+    /**
+     * A lookup of statistics which doesn't wait for other commands
+     *
+     * @see WorkerCommand::priority()
+     */
+    Priority priority() const override { return HIGH; }
+
+private:
+
+    /**
+     * Report error condition to the logging stream and reply back to
+     * a service caller.
+     *
+     * @param message - message to be reported
+     */
+    void reportError(std::string const& message);
+
+private:
+
+    std::shared_ptr<ChunkInventory> _chunkInventory;
+    mysql::MySqlConfig const        _mySqlConfig;
+    QueriesAndChunks::Ptr           _queries;
+    std::vector<std::string> const  _databases;
+    uint64_t const                  _updatedAfter;
+};
+
+}}} // namespace lsst::qserv::wpublish
+
+#endif // LSST_QSERV_WPUBLISH_GET_CHUNK_STATS_COMMAND_H
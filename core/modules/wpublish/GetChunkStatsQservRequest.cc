@@ -0,0 +1,152 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "wpublish/GetChunkStatsQservRequest.h"
+
+// System headers
+#include <stdexcept>
+#include <string>
+
+// Qserv headers
+#include "lsst/log/Log.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.wpublish.GetChunkStatsQservRequest");
+
+using namespace lsst::qserv;
+
+wpublish::GetChunkStatsQservRequest::Status translate(
+                                        proto::WorkerCommandGetChunkStatsR::Status status) {
+    switch (status) {
+        case proto::WorkerCommandGetChunkStatsR::SUCCESS:
+            return wpublish::GetChunkStatsQservRequest::SUCCESS;
+        case proto::WorkerCommandGetChunkStatsR::ERROR:
+            return wpublish::GetChunkStatsQservRequest::ERROR;
+    }
+    throw std::domain_error(
+            "GetChunkStatsQservRequest::translate  no match for Protobuf status: " +
+            proto::WorkerCommandGetChunkStatsR_Status_Name(status));
+}
+}  // namespace
+
+namespace lsst {
+namespace qserv {
+namespace wpublish {
+
+std::string GetChunkStatsQservRequest::status2str(Status status) {
+    switch (status) {
+        case SUCCESS: return "SUCCESS";
+        case ERROR:   return "ERROR";
+    }
+    throw std::domain_error(
+            "GetChunkStatsQservRequest::status2str  no match for status: " +
+            std::to_string(status));
+}
+
+GetChunkStatsQservRequest::Ptr GetChunkStatsQservRequest::create(
+                                        std::vector<std::string> const& databases,
+                                        uint64_t updatedAfter,
+                                        GetChunkStatsQservRequest::CallbackType onFinish) {
+    return GetChunkStatsQservRequest::Ptr(
+        new GetChunkStatsQservRequest(databases, updatedAfter, onFinish));
+}
+
+GetChunkStatsQservRequest::GetChunkStatsQservRequest(
+                                        std::vector<std::string> const& databases,
+                                        uint64_t updatedAfter,
+                                        GetChunkStatsQservRequest::CallbackType onFinish)
+    :   _databases(databases),
+        _updatedAfter(updatedAfter),
+        _onFinish(onFinish) {
+
+    LOGS(_log, LOG_LVL_DEBUG, "GetChunkStatsQservRequest  ** CONSTRUCTED **");
+}
+
+GetChunkStatsQservRequest::~GetChunkStatsQservRequest() {
+    LOGS(_log, LOG_LVL_DEBUG, "GetChunkStatsQservRequest  ** DELETED **");
+}
+
+void GetChunkStatsQservRequest::onRequest(proto::FrameBuffer& buf) {
+
+    proto::WorkerCommandH header;
+    header.set_command(proto::WorkerCommandH::GET_CHUNK_STATS);
+    buf.serialize(header);
+
+    proto::WorkerCommandGetChunkStatsM message;
+    for (auto const& database: _databases) {
+        message.add_databases(database);
+    }
+    message.set_updated_after(_updatedAfter);
+    buf.serialize(message);
+}
+
+void GetChunkStatsQservRequest::onResponse(proto::FrameBufferView& view) {
+
+    static std::string const context = "GetChunkStatsQservRequest  ";
+
+    proto::WorkerCommandGetChunkStatsR reply;
+    view.parse(reply);
+
+    LOGS(_log, LOG_LVL_DEBUG, context << "** SERVICE REPLY **  status: "
+         << proto::WorkerCommandGetChunkStatsR_Status_Name(reply.status()));
+
+    EntryCollection entries;
+
+    if (reply.status() == proto::WorkerCommandGetChunkStatsR::SUCCESS) {
+        for (auto const& entry: reply.entries()) {
+            entries.push_back(Entry{entry.chunk(), entry.db(), entry.table(),
+                                    entry.has_size(), entry.num_rows(), entry.data_size(),
+                                    entry.index_size(), entry.update_time(),
+                                    entry.tasks_completed(), entry.tasks_booted(),
+                                    entry.avg_seconds(), entry.last_seconds()});
+        }
+        LOGS(_log, LOG_LVL_DEBUG, context << "total entries: " << entries.size());
+    }
+    if (nullptr != _onFinish) {
+
+        // Clearing the stored callback before the notification guaranties
+        // (exactly) one time notification and breaks the dependency on a caller
+        // object mentioned in the closure, as in GetChunkListQservRequest.
+
+        auto onFinish = std::move(_onFinish);
+        _onFinish = nullptr;
+        onFinish(::translate(reply.status()),
+                 reply.error(),
+                 entries);
+    }
+}
+
+void GetChunkStatsQservRequest::onError(std::string const& error) {
+
+    if (nullptr != _onFinish) {
+        auto onFinish = std::move(_onFinish);
+        _onFinish = nullptr;
+        onFinish(Status::ERROR,
+                 error,
+                 EntryCollection());
+    }
+}
+
+}}} // namespace lsst::qserv::wpublish
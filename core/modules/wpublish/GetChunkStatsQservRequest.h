@@ -0,0 +1,146 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/// GetChunkStatsQservRequest.h
+#ifndef LSST_QSERV_WPUBLISH_GET_CHUNK_STATS_QSERV_REQUEST_H
+#define LSST_QSERV_WPUBLISH_GET_CHUNK_STATS_QSERV_REQUEST_H
+
+// System headers
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "wpublish/QservRequest.h"
+
+namespace lsst {
+namespace qserv {
+namespace wpublish {
+
+/**
+  * Class GetChunkStatsQservRequest implements the client-side requests
+  * the Qserv worker services for the sizes of the tables of each chunk and
+  * the completion times of the tasks which scanned them.
+  */
+class GetChunkStatsQservRequest
+    :    public QservRequest {
+
+public:
+
+    /// Completion status of the operation
+    enum Status {
+        SUCCESS,    // successful completion of a request
+        ERROR       // an error occured during command execution
+    };
+
+    /// @return string representation of a status
+    static std::string status2str (Status status);
+
+    /// Struct Entry a value type encapsulating the size of one table of
+    /// one chunk and the completion times of the tasks which scanned it
+    struct Entry {
+        unsigned int chunk;
+        std::string  db;
+        std::string  table;
+        bool         hasSize;       ///< the size was reported
+        uint64_t     numRows;
+        uint64_t     dataSize;      ///< bytes
+        uint64_t     indexSize;     ///< bytes
+        uint64_t     updateTime;    ///< seconds since the UNIX Epoch, 0 if not known
+        uint64_t     tasksCompleted;
+        uint64_t     tasksBooted;
+        double       avgSeconds;    ///< weighted average of the completion times
+        double       lastSeconds;   ///< completion time of the last task
+    };
+
+    /// The EntryCollection type represents a collection of entries
+    using EntryCollection = std::list<Entry>;
+
+    /// The pointer type for instances of the class
+    typedef std::shared_ptr<GetChunkStatsQservRequest> Ptr;
+
+    /// The callback function type to be used for notifications on
+    /// the operation completion.
+    using CallbackType =
+        std::function<void(Status,                          // completion status
+                           std::string const&,              // error message
+                           EntryCollection const&)>;        // entries (if success)
+
+    /**
+     * Static factory method is needed to prevent issues with the lifespan
+     * and memory management of instances created otherwise (as values or via
+     * low-level pointers).
+     *
+     * @param databases    - databases of the tables, all published ones if empty
+     * @param updatedAfter - only report the sizes of the tables modified at or
+     *                       after this time (seconds), of all tables if 0
+     * @param onFinish     - optional callback function to be called upon the completion
+     *                       (successful or not) of the request.
+     * @return smart pointer to the object of the class
+     */
+    static Ptr create(std::vector<std::string> const& databases = std::vector<std::string>(),
+                      uint64_t updatedAfter = 0,
+                      CallbackType onFinish = nullptr);
+
+    // Default construction and copy semantics are prohibited
+    GetChunkStatsQservRequest(GetChunkStatsQservRequest const&) = delete;
+    GetChunkStatsQservRequest& operator=(GetChunkStatsQservRequest const&) = delete;
+
+    /// Destructor
+    ~GetChunkStatsQservRequest() override;
+
+protected:
+
+    /**
+     * Normal constructor
+     *
+     * @see GetChunkStatsQservRequest::create()
+     */
+    GetChunkStatsQservRequest(std::vector<std::string> const& databases,
+                              uint64_t updatedAfter,
+                              CallbackType onFinish);
+
+    /// Implement the corresponding method of the base class
+    void onRequest(proto::FrameBuffer& buf) override;
+
+    /// Implement the corresponding method of the base class
+    void onResponse(proto::FrameBufferView& view) override;
+
+    /// Implement the corresponding method of the base class
+    void onError(std::string const& error) override;
+
+private:
+
+    std::vector<std::string> const _databases;
+    uint64_t const _updatedAfter;
+
+    /// Optional callback function to be called upon the completion
+    /// (successfull or not) of the request.
+    CallbackType _onFinish;
+};
+
+}}} // namespace lsst::qserv::wpublish
+
+#endif // LSST_QSERV_WPUBLISH_GET_CHUNK_STATS_QSERV_REQUEST_H
@@ -23,6 +23,10 @@
 
 // Class header
 #include "wpublish/QueriesAndChunks.h"
+
+// System headers
+#include <algorithm>
+
 // LSST headers
 #include "lsst/log/Log.h"
 
@@ -93,12 +97,13 @@ void QueriesAndChunks::setRequiredTasksCompleted(unsigned int value) {
 /// Add statistics for the Task, creating a QueryStatistics object if needed.
 void QueriesAndChunks::addTask(wbase::Task::Ptr const& task) {
     auto qid = task->getQueryId();
-    std::unique_lock<std::mutex> guardStats(_queryStatsMtx);
-    auto itr = _queryStats.find(qid);
+    QueryShard& shard = _queryShard(qid);
+    std::unique_lock<std::mutex> guardStats(shard.mtx);
+    auto itr = shard.queryStats.find(qid);
     QueryStatistics::Ptr stats;
-    if (_queryStats.end() == itr) {
+    if (shard.queryStats.end() == itr) {
         stats = std::make_shared<QueryStatistics>(qid);
-        _queryStats[qid] = stats;
+        shard.queryStats[qid] = stats;
     } else {
         stats = itr->second;
     }
@@ -114,7 +119,7 @@ void QueriesAndChunks::queuedTask(wbase::Task::Ptr const& task) {
 
     QueryStatistics::Ptr stats = getStats(task->getQueryId());
     if (stats != nullptr) {
-        std::lock_guard<std::mutex>(stats->_qStatsMtx);
+        std::lock_guard<std::mutex> gs(stats->_qStatsMtx);
         stats->_touched = now;
         stats->_size += 1;
     }
@@ -126,9 +131,18 @@ void QueriesAndChunks::startedTask(wbase::Task::Ptr const& task) {
     auto now = std::chrono::system_clock::now();
     task->started(now);
 
-    QueryStatistics::Ptr stats = getStats(task->getQueryId());
+    QueryShard& shard = _queryShard(task->getQueryId());
+    QueryStatistics::Ptr stats;
+    {
+        std::lock_guard<std::mutex> g(shard.mtx);
+        auto iter = shard.queryStats.find(task->getQueryId());
+        if (iter != shard.queryStats.end()) {
+            stats = iter->second;
+            shard.running[task.get()] = task;
+        }
+    }
     if (stats != nullptr) {
-        std::lock_guard<std::mutex>(stats->_qStatsMtx);
+        std::lock_guard<std::mutex> gs(stats->_qStatsMtx);
         stats->_touched = now;
         stats->_tasksRunning += 1;
     }
@@ -142,7 +156,14 @@ void QueriesAndChunks::finishedTask(wbase::Task::Ptr const& task) {
     taskDuration /= 60000.0; // convert to minutes.
 
     QueryId qId = task->getQueryId();
-    QueryStatistics::Ptr stats = getStats(qId);
+    QueryShard& shard = _queryShard(qId);
+    QueryStatistics::Ptr stats;
+    {
+        std::lock_guard<std::mutex> g(shard.mtx);
+        shard.running.erase(task.get());
+        auto iter = shard.queryStats.find(qId);
+        if (iter != shard.queryStats.end()) stats = iter->second;
+    }
     if (stats != nullptr) {
         bool mostlyDead = false;
         {
@@ -151,6 +172,7 @@ void QueriesAndChunks::finishedTask(wbase::Task::Ptr const& task) {
             stats->_tasksRunning -= 1;
             stats->_tasksCompleted += 1;
             stats->_totalTimeMinutes += taskDuration;
+            stats->_usage += task->getUsage();
             mostlyDead = stats->_isMostlyDead();
         }
         if (mostlyDead) {
@@ -165,18 +187,19 @@ void QueriesAndChunks::finishedTask(wbase::Task::Ptr const& task) {
 
 /// Update statistics for the Task that finished and the chunk it was querying.
 void QueriesAndChunks::_finishedTaskForChunk(wbase::Task::Ptr const& task, double minutes) {
-    std::unique_lock<std::mutex> ul(_chunkMtx);
+    ChunkShard& shard = _chunkShard(task->getChunkId());
+    std::unique_lock<std::mutex> ul(shard.mtx);
     std::pair<int, ChunkStatistics::Ptr> ele(task->getChunkId(), nullptr);
-    auto res = _chunkStats.insert(ele);
+    auto res = shard.chunkStats.insert(ele);
     if (res.second) {
         res.first->second = std::make_shared<ChunkStatistics>(task->getChunkId());
     }
-    ul.unlock();
     auto iter = res.first->second;
-    proto::ScanInfo& scanInfo = task->getScanInfo();
+    ul.unlock();
+    proto::ScanInfo const& scanInfo = task->getScanInfo();
     std::string tblName;
     if (!scanInfo.infoTables.empty()) {
-        proto::ScanTableInfo& sti = scanInfo.infoTables.at(0);
+        proto::ScanTableInfo const& sti = scanInfo.infoTables.at(0);
         tblName = ChunkTableStats::makeTableName(sti.db, sti.table);
     }
     ChunkTableStats::Ptr tableStats = iter->add(tblName, minutes);
@@ -225,20 +248,20 @@ void QueriesAndChunks::removeDead() {
 /// Query Ids should be unique for the life of the system, so erasing
 /// a qId multiple times from _queryStats should be harmless.
 void QueriesAndChunks::removeDead(QueryStatistics::Ptr const& queryStats) {
-    std::unique_lock<std::mutex> gS(queryStats->_qStatsMtx);
     QueryId qId = queryStats->_queryId;
-    gS.unlock();
-    LOGS(_log, LOG_LVL_DEBUG, QueryIdHelper::makeIdStr(qId) << " Queries::removeDead");
+    LOGS(_log, LOG_LVL_INFO, "Queries::removeDead " << *queryStats);
 
-    std::lock_guard<std::mutex> gQ(_queryStatsMtx);
-    _queryStats.erase(qId);
+    QueryShard& shard = _queryShard(qId);
+    std::lock_guard<std::mutex> gQ(shard.mtx);
+    shard.queryStats.erase(qId);
 }
 
 /// @return the statistics for a user query.
 QueryStatistics::Ptr QueriesAndChunks::getStats(QueryId const& qId) const {
-    std::lock_guard<std::mutex> g(_queryStatsMtx);
-    auto iter = _queryStats.find(qId);
-    if (iter != _queryStats.end()) {
+    QueryShard const& shard = _queryShard(qId);
+    std::lock_guard<std::mutex> g(shard.mtx);
+    auto iter = shard.queryStats.find(qId);
+    if (iter != shard.queryStats.end()) {
         return iter->second;
     }
     return nullptr;
@@ -252,72 +275,63 @@ void QueriesAndChunks::examineAll() {
     // Need to know how long it takes to complete tasks on each table
     // in each chunk, and their percentage total of the whole.
     auto scanTblSums = _calcScanTableSums();
-
-    // Copy a vector of the Queries in the map and work with the copy
-    // to free up the mutex.
-    std::vector<QueryStatistics::Ptr> uqs;
     {
-        std::lock_guard<std::mutex> g(_queryStatsMtx);
-        for (auto const& ele : _queryStats) {
-            auto const q = ele.second;
-            uqs.push_back(q);
+        std::lock_guard<std::mutex> g(_scanTableSumsMtx);
+        _scanTableSums = scanTblSums;
+    }
+
+    // Copy the running Tasks of each shard, with their user query, and work with
+    // the copy to free up the mutex. Only running Tasks that were not booted yet
+    // are indexed, so this does not depend on the number of queued Tasks.
+    std::vector<std::pair<QueryStatistics::Ptr, wbase::Task::Ptr>> runningTasks;
+    for (auto& shard : _queryShards) {
+        std::lock_guard<std::mutex> g(shard.mtx);
+        for (auto const& ele : shard.running) {
+            auto const& task = ele.second;
+            auto uq = shard.queryStats.find(task->getQueryId());
+            if (uq != shard.queryStats.end() && task->getState() == wbase::Task::State::RUNNING) {
+                runningTasks.emplace_back(uq->second, task);
+            }
         }
     }
 
-    // Go through all Tasks in each query and examine the running ones.
     // If a running Task is taking longer than its percent of total time, boot it.
     // Booting a Task may result in the entire user query it belongs to being moved
     // to the snail scan.
-    for (auto const& uq : uqs) {
-        // Copy all the running tasks that are on ScanSchedulers.
-        std::vector<wbase::Task::Ptr> runningTasks;
-        {
-            std::lock_guard<std::mutex> lock(uq->_qStatsMtx);
-            for (auto const& ele : uq->_taskMap) {
-                auto const& task = ele.second;
-                if (task->getState() == wbase::Task::State::RUNNING) {
-                    auto const& sched = std::dynamic_pointer_cast<wsched::ScanScheduler>(task->getTaskScheduler());
-                    if (sched != nullptr) {
-                        runningTasks.push_back(task);
-                    }
-                }
-            }
+    for (auto const& elem : runningTasks) {
+        auto const& uq = elem.first;
+        auto const& task = elem.second;
+        auto const& sched = std::dynamic_pointer_cast<wsched::ScanScheduler>(task->getTaskScheduler());
+        if (sched == nullptr) {
+            continue;
         }
-
-        // For each running task, check if it is taking too long, or if the query is taking too long.
-        for (auto const& task : runningTasks) {
-            auto const& sched = std::dynamic_pointer_cast<wsched::ScanScheduler>(task->getTaskScheduler());
-            if (sched == nullptr) {
-                continue;
-            }
-            double schedMaxTime = sched->getMaxTimeMinutes(); // Get max time for scheduler
-            // Get the slowest scan table in task.
-            auto begin = task->getScanInfo().infoTables.begin();
-            if (begin == task->getScanInfo().infoTables.end()) {
-                continue;
-            }
-            std::string const& slowestTable = begin->db + ":" + begin->table;
-            auto iterTbl = scanTblSums.find(slowestTable);
-            if (iterTbl != scanTblSums.end()) {
-                LOGS(_log, LOG_LVL_DEBUG, "examineAll " << slowestTable
-                                       << " chunkId=" << task->getChunkId());
-                ScanTableSums& tblSums = iterTbl->second;
-                auto iterChunk = tblSums.chunkPercentages.find(task->getChunkId());
-                if (iterChunk != tblSums.chunkPercentages.end()) {
-                    // We can only make the check if there's data on past chunks/tables.
-                    double percent = iterChunk->second.percent;
-                    bool valid = iterChunk->second.valid;
-                    double maxTimeChunk = percent * schedMaxTime;
-                    auto runTimeMilli = task->getRunTime();
-                    double runTimeMinutes = (double)runTimeMilli.count()/60000.0;
-                    bool booting = runTimeMinutes > maxTimeChunk && valid;
-                    auto lvl = booting ? LOG_LVL_INFO : LOG_LVL_DEBUG;
-                    LOGS(_log, lvl, "examineAll " << (booting ? "booting" : "keeping") << " task " << task->getIdStr()
-                            << "maxTimeChunk(" << maxTimeChunk << ")=percent(" << percent << ")*schedMaxTime(" << schedMaxTime << ")"
-                            << " runTimeMinutes=" << runTimeMinutes << " valid=" << valid);
-                    if (booting) {
-                        _bootTask(uq, task, sched);
-                    }
+        double schedMaxTime = sched->getMaxTimeMinutes(); // Get max time for scheduler
+        // Get the slowest scan table in task.
+        auto begin = task->getScanInfo().infoTables.begin();
+        if (begin == task->getScanInfo().infoTables.end()) {
+            continue;
+        }
+        std::string const& slowestTable = begin->db + ":" + begin->table;
+        auto iterTbl = scanTblSums.find(slowestTable);
+        if (iterTbl != scanTblSums.end()) {
+            LOGS(_log, LOG_LVL_DEBUG, "examineAll " << slowestTable
+                                   << " chunkId=" << task->getChunkId());
+            ScanTableSums& tblSums = iterTbl->second;
+            auto iterChunk = tblSums.chunkPercentages.find(task->getChunkId());
+            if (iterChunk != tblSums.chunkPercentages.end()) {
+                // We can only make the check if there's data on past chunks/tables.
+                double percent = iterChunk->second.percent;
+                bool valid = iterChunk->second.valid;
+                double maxTimeChunk = percent * schedMaxTime;
+                auto runTimeMilli = task->getRunTime();
+                double runTimeMinutes = (double)runTimeMilli.count()/60000.0;
+                bool booting = runTimeMinutes > maxTimeChunk && valid;
+                auto lvl = booting ? LOG_LVL_INFO : LOG_LVL_DEBUG;
+                LOGS(_log, lvl, "examineAll " << (booting ? "booting" : "keeping") << " task " << task->getIdStr()
+                        << "maxTimeChunk(" << maxTimeChunk << ")=percent(" << percent << ")*schedMaxTime(" << schedMaxTime << ")"
+                        << " runTimeMinutes=" << runTimeMinutes << " valid=" << valid);
+                if (booting) {
+                    _bootTask(uq, task, sched);
                 }
             }
         }
@@ -326,6 +340,29 @@ void QueriesAndChunks::examineAll() {
 }
 
 
+std::vector<QueriesAndChunks::ChunkTableEntry> QueriesAndChunks::getChunkTableStats() const {
+    std::vector<ChunkStatistics::Ptr> chks;
+    for (auto const& shard : _chunkShards) {
+        std::lock_guard<std::mutex> g(shard.mtx);
+        for (auto const& ele : shard.chunkStats) {
+            chks.push_back(ele.second);
+        }
+    }
+    std::sort(chks.begin(), chks.end(), [](ChunkStatistics::Ptr const& a, ChunkStatistics::Ptr const& b) {
+        return a->_chunkId < b->_chunkId;
+    });
+
+    std::vector<ChunkTableEntry> entries;
+    for (auto const& chunkStats : chks) {
+        std::lock_guard<std::mutex> lock(chunkStats->_tStatsMtx);
+        for (auto const& ele : chunkStats->_tableStats) {
+            entries.push_back(ChunkTableEntry{chunkStats->_chunkId, ele.first, ele.second->getData()});
+        }
+    }
+    return entries;
+}
+
+
 /// @return a map that contains time totals for all chunks for tasks running on specific
 /// tables. The map is sorted by table name and contains sub-maps ordered by chunk id.
 /// The sub-maps contain information about how long tasks take to complete on that table
@@ -335,9 +372,9 @@ void QueriesAndChunks::examineAll() {
 QueriesAndChunks::ScanTableSumsMap QueriesAndChunks::_calcScanTableSums() {
     // Copy a vector of all the chunks in the map;
     std::vector<ChunkStatistics::Ptr> chks;
-    {
-        std::lock_guard<std::mutex> g(_chunkMtx);
-        for (auto const& ele : _chunkStats) {
+    for (auto const& shard : _chunkShards) {
+        std::lock_guard<std::mutex> g(shard.mtx);
+        for (auto const& ele : shard.chunkStats) {
             auto const& chk = ele.second;
             chks.push_back(chk);
         }
@@ -356,6 +393,7 @@ QueriesAndChunks::ScanTableSumsMap QueriesAndChunks::_calcScanTableSums() {
                 ChunkTimePercent& ctp = sTSums.chunkPercentages[chunkId];
                 ctp.shardTime = data.avgCompletionTime;
                 ctp.valid = data.tasksCompleted >= _requiredTasksCompleted;
+                if (ctp.valid) ++sTSums.validChunks;
             }
         }
     }
@@ -373,6 +411,57 @@ QueriesAndChunks::ScanTableSumsMap QueriesAndChunks::_calcScanTableSums() {
 }
 
 
+double QueriesAndChunks::predictScanMinutes(std::string const& tblName) const {
+    std::lock_guard<std::mutex> g(_scanTableSumsMtx);
+    auto iter = _scanTableSums.find(tblName);
+    if (iter == _scanTableSums.end()) {
+        return -1.0;
+    }
+    auto const& sums = iter->second;
+    if (sums.validChunks == 0 || 2*sums.validChunks < static_cast<int>(sums.chunkPercentages.size())) {
+        return -1.0;
+    }
+    return sums.totalTime;
+}
+
+
+double QueriesAndChunks::predictTaskMinutes(wbase::Task::Ptr const& task) {
+    QueryStatistics::Ptr stats = getStats(task->getQueryId());
+    if (stats != nullptr) {
+        std::lock_guard<std::mutex> g(stats->_qStatsMtx);
+        if (stats->_tasksCompleted > 0
+            && static_cast<unsigned int>(stats->_tasksCompleted) >= _requiredTasksCompleted) {
+            return stats->_totalTimeMinutes / stats->_tasksCompleted;
+        }
+    }
+
+    auto const& infoTables = task->getScanInfo().infoTables;
+    if (infoTables.empty()) {
+        return -1.0;
+    }
+    ChunkStatistics::Ptr chunkStats;
+    {
+        ChunkShard& shard = _chunkShard(task->getChunkId());
+        std::lock_guard<std::mutex> g(shard.mtx);
+        auto iter = shard.chunkStats.find(task->getChunkId());
+        if (iter == shard.chunkStats.end()) {
+            return -1.0;
+        }
+        chunkStats = iter->second;
+    }
+    auto tableStats = chunkStats->getStats(
+        ChunkTableStats::makeTableName(infoTables.front().db, infoTables.front().table));
+    if (tableStats == nullptr) {
+        return -1.0;
+    }
+    auto data = tableStats->getData();
+    if (data.tasksCompleted < _requiredTasksCompleted) {
+        return -1.0;
+    }
+    return data.avgCompletionTime;
+}
+
+
 /// Remove the running 'task' from a scheduler and possibly move all Tasks that belong to its user query
 /// to the snail scheduler. 'task' continues to run in its thread, but the scheduler is told 'task' is
 /// finished, which allows the scheduler to move on to another Task.
@@ -382,7 +471,16 @@ void QueriesAndChunks::_bootTask(QueryStatistics::Ptr const& uq, wbase::Task::Pt
                                      wsched::SchedulerBase::Ptr const& sched) {
     LOGS(_log, LOG_LVL_INFO, task->getIdStr() << " taking too long, booting from " << sched->getName());
     sched->removeTask(task, true);
-    uq->_tasksBooted += 1;
+    {
+        // A booted Task is not examined again.
+        QueryShard& shard = _queryShard(task->getQueryId());
+        std::lock_guard<std::mutex> g(shard.mtx);
+        shard.running.erase(task.get());
+    }
+    {
+        std::lock_guard<std::mutex> g(uq->_qStatsMtx);
+        uq->_tasksBooted += 1;
+    }
 
     auto bSched = _blendSched.lock();
     if (bSched == nullptr) {
@@ -425,6 +523,12 @@ int QueryStatistics::getTasksBooted() {
 }
 
 
+wbase::TaskUsage QueryStatistics::getUsage() const {
+    std::lock_guard<std::mutex> guard(_qStatsMtx);
+    return _usage;
+}
+
+
 /// @return true if this query is done and has not been touched for deadTime.
 bool QueryStatistics::isDead(std::chrono::seconds deadTime, std::chrono::system_clock::time_point now) {
     std::lock_guard<std::mutex> guard(_qStatsMtx);
@@ -450,7 +554,11 @@ std::ostream& operator<<(std::ostream& os, QueryStatistics const& q) {
        << " size="           << q._size
        << " tasksCompleted=" << q._tasksCompleted
        << " tasksRunning="   << q._tasksRunning
-       << " tasksBooted="    << q._tasksBooted;
+       << " tasksBooted="    << q._tasksBooted
+       << " cpuUs="          << q._usage.cpuUs
+       << " rowsRead="       << q._usage.rowsRead
+       << " bytesTransmitted=" << q._usage.bytesTransmitted
+       << " memLockedBytes=" << q._usage.memLockedBytes;
     return os;
 }
 
@@ -466,21 +574,18 @@ QueriesAndChunks::removeQueryFrom(QueryId const& qId, wsched::SchedulerBase::Ptr
     std::vector<wbase::Task::Ptr> removedList; // Return value;
 
     // Find the user query.
-    std::unique_lock<std::mutex> lock(_queryStatsMtx);
-    auto query = _queryStats.find(qId);
-    if (query == _queryStats.end()) {
+    QueryStatistics::Ptr query = getStats(qId);
+    if (query == nullptr) {
         LOGS(_log, LOG_LVL_DEBUG, QueryIdHelper::makeIdStr(qId) << " was not found by removeQueryFrom");
         return removedList;
     }
-    lock.unlock();
 
     // Remove Tasks from their scheduler put them on 'removedList', but only if their Scheduler is the same
     // as 'sched' or if sched == nullptr.
-    auto& taskMap = query->second->_taskMap;
     std::vector<wbase::Task::Ptr> taskList;
     {
-        std::lock_guard<std::mutex> taskLock(query->second->_qStatsMtx);
-        for (auto const& elem : taskMap) {
+        std::lock_guard<std::mutex> taskLock(query->_qStatsMtx);
+        for (auto const& elem : query->_taskMap) {
             taskList.push_back(elem.second);
         }
     }
@@ -513,11 +618,40 @@ QueriesAndChunks::removeQueryFrom(QueryId const& qId, wsched::SchedulerBase::Ptr
 }
 
 
+int QueriesAndChunks::cancelQuery(QueryId qId) {
+    QueryStatistics::Ptr query = getStats(qId);
+    if (query == nullptr) {
+        LOGS(_log, LOG_LVL_DEBUG, QueryIdHelper::makeIdStr(qId) << " was not found by cancelQuery");
+        return 0;
+    }
+    std::vector<wbase::Task::Ptr> taskList;
+    {
+        std::lock_guard<std::mutex> taskLock(query->_qStatsMtx);
+        for (auto const& elem : query->_taskMap) {
+            taskList.push_back(elem.second);
+        }
+    }
+    // Task::cancel() may kill a MySQL statement, _qStatsMtx must not be held.
+    int count = 0;
+    for (auto const& task : taskList) {
+        if (!task->getCancelled()) {
+            task->cancel();
+            ++count;
+        }
+    }
+    LOGS(_log, LOG_LVL_INFO, QueryIdHelper::makeIdStr(qId) << " cancelQuery cancelled " << count
+         << " of " << taskList.size() << " Tasks");
+    return count;
+}
+
+
 std::ostream& operator<<(std::ostream& os, QueriesAndChunks const& qc) {
-    std::lock_guard<std::mutex> g(qc._chunkMtx);
     os << "Chunks(";
-    for (auto const& ele : qc._chunkStats) {
-        os << *(ele.second) << ";";
+    for (auto const& shard : qc._chunkShards) {
+        std::lock_guard<std::mutex> g(shard.mtx);
+        for (auto const& ele : shard.chunkStats) {
+            os << *(ele.second) << ";";
+        }
     }
     os << ")";
     return os;
@@ -567,6 +701,7 @@ std::ostream& operator<<(std::ostream& os, ChunkStatistics const& cs) {
 void ChunkTableStats::addTaskFinished(double minutes) {
     std::lock_guard<std::mutex> g(_dataMtx);
     ++_data.tasksCompleted;
+    _data.lastCompletionTime = minutes;
     if (_data.tasksCompleted > 1) {
         _data.avgCompletionTime = (_data.avgCompletionTime*_weightAvg + minutes*_weightNew)/_weightSum;
     } else {
@@ -25,6 +25,9 @@
 #define LSST_QSERV_WPUBLISH_QUERIESANDCHUNKS_H
 
 // System headers
+#include <array>
+#include <unordered_map>
+#include <vector>
 
 // Qserv headers
 #include "wbase/Task.h"
@@ -60,6 +63,9 @@ public:
     int getTasksBooted();
     bool getQueryBooted() { return _queryBooted; }
 
+    /// @return the resources used by the finished tasks of the query.
+    wbase::TaskUsage getUsage() const;
+
     friend class QueriesAndChunks;
     friend std::ostream& operator<<(std::ostream& os, QueryStatistics const& q);
 
@@ -77,6 +83,7 @@ private:
     std::atomic<bool> _queryBooted{false}; ///< True when the entire query booted.
 
     double _totalTimeMinutes{0.0};
+    wbase::TaskUsage _usage; ///< Sum of the resources used by finished tasks.
 
     std::map<int, wbase::Task::Ptr> _taskMap; ///< Map of Tasks keyed by job id.
 };
@@ -94,6 +101,7 @@ public:
         std::uint64_t tasksCompleted{0}; ///< Number of Tasks that have completed on this chunk/table.
         std::uint64_t tasksBooted{0}; ///< Number of Tasks that have been booted for taking too long.
         double avgCompletionTime{0.0}; ///< weighted average of completion time in minutes.
+        double lastCompletionTime{0.0}; ///< completion time in minutes of the last Task.
     };
 
     static std::string makeTableName(std::string const& db, std::string const& table) {
@@ -157,6 +165,10 @@ public:
 
     std::vector<wbase::Task::Ptr> removeQueryFrom(QueryId const& qId,
                    std::shared_ptr<wsched::SchedulerBase> const& sched);
+    /// Cancel all the Tasks of the user query 'qId'. Running ones have their
+    /// MySQL statement killed, see wbase::Task::cancel().
+    /// @return the number of Tasks that were not already cancelled.
+    int cancelQuery(QueryId qId);
     void removeDead();
     void removeDead(QueryStatistics::Ptr const& queryStats);
 
@@ -169,6 +181,27 @@ public:
 
     void examineAll();
 
+    /// @return the minutes one thread took to scan 'tblName' on all chunks of this
+    ///         worker, as of the last examineAll(), or -1 if most chunks have too
+    ///         few completed tasks to tell.
+    double predictScanMinutes(std::string const& tblName) const;
+
+    /// @return the minutes 'task' is expected to take, from the average of the
+    ///         tasks of its user query or else of the tasks on its chunk and
+    ///         slowest table, or -1 if neither has enough completed tasks.
+    double predictTaskMinutes(wbase::Task::Ptr const& task);
+
+    /// The statistics of the Tasks of one scan table on one chunk.
+    struct ChunkTableEntry {
+        int chunkId;
+        std::string scanTableName; ///< "<db>:<table>", see ChunkTableStats::makeTableName()
+        ChunkTableStats::Data data;
+    };
+
+    /// @return a copy of the statistics of every chunk and scan table which had
+    ///         a Task completed, ordered by chunk id.
+    std::vector<ChunkTableEntry> getChunkTableStats() const;
+
     // Figure out each chunkTable's percentage of time.
     // Store average time for a task to run on this table for this chunk.
     struct ChunkTimePercent {
@@ -179,6 +212,7 @@ public:
     // Store the time to scan entire table with time for each chunk within that table.
     struct ScanTableSums {
         double totalTime{0.0};
+        int validChunks{0}; ///< Number of chunks with enough completed tasks.
         std::map<int, ChunkTimePercent> chunkPercentages;
     };
     using ScanTableSumsMap = std::map<std::string, ScanTableSums>;
@@ -186,16 +220,36 @@ public:
     friend std::ostream& operator<<(std::ostream& os, QueriesAndChunks const& qc);
 
 private:
+    /// The user queries are spread over shards by QueryId, and the chunks by chunk id,
+    /// so that tasks of different queries and chunks do not wait on the same mutex.
+    static unsigned int const _shardCount = 16;
+
+    struct QueryShard {
+        mutable std::mutex mtx; ///< protects members below.
+        std::map<QueryId, QueryStatistics::Ptr> queryStats; ///< Query stats indexed by QueryId.
+        /// Running Tasks that were not booted, so examineAll() only looks at these.
+        std::unordered_map<wbase::Task*, wbase::Task::Ptr> running;
+    };
+
+    struct ChunkShard {
+        mutable std::mutex mtx; ///< protects chunkStats.
+        std::map<int, ChunkStatistics::Ptr> chunkStats; ///< Chunk stats indexed by chunk id.
+    };
+
+    QueryShard& _queryShard(QueryId qId) { return _queryShards[qId % _shardCount]; }
+    QueryShard const& _queryShard(QueryId qId) const { return _queryShards[qId % _shardCount]; }
+    ChunkShard& _chunkShard(int chunkId) { return _chunkShards[static_cast<unsigned int>(chunkId) % _shardCount]; }
+
     void _bootTask(QueryStatistics::Ptr const& uq, wbase::Task::Ptr const& task,
                        std::shared_ptr<wsched::SchedulerBase> const& sched);
     ScanTableSumsMap _calcScanTableSums();
     void _finishedTaskForChunk(wbase::Task::Ptr const& task, double minutes);
 
-    mutable std::mutex _queryStatsMtx; ///< protects _queryStats;
-    std::map<QueryId, QueryStatistics::Ptr> _queryStats; ///< Map of Query stats indexed by QueryId.
+    std::array<QueryShard, _shardCount> _queryShards;
+    std::array<ChunkShard, _shardCount> _chunkShards;
 
-    mutable std::mutex _chunkMtx;
-    std::map<int, ChunkStatistics::Ptr> _chunkStats;///< Map of Chunk stats indexed by chunk id.
+    mutable std::mutex _scanTableSumsMtx; ///< Protects _scanTableSums.
+    ScanTableSumsMap _scanTableSums; ///< Scan times computed by the last examineAll().
 
     std::weak_ptr<wsched::BlendScheduler> _blendSched; ///< Pointer to the BlendScheduler.
 
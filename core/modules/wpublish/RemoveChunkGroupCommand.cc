@@ -128,6 +128,7 @@ void RemoveChunkGroupCommand::run() {
 
             // Notify QServ and update the database
             _chunkInventory->remove(db, _chunk, _mySqlConfig);
+            _chunkInventory->markChanged(db);
 
         } catch (InvalidParamError const& ex) {
             reportError(proto::WorkerCommandChunkGroupR::INVALID, ex.what());
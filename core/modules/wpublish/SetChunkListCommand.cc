@@ -65,7 +65,28 @@ SetChunkListCommand::SetChunkListCommand(std::shared_ptr<wbase::SendChannel>
         _resourceMonitor(resourceMonitor),
         _mySqlConfig(mySqlConfig),
         _chunks(chunks),
-        _force(force) {
+        _force(force),
+        _diff(false),
+        _baseRevision(0) {
+}
+
+SetChunkListCommand::SetChunkListCommand(std::shared_ptr<wbase::SendChannel>     const& sendChannel,
+                                         std::shared_ptr<ChunkInventory>         const& chunkInventory,
+                                         std::shared_ptr<ResourceMonitor>        const& resourceMonitor,
+                                         mysql::MySqlConfig                      const& mySqlConfig,
+                                         std::vector<SetChunkListCommand::Chunk> const& addedChunks,
+                                         std::vector<SetChunkListCommand::Chunk> const& removedChunks,
+                                         std::uint64_t baseRevision,
+                                         bool force)
+    :   wbase::WorkerCommand(sendChannel),
+        _chunkInventory(chunkInventory),
+        _resourceMonitor(resourceMonitor),
+        _mySqlConfig(mySqlConfig),
+        _chunks(addedChunks),
+        _force(force),
+        _diff(true),
+        _removedChunks(removedChunks),
+        _baseRevision(baseRevision) {
 }
 
 void SetChunkListCommand::setChunks(proto::WorkerCommandSetChunkListR& reply,
@@ -93,6 +114,7 @@ void SetChunkListCommand::reportError(proto::WorkerCommandSetChunkListR::Status
 
     reply.set_status(status);
     reply.set_error(message);
+    reply.set_revision(_chunkInventory->revision());
     setChunks(reply, prevExistMap);
 
     _frameBuf.serialize(reply);
@@ -105,21 +127,49 @@ void SetChunkListCommand::run() {
 
     LOGS(_log, LOG_LVL_DEBUG, "SetChunkListCommand::run");
 
-    // Store the current collection of chnuks
-    ChunkInventory::ExistMap const prevExistMap = _chunkInventory->existMap();
+    // Store the current collection of chnuks. The caller of the 'diff' mode
+    // already knows it, hence it's not sent back.
+    ChunkInventory::ExistMap const prevExistMap =
+        _diff ? ChunkInventory::ExistMap() : _chunkInventory->existMap();
 
-    // Build a temporary object representing a desired chunk list and
-    // compare it with the present one.
-    ChunkInventory::ExistMap newExistMap;
-    for (Chunk const& chunkEntry: _chunks) {
-        newExistMap[chunkEntry.database].insert(chunkEntry.chunk);
-    }
-    ChunkInventory const newChunkInventory(newExistMap,
-                                           _chunkInventory->name(),
-                                           _chunkInventory->id());
+    ChunkInventory::ExistMap toBeRemovedExistMap;
+    ChunkInventory::ExistMap toBeAddedExistMap;
+
+    if (_diff) {
 
-    ChunkInventory::ExistMap const toBeRemovedExistMap =  *_chunkInventory - newChunkInventory;
-    ChunkInventory::ExistMap const toBeAddedExistMap   = newChunkInventory -  *_chunkInventory;
+        // The diff is meaningless if the inventory was changed by anyone else.
+        // Only the chunks which would change the inventory are considered.
+        if (_chunkInventory->revision() != _baseRevision) {
+            reportError(proto::WorkerCommandSetChunkListR::STALE,
+                        "the inventory has changed since revision " + std::to_string(_baseRevision),
+                        prevExistMap);
+            return;
+        }
+        for (Chunk const& chunkEntry: _removedChunks) {
+            if (_chunkInventory->has(chunkEntry.database, chunkEntry.chunk)) {
+                toBeRemovedExistMap[chunkEntry.database].insert(chunkEntry.chunk);
+            }
+        }
+        for (Chunk const& chunkEntry: _chunks) {
+            if (not _chunkInventory->has(chunkEntry.database, chunkEntry.chunk)) {
+                toBeAddedExistMap[chunkEntry.database].insert(chunkEntry.chunk);
+            }
+        }
+    } else {
+
+        // Build a temporary object representing a desired chunk list and
+        // compare it with the present one.
+        ChunkInventory::ExistMap newExistMap;
+        for (Chunk const& chunkEntry: _chunks) {
+            newExistMap[chunkEntry.database].insert(chunkEntry.chunk);
+        }
+        ChunkInventory const newChunkInventory(newExistMap,
+                                               _chunkInventory->name(),
+                                               _chunkInventory->id());
+
+        toBeRemovedExistMap =  *_chunkInventory - newChunkInventory;
+        toBeAddedExistMap   = newChunkInventory -  *_chunkInventory;
+    }
 
     // Make sure none of the chunks in the 'to be removed' group is not being used
     // unless in the 'force' mode
@@ -224,6 +274,7 @@ void SetChunkListCommand::run() {
     // Send back a reply
     proto::WorkerCommandSetChunkListR reply;
     reply.set_status(proto::WorkerCommandSetChunkListR::SUCCESS);
+    reply.set_revision(_chunkInventory->revision());
     setChunks(reply, prevExistMap);
 
     _frameBuf.serialize(reply);
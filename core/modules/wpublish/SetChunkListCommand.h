@@ -25,6 +25,7 @@
 #define LSST_QSERV_WPUBLISH_SET_CHUNK_LIST_COMMAND_H
 
 // System headers
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -50,7 +51,8 @@ namespace wpublish {
 class ResourceMonitor;
 
 /**
-  * Class SetChunkListCommand sets a new list of chunks
+  * Class SetChunkListCommand sets a new list of chunks, or adds and removes
+  * chunks from the current list in the 'diff' mode.
   */
 class SetChunkListCommand
     :   public wbase::WorkerCommand {
@@ -85,6 +87,28 @@ public:
                         std::vector<Chunk>                  const& chunks,
                         bool                                       force);
 
+    /**
+     * The constructor for the 'diff' mode. The diff is rejected with
+     * status STALE if the revision of the inventory isn't 'baseRevision'.
+     *
+     * @param sendChannel     - communication channel for reporting results
+     * @param chunkInventory  - chunks known to the application
+     * @param resourceMonitor - counters of resources which are being used
+     * @param mySqlConfig     - database connection parameters
+     * @param addedChunks     - chunks to be added to the current collection
+     * @param removedChunks   - chunks to be removed from the current collection
+     * @param baseRevision    - revision of the inventory the diff was made against
+     * @param force           - force chunks removal even if chunks are in use
+     */
+    SetChunkListCommand(std::shared_ptr<wbase::SendChannel> const& sendChannel,
+                        std::shared_ptr<ChunkInventory>     const& chunkInventory,
+                        std::shared_ptr<ResourceMonitor>    const& resourceMonitor,
+                        mysql::MySqlConfig                  const& mySqlConfig,
+                        std::vector<Chunk>                  const& addedChunks,
+                        std::vector<Chunk>                  const& removedChunks,
+                        std::uint64_t                              baseRevision,
+                        bool                                       force);
+
     /// The destructor
     ~SetChunkListCommand() override = default;
 
@@ -124,6 +148,12 @@ private:
     mysql::MySqlConfig _mySqlConfig;
     std::vector<Chunk> _chunks;
     bool _force;
+
+    // Parameters of the 'diff' mode
+
+    bool _diff;
+    std::vector<Chunk> _removedChunks;
+    std::uint64_t _baseRevision;
 };
 
 }}} // namespace lsst::qserv::wpublish
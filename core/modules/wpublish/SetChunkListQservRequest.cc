@@ -42,6 +42,7 @@ wpublish::SetChunkListQservRequest::Status translate(proto::WorkerCommandSetChun
         case proto::WorkerCommandSetChunkListR::INVALID: return wpublish::SetChunkListQservRequest::INVALID;
         case proto::WorkerCommandSetChunkListR::IN_USE:  return wpublish::SetChunkListQservRequest::IN_USE;
         case proto::WorkerCommandSetChunkListR::ERROR:   return wpublish::SetChunkListQservRequest::ERROR;
+        case proto::WorkerCommandSetChunkListR::STALE:   return wpublish::SetChunkListQservRequest::STALE;
     }
     throw std::domain_error(
             "SetChunkListQservRequest::translate  no match for Protobuf status: " +
@@ -59,6 +60,7 @@ std::string SetChunkListQservRequest::status2str(Status status) {
         case INVALID: return "INVALID";
         case IN_USE:  return "IN_USE";
         case ERROR:   return "ERROR";
+        case STALE:   return "STALE";
     }
     throw std::domain_error(
             "SetChunkListQservRequest::status2str  no match for status: " +
@@ -74,12 +76,48 @@ SetChunkListQservRequest::Ptr SetChunkListQservRequest::create(
         onFinish
     ));
                                 }
+
+SetChunkListQservRequest::Ptr SetChunkListQservRequest::createDiff(
+                                SetChunkListQservRequest::ChunkCollection const& addedChunks,
+                                SetChunkListQservRequest::ChunkCollection const& removedChunks,
+                                std::uint64_t baseRevision,
+                                bool force,
+                                SetChunkListQservRequest::CallbackType onFinish) {
+    return SetChunkListQservRequest::Ptr(new SetChunkListQservRequest(
+        addedChunks,
+        removedChunks,
+        baseRevision,
+        force,
+        onFinish
+    ));
+}
+
 SetChunkListQservRequest::SetChunkListQservRequest(
                                 SetChunkListQservRequest::ChunkCollection const& chunks,
                                 bool force,
                                 SetChunkListQservRequest::CallbackType onFinish)
     :   _chunks(chunks),
         _force(force),
+        _diff(false),
+        _baseRevision(0),
+        _revision(0),
+        _onFinish(onFinish) {
+
+    LOGS(_log, LOG_LVL_DEBUG, "SetChunkListQservRequest  ** CONSTRUCTED **");
+}
+
+SetChunkListQservRequest::SetChunkListQservRequest(
+                                SetChunkListQservRequest::ChunkCollection const& addedChunks,
+                                SetChunkListQservRequest::ChunkCollection const& removedChunks,
+                                std::uint64_t baseRevision,
+                                bool force,
+                                SetChunkListQservRequest::CallbackType onFinish)
+    :   _chunks(addedChunks),
+        _force(force),
+        _diff(true),
+        _removedChunks(removedChunks),
+        _baseRevision(baseRevision),
+        _revision(0),
         _onFinish(onFinish) {
 
     LOGS(_log, LOG_LVL_DEBUG, "SetChunkListQservRequest  ** CONSTRUCTED **");
@@ -102,6 +140,15 @@ void SetChunkListQservRequest::onRequest(proto::FrameBuffer& buf) {
         ptr->set_chunk(chunkEntry.chunk);
     }
     message.set_force(_force);
+    if (_diff) {
+        for(auto const& chunkEntry: _removedChunks) {
+            proto::WorkerCommandChunk* ptr = message.add_removed();
+            ptr->set_db(chunkEntry.database);
+            ptr->set_chunk(chunkEntry.chunk);
+        }
+        message.set_diff(true);
+        message.set_base_revision(_baseRevision);
+    }
     buf.serialize(message);
 }
 
@@ -113,7 +160,10 @@ void SetChunkListQservRequest::onResponse(proto::FrameBufferView& view) {
     view.parse(reply);
 
     LOGS(_log, LOG_LVL_DEBUG, context << "** SERVICE REPLY **  status: "
-         << proto::WorkerCommandSetChunkListR_Status_Name(reply.status()));
+         << proto::WorkerCommandSetChunkListR_Status_Name(reply.status())
+         << " revision: " << reply.revision());
+
+    _revision = reply.revision();
 
     ChunkCollection chunks;
 
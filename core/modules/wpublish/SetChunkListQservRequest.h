@@ -25,6 +25,7 @@
 #define LSST_QSERV_WPUBLISH_SET_CHUNK_LIST_QSERV_REQUEST_H
 
 // System headers
+#include <cstdint>
 #include <functional>
 #include <list>
 #include <memory>
@@ -54,7 +55,8 @@ public:
         SUCCESS,    // successful completion of a request
         INVALID,    // invalid parameters of the request
         IN_USE,     // request is rejected because one of the chunks is in use
-        ERROR       // an error occured during command execution
+        ERROR,      // an error occured during command execution
+        STALE       // the diff was made against another revision of the inventory
     };
 
     /// @return string representation of a status
@@ -98,6 +100,26 @@ public:
                      bool force = false,
                      CallbackType onFinish = nullptr);
 
+    /**
+     * Static factory method for the 'diff' mode, in which the worker adds
+     * and removes the specified chunks only if the revision of its inventory
+     * is still the one the diff was made against. In this mode the worker
+     * doesn't report its previous collection of chunks.
+     *
+     * @param addedChunks   - chunks to be added to the worker's collection
+     * @param removedChunks - chunks to be removed from the worker's collection
+     * @param baseRevision  - revision of the worker's inventory the diff was made against
+     * @param force         - force the proposed change even if the chunk is in use
+     * @param onFinish      - optional callback function to be called upon the completion
+     *                        (successful or not) of the request.
+     * @return smart pointer to the object of the class
+     */
+   static Ptr createDiff(ChunkCollection const& addedChunks,
+                         ChunkCollection const& removedChunks,
+                         std::uint64_t baseRevision,
+                         bool force = false,
+                         CallbackType onFinish = nullptr);
+
     // Default onstruction and copy semantics are prohibited
     SetChunkListQservRequest() = delete;
     SetChunkListQservRequest(SetChunkListQservRequest const&) = delete;
@@ -106,6 +128,10 @@ public:
     /// Destructor
     ~SetChunkListQservRequest() override;
 
+    /// @return the revision of the worker's inventory reported by the worker,
+    ///         it's available when the callback is called (0 on errors)
+    std::uint64_t revision() const { return _revision; }
+
 protected:
 
     /**
@@ -123,6 +149,13 @@ protected:
                              bool force,
                              CallbackType onFinish);
 
+    /// @see SetChunkListQservRequest::createDiff()
+    SetChunkListQservRequest(ChunkCollection const& addedChunks,
+                             ChunkCollection const& removedChunks,
+                             std::uint64_t baseRevision,
+                             bool force,
+                             CallbackType onFinish);
+
     /// Implement the corresponding method of the base class
     void onRequest(proto::FrameBuffer& buf) override;
 
@@ -137,6 +170,15 @@ private:
     ChunkCollection _chunks;
     bool _force;
 
+    // Parameters of the 'diff' mode
+
+    bool _diff;
+    ChunkCollection _removedChunks;
+    std::uint64_t _baseRevision;
+
+    /// The revision reported by the worker
+    std::uint64_t _revision;
+
     /// Optional callback function to be called upon the completion
     /// (successfull or not) of the request.
     CallbackType _onFinish;
@@ -0,0 +1,95 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "wpublish/SetConfigCommand.h"
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+// Qserv headers
+#include "proto/worker.pb.h"
+#include "wbase/SendChannel.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.wpublish.SetConfigCommand");
+
+} // annonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace wpublish {
+
+SetConfigCommand::SetConfigCommand(std::shared_ptr<wbase::SendChannel> const& sendChannel,
+                                   wcontrol::RuntimeConfig::Ptr        const& runtimeConfig,
+                                   wcontrol::RuntimeConfig::Params     const& params)
+    :   wbase::WorkerCommand(sendChannel),
+        _runtimeConfig(runtimeConfig),
+        _params(params) {
+}
+
+void SetConfigCommand::reportError(std::string const& message) {
+
+    LOGS(_log, LOG_LVL_ERROR, "SetConfigCommand::run  " << message);
+
+    proto::WorkerCommandSetConfigR reply;
+
+    reply.set_status(proto::WorkerCommandSetConfigR::ERROR);
+    reply.set_error(message);
+
+    _frameBuf.serialize(reply);
+    std::string str(_frameBuf.data(), _frameBuf.size());
+    _sendChannel->sendStream(xrdsvc::StreamBuffer::createWithMove(str), true);
+}
+
+void SetConfigCommand::run() {
+
+    LOGS(_log, LOG_LVL_DEBUG, "SetConfigCommand::run  params: " << _params.size());
+
+    if (_runtimeConfig == nullptr) {
+        reportError("parameters of this worker can't be changed");
+        return;
+    }
+
+    proto::WorkerCommandSetConfigR reply;
+    std::string error;
+    if (_params.empty() or _runtimeConfig->set(_params, error)) {
+        reply.set_status(proto::WorkerCommandSetConfigR::SUCCESS);
+    } else {
+        LOGS(_log, LOG_LVL_ERROR, "SetConfigCommand::run  " << error);
+        reply.set_status(proto::WorkerCommandSetConfigR::INVALID);
+        reply.set_error(error);
+    }
+    for (auto const& elem: _runtimeConfig->get()) {
+        proto::WorkerCommandParam* ptr = reply.add_params();
+        ptr->set_name(elem.first);
+        ptr->set_value(elem.second);
+    }
+
+    _frameBuf.serialize(reply);
+    std::string str(_frameBuf.data(), _frameBuf.size());
+    _sendChannel->sendStream(xrdsvc::StreamBuffer::createWithMove(str), true);
+}
+
+}}} // namespace lsst::qserv::wpublish
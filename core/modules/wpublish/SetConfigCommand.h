@@ -0,0 +1,99 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/// SetConfigCommand.h
+#ifndef LSST_QSERV_WPUBLISH_SET_CONFIG_COMMAND_H
+#define LSST_QSERV_WPUBLISH_SET_CONFIG_COMMAND_H
+
+// System headers
+#include <memory>
+#include <string>
+
+// Qserv headers
+#include "wbase/WorkerCommand.h"
+#include "wcontrol/RuntimeConfig.h"
+
+namespace lsst {
+namespace qserv {
+namespace wpublish {
+
+/**
+  * Class SetConfigCommand changes scheduler, thread pool and memman parameters
+  * of the worker while it runs, and returns the values of all the parameters
+  */
+class SetConfigCommand
+    :   public wbase::WorkerCommand {
+
+public:
+
+    // The default construction and copy semantics are prohibited
+    SetConfigCommand() = delete;
+    SetConfigCommand& operator=(SetConfigCommand const&) = delete;
+    SetConfigCommand(SetConfigCommand const&) = delete;
+
+    /// The destructor
+    ~SetConfigCommand() override = default;
+
+    /**
+     * The normal constructor of the class
+     *
+     * @param sendChannel   - communication channel for reporting results
+     * @param runtimeConfig - parameters of the worker, null if they can't be changed
+     * @param params        - parameters to be changed, none to only read them
+     */
+    SetConfigCommand(std::shared_ptr<wbase::SendChannel> const& sendChannel,
+                     wcontrol::RuntimeConfig::Ptr        const& runtimeConfig,
+                     wcontrol::RuntimeConfig::Params     const& params);
+
+    /**
+     * Implement the corresponding method of the base class
+     *
+     * @see WorkerCommand::run()
+     */
+    void run() override;
+
+    /**
+     * Tuning a worker struggling with its load shouldn't wait for other commands
+     *
+     * @see WorkerCommand::priority()
+     */
+    Priority priority() const override { return HIGH; }
+
+private:
+
+    /**
+     * Report error condition to the logging stream and reply back to
+     * a service caller.
+     *
+     * @param message - message to be reported
+     */
+    void reportError(std::string const& message);
+
+private:
+
+    wcontrol::RuntimeConfig::Ptr _runtimeConfig;
+    wcontrol::RuntimeConfig::Params _params;
+};
+
+}}} // namespace lsst::qserv::wpublish
+
+#endif // LSST_QSERV_WPUBLISH_SET_CONFIG_COMMAND_H
@@ -0,0 +1,143 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "wpublish/SetConfigQservRequest.h"
+
+// System headers
+#include <stdexcept>
+#include <string>
+
+// Qserv headers
+#include "lsst/log/Log.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.wpublish.SetConfigQservRequest");
+
+using namespace lsst::qserv;
+
+wpublish::SetConfigQservRequest::Status translate(proto::WorkerCommandSetConfigR::Status status) {
+    switch (status) {
+        case proto::WorkerCommandSetConfigR::SUCCESS:
+            return wpublish::SetConfigQservRequest::SUCCESS;
+        case proto::WorkerCommandSetConfigR::INVALID:
+            return wpublish::SetConfigQservRequest::INVALID;
+        case proto::WorkerCommandSetConfigR::ERROR:
+            return wpublish::SetConfigQservRequest::ERROR;
+    }
+    throw std::domain_error(
+            "SetConfigQservRequest::translate  no match for Protobuf status: " +
+            proto::WorkerCommandSetConfigR_Status_Name(status));
+}
+}  // namespace
+
+namespace lsst {
+namespace qserv {
+namespace wpublish {
+
+std::string SetConfigQservRequest::status2str(Status status) {
+    switch (status) {
+        case SUCCESS: return "SUCCESS";
+        case INVALID: return "INVALID";
+        case ERROR:   return "ERROR";
+    }
+    throw std::domain_error(
+            "SetConfigQservRequest::status2str  no match for status: " +
+            std::to_string(status));
+}
+
+SetConfigQservRequest::Ptr SetConfigQservRequest::create(
+                                    Params const& params,
+                                    SetConfigQservRequest::CallbackType onFinish) {
+    return SetConfigQservRequest::Ptr(new SetConfigQservRequest(params, onFinish));
+}
+
+SetConfigQservRequest::SetConfigQservRequest(
+                                    Params const& params,
+                                    SetConfigQservRequest::CallbackType onFinish)
+    :   _params(params),
+        _onFinish(onFinish) {
+
+    LOGS(_log, LOG_LVL_DEBUG, "SetConfigQservRequest  ** CONSTRUCTED **");
+}
+
+SetConfigQservRequest::~SetConfigQservRequest() {
+    LOGS(_log, LOG_LVL_DEBUG, "SetConfigQservRequest  ** DELETED **");
+}
+
+void SetConfigQservRequest::onRequest(proto::FrameBuffer& buf) {
+
+    proto::WorkerCommandH header;
+    header.set_command(proto::WorkerCommandH::SET_CONFIG);
+    buf.serialize(header);
+
+    proto::WorkerCommandSetConfigM message;
+    for (auto const& elem: _params) {
+        proto::WorkerCommandParam* ptr = message.add_params();
+        ptr->set_name(elem.first);
+        ptr->set_value(elem.second);
+    }
+    buf.serialize(message);
+}
+
+void SetConfigQservRequest::onResponse(proto::FrameBufferView& view) {
+
+    static std::string const context = "SetConfigQservRequest  ";
+
+    proto::WorkerCommandSetConfigR reply;
+    view.parse(reply);
+
+    LOGS(_log, LOG_LVL_DEBUG, context << "** SERVICE REPLY **  status: "
+         << proto::WorkerCommandSetConfigR_Status_Name(reply.status()));
+
+    if (nullptr != _onFinish) {
+
+        // Clearing the stored callback before the notification guaranties
+        // (exactly) one time notification and breaks the dependency on a caller
+        // object mentioned in the closure, as in GetChunkListQservRequest.
+
+        Params params;
+        for (int i = 0, num = reply.params_size(); i < num; ++i) {
+            params[reply.params(i).name()] = reply.params(i).value();
+        }
+        auto onFinish = std::move(_onFinish);
+        _onFinish = nullptr;
+        onFinish(::translate(reply.status()),
+                 reply.error(),
+                 params);
+    }
+}
+
+void SetConfigQservRequest::onError(std::string const& error) {
+
+    if (nullptr != _onFinish) {
+        auto onFinish = std::move(_onFinish);
+        _onFinish = nullptr;
+        onFinish(Status::ERROR,
+                 error,
+                 Params());
+    }
+}
+
+}}} // namespace lsst::qserv::wpublish
@@ -0,0 +1,218 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "wpublish/TaskQservRequest.h"
+
+// System headers
+#include <stdexcept>
+
+// Qserv headers
+#include "lsst/log/Log.h"
+#include "proto/ProtoHeaderWrap.h"
+#include "proto/ProtoImporter.h"
+#include "proto/ResultCompression.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.wpublish.TaskQservRequest");
+
+}  // namespace
+
+namespace lsst {
+namespace qserv {
+namespace wpublish {
+
+int const TaskQservRequest::_readSize = 64 * 1024;
+
+std::string TaskQservRequest::status2str(Status status) {
+    switch (status) {
+        case SUCCESS: return "SUCCESS";
+        case ERROR:   return "ERROR";
+    }
+    throw std::domain_error(
+            "TaskQservRequest::status2str  no match for status: " +
+            std::to_string(status));
+}
+
+TaskQservRequest::Ptr TaskQservRequest::create(
+                                    std::string const& taskMsg,
+                                    TaskQservRequest::CallbackType onFinish) {
+    return TaskQservRequest::Ptr(
+        new TaskQservRequest(taskMsg,
+                             onFinish));
+}
+
+TaskQservRequest::TaskQservRequest(
+                                    std::string const& taskMsg,
+                                    TaskQservRequest::CallbackType onFinish)
+    :   _taskMsg(taskMsg),
+        _onFinish(onFinish),
+        _readBuf(_readSize) {
+
+    LOGS(_log, LOG_LVL_DEBUG, "TaskQservRequest  ** CONSTRUCTED **");
+}
+
+TaskQservRequest::~TaskQservRequest() {
+    LOGS(_log, LOG_LVL_DEBUG, "TaskQservRequest  ** DELETED **");
+}
+
+char* TaskQservRequest::GetRequest(int& dlen) {
+    dlen = _taskMsg.size();
+    return &_taskMsg[0];
+}
+
+bool TaskQservRequest::ProcessResponse(const XrdSsiErrInfo&  eInfo,
+                                       const XrdSsiRespInfo& rInfo) {
+
+    static std::string const context = "TaskQservRequest::ProcessResponse  ";
+
+    if (eInfo.hasError()) {
+        std::string const errorStr = eInfo.Get();
+        LOGS(_log, LOG_LVL_ERROR, context << "** FAILED **, error: " << errorStr);
+        _finish(ERROR, errorStr);
+        return false;
+    }
+    switch (rInfo.rType) {
+
+        case XrdSsiRespInfo::isData:
+        case XrdSsiRespInfo::isStream:
+            GetResponseData(_readBuf.data(), _readSize);
+            return true;
+
+        case XrdSsiRespInfo::isError:
+            _finish(ERROR, rInfo.eMsg == nullptr ? "worker error " + std::to_string(rInfo.eNum)
+                                                 : std::string(rInfo.eMsg));
+            return false;
+
+        default:
+            _finish(ERROR, context + "** ERROR ** unexpeted response type: " + std::to_string(rInfo.rType));
+            return false;
+    }
+}
+
+XrdSsiRequest::PRD_Xeq TaskQservRequest::ProcessResponseData(const XrdSsiErrInfo& eInfo,
+                                                             char* buff,
+                                                             int   blen,
+                                                             bool  last) {
+
+    static std::string const context = "TaskQservRequest::ProcessResponseData  ";
+
+    if (not eInfo.isOK()) {
+        std::string const errorStr = eInfo.Get();
+        LOGS(_log, LOG_LVL_ERROR, context << "** FAILED **  eInfo.Get(): " << errorStr);
+        _finish(ERROR, errorStr);
+        return XrdSsiRequest::PRD_Normal;
+    }
+    if (blen > 0) {
+        _result.bytes += blen;
+        _pending.append(buff, blen);
+    }
+    if (not _parse()) {
+        _finish(ERROR, context + "** ERROR ** failed to parse the result stream");
+    } else if (last) {
+        if (not _workerError.empty()) {
+            _finish(ERROR, _workerError);
+        } else if (not _inHeader or not _pending.empty()) {
+            _finish(ERROR, context + "** ERROR ** result stream ended in the middle of a message");
+        } else {
+            _finish(SUCCESS, std::string());
+        }
+    } else {
+        GetResponseData(_readBuf.data(), _readSize);
+    }
+    return XrdSsiRequest::PRD_Normal;
+}
+
+bool TaskQservRequest::_parse() {
+    size_t offset = 0;
+    while (true) {
+        if (_inHeader) {
+            size_t const headerSize = proto::ProtoHeaderWrap::PROTO_HEADER_SIZE;
+            if (_pending.size() - offset < headerSize) break;
+            unsigned char const size = static_cast<unsigned char>(_pending[offset]);
+            if (not proto::ProtoImporter<proto::ProtoHeader>::setMsgFrom(
+                    _header, &_pending[offset + 1], size)) {
+                return false;
+            }
+            offset += headerSize;
+            _inHeader = false;
+            // The first header says how long the task was queued, the last one
+            // how long it ran.
+            if (_result.messages == 0) _result.queueMillis = _header.queuemillis();
+            _result.runMillis = _header.runmillis();
+        } else {
+            size_t const msgSize = _header.size();
+            if (_pending.size() - offset < msgSize) break;
+            char const* msg = &_pending[offset];
+            std::vector<char> uncompressed;
+            if (_header.compression() != proto::ProtoHeader::NONE) {
+                if (not proto::ResultCompression::decompress(_header.compression(), msg, msgSize,
+                                                             _header.uncompressedsize(), uncompressed)) {
+                    return false;
+                }
+                msg = uncompressed.data();
+            }
+            proto::Result result;
+            size_t const resultSize = uncompressed.empty() ? msgSize : uncompressed.size();
+            if (not proto::ProtoImporter<proto::Result>::setMsgFrom(result, msg, resultSize)) {
+                return false;
+            }
+            if (result.has_errormsg() and _workerError.empty()) {
+                _workerError = result.errormsg();
+            }
+            _result.rows += result.rowcount();
+            ++_result.messages;
+            offset += msgSize;
+            _inHeader = true;
+        }
+    }
+    _pending.erase(0, offset);
+    return true;
+}
+
+void TaskQservRequest::_finish(Status status, std::string const& error) {
+
+    // Tell XrootD to realease all resources associated with this request
+    Finished();
+
+    // Callers may keep many finished requests around, only keep what was learned.
+    std::vector<char>().swap(_readBuf);
+    std::string().swap(_pending);
+
+    if (nullptr != _onFinish) {
+
+        // Clearing the stored callback after finishing the up-stream notification
+        // has two purposes:
+        //
+        // 1. it guaranties (exactly) one time notification
+        // 2. it breaks the up-stream dependency on a caller object if a shared
+        //    pointer to the object was mentioned as the lambda-function's closure
+
+        auto onFinish = std::move(_onFinish);
+        _onFinish = nullptr;
+        onFinish(status, error, _result);
+    }
+}
+
+}}} // namespace lsst::qserv::wpublish
@@ -0,0 +1,160 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/// TaskQservRequest.h
+#ifndef LSST_QSERV_WPUBLISH_TASK_QSERV_REQUEST_H
+#define LSST_QSERV_WPUBLISH_TASK_QSERV_REQUEST_H
+
+// System headers
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Third party headers
+#include "XrdSsi/XrdSsiRequest.hh"
+
+// Qserv headers
+#include "proto/worker.pb.h"
+
+// Forward declarations
+
+namespace lsst {
+namespace qserv {
+namespace wpublish {
+
+/**
+  * Class TaskQservRequest sends a chunk query (a TaskMsg) to a worker the way
+  * the czar does, and reads the result stream back without merging it. It is
+  * meant for load generators: the result headers carry how long the task was
+  * queued and running on the worker, which are reported along with the number
+  * of rows and bytes received.
+  */
+class TaskQservRequest
+    :   public XrdSsiRequest {
+
+public:
+
+    /// Completion status of the operation
+    enum Status {
+        SUCCESS,    // all result messages were received
+        ERROR       // the request failed, or the worker reported an error
+    };
+
+    /// @return string representation of a status
+    static std::string status2str(Status status);
+
+    /// What is known about the task once the request has finished
+    struct Result {
+        uint32_t queueMillis{0};    ///< time the task waited in the worker queue
+        uint32_t runMillis{0};      ///< time the task ran until its last message was made
+        unsigned int messages{0};   ///< number of Result messages received
+        uint64_t rows{0};           ///< number of rows received
+        uint64_t bytes{0};          ///< number of bytes received, headers included
+    };
+
+    /// The pointer type for instances of the class
+    typedef std::shared_ptr<TaskQservRequest> Ptr;
+
+    /// The callback function type to be used for notifications on
+    /// the operation completion.
+    using CallbackType =
+        std::function<void(Status,                  // completion status
+                           std::string const&,      // error message
+                           Result const&)>;         // what was received
+
+    /**
+     * Static factory method is needed to prevent issues with the lifespan
+     * and memory management of instances created otherwise (as values or via
+     * low-level pointers).
+     *
+     * @param taskMsg  - serialized TaskMsg to be sent to the worker
+     * @param onFinish - optional callback function to be called upon the completion
+     *                   (successful or not) of the request.
+     * @return smart pointer to the object of the class
+     */
+    static Ptr create(std::string const& taskMsg,
+                      CallbackType onFinish = nullptr);
+
+    // Default construction and copy semantics is prohibited
+    TaskQservRequest() = delete;
+    TaskQservRequest(TaskQservRequest const&) = delete;
+    TaskQservRequest& operator=(TaskQservRequest const&) = delete;
+
+    /// Destructor
+    ~TaskQservRequest() override;
+
+protected:
+
+    /**
+     * Normal constructor
+     *
+     * @param taskMsg  - serialized TaskMsg to be sent to the worker
+     * @param onFinish - function to be called upon the completion of a request
+     */
+    TaskQservRequest(std::string const& taskMsg,
+                     CallbackType onFinish);
+
+    /// Implements the corresponidng method of the base class
+    char* GetRequest(int& dlen) override;
+
+    /// Implements the corresponidng method of the base class
+    bool ProcessResponse(const XrdSsiErrInfo&  eInfo,
+                         const XrdSsiRespInfo& rInfo) override;
+
+    /// Implements the corresponidng method of the base class
+    XrdSsiRequest::PRD_Xeq ProcessResponseData(const XrdSsiErrInfo& eInfo,
+                                               char* buff,
+                                               int   blen,
+                                               bool  last) override;
+
+private:
+
+    /// Consume the complete headers and Result messages in _pending.
+    /// @return false if a message could not be parsed
+    bool _parse();
+
+    /// Release the request and call the callback, at most once.
+    void _finish(Status status, std::string const& error);
+
+    /// Serialized TaskMsg
+    std::string _taskMsg;
+
+    /// Optional callback function to be called upon the completion
+    /// (successfull or not) of the request.
+    CallbackType _onFinish;
+
+    static int const _readSize;     ///< number of bytes asked for at a time
+    std::vector<char> _readBuf;     ///< buffer given to XrdSsi for incoming data
+
+    std::string _pending;           ///< bytes received but not parsed yet
+    bool _inHeader{true};           ///< true if a header is expected next in _pending
+    proto::ProtoHeader _header;     ///< header of the Result message expected next
+    std::string _workerError;       ///< error message found in a Result, if any
+
+    Result _result;
+};
+
+}}} // namespace lsst::qserv::wpublish
+
+#endif // LSST_QSERV_WPUBLISH_TASK_QSERV_REQUEST_H
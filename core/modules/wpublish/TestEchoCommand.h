@@ -73,6 +73,13 @@ public:
      */
     void run() override;
 
+    /**
+     * Replies without waiting for other commands
+     *
+     * @see WorkerCommand::priority()
+     */
+    Priority priority() const override { return HIGH; }
+
 private:
 
     std::string _value;
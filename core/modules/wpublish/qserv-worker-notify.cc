@@ -15,10 +15,14 @@
 #include "proto/worker.pb.h"
 #include "util/BlockPost.h"
 #include "util/CmdLineParser.h"
+#include "wpublish/CancelQueryQservRequest.h"
 #include "wpublish/ChunkGroupQservRequest.h"
 #include "wpublish/ChunkListQservRequest.h"
+#include "wpublish/GetAdmissionStatsQservRequest.h"
 #include "wpublish/GetChunkListQservRequest.h"
+#include "wpublish/GetChunkStatsQservRequest.h"
 #include "wpublish/SetChunkListQservRequest.h"
+#include "wpublish/SetConfigQservRequest.h"
 #include "wpublish/TestEchoQservRequest.h"
 
 /// This C++ symbol is provided by the SSI shared library
@@ -36,11 +40,14 @@ std::string operation;
 std::string worker;
 std::string inFileName;
 unsigned int chunk;
+uint64_t queryId;
 std::vector<std::string> dbs;
+std::vector<std::string> params;
 std::string value;
 std::string serviceProviderLocation;
 bool inUseOnly;
 bool reload;
+bool incremental;
 bool force;
 bool printReport;
 
@@ -175,7 +182,8 @@ int test() {
                               << "# chuks  removed: " << removed.size() << std::endl;
                 }
                 finished = true;
-            });
+            },
+            incremental);
 
     } else if ("RELOAD_CHUNK_LIST" == operation) {
         request = wpublish::ReloadChunkListQservRequest::create(
@@ -192,7 +200,8 @@ int test() {
                               << "# chuks  removed: " << removed.size() << std::endl;
                 }
                 finished = true;
-            });
+            },
+            incremental);
 
     } else if ("ADD_CHUNK_GROUP" == operation) {
         request = wpublish::AddChunkGroupQservRequest::create(
@@ -223,6 +232,112 @@ int test() {
                 finished = true;
             });
 
+    } else if ("GET_ADMISSION_STATS" == operation) {
+        request = wpublish::GetAdmissionStatsQservRequest::create(
+            [&finished] (wpublish::GetAdmissionStatsQservRequest::Status status,
+                         std::string const& error,
+                         wpublish::GetAdmissionStatsQservRequest::PrincipalCollection const& principals) {
+
+                if (status != wpublish::GetAdmissionStatsQservRequest::Status::SUCCESS) {
+                    std::cout << "status: " << wpublish::GetAdmissionStatsQservRequest::status2str(status) << "\n"
+                              << "error:  " << error << std::endl;
+                } else {
+                    std::cout << "# total principals: " << principals.size() << "\n"
+                              << std::endl;
+                    if (principals.size()) {
+                        std::cout << "                        principal | weight | in flight |   queued |   admitted |   rejected \n"
+                                  << "----------------------------------+--------+-----------+----------+------------+------------\n";
+                        for (auto const& entry: principals) {
+                            std::cout << " " << std::setw(32) << entry.name << " |"
+                                      << " " << std::setw(6)  << entry.weight << " |"
+                                      << " " << std::setw(9)  << entry.inflight << " |"
+                                      << " " << std::setw(8)  << entry.queued << " |"
+                                      << " " << std::setw(10) << entry.admitted << " |"
+                                      << " " << std::setw(10) << entry.rejected << " \n";
+                        }
+                        std::cout << std::endl;
+                    }
+                }
+                finished = true;
+            });
+
+    } else if ("GET_CHUNK_STATS" == operation) {
+        request = wpublish::GetChunkStatsQservRequest::create(
+            std::vector<std::string>(),
+            0,
+            [&finished] (wpublish::GetChunkStatsQservRequest::Status status,
+                         std::string const& error,
+                         wpublish::GetChunkStatsQservRequest::EntryCollection const& entries) {
+
+                if (status != wpublish::GetChunkStatsQservRequest::Status::SUCCESS) {
+                    std::cout << "status: " << wpublish::GetChunkStatsQservRequest::status2str(status) << "\n"
+                              << "error:  " << error << std::endl;
+                } else {
+                    std::cout << "# total entries: " << entries.size() << "\n"
+                              << std::endl;
+                    if (entries.size()) {
+                        std::cout << "                 database |                table |    chunk |         rows |     data bytes |    index bytes |    tasks | avg sec | last sec \n"
+                                  << "--------------------------+----------------------+----------+--------------+----------------+----------------+----------+---------+----------\n";
+                        for (auto const& entry: entries) {
+                            std::cout << " " << std::setw(24) << entry.db << " |"
+                                      << " " << std::setw(20) << entry.table << " |"
+                                      << " " << std::setw(8)  << entry.chunk << " |"
+                                      << " " << std::setw(12) << entry.numRows << " |"
+                                      << " " << std::setw(14) << entry.dataSize << " |"
+                                      << " " << std::setw(14) << entry.indexSize << " |"
+                                      << " " << std::setw(8)  << entry.tasksCompleted << " |"
+                                      << " " << std::setw(7)  << entry.avgSeconds << " |"
+                                      << " " << std::setw(8)  << entry.lastSeconds << " \n";
+                        }
+                        std::cout << std::endl;
+                    }
+                }
+                finished = true;
+            });
+
+    } else if ("CANCEL_QUERY" == operation) {
+        request = wpublish::CancelQueryQservRequest::create(
+            queryId,
+            [&finished] (wpublish::CancelQueryQservRequest::Status status,
+                         std::string const& error,
+                         unsigned int tasks) {
+
+                if (status != wpublish::CancelQueryQservRequest::Status::SUCCESS) {
+                    std::cout << "status: " << wpublish::CancelQueryQservRequest::status2str(status) << "\n"
+                              << "error:  " << error << std::endl;
+                } else {
+                    std::cout << "tasks cancelled: " << tasks << std::endl;
+                }
+                finished = true;
+            });
+
+    } else if ("SET_CONFIG" == operation) {
+        wpublish::SetConfigQservRequest::Params values;
+        for (auto const& param: params) {
+            std::string::size_type const pos = param.find('=');
+            if (pos == std::string::npos) {
+                std::cerr << "parameter is not <name>=<value>: " << param << std::endl;
+                return 1;
+            }
+            values[param.substr(0, pos)] = param.substr(pos + 1);
+        }
+        request = wpublish::SetConfigQservRequest::create(
+            values,
+            [&finished] (wpublish::SetConfigQservRequest::Status status,
+                         std::string const& error,
+                         wpublish::SetConfigQservRequest::Params const& current) {
+
+                if (status != wpublish::SetConfigQservRequest::Status::SUCCESS) {
+                    std::cout << "status: " << wpublish::SetConfigQservRequest::status2str(status) << "\n"
+                              << "error:  " << error << std::endl;
+                }
+                for (auto const& entry: current) {
+                    std::cout << entry.first << "=" << entry.second << "\n";
+                }
+                std::cout << std::endl;
+                finished = true;
+            });
+
     } else if ("TEST_ECHO" == operation) {
         request = wpublish::TestEchoQservRequest::create(
             value,
@@ -288,6 +403,7 @@ int main(int argc, const char* const argv[]) {
             "              [--service=<provider>]\n"
             "              [--in-use-only]\n"
             "              [--reload]\n"
+            "              [--incremental]\n"
             "              [--force>]\n"
             "              [--print-report]\n"
             "\n"
@@ -298,6 +414,10 @@ int main(int argc, const char* const argv[]) {
             "    RELOAD_CHUNK_LIST  <worker>\n"
             "    ADD_CHUNK_GROUP    <worker> <chunk> <db> [<db> [<db> ... ]]\n"
             "    REMOVE_CHUNK_GROUP <worker> <chunk> <db> [<db> [<db> ... ]]\n"
+            "    GET_ADMISSION_STATS <worker>\n"
+            "    GET_CHUNK_STATS    <worker>\n"
+            "    CANCEL_QUERY       <worker> <query>\n"
+            "    SET_CONFIG         <worker> [<param> [<param> ... ]]\n"
             "    TEST_ECHO          <worker> <value>\n"
             "\n"
             "Flags an options:\n"
@@ -305,6 +425,8 @@ int main(int argc, const char* const argv[]) {
             "  --in-use-only         - used with GET_CHUNK_LIST to only report chunks which are in use.\n"
             "                          Otherwise all chunks will be reported\n"
             "  --reload              - used with REBUILD_CHUNK_LIST to also reload the list into a worker\n"
+            "  --incremental         - used with REBUILD_CHUNK_LIST and RELOAD_CHUNK_LIST to only process\n"
+            "                          databases changed since the last incremental update\n"
             "  --force               - force operation in REMOVE_CHUNK_GROUP even for chunks in use\n"
             "  --print-report        - print \n"
             "\n"
@@ -313,7 +435,10 @@ int main(int argc, const char* const argv[]) {
             "  <infile>  - text file with space or newline separated pairs of <database>:<chunk>\n"
             "  <chunk>   - chunk number\n"
             "  <db>      - database name\n"
-            "  <value>   - arbitrary string\n");
+            "  <value>   - arbitrary string\n"
+            "  <query>   - user query identifier\n"
+            "  <param>   - <name>=<value> of a worker parameter to change at once, none\n"
+            "              to print the current values (example: 'scheduler.maxactivechunks_slow=4')\n");
 
         ::operation = parser.parameterRestrictedBy(1, {
             "GET_CHUNK_LIST",
@@ -322,6 +447,10 @@ int main(int argc, const char* const argv[]) {
             "RELOAD_CHUNK_LIST",
             "ADD_CHUNK_GROUP",
             "REMOVE_CHUNK_GROUP",
+            "GET_ADMISSION_STATS",
+            "GET_CHUNK_STATS",
+            "CANCEL_QUERY",
+            "SET_CONFIG",
             "TEST_ECHO"});
 
         ::worker = parser.parameter<std::string>(2);
@@ -336,6 +465,14 @@ int main(int argc, const char* const argv[]) {
             ::chunk = parser.parameter<unsigned int>(3);
             ::dbs   = parser.parameters<std::string>(4);
 
+        } else if (parser.in(::operation, {
+            "CANCEL_QUERY"})) {
+            ::queryId = parser.parameter<uint64_t>(3);
+
+        } else if (parser.in(::operation, {
+            "SET_CONFIG"})) {
+            ::params = parser.parameters<std::string>(3);
+
         } else if (parser.in(::operation, {
             "TEST_ECHO"})) {
             ::value = parser.parameter<std::string>(3);
@@ -343,6 +480,7 @@ int main(int argc, const char* const argv[]) {
         ::serviceProviderLocation = parser.option<std::string>("service", "localhost:1094");
         ::inUseOnly               = parser.flag("in-use-only");
         ::reload                  = parser.flag("reload");
+        ::incremental             = parser.flag("incremental");
         ::force                   = parser.flag("force");
         ::printReport             = parser.flag("print-report");
 
@@ -1,12 +1,22 @@
 // System header
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <iomanip>
+#include <iterator>
 #include <fstream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
 // Third party headers
+#include <google/protobuf/text_format.h>
 #include "XrdSsi/XrdSsiProvider.hh"
 #include "XrdSsi/XrdSsiService.hh"
 
@@ -15,12 +25,14 @@
 #include "proto/worker.pb.h"
 #include "util/BlockPost.h"
 #include "util/CmdLineParser.h"
+#include "wpublish/TaskQservRequest.h"
 #include "wpublish/TestEchoQservRequest.h"
 
 /// This C++ symbol is provided by the SSI shared library
 extern XrdSsiProvider* XrdSsiProviderClient;
 
 namespace global   = lsst::qserv;
+namespace proto    = lsst::qserv::proto;
 namespace util     = lsst::qserv::util;
 namespace wpublish = lsst::qserv::wpublish;
 
@@ -28,6 +40,7 @@ namespace {
 
 // Command line parameters
 
+std::string  operation;
 std::string  workersFileName;
 unsigned int numRequests;
 std::string  value;
@@ -35,6 +48,14 @@ std::string  serviceProviderLocation;
 unsigned int numWorkers;
 bool workerFirst;
 
+std::string  mixFileName;
+double       rate;
+unsigned int maxInFlight;
+unsigned int seed;
+unsigned long long queryIdBase;
+std::string  jsonFileName;
+std::string  tasksFileName;
+
 
 std::vector<std::string> workers;
 
@@ -58,16 +79,7 @@ bool readWorkersFile() {
 }
 
 
-int test() {
-
-    if (not readWorkersFile()) return 1;
-    if (not numWorkers or (workers.size() < numWorkers)) {
-        std::cerr << "error: specified number of workers not in the valid range: 1.."
-                  << numWorkers << std::endl;
-        return 1;
-    }
-
-    // Connect to a service provider
+XrdSsiService* connect() {
     XrdSsiErrInfo errInfo;
     auto serviceProvider =
         XrdSsiProviderClient->GetService(errInfo,
@@ -76,9 +88,25 @@ int test() {
         std::cerr
             << "failed to contact service provider at: " << serviceProviderLocation
             << ", error: " << errInfo.Get() << std::endl;
+        return nullptr;
+    }
+    std::cerr << "connected to service provider at: " << serviceProviderLocation << std::endl;
+    return serviceProvider;
+}
+
+
+int testEcho() {
+
+    if (not readWorkersFile()) return 1;
+    if (not numWorkers or (workers.size() < numWorkers)) {
+        std::cerr << "error: specified number of workers not in the valid range: 1.."
+                  << numWorkers << std::endl;
         return 1;
     }
-    std::cout << "connected to service provider at: " << serviceProviderLocation << std::endl;
+
+    // Connect to a service provider
+    auto serviceProvider = connect();
+    if (serviceProvider == nullptr) return 1;
 
     // Instantiate a request object
 
@@ -156,6 +184,262 @@ int test() {
     }
     return 0;
 }
+
+
+/// A kind of chunk query in the replayed mix, such as a shared scan,
+/// an interactive query or a near-neighbour query.
+struct TaskClass {
+    std::string name;
+    double weight;
+    proto::TaskMsg msg;
+};
+
+
+/// What was measured for one replayed task
+struct TaskSample {
+    size_t classIdx{0};
+    bool ok{false};
+    std::string error;
+    double submitSec{0};    ///< since the start of the run
+    double queueMs{0};      ///< as reported by the worker
+    double execMs{0};       ///< as reported by the worker
+    double transmitMs{0};   ///< what remains of the total
+    double totalMs{0};      ///< from submitting the request to the last byte received
+    wpublish::TaskQservRequest::Result result;
+};
+
+
+/**
+ * Read the mix of tasks to replay. Each line of the file has the name of the
+ * class of the task, its relative weight in the mix and the name of a file
+ * with a TaskMsg as it was sent by a czar: serialized, or in the Protobuf
+ * text format if the file name ends with ".txt". Empty lines and lines
+ * starting with '#' are ignored.
+ */
+bool readMixFile(std::vector<TaskClass>& classes) {
+    std::ifstream file(mixFileName);
+    if (not file.good()) {
+        std::cerr << "error: failed to open the mix file: " << mixFileName << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() or line[0] == '#') continue;
+        std::istringstream is(line);
+        TaskClass taskClass;
+        std::string msgFileName;
+        if (not (is >> taskClass.name >> taskClass.weight >> msgFileName) or taskClass.weight <= 0) {
+            std::cerr << "error: expected '<class> <weight> <task-file>' in the mix file, got: "
+                      << line << std::endl;
+            return false;
+        }
+        std::ifstream msgFile(msgFileName, std::ios::binary);
+        bool const opened = msgFile.is_open();
+        std::string const msgStr((std::istreambuf_iterator<char>(msgFile)), std::istreambuf_iterator<char>());
+        bool const isText = msgFileName.size() > 4 and msgFileName.substr(msgFileName.size() - 4) == ".txt";
+        bool const parsed = isText ? google::protobuf::TextFormat::ParseFromString(msgStr, &taskClass.msg)
+                                   : taskClass.msg.ParseFromString(msgStr);
+        if (not opened or not parsed or not taskClass.msg.has_db() or not taskClass.msg.has_chunkid()) {
+            std::cerr << "error: failed to read a TaskMsg with a database and a chunk from: "
+                      << msgFileName << std::endl;
+            return false;
+        }
+        classes.push_back(taskClass);
+    }
+    if (classes.empty()) {
+        std::cerr << "error: no tasks found in the mix file: " << mixFileName << std::endl;
+        return false;
+    }
+    return true;
+}
+
+
+/// @return the value at 'fraction' of sorted 'vals', using the nearest rank.
+double percentile(std::vector<double> const& vals, double fraction) {
+    if (vals.empty()) return 0;
+    size_t rank = static_cast<size_t>(fraction * vals.size() + 0.999999);
+    return vals[std::min(vals.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+
+void printLatency(std::ostream& os, std::string const& name, std::vector<double> vals) {
+    std::sort(vals.begin(), vals.end());
+    os << "\"" << name << "\": {"
+       << "\"p50\": "  << percentile(vals, 0.50) << ", "
+       << "\"p90\": "  << percentile(vals, 0.90) << ", "
+       << "\"p99\": "  << percentile(vals, 0.99) << ", "
+       << "\"max\": "  << (vals.empty() ? 0 : vals.back()) << "}";
+}
+
+
+/// Print the summary of the samples of class 'classIdx', or of all samples if
+/// 'classIdx' is out of range, as a JSON object.
+void printSummary(std::ostream& os, std::vector<TaskSample> const& samples, size_t classIdx) {
+    std::vector<double> queue, exec, transmit, total;
+    size_t count = 0, errors = 0;
+    uint64_t rows = 0, bytes = 0;
+    for (auto const& sample : samples) {
+        if (classIdx != std::string::npos and sample.classIdx != classIdx) continue;
+        ++count;
+        if (not sample.ok) {
+            ++errors;
+            continue;
+        }
+        queue.push_back(sample.queueMs);
+        exec.push_back(sample.execMs);
+        transmit.push_back(sample.transmitMs);
+        total.push_back(sample.totalMs);
+        rows += sample.result.rows;
+        bytes += sample.result.bytes;
+    }
+    os << "{\"count\": " << count << ", \"errors\": " << errors
+       << ", \"rows\": " << rows << ", \"bytes\": " << bytes << ", ";
+    printLatency(os, "queue_ms", queue);
+    os << ", ";
+    printLatency(os, "exec_ms", exec);
+    os << ", ";
+    printLatency(os, "transmit_ms", transmit);
+    os << ", ";
+    printLatency(os, "total_ms", total);
+    os << "}";
+}
+
+
+/**
+ * Replay a mix of chunk queries against the workers at a controlled rate.
+ * The class of each task is drawn from the mix with a seeded generator, and
+ * each task gets its own query id, so a run with the same parameters sends
+ * the same sequence of tasks. The queueing and execution times come from the
+ * result headers sent by the worker, the transmit time is what remains of
+ * the time between submitting the request and receiving the last byte.
+ */
+int testTasks() {
+
+    std::vector<TaskClass> classes;
+    if (not readMixFile(classes)) return 1;
+    if (rate < 0 or not maxInFlight) {
+        std::cerr << "error: the rate can't be negative, and at least one task must be in flight" << std::endl;
+        return 1;
+    }
+
+    auto serviceProvider = connect();
+    if (serviceProvider == nullptr) return 1;
+
+    std::vector<double> weights;
+    for (auto const& taskClass : classes) weights.push_back(taskClass.weight);
+    std::mt19937 generator(seed);
+    std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+
+    std::vector<TaskSample> samples(numRequests);
+    std::vector<wpublish::TaskQservRequest::Ptr> requests;
+    requests.reserve(numRequests);
+    std::mutex samplesMtx;
+    std::atomic<unsigned int> inFlight(0);
+
+    using Clock = std::chrono::steady_clock;
+    auto const start = Clock::now();
+    auto sinceStart = [start](Clock::time_point const& tp) {
+        return std::chrono::duration<double>(tp - start).count();
+    };
+
+    util::BlockPost blockPost(1, 2);
+    for (unsigned int i = 0; i < numRequests; ++i) {
+
+        // Open loop at the requested rate, or as fast as the in-flight cap allows.
+        if (rate > 0) {
+            auto const due = start + std::chrono::duration_cast<Clock::duration>(
+                                         std::chrono::duration<double>(i / rate));
+            std::this_thread::sleep_until(due);
+        }
+        while (inFlight >= maxInFlight) {
+            blockPost.wait();
+        }
+
+        size_t const classIdx = pick(generator);
+        proto::TaskMsg msg = classes[classIdx].msg;
+        msg.set_queryid(queryIdBase + i);
+        msg.set_jobid(i);
+        msg.set_attemptcount(0);
+        std::string msgStr;
+        msg.SerializeToString(&msgStr);
+
+        auto const submitted = Clock::now();
+        {
+            std::lock_guard<std::mutex> lock(samplesMtx);
+            samples[i].classIdx = classIdx;
+            samples[i].submitSec = sinceStart(submitted);
+        }
+        auto request = wpublish::TaskQservRequest::create(
+            msgStr,
+            [i, submitted, &samples, &samplesMtx, &inFlight] (
+                    wpublish::TaskQservRequest::Status status,
+                    std::string const& error,
+                    wpublish::TaskQservRequest::Result const& result) {
+
+                double const totalMs = std::chrono::duration<double, std::milli>(
+                        Clock::now() - submitted).count();
+                {
+                    std::lock_guard<std::mutex> lock(samplesMtx);
+                    TaskSample& sample = samples[i];
+                    sample.ok = status == wpublish::TaskQservRequest::Status::SUCCESS;
+                    sample.error = error;
+                    sample.result = result;
+                    sample.queueMs = result.queueMillis;
+                    sample.execMs = result.runMillis;
+                    sample.totalMs = totalMs;
+                    sample.transmitMs = std::max(0.0, totalMs - sample.queueMs - sample.execMs);
+                }
+                inFlight--;
+            });
+        requests.push_back(request);
+
+        // Submit the request
+        inFlight++;
+        XrdSsiResource resource(global::ResourceUnit::makePath(msg.chunkid(), msg.db()));
+        serviceProvider->ProcessRequest(*request, resource);
+    }
+
+    // Block while at least one request is in progress
+    while (inFlight) {
+        blockPost.wait(200);
+    }
+    double const durationSec = sinceStart(Clock::now());
+
+    std::lock_guard<std::mutex> lock(samplesMtx);
+    if (not tasksFileName.empty()) {
+        std::ofstream tasksFile(tasksFileName);
+        tasksFile << "task,class,ok,submit_sec,queue_ms,exec_ms,transmit_ms,total_ms,messages,rows,bytes\n";
+        for (size_t i = 0; i < samples.size(); ++i) {
+            auto const& sample = samples[i];
+            tasksFile << i << "," << classes[sample.classIdx].name << "," << sample.ok << ","
+                      << sample.submitSec << "," << sample.queueMs << "," << sample.execMs << ","
+                      << sample.transmitMs << "," << sample.totalMs << "," << sample.result.messages << ","
+                      << sample.result.rows << "," << sample.result.bytes << "\n";
+        }
+    }
+    for (auto const& sample : samples) {
+        if (not sample.ok) {
+            std::cerr << "error: " << classes[sample.classIdx].name << " task failed: " << sample.error << "\n";
+        }
+    }
+
+    std::ofstream jsonFile;
+    if (not jsonFileName.empty()) jsonFile.open(jsonFileName);
+    std::ostream& os = jsonFileName.empty() ? std::cout : jsonFile;
+    os << "{\"tasks\": " << numRequests << ", \"seed\": " << seed
+       << ", \"rate\": " << rate << ", \"max_in_flight\": " << maxInFlight
+       << ", \"duration_sec\": " << durationSec
+       << ", \"achieved_rate\": " << (durationSec > 0 ? numRequests / durationSec : 0)
+       << ", \"all\": ";
+    printSummary(os, samples, std::string::npos);
+    os << ", \"classes\": {";
+    for (size_t j = 0; j < classes.size(); ++j) {
+        os << (j == 0 ? "" : ", ") << "\"" << classes[j].name << "\": ";
+        printSummary(os, samples, j);
+    }
+    os << "}}" << std::endl;
+    return 0;
+}
 } // namespace
 
 int main(int argc, const char* const argv[]) {
@@ -172,31 +456,62 @@ int main(int argc, const char* const argv[]) {
             argv,
             "\n"
             "Usage:\n"
-            "  <workers-file-name> <num-requests> <value>\n"
+            "  TEST_ECHO <workers-file-name> <num-requests> <value>\n"
+            "  TASKS     <mix-file-name> <num-requests>\n"
             "  [--service=<provider>]\n"
             "  [--num-workers=<value>]\n"
-            "  [--worker-first]\b"
+            "  [--worker-first]\n"
+            "  [--rate=<tasks-per-second>]\n"
+            "  [--max-in-flight=<value>]\n"
+            "  [--seed=<value>]\n"
+            "  [--query-id-base=<value>]\n"
+            "  [--json=<file>]\n"
+            "  [--tasks=<file>]\n"
             "\n"
             "Flags an options:\n"
-            "  --service=<provider>  - location of a service provider (default: 'localhost:1094')\n"
-            "  --num-workers=<value> - the number of workers (default: 1, range: 1..10)\n"
-            "  --worker-first        - iterate over workers, then over requests\n"
+            "  --service=<provider>      - location of a service provider (default: 'localhost:1094')\n"
+            "  --num-workers=<value>     - the number of workers (default: 1, range: 1..10)\n"
+            "  --worker-first            - iterate over workers, then over requests\n"
+            "  --rate=<tasks-per-second> - rate at which tasks are sent (default: 0, as fast as\n"
+            "                              the number of tasks in flight allows)\n"
+            "  --max-in-flight=<value>   - maximum number of tasks in flight (default: 100)\n"
+            "  --seed=<value>            - seed for drawing tasks from the mix (default: 1)\n"
+            "  --query-id-base=<value>   - query id of the first task, the next tasks get the\n"
+            "                              next ids (default: 1000000000)\n"
+            "  --json=<file>             - write the summary to the file instead of the standard output\n"
+            "  --tasks=<file>            - also write the measurements of each task as CSV\n"
             "\n"
             "Parameters:\n"
             "  <workers-file-name>  - a file with worker identifiers (one worker per line)\n"
-            "  <num-requests>       - chunk number\n"
+            "  <mix-file-name>      - a file with one '<class> <weight> <task-file>' line for\n"
+            "                         each kind of task in the mix, where the task file holds\n"
+            "                         a TaskMsg, serialized or as text if its name ends with '.txt'\n"
+            "  <num-requests>       - number of requests\n"
             "  <value>              - arbitrary string\n");
 
-        ::workersFileName = parser.parameter<std::string>(1);
-        ::numRequests     = parser.parameter<unsigned int>(2);
-        ::value           = parser.parameter<std::string>(3);
+        ::operation = parser.parameterRestrictedBy(1, {"TEST_ECHO", "TASKS"});
+        if (::operation == "TEST_ECHO") {
+            ::workersFileName = parser.parameter<std::string>(2);
+            ::numRequests     = parser.parameter<unsigned int>(3);
+            ::value           = parser.parameter<std::string>(4);
+        } else {
+            ::mixFileName     = parser.parameter<std::string>(2);
+            ::numRequests     = parser.parameter<unsigned int>(3);
+        }
 
         ::serviceProviderLocation = parser.option<std::string>("service", "localhost:1094");
         ::numWorkers              = parser.option<unsigned int>("num-workers", 1);
         ::workerFirst             = parser.flag("worker-first");
 
+        ::rate          = std::stod(parser.option<std::string>("rate", "0"));
+        ::maxInFlight   = parser.option<unsigned int>("max-in-flight", 100);
+        ::seed          = parser.option<unsigned int>("seed", 1);
+        ::queryIdBase   = std::stoull(parser.option<std::string>("query-id-base", "1000000000"));
+        ::jsonFileName  = parser.option<std::string>("json", "");
+        ::tasksFileName = parser.option<std::string>("tasks", "");
+
     } catch (std::exception const& ex) {
         return 1;
     }
-    return ::test();
+    return ::operation == "TEST_ECHO" ? ::testEcho() : ::testTasks();
 }
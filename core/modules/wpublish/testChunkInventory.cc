@@ -69,9 +69,17 @@ struct ChunkSql : public MockSql {
         if (startswith(query, "SELECT db FROM"))
             return std::make_shared<SqlIter>(_selectDbTuples.begin(),
                                              _selectDbTuples.end  ());
-        else if (startswith(query, "SELECT db,chunk FROM"))
-            return std::make_shared<SqlIter>(_selectChunkTuples.begin(),
-                                             _selectChunkTuples.end  ());
+        else if (startswith(query, "SELECT db,chunk FROM")) {
+            // Only the chunks of the database in "WHERE db='<db>'"
+            std::string::size_type const pos = query.find("db='") + 4;
+            std::string const db = query.substr(pos, query.find('\'', pos) - pos);
+            _dbChunkTuples.clear();
+            for (auto const& t: _selectChunkTuples) {
+                if (t[0] == db) _dbChunkTuples.push_back(t);
+            }
+            return std::make_shared<SqlIter>(_dbChunkTuples.begin(),
+                                             _dbChunkTuples.end  ());
+        }
         else if (startswith(query, "SELECT id FROM"))
             return std::make_shared<SqlIter>(_selectWorkerIdTuples.begin(),
                                              _selectWorkerIdTuples.end  ());
@@ -86,6 +94,7 @@ struct ChunkSql : public MockSql {
 
     TupleVector _selectDbTuples;
     TupleVector _selectChunkTuples;
+    TupleVector _dbChunkTuples;
     TupleVector _selectWorkerIdTuples;
 
 };
@@ -111,6 +120,30 @@ BOOST_AUTO_TEST_CASE(Test1) {
     BOOST_CHECK(!ci.has("LSST", 123));
 }
 
+BOOST_AUTO_TEST_CASE(ParsedPath) {
+    std::shared_ptr<ChunkSql> cs = std::make_shared<ChunkSql>(chunks, workerId);
+    ChunkInventory ci("test", cs);
+    lsst::qserv::ResourceUnit::DbChunkRef ref;
+    BOOST_REQUIRE(lsst::qserv::ResourceUnit::parseDbChunk(std::string("/chk/LSST/31415"), ref));
+    BOOST_CHECK(ci.has(ref));
+    int const id = ci.dbId("LSSTx", 4);
+    BOOST_CHECK(id >= 0);
+    BOOST_CHECK(ci.has(id, 1234567890));
+    BOOST_CHECK(!ci.has(id, 123));
+    BOOST_CHECK_EQUAL(ci.dbId("LSS", 3), -1);
+
+    // Many databases, the interned names grow and keep their numbers.
+    for (int j = 0; j < 100; ++j) {
+        ci.add("db" + std::to_string(j), j);
+    }
+    BOOST_CHECK_EQUAL(ci.dbId("LSST", 4), id);
+    for (int j = 0; j < 100; ++j) {
+        std::string const db = "db" + std::to_string(j);
+        BOOST_CHECK(ci.has(db, j));
+        BOOST_CHECK(!ci.has(db, j + 1));
+    }
+}
+
 BOOST_AUTO_TEST_CASE(Test2) {
     std::shared_ptr<ChunkSql> cs = std::make_shared<ChunkSql>(chunks, workerId);
     ChunkInventory ci("test", cs);
@@ -135,4 +168,57 @@ BOOST_AUTO_TEST_CASE(WorkerId) {
     BOOST_CHECK(ci.id() == "worker");
 }
 
+BOOST_AUTO_TEST_CASE(Incremental) {
+    std::shared_ptr<ChunkSql> cs = std::make_shared<ChunkSql>(chunks, workerId);
+    ChunkInventory ci("test", cs);
+    BOOST_CHECK(ci.changedDbs(*cs).empty());
+    auto const version = ci.version("LSST", 31415);
+
+    // A database newly published and one flagged by the chunk group commands
+    cs->_selectDbTuples.push_back({"Winter2012"});
+    cs->_selectChunkTuples = {{"LSST", "31415"}, {"LSST", "7"}, {"Winter2012", "123"}};
+    ci.add("Other", 1);
+    ci.markChanged("LSST");
+    ChunkInventory::DbSet const dbs = ci.changedDbs(*cs);
+    BOOST_CHECK(dbs == (ChunkInventory::DbSet{"LSST", "Other", "Winter2012"}));
+
+    ci.init(dbs, *cs);
+    ci.clearChanged(dbs);
+    BOOST_CHECK(ci.has("LSST", 31415));
+    BOOST_CHECK(ci.has("LSST", 7));
+    BOOST_CHECK(!ci.has("LSST", 1234567890));
+    BOOST_CHECK(ci.has("Winter2012", 123));
+    BOOST_CHECK(!ci.has("Other", 1)); // Not published
+    BOOST_CHECK(ci.version("LSST", 31415) != version);
+    BOOST_CHECK(ci.changedDbs(*cs).empty());
+    BOOST_CHECK_EQUAL(ci.existMap({"Winter2012"}).size(), 1U);
+
+    // A database published without chunks is only reported until cleared
+    cs->_selectDbTuples.push_back({"Empty"});
+    BOOST_CHECK(ci.changedDbs(*cs) == (ChunkInventory::DbSet{"Empty"}));
+    ci.clearChanged({"Empty"});
+    BOOST_CHECK(ci.changedDbs(*cs).empty());
+}
+
+BOOST_AUTO_TEST_CASE(Revision) {
+    std::shared_ptr<ChunkSql> cs = std::make_shared<ChunkSql>(chunks, workerId);
+    ChunkInventory ci("test", cs);
+    auto revision = ci.revision();
+    BOOST_CHECK(revision != 0);
+
+    ci.add("LSST", 7);
+    BOOST_CHECK(ci.revision() != revision);
+    revision = ci.revision();
+
+    // Removing a chunk which isn't there changes nothing
+    ci.remove("LSST", 123);
+    BOOST_CHECK_EQUAL(ci.revision(), revision);
+    ci.remove("LSST", 7);
+    BOOST_CHECK(ci.revision() != revision);
+    revision = ci.revision();
+
+    ci.init({"LSST"}, *cs);
+    BOOST_CHECK(ci.revision() != revision);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
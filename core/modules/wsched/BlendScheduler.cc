@@ -34,6 +34,7 @@
 
 // System headers
 #include <algorithm>
+#include <chrono>
 #include <cstddef>
 #include <iostream>
 #include <mutex>
@@ -58,6 +59,9 @@ inline Sched* other(Sched* notThis, Sched* a, Sched* b) {
 
 namespace {
 LOG_LOGGER _log = LOG_GET("lsst.qserv.wsched.BlendScheduler");
+
+/// Sampled timing of the scheduler mutex, util::CommandQueue::_mx.
+lsst::qserv::util::LockTiming schedLockTiming("blend_scheduler");
 }
 
 namespace lsst {
@@ -92,6 +96,7 @@ BlendScheduler::BlendScheduler(std::string const& name,
     }
     _schedulers.push_back(_scanSnail);
     _scanSnail->setDefaultPosition(position++);
+    _scanSnail->setBlendScheduler(this);
     assert(_schedulers.size() >= 2); // Must have at least _group and _scanSnail in the list.
     _sortScanSchedulers();
     for (auto sched : _schedulers) {
@@ -149,10 +154,10 @@ void BlendScheduler::queCmd(util::Command::Ptr const& cmd) {
     if (task == nullptr) {
         LOGS(_log, LOG_LVL_INFO, "BlendScheduler::queCmd got control command");
         {
-            util::LockGuardTimed guard(util::CommandQueue::_mx, "BlendScheduler::queCmd a");
+            util::LockGuardTimed guard(util::CommandQueue::_mx, schedLockTiming);
             _ctrlCmdQueue.queCmd(cmd);
         }
-        notify(true);
+        notify(false);
         return;
     }
     if (task->msg == nullptr) {
@@ -160,7 +165,7 @@ void BlendScheduler::queCmd(util::Command::Ptr const& cmd) {
     }
     LOGS(_log, LOG_LVL_DEBUG, "BlendScheduler::queCmd " << task->getIdStr());
 
-    util::LockGuardTimed guard(util::CommandQueue::_mx, "BlendScheduler::queCmd b");
+    util::LockGuardTimed guard(util::CommandQueue::_mx, schedLockTiming);
     // Check for scan tables
     SchedulerBase::Ptr s{nullptr};
     auto const& scanTables = task->getScanInfo().infoTables;
@@ -192,6 +197,22 @@ void BlendScheduler::queCmd(util::Command::Ptr const& cmd) {
                 }
             }
         }
+        // What past tasks on the slowest table took on this worker beats the rating
+        // the czar guessed, as the query would be booted from a scheduler that is too fast.
+        auto const& slowest = scanTables.front();
+        double scanMinutes = _queries->predictScanMinutes(
+            wpublish::ChunkTableStats::makeTableName(slowest.db, slowest.table));
+        if (scanMinutes >= 0) {
+            auto byTime = _getScanForMinutes(scanMinutes);
+            if (byTime != s) {
+                LOGS(_log, LOG_LVL_DEBUG, task->getIdStr() << " predicted scan minutes=" << scanMinutes
+                     << " moves task from " << (s == nullptr ? "none" : s->getName())
+                     << " to " << byTime->getName());
+                s = byTime;
+            }
+        }
+        task->setPredictedMinutes(_queries->predictTaskMinutes(task));
+
         // If the user query for this task has been booted, put this task on the snail scheduler.
         auto queryStats = _queries->getStats(task->getQueryId());
         if (queryStats && queryStats->getQueryBooted()) {
@@ -211,9 +232,30 @@ void BlendScheduler::queCmd(util::Command::Ptr const& cmd) {
     s->queCmd(task);
     _queries->queuedTask(task);
     _infoChanged = true;
-    notify(true);
+    notify(false);
+}
+
+/// @return the fastest ScanScheduler that is expected to finish a scan taking
+///         'minutes' in its time limit, or _scanSnail if there is none.
+/// Precondition util::CommandQueue::_mx must be locked when this is called.
+SchedulerBase::Ptr BlendScheduler::_getScanForMinutes(double minutes) {
+    ScanScheduler::Ptr best;
+    for (auto const& sched : _schedulers) {
+        auto scan = std::dynamic_pointer_cast<ScanScheduler>(sched);
+        if (scan == nullptr || scan == _scanSnail || scan->getMaxTimeMinutes() < minutes) {
+            continue;
+        }
+        if (best == nullptr || scan->getMaxTimeMinutes() < best->getMaxTimeMinutes()) {
+            best = scan;
+        }
+    }
+    if (best == nullptr) {
+        return _scanSnail;
+    }
+    return best;
 }
 
+
 void BlendScheduler::commandStart(util::Command::Ptr const& cmd) {
     auto t = std::dynamic_pointer_cast<wbase::Task>(cmd);
     if (t == nullptr) {
@@ -239,6 +281,21 @@ void BlendScheduler::commandFinish(util::Command::Ptr const& cmd) {
         LOGS(_log, LOG_LVL_WARN, "BlendScheduler::commandFinish cmd failed conversion");
         return;
     }
+    {
+        std::lock_guard<std::mutex> lock(util::CommandQueue::_mx);
+        _lentTasks.erase(t.get()); // The thread goes back to the sub-scheduler that reserved it.
+    }
+    if (t->hasDeadline()) {
+        auto now = std::chrono::system_clock::now();
+        if (now > t->getDeadline()) {
+            ++_deadlinesMissed;
+            LOGS(_log, LOG_LVL_INFO, t->getIdStr() << " missed its deadline by "
+                 << std::chrono::duration_cast<std::chrono::milliseconds>(now - t->getDeadline()).count()
+                 << "ms, missed=" << _deadlinesMissed << " met=" << _deadlinesMet);
+        } else {
+            ++_deadlinesMet;
+        }
+    }
     wcontrol::Scheduler::Ptr s = std::dynamic_pointer_cast<wcontrol::Scheduler>(t->getTaskScheduler());
     LOGS(_log, LOG_LVL_DEBUG, "BlendScheduler::commandFinish " << t->getIdStr());
     if (s != nullptr) {
@@ -249,14 +306,14 @@ void BlendScheduler::commandFinish(util::Command::Ptr const& cmd) {
     _infoChanged = true;
     _logChunkStatus();
     _queries->finishedTask(t);
-    notify(true);
+    notify(false);
 }
 
 
 bool BlendScheduler::ready() {
     bool ready = false;
     {
-        util::LockGuardTimed guard(util::CommandQueue::_mx, "BlendScheduler::ready");
+        util::LockGuardTimed guard(util::CommandQueue::_mx, schedLockTiming);
         ready = _ready();
     }
     if (ready) {
@@ -297,6 +354,14 @@ bool BlendScheduler::_ready() {
         }
     }
 
+    if (!ready) {
+        ready = _readyForDeadline();
+    }
+
+    if (!ready) {
+        ready = _readyToLend();
+    }
+
     if (!ready) {
         ready = _ctrlCmdQueue.ready();
     }
@@ -307,24 +372,86 @@ bool BlendScheduler::_ready() {
 }
 
 
+/// @return true if _group has a Task whose deadline is at risk and a thread is
+///         not running any Task, setting _readySched to _group.
+/// Thread reserves are ignored, but the Task does not take a thread that is in use.
+/// Precondition util::CommandQueue::_mx must be locked when this is called.
+bool BlendScheduler::_readyForDeadline() {
+    if (_group == nullptr) {
+        return false;
+    }
+    int inFlight = 0;
+    for (auto const& sched : _schedulers) {
+        inFlight += sched->getInFlight();
+    }
+    if (inFlight >= _schedMaxThreads || !_group->readyForDeadline()) {
+        return false;
+    }
+    LOGS(_log, LOG_LVL_DEBUG, "deadline at risk on " << _group->getName() << " inFlight=" << inFlight);
+    _readySched = _group;
+    _readySchedDeadline = true;
+    return true;
+}
+
+
+/// @return true if a ScanScheduler can run a Task in a thread reserved by a
+///         sub-scheduler that has nothing queued, setting _readySched to it.
+/// Precondition util::CommandQueue::_mx must be locked when this is called.
+bool BlendScheduler::_readyToLend() {
+    int maxLent = _maxLentThreads;
+    if (maxLent <= 0 || static_cast<int>(_lentTasks.size()) >= maxLent) {
+        return false;
+    }
+    // Threads reserved beyond the Tasks a sub-scheduler has in flight are idle
+    // until it gets new Tasks.
+    int idleReserve = 0;
+    for (auto const& sched : _schedulers) {
+        if (sched->getSize() == 0) {
+            idleReserve += std::max(0, sched->desiredThreadReserve() - sched->getInFlight());
+        }
+    }
+    if (idleReserve - static_cast<int>(_lentTasks.size()) <= 0) {
+        return false;
+    }
+    for (auto const& sched : _schedulers) {
+        auto scan = std::dynamic_pointer_cast<ScanScheduler>(sched);
+        if (scan != nullptr && scan->getSize() > 0 && scan->readyToBorrow()) {
+            LOGS(_log, LOG_LVL_DEBUG, "lending thread to " << scan->getName() << " idleReserve="
+                 << idleReserve << " lent=" << _lentTasks.size());
+            _readySched = scan;
+            _readySchedBorrows = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+
 util::Command::Ptr BlendScheduler::getCmd(bool wait) {
+    // Only sampled calls are timed, the time spent waiting on _cv is
+    // not counted as held.
+    bool const timed = schedLockTiming.sample();
     util::Timer timeToLock;
     util::Timer timeHeld;
     util::Command::Ptr cmd;
     double totalTimeHeld = 0.0;
     bool ready = false;
     {
-        timeToLock.start();
+        if (timed) timeToLock.start();
         std::unique_lock<std::mutex> lock(util::CommandQueue::_mx);
-        timeToLock.stop();
-        timeHeld.start();
+        if (timed) {
+            timeToLock.stop();
+            timeHeld.start();
+        }
         if (wait) {
             // util::CommandQueue::_cv.wait(lock, [this](){return _ready();});
             while (!_ready()) {
-                timeHeld.stop();
-                totalTimeHeld += timeHeld.getElapsed();
+                if (timed) {
+                    timeHeld.stop();
+                    totalTimeHeld += timeHeld.getElapsed();
+                }
                 util::CommandQueue::_cv.wait(lock);
-                timeHeld.start();
+                if (timed) timeHeld.start();
             }
             ready = true;
         } else {
@@ -333,10 +460,28 @@ util::Command::Ptr BlendScheduler::getCmd(bool wait) {
 
         // Try to get a command from the schedulers
         if (ready && (_readySched != nullptr)) {
-            cmd = _readySched->getCmd(false);
+            auto scan = std::dynamic_pointer_cast<ScanScheduler>(_readySched);
+            if (_readySchedBorrows && scan != nullptr) {
+                cmd = scan->getBorrowedCmd();
+                if (cmd != nullptr) {
+                    _lentTasks.insert(cmd.get());
+                }
+            } else if (_readySchedDeadline) {
+                cmd = _group->getDeadlineCmd();
+                if (cmd != nullptr) {
+                    ++_deadlinePreempts;
+                }
+            } else {
+                cmd = _readySched->getCmd(false);
+            }
+            _readySchedBorrows = false;
+            _readySchedDeadline = false;
             if (cmd != nullptr) {
                 LOGS(_log, LOG_LVL_DEBUG, "Blend getCmd() using cmd from " << _readySched->getName());
                 wbase::Task::Ptr task = std::dynamic_pointer_cast<wbase::Task>(cmd);
+                if (task != nullptr) {
+                    task->setSubChunkThreads(_calcSubChunkThreads());
+                }
             }
             _readySched.reset();
             _sortScanSchedulers();
@@ -347,17 +492,23 @@ util::Command::Ptr BlendScheduler::getCmd(bool wait) {
             // which could change the size of the pool.
             cmd = _ctrlCmdQueue.getCmd();
         }
+        if (timed) {
+            timeHeld.stop();
+            totalTimeHeld += timeHeld.getElapsed();
+        }
+    }
+    if (timed) {
+        schedLockTiming.addWait(timeToLock.getElapsed());
+        schedLockTiming.addHeld(totalTimeHeld);
     }
     if (cmd != nullptr) {
         _infoChanged = true;
         _logChunkStatus();
-        notify(true);
+        // Threads wait for _ready(), so one is woken at a time: if it finds
+        // a command it wakes the next one here, otherwise none would.
+        notify(false);
     }
     // returning nullptr is acceptable.
-    timeHeld.stop();
-    totalTimeHeld += timeHeld.getElapsed();
-    LOGS(_log, LOG_LVL_DEBUG, "lockTime BlendScheduler::getCmd ready toLock=" << timeToLock.getElapsed() <<
-                              " held=" << timeHeld.getElapsed() << " totalHeld=" << totalTimeHeld);
     return cmd;
 }
 
@@ -372,6 +523,23 @@ int BlendScheduler::_getAdjustedMaxThreads(int oldAdjMax, int inFlight) {
     return newAdjMax;
 }
 
+/// Precondition: util::CommandQueue::_mx must be locked.
+/// @return the number of connections the subchunk queries of the Task being
+///         started may use: one plus the pool threads no Task is using, up to
+///         _maxSubChunkThreads.
+int BlendScheduler::_calcSubChunkThreads() {
+    int maxThreads = _maxSubChunkThreads;
+    if (maxThreads <= 1) {
+        return 1;
+    }
+    int inFlight = 0;
+    for (auto const& sched : _schedulers) {
+        inFlight += sched->getInFlight();
+    }
+    int idle = _schedMaxThreads - inFlight; // The Task being started is already in flight.
+    return std::max(1, std::min(maxThreads, 1 + idle));
+}
+
 /// @return the number of threads that are not reserved by any sub-scheduler.
 int BlendScheduler::calcAvailableTheads() {
     int reserve = 0;
@@ -395,6 +563,67 @@ std::size_t BlendScheduler::getSize() const {
     return sz;
 }
 
+BlendScheduler::DeadlineStats BlendScheduler::getDeadlineStats() const {
+    DeadlineStats stats;
+    stats.met = _deadlinesMet;
+    stats.missed = _deadlinesMissed;
+    stats.preempted = _deadlinePreempts;
+    return stats;
+}
+
+
+void BlendScheduler::setMaxThreads(int maxThreads) {
+    {
+        std::lock_guard<std::mutex> lock(util::CommandQueue::_mx);
+        _schedMaxThreads = maxThreads;
+        for (auto const& sched : _schedulers) {
+            sched->setMaxThreads(maxThreads);
+        }
+    }
+    LOGS(_log, LOG_LVL_INFO, "BlendScheduler maxThreads=" << maxThreads);
+    limitsChanged();
+}
+
+
+void BlendScheduler::limitsChanged() {
+    _infoChanged = true;
+    {
+        // Taking the lock keeps the notification from falling between a
+        // waiting thread's check of _ready() and its wait.
+        std::lock_guard<std::mutex> lock(util::CommandQueue::_mx);
+    }
+    util::CommandQueue::_cv.notify_all();
+}
+
+
+/// Returns the number of Tasks running in lent threads.
+void BlendScheduler::setPreemption(std::chrono::milliseconds after, std::chrono::milliseconds maxPause) {
+    _preemptAfter = after;
+    _preemptMaxPause = maxPause;
+}
+
+
+bool BlendScheduler::preemptScan() {
+    auto const after = _preemptAfter.load();
+    return after.count() > 0 && _group->preemptFor(after);
+}
+
+
+void BlendScheduler::waitPreempted() {
+    _group->waitForLate(_preemptAfter, _preemptMaxPause);
+}
+
+
+uint64_t BlendScheduler::getScanPreempts() const {
+    return _group->getPreempts();
+}
+
+
+int BlendScheduler::getLentThreads() const {
+    std::lock_guard<std::mutex> lock(util::CommandQueue::_mx);
+    return _lentTasks.size();
+}
+
 /// Returns the number of Tasks inFlight.
 int BlendScheduler::getInFlight() const {
     std::lock_guard<std::mutex> lock(util::CommandQueue::_mx);
@@ -458,6 +687,20 @@ int BlendScheduler::moveUserQuery(QueryId qId, SchedulerBase::Ptr const& source,
 }
 
 
+int BlendScheduler::cancelQuery(QueryId qId) {
+    // Each sub-scheduler locks its own queue, _mx is not needed.
+    int count = 0;
+    for (auto const& sched : _schedulers) {
+        count += sched->cancelQuery(qId);
+    }
+    _infoChanged = true;
+    if (count > 0) {
+        notify(true); // Each pool thread can take one of them.
+    }
+    return count;
+}
+
+
 void ControlCommandQueue::queCmd(util::Command::Ptr const& cmd) {
     std::lock_guard<std::mutex> lock{_mx};
     _qu.push_back(cmd);
@@ -24,7 +24,11 @@
 #define LSST_QSERV_WSCHED_BLENDSCHEDULER_H
 
 // System headers
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <map>
+#include <set>
 
 // Qserv headers
 #include "wpublish/QueriesAndChunks.h"
@@ -92,6 +96,28 @@ private:
 /// Secondly, the ScanScheduler schedulers are only allowed to advance to a new chunk
 /// if resources are available to read the chunk into memory, or if the sub-scheduler
 /// has no Tasks inFlight.
+///
+/// ScanScheduler Tasks go to the scheduler matching their scan rating, unless
+/// past Tasks on the slowest table show that scanning it takes longer, or
+/// shorter, than that scheduler allows.
+///
+/// Lastly, the threads reserved by sub-schedulers with nothing queued can be lent,
+/// up to _maxLentThreads, to ScanSchedulers with Tasks for chunks they already have
+/// in memory. Lent threads are only used when no sub-scheduler is ready on its own,
+/// so a sub-scheduler that gets new Tasks has its thread back once a borrowed Task
+/// finishes.
+///
+/// Tasks of interactive queries may come with a deadline. When one of them has used
+/// half of its time on the _group queue, it is run in any thread that is not
+/// running a Task, even one reserved by another sub-scheduler. The number of
+/// deadlines met and missed is kept for monitoring.
+///
+/// When interactive Tasks have waited longer than a latency target for a thread,
+/// Tasks of the ScanSchedulers running between two result messages may be
+/// preempted for them, one scan Task for each waiting Task. A preempted Task
+/// leaves the pool, a new thread taking its place, and pauses until the
+/// interactive Tasks have started, keeping its MySQL result and its tables
+/// locked, then resumes out of the pool like Tasks with large results do.
 class BlendScheduler : public wsched::SchedulerBase {
 public:
     using Ptr = std::shared_ptr<BlendScheduler>;
@@ -125,16 +151,58 @@ public:
     int moveUserQueryToSnail(QueryId qId, SchedulerBase::Ptr const& source);
     int moveUserQuery(QueryId qId, SchedulerBase::Ptr const& source, SchedulerBase::Ptr const& destination);
 
+    /// Cancel the queued Tasks of 'qId' on all the sub-schedulers.
+    int cancelQuery(QueryId qId) override;
+
     void setPrioritizeByInFlight(bool val) { _prioritizeByInFlight = val; }
 
+    /// Set the maximum number of reserved threads lent to busy ScanSchedulers, 0 disables lending.
+    void setMaxLentThreads(int val) { _maxLentThreads = val; }
+    int getLentThreads() const;
+
+    /// Set the maximum number of connections the subchunk queries of one Task
+    /// may run on at once. Tasks only get more than one while pool threads are idle.
+    void setMaxSubChunkThreads(int val) { _maxSubChunkThreads = val; }
+
+    /// Change the number of threads the Tasks run in, for this scheduler and
+    /// its sub-schedulers, as the thread pool is resized.
+    void setMaxThreads(int maxThreads);
+    int getMaxThreads() const { return _schedMaxThreads; }
+
+    /// Wake the threads waiting for a Task, to check again whether one is
+    /// ready after the limits of the sub-schedulers were changed.
+    void limitsChanged();
+
+    /// Deadline statistics of the Tasks that finished.
+    struct DeadlineStats {
+        uint64_t met{0};      ///< Tasks finished by their deadline.
+        uint64_t missed{0};   ///< Tasks finished after their deadline.
+        uint64_t preempted{0}; ///< Tasks started in a thread reserved by another scheduler.
+    };
+    DeadlineStats getDeadlineStats() const;
+
+    /// Preempt scan Tasks for the interactive Tasks queued for longer than
+    /// 'after', pausing them for at most 'maxPause'. 0 disables preemption.
+    void setPreemption(std::chrono::milliseconds after, std::chrono::milliseconds maxPause);
+    /// @return true if a scan Task should yield its thread, see GroupScheduler::preemptFor().
+    bool preemptScan();
+    /// Pause a preempted scan Task, see GroupScheduler::waitForLate().
+    void waitPreempted();
+    /// @return the number of scan Tasks preempted for interactive Tasks.
+    uint64_t getScanPreempts() const;
+
 private:
     int _getAdjustedMaxThreads(int oldAdjMax, int inFlight);
     bool _ready();
+    bool _readyToLend();
+    bool _readyForDeadline();
+    SchedulerBase::Ptr _getScanForMinutes(double minutes);
     void _sortScanSchedulers();
     void _logChunkStatus();
+    int _calcSubChunkThreads();
     ControlCommandQueue _ctrlCmdQueue; ///< Needed for changing thread pool size.
 
-    int _schedMaxThreads; ///< maximum number of threads that can run.
+    std::atomic<int> _schedMaxThreads; ///< maximum number of threads that can run.
 
     // Sub-schedulers.
     std::shared_ptr<GroupScheduler> _group;    ///< group scheduler
@@ -147,6 +215,19 @@ private:
 
     std::atomic<bool> _prioritizeByInFlight{false}; // Schedulers with more tasks inflight get lower priority.
     SchedulerBase::Ptr _readySched; //< Pointer to the scheduler with a ready task.
+    bool _readySchedBorrows{false}; //< True if the task of _readySched runs in a lent thread.
+    bool _readySchedDeadline{false}; //< True if the task of _readySched has its deadline at risk.
+
+    std::atomic<int> _maxLentThreads{0}; //< Maximum number of reserved threads lent at one time.
+    std::set<util::Command const*> _lentTasks; //< Tasks running in lent threads, protected by _mx.
+    std::atomic<int> _maxSubChunkThreads{1}; //< Maximum connections for the subchunk queries of a Task.
+
+    std::atomic<uint64_t> _deadlinesMet{0};
+    std::atomic<uint64_t> _deadlinesMissed{0};
+    std::atomic<uint64_t> _deadlinePreempts{0};
+
+    std::atomic<std::chrono::milliseconds> _preemptAfter{std::chrono::milliseconds(0)}; //< 0 disables preemption.
+    std::atomic<std::chrono::milliseconds> _preemptMaxPause{std::chrono::milliseconds(0)};
 };
 
 }}} // namespace lsst::qserv::wsched
@@ -0,0 +1,303 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "wsched/ChunkDevicesQueue.h"
+
+// System headers
+#include <algorithm>
+#include <fstream>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+namespace {
+LOG_LOGGER _log = LOG_GET("lsst.qserv.wsched.ChunkDevicesQueue");
+
+/// @return true if the block device 'major:minor', or the disk holding
+///         that partition, is flagged as rotational.
+bool isRotational(unsigned int major, unsigned int minor) {
+    std::string const dir = "/sys/dev/block/" + std::to_string(major) + ":" + std::to_string(minor);
+    for (auto const& path : {dir + "/queue/rotational", dir + "/../queue/rotational"}) {
+        std::ifstream is(path);
+        int flag = 0;
+        if (is >> flag) return flag != 0;
+    }
+    return false;
+}
+
+} // anonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace wsched {
+
+
+ChunkDevicesQueue::ChunkDevicesQueue(SchedulerBase* scheduler, memman::MemMan::Ptr const& memMan,
+                                     DeviceLookup const& lookup, int maxChunksRotational)
+    : _memMan{memMan}, _lookup{lookup}, _maxChunksRotational{std::max(1, maxChunksRotational)},
+      _scheduler{scheduler} {
+    if (_lookup == nullptr) {
+        auto mm = _memMan;
+        _lookup = [mm](wbase::Task::Ptr const& task) {
+            auto const& tables = task->getScanInfo().infoTables;
+            if (tables.empty()) return DeviceInfo();
+            auto const& tbl = tables.front();
+            return deviceOfFile(mm->filePath(tbl.db + "/" + tbl.table, task->getChunkId()));
+        };
+    }
+}
+
+
+ChunkDevicesQueue::DeviceInfo ChunkDevicesQueue::deviceOfFile(std::string const& path) {
+    DeviceInfo info;
+    struct stat sBuff;
+    if (path.empty() || stat(path.c_str(), &sBuff) != 0) {
+        return info;
+    }
+    info.id = sBuff.st_dev;
+    info.rotational = isRotational(major(sBuff.st_dev), minor(sBuff.st_dev));
+    return info;
+}
+
+
+/// Queue a Task on the device holding its chunk.
+void ChunkDevicesQueue::queueTask(wbase::Task::Ptr const& task) {
+    std::lock_guard<std::mutex> lock(_mx);
+    _deviceFor(task)->queue->queueTask(task);
+    ++_taskCount;
+}
+
+
+/// Precondition: _mx must be locked.
+/// @return the device of the chunk of 'task', looking it up the first time
+///         the chunk is seen.
+ChunkDevicesQueue::Device::Ptr ChunkDevicesQueue::_deviceFor(wbase::Task::Ptr const& task) {
+    int chunkId = task->getChunkId();
+    auto iter = _chunkDevices.find(chunkId);
+    if (iter != _chunkDevices.end()) {
+        return iter->second;
+    }
+    DeviceInfo info = _lookup(task);
+    auto& device = _devices[info.id];
+    if (device == nullptr) {
+        device = std::make_shared<Device>(info, std::make_shared<ChunkTasksQueue>(_scheduler, _memMan));
+        LOGS(_log, LOG_LVL_INFO, "new device=" << info.id << " rotational=" << info.rotational
+             << " for chunk=" << chunkId);
+    }
+    _chunkDevices[chunkId] = device;
+    return device;
+}
+
+
+/// Precondition: _mx must be locked.
+ChunkDevicesQueue::Device::Ptr ChunkDevicesQueue::_findDevice(int chunkId) const {
+    auto iter = _chunkDevices.find(chunkId);
+    return (iter == _chunkDevices.end()) ? nullptr : iter->second;
+}
+
+
+/// Precondition: _mx must be locked.
+/// @return true if starting a Task on 'chunkId' would read more chunks from
+///         'device', or be on more chunks for the scheduler, than allowed.
+bool ChunkDevicesQueue::_overSubscribed(Device const& device, int chunkId) const {
+    if (device.chunksInFlight.count(chunkId) > 0) {
+        return false;
+    }
+    if (device.info.rotational
+          && static_cast<int>(device.chunksInFlight.size()) >= _maxChunksRotational) {
+        return true;
+    }
+    // Each device has its own active chunk, which ChunkTasksQueue does not
+    // count against the scheduler's limit.
+    return _scheduler != nullptr
+           && _scheduler->getActiveChunkCount() >= _scheduler->getMaxActiveChunks()
+           && !_scheduler->chunkAlreadyActive(chunkId);
+}
+
+
+bool ChunkDevicesQueue::ready(bool useFlexibleLock) {
+    std::lock_guard<std::mutex> lock(_mx);
+    return _ready(useFlexibleLock);
+}
+
+
+/// Precondition: _mx must be locked.
+/// @return true if a device has a Task ready to run, with _readyDevice pointing at it.
+/// A device whose ready Task is on a chunk that would over-subscribe it keeps
+/// that Task, and its memory reservation, until the device can take the chunk.
+bool ChunkDevicesQueue::_ready(bool useFlexibleLock) {
+    if (_readyDevice != nullptr) {
+        return true;
+    }
+    std::vector<Device::Ptr> devices;
+    for (auto const& elem : _devices) {
+        if (!elem.second->queue->empty()) devices.push_back(elem.second);
+    }
+    std::sort(devices.begin(), devices.end(), [](Device::Ptr const& x, Device::Ptr const& y) {
+        if (x->chunksInFlight.size() != y->chunksInFlight.size()) {
+            return x->chunksInFlight.size() < y->chunksInFlight.size();
+        }
+        if (x->queue->getSize() != y->queue->getSize()) {
+            return x->queue->getSize() > y->queue->getSize();
+        }
+        return x->bytesPerSec() < y->bytesPerSec();
+    });
+    for (auto const& device : devices) {
+        if (!device->queue->ready(useFlexibleLock)) continue;
+        if (_overSubscribed(*device, device->queue->getReadyChunkId())) continue;
+        _readyDevice = device;
+        return true;
+    }
+    return false;
+}
+
+
+wbase::Task::Ptr ChunkDevicesQueue::getTask(bool useFlexibleLock) {
+    std::lock_guard<std::mutex> lock(_mx);
+    if (!_ready(useFlexibleLock)) {
+        return nullptr;
+    }
+    auto device = _readyDevice;
+    _readyDevice = nullptr;
+    auto task = device->queue->getTask(useFlexibleLock);
+    if (task != nullptr) {
+        --_taskCount;
+        ++device->chunksInFlight[task->getChunkId()];
+        ++device->tasksInFlight;
+    }
+    return task;
+}
+
+
+/// @return true if every device will provide its next Task from a different chunk.
+bool ChunkDevicesQueue::nextTaskDifferentChunkId() {
+    std::lock_guard<std::mutex> lock(_mx);
+    for (auto const& elem : _devices) {
+        if (!elem.second->queue->nextTaskDifferentChunkId()) return false;
+    }
+    return true;
+}
+
+
+/// This is called when a Task finishes. The locking throughput of a chunk is
+/// added to its device once the last Task in flight on it finishes, as the
+/// Tasks on a chunk share the same locked files.
+void ChunkDevicesQueue::taskComplete(wbase::Task::Ptr const& task) {
+    std::lock_guard<std::mutex> lock(_mx);
+    int chunkId = task->getChunkId();
+    auto device = _findDevice(chunkId);
+    if (device == nullptr) {
+        return;
+    }
+    device->queue->taskComplete(task);
+    auto iter = device->chunksInFlight.find(chunkId);
+    if (iter == device->chunksInFlight.end()) {
+        return;
+    }
+    --device->tasksInFlight;
+    if (--iter->second <= 0) {
+        device->chunksInFlight.erase(iter);
+        auto status = _memMan->getStatus(task->getMemHandle());
+        device->bytesLocked += status.bytesLock;
+        device->secondsLocked += status.secondsLock;
+    }
+}
+
+
+bool ChunkDevicesQueue::setResourceStarved(bool starved) {
+    std::lock_guard<std::mutex> lock(_mx);
+    bool ret = _resourceStarved;
+    _resourceStarved = starved;
+    for (auto const& elem : _devices) {
+        elem.second->queue->setResourceStarved(starved);
+    }
+    return ret;
+}
+
+
+wbase::Task::Ptr ChunkDevicesQueue::removeTask(wbase::Task::Ptr const& task) {
+    std::lock_guard<std::mutex> lock(_mx);
+    auto device = _findDevice(task->getChunkId());
+    if (device == nullptr) {
+        return nullptr;
+    }
+    auto ret = device->queue->removeTask(task);
+    if (ret != nullptr) {
+        --_taskCount;
+    }
+    return ret;
+}
+
+
+std::vector<wbase::Task::Ptr> ChunkDevicesQueue::removeQuery(QueryId qId) {
+    std::lock_guard<std::mutex> lock(_mx);
+    std::vector<wbase::Task::Ptr> removed;
+    for (auto const& elem : _devices) {
+        auto tasks = elem.second->queue->removeQuery(qId);
+        removed.insert(removed.end(), tasks.begin(), tasks.end());
+    }
+    _taskCount -= removed.size();
+    if (_readyDevice != nullptr && _readyDevice->queue->getReadyChunkId() < 0) {
+        _readyDevice = nullptr; // Its ready Task was removed.
+    }
+    return removed;
+}
+
+
+/// Each device is scanned on its own, the cursor is the one of the device of 'chunkId'.
+int ChunkDevicesQueue::getScanCursor(int chunkId) {
+    std::lock_guard<std::mutex> lock(_mx);
+    auto device = _findDevice(chunkId);
+    return (device == nullptr) ? -1 : device->queue->getActiveChunkId();
+}
+
+
+bool ChunkDevicesQueue::empty() const {
+    std::lock_guard<std::mutex> lock(_mx);
+    for (auto const& elem : _devices) {
+        if (!elem.second->queue->empty()) return false;
+    }
+    return true;
+}
+
+
+std::vector<ChunkDevicesQueue::DeviceStats> ChunkDevicesQueue::getDeviceStats() const {
+    std::lock_guard<std::mutex> lock(_mx);
+    std::vector<DeviceStats> stats;
+    for (auto const& elem : _devices) {
+        Device const& device = *elem.second;
+        DeviceStats ds;
+        ds.info = device.info;
+        ds.chunksInFlight = device.chunksInFlight.size();
+        ds.tasksInFlight = device.tasksInFlight;
+        ds.queued = device.queue->getSize();
+        ds.bytesPerSec = device.bytesPerSec();
+        stats.push_back(ds);
+    }
+    return stats;
+}
+
+}}} // namespace lsst::qserv::wsched
@@ -0,0 +1,141 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_WSCHED_CHUNKDEVICESQUEUE_H
+#define LSST_QSERV_WSCHED_CHUNKDEVICESQUEUE_H
+
+// System headers
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "memman/MemMan.h"
+#include "wbase/Task.h"
+#include "wsched/ChunkTaskCollection.h"
+#include "wsched/ChunkTasksQueue.h"
+#include "wsched/SchedulerBase.h"
+
+namespace lsst {
+namespace qserv {
+namespace wsched {
+
+/// This class queues Tasks by the block device holding their chunk, with
+/// one ChunkTasksQueue per device, so that chunks on different devices are
+/// read at the same time while a device is not asked to read more chunks
+/// than it can stream.
+/// - The device of a chunk is the device of the data file of the first
+///   scan table of its first Task, as named by MemMan::filePath().
+///   Chunks without a file, as with MemManNone, all go to one device.
+/// - A rotational device only has one chunk in flight at a time, as a
+///   second one would make it seek between the two. Other devices are only
+///   limited by the scheduler's maximum number of active chunks.
+/// - Devices with the fewest chunks in flight are served first, then the
+///   ones with the most queued Tasks, and then the ones with the lowest
+///   throughput, so that the slowest work is started first.
+class ChunkDevicesQueue : public ChunkTaskCollection {
+public:
+    using Ptr = std::shared_ptr<ChunkDevicesQueue>;
+
+    /// Block device holding a file.
+    struct DeviceInfo {
+        int64_t id{-1};         ///< st_dev of the file, -1 if unknown.
+        bool rotational{false}; ///< True for a spinning disk.
+    };
+
+    /// Function returning the device to read the chunk of 'task' from.
+    using DeviceLookup = std::function<DeviceInfo(wbase::Task::Ptr const& task)>;
+
+    /// Load of one device.
+    struct DeviceStats {
+        DeviceInfo info;
+        int chunksInFlight{0};
+        int tasksInFlight{0};
+        std::size_t queued{0};
+        double bytesPerSec{0.0}; ///< Locking throughput of completed chunks, 0 if none.
+    };
+
+    /// @param lookup - finds the device of a Task, by default from MemMan::filePath().
+    /// @param maxChunksRotational - chunks in flight allowed on a rotational device.
+    ChunkDevicesQueue(SchedulerBase* scheduler, memman::MemMan::Ptr const& memMan,
+                      DeviceLookup const& lookup=nullptr, int maxChunksRotational=1);
+    ChunkDevicesQueue(ChunkDevicesQueue const&) = delete;
+    ChunkDevicesQueue& operator=(ChunkDevicesQueue const&) = delete;
+
+    void queueTask(wbase::Task::Ptr const& task) override;
+    wbase::Task::Ptr getTask(bool useFlexibleLock) override;
+    bool empty() const override;
+    std::size_t getSize() const override { return _taskCount; }
+    bool ready(bool useFlexibleLock) override;
+    void taskComplete(wbase::Task::Ptr const& task) override;
+
+    bool setResourceStarved(bool starved) override;
+    bool nextTaskDifferentChunkId() override;
+
+    wbase::Task::Ptr removeTask(wbase::Task::Ptr const& task) override;
+    std::vector<wbase::Task::Ptr> removeQuery(QueryId qId) override;
+    int getScanCursor(int chunkId) override;
+
+    std::vector<DeviceStats> getDeviceStats() const;
+
+    /// @return the device holding 'path', with an id of -1 if it cannot be found.
+    static DeviceInfo deviceOfFile(std::string const& path);
+
+private:
+    struct Device {
+        using Ptr = std::shared_ptr<Device>;
+        Device(DeviceInfo const& info_, ChunkTasksQueue::Ptr const& queue_) : info(info_), queue(queue_) {}
+        double bytesPerSec() const { return secondsLocked > 0.0 ? bytesLocked / secondsLocked : 0.0; }
+
+        DeviceInfo const info;
+        ChunkTasksQueue::Ptr const queue;
+        std::map<int, int> chunksInFlight; ///< Tasks in flight by chunk id.
+        int tasksInFlight{0};
+        uint64_t bytesLocked{0};   ///< Bytes locked for completed chunks.
+        double secondsLocked{0.0}; ///< Time spent locking them.
+    };
+
+    bool _ready(bool useFlexibleLock);
+    Device::Ptr _deviceFor(wbase::Task::Ptr const& task);
+    Device::Ptr _findDevice(int chunkId) const;
+    bool _overSubscribed(Device const& device, int chunkId) const;
+
+    mutable std::mutex _mx; ///< Protects all members below, except _taskCount.
+    std::map<int64_t, Device::Ptr> _devices; ///< by device id.
+    std::map<int, Device::Ptr> _chunkDevices; ///< Device of each chunk seen, by chunk id.
+    Device::Ptr _readyDevice; ///< Device whose queue has a Task ready to run.
+    memman::MemMan::Ptr _memMan;
+    DeviceLookup _lookup;
+    int const _maxChunksRotational;
+    std::atomic<int> _taskCount{0}; ///< Count of all tasks queued on the devices.
+    bool _resourceStarved{false};
+    SchedulerBase* _scheduler; ///< Pointer to scheduler that owns this. This can be nullptr.
+};
+
+}}} // namespace lsst::qserv::wsched
+
+#endif // LSST_QSERV_WSCHED_CHUNKDEVICESQUEUE_H
@@ -163,16 +163,8 @@ bool ChunkDisk::_ready(bool useFlexibleLock) {
     wbase::Task::Ptr task = _activeTasks.top();
     // Try to get memHandle for the task if doesn't have one.
     if (!task->hasMemHandle()) {
-        memman::TableInfo::LockType lckOptTbl = memman::TableInfo::LockType::REQUIRED;
-        memman::TableInfo::LockType lckOptIdx = memman::TableInfo::LockType::NOLOCK;
-        if (useFlexibleLock) lckOptTbl = memman::TableInfo::LockType::FLEXIBLE;
-        auto scanInfo = task->getScanInfo();
         auto chunkId = task->getChunkId();
-        std::vector<memman::TableInfo> tblVect;
-        for (auto const& tbl : scanInfo.infoTables) {
-            memman::TableInfo ti(tbl.db + "/" + tbl.table, lckOptTbl, lckOptIdx);
-            tblVect.push_back(ti);
-        }
+        std::vector<memman::TableInfo> tblVect = task->getMemTables(useFlexibleLock);
         // If tblVect is empty, we should get the empty handle
         memman::MemMan::Handle handle = _memMan->prepare(tblVect, chunkId);
         if (handle == 0) {
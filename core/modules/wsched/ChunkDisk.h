@@ -69,6 +69,8 @@ public:
     /// ChunkDisk version does nothing for now.
     /// TODO: Make a legitimate removeTask function or delete the ChunkDisk class.
     wbase::Task::Ptr removeTask(wbase::Task::Ptr const& task) override {return nullptr;}
+    std::vector<wbase::Task::Ptr> removeQuery(QueryId qId) override { return {}; }
+    int getScanCursor(int chunkId) override { return -1; }
 
     /// Class that keeps the minimum chunkId at the front of the heap
     /// and within that chunkId, start with the slowest tables to scan.
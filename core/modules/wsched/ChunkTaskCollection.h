@@ -33,7 +33,8 @@ namespace qserv {
 namespace wsched {
 
 /// Class defines an interface to store Tasks related to chunks in an ordered manner.
-/// The only derived classes are expected to be ChunkDisk and ChunkTasksQueue.
+/// The only derived classes are expected to be ChunkDisk and ChunkTasksQueue,
+/// and ChunkDevicesQueue, which keeps a ChunkTasksQueue per block device.
 /// With luck, one of them will prove to be superior and the other will be destroyed, thus
 /// this class will no longer be needed.
 class ChunkTaskCollection {
@@ -65,6 +66,14 @@ public:
     /// Remove task from this collection.
     /// @return a pointer to the removed task or nullptr if the task was not found.
     virtual wbase::Task::Ptr removeTask(wbase::Task::Ptr const& task) = 0;
+
+    /// Remove all the Tasks of the user query 'qId' from this collection.
+    /// @return the removed Tasks.
+    virtual std::vector<wbase::Task::Ptr> removeQuery(QueryId qId) = 0;
+
+    /// @return the id of the chunk being scanned by the queue holding the
+    ///         Tasks of 'chunkId', or -1 if there isn't one.
+    virtual int getScanCursor(int chunkId) = 0;
 };
 
 }}} // namespace lsst::qserv::wsched
@@ -25,6 +25,11 @@
 // Class header
 #include "ChunkTasksQueue.h"
 
+// System headers
+#include <algorithm>
+#include <set>
+#include <utility>
+
 #include "global/Bug.h"
 
 // LSST headers
@@ -92,6 +97,8 @@ bool ChunkTasksQueue::_ready(bool useFlexibleLock) {
     if (_activeChunk == _chunkMap.end()) {
         _activeChunk = _chunkMap.begin();
         _activeChunk->second->setActive(); // Flag tasks on active so new Tasks added wont be run.
+        _notifyActive();
+        _prefetchNext(useFlexibleLock);
     }
 
     // Check the active chunk for valid Tasks
@@ -125,6 +132,8 @@ bool ChunkTasksQueue::_ready(bool useFlexibleLock) {
         }
         newActive->second->movePendingToActive();
         newActive->second->setActive();
+        _notifyActive();
+        _prefetchNext(useFlexibleLock);
     }
 
     // Advance through chunks until READY or NO_RESOURCES found, or until entire list scanned.
@@ -159,6 +168,34 @@ bool ChunkTasksQueue::_ready(bool useFlexibleLock) {
 }
 
 
+/// Have memman read ahead the chunk that will follow _activeChunk, so that its
+/// I/O overlaps the scan of _activeChunk instead of stalling the switch to it.
+/// Precondition: _mapMx must be held and _activeChunk must be valid.
+void ChunkTasksQueue::_prefetchNext(bool useFlexibleLock) {
+    auto next = _activeChunk;
+    ++next;
+    if (next == _chunkMap.end()) {
+        next = _chunkMap.begin();
+    }
+    if (next == _activeChunk || next->first == _prefetchedChunkId) {
+        return;
+    }
+    if (next->second->prefetch(useFlexibleLock) > 0) {
+        _prefetchedChunkId = next->first;
+    }
+}
+
+
+/// Let the scheduler prepare for the Tasks of the new _activeChunk, such as
+/// building their subchunk tables, see SchedulerBase::setChunkActiveFunc().
+/// Precondition: _mapMx must be held and _activeChunk must be valid.
+void ChunkTasksQueue::_notifyActive() {
+    if (_scheduler != nullptr && _scheduler->getChunkActiveFunc()) {
+        _scheduler->getChunkActiveFunc()(_activeChunk->second->getTasks());
+    }
+}
+
+
 wbase::Task::Ptr ChunkTasksQueue::getTask(bool useFlexibleLock) {
     std::lock_guard<std::mutex> lock(_mapMx);
     // Attempt to set _readyChunk.
@@ -212,6 +249,15 @@ int ChunkTasksQueue::getActiveChunkId() {
 }
 
 
+int ChunkTasksQueue::getReadyChunkId() {
+    std::lock_guard<std::mutex> lock(_mapMx);
+    if (_readyChunk == nullptr) {
+        return -1;
+    }
+    return _readyChunk->getChunkId();
+}
+
+
 wbase::Task::Ptr ChunkTasksQueue::removeTask(wbase::Task::Ptr const& task) {
     // Find the correct chunk
     auto chunkId = task->getChunkId();
@@ -229,6 +275,29 @@ wbase::Task::Ptr ChunkTasksQueue::removeTask(wbase::Task::Ptr const& task) {
 }
 
 
+std::vector<wbase::Task::Ptr> ChunkTasksQueue::removeQuery(QueryId qId) {
+    std::vector<wbase::Task::Ptr> removed;
+    std::lock_guard<std::mutex> lock(_mapMx);
+    for (auto iter = _chunkMap.begin(); iter != _chunkMap.end();) {
+        ChunkTasks::Ptr ct = iter->second;
+        auto count = removed.size();
+        ct->removeQuery(qId, removed);
+        _taskCount -= removed.size() - count;
+        if (ct == _readyChunk && !ct->hasReadyTask()) {
+            _readyChunk = nullptr;
+        }
+        // Chunks left without Tasks are dropped unless they are active, as
+        // _ready() takes care of those when advancing, or have Tasks in flight.
+        if (iter != _activeChunk && ct != _readyChunk && ct->empty() && ct->readyToAdvance()) {
+            iter = _chunkMap.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+    return removed;
+}
+
+
 bool ChunkTasksQueue::empty() const {
     std::lock_guard<std::mutex> lock(_mapMx);
     return _empty();
@@ -264,6 +333,25 @@ wbase::Task::Ptr ChunkTasks::removeTask(wbase::Task::Ptr const& task) {
 }
 
 
+/// Remove the Tasks of the user query 'qId', including _readyTask, and append them to 'removed'.
+/// This depends on owner for thread safety.
+void ChunkTasks::removeQuery(QueryId qId, std::vector<wbase::Task::Ptr>& removed) {
+    auto eraseFunc = [qId, &removed](std::vector<wbase::Task::Ptr>& vect) {
+        auto iter = std::stable_partition(vect.begin(), vect.end(),
+                [qId](wbase::Task::Ptr const& task) { return task->getQueryId() != qId; });
+        removed.insert(removed.end(), iter, vect.end());
+        vect.erase(iter, vect.end());
+    };
+    eraseFunc(_activeTasks._tasks);
+    _activeTasks.heapify();
+    eraseFunc(_pendingTasks);
+    if (_readyTask != nullptr && _readyTask->getQueryId() == qId) {
+        removed.push_back(_readyTask);
+        _readyTask = nullptr;
+    }
+}
+
+
 void ChunkTasks::SlowTableHeap::push(wbase::Task::Ptr const& task) {
     _tasks.push_back(task);
     std::push_heap(_tasks.begin(), _tasks.end(), compareFunc);
@@ -290,8 +378,13 @@ void ChunkTasks::queTask(wbase::Task::Ptr const& a) {
 
     const char* state = "";
     // If this is the active chunk, put new Tasks on the pending list, as
-    // we could easily get stuck on this chunk as new Tasks come in.
-    if (_active) {
+    // we could easily get stuck on this chunk as new Tasks come in. Unless
+    // the tables of the Task are already in memory for the Tasks in flight.
+    if (_active && _canJoinActive(a)) {
+        _activeTasks.push(a);
+        ++_lateJoins;
+        state = "JOINED";
+    } else if (_active) {
         _pendingTasks.push_back(a);
         state = "PENDING";
     } else {
@@ -320,11 +413,37 @@ void ChunkTasks::setActive(bool active) {
         if (_active && !active) {
             movePendingToActive();
         }
+        if (!_active && active) {
+            _activatedCount = _activeTasks.size() + _inFlightTasks.size();
+            _lateJoins = 0;
+        }
     }
     _active = active;
 }
 
 
+/// @return true if 'task' may join the Tasks of the active chunk. Tasks of this
+/// chunk must be in flight, holding their tables locked, and these tables must
+/// cover the tables of 'task'.
+bool ChunkTasks::_canJoinActive(wbase::Task::Ptr const& task) const {
+    if (_inFlightTasks.empty() || _lateJoins >= _activatedCount || task->getChunkId() != _chunkId) {
+        return false;
+    }
+    std::set<std::pair<std::string, std::string>> locked;
+    for (auto const& inFlight : _inFlightTasks) {
+        for (auto const& tbl : inFlight->getScanInfo().infoTables) {
+            locked.emplace(tbl.db, tbl.table);
+        }
+    }
+    for (auto const& tbl : task->getScanInfo().infoTables) {
+        if (locked.count(std::make_pair(tbl.db, tbl.table)) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
 /// Move all pending Tasks to the active heap.
 void ChunkTasks::movePendingToActive() {
     for (auto const& t:_pendingTasks) {
@@ -347,6 +466,21 @@ bool ChunkTasks::readyToAdvance() {
 }
 
 
+/// Start reading the tables of the first Task in _activeTasks into the page cache.
+/// Other Tasks on the chunk normally use the same or a subset of the tables, as
+/// the slowest tables are at the top of the heap.
+/// @return the number of bytes memman started to read.
+uint64_t ChunkTasks::prefetch(bool useFlexibleLock) {
+    auto task = _activeTasks.top();
+    if (task == nullptr) {
+        return 0;
+    }
+    uint64_t bytes = _memMan->prefetch(task->getMemTables(useFlexibleLock), _chunkId);
+    LOGS(_log, LOG_LVL_DEBUG, "prefetch chunk=" << _chunkId << " bytes=" << bytes);
+    return bytes;
+}
+
+
 /// @Return true if a Task is ready to be run.
 // ChunkTasks does not have its own mutex and depends on its owner for thread safety.
 // If a Task is ready to be run, _readyTask will not be nullptr.
@@ -377,22 +511,19 @@ ChunkTasks::ReadyState ChunkTasks::ready(bool useFlexibleLock) {
     // will not examine any further chunks upon seeing those results.
     auto task = _activeTasks.top();
     int chunkId = -1;
+    if (!task->hasMemHandle() && task->getCancelled()) {
+        // A cancelled Task returns before using its tables, there is no need to lock them.
+        LOGS(_log, LOG_LVL_DEBUG, task->getIdStr() << " cancelled, skipping memMan");
+        task->setMemHandle(memman::MemMan::HandleType::ISEMPTY);
+    }
     if (!task->hasMemHandle()) {
-        memman::TableInfo::LockType lckOptTbl = memman::TableInfo::LockType::REQUIRED;
-        if (useFlexibleLock) lckOptTbl = memman::TableInfo::LockType::FLEXIBLE;
-        memman::TableInfo::LockType lckOptIdx = memman::TableInfo::LockType::NOLOCK;
-        auto scanInfo = task->getScanInfo();
         chunkId = task->getChunkId();
         if (chunkId != _chunkId) {
             // This would slow things down badly, but the system would survive.
             LOGS(_log, LOG_LVL_ERROR, "ChunkTasks " << _chunkId << " got task for chunk " << chunkId
                     << " " << task->getIdStr());
         }
-        std::vector<memman::TableInfo> tblVect;
-        for (auto const& tbl : scanInfo.infoTables) {
-            memman::TableInfo ti(tbl.db + "/" + tbl.table, lckOptTbl, lckOptIdx);
-            tblVect.push_back(ti);
-        }
+        std::vector<memman::TableInfo> tblVect = task->getMemTables(useFlexibleLock);
         // If tblVect is empty, we should get the empty handle
         memman::MemMan::Handle handle = _memMan->prepare(tblVect, chunkId);
         LOGS(_log, LOG_LVL_DEBUG, "memPrep " << _memMan->getStatistics().logString() <<
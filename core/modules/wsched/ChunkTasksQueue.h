@@ -45,7 +45,11 @@ namespace wsched {
 /// to _pendingTasks when this is the active chunk.
 /// The active chunk is the first chunk to be checked for tasks to run.
 /// Placing tasks on the pending list prevents getting stuck on the
-/// active chunk indefinitely.
+/// active chunk indefinitely. A Task arriving while Tasks of the active
+/// chunk are in flight, which only needs tables that they hold locked in
+/// memory, joins them on _activeTasks instead of waiting for the next
+/// pass over all chunks. At most as many Tasks join as there were when the
+/// chunk became active, so the chunk still gets done.
 class ChunkTasks {
 public:
     using Ptr = std::shared_ptr<ChunkTasks>;
@@ -60,6 +64,7 @@ public:
     void queTask(wbase::Task::Ptr const& task);
     wbase::Task::Ptr getTask(bool useFlexibleLock);
     ReadyState ready(bool useFlexibleLock);
+    uint64_t prefetch(bool useFlexibleLock);
     void taskComplete(wbase::Task::Ptr const& task);
 
     void movePendingToActive(); ///< Move all pending Tasks to _activeTasks.
@@ -68,10 +73,15 @@ public:
     bool setResourceStarved(bool starved); ///< hook for tracking starvation.
     std::size_t size() const { return _activeTasks.size() + _pendingTasks.size(); }
     int getChunkId() { return _chunkId; }
+    std::vector<wbase::Task::Ptr> getTasks() const { return _activeTasks._tasks; } ///< @return queued Tasks.
 
     wbase::Task::Ptr removeTask(wbase::Task::Ptr const& task);
+    void removeQuery(QueryId qId, std::vector<wbase::Task::Ptr>& removed); ///< Append the Tasks of qId to removed.
+    bool hasReadyTask() const { return _readyTask != nullptr; }
 
-    /// Class that keeps the slowest tables at the front of the heap.
+    /// Class that keeps the slowest tables at the front of the heap, and among
+    /// Tasks on the same tables, the ones expected to take longest. Starting
+    /// long Tasks first keeps a thread from being left with one at the end.
     class SlowTableHeap {
     public:
         // Using a greater than comparison function results in a minimum value heap.
@@ -79,7 +89,8 @@ public:
             if(!x || !y) { return false; }
             // compare scanInfo (slower scans first)
             int siComp = x->getScanInfo().compareTables(y->getScanInfo());
-            return siComp < 0;
+            if (siComp != 0) { return siComp < 0; }
+            return x->getPredictedMinutes() < y->getPredictedMinutes();
         };
         void push(wbase::Task::Ptr const& task);
         wbase::Task::Ptr pop();
@@ -97,6 +108,8 @@ public:
     };
 
 private:
+    bool _canJoinActive(wbase::Task::Ptr const& task) const;
+
     int _chunkId;                    ///< Chunk Id for all Tasks in this instance.
     bool _active{false};            ///< True when this is the active chunk.
     bool _resourceStarved{false};   ///< True when advancement is prevented by lack of memory.
@@ -104,6 +117,8 @@ private:
     SlowTableHeap                 _activeTasks;        ///< All Tasks must be put on this before they can run.
     std::vector<wbase::Task::Ptr> _pendingTasks;       ///< Task that should not be run until later.
     std::set<wbase::Task*>        _inFlightTasks;      ///< Set of Tasks that this chunk has in flight.
+    std::size_t _activatedCount{0}; ///< Tasks queued or in flight when this became the active chunk.
+    std::size_t _lateJoins{0};      ///< Tasks that joined _activeTasks since then.
 
     memman::MemMan::Ptr _memMan;
 };
@@ -115,11 +130,14 @@ private:
 /// - Tasks are provided starting with the _activeChunk, which remains the
 ///   _activeChunk until all of its Tasks are completed. At which time, the
 ///   _activeChunk advances to the chunk with the next higher chunkId. While
-///   a chunk is the _activeChunk, all new Tasks for that chunk are put in
-///   in a pending list so that the active chunk does not get stalled.
+///   a chunk is the _activeChunk, new Tasks for that chunk are put in
+///   in a pending list so that the active chunk does not get stalled, unless
+///   they can use the tables locked by its Tasks in flight (see ChunkTasks).
 /// - While all the Tasks on the _active chunk have been started, but not completed,
 ///   Tasks can be taken from chunks after the _activeChunk as long as resources are
 ///   available.
+/// - When the _activeChunk changes, the tables of the chunk after it are read ahead
+///   through memman so that they are in memory when that chunk becomes active.
 /// Like the other schedulers, ready() is the core of this class as it determines
 /// if a Task is ready to run and which Task will be provided by getTask().
 class ChunkTasksQueue : public ChunkTaskCollection {
@@ -147,17 +165,23 @@ public:
     bool setResourceStarved(bool starved) override;
     bool nextTaskDifferentChunkId() override;
     int getActiveChunkId(); ///< return the active chunk id, or -1 if there isn't one.
+    int getReadyChunkId(); ///< return the chunk id of the ready Task, or -1 if there isn't one.
 
     wbase::Task::Ptr removeTask(wbase::Task::Ptr const& task) override;
+    std::vector<wbase::Task::Ptr> removeQuery(QueryId qId) override;
+    int getScanCursor(int chunkId) override { return getActiveChunkId(); }
 
 private:
     bool _ready(bool useFlexibleLock);
     bool _empty() const { return _chunkMap.empty(); }
+    void _prefetchNext(bool useFlexibleLock);
+    void _notifyActive();
 
     mutable std::mutex _mapMx; ///< Protects _chunkMap, _activeChunk, and _readyChunk.
     ChunkMap _chunkMap; ///< map by chunk Id.
     ChunkMap::iterator _activeChunk{_chunkMap.end()}; ///< points at the active ChunkTasks in _chunkList
     ChunkTasks::Ptr _readyChunk{nullptr}; ///< Chunk with the task that's ready to run.
+    int _prefetchedChunkId{-1}; ///< Last chunk read ahead, to avoid reading it ahead again.
 
     memman::MemMan::Ptr _memMan;
     std::atomic<int> _taskCount{0}; ///< Count of all tasks currently in _chunkMap.
@@ -0,0 +1,192 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "wsched/FairShareAdmission.h"
+
+// System headers
+#include <cstdlib>
+#include <stdexcept>
+
+// LSST headers
+#include "lsst/log/Log.h"
+
+namespace {
+
+LOG_LOGGER _log = LOG_GET("lsst.qserv.wsched.FairShareAdmission");
+
+} // anonymous namespace
+
+namespace lsst {
+namespace qserv {
+namespace wsched {
+
+FairShareAdmission::FairShareAdmission(Config const& config, AdmitFunc const& admit)
+    : _config(config), _admit(admit) {
+}
+
+
+std::map<std::string, double> FairShareAdmission::parseWeights(std::string const& spec) {
+    std::map<std::string, double> weights;
+    size_t pos = 0;
+    while (pos < spec.size()) {
+        size_t end = spec.find(',', pos);
+        if (end == std::string::npos) {
+            end = spec.size();
+        }
+        std::string const entry = spec.substr(pos, end - pos);
+        pos = end + 1;
+        if (entry.empty()) {
+            continue;
+        }
+        size_t const eq = entry.rfind('=');
+        char* last = nullptr;
+        double weight = (eq == std::string::npos) ? 0.0 : std::strtod(entry.c_str() + eq + 1, &last);
+        if (eq == 0 || eq == std::string::npos || last == entry.c_str() + eq + 1 || *last != '\0'
+            || !(weight > 0.0)) {
+            throw std::invalid_argument("FairShareAdmission bad weight '" + entry + "'");
+        }
+        weights[entry.substr(0, eq)] = weight;
+    }
+    return weights;
+}
+
+
+std::string FairShareAdmission::principalOf(wbase::Task const& task) {
+    return std::to_string(task.getCzarId()) + ":" + task.user;
+}
+
+
+double FairShareAdmission::_weightOf(std::string const& name, wbase::Task const& task) const {
+    auto iter = _config.weights.find(name);
+    if (iter == _config.weights.end()) {
+        iter = _config.weights.find(task.user);
+    }
+    return (iter == _config.weights.end()) ? 1.0 : iter->second;
+}
+
+
+/// Precondition: _mtx must be held.
+bool FairShareAdmission::_hasRoom(Principal const& principal) const {
+    return (_config.slots == 0 || _inFlight < _config.slots)
+        && (_config.maxInFlight == 0 || principal.inFlight < _config.maxInFlight);
+}
+
+
+bool FairShareAdmission::add(wbase::Task::Ptr const& task) {
+    std::string const name = principalOf(*task);
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        auto iter = _principals.find(name);
+        if (iter == _principals.end()) {
+            iter = _principals.emplace(name, Principal()).first;
+            iter->second.weight = _weightOf(name, *task);
+        }
+        Principal& principal = iter->second;
+        // Tasks already waiting go first, so a principal keeps its order.
+        if (!principal.queue.empty() || !_hasRoom(principal)) {
+            if (_config.maxQueued > 0 && principal.queue.size() >= _config.maxQueued) {
+                ++principal.rejected;
+                LOGS(_log, LOG_LVL_WARN, task->getIdStr() << " refused, " << name << " has "
+                     << principal.queue.size() << " tasks waiting");
+                return false;
+            }
+            principal.queue.push_back(task);
+            return true;
+        }
+        ++principal.inFlight;
+        ++principal.admitted;
+        ++_inFlight;
+    }
+    _admit(task);
+    return true;
+}
+
+
+void FairShareAdmission::finished(wbase::Task::Ptr const& task) {
+    std::string const name = principalOf(*task);
+    std::vector<wbase::Task::Ptr> admitted;
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        auto iter = _principals.find(name);
+        if (iter == _principals.end() || iter->second.inFlight == 0) {
+            LOGS(_log, LOG_LVL_ERROR, task->getIdStr() << " finished but " << name << " has no task admitted");
+            return;
+        }
+        --iter->second.inFlight;
+        --_inFlight;
+        for (auto next = _next(); next != nullptr; next = _next()) {
+            admitted.push_back(next);
+        }
+    }
+    for (auto const& next : admitted) {
+        _admit(next);
+    }
+}
+
+
+/// @return the next task to admit, or nullptr if none fits.
+/// Precondition: _mtx must be held.
+wbase::Task::Ptr FairShareAdmission::_next() {
+    Principal* best = nullptr;
+    double bestShare = 0.0;
+    for (auto& elem : _principals) {
+        Principal& principal = elem.second;
+        if (principal.queue.empty() || !_hasRoom(principal)) {
+            continue;
+        }
+        double const share = principal.inFlight / principal.weight;
+        if (best == nullptr || share < bestShare) {
+            best = &principal;
+            bestShare = share;
+        }
+    }
+    if (best == nullptr) {
+        return nullptr;
+    }
+    wbase::Task::Ptr task = best->queue.front();
+    best->queue.pop_front();
+    ++best->inFlight;
+    ++best->admitted;
+    ++_inFlight;
+    return task;
+}
+
+
+std::vector<FairShareAdmission::Stats> FairShareAdmission::getStats() const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    std::vector<Stats> stats;
+    for (auto const& elem : _principals) {
+        Stats s;
+        s.principal = elem.first;
+        s.weight = elem.second.weight;
+        s.inFlight = elem.second.inFlight;
+        s.queued = elem.second.queue.size();
+        s.admitted = elem.second.admitted;
+        s.rejected = elem.second.rejected;
+        stats.push_back(s);
+    }
+    return stats;
+}
+
+}}} // namespace lsst::qserv::wsched
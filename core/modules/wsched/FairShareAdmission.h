@@ -0,0 +1,126 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_WSCHED_FAIRSHAREADMISSION_H
+#define LSST_QSERV_WSCHED_FAIRSHAREADMISSION_H
+
+// System headers
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "wbase/Task.h"
+
+namespace lsst {
+namespace qserv {
+namespace wsched {
+
+/// FairShareAdmission decides when the tasks of each principal, a user of a
+/// czar, are handed to the scheduler, so that one large query cannot fill
+/// the scheduler queues ahead of everybody else.
+///
+/// At most 'slots' tasks of all principals, and 'maxInFlight' of one
+/// principal, are in the scheduler at once. Further tasks wait here, and
+/// when a task finishes the next one comes from the waiting principal with
+/// the fewest tasks in the scheduler for its weight. A principal with
+/// 'maxQueued' tasks waiting has further tasks refused.
+class FairShareAdmission {
+public:
+    using Ptr = std::shared_ptr<FairShareAdmission>;
+    /// Hands a task to the scheduler.
+    using AdmitFunc = std::function<void(wbase::Task::Ptr const&)>;
+
+    struct Config {
+        unsigned int slots{0};       ///< Tasks of all principals in the scheduler, 0 for no limit.
+        unsigned int maxInFlight{0}; ///< Tasks of one principal in the scheduler, 0 for no limit.
+        unsigned int maxQueued{0};   ///< Tasks of one principal waiting here, 0 for no limit.
+        /// Weights by principal, "<czarId>:<user>", or by user. 1 if not given.
+        std::map<std::string, double> weights;
+
+        /// @return true if tasks can wait for admission with this configuration.
+        bool isEnabled() const { return slots > 0 || maxInFlight > 0; }
+    };
+
+    struct Stats {
+        std::string principal;
+        double weight{1.0};
+        unsigned int inFlight{0}; ///< Tasks in the scheduler.
+        size_t queued{0};         ///< Tasks waiting for admission.
+        uint64_t admitted{0};
+        uint64_t rejected{0};
+    };
+
+    FairShareAdmission(Config const& config, AdmitFunc const& admit);
+
+    FairShareAdmission(FairShareAdmission const&) = delete;
+    FairShareAdmission& operator=(FairShareAdmission const&) = delete;
+
+    /// @return the weights of 'spec', a comma separated list of
+    ///         <principal or user>=<weight>, such as "qsmaster=4,2:alice=0.5".
+    /// @throws std::invalid_argument if an entry is not understood.
+    static std::map<std::string, double> parseWeights(std::string const& spec);
+
+    /// @return the principal of 'task', "<czarId>:<user>".
+    static std::string principalOf(wbase::Task const& task);
+
+    /// Admit 'task' now if its principal and the scheduler have room,
+    /// otherwise keep it until a task finishes.
+    /// @return false if the task was refused as its principal has too many
+    ///         tasks waiting.
+    bool add(wbase::Task::Ptr const& task);
+
+    /// Free the slot of an admitted 'task' and admit the tasks that now fit.
+    void finished(wbase::Task::Ptr const& task);
+
+    /// @return the statistics of each principal seen so far.
+    std::vector<Stats> getStats() const;
+
+private:
+    struct Principal {
+        double weight{1.0};
+        unsigned int inFlight{0};
+        std::deque<wbase::Task::Ptr> queue;
+        uint64_t admitted{0};
+        uint64_t rejected{0};
+    };
+
+    double _weightOf(std::string const& name, wbase::Task const& task) const;
+    bool _hasRoom(Principal const& principal) const;
+    wbase::Task::Ptr _next();
+
+    Config const _config;
+    AdmitFunc const _admit;
+
+    mutable std::mutex _mtx; ///< Protects members below.
+    std::map<std::string, Principal> _principals;
+    unsigned int _inFlight{0}; ///< Tasks of all principals in the scheduler.
+};
+
+}}} // namespace lsst::qserv::wsched
+
+#endif // LSST_QSERV_WSCHED_FAIRSHAREADMISSION_H
@@ -33,6 +33,7 @@
 #include "wsched/GroupScheduler.h"
 
 // System headers
+#include <algorithm>
 #include <iostream>
 #include <mutex>
 #include <sstream>
@@ -83,17 +84,58 @@ bool GroupQueue::queTask(wbase::Task::Ptr const& task) {
     return false;
 }
 
-/// Get a command off the queue. If no message is available, wait until one is.
+/// Get the Task with the earliest deadline off the queue, the first one if none has a deadline.
 wbase::Task::Ptr GroupQueue::getTask() {
-    auto task = _tasks.front();
-    _tasks.pop_front();
+    auto best = _tasks.begin();
+    for (auto iter = _tasks.begin(); iter != _tasks.end(); ++iter) {
+        if ((*iter)->getDeadline() < (*best)->getDeadline()) {
+            best = iter;
+        }
+    }
+    auto task = *best;
+    _tasks.erase(best);
     return task;
 }
 
+void GroupQueue::removeQuery(QueryId qId, std::vector<wbase::Task::Ptr>& removed) {
+    for (auto iter = _tasks.begin(); iter != _tasks.end();) {
+        if ((*iter)->getQueryId() == qId) {
+            removed.push_back(*iter);
+            iter = _tasks.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+}
+
 wbase::Task::Ptr GroupQueue::peekTask() {
     return _tasks.front();
 }
 
+std::chrono::system_clock::time_point GroupQueue::getEarliestDeadline() const {
+    auto earliest = std::chrono::system_clock::time_point::max();
+    for (auto const& task : _tasks) {
+        earliest = std::min(earliest, task->getDeadline());
+    }
+    return earliest;
+}
+
+bool GroupQueue::deadlineAtRisk(std::chrono::system_clock::time_point const& now) const {
+    for (auto const& task : _tasks) {
+        if (task->deadlineAtRisk(now)) return true;
+    }
+    return false;
+}
+
+int GroupQueue::countQueuedBefore(std::chrono::system_clock::time_point const& cutoff) const {
+    int count = 0;
+    for (auto const& task : _tasks) {
+        auto const queueTime = task->getQueueTime();
+        if (queueTime != std::chrono::system_clock::time_point() && queueTime < cutoff) ++count;
+    }
+    return count;
+}
+
 /// Queue a Task in the GroupScheduler.
 /// Tasks in the same chunk are grouped together.
 void GroupScheduler::queCmd(util::Command::Ptr const& cmd) {
@@ -122,7 +164,8 @@ void GroupScheduler::queCmd(util::Command::Ptr const& cmd) {
     util::CommandQueue::_cv.notify_all();
 }
 
-/// Return a Task from the front of the queue. If no message is available, wait until one is.
+/// Return the Task with the earliest deadline, or from the front of the queue if
+/// none has a deadline. If no message is available, wait until one is.
 util::Command::Ptr GroupScheduler::getCmd(bool wait)  {
     std::unique_lock<std::mutex> lock(util::CommandQueue::_mx);
     if (wait) {
@@ -130,33 +173,142 @@ util::Command::Ptr GroupScheduler::getCmd(bool wait)  {
     } else if (!_ready()) {
         return nullptr;
     }
-    auto group = _queue.front();
+    auto cancelled = _getCancelledTask();
+    if (cancelled != nullptr) {
+        return cancelled;
+    }
+    return _getTask();
+}
+
+
+/// Precondition: _mx must be locked and _queue not empty.
+util::Command::Ptr GroupScheduler::_getTask() {
+    auto best = _queue.begin();
+    auto bestDeadline = (*best)->getEarliestDeadline();
+    for (auto iter = best + 1; iter != _queue.end(); ++iter) {
+        auto deadline = (*iter)->getEarliestDeadline();
+        if (deadline < bestDeadline) {
+            best = iter;
+            bestDeadline = deadline;
+        }
+    }
+    auto group = *best;
     auto task = group->getTask();
     if (group->isEmpty()) {
-        _queue.pop_front();
+        _queue.erase(best);
     }
     ++_inFlight; // Considered inFlight as soon as it's off the queue.
+    if (_preemptsPending > 0) {
+        --_preemptsPending;
+        _preemptCv.notify_all();
+    }
     _decrCountForUserQuery(task->getQueryId());
     _incrChunkTaskCount(task->getChunkId());
+    _lockIndexes(task);
     return task;
 }
 
 
+/// Give 'task' a memman handle on the index files of the tables it looks
+/// up, which Task::waitForMemMan() locks before the queries run. The locks
+/// are FLEXIBLE, the Task runs without them when memory is short rather
+/// than waiting on the scans.
+/// Precondition: _mx must be locked.
+void GroupScheduler::_lockIndexes(wbase::Task::Ptr const& task) {
+    if (_memMan == nullptr || task->hasMemHandle() || task->getScanInfo().indexTables.empty()) {
+        return;
+    }
+    auto tblVect = task->getMemTables(true);
+    memman::MemMan::Handle handle = _memMan->prepare(tblVect, task->getChunkId());
+    if (handle == 0) {
+        LOGS(_log, LOG_LVL_DEBUG, task->getIdStr() << " " << getName()
+             << " no index lock errno=" << errno);
+        return;
+    }
+    task->setMemHandle(handle);
+    task->setMemMan(_memMan);
+}
+
+
+bool GroupScheduler::readyForDeadline() {
+    std::lock_guard<std::mutex> lock(util::CommandQueue::_mx);
+    return _inFlight < _maxThreads && _deadlineAtRisk();
+}
+
+
+util::Command::Ptr GroupScheduler::getDeadlineCmd() {
+    std::lock_guard<std::mutex> lock(util::CommandQueue::_mx);
+    if (_inFlight >= _maxThreads || !_deadlineAtRisk()) {
+        return nullptr;
+    }
+    return _getTask();
+}
+
+
+/// Precondition: _mx must be locked.
+/// @return true if a queued Task has less than half of its time left.
+bool GroupScheduler::_deadlineAtRisk() {
+    auto now = std::chrono::system_clock::now();
+    for (auto const& group : _queue) {
+        if (group->deadlineAtRisk(now)) return true;
+    }
+    return false;
+}
+
+
+bool GroupScheduler::preemptFor(std::chrono::milliseconds after) {
+    std::lock_guard<std::mutex> lock(util::CommandQueue::_mx);
+    int const late = _countLate(after);
+    // Tasks that stopped being late, cancelled ones, no longer wait for a thread.
+    _preemptsPending = std::min(_preemptsPending, late);
+    if (late <= _preemptsPending || _inFlight + _preemptsPending >= maxInFlight()) {
+        return false;
+    }
+    ++_preemptsPending;
+    ++_preempts;
+    return true;
+}
+
+
+void GroupScheduler::waitForLate(std::chrono::milliseconds after, std::chrono::milliseconds maxPause) {
+    std::unique_lock<std::mutex> lock(util::CommandQueue::_mx);
+    _preemptCv.wait_for(lock, maxPause, [this, after]() { return _countLate(after) == 0; });
+}
+
+
+/// Precondition: _mx must be locked.
+/// @return the number of Tasks queued for longer than 'after'.
+int GroupScheduler::_countLate(std::chrono::milliseconds after) {
+    auto const cutoff = std::chrono::system_clock::now() - after;
+    int late = 0;
+    for (auto const& group : _queue) {
+        late += group->countQueuedBefore(cutoff);
+    }
+    return late;
+}
+
+
 void GroupScheduler::commandFinish(util::Command::Ptr const& cmd) {
     --_inFlight;
     auto t = std::dynamic_pointer_cast<wbase::Task>(cmd);
-    if (t != nullptr) _decrChunkTaskCount(t->getChunkId());
+    if (t != nullptr) {
+        _decrChunkTaskCount(t->getChunkId());
+        if (_memMan != nullptr && t->hasMemHandle()) {
+            _memMan->unlock(t->getMemHandle());
+        }
+    }
 }
 
 
 /// MaxActiveChunks and resource limitations (aside from available threads) are ignored by the GroupScheduler.
-GroupScheduler::GroupScheduler(std::string const& name, int maxThreads, int maxReserve, int maxGroupSize, int priority)
-  : SchedulerBase{name, maxThreads, maxReserve, 0, priority}, _maxGroupSize{maxGroupSize} {
+GroupScheduler::GroupScheduler(std::string const& name, int maxThreads, int maxReserve, int maxGroupSize,
+                               int priority, memman::MemMan::Ptr const& memMan)
+  : SchedulerBase{name, maxThreads, maxReserve, 0, priority}, _maxGroupSize{maxGroupSize}, _memMan{memMan} {
 }
 
 bool GroupScheduler::empty() {
     std::lock_guard<std::mutex> lock(util::CommandQueue::_mx);
-    return _queue.empty();
+    return _queue.empty() && _cancelledTasks.empty();
 }
 
 /// Returns true when a Task is ready to run.
@@ -168,14 +320,37 @@ bool GroupScheduler::ready() {
 /// Precondition: _mx must be locked.
 bool GroupScheduler::_ready() {
     // GroupScheduler is not limited by resource availability and ignores maxActiveChunks.
-    return !_queue.empty() && _inFlight < maxInFlight();
+    // Cancelled Tasks return at once and are not limited at all.
+    return !_cancelledTasks.empty() || (!_queue.empty() && _inFlight < maxInFlight());
 }
 
 
-/// Return the number of groups (not Tasks) in the queue.
+/// Return the number of groups (not Tasks) in the queue, plus the cancelled Tasks.
 std::size_t GroupScheduler::getSize() const {
     std::lock_guard<std::mutex> lock(util::CommandQueue::_mx);
-    return _queue.size();
+    return _queue.size() + _cancelledTasks.size();
+}
+
+
+int GroupScheduler::cancelQuery(QueryId qId) {
+    std::vector<wbase::Task::Ptr> tasks;
+    {
+        std::lock_guard<std::mutex> lock(util::CommandQueue::_mx);
+        for (auto iter = _queue.begin(); iter != _queue.end();) {
+            (*iter)->removeQuery(qId, tasks);
+            if ((*iter)->isEmpty()) {
+                iter = _queue.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+        _addCancelledTasks(tasks);
+    }
+    _preemptCv.notify_all();
+    LOGS(_log, LOG_LVL_INFO, QueryIdHelper::makeIdStr(qId) << " cancelQuery " << getName()
+         << " cancelled " << tasks.size() << " queued Tasks");
+    util::CommandQueue::_cv.notify_all();
+    return tasks.size();
 }
 
 }}} // namespace lsst::qserv::wsched
@@ -23,7 +23,13 @@
 #ifndef LSST_QSERV_WSCHED_GROUPSCHEDULER_H
 #define LSST_QSERV_WSCHED_GROUPSCHEDULER_H
 
+// System headers
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+
 // Qserv headers
+#include "memman/MemMan.h"
 #include "util/EventThread.h"
 #include "wsched/SchedulerBase.h"
 
@@ -42,6 +48,14 @@ public:
     wbase::Task::Ptr getTask();
     wbase::Task::Ptr peekTask();
     bool isEmpty() { return _tasks.empty(); }
+    /// Remove the Tasks of the user query 'qId' and append them to 'removed'.
+    void removeQuery(QueryId qId, std::vector<wbase::Task::Ptr>& removed);
+    /// @return the earliest deadline of the queued Tasks, time_point::max() if none has one.
+    std::chrono::system_clock::time_point getEarliestDeadline() const;
+    /// @return true if a queued Task has less than half of its time left at 'now'.
+    bool deadlineAtRisk(std::chrono::system_clock::time_point const& now) const;
+    /// @return the number of queued Tasks that were queued before 'cutoff'.
+    int countQueuedBefore(std::chrono::system_clock::time_point const& cutoff) const;
 
 protected:
     bool _hasChunkId{false};
@@ -54,12 +68,21 @@ protected:
 /// GroupScheduler -- A scheduler that is a cross between FIFO and shared scan.
 /// Tasks are ordered as they come in, except that queries for the
 /// same chunks are grouped together.
+/// Tasks with a deadline go first, earliest deadline first (EDF). Groups
+/// whose Tasks have no deadline keep their FIFO order behind them. When a
+/// Task has used half of its time, it may run in a thread reserved by other
+/// schedulers, see BlendScheduler.
+/// Tasks that waited longer than a latency target may also have scan Tasks
+/// yield their threads to them, see preemptFor().
+/// Given a memMan, the index files of the Tasks looking up rows through
+/// indexes are locked in memory while they run, when memory allows.
 class GroupScheduler : public SchedulerBase {
 public:
     typedef std::shared_ptr<GroupScheduler> Ptr;
 
     GroupScheduler(std::string const& name,
-                   int maxThreads, int maxReserve, int maxGroupSize, int priority);
+                   int maxThreads, int maxReserve, int maxGroupSize, int priority,
+                   memman::MemMan::Ptr const& memMan=nullptr);
     virtual ~GroupScheduler() {}
 
     bool empty();
@@ -73,12 +96,41 @@ public:
     bool ready() override;
     std::size_t getSize() const override;
 
+    int cancelQuery(QueryId qId) override;
+
+    /// @return true if a Task whose deadline is at risk could run, were the
+    ///         threads reserved by other schedulers available to it.
+    bool readyForDeadline();
+    /// @return the Task with the earliest deadline if its deadline is at risk,
+    ///         ignoring the thread reserves of other schedulers, or nullptr.
+    util::Command::Ptr getDeadlineCmd();
+
+    /// Called by scan Tasks between their result messages. One of them is
+    /// preempted for each Task queued for longer than 'after' that could
+    /// run, were a thread available, and that no Task preempted before
+    /// yields to.
+    /// @return true if the calling scan Task should yield its thread.
+    bool preemptFor(std::chrono::milliseconds after);
+    /// Wait until no Task is queued for longer than 'after', or for 'maxPause'.
+    void waitForLate(std::chrono::milliseconds after, std::chrono::milliseconds maxPause);
+    /// @return the number of scan Tasks preempted.
+    uint64_t getPreempts() const { return _preempts; }
 
 private:
     bool _ready();
+    bool _deadlineAtRisk();
+    int _countLate(std::chrono::milliseconds after);
+    util::Command::Ptr _getTask();
+
+    void _lockIndexes(wbase::Task::Ptr const& task);
 
     std::deque<GroupQueue::Ptr> _queue;
     int _maxGroupSize{1};
+    memman::MemMan::Ptr _memMan; ///< Locks the index files, may be nullptr.
+
+    int _preemptsPending{0}; ///< Scan Tasks that yielded to Tasks not started yet, protected by _mx.
+    std::atomic<uint64_t> _preempts{0};
+    std::condition_variable _preemptCv; ///< Notified when queued Tasks start or are cancelled.
 };
 
 }}} // namespace lsst::qserv::wsched
@@ -48,6 +48,7 @@
 #include "wcontrol/Foreman.h"
 #include "wsched/BlendScheduler.h"
 #include "wsched/ChunkDisk.h"
+#include "wsched/ChunkDevicesQueue.h"
 #include "wsched/ChunkTasksQueue.h"
 
 namespace {
@@ -70,6 +71,16 @@ ScanScheduler::ScanScheduler(std::string const& name, int maxThreads, int maxRes
 }
 
 
+void ScanScheduler::useDeviceQueues(int maxChunksRotational) {
+    std::lock_guard<std::mutex> lock(util::CommandQueue::_mx);
+    if (!_taskQueue->empty()) {
+        LOGS(_log, LOG_LVL_WARN, getName() << " useDeviceQueues ignored, Tasks already queued");
+        return;
+    }
+    _taskQueue = std::make_shared<ChunkDevicesQueue>(this, _memMan, nullptr, maxChunksRotational);
+}
+
+
 void ScanScheduler::commandStart(util::Command::Ptr const& cmd) {
     wbase::Task::Ptr task = std::dynamic_pointer_cast<wbase::Task>(cmd);
     _infoChanged = true;
@@ -106,7 +117,10 @@ void ScanScheduler::commandFinish(util::Command::Ptr const& cmd) {
         // Wait to unlock the tables until after the next call to _ready or commandFinish.
         // This is done in case only one thread is running on this scheduler as
         // we don't want to release the tables in case the next Task wants some of them.
-        if (!_taskQueue->empty()) {
+        // A preempted Task is still reading its tables and unlocks them itself.
+        if (t->getPreempted()) {
+            LOGS(_log, LOG_LVL_DEBUG, t->getIdStr() << " preempted, keeping handle=" << t->getMemHandle());
+        } else if (!_taskQueue->empty()) {
             _memManHandleToUnlock = t->getMemHandle();
             LOGS(_log, LOG_LVL_DEBUG, t->getIdStr() << " setting handleToUnlock handle=" << _memManHandleToUnlock);
         } else {
@@ -123,6 +137,24 @@ void ScanScheduler::commandFinish(util::Command::Ptr const& cmd) {
 }
 
 
+bool ScanScheduler::preempt(wbase::Task& task) {
+    if (_blendScheduler == nullptr || !_blendScheduler->preemptScan()) {
+        return false;
+    }
+    LOGS(_log, LOG_LVL_INFO, task.getIdStr() << " " << getName() << " preempted for interactive Tasks");
+    task.setPreempted(true);
+    return true;
+}
+
+
+void ScanScheduler::waitPreempted(wbase::Task& task) {
+    if (_blendScheduler != nullptr) {
+        _blendScheduler->waitPreempted();
+    }
+    LOGS(_log, LOG_LVL_DEBUG, task.getIdStr() << " " << getName() << " resuming after preemption");
+}
+
+
 /// Returns true if there is a Task ready to go and we aren't up against any limits.
 bool ScanScheduler::ready() {
     std::lock_guard<std::mutex> lock(util::CommandQueue::_mx);
@@ -140,6 +172,9 @@ bool ScanScheduler::_ready() {
              << _inFlight << " maxThreads=" << _maxThreads << " adj=" << _maxThreadsAdj
              << " activeChunks=" << getActiveChunkCount());
     }
+    if (!_cancelledTasks.empty()) {
+        return true; // They return at once, limits do not apply.
+    }
     if (_inFlight >= maxInFlight()) {
         if (logStuff) {
             LOGS(_log, LOG_LVL_DEBUG, "ScanScheduler::_ready too many in flight "
@@ -188,7 +223,7 @@ bool ScanScheduler::_ready() {
 
 std::size_t ScanScheduler::getSize() const {
     std::lock_guard<std::mutex> lock(util::CommandQueue::_mx);
-    return _taskQueue->getSize();
+    return _taskQueue->getSize() + _cancelledTasks.size();
 }
 
 
@@ -199,7 +234,18 @@ util::Command::Ptr ScanScheduler::getCmd(bool wait)  {
     } else if (!_ready()) {
         return nullptr;
     }
+    auto cancelled = _getCancelledTask();
+    if (cancelled != nullptr) {
+        return cancelled;
+    }
     bool useFlexibleLock = (_inFlight < 1);
+    return _getTask(useFlexibleLock);
+}
+
+
+/// Precondition: _mx is locked
+/// @return the next Task from _taskQueue, registered as in flight, or nullptr.
+wbase::Task::Ptr ScanScheduler::_getTask(bool useFlexibleLock) {
     auto task = _taskQueue->getTask(useFlexibleLock);
     if (task != nullptr) {
         ++_inFlight; // in flight as soon as it is off the queue.
@@ -212,6 +258,37 @@ util::Command::Ptr ScanScheduler::getCmd(bool wait)  {
 }
 
 
+bool ScanScheduler::readyToBorrow() {
+    std::lock_guard<std::mutex> lock(util::CommandQueue::_mx);
+    return _readyToBorrow();
+}
+
+
+/// Precondition: _mx is locked
+/// Lent threads are only used for chunks that already have Tasks in flight,
+/// as their tables are locked in memory and the extra Task costs no i/o.
+/// The normal limits of maxInFlight() do not apply, but _maxThreads does.
+bool ScanScheduler::_readyToBorrow() {
+    if (_inFlight < 1 || _inFlight >= _maxThreads) {
+        return false;
+    }
+    auto chunkQueue = std::dynamic_pointer_cast<ChunkTasksQueue>(_taskQueue);
+    if (chunkQueue == nullptr || !chunkQueue->ready(false)) {
+        return false;
+    }
+    return chunkAlreadyActive(chunkQueue->getReadyChunkId());
+}
+
+
+util::Command::Ptr ScanScheduler::getBorrowedCmd() {
+    std::lock_guard<std::mutex> lock(util::CommandQueue::_mx);
+    if (!_readyToBorrow()) {
+        return nullptr;
+    }
+    return _getTask(false);
+}
+
+
 void ScanScheduler::queCmd(util::Command::Ptr const& cmd) {
     wbase::Task::Ptr t = std::dynamic_pointer_cast<wbase::Task>(cmd);
     if (t == nullptr) {
@@ -274,6 +351,32 @@ bool ScanScheduler::removeTask(wbase::Task::Ptr const& task, bool removeRunning)
 }
 
 
+/// Remove the queued Tasks of 'qId' from _taskQueue and unlock the tables that were
+/// locked for them right away, instead of when they finish.
+int ScanScheduler::cancelQuery(QueryId qId) {
+    int count = 0;
+    {
+        std::lock_guard<std::mutex> lock(util::CommandQueue::_mx);
+        auto tasks = _taskQueue->removeQuery(qId);
+        for (auto const& task : tasks) {
+            if (task->hasMemHandle()) {
+                LOGS(_log, LOG_LVL_DEBUG, task->getIdStr() << " cancelQuery unlocking handle="
+                     << task->getMemHandle());
+                _memMan->unlock(task->getMemHandle());
+            }
+            task->setMemHandle(memman::MemMan::HandleType::ISEMPTY);
+        }
+        _addCancelledTasks(tasks);
+        count = tasks.size();
+        _infoChanged = true;
+    }
+    LOGS(_log, LOG_LVL_INFO, QueryIdHelper::makeIdStr(qId) << " cancelQuery " << getName()
+         << " cancelled " << count << " queued Tasks");
+    util::CommandQueue::_cv.notify_all();
+    return count;
+}
+
+
 void ScanScheduler::logMemManStats() {
     LOGS(_log, LOG_LVL_DEBUG, "Scan " <<_memMan->getStatistics().logString());
 }
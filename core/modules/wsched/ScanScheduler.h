@@ -82,10 +82,29 @@ public:
     void logMemManStats();
 
     double getMaxTimeMinutes() const { return _maxTimeMinutes; }
+    void setMaxTimeMinutes(double minutes) { _maxTimeMinutes = minutes; }
+
+    /// @return true if a Task for a chunk this scheduler is already working on
+    ///         could run in a thread lent by an idle scheduler.
+    bool readyToBorrow();
+    /// @return a Task ready to run in a lent thread or nullptr.
+    util::Command::Ptr getBorrowedCmd();
+
     bool removeTask(wbase::Task::Ptr const& task, bool removeRunning) override;
+    int cancelQuery(QueryId qId) override;
+    int getScanCursor(int chunkId) override { return _taskQueue->getScanCursor(chunkId); }
+    bool preempt(wbase::Task& task) override;
+    void waitPreempted(wbase::Task& task) override;
+
+    /// Queue Tasks by the block device holding their chunk, see ChunkDevicesQueue.
+    /// This has no effect once Tasks have been queued.
+    /// @param maxChunksRotational - chunks read at the same time from a spinning disk.
+    void useDeviceQueues(int maxChunksRotational);
 
 private:
     bool _ready();
+    bool _readyToBorrow();
+    wbase::Task::Ptr _getTask(bool useFlexibleLock);
     std::shared_ptr<ChunkTaskCollection> _taskQueue; ///< Constrains access to files.
 
     memman::MemMan::Ptr _memMan; ///< Limits queries when resources not available.
@@ -97,7 +116,7 @@ private:
 
     /// Maximum amount of time a UserQuery (all of its Tasks for this worker) should
     /// take to complete on this scheduler.
-    double _maxTimeMinutes;
+    std::atomic<double> _maxTimeMinutes;
 
     std::atomic<bool> _infoChanged{true}; ///< "Used to limit the amount of debug logging.
 };
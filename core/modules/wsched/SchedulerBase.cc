@@ -99,6 +99,28 @@ void SchedulerBase::_decrChunkTaskCount(int chunkId) {
 }
 
 
+void SchedulerBase::_addCancelledTasks(std::vector<wbase::Task::Ptr> const& tasks) {
+    for (auto const& task : tasks) {
+        task->cancel();
+        LOGS(_log, LOG_LVL_DEBUG, task->getIdStr() << " cancelled on " << getName());
+        _cancelledTasks.push_back(task);
+    }
+}
+
+
+wbase::Task::Ptr SchedulerBase::_getCancelledTask() {
+    if (_cancelledTasks.empty()) {
+        return nullptr;
+    }
+    auto task = _cancelledTasks.front();
+    _cancelledTasks.pop_front();
+    ++_inFlight; // commandFinish() will be called for it as for any other Task.
+    _decrCountForUserQuery(task->getQueryId());
+    _incrChunkTaskCount(task->getChunkId());
+    return task;
+}
+
+
 int SchedulerBase::getActiveChunkCount() {
     std::lock_guard<std::mutex> lock(_countsMutex);
     return _chunkTasks.size();
@@ -26,6 +26,11 @@
 #define LSST_QSERV_WSCHED_SCHEDULERBASE_H
 
 // System headers
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <vector>
 
 // Qserv headers
 #include "wcontrol/Foreman.h"
@@ -42,6 +47,8 @@ class BlendScheduler;
 class SchedulerBase : public wcontrol::Scheduler {
 public:
     using Ptr = std::shared_ptr<SchedulerBase>;
+    /// Function called with the queued Tasks of a chunk that becomes active.
+    using ChunkActiveFunc = std::function<void(std::vector<wbase::Task::Ptr> const& tasks)>;
 
     static int getMaxPriority(){ return 1000000000; }
 
@@ -76,13 +83,20 @@ public:
     int getMaxReserve() { return _maxReserve; }
     virtual void setMaxReserve(int maxReserve) { _maxReserve = maxReserve; }
     void restoreMaxReserve() { setMaxReserve(_maxReserveDefault); }
+    /// Change the reserve this scheduler returns to, and its current reserve.
+    void setMaxReserveDefault(int maxReserve) {
+        _maxReserveDefault = maxReserve;
+        setMaxReserve(maxReserve);
+    }
+    int getMaxThreads() const { return _maxThreads; }
+    void setMaxThreads(int maxThreads) { _maxThreads = std::max(1, maxThreads); }
 
     /// Use the number of available threads to determine how many threads this
     /// scheduler can use (_maxThreadAdj).
     /// @return (availableThreads - (The number of threads beyond our reserve that we are using.))
     virtual int applyAvailableThreads(int availableThreads) {
         _maxThreadsAdj = availableThreads + desiredThreadReserve();
-        int remainingThreads = availableThreads - std::max(0, _inFlight - _maxReserve);
+        int remainingThreads = availableThreads - std::max(0, _inFlight - _maxReserve.load());
         return remainingThreads;
     }
 
@@ -93,11 +107,11 @@ public:
     /// do not get interrupted, or in the case of 1 Task, a second Task can be started right away.
     /// If 3 or more Tasks are running it still asks for 2 to be reserved.
     virtual int desiredThreadReserve() {
-        return std::min(_inFlight + 1, _maxReserve);
+        return std::min(_inFlight + 1, _maxReserve.load());
     }
 
     /// Return maximum number of Tasks this scheduler can have inFlight.
-    virtual int maxInFlight() { return std::min(_maxThreads, _maxThreadsAdj); }
+    virtual int maxInFlight() { return std::min(_maxThreads.load(), _maxThreadsAdj); }
 
     std::string chunkStatusStr(); //< @return a string
 
@@ -111,6 +125,11 @@ public:
     void setDefaultPosition(int val) { _defaultPosition = val; }
     int getDefaultPosition() const { return _defaultPosition; }
 
+    /// Set the function called when a chunk becomes active. It is called with
+    /// the scheduler locked and must not block. Set it before Tasks are queued.
+    void setChunkActiveFunc(ChunkActiveFunc const& func) { _chunkActiveFunc = func; }
+    ChunkActiveFunc const& getChunkActiveFunc() const { return _chunkActiveFunc; }
+
 protected:
     /// Increment the _userQueryCounts entry for queryId, creating it if needed.
     /// Precondition util::CommandQueue::_mx must be locked.
@@ -124,10 +143,19 @@ protected:
     void _incrChunkTaskCount(int chunkId); //< Increase the count of Tasks working on this chunk.
     void _decrChunkTaskCount(int chunkId); //< Decrease the count of Tasks working on this chunk.
 
+    /// Cancel 'tasks', which were removed from the queue, and keep them in _cancelledTasks.
+    /// Precondition util::CommandQueue::_mx must be locked.
+    void _addCancelledTasks(std::vector<wbase::Task::Ptr> const& tasks);
+
+    /// @return the first Task of _cancelledTasks, registered as in flight, or nullptr.
+    /// Precondition util::CommandQueue::_mx must be locked.
+    wbase::Task::Ptr _getCancelledTask();
+
     std::string const _name{}; //< Name of this scheduler.
-    int _maxReserve{1};    //< Number of threads this scheduler would like to have reserved for its use.
-    int _maxReserveDefault{1};
-    int _maxThreads{1};    //< Maximum number of threads for this scheduler to have inFlight.
+    // The limits below may be changed while the worker runs, see wcontrol::RuntimeConfig.
+    std::atomic<int> _maxReserve{1}; //< Number of threads this scheduler would like to have reserved for its use.
+    std::atomic<int> _maxReserveDefault{1};
+    std::atomic<int> _maxThreads{1}; //< Maximum number of threads for this scheduler to have inFlight.
     int _maxThreadsAdj{1}; //< Maximum number of threads to have inFlight adjusted for available pool.
 
     BlendScheduler *_blendScheduler{nullptr};
@@ -136,6 +164,9 @@ protected:
 
     std::atomic<int> _inFlight{0}; //< Number of Tasks running.
 
+    /// Tasks removed from the queue by cancelQuery(), protected by util::CommandQueue::_mx.
+    std::deque<wbase::Task::Ptr> _cancelledTasks;
+
 private:
     /// The true purpose of _userQuerycount is to track how many different UserQuery's are on the queue.
     /// Number of Tasks for each UserQuery in the queue.
@@ -145,8 +176,9 @@ private:
     std::mutex _countsMutex; ///< Protects _userQueryCounts and _chunkTasks.
     // TODO: Decide to keep or remove _maxActiveChunks and related code. This depends primarily
     //       on 'everything' scheduler limits/needs.
-    int _maxActiveChunks; ///< Limit the number of chunks this scheduler can work on at one time.
+    std::atomic<int> _maxActiveChunks; ///< Limit the number of chunks this scheduler can work on at one time.
     int _defaultPosition{10}; ///< Position of this scheduler in the list of schedulers.
+    ChunkActiveFunc _chunkActiveFunc; ///< May be empty.
 };
 
 }}} // namespace lsst::qserv::wsched
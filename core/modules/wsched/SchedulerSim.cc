@@ -0,0 +1,470 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// Class header
+#include "wsched/SchedulerSim.h"
+
+// System headers
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <ostream>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+// Qserv headers
+#include "memman/MemMan.h"
+#include "proto/ScanTableInfo.h"
+#include "proto/worker.pb.h"
+#include "wbase/Task.h"
+#include "wpublish/QueriesAndChunks.h"
+#include "wsched/BlendScheduler.h"
+#include "wsched/GroupScheduler.h"
+#include "wsched/ScanScheduler.h"
+
+namespace lsst {
+namespace qserv {
+namespace wsched {
+
+namespace {
+
+/// A MemMan that only keeps the accounts. The tables of a chunk take
+/// tableBytes while they have a handle and are read, one table after the
+/// other, when the first task holding them starts.
+class SimMemMan : public memman::MemMan {
+public:
+    SimMemMan(uint64_t maxBytes, uint64_t tableBytes, double readBytesPerSec)
+        : _maxBytes(maxBytes), _tableBytes(tableBytes), _readBytesPerSec(readBytesPerSec) {}
+
+    int lock(Handle handle, bool strict=false) override { return 0; }
+
+    uint64_t prefetch(std::vector<memman::TableInfo> const& tables, int chunk) override { return 0; }
+
+    Handle prepare(std::vector<memman::TableInfo> const& tables, int chunk) override {
+        HandleInfo info;
+        info.chunk = chunk;
+        uint64_t needed = 0;
+        bool required = false;
+        for (auto const& tbl : tables) {
+            if (tbl.theData == memman::TableInfo::LockType::NOLOCK) continue;
+            std::string key = tbl.tableName + ":" + std::to_string(chunk);
+            if (_tables.find(key) == _tables.end()) needed += _tableBytes;
+            required |= tbl.theData == memman::TableInfo::LockType::REQUIRED;
+            info.keys.push_back(std::move(key));
+        }
+        if (info.keys.empty()) return HandleType::ISEMPTY;
+        if (_usedBytes + needed > _maxBytes) {
+            ++memWaits;
+            if (required) {
+                errno = ENOMEM;
+                return HandleType::INVALID;
+            }
+            // Flexible tables that do not fit are read by the task without being kept.
+            info.unlockedBytes = _tableBytes * info.keys.size();
+            info.keys.clear();
+        }
+        for (auto const& key : info.keys) {
+            auto& table = _tables[key];
+            if (table.refs++ == 0) _usedBytes += _tableBytes;
+        }
+        Handle const handle = _nextHandle++;
+        _handles[handle] = std::move(info);
+        return handle;
+    }
+
+    bool unlock(Handle handle) override {
+        auto iter = _handles.find(handle);
+        if (iter == _handles.end()) return handle == HandleType::ISEMPTY;
+        for (auto const& key : iter->second.keys) {
+            auto tIter = _tables.find(key);
+            if (--tIter->second.refs == 0) {
+                _usedBytes -= _tableBytes;
+                _tables.erase(tIter);
+            }
+        }
+        _handles.erase(iter);
+        return true;
+    }
+
+    void unlockAll() override {
+        _handles.clear();
+        _tables.clear();
+        _usedBytes = 0;
+    }
+
+    Statistics getStatistics() override {
+        Statistics stats = Statistics();
+        stats.bytesLockMax = _maxBytes;
+        stats.bytesLocked = _usedBytes;
+        stats.numFSets = _handles.size();
+        stats.numFiles = _tables.size();
+        return stats;
+    }
+
+    Status getStatus(Handle handle) override {
+        auto iter = _handles.find(handle);
+        if (iter == _handles.end()) return Status();
+        auto const& info = iter->second;
+        return Status(_tableBytes * info.keys.size(), 0, info.keys.size(), info.chunk);
+    }
+
+    void setMaxBytes(uint64_t maxBytes) override { _maxBytes = maxBytes; }
+
+    std::string filePath(std::string const& dbTable, int chunk) override { return std::string(); }
+
+    /// @return the time the tables of 'handle' are in memory, reading the
+    ///         ones not read yet from 'now' on.
+    double readyAt(Handle handle, double now) {
+        auto iter = _handles.find(handle);
+        if (iter == _handles.end()) return now;
+        double ready = now;
+        for (auto const& key : iter->second.keys) {
+            auto& table = _tables[key];
+            if (table.readyAt < 0) table.readyAt = _read(_tableBytes, now);
+            ready = std::max(ready, table.readyAt);
+        }
+        if (iter->second.unlockedBytes > 0) {
+            ready = std::max(ready, _read(iter->second.unlockedBytes, now));
+        }
+        return ready;
+    }
+
+    uint64_t tablesRead{0};
+    uint64_t bytesRead{0};
+    uint64_t memWaits{0};
+
+private:
+    struct Table {
+        int refs{0};
+        double readyAt{-1}; ///< Time the table is read, -1 until a task starts on it.
+    };
+    struct HandleInfo {
+        int chunk{-1};
+        std::vector<std::string> keys;
+        uint64_t unlockedBytes{0};
+    };
+
+    /// @return the time 'bytes' are read starting no sooner than 'now'.
+    double _read(uint64_t bytes, double now) {
+        _diskFreeAt = std::max(_diskFreeAt, now) + bytes / _readBytesPerSec;
+        ++tablesRead;
+        bytesRead += bytes;
+        return _diskFreeAt;
+    }
+
+    uint64_t _maxBytes;
+    uint64_t const _tableBytes;
+    double const _readBytesPerSec;
+    uint64_t _usedBytes{0};
+    double _diskFreeAt{0};
+    Handle _nextHandle{HandleType::ISEMPTY + 1};
+    std::map<std::string, Table> _tables;
+    std::unordered_map<Handle, HandleInfo> _handles;
+};
+
+
+void writeSeconds(std::ostream& os, std::string const& name, std::vector<double> const& vals) {
+    os << "\"" << name << "\": {"
+       << "\"p50\": " << SchedulerSim::Report::percentile(vals, 0.50) << ", "
+       << "\"p90\": " << SchedulerSim::Report::percentile(vals, 0.90) << ", "
+       << "\"p99\": " << SchedulerSim::Report::percentile(vals, 0.99) << ", "
+       << "\"max\": " << (vals.empty() ? 0 : vals.back()) << "}";
+}
+
+} // anonymous namespace
+
+
+double SchedulerSim::Report::percentile(std::vector<double> const& vals, double fraction) {
+    if (vals.empty()) return 0;
+    size_t rank = static_cast<size_t>(fraction * vals.size() + 0.999999);
+    return vals[std::min(vals.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+
+void SchedulerSim::Report::write(std::ostream& os) const {
+    double const perSec = seconds > 0 ? 1.0 / seconds : 0;
+    os << "{\"seconds\": " << seconds << ", \"tasks\": " << tasks
+       << ", \"unfinished\": " << unfinished
+       << ", \"tasks_per_sec\": " << tasks * perSec
+       << ", \"result_bytes\": " << resultBytes
+       << ", \"result_mb_per_sec\": " << resultBytes * perSec / 1e6
+       << ", \"tables_read\": " << tablesRead << ", \"bytes_read\": " << bytesRead
+       << ", \"mem_waits\": " << memWaits << ", \"schedulers\": {";
+    std::string sep;
+    for (auto const& sched : schedulers) {
+        os << sep << "\"" << sched.name << "\": {\"tasks\": " << sched.tasks
+           << ", \"chunk_switches\": " << sched.chunkSwitches << ", \"starved\": " << sched.starved << ", ";
+        writeSeconds(os, "wait_s", sched.waits);
+        os << ", ";
+        writeSeconds(os, "total_s", sched.totals);
+        os << "}";
+        sep = ", ";
+    }
+    os << "}}" << std::endl;
+}
+
+
+void SchedulerSim::add(std::vector<TaskSpec> const& specs) {
+    _specs.insert(_specs.end(), specs.begin(), specs.end());
+}
+
+
+std::vector<SchedulerSim::TaskSpec> SchedulerSim::makeSynthetic(Synthetic const& synth) {
+    std::vector<TaskSpec> specs;
+    std::mt19937 gen(synth.seed);
+    QueryId qId = 1;
+    for (int j = 0; j < synth.scanQueries; ++j, ++qId) {
+        int const rating = synth.scanRatings.empty() ? 10 : synth.scanRatings[j % synth.scanRatings.size()];
+        std::exponential_distribution<double> seconds(1.0 / (synth.scanSeconds * std::max(1, rating / 10)));
+        for (int chunkId = 1; chunkId <= synth.chunks; ++chunkId) {
+            TaskSpec spec;
+            spec.arrival = j * synth.scanInterval;
+            spec.queryId = qId;
+            spec.chunkId = chunkId;
+            spec.scanRating = rating;
+            // Queries of the same rating scan the same table and can share it.
+            spec.table = "Table" + std::to_string(rating);
+            spec.seconds = seconds(gen);
+            spec.resultBytes = synth.scanResultBytes;
+            specs.push_back(spec);
+        }
+    }
+    std::exponential_distribution<double> interval(1.0 / synth.interactiveInterval);
+    std::exponential_distribution<double> seconds(1.0 / synth.interactiveSeconds);
+    std::uniform_int_distribution<int> chunk(1, std::max(1, synth.chunks));
+    double arrival = 0;
+    for (int j = 0; j < synth.interactiveQueries; ++j, ++qId) {
+        arrival += interval(gen);
+        TaskSpec spec;
+        spec.arrival = arrival;
+        spec.queryId = qId;
+        spec.chunkId = chunk(gen);
+        spec.interactive = true;
+        spec.seconds = seconds(gen);
+        spec.resultBytes = 1000;
+        specs.push_back(spec);
+    }
+    return specs;
+}
+
+
+std::vector<SchedulerSim::TaskSpec> SchedulerSim::read(std::istream& is) {
+    std::vector<TaskSpec> specs;
+    std::string line;
+    for (int lineNum = 1; std::getline(is, line); ++lineNum) {
+        if (line.empty() || line[0] == '#') continue;
+        std::vector<std::string> fields;
+        std::istringstream ls(line);
+        for (std::string field; std::getline(ls, field, ',');) {
+            fields.push_back(field);
+        }
+        if (fields.size() != 8 && fields.size() != 9) {
+            throw std::invalid_argument("line " + std::to_string(lineNum) + ": expected 8 or 9 fields");
+        }
+        TaskSpec spec;
+        try {
+            spec.arrival = std::stod(fields[0]);
+            spec.queryId = std::stoull(fields[1]);
+            spec.chunkId = std::stoi(fields[2]);
+            spec.scanRating = std::stoi(fields[3]);
+            spec.interactive = std::stoi(fields[4]) != 0;
+            spec.table = fields[5];
+            spec.seconds = std::stod(fields[6]);
+            spec.resultBytes = std::stoull(fields[7]);
+        } catch (std::logic_error const& ex) {
+            throw std::invalid_argument("line " + std::to_string(lineNum) + ": " + ex.what());
+        }
+        if (fields.size() == 9) spec.user = fields[8];
+        specs.push_back(spec);
+    }
+    return specs;
+}
+
+
+SchedulerSim::Report SchedulerSim::run() {
+    // The schedulers are set up as in xrdsvc::SsiService with the default configuration.
+    int const fastest = proto::ScanInfo::Rating::FASTEST;
+    int const fast    = proto::ScanInfo::Rating::FAST;
+    int const medium  = proto::ScanInfo::Rating::MEDIUM;
+    int const slow    = proto::ScanInfo::Rating::SLOW;
+    int const slowest = proto::ScanInfo::Rating::SLOWEST;
+    auto memMan = std::make_shared<SimMemMan>(_config.memoryBytes, _config.tableBytes,
+                                              _config.readBytesPerSec);
+    int const maxThread = _config.poolSize;
+    int const maxActive = _config.maxActiveChunks;
+    auto group = std::make_shared<GroupScheduler>("SchedGroup", maxThread, _config.maxReserve,
+                                                  _config.maxGroupSize, SchedulerBase::getMaxPriority());
+    std::vector<ScanScheduler::Ptr> scanSchedulers{
+        std::make_shared<ScanScheduler>("SchedSlow", maxThread, _config.maxReserve, 2,
+                                        std::max(1, maxActive / 2), memMan, medium+1, slow, 60*12),
+        std::make_shared<ScanScheduler>("SchedFast", maxThread, _config.maxReserve, 4,
+                                        maxActive, memMan, fastest, fast, 60),
+        std::make_shared<ScanScheduler>("SchedMed", maxThread, _config.maxReserve, 3,
+                                        maxActive, memMan, fast+1, medium, 60*8)
+    };
+    auto snail = std::make_shared<ScanScheduler>("SchedSnail", maxThread, _config.maxReserve, 1,
+                                                 1, memMan, slow+1, slowest, 60*24);
+    // No thread examines the queries, so nothing is booted for taking too long.
+    // The thread removing dead queries wakes up every second, so that it can
+    // be joined soon after the run.
+    auto queries = std::make_shared<wpublish::QueriesAndChunks>(std::chrono::seconds(1),
+                                                                std::chrono::seconds(0), 5);
+    auto blend = std::make_shared<BlendScheduler>("BlendSched", queries, maxThread, group, snail,
+                                                  scanSchedulers);
+    blend->setMaxLentThreads(_config.maxLentThreads);
+    queries->setBlendScheduler(blend);
+
+    std::unique_ptr<FairShareAdmission> admission;
+    if (_config.fairShare.isEnabled()) {
+        admission.reset(new FairShareAdmission(_config.fairShare,
+                [&blend](wbase::Task::Ptr const& task) { blend->queCmd(task); }));
+    }
+
+    std::vector<TaskSpec> specs(_specs);
+    std::stable_sort(specs.begin(), specs.end(),
+                     [](TaskSpec const& a, TaskSpec const& b) { return a.arrival < b.arrival; });
+
+    struct Finish {
+        double time;
+        uint64_t seq; ///< Keeps the order of tasks finishing at the same time.
+        wbase::Task::Ptr task;
+        bool operator>(Finish const& other) const {
+            return time > other.time || (time == other.time && seq > other.seq);
+        }
+    };
+    std::priority_queue<Finish, std::vector<Finish>, std::greater<Finish>> running;
+    struct TaskRecord {
+        size_t spec;
+        double start{0};
+        size_t sched{0};
+    };
+    std::unordered_map<wbase::Task const*, TaskRecord> records;
+    std::map<std::string, size_t> schedIndex;
+    std::vector<std::map<int, int>> runningOnChunk; ///< Running Tasks by chunk, of each scheduler.
+
+    Report report;
+    double now = 0;
+    size_t next = 0;
+    uint64_t seq = 0;
+    int jobId = 0;
+    while (true) {
+        for (; next < specs.size() && specs[next].arrival <= now; ++next) {
+            auto const& spec = specs[next];
+            auto msg = std::make_shared<proto::TaskMsg>();
+            msg->set_session(0);
+            msg->set_queryid(spec.queryId);
+            msg->set_jobid(jobId++);
+            msg->set_czarid(1);
+            msg->set_chunkid(spec.chunkId);
+            msg->set_db("sim");
+            msg->set_user(spec.user);
+            msg->set_scanpriority(spec.scanRating);
+            msg->set_scaninteractive(spec.interactive);
+            if (!spec.table.empty()) {
+                auto sTbl = msg->add_scantable();
+                sTbl->set_db("sim");
+                sTbl->set_table(spec.table);
+                sTbl->set_scanrating(spec.scanRating);
+                sTbl->set_lockinmemory(true);
+            }
+            auto frag = msg->add_fragment();
+            frag->add_query("SELECT 1");
+            frag->set_resulttable("r_sim");
+            auto task = std::make_shared<wbase::Task>(msg, std::shared_ptr<wbase::SendChannel>());
+            task->setSafeToMoveRunning(true); // Nothing waits for MemMan.
+            records[task.get()].spec = next;
+            if (admission == nullptr) {
+                blend->queCmd(task);
+            } else if (!admission->add(task)) {
+                records.erase(task.get());
+                ++report.unfinished;
+            }
+        }
+
+        // Start Tasks while threads are free, as the pool threads would.
+        while (static_cast<int>(running.size()) < _config.poolSize) {
+            auto task = std::dynamic_pointer_cast<wbase::Task>(blend->getCmd(false));
+            if (task == nullptr) break;
+            blend->commandStart(task);
+            auto& rec = records[task.get()];
+            auto const& spec = specs[rec.spec];
+            auto sched = std::dynamic_pointer_cast<SchedulerBase>(task->getTaskScheduler());
+            std::string const name = (sched == nullptr) ? "none" : sched->getName();
+            auto res = schedIndex.insert(std::make_pair(name, report.schedulers.size()));
+            if (res.second) {
+                report.schedulers.emplace_back();
+                report.schedulers.back().name = name;
+                runningOnChunk.emplace_back();
+            }
+            rec.sched = res.first->second;
+            rec.start = now;
+            auto& sReport = report.schedulers[rec.sched];
+            ++sReport.tasks;
+            if (runningOnChunk[rec.sched][spec.chunkId]++ == 0) ++sReport.chunkSwitches;
+            double const wait = now - spec.arrival;
+            sReport.waits.push_back(wait);
+            if (wait > _config.starvedSeconds) ++sReport.starved;
+            double const finish = memMan->readyAt(task->getMemHandle(), now) + spec.seconds
+                                  + spec.resultBytes / _config.resultBytesPerSec;
+            running.push(Finish{finish, seq++, task});
+        }
+
+        double nextTime = std::numeric_limits<double>::infinity();
+        if (next < specs.size()) nextTime = specs[next].arrival;
+        if (!running.empty()) nextTime = std::min(nextTime, running.top().time);
+        if (std::isinf(nextTime)) break; // Done, or the queued Tasks can never run.
+        now = std::max(now, nextTime);
+
+        while (!running.empty() && running.top().time <= now) {
+            auto task = running.top().task;
+            running.pop();
+            blend->commandFinish(task);
+            if (admission != nullptr) admission->finished(task);
+            auto iter = records.find(task.get());
+            auto const& spec = specs[iter->second.spec];
+            auto& onChunk = runningOnChunk[iter->second.sched];
+            if (--onChunk[spec.chunkId] == 0) onChunk.erase(spec.chunkId);
+            report.schedulers[iter->second.sched].totals.push_back(now - spec.arrival);
+            ++report.tasks;
+            report.resultBytes += spec.resultBytes;
+            report.seconds = now;
+            records.erase(iter);
+        }
+    }
+    report.unfinished += records.size();
+    report.tablesRead = memMan->tablesRead;
+    report.bytesRead = memMan->bytesRead;
+    report.memWaits = memMan->memWaits;
+    for (auto& sched : report.schedulers) {
+        std::sort(sched.waits.begin(), sched.waits.end());
+        std::sort(sched.totals.begin(), sched.totals.end());
+    }
+    return report;
+}
+
+}}} // namespace lsst::qserv::wsched
@@ -0,0 +1,158 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+#ifndef LSST_QSERV_WSCHED_SCHEDULERSIM_H
+#define LSST_QSERV_WSCHED_SCHEDULERSIM_H
+
+// System headers
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "global/intTypes.h"
+#include "wsched/FairShareAdmission.h"
+
+namespace lsst {
+namespace qserv {
+namespace wsched {
+
+/// SchedulerSim runs a stream of simulated tasks through the worker's real
+/// schedulers, a BlendScheduler over a GroupScheduler and the ScanSchedulers,
+/// set up as in xrdsvc::SsiService. Time is virtual, the simulation jumps from
+/// one task arrival or completion to the next, so that hours of load take
+/// seconds to replay and runs with the same input give the same result.
+///
+/// Memory is managed by a simulated MemMan. A scan table of a chunk takes
+/// tableBytes while any task holding it has a handle, and is read from a
+/// single disk at readBytesPerSec when the first task needing it starts.
+/// A task runs for its given time once its tables are read, plus the time
+/// to send its result at resultBytesPerSec.
+///
+/// Which ScanScheduler a task goes to follows its scan rating alone. Moving
+/// tasks by the measured time of past scans, such as booting slow user
+/// queries to the snail scheduler, and deadlines depend on the wall clock
+/// and are not simulated.
+class SchedulerSim {
+public:
+    /// One task of a user query. Rows of a replay file have these fields in
+    /// this order, separated by commas:
+    ///   arrival,queryId,chunkId,scanRating,interactive,table,seconds,resultBytes[,user]
+    struct TaskSpec {
+        double arrival{0};      ///< Seconds from the start of the simulation.
+        QueryId queryId{0};
+        int chunkId{0};
+        int scanRating{0};
+        bool interactive{false}; ///< Goes to the GroupScheduler.
+        std::string table;      ///< Scan table, empty for tasks not scanning a table.
+        double seconds{1};      ///< Run time once the tables are in memory.
+        uint64_t resultBytes{0};
+        std::string user{"qsmaster"};
+    };
+
+    /// Parameters of a synthetic load of full table scans over all the chunks
+    /// of the worker, and interactive queries on single chunks. Run times are
+    /// drawn from exponential distributions around the given means.
+    struct Synthetic {
+        int chunks{100};              ///< Chunks on the worker, numbered from 1.
+        int scanQueries{12};          ///< Each has a task on every chunk.
+        double scanInterval{60};      ///< Seconds between the arrival of scan queries.
+        std::vector<int> scanRatings{10, 20, 30}; ///< Used by the scan queries in turn.
+        double scanSeconds{1};        ///< Mean task run time per 10 of scan rating.
+        uint64_t scanResultBytes{100000};
+        int interactiveQueries{200};
+        double interactiveInterval{5}; ///< Mean seconds between interactive queries.
+        double interactiveSeconds{0.1};
+        unsigned int seed{1};
+    };
+
+    struct Config {
+        int poolSize{20};          ///< Threads running tasks.
+        int maxGroupSize{10};
+        int maxReserve{2};         ///< Threads reserved by each scan scheduler.
+        int maxActiveChunks{4};    ///< Of each scan scheduler.
+        int maxLentThreads{2};
+        uint64_t memoryBytes{8000ULL*1000*1000}; ///< Memory that can be locked.
+        uint64_t tableBytes{200ULL*1000*1000};   ///< Size of a scan table of a chunk.
+        double readBytesPerSec{500.0*1000*1000};
+        double resultBytesPerSec{100.0*1000*1000};
+        double starvedSeconds{600}; ///< Tasks waiting longer than this are starved.
+        FairShareAdmission::Config fairShare; ///< Admission ahead of the schedulers, if enabled.
+    };
+
+    /// What was measured for the tasks of one scheduler.
+    struct SchedulerReport {
+        std::string name;
+        uint64_t tasks{0};
+        uint64_t chunkSwitches{0}; ///< Tasks started on a chunk the scheduler had no
+                                   ///< other Task running on.
+        uint64_t starved{0};       ///< Tasks waiting more than Config::starvedSeconds.
+        std::vector<double> waits; ///< Seconds from arrival to start, sorted.
+        std::vector<double> totals; ///< Seconds from arrival to finish, sorted.
+    };
+
+    struct Report {
+        double seconds{0};         ///< Virtual time when the last task finished.
+        uint64_t tasks{0};         ///< Tasks that finished.
+        uint64_t unfinished{0};    ///< Tasks refused by admission or left queued when
+                                   ///< nothing could run anymore.
+        uint64_t resultBytes{0};
+        uint64_t tablesRead{0};
+        uint64_t bytesRead{0};
+        uint64_t memWaits{0};      ///< Times prepare() found too little memory.
+        std::vector<SchedulerReport> schedulers;
+
+        /// @return the value at 'fraction' of sorted 'vals' by nearest rank.
+        static double percentile(std::vector<double> const& vals, double fraction);
+        /// Write the report as a JSON object.
+        void write(std::ostream& os) const;
+    };
+
+    explicit SchedulerSim(Config const& config) : _config(config) {}
+
+    SchedulerSim(SchedulerSim const&) = delete;
+    SchedulerSim& operator=(SchedulerSim const&) = delete;
+
+    void add(TaskSpec const& spec) { _specs.push_back(spec); }
+    void add(std::vector<TaskSpec> const& specs);
+
+    /// @return the tasks of the synthetic load 'synth'.
+    static std::vector<TaskSpec> makeSynthetic(Synthetic const& synth);
+
+    /// @return the tasks of a replay file, skipping empty lines and lines
+    ///         starting with '#'.
+    /// @throws std::invalid_argument if a line cannot be parsed.
+    static std::vector<TaskSpec> read(std::istream& is);
+
+    /// Run all the tasks added so far.
+    Report run();
+
+private:
+    Config const _config;
+    std::vector<TaskSpec> _specs;
+};
+
+}}} // namespace lsst::qserv::wsched
+
+#endif // LSST_QSERV_WSCHED_SCHEDULERSIM_H
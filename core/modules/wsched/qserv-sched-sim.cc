@@ -0,0 +1,164 @@
+// System header
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+// Qserv headers
+#include "proto/worker.pb.h"
+#include "util/CmdLineParser.h"
+#include "wsched/SchedulerSim.h"
+
+namespace util   = lsst::qserv::util;
+namespace wsched = lsst::qserv::wsched;
+
+namespace {
+
+// Command line parameters
+
+std::string operation;
+std::string replayFileName;
+std::string jsonFileName;
+
+wsched::SchedulerSim::Config config;
+wsched::SchedulerSim::Synthetic synth;
+
+int run() {
+    std::vector<wsched::SchedulerSim::TaskSpec> specs;
+    if (::operation == "REPLAY") {
+        std::ifstream file(::replayFileName);
+        if (not file.good()) {
+            std::cerr << "error: failed to open the replay file: " << ::replayFileName << std::endl;
+            return 1;
+        }
+        try {
+            specs = wsched::SchedulerSim::read(file);
+        } catch (std::invalid_argument const& ex) {
+            std::cerr << "error: " << ::replayFileName << " " << ex.what() << std::endl;
+            return 1;
+        }
+    } else {
+        specs = wsched::SchedulerSim::makeSynthetic(::synth);
+    }
+    std::cerr << "simulating " << specs.size() << " tasks" << std::endl;
+
+    wsched::SchedulerSim sim(::config);
+    sim.add(specs);
+    auto report = sim.run();
+    if (::jsonFileName.empty()) {
+        report.write(std::cout);
+    } else {
+        std::ofstream file(::jsonFileName);
+        report.write(file);
+    }
+    return 0;
+}
+} // namespace
+
+int main(int argc, const char* const argv[]) {
+
+    // Verify that the version of the library that we linked against is
+    // compatible with the version of the headers we compiled against.
+
+    GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+    // Parse command line parameters
+    try {
+        util::CmdLineParser parser(
+            argc,
+            argv,
+            "\n"
+            "Usage:\n"
+            "  SYNTHETIC\n"
+            "  REPLAY    <replay-file-name>\n"
+            "  [--threads=<value>]\n"
+            "  [--group-size=<value>]\n"
+            "  [--reserve=<value>]\n"
+            "  [--max-active-chunks=<value>]\n"
+            "  [--max-lent-threads=<value>]\n"
+            "  [--memory-mb=<value>]\n"
+            "  [--table-mb=<value>]\n"
+            "  [--read-mb-sec=<value>]\n"
+            "  [--result-mb-sec=<value>]\n"
+            "  [--starved-sec=<value>]\n"
+            "  [--fair-share-slots=<value>]\n"
+            "  [--fair-share-max-inflight=<value>]\n"
+            "  [--chunks=<value>]\n"
+            "  [--scans=<value>]\n"
+            "  [--scan-interval=<seconds>]\n"
+            "  [--scan-sec=<seconds>]\n"
+            "  [--interactive=<value>]\n"
+            "  [--interactive-interval=<seconds>]\n"
+            "  [--interactive-sec=<seconds>]\n"
+            "  [--seed=<value>]\n"
+            "  [--json=<file>]\n"
+            "\n"
+            "Flags an options:\n"
+            "  --threads=<value>           - threads running tasks (default: 20)\n"
+            "  --group-size=<value>        - maximum group size of the group scheduler (default: 10)\n"
+            "  --reserve=<value>           - threads reserved by each scheduler (default: 2)\n"
+            "  --max-active-chunks=<value> - active chunks of the fast and medium scan schedulers,\n"
+            "                                the slow one gets half as many (default: 4)\n"
+            "  --max-lent-threads=<value>  - reserved threads lent to busy scan schedulers (default: 2)\n"
+            "  --memory-mb=<value>         - memory in MB that can be locked (default: 8000)\n"
+            "  --table-mb=<value>          - size in MB of a scan table of a chunk (default: 200)\n"
+            "  --read-mb-sec=<value>       - disk read rate in MB/sec (default: 500)\n"
+            "  --result-mb-sec=<value>     - rate results are sent at in MB/sec (default: 100)\n"
+            "  --starved-sec=<value>       - tasks waiting longer are counted as starved (default: 600)\n"
+            "  --fair-share-slots=<value>  - tasks of all users in the schedulers, 0 for no\n"
+            "                                admission (default: 0)\n"
+            "  --fair-share-max-inflight=<value> - tasks of one user in the schedulers (default: 0)\n"
+            "  --chunks=<value>            - SYNTHETIC: chunks on the worker (default: 100)\n"
+            "  --scans=<value>             - SYNTHETIC: full scan queries, with ratings 10, 20\n"
+            "                                and 30 in turn (default: 12)\n"
+            "  --scan-interval=<seconds>   - SYNTHETIC: time between scan queries (default: 60)\n"
+            "  --scan-sec=<seconds>        - SYNTHETIC: mean run time of a scan task per 10 of\n"
+            "                                scan rating (default: 1)\n"
+            "  --interactive=<value>       - SYNTHETIC: interactive queries (default: 200)\n"
+            "  --interactive-interval=<seconds> - SYNTHETIC: mean time between interactive\n"
+            "                                queries (default: 5)\n"
+            "  --interactive-sec=<seconds> - SYNTHETIC: mean run time of an interactive task\n"
+            "                                (default: 0.1)\n"
+            "  --seed=<value>              - SYNTHETIC: seed of the random load (default: 1)\n"
+            "  --json=<file>               - write the report to the file instead of the standard output\n"
+            "\n"
+            "Parameters:\n"
+            "  <replay-file-name>  - a file with one line for each task:\n"
+            "                        arrival,queryId,chunkId,scanRating,interactive,table,seconds,resultBytes[,user]\n"
+            "                        where arrival and seconds are in seconds, interactive is 0 or 1\n"
+            "                        and table is empty for tasks not scanning a table\n");
+
+        ::operation = parser.parameterRestrictedBy(1, {"SYNTHETIC", "REPLAY"});
+        if (::operation == "REPLAY") {
+            ::replayFileName = parser.parameter<std::string>(2);
+        }
+
+        ::config.poolSize        = parser.option<unsigned int>("threads", 20);
+        ::config.maxGroupSize    = parser.option<unsigned int>("group-size", 10);
+        ::config.maxReserve      = parser.option<unsigned int>("reserve", 2);
+        ::config.maxActiveChunks = parser.option<unsigned int>("max-active-chunks", 4);
+        ::config.maxLentThreads  = parser.option<unsigned int>("max-lent-threads", 2);
+        ::config.memoryBytes     = parser.option<unsigned int>("memory-mb", 8000) * 1000000ULL;
+        ::config.tableBytes      = parser.option<unsigned int>("table-mb", 200) * 1000000ULL;
+        ::config.readBytesPerSec   = std::stod(parser.option<std::string>("read-mb-sec", "500")) * 1e6;
+        ::config.resultBytesPerSec = std::stod(parser.option<std::string>("result-mb-sec", "100")) * 1e6;
+        ::config.starvedSeconds    = std::stod(parser.option<std::string>("starved-sec", "600"));
+        ::config.fairShare.slots       = parser.option<unsigned int>("fair-share-slots", 0);
+        ::config.fairShare.maxInFlight = parser.option<unsigned int>("fair-share-max-inflight", 0);
+
+        ::synth.chunks              = parser.option<unsigned int>("chunks", 100);
+        ::synth.scanQueries         = parser.option<unsigned int>("scans", 12);
+        ::synth.scanInterval        = std::stod(parser.option<std::string>("scan-interval", "60"));
+        ::synth.scanSeconds         = std::stod(parser.option<std::string>("scan-sec", "1"));
+        ::synth.interactiveQueries  = parser.option<unsigned int>("interactive", 200);
+        ::synth.interactiveInterval = std::stod(parser.option<std::string>("interactive-interval", "5"));
+        ::synth.interactiveSeconds  = std::stod(parser.option<std::string>("interactive-sec", "0.1"));
+        ::synth.seed                = parser.option<unsigned int>("seed", 1);
+
+        ::jsonFileName = parser.option<std::string>("json", "");
+
+    } catch (std::exception const& ex) {
+        return 1;
+    }
+    return ::run();
+}
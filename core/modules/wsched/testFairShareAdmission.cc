@@ -0,0 +1,153 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+// System headers
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Qserv headers
+#include "proto/worker.pb.h"
+#include "wbase/SendChannel.h"
+#include "wbase/Task.h"
+#include "wsched/FairShareAdmission.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE FairShareAdmission
+#include "boost/test/included/unit_test.hpp"
+
+namespace test = boost::test_tools;
+
+using lsst::qserv::proto::TaskMsg;
+using lsst::qserv::wbase::SendChannel;
+using lsst::qserv::wbase::Task;
+using lsst::qserv::wsched::FairShareAdmission;
+
+namespace {
+
+Task::Ptr makeTask(unsigned int czarId, std::string const& user, int jobId) {
+    auto tm = std::make_shared<TaskMsg>();
+    tm->set_session(123456);
+    tm->set_queryid(1);
+    tm->set_jobid(jobId);
+    tm->set_chunkid(jobId);
+    tm->set_db("elephant");
+    tm->set_scaninteractive(false);
+    tm->set_attemptcount(0);
+    tm->set_czarid(czarId);
+    tm->set_user(user);
+    return Task::Ptr(new Task(tm, std::shared_ptr<SendChannel>()));
+}
+
+struct Fixture {
+    FairShareAdmission::Ptr make(FairShareAdmission::Config const& config) {
+        return std::make_shared<FairShareAdmission>(config,
+            [this](Task::Ptr const& task) { admitted.push_back(task); });
+    }
+
+    FairShareAdmission::Stats statsOf(FairShareAdmission const& admission, std::string const& name) {
+        for (auto const& stats : admission.getStats()) {
+            if (stats.principal == name) return stats;
+        }
+        return FairShareAdmission::Stats();
+    }
+
+    std::vector<Task::Ptr> admitted;
+};
+
+} // anonymous namespace
+
+BOOST_FIXTURE_TEST_SUITE(Suite, Fixture)
+
+BOOST_AUTO_TEST_CASE(Weights) {
+    auto weights = FairShareAdmission::parseWeights("qsmaster=4,2:alice=0.5,");
+    BOOST_CHECK_EQUAL(weights.size(), 2U);
+    BOOST_CHECK_EQUAL(weights["qsmaster"], 4.0);
+    BOOST_CHECK_EQUAL(weights["2:alice"], 0.5);
+    BOOST_CHECK(FairShareAdmission::parseWeights("").empty());
+    BOOST_CHECK_THROW(FairShareAdmission::parseWeights("alice"), std::invalid_argument);
+    BOOST_CHECK_THROW(FairShareAdmission::parseWeights("alice=x"), std::invalid_argument);
+    BOOST_CHECK_THROW(FairShareAdmission::parseWeights("alice=0"), std::invalid_argument);
+    BOOST_CHECK_THROW(FairShareAdmission::parseWeights("=2"), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(Caps) {
+    FairShareAdmission::Config config;
+    config.slots = 3;
+    config.maxInFlight = 2;
+    config.maxQueued = 2;
+    config.weights = FairShareAdmission::parseWeights("2:alice=2");
+    auto admission = make(config);
+
+    auto a1 = makeTask(1, "alice", 1);
+    BOOST_CHECK(admission->add(a1));
+    BOOST_CHECK(admission->add(makeTask(1, "alice", 2)));
+    BOOST_CHECK_EQUAL(admitted.size(), 2U);
+    // alice is at her cap, her next tasks wait until the queue is full.
+    BOOST_CHECK(admission->add(makeTask(1, "alice", 3)));
+    BOOST_CHECK(admission->add(makeTask(1, "alice", 4)));
+    BOOST_CHECK(!admission->add(makeTask(1, "alice", 5)));
+    BOOST_CHECK_EQUAL(admitted.size(), 2U);
+    // The same user of another czar is another principal.
+    BOOST_CHECK(admission->add(makeTask(2, "alice", 6)));
+    BOOST_CHECK_EQUAL(admitted.size(), 3U);
+    BOOST_CHECK(admission->add(makeTask(2, "alice", 7)));
+    BOOST_CHECK_EQUAL(admitted.size(), 3U);
+
+    auto stats = statsOf(*admission, "1:alice");
+    BOOST_CHECK_EQUAL(stats.inFlight, 2U);
+    BOOST_CHECK_EQUAL(stats.queued, 2U);
+    BOOST_CHECK_EQUAL(stats.admitted, 2U);
+    BOOST_CHECK_EQUAL(stats.rejected, 1U);
+
+    // A free slot goes to 2:alice, who has fewer tasks in flight for her weight.
+    admission->finished(a1);
+    BOOST_CHECK_EQUAL(admitted.size(), 4U);
+    BOOST_CHECK_EQUAL(admitted.back()->getCzarId(), 2U);
+    BOOST_CHECK_EQUAL(statsOf(*admission, "1:alice").inFlight, 1U);
+}
+
+BOOST_AUTO_TEST_CASE(Share) {
+    FairShareAdmission::Config config;
+    config.slots = 2;
+    config.weights = FairShareAdmission::parseWeights("bob=3");
+    auto admission = make(config);
+
+    for (int j = 0; j < 10; ++j) {
+        admission->add(makeTask(1, "alice", j));
+        admission->add(makeTask(1, "bob", 100 + j));
+    }
+    BOOST_CHECK_EQUAL(admitted.size(), 2U);
+    // Finish tasks as they are admitted and count who got the slots.
+    int bob = 0;
+    for (size_t j = 2; j < 14; ++j) {
+        admission->finished(admitted[j - 2]);
+        BOOST_REQUIRE_EQUAL(admitted.size(), j + 1);
+        if (admitted[j]->user == "bob") ++bob;
+    }
+    BOOST_CHECK_EQUAL(statsOf(*admission, "1:bob").weight, 3.0);
+    BOOST_CHECK_EQUAL(statsOf(*admission, "1:alice").weight, 1.0);
+    BOOST_CHECK_GE(bob, 6);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
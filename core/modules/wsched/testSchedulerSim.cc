@@ -0,0 +1,164 @@
+// -*- LSST-C++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2018 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/**
+  * @brief Test the scheduler simulation on small loads.
+  */
+
+// System headers
+#include <sstream>
+#include <stdexcept>
+
+// Qserv headers
+#include "wsched/SchedulerSim.h"
+
+// Boost unit test header
+#define BOOST_TEST_MODULE SchedulerSim
+#include "boost/test/included/unit_test.hpp"
+
+namespace wsched = lsst::qserv::wsched;
+
+using Sim = wsched::SchedulerSim;
+
+namespace {
+
+Sim::SchedulerReport const* findSched(Sim::Report const& report, std::string const& name) {
+    for (auto const& sched : report.schedulers) {
+        if (sched.name == name) return &sched;
+    }
+    return nullptr;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(Suite)
+
+BOOST_AUTO_TEST_CASE(Synthetic) {
+    Sim::Synthetic synth;
+    synth.chunks = 20;
+    synth.scanQueries = 6;
+    synth.scanInterval = 10;
+    synth.interactiveQueries = 30;
+    auto specs = Sim::makeSynthetic(synth);
+    BOOST_CHECK_EQUAL(specs.size(), 6U*20 + 30);
+
+    Sim::Config config;
+    Sim sim(config);
+    sim.add(specs);
+    auto report = sim.run();
+    BOOST_CHECK_EQUAL(report.tasks, specs.size());
+    BOOST_CHECK_EQUAL(report.unfinished, 0U);
+    BOOST_CHECK(report.seconds > 0);
+
+    // Ratings 10, 20 and 30 go to their scan schedulers.
+    for (auto name : {"SchedFast", "SchedMed", "SchedSlow"}) {
+        auto sched = findSched(report, name);
+        BOOST_REQUIRE(sched != nullptr);
+        BOOST_CHECK_EQUAL(sched->tasks, 2U*20);
+        BOOST_CHECK_EQUAL(sched->totals.size(), sched->tasks);
+    }
+    auto group = findSched(report, "SchedGroup");
+    BOOST_REQUIRE(group != nullptr);
+    BOOST_CHECK_EQUAL(group->tasks, 30U);
+
+    // The same input gives the same result.
+    Sim again(config);
+    again.add(specs);
+    auto report2 = again.run();
+    BOOST_CHECK_EQUAL(report2.seconds, report.seconds);
+    BOOST_CHECK_EQUAL(report2.tablesRead, report.tablesRead);
+
+    std::ostringstream os;
+    report.write(os);
+    BOOST_CHECK(os.str().find("\"SchedFast\": {\"tasks\": 40") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(SharedScan) {
+    // Two scans of the same table arriving together read each chunk once.
+    Sim::Config config;
+    config.memoryBytes = 4 * config.tableBytes;
+    Sim sim(config);
+    for (lsst::qserv::QueryId qId = 1; qId <= 2; ++qId) {
+        for (int chunkId = 1; chunkId <= 10; ++chunkId) {
+            Sim::TaskSpec spec;
+            spec.queryId = qId;
+            spec.chunkId = chunkId;
+            spec.scanRating = 10;
+            spec.table = "Object";
+            sim.add(spec);
+        }
+    }
+    auto report = sim.run();
+    BOOST_CHECK_EQUAL(report.tasks, 20U);
+    BOOST_CHECK_EQUAL(report.tablesRead, 10U);
+    auto fast = findSched(report, "SchedFast");
+    BOOST_REQUIRE(fast != nullptr);
+    // The tasks of both queries on a chunk run together.
+    BOOST_CHECK_EQUAL(fast->chunkSwitches, 10U);
+}
+
+BOOST_AUTO_TEST_CASE(Replay) {
+    std::istringstream is("# arrival,queryId,chunkId,scanRating,interactive,table,seconds,resultBytes\n"
+                          "0,1,5,20,0,Source,2.5,1000\n"
+                          "\n"
+                          "1.5,2,6,0,1,,0.1,10,alice\n");
+    auto specs = Sim::read(is);
+    BOOST_REQUIRE_EQUAL(specs.size(), 2U);
+    BOOST_CHECK_EQUAL(specs[0].chunkId, 5);
+    BOOST_CHECK_EQUAL(specs[0].table, "Source");
+    BOOST_CHECK_CLOSE(specs[0].seconds, 2.5, 1e-9);
+    BOOST_CHECK(specs[1].interactive);
+    BOOST_CHECK(specs[1].table.empty());
+    BOOST_CHECK_EQUAL(specs[1].user, "alice");
+
+    Sim sim(Sim::Config{});
+    sim.add(specs);
+    auto report = sim.run();
+    BOOST_CHECK_EQUAL(report.tasks, 2U);
+    // Reading the Source table takes 0.4s, then 2.5s of run and 10us of result.
+    BOOST_CHECK_CLOSE(report.seconds, 2.90001, 1e-3);
+
+    std::istringstream bad("0,1,5\n");
+    BOOST_CHECK_THROW(Sim::read(bad), std::invalid_argument);
+    std::istringstream badNum("x,1,5,20,0,Source,2.5,1000\n");
+    BOOST_CHECK_THROW(Sim::read(badNum), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(Admission) {
+    Sim::Config config;
+    config.fairShare.slots = 2;
+    config.fairShare.maxQueued = 3;
+    Sim sim(config);
+    for (int chunkId = 1; chunkId <= 6; ++chunkId) {
+        Sim::TaskSpec spec;
+        spec.queryId = 1;
+        spec.chunkId = chunkId;
+        spec.interactive = true;
+        sim.add(spec);
+    }
+    auto report = sim.run();
+    // 2 are admitted, 3 wait and 1 is refused.
+    BOOST_CHECK_EQUAL(report.tasks, 5U);
+    BOOST_CHECK_EQUAL(report.unfinished, 1U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -32,12 +32,14 @@
 #include "lsst/log/Log.h"
 
 // Qserv headers
+#include "global/constants.h"
 #include "memman/MemManNone.h"
 #include "proto/ScanTableInfo.h"
 #include "proto/worker.pb.h"
 #include "util/EventThread.h"
 #include "wbase/Task.h"
 #include "wpublish/QueriesAndChunks.h"
+#include "wsched/ChunkDevicesQueue.h"
 #include "wsched/ChunkDisk.h"
 #include "wsched/ChunkTasksQueue.h"
 #include "wsched/BlendScheduler.h"
@@ -213,6 +215,83 @@ BOOST_AUTO_TEST_CASE(Grouping) {
 }
 
 
+BOOST_AUTO_TEST_CASE(GroupDeadlineTest) {
+    // Tasks with the earliest deadline go first, then the others in order.
+    wsched::GroupScheduler gs{"GroupSchedD", 100, 0, 3, 0};
+    auto makeDeadlineTask = [this](int chunkId, lsst::qserv::QueryId qId, uint32_t deadlineMs) {
+        auto taskMsg = newTaskMsg(chunkId, qId, 0);
+        if (deadlineMs > 0) taskMsg->set_deadlinems(deadlineMs);
+        return makeTask(taskMsg);
+    };
+    Task::Ptr t1 = makeDeadlineTask(5, 1, 0);
+    Task::Ptr t2 = makeDeadlineTask(6, 2, 60000);
+    Task::Ptr t3 = makeDeadlineTask(7, 3, 30000);
+    Task::Ptr t4 = makeDeadlineTask(8, 4, 0);
+    BOOST_CHECK(t1->hasDeadline() == false);
+    BOOST_CHECK(t2->hasDeadline() == true);
+    for (auto const& task : {t1, t2, t3, t4}) {
+        gs.queCmd(task);
+    }
+    BOOST_CHECK(gs.readyForDeadline() == false);
+    BOOST_CHECK(gs.getCmd(false).get() == t3.get());
+    BOOST_CHECK(gs.getCmd(false).get() == t2.get());
+    BOOST_CHECK(gs.getCmd(false).get() == t1.get());
+    BOOST_CHECK(gs.getCmd(false).get() == t4.get());
+
+    // A Task past half of its time may run when other schedulers reserve
+    // every thread.
+    Task::Ptr t5 = makeDeadlineTask(9, 5, 1);
+    gs.queCmd(t5);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    BOOST_CHECK(t5->deadlineAtRisk(std::chrono::system_clock::now()) == true);
+    gs.applyAvailableThreads(-gs.getInFlight());
+    BOOST_CHECK(gs.ready() == false);
+    BOOST_CHECK(gs.readyForDeadline() == true);
+    BOOST_CHECK(gs.getDeadlineCmd().get() == t5.get());
+    BOOST_CHECK(gs.getDeadlineCmd() == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(GroupPreemptTest) {
+    // One scan Task is preempted for each Task waiting longer than the target.
+    wsched::GroupScheduler gs{"GroupSchedP", 100, 0, 1, 0};
+    std::chrono::milliseconds const after{500};
+    BOOST_CHECK(gs.preemptFor(after) == false);
+    auto const now = std::chrono::system_clock::now();
+    Task::Ptr t1 = makeTask(newTaskMsg(5, 1, 0));
+    Task::Ptr t2 = makeTask(newTaskMsg(6, 2, 0));
+    Task::Ptr t3 = makeTask(newTaskMsg(7, 3, 0));
+    t1->queued(now - std::chrono::seconds(1));
+    t2->queued(now - std::chrono::seconds(1));
+    t3->queued(now);
+    for (auto const& task : {t1, t2, t3}) {
+        gs.queCmd(task);
+    }
+    BOOST_CHECK(gs.preemptFor(after) == true);
+    BOOST_CHECK(gs.preemptFor(after) == true);
+    BOOST_CHECK(gs.preemptFor(after) == false);
+    BOOST_CHECK_EQUAL(gs.getPreempts(), 2U);
+
+    // The preempted Tasks resume once the late Tasks started.
+    BOOST_CHECK(gs.getCmd(false).get() == t1.get());
+    BOOST_CHECK(gs.getCmd(false).get() == t2.get());
+    auto const start = std::chrono::steady_clock::now();
+    gs.waitForLate(after, std::chrono::seconds(10));
+    BOOST_CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+
+    // No Task is preempted for a Task that could not run in the thread.
+    wsched::GroupScheduler gs1{"GroupSchedQ", 1, 0, 1, 0};
+    Task::Ptr a1 = makeTask(newTaskMsg(5, 4, 0));
+    Task::Ptr a2 = makeTask(newTaskMsg(6, 5, 0));
+    a1->queued(now - std::chrono::seconds(1));
+    a2->queued(now - std::chrono::seconds(1));
+    gs1.queCmd(a1);
+    gs1.queCmd(a2);
+    BOOST_CHECK(gs1.getCmd(false).get() == a1.get());
+    BOOST_CHECK(gs1.preemptFor(after) == false);
+    gs1.commandFinish(a1);
+    BOOST_CHECK(gs1.preemptFor(after) == true);
+}
+
 BOOST_AUTO_TEST_CASE(GroupMaxThread) {
     // Test that maxThreads is meaningful.
     wsched::GroupScheduler gs{"GroupSchedB", 3, 0, 100, 0};
@@ -243,6 +322,73 @@ BOOST_AUTO_TEST_CASE(GroupMaxThread) {
     BOOST_CHECK(gs.ready() == false);
 }
 
+BOOST_AUTO_TEST_CASE(TaskSharedTest) {
+    // The tasks of a user query keep its query templates and scan tables once.
+    auto newMsg = [this](int chunkId, int jobId, std::string const& table) {
+        auto tm = newTaskMsgScan(chunkId, lsst::qserv::proto::ScanInfo::Rating::FAST, 7, jobId, table);
+        tm->clear_fragment();
+        tm->add_fragment()->set_resulttable("r_7");
+        tm->add_querytemplate(std::string("SELECT * FROM elephant.whatever_") + lsst::qserv::CHUNK_TAG);
+        return tm;
+    };
+    Task::Ptr a = makeTask(newMsg(100, 0, "whatever"));
+    Task::Ptr b = makeTask(newMsg(101, 1, "whatever"));
+    Task::Ptr c = makeTask(newMsg(102, 2, "other"));
+    BOOST_CHECK(&a->getScanInfo() == &b->getScanInfo());
+    BOOST_CHECK(&a->getScanInfo() != &c->getScanInfo());
+    BOOST_CHECK_EQUAL(c->getScanInfo().infoTables.at(0).table, "other");
+    BOOST_CHECK_EQUAL(a->msg->querytemplate_size(), 0);
+    BOOST_CHECK_EQUAL(a->msg->scantable_size(), 0);
+    BOOST_CHECK_EQUAL(a->msg->fragment(0).query_size(), 0);
+
+    b->expandMsg();
+    b->expandMsg();
+    BOOST_REQUIRE_EQUAL(b->msg->fragment(0).query_size(), 1);
+    BOOST_CHECK_EQUAL(b->msg->fragment(0).query(0), "SELECT * FROM elephant.whatever_101");
+    BOOST_REQUIRE_EQUAL(b->msg->scantable_size(), 1);
+    BOOST_CHECK_EQUAL(b->msg->scantable(0).table(), "whatever");
+    BOOST_CHECK_EQUAL(a->msg->fragment(0).query_size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(MemTablesTest) {
+    // Scans lock the data files, index lookups the index files.
+    using LockType = lsst::qserv::memman::TableInfo::LockType;
+    using Access = lsst::qserv::proto::ScanInfo::Access;
+    Task::Ptr scan = makeTask(newTaskMsgScan(30, 0, 8, 0));
+    auto tbls = scan->getMemTables(false);
+    BOOST_REQUIRE_EQUAL(tbls.size(), 1U);
+    BOOST_CHECK_EQUAL(tbls[0].tableName, "elephant/whatever");
+    BOOST_CHECK(tbls[0].theData == LockType::REQUIRED);
+    BOOST_CHECK(tbls[0].theIndex == LockType::NOLOCK);
+
+    // An interactive lookup has no scan tables, only index tables.
+    auto tm = newTaskMsg(31, 9, 0);
+    tm->set_scanaccess(Access::INDEX);
+    auto iTbl = tm->add_indextable();
+    iTbl->set_db("elephant");
+    iTbl->set_table("Object");
+    iTbl->set_scanrating(0);
+    iTbl->set_lockinmemory(true);
+    Task::Ptr lookup = makeTask(tm);
+    tbls = lookup->getMemTables(true);
+    BOOST_REQUIRE_EQUAL(tbls.size(), 1U);
+    BOOST_CHECK_EQUAL(tbls[0].tableName, "elephant/Object");
+    BOOST_CHECK(tbls[0].theData == LockType::NOLOCK);
+    BOOST_CHECK(tbls[0].theIndex == LockType::FLEXIBLE);
+    BOOST_CHECK_EQUAL(lookup->msg->indextable_size(), 0);
+    lookup->expandMsg();
+    BOOST_CHECK_EQUAL(lookup->msg->indextable_size(), 1);
+
+    // A near-neighbor scan locks both.
+    tm = newTaskMsgScan(32, 0, 10, 0);
+    tm->set_scanaccess(Access::MIXED);
+    *tm->add_indextable() = tm->scantable(0);
+    tbls = makeTask(tm)->getMemTables(false);
+    BOOST_REQUIRE_EQUAL(tbls.size(), 1U);
+    BOOST_CHECK(tbls[0].theData == LockType::REQUIRED);
+    BOOST_CHECK(tbls[0].theIndex == LockType::REQUIRED);
+}
+
 BOOST_AUTO_TEST_CASE(DiskMinHeap) {
     wsched::ChunkDisk::MinHeap minHeap{};
     lsst::qserv::QueryId qIdInc = 1;
@@ -411,6 +557,68 @@ BOOST_AUTO_TEST_CASE(ScanScheduleTest) {
 }
 
 
+BOOST_AUTO_TEST_CASE(ScanScheduleCancelTest) {
+    auto memMan = std::make_shared<lsst::qserv::memman::MemManNone>(1, false);
+    wsched::ScanScheduler sched{"ScanSchedC", 1, 1, 0, 20, memMan, 0, 100, oneHr};
+    lsst::qserv::QueryId qIdA = 1;
+    lsst::qserv::QueryId qIdB = 2;
+
+    std::vector<Task::Ptr> tasksA;
+    for (int chunkId=50; chunkId < 54; ++chunkId) {
+        tasksA.push_back(makeTask(newTaskMsgScan(chunkId, 0, qIdA, chunkId)));
+        sched.queCmd(tasksA.back());
+    }
+    Task::Ptr b51 = makeTask(newTaskMsgScan(51, 0, qIdB, 0));
+    sched.queCmd(b51);
+    BOOST_CHECK(sched.getSize() == 5);
+
+    auto running = sched.getCmd(false);
+    BOOST_CHECK(running.get() == tasksA[0].get());
+    BOOST_CHECK(sched.ready() == false); // Only one Task may be in flight.
+
+    BOOST_CHECK(sched.cancelQuery(qIdA) == 3);
+    BOOST_CHECK(sched.getSize() == 4);
+    // Cancelled Tasks do not wait for the running Task to finish.
+    for (int j=1; j < 4; ++j) {
+        BOOST_CHECK(sched.ready() == true);
+        auto cmd = sched.getCmd(false);
+        auto task = std::dynamic_pointer_cast<Task>(cmd);
+        BOOST_REQUIRE(task != nullptr);
+        BOOST_CHECK(task->getQueryId() == qIdA);
+        BOOST_CHECK(task->getCancelled());
+        sched.commandFinish(cmd);
+    }
+    BOOST_CHECK(sched.getSize() == 1);
+    BOOST_CHECK(sched.ready() == false);
+    sched.commandFinish(running);
+    BOOST_CHECK(sched.getCmd(false).get() == b51.get());
+    BOOST_CHECK(!b51->getCancelled());
+    BOOST_CHECK(sched.cancelQuery(qIdA) == 0);
+}
+
+
+BOOST_AUTO_TEST_CASE(GroupCancelTest) {
+    wsched::GroupScheduler gs{"GroupSchedC", 1, 1, 3, 0};
+    lsst::qserv::QueryId qIdA = 1;
+    lsst::qserv::QueryId qIdB = 2;
+    auto a1 = queMsgWithChunkId(gs, 7, qIdA, 1);
+    auto b1 = queMsgWithChunkId(gs, 7, qIdB, 1);
+    auto a2 = queMsgWithChunkId(gs, 8, qIdA, 2);
+    auto running = gs.getCmd(false);
+    BOOST_CHECK(running.get() == a1.get());
+    BOOST_CHECK(gs.ready() == false);
+    BOOST_CHECK(gs.cancelQuery(qIdA) == 1);
+    BOOST_CHECK(gs.ready() == true);
+    BOOST_CHECK(gs.getCmd(false).get() == a2.get());
+    BOOST_CHECK(a2->getCancelled());
+    BOOST_CHECK(gs.ready() == false);
+    gs.commandFinish(a2);
+    gs.commandFinish(running);
+    BOOST_CHECK(gs.getCmd(false).get() == b1.get());
+    BOOST_CHECK(gs.empty());
+}
+
+
 struct SchedFixture {
     SchedFixture() {
         setupQueriesBlend();
@@ -739,6 +947,54 @@ BOOST_AUTO_TEST_CASE(BlendScheduleThreadLimitingTest) {
 }
 
 
+BOOST_AUTO_TEST_CASE(BlendScheduleLendingTest) {
+    SchedFixture f;
+    LOGS(_log, LOG_LVL_DEBUG, "BlendScheduleLendingTest");
+    // Only 6 Tasks can start on a single ScanScheduler, as in BlendScheduleThreadLimitingTest,
+    // but lending the threads reserved by the idle schedulers allows 2 more for a chunk
+    // that is already in memory.
+    f.blend->setMaxLentThreads(2);
+    int const chunkId = 30;
+    for (int j=0; j<9; ++j) {
+        f.blend->queCmd(makeTask(newTaskMsgScan(chunkId, lsst::qserv::proto::ScanInfo::Rating::MEDIUM,
+                                                f.qIdInc++, 0)));
+    }
+    std::vector<Task::Ptr> scanTasks;
+    for (int j=0; j<8; ++j) {
+        BOOST_CHECK(f.blend->ready() == true);
+        auto task = std::dynamic_pointer_cast<lsst::qserv::wbase::Task>(f.blend->getCmd(false));
+        BOOST_CHECK(task != nullptr);
+        scanTasks.push_back(task);
+        BOOST_CHECK(f.blend->getLentThreads() == std::max(0, j - 5));
+    }
+    BOOST_CHECK(f.blend->ready() == false);
+    BOOST_CHECK(f.blend->getCmd(false) == nullptr);
+
+    // A Task for an idle scheduler still starts.
+    f.blend->queCmd(makeTask(newTaskMsg(chunkId, f.qIdInc++, 0)));
+    BOOST_CHECK(f.blend->ready() == true);
+    auto groupTask = std::dynamic_pointer_cast<lsst::qserv::wbase::Task>(f.blend->getCmd(false));
+    BOOST_CHECK(groupTask != nullptr);
+    BOOST_CHECK(groupTask->getOnInteractive());
+
+    // Finishing the borrowed Tasks returns their threads.
+    f.blend->commandFinish(scanTasks[7]);
+    f.blend->commandFinish(scanTasks[6]);
+    BOOST_CHECK(f.blend->getLentThreads() == 0);
+    f.blend->commandFinish(groupTask);
+    BOOST_CHECK(f.blend->ready() == true);
+    scanTasks.push_back(std::dynamic_pointer_cast<lsst::qserv::wbase::Task>(f.blend->getCmd(false)));
+    BOOST_CHECK(scanTasks.back() != nullptr);
+    BOOST_CHECK(f.blend->getLentThreads() == 1);
+
+    for (int j=0; j<6; ++j) f.blend->commandFinish(scanTasks[j]);
+    f.blend->commandFinish(scanTasks[8]);
+    BOOST_CHECK(f.blend->getInFlight() == 0);
+    BOOST_CHECK(f.blend->getLentThreads() == 0);
+    BOOST_CHECK(f.blend->ready() == false);
+}
+
+
 BOOST_AUTO_TEST_CASE(BlendScheduleQueryRemovalTest) {
     // Test that space is appropriately reserved for each scheduler as Tasks are started and finished.
     // In this case, memMan->lock(..) always returns true (really HandleType::ISEMPTY).
@@ -907,6 +1163,26 @@ BOOST_AUTO_TEST_CASE(SlowTableHeapTest) {
 }
 
 
+BOOST_AUTO_TEST_CASE(SlowTableHeapPredictedTest) {
+    // Tasks on the same tables come off longest predicted first, unknown last.
+    wsched::ChunkTasks::SlowTableHeap heap{};
+    lsst::qserv::QueryId qIdInc = 1;
+    std::vector<double> minutes{2.0, -1.0, 10.0, 0.5};
+    std::vector<Task::Ptr> tasks;
+    for (double m : minutes) {
+        Task::Ptr t = makeTask(newTaskMsgScan(7, 3, qIdInc++, 0, "charlie"));
+        t->setPredictedMinutes(m);
+        heap.push(t);
+        tasks.push_back(t);
+    }
+    BOOST_CHECK(heap.pop().get() == tasks[2].get());
+    BOOST_CHECK(heap.pop().get() == tasks[0].get());
+    BOOST_CHECK(heap.pop().get() == tasks[3].get());
+    BOOST_CHECK(heap.pop().get() == tasks[1].get());
+    BOOST_CHECK(heap.empty() == true);
+}
+
+
 BOOST_AUTO_TEST_CASE(ChunkTasksTest) {
     // MemManNone always returns that memory is available.
     auto memMan = std::make_shared<lsst::qserv::memman::MemManNone>(1, true);
@@ -977,6 +1253,59 @@ BOOST_AUTO_TEST_CASE(ChunkTasksTest) {
 }
 
 
+BOOST_AUTO_TEST_CASE(ChunkTasksLateJoinTest) {
+    // MemManNone always returns that memory is available.
+    auto memMan = std::make_shared<lsst::qserv::memman::MemManNone>(1, true);
+    int chunkId = 7;
+    wsched::ChunkTasks chunkTasks{chunkId, memMan};
+    lsst::qserv::QueryId qIdInc = 1;
+
+    Task::Ptr a1 = makeTask(newTaskMsgScan(chunkId, 3, qIdInc++, 0, "alpha"));
+    Task::Ptr a2 = makeTask(newTaskMsgScan(chunkId, 3, qIdInc++, 0, "bravo"));
+    chunkTasks.queTask(a1);
+    chunkTasks.queTask(a2);
+    chunkTasks.setActive();
+
+    // Nothing is in flight, new Tasks wait for the next pass.
+    Task::Ptr p1 = makeTask(newTaskMsgScan(chunkId, 3, qIdInc++, 0, "alpha"));
+    chunkTasks.queTask(p1);
+    auto t1 = chunkTasks.getTask(true);
+    auto t2 = chunkTasks.getTask(true);
+    BOOST_CHECK(t1 != nullptr);
+    BOOST_CHECK(t2 != nullptr);
+    BOOST_CHECK(chunkTasks.getTask(true) == nullptr);
+
+    // Tasks on the tables in flight join, up to the number of Tasks of the pass.
+    Task::Ptr j1 = makeTask(newTaskMsgScan(chunkId, 3, qIdInc++, 0, "alpha"));
+    chunkTasks.queTask(j1);
+    BOOST_CHECK(chunkTasks.getTask(true).get() == j1.get());
+    Task::Ptr p2 = makeTask(newTaskMsgScan(chunkId, 3, qIdInc++, 0, "charlie"));
+    chunkTasks.queTask(p2);
+    BOOST_CHECK(chunkTasks.getTask(true) == nullptr);
+    Task::Ptr j2 = makeTask(newTaskMsgScan(chunkId, 3, qIdInc++, 0, "bravo"));
+    chunkTasks.queTask(j2);
+    BOOST_CHECK(chunkTasks.getTask(true).get() == j2.get());
+    Task::Ptr p3 = makeTask(newTaskMsgScan(chunkId, 3, qIdInc++, 0, "alpha"));
+    chunkTasks.queTask(p3);
+    BOOST_CHECK(chunkTasks.getTask(true) == nullptr);
+    BOOST_CHECK(chunkTasks.size() == 3);
+
+    chunkTasks.taskComplete(t1);
+    chunkTasks.taskComplete(t2);
+    chunkTasks.taskComplete(j1);
+    BOOST_CHECK(chunkTasks.readyToAdvance() == false);
+    chunkTasks.taskComplete(j2);
+    BOOST_CHECK(chunkTasks.readyToAdvance() == true);
+
+    // The pending Tasks run in the next pass.
+    chunkTasks.setActive(false);
+    BOOST_CHECK(chunkTasks.getTask(true) != nullptr);
+    BOOST_CHECK(chunkTasks.getTask(true) != nullptr);
+    BOOST_CHECK(chunkTasks.getTask(true) != nullptr);
+    BOOST_CHECK(chunkTasks.empty() == true);
+}
+
+
 BOOST_AUTO_TEST_CASE(ChunkTasksQueueTest) {
     // MemManNone always returns that memory is available.
     auto memMan = std::make_shared<lsst::qserv::memman::MemManNone>(1, true);
@@ -1103,4 +1432,63 @@ BOOST_AUTO_TEST_CASE(ChunkTasksQueueTest) {
     BOOST_CHECK(ctl.getActiveChunkId() == -1);
 }
 
+BOOST_AUTO_TEST_CASE(ChunkDevicesQueueTest) {
+    // Even chunks are on a spinning disk, odd chunks on a solid state device.
+    auto memMan = std::make_shared<lsst::qserv::memman::MemManNone>(1, true);
+    auto lookup = [](Task::Ptr const& task) {
+        wsched::ChunkDevicesQueue::DeviceInfo info;
+        info.id = (task->getChunkId() % 2 == 0) ? 1 : 2;
+        info.rotational = (info.id == 1);
+        return info;
+    };
+    wsched::ChunkDevicesQueue cdq{nullptr, memMan, lookup};
+    lsst::qserv::QueryId qIdInc = 1;
+
+    BOOST_CHECK(cdq.empty() == true);
+    BOOST_CHECK(cdq.ready(true) == false);
+
+    Task::Ptr a1 = makeTask(newTaskMsgScan(10, 4, qIdInc++, 0, "charlie"));
+    Task::Ptr a2 = makeTask(newTaskMsgScan(10, 3, qIdInc++, 0, "delta"));
+    Task::Ptr b1 = makeTask(newTaskMsgScan(12, 3, qIdInc++, 0, "charlie"));
+    Task::Ptr c1 = makeTask(newTaskMsgScan(11, 3, qIdInc++, 0, "charlie"));
+    Task::Ptr d1 = makeTask(newTaskMsgScan(13, 3, qIdInc++, 0, "charlie"));
+    for (auto const& task : {a1, a2, b1, c1, d1}) {
+        cdq.queueTask(task);
+    }
+    BOOST_CHECK(cdq.empty() == false);
+    BOOST_CHECK_EQUAL(cdq.getSize(), 5U);
+
+    // The device with the most queued Tasks goes first, then the idle one.
+    BOOST_CHECK(cdq.getTask(true).get() == a1.get());
+    BOOST_CHECK(cdq.getTask(true).get() == c1.get());
+    BOOST_CHECK(cdq.getTask(true).get() == a2.get());
+    // Chunk 12 would be a second chunk on the spinning disk.
+    BOOST_CHECK(cdq.getTask(true).get() == d1.get());
+    BOOST_CHECK(cdq.getTask(true) == nullptr);
+    BOOST_CHECK(cdq.ready(true) == false);
+
+    auto stats = cdq.getDeviceStats();
+    BOOST_REQUIRE_EQUAL(stats.size(), 2U);
+    BOOST_CHECK(stats[0].info.rotational == true);
+    BOOST_CHECK_EQUAL(stats[0].chunksInFlight, 1);
+    BOOST_CHECK_EQUAL(stats[0].tasksInFlight, 2);
+    BOOST_CHECK_EQUAL(stats[0].queued, 1U);
+    BOOST_CHECK_EQUAL(stats[1].chunksInFlight, 2);
+
+    cdq.taskComplete(a1);
+    BOOST_CHECK(cdq.getTask(true) == nullptr);
+    cdq.taskComplete(a2);
+    BOOST_CHECK(cdq.getTask(true).get() == b1.get());
+    BOOST_CHECK_EQUAL(cdq.getSize(), 0U);
+    for (auto const& task : {b1, c1, d1}) {
+        cdq.taskComplete(task);
+    }
+    BOOST_CHECK(cdq.ready(true) == false);
+    BOOST_CHECK_EQUAL(cdq.getSize(), 0U);
+
+    // Files that cannot be found have no device.
+    BOOST_CHECK_EQUAL(wsched::ChunkDevicesQueue::deviceOfFile("").id, -1);
+    BOOST_CHECK_EQUAL(wsched::ChunkDevicesQueue::deviceOfFile("/nonexistent/file").id, -1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
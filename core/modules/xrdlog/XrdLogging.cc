@@ -35,6 +35,7 @@
 #include "lsst/log/Log.h"
 
 // Qserv headers
+#include "util/RingAppender.h"
 
 /******************************************************************************/
 /*                L o g g i n g   I n t e r c e p t   H o o k                 */
@@ -64,7 +65,8 @@ XrdSsiLogger::MCB_t& ConfigLog() {
     // Set the originator of the messages
     origin = (getenv("XRDPROG") ? getenv("XRDPROG") : "<SSI>");
 
-    // Configure the logging system
+    // Configure the logging system, the configuration may name RingAppender
+    lsst::qserv::util::RingAppender::registerClass();
     LOG_CONFIG();
 
     // Return the address the logger to be used
@@ -24,6 +24,10 @@
 // Class header
 #include "xrdsvc/ChannelStream.h"
 
+// System headers
+#include <string>
+#include <vector>
+
 // Third-party headers
 #include "boost/utility.hpp"
 
@@ -45,6 +49,9 @@ namespace qserv {
 namespace xrdsvc {
 
 
+std::atomic<std::size_t> ChannelStream::_coalesceLimit(64*1024);
+
+
 /// Constructor
 ChannelStream::ChannelStream()
     : XrdSsiStream(isActive),
@@ -94,12 +101,53 @@ XrdSsiStream::Buffer* ChannelStream::GetBuff(XrdSsiErrInfo &eInfo, int &dlen, bo
         return 0;
     }
 
-    StreamBuffer::Ptr sb = _msgs.front();
+    StreamBuffer::Ptr sb = _coalesce();
     dlen = sb->getSize();
-    _msgs.pop_front();
     last = _closed && _msgs.empty();
     LOGS(_log, LOG_LVL_DEBUG, "returning buffer (" << dlen << ", " << (last ? "(last)" : "(more)") << ")");
     return sb.get();
 }
 
+
+/// @return the front of _msgs, removed from the queue. If it and the buffers
+/// after it fit within _coalesceLimit, they are copied into one new buffer
+/// instead. The originals are recycled when XrdSsi recycles the copy, so
+/// anything waiting on them still waits until the data has been sent.
+/// _mutex must be held.
+StreamBuffer::Ptr ChannelStream::_coalesce() {
+    StreamBuffer::Ptr front = _msgs.front();
+    _msgs.pop_front();
+    size_t const limit = _coalesceLimit;
+    size_t total = front->getSize();
+    size_t count = 0;
+    while (count < _msgs.size() && total + _msgs[count]->getSize() <= limit) {
+        total += _msgs[count]->getSize();
+        ++count;
+    }
+    if (count == 0) {
+        return front;
+    }
+
+    std::vector<StreamBuffer::Ptr> parts;
+    parts.reserve(count + 1);
+    parts.push_back(front);
+    for (size_t j = 0; j < count; ++j) {
+        parts.push_back(_msgs.front());
+        _msgs.pop_front();
+    }
+    std::string data;
+    data.reserve(total);
+    for (auto const& part : parts) {
+        data.append(part->data, part->getSize());
+    }
+    auto combined = StreamBuffer::createWithMove(data);
+    combined->setRecycleFunc([parts]() {
+        for (auto const& part : parts) {
+            part->Recycle();
+        }
+    });
+    LOGS(_log, LOG_LVL_DEBUG, "coalesced " << parts.size() << " buffers into " << total << " bytes");
+    return combined;
+}
+
 }}} // lsst::qserv::xrdsvc
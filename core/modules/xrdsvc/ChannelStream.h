@@ -24,6 +24,7 @@
 #define LSST_QSERV_XRDSVC_CHANNELSTREAM_H
 
 // System headers
+#include <atomic>
 #include <condition_variable>
 #include <deque>
 #include <mutex>
@@ -56,12 +57,21 @@ public:
 
     bool closed() const { return _closed; }
 
+    /// Small queued buffers are returned by GetBuff() as one buffer of up to
+    /// 'bytes' bytes, saving XrdSsi round trips. 0 disables coalescing.
+    static void setCoalesceLimit(std::size_t bytes) { _coalesceLimit = bytes; }
+    static std::size_t getCoalesceLimit() { return _coalesceLimit; }
+
 private:
+    StreamBuffer::Ptr _coalesce();
+
     bool _closed; ///< Closed to new append() calls?
     // Can keep a deque of (buf, bufsize) to reduce copying, if needed.
     std::deque<StreamBuffer::Ptr> _msgs; ///< Message queue
     std::mutex _mutex; ///< _msgs protection
     std::condition_variable _hasDataCondition; ///< _msgs condition
+
+    static std::atomic<std::size_t> _coalesceLimit;
 };
 
 }}} // namespace lsst::qserv::xrdsvc
@@ -28,6 +28,7 @@
 #include "xrdsvc/SsiProvider.h"
 
 // System headers
+#include <cstring>
 #include <sstream>
 #include <sys/types.h>
 
@@ -153,24 +154,32 @@ bool SsiProviderServer::Init(XrdSsiLogger* logP,  XrdSsiCluster* clsP,
 XrdSsiProvider::rStat SsiProviderServer::QueryResource(char const* rName,
                                                        char const* contact) {
 
-    // Validate resource name based on its proposed type
+    // Validate resource name based on its proposed type. Chunk paths, nearly
+    // all of the queries, are parsed without building a ResourceUnit.
 
-    ResourceUnit ru(rName);
-    if (ru.unitType() == ResourceUnit::DBCHUNK) {
+    ResourceUnit::DbChunkRef ref;
+    if (ResourceUnit::parseDbChunk(rName, std::strlen(rName), ref)) {
 
-        // Extract db and chunk from path and validate result
+        // A path naming a worker is for that replica of the chunk only.
+        if (ref.workerLen > 0 && _chunkInventory.id().compare(0, std::string::npos,
+                                                              ref.worker, ref.workerLen) != 0) {
+            LOGS(_log, LOG_LVL_DEBUG, "SsiProvider Query " << rName << " absent, other worker");
+            return notPresent;
+        }
 
         // If the chunk exists on our node then tell the caller it is here.
-        if (_chunkInventory.has(ru.db(), ru.chunk())) {
+        if (_chunkInventory.has(ref)) {
             LOGS(_log, LOG_LVL_DEBUG, "SsiProvider Query " << rName << " present");
             return isPresent;
         }
-    
+
         // Tell the caller we do not have the chunk.
         LOGS(_log, LOG_LVL_DEBUG, "SsiProvider Query " << rName << " absent");
         return notPresent;
+    }
 
-    } else if (ru.unitType() == ResourceUnit::WORKER) {
+    ResourceUnit ru(rName);
+    if (ru.unitType() == ResourceUnit::WORKER) {
 
         // Extract the worker name and alidate it against the one which is
         // provided through the inventory
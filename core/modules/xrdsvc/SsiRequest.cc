@@ -27,6 +27,7 @@
 #include <cstddef>
 #include <iostream>
 #include <string>
+#include <vector>
 
 // Third-party headers
 #include "XrdSsi/XrdSsiRequest.hh"
@@ -37,16 +38,21 @@
 // Qserv headers
 #include "global/ResourceUnit.h"
 #include "proto/FrameBuffer.h"
+#include "proto/TaskMsgArena.h"
 #include "proto/worker.pb.h"
 #include "util/Timer.h"
 #include "wbase/MsgProcessor.h"
 #include "wbase/SendChannel.h"
 #include "wpublish/AddChunkGroupCommand.h"
+#include "wpublish/CancelQueryCommand.h"
 #include "wpublish/ChunkListCommand.h"
+#include "wpublish/GetAdmissionStatsCommand.h"
 #include "wpublish/GetChunkListCommand.h"
+#include "wpublish/GetChunkStatsCommand.h"
 #include "wpublish/RemoveChunkGroupCommand.h"
 #include "wpublish/ResourceMonitor.h"
 #include "wpublish/SetChunkListCommand.h"
+#include "wpublish/SetConfigCommand.h"
 #include "wpublish/TestEchoCommand.h"
 #include "xrdsvc/ChannelStream.h"
 
@@ -95,17 +101,26 @@ void SsiRequest::execute(XrdSsiRequest& req) {
     std::lock_guard<std::mutex> lock(_finMutex);
     BindRequest(req);
 
-    ResourceUnit ru(_resourceName);
+    // Chunk paths are parsed and checked without allocating, only the other
+    // resources build a ResourceUnit.
+    ResourceUnit::DbChunkRef ref;
+    bool const isDbChunk = ResourceUnit::parseDbChunk(_resourceName, ref);
+    ResourceUnit ru = isDbChunk ? ResourceUnit() : ResourceUnit(_resourceName);
+    ResourceUnit::UnitType const unitType = isDbChunk ? ResourceUnit::DBCHUNK : ru.unitType();
 
     // Make sure the requested resource belongs to this worker
-    if (!(*_validator)(ru)) {
+    if (isDbChunk ? !(*_validator)(ref) : !(*_validator)(ru)) {
         reportError("WARNING: request to the unowned resource detected:" + _resourceName);
         return;
     }
 
     // Process the request
-    switch (ru.unitType()) {
+    switch (unitType) {
         case ResourceUnit::DBCHUNK: {
+            if (!isDbChunk) {
+                reportError("Malformed chunk number in resource: " + _resourceName);
+                return;
+            }
 
             // Increment the counter of the database/chunk resources in use
             _resourceMonitor->increment(_resourceName);
@@ -113,19 +128,16 @@ void SsiRequest::execute(XrdSsiRequest& req) {
             // reqData has the entire request, so we can unpack it without waiting for
             // more data.
             LOGS(_log, LOG_LVL_DEBUG, "Decoding TaskMsg of size " << reqSize);
-            auto taskMsg = std::make_shared<proto::TaskMsg>();
-            if (!taskMsg->ParseFromArray(reqData, reqSize) ||
-                !taskMsg->IsInitialized()) {
-                reportError("Failed to decode TaskMsg on resource db=" + ru.db() +
-                            " chunkId=" + std::to_string(ru.chunk()));
+            auto taskMsg = proto::parseTaskMsg(reqData, reqSize);
+            if (taskMsg == nullptr) {
+                reportError("Failed to decode TaskMsg on resource " + _resourceName);
                 return;
             }
 
             if (!taskMsg->has_db() || !taskMsg->has_chunkid()
-                || (ru.db()    != taskMsg->db())
-                || (ru.chunk() != taskMsg->chunkid())) {
-                reportError("Mismatched db/chunk in TaskMsg on resource db=" + ru.db() +
-                            " chunkId=" + std::to_string(ru.chunk()));
+                || (taskMsg->db().compare(0, std::string::npos, ref.db, ref.dbLen) != 0)
+                || (ref.chunk != taskMsg->chunkid())) {
+                reportError("Mismatched db/chunk in TaskMsg on resource " + _resourceName);
                 return;
             }
 
@@ -138,10 +150,11 @@ void SsiRequest::execute(XrdSsiRequest& req) {
                                 taskMsg,
                                 std::make_shared<wbase::SendChannel>(shared_from_this()));
             ReleaseRequestBuffer();
+            _task = task;
             t.start();
             _processor->processTask(task); // Queues task to be run later.
             t.stop();
-            LOGS(_log, LOG_LVL_DEBUG, "Enqueued TaskMsg for " << ru <<
+            LOGS(_log, LOG_LVL_DEBUG, "Enqueued TaskMsg for " << _resourceName <<
                  " in " << t.getElapsed() << " seconds");
 
             break;
@@ -162,7 +175,7 @@ void SsiRequest::execute(XrdSsiRequest& req) {
             break;
         }
         default:
-            reportError("Unexpected unit type '" + std::to_string(ru.unitType()) +
+            reportError("Unexpected unit type '" + std::to_string(unitType) +
                         "', resource name: " + _resourceName);
             break;
     }
@@ -247,12 +260,14 @@ wbase::WorkerCommand::Ptr SsiRequest::parseWorkerCommand(char const* reqData, in
                                     sendChannel,
                                     _chunkInventory,
                                     _mySqlConfig,
-                                    message.reload());
+                                    message.reload(),
+                                    message.incremental());
                 else
                     command = std::make_shared<wpublish::ReloadChunkListCommand> (
                                     sendChannel,
                                     _chunkInventory,
-                                    _mySqlConfig);
+                                    _mySqlConfig,
+                                    message.incremental());
                 break;
             }
             case proto::WorkerCommandH::GET_CHUNK_LIST: {
@@ -263,6 +278,60 @@ wbase::WorkerCommand::Ptr SsiRequest::parseWorkerCommand(char const* reqData, in
                                     _resourceMonitor);
                 break;
             }
+            case proto::WorkerCommandH::GET_ADMISSION_STATS: {
+
+                command = std::make_shared<wpublish::GetAdmissionStatsCommand> (
+                                    sendChannel,
+                                    _admission);
+                break;
+            }
+            case proto::WorkerCommandH::GET_CHUNK_STATS: {
+
+                LOGS(_log, LOG_LVL_DEBUG, "Decoding WorkerCommandGetChunkStatsM");
+                proto::WorkerCommandGetChunkStatsM message;
+                view.parse(message);
+
+                std::vector<std::string> databases;
+                for (int i = 0, num = message.databases_size(); i < num; ++i) {
+                    databases.push_back(message.databases(i));
+                }
+                command = std::make_shared<wpublish::GetChunkStatsCommand> (
+                                    sendChannel,
+                                    _chunkInventory,
+                                    _mySqlConfig,
+                                    _queries,
+                                    databases,
+                                    message.updated_after());
+                break;
+            }
+            case proto::WorkerCommandH::CANCEL_QUERY: {
+
+                LOGS(_log, LOG_LVL_DEBUG, "Decoding WorkerCommandCancelQueryM");
+                proto::WorkerCommandCancelQueryM message;
+                view.parse(message);
+
+                command = std::make_shared<wpublish::CancelQueryCommand> (
+                                    sendChannel,
+                                    _processor,
+                                    message.queryid());
+                break;
+            }
+            case proto::WorkerCommandH::SET_CONFIG: {
+
+                LOGS(_log, LOG_LVL_DEBUG, "Decoding WorkerCommandSetConfigM");
+                proto::WorkerCommandSetConfigM message;
+                view.parse(message);
+
+                wcontrol::RuntimeConfig::Params params;
+                for (int i = 0, num = message.params_size(); i < num; ++i) {
+                    params[message.params(i).name()] = message.params(i).value();
+                }
+                command = std::make_shared<wpublish::SetConfigCommand> (
+                                    sendChannel,
+                                    _runtimeConfig,
+                                    params);
+                break;
+            }
             case proto::WorkerCommandH::SET_CHUNK_LIST: {
 
                 LOGS(_log, LOG_LVL_DEBUG, "Decoding WorkerCommandSetChunkListM");
@@ -280,13 +349,34 @@ wbase::WorkerCommand::Ptr SsiRequest::parseWorkerCommand(char const* reqData, in
                 }
                 bool const force = message.force();
 
-                command = std::make_shared<wpublish::SetChunkListCommand> (
-                                    sendChannel,
-                                    _chunkInventory,
-                                    _resourceMonitor,
-                                    _mySqlConfig,
-                                    chunks,
-                                    force);
+                if (message.diff()) {
+                    std::vector<wpublish::SetChunkListCommand::Chunk> removedChunks;
+                    for (int i = 0, num = message.removed_size(); i < num; ++i) {
+                        removedChunks.push_back(
+                            wpublish::SetChunkListCommand::Chunk{
+                                message.removed(i).db(),
+                                message.removed(i).chunk()
+                            }
+                        );
+                    }
+                    command = std::make_shared<wpublish::SetChunkListCommand> (
+                                        sendChannel,
+                                        _chunkInventory,
+                                        _resourceMonitor,
+                                        _mySqlConfig,
+                                        chunks,
+                                        removedChunks,
+                                        message.base_revision(),
+                                        force);
+                } else {
+                    command = std::make_shared<wpublish::SetChunkListCommand> (
+                                        sendChannel,
+                                        _chunkInventory,
+                                        _resourceMonitor,
+                                        _mySqlConfig,
+                                        chunks,
+                                        force);
+                }
                 break;
             }
             default:
@@ -329,14 +419,27 @@ void SsiRequest::Finished(XrdSsiRequest& req, XrdSsiRespInfo const& rinfo, bool
     case XrdSsiRespInfo::isHandle: type = "type=isHandle"; break;
     }
 
+    // A cancelled request will not read any more results, so its task should
+    // stop its queries and not wait for memory or transmit slots.
+    if (cancel) {
+        auto task = _task.lock();
+        if (task != nullptr) {
+            LOGS(_log, LOG_LVL_DEBUG, task->getIdStr() << " request cancelled, cancelling task");
+            task->cancel();
+        }
+    }
+
     // Decrement the counter of the database/chunk resources in use
-    ResourceUnit ru(_resourceName);
-    if (ru.unitType() == ResourceUnit::DBCHUNK) {
+    ResourceUnit::DbChunkRef ref;
+    if (ResourceUnit::parseDbChunk(_resourceName, ref)) {
         _resourceMonitor->decrement(_resourceName);
     }
 
-    // We can't do much other than close the file.
-    // It should work (on linux) to unlink the file after we open it, though.
+    // Close the response file, if any, now that XrdSsi no longer reads it.
+    if (_fileRelease) {
+        _fileRelease();
+        _fileRelease = nullptr;
+    }
     LOGS(_log, LOG_LVL_DEBUG, "RequestFinished " << type);
 }
 
@@ -359,11 +462,12 @@ bool SsiRequest::replyError(std::string const& msg, int code) {
 }
 
 
-bool SsiRequest::replyFile(int fd, long long fSize) {
+bool SsiRequest::replyFile(int fd, long long fSize, std::function<void()> const& release) {
     util::Timer t;
     t.start();
     Status s = SetResponse(fSize, fd);
     if (s == XrdSsiResponder::wasPosted) {
+        _fileRelease = release;
         LOGS(_log, LOG_LVL_DEBUG, "file posted ok");
     } else {
         if (s == XrdSsiResponder::notActive) {
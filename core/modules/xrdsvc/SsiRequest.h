@@ -25,6 +25,7 @@
 
 // System headers
 #include <atomic>
+#include <functional>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -37,7 +38,10 @@
 #include "mysql/MySqlConfig.h"
 #include "wbase/Task.h"
 #include "wbase/WorkerCommand.h"
+#include "wcontrol/RuntimeConfig.h"
 #include "wpublish/ChunkInventory.h"
+#include "wpublish/QueriesAndChunks.h"
+#include "wsched/FairShareAdmission.h"
 #include "xrdsvc/StreamBuffer.h"
 
 
@@ -79,12 +83,18 @@ public:
             std::string const&                               rname,
             std::shared_ptr<wpublish::ChunkInventory> const& chunkInventory,
             std::shared_ptr<wbase::MsgProcessor> const&      processor,
-            mysql::MySqlConfig const&                        mySqlConfig) {
+            mysql::MySqlConfig const&                        mySqlConfig,
+            wsched::FairShareAdmission::Ptr const&           admission=nullptr,
+            wcontrol::RuntimeConfig::Ptr const&              runtimeConfig=nullptr,
+            wpublish::QueriesAndChunks::Ptr const&           queries=nullptr) {
 
         return SsiRequest::Ptr(new SsiRequest(rname,
                                               chunkInventory,
                                               processor,
-                                              mySqlConfig));
+                                              mySqlConfig,
+                                              admission,
+                                              runtimeConfig,
+                                              queries));
     }
 
     virtual ~SsiRequest();
@@ -102,7 +112,8 @@ public:
 
     bool reply(char const* buf, int bufLen);
     bool replyError(std::string const& msg, int code);
-    bool replyFile(int fd, long long fSize);
+    /// Send the contents of 'fd', 'release' is called once XrdSsi is done with it.
+    bool replyFile(int fd, long long fSize, std::function<void()> const& release=nullptr);
     bool replyStream(StreamBuffer::Ptr const& sbuf, bool last);
 
 private:
@@ -111,13 +122,19 @@ private:
     SsiRequest(std::string const&                               rname,
                std::shared_ptr<wpublish::ChunkInventory> const& chunkInventory,
                std::shared_ptr<wbase::MsgProcessor> const&      processor,
-               mysql::MySqlConfig const&                        mySqlConfig)
+               mysql::MySqlConfig const&                        mySqlConfig,
+               wsched::FairShareAdmission::Ptr const&           admission,
+               wcontrol::RuntimeConfig::Ptr const&              runtimeConfig,
+               wpublish::QueriesAndChunks::Ptr const&           queries)
         :   _chunkInventory(chunkInventory),
             _validator(_chunkInventory->newValidator()),
             _processor(processor),
             _resourceName(rname),
             _stream(0),
-            _mySqlConfig(mySqlConfig) {
+            _mySqlConfig(mySqlConfig),
+            _admission(admission),
+            _runtimeConfig(runtimeConfig),
+            _queries(queries) {
     }
     
     /// For internal error reporting
@@ -148,7 +165,17 @@ private:
 
     ChannelStream* _stream;
 
+    std::function<void()> _fileRelease; ///< Releases the file sent by replyFile()
+
+    std::weak_ptr<wbase::Task> _task; ///< The task of a chunk request, cancelled with the request
+
     mysql::MySqlConfig const _mySqlConfig;
+
+    wsched::FairShareAdmission::Ptr _admission; ///< null if fair-share admission is disabled
+
+    wcontrol::RuntimeConfig::Ptr _runtimeConfig; ///< null if parameters can't be changed
+
+    wpublish::QueriesAndChunks::Ptr _queries; ///< null if query statistics aren't known
 };
 
 }}} // namespace
@@ -26,8 +26,12 @@
 
 // System headers
 #include <cassert>
+#include <chrono>
 #include <iostream>
+#include <map>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <stdlib.h>
 #include <unistd.h>
 #include <xrdsvc/SsiRequest.h>
@@ -43,15 +47,21 @@
 #include "memman/MemManNone.h"
 #include "mysql/MySqlConnection.h"
 #include "sql/SqlConnection.h"
+#include "util/Metrics.h"
+#include "util/Numa.h"
+#include "util/Profiler.h"
 #include "wbase/Base.h"
 #include "wconfig/WorkerConfig.h"
 #include "wconfig/WorkerConfigError.h"
 #include "wcontrol/Foreman.h"
+#include "wcontrol/MemPressureMonitor.h"
+#include "wcontrol/RuntimeConfig.h"
 #include "wpublish/ChunkInventory.h"
 #include "wsched/BlendScheduler.h"
 #include "wsched/FifoScheduler.h"
 #include "wsched/GroupScheduler.h"
 #include "wsched/ScanScheduler.h"
+#include "xrdsvc/ChannelStream.h"
 #include "xrdsvc/XrdName.h"
 
 
@@ -66,6 +76,71 @@ void initMDC() {
 }
 int dummyInitMDC = LOG_MDC_INIT(initMDC);
 
+using lsst::qserv::util::MetricsRegistry;
+
+/// Write the queues of the schedulers, and of fair-share admission if it is enabled.
+void writeSchedulerMetrics(std::ostream& os, lsst::qserv::wsched::BlendScheduler& blend,
+                           std::vector<lsst::qserv::wsched::SchedulerBase::Ptr> const& schedulers,
+                           lsst::qserv::wsched::FairShareAdmission::Ptr const& admission) {
+    auto label = [](std::string const& name, std::string const& val) {
+        return name + "=\"" + MetricsRegistry::escapeLabel(val) + "\"";
+    };
+    MetricsRegistry::writeHeader(os, "qserv_scheduler_queued_tasks", "gauge", "Tasks waiting in a scheduler");
+    for (auto const& sched : schedulers) {
+        MetricsRegistry::writeValue(os, "qserv_scheduler_queued_tasks", label("scheduler", sched->getName()),
+                                    sched->getSize());
+    }
+    MetricsRegistry::writeHeader(os, "qserv_scheduler_inflight_tasks", "gauge", "Tasks running in a scheduler");
+    for (auto const& sched : schedulers) {
+        MetricsRegistry::writeValue(os, "qserv_scheduler_inflight_tasks", label("scheduler", sched->getName()),
+                                    sched->getInFlight());
+    }
+    MetricsRegistry::writeHeader(os, "qserv_scheduler_active_chunks", "gauge", "Chunks being queried");
+    for (auto const& sched : schedulers) {
+        MetricsRegistry::writeValue(os, "qserv_scheduler_active_chunks", label("scheduler", sched->getName()),
+                                    sched->getActiveChunkCount());
+    }
+    MetricsRegistry::writeHeader(os, "qserv_scheduler_lent_threads", "gauge",
+                                 "Threads lent to the scan schedulers");
+    MetricsRegistry::writeValue(os, "qserv_scheduler_lent_threads", "", blend.getLentThreads());
+    auto const deadline = blend.getDeadlineStats();
+    MetricsRegistry::writeHeader(os, "qserv_scheduler_deadline_tasks_total", "counter",
+                                 "Tasks finished, by whether they met their deadline");
+    MetricsRegistry::writeValue(os, "qserv_scheduler_deadline_tasks_total", label("outcome", "met"),
+                                deadline.met);
+    MetricsRegistry::writeValue(os, "qserv_scheduler_deadline_tasks_total", label("outcome", "missed"),
+                                deadline.missed);
+    MetricsRegistry::writeValue(os, "qserv_scheduler_deadline_tasks_total", label("outcome", "preempted"),
+                                deadline.preempted);
+    MetricsRegistry::writeHeader(os, "qserv_scheduler_scan_preempts_total", "counter",
+                                 "Scan tasks preempted for interactive tasks");
+    MetricsRegistry::writeValue(os, "qserv_scheduler_scan_preempts_total", "", blend.getScanPreempts());
+    if (admission == nullptr) return;
+
+    auto const stats = admission->getStats();
+    MetricsRegistry::writeHeader(os, "qserv_admission_inflight_tasks", "gauge",
+                                 "Admitted tasks of a user in the schedulers");
+    for (auto const& st : stats) {
+        MetricsRegistry::writeValue(os, "qserv_admission_inflight_tasks", label("principal", st.principal),
+                                    st.inFlight);
+    }
+    MetricsRegistry::writeHeader(os, "qserv_admission_queued_tasks", "gauge",
+                                 "Tasks of a user waiting for admission");
+    for (auto const& st : stats) {
+        MetricsRegistry::writeValue(os, "qserv_admission_queued_tasks", label("principal", st.principal),
+                                    st.queued);
+    }
+    MetricsRegistry::writeHeader(os, "qserv_admission_tasks_total", "counter",
+                                 "Tasks of a user admitted or rejected");
+    for (auto const& st : stats) {
+        std::string const principal = label("principal", st.principal);
+        MetricsRegistry::writeValue(os, "qserv_admission_tasks_total", principal + "," + label("outcome", "admitted"),
+                                    st.admitted);
+        MetricsRegistry::writeValue(os, "qserv_admission_tasks_total", principal + "," + label("outcome", "rejected"),
+                                    st.rejected);
+    }
+}
+
 }
 
 namespace lsst {
@@ -90,7 +165,16 @@ SsiService::SsiService(XrdSsiLogger* log, wconfig::WorkerConfig const& workerCon
         uint64_t memManSize = workerConfig.getMemManSizeMb()*1000000;
         LOGS(_log, LOG_LVL_DEBUG, "Using MemManReal with memManSizeMb=" << workerConfig.getMemManSizeMb() 
             << " location=" <<  workerConfig.getMemManLocation());
-        memMan = std::shared_ptr<memman::MemMan>(memman::MemMan::create(memManSize, workerConfig.getMemManLocation()));
+        util::Numa::get().setEnabled(workerConfig.getMemManNuma());
+        LOGS(_log, LOG_LVL_INFO, "NUMA nodes=" << util::Numa::get().nodeCount()
+             << " placement=" << util::Numa::get().isEnabled());
+        memman::MemMan::Options memManOptions;
+        memManOptions.retain = workerConfig.getMemManRetain();
+        memManOptions.populate = workerConfig.getMemManPopulate();
+        memManOptions.hugePages = workerConfig.getMemManHugePages();
+        memManOptions.faultThreads = workerConfig.getMemManFaultThreads();
+        memMan = std::shared_ptr<memman::MemMan>(memman::MemMan::create(memManSize, workerConfig.getMemManLocation(),
+                                                                        memManOptions));
     } else if (cfgMemMan == "MemManNone"){
         memMan = std::make_shared<memman::MemManNone>(1, false);
     } else {
@@ -106,7 +190,7 @@ SsiService::SsiService(XrdSsiLogger* log, wconfig::WorkerConfig const& workerCon
     int maxReserve = 2;
     auto group = std::make_shared<wsched::GroupScheduler>(
         "SchedGroup", maxThread, maxReserve,
-        workerConfig.getMaxGroupSize(), wsched::SchedulerBase::getMaxPriority());
+        workerConfig.getMaxGroupSize(), wsched::SchedulerBase::getMaxPriority(), memMan);
 
     int const fastest = lsst::qserv::proto::ScanInfo::Rating::FASTEST;
     int const fast    = lsst::qserv::proto::ScanInfo::Rating::FAST;
@@ -134,28 +218,167 @@ SsiService::SsiService(XrdSsiLogger* log, wconfig::WorkerConfig const& workerCon
         "SchedSnail", maxThread, workerConfig.getMaxReserveSnail(), workerConfig.getPrioritySnail(),
         workerConfig.getMaxActiveChunksSnail(), memMan, slow+1, slowest, snailScanMaxMinutes);
 
+    if (workerConfig.getDeviceQueues()) {
+        for (auto const& scan : scanSchedulers) {
+            scan->useDeviceQueues(workerConfig.getMaxActiveChunksRotational());
+        }
+        snail->useDeviceQueues(workerConfig.getMaxActiveChunksRotational());
+    }
+
     wpublish::QueriesAndChunks::Ptr queries =
         std::make_shared<wpublish::QueriesAndChunks>(std::chrono::minutes(5), std::chrono::minutes(5),
                 maxTasksBootedPerUserQuery);
     wsched::BlendScheduler::Ptr blendSched = std::make_shared<wsched::BlendScheduler>("BlendSched", queries,
             maxThread, group, snail, scanSchedulers);
     blendSched->setPrioritizeByInFlight(false); // TODO: set in configuration file.
+    blendSched->setMaxLentThreads(workerConfig.getMaxLentThreads());
+    blendSched->setMaxSubChunkThreads(workerConfig.getSubChunkThreads());
+    blendSched->setPreemption(std::chrono::milliseconds(workerConfig.getPreemptAfterMs()),
+                              std::chrono::milliseconds(workerConfig.getPreemptMaxPauseMs()));
     queries->setBlendScheduler(blendSched);
 
     unsigned int requiredTasksCompleted = workerConfig.getRequiredTasksCompleted();
     queries->setRequiredTasksCompleted(requiredTasksCompleted);
 
+    ChannelStream::setCoalesceLimit(workerConfig.getTransmitConfig().coalesceKB * 1024);
+
     _foreman = std::make_shared<wcontrol::Foreman>(
-            blendSched, poolSize, workerConfig.getMySqlConfig(), queries);
+            blendSched, poolSize, workerConfig.getMySqlConfig(), queries,
+            workerConfig.getTransmitConfig(), _chunkInventory, workerConfig.getMySqlPool(),
+            workerConfig.getSubChunkCache(), workerConfig.getMySqlStatementCache(),
+            workerConfig.getFairShare(), workerConfig.getCommandThreads());
+
+    if (workerConfig.getSubChunkCache() > 0 && workerConfig.getSubChunkPrebuild()) {
+        std::weak_ptr<wcontrol::Foreman> weakForeman(_foreman);
+        auto chunkActiveFunc = [weakForeman](std::vector<wbase::Task::Ptr> const& tasks) {
+            auto foreman = weakForeman.lock();
+            if (foreman != nullptr) {
+                foreman->prebuildSubChunks(tasks);
+            }
+        };
+        for (auto const& scan : scanSchedulers) {
+            scan->setChunkActiveFunc(chunkActiveFunc);
+        }
+        snail->setChunkActiveFunc(chunkActiveFunc);
+    }
+
+    std::map<std::string, wsched::ScanScheduler::Ptr> scansByName{
+        {"fast", scanSchedulers[1]}, {"med", scanSchedulers[2]}, {"slow", scanSchedulers[0]},
+        {"snail", snail}};
+    _runtimeConfig = std::make_shared<wcontrol::RuntimeConfig>(blendSched, scansByName,
+            _foreman->getThreadPool(), memMan, workerConfig.getMemManSizeMb());
+
+    if (cfgMemMan == "MemManReal" && workerConfig.getMemManPressure()) {
+        // Under pressure, the scan schedulers work on half as many chunks.
+        std::weak_ptr<wcontrol::RuntimeConfig> weakConfig(_runtimeConfig);
+        auto pressureFunc = [weakConfig](bool underPressure) {
+            auto runtimeConfig = weakConfig.lock();
+            if (runtimeConfig != nullptr) {
+                runtimeConfig->setUnderPressure(underPressure);
+            }
+        };
+        _memPressureMonitor = std::make_shared<wcontrol::MemPressureMonitor>(
+                memMan, workerConfig.getMemManSizeMb()*1000000, workerConfig.getMemManPressureThreshold(),
+                pressureFunc);
+        if (_memPressureMonitor->start()) {
+            _runtimeConfig->setMemPressureMonitor(_memPressureMonitor);
+        }
+    }
+
+    std::vector<wsched::SchedulerBase::Ptr> schedulers{group, snail};
+    schedulers.insert(schedulers.end(), scanSchedulers.begin(), scanSchedulers.end());
+    auto admission = _foreman->getAdmission();
+    util::MetricsRegistry::get().addCollector("worker",
+            [memMan, blendSched, schedulers, admission](std::ostream& os) {
+        memMan->getStatistics().writeMetrics(os);
+        writeSchedulerMetrics(os, *blendSched, schedulers, admission);
+    });
+    if (workerConfig.getMetricsPort() > 0) {
+        _startMetricsServer(workerConfig.getMetricsPort());
+    }
 }
 
 SsiService::~SsiService() {
     LOGS(_log, LOG_LVL_DEBUG, "SsiService dying.");
+    util::MetricsRegistry::get().removeCollector("worker");
+    if (_metricsServer != nullptr) {
+        _metricsIoService.stop();
+        _metricsThread.join();
+    }
+}
+
+void SsiService::_startMetricsServer(unsigned short port) {
+    _metricsServer = qhttp::Server::create(_metricsIoService, port);
+    _metricsServer->addHandler("GET", "/metrics", [](qhttp::Request::Ptr, qhttp::Response::Ptr resp) {
+        std::ostringstream os;
+        util::MetricsRegistry::get().write(os);
+        resp->send(os.str(), "text/plain; version=0.0.4");
+    });
+    auto runtimeConfig = _runtimeConfig;
+    _metricsServer->addHandler("GET", "/config",
+            [runtimeConfig](qhttp::Request::Ptr, qhttp::Response::Ptr resp) {
+        std::ostringstream os;
+        for (auto const& elem : runtimeConfig->get()) {
+            os << elem.first << "=" << elem.second << "\n";
+        }
+        resp->send(os.str(), "text/plain");
+    });
+    // Parameters to change go in the query, e.g. PUT /config?scheduler.maxactivechunks_slow=4
+    _metricsServer->addHandler("PUT", "/config",
+            [runtimeConfig](qhttp::Request::Ptr req, qhttp::Response::Ptr resp) {
+        wcontrol::RuntimeConfig::Params params(req->query.begin(), req->query.end());
+        std::string error;
+        if (!runtimeConfig->set(params, error)) {
+            resp->status = 400;
+            resp->send(error + "\n", "text/plain");
+            return;
+        }
+        std::ostringstream os;
+        for (auto const& elem : runtimeConfig->get()) {
+            os << elem.first << "=" << elem.second << "\n";
+        }
+        resp->send(os.str(), "text/plain");
+    });
+    // GET /profile?seconds=10&hz=99 samples the stacks of the worker threads, see
+    // util::Profiler. The profile runs on its own thread, the response is sent from
+    // the one of the server.
+    _metricsServer->addHandler("GET", "/profile", [this](qhttp::Request::Ptr req, qhttp::Response::Ptr resp) {
+        unsigned long seconds = 10;
+        unsigned long hz = 99;
+        try {
+            auto itr = req->query.find("seconds");
+            if (itr != req->query.end()) seconds = std::stoul(itr->second);
+            itr = req->query.find("hz");
+            if (itr != req->query.end()) hz = std::stoul(itr->second);
+        } catch (std::exception const&) {
+            resp->sendStatus(400);
+            return;
+        }
+        std::thread([this, resp, seconds, hz]() {
+            std::string folded;
+            std::string error;
+            bool const ok = util::Profiler::profile(std::chrono::seconds(seconds), hz, folded, error);
+            _metricsIoService.post([resp, ok, folded, error]() {
+                if (!ok) {
+                    resp->status = 409;
+                    resp->send(error + "\n", "text/plain");
+                    return;
+                }
+                resp->send(folded, "text/plain");
+            });
+        }).detach();
+    });
+    _metricsServer->start();
+    LOGS(_log, LOG_LVL_INFO, "serving metrics on port " << _metricsServer->getPort());
+    _metricsThread = std::thread([this]() { _metricsIoService.run(); });
 }
 
 void SsiService::ProcessRequest(XrdSsiRequest &reqRef, XrdSsiResource &resRef) {
+    util::ThreadRole role("ssi-callback");
     LOGS(_log, LOG_LVL_DEBUG, "Got request call where rName is: " << resRef.rName);
-    auto request = SsiRequest::newSsiRequest(resRef.rName, _chunkInventory, _foreman, _mySqlConfig);
+    auto request = SsiRequest::newSsiRequest(resRef.rName, _chunkInventory, _foreman, _mySqlConfig,
+                                             _foreman->getAdmission(), _runtimeConfig,
+                                             _foreman->getQueriesAndChunks());
 
     // Continue execution in the session object as SSI gave us a new thread.
     // Object deletes itself when finished is called.
@@ -26,13 +26,16 @@
 
 // System headers
 #include <memory>
+#include <thread>
 
 // Third-party headers
+#include <boost/asio.hpp>
 #include "XrdSsi/XrdSsiResource.hh"
 #include "XrdSsi/XrdSsiService.hh"
 
 // Qserv headers
 #include "mysql/MySqlConfig.h"
+#include "qhttp/Server.h"
 #include "wconfig/WorkerConfig.h"
 
 // Forward declarations
@@ -42,6 +45,8 @@ namespace lsst {
 namespace qserv {
 namespace wcontrol {
   class Foreman;
+  class MemPressureMonitor;
+  class RuntimeConfig;
 }
 namespace wpublish {
   class ChunkInventory;
@@ -75,11 +80,21 @@ private:
     void _initInventory();
     void _configure();
 
+    /// Serve the metrics of the worker at /metrics on 'port', and its runtime
+    /// parameters at /config (GET reads them, PUT changes them).
+    void _startMetricsServer(unsigned short port);
+
     std::shared_ptr<wpublish::ChunkInventory> _chunkInventory;
     std::shared_ptr<wcontrol::Foreman> _foreman;
+    std::shared_ptr<wcontrol::MemPressureMonitor> _memPressureMonitor;
+    std::shared_ptr<wcontrol::RuntimeConfig> _runtimeConfig;
 
     mysql::MySqlConfig const _mySqlConfig;
 
+    boost::asio::io_service _metricsIoService; ///< Runs the metrics HTTP server.
+    qhttp::Server::Ptr _metricsServer;
+    std::thread _metricsThread;
+
 }; // class SsiService
 
 }}} // namespace lsst::qserv::xrdsvc
@@ -71,13 +71,22 @@ StreamBuffer::~StreamBuffer() {
 }
 
 
+ void StreamBuffer::setRecycleFunc(std::function<void()> const& func) {
+     std::lock_guard<std::mutex> lg(_mtx);
+     _recycleFunc = func;
+ }
+
+
  /// xrdssi calls this to recycle the buffer when finished.
  void StreamBuffer::Recycle() {
+     std::function<void()> recycleFunc;
      {
          std::lock_guard<std::mutex> lg(_mtx);
          _doneWithThis = true;
+         recycleFunc = std::move(_recycleFunc);
      }
      _cv.notify_all();
+     if (recycleFunc) recycleFunc();
 
      // delete this;
      // Effectively reset _selfKeepAlive, and if nobody else was
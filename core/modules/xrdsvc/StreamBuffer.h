@@ -27,6 +27,7 @@
 #include <atomic>
 #include <condition_variable>
 #include <deque>
+#include <functional>
 #include <mutex>
 #include <string>
 
@@ -64,6 +65,9 @@ public:
     /// @Return total number of bytes used by ALL StreamBuffer objects.
     static size_t getTotalBytes() { return _totalBytes; }
 
+    /// Set a function to be called once, when XrdSsi recycles the buffer.
+    void setRecycleFunc(std::function<void()> const& func);
+
     //!> Call to recycle the buffer when finished
     void Recycle() override;
 
@@ -84,6 +88,7 @@ private:
     std::mutex _mtx;
     std::condition_variable _cv;
     bool _doneWithThis{false};
+    std::function<void()> _recycleFunc; ///< protected by _mtx
     Ptr _selfKeepAlive; ///< keep this object alive until after Recycle() is called.
     util::InstanceCount _ic{"StreamBuffer"}; ///< Useful as it indicates amount of waiting for czar.
 